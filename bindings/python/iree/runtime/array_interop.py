@@ -22,8 +22,12 @@ from .binding import (
 __all__ = [
     "asdevicearray",
     "DeviceArray",
+    "from_dlpack",
 ]
 
+# DLPack device type of host memory (kDLCPU).
+_DLPACK_CPU_DEVICE_TYPE = 1
+
 _DEVICE_HANDLED_FUNCTIONS = {}
 
 
@@ -58,6 +62,10 @@ class DeviceArray(numpy.lib.mixins.NDArrayOperatorsMixin):
       implicit transfer back to the host will trigger appropriate waits and
       be performed automatically (this is the common case for function return
       values if not otherwise configured, as an example).
+
+  Arrays stay device resident until their contents are first accessed from
+  the host, so that results passed to further calls are never copied.
+  Buffers that are not host visible are then copied to host memory once.
   """
 
   def __init__(self,
@@ -112,9 +120,11 @@ class DeviceArray(numpy.lib.mixins.NDArrayOperatorsMixin):
     self._mapped_memory, self._host_array = self._map_to_host()
 
   def _map_to_host(self) -> Tuple[MappedMemory, np.ndarray]:
-    # TODO: When synchronization is enabled, need to block here.
+    # Invocations are synchronous: the contents are ready once the buffer
+    # view is returned and the transfer only waits on device local buffers.
     raw_dtype = self._get_raw_dtype()
-    mapped_memory = self._buffer_view.map()
+    host_buffer_view = self._device.transfer_to_host(self._buffer_view)
+    mapped_memory = host_buffer_view.map()
     host_array = mapped_memory.asarray(self._buffer_view.shape, raw_dtype)
     # Detect if we need to force an explicit conversion. This happens when
     # we were requested to pretend that the array is in a specific dtype,
@@ -143,6 +153,28 @@ class DeviceArray(numpy.lib.mixins.NDArrayOperatorsMixin):
     host_ary = self.to_host()
     return host_ary.astype(dtype, casting=casting, copy=copy)
 
+  def __dlpack_device__(self) -> Tuple[int, int]:
+    """Returns the DLPack (device_type, device_id) of the array memory.
+
+    Only arrays in host visible memory can currently be exchanged: the HAL
+    does not expose device pointers of device resident buffers.
+    """
+    memory_type = self._buffer_view.memory_type
+    if not memory_type & int(MemoryType.HOST_VISIBLE):
+      raise BufferError("DLPack export of device resident arrays is not "
+                        "supported: transfer to the host with .to_host()")
+    return (_DLPACK_CPU_DEVICE_TYPE, 0)
+
+  def __dlpack__(self, stream=None):
+    """Exports the array memory as a DLPack capsule without copying it.
+
+    The capsule keeps the mapping of the buffer alive.
+    """
+    self.__dlpack_device__()
+    if stream is not None:
+      raise BufferError("stream must be None for host memory")
+    return self.to_host().__dlpack__()
+
   def __reduce__(self):
     # Since this is used for making deep copies and pickling, we map
     # separately from any interactive state. We just reduce to the actual
@@ -206,6 +238,35 @@ def asdevicearray(device: HalDevice,
                      override_dtype=a.dtype)
 
 
+def from_dlpack(device: HalDevice,
+                x,
+                *,
+                implicit_host_transfer: bool = False,
+                memory_type=MemoryType.DEVICE_LOCAL | MemoryType.DEVICE_VISIBLE,
+                allowed_usage=BufferUsage.ALL) -> DeviceArray:
+  """Creates a DeviceArray from an object implementing the DLPack protocol.
+
+  The memory of `x` is imported without a copy when `device` can access it
+  (see `HalAllocator.import_buffer`), in which case the array aliases `x` and
+  keeps it alive. Only host (kDLCPU) tensors are currently supported.
+  """
+  if not hasattr(np, "from_dlpack"):
+    raise NotImplementedError("DLPack interop requires numpy >= 1.22")
+  # An ndarray viewing the DLPack tensor; its base owns the capsule.
+  a = np.ascontiguousarray(np.from_dlpack(x))
+  element_type = map_dtype_to_element_type(a.dtype)
+  if element_type is None:
+    raise ValueError(f"Could not map dtype {a.dtype} to IREE element type")
+  buffer_view = device.allocator.import_buffer(memory_type=memory_type,
+                                               allowed_usage=allowed_usage,
+                                               buffer=a,
+                                               element_type=element_type)
+  return DeviceArray(device,
+                     buffer_view,
+                     implicit_host_transfer=implicit_host_transfer,
+                     override_dtype=a.dtype)
+
+
 # NOTE: Numpy dtypes are not hashable and exist in a hierarchy that should
 # be queried via isinstance checks. This should be done as a fallback but
 # this is a linear list for quick access to the most common. There may also
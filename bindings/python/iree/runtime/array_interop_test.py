@@ -107,6 +107,20 @@ class DeviceHalTest(unittest.TestCase):
     self.assertEqual(f32_copy.dtype, np.float32)
     np.testing.assert_array_equal(orig_ary.astype(np.float32), f32_copy)
 
+  @unittest.skipUnless(hasattr(np, "from_dlpack"), "requires numpy >= 1.22")
+  def testDLPackRoundTrip(self):
+    init_ary = np.arange(12, dtype=np.float32).reshape([3, 4])
+    ary = iree.runtime.from_dlpack(self.device, init_ary)
+    self.assertEqual([3, 4], ary.shape)
+    self.assertEqual(np.float32, ary.dtype)
+    self.assertEqual((1, 0), ary.__dlpack_device__())
+
+    # Both directions alias the original memory.
+    host_ary = np.from_dlpack(ary)
+    init_ary[2, 3] = 42.0
+    self.assertEqual(host_ary[2, 3], 42.0)
+    np.testing.assert_array_equal(host_ary, init_ary)
+
 
 if __name__ == "__main__":
   unittest.main()
@@ -5,74 +5,55 @@
 # See https://llvm.org/LICENSE.txt for license information.
 # SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+from concurrent.futures import Executor, ThreadPoolExecutor
 from typing import Dict, Optional
 
+import asyncio
 import json
 import logging
-
-import numpy as np
+import threading
 
 from .binding import (
     _invoke_statics,
     ArgumentPacker,
     BufferUsage,
-    HalBufferView,
     HalDevice,
     InvokeContext,
     MemoryType,
+    ResultUnpacker,
     VmContext,
     VmFunction,
     VmVariantList,
 )
 
 from . import tracing
-from .array_interop import (
-    map_dtype_to_element_type,
-    DeviceArray,
-)
-from .flags import (
-    FUNCTION_INPUT_VALIDATION,)
 
 __all__ = [
+    "create_invoke_executor",
     "FunctionInvoker",
 ]
 
 
-class Invocation:
-  __slots__ = [
-      "current_arg",
-      "current_desc",
-      "current_return_list",
-      "current_return_index",
-      "device",
-  ]
+_default_invoke_executor = None  # type: Optional[Executor]
+_default_invoke_executor_lock = threading.Lock()
 
-  def __init__(self, device: HalDevice):
-    self.device = device
-    # Captured during arg/ret processing to emit better error messages.
-    self.current_arg = None
-    self.current_desc = None
-    self.current_return_list = None
-    self.current_return_index = 0
 
-  def summarize_arg_error(self) -> str:
-    if self.current_arg is None:
-      return ""
-    if isinstance(self.current_arg, np.ndarray):
-      current_arg_repr = (
-          f"ndarray({self.current_arg.shape}, {self.current_arg.dtype})")
-    else:
-      current_arg_repr = repr(self.current_arg)
-    return f"{repr(current_arg_repr)} with description {self.current_desc}"
+def _get_default_invoke_executor() -> Executor:
+  """Returns the executor of async calls of invokers without one."""
+  global _default_invoke_executor
+  with _default_invoke_executor_lock:
+    if _default_invoke_executor is None:
+      _default_invoke_executor = create_invoke_executor()
+    return _default_invoke_executor
 
-  def summarize_return_error(self) -> str:
-    if self.current_return_list is None:
-      return ""
-    try:
-      vm_repr = f"{self.current_return_index}@{self.current_return_list}"
-    except:
-      vm_repr = "<error printing list item>"
-    return f"{vm_repr} with description {self.current_desc}"
+
+def create_invoke_executor() -> Executor:
+  """Creates an executor serializing the async calls into a VM context.
+
+  Invocations of the same context must not run concurrently; they release the
+  GIL while running so that the event loop and other contexts can progress.
+  """
+  return ThreadPoolExecutor(max_workers=1, thread_name_prefix="iree-invoke")
 
 
 class FunctionInvoker:
@@ -85,13 +66,17 @@ class FunctionInvoker:
       "_arg_descs",
       "_arg_packer",
       "_ret_descs",
-      "_has_inlined_results",
+      "_result_unpacker",
       "_tracer",
+      "_executor",
   ]
 
-  def __init__(self, vm_context: VmContext, device: HalDevice,
+  def __init__(self,
+               vm_context: VmContext,
+               device: HalDevice,
                vm_function: VmFunction,
-               tracer: Optional[tracing.ContextTracer]):
+               tracer: Optional[tracing.ContextTracer],
+               executor: Optional[Executor] = None):
     self._vm_context = vm_context
     # TODO: Needing to know the precise device to allocate on here is bad
     # layering and will need to be fixed in some fashion if/when doing
@@ -99,12 +84,15 @@ class FunctionInvoker:
     self._device = device
     self._vm_function = vm_function
     self._tracer = tracer
+    # Executor running the async calls. It must serialize the calls into
+    # |vm_context| (see create_invoke_executor).
+    self._executor = executor
     self._abi_dict = None
     self._arg_descs = None
     self._ret_descs = None
-    self._has_inlined_results = False
     self._parse_abi_dict(vm_function)
     self._arg_packer = ArgumentPacker(_invoke_statics, self._arg_descs)
+    self._result_unpacker = ResultUnpacker(_invoke_statics, self._ret_descs)
 
   @property
   def vm_function(self) -> VmFunction:
@@ -118,37 +106,60 @@ class FunctionInvoker:
     if self._tracer:
       call_trace = self._tracer.start_call(self._vm_function)
     try:
-      # Initialize the capacity to our total number of args, since we should
-      # be below that when doing a flat invocation. May want to be more
-      # conservative here when considering nesting.
-      inv = Invocation(self._device)
-      ret_descs = self._ret_descs
-
-      ret_list = VmVariantList(len(ret_descs) if ret_descs is not None else 1)
+      ret_list = self._create_ret_list()
       if call_trace:
         call_trace.add_vm_list(arg_list, "args")
       self._invoke(arg_list, ret_list)
       if call_trace:
         call_trace.add_vm_list(ret_list, "results")
+      return self._unpack_results(invoke_context, ret_list)
+    finally:
+      if call_trace:
+        call_trace.end_call()
+
+  async def async_call(self, *args, **kwargs):
+    """Invokes the function without blocking the running event loop.
 
-      # Un-inline the results to align with reflection, as needed.
-      reflection_aligned_ret_list = ret_list
-      if self._has_inlined_results:
-        reflection_aligned_ret_list = VmVariantList(1)
-        reflection_aligned_ret_list.push_list(ret_list)
-      returns = _extract_vm_sequence_to_python(inv, reflection_aligned_ret_list,
-                                               ret_descs)
-      return_arity = len(returns)
-      if return_arity == 1:
-        return returns[0]
-      elif return_arity == 0:
-        return None
-      else:
-        return tuple(returns)
+    Arguments are packed and results unpacked on the calling thread; the
+    invocation itself runs on the executor of the invoker, with the GIL
+    released, so that other coroutines can progress meanwhile.
+    """
+    loop = asyncio.get_running_loop()
+    invoke_context = InvokeContext(self._device)
+    arg_list = self._arg_packer.pack(invoke_context, args, kwargs)
+
+    call_trace = None  # type: Optional[tracing.CallTrace]
+    if self._tracer:
+      call_trace = self._tracer.start_call(self._vm_function)
+    try:
+      ret_list = self._create_ret_list()
+      if call_trace:
+        call_trace.add_vm_list(arg_list, "args")
+      executor = self._executor or _get_default_invoke_executor()
+      await loop.run_in_executor(executor, self._invoke, arg_list, ret_list)
+      if call_trace:
+        call_trace.add_vm_list(ret_list, "results")
+      return self._unpack_results(invoke_context, ret_list)
     finally:
       if call_trace:
         call_trace.end_call()
 
+  def _create_ret_list(self) -> VmVariantList:
+    # Initialize the capacity to our total number of args, since we should
+    # be below that when doing a flat invocation. May want to be more
+    # conservative here when considering nesting.
+    ret_descs = self._ret_descs
+    return VmVariantList(len(ret_descs) if ret_descs is not None else 1)
+
+  def _unpack_results(self, invoke_context: InvokeContext,
+                      ret_list: VmVariantList):
+    try:
+      return self._result_unpacker.unpack(invoke_context, ret_list)
+    except ValueError as e:
+      raise ReturnError(f"Error processing function return: {e} "
+                        f"(while decoding {ret_list} with description "
+                        f"{self._ret_descs})") from e
+
   # Break out invoke so it shows up in profiles.
   def _invoke(self, arg_list, ret_list):
     self._vm_context.invoke(self._vm_function, arg_list, ret_list)
@@ -179,120 +190,10 @@ class FunctionInvoker:
       raise RuntimeError(
           f"Malformed function reflection metadata structure: {reflection}")
 
-    # Detect whether the results are a slist/stuple/sdict, which indicates
-    # that they are inlined with the function's results.
-    if len(self._ret_descs) == 1:
-      maybe_inlined = self._ret_descs[0]
-      if maybe_inlined and maybe_inlined[0] in ["slist", "stuple", "sdict"]:
-        self._has_inlined_results = True
-
   def __repr__(self):
     return repr(self._vm_function)
 
 
-# VM to Python converters. All take:
-#   inv: Invocation
-#   vm_list: VmVariantList to read from
-#   vm_index: Index in the vm_list to extract
-#   desc: The ABI descriptor list (or None if in dynamic mode)
-# Return the corresponding Python object.
-
-
-def _vm_to_ndarray(inv: Invocation, vm_list: VmVariantList, vm_index: int,
-                   desc):
-  # The descriptor for an ndarray is like:
-  #   ["ndarray", "<dtype>", <rank>, <dim>...]
-  #   ex: ['ndarray', 'i32', 1, 25948]
-  buffer_view = vm_list.get_as_buffer_view(vm_index)
-  dtype_str = desc[1]
-  try:
-    dtype = ABI_TYPE_TO_DTYPE[dtype_str]
-  except KeyError:
-    _raise_return_error(inv, f"unrecognized dtype '{dtype_str}'")
-  x = DeviceArray(inv.device,
-                  buffer_view,
-                  implicit_host_transfer=True,
-                  override_dtype=dtype)
-  return x
-
-
-def _vm_to_sdict(inv: Invocation, vm_list: VmVariantList, vm_index: int, desc):
-  # The descriptor for an sdict is like:
-  #   ['sdict', ['key1', value1], ...]
-  sub_vm_list = vm_list.get_as_list(vm_index)
-  item_keys = []
-  item_descs = []
-  for k, d in desc[1:]:
-    item_keys.append(k)
-    item_descs.append(d)
-  py_items = _extract_vm_sequence_to_python(inv, sub_vm_list, item_descs)
-  return dict(zip(item_keys, py_items))
-
-
-def _vm_to_slist(inv: Invocation, vm_list: VmVariantList, vm_index: int, desc):
-  # The descriptor for an slist is like:
-  #   ['slist, item1, ...]
-  sub_vm_list = vm_list.get_as_list(vm_index)
-  item_descs = desc[1:]
-  py_items = _extract_vm_sequence_to_python(inv, sub_vm_list, item_descs)
-  return py_items
-
-
-def _vm_to_stuple(inv: Invocation, vm_list: VmVariantList, vm_index: int, desc):
-  return tuple(_vm_to_slist(inv, vm_list, vm_index, desc))
-
-
-def _vm_to_scalar(type_bound: type):
-
-  def convert(inv: Invocation, vm_list: VmVariantList, vm_index: int, desc):
-    value = vm_list.get_variant(vm_index)
-    if not isinstance(value, type_bound):
-      raise ReturnError(
-          f"expected an {type_bound} value but got {value.__class__}")
-    return value
-
-  return convert
-
-
-def _vm_to_pylist(inv: Invocation, vm_list: VmVariantList, vm_index: int, desc):
-  # The descriptor for a pylist is like:
-  #   ['pylist', element_type]
-  sub_vm_list = vm_list.get_as_list(vm_index)
-  element_type_desc = desc[1:]
-  py_items = _extract_vm_sequence_to_python(
-      inv, sub_vm_list, element_type_desc * len(sub_vm_list))
-  return py_items
-
-
-VM_TO_PYTHON_CONVERTERS = {
-    "ndarray": _vm_to_ndarray,
-    "sdict": _vm_to_sdict,
-    "slist": _vm_to_slist,
-    "stuple": _vm_to_stuple,
-    "py_homogeneous_list": _vm_to_pylist,
-
-    # Scalars.
-    "i8": _vm_to_scalar(int),
-    "i16": _vm_to_scalar(int),
-    "i32": _vm_to_scalar(int),
-    "i64": _vm_to_scalar(int),
-    "f16": _vm_to_scalar(float),
-    "f32": _vm_to_scalar(float),
-    "f64": _vm_to_scalar(float),
-    "bf16": _vm_to_scalar(float),
-}
-
-ABI_TYPE_TO_DTYPE = {
-    # TODO: Others.
-    "f32": np.float32,
-    "i32": np.int32,
-    "i64": np.int64,
-    "f64": np.float64,
-    "i16": np.int16,
-    "i8": np.int8,
-    "i1": np.bool_,
-}
-
 # When we get an ndarray as an argument and are implicitly mapping it to a
 # buffer view, flags for doing so.
 IMPLICIT_BUFFER_ARG_MEMORY_TYPE = (MemoryType.DEVICE_LOCAL |
@@ -300,91 +201,5 @@ IMPLICIT_BUFFER_ARG_MEMORY_TYPE = (MemoryType.DEVICE_LOCAL |
 IMPLICIT_BUFFER_ARG_USAGE = BufferUsage.ALL
 
 
-def _is_ndarray_descriptor(desc):
-  return desc and desc[0] == "ndarray"
-
-
-def _is_0d_ndarray_descriptor(desc):
-  # Example: ["ndarray", "f32", 0]
-  return desc and desc[0] == "ndarray" and desc[2] == 0
-
-
-def _cast_scalar_to_ndarray(inv: Invocation, x, desc):
-  # Example descriptor: ["ndarray", "f32", 0]
-  dtype_str = desc[1]
-  try:
-    dtype = ABI_TYPE_TO_DTYPE[dtype_str]
-  except KeyError:
-    _raise_argument_error(inv, f"unrecognized dtype '{dtype_str}'")
-  return dtype(x)
-
-
-class ArgumentError(ValueError):
-  pass
-
-
 class ReturnError(ValueError):
   pass
-
-
-def _raise_argument_error(inv: Invocation,
-                          summary: str,
-                          e: Optional[Exception] = None):
-  new_e = ArgumentError(
-      f"Error passing argument: {summary} "
-      f"(while encoding argument {inv.summarize_arg_error()})")
-  if e:
-    raise new_e from e
-  else:
-    raise new_e
-
-
-def _raise_return_error(inv: Invocation,
-                        summary: str,
-                        e: Optional[Exception] = None):
-  new_e = ReturnError(f"Error processing function return: {summary} "
-                      f"(while decoding return {inv.summarize_return_error()})")
-  if e:
-    raise new_e from e
-  else:
-    raise new_e
-
-
-def _extract_vm_sequence_to_python(inv: Invocation, vm_list, descs):
-  vm_list_arity = len(vm_list)
-  if descs is None:
-    descs = [None] * vm_list_arity
-  elif vm_list_arity != len(descs):
-    _raise_return_error(
-        inv, f"mismatched return arity: {vm_list_arity} vs {len(descs)}")
-  results = []
-  for vm_index, desc in zip(range(vm_list_arity), descs):
-    inv.current_return_list = vm_list
-    inv.current_return_index = vm_index
-    inv.current_desc = desc
-    if desc is None:
-      # Dynamic (non reflection mode).
-      converted = vm_list.get_variant(vm_index)
-      # Special case: Upgrade HalBufferView to a DeviceArray. We do that here
-      # since this is higher level and it preserves layering. Note that
-      # the reflection case also does this conversion.
-      if isinstance(converted, HalBufferView):
-        converted = DeviceArray(inv.device,
-                                converted,
-                                implicit_host_transfer=True)
-    else:
-      # Known type descriptor.
-      vm_type = desc if isinstance(desc, str) else desc[0]
-      try:
-        converter = VM_TO_PYTHON_CONVERTERS[vm_type]
-      except KeyError:
-        _raise_return_error(inv, f"cannot map VM type to Python: {vm_type}")
-      try:
-        converted = converter(inv, vm_list, vm_index, desc)
-      except ReturnError:
-        raise
-      except Exception as e:
-        _raise_return_error(inv, f"exception converting from VM type to Python",
-                            e)
-    results.append(converted)
-  return results
@@ -5,6 +5,7 @@
 # See https://llvm.org/LICENSE.txt for license information.
 # SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+import asyncio
 import json
 import numpy as np
 
@@ -12,6 +13,7 @@ from absl.testing import absltest
 
 from iree import runtime as rt
 from iree.runtime.function import (
+    create_invoke_executor,
     FunctionInvoker,
     IMPLICIT_BUFFER_ARG_MEMORY_TYPE,
     IMPLICIT_BUFFER_ARG_USAGE,
@@ -591,6 +593,47 @@ class FunctionTest(absltest.TestCase):
     result = invoker()
     self.assertEqual("[1, 2]", repr(result))
 
+  def testReturnArityMismatch(self):
+
+    def invoke(arg_list, ret_list):
+      ret_list.push_int(3)
+
+    vm_context = MockVmContext(invoke)
+    vm_function = MockVmFunction(reflection={
+        "iree.abi": json.dumps({
+            "a": [],
+            "r": ["i32", "i32"],
+        })
+    })
+    invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
+    with self.assertRaisesRegex(ValueError, "mismatched return arity: 1 vs 2"):
+      _ = invoker()
+
+  def testAsyncCall(self):
+
+    def invoke(arg_list, ret_list):
+      ret_list.push_int(3)
+
+    vm_context = MockVmContext(invoke)
+    vm_function = MockVmFunction(reflection={
+        "iree.abi": json.dumps({
+            "a": ["i32"],
+            "r": ["i32"],
+        })
+    })
+    invoker = FunctionInvoker(vm_context,
+                              self.device,
+                              vm_function,
+                              tracer=None,
+                              executor=create_invoke_executor())
+
+    async def main():
+      return await asyncio.gather(invoker.async_call(1), invoker.async_call(2))
+
+    self.assertEqual([3, 3], asyncio.run(main()))
+    self.assertEqual("[<VmVariantList(1): [1]>, <VmVariantList(1): [2]>]",
+                     vm_context.mock_arg_reprs)
+
 
 if __name__ == "__main__":
   absltest.main()
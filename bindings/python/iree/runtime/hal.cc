@@ -6,6 +6,8 @@
 
 #include "bindings/python/iree/runtime/hal.h"
 
+#include <memory>
+
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "pybind11/numpy.h"
@@ -40,6 +42,52 @@ static std::string ToHexString(uint32_t value) {
   return ToHexString((const uint8_t*)&value, sizeof(value));
 }
 
+// Allocator control function releasing the Py_buffer passed as |self| when
+// the HAL buffer wrapping its memory is freed. This may happen on any thread
+// so the GIL is acquired first.
+static iree_status_t PyBufferReleaseCtl(void* self,
+                                        iree_allocator_command_t command,
+                                        const void* params, void** inout_ptr) {
+  if (command != IREE_ALLOCATOR_COMMAND_FREE) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "imported Python buffers can only be freed");
+  }
+  py::gil_scoped_acquire acquire;
+  Py_buffer* py_view = static_cast<Py_buffer*>(self);
+  PyBuffer_Release(py_view);
+  delete py_view;
+  return iree_ok_status();
+}
+
+// Wraps |hal_buffer| in a buffer view matching the shape of |py_view| if an
+// element type is given, and returns the buffer otherwise. Takes ownership of
+// |hal_buffer|.
+static py::object CreateBufferOrView(
+    iree_hal_allocator_t* allocator, iree_hal_buffer_t* hal_buffer,
+    const Py_buffer& py_view,
+    std::optional<iree_hal_element_types_t> element_type) {
+  if (!element_type) {
+    return py::cast(HalBuffer::StealFromRawPtr(hal_buffer),
+                    py::return_value_policy::move);
+  }
+
+  // Create the buffer_view. (note that numpy shape is ssize_t, so we need to
+  // copy).
+  iree_hal_encoding_type_t encoding_type =
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR;
+  std::vector<iree_hal_dim_t> dims(py_view.ndim);
+  std::copy(py_view.shape, py_view.shape + py_view.ndim, dims.begin());
+  iree_hal_buffer_view_t* hal_buffer_view;
+  iree_status_t status = iree_hal_buffer_view_create(
+      hal_buffer, dims.data(), dims.size(), *element_type, encoding_type,
+      iree_hal_allocator_host_allocator(allocator), &hal_buffer_view);
+  iree_hal_buffer_release(hal_buffer);
+  CheckApiStatus(status, "Error allocating buffer_view");
+
+  return py::cast(HalBufferView::StealFromRawPtr(hal_buffer_view),
+                  py::return_value_policy::move);
+}
+
 }  // namespace
 
 //------------------------------------------------------------------------------
@@ -109,27 +157,57 @@ py::object HalAllocator::AllocateBufferCopy(
   }
   CheckApiStatus(status, "Failed to allocate device visible buffer");
 
-  if (!element_type) {
-    return py::cast(HalBuffer::StealFromRawPtr(hal_buffer),
-                    py::return_value_policy::move);
+  return CreateBufferOrView(raw_ptr(), hal_buffer, py_view, element_type);
+}
+
+py::object HalAllocator::ImportBuffer(
+    int memory_type, int allowed_usage, py::object buffer,
+    std::optional<iree_hal_element_types_t> element_type) {
+  IREE_TRACE_SCOPE0("HalAllocator::ImportBuffer");
+  // The view is kept alive (and with it the Python object) until the HAL
+  // buffer wrapping its memory is freed.
+  auto py_view = std::make_unique<Py_buffer>();
+  int flags = PyBUF_FORMAT | PyBUF_ND;
+  if (PyObject_GetBuffer(buffer.ptr(), py_view.get(), flags) != 0) {
+    // The GetBuffer call is required to set an appropriate error.
+    throw py::error_already_set();
   }
 
-  // Create the buffer_view. (note that numpy shape is ssize_t, so we need to
-  // copy).
-  iree_hal_encoding_type_t encoding_type =
-      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR;
-  std::vector<iree_hal_dim_t> dims(py_view.ndim);
-  std::copy(py_view.shape, py_view.shape + py_view.ndim, dims.begin());
-  iree_hal_buffer_view_t* hal_buffer_view;
-  CheckApiStatus(
-      iree_hal_buffer_view_create(
-          hal_buffer, dims.data(), dims.size(), *element_type, encoding_type,
-          iree_hal_allocator_host_allocator(raw_ptr()), &hal_buffer_view),
-      "Error allocating buffer_view");
-  iree_hal_buffer_release(hal_buffer);
+  iree_hal_memory_type_t wrap_memory_type =
+      memory_type | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+  iree_hal_memory_access_t allowed_access =
+      py_view->readonly ? IREE_HAL_MEMORY_ACCESS_READ
+                        : IREE_HAL_MEMORY_ACCESS_ALL;
+  iree_hal_buffer_t* hal_buffer = nullptr;
+  iree_status_t status = iree_ok_status();
+  {
+    py::gil_scoped_release release;
+    iree_hal_buffer_compatibility_t compatibility =
+        iree_hal_allocator_query_buffer_compatibility(
+            raw_ptr(), wrap_memory_type, allowed_usage, allowed_usage,
+            py_view->len);
+    if (iree_all_bits_set(compatibility,
+                          IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE)) {
+      iree_allocator_t data_allocator = {py_view.get(), PyBufferReleaseCtl};
+      status = iree_hal_allocator_wrap_buffer(
+          raw_ptr(), wrap_memory_type, allowed_access, allowed_usage,
+          iree_make_byte_span(py_view->buf, py_view->len), data_allocator,
+          &hal_buffer);
+    }
+  }
+  if (!hal_buffer) {
+    // The device cannot access the host memory: fall back to a copy.
+    iree_status_ignore(status);
+    PyBuffer_Release(py_view.get());
+    return AllocateBufferCopy(memory_type, allowed_usage, std::move(buffer),
+                              element_type);
+  }
 
-  return py::cast(HalBufferView::StealFromRawPtr(hal_buffer_view),
-                  py::return_value_policy::move);
+  // The HAL buffer now owns the view, which may still be needed to create the
+  // buffer view below.
+  Py_buffer* owned_py_view = py_view.release();
+  return CreateBufferOrView(raw_ptr(), hal_buffer, *owned_py_view,
+                            element_type);
 }
 
 //------------------------------------------------------------------------------
@@ -202,6 +280,41 @@ py::str HalBufferView::Repr() {
   return py::str(repr);
 }
 
+//------------------------------------------------------------------------------
+// HalDevice
+//------------------------------------------------------------------------------
+
+HalBufferView HalDevice::TransferToHost(HalBufferView& buffer_view) {
+  iree_hal_buffer_t* source_buffer =
+      iree_hal_buffer_view_buffer(buffer_view.raw_ptr());
+  if (iree_all_bits_set(iree_hal_buffer_memory_type(source_buffer),
+                        IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    return HalBufferView::BorrowFromRawPtr(buffer_view.raw_ptr());
+  }
+
+  iree_hal_buffer_t* target_buffer;
+  iree_status_t status;
+  {
+    // The transfer waits on the device.
+    py::gil_scoped_release release;
+    status = iree_hal_device_transfer_to_host(raw_ptr(), source_buffer,
+                                              &target_buffer);
+  }
+  CheckApiStatus(status, "Error transferring buffer to host");
+
+  iree_host_size_t rank =
+      iree_hal_buffer_view_shape_rank(buffer_view.raw_ptr());
+  iree_hal_buffer_view_t* target_buffer_view;
+  status = iree_hal_buffer_view_create(
+      target_buffer, iree_hal_buffer_view_shape_dims(buffer_view.raw_ptr()),
+      rank, iree_hal_buffer_view_element_type(buffer_view.raw_ptr()),
+      iree_hal_buffer_view_encoding_type(buffer_view.raw_ptr()),
+      iree_hal_device_host_allocator(raw_ptr()), &target_buffer_view);
+  iree_hal_buffer_release(target_buffer);
+  CheckApiStatus(status, "Error allocating buffer_view");
+  return HalBufferView::StealFromRawPtr(target_buffer_view);
+}
+
 //------------------------------------------------------------------------------
 // HalDriver
 //------------------------------------------------------------------------------
@@ -403,9 +516,16 @@ void SetupHalBindings(pybind11::module m) {
       .def_static("map_to_dtype", &MapElementTypeToDType);
 
   py::class_<HalDevice>(m, "HalDevice")
-      .def_property_readonly("allocator", [](HalDevice& self) {
-        return HalAllocator::BorrowFromRawPtr(self.allocator());
-      });
+      .def_property_readonly("allocator",
+                             [](HalDevice& self) {
+                               return HalAllocator::BorrowFromRawPtr(
+                                   self.allocator());
+                             })
+      .def("transfer_to_host", &HalDevice::TransferToHost,
+           py::arg("buffer_view"),
+           "Synchronously copies the contents of a buffer view to host "
+           "visible memory. Buffer views that are already host visible are "
+           "returned as is.");
 
   py::class_<HalDriver>(m, "HalDriver")
       .def_static("query", &HalDriver::Query)
@@ -458,7 +578,15 @@ void SetupHalBindings(pybind11::module m) {
            "object. If an element type is specified, wraps in a BufferView "
            "matching the characteristics of the Python buffer. The format is "
            "requested as ND/C-Contiguous, which may incur copies if not "
-           "already in that format.");
+           "already in that format.")
+      .def("import_buffer", &HalAllocator::ImportBuffer,
+           py::arg("memory_type"), py::arg("allowed_usage"), py::arg("buffer"),
+           py::arg("element_type") = py::none(),
+           "Wraps the memory of a Python buffer object without copying it when "
+           "the device can access host memory, keeping the object alive for "
+           "the lifetime of the buffer. The device then aliases the Python "
+           "buffer: writes through either are visible to the other. Falls "
+           "back to allocate_buffer_copy otherwise.");
 
   py::class_<HalBuffer>(m, "HalBuffer")
       .def("fill_zero", &HalBuffer::FillZero, py::arg("byte_offset"),
@@ -486,6 +614,12 @@ void SetupHalBindings(pybind11::module m) {
           [](HalBufferView& self) {
             return iree_hal_buffer_view_element_type(self.raw_ptr());
           })
+      .def_property_readonly(
+          "memory_type",
+          [](HalBufferView& self) {
+            return iree_hal_buffer_memory_type(
+                iree_hal_buffer_view_buffer(self.raw_ptr()));
+          })
       .def("__repr__", &HalBufferView::Repr);
 
   py::class_<HalMappedMemory>(m, "MappedMemory", py::buffer_protocol())
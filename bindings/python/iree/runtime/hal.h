@@ -60,11 +60,15 @@ struct ApiPtrAdapter<iree_hal_buffer_view_t> {
 // ApiRefCounted types
 //------------------------------------------------------------------------------
 
+class HalBufferView;
+
 class HalDevice : public ApiRefCounted<HalDevice, iree_hal_device_t> {
  public:
   iree_hal_allocator_t* allocator() {
     return iree_hal_device_allocator(raw_ptr());
   }
+
+  HalBufferView TransferToHost(HalBufferView& buffer_view);
 };
 
 class HalDriver : public ApiRefCounted<HalDriver, iree_hal_driver_t> {
@@ -83,6 +87,9 @@ class HalAllocator : public ApiRefCounted<HalAllocator, iree_hal_allocator_t> {
   py::object AllocateBufferCopy(
       int memory_type, int allowed_usage, py::object buffer,
       std::optional<iree_hal_element_types_t> element_type);
+  py::object ImportBuffer(int memory_type, int allowed_usage,
+                          py::object buffer,
+                          std::optional<iree_hal_element_types_t> element_type);
 };
 
 struct HalShape {
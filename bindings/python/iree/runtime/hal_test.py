@@ -127,6 +127,35 @@ class DeviceHalTest(unittest.TestCase):
         "<HalBufferView (3, 4), element_type=0x20000011, 48 bytes (at offset 0 into 48), memory_type=DEVICE_LOCAL|HOST_VISIBLE, allowed_access=ALL, allowed_usage=CONSTANT|TRANSFER|MAPPING>"
     )
 
+  def testImportBufferView(self):
+    ary = np.zeros([3, 4], dtype=np.int32) + 2
+    buffer_view = self.allocator.import_buffer(
+        memory_type=iree.runtime.MemoryType.DEVICE_LOCAL,
+        allowed_usage=iree.runtime.BufferUsage.CONSTANT,
+        buffer=ary,
+        element_type=iree.runtime.HalElementType.SINT_32)
+    self.assertEqual(buffer_view.shape, [3, 4])
+    # The local device aliases the array instead of copying it.
+    ary[1, 2] = 5
+    del ary
+    mapped = buffer_view.map().asarray([3, 4], np.int32)
+    self.assertEqual(mapped[1, 2], 5)
+    self.assertEqual(mapped[0, 0], 2)
+
+  def testTransferToHost(self):
+    ary = np.zeros([3, 4], dtype=np.int32) + 2
+    buffer_view = self.allocator.allocate_buffer_copy(
+        memory_type=iree.runtime.MemoryType.DEVICE_LOCAL,
+        allowed_usage=iree.runtime.BufferUsage.CONSTANT,
+        buffer=ary,
+        element_type=iree.runtime.HalElementType.SINT_32)
+    host_buffer_view = self.device.transfer_to_host(buffer_view)
+    self.assertEqual(host_buffer_view.shape, [3, 4])
+    self.assertTrue(host_buffer_view.memory_type &
+                    int(iree.runtime.MemoryType.HOST_VISIBLE))
+    mapped = host_buffer_view.map().asarray([3, 4], np.int32)
+    np.testing.assert_array_equal(mapped, ary)
+
 
 if __name__ == "__main__":
   unittest.main()
@@ -37,6 +37,60 @@ class InvokeContext {
 using PackCallback =
     std::function<void(InvokeContext &, iree_vm_list_t *, py::handle)>;
 
+// Converts the item at an index of a VM list to a Python value.
+using UnpackCallback = std::function<py::object(
+    InvokeContext &, iree_vm_list_t *, iree_host_size_t)>;
+
+// Converts all items of a VM list to a Python sequence or dict.
+using UnpackListCallback =
+    std::function<py::object(InvokeContext &, iree_vm_list_t *)>;
+
+// Returns the list at |index| of |list|, borrowed from it.
+static iree_vm_list_t *GetSubList(iree_vm_list_t *list,
+                                  iree_host_size_t index) {
+  iree_vm_ref_t ref = {0};
+  CheckApiStatus(iree_vm_list_get_ref_assign(list, index, &ref),
+                 "could not access list element");
+  iree_vm_list_t *sub_list = nullptr;
+  CheckApiStatus(iree_vm_list_check_deref(ref, &sub_list),
+                 "could not deref list (wrong type?)");
+  return sub_list;
+}
+
+// Returns the item at |index| of |list| as a Python int or float.
+static py::object GetScalar(iree_vm_list_t *list, iree_host_size_t index,
+                            bool expect_float) {
+  iree_vm_variant_t v = iree_vm_variant_empty();
+  CheckApiStatus(iree_vm_list_get_variant(list, index, &v),
+                 "could not access list element");
+  if (iree_vm_type_def_is_value(&v.type)) {
+    switch (v.type.value_type) {
+      case IREE_VM_VALUE_TYPE_I8:
+        if (!expect_float) return py::int_(v.i8);
+        break;
+      case IREE_VM_VALUE_TYPE_I16:
+        if (!expect_float) return py::int_(v.i16);
+        break;
+      case IREE_VM_VALUE_TYPE_I32:
+        if (!expect_float) return py::int_(v.i32);
+        break;
+      case IREE_VM_VALUE_TYPE_I64:
+        if (!expect_float) return py::int_(v.i64);
+        break;
+      case IREE_VM_VALUE_TYPE_F32:
+        if (expect_float) return py::float_(v.f32);
+        break;
+      case IREE_VM_VALUE_TYPE_F64:
+        if (expect_float) return py::float_(v.f64);
+        break;
+      default:
+        break;
+    }
+  }
+  throw std::invalid_argument(expect_float ? "expected a float value"
+                                           : "expected an int value");
+}
+
 class InvokeStatics {
  public:
   ~InvokeStatics() {
@@ -68,8 +122,12 @@ class InvokeStatics {
   py::str kI32 = py::str("i32");
   py::str kI64 = py::str("i64");
 
+  py::str kF16 = py::str("f16");
+  py::str kBF16 = py::str("bf16");
+
   // Compound types names.
   py::str kNdarray = py::str("ndarray");
+  py::str kPyHomogeneousList = py::str("py_homogeneous_list");
 
   // Attribute names.
   py::str kAttrBufferView = py::str("_buffer_view");
@@ -362,6 +420,124 @@ class InvokeStatics {
     }
   }
 
+  // Given a return ABI desc, return a callback that converts the
+  // corresponding VM list item to a Python value.
+  UnpackCallback AbiTypeToUnpackCallback(py::handle desc) {
+    if (py::isinstance<py::list>(desc)) {
+      py::object compound_type = desc[kZero];
+      if (compound_type.equal(kNdarray)) {
+        // Has format:
+        //   ["ndarray", "f32", rank, dim0, dim1, ...]
+        py::object abi_type = desc[kOne];
+        py::object dtype = MapElementAbiTypeToDtype(abi_type);
+        return [this, dtype = std::move(dtype)](InvokeContext &c,
+                                                iree_vm_list_t *list,
+                                                iree_host_size_t index) {
+          IREE_TRACE_SCOPE0("ResultUnpacker::ReflectionNdarray");
+          return CreateDeviceArray(c, list, index, dtype);
+        };
+      }
+      UnpackListCallback unpack_list = AbiTypeToUnpackListCallback(desc);
+      return [unpack_list = std::move(unpack_list)](InvokeContext &c,
+                                                    iree_vm_list_t *list,
+                                                    iree_host_size_t index) {
+        return unpack_list(c, GetSubList(list, index));
+      };
+    }
+
+    // Primitive type.
+    py::str prim_type = py::cast<py::str>(desc);
+    bool expect_float;
+    if (prim_type.equal(kI8) || prim_type.equal(kI16) ||
+        prim_type.equal(kI32) || prim_type.equal(kI64)) {
+      expect_float = false;
+    } else if (prim_type.equal(kF16) || prim_type.equal(kF32) ||
+               prim_type.equal(kF64) || prim_type.equal(kBF16)) {
+      expect_float = true;
+    } else {
+      std::string message("cannot map VM type to Python: ");
+      message.append(py::cast<std::string>(prim_type));
+      throw std::invalid_argument(message);
+    }
+    return [expect_float](InvokeContext &c, iree_vm_list_t *list,
+                          iree_host_size_t index) {
+      return GetScalar(list, index, expect_float);
+    };
+  }
+
+  // Given the ABI desc of a compound return type, return a callback that
+  // converts the items of the corresponding VM list.
+  UnpackListCallback AbiTypeToUnpackListCallback(py::handle desc) {
+    py::object compound_type = desc[kZero];
+    size_t item_count = py::len(desc) - 1;
+    if (compound_type.equal(kSlistTag) || compound_type.equal(kStupleTag)) {
+      // The descriptor for an slist or stuple is like:
+      //   ['slist', item1, ...]
+      std::vector<UnpackCallback> sub_unpackers(item_count);
+      for (size_t i = 0; i < item_count; ++i) {
+        sub_unpackers[i] = AbiTypeToUnpackCallback(desc[py::int_(i + 1)]);
+      }
+      bool is_tuple = compound_type.equal(kStupleTag);
+      return [sub_unpackers = std::move(sub_unpackers), is_tuple](
+                 InvokeContext &c, iree_vm_list_t *list) -> py::object {
+        CheckListArity(list, sub_unpackers.size());
+        py::list items(sub_unpackers.size());
+        for (size_t i = 0; i < sub_unpackers.size(); ++i) {
+          items[i] = sub_unpackers[i](c, list, i);
+        }
+        if (is_tuple) return py::tuple(items);
+        return std::move(items);
+      };
+    } else if (compound_type.equal(kSdictTag)) {
+      // The descriptor for an sdict is like:
+      //   ['sdict', ['key1', value1], ...]
+      std::vector<std::pair<py::object, UnpackCallback>> sub_unpackers(
+          item_count);
+      for (size_t i = 0; i < item_count; ++i) {
+        py::object sub_desc = desc[py::int_(i + 1)];
+        sub_unpackers[i] = std::make_pair(
+            sub_desc[kZero], AbiTypeToUnpackCallback(sub_desc[kOne]));
+      }
+      return [sub_unpackers = std::move(sub_unpackers)](
+                 InvokeContext &c, iree_vm_list_t *list) -> py::object {
+        CheckListArity(list, sub_unpackers.size());
+        py::dict items;
+        for (size_t i = 0; i < sub_unpackers.size(); ++i) {
+          items[sub_unpackers[i].first] = sub_unpackers[i].second(c, list, i);
+        }
+        return std::move(items);
+      };
+    } else if (compound_type.equal(kPyHomogeneousList)) {
+      // The descriptor for a homogeneous list is like:
+      //   ['py_homogeneous_list', element_type]
+      UnpackCallback element_unpacker = AbiTypeToUnpackCallback(desc[kOne]);
+      return [element_unpacker = std::move(element_unpacker)](
+                 InvokeContext &c, iree_vm_list_t *list) -> py::object {
+        iree_host_size_t size = iree_vm_list_size(list);
+        py::list items(size);
+        for (iree_host_size_t i = 0; i < size; ++i) {
+          items[i] = element_unpacker(c, list, i);
+        }
+        return std::move(items);
+      };
+    }
+    std::string message("cannot map VM type to Python: ");
+    message.append(py::cast<std::string>(py::str(compound_type)));
+    throw std::invalid_argument(message);
+  }
+
+  // Converts the item at |index| of |list| without reflection metadata.
+  // Buffer views are upgraded to DeviceArrays.
+  py::object UnpackDynamic(InvokeContext &c, VmVariantList &list,
+                           iree_host_size_t index) {
+    py::object converted = list.GetVariant(index);
+    if (py::isinstance(converted, hal_buffer_view_type())) {
+      return device_array_type()(py::cast(c.device()), converted,
+                                 py::arg("implicit_host_transfer") = true);
+    }
+    return converted;
+  }
+
   PackCallback GetGenericPackCallbackFor(py::handle arg) {
     PopulatePyTypeToPackCallbacks();
     py::type clazz = py::type::of(arg);
@@ -378,6 +554,37 @@ class InvokeStatics {
   }
 
  private:
+  static void CheckListArity(iree_vm_list_t *list, size_t expected) {
+    iree_host_size_t size = iree_vm_list_size(list);
+    if (size != expected) {
+      std::string message("mismatched return arity: ");
+      message.append(std::to_string(size));
+      message.append(" vs ");
+      message.append(std::to_string(expected));
+      throw std::invalid_argument(std::move(message));
+    }
+  }
+
+  // Wraps the buffer view at |index| of |list| in a DeviceArray that
+  // implicitly transfers to the host, as results are expected to.
+  py::object CreateDeviceArray(InvokeContext &c, iree_vm_list_t *list,
+                               iree_host_size_t index, py::object dtype) {
+    iree_vm_variant_t v = iree_vm_variant_empty();
+    CheckApiStatus(iree_vm_list_get_variant(list, index, &v),
+                   "could not access list element");
+    iree_hal_buffer_view_t *buffer_view = iree_hal_buffer_view_deref(v.ref);
+    if (!buffer_view) {
+      throw std::invalid_argument(
+          "could not deref result buffer view (wrong type?)");
+    }
+    py::object py_buffer_view =
+        py::cast(HalBufferView::BorrowFromRawPtr(buffer_view),
+                 py::return_value_policy::move);
+    return device_array_type()(py::cast(c.device()), py_buffer_view,
+                               py::arg("implicit_host_transfer") = true,
+                               py::arg("override_dtype") = std::move(dtype));
+  }
+
   PackCallback GetGenericPackCallbackForNdarray() {
     return [this](InvokeContext &c, iree_vm_list_t *list, py::handle py_value) {
       IREE_TRACE_SCOPE0("ArgumentPacker::GenericNdarray");
@@ -694,6 +901,106 @@ class ArgumentPacker {
   bool dynamic_dispatch_ = false;
 };
 
+/// Object that can unpack the results of a specific function from a VM list
+/// into Python values.
+class ResultUnpacker {
+ public:
+  ResultUnpacker(InvokeStatics &statics, std::optional<py::list> ret_descs)
+      : statics_(statics) {
+    IREE_TRACE_SCOPE0("ResultUnpacker::Init");
+    if (!ret_descs) {
+      dynamic_dispatch_ = true;
+      return;
+    }
+    // Results described by a single slist/stuple/sdict are inlined into the
+    // result list of the function.
+    if (py::len(*ret_descs) == 1) {
+      py::object desc = (*ret_descs)[statics.kZero];
+      if (py::isinstance<py::list>(desc) && py::len(desc) > 0) {
+        py::object compound_type = desc[statics.kZero];
+        if (compound_type.equal(statics.kSlistTag) ||
+            compound_type.equal(statics.kStupleTag) ||
+            compound_type.equal(statics.kSdictTag)) {
+          try {
+            inlined_unpacker_ = statics.AbiTypeToUnpackListCallback(desc);
+          } catch (std::invalid_argument &e) {
+            inlined_unpacker_ = [message = std::string(e.what())](
+                                    InvokeContext &,
+                                    iree_vm_list_t *) -> py::object {
+              throw std::invalid_argument(message);
+            };
+          }
+          return;
+        }
+      }
+    }
+    for (py::handle desc : *ret_descs) {
+      // Unsupported results only fail the calls that produce them.
+      try {
+        flat_unpackers_.push_back(statics.AbiTypeToUnpackCallback(desc));
+      } catch (std::invalid_argument &e) {
+        flat_unpackers_.push_back(
+            [message = std::string(e.what())](
+                InvokeContext &, iree_vm_list_t *,
+                iree_host_size_t) -> py::object {
+              throw std::invalid_argument(message);
+            });
+      }
+    }
+  }
+
+  /// Unpacks |ret_list| into None, a single value or a tuple of values
+  /// depending on the arity of the function.
+  py::object Unpack(InvokeContext &invoke_context, VmVariantList &ret_list) {
+    iree_vm_list_t *list = ret_list.raw_ptr();
+    iree_host_size_t size = iree_vm_list_size(list);
+    if (inlined_unpacker_) {
+      IREE_TRACE_SCOPE0("ResultUnpacker::UnpackInlined");
+      return inlined_unpacker_(invoke_context, list);
+    }
+
+    std::vector<py::object> results(size);
+    if (dynamic_dispatch_) {
+      IREE_TRACE_SCOPE0("ResultUnpacker::UnpackDynamic");
+      for (iree_host_size_t i = 0; i < size; ++i) {
+        results[i] = statics_.UnpackDynamic(invoke_context, ret_list, i);
+      }
+    } else {
+      IREE_TRACE_SCOPE0("ResultUnpacker::UnpackReflection");
+      if (size != flat_unpackers_.size()) {
+        std::string message("mismatched return arity: ");
+        message.append(std::to_string(size));
+        message.append(" vs ");
+        message.append(std::to_string(flat_unpackers_.size()));
+        throw std::invalid_argument(std::move(message));
+      }
+      for (iree_host_size_t i = 0; i < size; ++i) {
+        results[i] = flat_unpackers_[i](invoke_context, list, i);
+      }
+    }
+
+    if (results.empty()) return py::none();
+    if (results.size() == 1) return std::move(results.front());
+    py::tuple tuple(results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+      tuple[i] = std::move(results[i]);
+    }
+    return std::move(tuple);
+  }
+
+ private:
+  InvokeStatics &statics_;
+
+  std::vector<UnpackCallback> flat_unpackers_;
+
+  // Set if the results are inlined into the result list.
+  UnpackListCallback inlined_unpacker_;
+
+  // If true, then there is no reflection metadata and results are converted
+  // fully dynamically.
+  bool dynamic_dispatch_ = false;
+};
+
 }  // namespace
 
 void SetupInvokeBindings(pybind11::module &m) {
@@ -702,6 +1009,9 @@ void SetupInvokeBindings(pybind11::module &m) {
   py::class_<ArgumentPacker>(m, "ArgumentPacker")
       .def(py::init<InvokeStatics &, std::optional<py::list>>())
       .def("pack", &ArgumentPacker::Pack);
+  py::class_<ResultUnpacker>(m, "ResultUnpacker")
+      .def(py::init<InvokeStatics &, std::optional<py::list>>())
+      .def("unpack", &ResultUnpacker::Unpack);
 
   m.attr("_invoke_statics") = py::cast(InvokeStatics());
 }
@@ -29,13 +29,15 @@ __all__ = [
 ]
 
 import logging
+import mmap
 import os
 import sys
 
 from typing import Any, List, Mapping, Optional, Sequence, Tuple, Union
 
 from . import binding as _binding
-from .function import FunctionInvoker
+from .array_interop import DeviceArray
+from .function import create_invoke_executor, FunctionInvoker
 from . import tracing
 
 import numpy as np
@@ -158,6 +160,10 @@ def normalize_value(
   if isinstance(value, (list, tuple, dict)):
     return value
 
+  # Device arrays are passed to functions as is, without a host round trip.
+  if isinstance(value, DeviceArray):
+    return value
+
   array = np.asarray(value)
   # TODO(#5359): Move into the function abi.
   if isinstance(value, (bool, int, float)):
@@ -225,8 +231,10 @@ class BoundModule:
     # layering and will need to be fixed in some fashion if/when doing
     # heterogenous dispatch.
     return FunctionInvoker(self._context.vm_context,
-                           self._context.config.device, vm_function,
-                           self._context._tracer)
+                           self._context.config.device,
+                           vm_function,
+                           self._context._tracer,
+                           executor=self._context._invoke_executor)
 
   def __repr__(self):
     return f"<BoundModule {repr(self._vm_module)}>"
@@ -268,6 +276,9 @@ class SystemContext:
           (m.name, BoundModule(self, m)) for m in init_vm_modules
       ])
 
+    # Runs the async calls into the context, one at a time.
+    self._invoke_executor = create_invoke_executor()
+
     self._tracer = None  # type: Optional[tracing.ContextTracer]
     if self._config.tracer:
       self._tracer = tracing.ContextTracer(
@@ -343,16 +354,21 @@ def load_vm_flatbuffer(vm_flatbuffer: bytes,
   return bound_module
 
 
-# TODO: There should be an API for mmap'ing the file which should be used
-# instead of reading into memory.
 def load_vm_flatbuffer_file(path: str,
                             *,
                             driver: Optional[str] = None,
                             backend: Optional[str] = None) -> BoundModule:
   """Loads a file containing a VM Flatbuffer into a callable module.
 
+  The file is memory mapped so that only the pages used are read from disk.
+  The mapping is retained by the module for its lifetime.
+
   Either 'driver' or 'backend' must be specified.
   """
   with open(path, "rb") as f:
-    vm_flatbuffer = f.read()
+    try:
+      vm_flatbuffer = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    except ValueError:
+      # Empty files cannot be mapped.
+      vm_flatbuffer = f.read()
   return load_vm_flatbuffer(vm_flatbuffer, driver=driver, backend=backend)
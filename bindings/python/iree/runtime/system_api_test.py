@@ -97,7 +97,11 @@ class SystemApiTest(absltest.TestCase):
     arg1 = np.array([4., 5., 6., 7.], dtype=np.float32)
     results = f(arg0, arg1)
     results2 = f(results, results)
+    # The intermediate result was passed on without a host round trip.
+    self.assertFalse(results.is_host_accessible)
+    self.assertIs(iree.runtime.normalize_value(results), results)
     np.testing.assert_allclose(results2, [16., 100., 324., 784.])
+    self.assertTrue(results2.is_host_accessible)
 
   def test_tracing_explicit(self):
     with tempfile.TemporaryDirectory() as temp_dir:
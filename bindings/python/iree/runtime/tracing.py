@@ -12,6 +12,7 @@ from typing import Dict, List, Optional, Sequence
 import logging
 import os
 import sys
+import time
 
 from . import binding as _binding
 
@@ -30,6 +31,10 @@ __all__ = [
 
 TRACE_PATH_ENV_KEY = "IREE_SAVE_CALLS"
 
+# Buffer contents at least this large are written to a binary sidecar file
+# next to the trace instead of being embedded as base64 in the YAML.
+_SIDECAR_CONTENTS_MIN_SIZE = 1024
+
 
 class Tracer:
   """Object for tracing calls made into the runtime."""
@@ -102,6 +107,9 @@ class ContextTracer:
     self._parent = parent
     self._modules = list(modules)  # type: List[TracedModule]
     self._frame_count = 0
+    # Call timestamps are relative to when tracing of the context began so that
+    # replays can reproduce the inter-arrival timing of calls.
+    self._start_time_ns = time.monotonic_ns()
     self._file_path = os.path.join(parent.trace_path,
                                    parent.get_unique_name("calls.yaml"))
     if os.path.exists(self._file_path):
@@ -110,6 +118,10 @@ class ContextTracer:
         pass
     else:
       os.makedirs(os.path.dirname(parent.trace_path), exist_ok=True)
+    self._contents_file_path = os.path.splitext(self._file_path)[0] + ".bin"
+    self._contents_file_size = 0
+    if os.path.exists(self._contents_file_path):
+      os.remove(self._contents_file_path)
     logging.info("Tracing context events to: %s", self._file_path)
     self.emit_frame({
         "type": "context_load",
@@ -134,9 +146,35 @@ class ContextTracer:
     record = {
         "type": "call",
         "function": "%s.%s" % (function.module_name, function.name),
+        "timestamp_ns": time.monotonic_ns() - self._start_time_ns,
     }
     return CallTrace(self, record)
 
+  def externalize_contents(self, record):
+    """Moves large buffer contents in a trace value to the sidecar file.
+
+    The replay maps the sidecar and copies the contents directly instead of
+    decoding them from the YAML.
+    """
+    if not isinstance(record, dict):
+      return record
+    if record.get("type") == "vm.list":
+      record["items"] = [
+          self.externalize_contents(item) for item in record["items"]
+      ]
+      return record
+    contents = record.get("contents")
+    if not isinstance(contents, bytes) or len(
+        contents) < _SIDECAR_CONTENTS_MIN_SIZE:
+      return record
+    with open(self._contents_file_path, "ab") as f:
+      f.write(contents)
+    del record["contents"]
+    record["contents_file"] = os.path.basename(self._contents_file_path)
+    record["contents_offset"] = self._contents_file_size
+    self._contents_file_size += len(contents)
+    return record
+
   def emit_frame(self, frame: dict):
     self._frame_count += 1
     with open(self._file_path, "at") as f:
@@ -155,7 +193,9 @@ class CallTrace:
   def add_vm_list(self, vm_list: _binding.VmVariantList, key: str):
     mapped = []
     for i in range(len(vm_list)):
-      mapped.append(vm_list.get_serialized_trace_value(i))
+      mapped.append(
+          self._parent.externalize_contents(
+              vm_list.get_serialized_trace_value(i)))
     self._record[key] = mapped
 
   def end_call(self):
@@ -12,7 +12,12 @@
 #include "iree/base/internal/call_once.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/drivers/init.h"
+#include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/loaders/embedded_library_loader.h"
+#include "iree/hal/local/loaders/system_library_loader.h"
+#include "iree/hal/local/task_device.h"
 #include "iree/modules/hal/module.h"
+#include "iree/task/api.h"
 
 //===----------------------------------------------------------------------===//
 // HAL / driver support
@@ -25,35 +30,104 @@ static void _TfLiteInterpreterRegisterDrivers(void) {
       iree_hal_driver_registry_default()));
 }
 
-// TODO(#3977): if already provided a HAL device in the options use that.
+// Creates a dylib device whose task executor has |worker_count| workers.
+// The driver registry creates executors configured by the global task flags,
+// which embedders of the tflite API can't set.
+static iree_status_t _TfLiteInterpreterCreateDylibDevice(
+    iree_host_size_t worker_count, iree_allocator_t host_allocator,
+    iree_hal_device_t** out_device) {
+  iree_hal_task_device_params_t params;
+  iree_hal_task_device_params_initialize(&params);
+
+  iree_status_t status = iree_ok_status();
+
+  iree_hal_executable_loader_t* loaders[2] = {NULL, NULL};
+  iree_host_size_t loader_count = 0;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_embedded_library_loader_create(
+        iree_hal_executable_import_provider_null(), host_allocator,
+        &loaders[loader_count++]);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_system_library_loader_create(
+        iree_hal_executable_import_provider_null(), host_allocator,
+        &loaders[loader_count++]);
+  }
+
+  iree_task_executor_t* executor = NULL;
+  if (iree_status_is_ok(status)) {
+    iree_task_executor_options_t options;
+    iree_task_executor_options_initialize(&options);
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(worker_count, &topology);
+    status = iree_task_executor_create(&options, &topology, host_allocator,
+                                       &executor);
+    iree_task_topology_deinitialize(&topology);
+  }
+
+  iree_hal_allocator_t* device_allocator = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_allocator_create_heap(iree_make_cstring_view("cpu"),
+                                            host_allocator, host_allocator,
+                                            &device_allocator);
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_task_device_create(
+        iree_make_cstring_view("cpu"), &params, executor, loader_count,
+        loaders, device_allocator, host_allocator, out_device);
+  }
+
+  iree_hal_allocator_release(device_allocator);
+  iree_task_executor_release(executor);
+  for (iree_host_size_t i = 0; i < loader_count; ++i) {
+    iree_hal_executable_loader_release(loaders[i]);
+  }
+  return status;
+}
+
 static iree_status_t _TfLiteInterpreterPrepareHAL(
     TfLiteInterpreter* interpreter) {
-  iree_call_once(&_TfLiteInterpreterRegisterDriverFlag,
-                 _TfLiteInterpreterRegisterDrivers);
-
-  iree_hal_driver_registry_t* driver_registry =
-      iree_hal_driver_registry_default();
+  const TfLiteInterpreterOptions* options = &interpreter->options;
+  if (options->device) {
+    // Shared with other interpreters; the device is already configured.
+    interpreter->device = options->device;
+    iree_hal_device_retain(interpreter->device);
+    return iree_hal_module_create(interpreter->device, interpreter->allocator,
+                                  &interpreter->hal_module);
+  }
 
-  iree_hal_driver_info_t* driver_infos = NULL;
-  iree_host_size_t driver_info_count = 0;
-  IREE_RETURN_IF_ERROR(iree_hal_driver_registry_enumerate(
-      driver_registry, interpreter->allocator, &driver_infos,
-      &driver_info_count));
+  // NOTE: the sample files are compiled only with vmvx so that's the default.
+  iree_string_view_t driver_name = iree_make_cstring_view(
+      options->driver_name[0] ? options->driver_name : "vmvx");
+
+  if (options->num_threads >= 0 &&
+      iree_string_view_equal(driver_name, iree_make_cstring_view("dylib"))) {
+    // As in tflite the calling thread counts as one of the threads (and 0
+    // means 1): it executes tasks while waiting on the invocation.
+    iree_host_size_t worker_count =
+        options->num_threads > 1 ? (iree_host_size_t)options->num_threads - 1
+                                 : 0;
+    IREE_RETURN_IF_ERROR(_TfLiteInterpreterCreateDylibDevice(
+        worker_count, interpreter->allocator, &interpreter->device));
+    return iree_hal_module_create(interpreter->device, interpreter->allocator,
+                                  &interpreter->hal_module);
+  } else if (options->num_threads >= 0) {
+    IREE_TRACE_MESSAGE(WARNING,
+                       "TfLiteInterpreterOptionsSetNumThreads: thread counts "
+                       "are only supported by the dylib driver and ignored");
+  }
 
-  // TODO(benvanik): figure out how we want to emulate device selection; may
-  // just say "whatever is first" on a query.
-  // iree_string_view_t driver_name = driver_infos[0].driver_name;
-  // NOTE: currently the sample file is compiled only with vmvx.
-  iree_string_view_t driver_name = iree_make_cstring_view("vmvx");
+  iree_call_once(&_TfLiteInterpreterRegisterDriverFlag,
+                 _TfLiteInterpreterRegisterDrivers);
 
   // TODO(benvanik): switch to iree_hal_driver_registry_try_create when
   // implemented.
-  iree_status_t status = iree_hal_driver_registry_try_create_by_name(
-      driver_registry, driver_name, interpreter->allocator,
-      &interpreter->driver);
-  iree_allocator_free(interpreter->allocator, driver_infos);
-  IREE_RETURN_IF_ERROR(status, "failed to create driver '%.*s'",
-                       (int)driver_name.size, driver_name.data);
+  IREE_RETURN_IF_ERROR(iree_hal_driver_registry_try_create_by_name(
+                           iree_hal_driver_registry_default(), driver_name,
+                           interpreter->allocator, &interpreter->driver),
+                       "failed to create driver '%.*s'", (int)driver_name.size,
+                       driver_name.data);
 
   IREE_RETURN_IF_ERROR(
       iree_hal_driver_create_default_device(
@@ -197,11 +271,10 @@ static iree_status_t _TfLiteInterpreterRefreshOutputShapes(
   return iree_ok_status();
 }
 
-// Refreshes both input and output tensor shapes by querying the module.
-// This should be called after each shape change so that we can let the module
-// run "shape propagation" and compute the new output shapes.
-static iree_status_t _TfLiteInterpreterRefreshIOShapes(
-    TfLiteInterpreter* interpreter) {
+// Refreshes the output and optionally the input tensor shapes by querying the
+// module. Inputs only change shape when resized by the user.
+static iree_status_t _TfLiteInterpreterRefreshShapes(
+    TfLiteInterpreter* interpreter, bool refresh_inputs) {
   IREE_TRACE_ZONE_BEGIN(z0);
   _TfLiteInterpreterShapeFrame frame;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -209,7 +282,7 @@ static iree_status_t _TfLiteInterpreterRefreshIOShapes(
 
   // Query all shapes.
   iree_status_t status = iree_ok_status();
-  if (iree_status_is_ok(status)) {
+  if (iree_status_is_ok(status) && refresh_inputs) {
     status = _TfLiteInterpreterRefreshInputShapes(interpreter, &frame);
   }
   if (iree_status_is_ok(status)) {
@@ -221,6 +294,22 @@ static iree_status_t _TfLiteInterpreterRefreshIOShapes(
   return status;
 }
 
+// Refreshes both input and output tensor shapes by querying the module.
+// This should be called after each shape change so that we can let the module
+// run "shape propagation" and compute the new output shapes.
+static iree_status_t _TfLiteInterpreterRefreshIOShapes(
+    TfLiteInterpreter* interpreter) {
+  return _TfLiteInterpreterRefreshShapes(interpreter, /*refresh_inputs=*/true);
+}
+
+// Releases the outputs of the previous invocation, if any.
+static void _TfLiteInterpreterReleaseOutputs(TfLiteInterpreter* interpreter) {
+  IREE_IGNORE_ERROR(iree_vm_list_resize(interpreter->output_list, 0));
+  for (iree_host_size_t i = 0; i < interpreter->model->output_count; ++i) {
+    _TfLiteTensorDiscardBuffer(&interpreter->output_tensors[i]);
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // Creation and static initialization
 //===----------------------------------------------------------------------===//
@@ -340,6 +429,93 @@ static iree_status_t _TfLiteInterpreterPopulateIO(
   return iree_ok_status();
 }
 
+// Creates a new context for the interpreter along with its own device.
+static iree_status_t _TfLiteInterpreterCreateContext(
+    TfLiteInterpreter* interpreter) {
+  // External contexts could possibly used to emulate sharing this, but really
+  // if a user is running with multiple models the tflite API is insufficient.
+  IREE_RETURN_IF_ERROR(
+      iree_vm_instance_create(interpreter->allocator, &interpreter->instance));
+  IREE_RETURN_IF_ERROR(_TfLiteInterpreterPrepareHAL(interpreter));
+
+  // Context will contain both the user-provided bytecode and the HAL module.
+  // If we were to support custom ops we would also have a
+  // tflite_resolver_module that we would register to resolve tflite ops into
+  // IREE functions that will call custom ops through TfLiteRegistrations.
+  return iree_vm_context_create_with_modules(
+      interpreter->instance, IREE_VM_CONTEXT_FLAG_NONE,
+      interpreter->all_modules, IREE_ARRAYSIZE(interpreter->all_modules),
+      interpreter->allocator, &interpreter->context);
+}
+
+// Returns true if an interpreter created with |options| can use the device
+// that |shared_state| was created with.
+static bool _TfLiteInterpreterCanShareState(
+    const TfLiteInterpreterOptions* options,
+    const _TfLiteModelSharedState* shared_state) {
+  if (options->device) return options->device == shared_state->device;
+  const TfLiteInterpreterOptions* shared_options = &shared_state->options;
+  return !shared_options->device &&
+         options->num_threads == shared_options->num_threads &&
+         strcmp(options->driver_name, shared_options->driver_name) == 0;
+}
+
+// Prepares the interpreter context by forking the template context of the
+// model, creating the template if this is the first interpreter of the model.
+// Interpreters that need a different device get a context of their own.
+static iree_status_t _TfLiteInterpreterPrepareContext(
+    TfLiteInterpreter* interpreter) {
+  TfLiteModel* model = interpreter->model;
+  _TfLiteModelSharedState* shared_state = &model->shared_state;
+  iree_slim_mutex_lock(&model->shared_state_mutex);
+
+  iree_status_t status = iree_ok_status();
+  if (!shared_state->context) {
+    // The template runs the module initializers on behalf of all interpreters.
+    status = _TfLiteInterpreterCreateContext(interpreter);
+    if (iree_status_is_ok(status)) {
+      status = iree_vm_context_freeze(interpreter->context);
+    }
+    if (iree_status_is_ok(status)) {
+      memcpy(&shared_state->options, &interpreter->options,
+             sizeof(shared_state->options));
+      shared_state->instance = interpreter->instance;
+      iree_vm_instance_retain(shared_state->instance);
+      shared_state->driver = interpreter->driver;
+      iree_hal_driver_retain(shared_state->driver);
+      shared_state->device = interpreter->device;
+      iree_hal_device_retain(shared_state->device);
+      shared_state->hal_module = interpreter->hal_module;
+      iree_vm_module_retain(shared_state->hal_module);
+      shared_state->context = interpreter->context;
+      interpreter->context = NULL;
+    }
+  } else if (_TfLiteInterpreterCanShareState(&interpreter->options,
+                                             shared_state)) {
+    interpreter->instance = shared_state->instance;
+    iree_vm_instance_retain(interpreter->instance);
+    interpreter->driver = shared_state->driver;
+    iree_hal_driver_retain(interpreter->driver);
+    interpreter->device = shared_state->device;
+    iree_hal_device_retain(interpreter->device);
+    interpreter->hal_module = shared_state->hal_module;
+    iree_vm_module_retain(interpreter->hal_module);
+  } else {
+    iree_slim_mutex_unlock(&model->shared_state_mutex);
+    return _TfLiteInterpreterCreateContext(interpreter);
+  }
+
+  // Executables and constant buffers are shared with the template while the
+  // module globals and HAL module state are per-interpreter.
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_context_fork(shared_state->context, interpreter->allocator,
+                                  &interpreter->context);
+  }
+
+  iree_slim_mutex_unlock(&model->shared_state_mutex);
+  return status;
+}
+
 static iree_status_t _TfLiteInterpreterCreate(
     const TfLiteModel* model, const TfLiteInterpreterOptions* optional_options,
     TfLiteInterpreter** out_interpreter) {
@@ -359,20 +535,7 @@ static iree_status_t _TfLiteInterpreterCreate(
   interpreter->user_module = model->module;
   iree_vm_module_retain(interpreter->user_module);
 
-  // External contexts could possibly used to emulate sharing this, but really
-  // if a user is running with multiple models the tflite API is insufficient.
-  IREE_RETURN_IF_ERROR(
-      iree_vm_instance_create(interpreter->allocator, &interpreter->instance));
-  IREE_RETURN_IF_ERROR(_TfLiteInterpreterPrepareHAL(interpreter));
-
-  // Context will contain both the user-provided bytecode and the HAL module.
-  // If we were to support custom ops we would also have a
-  // tflite_resolver_module that we would register to resolve tflite ops into
-  // IREE functions that will call custom ops through TfLiteRegistrations.
-  IREE_RETURN_IF_ERROR(iree_vm_context_create_with_modules(
-      interpreter->instance, IREE_VM_CONTEXT_FLAG_NONE,
-      interpreter->all_modules, IREE_ARRAYSIZE(interpreter->all_modules),
-      interpreter->allocator, &interpreter->context));
+  IREE_RETURN_IF_ERROR(_TfLiteInterpreterPrepareContext(interpreter));
 
   // Setup all I/O tensors and buffer views.
   IREE_RETURN_IF_ERROR(_TfLiteInterpreterPopulateIO(interpreter));
@@ -426,6 +589,8 @@ TFL_CAPI_EXPORT extern void TfLiteInterpreterDelete(
   iree_vm_context_release(interpreter->context);
   iree_vm_module_release(interpreter->hal_module);
   iree_vm_module_release(interpreter->user_module);
+  iree_hal_device_release(interpreter->device);
+  iree_hal_driver_release(interpreter->driver);
   iree_vm_instance_release(interpreter->instance);
 
   _TfLiteModelRelease(interpreter->model);
@@ -434,6 +599,17 @@ TFL_CAPI_EXPORT extern void TfLiteInterpreterDelete(
   IREE_TRACE_ZONE_END(z0);
 }
 
+TfLiteStatus _TfLiteInterpreterTrimMemory(TfLiteInterpreter* interpreter,
+                                          bool critical) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status =
+      critical ? iree_hal_device_trim(interpreter->device)
+               : iree_hal_allocator_trim(
+                     iree_hal_device_allocator(interpreter->device));
+  IREE_TRACE_ZONE_END(z0);
+  return _TfLiteStatusFromIREEStatus(status);
+}
+
 TFL_CAPI_EXPORT extern TfLiteStatus TfLiteInterpreterResetVariableTensors(
     TfLiteInterpreter* interpreter) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -467,6 +643,68 @@ TFL_CAPI_EXPORT extern TfLiteTensor* TfLiteInterpreterGetInputTensor(
   return &interpreter->input_tensors[input_index];
 }
 
+static iree_status_t _TfLiteInterpreterImportInputTensorData(
+    TfLiteInterpreter* interpreter, int32_t input_index, void* data,
+    size_t data_size) {
+  if (input_index < 0 || input_index >= interpreter->model->input_count) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "input index %d out of range", input_index);
+  }
+  TfLiteTensor* tensor = &interpreter->input_tensors[input_index];
+  if (!tensor->buffer) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "tensors must be allocated first");
+  }
+  iree_hal_allocator_t* device_allocator =
+      iree_hal_device_allocator(interpreter->device);
+
+  if (data) {
+    if (data_size != iree_hal_buffer_byte_length(tensor->buffer)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "data size %zu does not match the tensor size",
+                              data_size);
+    }
+    // The devices that can't access the memory directly fail the import and
+    // the user falls back to copying.
+    iree_hal_external_buffer_t external_buffer = {
+        .type = IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION,
+        .flags = 0,
+        .size = data_size,
+        .handle.host_allocation.ptr = data,
+    };
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_allocator_import_buffer(
+        device_allocator,
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+        IREE_HAL_MEMORY_ACCESS_ALL, IREE_HAL_BUFFER_USAGE_ALL, &external_buffer,
+        &buffer));
+    iree_status_t status = _TfLiteTensorBind(tensor, buffer);
+    iree_hal_buffer_release(buffer);
+    IREE_RETURN_IF_ERROR(status);
+    tensor->is_external = true;
+  } else if (tensor->is_external) {
+    IREE_RETURN_IF_ERROR(_TfLiteTensorReallocateIfNeeded(
+        tensor, device_allocator, interpreter->allocator));
+  } else {
+    return iree_ok_status();
+  }
+
+  iree_vm_ref_t buffer_ref = iree_hal_buffer_retain_ref(tensor->buffer);
+  return iree_vm_list_set_ref_move(interpreter->input_list, input_index,
+                                   &buffer_ref);
+}
+
+TfLiteStatus _TfLiteInterpreterSetInputTensorData(
+    TfLiteInterpreter* interpreter, int32_t input_index, void* data,
+    size_t data_size) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, data_size);
+  iree_status_t status = _TfLiteInterpreterImportInputTensorData(
+      interpreter, input_index, data, data_size);
+  IREE_TRACE_ZONE_END(z0);
+  return _TfLiteStatusFromIREEStatus(status);
+}
+
 static iree_status_t _TfLiteInterpreterResizeInputTensor(
     TfLiteInterpreter* interpreter, int32_t input_index, const int* input_dims,
     int32_t input_dims_size) {
@@ -524,6 +762,15 @@ static iree_status_t _TfLiteInterpreterAllocateTensors(
   // Refresh all shapes from the model. It should have all of the
   // non-data-dependent output shapes.
   IREE_RETURN_IF_ERROR(_TfLiteInterpreterRefreshIOShapes(interpreter));
+  interpreter->has_dynamic_output_shapes = false;
+  for (iree_host_size_t i = 0; i < interpreter->model->output_count; ++i) {
+    const TfLiteTensor* tensor = &interpreter->output_tensors[i];
+    for (int32_t j = 0; j < tensor->shape_rank; ++j) {
+      if (tensor->shape_dims[j] < 0) {
+        interpreter->has_dynamic_output_shapes = true;
+      }
+    }
+  }
 
   // Drop all input tensors we hang on to in the input list. This way we aren't
   // double-allocating during the resize.
@@ -540,12 +787,9 @@ static iree_status_t _TfLiteInterpreterAllocateTensors(
         iree_vm_list_push_ref_move(interpreter->input_list, &buffer_ref));
   }
 
-  // TODO(benvanik): preallocate outputs when we support using them.
-  // We could stash the buffer views in interpreter->output_list.
-  // For now we just drop them all.
-  for (iree_host_size_t i = 0; i < interpreter->model->output_count; ++i) {
-    _TfLiteTensorDiscardBuffer(&interpreter->output_tensors[i]);
-  }
+  // The model allocates its outputs and the old ones no longer match the new
+  // shapes, so drop them all.
+  _TfLiteInterpreterReleaseOutputs(interpreter);
 
   return iree_ok_status();
 }
@@ -570,6 +814,11 @@ TFL_CAPI_EXPORT extern TfLiteStatus TfLiteInterpreterAllocateTensors(
 }
 
 static iree_status_t _TfLiteInterpreterInvoke(TfLiteInterpreter* interpreter) {
+  // The model allocates new outputs on each invocation. Releasing the previous
+  // ones first returns their storage to the device allocator cache so that
+  // same-sized outputs reuse it instead of growing the heap at every call.
+  _TfLiteInterpreterReleaseOutputs(interpreter);
+
   // tflite models only have a single entry point and the IREE converter
   // emits it as '_main'.
   IREE_RETURN_IF_ERROR(
@@ -578,13 +827,15 @@ static iree_status_t _TfLiteInterpreterInvoke(TfLiteInterpreter* interpreter) {
                      /*policy=*/NULL, interpreter->input_list,
                      interpreter->output_list, interpreter->allocator));
 
-  // Refresh output shapes.
-  // TODO(#3975): just use buffer view results or at least just refresh outputs.
-  IREE_RETURN_IF_ERROR(_TfLiteInterpreterRefreshIOShapes(interpreter));
+  // Refresh data-dependent output shapes; input shapes can't change during
+  // invocation and the other output shapes were known when allocating.
+  // TODO(#3975): just use buffer view results.
+  if (interpreter->has_dynamic_output_shapes) {
+    IREE_RETURN_IF_ERROR(
+        _TfLiteInterpreterRefreshShapes(interpreter, /*refresh_inputs=*/false));
+  }
 
-  // Map the output buffers.
-  // NOTE: we could defer the mapping unless requested and ensure state buffers
-  // remain where they currently are for the next invocation.
+  // Bind the output buffers. They are mapped when first accessed.
   for (iree_host_size_t i = 0; i < interpreter->model->output_count; ++i) {
     iree_hal_buffer_t* buffer = (iree_hal_buffer_t*)iree_vm_list_get_ref_deref(
         interpreter->output_list, i, iree_hal_buffer_get_descriptor());
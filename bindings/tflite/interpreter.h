@@ -43,6 +43,30 @@ struct TfLiteInterpreter {
   iree_vm_list_t* output_list;
   TfLiteTensor* input_tensors;
   TfLiteTensor* output_tensors;
+
+  // True if the output shapes queried when allocating tensors were not fully
+  // resolved and must be queried again after each invocation.
+  bool has_dynamic_output_shapes;
 };
 
+// IREE extension: releases cached and pooled memory held by the interpreter's
+// device. When |critical| is false only cached allocations that went unused
+// since the previous trim are released; otherwise the device is trimmed to the
+// minimum required for live allocations, including its task executor and arena
+// block pools. Intended to be called from OS memory pressure callbacks and may
+// be called from any thread concurrently with TfLiteInterpreterInvoke.
+TfLiteStatus _TfLiteInterpreterTrimMemory(TfLiteInterpreter* interpreter,
+                                          bool critical);
+
+// IREE extension: makes the input tensor at |input_index| use the |data_size|
+// bytes at |data| as its storage instead of copying them, when the device can
+// access that memory. The memory must remain valid and must not be modified
+// during invocations until the tensor is reallocated, the interpreter is
+// deleted or its data is set again. Passing NULL |data| restores memory owned
+// by the interpreter. Tensors must have been allocated and |data_size| must
+// match TfLiteTensorByteSize.
+TfLiteStatus _TfLiteInterpreterSetInputTensorData(
+    TfLiteInterpreter* interpreter, int32_t input_index, void* data,
+    size_t data_size);
+
 #endif  // IREE_BINDINGS_TFLITE_INTERPRETER_H_
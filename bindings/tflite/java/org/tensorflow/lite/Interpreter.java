@@ -8,6 +8,7 @@
 
 package org.tensorflow.lite;
 
+import android.content.ComponentCallbacks2;
 import androidx.annotation.NonNull;
 import java.nio.Buffer;
 import java.nio.ByteBuffer;
@@ -200,6 +201,9 @@ public final class Interpreter implements AutoCloseable {
    * <p>Note: that the number of elements in single/multi arrays should match the tensor's {@link
    * Tensor#numElements()} output, else inference will fail.
    *
+   * <p>Direct input buffers are used by the device without copies when it can access their memory
+   * and are otherwise copied. They must not be modified while inference is running.
+   *
    * @param input a {@link java.nio.Buffer} with correct capacity populated with tensor input.
    * @param output an empty {@link java.nio.Buffer} to be filled with tensor output. The caller must
    *     ensure that it is set to the appropriate write position and remaining capacity.
@@ -286,6 +290,11 @@ public final class Interpreter implements AutoCloseable {
     if (nativeAllocateTensors() != 0) {
       throw new IllegalStateException("Failed to allocate Tensors.");
     }
+    for (Tensor inputTensor : inputTensors) {
+      if (inputTensor != null) {
+        inputTensor.onTensorsReallocated();
+      }
+    }
     tensorsAllocated = true;
   }
 
@@ -383,6 +392,26 @@ public final class Interpreter implements AutoCloseable {
     return inferenceDurationNanoseconds;
   }
 
+  /**
+   * Releases cached memory held by the interpreter in response to memory pressure.
+   *
+   * <p>Intended to be called from {@link ComponentCallbacks2#onTrimMemory(int)} with the level
+   * provided by the system. Levels at or above {@link ComponentCallbacks2#TRIM_MEMORY_RUNNING_LOW}
+   * release all possible memory (at the cost of reallocating it on the next inference) while lower
+   * levels, including {@link ComponentCallbacks2#TRIM_MEMORY_UI_HIDDEN}, only release cached memory
+   * that went unused since the previous trim. May be called from any thread.
+   *
+   * @param level the trim level provided to {@code onTrimMemory}.
+   * @throws IllegalStateException if trimming fails.
+   */
+  public void trimMemory(int level) {
+    boolean critical = level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW
+        && level != ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN;
+    if (nativeTrimMemory(critical) != 0) {
+      throw new IllegalStateException("Failed to trim memory");
+    }
+  }
+
   /** Release resources associated with the {@code Interpreter}. */
   @Override
   public void close() {
@@ -402,4 +431,6 @@ public final class Interpreter implements AutoCloseable {
   private native int nativeResizeInputTensor(int inputIndex, int[] dims);
 
   private native int nativeInvoke();
+
+  private native int nativeTrimMemory(boolean critical);
 }
@@ -30,7 +30,7 @@ public final class Tensor {
     if (nativeAddress == 0) {
       throw new RuntimeException(String.format("Failed to create input tensor %d", tensorIndex));
     }
-    return new Tensor(nativeAddress, tensorIndex);
+    return new Tensor(nativeAddress, nativeInterpreterHandle, tensorIndex);
   }
 
   static Tensor outputFromIndex(long nativeInterpreterHandle, int tensorIndex) {
@@ -38,7 +38,7 @@ public final class Tensor {
     if (nativeAddress == 0) {
       throw new RuntimeException(String.format("Failed to create output tensor %d", tensorIndex));
     }
-    return new Tensor(nativeAddress, tensorIndex);
+    return new Tensor(nativeAddress, 0, tensorIndex);
   }
 
   /**
@@ -164,6 +164,10 @@ public final class Tensor {
 
   void copyFromBuffer(Buffer inputBuffer) {
     checkBufferCapacity(inputBuffer);
+    if (isDirectBuffer(inputBuffer) && importDirectBuffer(inputBuffer)) {
+      return;
+    }
+    releaseImportedBuffer();
     if (isDirectBuffer(inputBuffer)) {
       copyFromDirectBuffer(inputBuffer);
     } else {
@@ -243,6 +247,48 @@ public final class Tensor {
     }
   }
 
+  /**
+   * Makes the input tensor use the memory of {@code inputBuffer} directly instead of a copy of it.
+   * The buffer is kept referenced while in use and must not be modified during inference.
+   *
+   * @return false if the memory cannot be used by the device, in which case it must be copied.
+   */
+  private boolean importDirectBuffer(Buffer inputBuffer) {
+    if (nativeInterpreterHandle == 0) {
+      return false;
+    }
+    if (inputBuffer == importedBuffer) {
+      return true;
+    }
+    if (nativeImportDirectBuffer(nativeInterpreterHandle, tensorIndex, inputBuffer) != 0) {
+      return false;
+    }
+    importedBuffer = inputBuffer;
+    return true;
+  }
+
+  /** Restores the memory owned by the interpreter if a buffer was imported. */
+  void releaseImportedBuffer() {
+    if (importedBuffer == null) {
+      return;
+    }
+    importedBuffer = null;
+    int statusCode = nativeImportDirectBuffer(nativeInterpreterHandle, tensorIndex, null);
+    if (statusCode != 0) {
+      throw new IllegalStateException(
+          String.format("Unable to reallocate input tensor(%d). Return code: %d",
+              tensorIndex, statusCode));
+    }
+  }
+
+  /**
+   * Forgets the imported buffer after the interpreter reallocated the tensor memory, e.g. in
+   * {@link Interpreter#allocateTensors()}.
+   */
+  void onTensorsReallocated() {
+    importedBuffer = null;
+  }
+
   private void copyFromDirectBuffer(Buffer inputBuffer) {
     int statusCode = nativeCopyFromDirectBuffer(inputBuffer);
     if (statusCode != 0) {
@@ -266,12 +312,17 @@ public final class Tensor {
   }
 
   private final long nativeAddress;
+  // Handle of the owning interpreter for input tensors and 0 for outputs.
+  private final long nativeInterpreterHandle;
   private final int tensorIndex;
   private final QuantizationParams quantizationParams;
   private final int shapeSignature[];
+  // Direct buffer whose memory backs the input tensor, if any.
+  private Buffer importedBuffer;
 
-  private Tensor(long nativeAddress, int tensorIndex) {
+  private Tensor(long nativeAddress, long nativeInterpreterHandle, int tensorIndex) {
     this.nativeAddress = nativeAddress;
+    this.nativeInterpreterHandle = nativeInterpreterHandle;
     this.tensorIndex = tensorIndex;
     this.quantizationParams =
         new QuantizationParams(nativeQuantizationScale(), nativeQuantizationZeroPoint());
@@ -298,6 +349,9 @@ public final class Tensor {
 
   private native int nativeCopyFromDirectBuffer(Buffer inputByteBuffer);
 
+  private static native int nativeImportDirectBuffer(
+      long interpreterAddress, int inputIndex, Buffer inputByteBuffer);
+
   private native int nativeCopyToDirectBuffer(Buffer outputByteBuffer);
 
   private native ByteBuffer nativeGetByteBuffer();
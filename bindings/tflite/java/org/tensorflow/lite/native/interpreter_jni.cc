@@ -15,6 +15,11 @@
 #define JNI_FUNC extern "C" JNIEXPORT
 #define JNI_PREFIX(METHOD) Java_org_tensorflow_lite_Interpreter_##METHOD
 
+// IREE extension defined in bindings/tflite/interpreter.h. That header exposes
+// the C interpreter internals and is not included here.
+extern "C" TfLiteStatus _TfLiteInterpreterTrimMemory(
+    TfLiteInterpreter* interpreter, bool critical);
+
 namespace {
 
 // Returns a pointer to the native IREE module stored by the GetInterpreter
@@ -111,3 +116,13 @@ JNI_FUNC jint JNI_PREFIX(nativeInvoke)(JNIEnv* env, jobject thiz) {
 
   return (jint)TfLiteInterpreterInvoke(interpreter);
 }
+
+JNI_FUNC jint JNI_PREFIX(nativeTrimMemory)(JNIEnv* env, jobject thiz,
+                                           jboolean critical) {
+  TfLiteInterpreter* interpreter = GetInterpreter(env, thiz);
+  if (!interpreter) {
+    return kTfLiteError;  // Failed get handle. Returning to error in Java.
+  }
+
+  return (jint)_TfLiteInterpreterTrimMemory(interpreter, critical == JNI_TRUE);
+}
@@ -15,6 +15,12 @@
 #define JNI_FUNC extern "C" JNIEXPORT
 #define JNI_PREFIX(METHOD) Java_org_tensorflow_lite_Tensor_##METHOD
 
+// IREE extension defined in bindings/tflite/interpreter.h. That header exposes
+// the C interpreter internals and is not included here.
+extern "C" TfLiteStatus _TfLiteInterpreterSetInputTensorData(
+    TfLiteInterpreter* interpreter, int32_t input_index, void* data,
+    size_t data_size);
+
 namespace {
 
 // Returns a pointer to the native IREE module stored by the GetTensor
@@ -137,6 +143,32 @@ JNI_FUNC jint JNI_PREFIX(nativeCopyFromDirectBuffer)(
                                           TfLiteTensorByteSize(tensor));
 }
 
+JNI_FUNC jint JNI_PREFIX(nativeImportDirectBuffer)(JNIEnv* env, jclass clazz,
+                                                   jlong interpreter_handle,
+                                                   jint input_index,
+                                                   jobject input_byte_buffer) {
+  TfLiteInterpreter* interpreter = (TfLiteInterpreter*)interpreter_handle;
+  if (!interpreter) {
+    return kTfLiteError;  // Null handle input. Returning to error in Java.
+  }
+  if (!input_byte_buffer) {
+    // Restores the storage owned by the interpreter.
+    return (jint)_TfLiteInterpreterSetInputTensorData(interpreter, input_index,
+                                                      nullptr, 0);
+  }
+  TfLiteTensor* tensor =
+      TfLiteInterpreterGetInputTensor(interpreter, input_index);
+  if (!tensor) {
+    return kTfLiteError;  // Invalid index. Returning to error in Java.
+  }
+  void* buf = env->GetDirectBufferAddress(input_byte_buffer);
+
+  // Note: as with the copies below the tensor size is used rather than the
+  // buffer capacity, which Java has already checked.
+  return (jint)_TfLiteInterpreterSetInputTensorData(
+      interpreter, input_index, buf, TfLiteTensorByteSize(tensor));
+}
+
 JNI_FUNC jint JNI_PREFIX(nativeCopyToDirectBuffer)(JNIEnv* env, jobject thiz,
                                                    jobject output_byte_buffer) {
   const TfLiteTensor* tensor = GetTensor(env, thiz);
@@ -6,9 +6,9 @@
 
 #include "bindings/tflite/model.h"
 
-#include <stdio.h>
 #include <string.h>
 
+#include "iree/base/internal/file_io.h"
 #include "iree/base/tracing.h"
 #include "iree/modules/hal/module.h"
 #include "iree/vm/bytecode_module.h"
@@ -37,17 +37,17 @@ static iree_status_t _TfLiteModelCalculateFunctionIOCounts(
   return iree_ok_status();
 }
 
-static iree_status_t _TfLiteModelInitializeModule(const void* flatbuffer_data,
-                                                  size_t flatbuffer_size,
-                                                  iree_allocator_t allocator,
-                                                  TfLiteModel* model) {
+// Creates the model module from |flatbuffer_span|. If creation succeeds the
+// module takes ownership of the flatbuffer and frees it with
+// |flatbuffer_allocator| when destroyed.
+static iree_status_t _TfLiteModelInitializeModule(
+    iree_const_byte_span_t flatbuffer_span,
+    iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
+    TfLiteModel* model) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   IREE_RETURN_AND_END_ZONE_IF_ERROR(z0, _TfLiteModelPrepareRuntime());
 
-  iree_const_byte_span_t flatbuffer_span =
-      iree_make_const_byte_span(flatbuffer_data, flatbuffer_size);
-  iree_allocator_t flatbuffer_allocator = iree_allocator_null();
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0,
       iree_vm_bytecode_module_create(flatbuffer_span, flatbuffer_allocator,
@@ -118,10 +118,12 @@ TFL_CAPI_EXPORT extern TfLiteModel* TfLiteModelCreate(const void* model_data,
   }
   memset(model, 0, sizeof(*model));
   iree_atomic_ref_count_init(&model->ref_count);
+  iree_slim_mutex_initialize(&model->shared_state_mutex);
   model->allocator = allocator;
 
-  status =
-      _TfLiteModelInitializeModule(model_data, model_size, allocator, model);
+  status = _TfLiteModelInitializeModule(
+      iree_make_const_byte_span(model_data, model_size), iree_allocator_null(),
+      allocator, model);
   if (!iree_status_is_ok(iree_status_consume_code(status))) {
     IREE_TRACE_ZONE_END(z0);
     return NULL;
@@ -136,40 +138,41 @@ TFL_CAPI_EXPORT extern TfLiteModel* TfLiteModelCreateFromFile(
   iree_allocator_t allocator = iree_allocator_system();
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // TODO(#3909): use file mapping C API.
-  FILE* file = fopen(model_path, "r");
-  if (!file) {
-    IREE_TRACE_MESSAGE(ERROR, "failed to open model file");
+  // The file is mapped so that only the pages used are read from disk. The
+  // module owns the mapping once created.
+  iree_const_byte_span_t model_data = iree_make_const_byte_span(NULL, 0);
+  iree_allocator_t model_data_allocator = iree_allocator_null();
+  iree_status_t status =
+      iree_file_map_contents(model_path, IREE_FILE_ACCESS_HINT_DEFAULT,
+                             allocator, &model_data, &model_data_allocator);
+  if (!iree_status_is_ok(iree_status_consume_code(status))) {
+    IREE_TRACE_MESSAGE(ERROR, "failed to map model file");
     IREE_TRACE_MESSAGE_DYNAMIC(ERROR, model_path, strlen(model_path));
     IREE_TRACE_ZONE_END(z0);
     return NULL;
   }
-  fseek(file, 0, SEEK_END);
-  size_t file_size = ftell(file);
-  fseek(file, 0, SEEK_SET);
+
   TfLiteModel* model = NULL;
-  iree_status_t status = iree_allocator_malloc(
-      allocator, sizeof(TfLiteModel) + file_size, (void**)&model);
+  status = iree_allocator_malloc(allocator, sizeof(*model), (void**)&model);
   if (!iree_status_is_ok(iree_status_consume_code(status))) {
-    IREE_TRACE_MESSAGE(ERROR, "failed model+data allocation");
+    IREE_TRACE_MESSAGE(ERROR, "failed model allocation");
+    iree_allocator_free(model_data_allocator, (void*)model_data.data);
     IREE_TRACE_ZONE_END(z0);
     return NULL;
   }
   memset(model, 0, sizeof(*model));
   iree_atomic_ref_count_init(&model->ref_count);
+  iree_slim_mutex_initialize(&model->shared_state_mutex);
   model->allocator = allocator;
-  model->owned_model_data = (uint8_t*)model + file_size;
-  int ret = fread(model->owned_model_data, 1, file_size, file);
-  fclose(file);
-  if (ret != file_size) {
-    IREE_TRACE_MESSAGE(ERROR, "failed model+data read");
-    IREE_TRACE_ZONE_END(z0);
-    return NULL;
-  }
 
-  status = _TfLiteModelInitializeModule(model->owned_model_data, file_size,
+  status = _TfLiteModelInitializeModule(model_data, model_data_allocator,
                                         allocator, model);
+  if (!model->module) {
+    // Module creation failed and the mapping was not taken.
+    iree_allocator_free(model_data_allocator, (void*)model_data.data);
+  }
   if (!iree_status_is_ok(iree_status_consume_code(status))) {
+    _TfLiteModelRelease(model);
     IREE_TRACE_ZONE_END(z0);
     return NULL;
   }
@@ -187,6 +190,13 @@ void _TfLiteModelRetain(TfLiteModel* model) {
 void _TfLiteModelRelease(TfLiteModel* model) {
   if (model && iree_atomic_ref_count_dec(&model->ref_count) == 1) {
     IREE_TRACE_ZONE_BEGIN(z0);
+    _TfLiteModelSharedState* shared_state = &model->shared_state;
+    iree_vm_context_release(shared_state->context);
+    iree_vm_module_release(shared_state->hal_module);
+    iree_hal_device_release(shared_state->device);
+    iree_hal_driver_release(shared_state->driver);
+    iree_vm_instance_release(shared_state->instance);
+    iree_slim_mutex_deinitialize(&model->shared_state_mutex);
     iree_vm_module_release(model->module);
     iree_allocator_free(model->allocator, model);
     IREE_TRACE_ZONE_END(z0);
@@ -9,12 +9,15 @@
 
 #include "iree/base/api.h"
 #include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/api.h"
 #include "iree/vm/api.h"
 
 // NOTE: we pull in our own copy here in case the tflite API changes upstream.
 #define TFL_COMPILE_LIBRARY 1
 #include "bindings/tflite/include/tensorflow/lite/c/c_api.h"
 #include "bindings/tflite/include/tensorflow/lite/c/c_api_experimental.h"
+#include "bindings/tflite/options.h"
 
 typedef struct _TfLiteModelExports {
   iree_vm_function_t _reset_variables;
@@ -24,15 +27,35 @@ typedef struct _TfLiteModelExports {
   iree_vm_function_t _main;
 } _TfLiteModelExports;
 
+// Runtime state shared by the interpreters created from a model with the same
+// device configuration. The template context has run the module initializers:
+// interpreters fork it so that they share its executables and constant
+// buffers and only duplicate their mutable state.
+typedef struct _TfLiteModelSharedState {
+  // Interpreter options the state was created with; only the fields that
+  // configure the device are meaningful.
+  TfLiteInterpreterOptions options;
+
+  iree_vm_instance_t* instance;
+  iree_hal_driver_t* driver;
+  iree_hal_device_t* device;
+  iree_vm_module_t* hal_module;
+  // Frozen template context.
+  iree_vm_context_t* context;
+} _TfLiteModelSharedState;
+
 struct TfLiteModel {
   iree_atomic_ref_count_t ref_count;
   iree_allocator_t allocator;
-  void* owned_model_data;
 
   iree_vm_module_t* module;
   _TfLiteModelExports exports;
   int32_t input_count;
   int32_t output_count;
+
+  // Guards |shared_state|, which is set by the first interpreter created.
+  iree_slim_mutex_t shared_state_mutex;
+  _TfLiteModelSharedState shared_state;
 };
 
 void _TfLiteModelRetain(TfLiteModel* model);
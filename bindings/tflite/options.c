@@ -37,6 +37,7 @@ TfLiteInterpreterOptionsCreate() {
 TFL_CAPI_EXPORT extern void TfLiteInterpreterOptionsDelete(
     TfLiteInterpreterOptions* options) {
   IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_device_release(options->device);
   iree_allocator_free(options->allocator, options);
   IREE_TRACE_ZONE_END(z0);
 }
@@ -49,6 +50,23 @@ TFL_CAPI_EXPORT extern void TfLiteInterpreterOptionsSetNumThreads(
   IREE_TRACE_ZONE_END(z0);
 }
 
+TfLiteStatus _TfLiteInterpreterOptionsSetDriver(
+    TfLiteInterpreterOptions* options, const char* driver_name) {
+  size_t driver_name_length = strlen(driver_name);
+  if (driver_name_length >= sizeof(options->driver_name)) {
+    return kTfLiteError;
+  }
+  memcpy(options->driver_name, driver_name, driver_name_length + 1);
+  return kTfLiteOk;
+}
+
+void _TfLiteInterpreterOptionsSetDevice(TfLiteInterpreterOptions* options,
+                                        iree_hal_device_t* device) {
+  iree_hal_device_retain(device);
+  iree_hal_device_release(options->device);
+  options->device = device;
+}
+
 TFL_CAPI_EXPORT extern void TfLiteInterpreterOptionsAddDelegate(
     TfLiteInterpreterOptions* options, TfLiteDelegate* delegate) {
   IREE_TRACE_ZONE_BEGIN(z0);
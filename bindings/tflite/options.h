@@ -8,6 +8,7 @@
 #define IREE_BINDINGS_TFLITE_OPTIONS_H_
 
 #include "iree/base/api.h"
+#include "iree/hal/api.h"
 
 // NOTE: we pull in our own copy here in case the tflite API changes upstream.
 #define TFL_COMPILE_LIBRARY 1
@@ -20,9 +21,24 @@ struct TfLiteInterpreterOptions {
   void (*reporter)(void* user_data, const char* format, va_list args);
   void* reporter_user_data;
 
-  // TODO(#3977): an existing iree_hal_device_t to use for the HAL.
+  // Name of the HAL driver used to create the device, if any.
+  char driver_name[32];
+  // Existing device used instead of creating one; retained.
+  iree_hal_device_t* device;
 };
 
 void _TfLiteInterpreterOptionsSetDefaults(TfLiteInterpreterOptions* options);
 
+// IREE extension: selects the HAL driver used to create the interpreter
+// device, such as `dylib` or `vulkan`. Defaults to `vmvx`.
+TfLiteStatus _TfLiteInterpreterOptionsSetDriver(
+    TfLiteInterpreterOptions* options, const char* driver_name);
+
+// IREE extension: makes interpreters created with |options| use |device|
+// instead of each creating their own. Sharing a device across interpreters
+// shares its allocator and executor. The driver name and thread count options
+// are ignored when a device is set. Passing NULL clears the device.
+void _TfLiteInterpreterOptionsSetDevice(TfLiteInterpreterOptions* options,
+                                        iree_hal_device_t* device);
+
 #endif  // IREE_BINDINGS_TFLITE_OPTIONS_H_
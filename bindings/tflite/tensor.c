@@ -128,11 +128,12 @@ iree_status_t _TfLiteTensorReallocateIfNeeded(
   allocation_size *= storage_scalar;
 
   // If the old buffer is the same size then no need to realloc.
-  if (tensor->buffer &&
+  if (tensor->buffer && !tensor->is_external &&
       iree_hal_buffer_byte_length(tensor->buffer) == allocation_size) {
     IREE_TRACE_ZONE_END(z0);
     return iree_ok_status();
   }
+  _TfLiteTensorDiscardBuffer(tensor);
 
   // Allocate the underlying buffer for the tensor.
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -168,19 +169,9 @@ iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
     return iree_ok_status();
   }
 
-  // Attempt to map the buffer. The tflite API doesn't let us know if this
-  // should be read or read/write - or if we even need to map at all. We could
-  // move this to an on-demand mapping when the user calls TfLiteTensorData but
-  // this at least puts potential errors in the same easy to find place.
-  iree_device_size_t byte_offset = 0;
-  iree_device_size_t byte_length = IREE_WHOLE_BUFFER;
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_hal_buffer_map_range(
-              buffer, IREE_HAL_MAPPING_MODE_SCOPED,
-              IREE_HAL_MEMORY_ACCESS_READ | IREE_HAL_MEMORY_ACCESS_WRITE,
-              byte_offset, byte_length, &tensor->buffer_mapping));
-
-  // Retain the buffer view until discarded/reset.
+  // Retain the buffer view until discarded/reset. Mapping is deferred until
+  // the user asks for TfLiteTensorData: models with many outputs are often
+  // only partially read and copies don't need a mapping.
   tensor->buffer = buffer;
   iree_hal_buffer_retain(tensor->buffer);
 
@@ -188,13 +179,33 @@ iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
   return iree_ok_status();
 }
 
+iree_status_t _TfLiteTensorMapIfNeeded(TfLiteTensor* tensor) {
+  if (!tensor->buffer || tensor->buffer_mapping.contents.data != NULL) {
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The tflite API doesn't let us know if this should be read or read/write.
+  iree_device_size_t byte_offset = 0;
+  iree_device_size_t byte_length = IREE_WHOLE_BUFFER;
+  iree_status_t status = iree_hal_buffer_map_range(
+      tensor->buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+      IREE_HAL_MEMORY_ACCESS_READ | IREE_HAL_MEMORY_ACCESS_WRITE, byte_offset,
+      byte_length, &tensor->buffer_mapping);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 void _TfLiteTensorDiscardBuffer(TfLiteTensor* tensor) {
   IREE_TRACE_ZONE_BEGIN(z0);
   if (tensor->buffer_mapping.contents.data != NULL) {
     iree_hal_buffer_unmap_range(&tensor->buffer_mapping);
   }
+  memset(&tensor->buffer_mapping, 0, sizeof(tensor->buffer_mapping));
   iree_hal_buffer_release(tensor->buffer);
   tensor->buffer = NULL;
+  tensor->is_external = false;
   IREE_TRACE_ZONE_END(z0);
 }
 
@@ -223,6 +234,12 @@ TFL_CAPI_EXPORT extern size_t TfLiteTensorByteSize(const TfLiteTensor* tensor) {
 }
 
 TFL_CAPI_EXPORT extern void* TfLiteTensorData(const TfLiteTensor* tensor) {
+  // Mapping is lazy and only caches state on the tensor.
+  iree_status_t status = _TfLiteTensorMapIfNeeded((TfLiteTensor*)tensor);
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(status);
+    return NULL;
+  }
   return tensor->buffer_mapping.contents.data;
 }
 
@@ -238,36 +255,48 @@ TFL_CAPI_EXPORT extern TfLiteQuantizationParams TfLiteTensorQuantizationParams(
 
 TFL_CAPI_EXPORT extern TfLiteStatus TfLiteTensorCopyFromBuffer(
     TfLiteTensor* tensor, const void* input_data, size_t input_data_size) {
-  if (input_data_size != tensor->buffer_mapping.contents.data_length) {
+  if (!tensor->buffer ||
+      input_data_size != iree_hal_buffer_byte_length(tensor->buffer)) {
     return kTfLiteApplicationError;
   }
   IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_TRACE_ZONE_APPEND_VALUE(z0, tensor->buffer_mapping.contents.data_length);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, input_data_size);
 
-  // NOTE: we could use a iree_hal_buffer_write_data here but we already have
-  // the buffer mapped. If we knew the user would never use TfLiteTensorData and
-  // could avoid mapping the buffer it would be more efficient and portable to
-  // do the iree_hal_buffer_copy_data.
-  memcpy(tensor->buffer_mapping.contents.data, input_data, input_data_size);
+  // Use the mapping if the buffer has one (as input buffers do) and otherwise
+  // avoid mapping it.
+  iree_status_t status = iree_ok_status();
+  if (tensor->buffer_mapping.contents.data != NULL) {
+    memcpy(tensor->buffer_mapping.contents.data, input_data, input_data_size);
+  } else {
+    status = iree_hal_buffer_write_data(tensor->buffer, 0, input_data,
+                                        input_data_size);
+  }
 
   IREE_TRACE_ZONE_END(z0);
-  return kTfLiteOk;
+  return _TfLiteStatusFromIREEStatus(status);
 }
 
 TFL_CAPI_EXPORT extern TfLiteStatus TfLiteTensorCopyToBuffer(
     const TfLiteTensor* output_tensor, void* output_data,
     size_t output_data_size) {
-  if (output_data_size != output_tensor->buffer_mapping.contents.data_length) {
+  if (!output_tensor->buffer ||
+      output_data_size != iree_hal_buffer_byte_length(output_tensor->buffer)) {
     return kTfLiteApplicationError;
   }
   IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_TRACE_ZONE_APPEND_VALUE(
-      z0, output_tensor->buffer_mapping.contents.data_length);
-
-  // NOTE: as with above we should use an iree_hal_buffer_read_data here.
-  memcpy(output_data, output_tensor->buffer_mapping.contents.data,
-         output_data_size);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, output_data_size);
+
+  // As above, outputs that were never accessed through TfLiteTensorData are
+  // read without being mapped.
+  iree_status_t status = iree_ok_status();
+  if (output_tensor->buffer_mapping.contents.data != NULL) {
+    memcpy(output_data, output_tensor->buffer_mapping.contents.data,
+           output_data_size);
+  } else {
+    status = iree_hal_buffer_read_data(output_tensor->buffer, 0, output_data,
+                                       output_data_size);
+  }
 
   IREE_TRACE_ZONE_END(z0);
-  return kTfLiteOk;
+  return _TfLiteStatusFromIREEStatus(status);
 }
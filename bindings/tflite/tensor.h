@@ -36,7 +36,11 @@ struct TfLiteTensor {
 
   // Allocated buffer view referencing the backing tensor memory.
   iree_hal_buffer_t* buffer;
-  // Persistently mapped buffer; invalidated when buffer is resized.
+  // True if |buffer| references memory owned by the user; it is never reused
+  // by _TfLiteTensorReallocateIfNeeded.
+  bool is_external;
+  // Persistently mapped buffer; invalidated when buffer is resized. Bound
+  // buffers are mapped on first access with _TfLiteTensorMapIfNeeded.
   iree_hal_buffer_mapping_t buffer_mapping;
 };
 
@@ -54,17 +58,20 @@ iree_status_t _TfLiteTensorParseQuantAttr(TfLiteTensor* tensor,
                                           iree_string_view_t attr);
 
 // Reallocates and remaps the tensor buffer view if needed.
-// No-op if the buffer view is already allocated and its shape matches the
-// current tensor shape.
+// No-op if the buffer view is already allocated, not external, and its shape
+// matches the current tensor shape.
 iree_status_t _TfLiteTensorReallocateIfNeeded(
     TfLiteTensor* tensor, iree_hal_allocator_t* buffer_allocator,
     iree_allocator_t heap_allocator);
 
-// Binds the given |buffer| to the tensor and maps it.
+// Binds the given |buffer| to the tensor without mapping it.
 // The tensor shape will be overwritten with the buffer view shape.
 iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
                                 iree_hal_buffer_t* buffer);
 
+// Maps the tensor buffer, if any, unless it is already mapped.
+iree_status_t _TfLiteTensorMapIfNeeded(TfLiteTensor* tensor);
+
 // Discards the current buffer view, if any, resetting it to NULL.
 void _TfLiteTensorDiscardBuffer(TfLiteTensor* tensor);
 
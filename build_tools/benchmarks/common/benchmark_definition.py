@@ -27,6 +27,7 @@ __all__ = [
 # benchmark presentation stable.
 IREE_DRIVERS_TO_PRETTY_NAMES = {
     "iree-dylib": "IREE-Dylib",
+    "iree-cuda": "IREE-CUDA",
     "iree-dylib-sync": "IREE-Dylib-Sync",
     "iree-vmvx": "IREE-VMVX",
     "iree-vmvx-sync": "IREE-VMVX-Sync",
@@ -0,0 +1,333 @@
+#!/usr/bin/env python3
+# Copyright 2022 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Runs all matched benchmark suites on the local Linux host.
+
+This is the host counterpart to run_benchmarks_on_android.py for the desktop
+and server configurations (x86_64 CPU, CUDA, and Vulkan). It expects the
+benchmark artifacts to be generated by building the `iree-benchmark-suites`
+target and uses the same directory structure:
+
+<root-build-dir>/benchmark_suites
+└── <benchmark-category> (e.g., MHLO)
+    ├── <benchmark-suite> (e.g., ResNet50-fp32,imagenet)
+    │   └── <benchmark-case> (e.g., iree-dylib__CPU-x86_64__full-inference)
+    │       ├── tool
+    │       └── flagfile
+    └── vmfb
+        ├── <compiled-iree-model>-<sha1>.vmfb
+        └── <compiled-iree-model>-<sha1>.vmfb.statistics.json
+
+Results are written as a single JSON file containing, for each benchmark, the
+Google Benchmark results (including the host/device peak allocation counters
+reported by iree-benchmark-module), the peak resident memory of the benchmark
+process, and the compile time and module size recorded when the module was
+generated.
+
+Example usage:
+
+  python3 run_benchmarks_on_linux.py \
+    --benchmark_tool_dir=/path/to/host/build/iree/tools \
+    --target_arch=cpu-x86_64 --target_arch=gpu-nvidia-ampere \
+    -o results.json \
+    /path/to/host/build/dir
+"""
+
+import argparse
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+
+from typing import Any, Dict, Optional, Sequence
+
+from common.benchmark_definition import (execute_cmd_and_get_output,
+                                         IREE_DRIVERS_TO_PRETTY_NAMES)
+
+# All benchmarks' relative path against root build directory.
+BENCHMARK_SUITE_REL_PATH = "benchmark_suites"
+
+# The flagfile/toolfile's filename for compiled benchmark artifacts.
+MODEL_FLAGFILE_NAME = "flagfile"
+MODEL_TOOLFILE_NAME = "tool"
+
+# Suffix of the compilation statistics file written next to each module.
+COMPILATION_STATISTICS_SUFFIX = ".statistics.json"
+
+
+def get_benchmark_repetition_count(runner: str) -> int:
+  """Returns the benchmark repetition count for the given runner."""
+  if runner.startswith("iree-vmvx"):
+    # VMVX is very unoptimized for now and can take a long time to run.
+    return 3
+  return 10
+
+
+def get_git_commit_hash(commit: str) -> str:
+  return execute_cmd_and_get_output(['git', 'rev-parse', commit],
+                                    cwd=os.path.dirname(
+                                        os.path.realpath(__file__)))
+
+
+def get_host_info() -> Dict[str, Any]:
+  """Returns a description of the host the benchmarks run on."""
+  cpu_model = platform.processor()
+  try:
+    with open("/proc/cpuinfo") as f:
+      for line in f:
+        if line.startswith("model name"):
+          cpu_model = line.split(":", 1)[1].strip()
+          break
+  except OSError:
+    pass
+  return {
+      "hostname": platform.node(),
+      "machine": platform.machine(),
+      "cpu_model": cpu_model,
+      "cpu_count": os.cpu_count(),
+      "kernel": platform.release(),
+  }
+
+
+def read_flagfile(path: str) -> Dict[str, str]:
+  """Returns the --key=value flags from the given flagfile."""
+  flags = {}
+  with open(path) as f:
+    for line in f:
+      match = re.match(r"^--([^=]+)=(.*)$", line.strip())
+      if match:
+        flags[match.group(1)] = match.group(2)
+  return flags
+
+
+def load_compilation_statistics(
+    benchmark_case_dir: str) -> Optional[Dict[str, Any]]:
+  """Loads the compilation statistics for the module of a benchmark case."""
+  flags = read_flagfile(os.path.join(benchmark_case_dir, MODEL_FLAGFILE_NAME))
+  module_file = flags.get("module_file")
+  if not module_file:
+    return None
+  statistics_file = os.path.join(benchmark_case_dir,
+                                 module_file + COMPILATION_STATISTICS_SUFFIX)
+  if not os.path.exists(statistics_file):
+    return None
+  with open(statistics_file) as f:
+    return json.load(f)
+
+
+def filter_benchmarks_for_category(benchmark_category_dir: str,
+                                   target_archs: Sequence[str],
+                                   driver_filter: Optional[str],
+                                   verbose: bool = False) -> Sequence[str]:
+  """Filters benchmarks in a specific category for the given architectures.
+
+  Args:
+    benchmark_category_dir: the directory to a specific benchmark category.
+    target_archs: lowercase target architectures to run.
+    driver_filter: only run benchmarks for the given driver if not None.
+    verbose: whether to print additional debug info.
+
+  Returns:
+    A list containing all matched benchmark cases' directories.
+  """
+  matched_benchmarks = []
+  for root, _, _ in os.walk(benchmark_category_dir):
+    # Relies on the following directory naming convention:
+    #   <iree-driver>__<target-architecture>__<benchmark_mode>
+    segments = os.path.basename(root).split("__")
+    if len(segments) != 3 or not segments[0].startswith("iree-"):
+      continue
+
+    iree_driver, target_arch, bench_mode = segments
+    iree_driver = iree_driver[len("iree-"):].lower()
+    matched_driver = (driver_filter is None or
+                      iree_driver == driver_filter.lower())
+    should_choose = matched_driver and target_arch.lower() in target_archs
+    if should_choose:
+      matched_benchmarks.append(root)
+
+    if verbose:
+      print(f"dir: {root}")
+      print(f"  iree_driver: {iree_driver}")
+      print(f"  target_arch: {target_arch}")
+      print(f"  bench_mode: {bench_mode}")
+      print(f"  chosen: {should_choose}")
+
+  return sorted(matched_benchmarks)
+
+
+def compose_benchmark_info(benchmark_category_dir: str,
+                           benchmark_case_dir: str) -> Dict[str, Any]:
+  """Describes the benchmark based on its directory path."""
+  # <model-name>-<model-tags>/<iree-driver>__<target-arch>__<bench_mode>
+  suite_dir = os.path.relpath(os.path.dirname(benchmark_case_dir),
+                              benchmark_category_dir)
+  model_name, model_tags = suite_dir.split("-", 1)
+  runner, target_arch, bench_mode = os.path.basename(
+      benchmark_case_dir).split("__")
+  return {
+      "model_name": model_name,
+      "model_tags": model_tags.split(","),
+      "model_source": os.path.basename(benchmark_category_dir),
+      "bench_mode": bench_mode.split(","),
+      "runner": runner,
+      "target_arch": target_arch,
+  }
+
+
+def get_benchmark_name(info: Dict[str, Any]) -> str:
+  tags = ",".join(info["model_tags"])
+  mode = ",".join(info["bench_mode"])
+  driver = IREE_DRIVERS_TO_PRETTY_NAMES.get(info["runner"], info["runner"])
+  return (f"{info['model_name']} [{tags}] ({info['model_source']}) {mode} "
+          f"with {driver} @ {info['target_arch']}")
+
+
+def run_benchmark(benchmark_case_dir: str, tool_path: str, runner: str,
+                  results_file: str, verbose: bool = False) -> int:
+  """Runs the benchmark case and returns the peak RSS of the process."""
+  cmd = [tool_path, f"--flagfile={MODEL_FLAGFILE_NAME}"]
+  if os.path.basename(tool_path) == "iree-benchmark-module":
+    cmd.extend([
+        f"--benchmark_repetitions={get_benchmark_repetition_count(runner)}",
+        "--benchmark_format=json",
+        "--benchmark_out_format=json",
+        f"--benchmark_out={results_file}",
+    ])
+  if verbose:
+    print(f"cmd: {' '.join(cmd)}")
+  stdout = None if verbose else subprocess.DEVNULL
+  process = subprocess.Popen(cmd, cwd=benchmark_case_dir, stdout=stdout)
+  _, status, rusage = os.wait4(process.pid, 0)
+  exit_code = os.waitstatus_to_exitcode(status)
+  if exit_code != 0:
+    raise subprocess.CalledProcessError(exit_code, cmd)
+  # ru_maxrss is reported in KiB on Linux.
+  return rusage.ru_maxrss * 1024
+
+
+def parse_arguments():
+  """Parses command-line options."""
+
+  def check_dir_path(path):
+    if os.path.isdir(path):
+      return path
+    else:
+      raise argparse.ArgumentTypeError(path)
+
+  parser = argparse.ArgumentParser()
+  parser.add_argument(
+      "build_dir",
+      metavar="<build-dir>",
+      type=check_dir_path,
+      help="Path to the build directory containing benchmark suites")
+  parser.add_argument("--benchmark_tool_dir",
+                      "--benchmark-tool-dir",
+                      type=check_dir_path,
+                      required=True,
+                      help="Path to the iree tool directory")
+  parser.add_argument(
+      "--target_arch",
+      "--target-arch",
+      action="append",
+      default=None,
+      help="Target architecture to run benchmarks for, e.g., 'CPU-x86_64' or "
+      "'GPU-Nvidia-Ampere'. May be repeated. Defaults to 'CPU-x86_64'")
+  parser.add_argument(
+      "--driver",
+      type=str,
+      default=None,
+      help="Only run benchmarks for a specific driver, e.g., 'cuda'")
+  parser.add_argument("--output",
+                      "-o",
+                      default=None,
+                      help="Path to the ouput file")
+  parser.add_argument("--tmp_dir",
+                      "--tmp-dir",
+                      "--tmpdir",
+                      default="/tmp/iree-benchmarks",
+                      help="Base directory in which to store temporary files")
+  parser.add_argument(
+      "--keep_going",
+      "--keep-going",
+      action="store_true",
+      help="Continue running after a failed benchmark. The overall exit status"
+      " will still indicate failure and all errors will be reported at the end."
+  )
+  parser.add_argument("--verbose",
+                      action="store_true",
+                      help="Print internal information during execution")
+  return parser.parse_args()
+
+
+def main(args):
+  target_archs = [a.lower() for a in (args.target_arch or ["CPU-x86_64"])]
+  commit = get_git_commit_hash("HEAD")
+  results_dir = os.path.join(args.tmp_dir, commit, "benchmark-results")
+  os.makedirs(results_dir, exist_ok=True)
+
+  root_benchmark_dir = os.path.join(args.build_dir, BENCHMARK_SUITE_REL_PATH)
+  benchmarks = []
+  errors = []
+  for directory in sorted(os.listdir(root_benchmark_dir)):
+    benchmark_category_dir = os.path.join(root_benchmark_dir, directory)
+    matched_benchmarks = filter_benchmarks_for_category(
+        benchmark_category_dir, target_archs, args.driver, args.verbose)
+    for benchmark_case_dir in matched_benchmarks:
+      with open(os.path.join(benchmark_case_dir, MODEL_TOOLFILE_NAME)) as f:
+        tool = f.read().strip()
+      info = compose_benchmark_info(benchmark_category_dir, benchmark_case_dir)
+      name = get_benchmark_name(info)
+      print(f"--> benchmark: {name} <--")
+
+      results_file = os.path.join(results_dir, f"{name}.json")
+      try:
+        peak_rss_bytes = run_benchmark(benchmark_case_dir,
+                                       os.path.join(args.benchmark_tool_dir,
+                                                    tool),
+                                       info["runner"],
+                                       results_file,
+                                       verbose=args.verbose)
+      except subprocess.CalledProcessError as e:
+        if args.keep_going:
+          print(f"Processing of benchmark failed with: {e}")
+          errors.append(e)
+          continue
+        raise e
+
+      with open(results_file) as f:
+        result_json_object = json.load(f)
+      benchmarks.append({
+          "name": name,
+          "benchmark_info": info,
+          "context": result_json_object["context"],
+          "results": result_json_object["benchmarks"],
+          "peak_rss_bytes": peak_rss_bytes,
+          "compilation_statistics":
+              load_compilation_statistics(benchmark_case_dir),
+      })
+      print("...benchmark completed")
+
+  results = {
+      "commit": commit,
+      "host_info": get_host_info(),
+      "benchmarks": benchmarks,
+  }
+  if args.output is not None:
+    with open(args.output, "w") as f:
+      json.dump(results, f, indent=2)
+  if args.verbose:
+    print(json.dumps(results, indent=2))
+
+  if errors:
+    print("Benchmarking completed with errors", file=sys.stderr)
+    raise RuntimeError(errors)
+
+
+if __name__ == "__main__":
+  main(parse_arguments())
@@ -39,6 +39,9 @@
 #   RUNTIME_FLAGS: A list of command-line options and their values to pass
 #       to the IREE runtime during benchmark exectuion.
 #
+# Alongside each generated module a "<module>.vmfb.statistics.json" file is
+# written recording the compile time, peak compiler memory use, and module size.
+#
 # The above parameters largely fall into two categories: 1) for specifying
 # the MLIR input module and its metadata, 2) for specifying the translation/
 # runtime configuration.
@@ -192,6 +195,7 @@ function(iree_benchmark_suite)
       string(MD5 _VMFB_HASH "${_TRANSLATION_ARGS};${_MODULE_SOURCE}")
       get_filename_component(_MODULE_SOURCE_BASENAME "${_MODULE_SOURCE}" NAME)
       set(_VMFB_FILE "${_VMFB_ARTIFACTS_DIR}/${_MODULE_SOURCE_BASENAME}-${_VMFB_HASH}.vmfb")
+      set(_VMFB_STATISTICS_FILE "${_VMFB_FILE}.statistics.json")
 
       # Register the target once and share across all benchmarks having the same
       # MLIR source and translation flags.
@@ -201,8 +205,14 @@ function(iree_benchmark_suite)
       )
       if(NOT TARGET "${_TRANSLATION_TARGET_NAME}")
         add_custom_command(
-          OUTPUT "${_VMFB_FILE}"
+          OUTPUT
+            "${_VMFB_FILE}"
+            "${_VMFB_STATISTICS_FILE}"
           COMMAND
+            "${Python3_EXECUTABLE}" "${IREE_ROOT_DIR}/scripts/compile_with_statistics.py"
+              --module_file="${_VMFB_FILE}"
+              -o "${_VMFB_STATISTICS_FILE}"
+              --
             "$<TARGET_FILE:iree::tools::iree-translate>"
               ${_TRANSLATION_ARGS}
               "--mlir-print-op-on-diagnostic=false"
@@ -211,6 +221,7 @@ function(iree_benchmark_suite)
           WORKING_DIRECTORY "${_VMFB_ARTIFACTS_DIR}"
           DEPENDS
             iree::tools::iree-translate
+            "${IREE_ROOT_DIR}/scripts/compile_with_statistics.py"
             "${_MODULE_SOURCE_TARGET}"
             COMMENT "Generating VMFB for ${_COMMON_NAME_SEGMENTS}"
         )
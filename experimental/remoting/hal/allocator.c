@@ -0,0 +1,225 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/remoting/hal/allocator.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "experimental/remoting/hal/buffer.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_remoting_hal_allocator_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_remoting_hal_channel_t* channel;
+} iree_remoting_hal_allocator_t;
+
+static const iree_hal_allocator_vtable_t iree_remoting_hal_allocator_vtable;
+
+static iree_remoting_hal_allocator_t* iree_remoting_hal_allocator_cast(
+    iree_hal_allocator_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_remoting_hal_allocator_vtable);
+  return (iree_remoting_hal_allocator_t*)base_value;
+}
+
+iree_status_t iree_remoting_hal_allocator_create(
+    iree_remoting_hal_channel_t* channel, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(channel);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_remoting_hal_allocator_t* allocator = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*allocator), (void**)&allocator);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_remoting_hal_allocator_vtable,
+                                 &allocator->resource);
+    allocator->host_allocator = host_allocator;
+    allocator->channel = channel;
+    iree_remoting_hal_channel_retain(channel);
+    *out_allocator = (iree_hal_allocator_t*)allocator;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_remoting_hal_allocator_destroy(
+    iree_hal_allocator_t* base_allocator) {
+  iree_remoting_hal_allocator_t* allocator =
+      iree_remoting_hal_allocator_cast(base_allocator);
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_remoting_hal_channel_release(allocator->channel);
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_allocator_t iree_remoting_hal_allocator_host_allocator(
+    const iree_hal_allocator_t* base_allocator) {
+  iree_remoting_hal_allocator_t* allocator =
+      (iree_remoting_hal_allocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_status_t iree_remoting_hal_allocator_trim(
+    iree_hal_allocator_t* base_allocator) {
+  return iree_ok_status();
+}
+
+static void iree_remoting_hal_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  // Allocations are tracked by the allocator of the served device.
+  memset(out_statistics, 0, sizeof(*out_statistics));
+}
+
+static iree_hal_buffer_compatibility_t
+iree_remoting_hal_allocator_query_buffer_compatibility(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_buffer_usage_t intended_usage,
+    iree_device_size_t allocation_size) {
+  // Disallow usage not permitted by the buffer itself. Since we then use this
+  // to determine compatibility below we'll naturally set the right compat flags
+  // based on what's both allowed and intended.
+  intended_usage &= allowed_usage;
+
+  // All buffers are allocated remotely. Host-visible memory types are emulated
+  // by staging through the connection.
+  iree_hal_buffer_compatibility_t compatibility =
+      IREE_HAL_BUFFER_COMPATIBILITY_ALLOCATABLE;
+
+  // Only transfer commands are forwarded today so dispatch usage is not
+  // reported as compatible.
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE) &&
+      iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
+    compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_TRANSFER;
+  }
+
+  return compatibility;
+}
+
+static iree_status_t iree_remoting_hal_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_const_byte_span_t initial_data, iree_hal_buffer_t** out_buffer) {
+  iree_remoting_hal_allocator_t* allocator =
+      iree_remoting_hal_allocator_cast(base_allocator);
+
+  // Host access is emulated with staging copies that work on any buffer. The
+  // host uses mapping to read and write buffer contents so it is always
+  // allowed.
+  memory_type |= IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+  allowed_usage |=
+      IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING;
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)allocation_size);
+
+  // Allocation is a call so that out-of-memory is reported here instead of at
+  // the first use of the buffer.
+  uint32_t buffer_id =
+      iree_remoting_hal_channel_acquire_id(allocator->channel);
+  iree_remoting_hal_buffer_allocate_request_t request = {
+      .buffer_id = buffer_id,
+      .memory_type = memory_type,
+      .allowed_usage = allowed_usage,
+      .allocation_size = allocation_size,
+  };
+  iree_const_byte_span_t span =
+      iree_make_const_byte_span(&request, sizeof(request));
+  iree_status_t status = iree_remoting_hal_channel_call(
+      allocator->channel, IREE_REMOTING_HAL_OPCODE_BUFFER_ALLOCATE, 1, &span,
+      iree_byte_span_empty());
+
+  iree_hal_buffer_t* buffer = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_remoting_hal_buffer_wrap(
+        base_allocator, allocator->channel, buffer_id, memory_type,
+        IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage, allocation_size, &buffer);
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_remoting_hal_channel_release_id(allocator->channel, buffer_id);
+  }
+
+  // Initial data is pipelined behind the allocation.
+  if (iree_status_is_ok(status) &&
+      !iree_const_byte_span_is_empty(initial_data)) {
+    iree_remoting_hal_buffer_range_t range = {
+        .buffer_id = buffer_id,
+        .offset = 0,
+        .length = initial_data.data_length,
+    };
+    iree_const_byte_span_t spans[2] = {
+        iree_make_const_byte_span(&range, sizeof(range)),
+        initial_data,
+    };
+    status = iree_remoting_hal_channel_send(
+        allocator->channel, IREE_REMOTING_HAL_OPCODE_BUFFER_WRITE,
+        IREE_ARRAYSIZE(spans), spans);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_buffer = buffer;
+  } else {
+    iree_hal_buffer_release(buffer);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_remoting_hal_allocator_deallocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* base_buffer) {
+  iree_hal_buffer_destroy(base_buffer);
+}
+
+static iree_status_t iree_remoting_hal_allocator_wrap_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "wrapping of external buffers not supported");
+}
+
+static iree_status_t iree_remoting_hal_allocator_import_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_external_buffer_t* external_buffer,
+    iree_hal_buffer_t** out_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "importing from external buffers not supported");
+}
+
+static iree_status_t iree_remoting_hal_allocator_export_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer,
+    iree_hal_external_buffer_type_t requested_type,
+    iree_hal_external_buffer_flags_t requested_flags,
+    iree_hal_external_buffer_t* out_external_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "exporting to external buffers not supported");
+}
+
+static const iree_hal_allocator_vtable_t iree_remoting_hal_allocator_vtable = {
+    .destroy = iree_remoting_hal_allocator_destroy,
+    .host_allocator = iree_remoting_hal_allocator_host_allocator,
+    .trim = iree_remoting_hal_allocator_trim,
+    .query_statistics = iree_remoting_hal_allocator_query_statistics,
+    .query_buffer_compatibility =
+        iree_remoting_hal_allocator_query_buffer_compatibility,
+    .allocate_buffer = iree_remoting_hal_allocator_allocate_buffer,
+    .deallocate_buffer = iree_remoting_hal_allocator_deallocate_buffer,
+    .wrap_buffer = iree_remoting_hal_allocator_wrap_buffer,
+    .import_buffer = iree_remoting_hal_allocator_import_buffer,
+    .export_buffer = iree_remoting_hal_allocator_export_buffer,
+};
@@ -0,0 +1,29 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef EXPERIMENTAL_REMOTING_HAL_ALLOCATOR_H_
+#define EXPERIMENTAL_REMOTING_HAL_ALLOCATOR_H_
+
+#include "experimental/remoting/hal/channel.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates an allocator that allocates buffers from the device allocator of the
+// device served on the other end of |channel|. All buffers are usable as copy
+// operands; host mapping is emulated as described in buffer.h.
+iree_status_t iree_remoting_hal_allocator_create(
+    iree_remoting_hal_channel_t* channel, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // EXPERIMENTAL_REMOTING_HAL_ALLOCATOR_H_
@@ -0,0 +1,86 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// See iree/base/api.h for documentation on the API conventions used.
+
+#ifndef EXPERIMENTAL_REMOTING_HAL_API_H_
+#define EXPERIMENTAL_REMOTING_HAL_API_H_
+
+#include "experimental/remoting/transport/transport.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_remoting_hal_device_t
+//===----------------------------------------------------------------------===//
+
+// Creates a HAL device that forwards buffer transfers, command buffers and
+// semaphores to a device server connected through |transport|, which is
+// retained. See experimental/remoting/hal/protocol.h for the wire format.
+//
+// Most operations are pipelined: allocation, mapping for read, semaphore
+// queries/waits and device queries wait on a round trip while everything else
+// (buffer writes, command buffer recording, submissions and signals) is sent
+// without waiting. Failures of pipelined operations surface from the next
+// operation that waits.
+//
+// Only transfer commands are forwarded today; executables, descriptor sets
+// and events return IREE_STATUS_UNIMPLEMENTED.
+//
+// |out_device| must be released by the caller (see |iree_hal_device_release|).
+IREE_API_EXPORT iree_status_t iree_remoting_hal_device_create(
+    iree_string_view_t identifier, iree_remoting_transport_t* transport,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device);
+
+//===----------------------------------------------------------------------===//
+// iree_remoting_hal_driver_t
+//===----------------------------------------------------------------------===//
+
+// Creates a driver exposing one remote device per server endpoint in
+// |endpoints| of the form `host:port`. Devices connect over TCP when created.
+//
+// |out_driver| must be released by the caller (see |iree_hal_driver_release|).
+IREE_API_EXPORT iree_status_t iree_remoting_hal_driver_create(
+    iree_string_view_t identifier, iree_host_size_t endpoint_count,
+    const iree_string_view_t* endpoints, iree_allocator_t host_allocator,
+    iree_hal_driver_t** out_driver);
+
+//===----------------------------------------------------------------------===//
+// iree_remoting_hal_server_t
+//===----------------------------------------------------------------------===//
+
+// Serves a local HAL device to a single remote device client.
+typedef struct iree_remoting_hal_server_t iree_remoting_hal_server_t;
+
+// Creates a server that executes requests received over |transport| on
+// |device|. Both are retained.
+//
+// Requests are processed in order on the thread calling
+// iree_remoting_hal_server_run and so |device| should have an asynchronous
+// queue: submissions waiting on semaphores the client signals later would
+// otherwise block the connection.
+IREE_API_EXPORT iree_status_t iree_remoting_hal_server_create(
+    iree_hal_device_t* device, iree_remoting_transport_t* transport,
+    iree_allocator_t host_allocator, iree_remoting_hal_server_t** out_server);
+
+// Releases all resources the client created and frees the server.
+IREE_API_EXPORT void iree_remoting_hal_server_free(
+    iree_remoting_hal_server_t* server);
+
+// Processes requests until the client disconnects (returning OK) or the
+// connection fails.
+IREE_API_EXPORT iree_status_t
+iree_remoting_hal_server_run(iree_remoting_hal_server_t* server);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // EXPERIMENTAL_REMOTING_HAL_API_H_
@@ -0,0 +1,189 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/remoting/hal/buffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_remoting_hal_buffer_t {
+  iree_hal_buffer_t base;
+  iree_remoting_hal_channel_t* channel;
+  uint32_t buffer_id;
+} iree_remoting_hal_buffer_t;
+
+static const iree_hal_buffer_vtable_t iree_remoting_hal_buffer_vtable;
+
+static iree_remoting_hal_buffer_t* iree_remoting_hal_buffer_cast(
+    iree_hal_buffer_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_remoting_hal_buffer_vtable);
+  return (iree_remoting_hal_buffer_t*)base_value;
+}
+
+iree_status_t iree_remoting_hal_buffer_wrap(
+    iree_hal_allocator_t* allocator, iree_remoting_hal_channel_t* channel,
+    uint32_t buffer_id, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_hal_buffer_t** out_buffer) {
+  IREE_ASSERT_ARGUMENT(allocator);
+  IREE_ASSERT_ARGUMENT(channel);
+  IREE_ASSERT_ARGUMENT(out_buffer);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocator_t host_allocator =
+      iree_hal_allocator_host_allocator(allocator);
+  iree_remoting_hal_buffer_t* buffer = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, sizeof(*buffer), (void**)&buffer);
+  if (iree_status_is_ok(status)) {
+    iree_hal_buffer_initialize(host_allocator, allocator, &buffer->base,
+                               allocation_size, 0, allocation_size, memory_type,
+                               allowed_access, allowed_usage,
+                               &iree_remoting_hal_buffer_vtable, &buffer->base);
+    buffer->channel = channel;
+    iree_remoting_hal_channel_retain(channel);
+    buffer->buffer_id = buffer_id;
+    *out_buffer = &buffer->base;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_remoting_hal_buffer_destroy(iree_hal_buffer_t* base_buffer) {
+  iree_remoting_hal_buffer_t* buffer =
+      iree_remoting_hal_buffer_cast(base_buffer);
+  iree_allocator_t host_allocator = base_buffer->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The server retains the allocation for as long as any submitted command
+  // buffer references it so this can be sent without waiting for idle.
+  iree_remoting_hal_channel_release_id(buffer->channel, buffer->buffer_id);
+  iree_remoting_hal_channel_release(buffer->channel);
+  iree_allocator_free(host_allocator, buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_remoting_hal_buffer_resolve(iree_hal_buffer_t* buffer,
+                                               uint32_t* out_buffer_id,
+                                               iree_device_size_t* offset) {
+  iree_hal_buffer_t* allocated_buffer =
+      iree_hal_buffer_allocated_buffer(buffer);
+  if (!iree_hal_resource_is(allocated_buffer,
+                            &iree_remoting_hal_buffer_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "buffer was not allocated from a remote device");
+  }
+  *out_buffer_id = ((iree_remoting_hal_buffer_t*)allocated_buffer)->buffer_id;
+  *offset += iree_hal_buffer_byte_offset(buffer);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_buffer_map_range(
+    iree_hal_buffer_t* base_buffer, iree_hal_mapping_mode_t mapping_mode,
+    iree_hal_memory_access_t memory_access,
+    iree_device_size_t local_byte_offset, iree_device_size_t local_byte_length,
+    iree_hal_buffer_mapping_t* mapping) {
+  iree_remoting_hal_buffer_t* buffer =
+      iree_remoting_hal_buffer_cast(base_buffer);
+  if (iree_all_bits_set(mapping_mode, IREE_HAL_MAPPING_MODE_PERSISTENT)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "remote buffers only support scoped mappings");
+  }
+  IREE_RETURN_IF_ERROR(
+      iree_hal_buffer_validate_usage(iree_hal_buffer_allowed_usage(base_buffer),
+                                     IREE_HAL_BUFFER_USAGE_MAPPING));
+
+  uint8_t* shadow_ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc_uninitialized(
+      base_buffer->host_allocator, local_byte_length, (void**)&shadow_ptr));
+
+  // Discarded contents don't need to cross the connection.
+  iree_status_t status = iree_ok_status();
+  if (!iree_all_bits_set(memory_access, IREE_HAL_MEMORY_ACCESS_DISCARD)) {
+    IREE_TRACE_ZONE_BEGIN(z0);
+    iree_remoting_hal_buffer_range_t request = {
+        .buffer_id = buffer->buffer_id,
+        .offset = local_byte_offset,
+        .length = local_byte_length,
+    };
+    iree_const_byte_span_t span =
+        iree_make_const_byte_span(&request, sizeof(request));
+    status = iree_remoting_hal_channel_call(
+        buffer->channel, IREE_REMOTING_HAL_OPCODE_BUFFER_READ, 1, &span,
+        iree_make_byte_span(shadow_ptr, local_byte_length));
+    IREE_TRACE_ZONE_END(z0);
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(base_buffer->host_allocator, shadow_ptr);
+    return status;
+  }
+
+  mapping->contents = iree_make_byte_span(shadow_ptr, local_byte_length);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_buffer_unmap_range(
+    iree_hal_buffer_t* base_buffer, iree_device_size_t local_byte_offset,
+    iree_device_size_t local_byte_length, iree_hal_buffer_mapping_t* mapping) {
+  iree_remoting_hal_buffer_t* buffer =
+      iree_remoting_hal_buffer_cast(base_buffer);
+  uint8_t* shadow_ptr = mapping->contents.data;
+
+  // Send the contents back if they may have been modified. The write is
+  // pipelined: it is ordered after all previously submitted work but we don't
+  // wait for it to land.
+  iree_status_t status = iree_ok_status();
+  if (iree_any_bit_set(mapping->impl.allowed_access,
+                       IREE_HAL_MEMORY_ACCESS_WRITE)) {
+    IREE_TRACE_ZONE_BEGIN(z0);
+    iree_remoting_hal_buffer_range_t request = {
+        .buffer_id = buffer->buffer_id,
+        .offset = local_byte_offset,
+        .length = local_byte_length,
+    };
+    iree_const_byte_span_t spans[2] = {
+        iree_make_const_byte_span(&request, sizeof(request)),
+        iree_make_const_byte_span(shadow_ptr, local_byte_length),
+    };
+    status = iree_remoting_hal_channel_send(
+        buffer->channel, IREE_REMOTING_HAL_OPCODE_BUFFER_WRITE,
+        IREE_ARRAYSIZE(spans), spans);
+    IREE_TRACE_ZONE_END(z0);
+  }
+
+  iree_allocator_free(base_buffer->host_allocator, shadow_ptr);
+  return status;
+}
+
+static iree_status_t iree_remoting_hal_buffer_invalidate_range(
+    iree_hal_buffer_t* base_buffer, iree_device_size_t local_byte_offset,
+    iree_device_size_t local_byte_length) {
+  // Nothing to do: mappings are snapshots taken at map time.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_buffer_flush_range(
+    iree_hal_buffer_t* base_buffer, iree_device_size_t local_byte_offset,
+    iree_device_size_t local_byte_length) {
+  // Nothing to do: writes are sent on unmap.
+  return iree_ok_status();
+}
+
+static const iree_hal_buffer_vtable_t iree_remoting_hal_buffer_vtable = {
+    .recycle = iree_hal_buffer_recycle,
+    .destroy = iree_remoting_hal_buffer_destroy,
+    .map_range = iree_remoting_hal_buffer_map_range,
+    .unmap_range = iree_remoting_hal_buffer_unmap_range,
+    .invalidate_range = iree_remoting_hal_buffer_invalidate_range,
+    .flush_range = iree_remoting_hal_buffer_flush_range,
+};
@@ -0,0 +1,43 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef EXPERIMENTAL_REMOTING_HAL_BUFFER_H_
+#define EXPERIMENTAL_REMOTING_HAL_BUFFER_H_
+
+#include "experimental/remoting/hal/channel.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a buffer referencing the remote allocation |buffer_id|. The buffer
+// takes ownership of the id and releases the remote allocation when destroyed.
+//
+// Remote buffers cannot be mapped directly. Mapping is emulated: mapping for
+// read fetches the range into a host shadow copy and unmapping after a write
+// sends the shadow back. Both are ordered with respect to all previously
+// submitted work on the connection; mappings are only coherent with device
+// work that completed before the map.
+iree_status_t iree_remoting_hal_buffer_wrap(
+    iree_hal_allocator_t* allocator, iree_remoting_hal_channel_t* channel,
+    uint32_t buffer_id, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_hal_buffer_t** out_buffer);
+
+// Resolves |buffer| (which may be a subspan of a remote allocation) to the id
+// of the remote allocation and adjusts |offset| to be relative to it.
+iree_status_t iree_remoting_hal_buffer_resolve(iree_hal_buffer_t* buffer,
+                                               uint32_t* out_buffer_id,
+                                               iree_device_size_t* offset);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // EXPERIMENTAL_REMOTING_HAL_BUFFER_H_
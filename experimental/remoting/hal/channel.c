@@ -0,0 +1,184 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/remoting/hal/channel.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/tracing.h"
+
+// Maximum number of characters of a remote error message that are preserved.
+#define IREE_REMOTING_HAL_MAX_ERROR_MESSAGE_LENGTH 1024
+
+iree_status_t iree_remoting_hal_channel_create(
+    iree_remoting_transport_t* transport, iree_allocator_t host_allocator,
+    iree_remoting_hal_channel_t** out_channel) {
+  IREE_ASSERT_ARGUMENT(transport);
+  IREE_ASSERT_ARGUMENT(out_channel);
+  *out_channel = NULL;
+
+  iree_remoting_hal_channel_t* channel = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(host_allocator, sizeof(*channel),
+                                             (void**)&channel));
+  iree_atomic_ref_count_init(&channel->ref_count);
+  channel->host_allocator = host_allocator;
+  channel->transport = transport;
+  iree_remoting_transport_retain(transport);
+  iree_slim_mutex_initialize(&channel->mutex);
+  channel->next_id = IREE_REMOTING_HAL_NULL_ID + 1;
+  *out_channel = channel;
+  return iree_ok_status();
+}
+
+void iree_remoting_hal_channel_retain(iree_remoting_hal_channel_t* channel) {
+  if (IREE_LIKELY(channel)) {
+    iree_atomic_ref_count_inc(&channel->ref_count);
+  }
+}
+
+void iree_remoting_hal_channel_release(iree_remoting_hal_channel_t* channel) {
+  if (IREE_LIKELY(channel) &&
+      iree_atomic_ref_count_dec(&channel->ref_count) == 1) {
+    iree_allocator_t host_allocator = channel->host_allocator;
+    iree_remoting_transport_release(channel->transport);
+    iree_slim_mutex_deinitialize(&channel->mutex);
+    iree_allocator_free(host_allocator, channel->free_ids);
+    iree_allocator_free(host_allocator, channel);
+  }
+}
+
+uint32_t iree_remoting_hal_channel_acquire_id(
+    iree_remoting_hal_channel_t* channel) {
+  iree_slim_mutex_lock(&channel->mutex);
+  uint32_t id = channel->free_id_count > 0
+                    ? channel->free_ids[--channel->free_id_count]
+                    : channel->next_id++;
+  iree_slim_mutex_unlock(&channel->mutex);
+  return id;
+}
+
+// Writes a request header and payload. Must be called with the mutex held.
+static iree_status_t iree_remoting_hal_channel_write_request(
+    iree_remoting_hal_channel_t* channel, iree_remoting_hal_opcode_t opcode,
+    uint32_t flags, iree_host_size_t span_count,
+    const iree_const_byte_span_t* spans) {
+  // The header and payload spans are gathered into a single write so that
+  // small requests go out as one transport operation.
+  iree_const_byte_span_t* all_spans =
+      (iree_const_byte_span_t*)iree_alloca((span_count + 1) * sizeof(*spans));
+  iree_remoting_hal_request_header_t header = {
+      .opcode = (uint32_t)opcode,
+      .flags = flags,
+      .payload_length = 0,
+  };
+  for (iree_host_size_t i = 0; i < span_count; ++i) {
+    header.payload_length += spans[i].data_length;
+    all_spans[i + 1] = spans[i];
+  }
+  all_spans[0] = iree_make_const_byte_span(&header, sizeof(header));
+  return iree_remoting_transport_write(channel->transport, span_count + 1,
+                                       all_spans);
+}
+
+void iree_remoting_hal_channel_release_id(iree_remoting_hal_channel_t* channel,
+                                          uint32_t id) {
+  iree_const_byte_span_t span = iree_make_const_byte_span(&id, sizeof(id));
+  iree_slim_mutex_lock(&channel->mutex);
+
+  // A failure here means the connection is gone and the server has dropped
+  // all resources already.
+  iree_status_ignore(iree_remoting_hal_channel_write_request(
+      channel, IREE_REMOTING_HAL_OPCODE_RESOURCE_RELEASE, 0, 1, &span));
+
+  // The id can only be reused once the release has been sent so that the
+  // server never sees two live resources with the same id.
+  if (channel->free_id_count == channel->free_id_capacity) {
+    iree_host_size_t new_capacity =
+        iree_max((iree_host_size_t)16, channel->free_id_capacity * 2);
+    if (iree_status_is_ok(iree_allocator_realloc(
+            channel->host_allocator, new_capacity * sizeof(*channel->free_ids),
+            (void**)&channel->free_ids))) {
+      channel->free_id_capacity = new_capacity;
+    }
+  }
+  if (channel->free_id_count < channel->free_id_capacity) {
+    channel->free_ids[channel->free_id_count++] = id;
+  }
+
+  iree_slim_mutex_unlock(&channel->mutex);
+}
+
+iree_status_t iree_remoting_hal_channel_send(
+    iree_remoting_hal_channel_t* channel, iree_remoting_hal_opcode_t opcode,
+    iree_host_size_t span_count, const iree_const_byte_span_t* spans) {
+  iree_slim_mutex_lock(&channel->mutex);
+  iree_status_t status = iree_remoting_hal_channel_write_request(
+      channel, opcode, 0, span_count, spans);
+  iree_slim_mutex_unlock(&channel->mutex);
+  return status;
+}
+
+// Reads the error message of a failed call and returns it as a status.
+static iree_status_t iree_remoting_hal_channel_read_error(
+    iree_remoting_hal_channel_t* channel,
+    const iree_remoting_hal_response_header_t* header) {
+  char message[IREE_REMOTING_HAL_MAX_ERROR_MESSAGE_LENGTH];
+  iree_host_size_t message_length =
+      (iree_host_size_t)iree_min(header->payload_length, sizeof(message));
+  IREE_RETURN_IF_ERROR(iree_remoting_transport_read(
+      channel->transport, iree_make_byte_span(message, message_length)));
+
+  // Drain anything beyond what we keep so the stream stays in sync.
+  uint64_t remaining = header->payload_length - message_length;
+  while (remaining > 0) {
+    char discard[256];
+    iree_host_size_t chunk =
+        (iree_host_size_t)iree_min(remaining, sizeof(discard));
+    IREE_RETURN_IF_ERROR(iree_remoting_transport_read(
+        channel->transport, iree_make_byte_span(discard, chunk)));
+    remaining -= chunk;
+  }
+
+  return iree_make_status((iree_status_code_t)header->status_code,
+                          "remote: %.*s", (int)message_length, message);
+}
+
+iree_status_t iree_remoting_hal_channel_call(
+    iree_remoting_hal_channel_t* channel, iree_remoting_hal_opcode_t opcode,
+    iree_host_size_t span_count, const iree_const_byte_span_t* spans,
+    iree_byte_span_t result) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)opcode);
+  iree_slim_mutex_lock(&channel->mutex);
+
+  iree_status_t status = iree_remoting_hal_channel_write_request(
+      channel, opcode, IREE_REMOTING_HAL_REQUEST_FLAG_CALL, span_count, spans);
+
+  iree_remoting_hal_response_header_t header;
+  if (iree_status_is_ok(status)) {
+    status = iree_remoting_transport_read(
+        channel->transport, iree_make_byte_span(&header, sizeof(header)));
+  }
+  if (iree_status_is_ok(status)) {
+    if (header.status_code != IREE_STATUS_OK) {
+      status = iree_remoting_hal_channel_read_error(channel, &header);
+    } else if (header.payload_length != result.data_length) {
+      // The stream can't be resynchronized from here.
+      status = iree_make_status(
+          IREE_STATUS_DATA_LOSS,
+          "remote call returned %" PRIu64 " bytes but %zu were expected",
+          header.payload_length, result.data_length);
+    } else {
+      status = iree_remoting_transport_read(channel->transport, result);
+    }
+  }
+
+  iree_slim_mutex_unlock(&channel->mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
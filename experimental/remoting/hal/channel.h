@@ -0,0 +1,79 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef EXPERIMENTAL_REMOTING_HAL_CHANNEL_H_
+#define EXPERIMENTAL_REMOTING_HAL_CHANNEL_H_
+
+#include "experimental/remoting/hal/protocol.h"
+#include "experimental/remoting/transport/transport.h"
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Client end of a connection to a device server.
+// Shared by the remote device and all resources created from it; each
+// resource retains the channel so it can release its remote counterpart.
+//
+// Thread-safe: requests from multiple threads are serialized so that each
+// call observes its own response.
+typedef struct iree_remoting_hal_channel_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_remoting_transport_t* transport;
+
+  // Guards the transport and the id pool.
+  iree_slim_mutex_t mutex;
+
+  // Next never-used resource id.
+  uint32_t next_id;
+  // Ids whose resources have been released and may be reused.
+  uint32_t* free_ids;
+  iree_host_size_t free_id_count;
+  iree_host_size_t free_id_capacity;
+} iree_remoting_hal_channel_t;
+
+// Creates a channel communicating over |transport|, which is retained.
+iree_status_t iree_remoting_hal_channel_create(
+    iree_remoting_transport_t* transport, iree_allocator_t host_allocator,
+    iree_remoting_hal_channel_t** out_channel);
+
+void iree_remoting_hal_channel_retain(iree_remoting_hal_channel_t* channel);
+
+void iree_remoting_hal_channel_release(iree_remoting_hal_channel_t* channel);
+
+// Reserves an id for a new remote resource.
+uint32_t iree_remoting_hal_channel_acquire_id(
+    iree_remoting_hal_channel_t* channel);
+
+// Releases the remote resource |id| and returns the id to the pool.
+// Failures are latched by the server and reported from the next call.
+void iree_remoting_hal_channel_release_id(iree_remoting_hal_channel_t* channel,
+                                          uint32_t id);
+
+// Sends a one-way request with the concatenation of |spans| as payload.
+iree_status_t iree_remoting_hal_channel_send(
+    iree_remoting_hal_channel_t* channel, iree_remoting_hal_opcode_t opcode,
+    iree_host_size_t span_count, const iree_const_byte_span_t* spans);
+
+// Sends a call with the concatenation of |spans| as payload and waits for the
+// response. On success the result payload must be exactly
+// |result|.data_length bytes and is read directly into |result|.
+//
+// Returns the failure of the call or of any one-way request sent before it.
+iree_status_t iree_remoting_hal_channel_call(
+    iree_remoting_hal_channel_t* channel, iree_remoting_hal_opcode_t opcode,
+    iree_host_size_t span_count, const iree_const_byte_span_t* spans,
+    iree_byte_span_t result);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // EXPERIMENTAL_REMOTING_HAL_CHANNEL_H_
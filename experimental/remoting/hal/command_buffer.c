@@ -0,0 +1,439 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/remoting/hal/command_buffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "experimental/remoting/hal/buffer.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/utils/resource_set.h"
+
+// Alignment of each encoded command.
+#define IREE_REMOTING_HAL_COMMAND_ALIGNMENT 8
+
+typedef struct iree_remoting_hal_command_buffer_t {
+  iree_hal_command_buffer_t base;
+  iree_allocator_t host_allocator;
+  iree_remoting_hal_channel_t* channel;
+  iree_arena_block_pool_t* block_pool;
+
+  // Buffers referenced by the recorded commands. Retained so that their ids
+  // remain valid until the server has recorded the commands.
+  iree_hal_resource_set_t* resource_set;
+
+  // Commands encoded since the last begin.
+  uint8_t* commands;
+  iree_host_size_t commands_length;
+  iree_host_size_t commands_capacity;
+
+  // Id of the command buffer recorded on the server by the last end or
+  // IREE_REMOTING_HAL_NULL_ID if not yet ended.
+  uint32_t command_buffer_id;
+} iree_remoting_hal_command_buffer_t;
+
+static const iree_hal_command_buffer_vtable_t
+    iree_remoting_hal_command_buffer_vtable;
+
+static iree_remoting_hal_command_buffer_t*
+iree_remoting_hal_command_buffer_cast(iree_hal_command_buffer_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_remoting_hal_command_buffer_vtable);
+  return (iree_remoting_hal_command_buffer_t*)base_value;
+}
+
+iree_status_t iree_remoting_hal_command_buffer_create(
+    iree_hal_device_t* device, iree_remoting_hal_channel_t* channel,
+    iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(channel);
+  IREE_ASSERT_ARGUMENT(block_pool);
+  IREE_ASSERT_ARGUMENT(out_command_buffer);
+  *out_command_buffer = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_remoting_hal_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*command_buffer), (void**)&command_buffer);
+  if (iree_status_is_ok(status)) {
+    memset(command_buffer, 0, sizeof(*command_buffer));
+    iree_hal_command_buffer_initialize(
+        device, mode, command_categories, queue_affinity,
+        &iree_remoting_hal_command_buffer_vtable, &command_buffer->base);
+    command_buffer->host_allocator = host_allocator;
+    command_buffer->channel = channel;
+    iree_remoting_hal_channel_retain(channel);
+    command_buffer->block_pool = block_pool;
+    status = iree_hal_resource_set_allocate(block_pool,
+                                            &command_buffer->resource_set);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_command_buffer = &command_buffer->base;
+  } else if (command_buffer) {
+    iree_hal_command_buffer_release(&command_buffer->base);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Releases the server command buffer of the previous recording, if any.
+static void iree_remoting_hal_command_buffer_release_remote(
+    iree_remoting_hal_command_buffer_t* command_buffer) {
+  if (command_buffer->command_buffer_id != IREE_REMOTING_HAL_NULL_ID) {
+    iree_remoting_hal_channel_release_id(command_buffer->channel,
+                                         command_buffer->command_buffer_id);
+    command_buffer->command_buffer_id = IREE_REMOTING_HAL_NULL_ID;
+  }
+}
+
+static void iree_remoting_hal_command_buffer_destroy(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_remoting_hal_command_buffer_t* command_buffer =
+      iree_remoting_hal_command_buffer_cast(base_command_buffer);
+  iree_allocator_t host_allocator = command_buffer->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_remoting_hal_command_buffer_release_remote(command_buffer);
+  iree_hal_resource_set_free(command_buffer->resource_set);
+  iree_allocator_free(host_allocator, command_buffer->commands);
+  iree_remoting_hal_channel_release(command_buffer->channel);
+  iree_allocator_free(host_allocator, command_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_remoting_hal_command_buffer_id(
+    iree_hal_command_buffer_t* base_command_buffer,
+    uint32_t* out_command_buffer_id) {
+  iree_remoting_hal_command_buffer_t* command_buffer =
+      (iree_remoting_hal_command_buffer_t*)iree_hal_command_buffer_dyn_cast(
+          base_command_buffer, &iree_remoting_hal_command_buffer_vtable);
+  if (!command_buffer) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "command buffer was not created by a remote device");
+  } else if (command_buffer->command_buffer_id == IREE_REMOTING_HAL_NULL_ID) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "command buffer has not finished recording");
+  }
+  *out_command_buffer_id = command_buffer->command_buffer_id;
+  return iree_ok_status();
+}
+
+static void* iree_remoting_hal_command_buffer_dyn_cast(
+    iree_hal_command_buffer_t* command_buffer, const void* vtable) {
+  if (vtable == &iree_remoting_hal_command_buffer_vtable) {
+    IREE_HAL_ASSERT_TYPE(command_buffer, vtable);
+    return command_buffer;
+  }
+  return NULL;
+}
+
+// Appends a command of |type| with |payload_length| bytes of payload to the
+// encoding and returns a pointer to the payload in |out_payload|.
+static iree_status_t iree_remoting_hal_command_buffer_append(
+    iree_remoting_hal_command_buffer_t* command_buffer,
+    iree_remoting_hal_command_type_t type, iree_host_size_t payload_length,
+    void** out_payload) {
+  iree_host_size_t command_length =
+      iree_host_align(sizeof(iree_remoting_hal_command_header_t) +
+                          payload_length,
+                      IREE_REMOTING_HAL_COMMAND_ALIGNMENT);
+  if (command_length > UINT32_MAX) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "command of %zu bytes exceeds the encoding limit",
+                            command_length);
+  }
+  iree_host_size_t required_capacity =
+      command_buffer->commands_length + command_length;
+  if (required_capacity > command_buffer->commands_capacity) {
+    iree_host_size_t new_capacity =
+        iree_max(iree_max((iree_host_size_t)4096, required_capacity),
+                 command_buffer->commands_capacity * 2);
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(command_buffer->host_allocator,
+                                                new_capacity,
+                                                (void**)&command_buffer->commands));
+    command_buffer->commands_capacity = new_capacity;
+  }
+
+  uint8_t* command_ptr =
+      command_buffer->commands + command_buffer->commands_length;
+  memset(command_ptr, 0, command_length);
+  iree_remoting_hal_command_header_t* header =
+      (iree_remoting_hal_command_header_t*)command_ptr;
+  header->type = (uint32_t)type;
+  header->length = (uint32_t)command_length;
+  command_buffer->commands_length += command_length;
+  if (out_payload) *out_payload = command_ptr + sizeof(*header);
+  return iree_ok_status();
+}
+
+// Retains |buffer| for the recording and resolves it to a remote allocation.
+static iree_status_t iree_remoting_hal_command_buffer_use_buffer(
+    iree_remoting_hal_command_buffer_t* command_buffer,
+    iree_hal_buffer_t* buffer, uint32_t* out_buffer_id,
+    iree_device_size_t* offset) {
+  IREE_RETURN_IF_ERROR(
+      iree_remoting_hal_buffer_resolve(buffer, out_buffer_id, offset));
+  return iree_hal_resource_set_insert(command_buffer->resource_set, 1, &buffer);
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_begin(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_remoting_hal_command_buffer_t* command_buffer =
+      iree_remoting_hal_command_buffer_cast(base_command_buffer);
+  iree_remoting_hal_command_buffer_release_remote(command_buffer);
+  iree_hal_resource_set_reset(command_buffer->resource_set);
+  command_buffer->commands_length = 0;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_end(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_remoting_hal_command_buffer_t* command_buffer =
+      iree_remoting_hal_command_buffer_cast(base_command_buffer);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)command_buffer->commands_length);
+
+  // The whole recording goes out as one pipelined message. Recording failures
+  // on the server are reported by the next call.
+  uint32_t command_buffer_id =
+      iree_remoting_hal_channel_acquire_id(command_buffer->channel);
+  iree_remoting_hal_command_buffer_create_request_t request = {
+      .command_buffer_id = command_buffer_id,
+      .mode = base_command_buffer->mode,
+      .command_categories = base_command_buffer->allowed_categories,
+      .queue_affinity = base_command_buffer->queue_affinity,
+  };
+  iree_const_byte_span_t spans[2] = {
+      iree_make_const_byte_span(&request, sizeof(request)),
+      iree_make_const_byte_span(command_buffer->commands,
+                                command_buffer->commands_length),
+  };
+  iree_status_t status = iree_remoting_hal_channel_send(
+      command_buffer->channel, IREE_REMOTING_HAL_OPCODE_COMMAND_BUFFER_CREATE,
+      IREE_ARRAYSIZE(spans), spans);
+  if (iree_status_is_ok(status)) {
+    command_buffer->command_buffer_id = command_buffer_id;
+  } else {
+    iree_remoting_hal_channel_release_id(command_buffer->channel,
+                                         command_buffer_id);
+  }
+
+  // Ids referenced by the recording are captured by the server command buffer
+  // and the encoding is no longer needed.
+  iree_hal_resource_set_reset(command_buffer->resource_set);
+  command_buffer->commands_length = 0;
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_remoting_hal_command_buffer_begin_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer, iree_string_view_t label,
+    iree_hal_label_color_t label_color,
+    const iree_hal_label_location_t* location) {
+  // TODO: forward debug groups so remote captures are annotated.
+}
+
+static void iree_remoting_hal_command_buffer_end_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer) {}
+
+static iree_status_t iree_remoting_hal_command_buffer_execution_barrier(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_hal_execution_barrier_flags_t flags,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  iree_remoting_hal_command_buffer_t* command_buffer =
+      iree_remoting_hal_command_buffer_cast(base_command_buffer);
+  // Barriers are widened to full execution barriers; the transfer commands we
+  // forward gain nothing from finer scopes.
+  return iree_remoting_hal_command_buffer_append(
+      command_buffer, IREE_REMOTING_HAL_COMMAND_EXECUTION_BARRIER, 0, NULL);
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_signal_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "events not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_reset_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "events not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_wait_events(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_host_size_t event_count, const iree_hal_event_t** events,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "events not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_discard_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_buffer_t* buffer) {
+  // Nothing to do.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_fill_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length, const void* pattern,
+    iree_host_size_t pattern_length) {
+  iree_remoting_hal_command_buffer_t* command_buffer =
+      iree_remoting_hal_command_buffer_cast(base_command_buffer);
+  uint32_t target_buffer_id = IREE_REMOTING_HAL_NULL_ID;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_command_buffer_use_buffer(
+      command_buffer, target_buffer, &target_buffer_id, &target_offset));
+  iree_remoting_hal_fill_buffer_command_t* command = NULL;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_command_buffer_append(
+      command_buffer, IREE_REMOTING_HAL_COMMAND_FILL_BUFFER, sizeof(*command),
+      (void**)&command));
+  command->target.buffer_id = target_buffer_id;
+  command->target.offset = target_offset;
+  command->target.length = length;
+  memcpy(&command->pattern, pattern, pattern_length);
+  command->pattern_length = (uint32_t)pattern_length;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_update_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, const void* source_buffer,
+    iree_host_size_t source_offset, iree_hal_buffer_t* target_buffer,
+    iree_device_size_t target_offset, iree_device_size_t length) {
+  iree_remoting_hal_command_buffer_t* command_buffer =
+      iree_remoting_hal_command_buffer_cast(base_command_buffer);
+  uint32_t target_buffer_id = IREE_REMOTING_HAL_NULL_ID;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_command_buffer_use_buffer(
+      command_buffer, target_buffer, &target_buffer_id, &target_offset));
+  // The source data is captured inline as the caller may reuse it as soon as
+  // this returns.
+  iree_remoting_hal_buffer_range_t* command = NULL;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_command_buffer_append(
+      command_buffer, IREE_REMOTING_HAL_COMMAND_UPDATE_BUFFER,
+      sizeof(*command) + (iree_host_size_t)length, (void**)&command));
+  command->buffer_id = target_buffer_id;
+  command->offset = target_offset;
+  command->length = length;
+  memcpy(command + 1, (const uint8_t*)source_buffer + source_offset,
+         (iree_host_size_t)length);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_copy_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* source_buffer, iree_device_size_t source_offset,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length) {
+  iree_remoting_hal_command_buffer_t* command_buffer =
+      iree_remoting_hal_command_buffer_cast(base_command_buffer);
+  uint32_t source_buffer_id = IREE_REMOTING_HAL_NULL_ID;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_command_buffer_use_buffer(
+      command_buffer, source_buffer, &source_buffer_id, &source_offset));
+  uint32_t target_buffer_id = IREE_REMOTING_HAL_NULL_ID;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_command_buffer_use_buffer(
+      command_buffer, target_buffer, &target_buffer_id, &target_offset));
+  iree_remoting_hal_copy_buffer_command_t* command = NULL;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_command_buffer_append(
+      command_buffer, IREE_REMOTING_HAL_COMMAND_COPY_BUFFER, sizeof(*command),
+      (void**)&command));
+  command->source_buffer_id = source_buffer_id;
+  command->target_buffer_id = target_buffer_id;
+  command->source_offset = source_offset;
+  command->target_offset = target_offset;
+  command->length = length;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_push_constants(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
+    const void* values, iree_host_size_t values_length) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "dispatches not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_push_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "dispatches not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_bind_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_hal_descriptor_set_t* descriptor_set,
+    iree_host_size_t dynamic_offset_count,
+    const iree_device_size_t* dynamic_offsets) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "dispatches not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_dispatch(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "dispatches not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_command_buffer_dispatch_indirect(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    iree_hal_buffer_t* workgroups_buffer,
+    iree_device_size_t workgroups_offset) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "dispatches not yet supported by remote devices");
+}
+
+static const iree_hal_command_buffer_vtable_t
+    iree_remoting_hal_command_buffer_vtable = {
+        .destroy = iree_remoting_hal_command_buffer_destroy,
+        .dyn_cast = iree_remoting_hal_command_buffer_dyn_cast,
+        .begin = iree_remoting_hal_command_buffer_begin,
+        .end = iree_remoting_hal_command_buffer_end,
+        .begin_debug_group = iree_remoting_hal_command_buffer_begin_debug_group,
+        .end_debug_group = iree_remoting_hal_command_buffer_end_debug_group,
+        .execution_barrier = iree_remoting_hal_command_buffer_execution_barrier,
+        .signal_event = iree_remoting_hal_command_buffer_signal_event,
+        .reset_event = iree_remoting_hal_command_buffer_reset_event,
+        .wait_events = iree_remoting_hal_command_buffer_wait_events,
+        .discard_buffer = iree_remoting_hal_command_buffer_discard_buffer,
+        .fill_buffer = iree_remoting_hal_command_buffer_fill_buffer,
+        .update_buffer = iree_remoting_hal_command_buffer_update_buffer,
+        .copy_buffer = iree_remoting_hal_command_buffer_copy_buffer,
+        .push_constants = iree_remoting_hal_command_buffer_push_constants,
+        .push_descriptor_set =
+            iree_remoting_hal_command_buffer_push_descriptor_set,
+        .bind_descriptor_set =
+            iree_remoting_hal_command_buffer_bind_descriptor_set,
+        .dispatch = iree_remoting_hal_command_buffer_dispatch,
+        .dispatch_indirect = iree_remoting_hal_command_buffer_dispatch_indirect,
+};
@@ -0,0 +1,43 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef EXPERIMENTAL_REMOTING_HAL_COMMAND_BUFFER_H_
+#define EXPERIMENTAL_REMOTING_HAL_COMMAND_BUFFER_H_
+
+#include "experimental/remoting/hal/channel.h"
+#include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a command buffer that encodes commands on the host and sends them to
+// the server in one message when recording ends. The server records them into
+// a command buffer on the served device that can then be submitted by id any
+// number of times (if not one-shot).
+//
+// Only transfer commands and barriers are supported; dispatches, events and
+// descriptor sets return IREE_STATUS_UNIMPLEMENTED as executables are not yet
+// forwarded to the server.
+iree_status_t iree_remoting_hal_command_buffer_create(
+    iree_hal_device_t* device, iree_remoting_hal_channel_t* channel,
+    iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer);
+
+// Returns the remote id of the last completed recording of |command_buffer|.
+iree_status_t iree_remoting_hal_command_buffer_id(
+    iree_hal_command_buffer_t* command_buffer, uint32_t* out_command_buffer_id);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // EXPERIMENTAL_REMOTING_HAL_COMMAND_BUFFER_H_
@@ -0,0 +1,201 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Wire format shared by the remote HAL device and the device server.
+//
+// Every message sent by the client begins with an
+// iree_remoting_hal_request_header_t followed by |payload_length| bytes of
+// opcode-specific payload. Messages are processed by the server strictly in
+// the order they are sent.
+//
+// Requests are either calls or one-way messages:
+//  - Calls (IREE_REMOTING_HAL_REQUEST_FLAG_CALL) are answered with an
+//    iree_remoting_hal_response_header_t followed by the result payload (or,
+//    on failure, the formatted error message).
+//  - One-way messages are not answered so that the client can pipeline them
+//    without waiting on the round trip. Any failure is latched by the server
+//    and returned from the next call.
+//
+// Resources are named by 32-bit ids chosen by the client so that creating them
+// does not require a round trip either. Ids are only reused after the release
+// of the previous resource with the same id has been sent.
+//
+// All values are in host byte order: both endpoints are expected to share an
+// architecture.
+
+#ifndef EXPERIMENTAL_REMOTING_HAL_PROTOCOL_H_
+#define EXPERIMENTAL_REMOTING_HAL_PROTOCOL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Resource id that never names a resource.
+#define IREE_REMOTING_HAL_NULL_ID 0u
+
+// Upper bound on how long the server blocks in a single semaphore wait call.
+// Waits are serviced on the connection thread and longer waits are split into
+// slices by the client so other requests are not starved.
+#define IREE_REMOTING_HAL_MAX_WAIT_SLICE_NS (2 * 1000000ll)
+
+typedef enum iree_remoting_hal_opcode_e {
+  // Call. Payload: iree_remoting_hal_query_i32_request_t followed by the
+  // category and key characters. Result: int32_t.
+  IREE_REMOTING_HAL_OPCODE_DEVICE_QUERY_I32 = 1,
+  // Call. Payload: int64_t relative timeout in nanoseconds.
+  IREE_REMOTING_HAL_OPCODE_DEVICE_WAIT_IDLE = 2,
+  // One-way. Payload: uint32_t resource id.
+  IREE_REMOTING_HAL_OPCODE_RESOURCE_RELEASE = 3,
+  // Call. Payload: iree_remoting_hal_buffer_allocate_request_t.
+  IREE_REMOTING_HAL_OPCODE_BUFFER_ALLOCATE = 4,
+  // One-way. Payload: iree_remoting_hal_buffer_range_t followed by |length|
+  // bytes of data.
+  IREE_REMOTING_HAL_OPCODE_BUFFER_WRITE = 5,
+  // Call. Payload: iree_remoting_hal_buffer_range_t. Result: |length| bytes.
+  IREE_REMOTING_HAL_OPCODE_BUFFER_READ = 6,
+  // One-way. Payload: iree_remoting_hal_semaphore_value_t with the initial
+  // value.
+  IREE_REMOTING_HAL_OPCODE_SEMAPHORE_CREATE = 7,
+  // Call. Payload: uint32_t semaphore id. Result: uint64_t value.
+  IREE_REMOTING_HAL_OPCODE_SEMAPHORE_QUERY = 8,
+  // One-way. Payload: iree_remoting_hal_semaphore_value_t.
+  IREE_REMOTING_HAL_OPCODE_SEMAPHORE_SIGNAL = 9,
+  // One-way. Payload: iree_remoting_hal_semaphore_fail_request_t followed by
+  // the message characters.
+  IREE_REMOTING_HAL_OPCODE_SEMAPHORE_FAIL = 10,
+  // Call. Payload: iree_remoting_hal_semaphore_wait_request_t.
+  IREE_REMOTING_HAL_OPCODE_SEMAPHORE_WAIT = 11,
+  // One-way. Payload: iree_remoting_hal_command_buffer_create_request_t
+  // followed by the encoded commands.
+  IREE_REMOTING_HAL_OPCODE_COMMAND_BUFFER_CREATE = 12,
+  // One-way. Payload: uint64_t batch count followed by that many encoded
+  // batches (see iree_remoting_hal_submit_batch_t).
+  IREE_REMOTING_HAL_OPCODE_QUEUE_SUBMIT = 13,
+} iree_remoting_hal_opcode_t;
+
+typedef enum iree_remoting_hal_request_flag_bits_e {
+  // The client waits for a response to the request.
+  IREE_REMOTING_HAL_REQUEST_FLAG_CALL = 1u << 0,
+} iree_remoting_hal_request_flag_bits_t;
+
+typedef struct iree_remoting_hal_request_header_t {
+  uint32_t opcode;
+  uint32_t flags;
+  uint64_t payload_length;
+} iree_remoting_hal_request_header_t;
+
+typedef struct iree_remoting_hal_response_header_t {
+  // iree_status_code_t of the call.
+  uint32_t status_code;
+  uint32_t reserved;
+  // Result payload when successful or the error message length on failure.
+  uint64_t payload_length;
+} iree_remoting_hal_response_header_t;
+
+typedef struct iree_remoting_hal_query_i32_request_t {
+  uint32_t category_length;
+  uint32_t key_length;
+} iree_remoting_hal_query_i32_request_t;
+
+typedef struct iree_remoting_hal_buffer_allocate_request_t {
+  uint32_t buffer_id;
+  uint32_t memory_type;
+  uint32_t allowed_usage;
+  uint32_t reserved;
+  uint64_t allocation_size;
+} iree_remoting_hal_buffer_allocate_request_t;
+
+typedef struct iree_remoting_hal_buffer_range_t {
+  uint32_t buffer_id;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t length;
+} iree_remoting_hal_buffer_range_t;
+
+typedef struct iree_remoting_hal_semaphore_value_t {
+  uint32_t semaphore_id;
+  uint32_t reserved;
+  uint64_t value;
+} iree_remoting_hal_semaphore_value_t;
+
+typedef struct iree_remoting_hal_semaphore_fail_request_t {
+  uint32_t semaphore_id;
+  uint32_t status_code;
+  uint64_t message_length;
+} iree_remoting_hal_semaphore_fail_request_t;
+
+typedef struct iree_remoting_hal_semaphore_wait_request_t {
+  uint32_t semaphore_id;
+  uint32_t reserved;
+  uint64_t value;
+  // Relative timeout; clamped by the server to
+  // IREE_REMOTING_HAL_MAX_WAIT_SLICE_NS.
+  int64_t timeout_ns;
+} iree_remoting_hal_semaphore_wait_request_t;
+
+typedef struct iree_remoting_hal_command_buffer_create_request_t {
+  uint32_t command_buffer_id;
+  uint32_t mode;
+  uint32_t command_categories;
+  uint32_t reserved;
+  uint64_t queue_affinity;
+} iree_remoting_hal_command_buffer_create_request_t;
+
+// Batch header in a QUEUE_SUBMIT payload. Followed by |wait_count| and then
+// |signal_count| iree_remoting_hal_semaphore_value_t and finally
+// |command_buffer_count| uint32_t command buffer ids padded to 8 bytes.
+typedef struct iree_remoting_hal_submit_batch_t {
+  uint32_t wait_count;
+  uint32_t signal_count;
+  uint32_t command_buffer_count;
+  uint32_t reserved;
+} iree_remoting_hal_submit_batch_t;
+
+//===----------------------------------------------------------------------===//
+// Command encoding
+//===----------------------------------------------------------------------===//
+
+// Commands are recorded by the client and replayed by the server into a
+// command buffer created on the served device. Each command begins with an
+// iree_remoting_hal_command_header_t and is padded to 8 bytes.
+typedef enum iree_remoting_hal_command_type_e {
+  // A full execution barrier; no payload.
+  IREE_REMOTING_HAL_COMMAND_EXECUTION_BARRIER = 1,
+  // Payload: iree_remoting_hal_fill_buffer_command_t.
+  IREE_REMOTING_HAL_COMMAND_FILL_BUFFER = 2,
+  // Payload: iree_remoting_hal_buffer_range_t followed by the data.
+  IREE_REMOTING_HAL_COMMAND_UPDATE_BUFFER = 3,
+  // Payload: iree_remoting_hal_copy_buffer_command_t.
+  IREE_REMOTING_HAL_COMMAND_COPY_BUFFER = 4,
+} iree_remoting_hal_command_type_t;
+
+typedef struct iree_remoting_hal_command_header_t {
+  uint32_t type;
+  // Total length of the command in bytes including this header and padding.
+  uint32_t length;
+} iree_remoting_hal_command_header_t;
+
+typedef struct iree_remoting_hal_fill_buffer_command_t {
+  iree_remoting_hal_buffer_range_t target;
+  uint32_t pattern;
+  uint32_t pattern_length;
+} iree_remoting_hal_fill_buffer_command_t;
+
+typedef struct iree_remoting_hal_copy_buffer_command_t {
+  uint32_t source_buffer_id;
+  uint32_t target_buffer_id;
+  uint64_t source_offset;
+  uint64_t target_offset;
+  uint64_t length;
+} iree_remoting_hal_copy_buffer_command_t;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // EXPERIMENTAL_REMOTING_HAL_PROTOCOL_H_
@@ -0,0 +1,356 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "experimental/remoting/hal/allocator.h"
+#include "experimental/remoting/hal/api.h"
+#include "experimental/remoting/hal/channel.h"
+#include "experimental/remoting/hal/command_buffer.h"
+#include "experimental/remoting/hal/semaphore.h"
+#include "iree/base/internal/arena.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/utils/buffer_transfer.h"
+
+// Block size used for command buffer resource sets.
+#define IREE_REMOTING_HAL_DEVICE_BLOCK_SIZE (32 * 1024)
+
+typedef struct iree_remoting_hal_device_t {
+  iree_hal_resource_t resource;
+  iree_string_view_t identifier;
+  iree_allocator_t host_allocator;
+  iree_hal_allocator_t* device_allocator;
+
+  iree_remoting_hal_channel_t* channel;
+
+  // Block pool used for command buffer transient allocations.
+  iree_arena_block_pool_t block_pool;
+} iree_remoting_hal_device_t;
+
+static const iree_hal_device_vtable_t iree_remoting_hal_device_vtable;
+
+static iree_remoting_hal_device_t* iree_remoting_hal_device_cast(
+    iree_hal_device_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_remoting_hal_device_vtable);
+  return (iree_remoting_hal_device_t*)base_value;
+}
+
+IREE_API_EXPORT iree_status_t iree_remoting_hal_device_create(
+    iree_string_view_t identifier, iree_remoting_transport_t* transport,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  IREE_ASSERT_ARGUMENT(transport);
+  IREE_ASSERT_ARGUMENT(out_device);
+  *out_device = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_remoting_hal_device_t* device = NULL;
+  iree_host_size_t total_size = sizeof(*device) + identifier.size;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, total_size, (void**)&device);
+  if (iree_status_is_ok(status)) {
+    memset(device, 0, total_size);
+    iree_hal_resource_initialize(&iree_remoting_hal_device_vtable,
+                                 &device->resource);
+    iree_string_view_append_to_buffer(identifier, &device->identifier,
+                                      (char*)device + sizeof(*device));
+    device->host_allocator = host_allocator;
+    iree_arena_block_pool_initialize(IREE_REMOTING_HAL_DEVICE_BLOCK_SIZE,
+                                     host_allocator, &device->block_pool);
+    status = iree_remoting_hal_channel_create(transport, host_allocator,
+                                              &device->channel);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_remoting_hal_allocator_create(
+        device->channel, host_allocator, &device->device_allocator);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_device = (iree_hal_device_t*)device;
+  } else {
+    iree_hal_device_release((iree_hal_device_t*)device);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_remoting_hal_device_destroy(iree_hal_device_t* base_device) {
+  iree_remoting_hal_device_t* device =
+      iree_remoting_hal_device_cast(base_device);
+  iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Resources created from the device retain the channel and the connection
+  // stays open until the last of them is released.
+  iree_hal_allocator_release(device->device_allocator);
+  iree_remoting_hal_channel_release(device->channel);
+  iree_arena_block_pool_deinitialize(&device->block_pool);
+  iree_allocator_free(host_allocator, device);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_string_view_t iree_remoting_hal_device_id(
+    iree_hal_device_t* base_device) {
+  iree_remoting_hal_device_t* device =
+      iree_remoting_hal_device_cast(base_device);
+  return device->identifier;
+}
+
+static iree_allocator_t iree_remoting_hal_device_host_allocator(
+    iree_hal_device_t* base_device) {
+  iree_remoting_hal_device_t* device =
+      iree_remoting_hal_device_cast(base_device);
+  return device->host_allocator;
+}
+
+static iree_hal_allocator_t* iree_remoting_hal_device_allocator(
+    iree_hal_device_t* base_device) {
+  iree_remoting_hal_device_t* device =
+      iree_remoting_hal_device_cast(base_device);
+  return device->device_allocator;
+}
+
+static iree_status_t iree_remoting_hal_device_trim(
+    iree_hal_device_t* base_device) {
+  iree_remoting_hal_device_t* device =
+      iree_remoting_hal_device_cast(base_device);
+  iree_arena_block_pool_trim(&device->block_pool);
+  return iree_hal_allocator_trim(device->device_allocator);
+}
+
+static iree_status_t iree_remoting_hal_device_query_i32(
+    iree_hal_device_t* base_device, iree_string_view_t category,
+    iree_string_view_t key, int32_t* out_value) {
+  iree_remoting_hal_device_t* device =
+      iree_remoting_hal_device_cast(base_device);
+  *out_value = 0;
+  iree_remoting_hal_query_i32_request_t request = {
+      .category_length = (uint32_t)category.size,
+      .key_length = (uint32_t)key.size,
+  };
+  iree_const_byte_span_t spans[3] = {
+      iree_make_const_byte_span(&request, sizeof(request)),
+      iree_make_const_byte_span(category.data, category.size),
+      iree_make_const_byte_span(key.data, key.size),
+  };
+  return iree_remoting_hal_channel_call(
+      device->channel, IREE_REMOTING_HAL_OPCODE_DEVICE_QUERY_I32,
+      IREE_ARRAYSIZE(spans), spans,
+      iree_make_byte_span(out_value, sizeof(*out_value)));
+}
+
+static iree_status_t iree_remoting_hal_device_create_command_buffer(
+    iree_hal_device_t* base_device, iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  iree_remoting_hal_device_t* device =
+      iree_remoting_hal_device_cast(base_device);
+  return iree_remoting_hal_command_buffer_create(
+      base_device, device->channel, mode, command_categories, queue_affinity,
+      &device->block_pool, device->host_allocator, out_command_buffer);
+}
+
+static iree_status_t iree_remoting_hal_device_create_descriptor_set(
+    iree_hal_device_t* base_device,
+    iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_hal_descriptor_set_t** out_descriptor_set) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "descriptor sets not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_device_create_descriptor_set_layout(
+    iree_hal_device_t* base_device,
+    iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "descriptor sets not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_device_create_event(
+    iree_hal_device_t* base_device, iree_hal_event_t** out_event) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "events not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_device_create_executable_cache(
+    iree_hal_device_t* base_device, iree_string_view_t identifier,
+    iree_hal_executable_cache_t** out_executable_cache) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "executables not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_device_create_executable_layout(
+    iree_hal_device_t* base_device, iree_host_size_t push_constants,
+    iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_hal_executable_layout_t** out_executable_layout) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "executables not yet supported by remote devices");
+}
+
+static iree_status_t iree_remoting_hal_device_create_semaphore(
+    iree_hal_device_t* base_device, uint64_t initial_value,
+    iree_hal_semaphore_t** out_semaphore) {
+  iree_remoting_hal_device_t* device =
+      iree_remoting_hal_device_cast(base_device);
+  return iree_remoting_hal_semaphore_create(device->channel, initial_value,
+                                            device->host_allocator,
+                                            out_semaphore);
+}
+
+// Encodes |semaphore_list| as iree_remoting_hal_semaphore_value_t entries.
+static iree_status_t iree_remoting_hal_device_encode_semaphores(
+    const iree_hal_semaphore_list_t* semaphore_list,
+    iree_remoting_hal_semaphore_value_t* out_values) {
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    memset(&out_values[i], 0, sizeof(out_values[i]));
+    IREE_RETURN_IF_ERROR(iree_remoting_hal_semaphore_id(
+        semaphore_list->semaphores[i], &out_values[i].semaphore_id));
+    out_values[i].value = semaphore_list->payload_values[i];
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_device_queue_submit(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches) {
+  iree_remoting_hal_device_t* device =
+      iree_remoting_hal_device_cast(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Encode all batches into a single message so the submission is one
+  // pipelined write.
+  iree_host_size_t payload_length = sizeof(uint64_t);
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    payload_length +=
+        sizeof(iree_remoting_hal_submit_batch_t) +
+        (batches[i].wait_semaphores.count +
+         batches[i].signal_semaphores.count) *
+            sizeof(iree_remoting_hal_semaphore_value_t) +
+        iree_host_align(batches[i].command_buffer_count * sizeof(uint32_t), 8);
+  }
+  uint8_t* payload = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(device->host_allocator, payload_length,
+                                (void**)&payload));
+
+  iree_status_t status = iree_ok_status();
+  uint8_t* payload_ptr = payload;
+  *(uint64_t*)payload_ptr = (uint64_t)batch_count;
+  payload_ptr += sizeof(uint64_t);
+  for (iree_host_size_t i = 0; i < batch_count && iree_status_is_ok(status);
+       ++i) {
+    const iree_hal_submission_batch_t* batch = &batches[i];
+    iree_remoting_hal_submit_batch_t header = {
+        .wait_count = (uint32_t)batch->wait_semaphores.count,
+        .signal_count = (uint32_t)batch->signal_semaphores.count,
+        .command_buffer_count = (uint32_t)batch->command_buffer_count,
+    };
+    memcpy(payload_ptr, &header, sizeof(header));
+    payload_ptr += sizeof(header);
+
+    iree_remoting_hal_semaphore_value_t* values =
+        (iree_remoting_hal_semaphore_value_t*)payload_ptr;
+    status = iree_remoting_hal_device_encode_semaphores(&batch->wait_semaphores,
+                                                        values);
+    if (!iree_status_is_ok(status)) break;
+    values += batch->wait_semaphores.count;
+    status = iree_remoting_hal_device_encode_semaphores(
+        &batch->signal_semaphores, values);
+    if (!iree_status_is_ok(status)) break;
+    values += batch->signal_semaphores.count;
+    payload_ptr = (uint8_t*)values;
+
+    uint32_t* command_buffer_ids = (uint32_t*)payload_ptr;
+    memset(command_buffer_ids, 0,
+           iree_host_align(batch->command_buffer_count * sizeof(uint32_t), 8));
+    for (iree_host_size_t j = 0;
+         j < batch->command_buffer_count && iree_status_is_ok(status); ++j) {
+      status = iree_remoting_hal_command_buffer_id(batch->command_buffers[j],
+                                                   &command_buffer_ids[j]);
+    }
+    payload_ptr +=
+        iree_host_align(batch->command_buffer_count * sizeof(uint32_t), 8);
+  }
+
+  if (iree_status_is_ok(status)) {
+    iree_const_byte_span_t span =
+        iree_make_const_byte_span(payload, payload_length);
+    status = iree_remoting_hal_channel_send(
+        device->channel, IREE_REMOTING_HAL_OPCODE_QUEUE_SUBMIT, 1, &span);
+  }
+
+  iree_allocator_free(device->host_allocator, payload);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_remoting_hal_device_submit_and_wait(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches,
+    iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
+    iree_timeout_t timeout) {
+  // Submit...
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_device_queue_submit(
+      base_device, command_categories, queue_affinity, batch_count, batches));
+
+  // ...and wait.
+  return iree_hal_semaphore_wait(wait_semaphore, wait_value, timeout);
+}
+
+static iree_status_t iree_remoting_hal_device_wait_semaphores(
+    iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  return iree_remoting_hal_semaphore_multi_wait(wait_mode, semaphore_list,
+                                                timeout);
+}
+
+static iree_status_t iree_remoting_hal_device_wait_idle(
+    iree_hal_device_t* base_device, iree_timeout_t timeout) {
+  iree_remoting_hal_device_t* device =
+      iree_remoting_hal_device_cast(base_device);
+  int64_t timeout_ns =
+      iree_absolute_deadline_to_timeout_ns(iree_timeout_as_deadline_ns(timeout));
+  iree_const_byte_span_t span =
+      iree_make_const_byte_span(&timeout_ns, sizeof(timeout_ns));
+  return iree_remoting_hal_channel_call(
+      device->channel, IREE_REMOTING_HAL_OPCODE_DEVICE_WAIT_IDLE, 1, &span,
+      iree_byte_span_empty());
+}
+
+static const iree_hal_device_vtable_t iree_remoting_hal_device_vtable = {
+    .destroy = iree_remoting_hal_device_destroy,
+    .id = iree_remoting_hal_device_id,
+    .host_allocator = iree_remoting_hal_device_host_allocator,
+    .device_allocator = iree_remoting_hal_device_allocator,
+    .trim = iree_remoting_hal_device_trim,
+    .query_i32 = iree_remoting_hal_device_query_i32,
+    .create_command_buffer = iree_remoting_hal_device_create_command_buffer,
+    .create_descriptor_set = iree_remoting_hal_device_create_descriptor_set,
+    .create_descriptor_set_layout =
+        iree_remoting_hal_device_create_descriptor_set_layout,
+    .create_event = iree_remoting_hal_device_create_event,
+    .create_executable_cache = iree_remoting_hal_device_create_executable_cache,
+    .create_executable_layout =
+        iree_remoting_hal_device_create_executable_layout,
+    .create_semaphore = iree_remoting_hal_device_create_semaphore,
+    .transfer_range = iree_hal_device_transfer_mappable_range,
+    .queue_submit = iree_remoting_hal_device_queue_submit,
+    .submit_and_wait = iree_remoting_hal_device_submit_and_wait,
+    .wait_semaphores = iree_remoting_hal_device_wait_semaphores,
+    .wait_idle = iree_remoting_hal_device_wait_idle,
+};
@@ -0,0 +1,198 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "experimental/remoting/hal/api.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/sync_device.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using iree::StatusCode;
+using iree::testing::status::StatusIs;
+
+// Serves a local synchronous device over an in-process shared-memory
+// transport and connects a remote device to it.
+class RemoteDeviceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_allocator_t host_allocator = iree_allocator_system();
+    iree_hal_allocator_t* local_allocator = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("local"), host_allocator, host_allocator,
+        &local_allocator));
+    iree_hal_sync_device_params_t params;
+    iree_hal_sync_device_params_initialize(&params);
+    IREE_ASSERT_OK(iree_hal_sync_device_create(
+        iree_make_cstring_view("local"), &params, /*loader_count=*/0,
+        /*loaders=*/NULL, local_allocator, host_allocator, &local_device_));
+    iree_hal_allocator_release(local_allocator);
+
+    iree_remoting_transport_t* client_transport = NULL;
+    iree_remoting_transport_t* server_transport = NULL;
+    IREE_ASSERT_OK(iree_remoting_shm_transport_create_pair(
+        64 * 1024, host_allocator, &client_transport, &server_transport));
+    IREE_ASSERT_OK(iree_remoting_hal_server_create(
+        local_device_, server_transport, host_allocator, &server_));
+    iree_remoting_transport_release(server_transport);
+    server_thread_ = std::thread([this]() {
+      IREE_EXPECT_OK(iree_remoting_hal_server_run(server_));
+    });
+    IREE_ASSERT_OK(iree_remoting_hal_device_create(
+        iree_make_cstring_view("remote"), client_transport, host_allocator,
+        &device_));
+    iree_remoting_transport_release(client_transport);
+  }
+
+  void TearDown() override {
+    // Releasing the device closes the connection and ends the server loop.
+    iree_hal_device_release(device_);
+    if (server_thread_.joinable()) server_thread_.join();
+    iree_remoting_hal_server_free(server_);
+    iree_hal_device_release(local_device_);
+  }
+
+  iree_hal_buffer_t* AllocateBuffer(iree_device_size_t size) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device_),
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING, size,
+        iree_const_byte_span_empty(), &buffer));
+    return buffer;
+  }
+
+  std::vector<uint8_t> ReadBuffer(iree_hal_buffer_t* buffer) {
+    iree_hal_buffer_mapping_t mapping;
+    IREE_CHECK_OK(iree_hal_buffer_map_range(
+        buffer, IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_READ, 0,
+        IREE_WHOLE_BUFFER, &mapping));
+    std::vector<uint8_t> data(
+        mapping.contents.data,
+        mapping.contents.data + mapping.contents.data_length);
+    IREE_CHECK_OK(iree_hal_buffer_unmap_range(&mapping));
+    return data;
+  }
+
+  iree_hal_device_t* local_device_ = NULL;
+  iree_remoting_hal_server_t* server_ = NULL;
+  std::thread server_thread_;
+  iree_hal_device_t* device_ = NULL;
+};
+
+TEST_F(RemoteDeviceTest, BufferMappingRoundTrip) {
+  iree_hal_buffer_t* buffer = AllocateBuffer(64);
+
+  iree_hal_buffer_mapping_t mapping;
+  IREE_ASSERT_OK(iree_hal_buffer_map_range(
+      buffer, IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_DISCARD_WRITE,
+      16, 32, &mapping));
+  for (iree_host_size_t i = 0; i < mapping.contents.data_length; ++i) {
+    mapping.contents.data[i] = (uint8_t)i;
+  }
+  IREE_ASSERT_OK(iree_hal_buffer_unmap_range(&mapping));
+
+  std::vector<uint8_t> data = ReadBuffer(buffer);
+  ASSERT_EQ(data.size(), 64);
+  for (size_t i = 0; i < 32; ++i) {
+    EXPECT_EQ(data[16 + i], (uint8_t)i);
+  }
+
+  iree_hal_buffer_release(buffer);
+}
+
+TEST_F(RemoteDeviceTest, SubmitTransferCommands) {
+  iree_hal_buffer_t* source_buffer = AllocateBuffer(16);
+  iree_hal_buffer_t* target_buffer = AllocateBuffer(16);
+
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  uint32_t pattern = 0xAABBCCDDu;
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, source_buffer, 0, 16, &pattern, sizeof(pattern)));
+  uint8_t update[4] = {1, 2, 3, 4};
+  IREE_ASSERT_OK(iree_hal_command_buffer_update_buffer(
+      command_buffer, update, 0, source_buffer, 4, sizeof(update)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+      IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      0, NULL, 0, NULL));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, source_buffer, 0, target_buffer, 0, 16));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &semaphore));
+  uint64_t signal_value = 1ull;
+  iree_hal_submission_batch_t batch;
+  memset(&batch, 0, sizeof(batch));
+  batch.command_buffer_count = 1;
+  batch.command_buffers = &command_buffer;
+  batch.signal_semaphores.count = 1;
+  batch.signal_semaphores.semaphores = &semaphore;
+  batch.signal_semaphores.payload_values = &signal_value;
+  IREE_ASSERT_OK(iree_hal_device_queue_submit(
+      device_, IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      1, &batch));
+  IREE_ASSERT_OK(
+      iree_hal_semaphore_wait(semaphore, 1ull, iree_infinite_timeout()));
+
+  std::vector<uint8_t> data = ReadBuffer(target_buffer);
+  const uint8_t expected[16] = {0xDD, 0xCC, 0xBB, 0xAA, 1,    2,    3,    4,
+                                0xDD, 0xCC, 0xBB, 0xAA, 0xDD, 0xCC, 0xBB, 0xAA};
+  ASSERT_EQ(data.size(), sizeof(expected));
+  EXPECT_EQ(0, memcmp(data.data(), expected, sizeof(expected)));
+
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(target_buffer);
+  iree_hal_buffer_release(source_buffer);
+}
+
+TEST_F(RemoteDeviceTest, SemaphoreSignalQueryWait) {
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 2ull, &semaphore));
+  uint64_t value = 0;
+  IREE_ASSERT_OK(iree_hal_semaphore_query(semaphore, &value));
+  EXPECT_EQ(value, 2ull);
+
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphore, 5ull));
+  IREE_ASSERT_OK(
+      iree_hal_semaphore_wait(semaphore, 5ull, iree_infinite_timeout()));
+  EXPECT_THAT(iree::Status(iree_hal_semaphore_wait(
+                  semaphore, 6ull, iree_make_timeout(10 * 1000000ll))),
+              StatusIs(StatusCode::kDeadlineExceeded));
+
+  iree_hal_semaphore_release(semaphore);
+}
+
+// Failures of pipelined requests are reported by the next round trip.
+TEST_F(RemoteDeviceTest, DeferredFailureSurfaces) {
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 4ull, &semaphore));
+  // Semaphores may not go backwards; the signal itself is pipelined.
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphore, 1ull));
+  uint64_t value = 0;
+  EXPECT_THAT(iree::Status(iree_hal_semaphore_query(semaphore, &value)),
+              StatusIs(StatusCode::kOutOfRange));
+  // Only reported once.
+  IREE_ASSERT_OK(iree_hal_semaphore_query(semaphore, &value));
+  EXPECT_EQ(value, 4ull);
+  iree_hal_semaphore_release(semaphore);
+}
+
+}  // namespace
@@ -0,0 +1,153 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "experimental/remoting/hal/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_remoting_hal_driver_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+
+  iree_string_view_t identifier;
+
+  // Server endpoints as `host:port`; device N connects to endpoints[N - 1].
+  iree_host_size_t endpoint_count;
+  iree_string_view_t endpoints[];
+} iree_remoting_hal_driver_t;
+
+static const iree_hal_driver_vtable_t iree_remoting_hal_driver_vtable;
+
+static iree_remoting_hal_driver_t* iree_remoting_hal_driver_cast(
+    iree_hal_driver_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_remoting_hal_driver_vtable);
+  return (iree_remoting_hal_driver_t*)base_value;
+}
+
+IREE_API_EXPORT iree_status_t iree_remoting_hal_driver_create(
+    iree_string_view_t identifier, iree_host_size_t endpoint_count,
+    const iree_string_view_t* endpoints, iree_allocator_t host_allocator,
+    iree_hal_driver_t** out_driver) {
+  IREE_ASSERT_ARGUMENT(!endpoint_count || endpoints);
+  IREE_ASSERT_ARGUMENT(out_driver);
+  *out_driver = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t total_size = sizeof(iree_remoting_hal_driver_t) +
+                                endpoint_count * sizeof(iree_string_view_t) +
+                                identifier.size;
+  for (iree_host_size_t i = 0; i < endpoint_count; ++i) {
+    total_size += endpoints[i].size;
+  }
+  iree_remoting_hal_driver_t* driver = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&driver));
+  iree_hal_resource_initialize(&iree_remoting_hal_driver_vtable,
+                               &driver->resource);
+  driver->host_allocator = host_allocator;
+
+  char* string_ptr = (char*)&driver->endpoints[endpoint_count];
+  string_ptr += iree_string_view_append_to_buffer(
+      identifier, &driver->identifier, string_ptr);
+  driver->endpoint_count = endpoint_count;
+  for (iree_host_size_t i = 0; i < endpoint_count; ++i) {
+    string_ptr += iree_string_view_append_to_buffer(
+        endpoints[i], &driver->endpoints[i], string_ptr);
+  }
+
+  *out_driver = (iree_hal_driver_t*)driver;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_remoting_hal_driver_destroy(iree_hal_driver_t* base_driver) {
+  iree_remoting_hal_driver_t* driver =
+      iree_remoting_hal_driver_cast(base_driver);
+  iree_allocator_t host_allocator = driver->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocator_free(host_allocator, driver);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_status_t iree_remoting_hal_driver_query_available_devices(
+    iree_hal_driver_t* base_driver, iree_allocator_t allocator,
+    iree_hal_device_info_t** out_device_infos,
+    iree_host_size_t* out_device_info_count) {
+  iree_remoting_hal_driver_t* driver =
+      iree_remoting_hal_driver_cast(base_driver);
+  *out_device_info_count = 0;
+  *out_device_infos = NULL;
+
+  // Infos and their names are returned in a single allocation.
+  iree_host_size_t total_size =
+      driver->endpoint_count * sizeof(iree_hal_device_info_t);
+  for (iree_host_size_t i = 0; i < driver->endpoint_count; ++i) {
+    total_size += driver->endpoints[i].size;
+  }
+  iree_hal_device_info_t* device_infos = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(allocator, total_size, (void**)&device_infos));
+  char* string_ptr = (char*)&device_infos[driver->endpoint_count];
+  for (iree_host_size_t i = 0; i < driver->endpoint_count; ++i) {
+    device_infos[i].device_id = (iree_hal_device_id_t)(i + 1);
+    string_ptr += iree_string_view_append_to_buffer(
+        driver->endpoints[i], &device_infos[i].name, string_ptr);
+  }
+  *out_device_info_count = driver->endpoint_count;
+  *out_device_infos = device_infos;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_driver_create_device(
+    iree_hal_driver_t* base_driver, iree_hal_device_id_t device_id,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  iree_remoting_hal_driver_t* driver =
+      iree_remoting_hal_driver_cast(base_driver);
+
+  // The default device is the first endpoint.
+  iree_host_size_t endpoint_ordinal =
+      device_id ? (iree_host_size_t)(device_id - 1) : 0;
+  if (endpoint_ordinal >= driver->endpoint_count) {
+    return iree_make_status(IREE_STATUS_NOT_FOUND,
+                            "remote device %" PRIu64 " not found",
+                            (uint64_t)device_id);
+  }
+  iree_string_view_t endpoint = driver->endpoints[endpoint_ordinal];
+
+  iree_string_view_t host = iree_string_view_empty();
+  iree_string_view_t port_str = iree_string_view_empty();
+  uint32_t port = 0;
+  if (iree_string_view_split(endpoint, ':', &host, &port_str) == -1 ||
+      !iree_string_view_atoi_uint32(port_str, &port) || port > UINT16_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid remote endpoint '%.*s'; expected "
+                            "`host:port`",
+                            (int)endpoint.size, endpoint.data);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_remoting_transport_t* transport = NULL;
+  iree_status_t status = iree_remoting_tcp_transport_connect(
+      host, (uint16_t)port, host_allocator, &transport);
+  if (iree_status_is_ok(status)) {
+    status = iree_remoting_hal_device_create(driver->identifier, transport,
+                                             host_allocator, out_device);
+  }
+  iree_remoting_transport_release(transport);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static const iree_hal_driver_vtable_t iree_remoting_hal_driver_vtable = {
+    .destroy = iree_remoting_hal_driver_destroy,
+    .query_available_devices = iree_remoting_hal_driver_query_available_devices,
+    .create_device = iree_remoting_hal_driver_create_device,
+};
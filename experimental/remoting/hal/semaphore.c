@@ -0,0 +1,224 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/remoting/hal/semaphore.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_remoting_hal_semaphore_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_remoting_hal_channel_t* channel;
+  uint32_t semaphore_id;
+} iree_remoting_hal_semaphore_t;
+
+static const iree_hal_semaphore_vtable_t iree_remoting_hal_semaphore_vtable;
+
+static iree_remoting_hal_semaphore_t* iree_remoting_hal_semaphore_cast(
+    iree_hal_semaphore_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_remoting_hal_semaphore_vtable);
+  return (iree_remoting_hal_semaphore_t*)base_value;
+}
+
+iree_status_t iree_remoting_hal_semaphore_create(
+    iree_remoting_hal_channel_t* channel, uint64_t initial_value,
+    iree_allocator_t host_allocator, iree_hal_semaphore_t** out_semaphore) {
+  IREE_ASSERT_ARGUMENT(channel);
+  IREE_ASSERT_ARGUMENT(out_semaphore);
+  *out_semaphore = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_remoting_hal_semaphore_t* semaphore = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*semaphore),
+                                (void**)&semaphore));
+  iree_hal_resource_initialize(&iree_remoting_hal_semaphore_vtable,
+                               &semaphore->resource);
+  semaphore->host_allocator = host_allocator;
+  semaphore->channel = channel;
+  iree_remoting_hal_channel_retain(channel);
+  semaphore->semaphore_id = iree_remoting_hal_channel_acquire_id(channel);
+
+  iree_remoting_hal_semaphore_value_t request = {
+      .semaphore_id = semaphore->semaphore_id,
+      .value = initial_value,
+  };
+  iree_const_byte_span_t span =
+      iree_make_const_byte_span(&request, sizeof(request));
+  iree_status_t status = iree_remoting_hal_channel_send(
+      channel, IREE_REMOTING_HAL_OPCODE_SEMAPHORE_CREATE, 1, &span);
+
+  if (iree_status_is_ok(status)) {
+    *out_semaphore = (iree_hal_semaphore_t*)semaphore;
+  } else {
+    iree_hal_semaphore_release((iree_hal_semaphore_t*)semaphore);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_remoting_hal_semaphore_destroy(
+    iree_hal_semaphore_t* base_semaphore) {
+  iree_remoting_hal_semaphore_t* semaphore =
+      iree_remoting_hal_semaphore_cast(base_semaphore);
+  iree_allocator_t host_allocator = semaphore->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_remoting_hal_channel_release_id(semaphore->channel,
+                                       semaphore->semaphore_id);
+  iree_remoting_hal_channel_release(semaphore->channel);
+  iree_allocator_free(host_allocator, semaphore);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_remoting_hal_semaphore_id(iree_hal_semaphore_t* semaphore,
+                                             uint32_t* out_semaphore_id) {
+  if (!iree_hal_resource_is(semaphore, &iree_remoting_hal_semaphore_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "semaphore was not created by a remote device");
+  }
+  *out_semaphore_id =
+      ((iree_remoting_hal_semaphore_t*)semaphore)->semaphore_id;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_semaphore_query(
+    iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
+  iree_remoting_hal_semaphore_t* semaphore =
+      iree_remoting_hal_semaphore_cast(base_semaphore);
+  iree_const_byte_span_t span = iree_make_const_byte_span(
+      &semaphore->semaphore_id, sizeof(semaphore->semaphore_id));
+  return iree_remoting_hal_channel_call(
+      semaphore->channel, IREE_REMOTING_HAL_OPCODE_SEMAPHORE_QUERY, 1, &span,
+      iree_make_byte_span(out_value, sizeof(*out_value)));
+}
+
+static iree_status_t iree_remoting_hal_semaphore_signal(
+    iree_hal_semaphore_t* base_semaphore, uint64_t new_value) {
+  iree_remoting_hal_semaphore_t* semaphore =
+      iree_remoting_hal_semaphore_cast(base_semaphore);
+  iree_remoting_hal_semaphore_value_t request = {
+      .semaphore_id = semaphore->semaphore_id,
+      .value = new_value,
+  };
+  iree_const_byte_span_t span =
+      iree_make_const_byte_span(&request, sizeof(request));
+  return iree_remoting_hal_channel_send(
+      semaphore->channel, IREE_REMOTING_HAL_OPCODE_SEMAPHORE_SIGNAL, 1, &span);
+}
+
+static void iree_remoting_hal_semaphore_fail(
+    iree_hal_semaphore_t* base_semaphore, iree_status_t status) {
+  iree_remoting_hal_semaphore_t* semaphore =
+      iree_remoting_hal_semaphore_cast(base_semaphore);
+
+  // Only the code and message travel; payloads such as stack traces stay here.
+  char message[256];
+  iree_host_size_t message_length = 0;
+  if (!iree_status_format(status, sizeof(message), message, &message_length)) {
+    message_length = 0;
+  }
+  message_length = iree_min(message_length, sizeof(message) - 1);
+  iree_remoting_hal_semaphore_fail_request_t request = {
+      .semaphore_id = semaphore->semaphore_id,
+      .status_code = iree_status_code(status),
+      .message_length = message_length,
+  };
+  iree_status_ignore(status);
+
+  iree_const_byte_span_t spans[2] = {
+      iree_make_const_byte_span(&request, sizeof(request)),
+      iree_make_const_byte_span(message, message_length),
+  };
+  iree_status_ignore(iree_remoting_hal_channel_send(
+      semaphore->channel, IREE_REMOTING_HAL_OPCODE_SEMAPHORE_FAIL,
+      IREE_ARRAYSIZE(spans), spans));
+}
+
+// Performs a single wait call of at most IREE_REMOTING_HAL_MAX_WAIT_SLICE_NS.
+static iree_status_t iree_remoting_hal_semaphore_wait_slice(
+    iree_remoting_hal_semaphore_t* semaphore, uint64_t value,
+    iree_time_t deadline_ns) {
+  iree_duration_t timeout_ns = iree_absolute_deadline_to_timeout_ns(deadline_ns);
+  iree_remoting_hal_semaphore_wait_request_t request = {
+      .semaphore_id = semaphore->semaphore_id,
+      .value = value,
+      .timeout_ns = iree_min(timeout_ns, IREE_REMOTING_HAL_MAX_WAIT_SLICE_NS),
+  };
+  iree_const_byte_span_t span =
+      iree_make_const_byte_span(&request, sizeof(request));
+  return iree_remoting_hal_channel_call(
+      semaphore->channel, IREE_REMOTING_HAL_OPCODE_SEMAPHORE_WAIT, 1, &span,
+      iree_byte_span_empty());
+}
+
+static iree_status_t iree_remoting_hal_semaphore_wait(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    iree_timeout_t timeout) {
+  iree_remoting_hal_semaphore_t* semaphore =
+      iree_remoting_hal_semaphore_cast(base_semaphore);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  iree_status_t status = iree_ok_status();
+  do {
+    iree_status_ignore(status);
+    status =
+        iree_remoting_hal_semaphore_wait_slice(semaphore, value, deadline_ns);
+  } while (iree_status_is_deadline_exceeded(status) &&
+           iree_time_now() < deadline_ns);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_remoting_hal_semaphore_multi_wait(
+    iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  if (semaphore_list->count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  iree_status_t status = iree_ok_status();
+  if (wait_mode == IREE_HAL_WAIT_MODE_ALL || semaphore_list->count == 1) {
+    // Waiting for each in turn is equivalent to waiting for all.
+    for (iree_host_size_t i = 0;
+         i < semaphore_list->count && iree_status_is_ok(status); ++i) {
+      status = iree_remoting_hal_semaphore_wait(
+          semaphore_list->semaphores[i], semaphore_list->payload_values[i],
+          iree_make_deadline(deadline_ns));
+    }
+  } else {
+    // Round-robin single slices across the semaphores until any is reached.
+    status = iree_make_status(IREE_STATUS_DEADLINE_EXCEEDED);
+    do {
+      for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+        iree_status_ignore(status);
+        status = iree_remoting_hal_semaphore_wait_slice(
+            iree_remoting_hal_semaphore_cast(semaphore_list->semaphores[i]),
+            semaphore_list->payload_values[i], deadline_ns);
+        if (!iree_status_is_deadline_exceeded(status)) break;
+      }
+    } while (iree_status_is_deadline_exceeded(status) &&
+             iree_time_now() < deadline_ns);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static const iree_hal_semaphore_vtable_t iree_remoting_hal_semaphore_vtable = {
+    .destroy = iree_remoting_hal_semaphore_destroy,
+    .query = iree_remoting_hal_semaphore_query,
+    .signal = iree_remoting_hal_semaphore_signal,
+    .fail = iree_remoting_hal_semaphore_fail,
+    .wait = iree_remoting_hal_semaphore_wait,
+};
@@ -0,0 +1,40 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef EXPERIMENTAL_REMOTING_HAL_SEMAPHORE_H_
+#define EXPERIMENTAL_REMOTING_HAL_SEMAPHORE_H_
+
+#include "experimental/remoting/hal/channel.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a timeline semaphore whose payload lives on the served device.
+// Creation and signals are pipelined; queries and waits are calls. Waits are
+// split into slices of at most IREE_REMOTING_HAL_MAX_WAIT_SLICE_NS so that a
+// thread blocked on a semaphore does not starve other users of the connection.
+iree_status_t iree_remoting_hal_semaphore_create(
+    iree_remoting_hal_channel_t* channel, uint64_t initial_value,
+    iree_allocator_t host_allocator, iree_hal_semaphore_t** out_semaphore);
+
+// Returns the remote id of |semaphore|.
+iree_status_t iree_remoting_hal_semaphore_id(iree_hal_semaphore_t* semaphore,
+                                             uint32_t* out_semaphore_id);
+
+// Waits until one or all of the semaphores in |semaphore_list| reach their
+// values, depending on |wait_mode|.
+iree_status_t iree_remoting_hal_semaphore_multi_wait(
+    iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // EXPERIMENTAL_REMOTING_HAL_SEMAPHORE_H_
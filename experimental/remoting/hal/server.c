@@ -0,0 +1,775 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "experimental/remoting/hal/api.h"
+#include "experimental/remoting/hal/protocol.h"
+#include "iree/base/tracing.h"
+
+// Largest resource id a client may use. Bounds the resource table so that a
+// misbehaving client can't make the server allocate unbounded memory.
+#define IREE_REMOTING_HAL_SERVER_MAX_RESOURCE_ID (1u << 20)
+
+// Maximum number of characters of an error message returned to the client.
+#define IREE_REMOTING_HAL_SERVER_MAX_ERROR_MESSAGE_LENGTH 1024
+
+typedef enum iree_remoting_hal_resource_type_e {
+  IREE_REMOTING_HAL_RESOURCE_TYPE_NONE = 0,
+  IREE_REMOTING_HAL_RESOURCE_TYPE_BUFFER,
+  IREE_REMOTING_HAL_RESOURCE_TYPE_SEMAPHORE,
+  IREE_REMOTING_HAL_RESOURCE_TYPE_COMMAND_BUFFER,
+} iree_remoting_hal_resource_type_t;
+
+typedef struct iree_remoting_hal_resource_entry_t {
+  iree_remoting_hal_resource_type_t type;
+  iree_hal_resource_t* resource;
+} iree_remoting_hal_resource_entry_t;
+
+struct iree_remoting_hal_server_t {
+  iree_allocator_t host_allocator;
+  iree_hal_device_t* device;
+  iree_remoting_transport_t* transport;
+
+  // Resources created by the client indexed by id.
+  iree_remoting_hal_resource_entry_t* resources;
+  iree_host_size_t resource_capacity;
+
+  // Storage for request payloads; grown as needed.
+  uint8_t* payload;
+  iree_host_size_t payload_capacity;
+
+  // First failure of a one-way request since the last call.
+  iree_status_t deferred_status;
+};
+
+IREE_API_EXPORT iree_status_t iree_remoting_hal_server_create(
+    iree_hal_device_t* device, iree_remoting_transport_t* transport,
+    iree_allocator_t host_allocator, iree_remoting_hal_server_t** out_server) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(transport);
+  IREE_ASSERT_ARGUMENT(out_server);
+  *out_server = NULL;
+
+  iree_remoting_hal_server_t* server = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(host_allocator, sizeof(*server), (void**)&server));
+  memset(server, 0, sizeof(*server));
+  server->host_allocator = host_allocator;
+  server->device = device;
+  iree_hal_device_retain(device);
+  server->transport = transport;
+  iree_remoting_transport_retain(transport);
+  server->deferred_status = iree_ok_status();
+  *out_server = server;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT void iree_remoting_hal_server_free(
+    iree_remoting_hal_server_t* server) {
+  if (!server) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator = server->host_allocator;
+
+  // Command buffers first as they may reference buffers.
+  for (iree_host_size_t i = 0; i < server->resource_capacity; ++i) {
+    if (server->resources[i].type ==
+        IREE_REMOTING_HAL_RESOURCE_TYPE_COMMAND_BUFFER) {
+      iree_hal_resource_release(server->resources[i].resource);
+      server->resources[i].type = IREE_REMOTING_HAL_RESOURCE_TYPE_NONE;
+    }
+  }
+  for (iree_host_size_t i = 0; i < server->resource_capacity; ++i) {
+    if (server->resources[i].type != IREE_REMOTING_HAL_RESOURCE_TYPE_NONE) {
+      iree_hal_resource_release(server->resources[i].resource);
+    }
+  }
+  iree_allocator_free(host_allocator, server->resources);
+  iree_allocator_free(host_allocator, server->payload);
+  iree_status_ignore(server->deferred_status);
+  iree_remoting_transport_release(server->transport);
+  iree_hal_device_release(server->device);
+  iree_allocator_free(host_allocator, server);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+//===----------------------------------------------------------------------===//
+// Resource table
+//===----------------------------------------------------------------------===//
+
+// Inserts |resource| as |id|, retaining it.
+static iree_status_t iree_remoting_hal_server_insert(
+    iree_remoting_hal_server_t* server, uint32_t id,
+    iree_remoting_hal_resource_type_t type, void* resource) {
+  if (id == IREE_REMOTING_HAL_NULL_ID ||
+      id > IREE_REMOTING_HAL_SERVER_MAX_RESOURCE_ID) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "resource id %u out of range", id);
+  }
+  if (id >= server->resource_capacity) {
+    iree_host_size_t new_capacity =
+        iree_max((iree_host_size_t)id + 1, server->resource_capacity * 2);
+    new_capacity = iree_min(new_capacity,
+                            IREE_REMOTING_HAL_SERVER_MAX_RESOURCE_ID + 1);
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        server->host_allocator, new_capacity * sizeof(*server->resources),
+        (void**)&server->resources));
+    memset(server->resources + server->resource_capacity, 0,
+           (new_capacity - server->resource_capacity) *
+               sizeof(*server->resources));
+    server->resource_capacity = new_capacity;
+  }
+  iree_remoting_hal_resource_entry_t* entry = &server->resources[id];
+  if (entry->type != IREE_REMOTING_HAL_RESOURCE_TYPE_NONE) {
+    return iree_make_status(IREE_STATUS_ALREADY_EXISTS,
+                            "resource id %u already in use", id);
+  }
+  entry->type = type;
+  entry->resource = (iree_hal_resource_t*)resource;
+  iree_hal_resource_retain(resource);
+  return iree_ok_status();
+}
+
+// Looks up resource |id| which must be of |type|. Not retained.
+static iree_status_t iree_remoting_hal_server_lookup(
+    iree_remoting_hal_server_t* server, uint32_t id,
+    iree_remoting_hal_resource_type_t type, void** out_resource) {
+  if (id >= server->resource_capacity ||
+      server->resources[id].type != type) {
+    return iree_make_status(IREE_STATUS_NOT_FOUND,
+                            "resource id %u not found or of the wrong type",
+                            id);
+  }
+  *out_resource = server->resources[id].resource;
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Payload parsing
+//===----------------------------------------------------------------------===//
+
+// Consumes |length| bytes from the front of |payload| and returns a pointer to
+// them in |out_ptr|.
+static iree_status_t iree_remoting_hal_payload_consume(
+    iree_const_byte_span_t* payload, iree_host_size_t length,
+    const void** out_ptr) {
+  if (payload->data_length < length) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "truncated request payload");
+  }
+  *out_ptr = payload->data;
+  payload->data += length;
+  payload->data_length -= length;
+  return iree_ok_status();
+}
+
+#define IREE_REMOTING_HAL_CONSUME(payload, out_ptr) \
+  iree_remoting_hal_payload_consume(payload, sizeof(**(out_ptr)), \
+                                    (const void**)(out_ptr))
+
+//===----------------------------------------------------------------------===//
+// Request handlers
+//===----------------------------------------------------------------------===//
+
+// Result of a call. Either |data| is sent as-is or, for buffer reads, the
+// contents of |mapping| are sent and the mapping is released afterward.
+typedef struct iree_remoting_hal_result_t {
+  iree_const_byte_span_t data;
+  uint8_t inline_storage[8];
+  iree_hal_buffer_mapping_t mapping;
+} iree_remoting_hal_result_t;
+
+static iree_status_t iree_remoting_hal_server_query_i32(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload,
+    iree_remoting_hal_result_t* result) {
+  const iree_remoting_hal_query_i32_request_t* request = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &request));
+  const char* category = NULL;
+  const char* key = NULL;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_payload_consume(
+      &payload, request->category_length, (const void**)&category));
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_payload_consume(
+      &payload, request->key_length, (const void**)&key));
+  int32_t value = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_device_query_i32(
+      server->device,
+      iree_make_string_view(category, request->category_length),
+      iree_make_string_view(key, request->key_length), &value));
+  memcpy(result->inline_storage, &value, sizeof(value));
+  result->data =
+      iree_make_const_byte_span(result->inline_storage, sizeof(value));
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_server_wait_idle(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload) {
+  const int64_t* timeout_ns = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &timeout_ns));
+  return iree_hal_device_wait_idle(server->device,
+                                   iree_make_timeout(*timeout_ns));
+}
+
+static iree_status_t iree_remoting_hal_server_resource_release(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload) {
+  const uint32_t* id = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &id));
+  // Unknown ids are ignored: the client releases ids whose creation failed.
+  if (*id < server->resource_capacity &&
+      server->resources[*id].type != IREE_REMOTING_HAL_RESOURCE_TYPE_NONE) {
+    iree_remoting_hal_resource_entry_t* entry = &server->resources[*id];
+    iree_hal_resource_release(entry->resource);
+    entry->type = IREE_REMOTING_HAL_RESOURCE_TYPE_NONE;
+    entry->resource = NULL;
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_server_buffer_allocate(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload) {
+  const iree_remoting_hal_buffer_allocate_request_t* request = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &request));
+  if (request->allocation_size > SIZE_MAX) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "allocation size exceeds the host size limit");
+  }
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+      iree_hal_device_allocator(server->device), request->memory_type,
+      request->allowed_usage, (iree_host_size_t)request->allocation_size,
+      iree_const_byte_span_empty(), &buffer));
+  iree_status_t status = iree_remoting_hal_server_insert(
+      server, request->buffer_id, IREE_REMOTING_HAL_RESOURCE_TYPE_BUFFER,
+      buffer);
+  iree_hal_buffer_release(buffer);
+  return status;
+}
+
+// Reads |length| bytes from the transport and drops them.
+static iree_status_t iree_remoting_hal_server_discard(
+    iree_remoting_hal_server_t* server, uint64_t length) {
+  uint8_t discard[256];
+  while (length > 0) {
+    iree_host_size_t chunk = (iree_host_size_t)iree_min(length, sizeof(discard));
+    IREE_RETURN_IF_ERROR(iree_remoting_transport_read(
+        server->transport, iree_make_byte_span(discard, chunk)));
+    length -= chunk;
+  }
+  return iree_ok_status();
+}
+
+// Buffer writes are read from the transport directly into the mapped buffer
+// instead of staging the payload. |connection_status| receives transport
+// failures which, unlike request failures, end the connection.
+static iree_status_t iree_remoting_hal_server_buffer_write(
+    iree_remoting_hal_server_t* server, uint64_t payload_length,
+    iree_status_t* connection_status) {
+  iree_remoting_hal_buffer_range_t range;
+  if (payload_length < sizeof(range)) {
+    *connection_status = iree_make_status(IREE_STATUS_DATA_LOSS,
+                                          "truncated buffer write request");
+    return iree_ok_status();
+  }
+  *connection_status = iree_remoting_transport_read(
+      server->transport, iree_make_byte_span(&range, sizeof(range)));
+  if (!iree_status_is_ok(*connection_status)) return iree_ok_status();
+  uint64_t data_length = payload_length - sizeof(range);
+
+  iree_hal_buffer_t* buffer = NULL;
+  iree_status_t status = iree_remoting_hal_server_lookup(
+      server, range.buffer_id, IREE_REMOTING_HAL_RESOURCE_TYPE_BUFFER,
+      (void**)&buffer);
+  if (iree_status_is_ok(status) && data_length != range.length) {
+    status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "buffer write data length mismatch");
+  }
+  iree_hal_buffer_mapping_t mapping;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_buffer_map_range(
+        buffer, IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_WRITE,
+        range.offset, range.length, &mapping);
+  }
+  if (iree_status_is_ok(status)) {
+    *connection_status =
+        iree_remoting_transport_read(server->transport, mapping.contents);
+    status = iree_hal_buffer_unmap_range(&mapping);
+  } else {
+    *connection_status = iree_remoting_hal_server_discard(server, data_length);
+  }
+  return status;
+}
+
+static iree_status_t iree_remoting_hal_server_buffer_read(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload,
+    iree_remoting_hal_result_t* result) {
+  const iree_remoting_hal_buffer_range_t* range = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &range));
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_server_lookup(
+      server, range->buffer_id, IREE_REMOTING_HAL_RESOURCE_TYPE_BUFFER,
+      (void**)&buffer));
+  // The response is written straight from the mapping.
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+      buffer, IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_READ,
+      range->offset, range->length, &result->mapping));
+  result->data = iree_make_const_byte_span(result->mapping.contents.data,
+                                           result->mapping.contents.data_length);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_server_semaphore_create(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload) {
+  const iree_remoting_hal_semaphore_value_t* request = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &request));
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_semaphore_create(server->device, request->value, &semaphore));
+  iree_status_t status = iree_remoting_hal_server_insert(
+      server, request->semaphore_id, IREE_REMOTING_HAL_RESOURCE_TYPE_SEMAPHORE,
+      semaphore);
+  iree_hal_semaphore_release(semaphore);
+  return status;
+}
+
+static iree_status_t iree_remoting_hal_server_semaphore_query(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload,
+    iree_remoting_hal_result_t* result) {
+  const uint32_t* id = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &id));
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_server_lookup(
+      server, *id, IREE_REMOTING_HAL_RESOURCE_TYPE_SEMAPHORE,
+      (void**)&semaphore));
+  uint64_t value = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_semaphore_query(semaphore, &value));
+  memcpy(result->inline_storage, &value, sizeof(value));
+  result->data =
+      iree_make_const_byte_span(result->inline_storage, sizeof(value));
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_server_semaphore_signal(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload) {
+  const iree_remoting_hal_semaphore_value_t* request = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &request));
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_server_lookup(
+      server, request->semaphore_id, IREE_REMOTING_HAL_RESOURCE_TYPE_SEMAPHORE,
+      (void**)&semaphore));
+  return iree_hal_semaphore_signal(semaphore, request->value);
+}
+
+static iree_status_t iree_remoting_hal_server_semaphore_fail(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload) {
+  const iree_remoting_hal_semaphore_fail_request_t* request = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &request));
+  const char* message = NULL;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_payload_consume(
+      &payload, (iree_host_size_t)request->message_length,
+      (const void**)&message));
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_server_lookup(
+      server, request->semaphore_id, IREE_REMOTING_HAL_RESOURCE_TYPE_SEMAPHORE,
+      (void**)&semaphore));
+  iree_status_code_t status_code =
+      request->status_code == IREE_STATUS_OK
+          ? IREE_STATUS_UNKNOWN
+          : (iree_status_code_t)(request->status_code & IREE_STATUS_CODE_MASK);
+  iree_hal_semaphore_fail(
+      semaphore, iree_make_status(status_code, "%.*s",
+                                  (int)request->message_length, message));
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_server_semaphore_wait(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload) {
+  const iree_remoting_hal_semaphore_wait_request_t* request = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &request));
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_RETURN_IF_ERROR(iree_remoting_hal_server_lookup(
+      server, request->semaphore_id, IREE_REMOTING_HAL_RESOURCE_TYPE_SEMAPHORE,
+      (void**)&semaphore));
+  // The connection is blocked for the duration of the wait so it is bounded;
+  // clients retry until their own deadline.
+  iree_duration_t timeout_ns =
+      iree_min(request->timeout_ns, IREE_REMOTING_HAL_MAX_WAIT_SLICE_NS);
+  return iree_hal_semaphore_wait(semaphore, request->value,
+                                 iree_make_timeout(timeout_ns));
+}
+
+// Replays the encoded |commands| into |command_buffer|.
+static iree_status_t iree_remoting_hal_server_record_commands(
+    iree_remoting_hal_server_t* server,
+    iree_hal_command_buffer_t* command_buffer,
+    iree_const_byte_span_t commands) {
+  while (commands.data_length > 0) {
+    const iree_remoting_hal_command_header_t* header = NULL;
+    IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&commands, &header));
+    if (header->length < sizeof(*header)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "malformed command length %u", header->length);
+    }
+    iree_const_byte_span_t command = iree_make_const_byte_span(NULL, 0);
+    IREE_RETURN_IF_ERROR(iree_remoting_hal_payload_consume(
+        &commands, header->length - sizeof(*header),
+        (const void**)&command.data));
+    command.data_length = header->length - sizeof(*header);
+
+    switch (header->type) {
+      case IREE_REMOTING_HAL_COMMAND_EXECUTION_BARRIER: {
+        IREE_RETURN_IF_ERROR(iree_hal_command_buffer_execution_barrier(
+            command_buffer, IREE_HAL_EXECUTION_STAGE_COMMAND_RETIRE,
+            IREE_HAL_EXECUTION_STAGE_COMMAND_ISSUE,
+            IREE_HAL_EXECUTION_BARRIER_FLAG_NONE, 0, NULL, 0, NULL));
+        break;
+      }
+      case IREE_REMOTING_HAL_COMMAND_FILL_BUFFER: {
+        const iree_remoting_hal_fill_buffer_command_t* fill = NULL;
+        IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&command, &fill));
+        iree_hal_buffer_t* target_buffer = NULL;
+        IREE_RETURN_IF_ERROR(iree_remoting_hal_server_lookup(
+            server, fill->target.buffer_id,
+            IREE_REMOTING_HAL_RESOURCE_TYPE_BUFFER, (void**)&target_buffer));
+        if (fill->pattern_length > sizeof(fill->pattern)) {
+          return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                  "fill pattern too long");
+        }
+        IREE_RETURN_IF_ERROR(iree_hal_command_buffer_fill_buffer(
+            command_buffer, target_buffer, fill->target.offset,
+            fill->target.length, &fill->pattern, fill->pattern_length));
+        break;
+      }
+      case IREE_REMOTING_HAL_COMMAND_UPDATE_BUFFER: {
+        const iree_remoting_hal_buffer_range_t* target = NULL;
+        IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&command, &target));
+        if (command.data_length < target->length) {
+          return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                  "truncated buffer update");
+        }
+        iree_hal_buffer_t* target_buffer = NULL;
+        IREE_RETURN_IF_ERROR(iree_remoting_hal_server_lookup(
+            server, target->buffer_id, IREE_REMOTING_HAL_RESOURCE_TYPE_BUFFER,
+            (void**)&target_buffer));
+        IREE_RETURN_IF_ERROR(iree_hal_command_buffer_update_buffer(
+            command_buffer, command.data, 0, target_buffer, target->offset,
+            target->length));
+        break;
+      }
+      case IREE_REMOTING_HAL_COMMAND_COPY_BUFFER: {
+        const iree_remoting_hal_copy_buffer_command_t* copy = NULL;
+        IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&command, &copy));
+        iree_hal_buffer_t* source_buffer = NULL;
+        IREE_RETURN_IF_ERROR(iree_remoting_hal_server_lookup(
+            server, copy->source_buffer_id,
+            IREE_REMOTING_HAL_RESOURCE_TYPE_BUFFER, (void**)&source_buffer));
+        iree_hal_buffer_t* target_buffer = NULL;
+        IREE_RETURN_IF_ERROR(iree_remoting_hal_server_lookup(
+            server, copy->target_buffer_id,
+            IREE_REMOTING_HAL_RESOURCE_TYPE_BUFFER, (void**)&target_buffer));
+        IREE_RETURN_IF_ERROR(iree_hal_command_buffer_copy_buffer(
+            command_buffer, source_buffer, copy->source_offset, target_buffer,
+            copy->target_offset, copy->length));
+        break;
+      }
+      default:
+        return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                                "unknown command type %u", header->type);
+    }
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_server_command_buffer_create(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload) {
+  const iree_remoting_hal_command_buffer_create_request_t* request = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &request));
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_hal_command_buffer_create(
+      server->device, request->mode, request->command_categories,
+      request->queue_affinity, &command_buffer);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_begin(command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_remoting_hal_server_record_commands(server, command_buffer,
+                                                      payload);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_end(command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_remoting_hal_server_insert(
+        server, request->command_buffer_id,
+        IREE_REMOTING_HAL_RESOURCE_TYPE_COMMAND_BUFFER, command_buffer);
+  }
+  iree_hal_command_buffer_release(command_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Decodes |count| semaphore values from |payload| into |out_list|.
+static iree_status_t iree_remoting_hal_server_decode_semaphores(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t* payload,
+    iree_host_size_t count, iree_hal_semaphore_t** semaphores,
+    uint64_t* payload_values, iree_hal_semaphore_list_t* out_list) {
+  out_list->count = count;
+  out_list->semaphores = semaphores;
+  out_list->payload_values = payload_values;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    const iree_remoting_hal_semaphore_value_t* value = NULL;
+    IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(payload, &value));
+    IREE_RETURN_IF_ERROR(iree_remoting_hal_server_lookup(
+        server, value->semaphore_id, IREE_REMOTING_HAL_RESOURCE_TYPE_SEMAPHORE,
+        (void**)&semaphores[i]));
+    payload_values[i] = value->value;
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_hal_server_queue_submit(
+    iree_remoting_hal_server_t* server, iree_const_byte_span_t payload) {
+  const uint64_t* batch_count = NULL;
+  IREE_RETURN_IF_ERROR(IREE_REMOTING_HAL_CONSUME(&payload, &batch_count));
+  if (*batch_count == 0) return iree_ok_status();
+
+  if (*batch_count > payload.data_length /
+                         sizeof(iree_remoting_hal_submit_batch_t)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "truncated submission");
+  }
+
+  // Each encoded semaphore value decodes to a pointer and a value of the same
+  // total size and each padded pair of command buffer ids to at most two
+  // pointers, so twice the payload bounds the decoded arrays.
+  iree_host_size_t storage_size =
+      (iree_host_size_t)*batch_count * sizeof(iree_hal_submission_batch_t) +
+      payload.data_length * 2;
+  uint8_t* storage = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(server->host_allocator,
+                                             storage_size, (void**)&storage));
+  iree_hal_submission_batch_t* batches = (iree_hal_submission_batch_t*)storage;
+  uint8_t* storage_ptr =
+      storage +
+      (iree_host_size_t)*batch_count * sizeof(iree_hal_submission_batch_t);
+
+  iree_status_t status = iree_ok_status();
+  for (uint64_t i = 0; i < *batch_count && iree_status_is_ok(status); ++i) {
+    const iree_remoting_hal_submit_batch_t* header = NULL;
+    status = IREE_REMOTING_HAL_CONSUME(&payload, &header);
+    if (!iree_status_is_ok(status)) break;
+    if (payload.data_length <
+        (header->wait_count + (iree_host_size_t)header->signal_count) *
+                sizeof(iree_remoting_hal_semaphore_value_t) +
+            header->command_buffer_count * sizeof(uint32_t)) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "truncated submission batch");
+      break;
+    }
+
+    iree_hal_submission_batch_t* batch = &batches[i];
+    iree_hal_semaphore_t** semaphores = (iree_hal_semaphore_t**)storage_ptr;
+    storage_ptr += (header->wait_count + header->signal_count) *
+                   sizeof(iree_hal_semaphore_t*);
+    uint64_t* values = (uint64_t*)storage_ptr;
+    storage_ptr +=
+        (header->wait_count + header->signal_count) * sizeof(uint64_t);
+    status = iree_remoting_hal_server_decode_semaphores(
+        server, &payload, header->wait_count, semaphores, values,
+        &batch->wait_semaphores);
+    if (!iree_status_is_ok(status)) break;
+    status = iree_remoting_hal_server_decode_semaphores(
+        server, &payload, header->signal_count,
+        semaphores + header->wait_count, values + header->wait_count,
+        &batch->signal_semaphores);
+    if (!iree_status_is_ok(status)) break;
+
+    iree_hal_command_buffer_t** command_buffers =
+        (iree_hal_command_buffer_t**)storage_ptr;
+    storage_ptr +=
+        header->command_buffer_count * sizeof(iree_hal_command_buffer_t*);
+    batch->command_buffer_count = header->command_buffer_count;
+    batch->command_buffers = command_buffers;
+    const uint32_t* ids = NULL;
+    status = iree_remoting_hal_payload_consume(
+        &payload,
+        iree_host_align(header->command_buffer_count * sizeof(uint32_t), 8),
+        (const void**)&ids);
+    for (uint32_t j = 0;
+         j < header->command_buffer_count && iree_status_is_ok(status); ++j) {
+      status = iree_remoting_hal_server_lookup(
+          server, ids[j], IREE_REMOTING_HAL_RESOURCE_TYPE_COMMAND_BUFFER,
+          (void**)&command_buffers[j]);
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_device_queue_submit(
+        server->device, IREE_HAL_COMMAND_CATEGORY_ANY,
+        IREE_HAL_QUEUE_AFFINITY_ANY, (iree_host_size_t)*batch_count, batches);
+  }
+
+  iree_allocator_free(server->host_allocator, storage);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Request loop
+//===----------------------------------------------------------------------===//
+
+// Reads a request payload of |length| bytes into the payload storage.
+static iree_status_t iree_remoting_hal_server_read_payload(
+    iree_remoting_hal_server_t* server, uint64_t length,
+    iree_const_byte_span_t* out_payload) {
+  if (length > SIZE_MAX) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "request payload too large");
+  }
+  if (length > server->payload_capacity) {
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        server->host_allocator, (iree_host_size_t)length,
+        (void**)&server->payload));
+    server->payload_capacity = (iree_host_size_t)length;
+  }
+  IREE_RETURN_IF_ERROR(iree_remoting_transport_read(
+      server->transport,
+      iree_make_byte_span(server->payload, (iree_host_size_t)length)));
+  *out_payload =
+      iree_make_const_byte_span(server->payload, (iree_host_size_t)length);
+  return iree_ok_status();
+}
+
+// Dispatches a request whose payload has been read.
+static iree_status_t iree_remoting_hal_server_dispatch(
+    iree_remoting_hal_server_t* server, uint32_t opcode,
+    iree_const_byte_span_t payload, iree_remoting_hal_result_t* result) {
+  switch (opcode) {
+    case IREE_REMOTING_HAL_OPCODE_DEVICE_QUERY_I32:
+      return iree_remoting_hal_server_query_i32(server, payload, result);
+    case IREE_REMOTING_HAL_OPCODE_DEVICE_WAIT_IDLE:
+      return iree_remoting_hal_server_wait_idle(server, payload);
+    case IREE_REMOTING_HAL_OPCODE_RESOURCE_RELEASE:
+      return iree_remoting_hal_server_resource_release(server, payload);
+    case IREE_REMOTING_HAL_OPCODE_BUFFER_ALLOCATE:
+      return iree_remoting_hal_server_buffer_allocate(server, payload);
+    case IREE_REMOTING_HAL_OPCODE_BUFFER_READ:
+      return iree_remoting_hal_server_buffer_read(server, payload, result);
+    case IREE_REMOTING_HAL_OPCODE_SEMAPHORE_CREATE:
+      return iree_remoting_hal_server_semaphore_create(server, payload);
+    case IREE_REMOTING_HAL_OPCODE_SEMAPHORE_QUERY:
+      return iree_remoting_hal_server_semaphore_query(server, payload, result);
+    case IREE_REMOTING_HAL_OPCODE_SEMAPHORE_SIGNAL:
+      return iree_remoting_hal_server_semaphore_signal(server, payload);
+    case IREE_REMOTING_HAL_OPCODE_SEMAPHORE_FAIL:
+      return iree_remoting_hal_server_semaphore_fail(server, payload);
+    case IREE_REMOTING_HAL_OPCODE_SEMAPHORE_WAIT:
+      return iree_remoting_hal_server_semaphore_wait(server, payload);
+    case IREE_REMOTING_HAL_OPCODE_COMMAND_BUFFER_CREATE:
+      return iree_remoting_hal_server_command_buffer_create(server, payload);
+    case IREE_REMOTING_HAL_OPCODE_QUEUE_SUBMIT:
+      return iree_remoting_hal_server_queue_submit(server, payload);
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED, "unknown opcode %u",
+                              opcode);
+  }
+}
+
+// Writes the response to a call with |status|, which is consumed.
+static iree_status_t iree_remoting_hal_server_respond(
+    iree_remoting_hal_server_t* server, iree_status_t status,
+    iree_const_byte_span_t data) {
+  char message[IREE_REMOTING_HAL_SERVER_MAX_ERROR_MESSAGE_LENGTH];
+  iree_remoting_hal_response_header_t header = {
+      .status_code = iree_status_code(status),
+      .payload_length = data.data_length,
+  };
+  if (!iree_status_is_ok(status)) {
+    iree_host_size_t message_length = 0;
+    if (!iree_status_format(status, sizeof(message), message,
+                            &message_length)) {
+      message_length = 0;
+    }
+    message_length = iree_min(message_length, sizeof(message) - 1);
+    data = iree_make_const_byte_span(message, message_length);
+    header.payload_length = message_length;
+    iree_status_ignore(status);
+  }
+  iree_const_byte_span_t spans[2] = {
+      iree_make_const_byte_span(&header, sizeof(header)),
+      data,
+  };
+  return iree_remoting_transport_write(server->transport,
+                                       IREE_ARRAYSIZE(spans), spans);
+}
+
+IREE_API_EXPORT iree_status_t
+iree_remoting_hal_server_run(iree_remoting_hal_server_t* server) {
+  IREE_ASSERT_ARGUMENT(server);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t connection_status = iree_ok_status();
+  while (iree_status_is_ok(connection_status)) {
+    iree_remoting_hal_request_header_t header;
+    connection_status = iree_remoting_transport_read(
+        server->transport, iree_make_byte_span(&header, sizeof(header)));
+    if (!iree_status_is_ok(connection_status)) break;
+    const bool is_call =
+        iree_all_bits_set(header.flags, IREE_REMOTING_HAL_REQUEST_FLAG_CALL);
+
+    iree_remoting_hal_result_t result;
+    memset(&result, 0, sizeof(result));
+    iree_status_t status = iree_ok_status();
+    if (header.opcode == IREE_REMOTING_HAL_OPCODE_BUFFER_WRITE) {
+      status = iree_remoting_hal_server_buffer_write(
+          server, header.payload_length, &connection_status);
+    } else {
+      iree_const_byte_span_t payload = iree_const_byte_span_empty();
+      connection_status = iree_remoting_hal_server_read_payload(
+          server, header.payload_length, &payload);
+      if (iree_status_is_ok(connection_status)) {
+        status = iree_remoting_hal_server_dispatch(server, header.opcode,
+                                                   payload, &result);
+      }
+    }
+    if (!iree_status_is_ok(connection_status)) {
+      iree_status_ignore(status);
+      break;
+    }
+
+    if (is_call) {
+      // Failures of earlier one-way requests take precedence so that the
+      // client learns about them as soon as possible.
+      if (!iree_status_is_ok(server->deferred_status)) {
+        iree_status_ignore(status);
+        status = server->deferred_status;
+        server->deferred_status = iree_ok_status();
+      }
+      connection_status =
+          iree_remoting_hal_server_respond(server, status, result.data);
+    } else if (!iree_status_is_ok(status)) {
+      if (iree_status_is_ok(server->deferred_status)) {
+        server->deferred_status = status;
+      } else {
+        iree_status_ignore(status);
+      }
+    }
+    if (result.mapping.buffer) {
+      iree_status_ignore(iree_hal_buffer_unmap_range(&result.mapping));
+    }
+  }
+
+  // The client closing the connection is the normal way to end a session.
+  if (iree_status_is_unavailable(connection_status)) {
+    iree_status_ignore(connection_status);
+    connection_status = iree_ok_status();
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return connection_status;
+}
@@ -0,0 +1,469 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "experimental/remoting/transport/transport.h"
+#include "iree/base/internal/math.h"
+#include "iree/base/target_platform.h"
+#include "iree/base/tracing.h"
+
+#if defined(IREE_PLATFORM_LINUX)
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif  // !MFD_CLOEXEC
+
+//===----------------------------------------------------------------------===//
+// Shared memory layout
+//===----------------------------------------------------------------------===//
+
+#define IREE_REMOTING_SHM_MAGIC 0x4D485352u  // 'RSHM'
+#define IREE_REMOTING_SHM_VERSION 1u
+
+// Endpoint indices; each endpoint writes to the ring of its own index and
+// reads from the ring of the other.
+#define IREE_REMOTING_SHM_CLIENT 0
+#define IREE_REMOTING_SHM_SERVER 1
+
+// Single-producer single-consumer byte ring living in shared memory.
+// Positions count the total number of bytes ever written/read and are masked
+// to the capacity when indexing the data. The producer and consumer fields are
+// kept on separate cache lines to avoid false sharing between the endpoints.
+typedef struct iree_remoting_shm_ring_t {
+  // Producer-owned.
+  iree_alignas(64) iree_atomic_int64_t write_position;
+  // Futex word incremented after data is published.
+  iree_atomic_int32_t data_sequence;
+  // Nonzero while the consumer is (about to be) parked on |data_sequence|.
+  iree_atomic_int32_t reader_waiting;
+
+  // Consumer-owned.
+  iree_alignas(64) iree_atomic_int64_t read_position;
+  // Futex word incremented after space is released.
+  iree_atomic_int32_t space_sequence;
+  // Nonzero while the producer is (about to be) parked on |space_sequence|.
+  iree_atomic_int32_t writer_waiting;
+} iree_remoting_shm_ring_t;
+
+typedef struct iree_remoting_shm_header_t {
+  uint32_t magic;
+  uint32_t version;
+  // Capacity in bytes of each ring; always a power of two.
+  uint64_t capacity;
+  // Nonzero once the endpoint of the corresponding index has been destroyed.
+  iree_atomic_int32_t closed[2];
+  iree_remoting_shm_ring_t rings[2];
+  // Followed by the data of rings[0] and then rings[1] at
+  // iree_remoting_shm_data_offset.
+} iree_remoting_shm_header_t;
+
+static iree_host_size_t iree_remoting_shm_data_offset(void) {
+  return iree_host_align(sizeof(iree_remoting_shm_header_t), 4096);
+}
+
+static void iree_remoting_shm_futex_wait(iree_atomic_int32_t* address,
+                                         int32_t expected_value) {
+  // Shared futexes (no FUTEX_PRIVATE_FLAG) as the words may be mapped into
+  // multiple processes. Spurious wakes are handled by the callers.
+  syscall(SYS_futex, address, FUTEX_WAIT, expected_value, NULL, NULL, 0);
+}
+
+static void iree_remoting_shm_futex_wake(iree_atomic_int32_t* address) {
+  syscall(SYS_futex, address, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_remoting_shm_transport_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_remoting_shm_transport_t {
+  iree_remoting_transport_t base;
+  iree_allocator_t host_allocator;
+
+  int fd;
+  void* mapping;
+  iree_host_size_t mapping_size;
+  iree_remoting_shm_header_t* header;
+
+  // Index of this endpoint in the header.
+  int endpoint;
+  uint64_t mask;
+  iree_remoting_shm_ring_t* tx_ring;
+  uint8_t* tx_data;
+  iree_remoting_shm_ring_t* rx_ring;
+  const uint8_t* rx_data;
+} iree_remoting_shm_transport_t;
+
+static const iree_remoting_transport_vtable_t
+    iree_remoting_shm_transport_vtable;
+
+static iree_remoting_shm_transport_t* iree_remoting_shm_transport_cast(
+    iree_remoting_transport_t* base_value) {
+  IREE_ASSERT_EQ(base_value->vtable, &iree_remoting_shm_transport_vtable);
+  return (iree_remoting_shm_transport_t*)base_value;
+}
+
+static iree_status_t iree_remoting_shm_transport_map(
+    int fd, int endpoint, bool initialize, iree_host_size_t capacity,
+    iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_transport) {
+  *out_transport = NULL;
+
+  if (!initialize) {
+    // Size the mapping from the existing file and validate its header below.
+    struct stat fd_stat;
+    if (fstat(fd, &fd_stat) != 0) {
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "unable to query shared memory size");
+    }
+    if ((iree_host_size_t)fd_stat.st_size <= iree_remoting_shm_data_offset()) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "shared memory is too small for a transport");
+    }
+    capacity = ((iree_host_size_t)fd_stat.st_size -
+                iree_remoting_shm_data_offset()) /
+               2;
+  }
+  iree_host_size_t mapping_size =
+      iree_remoting_shm_data_offset() + capacity * 2;
+
+  void* mapping =
+      mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "unable to map %" PRIhsz " bytes of shared memory",
+                            mapping_size);
+  }
+  iree_remoting_shm_header_t* header = (iree_remoting_shm_header_t*)mapping;
+  if (initialize) {
+    // The file is freshly truncated and thus zero filled.
+    header->magic = IREE_REMOTING_SHM_MAGIC;
+    header->version = IREE_REMOTING_SHM_VERSION;
+    header->capacity = capacity;
+  } else if (header->magic != IREE_REMOTING_SHM_MAGIC ||
+             header->version != IREE_REMOTING_SHM_VERSION ||
+             header->capacity != capacity ||
+             (capacity & (capacity - 1)) != 0) {
+    munmap(mapping, mapping_size);
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "shared memory does not contain a compatible "
+                            "transport");
+  }
+
+  iree_remoting_shm_transport_t* transport = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*transport), (void**)&transport);
+  if (!iree_status_is_ok(status)) {
+    munmap(mapping, mapping_size);
+    return status;
+  }
+  memset(transport, 0, sizeof(*transport));
+  iree_remoting_transport_initialize(&iree_remoting_shm_transport_vtable,
+                                     &transport->base);
+  transport->host_allocator = host_allocator;
+  transport->fd = fd;
+  transport->mapping = mapping;
+  transport->mapping_size = mapping_size;
+  transport->header = header;
+  transport->endpoint = endpoint;
+  transport->mask = capacity - 1;
+  uint8_t* data_base = (uint8_t*)mapping + iree_remoting_shm_data_offset();
+  transport->tx_ring = &header->rings[endpoint];
+  transport->tx_data = data_base + endpoint * capacity;
+  transport->rx_ring = &header->rings[1 - endpoint];
+  transport->rx_data = data_base + (1 - endpoint) * capacity;
+  *out_transport = &transport->base;
+  return iree_ok_status();
+}
+
+iree_status_t iree_remoting_shm_transport_create_pair(
+    iree_host_size_t capacity, iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_client,
+    iree_remoting_transport_t** out_server) {
+  IREE_ASSERT_ARGUMENT(out_client);
+  IREE_ASSERT_ARGUMENT(out_server);
+  *out_client = NULL;
+  *out_server = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  capacity = iree_math_round_up_to_pow2_u64(
+      iree_max(capacity, (iree_host_size_t)4096));
+  int fd = (int)syscall(SYS_memfd_create, "iree-remoting", MFD_CLOEXEC);
+  if (fd < 0) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "unable to create shared memory");
+  }
+  iree_host_size_t file_size = iree_remoting_shm_data_offset() + capacity * 2;
+  if (ftruncate(fd, (off_t)file_size) != 0) {
+    close(fd);
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "unable to size shared memory to %" PRIhsz
+                            " bytes",
+                            file_size);
+  }
+
+  // Each endpoint owns its own mapping and descriptor so that they can be
+  // destroyed independently (and so that either can be handed to another
+  // process).
+  iree_status_t status = iree_remoting_shm_transport_map(
+      fd, IREE_REMOTING_SHM_CLIENT, /*initialize=*/true, capacity,
+      host_allocator, out_client);
+  if (!iree_status_is_ok(status)) close(fd);
+  if (iree_status_is_ok(status)) {
+    int server_fd = dup(fd);
+    if (server_fd < 0) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "unable to duplicate shared memory fd");
+    } else {
+      status = iree_remoting_shm_transport_map(
+          server_fd, IREE_REMOTING_SHM_SERVER, /*initialize=*/false, capacity,
+          host_allocator, out_server);
+      if (!iree_status_is_ok(status)) close(server_fd);
+    }
+  }
+
+  if (!iree_status_is_ok(status)) {
+    iree_remoting_transport_release(*out_client);
+    *out_client = NULL;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+int iree_remoting_shm_transport_fd(iree_remoting_transport_t* base_transport) {
+  iree_remoting_shm_transport_t* transport =
+      iree_remoting_shm_transport_cast(base_transport);
+  return transport->fd;
+}
+
+iree_status_t iree_remoting_shm_transport_open(
+    int fd, iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_server) {
+  IREE_ASSERT_ARGUMENT(out_server);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_remoting_shm_transport_map(
+      fd, IREE_REMOTING_SHM_SERVER, /*initialize=*/false, /*capacity=*/0,
+      host_allocator, out_server);
+  if (!iree_status_is_ok(status)) close(fd);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_remoting_shm_transport_destroy(
+    iree_remoting_transport_t* base_transport) {
+  iree_remoting_shm_transport_t* transport =
+      iree_remoting_shm_transport_cast(base_transport);
+  iree_allocator_t host_allocator = transport->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Mark this endpoint closed and wake the peer if it is blocked on us.
+  iree_atomic_store_int32(&transport->header->closed[transport->endpoint], 1,
+                          iree_memory_order_seq_cst);
+  iree_atomic_fetch_add_int32(&transport->tx_ring->data_sequence, 1,
+                              iree_memory_order_seq_cst);
+  iree_remoting_shm_futex_wake(&transport->tx_ring->data_sequence);
+  iree_atomic_fetch_add_int32(&transport->rx_ring->space_sequence, 1,
+                              iree_memory_order_seq_cst);
+  iree_remoting_shm_futex_wake(&transport->rx_ring->space_sequence);
+
+  munmap(transport->mapping, transport->mapping_size);
+  close(transport->fd);
+  iree_allocator_free(host_allocator, transport);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static bool iree_remoting_shm_transport_is_peer_closed(
+    iree_remoting_shm_transport_t* transport) {
+  return iree_atomic_load_int32(
+             &transport->header->closed[1 - transport->endpoint],
+             iree_memory_order_seq_cst) != 0;
+}
+
+// Publishes new data to the reader and wakes it if it is parked.
+static void iree_remoting_shm_transport_notify_data(
+    iree_remoting_shm_transport_t* transport) {
+  iree_remoting_shm_ring_t* ring = transport->tx_ring;
+  iree_atomic_fetch_add_int32(&ring->data_sequence, 1,
+                              iree_memory_order_seq_cst);
+  if (iree_atomic_load_int32(&ring->reader_waiting,
+                             iree_memory_order_seq_cst)) {
+    iree_remoting_shm_futex_wake(&ring->data_sequence);
+  }
+}
+
+// Publishes released space to the writer and wakes it if it is parked.
+static void iree_remoting_shm_transport_notify_space(
+    iree_remoting_shm_transport_t* transport) {
+  iree_remoting_shm_ring_t* ring = transport->rx_ring;
+  iree_atomic_fetch_add_int32(&ring->space_sequence, 1,
+                              iree_memory_order_seq_cst);
+  if (iree_atomic_load_int32(&ring->writer_waiting,
+                             iree_memory_order_seq_cst)) {
+    iree_remoting_shm_futex_wake(&ring->space_sequence);
+  }
+}
+
+static iree_status_t iree_remoting_shm_transport_write(
+    iree_remoting_transport_t* base_transport, iree_host_size_t span_count,
+    const iree_const_byte_span_t* spans) {
+  iree_remoting_shm_transport_t* transport =
+      iree_remoting_shm_transport_cast(base_transport);
+  iree_remoting_shm_ring_t* ring = transport->tx_ring;
+  const uint64_t capacity = transport->mask + 1;
+
+  for (iree_host_size_t i = 0; i < span_count; ++i) {
+    const uint8_t* data = spans[i].data;
+    iree_host_size_t remaining = spans[i].data_length;
+    while (remaining > 0) {
+      int64_t write_position = iree_atomic_load_int64(
+          &ring->write_position, iree_memory_order_relaxed);
+      int32_t sequence = iree_atomic_load_int32(&ring->space_sequence,
+                                                iree_memory_order_seq_cst);
+      uint64_t free_space =
+          capacity - (uint64_t)(write_position -
+                                iree_atomic_load_int64(
+                                    &ring->read_position,
+                                    iree_memory_order_acquire));
+      if (free_space == 0) {
+        if (iree_remoting_shm_transport_is_peer_closed(transport)) {
+          return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                                  "shared memory transport peer closed");
+        }
+        // Publish what has been written so far so that the reader can make
+        // progress, then park until it releases space.
+        iree_remoting_shm_transport_notify_data(transport);
+        iree_atomic_store_int32(&ring->writer_waiting, 1,
+                                iree_memory_order_seq_cst);
+        if (iree_atomic_load_int64(&ring->read_position,
+                                   iree_memory_order_seq_cst) +
+                    (int64_t)capacity ==
+                write_position &&
+            !iree_remoting_shm_transport_is_peer_closed(transport)) {
+          iree_remoting_shm_futex_wait(&ring->space_sequence, sequence);
+        }
+        iree_atomic_store_int32(&ring->writer_waiting, 0,
+                                iree_memory_order_relaxed);
+        continue;
+      }
+
+      // Copy up to the end of the ring; wrapped data is copied on the next
+      // iteration.
+      uint64_t offset = (uint64_t)write_position & transport->mask;
+      iree_host_size_t chunk_length = (iree_host_size_t)iree_min(
+          iree_min((uint64_t)remaining, free_space), capacity - offset);
+      memcpy(transport->tx_data + offset, data, chunk_length);
+      iree_atomic_store_int64(&ring->write_position,
+                              write_position + (int64_t)chunk_length,
+                              iree_memory_order_release);
+      data += chunk_length;
+      remaining -= chunk_length;
+    }
+  }
+
+  iree_remoting_shm_transport_notify_data(transport);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_shm_transport_read(
+    iree_remoting_transport_t* base_transport, iree_byte_span_t buffer) {
+  iree_remoting_shm_transport_t* transport =
+      iree_remoting_shm_transport_cast(base_transport);
+  iree_remoting_shm_ring_t* ring = transport->rx_ring;
+  const uint64_t capacity = transport->mask + 1;
+
+  uint8_t* data = buffer.data;
+  iree_host_size_t remaining = buffer.data_length;
+  while (remaining > 0) {
+    int64_t read_position =
+        iree_atomic_load_int64(&ring->read_position, iree_memory_order_relaxed);
+    int32_t sequence =
+        iree_atomic_load_int32(&ring->data_sequence, iree_memory_order_seq_cst);
+    uint64_t available = (uint64_t)(iree_atomic_load_int64(
+                                        &ring->write_position,
+                                        iree_memory_order_acquire) -
+                                    read_position);
+    if (available == 0) {
+      if (iree_remoting_shm_transport_is_peer_closed(transport)) {
+        // Recheck as the peer may have written data before closing.
+        if (iree_atomic_load_int64(&ring->write_position,
+                                   iree_memory_order_seq_cst) ==
+            read_position) {
+          return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                                  "shared memory transport peer closed");
+        }
+        continue;
+      }
+      iree_atomic_store_int32(&ring->reader_waiting, 1,
+                              iree_memory_order_seq_cst);
+      if (iree_atomic_load_int64(&ring->write_position,
+                                 iree_memory_order_seq_cst) == read_position &&
+          !iree_remoting_shm_transport_is_peer_closed(transport)) {
+        iree_remoting_shm_futex_wait(&ring->data_sequence, sequence);
+      }
+      iree_atomic_store_int32(&ring->reader_waiting, 0,
+                              iree_memory_order_relaxed);
+      continue;
+    }
+
+    uint64_t offset = (uint64_t)read_position & transport->mask;
+    iree_host_size_t chunk_length = (iree_host_size_t)iree_min(
+        iree_min((uint64_t)remaining, available), capacity - offset);
+    memcpy(data, transport->rx_data + offset, chunk_length);
+    iree_atomic_store_int64(&ring->read_position,
+                            read_position + (int64_t)chunk_length,
+                            iree_memory_order_release);
+    iree_remoting_shm_transport_notify_space(transport);
+    data += chunk_length;
+    remaining -= chunk_length;
+  }
+  return iree_ok_status();
+}
+
+static const iree_remoting_transport_vtable_t
+    iree_remoting_shm_transport_vtable = {
+        .destroy = iree_remoting_shm_transport_destroy,
+        .write = iree_remoting_shm_transport_write,
+        .read = iree_remoting_shm_transport_read,
+};
+
+#else
+
+iree_status_t iree_remoting_shm_transport_create_pair(
+    iree_host_size_t capacity, iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_client,
+    iree_remoting_transport_t** out_server) {
+  *out_client = NULL;
+  *out_server = NULL;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "shared memory transports require Linux");
+}
+
+int iree_remoting_shm_transport_fd(iree_remoting_transport_t* transport) {
+  return -1;
+}
+
+iree_status_t iree_remoting_shm_transport_open(
+    int fd, iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_server) {
+  *out_server = NULL;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "shared memory transports require Linux");
+}
+
+#endif  // IREE_PLATFORM_LINUX
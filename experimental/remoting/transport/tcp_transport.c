@@ -0,0 +1,379 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "experimental/remoting/transport/transport.h"
+#include "iree/base/target_platform.h"
+#include "iree/base/tracing.h"
+
+#if defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_APPLE) || \
+    defined(IREE_PLATFORM_ANDROID)
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(MSG_NOSIGNAL)
+#define IREE_REMOTING_TCP_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define IREE_REMOTING_TCP_SEND_FLAGS 0
+#endif  // MSG_NOSIGNAL
+
+// Maximum number of iovecs passed to a single sendmsg call.
+#define IREE_REMOTING_TCP_MAX_IOVECS 16
+
+//===----------------------------------------------------------------------===//
+// iree_remoting_tcp_transport_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_remoting_tcp_transport_t {
+  iree_remoting_transport_t base;
+  iree_allocator_t host_allocator;
+  int socket_fd;
+} iree_remoting_tcp_transport_t;
+
+static const iree_remoting_transport_vtable_t
+    iree_remoting_tcp_transport_vtable;
+
+static iree_remoting_tcp_transport_t* iree_remoting_tcp_transport_cast(
+    iree_remoting_transport_t* base_value) {
+  IREE_ASSERT_EQ(base_value->vtable, &iree_remoting_tcp_transport_vtable);
+  return (iree_remoting_tcp_transport_t*)base_value;
+}
+
+static iree_status_t iree_remoting_tcp_transport_wrap(
+    int socket_fd, iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_transport) {
+  int enable = 1;
+  setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+#if defined(SO_NOSIGPIPE)
+  setsockopt(socket_fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif  // SO_NOSIGPIPE
+
+  iree_remoting_tcp_transport_t* transport = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*transport), (void**)&transport);
+  if (!iree_status_is_ok(status)) {
+    close(socket_fd);
+    return status;
+  }
+  iree_remoting_transport_initialize(&iree_remoting_tcp_transport_vtable,
+                                     &transport->base);
+  transport->host_allocator = host_allocator;
+  transport->socket_fd = socket_fd;
+  *out_transport = &transport->base;
+  return iree_ok_status();
+}
+
+iree_status_t iree_remoting_tcp_transport_connect(
+    iree_string_view_t host, uint16_t port, iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_transport) {
+  IREE_ASSERT_ARGUMENT(out_transport);
+  *out_transport = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  char host_str[256];
+  char port_str[8];
+  if (host.size >= sizeof(host_str)) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "host name too long");
+  }
+  memcpy(host_str, host.data, host.size);
+  host_str[host.size] = 0;
+  snprintf(port_str, sizeof(port_str), "%u", (unsigned)port);
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* addresses = NULL;
+  int result = getaddrinfo(host_str, port_str, &hints, &addresses);
+  if (result != 0) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "unable to resolve '%s': %s", host_str,
+                            gai_strerror(result));
+  }
+
+  // Try each resolved address in order until one connects.
+  int socket_fd = -1;
+  int last_errno = 0;
+  for (struct addrinfo* address = addresses; address;
+       address = address->ai_next) {
+    socket_fd =
+        socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (socket_fd < 0) {
+      last_errno = errno;
+      continue;
+    }
+    if (connect(socket_fd, address->ai_addr, address->ai_addrlen) == 0) break;
+    last_errno = errno;
+    close(socket_fd);
+    socket_fd = -1;
+  }
+  freeaddrinfo(addresses);
+
+  iree_status_t status = iree_ok_status();
+  if (socket_fd < 0) {
+    status = iree_make_status(iree_status_code_from_errno(last_errno),
+                              "unable to connect to %s:%u", host_str,
+                              (unsigned)port);
+  } else {
+    status = iree_remoting_tcp_transport_wrap(socket_fd, host_allocator,
+                                              out_transport);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_remoting_tcp_transport_destroy(
+    iree_remoting_transport_t* base_transport) {
+  iree_remoting_tcp_transport_t* transport =
+      iree_remoting_tcp_transport_cast(base_transport);
+  iree_allocator_t host_allocator = transport->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  shutdown(transport->socket_fd, SHUT_RDWR);
+  close(transport->socket_fd);
+  iree_allocator_free(host_allocator, transport);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_status_t iree_remoting_tcp_transport_write(
+    iree_remoting_transport_t* base_transport, iree_host_size_t span_count,
+    const iree_const_byte_span_t* spans) {
+  iree_remoting_tcp_transport_t* transport =
+      iree_remoting_tcp_transport_cast(base_transport);
+
+  // Gather as many spans as possible into each sendmsg so that a message
+  // header and its payload go out in a single segment.
+  iree_host_size_t span_index = 0;
+  iree_host_size_t span_offset = 0;
+  while (span_index < span_count) {
+    struct iovec iovecs[IREE_REMOTING_TCP_MAX_IOVECS];
+    int iovec_count = 0;
+    for (iree_host_size_t i = span_index;
+         i < span_count && iovec_count < IREE_REMOTING_TCP_MAX_IOVECS; ++i) {
+      iree_host_size_t offset = i == span_index ? span_offset : 0;
+      if (spans[i].data_length == offset) continue;
+      iovecs[iovec_count].iov_base = (void*)(spans[i].data + offset);
+      iovecs[iovec_count].iov_len = spans[i].data_length - offset;
+      ++iovec_count;
+    }
+    if (iovec_count == 0) break;
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = iovecs;
+    message.msg_iovlen = iovec_count;
+    ssize_t sent =
+        sendmsg(transport->socket_fd, &message, IREE_REMOTING_TCP_SEND_FLAGS);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EPIPE || errno == ECONNRESET) {
+        return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                                "tcp transport peer closed");
+      }
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "tcp transport send failed");
+    }
+
+    // Advance past the bytes sent; a short send resumes mid-span.
+    iree_host_size_t remaining = (iree_host_size_t)sent;
+    while (remaining > 0 && span_index < span_count) {
+      iree_host_size_t span_remaining =
+          spans[span_index].data_length - span_offset;
+      if (remaining < span_remaining) {
+        span_offset += remaining;
+        remaining = 0;
+      } else {
+        remaining -= span_remaining;
+        ++span_index;
+        span_offset = 0;
+      }
+    }
+    while (span_index < span_count &&
+           spans[span_index].data_length == span_offset) {
+      ++span_index;
+      span_offset = 0;
+    }
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_remoting_tcp_transport_read(
+    iree_remoting_transport_t* base_transport, iree_byte_span_t buffer) {
+  iree_remoting_tcp_transport_t* transport =
+      iree_remoting_tcp_transport_cast(base_transport);
+  uint8_t* data = buffer.data;
+  iree_host_size_t remaining = buffer.data_length;
+  while (remaining > 0) {
+    ssize_t received = recv(transport->socket_fd, data, remaining, 0);
+    if (received == 0) {
+      return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                              "tcp transport peer closed");
+    } else if (received < 0) {
+      if (errno == EINTR) continue;
+      if (errno == ECONNRESET) {
+        return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                                "tcp transport peer closed");
+      }
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "tcp transport receive failed");
+    }
+    data += received;
+    remaining -= (iree_host_size_t)received;
+  }
+  return iree_ok_status();
+}
+
+static const iree_remoting_transport_vtable_t
+    iree_remoting_tcp_transport_vtable = {
+        .destroy = iree_remoting_tcp_transport_destroy,
+        .write = iree_remoting_tcp_transport_write,
+        .read = iree_remoting_tcp_transport_read,
+};
+
+//===----------------------------------------------------------------------===//
+// iree_remoting_tcp_listener_t
+//===----------------------------------------------------------------------===//
+
+struct iree_remoting_tcp_listener_t {
+  iree_allocator_t host_allocator;
+  int socket_fd;
+  uint16_t port;
+};
+
+iree_status_t iree_remoting_tcp_listener_create(
+    uint16_t port, iree_allocator_t host_allocator,
+    iree_remoting_tcp_listener_t** out_listener) {
+  IREE_ASSERT_ARGUMENT(out_listener);
+  *out_listener = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (socket_fd < 0) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "unable to create listening socket");
+  }
+  int enable = 1;
+  setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  socklen_t address_length = sizeof(address);
+  iree_status_t status = iree_ok_status();
+  if (bind(socket_fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+      listen(socket_fd, SOMAXCONN) != 0 ||
+      getsockname(socket_fd, (struct sockaddr*)&address, &address_length) !=
+          0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "unable to listen on port %u", (unsigned)port);
+  }
+
+  iree_remoting_tcp_listener_t* listener = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_malloc(host_allocator, sizeof(*listener),
+                                   (void**)&listener);
+  }
+  if (iree_status_is_ok(status)) {
+    listener->host_allocator = host_allocator;
+    listener->socket_fd = socket_fd;
+    listener->port = ntohs(address.sin_port);
+    *out_listener = listener;
+  } else {
+    close(socket_fd);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_remoting_tcp_listener_free(iree_remoting_tcp_listener_t* listener) {
+  if (!listener) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator = listener->host_allocator;
+  shutdown(listener->socket_fd, SHUT_RDWR);
+  close(listener->socket_fd);
+  iree_allocator_free(host_allocator, listener);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+uint16_t iree_remoting_tcp_listener_port(
+    iree_remoting_tcp_listener_t* listener) {
+  return listener->port;
+}
+
+iree_status_t iree_remoting_tcp_listener_accept(
+    iree_remoting_tcp_listener_t* listener,
+    iree_remoting_transport_t** out_transport) {
+  IREE_ASSERT_ARGUMENT(listener);
+  IREE_ASSERT_ARGUMENT(out_transport);
+  *out_transport = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  int socket_fd = -1;
+  do {
+    socket_fd = accept(listener->socket_fd, NULL, NULL);
+  } while (socket_fd < 0 && errno == EINTR);
+  iree_status_t status = iree_ok_status();
+  if (socket_fd < 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "unable to accept connection");
+  } else {
+    status = iree_remoting_tcp_transport_wrap(
+        socket_fd, listener->host_allocator, out_transport);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+#else
+
+iree_status_t iree_remoting_tcp_transport_connect(
+    iree_string_view_t host, uint16_t port, iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_transport) {
+  *out_transport = NULL;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "tcp transports require POSIX sockets");
+}
+
+iree_status_t iree_remoting_tcp_listener_create(
+    uint16_t port, iree_allocator_t host_allocator,
+    iree_remoting_tcp_listener_t** out_listener) {
+  *out_listener = NULL;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "tcp transports require POSIX sockets");
+}
+
+void iree_remoting_tcp_listener_free(iree_remoting_tcp_listener_t* listener) {}
+
+uint16_t iree_remoting_tcp_listener_port(
+    iree_remoting_tcp_listener_t* listener) {
+  return 0;
+}
+
+iree_status_t iree_remoting_tcp_listener_accept(
+    iree_remoting_tcp_listener_t* listener,
+    iree_remoting_transport_t** out_transport) {
+  *out_transport = NULL;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "tcp transports require POSIX sockets");
+}
+
+#endif  // IREE_PLATFORM_LINUX || IREE_PLATFORM_APPLE || IREE_PLATFORM_ANDROID
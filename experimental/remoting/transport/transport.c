@@ -0,0 +1,44 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/remoting/transport/transport.h"
+
+#include <stddef.h>
+
+void iree_remoting_transport_initialize(
+    const iree_remoting_transport_vtable_t* vtable,
+    iree_remoting_transport_t* out_transport) {
+  iree_atomic_ref_count_init(&out_transport->ref_count);
+  out_transport->vtable = vtable;
+}
+
+void iree_remoting_transport_retain(iree_remoting_transport_t* transport) {
+  if (IREE_LIKELY(transport)) {
+    iree_atomic_ref_count_inc(&transport->ref_count);
+  }
+}
+
+void iree_remoting_transport_release(iree_remoting_transport_t* transport) {
+  if (IREE_LIKELY(transport) &&
+      iree_atomic_ref_count_dec(&transport->ref_count) == 1) {
+    transport->vtable->destroy(transport);
+  }
+}
+
+iree_status_t iree_remoting_transport_write(
+    iree_remoting_transport_t* transport, iree_host_size_t span_count,
+    const iree_const_byte_span_t* spans) {
+  IREE_ASSERT_ARGUMENT(transport);
+  IREE_ASSERT_ARGUMENT(!span_count || spans);
+  return transport->vtable->write(transport, span_count, spans);
+}
+
+iree_status_t iree_remoting_transport_read(iree_remoting_transport_t* transport,
+                                           iree_byte_span_t buffer) {
+  IREE_ASSERT_ARGUMENT(transport);
+  if (buffer.data_length == 0) return iree_ok_status();
+  return transport->vtable->read(transport, buffer);
+}
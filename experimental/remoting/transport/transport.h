@@ -0,0 +1,147 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef EXPERIMENTAL_REMOTING_TRANSPORT_TRANSPORT_H_
+#define EXPERIMENTAL_REMOTING_TRANSPORT_TRANSPORT_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_remoting_transport_t
+//===----------------------------------------------------------------------===//
+
+// A reliable, ordered, bidirectional byte stream connecting two endpoints.
+// Transports carry no framing of their own: writers and readers agree on
+// message boundaries (see experimental/remoting/hal/protocol.h).
+//
+// Writes may be issued from one thread at a time and reads from one thread at
+// a time; a read and a write may happen concurrently. Writes are pipelined:
+// they return as soon as the data has been handed to the transport and do not
+// wait for the peer to read it.
+//
+// When the peer is destroyed any blocked or future read or write fails with
+// IREE_STATUS_UNAVAILABLE once all data already sent by the peer has been
+// read.
+typedef struct iree_remoting_transport_t iree_remoting_transport_t;
+
+typedef struct iree_remoting_transport_vtable_t {
+  void(IREE_API_PTR* destroy)(iree_remoting_transport_t* transport);
+
+  iree_status_t(IREE_API_PTR* write)(iree_remoting_transport_t* transport,
+                                     iree_host_size_t span_count,
+                                     const iree_const_byte_span_t* spans);
+
+  iree_status_t(IREE_API_PTR* read)(iree_remoting_transport_t* transport,
+                                    iree_byte_span_t buffer);
+} iree_remoting_transport_vtable_t;
+
+struct iree_remoting_transport_t {
+  iree_atomic_ref_count_t ref_count;
+  const iree_remoting_transport_vtable_t* vtable;
+};
+
+// Initializes the base transport fields with a reference count of 1.
+void iree_remoting_transport_initialize(
+    const iree_remoting_transport_vtable_t* vtable,
+    iree_remoting_transport_t* out_transport);
+
+// Retains the given |transport| for the caller.
+void iree_remoting_transport_retain(iree_remoting_transport_t* transport);
+
+// Releases the given |transport| from the caller. The connection is closed
+// when the last reference is released.
+void iree_remoting_transport_release(iree_remoting_transport_t* transport);
+
+// Writes the concatenation of |spans| to the transport.
+// Blocks only while the transport has no capacity for more data.
+iree_status_t iree_remoting_transport_write(
+    iree_remoting_transport_t* transport, iree_host_size_t span_count,
+    const iree_const_byte_span_t* spans);
+
+// Reads exactly |buffer|.data_length bytes from the transport into |buffer|.
+// Blocks until all bytes have been read or the peer has disconnected.
+iree_status_t iree_remoting_transport_read(iree_remoting_transport_t* transport,
+                                           iree_byte_span_t buffer);
+
+//===----------------------------------------------------------------------===//
+// Shared-memory transport
+//===----------------------------------------------------------------------===//
+
+// Default capacity in bytes of each direction of a shared-memory transport.
+#define IREE_REMOTING_SHM_TRANSPORT_DEFAULT_CAPACITY (4 * 1024 * 1024)
+
+// Creates a pair of connected transports communicating through a pair of
+// shared-memory ring buffers of |capacity| bytes each (rounded up to a power
+// of two). Data written to one end of the pair is read from the other.
+//
+// The shared memory is backed by an anonymous file that can be mapped into
+// another process with iree_remoting_shm_transport_open: the pair returned
+// here can also be used within a single process (for example to serve a
+// device from a thread).
+//
+// Only available on Linux; other platforms return IREE_STATUS_UNAVAILABLE.
+iree_status_t iree_remoting_shm_transport_create_pair(
+    iree_host_size_t capacity, iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_client,
+    iree_remoting_transport_t** out_server);
+
+// Returns the file descriptor of the shared memory backing |transport|.
+// The descriptor remains owned by the transport; callers wishing to hand it to
+// another process (e.g. over a unix domain socket or by inheritance) should
+// duplicate it.
+int iree_remoting_shm_transport_fd(iree_remoting_transport_t* transport);
+
+// Opens the server end of a transport pair created in another process from
+// the shared memory referenced by |fd|. The transport takes ownership of |fd|.
+iree_status_t iree_remoting_shm_transport_open(
+    int fd, iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_server);
+
+//===----------------------------------------------------------------------===//
+// TCP transport
+//===----------------------------------------------------------------------===//
+
+// Connects to a listening TCP endpoint at |host|:|port|.
+// Nagle's algorithm is disabled so that small pipelined messages are sent
+// immediately.
+iree_status_t iree_remoting_tcp_transport_connect(
+    iree_string_view_t host, uint16_t port, iree_allocator_t host_allocator,
+    iree_remoting_transport_t** out_transport);
+
+// A listening TCP socket accepting transport connections.
+typedef struct iree_remoting_tcp_listener_t iree_remoting_tcp_listener_t;
+
+// Creates a listener bound to |port| on all interfaces. A |port| of 0 binds to
+// an ephemeral port that can be queried with iree_remoting_tcp_listener_port.
+iree_status_t iree_remoting_tcp_listener_create(
+    uint16_t port, iree_allocator_t host_allocator,
+    iree_remoting_tcp_listener_t** out_listener);
+
+// Closes the listening socket and frees the listener.
+void iree_remoting_tcp_listener_free(iree_remoting_tcp_listener_t* listener);
+
+// Returns the port the listener is bound to.
+uint16_t iree_remoting_tcp_listener_port(
+    iree_remoting_tcp_listener_t* listener);
+
+// Blocks until a client connects and returns the connection in
+// |out_transport|.
+iree_status_t iree_remoting_tcp_listener_accept(
+    iree_remoting_tcp_listener_t* listener,
+    iree_remoting_transport_t** out_transport);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // EXPERIMENTAL_REMOTING_TRANSPORT_TRANSPORT_H_
@@ -0,0 +1,141 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/remoting/transport/transport.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using iree::StatusCode;
+using iree::testing::status::StatusIs;
+
+struct TransportPair {
+  iree_remoting_transport_t* client = NULL;
+  iree_remoting_transport_t* server = NULL;
+  ~TransportPair() {
+    iree_remoting_transport_release(client);
+    iree_remoting_transport_release(server);
+  }
+};
+
+static std::vector<uint8_t> MakePattern(size_t length, uint8_t seed) {
+  std::vector<uint8_t> data(length);
+  for (size_t i = 0; i < length; ++i) {
+    data[i] = static_cast<uint8_t>(seed + i * 7);
+  }
+  return data;
+}
+
+static void ExpectRoundTrip(iree_remoting_transport_t* writer,
+                            iree_remoting_transport_t* reader,
+                            size_t length) {
+  auto header = MakePattern(16, 1);
+  auto payload = MakePattern(length, 3);
+  std::thread writer_thread([&]() {
+    iree_const_byte_span_t spans[2] = {
+        iree_make_const_byte_span(header.data(), header.size()),
+        iree_make_const_byte_span(payload.data(), payload.size()),
+    };
+    IREE_EXPECT_OK(iree_remoting_transport_write(writer, 2, spans));
+  });
+  std::vector<uint8_t> received(header.size() + payload.size());
+  IREE_EXPECT_OK(iree_remoting_transport_read(
+      reader, iree_make_byte_span(received.data(), received.size())));
+  writer_thread.join();
+  EXPECT_TRUE(std::equal(header.begin(), header.end(), received.begin()));
+  EXPECT_TRUE(std::equal(payload.begin(), payload.end(),
+                         received.begin() + header.size()));
+}
+
+TEST(ShmTransportTest, SmallMessages) {
+  TransportPair pair;
+  iree_status_t status = iree_remoting_shm_transport_create_pair(
+      4096, iree_allocator_system(), &pair.client, &pair.server);
+  if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    GTEST_SKIP() << "shared memory transports unavailable";
+  }
+  IREE_ASSERT_OK(status);
+  for (int i = 0; i < 32; ++i) {
+    ExpectRoundTrip(pair.client, pair.server, 100);
+    ExpectRoundTrip(pair.server, pair.client, 100);
+  }
+}
+
+// Messages larger than the ring capacity are streamed through in chunks.
+TEST(ShmTransportTest, MessageLargerThanCapacity) {
+  TransportPair pair;
+  iree_status_t status = iree_remoting_shm_transport_create_pair(
+      4096, iree_allocator_system(), &pair.client, &pair.server);
+  if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    GTEST_SKIP() << "shared memory transports unavailable";
+  }
+  IREE_ASSERT_OK(status);
+  ExpectRoundTrip(pair.client, pair.server, 1024 * 1024 + 13);
+}
+
+TEST(ShmTransportTest, PeerClosed) {
+  TransportPair pair;
+  iree_status_t status = iree_remoting_shm_transport_create_pair(
+      4096, iree_allocator_system(), &pair.client, &pair.server);
+  if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    GTEST_SKIP() << "shared memory transports unavailable";
+  }
+  IREE_ASSERT_OK(status);
+
+  // Data written before closing remains readable.
+  uint8_t value = 42;
+  iree_const_byte_span_t span = iree_make_const_byte_span(&value, 1);
+  IREE_ASSERT_OK(iree_remoting_transport_write(pair.client, 1, &span));
+  iree_remoting_transport_release(pair.client);
+  pair.client = NULL;
+
+  uint8_t received = 0;
+  IREE_ASSERT_OK(iree_remoting_transport_read(
+      pair.server, iree_make_byte_span(&received, 1)));
+  EXPECT_EQ(received, value);
+  EXPECT_THAT(iree::Status(iree_remoting_transport_read(
+                  pair.server, iree_make_byte_span(&received, 1))),
+              StatusIs(StatusCode::kUnavailable));
+}
+
+TEST(TcpTransportTest, Loopback) {
+  iree_remoting_tcp_listener_t* listener = NULL;
+  iree_status_t status =
+      iree_remoting_tcp_listener_create(0, iree_allocator_system(), &listener);
+  if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    GTEST_SKIP() << "tcp transports unavailable";
+  }
+  IREE_ASSERT_OK(status);
+
+  TransportPair pair;
+  std::thread accept_thread([&]() {
+    IREE_EXPECT_OK(iree_remoting_tcp_listener_accept(listener, &pair.server));
+  });
+  IREE_ASSERT_OK(iree_remoting_tcp_transport_connect(
+      iree_make_cstring_view("127.0.0.1"),
+      iree_remoting_tcp_listener_port(listener), iree_allocator_system(),
+      &pair.client));
+  accept_thread.join();
+  ASSERT_NE(pair.server, nullptr);
+
+  ExpectRoundTrip(pair.client, pair.server, 100);
+  ExpectRoundTrip(pair.server, pair.client, 4 * 1024 * 1024);
+  iree_remoting_tcp_listener_free(listener);
+}
+
+}  // namespace
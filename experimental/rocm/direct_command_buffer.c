@@ -9,6 +9,7 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "experimental/rocm/dynamic_symbols.h"
 #include "experimental/rocm/executable_layout.h"
@@ -16,6 +17,7 @@
 #include "experimental/rocm/rocm_buffer.h"
 #include "experimental/rocm/status_util.h"
 #include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
 #include "iree/base/tracing.h"
 
 // Command buffer implementation that directly maps to rocm direct.
@@ -26,6 +28,12 @@ typedef struct {
   iree_hal_command_buffer_t base;
   iree_hal_rocm_context_wrapper_t* context;
   iree_arena_block_pool_t* block_pool;
+  hipStream_t stream;
+
+  // Staging arena used for host->device transfers. Async copies may read the
+  // host memory after update_buffer returns so it is kept until the command
+  // buffer is reset.
+  iree_arena_allocator_t arena;
 
   // Keep track of the current set of kernel arguments.
   int32_t push_constant[IREE_HAL_ROCM_MAX_PUSH_CONSTANT_COUNT];
@@ -50,7 +58,7 @@ iree_status_t iree_hal_rocm_direct_command_buffer_create(
     iree_hal_device_t* device, iree_hal_rocm_context_wrapper_t* context,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
-    iree_hal_queue_affinity_t queue_affinity,
+    iree_hal_queue_affinity_t queue_affinity, hipStream_t stream,
     iree_arena_block_pool_t* block_pool,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(context);
@@ -70,6 +78,8 @@ iree_status_t iree_hal_rocm_direct_command_buffer_create(
         &iree_hal_rocm_direct_command_buffer_vtable, &command_buffer->base);
     command_buffer->context = context;
     command_buffer->block_pool = block_pool;
+    command_buffer->stream = stream;
+    iree_arena_initialize(block_pool, &command_buffer->arena);
     hipDeviceptr_t* device_ptrs =
         (hipDeviceptr_t*)(command_buffer->current_descriptor +
                           IREE_HAL_ROCM_MAX_KERNEL_ARG);
@@ -90,6 +100,7 @@ static void iree_hal_rocm_direct_command_buffer_destroy(
       iree_hal_rocm_direct_command_buffer_cast(base_command_buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_arena_deinitialize(&command_buffer->arena);
   iree_allocator_free(command_buffer->context->host_allocator, command_buffer);
 
   IREE_TRACE_ZONE_END(z0);
@@ -112,6 +123,9 @@ static void* iree_hal_rocm_direct_command_buffer_dyn_cast(
 
 static iree_status_t iree_hal_rocm_direct_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_rocm_direct_command_buffer_t* command_buffer =
+      iree_hal_rocm_direct_command_buffer_cast(base_command_buffer);
+  iree_arena_reset(&command_buffer->arena);
   return iree_ok_status();
 }
 
@@ -215,11 +229,10 @@ static iree_status_t iree_hal_rocm_direct_command_buffer_fill_buffer(
   hipDeviceptr_t dst = target_device_buffer + target_offset;
   int value = dword_pattern;
   size_t sizeBytes = length;
-  // TODO(raikonenfnu): Currently using NULL stream, need to figure out way to
-  // access proper stream from command buffer
-  ROCM_RETURN_IF_ERROR(command_buffer->context->syms,
-                       hipMemsetAsync(dst, value, sizeBytes, 0),
-                       "hipMemsetAsync");
+  ROCM_RETURN_IF_ERROR(
+      command_buffer->context->syms,
+      hipMemsetAsync(dst, value, sizeBytes, command_buffer->stream),
+      "hipMemsetAsync");
   return iree_ok_status();
 }
 
@@ -227,8 +240,27 @@ static iree_status_t iree_hal_rocm_direct_command_buffer_update_buffer(
     iree_hal_command_buffer_t* base_command_buffer, const void* source_buffer,
     iree_host_size_t source_offset, iree_hal_buffer_t* target_buffer,
     iree_device_size_t target_offset, iree_device_size_t length) {
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "need rocm implementation");
+  iree_hal_rocm_direct_command_buffer_t* command_buffer =
+      iree_hal_rocm_direct_command_buffer_cast(base_command_buffer);
+
+  // Capture the source data as the caller may reuse the memory before the
+  // stream reaches the copy.
+  uint8_t* storage = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_arena_allocate(&command_buffer->arena, length, (void**)&storage));
+  memcpy(storage, (const uint8_t*)source_buffer + source_offset, length);
+
+  hipDeviceptr_t target_device_buffer = iree_hal_rocm_buffer_device_pointer(
+      iree_hal_buffer_allocated_buffer(target_buffer));
+  hipDeviceptr_t dst = (uint8_t*)target_device_buffer +
+                       iree_hal_buffer_byte_offset(target_buffer) +
+                       target_offset;
+  ROCM_RETURN_IF_ERROR(
+      command_buffer->context->syms,
+      hipMemcpyAsync(dst, storage, length, hipMemcpyHostToDevice,
+                     command_buffer->stream),
+      "hipMemcpyAsync");
+  return iree_ok_status();
 }
 
 static iree_status_t iree_hal_rocm_direct_command_buffer_copy_buffer(
@@ -245,12 +277,12 @@ static iree_status_t iree_hal_rocm_direct_command_buffer_copy_buffer(
   hipDeviceptr_t source_device_buffer = iree_hal_rocm_buffer_device_pointer(
       iree_hal_buffer_allocated_buffer(source_buffer));
   source_offset += iree_hal_buffer_byte_offset(source_buffer);
-  // TODO(raikonenfnu): Currently using NULL stream, need to figure out way to
-  // access proper stream from command buffer
+  hipDeviceptr_t dst = (uint8_t*)target_device_buffer + target_offset;
+  hipDeviceptr_t src = (uint8_t*)source_device_buffer + source_offset;
   ROCM_RETURN_IF_ERROR(
       command_buffer->context->syms,
-      hipMemcpyAsync(target_device_buffer, source_device_buffer, length,
-                     hipMemcpyDeviceToDevice, 0),
+      hipMemcpyAsync(dst, src, length, hipMemcpyDeviceToDevice,
+                     command_buffer->stream),
       "hipMemcpyAsync");
   return iree_ok_status();
 }
@@ -353,12 +385,11 @@ static iree_status_t iree_hal_rocm_direct_command_buffer_dispatch(
       executable, entry_point, &block_size_x, &block_size_y, &block_size_z));
   hipFunction_t func =
       iree_hal_rocm_native_executable_for_entry_point(executable, entry_point);
-  // TODO(raikonenfnu): Currently using NULL stream, need to figure out way to
-  // access proper stream from command buffer
   ROCM_RETURN_IF_ERROR(
       command_buffer->context->syms,
       hipModuleLaunchKernel(func, workgroup_x, workgroup_y, workgroup_z,
-                            block_size_x, block_size_y, block_size_z, 0, 0,
+                            block_size_x, block_size_y, block_size_z, 0,
+                            command_buffer->stream,
                             command_buffer->current_descriptor, NULL),
       "hipModuleLaunchKernel");
   return iree_ok_status();
@@ -6,15 +6,82 @@
 
 #include "experimental/rocm/event_semaphore.h"
 
+#include <inttypes.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
 
+// Sentinel used the semaphore has failed and an error status is set.
+#define IREE_HAL_ROCM_SEMAPHORE_FAILURE_VALUE UINT64_MAX
+
+// Interval at which waiters with a deadline poll pending HIP events. HIP has no
+// timed event wait so we can only block in hipEventSynchronize when the wait is
+// unbounded.
+#define IREE_HAL_ROCM_SEMAPHORE_POLL_INTERVAL_NS (100 * 1000)
+
+//===----------------------------------------------------------------------===//
+// iree_hal_rocm_semaphore_state_t
+//===----------------------------------------------------------------------===//
+
+void iree_hal_rocm_semaphore_state_initialize(
+    iree_hal_rocm_semaphore_callback_t host_signal_callback,
+    iree_hal_rocm_semaphore_state_t* out_shared_state) {
+  memset(out_shared_state, 0, sizeof(*out_shared_state));
+  iree_notification_initialize(&out_shared_state->notification);
+  out_shared_state->host_signal_callback = host_signal_callback;
+}
+
+void iree_hal_rocm_semaphore_state_deinitialize(
+    iree_hal_rocm_semaphore_state_t* shared_state) {
+  iree_notification_deinitialize(&shared_state->notification);
+  memset(shared_state, 0, sizeof(*shared_state));
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_rocm_semaphore_t
+//===----------------------------------------------------------------------===//
+
+// A device signal of |value| that completes when |event| does.
+typedef struct iree_hal_rocm_timepoint_t {
+  uint64_t value;
+  hipEvent_t event;
+} iree_hal_rocm_timepoint_t;
+
 typedef struct iree_hal_rocm_semaphore_t {
   iree_hal_resource_t resource;
   iree_hal_rocm_context_wrapper_t* context;
-  uint64_t initial_value;
+
+  // Shared across all semaphores.
+  iree_hal_rocm_semaphore_state_t* shared_state;
+
+  // Guards all mutable fields.
+  iree_slim_mutex_t mutex;
+
+  // Current signaled value. May be IREE_HAL_ROCM_SEMAPHORE_FAILURE_VALUE to
+  // indicate that the semaphore has been signaled for failure and
+  // |failure_status| contains the error.
+  uint64_t current_value;
+
+  // OK or the status passed to iree_hal_semaphore_fail. Owned by the semaphore.
+  iree_status_t failure_status;
+
+  // Total number of HIP events created by the semaphore. Both |timepoints| and
+  // |free_events| have capacity for all of them so that retiring a timepoint
+  // never needs to allocate.
+  iree_host_size_t event_count;
+  iree_host_size_t event_capacity;
+
+  // Pending device signals in the order they were enqueued.
+  iree_host_size_t timepoint_count;
+  iree_hal_rocm_timepoint_t* timepoints;
+
+  // Events whose timepoints have retired and that can be recorded again.
+  // Events are only destroyed with the semaphore so that waiters blocking in
+  // hipEventSynchronize outside of the lock always reference a live event.
+  iree_host_size_t free_event_count;
+  hipEvent_t* free_events;
 } iree_hal_rocm_semaphore_t;
 
 static const iree_hal_semaphore_vtable_t iree_hal_rocm_semaphore_vtable;
@@ -26,20 +93,27 @@ static iree_hal_rocm_semaphore_t* iree_hal_rocm_semaphore_cast(
 }
 
 iree_status_t iree_hal_rocm_semaphore_create(
-    iree_hal_rocm_context_wrapper_t* context, uint64_t initial_value,
+    iree_hal_rocm_context_wrapper_t* context,
+    iree_hal_rocm_semaphore_state_t* shared_state, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore) {
   IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(shared_state);
   IREE_ASSERT_ARGUMENT(out_semaphore);
+  *out_semaphore = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_rocm_semaphore_t* semaphore = NULL;
   iree_status_t status = iree_allocator_malloc(
       context->host_allocator, sizeof(*semaphore), (void**)&semaphore);
   if (iree_status_is_ok(status)) {
+    memset(semaphore, 0, sizeof(*semaphore));
     iree_hal_resource_initialize(&iree_hal_rocm_semaphore_vtable,
                                  &semaphore->resource);
     semaphore->context = context;
-    semaphore->initial_value = initial_value;
+    semaphore->shared_state = shared_state;
+    iree_slim_mutex_initialize(&semaphore->mutex);
+    semaphore->current_value = initial_value;
+    semaphore->failure_status = iree_ok_status();
     *out_semaphore = (iree_hal_semaphore_t*)semaphore;
   }
 
@@ -54,36 +128,371 @@ static void iree_hal_rocm_semaphore_destroy(
   iree_allocator_t host_allocator = semaphore->context->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  for (iree_host_size_t i = 0; i < semaphore->timepoint_count; ++i) {
+    ROCM_IGNORE_ERROR(semaphore->context->syms,
+                      hipEventDestroy(semaphore->timepoints[i].event));
+  }
+  for (iree_host_size_t i = 0; i < semaphore->free_event_count; ++i) {
+    ROCM_IGNORE_ERROR(semaphore->context->syms,
+                      hipEventDestroy(semaphore->free_events[i]));
+  }
+  iree_allocator_free(host_allocator, semaphore->timepoints);
+  iree_allocator_free(host_allocator, semaphore->free_events);
+  iree_status_free(semaphore->failure_status);
+  iree_slim_mutex_deinitialize(&semaphore->mutex);
   iree_allocator_free(host_allocator, semaphore);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Marks |semaphore| as failed with |status|, taking ownership of it. Only the
+// first failure is preserved. The semaphore mutex must be held.
+static void iree_hal_rocm_semaphore_fail_unsafe(
+    iree_hal_rocm_semaphore_t* semaphore, iree_status_t status) {
+  if (!iree_status_is_ok(semaphore->failure_status)) {
+    // Previous status was not OK; drop our new status.
+    IREE_IGNORE_ERROR(status);
+    return;
+  }
+  semaphore->current_value = IREE_HAL_ROCM_SEMAPHORE_FAILURE_VALUE;
+  semaphore->failure_status = status;
+}
+
+// Retires all timepoints whose events have completed and advances the current
+// value to the largest retired payload. The semaphore mutex must be held.
+static void iree_hal_rocm_semaphore_advance_unsafe(
+    iree_hal_rocm_semaphore_t* semaphore) {
+  iree_host_size_t pending_count = 0;
+  for (iree_host_size_t i = 0; i < semaphore->timepoint_count; ++i) {
+    iree_hal_rocm_timepoint_t timepoint = semaphore->timepoints[i];
+    hipError_t result =
+        semaphore->context->syms->hipEventQuery(timepoint.event);
+    if (result == hipErrorNotReady) {
+      semaphore->timepoints[pending_count++] = timepoint;
+      continue;
+    }
+    semaphore->free_events[semaphore->free_event_count++] = timepoint.event;
+    if (result != hipSuccess) {
+      iree_hal_rocm_semaphore_fail_unsafe(
+          semaphore, iree_hal_rocm_result_to_status(semaphore->context->syms,
+                                                    result, __FILE__,
+                                                    __LINE__));
+    } else if (timepoint.value > semaphore->current_value) {
+      semaphore->current_value = timepoint.value;
+    }
+  }
+  semaphore->timepoint_count = pending_count;
+}
+
+// Returns the status of |semaphore| relative to |value| at the current time:
+// - IREE_STATUS_OK: the value has been reached.
+// - IREE_STATUS_ABORTED: the semaphore has failed.
+// - IREE_STATUS_DEADLINE_EXCEEDED: the value has not been reached.
+//   |out_event| receives the event of the earliest pending device signal that
+//   reaches the value or NULL if none has been enqueued.
+static iree_status_code_t iree_hal_rocm_semaphore_poll(
+    iree_hal_rocm_semaphore_t* semaphore, uint64_t value,
+    hipEvent_t* out_event) {
+  *out_event = NULL;
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_hal_rocm_semaphore_advance_unsafe(semaphore);
+  iree_status_code_t status_code = IREE_STATUS_DEADLINE_EXCEEDED;
+  if (!iree_status_is_ok(semaphore->failure_status)) {
+    status_code = IREE_STATUS_ABORTED;
+  } else if (semaphore->current_value >= value) {
+    status_code = IREE_STATUS_OK;
+  } else {
+    uint64_t event_value = 0;
+    for (iree_host_size_t i = 0; i < semaphore->timepoint_count; ++i) {
+      const iree_hal_rocm_timepoint_t* timepoint = &semaphore->timepoints[i];
+      if (timepoint->value >= value &&
+          (!*out_event || timepoint->value < event_value)) {
+        *out_event = timepoint->event;
+        event_value = timepoint->value;
+      }
+    }
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return status_code;
+}
+
 static iree_status_t iree_hal_rocm_semaphore_query(
     iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
-  // TODO: Support semaphores completely.
-  *out_value = 0;
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED, "Not impemented on rocm");
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+
+  iree_hal_rocm_semaphore_advance_unsafe(semaphore);
+  *out_value = semaphore->current_value;
+
+  iree_status_t status = iree_ok_status();
+  if (*out_value >= IREE_HAL_ROCM_SEMAPHORE_FAILURE_VALUE) {
+    status = iree_status_clone(semaphore->failure_status);
+  }
+
+  iree_slim_mutex_unlock(&semaphore->mutex);
+
+  return status;
+}
+
+// Notifies waiters and the owning device of a host-side state change.
+static void iree_hal_rocm_semaphore_notify(
+    iree_hal_rocm_semaphore_t* semaphore) {
+  iree_hal_rocm_semaphore_state_t* shared_state = semaphore->shared_state;
+  iree_notification_post(&shared_state->notification, IREE_ALL_WAITERS);
+  if (shared_state->host_signal_callback.fn) {
+    shared_state->host_signal_callback.fn(
+        shared_state->host_signal_callback.user_data);
+  }
 }
 
 static iree_status_t iree_hal_rocm_semaphore_signal(
     iree_hal_semaphore_t* base_semaphore, uint64_t new_value) {
-  // TODO: Support semaphores completely. Return OK currently as everything is
-  // synchronized for each submit to allow things to run.
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_hal_rocm_semaphore_advance_unsafe(semaphore);
+  if (new_value <= semaphore->current_value) {
+    uint64_t current_value IREE_ATTRIBUTE_UNUSED = semaphore->current_value;
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "semaphore values must be monotonically "
+                            "increasing; current_value=%" PRIu64
+                            ", new_value=%" PRIu64,
+                            current_value, new_value);
+  }
+  semaphore->current_value = new_value;
+  iree_slim_mutex_unlock(&semaphore->mutex);
+
+  iree_hal_rocm_semaphore_notify(semaphore);
   return iree_ok_status();
 }
 
 static void iree_hal_rocm_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
-                                         iree_status_t status) {}
+                                         iree_status_t status) {
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_hal_rocm_semaphore_fail_unsafe(semaphore, status);
+  iree_slim_mutex_unlock(&semaphore->mutex);
+
+  iree_hal_rocm_semaphore_notify(semaphore);
+}
 
 static iree_status_t iree_hal_rocm_semaphore_wait(
     iree_hal_semaphore_t* base_semaphore, uint64_t value,
     iree_timeout_t timeout) {
-  // TODO: Support semaphores completely. Return OK currently as everything is
-  // synchronized for each submit to allow things to run.
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+  iree_hal_semaphore_list_t semaphore_list = {
+      .count = 1,
+      .semaphores = &base_semaphore,
+      .payload_values = &value,
+  };
+  return iree_hal_rocm_semaphore_multi_wait(
+      semaphore->shared_state, IREE_HAL_WAIT_MODE_ALL, &semaphore_list,
+      timeout);
+}
+
+iree_status_t iree_hal_rocm_semaphore_is_wait_ready(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value, bool* out_is_ready) {
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+  hipEvent_t event = NULL;
+  iree_status_code_t status_code =
+      iree_hal_rocm_semaphore_poll(semaphore, value, &event);
+  *out_is_ready = status_code == IREE_STATUS_OK || event != NULL;
+  return status_code == IREE_STATUS_ABORTED
+             ? iree_status_from_code(IREE_STATUS_ABORTED)
+             : iree_ok_status();
+}
+
+iree_status_t iree_hal_rocm_semaphore_enqueue_wait(
+    iree_hal_semaphore_t* base_semaphore, hipStream_t stream, uint64_t value) {
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+  hipEvent_t event = NULL;
+  switch (iree_hal_rocm_semaphore_poll(semaphore, value, &event)) {
+    case IREE_STATUS_OK:
+      return iree_ok_status();
+    case IREE_STATUS_ABORTED:
+      return iree_status_from_code(IREE_STATUS_ABORTED);
+    default:
+      if (!event) {
+        return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                                "no signal of value %" PRIu64
+                                " has been enqueued",
+                                value);
+      }
+      // NOTE: the event is not recycled until it completes and it can only
+      // complete after the stream wait has been enqueued here.
+      return ROCM_RESULT_TO_STATUS(semaphore->context->syms,
+                                 hipStreamWaitEvent(stream, event, 0),
+                                 "hipStreamWaitEvent");
+  }
+}
+
+// Grows the timepoint and free event lists to hold at least |minimum_capacity|
+// events. The semaphore mutex must be held.
+static iree_status_t iree_hal_rocm_semaphore_reserve_unsafe(
+    iree_hal_rocm_semaphore_t* semaphore, iree_host_size_t minimum_capacity) {
+  if (minimum_capacity <= semaphore->event_capacity) return iree_ok_status();
+  iree_allocator_t host_allocator = semaphore->context->host_allocator;
+  iree_host_size_t new_capacity =
+      iree_max(minimum_capacity, semaphore->event_capacity * 2);
+  IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+      host_allocator, new_capacity * sizeof(*semaphore->timepoints),
+      (void**)&semaphore->timepoints));
+  IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+      host_allocator, new_capacity * sizeof(*semaphore->free_events),
+      (void**)&semaphore->free_events));
+  semaphore->event_capacity = new_capacity;
   return iree_ok_status();
 }
 
+iree_status_t iree_hal_rocm_semaphore_enqueue_signal(
+    iree_hal_semaphore_t* base_semaphore, hipStream_t stream, uint64_t value) {
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+  iree_hal_rocm_dynamic_symbols_t* syms = semaphore->context->syms;
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+
+  // Reuse a retired event if possible and otherwise create a new one.
+  iree_hal_rocm_semaphore_advance_unsafe(semaphore);
+  iree_status_t status = iree_ok_status();
+  hipEvent_t event = NULL;
+  if (semaphore->free_event_count > 0) {
+    event = semaphore->free_events[--semaphore->free_event_count];
+  } else {
+    status = iree_hal_rocm_semaphore_reserve_unsafe(semaphore,
+                                                    semaphore->event_count + 1);
+    if (iree_status_is_ok(status)) {
+      status = ROCM_RESULT_TO_STATUS(
+          syms, hipEventCreateWithFlags(&event, hipEventDisableTiming),
+          "hipEventCreateWithFlags");
+    }
+    if (iree_status_is_ok(status)) ++semaphore->event_count;
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = ROCM_RESULT_TO_STATUS(syms, hipEventRecord(event, stream),
+                                 "hipEventRecord");
+    if (iree_status_is_ok(status)) {
+      iree_hal_rocm_timepoint_t* timepoint =
+          &semaphore->timepoints[semaphore->timepoint_count++];
+      timepoint->value = value;
+      timepoint->event = event;
+    } else {
+      semaphore->free_events[semaphore->free_event_count++] = event;
+    }
+  }
+
+  iree_slim_mutex_unlock(&semaphore->mutex);
+
+  // Wake waiters so that they can block on the new event.
+  if (iree_status_is_ok(status)) {
+    iree_notification_post(&semaphore->shared_state->notification,
+                           IREE_ALL_WAITERS);
+  }
+  return status;
+}
+
+iree_status_t iree_hal_rocm_semaphore_multi_wait(
+    iree_hal_rocm_semaphore_state_t* shared_state,
+    iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  IREE_ASSERT_ARGUMENT(semaphore_list);
+  if (semaphore_list->count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  iree_status_t status = iree_ok_status();
+  while (true) {
+    // Prepare the wait before checking the semaphores so that we can't miss a
+    // notification posted in between.
+    iree_wait_token_t wait_token =
+        iree_notification_prepare_wait(&shared_state->notification);
+
+    bool any_signaled = false;
+    bool all_signaled = true;
+    bool any_failed = false;
+    iree_host_size_t pending_count = 0;
+    iree_hal_rocm_semaphore_t* pending_semaphore = NULL;
+    hipEvent_t pending_event = NULL;
+    for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+      iree_hal_rocm_semaphore_t* semaphore =
+          iree_hal_rocm_semaphore_cast(semaphore_list->semaphores[i]);
+      hipEvent_t event = NULL;
+      switch (iree_hal_rocm_semaphore_poll(
+          semaphore, semaphore_list->payload_values[i], &event)) {
+        case IREE_STATUS_OK:
+          any_signaled = true;
+          break;
+        case IREE_STATUS_ABORTED:
+          any_failed = true;
+          break;
+        default:
+          all_signaled = false;
+          ++pending_count;
+          if (event && !pending_event) {
+            pending_semaphore = semaphore;
+            pending_event = event;
+          }
+          break;
+      }
+    }
+
+    if (any_failed) {
+      // Always prioritize failure state.
+      iree_notification_cancel_wait(&shared_state->notification);
+      status = iree_status_from_code(IREE_STATUS_ABORTED);
+      break;
+    } else if (wait_mode == IREE_HAL_WAIT_MODE_ANY ? any_signaled
+                                                   : all_signaled) {
+      iree_notification_cancel_wait(&shared_state->notification);
+      break;
+    }
+
+    iree_time_t now_ns = iree_time_now();
+    if (now_ns >= deadline_ns) {
+      iree_notification_cancel_wait(&shared_state->notification);
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      break;
+    }
+
+    if (pending_event && deadline_ns == IREE_TIME_INFINITE_FUTURE &&
+        (wait_mode == IREE_HAL_WAIT_MODE_ALL || pending_count == 1)) {
+      // Unbounded wait that requires this event to complete: block in the
+      // driver and then recheck all semaphores.
+      iree_notification_cancel_wait(&shared_state->notification);
+      IREE_TRACE_ZONE_BEGIN_NAMED(z1, "hipEventSynchronize");
+      status = ROCM_RESULT_TO_STATUS(pending_semaphore->context->syms,
+                                   hipEventSynchronize(pending_event),
+                                   "hipEventSynchronize");
+      IREE_TRACE_ZONE_END(z1);
+      if (!iree_status_is_ok(status)) break;
+      continue;
+    }
+
+    // Wait for the host to signal or enqueue a device signal. If an event is
+    // pending we have to periodically wake to poll it.
+    iree_time_t wait_deadline_ns = deadline_ns;
+    if (pending_event) {
+      wait_deadline_ns = iree_min(
+          deadline_ns, now_ns + IREE_HAL_ROCM_SEMAPHORE_POLL_INTERVAL_NS);
+    }
+    iree_notification_commit_wait(&shared_state->notification, wait_token,
+                                  wait_deadline_ns);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static const iree_hal_semaphore_vtable_t iree_hal_rocm_semaphore_vtable = {
     .destroy = iree_hal_rocm_semaphore_destroy,
     .query = iree_hal_rocm_semaphore_query,
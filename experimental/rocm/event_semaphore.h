@@ -7,22 +7,90 @@
 #ifndef IREE_HAL_ROCM_SEMAPHORE_H_
 #define IREE_HAL_ROCM_SEMAPHORE_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "experimental/rocm/context_wrapper.h"
 #include "experimental/rocm/status_util.h"
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/hal/api.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
-// Create a rocm allocator.
+//===----------------------------------------------------------------------===//
+// iree_hal_rocm_semaphore_state_t
+//===----------------------------------------------------------------------===//
+
+// Callback issued after a semaphore is signaled or failed from the host.
+// Called without any semaphore locks held.
+typedef struct iree_hal_rocm_semaphore_callback_t {
+  void(IREE_API_PTR* fn)(void* user_data);
+  void* user_data;
+} iree_hal_rocm_semaphore_callback_t;
+
+// State shared between all semaphores created on a device.
+// Owned by the device and guaranteed to remain valid for the lifetime of any
+// semaphore created from it.
+typedef struct iree_hal_rocm_semaphore_state_t {
+  // In-process notification posted when any semaphore value changes or a new
+  // device signal is enqueued.
+  iree_notification_t notification;
+  // Used by the device to issue submissions that were waiting on host signals.
+  iree_hal_rocm_semaphore_callback_t host_signal_callback;
+} iree_hal_rocm_semaphore_state_t;
+
+// Initializes state used to perform semaphore synchronization.
+void iree_hal_rocm_semaphore_state_initialize(
+    iree_hal_rocm_semaphore_callback_t host_signal_callback,
+    iree_hal_rocm_semaphore_state_t* out_shared_state);
+
+// Deinitializes state used to perform semaphore synchronization; no semaphores
+// must be live with references.
+void iree_hal_rocm_semaphore_state_deinitialize(
+    iree_hal_rocm_semaphore_state_t* shared_state);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_rocm_semaphore_t
+//===----------------------------------------------------------------------===//
+
+// Creates a timeline semaphore whose device-side signals are HIP events
+// recorded into streams. Each pending device signal is tracked as a timepoint
+// of (payload value, hipEvent_t) and the semaphore value advances as the
+// events complete. Host waits block only on the event covering the requested
+// value.
 iree_status_t iree_hal_rocm_semaphore_create(
-    iree_hal_rocm_context_wrapper_t* context, uint64_t initial_value,
+    iree_hal_rocm_context_wrapper_t* context,
+    iree_hal_rocm_semaphore_state_t* shared_state, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore);
 
+// Returns true in |out_is_ready| if a stream wait for |value| can be enqueued
+// with iree_hal_rocm_semaphore_enqueue_wait: either the value has already been
+// reached or a device signal that reaches it has been enqueued.
+// Returns IREE_STATUS_ABORTED if the semaphore has failed.
+iree_status_t iree_hal_rocm_semaphore_is_wait_ready(
+    iree_hal_semaphore_t* semaphore, uint64_t value, bool* out_is_ready);
+
+// Makes |stream| wait until |semaphore| reaches |value|. The wait must be
+// ready as reported by iree_hal_rocm_semaphore_is_wait_ready.
+iree_status_t iree_hal_rocm_semaphore_enqueue_wait(
+    iree_hal_semaphore_t* semaphore, hipStream_t stream, uint64_t value);
+
+// Signals |semaphore| to |value| once all work currently enqueued on |stream|
+// has completed.
+iree_status_t iree_hal_rocm_semaphore_enqueue_signal(
+    iree_hal_semaphore_t* semaphore, hipStream_t stream, uint64_t value);
+
+// Performs a multi-wait on one or more semaphores.
+// Returns IREE_STATUS_DEADLINE_EXCEEDED if the wait does not complete before
+// |timeout| elapses.
+iree_status_t iree_hal_rocm_semaphore_multi_wait(
+    iree_hal_rocm_semaphore_state_t* shared_state,
+    iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
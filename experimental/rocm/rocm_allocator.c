@@ -13,12 +13,32 @@
 #include "experimental/rocm/status_util.h"
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/utils/allocation_cache.h"
+
+//===----------------------------------------------------------------------===//
+// Allocation cache
+//===----------------------------------------------------------------------===//
+
+// Physical heaps that freed allocations are cached for. Managed memory is not
+// cached as its migration state depends on how it was last accessed.
+typedef enum iree_hal_rocm_cache_heap_e {
+  // hipMalloc.
+  IREE_HAL_ROCM_CACHE_HEAP_DEVICE = 0,
+  // hipMemAllocHost with hipHostMallocWriteCombined.
+  IREE_HAL_ROCM_CACHE_HEAP_HOST_WRITE_COMBINED,
+  // hipMemAllocHost without hipHostMallocWriteCombined.
+  IREE_HAL_ROCM_CACHE_HEAP_HOST_CACHED,
+  IREE_HAL_ROCM_CACHE_HEAP_COUNT,
+} iree_hal_rocm_cache_heap_t;
 
 typedef struct iree_hal_rocm_allocator_t {
   iree_hal_resource_t resource;
   iree_hal_device_t* base_device;
   iree_hal_rocm_context_wrapper_t* context;
 
+  // Freed device-only and pinned host allocations retained for reuse.
+  iree_hal_allocation_cache_t cache;
+
   IREE_STATISTICS(iree_hal_allocator_statistics_t statistics;)
 } iree_hal_rocm_allocator_t;
 
@@ -30,9 +50,44 @@ static iree_hal_rocm_allocator_t* iree_hal_rocm_allocator_cast(
   return (iree_hal_rocm_allocator_t*)base_value;
 }
 
+// Returns the heap allocations of |memory_type| are made from in |out_heap|.
+// Returns false if allocations of the type are not cached.
+static bool iree_hal_rocm_cache_heap(iree_hal_memory_type_t memory_type,
+                                     iree_hal_rocm_cache_heap_t* out_heap) {
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+      return false;
+    }
+    *out_heap = IREE_HAL_ROCM_CACHE_HEAP_DEVICE;
+  } else if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_CACHED)) {
+    *out_heap = IREE_HAL_ROCM_CACHE_HEAP_HOST_CACHED;
+  } else {
+    *out_heap = IREE_HAL_ROCM_CACHE_HEAP_HOST_WRITE_COMBINED;
+  }
+  return true;
+}
+
+// Frees a cached allocation evicted from the cache back to HIP.
+static void iree_hal_rocm_cache_free(void* user_data, iree_host_size_t heap,
+                                     iree_hal_cached_allocation_t allocation) {
+  iree_hal_rocm_allocator_t* allocator = (iree_hal_rocm_allocator_t*)user_data;
+  if (heap == IREE_HAL_ROCM_CACHE_HEAP_DEVICE) {
+    hipDeviceptr_t device_ptr =
+        (hipDeviceptr_t)(uintptr_t)allocation.device_ptr;
+    ROCM_IGNORE_ERROR(allocator->context->syms, hipFree(device_ptr));
+  } else {
+    ROCM_IGNORE_ERROR(allocator->context->syms,
+                      hipHostFree(allocation.host_ptr));
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_rocm_allocator_t
+//===----------------------------------------------------------------------===//
+
 iree_status_t iree_hal_rocm_allocator_create(
     iree_hal_device_t* base_device, iree_hal_rocm_context_wrapper_t* context,
-    iree_hal_allocator_t** out_allocator) {
+    iree_device_size_t cache_limit, iree_hal_allocator_t** out_allocator) {
   IREE_ASSERT_ARGUMENT(base_device);
   IREE_ASSERT_ARGUMENT(context);
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -40,10 +95,18 @@ iree_status_t iree_hal_rocm_allocator_create(
   iree_status_t status = iree_allocator_malloc(
       context->host_allocator, sizeof(*allocator), (void**)&allocator);
   if (iree_status_is_ok(status)) {
+    memset(allocator, 0, sizeof(*allocator));
     iree_hal_resource_initialize(&iree_hal_rocm_allocator_vtable,
                                  &allocator->resource);
     allocator->context = context;
     allocator->base_device = base_device;
+    iree_hal_allocation_cache_free_callback_t free_callback = {
+        .fn = iree_hal_rocm_cache_free,
+        .user_data = allocator,
+    };
+    iree_hal_allocation_cache_initialize(
+        cache_limit, IREE_HAL_ROCM_CACHE_HEAP_COUNT, free_callback,
+        context->host_allocator, &allocator->cache);
     *out_allocator = (iree_hal_allocator_t*)allocator;
   }
 
@@ -58,6 +121,7 @@ static void iree_hal_rocm_allocator_destroy(
   iree_allocator_t host_allocator = allocator->context->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_allocation_cache_deinitialize(&allocator->cache);
   iree_allocator_free(host_allocator, allocator);
 
   IREE_TRACE_ZONE_END(z0);
@@ -72,6 +136,9 @@ static iree_allocator_t iree_hal_rocm_allocator_host_allocator(
 
 static iree_status_t iree_hal_rocm_allocator_trim(
     iree_hal_allocator_t* base_allocator) {
+  iree_hal_rocm_allocator_t* allocator =
+      iree_hal_rocm_allocator_cast(base_allocator);
+  iree_hal_allocation_cache_trim(&allocator->cache);
   return iree_ok_status();
 }
 
@@ -82,6 +149,12 @@ static void iree_hal_rocm_allocator_query_statistics(
     iree_hal_rocm_allocator_t* allocator =
         iree_hal_rocm_allocator_cast(base_allocator);
     memcpy(out_statistics, &allocator->statistics, sizeof(*out_statistics));
+    iree_hal_allocation_cache_statistics_t cache_statistics;
+    iree_hal_allocation_cache_query_statistics(&allocator->cache,
+                                               &cache_statistics);
+    out_statistics->cache_hit_count = cache_statistics.hit_count;
+    out_statistics->cache_miss_count = cache_statistics.miss_count;
+    out_statistics->cache_bytes = cache_statistics.cache_size;
   });
 }
 
@@ -128,44 +201,116 @@ static void iree_hal_rocm_buffer_free(iree_hal_rocm_context_wrapper_t* context,
   }
 }
 
-static iree_status_t iree_hal_rocm_allocator_allocate_buffer(
-    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
-    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
-    iree_const_byte_span_t initial_data, iree_hal_buffer_t** out_buffer) {
-  iree_hal_rocm_allocator_t* allocator =
-      iree_hal_rocm_allocator_cast(base_allocator);
-  // Guard against the corner case where the requested buffer size is 0. The
-  // application is unlikely to do anything when requesting a 0-byte buffer; but
-  // it can happen in real world use cases. So we should at least not crash.
-  if (allocation_size == 0) allocation_size = 4;
-  iree_status_t status;
+// Allocates |allocation_size| bytes of |memory_type| from HIP.
+// Returns the raw HIP result so that callers can handle out-of-memory errors.
+static hipError_t iree_hal_rocm_buffer_allocate(
+    iree_hal_rocm_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_device_size_t allocation_size, hipDeviceptr_t* out_device_ptr,
+    void** out_host_ptr) {
+  iree_hal_rocm_dynamic_symbols_t* syms = allocator->context->syms;
+  hipError_t result = hipSuccess;
   void* host_ptr = NULL;
   hipDeviceptr_t device_ptr = 0;
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_rocm_buffer_allocate");
   if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
     // Device local case.
     if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
-      status = ROCM_RESULT_TO_STATUS(
-          allocator->context->syms,
-          hipMallocManaged(&device_ptr, allocation_size, hipMemAttachGlobal));
+      result = syms->hipMallocManaged(&device_ptr, allocation_size,
+                                      hipMemAttachGlobal);
       host_ptr = (void*)device_ptr;
     } else {
       // Device only.
-      status = ROCM_RESULT_TO_STATUS(allocator->context->syms,
-                                     hipMalloc(&device_ptr, allocation_size));
+      result = syms->hipMalloc(&device_ptr, allocation_size);
     }
   } else {
     unsigned int flags = hipHostMallocMapped;
     if (!iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_CACHED)) {
       flags |= hipHostMallocWriteCombined;
     }
-    status = ROCM_RESULT_TO_STATUS(
-        allocator->context->syms,
-        hipMemAllocHost(&host_ptr, allocation_size, flags));
-    if (iree_status_is_ok(status)) {
-      status = ROCM_RESULT_TO_STATUS(
-          allocator->context->syms,
-          hipHostGetDevicePointer(&device_ptr, host_ptr, /*flags=*/0));
+    result = syms->hipMemAllocHost(&host_ptr, allocation_size, flags);
+    if (result == hipSuccess) {
+      result = syms->hipHostGetDevicePointer(&device_ptr, host_ptr,
+                                             /*flags=*/0);
+      if (result != hipSuccess) syms->hipHostFree(host_ptr);
+    }
+  }
+  if (result == hipSuccess) {
+    *out_device_ptr = device_ptr;
+    *out_host_ptr = host_ptr;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return result;
+}
+
+// Returns the memory backing a buffer of |allocation_size| bytes to the cache
+// or frees it if it cannot be cached.
+static void iree_hal_rocm_allocator_release_memory(
+    iree_hal_rocm_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_device_size_t allocation_size, hipDeviceptr_t device_ptr,
+    void* host_ptr) {
+  iree_hal_rocm_cache_heap_t cache_heap = IREE_HAL_ROCM_CACHE_HEAP_DEVICE;
+  iree_hal_allocation_cache_class_t size_class;
+  if (iree_hal_rocm_cache_heap(memory_type, &cache_heap) &&
+      iree_hal_allocation_cache_lookup_class(&allocator->cache,
+                                             allocation_size, &size_class)) {
+    iree_hal_cached_allocation_t allocation = {
+        .device_ptr = (uint64_t)(uintptr_t)device_ptr,
+        .host_ptr = host_ptr,
+    };
+    if (iree_hal_allocation_cache_release(&allocator->cache, cache_heap,
+                                          &size_class, allocation)) {
+      return;
+    }
+  }
+  iree_hal_rocm_buffer_free(allocator->context, memory_type, device_ptr,
+                            host_ptr);
+}
+
+static iree_status_t iree_hal_rocm_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_const_byte_span_t initial_data, iree_hal_buffer_t** out_buffer) {
+  iree_hal_rocm_allocator_t* allocator =
+      iree_hal_rocm_allocator_cast(base_allocator);
+  // Guard against the corner case where the requested buffer size is 0. The
+  // application is unlikely to do anything when requesting a 0-byte buffer; but
+  // it can happen in real world use cases. So we should at least not crash.
+  if (allocation_size == 0) allocation_size = 4;
+
+  // Cacheable allocations are rounded up to their size class so that the
+  // memory can be reused by any other allocation in the same class once freed.
+  iree_hal_rocm_cache_heap_t cache_heap = IREE_HAL_ROCM_CACHE_HEAP_DEVICE;
+  iree_hal_allocation_cache_class_t size_class = {
+      .index = 0,
+      .size = allocation_size,
+  };
+  const bool cacheable =
+      iree_hal_rocm_cache_heap(memory_type, &cache_heap) &&
+      iree_hal_allocation_cache_lookup_class(&allocator->cache,
+                                             allocation_size, &size_class);
+  const iree_device_size_t class_size = size_class.size;
+
+  iree_status_t status = iree_ok_status();
+  void* host_ptr = NULL;
+  hipDeviceptr_t device_ptr = 0;
+  iree_hal_cached_allocation_t cached_allocation;
+  if (cacheable && iree_hal_allocation_cache_acquire(
+                       &allocator->cache, cache_heap, &size_class,
+                       &cached_allocation)) {
+    device_ptr = (hipDeviceptr_t)(uintptr_t)cached_allocation.device_ptr;
+    host_ptr = cached_allocation.host_ptr;
+  } else {
+    hipError_t result = iree_hal_rocm_buffer_allocate(
+        allocator, memory_type, class_size, &device_ptr, &host_ptr);
+    if (result == hipErrorOutOfMemory) {
+      // Cached blocks of other size classes may be what is keeping us from
+      // allocating; return them to HIP and try once more.
+      iree_hal_allocation_cache_trim(&allocator->cache);
+      result = iree_hal_rocm_buffer_allocate(allocator, memory_type, class_size,
+                                             &device_ptr, &host_ptr);
     }
+    status = iree_hal_rocm_result_to_status(allocator->context->syms, result,
+                                            __FILE__, __LINE__);
   }
 
   iree_hal_buffer_t* buffer = NULL;
@@ -195,8 +340,10 @@ static iree_status_t iree_hal_rocm_allocator_allocate_buffer(
     *out_buffer = buffer;
   } else {
     if (!buffer) {
-      iree_hal_rocm_buffer_free(allocator->context, memory_type, device_ptr,
-                                host_ptr);
+      if (device_ptr || host_ptr) {
+        iree_hal_rocm_allocator_release_memory(
+            allocator, memory_type, allocation_size, device_ptr, host_ptr);
+      }
     } else {
       iree_hal_buffer_release(buffer);
     }
@@ -210,9 +357,10 @@ static void iree_hal_rocm_allocator_deallocate_buffer(
       iree_hal_rocm_allocator_cast(base_allocator);
 
   iree_hal_memory_type_t memory_type = iree_hal_buffer_memory_type(base_buffer);
-  iree_hal_rocm_buffer_free(allocator->context, memory_type,
-                            iree_hal_rocm_buffer_device_pointer(base_buffer),
-                            iree_hal_rocm_buffer_host_pointer(base_buffer));
+  iree_hal_rocm_allocator_release_memory(
+      allocator, memory_type, iree_hal_buffer_allocation_size(base_buffer),
+      iree_hal_rocm_buffer_device_pointer(base_buffer),
+      iree_hal_rocm_buffer_host_pointer(base_buffer));
 
   IREE_STATISTICS(iree_hal_allocator_statistics_record_free(
       &allocator->statistics, memory_type,
@@ -17,9 +17,12 @@ extern "C" {
 #endif  // __cplusplus
 
 // Create a ROCM allocator.
+// Up to |cache_limit| bytes of freed device-only and pinned host allocations
+// are retained for reuse by later allocations of a similar size; 0 disables
+// caching. Buffers must not be in use by the device when they are freed.
 iree_status_t iree_hal_rocm_allocator_create(
     iree_hal_device_t* base_device, iree_hal_rocm_context_wrapper_t* context,
-    iree_hal_allocator_t** out_allocator);
+    iree_device_size_t cache_limit, iree_hal_allocator_t** out_allocator);
 
 #ifdef __cplusplus
 }  // extern "C"
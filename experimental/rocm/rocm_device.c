@@ -20,10 +20,115 @@
 #include "experimental/rocm/rocm_allocator.h"
 #include "experimental/rocm/rocm_event.h"
 #include "experimental/rocm/status_util.h"
+#include "experimental/rocm/graph_command_buffer.h"
 #include "iree/base/internal/arena.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/utils/buffer_transfer.h"
 
+// Maximum total size of freed allocations retained by the device allocator
+// for reuse.
+#define IREE_HAL_ROCM_ALLOCATION_CACHE_LIMIT (256 * 1024 * 1024)
+
+//===----------------------------------------------------------------------===//
+// iree_hal_rocm_deferred_submission_t
+//===----------------------------------------------------------------------===//
+
+// A submission batch that could not be issued to the stream at the time it
+// was submitted as one or more of its waits had no device signal enqueued yet.
+// Retains all semaphores and command buffers referenced by the batch.
+typedef struct iree_hal_rocm_deferred_submission_t {
+  struct iree_hal_rocm_deferred_submission_t* next;
+  // Copy of the batch with lists pointing into the trailing storage.
+  iree_hal_submission_batch_t batch;
+  // Status of the submission once it has been retired from the queue. If not
+  // OK the signal semaphores are failed with it.
+  iree_status_t status;
+} iree_hal_rocm_deferred_submission_t;
+
+static iree_status_t iree_hal_rocm_deferred_submission_create(
+    const iree_hal_submission_batch_t* batch, iree_allocator_t host_allocator,
+    iree_hal_rocm_deferred_submission_t** out_submission) {
+  *out_submission = NULL;
+  const iree_hal_semaphore_list_t* wait_list = &batch->wait_semaphores;
+  const iree_hal_semaphore_list_t* signal_list = &batch->signal_semaphores;
+  const iree_host_size_t value_count = wait_list->count + signal_list->count;
+  const iree_host_size_t pointer_count =
+      value_count + batch->command_buffer_count;
+
+  iree_hal_rocm_deferred_submission_t* submission = NULL;
+  iree_host_size_t total_size = iree_sizeof_struct(*submission) +
+                                value_count * sizeof(uint64_t) +
+                                pointer_count * sizeof(void*);
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(host_allocator, total_size, (void**)&submission));
+  submission->next = NULL;
+  submission->status = iree_ok_status();
+
+  // Values first to keep them 8-byte aligned followed by the pointers.
+  uint8_t* storage = (uint8_t*)submission + iree_sizeof_struct(*submission);
+  uint64_t* wait_values = (uint64_t*)storage;
+  uint64_t* signal_values = wait_values + wait_list->count;
+  iree_hal_semaphore_t** wait_semaphores =
+      (iree_hal_semaphore_t**)(signal_values + signal_list->count);
+  iree_hal_semaphore_t** signal_semaphores =
+      wait_semaphores + wait_list->count;
+  iree_hal_command_buffer_t** command_buffers =
+      (iree_hal_command_buffer_t**)(signal_semaphores + signal_list->count);
+
+  for (iree_host_size_t i = 0; i < wait_list->count; ++i) {
+    wait_semaphores[i] = wait_list->semaphores[i];
+    wait_values[i] = wait_list->payload_values[i];
+    iree_hal_semaphore_retain(wait_semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < signal_list->count; ++i) {
+    signal_semaphores[i] = signal_list->semaphores[i];
+    signal_values[i] = signal_list->payload_values[i];
+    iree_hal_semaphore_retain(signal_semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < batch->command_buffer_count; ++i) {
+    command_buffers[i] = batch->command_buffers[i];
+    iree_hal_command_buffer_retain(command_buffers[i]);
+  }
+
+  submission->batch.wait_semaphores.count = wait_list->count;
+  submission->batch.wait_semaphores.semaphores = wait_semaphores;
+  submission->batch.wait_semaphores.payload_values = wait_values;
+  submission->batch.command_buffer_count = batch->command_buffer_count;
+  submission->batch.command_buffers = command_buffers;
+  submission->batch.signal_semaphores.count = signal_list->count;
+  submission->batch.signal_semaphores.semaphores = signal_semaphores;
+  submission->batch.signal_semaphores.payload_values = signal_values;
+
+  *out_submission = submission;
+  return iree_ok_status();
+}
+
+// Fails the signal semaphores of |submission| if it did not complete
+// successfully and releases all of its resources.
+static void iree_hal_rocm_deferred_submission_retire(
+    iree_hal_rocm_deferred_submission_t* submission,
+    iree_allocator_t host_allocator) {
+  const iree_hal_submission_batch_t* batch = &submission->batch;
+  if (!iree_status_is_ok(submission->status)) {
+    for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+      iree_hal_semaphore_fail(batch->signal_semaphores.semaphores[i],
+                              iree_status_clone(submission->status));
+    }
+    iree_status_free(submission->status);
+  }
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    iree_hal_semaphore_release(batch->wait_semaphores.semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+    iree_hal_semaphore_release(batch->signal_semaphores.semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < batch->command_buffer_count; ++i) {
+    iree_hal_command_buffer_release(batch->command_buffers[i]);
+  }
+  iree_allocator_free(host_allocator, submission);
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_rocm_device_t
 //===----------------------------------------------------------------------===//
@@ -47,6 +152,17 @@ typedef struct iree_hal_rocm_device_t {
   iree_hal_rocm_context_wrapper_t context_wrapper;
   iree_hal_allocator_t* device_allocator;
 
+  // Shared by all semaphores created by the device; notifies host waiters and
+  // flushes deferred submissions when semaphores are signaled from the host.
+  iree_hal_rocm_semaphore_state_t semaphore_state;
+
+  // Guards issuing work to |stream| and the deferred submission queue.
+  iree_slim_mutex_t submission_mutex;
+  // FIFO of submissions waiting on semaphores that have no device signal
+  // enqueued yet. Submissions are issued in order so once any submission is
+  // deferred all subsequent ones are as well.
+  iree_hal_rocm_deferred_submission_t* deferred_head;
+  iree_hal_rocm_deferred_submission_t* deferred_tail;
 } iree_hal_rocm_device_t;
 
 static const iree_hal_device_vtable_t iree_hal_rocm_device_vtable;
@@ -62,8 +178,25 @@ static void iree_hal_rocm_device_destroy(iree_hal_device_t* base_device) {
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Submissions that never became ready are dropped; their signal semaphores
+  // are left unsignaled.
+  iree_hal_rocm_deferred_submission_t* submission = device->deferred_head;
+  while (submission) {
+    iree_hal_rocm_deferred_submission_t* next = submission->next;
+    iree_hal_rocm_deferred_submission_retire(submission, host_allocator);
+    submission = next;
+  }
+  device->deferred_head = device->deferred_tail = NULL;
+  iree_slim_mutex_deinitialize(&device->submission_mutex);
+
   // There should be no more buffers live that use the allocator.
   iree_hal_allocator_release(device->device_allocator);
+
+  // All arena blocks should have been returned.
+  iree_arena_block_pool_deinitialize(&device->block_pool);
+
+  iree_hal_rocm_semaphore_state_deinitialize(&device->semaphore_state);
+
   ROCM_IGNORE_ERROR(device->context_wrapper.syms,
                     hipStreamDestroy(device->stream));
 
@@ -75,6 +208,8 @@ static void iree_hal_rocm_device_destroy(iree_hal_device_t* base_device) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+static void iree_hal_rocm_device_flush_deferred_submissions(void* user_data);
+
 static iree_status_t iree_hal_rocm_device_create_internal(
     iree_hal_driver_t* driver, iree_string_view_t identifier,
     hipDevice_t rocm_device, hipStream_t stream, hipCtx_t context,
@@ -96,9 +231,18 @@ static iree_status_t iree_hal_rocm_device_create_internal(
   device->context_wrapper.rocm_context = context;
   device->context_wrapper.host_allocator = host_allocator;
   device->context_wrapper.syms = syms;
+  iree_arena_block_pool_initialize(32 * 1024, host_allocator,
+                                   &device->block_pool);
+  iree_hal_rocm_semaphore_callback_t host_signal_callback = {
+      .fn = iree_hal_rocm_device_flush_deferred_submissions,
+      .user_data = device,
+  };
+  iree_hal_rocm_semaphore_state_initialize(host_signal_callback,
+                                           &device->semaphore_state);
+  iree_slim_mutex_initialize(&device->submission_mutex);
   iree_status_t status = iree_hal_rocm_allocator_create(
       (iree_hal_device_t*)device, &device->context_wrapper,
-      &device->device_allocator);
+      IREE_HAL_ROCM_ALLOCATION_CACHE_LIMIT, &device->device_allocator);
   if (iree_status_is_ok(status)) {
     *out_device = (iree_hal_device_t*)device;
   } else {
@@ -187,7 +331,18 @@ static iree_status_t iree_hal_rocm_device_create_command_buffer(
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_command_buffer_t** out_command_buffer) {
   iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
-  return iree_hal_rocm_direct_command_buffer_create(
+  if (iree_all_bits_set(mode,
+                        IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION)) {
+    // The caller has indicated the command buffer can be executed as it is
+    // recorded, implying that the command buffer cannot be reused and doesn't
+    // need to be persisted. This lets us lower the execution delay as we can
+    // directly route commands to the HIP stream and let it eagerly flush.
+    return iree_hal_rocm_direct_command_buffer_create(
+        base_device, &device->context_wrapper, mode, command_categories,
+        queue_affinity, device->stream, &device->block_pool,
+        out_command_buffer);
+  }
+  return iree_hal_rocm_graph_command_buffer_create(
       base_device, &device->context_wrapper, mode, command_categories,
       queue_affinity, &device->block_pool, out_command_buffer);
 }
@@ -243,24 +398,140 @@ static iree_status_t iree_hal_rocm_device_create_semaphore(
     iree_hal_device_t* base_device, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore) {
   iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
-  return iree_hal_rocm_semaphore_create(&device->context_wrapper, initial_value,
+  return iree_hal_rocm_semaphore_create(&device->context_wrapper,
+                                        &device->semaphore_state, initial_value,
                                         out_semaphore);
 }
 
+// Returns true in |out_is_ready| if all waits of |batch| can be enqueued on
+// the stream. Returns IREE_STATUS_ABORTED if any wait semaphore has failed.
+static iree_status_t iree_hal_rocm_device_is_batch_ready(
+    const iree_hal_submission_batch_t* batch, bool* out_is_ready) {
+  *out_is_ready = true;
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    bool is_ready = false;
+    IREE_RETURN_IF_ERROR(iree_hal_rocm_semaphore_is_wait_ready(
+        batch->wait_semaphores.semaphores[i],
+        batch->wait_semaphores.payload_values[i], &is_ready));
+    if (!is_ready) {
+      *out_is_ready = false;
+      break;
+    }
+  }
+  return iree_ok_status();
+}
+
+// Enqueues the waits, command buffers, and signals of |batch| on the device
+// stream. The batch must be ready as reported by
+// iree_hal_rocm_device_is_batch_ready and the submission mutex must be held.
+static iree_status_t iree_hal_rocm_device_issue_batch(
+    iree_hal_rocm_device_t* device, const iree_hal_submission_batch_t* batch) {
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_rocm_semaphore_enqueue_wait(
+        batch->wait_semaphores.semaphores[i], device->stream,
+        batch->wait_semaphores.payload_values[i]));
+  }
+  for (iree_host_size_t i = 0; i < batch->command_buffer_count; ++i) {
+    iree_hal_command_buffer_t* command_buffer = batch->command_buffers[i];
+    if (iree_hal_rocm_graph_command_buffer_isa(command_buffer)) {
+      hipGraphExec_t exec =
+          iree_hal_rocm_graph_command_buffer_exec(command_buffer);
+      ROCM_RETURN_IF_ERROR(device->context_wrapper.syms,
+                           hipGraphLaunch(exec, device->stream),
+                           "hipGraphLaunch");
+    }
+    // Nothing to do for direct command buffers; all the work has already been
+    // issued to the stream as it was recorded.
+  }
+  for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_rocm_semaphore_enqueue_signal(
+        batch->signal_semaphores.semaphores[i], device->stream,
+        batch->signal_semaphores.payload_values[i]));
+  }
+  return iree_ok_status();
+}
+
+// Issues the deferred submissions in order until one is found that is not yet
+// ready. Called by semaphores after they are signaled or failed from the host.
+static void iree_hal_rocm_device_flush_deferred_submissions(void* user_data) {
+  iree_hal_rocm_device_t* device = (iree_hal_rocm_device_t*)user_data;
+  // Submissions are popped under the lock but retired outside of it as
+  // failing signal semaphores calls back into the device.
+  iree_hal_rocm_deferred_submission_t* retired_head = NULL;
+  iree_hal_rocm_deferred_submission_t* retired_tail = NULL;
+  iree_slim_mutex_lock(&device->submission_mutex);
+  while (device->deferred_head) {
+    iree_hal_rocm_deferred_submission_t* submission = device->deferred_head;
+    bool is_ready = false;
+    submission->status =
+        iree_hal_rocm_device_is_batch_ready(&submission->batch, &is_ready);
+    if (iree_status_is_ok(submission->status)) {
+      if (!is_ready) break;
+      submission->status =
+          iree_hal_rocm_device_issue_batch(device, &submission->batch);
+    }
+    device->deferred_head = submission->next;
+    if (!device->deferred_head) device->deferred_tail = NULL;
+    submission->next = NULL;
+    if (retired_tail) {
+      retired_tail->next = submission;
+    } else {
+      retired_head = submission;
+    }
+    retired_tail = submission;
+  }
+  iree_slim_mutex_unlock(&device->submission_mutex);
+
+  while (retired_head) {
+    iree_hal_rocm_deferred_submission_t* next = retired_head->next;
+    iree_hal_rocm_deferred_submission_retire(
+        retired_head, device->context_wrapper.host_allocator);
+    retired_head = next;
+  }
+}
+
 static iree_status_t iree_hal_rocm_device_queue_submit(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
     const iree_hal_submission_batch_t* batches) {
   iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
-  // TODO(raikonenfnu): Once semaphore is implemented wait for semaphores
-  // TODO(thomasraoux): implement semaphores - for now this conservatively
-  // synchronizes after every submit.
-  // TODO(raikonenfnu): currently run on default/null stream, when cmd buffer
-  // stream work with device->stream, we'll change
-  ROCM_RETURN_IF_ERROR(device->context_wrapper.syms, hipStreamSynchronize(0),
-                       "hipStreamSynchronize");
-  return iree_ok_status();
+  iree_allocator_t host_allocator = device->context_wrapper.host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Batches are issued directly to the stream when all of their waits have
+  // device signals enqueued (or are already reached). Otherwise they are
+  // deferred until host signals make them ready; any batches submitted after
+  // must be deferred as well to preserve submission order.
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&device->submission_mutex);
+  for (iree_host_size_t i = 0; i < batch_count && iree_status_is_ok(status);
+       ++i) {
+    bool is_ready = false;
+    if (!device->deferred_head) {
+      status = iree_hal_rocm_device_is_batch_ready(&batches[i], &is_ready);
+    }
+    if (!iree_status_is_ok(status)) break;
+    if (is_ready) {
+      status = iree_hal_rocm_device_issue_batch(device, &batches[i]);
+      continue;
+    }
+    iree_hal_rocm_deferred_submission_t* submission = NULL;
+    status = iree_hal_rocm_deferred_submission_create(
+        &batches[i], host_allocator, &submission);
+    if (iree_status_is_ok(status)) {
+      if (device->deferred_tail) {
+        device->deferred_tail->next = submission;
+      } else {
+        device->deferred_head = submission;
+      }
+      device->deferred_tail = submission;
+    }
+  }
+  iree_slim_mutex_unlock(&device->submission_mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 static iree_status_t iree_hal_rocm_device_submit_and_wait(
@@ -281,8 +552,9 @@ static iree_status_t iree_hal_rocm_device_submit_and_wait(
 static iree_status_t iree_hal_rocm_device_wait_semaphores(
     iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "semaphore not implemented");
+  iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
+  return iree_hal_rocm_semaphore_multi_wait(&device->semaphore_state,
+                                            wait_mode, semaphore_list, timeout);
 }
 
 static iree_status_t iree_hal_rocm_device_wait_idle(
@@ -48,6 +48,14 @@ ${TRANSLATE_TOOL?} ${INPUT_PATH} \
   --iree-llvm-link-embedded=false \
   --o ${BINARY_DIR}/${INPUT_NAME}.vmfb
 
+# The same program compiled for the experimental WebGPU HAL driver. Only used
+# by the web-sample-dynamic-webgpu variant (see iree_worker.js).
+${TRANSLATE_TOOL?} ${INPUT_PATH} \
+  --iree-mlir-to-vm-bytecode-module \
+  --iree-input-type=mhlo \
+  --iree-hal-target-backends=webgpu \
+  --o ${BINARY_DIR}/${INPUT_NAME}_webgpu.vmfb
+
 ###############################################################################
 # Build the web artifacts using Emscripten                                    #
 ###############################################################################
@@ -63,11 +71,13 @@ emcmake "${CMAKE_BIN?}" -G Ninja .. \
   -DIREE_HOST_BINARY_ROOT=$PWD/../build-host/install \
   -DIREE_BUILD_EXPERIMENTAL_WEB_SAMPLES=ON \
   -DIREE_HAL_DRIVER_DEFAULTS=OFF \
+  -DIREE_HAL_DRIVER_EXPERIMENTAL_WEBGPU=ON \
   -DIREE_BUILD_COMPILER=OFF \
   -DIREE_BUILD_TESTS=OFF
 
 "${CMAKE_BIN?}" --build . --target \
-  iree_experimental_web_sample_dynamic_sync
+  iree_experimental_web_sample_dynamic_sync \
+  iree_experimental_web_sample_dynamic_webgpu
 
 popd
 
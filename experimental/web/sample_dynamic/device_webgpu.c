@@ -0,0 +1,24 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <emscripten/html5_webgpu.h>
+
+#include "experimental/webgpu/api.h"
+
+// NOTE: named to match the other device variants; programs for this device
+// are compiled for WebGPU and need no executable loader.
+iree_status_t create_device_with_wasm_loader(iree_allocator_t host_allocator,
+                                             iree_hal_device_t** out_device) {
+  // The device is requested by iree_worker.js before the module is loaded and
+  // handed over as Module.preinitializedWebGPUDevice.
+  WGPUDevice handle = emscripten_webgpu_get_device();
+  if (!handle) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "no WebGPU device was provided to the module");
+  }
+  return iree_hal_webgpu_device_create(iree_make_cstring_view("webgpu"),
+                                       handle, host_allocator, out_device);
+}
@@ -6,7 +6,9 @@
 
 // TODO(scotttodd): configure this through the build system / scripts?
 // const MAIN_SCRIPT_URL = 'web-sample-dynamic-multithreaded.js';
+// const MAIN_SCRIPT_URL = 'web-sample-dynamic-webgpu.js';
 const MAIN_SCRIPT_URL = 'web-sample-dynamic-sync.js';
+const USE_WEBGPU = MAIN_SCRIPT_URL.includes('webgpu');
 
 let wasmLoadProgramFn;
 var Module = {
@@ -19,8 +21,11 @@ var Module = {
   onRuntimeInitialized: function() {
     console.log('WebAssembly module onRuntimeInitialized()');
 
+    // The WebGPU module is built with ASYNCIFY and waits for GPU work by
+    // yielding to the event loop, so calls into it return Promises.
     wasmLoadProgramFn =
-        Module.cwrap('load_program', 'number', ['number', 'number']);
+        Module.cwrap('load_program', 'number', ['number', 'number'],
+                     {async: USE_WEBGPU});
 
     postMessage({
       'messageType': 'initialized',
@@ -44,24 +49,27 @@ function loadProgram(id, vmfbPath) {
         programDataView.length * programDataView.BYTES_PER_ELEMENT);
     Module.HEAP8.set(programDataView, programDataWasmBuffer);
 
-    const result =
-        wasmLoadProgramFn(programDataWasmBuffer, programDataBuffer.byteLength);
-    console.log('Result from loadProgramFn():', result);
-    Module._free(programDataWasmBuffer);
-
-    if (result !== 0) {
-      postMessage({
-        'messageType': 'loadProgramResult',
-        'id': id,
-        'error': 'Wasm module error, check console for details',
-      });
-    } else {
-      postMessage({
-        'messageType': 'loadProgramResult',
-        'id': id,
-        'payload': 'success',
-      });
-    }
+    Promise
+        .resolve(wasmLoadProgramFn(
+            programDataWasmBuffer, programDataBuffer.byteLength))
+        .then((result) => {
+          console.log('Result from loadProgramFn():', result);
+          Module._free(programDataWasmBuffer);
+
+          if (result !== 0) {
+            postMessage({
+              'messageType': 'loadProgramResult',
+              'id': id,
+              'error': 'Wasm module error, check console for details',
+            });
+          } else {
+            postMessage({
+              'messageType': 'loadProgramResult',
+              'id': id,
+              'payload': 'success',
+            });
+          }
+        });
   };
 
   fetchRequest.open('GET', vmfbPath);
@@ -79,4 +87,28 @@ self.onmessage = function(messageEvent) {
   }
 };
 
-importScripts(MAIN_SCRIPT_URL);
+// The WebGPU device can only be requested asynchronously so it is acquired
+// before the module loads and handed over through
+// Module.preinitializedWebGPUDevice (see emscripten_webgpu_get_device()).
+async function initializeWebGPU() {
+  if (!navigator.gpu) {
+    throw new Error('WebGPU is not supported by this browser');
+  }
+  const adapter = await navigator.gpu.requestAdapter();
+  if (!adapter) {
+    throw new Error('no WebGPU adapter available');
+  }
+  Module.preinitializedWebGPUDevice = await adapter.requestDevice();
+}
+
+if (USE_WEBGPU) {
+  initializeWebGPU()
+      .then(() => {
+        importScripts(MAIN_SCRIPT_URL);
+      })
+      .catch((error) => {
+        console.error('WebGPU initialization failed:', error);
+      });
+} else {
+  importScripts(MAIN_SCRIPT_URL);
+}
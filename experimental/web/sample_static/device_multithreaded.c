@@ -11,6 +11,13 @@
 #include "iree/task/api.h"
 #include "mnist_static.h"
 
+// Upper bound on the number of worker threads created by the task executor.
+// Each worker is a Web Worker with its own stack and instance of the module so
+// this trades off memory and startup latency with throughput.
+#if !defined(IREE_SAMPLE_MAX_WORKER_COUNT)
+#define IREE_SAMPLE_MAX_WORKER_COUNT 4
+#endif  // !IREE_SAMPLE_MAX_WORKER_COUNT
+
 iree_status_t create_device_with_static_loader(iree_allocator_t host_allocator,
                                                iree_hal_device_t** out_device) {
   iree_hal_task_device_params_t params;
@@ -20,7 +27,7 @@ iree_status_t create_device_with_static_loader(iree_allocator_t host_allocator,
   const iree_hal_executable_library_header_t** static_library =
       mnist_linked_llvm_library_query(
           IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
-          /*reserved=*/NULL);
+          /*environment=*/NULL);
   const iree_hal_executable_library_header_t** libraries[1] = {static_library};
 
   iree_hal_executable_loader_t* library_loader = NULL;
@@ -31,20 +38,22 @@ iree_status_t create_device_with_static_loader(iree_allocator_t host_allocator,
 
   // Create a task executor.
   iree_task_executor_t* executor = NULL;
-  iree_task_scheduling_mode_t scheduling_mode = 0;
-  iree_host_size_t worker_local_memory = 0;
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
   iree_task_topology_t topology;
   iree_task_topology_initialize(&topology);
-  iree_task_topology_initialize_from_group_count(
-      /*group_count=*/4, &topology);
+  // Use one worker per logical core (navigator.hardwareConcurrency) up to the
+  // configured maximum. The thread issuing work also blocks while the workers
+  // run so there is no benefit to reserving a core for it.
   // Note: threads increase memory usage. If using a high thread count, consider
   // passing in a larger WebAssembly.Memory object, increasing Emscripten's
   // INITIAL_MEMORY, or setting Emscripten's ALLOW_MEMORY_GROWTH.
-  // iree_task_topology_initialize_from_group_count(
-  //     /*group_count=*/emscripten_num_logical_cores(), &topology);
+  iree_host_size_t group_count = iree_min(
+      (iree_host_size_t)iree_max(1, emscripten_num_logical_cores()),
+      IREE_SAMPLE_MAX_WORKER_COUNT);
+  iree_task_topology_initialize_from_group_count(group_count, &topology);
   if (iree_status_is_ok(status)) {
-    status = iree_task_executor_create(scheduling_mode, &topology,
-                                       worker_local_memory, host_allocator,
+    status = iree_task_executor_create(&options, &topology, host_allocator,
                                        &executor);
   }
   iree_task_topology_deinitialize(&topology);
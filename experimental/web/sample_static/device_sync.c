@@ -17,7 +17,7 @@ iree_status_t create_device_with_static_loader(iree_allocator_t host_allocator,
   const iree_hal_executable_library_header_t** static_library =
       mnist_linked_llvm_library_query(
           IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
-          /*reserved=*/NULL);
+          /*environment=*/NULL);
   const iree_hal_executable_library_header_t** libraries[1] = {static_library};
 
   iree_hal_executable_loader_t* library_loader = NULL;
@@ -28,7 +28,8 @@ function _handleMessageFromWorker(messageEvent) {
   if (messageType == 'initialized') {
     pendingPromises['initialize']['resolve']();
     delete pendingPromises['initialize'];
-  } else if (messageType == 'predictResult') {
+  } else if (messageType == 'predictResult' ||
+             messageType == 'benchmarkResult') {
     if (payload !== undefined) {
       pendingPromises[id]['resolve'](payload);
     } else {
@@ -72,3 +73,28 @@ function ireePredictDigit(imageData) {
     ireeWorker.postMessage(message);
   });
 }
+
+// Benchmarks predicting the digit in a provided image asynchronously.
+// Input: 28x28 pixel data from CanvasRenderingContext2D.getImageData() and the
+//        number of iterations to time (after one warmup iteration)
+// Resolves with the average time per iteration in microseconds on success
+function ireeBenchmarkPredictDigit(imageData, iterationCount) {
+  return new Promise((resolve, reject) => {
+    const messageId = nextMessageId++;
+    const message = {
+      'messageType': 'benchmark',
+      'id': messageId,
+      'payload': {
+        'imageData': imageData,
+        'iterationCount': iterationCount,
+      },
+    };
+
+    pendingPromises[messageId] = {
+      'resolve': resolve,
+      'reject': reject,
+    };
+
+    ireeWorker.postMessage(message);
+  });
+}
@@ -23,6 +23,7 @@ const MAIN_SCRIPT_URL = 'web-sample-static-multithreaded.js';
 let wasmSetupSampleFn;
 let wasmCleanupSampleFn;
 let wasmRunSampleFn;
+let wasmBenchmarkSampleFn;
 let wasmState;
 let initialized = false;
 
@@ -44,6 +45,8 @@ var Module = {
     wasmCleanupSampleFn = Module.cwrap('cleanup_sample', null, ['number']);
     wasmRunSampleFn =
         Module.cwrap('run_sample', 'number', ['number', 'number']);
+    wasmBenchmarkSampleFn = Module.cwrap(
+        'benchmark_sample', 'number', ['number', 'number', 'number']);
 
     initializeSample();
   },
@@ -113,11 +116,35 @@ function handlePredict(id, canvasData) {
   }
 }
 
+function handleBenchmark(id, canvasData, iterationCount) {
+  if (!initialized) return;
+
+  preprocessImageDataIntoHeap(canvasData);
+  const averageUs =
+      wasmBenchmarkSampleFn(wasmState, imageBuffer, iterationCount);
+
+  if (averageUs < 0) {
+    postMessage({
+      'messageType': 'benchmarkResult',
+      'id': id,
+      'error': 'Wasm module error, check console for details',
+    });
+  } else {
+    postMessage({
+      'messageType': 'benchmarkResult',
+      'id': id,
+      'payload': averageUs,
+    });
+  }
+}
+
 self.onmessage = function(messageEvent) {
   const {messageType, id, payload} = messageEvent.data;
 
   if (messageType == 'predict') {
     handlePredict(id, payload);
+  } else if (messageType == 'benchmark') {
+    handleBenchmark(id, payload['imageData'], payload['iterationCount']);
   }
 };
 
@@ -24,6 +24,12 @@ void cleanup_sample(iree_sample_state_t* state);
 
 int run_sample(iree_sample_state_t* state, float* image_data);
 
+// Runs a prediction on |image_data| |iteration_count| times after a warmup
+// iteration and returns the average time per iteration in microseconds.
+// Returns a negative value on failure.
+double benchmark_sample(iree_sample_state_t* state, float* image_data,
+                        int iteration_count);
+
 //===----------------------------------------------------------------------===//
 // Implementation
 //===----------------------------------------------------------------------===//
@@ -112,7 +118,9 @@ void cleanup_sample(iree_sample_state_t* state) {
   free(state);
 }
 
-int run_sample(iree_sample_state_t* state, float* image_data) {
+static iree_status_t invoke_sample(iree_sample_state_t* state,
+                                   float* image_data, float* predictions,
+                                   iree_host_size_t prediction_count) {
   iree_status_t status = iree_ok_status();
 
   iree_runtime_call_reset(&state->call);
@@ -147,16 +155,22 @@ int run_sample(iree_sample_state_t* state, float* image_data) {
                                                              &ret_buffer_view);
   }
 
-  // Read back the results. The output of the mnist model is a 1x10 prediction
-  // confidence values for each digit in [0, 9].
-  float predictions[1 * 10] = {0.0f};
+  // Read back the results.
   if (iree_status_is_ok(status)) {
-    status =
-        iree_hal_buffer_read_data(iree_hal_buffer_view_buffer(ret_buffer_view),
-                                  0, predictions, sizeof(predictions));
+    status = iree_hal_buffer_read_data(
+        iree_hal_buffer_view_buffer(ret_buffer_view), 0, predictions,
+        prediction_count * sizeof(*predictions));
   }
   iree_hal_buffer_view_release(ret_buffer_view);
+  return status;
+}
 
+int run_sample(iree_sample_state_t* state, float* image_data) {
+  // The output of the mnist model is a 1x10 prediction confidence values for
+  // each digit in [0, 9].
+  float predictions[1 * 10] = {0.0f};
+  iree_status_t status = invoke_sample(state, image_data, predictions,
+                                       IREE_ARRAYSIZE(predictions));
   if (!iree_status_is_ok(status)) {
     iree_status_fprint(stderr, status);
     iree_status_free(status);
@@ -180,3 +194,34 @@ int run_sample(iree_sample_state_t* state, float* image_data) {
           predictions[7], predictions[8], predictions[9]);
   return result_idx;
 }
+
+double benchmark_sample(iree_sample_state_t* state, float* image_data,
+                        int iteration_count) {
+  float predictions[1 * 10] = {0.0f};
+
+  // Warmup to exclude one-time costs like executable loading and worker
+  // thread startup from the measurement.
+  iree_status_t status = invoke_sample(state, image_data, predictions,
+                                       IREE_ARRAYSIZE(predictions));
+
+  iree_time_t start_ns = iree_time_now();
+  for (int i = 0; i < iteration_count && iree_status_is_ok(status); ++i) {
+    status = invoke_sample(state, image_data, predictions,
+                           IREE_ARRAYSIZE(predictions));
+  }
+  iree_time_t end_ns = iree_time_now();
+
+  if (!iree_status_is_ok(status)) {
+    iree_status_fprint(stderr, status);
+    iree_status_free(status);
+    return -1.0;
+  }
+
+  double average_us =
+      iteration_count > 0
+          ? (double)(end_ns - start_ns) / 1000.0 / (double)iteration_count
+          : 0.0;
+  fprintf(stdout, "Benchmark: %d iterations, %.3f us/iteration\n",
+          iteration_count, average_us);
+  return average_us;
+}
@@ -0,0 +1,252 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/allocator.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "experimental/webgpu/buffer.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+// WebGPU requires buffer sizes and write ranges to be 4 byte aligned.
+#define IREE_HAL_WEBGPU_BUFFER_ALIGNMENT 4
+
+typedef struct iree_hal_webgpu_allocator_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  WGPUDevice device;
+
+  IREE_STATISTICS(iree_hal_allocator_statistics_t statistics;)
+} iree_hal_webgpu_allocator_t;
+
+static const iree_hal_allocator_vtable_t iree_hal_webgpu_allocator_vtable;
+
+static iree_hal_webgpu_allocator_t* iree_hal_webgpu_allocator_cast(
+    iree_hal_allocator_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_allocator_vtable);
+  return (iree_hal_webgpu_allocator_t*)base_value;
+}
+
+iree_status_t iree_hal_webgpu_allocator_create(
+    WGPUDevice device, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_allocator_t* allocator = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*allocator), (void**)&allocator);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_webgpu_allocator_vtable,
+                                 &allocator->resource);
+    allocator->host_allocator = host_allocator;
+    allocator->device = device;
+    *out_allocator = (iree_hal_allocator_t*)allocator;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_allocator_destroy(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_webgpu_allocator_t* allocator =
+      iree_hal_webgpu_allocator_cast(base_allocator);
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_allocator_t iree_hal_webgpu_allocator_host_allocator(
+    const iree_hal_allocator_t* base_allocator) {
+  iree_hal_webgpu_allocator_t* allocator =
+      (iree_hal_webgpu_allocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_status_t iree_hal_webgpu_allocator_trim(
+    iree_hal_allocator_t* base_allocator) {
+  return iree_ok_status();
+}
+
+static void iree_hal_webgpu_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  IREE_STATISTICS({
+    iree_hal_webgpu_allocator_t* allocator =
+        iree_hal_webgpu_allocator_cast(base_allocator);
+    memcpy(out_statistics, &allocator->statistics, sizeof(*out_statistics));
+  });
+}
+
+static iree_hal_buffer_compatibility_t
+iree_hal_webgpu_allocator_query_buffer_compatibility(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_buffer_usage_t intended_usage,
+    iree_device_size_t allocation_size) {
+  // Disallow usage not permitted by the buffer itself. Since we then use this
+  // to determine compatibility below we'll naturally set the right compat flags
+  // based on what's both allowed and intended.
+  intended_usage &= allowed_usage;
+
+  // All buffers are allocated from the device. Host-visible memory types are
+  // emulated by staging.
+  iree_hal_buffer_compatibility_t compatibility =
+      IREE_HAL_BUFFER_COMPATIBILITY_ALLOCATABLE;
+
+  // Buffers can only be used on the queue if they are device visible.
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE)) {
+    if (iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
+      compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_TRANSFER;
+    }
+    if (iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
+      compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_DISPATCH;
+    }
+  }
+
+  return compatibility;
+}
+
+static iree_status_t iree_hal_webgpu_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_const_byte_span_t initial_data, iree_hal_buffer_t** out_buffer) {
+  iree_hal_webgpu_allocator_t* allocator =
+      iree_hal_webgpu_allocator_cast(base_allocator);
+
+  // Every buffer is device-local and host access is emulated with staging
+  // copies that work on any buffer. The host uses mapping to read and write
+  // buffer contents so it is always allowed.
+  memory_type |= IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+  allowed_usage |=
+      IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING;
+  const iree_device_size_t aligned_size =
+      iree_device_align(allocation_size, IREE_HAL_WEBGPU_BUFFER_ALIGNMENT);
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)aligned_size);
+
+  const WGPUBufferDescriptor descriptor = {
+      .nextInChain = NULL,
+      .label = NULL,
+      .usage = WGPUBufferUsage_Storage | WGPUBufferUsage_Uniform |
+               WGPUBufferUsage_Indirect | WGPUBufferUsage_CopySrc |
+               WGPUBufferUsage_CopyDst,
+      .size = aligned_size,
+      .mappedAtCreation = false,
+  };
+  WGPUBuffer handle = wgpuDeviceCreateBuffer(allocator->device, &descriptor);
+  if (!handle) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "unable to allocate a %" PRIdsz " byte buffer",
+                            aligned_size);
+  }
+
+  iree_hal_buffer_t* buffer = NULL;
+  iree_status_t status = iree_hal_webgpu_buffer_wrap(
+      base_allocator, allocator->device, memory_type,
+      IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage, aligned_size,
+      /*byte_offset=*/0, /*byte_length=*/allocation_size, handle, &buffer);
+  if (!iree_status_is_ok(status)) {
+    wgpuBufferRelease(handle);
+  }
+
+  // Initial data is uploaded on the queue ahead of any work that could use the
+  // buffer. The tail of the last word is padded with zeros.
+  if (iree_status_is_ok(status) &&
+      !iree_const_byte_span_is_empty(initial_data)) {
+    WGPUQueue queue = wgpuDeviceGetQueue(allocator->device);
+    const iree_host_size_t aligned_length = (iree_host_size_t)iree_device_align(
+        initial_data.data_length, IREE_HAL_WEBGPU_BUFFER_ALIGNMENT);
+    if (aligned_length == initial_data.data_length) {
+      wgpuQueueWriteBuffer(queue, handle, 0, initial_data.data,
+                           initial_data.data_length);
+    } else {
+      uint8_t* padded_data = NULL;
+      status = iree_allocator_malloc(allocator->host_allocator, aligned_length,
+                                     (void**)&padded_data);
+      if (iree_status_is_ok(status)) {
+        memcpy(padded_data, initial_data.data, initial_data.data_length);
+        memset(padded_data + initial_data.data_length, 0,
+               aligned_length - initial_data.data_length);
+        wgpuQueueWriteBuffer(queue, handle, 0, padded_data, aligned_length);
+        iree_allocator_free(allocator->host_allocator, padded_data);
+      }
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    IREE_STATISTICS(iree_hal_allocator_statistics_record_alloc(
+        &allocator->statistics, memory_type, aligned_size));
+    *out_buffer = buffer;
+  } else if (buffer) {
+    iree_hal_buffer_release(buffer);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_allocator_deallocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* base_buffer) {
+  IREE_STATISTICS({
+    iree_hal_webgpu_allocator_t* allocator =
+        iree_hal_webgpu_allocator_cast(base_allocator);
+    iree_hal_allocator_statistics_record_free(
+        &allocator->statistics, iree_hal_buffer_memory_type(base_buffer),
+        iree_hal_buffer_allocation_size(base_buffer));
+  });
+  iree_hal_buffer_destroy(base_buffer);
+}
+
+static iree_status_t iree_hal_webgpu_allocator_wrap_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "wrapping of external buffers not supported");
+}
+
+static iree_status_t iree_hal_webgpu_allocator_import_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_external_buffer_t* external_buffer,
+    iree_hal_buffer_t** out_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "importing from external buffers not supported");
+}
+
+static iree_status_t iree_hal_webgpu_allocator_export_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer,
+    iree_hal_external_buffer_type_t requested_type,
+    iree_hal_external_buffer_flags_t requested_flags,
+    iree_hal_external_buffer_t* out_external_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "exporting to external buffers not supported");
+}
+
+static const iree_hal_allocator_vtable_t iree_hal_webgpu_allocator_vtable = {
+    .destroy = iree_hal_webgpu_allocator_destroy,
+    .host_allocator = iree_hal_webgpu_allocator_host_allocator,
+    .trim = iree_hal_webgpu_allocator_trim,
+    .query_statistics = iree_hal_webgpu_allocator_query_statistics,
+    .query_buffer_compatibility =
+        iree_hal_webgpu_allocator_query_buffer_compatibility,
+    .allocate_buffer = iree_hal_webgpu_allocator_allocate_buffer,
+    .deallocate_buffer = iree_hal_webgpu_allocator_deallocate_buffer,
+    .wrap_buffer = iree_hal_webgpu_allocator_wrap_buffer,
+    .import_buffer = iree_hal_webgpu_allocator_import_buffer,
+    .export_buffer = iree_hal_webgpu_allocator_export_buffer,
+};
@@ -0,0 +1,41 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// See iree/base/api.h for documentation on the API conventions used.
+
+#ifndef IREE_HAL_WEBGPU_API_H_
+#define IREE_HAL_WEBGPU_API_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_webgpu_device_t
+//===----------------------------------------------------------------------===//
+
+// Creates a HAL device wrapping an existing WGPUDevice.
+// WebGPU adapters and devices can only be requested asynchronously and on the
+// web are usually acquired by the hosting page ahead of time (such as with
+// emscripten_webgpu_get_device) so there is no driver to enumerate them.
+//
+// The device must only be used from the thread owning |handle|. Waits pump the
+// WebGPU event loop; see experimental/webgpu/platform.h.
+//
+// |out_device| must be released by the caller (see |iree_hal_device_release|).
+IREE_API_EXPORT iree_status_t iree_hal_webgpu_device_create(
+    iree_string_view_t identifier, WGPUDevice handle,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_API_H_
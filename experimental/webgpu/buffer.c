@@ -0,0 +1,242 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/buffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "experimental/webgpu/platform.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+// WebGPU requires copy and write offsets and sizes to be 4 byte aligned.
+#define IREE_HAL_WEBGPU_COPY_ALIGNMENT 4
+
+typedef struct iree_hal_webgpu_buffer_t {
+  iree_hal_buffer_t base;
+  WGPUDevice device;
+  WGPUBuffer handle;
+} iree_hal_webgpu_buffer_t;
+
+static const iree_hal_buffer_vtable_t iree_hal_webgpu_buffer_vtable;
+
+static iree_hal_webgpu_buffer_t* iree_hal_webgpu_buffer_cast(
+    iree_hal_buffer_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_buffer_vtable);
+  return (iree_hal_webgpu_buffer_t*)base_value;
+}
+
+iree_status_t iree_hal_webgpu_buffer_wrap(
+    iree_hal_allocator_t* allocator, WGPUDevice device,
+    iree_hal_memory_type_t memory_type, iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_device_size_t byte_offset, iree_device_size_t byte_length,
+    WGPUBuffer handle, iree_hal_buffer_t** out_buffer) {
+  IREE_ASSERT_ARGUMENT(allocator);
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(out_buffer);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocator_t host_allocator =
+      iree_hal_allocator_host_allocator(allocator);
+  iree_hal_webgpu_buffer_t* buffer = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, sizeof(*buffer), (void**)&buffer);
+  if (iree_status_is_ok(status)) {
+    iree_hal_buffer_initialize(host_allocator, allocator, &buffer->base,
+                               allocation_size, byte_offset, byte_length,
+                               memory_type, allowed_access, allowed_usage,
+                               &iree_hal_webgpu_buffer_vtable, &buffer->base);
+    buffer->device = device;
+    buffer->handle = handle;
+    *out_buffer = &buffer->base;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_buffer_destroy(iree_hal_buffer_t* base_buffer) {
+  iree_hal_webgpu_buffer_t* buffer = iree_hal_webgpu_buffer_cast(base_buffer);
+  iree_allocator_t host_allocator = base_buffer->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // NOTE: the buffer is released and not destroyed so that any in-flight
+  // command buffers referencing it keep the storage alive.
+  wgpuBufferRelease(buffer->handle);
+  iree_allocator_free(host_allocator, buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+WGPUBuffer iree_hal_webgpu_buffer_handle(iree_hal_buffer_t* base_buffer) {
+  iree_hal_webgpu_buffer_t* buffer = iree_hal_webgpu_buffer_cast(base_buffer);
+  return buffer->handle;
+}
+
+static void iree_hal_webgpu_buffer_map_callback(WGPUBufferMapAsyncStatus status,
+                                                void* user_data) {
+  *(volatile bool*)user_data = true;
+}
+
+// Reads |length| bytes starting at |offset| from |buffer| into |target|.
+// Both must be aligned to IREE_HAL_WEBGPU_COPY_ALIGNMENT.
+static iree_status_t iree_hal_webgpu_buffer_read_back(
+    iree_hal_webgpu_buffer_t* buffer, iree_device_size_t offset,
+    iree_device_size_t length, void* target) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  const WGPUBufferDescriptor staging_descriptor = {
+      .nextInChain = NULL,
+      .label = "iree-readback",
+      .usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst,
+      .size = length,
+      .mappedAtCreation = false,
+  };
+  WGPUBuffer staging_buffer =
+      wgpuDeviceCreateBuffer(buffer->device, &staging_descriptor);
+  if (!staging_buffer) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "unable to allocate a %" PRIdsz
+                            " byte readback buffer",
+                            length);
+  }
+
+  WGPUCommandEncoder encoder =
+      wgpuDeviceCreateCommandEncoder(buffer->device, NULL);
+  wgpuCommandEncoderCopyBufferToBuffer(encoder, buffer->handle, offset,
+                                       staging_buffer, 0, length);
+  WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(encoder, NULL);
+  wgpuCommandEncoderRelease(encoder);
+  WGPUQueue queue = wgpuDeviceGetQueue(buffer->device);
+  wgpuQueueSubmit(queue, 1, &command_buffer);
+  wgpuCommandBufferRelease(command_buffer);
+
+  // Mapping completes after all previously submitted work (including the copy)
+  // has completed.
+  volatile bool is_mapped = false;
+  wgpuBufferMapAsync(staging_buffer, WGPUMapMode_Read, 0, length,
+                     iree_hal_webgpu_buffer_map_callback, (void*)&is_mapped);
+  iree_status_t status = iree_hal_webgpu_wait_for_flag(
+      buffer->device, &is_mapped, iree_infinite_timeout());
+
+  if (iree_status_is_ok(status)) {
+    const void* mapped_ptr =
+        wgpuBufferGetConstMappedRange(staging_buffer, 0, length);
+    if (mapped_ptr) {
+      memcpy(target, mapped_ptr, length);
+    } else {
+      status = iree_make_status(IREE_STATUS_INTERNAL,
+                                "failed to map the readback buffer");
+    }
+    wgpuBufferUnmap(staging_buffer);
+  }
+  wgpuBufferDestroy(staging_buffer);
+  wgpuBufferRelease(staging_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_webgpu_buffer_map_range(
+    iree_hal_buffer_t* base_buffer, iree_hal_mapping_mode_t mapping_mode,
+    iree_hal_memory_access_t memory_access,
+    iree_device_size_t local_byte_offset, iree_device_size_t local_byte_length,
+    iree_hal_buffer_mapping_t* mapping) {
+  iree_hal_webgpu_buffer_t* buffer = iree_hal_webgpu_buffer_cast(base_buffer);
+  if (iree_all_bits_set(mapping_mode, IREE_HAL_MAPPING_MODE_PERSISTENT)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "WebGPU buffers only support scoped mappings");
+  }
+  IREE_RETURN_IF_ERROR(
+      iree_hal_buffer_validate_usage(iree_hal_buffer_allowed_usage(base_buffer),
+                                     IREE_HAL_BUFFER_USAGE_MAPPING));
+
+  // The shadow copy covers the mapped range expanded to the copy alignment.
+  iree_device_size_t aligned_offset =
+      local_byte_offset - (local_byte_offset % IREE_HAL_WEBGPU_COPY_ALIGNMENT);
+  iree_device_size_t aligned_length =
+      iree_device_align(local_byte_offset + local_byte_length,
+                        IREE_HAL_WEBGPU_COPY_ALIGNMENT) -
+      aligned_offset;
+
+  uint8_t* shadow_ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      base_buffer->host_allocator, aligned_length, (void**)&shadow_ptr));
+
+  // Discard writes don't care about the existing contents but the edges of the
+  // aligned range outside of the mapping must still be preserved on unmap.
+  iree_status_t status = iree_ok_status();
+  const bool is_full_discard =
+      iree_all_bits_set(memory_access, IREE_HAL_MEMORY_ACCESS_DISCARD) &&
+      aligned_offset == local_byte_offset &&
+      aligned_length == local_byte_length;
+  if (!is_full_discard) {
+    status = iree_hal_webgpu_buffer_read_back(buffer, aligned_offset,
+                                              aligned_length, shadow_ptr);
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(base_buffer->host_allocator, shadow_ptr);
+    return status;
+  }
+
+  mapping->impl.reserved[0] = (uint64_t)(uintptr_t)shadow_ptr;
+  mapping->contents = iree_make_byte_span(
+      shadow_ptr + (local_byte_offset - aligned_offset), local_byte_length);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_buffer_unmap_range(
+    iree_hal_buffer_t* base_buffer, iree_device_size_t local_byte_offset,
+    iree_device_size_t local_byte_length, iree_hal_buffer_mapping_t* mapping) {
+  iree_hal_webgpu_buffer_t* buffer = iree_hal_webgpu_buffer_cast(base_buffer);
+  uint8_t* shadow_ptr = (uint8_t*)(uintptr_t)mapping->impl.reserved[0];
+  uint8_t* contents_ptr = mapping->contents.data;
+  iree_device_size_t aligned_offset =
+      local_byte_offset - (iree_device_size_t)(contents_ptr - shadow_ptr);
+  iree_device_size_t aligned_length =
+      iree_device_align(local_byte_offset + local_byte_length,
+                        IREE_HAL_WEBGPU_COPY_ALIGNMENT) -
+      aligned_offset;
+
+  // Upload the contents if they may have been modified. The write is ordered
+  // on the queue after all previously submitted work.
+  if (iree_any_bit_set(mapping->impl.allowed_access,
+                       IREE_HAL_MEMORY_ACCESS_WRITE)) {
+    WGPUQueue queue = wgpuDeviceGetQueue(buffer->device);
+    wgpuQueueWriteBuffer(queue, buffer->handle, aligned_offset, shadow_ptr,
+                         aligned_length);
+  }
+
+  iree_allocator_free(base_buffer->host_allocator, shadow_ptr);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_buffer_invalidate_range(
+    iree_hal_buffer_t* base_buffer, iree_device_size_t local_byte_offset,
+    iree_device_size_t local_byte_length) {
+  // Nothing to do: mappings are snapshots taken at map time.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_buffer_flush_range(
+    iree_hal_buffer_t* base_buffer, iree_device_size_t local_byte_offset,
+    iree_device_size_t local_byte_length) {
+  // Nothing to do: writes are uploaded on unmap.
+  return iree_ok_status();
+}
+
+static const iree_hal_buffer_vtable_t iree_hal_webgpu_buffer_vtable = {
+    .recycle = iree_hal_buffer_recycle,
+    .destroy = iree_hal_webgpu_buffer_destroy,
+    .map_range = iree_hal_webgpu_buffer_map_range,
+    .unmap_range = iree_hal_webgpu_buffer_unmap_range,
+    .invalidate_range = iree_hal_webgpu_buffer_invalidate_range,
+    .flush_range = iree_hal_webgpu_buffer_flush_range,
+};
@@ -0,0 +1,41 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_BUFFER_H_
+#define IREE_HAL_WEBGPU_BUFFER_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Wraps a WGPUBuffer in an iree_hal_buffer_t, taking ownership of |handle|.
+//
+// WebGPU buffers that can be used by dispatches cannot be mapped by the host.
+// Mapping is emulated: mapping for read copies the range into a staging buffer
+// on the device queue and waits for it to be readable and unmapping after a
+// write uploads the contents with wgpuQueueWriteBuffer. Mappings are only
+// coherent with device work that completed before the map.
+iree_status_t iree_hal_webgpu_buffer_wrap(
+    iree_hal_allocator_t* allocator, WGPUDevice device,
+    iree_hal_memory_type_t memory_type, iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_device_size_t byte_offset, iree_device_size_t byte_length,
+    WGPUBuffer handle, iree_hal_buffer_t** out_buffer);
+
+// Returns the underlying WGPUBuffer of an allocated buffer.
+// Callers must account for iree_hal_buffer_byte_offset when |buffer| is a
+// subspan of the allocation.
+WGPUBuffer iree_hal_webgpu_buffer_handle(iree_hal_buffer_t* buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_BUFFER_H_
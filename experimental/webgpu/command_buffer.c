@@ -0,0 +1,556 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/command_buffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "experimental/webgpu/buffer.h"
+#include "experimental/webgpu/descriptor_set.h"
+#include "experimental/webgpu/executable.h"
+#include "experimental/webgpu/executable_layout.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+// Maximum number of dynamic offsets that can be bound per descriptor set.
+#define IREE_HAL_WEBGPU_MAX_DYNAMIC_OFFSET_COUNT 8
+
+// WebGPU requires copy and fill offsets and sizes to be 4 byte aligned.
+#define IREE_HAL_WEBGPU_COPY_ALIGNMENT 4
+
+typedef struct iree_hal_webgpu_command_buffer_t {
+  iree_hal_command_buffer_t base;
+  iree_allocator_t host_allocator;
+  WGPUDevice device;
+
+  // Encoder for the current recording; NULL outside of begin/end.
+  WGPUCommandEncoder encoder;
+  // Compute pass opened lazily by dispatches and ended by transfer commands.
+  WGPUComputePassEncoder compute_pass;
+  // Result of the last end; released on the next begin or destroy.
+  WGPUCommandBuffer handle;
+
+  // Bind groups created by push_descriptor_set. Released when replaced as
+  // recorded commands retain the bind groups they reference.
+  WGPUBindGroup push_bind_groups[IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT];
+
+  // Bind groups and dynamic offsets applied to every dispatch.
+  struct {
+    WGPUBindGroup bind_group;
+    uint32_t dynamic_offset_count;
+    uint32_t dynamic_offsets[IREE_HAL_WEBGPU_MAX_DYNAMIC_OFFSET_COUNT];
+  } bindings[IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT];
+} iree_hal_webgpu_command_buffer_t;
+
+static const iree_hal_command_buffer_vtable_t
+    iree_hal_webgpu_command_buffer_vtable;
+
+static iree_hal_webgpu_command_buffer_t* iree_hal_webgpu_command_buffer_cast(
+    iree_hal_command_buffer_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_command_buffer_vtable);
+  return (iree_hal_webgpu_command_buffer_t*)base_value;
+}
+
+iree_status_t iree_hal_webgpu_command_buffer_create(
+    iree_hal_device_t* device, WGPUDevice handle,
+    iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(out_command_buffer);
+  *out_command_buffer = NULL;
+  if (!iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "WebGPU command buffers can only be submitted once and must be "
+        "recorded as one-shot");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*command_buffer), (void**)&command_buffer);
+  if (iree_status_is_ok(status)) {
+    memset(command_buffer, 0, sizeof(*command_buffer));
+    iree_hal_command_buffer_initialize(
+        device, mode, command_categories, queue_affinity,
+        &iree_hal_webgpu_command_buffer_vtable, &command_buffer->base);
+    command_buffer->host_allocator = host_allocator;
+    command_buffer->device = handle;
+    *out_command_buffer = &command_buffer->base;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Releases all recording state and the result of any previous recording.
+static void iree_hal_webgpu_command_buffer_reset(
+    iree_hal_webgpu_command_buffer_t* command_buffer) {
+  if (command_buffer->compute_pass) {
+    wgpuComputePassEncoderRelease(command_buffer->compute_pass);
+    command_buffer->compute_pass = NULL;
+  }
+  if (command_buffer->encoder) {
+    wgpuCommandEncoderRelease(command_buffer->encoder);
+    command_buffer->encoder = NULL;
+  }
+  if (command_buffer->handle) {
+    wgpuCommandBufferRelease(command_buffer->handle);
+    command_buffer->handle = NULL;
+  }
+  for (iree_host_size_t i = 0; i < IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT;
+       ++i) {
+    if (command_buffer->push_bind_groups[i]) {
+      wgpuBindGroupRelease(command_buffer->push_bind_groups[i]);
+      command_buffer->push_bind_groups[i] = NULL;
+    }
+  }
+  memset(command_buffer->bindings, 0, sizeof(command_buffer->bindings));
+}
+
+static void iree_hal_webgpu_command_buffer_destroy(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  iree_allocator_t host_allocator = command_buffer->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_command_buffer_reset(command_buffer);
+  iree_allocator_free(host_allocator, command_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+bool iree_hal_webgpu_command_buffer_isa(
+    iree_hal_command_buffer_t* command_buffer) {
+  return iree_hal_command_buffer_dyn_cast(
+      command_buffer, &iree_hal_webgpu_command_buffer_vtable);
+}
+
+static void* iree_hal_webgpu_command_buffer_dyn_cast(
+    iree_hal_command_buffer_t* command_buffer, const void* vtable) {
+  if (vtable == &iree_hal_webgpu_command_buffer_vtable) {
+    IREE_HAL_ASSERT_TYPE(command_buffer, vtable);
+    return command_buffer;
+  }
+  return NULL;
+}
+
+WGPUCommandBuffer iree_hal_webgpu_command_buffer_handle(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  return command_buffer->handle;
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_begin(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  iree_hal_webgpu_command_buffer_reset(command_buffer);
+  command_buffer->encoder =
+      wgpuDeviceCreateCommandEncoder(command_buffer->device, NULL);
+  if (!command_buffer->encoder) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create a command encoder");
+  }
+  return iree_ok_status();
+}
+
+// Ends the current compute pass, if any, so that transfer commands can be
+// recorded on the encoder.
+static void iree_hal_webgpu_command_buffer_end_compute_pass(
+    iree_hal_webgpu_command_buffer_t* command_buffer) {
+  if (!command_buffer->compute_pass) return;
+  wgpuComputePassEncoderEnd(command_buffer->compute_pass);
+  wgpuComputePassEncoderRelease(command_buffer->compute_pass);
+  command_buffer->compute_pass = NULL;
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_end(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  iree_hal_webgpu_command_buffer_end_compute_pass(command_buffer);
+  command_buffer->handle =
+      wgpuCommandEncoderFinish(command_buffer->encoder, NULL);
+  wgpuCommandEncoderRelease(command_buffer->encoder);
+  command_buffer->encoder = NULL;
+  if (!command_buffer->handle) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to finish the command encoder");
+  }
+  return iree_ok_status();
+}
+
+static void iree_hal_webgpu_command_buffer_begin_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer, iree_string_view_t label,
+    iree_hal_label_color_t label_color,
+    const iree_hal_label_location_t* location) {
+  // TODO(benvanik): wgpuCommandEncoderPushDebugGroup.
+}
+
+static void iree_hal_webgpu_command_buffer_end_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  // TODO(benvanik): wgpuCommandEncoderPopDebugGroup.
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_execution_barrier(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_hal_execution_barrier_flags_t flags,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  // WebGPU orders all commands within a command buffer.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_signal_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  // WebGPU orders all commands within a command buffer.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_reset_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  // WebGPU orders all commands within a command buffer.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_wait_events(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_host_size_t event_count, const iree_hal_event_t** events,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  // WebGPU orders all commands within a command buffer.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_discard_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_buffer_t* buffer) {
+  // Nothing to do.
+  return iree_ok_status();
+}
+
+// Records a copy of |length| bytes of |data| into |target_buffer| at
+// |target_offset| through a staging buffer. The staging buffer is released
+// immediately as the recorded copy retains it.
+static iree_status_t iree_hal_webgpu_command_buffer_copy_from_staging(
+    iree_hal_webgpu_command_buffer_t* command_buffer,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length,
+    void(IREE_API_PTR* populate)(void* user_data, void* target,
+                                 iree_device_size_t length),
+    void* user_data) {
+  const WGPUBufferDescriptor descriptor = {
+      .nextInChain = NULL,
+      .label = "iree-staging",
+      .usage = WGPUBufferUsage_CopySrc,
+      .size = length,
+      .mappedAtCreation = true,
+  };
+  WGPUBuffer staging_buffer =
+      wgpuDeviceCreateBuffer(command_buffer->device, &descriptor);
+  if (!staging_buffer) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "unable to allocate a %" PRIdsz
+                            " byte staging buffer",
+                            length);
+  }
+  void* mapped_ptr = wgpuBufferGetMappedRange(staging_buffer, 0, length);
+  if (!mapped_ptr) {
+    wgpuBufferRelease(staging_buffer);
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to map the staging buffer");
+  }
+  populate(user_data, mapped_ptr, length);
+  wgpuBufferUnmap(staging_buffer);
+
+  iree_hal_webgpu_command_buffer_end_compute_pass(command_buffer);
+  wgpuCommandEncoderCopyBufferToBuffer(
+      command_buffer->encoder, staging_buffer, 0,
+      iree_hal_webgpu_buffer_handle(
+          iree_hal_buffer_allocated_buffer(target_buffer)),
+      iree_hal_buffer_byte_offset(target_buffer) + target_offset, length);
+  wgpuBufferRelease(staging_buffer);
+  return iree_ok_status();
+}
+
+// Splats a pattern value of 1, 2, or 4 bytes out to a 4 byte value.
+static uint32_t iree_hal_webgpu_splat_pattern(const void* pattern,
+                                              size_t pattern_length) {
+  switch (pattern_length) {
+    case 1: {
+      uint32_t pattern_value = *(const uint8_t*)(pattern);
+      return (pattern_value << 24) | (pattern_value << 16) |
+             (pattern_value << 8) | pattern_value;
+    }
+    case 2: {
+      uint32_t pattern_value = *(const uint16_t*)(pattern);
+      return (pattern_value << 16) | pattern_value;
+    }
+    case 4: {
+      uint32_t pattern_value = *(const uint32_t*)(pattern);
+      return pattern_value;
+    }
+    default:
+      return 0;  // Already verified that this should not be possible.
+  }
+}
+
+static void iree_hal_webgpu_populate_fill(void* user_data, void* target,
+                                          iree_device_size_t length) {
+  const uint32_t pattern = *(const uint32_t*)user_data;
+  uint32_t* target_words = (uint32_t*)target;
+  for (iree_device_size_t i = 0; i < length / sizeof(uint32_t); ++i) {
+    target_words[i] = pattern;
+  }
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_fill_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length, const void* pattern,
+    iree_host_size_t pattern_length) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  if ((target_offset % IREE_HAL_WEBGPU_COPY_ALIGNMENT) != 0 ||
+      (length % IREE_HAL_WEBGPU_COPY_ALIGNMENT) != 0) {
+    // TODO(benvanik): emulate unaligned fills with a builtin dispatch.
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unaligned fills are not yet supported");
+  }
+
+  uint32_t dword_pattern =
+      iree_hal_webgpu_splat_pattern(pattern, pattern_length);
+  if (dword_pattern == 0) {
+    iree_hal_webgpu_command_buffer_end_compute_pass(command_buffer);
+    wgpuCommandEncoderClearBuffer(
+        command_buffer->encoder,
+        iree_hal_webgpu_buffer_handle(
+            iree_hal_buffer_allocated_buffer(target_buffer)),
+        iree_hal_buffer_byte_offset(target_buffer) + target_offset, length);
+    return iree_ok_status();
+  }
+  return iree_hal_webgpu_command_buffer_copy_from_staging(
+      command_buffer, target_buffer, target_offset, length,
+      iree_hal_webgpu_populate_fill, &dword_pattern);
+}
+
+static void iree_hal_webgpu_populate_update(void* user_data, void* target,
+                                            iree_device_size_t length) {
+  memcpy(target, user_data, length);
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_update_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, const void* source_buffer,
+    iree_host_size_t source_offset, iree_hal_buffer_t* target_buffer,
+    iree_device_size_t target_offset, iree_device_size_t length) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  if ((target_offset % IREE_HAL_WEBGPU_COPY_ALIGNMENT) != 0 ||
+      (length % IREE_HAL_WEBGPU_COPY_ALIGNMENT) != 0) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unaligned updates are not yet supported");
+  }
+  // The source data is captured in the staging buffer so the caller may reuse
+  // the memory as soon as this returns.
+  return iree_hal_webgpu_command_buffer_copy_from_staging(
+      command_buffer, target_buffer, target_offset, length,
+      iree_hal_webgpu_populate_update,
+      (void*)((const uint8_t*)source_buffer + source_offset));
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_copy_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* source_buffer, iree_device_size_t source_offset,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  if ((source_offset % IREE_HAL_WEBGPU_COPY_ALIGNMENT) != 0 ||
+      (target_offset % IREE_HAL_WEBGPU_COPY_ALIGNMENT) != 0 ||
+      (length % IREE_HAL_WEBGPU_COPY_ALIGNMENT) != 0) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unaligned copies are not yet supported");
+  }
+
+  iree_hal_webgpu_command_buffer_end_compute_pass(command_buffer);
+  wgpuCommandEncoderCopyBufferToBuffer(
+      command_buffer->encoder,
+      iree_hal_webgpu_buffer_handle(
+          iree_hal_buffer_allocated_buffer(source_buffer)),
+      iree_hal_buffer_byte_offset(source_buffer) + source_offset,
+      iree_hal_webgpu_buffer_handle(
+          iree_hal_buffer_allocated_buffer(target_buffer)),
+      iree_hal_buffer_byte_offset(target_buffer) + target_offset, length);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_push_constants(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
+    const void* values, iree_host_size_t values_length) {
+  // Executable layouts with push constants are rejected at creation.
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "WebGPU has no push constants");
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_push_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  if (set >= IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "descriptor set %u out of range", set);
+  }
+
+  WGPUBindGroup bind_group = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_create_bind_group(
+      command_buffer->device,
+      iree_hal_webgpu_executable_layout_set_layout(executable_layout, set),
+      binding_count, bindings, command_buffer->host_allocator, &bind_group));
+  if (command_buffer->push_bind_groups[set]) {
+    wgpuBindGroupRelease(command_buffer->push_bind_groups[set]);
+  }
+  command_buffer->push_bind_groups[set] = bind_group;
+  command_buffer->bindings[set].bind_group = bind_group;
+  command_buffer->bindings[set].dynamic_offset_count = 0;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_bind_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_hal_descriptor_set_t* descriptor_set,
+    iree_host_size_t dynamic_offset_count,
+    const iree_device_size_t* dynamic_offsets) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  if (set >= IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "descriptor set %u out of range", set);
+  } else if (dynamic_offset_count > IREE_HAL_WEBGPU_MAX_DYNAMIC_OFFSET_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "dynamic offset count %zu over the limit of %d",
+                            dynamic_offset_count,
+                            IREE_HAL_WEBGPU_MAX_DYNAMIC_OFFSET_COUNT);
+  }
+  command_buffer->bindings[set].bind_group =
+      iree_hal_webgpu_descriptor_set_handle(descriptor_set);
+  command_buffer->bindings[set].dynamic_offset_count =
+      (uint32_t)dynamic_offset_count;
+  for (iree_host_size_t i = 0; i < dynamic_offset_count; ++i) {
+    command_buffer->bindings[set].dynamic_offsets[i] =
+        (uint32_t)dynamic_offsets[i];
+  }
+  return iree_ok_status();
+}
+
+// Begins a compute pass (if needed) and binds the pipeline and bind groups for
+// a dispatch of |entry_point|.
+static iree_status_t iree_hal_webgpu_command_buffer_prepare_dispatch(
+    iree_hal_webgpu_command_buffer_t* command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    WGPUComputePassEncoder* out_compute_pass) {
+  if (!command_buffer->compute_pass) {
+    command_buffer->compute_pass = wgpuCommandEncoderBeginComputePass(
+        command_buffer->encoder, /*descriptor=*/NULL);
+    if (!command_buffer->compute_pass) {
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "failed to begin a compute pass");
+    }
+  }
+  WGPUComputePassEncoder compute_pass = command_buffer->compute_pass;
+
+  wgpuComputePassEncoderSetPipeline(
+      compute_pass,
+      iree_hal_webgpu_executable_pipeline(executable, entry_point));
+  for (uint32_t i = 0; i < IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT; ++i) {
+    if (!command_buffer->bindings[i].bind_group) continue;
+    wgpuComputePassEncoderSetBindGroup(
+        compute_pass, i, command_buffer->bindings[i].bind_group,
+        command_buffer->bindings[i].dynamic_offset_count,
+        command_buffer->bindings[i].dynamic_offsets);
+  }
+
+  *out_compute_pass = compute_pass;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_dispatch(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  WGPUComputePassEncoder compute_pass = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_command_buffer_prepare_dispatch(
+      command_buffer, executable, entry_point, &compute_pass));
+  wgpuComputePassEncoderDispatchWorkgroups(compute_pass, workgroup_x,
+                                           workgroup_y, workgroup_z);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_dispatch_indirect(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    iree_hal_buffer_t* workgroups_buffer,
+    iree_device_size_t workgroups_offset) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  WGPUComputePassEncoder compute_pass = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_command_buffer_prepare_dispatch(
+      command_buffer, executable, entry_point, &compute_pass));
+  wgpuComputePassEncoderDispatchWorkgroupsIndirect(
+      compute_pass,
+      iree_hal_webgpu_buffer_handle(
+          iree_hal_buffer_allocated_buffer(workgroups_buffer)),
+      iree_hal_buffer_byte_offset(workgroups_buffer) + workgroups_offset);
+  return iree_ok_status();
+}
+
+static const iree_hal_command_buffer_vtable_t
+    iree_hal_webgpu_command_buffer_vtable = {
+        .destroy = iree_hal_webgpu_command_buffer_destroy,
+        .dyn_cast = iree_hal_webgpu_command_buffer_dyn_cast,
+        .begin = iree_hal_webgpu_command_buffer_begin,
+        .end = iree_hal_webgpu_command_buffer_end,
+        .begin_debug_group = iree_hal_webgpu_command_buffer_begin_debug_group,
+        .end_debug_group = iree_hal_webgpu_command_buffer_end_debug_group,
+        .execution_barrier = iree_hal_webgpu_command_buffer_execution_barrier,
+        .signal_event = iree_hal_webgpu_command_buffer_signal_event,
+        .reset_event = iree_hal_webgpu_command_buffer_reset_event,
+        .wait_events = iree_hal_webgpu_command_buffer_wait_events,
+        .discard_buffer = iree_hal_webgpu_command_buffer_discard_buffer,
+        .fill_buffer = iree_hal_webgpu_command_buffer_fill_buffer,
+        .update_buffer = iree_hal_webgpu_command_buffer_update_buffer,
+        .copy_buffer = iree_hal_webgpu_command_buffer_copy_buffer,
+        .push_constants = iree_hal_webgpu_command_buffer_push_constants,
+        .push_descriptor_set =
+            iree_hal_webgpu_command_buffer_push_descriptor_set,
+        .bind_descriptor_set =
+            iree_hal_webgpu_command_buffer_bind_descriptor_set,
+        .dispatch = iree_hal_webgpu_command_buffer_dispatch,
+        .dispatch_indirect = iree_hal_webgpu_command_buffer_dispatch_indirect,
+};
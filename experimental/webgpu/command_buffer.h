@@ -0,0 +1,45 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_COMMAND_BUFFER_H_
+#define IREE_HAL_WEBGPU_COMMAND_BUFFER_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a command buffer that records into a WGPUCommandEncoder.
+// WGPUCommandBuffers can only be submitted once and so this is only usable for
+// one-shot command buffers; reusable command buffers are recorded as deferred
+// command buffers and replayed into a new one of these on each submission.
+//
+// Pipeline barriers and events are no-ops as WebGPU tracks resource usage and
+// inserts the required synchronization itself.
+iree_status_t iree_hal_webgpu_command_buffer_create(
+    iree_hal_device_t* device, WGPUDevice handle,
+    iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer);
+
+// Returns true if |command_buffer| is a WebGPU command buffer.
+bool iree_hal_webgpu_command_buffer_isa(
+    iree_hal_command_buffer_t* command_buffer);
+
+// Returns the WGPUCommandBuffer produced by ending the recording.
+// Only valid between iree_hal_command_buffer_end and the next begin.
+WGPUCommandBuffer iree_hal_webgpu_command_buffer_handle(
+    iree_hal_command_buffer_t* command_buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_COMMAND_BUFFER_H_
@@ -0,0 +1,153 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/cts/cts_driver.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "experimental/webgpu/api.h"
+#include "iree/base/tracing.h"
+
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+#include <emscripten.h>
+#include <emscripten/html5_webgpu.h>
+#endif  // IREE_PLATFORM_EMSCRIPTEN
+
+#define IREE_HAL_WEBGPU_CTS_DRIVER_ID 0x57475055u  // WGPU
+#define IREE_HAL_WEBGPU_CTS_DEVICE_ID_DEFAULT 0
+
+// Returns the WGPUDevice provided by the hosting page or NULL if none was.
+static WGPUDevice iree_hal_webgpu_cts_preinitialized_device(void) {
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+  // emscripten_webgpu_get_device asserts that a device was provided so check
+  // first in order to fail gracefully when running without one (such as under
+  // node).
+  int has_device = EM_ASM_INT(
+      { return Module['preinitializedWebGPUDevice'] ? 1 : 0; });
+  return has_device ? emscripten_webgpu_get_device() : NULL;
+#else
+  return NULL;
+#endif  // IREE_PLATFORM_EMSCRIPTEN
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_webgpu_cts_driver_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_webgpu_cts_driver_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+} iree_hal_webgpu_cts_driver_t;
+
+static const iree_hal_driver_vtable_t iree_hal_webgpu_cts_driver_vtable;
+
+static iree_hal_webgpu_cts_driver_t* iree_hal_webgpu_cts_driver_cast(
+    iree_hal_driver_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_cts_driver_vtable);
+  return (iree_hal_webgpu_cts_driver_t*)base_value;
+}
+
+static iree_status_t iree_hal_webgpu_cts_driver_create(
+    iree_allocator_t host_allocator, iree_hal_driver_t** out_driver) {
+  iree_hal_webgpu_cts_driver_t* driver = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(host_allocator, sizeof(*driver), (void**)&driver));
+  iree_hal_resource_initialize(&iree_hal_webgpu_cts_driver_vtable,
+                               &driver->resource);
+  driver->host_allocator = host_allocator;
+  *out_driver = (iree_hal_driver_t*)driver;
+  return iree_ok_status();
+}
+
+static void iree_hal_webgpu_cts_driver_destroy(iree_hal_driver_t* base_driver) {
+  iree_hal_webgpu_cts_driver_t* driver =
+      iree_hal_webgpu_cts_driver_cast(base_driver);
+  iree_allocator_free(driver->host_allocator, driver);
+}
+
+static iree_status_t iree_hal_webgpu_cts_driver_query_available_devices(
+    iree_hal_driver_t* base_driver, iree_allocator_t allocator,
+    iree_hal_device_info_t** out_device_infos,
+    iree_host_size_t* out_device_info_count) {
+  static const iree_hal_device_info_t device_infos[1] = {
+      {
+          .device_id = IREE_HAL_WEBGPU_CTS_DEVICE_ID_DEFAULT,
+          .name = iree_string_view_literal("default"),
+      },
+  };
+  *out_device_infos = NULL;
+  *out_device_info_count = 0;
+  if (!iree_hal_webgpu_cts_preinitialized_device()) return iree_ok_status();
+  *out_device_info_count = IREE_ARRAYSIZE(device_infos);
+  return iree_allocator_clone(
+      allocator, iree_make_const_byte_span(device_infos, sizeof(device_infos)),
+      (void**)out_device_infos);
+}
+
+static iree_status_t iree_hal_webgpu_cts_driver_create_device(
+    iree_hal_driver_t* base_driver, iree_hal_device_id_t device_id,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  WGPUDevice handle = iree_hal_webgpu_cts_preinitialized_device();
+  if (!handle) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "no WebGPU device was provided to the module");
+  }
+  return iree_hal_webgpu_device_create(iree_make_cstring_view("webgpu"),
+                                       handle, host_allocator, out_device);
+}
+
+static const iree_hal_driver_vtable_t iree_hal_webgpu_cts_driver_vtable = {
+    .destroy = iree_hal_webgpu_cts_driver_destroy,
+    .query_available_devices =
+        iree_hal_webgpu_cts_driver_query_available_devices,
+    .create_device = iree_hal_webgpu_cts_driver_create_device,
+};
+
+//===----------------------------------------------------------------------===//
+// Driver factory
+//===----------------------------------------------------------------------===//
+
+static iree_status_t iree_hal_webgpu_cts_driver_factory_enumerate(
+    void* self, const iree_hal_driver_info_t** out_driver_infos,
+    iree_host_size_t* out_driver_info_count) {
+  static const iree_hal_driver_info_t driver_infos[1] = {{
+      .driver_id = IREE_HAL_WEBGPU_CTS_DRIVER_ID,
+      .driver_name = iree_string_view_literal("experimental_webgpu"),
+      .full_name = iree_string_view_literal("WebGPU (preinitialized device)"),
+  }};
+  *out_driver_info_count = IREE_ARRAYSIZE(driver_infos);
+  *out_driver_infos = driver_infos;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_cts_driver_factory_try_create(
+    void* self, iree_hal_driver_id_t driver_id, iree_allocator_t allocator,
+    iree_hal_driver_t** out_driver) {
+  IREE_ASSERT_ARGUMENT(out_driver);
+  *out_driver = NULL;
+  if (driver_id != IREE_HAL_WEBGPU_CTS_DRIVER_ID) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "no driver with ID %016" PRIu64
+                            " is provided by this factory",
+                            driver_id);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status =
+      iree_hal_webgpu_cts_driver_create(allocator, out_driver);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_webgpu_cts_driver_module_register(
+    iree_hal_driver_registry_t* registry) {
+  static const iree_hal_driver_factory_t factory = {
+      .self = NULL,
+      .enumerate = iree_hal_webgpu_cts_driver_factory_enumerate,
+      .try_create = iree_hal_webgpu_cts_driver_factory_try_create,
+  };
+  return iree_hal_driver_registry_register_factory(registry, &factory);
+}
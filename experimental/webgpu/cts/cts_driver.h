@@ -0,0 +1,32 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_CTS_CTS_DRIVER_H_
+#define IREE_HAL_WEBGPU_CTS_CTS_DRIVER_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Registers a test-only "experimental_webgpu" driver with |registry|.
+//
+// The WebGPU HAL has no driver of its own as devices can only be requested
+// asynchronously. This driver instead exposes the WGPUDevice the test harness
+// page handed to the module as Module.preinitializedWebGPUDevice (the same way
+// the web samples receive theirs). When no device was provided, such as in
+// native builds or when running under node, the driver reports no devices and
+// device creation fails with IREE_STATUS_UNAVAILABLE so that the CTS skips.
+iree_status_t iree_hal_webgpu_cts_driver_module_register(
+    iree_hal_driver_registry_t* registry);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_CTS_CTS_DRIVER_H_
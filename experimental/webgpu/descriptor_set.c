@@ -0,0 +1,149 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/descriptor_set.h"
+
+#include <stddef.h>
+
+#include "experimental/webgpu/buffer.h"
+#include "experimental/webgpu/descriptor_set_layout.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_webgpu_descriptor_set_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  WGPUBindGroup handle;
+} iree_hal_webgpu_descriptor_set_t;
+
+static const iree_hal_descriptor_set_vtable_t
+    iree_hal_webgpu_descriptor_set_vtable;
+
+static iree_hal_webgpu_descriptor_set_t* iree_hal_webgpu_descriptor_set_cast(
+    iree_hal_descriptor_set_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_descriptor_set_vtable);
+  return (iree_hal_webgpu_descriptor_set_t*)base_value;
+}
+
+iree_status_t iree_hal_webgpu_create_bind_group(
+    WGPUDevice device, iree_hal_descriptor_set_layout_t* layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_allocator_t host_allocator, WGPUBindGroup* out_bind_group) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(layout);
+  IREE_ASSERT_ARGUMENT(!binding_count || bindings);
+  IREE_ASSERT_ARGUMENT(out_bind_group);
+  *out_bind_group = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  WGPUBindGroupEntry* entries = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator,
+                                binding_count * sizeof(*entries),
+                                (void**)&entries));
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    const iree_hal_descriptor_set_binding_t* binding = &bindings[i];
+    // Buffers may be subspans of their allocation: the WGPUBuffer covers the
+    // entire allocation so the subspan offset is folded into the binding.
+    iree_hal_buffer_t* allocated_buffer =
+        iree_hal_buffer_allocated_buffer(binding->buffer);
+    iree_device_size_t length = binding->length;
+    if (length == IREE_WHOLE_BUFFER) {
+      length = iree_hal_buffer_byte_length(binding->buffer) - binding->offset;
+    }
+    iree_device_size_t offset =
+        iree_hal_buffer_byte_offset(binding->buffer) + binding->offset;
+    entries[i] = (WGPUBindGroupEntry){
+        .nextInChain = NULL,
+        .binding = binding->binding,
+        .buffer = iree_hal_webgpu_buffer_handle(allocated_buffer),
+        .offset = offset,
+        .size = length,
+        .sampler = NULL,
+        .textureView = NULL,
+    };
+  }
+
+  const WGPUBindGroupDescriptor descriptor = {
+      .nextInChain = NULL,
+      .label = NULL,
+      .layout = iree_hal_webgpu_descriptor_set_layout_handle(layout),
+      .entryCount = (uint32_t)binding_count,
+      .entries = entries,
+  };
+  WGPUBindGroup bind_group = wgpuDeviceCreateBindGroup(device, &descriptor);
+  iree_allocator_free(host_allocator, entries);
+
+  iree_status_t status = iree_ok_status();
+  if (bind_group) {
+    *out_bind_group = bind_group;
+  } else {
+    status = iree_make_status(IREE_STATUS_INTERNAL,
+                              "failed to create a bind group");
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_webgpu_descriptor_set_create(
+    WGPUDevice device, iree_hal_descriptor_set_layout_t* layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_allocator_t host_allocator,
+    iree_hal_descriptor_set_t** out_descriptor_set) {
+  IREE_ASSERT_ARGUMENT(out_descriptor_set);
+  *out_descriptor_set = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The bind group retains the underlying WGPUBuffers so the HAL buffers need
+  // not be retained by the set.
+  WGPUBindGroup handle = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_webgpu_create_bind_group(device, layout, binding_count,
+                                            bindings, host_allocator, &handle));
+
+  iree_hal_webgpu_descriptor_set_t* descriptor_set = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*descriptor_set), (void**)&descriptor_set);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_webgpu_descriptor_set_vtable,
+                                 &descriptor_set->resource);
+    descriptor_set->host_allocator = host_allocator;
+    descriptor_set->handle = handle;
+    *out_descriptor_set = (iree_hal_descriptor_set_t*)descriptor_set;
+  } else {
+    wgpuBindGroupRelease(handle);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+WGPUBindGroup iree_hal_webgpu_descriptor_set_handle(
+    iree_hal_descriptor_set_t* base_descriptor_set) {
+  iree_hal_webgpu_descriptor_set_t* descriptor_set =
+      iree_hal_webgpu_descriptor_set_cast(base_descriptor_set);
+  return descriptor_set->handle;
+}
+
+static void iree_hal_webgpu_descriptor_set_destroy(
+    iree_hal_descriptor_set_t* base_descriptor_set) {
+  iree_hal_webgpu_descriptor_set_t* descriptor_set =
+      iree_hal_webgpu_descriptor_set_cast(base_descriptor_set);
+  iree_allocator_t host_allocator = descriptor_set->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  wgpuBindGroupRelease(descriptor_set->handle);
+  iree_allocator_free(host_allocator, descriptor_set);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static const iree_hal_descriptor_set_vtable_t
+    iree_hal_webgpu_descriptor_set_vtable = {
+        .destroy = iree_hal_webgpu_descriptor_set_destroy,
+};
@@ -0,0 +1,42 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_DESCRIPTOR_SET_H_
+#define IREE_HAL_WEBGPU_DESCRIPTOR_SET_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a WGPUBindGroup of |layout| referencing the given buffer |bindings|.
+// Shared by descriptor sets and command buffer push descriptor sets.
+iree_status_t iree_hal_webgpu_create_bind_group(
+    WGPUDevice device, iree_hal_descriptor_set_layout_t* layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_allocator_t host_allocator, WGPUBindGroup* out_bind_group);
+
+// Creates a descriptor set backed by a WGPUBindGroup.
+iree_status_t iree_hal_webgpu_descriptor_set_create(
+    WGPUDevice device, iree_hal_descriptor_set_layout_t* layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_allocator_t host_allocator,
+    iree_hal_descriptor_set_t** out_descriptor_set);
+
+// Returns the WGPUBindGroup of the descriptor set.
+WGPUBindGroup iree_hal_webgpu_descriptor_set_handle(
+    iree_hal_descriptor_set_t* descriptor_set);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_DESCRIPTOR_SET_H_
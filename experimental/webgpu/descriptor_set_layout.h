@@ -0,0 +1,35 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_DESCRIPTOR_SET_LAYOUT_H_
+#define IREE_HAL_WEBGPU_DESCRIPTOR_SET_LAYOUT_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a descriptor set layout backed by a WGPUBindGroupLayout visible to
+// compute shaders.
+iree_status_t iree_hal_webgpu_descriptor_set_layout_create(
+    WGPUDevice device, iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_allocator_t host_allocator,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout);
+
+// Returns the WGPUBindGroupLayout of the descriptor set layout.
+WGPUBindGroupLayout iree_hal_webgpu_descriptor_set_layout_handle(
+    iree_hal_descriptor_set_layout_t* descriptor_set_layout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_DESCRIPTOR_SET_LAYOUT_H_
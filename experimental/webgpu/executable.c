@@ -0,0 +1,251 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/executable.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "experimental/webgpu/executable_layout.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+// flatcc schemas:
+#include "iree/base/internal/flatcc/parsing.h"
+#include "iree/schemas/wgsl_executable_def_reader.h"
+#include "iree/schemas/wgsl_executable_def_verifier.h"
+
+typedef struct iree_hal_webgpu_executable_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_host_size_t entry_point_count;
+  WGPUComputePipeline pipelines[];
+} iree_hal_webgpu_executable_t;
+
+static const iree_hal_executable_vtable_t iree_hal_webgpu_executable_vtable;
+
+static iree_hal_webgpu_executable_t* iree_hal_webgpu_executable_cast(
+    iree_hal_executable_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_executable_vtable);
+  return (iree_hal_webgpu_executable_t*)base_value;
+}
+
+// Verifies the structure of the flatbuffer so that we can avoid doing so during
+// runtime. There are still some conditions we must be aware of (such as omitted
+// names on functions with internal linkage), however we shouldn't need to
+// bounds check anything within the flatbuffer after this succeeds.
+static iree_status_t iree_hal_webgpu_executable_flatbuffer_verify(
+    iree_const_byte_span_t flatbuffer_data,
+    iree_host_size_t expected_entry_point_count) {
+  if (!flatbuffer_data.data || flatbuffer_data.data_length < 16) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "flatbuffer data is not present or less than 16 bytes (%zu total)",
+        flatbuffer_data.data_length);
+  }
+
+  // Run flatcc generated verification. This ensures all pointers are in-bounds
+  // and that we can safely walk the file, but not that the actual contents of
+  // the flatbuffer meet our expectations.
+  int verify_ret = iree_WGSLExecutableDef_verify_as_root(
+      flatbuffer_data.data, flatbuffer_data.data_length);
+  if (verify_ret != flatcc_verify_ok) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "flatbuffer verification failed: %s",
+                            flatcc_verify_error_string(verify_ret));
+  }
+
+  iree_WGSLExecutableDef_table_t executable_def =
+      iree_WGSLExecutableDef_as_root(flatbuffer_data.data);
+
+  iree_WGSLShaderModuleDef_vec_t shader_modules_vec =
+      iree_WGSLExecutableDef_shader_modules_get(executable_def);
+  size_t shader_module_count =
+      iree_WGSLShaderModuleDef_vec_len(shader_modules_vec);
+  for (size_t i = 0; i < shader_module_count; ++i) {
+    iree_WGSLShaderModuleDef_table_t shader_module_def =
+        iree_WGSLShaderModuleDef_vec_at(shader_modules_vec, i);
+    if (flatbuffers_string_len(
+            iree_WGSLShaderModuleDef_code_get(shader_module_def)) == 0) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "shader module %zu has no WGSL code", i);
+    }
+  }
+
+  flatbuffers_int32_vec_t entry_points_vec =
+      iree_WGSLExecutableDef_entry_points_get(executable_def);
+  size_t entry_point_count = flatbuffers_int32_vec_len(entry_points_vec);
+  if (entry_point_count != expected_entry_point_count) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "executable provides %zu entry points but caller "
+                            "provided %zu; must match",
+                            entry_point_count, expected_entry_point_count);
+  }
+  for (size_t i = 0; i < entry_point_count; ++i) {
+    int32_t module_ordinal = flatbuffers_int32_vec_at(entry_points_vec, i);
+    if (module_ordinal < 0 || (size_t)module_ordinal >= shader_module_count) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "entry point %zu references shader module %d "
+                              "out of %zu",
+                              i, module_ordinal, shader_module_count);
+    }
+  }
+
+  return iree_ok_status();
+}
+
+// Creates a WGPUShaderModule from WGSL source |code|.
+static iree_status_t iree_hal_webgpu_create_shader_module(
+    WGPUDevice device, flatbuffers_string_t code,
+    WGPUShaderModule* out_shader_module) {
+  const WGPUShaderModuleWGSLDescriptor wgsl_descriptor = {
+      .chain =
+          {
+              .next = NULL,
+              .sType = WGPUSType_ShaderModuleWGSLDescriptor,
+          },
+      .code = code,
+  };
+  const WGPUShaderModuleDescriptor descriptor = {
+      .nextInChain = &wgsl_descriptor.chain,
+      .label = NULL,
+  };
+  *out_shader_module = wgpuDeviceCreateShaderModule(device, &descriptor);
+  if (!*out_shader_module) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "failed to create a shader module");
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_webgpu_executable_create(
+    WGPUDevice device, const iree_hal_executable_spec_t* executable_spec,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(executable_spec);
+  IREE_ASSERT_ARGUMENT(out_executable);
+  *out_executable = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_webgpu_executable_flatbuffer_verify(
+              executable_spec->executable_data,
+              executable_spec->executable_layout_count));
+
+  iree_WGSLExecutableDef_table_t executable_def =
+      iree_WGSLExecutableDef_as_root(executable_spec->executable_data.data);
+  iree_WGSLShaderModuleDef_vec_t shader_modules_vec =
+      iree_WGSLExecutableDef_shader_modules_get(executable_def);
+  iree_host_size_t shader_module_count =
+      iree_WGSLShaderModuleDef_vec_len(shader_modules_vec);
+  flatbuffers_int32_vec_t entry_points_vec =
+      iree_WGSLExecutableDef_entry_points_get(executable_def);
+  iree_host_size_t entry_point_count =
+      flatbuffers_int32_vec_len(entry_points_vec);
+
+  iree_hal_webgpu_executable_t* executable = NULL;
+  iree_host_size_t total_size =
+      sizeof(*executable) + entry_point_count * sizeof(*executable->pipelines);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(host_allocator, total_size, (void**)&executable));
+  iree_hal_resource_initialize(&iree_hal_webgpu_executable_vtable,
+                               &executable->resource);
+  executable->host_allocator = host_allocator;
+  executable->entry_point_count = entry_point_count;
+  memset(executable->pipelines, 0,
+         entry_point_count * sizeof(*executable->pipelines));
+
+  // Shader modules are only needed while creating the pipelines.
+  WGPUShaderModule* shader_modules = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, shader_module_count * sizeof(*shader_modules),
+      (void**)&shader_modules);
+  if (iree_status_is_ok(status)) {
+    memset(shader_modules, 0, shader_module_count * sizeof(*shader_modules));
+  }
+  for (iree_host_size_t i = 0;
+       iree_status_is_ok(status) && i < shader_module_count; ++i) {
+    iree_WGSLShaderModuleDef_table_t shader_module_def =
+        iree_WGSLShaderModuleDef_vec_at(shader_modules_vec, i);
+    status = iree_hal_webgpu_create_shader_module(
+        device, iree_WGSLShaderModuleDef_code_get(shader_module_def),
+        &shader_modules[i]);
+  }
+
+  for (iree_host_size_t i = 0;
+       iree_status_is_ok(status) && i < entry_point_count; ++i) {
+    char entry_point_name[16];
+    snprintf(entry_point_name, sizeof(entry_point_name), "d%zu", i);
+    const WGPUComputePipelineDescriptor descriptor = {
+        .nextInChain = NULL,
+        .label = NULL,
+        .layout = iree_hal_webgpu_executable_layout_handle(
+            executable_spec->executable_layouts[i]),
+        .compute =
+            {
+                .nextInChain = NULL,
+                .module = shader_modules[flatbuffers_int32_vec_at(
+                    entry_points_vec, i)],
+                .entryPoint = entry_point_name,
+            },
+    };
+    executable->pipelines[i] =
+        wgpuDeviceCreateComputePipeline(device, &descriptor);
+    if (!executable->pipelines[i]) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "failed to create the compute pipeline for "
+                                "entry point %zu",
+                                i);
+    }
+  }
+
+  if (shader_modules) {
+    for (iree_host_size_t i = 0; i < shader_module_count; ++i) {
+      if (shader_modules[i]) wgpuShaderModuleRelease(shader_modules[i]);
+    }
+    iree_allocator_free(host_allocator, shader_modules);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_executable = (iree_hal_executable_t*)executable;
+  } else {
+    iree_hal_executable_destroy((iree_hal_executable_t*)executable);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+WGPUComputePipeline iree_hal_webgpu_executable_pipeline(
+    iree_hal_executable_t* base_executable, iree_host_size_t entry_point) {
+  iree_hal_webgpu_executable_t* executable =
+      iree_hal_webgpu_executable_cast(base_executable);
+  IREE_ASSERT_LT(entry_point, executable->entry_point_count);
+  return executable->pipelines[entry_point];
+}
+
+static void iree_hal_webgpu_executable_destroy(
+    iree_hal_executable_t* base_executable) {
+  iree_hal_webgpu_executable_t* executable =
+      iree_hal_webgpu_executable_cast(base_executable);
+  iree_allocator_t host_allocator = executable->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (iree_host_size_t i = 0; i < executable->entry_point_count; ++i) {
+    if (executable->pipelines[i]) {
+      wgpuComputePipelineRelease(executable->pipelines[i]);
+    }
+  }
+  iree_allocator_free(host_allocator, executable);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static const iree_hal_executable_vtable_t iree_hal_webgpu_executable_vtable = {
+    .destroy = iree_hal_webgpu_executable_destroy,
+};
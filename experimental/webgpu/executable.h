@@ -0,0 +1,32 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_EXECUTABLE_H_
+#define IREE_HAL_WEBGPU_EXECUTABLE_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates an executable from a WGSLExecutableDef flatbuffer with one compute
+// pipeline per entry point.
+iree_status_t iree_hal_webgpu_executable_create(
+    WGPUDevice device, const iree_hal_executable_spec_t* executable_spec,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable);
+
+// Returns the compute pipeline of the given |entry_point|.
+WGPUComputePipeline iree_hal_webgpu_executable_pipeline(
+    iree_hal_executable_t* executable, iree_host_size_t entry_point);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_EXECUTABLE_H_
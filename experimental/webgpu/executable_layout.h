@@ -0,0 +1,46 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_EXECUTABLE_LAYOUT_H_
+#define IREE_HAL_WEBGPU_EXECUTABLE_LAYOUT_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Minimum maxBindGroups limit guaranteed by all WebGPU implementations.
+#define IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT 4
+
+// Creates an executable layout backed by a WGPUPipelineLayout.
+// Push constants are not supported as WebGPU has no equivalent; executables
+// must pass them through uniform buffers instead.
+iree_status_t iree_hal_webgpu_executable_layout_create(
+    WGPUDevice device, iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_host_size_t push_constant_count, iree_allocator_t host_allocator,
+    iree_hal_executable_layout_t** out_executable_layout);
+
+// Returns the WGPUPipelineLayout of the executable layout.
+WGPUPipelineLayout iree_hal_webgpu_executable_layout_handle(
+    iree_hal_executable_layout_t* executable_layout);
+
+// Returns the number of descriptor sets in the executable layout.
+iree_host_size_t iree_hal_webgpu_executable_layout_set_count(
+    iree_hal_executable_layout_t* executable_layout);
+
+// Returns the descriptor set layout of |set| in the executable layout.
+iree_hal_descriptor_set_layout_t* iree_hal_webgpu_executable_layout_set_layout(
+    iree_hal_executable_layout_t* executable_layout, uint32_t set);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_EXECUTABLE_LAYOUT_H_
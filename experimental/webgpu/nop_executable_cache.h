@@ -0,0 +1,33 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_NOP_EXECUTABLE_CACHE_H_
+#define IREE_HAL_WEBGPU_NOP_EXECUTABLE_CACHE_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Executable format produced by the compiler WebGPU target backend.
+#define IREE_HAL_WEBGPU_EXECUTABLE_FORMAT "webgpu-wgsl-fb"
+
+// Creates a no-op executable cache that does not cache at all.
+// Browsers cache compiled pipelines themselves so there's little to gain from
+// doing it here.
+iree_status_t iree_hal_webgpu_nop_executable_cache_create(
+    WGPUDevice device, iree_string_view_t identifier,
+    iree_allocator_t host_allocator,
+    iree_hal_executable_cache_t** out_executable_cache);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_NOP_EXECUTABLE_CACHE_H_
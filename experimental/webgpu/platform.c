@@ -0,0 +1,42 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/platform.h"
+
+#include "iree/base/tracing.h"
+
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+#include <emscripten.h>
+#endif  // IREE_PLATFORM_EMSCRIPTEN
+
+iree_status_t iree_hal_webgpu_process_events(WGPUDevice device) {
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+  emscripten_sleep(0);
+  return iree_ok_status();
+#else
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "WebGPU event processing is only implemented for "
+                          "Emscripten builds");
+#endif  // IREE_PLATFORM_EMSCRIPTEN
+}
+
+iree_status_t iree_hal_webgpu_wait_for_flag(WGPUDevice device,
+                                            const volatile bool* flag,
+                                            iree_timeout_t timeout) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  iree_status_t status = iree_ok_status();
+  while (!*flag) {
+    if (iree_time_now() >= deadline_ns) {
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      break;
+    }
+    status = iree_hal_webgpu_process_events(device);
+    if (!iree_status_is_ok(status)) break;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,37 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_PLATFORM_H_
+#define IREE_HAL_WEBGPU_PLATFORM_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Allows pending WebGPU callbacks (buffer mapping, queue work done, etc) to
+// run. WebGPU only reports completion asynchronously and the HAL waits are
+// implemented by calling this until the callback of interest has fired.
+//
+// On the web callbacks are only delivered from the browser event loop so this
+// yields to it with emscripten_sleep and requires the module to be built with
+// -sASYNCIFY. Native implementations have no portable way of processing
+// events and return IREE_STATUS_UNIMPLEMENTED.
+iree_status_t iree_hal_webgpu_process_events(WGPUDevice device);
+
+// Calls iree_hal_webgpu_process_events until |*flag| is set or |timeout|
+// elapses.
+iree_status_t iree_hal_webgpu_wait_for_flag(WGPUDevice device,
+                                            const volatile bool* flag,
+                                            iree_timeout_t timeout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_PLATFORM_H_
@@ -0,0 +1,221 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/semaphore.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "experimental/webgpu/platform.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+//===----------------------------------------------------------------------===//
+// iree_hal_webgpu_semaphore_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_webgpu_semaphore_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  WGPUDevice device;
+  // Current signaled value. May be outdated at the time it is read.
+  uint64_t current_value;
+  // OK or the status passed to iree_hal_semaphore_fail. Owned by the semaphore.
+  iree_status_t failure_status;
+} iree_hal_webgpu_semaphore_t;
+
+static const iree_hal_semaphore_vtable_t iree_hal_webgpu_semaphore_vtable;
+
+static iree_hal_webgpu_semaphore_t* iree_hal_webgpu_semaphore_cast(
+    iree_hal_semaphore_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_semaphore_vtable);
+  return (iree_hal_webgpu_semaphore_t*)base_value;
+}
+
+iree_status_t iree_hal_webgpu_semaphore_create(
+    WGPUDevice device, uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore) {
+  IREE_ASSERT_ARGUMENT(out_semaphore);
+  *out_semaphore = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_semaphore_t* semaphore = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*semaphore), (void**)&semaphore);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_webgpu_semaphore_vtable,
+                                 &semaphore->resource);
+    semaphore->host_allocator = host_allocator;
+    semaphore->device = device;
+    semaphore->current_value = initial_value;
+    semaphore->failure_status = iree_ok_status();
+    *out_semaphore = (iree_hal_semaphore_t*)semaphore;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_semaphore_destroy(
+    iree_hal_semaphore_t* base_semaphore) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  iree_allocator_t host_allocator = semaphore->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_ignore(semaphore->failure_status);
+  iree_allocator_free(host_allocator, semaphore);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_status_t iree_hal_webgpu_semaphore_query(
+    iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  *out_value = semaphore->current_value;
+  if (!iree_status_is_ok(semaphore->failure_status)) {
+    return iree_status_from_code(IREE_STATUS_ABORTED);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_semaphore_signal(
+    iree_hal_semaphore_t* base_semaphore, uint64_t new_value) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  if (new_value <= semaphore->current_value) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "semaphore values must be monotonically "
+                            "increasing; current_value=%" PRIu64
+                            ", new_value=%" PRIu64,
+                            semaphore->current_value, new_value);
+  }
+  semaphore->current_value = new_value;
+  return iree_ok_status();
+}
+
+static void iree_hal_webgpu_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
+                                           iree_status_t status) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  // Only the first failure is retained.
+  if (iree_status_is_ok(semaphore->failure_status)) {
+    semaphore->failure_status = status;
+  } else {
+    iree_status_ignore(status);
+  }
+}
+
+static iree_status_t iree_hal_webgpu_semaphore_wait(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    iree_timeout_t timeout) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  iree_status_t status = iree_ok_status();
+  while (semaphore->current_value < value) {
+    if (!iree_status_is_ok(semaphore->failure_status)) {
+      status = iree_status_from_code(IREE_STATUS_ABORTED);
+      break;
+    } else if (iree_time_now() >= deadline_ns) {
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      break;
+    }
+    status = iree_hal_webgpu_process_events(semaphore->device);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static const iree_hal_semaphore_vtable_t iree_hal_webgpu_semaphore_vtable = {
+    .destroy = iree_hal_webgpu_semaphore_destroy,
+    .query = iree_hal_webgpu_semaphore_query,
+    .signal = iree_hal_webgpu_semaphore_signal,
+    .fail = iree_hal_webgpu_semaphore_fail,
+    .wait = iree_hal_webgpu_semaphore_wait,
+};
+
+//===----------------------------------------------------------------------===//
+// Queue completion signals
+//===----------------------------------------------------------------------===//
+
+// Semaphores to signal when queue work completes. Allocated as a single block
+// with the semaphore and value lists in the trailing storage.
+typedef struct iree_hal_webgpu_pending_signal_t {
+  iree_allocator_t host_allocator;
+  iree_host_size_t count;
+  iree_hal_semaphore_t** semaphores;
+  uint64_t* payload_values;
+} iree_hal_webgpu_pending_signal_t;
+
+static void iree_hal_webgpu_pending_signal_callback(
+    WGPUQueueWorkDoneStatus work_done_status, void* user_data) {
+  iree_hal_webgpu_pending_signal_t* pending_signal =
+      (iree_hal_webgpu_pending_signal_t*)user_data;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (iree_host_size_t i = 0; i < pending_signal->count; ++i) {
+    iree_hal_semaphore_t* semaphore = pending_signal->semaphores[i];
+    if (work_done_status == WGPUQueueWorkDoneStatus_Success) {
+      iree_status_t status = iree_hal_semaphore_signal(
+          semaphore, pending_signal->payload_values[i]);
+      if (!iree_status_is_ok(status)) {
+        iree_hal_semaphore_fail(semaphore, status);
+      }
+    } else {
+      iree_hal_semaphore_fail(
+          semaphore, iree_make_status(IREE_STATUS_ABORTED,
+                                      "queue work failed to complete (%d)",
+                                      (int)work_done_status));
+    }
+    iree_hal_semaphore_release(semaphore);
+  }
+  iree_allocator_free(pending_signal->host_allocator, pending_signal);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_webgpu_semaphore_list_signal_on_completion(
+    WGPUQueue queue, const iree_hal_semaphore_list_t* signal_list,
+    iree_allocator_t host_allocator) {
+  if (signal_list->count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_pending_signal_t* pending_signal = NULL;
+  iree_host_size_t total_size =
+      iree_sizeof_struct(*pending_signal) +
+      signal_list->count * sizeof(*pending_signal->payload_values) +
+      signal_list->count * sizeof(*pending_signal->semaphores);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size,
+                                (void**)&pending_signal));
+  pending_signal->host_allocator = host_allocator;
+  pending_signal->count = signal_list->count;
+  // Values first to keep them 8-byte aligned followed by the pointers.
+  uint8_t* storage =
+      (uint8_t*)pending_signal + iree_sizeof_struct(*pending_signal);
+  pending_signal->payload_values = (uint64_t*)storage;
+  pending_signal->semaphores =
+      (iree_hal_semaphore_t**)(pending_signal->payload_values +
+                               signal_list->count);
+  for (iree_host_size_t i = 0; i < signal_list->count; ++i) {
+    pending_signal->semaphores[i] = signal_list->semaphores[i];
+    pending_signal->payload_values[i] = signal_list->payload_values[i];
+    iree_hal_semaphore_retain(pending_signal->semaphores[i]);
+  }
+
+  wgpuQueueOnSubmittedWorkDone(queue, /*signalValue=*/0,
+                               iree_hal_webgpu_pending_signal_callback,
+                               pending_signal);
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
@@ -0,0 +1,39 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_SEMAPHORE_H_
+#define IREE_HAL_WEBGPU_SEMAPHORE_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a timeline semaphore whose payload is tracked on the host.
+// Device signals are delivered by wgpuQueueOnSubmittedWorkDone callbacks
+// registered with iree_hal_webgpu_semaphore_list_signal_on_completion and
+// waits pump the WebGPU event loop until the payload is reached.
+//
+// WebGPU devices are only usable from the thread that created them and so the
+// semaphores are not thread-safe.
+iree_status_t iree_hal_webgpu_semaphore_create(
+    WGPUDevice device, uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore);
+
+// Signals all semaphores in |signal_list| once all work submitted to |queue|
+// so far has completed. The semaphores are retained until then.
+iree_status_t iree_hal_webgpu_semaphore_list_signal_on_completion(
+    WGPUQueue queue, const iree_hal_semaphore_list_t* signal_list,
+    iree_allocator_t host_allocator);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_SEMAPHORE_H_
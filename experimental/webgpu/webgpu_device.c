@@ -0,0 +1,406 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "experimental/webgpu/allocator.h"
+#include "experimental/webgpu/api.h"
+#include "experimental/webgpu/command_buffer.h"
+#include "experimental/webgpu/descriptor_set.h"
+#include "experimental/webgpu/descriptor_set_layout.h"
+#include "experimental/webgpu/executable_layout.h"
+#include "experimental/webgpu/nop_executable_cache.h"
+#include "experimental/webgpu/platform.h"
+#include "experimental/webgpu/semaphore.h"
+#include "iree/base/internal/arena.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/utils/deferred_command_buffer.h"
+
+//===----------------------------------------------------------------------===//
+// iree_hal_webgpu_device_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_webgpu_device_t {
+  iree_hal_resource_t resource;
+  iree_string_view_t identifier;
+  iree_allocator_t host_allocator;
+
+  // Block pool used for recording reusable (deferred) command buffers.
+  iree_arena_block_pool_t block_pool;
+
+  WGPUDevice handle;
+  WGPUQueue queue;
+  iree_hal_allocator_t* device_allocator;
+} iree_hal_webgpu_device_t;
+
+static const iree_hal_device_vtable_t iree_hal_webgpu_device_vtable;
+
+static iree_hal_webgpu_device_t* iree_hal_webgpu_device_cast(
+    iree_hal_device_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_device_vtable);
+  return (iree_hal_webgpu_device_t*)base_value;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_webgpu_device_create(
+    iree_string_view_t identifier, WGPUDevice handle,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(out_device);
+  *out_device = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_device_t* device = NULL;
+  iree_host_size_t total_size = iree_sizeof_struct(*device) + identifier.size;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&device));
+  memset(device, 0, total_size);
+  iree_hal_resource_initialize(&iree_hal_webgpu_device_vtable,
+                               &device->resource);
+  iree_string_view_append_to_buffer(
+      identifier, &device->identifier,
+      (char*)device + iree_sizeof_struct(*device));
+  device->host_allocator = host_allocator;
+  iree_arena_block_pool_initialize(32 * 1024, host_allocator,
+                                   &device->block_pool);
+  device->handle = handle;
+  device->queue = wgpuDeviceGetQueue(handle);
+
+  iree_status_t status = iree_hal_webgpu_allocator_create(
+      handle, host_allocator, &device->device_allocator);
+
+  if (iree_status_is_ok(status)) {
+    *out_device = (iree_hal_device_t*)device;
+  } else {
+    iree_hal_device_release((iree_hal_device_t*)device);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_device_destroy(iree_hal_device_t* base_device) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // There should be no more buffers live that use the allocator.
+  iree_hal_allocator_release(device->device_allocator);
+
+  iree_arena_block_pool_deinitialize(&device->block_pool);
+
+  // The WGPUDevice is owned by the hosting application.
+  iree_allocator_free(host_allocator, device);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_string_view_t iree_hal_webgpu_device_id(
+    iree_hal_device_t* base_device) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return device->identifier;
+}
+
+static iree_allocator_t iree_hal_webgpu_device_host_allocator(
+    iree_hal_device_t* base_device) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return device->host_allocator;
+}
+
+static iree_hal_allocator_t* iree_hal_webgpu_device_allocator(
+    iree_hal_device_t* base_device) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return device->device_allocator;
+}
+
+static iree_status_t iree_hal_webgpu_device_trim(
+    iree_hal_device_t* base_device) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  iree_arena_block_pool_trim(&device->block_pool);
+  return iree_hal_allocator_trim(device->device_allocator);
+}
+
+static iree_status_t iree_hal_webgpu_device_query_i32(
+    iree_hal_device_t* base_device, iree_string_view_t category,
+    iree_string_view_t key, int32_t* out_value) {
+  *out_value = 0;
+
+  if (iree_string_view_equal(category,
+                             iree_make_cstring_view("hal.executable.format"))) {
+    *out_value =
+        iree_string_view_equal(
+            key, iree_make_cstring_view(IREE_HAL_WEBGPU_EXECUTABLE_FORMAT))
+            ? 1
+            : 0;
+    return iree_ok_status();
+  }
+
+  return iree_make_status(
+      IREE_STATUS_NOT_FOUND,
+      "unknown device configuration key value '%.*s :: %.*s'",
+      (int)category.size, category.data, (int)key.size, key.data);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_command_buffer(
+    iree_hal_device_t* base_device, iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  // WGPUCommandBuffers can only be submitted once so reusable command buffers
+  // are recorded in memory and replayed into a new one each submission.
+  if (iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
+    return iree_hal_webgpu_command_buffer_create(
+        base_device, device->handle, mode, command_categories, queue_affinity,
+        device->host_allocator, out_command_buffer);
+  }
+  return iree_hal_deferred_command_buffer_create(
+      base_device, mode, command_categories, &device->block_pool,
+      device->host_allocator, out_command_buffer);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_descriptor_set(
+    iree_hal_device_t* base_device,
+    iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_hal_descriptor_set_t** out_descriptor_set) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_descriptor_set_create(
+      device->handle, set_layout, binding_count, bindings,
+      device->host_allocator, out_descriptor_set);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_descriptor_set_layout(
+    iree_hal_device_t* base_device,
+    iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_descriptor_set_layout_create(
+      device->handle, usage_type, binding_count, bindings,
+      device->host_allocator, out_descriptor_set_layout);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_event(
+    iree_hal_device_t* base_device, iree_hal_event_t** out_event) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "WebGPU has no events; command buffer execution "
+                          "is always ordered");
+}
+
+static iree_status_t iree_hal_webgpu_device_create_executable_cache(
+    iree_hal_device_t* base_device, iree_string_view_t identifier,
+    iree_hal_executable_cache_t** out_executable_cache) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_nop_executable_cache_create(
+      device->handle, identifier, device->host_allocator,
+      out_executable_cache);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_executable_layout(
+    iree_hal_device_t* base_device, iree_host_size_t push_constants,
+    iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_hal_executable_layout_t** out_executable_layout) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_executable_layout_create(
+      device->handle, set_layout_count, set_layouts, push_constants,
+      device->host_allocator, out_executable_layout);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_semaphore(
+    iree_hal_device_t* base_device, uint64_t initial_value,
+    iree_hal_semaphore_t** out_semaphore) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_semaphore_create(device->handle, initial_value,
+                                          device->host_allocator,
+                                          out_semaphore);
+}
+
+// Submits |command_buffer| to the device queue. Deferred command buffers are
+// replayed into a transient WebGPU command buffer first.
+static iree_status_t iree_hal_webgpu_device_submit_command_buffer(
+    iree_hal_webgpu_device_t* device,
+    iree_hal_command_buffer_t* command_buffer) {
+  if (iree_hal_webgpu_command_buffer_isa(command_buffer)) {
+    WGPUCommandBuffer handle =
+        iree_hal_webgpu_command_buffer_handle(command_buffer);
+    wgpuQueueSubmit(device->queue, 1, &handle);
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_command_buffer_t* transient_command_buffer = NULL;
+  iree_status_t status = iree_hal_webgpu_command_buffer_create(
+      (iree_hal_device_t*)device, device->handle,
+      IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      iree_hal_command_buffer_allowed_categories(command_buffer),
+      IREE_HAL_QUEUE_AFFINITY_ANY, device->host_allocator,
+      &transient_command_buffer);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_deferred_command_buffer_apply(command_buffer,
+                                                    transient_command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    WGPUCommandBuffer handle =
+        iree_hal_webgpu_command_buffer_handle(transient_command_buffer);
+    wgpuQueueSubmit(device->queue, 1, &handle);
+  }
+  iree_hal_command_buffer_release(transient_command_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_webgpu_device_queue_submit(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; iree_status_is_ok(status) && i < batch_count;
+       ++i) {
+    const iree_hal_submission_batch_t* batch = &batches[i];
+
+    // WebGPU queues cannot wait on anything so waits happen on the host
+    // before the batch is submitted.
+    for (iree_host_size_t j = 0;
+         iree_status_is_ok(status) && j < batch->wait_semaphores.count; ++j) {
+      status = iree_hal_semaphore_wait(
+          batch->wait_semaphores.semaphores[j],
+          batch->wait_semaphores.payload_values[j], iree_infinite_timeout());
+    }
+
+    for (iree_host_size_t j = 0;
+         iree_status_is_ok(status) && j < batch->command_buffer_count; ++j) {
+      status = iree_hal_webgpu_device_submit_command_buffer(
+          device, batch->command_buffers[j]);
+    }
+
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_webgpu_semaphore_list_signal_on_completion(
+          device->queue, &batch->signal_semaphores, device->host_allocator);
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_webgpu_device_submit_and_wait(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches,
+    iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
+    iree_timeout_t timeout) {
+  // Submit...
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_device_queue_submit(
+      base_device, command_categories, queue_affinity, batch_count, batches));
+
+  // ...and wait.
+  return iree_hal_semaphore_wait(wait_semaphore, wait_value, timeout);
+}
+
+static iree_status_t iree_hal_webgpu_device_wait_semaphores(
+    iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Convert to an absolute deadline so that sequential waits share it.
+  timeout = iree_make_deadline(iree_timeout_as_deadline_ns(timeout));
+
+  iree_status_t status = iree_ok_status();
+  if (wait_mode == IREE_HAL_WAIT_MODE_ALL) {
+    for (iree_host_size_t i = 0;
+         iree_status_is_ok(status) && i < semaphore_list->count; ++i) {
+      status = iree_hal_semaphore_wait(semaphore_list->semaphores[i],
+                                       semaphore_list->payload_values[i],
+                                       timeout);
+    }
+  } else {
+    // Poll until any semaphore reaches its value; all signals are delivered
+    // from the WebGPU event loop.
+    iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+    bool any_reached = false;
+    while (iree_status_is_ok(status) && !any_reached) {
+      for (iree_host_size_t i = 0;
+           iree_status_is_ok(status) && i < semaphore_list->count; ++i) {
+        uint64_t value = 0;
+        status = iree_hal_semaphore_query(semaphore_list->semaphores[i],
+                                          &value);
+        if (value >= semaphore_list->payload_values[i]) any_reached = true;
+      }
+      if (!iree_status_is_ok(status) || any_reached) break;
+      if (iree_time_now() >= deadline_ns) {
+        status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+        break;
+      }
+      status = iree_hal_webgpu_process_events(device->handle);
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_device_work_done_callback(
+    WGPUQueueWorkDoneStatus status, void* user_data) {
+  *(volatile bool*)user_data = true;
+}
+
+static iree_status_t iree_hal_webgpu_device_wait_idle(
+    iree_hal_device_t* base_device, iree_timeout_t timeout) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // NOTE: the flag must outlive the callback and so this always waits for the
+  // queue to drain even if |timeout| elapses; the timeout only controls the
+  // returned status.
+  volatile bool is_idle = false;
+  wgpuQueueOnSubmittedWorkDone(device->queue, /*signalValue=*/0,
+                               iree_hal_webgpu_device_work_done_callback,
+                               (void*)&is_idle);
+  iree_status_t status =
+      iree_hal_webgpu_wait_for_flag(device->handle, &is_idle, timeout);
+  if (iree_status_is_deadline_exceeded(status)) {
+    iree_status_t drain_status = iree_hal_webgpu_wait_for_flag(
+        device->handle, &is_idle, iree_infinite_timeout());
+    iree_status_ignore(drain_status);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static const iree_hal_device_vtable_t iree_hal_webgpu_device_vtable = {
+    .destroy = iree_hal_webgpu_device_destroy,
+    .id = iree_hal_webgpu_device_id,
+    .host_allocator = iree_hal_webgpu_device_host_allocator,
+    .device_allocator = iree_hal_webgpu_device_allocator,
+    .trim = iree_hal_webgpu_device_trim,
+    .query_i32 = iree_hal_webgpu_device_query_i32,
+    .create_command_buffer = iree_hal_webgpu_device_create_command_buffer,
+    .create_descriptor_set = iree_hal_webgpu_device_create_descriptor_set,
+    .create_descriptor_set_layout =
+        iree_hal_webgpu_device_create_descriptor_set_layout,
+    .create_event = iree_hal_webgpu_device_create_event,
+    .create_executable_cache = iree_hal_webgpu_device_create_executable_cache,
+    .create_executable_layout = iree_hal_webgpu_device_create_executable_layout,
+    .create_semaphore = iree_hal_webgpu_device_create_semaphore,
+    .transfer_range = iree_hal_device_submit_transfer_range_and_wait,
+    .queue_submit = iree_hal_webgpu_device_queue_submit,
+    .submit_and_wait = iree_hal_webgpu_device_submit_and_wait,
+    .wait_semaphores = iree_hal_webgpu_device_wait_semaphores,
+    .wait_idle = iree_hal_webgpu_device_wait_idle,
+};
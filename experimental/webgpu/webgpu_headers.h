@@ -0,0 +1,14 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_WEBGPU_HEADERS_H_
+#define IREE_HAL_WEBGPU_WEBGPU_HEADERS_H_
+
+// The standard webgpu.h C API. Emscripten provides it with -sUSE_WEBGPU=1 and
+// native implementations (Dawn, wgpu-native) ship the same header.
+#include <webgpu/webgpu.h>  // IWYU pragma: export
+
+#endif  // IREE_HAL_WEBGPU_WEBGPU_HEADERS_H_
@@ -85,6 +85,11 @@ typedef IREE_HOST_SIZE_T iree_host_size_t;
 // Size, in bytes, of a buffer on remote devices.
 typedef IREE_DEVICE_SIZE_T iree_device_size_t;
 
+// Maximum value of iree_device_size_t.
+#if !defined(IREE_DEVICE_SIZE_MAX)
+#define IREE_DEVICE_SIZE_MAX (~(iree_device_size_t)0)
+#endif  // !IREE_DEVICE_SIZE_MAX
+
 //===----------------------------------------------------------------------===//
 // iree_status_t configuration
 //===----------------------------------------------------------------------===//
@@ -149,6 +154,14 @@ typedef IREE_DEVICE_SIZE_T iree_device_size_t;
 #define IREE_STATISTICS_ENABLE 1
 #endif  // !IREE_STATISTICS_ENABLE
 
+// Enables the iree/base/profiler.h event hooks. When enabled and no profiler
+// is registered each hook costs a relaxed atomic load and a predicted branch.
+// Disabling removes the hooks entirely.
+
+#if !defined(IREE_PROFILER_ENABLE)
+#define IREE_PROFILER_ENABLE 1
+#endif  // !IREE_PROFILER_ENABLE
+
 //===----------------------------------------------------------------------===//
 // IREE HAL configuration
 //===----------------------------------------------------------------------===//
@@ -217,6 +230,13 @@ typedef IREE_DEVICE_SIZE_T iree_device_size_t;
 #define IREE_VM_EXECUTION_TRACING_SRC_LOC_ENABLE 0
 #endif  // !IREE_VM_EXECUTION_TRACING_SRC_LOC_ENABLE
 
+#if !defined(IREE_VM_EXECUTION_PROFILING_ENABLE)
+// Enables per-function profiling of bytecode execution for invocations with
+// IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION. When compiled in but not used the
+// interpreter only pays for an instruction counter kept in a register.
+#define IREE_VM_EXECUTION_PROFILING_ENABLE 1
+#endif  // !IREE_VM_EXECUTION_PROFILING_ENABLE
+
 #if !defined(IREE_VM_EXT_I64_ENABLE)
 // Enables the 64-bit integer instruction extension.
 // Targeted from the compiler with `-iree-vm-target-extension-i64`.
@@ -235,4 +255,20 @@ typedef IREE_DEVICE_SIZE_T iree_device_size_t;
 #define IREE_VM_EXT_F64_ENABLE 0
 #endif  // !IREE_VM_EXT_F64_ENABLE
 
+#if !defined(IREE_VM_BYTECODE_VERIFICATION_ENABLE)
+// Verifies bytecode modules when they are loaded and elides the checks the
+// verifier guarantees (register and module table ordinal ranges) from the
+// interpreter. Disabling this skips the load-time verification but keeps the
+// defensive checks on every executed instruction.
+#define IREE_VM_BYTECODE_VERIFICATION_ENABLE 1
+#endif  // !IREE_VM_BYTECODE_VERIFICATION_ENABLE
+
+#if !defined(IREE_VM_BYTECODE_COMPRESSION_ENABLE)
+// Enables loading bytecode modules with compressed rodata segments (produced
+// with `-iree-vm-bytecode-module-compress-rodata`). Disabling this drops the
+// decompressor from the runtime and modules with compressed segments will fail
+// to load.
+#define IREE_VM_BYTECODE_COMPRESSION_ENABLE 1
+#endif  // !IREE_VM_BYTECODE_COMPRESSION_ENABLE
+
 #endif  // IREE_BASE_CONFIG_H_
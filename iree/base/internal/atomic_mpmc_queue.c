@@ -0,0 +1,118 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/atomic_mpmc_queue.h"
+
+#include <string.h>
+
+// Each cell has a sequence number that coordinates ownership between producers
+// and consumers. For a cell at index i the sequence is:
+//   pos      : empty and ready for the enqueue at position |pos|
+//   pos + 1  : full with the value enqueued at position |pos|
+//   pos + cap: empty and ready for the enqueue one lap later
+// Producers and consumers claim positions by compare-exchanging the respective
+// position counter and then publish their access by storing the next sequence.
+
+iree_status_t iree_atomic_mpmc_queue_initialize(
+    iree_host_size_t capacity, iree_allocator_t host_allocator,
+    iree_atomic_mpmc_queue_t* out_queue) {
+  IREE_ASSERT_ARGUMENT(out_queue);
+  memset(out_queue, 0, sizeof(*out_queue));
+  if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "queue capacity must be a power of two >= 2; got "
+                            "%zu",
+                            capacity);
+  }
+  out_queue->host_allocator = host_allocator;
+  out_queue->capacity_mask = capacity - 1;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      host_allocator, capacity * sizeof(out_queue->cells[0]),
+      (void**)&out_queue->cells));
+  for (iree_host_size_t i = 0; i < capacity; ++i) {
+    iree_atomic_store_intptr(&out_queue->cells[i].sequence, (intptr_t)i,
+                             iree_memory_order_relaxed);
+    out_queue->cells[i].value = NULL;
+  }
+  iree_atomic_store_intptr(&out_queue->enqueue_position, 0,
+                           iree_memory_order_relaxed);
+  iree_atomic_store_intptr(&out_queue->dequeue_position, 0,
+                           iree_memory_order_relaxed);
+  return iree_ok_status();
+}
+
+void iree_atomic_mpmc_queue_deinitialize(iree_atomic_mpmc_queue_t* queue) {
+  if (!queue->cells) return;
+  iree_allocator_free(queue->host_allocator, queue->cells);
+  queue->cells = NULL;
+}
+
+bool iree_atomic_mpmc_queue_try_enqueue(iree_atomic_mpmc_queue_t* queue,
+                                        void* value) {
+  intptr_t position = iree_atomic_load_intptr(&queue->enqueue_position,
+                                              iree_memory_order_relaxed);
+  iree_atomic_mpmc_queue_cell_t* cell = NULL;
+  for (;;) {
+    cell = &queue->cells[position & queue->capacity_mask];
+    intptr_t sequence =
+        iree_atomic_load_intptr(&cell->sequence, iree_memory_order_acquire);
+    intptr_t delta = sequence - position;
+    if (delta == 0) {
+      // Cell is empty for this lap; try to claim the position.
+      if (iree_atomic_compare_exchange_weak_intptr(
+              &queue->enqueue_position, &position, position + 1,
+              iree_memory_order_relaxed, iree_memory_order_relaxed)) {
+        break;
+      }
+      // Lost the race; |position| was updated with the latest value.
+    } else if (delta < 0) {
+      // Cell still holds the value from the previous lap; queue is full.
+      return false;
+    } else {
+      // Another producer claimed the position; reload and try again.
+      position = iree_atomic_load_intptr(&queue->enqueue_position,
+                                         iree_memory_order_relaxed);
+    }
+  }
+  cell->value = value;
+  iree_atomic_store_intptr(&cell->sequence, position + 1,
+                           iree_memory_order_release);
+  return true;
+}
+
+bool iree_atomic_mpmc_queue_try_dequeue(iree_atomic_mpmc_queue_t* queue,
+                                        void** out_value) {
+  intptr_t position = iree_atomic_load_intptr(&queue->dequeue_position,
+                                              iree_memory_order_relaxed);
+  iree_atomic_mpmc_queue_cell_t* cell = NULL;
+  for (;;) {
+    cell = &queue->cells[position & queue->capacity_mask];
+    intptr_t sequence =
+        iree_atomic_load_intptr(&cell->sequence, iree_memory_order_acquire);
+    intptr_t delta = sequence - (position + 1);
+    if (delta == 0) {
+      // Cell is full for this lap; try to claim the position.
+      if (iree_atomic_compare_exchange_weak_intptr(
+              &queue->dequeue_position, &position, position + 1,
+              iree_memory_order_relaxed, iree_memory_order_relaxed)) {
+        break;
+      }
+    } else if (delta < 0) {
+      // Cell has not been published yet; queue is (effectively) empty.
+      return false;
+    } else {
+      // Another consumer claimed the position; reload and try again.
+      position = iree_atomic_load_intptr(&queue->dequeue_position,
+                                         iree_memory_order_relaxed);
+    }
+  }
+  *out_value = cell->value;
+  // Make the cell available to the enqueue one lap from now.
+  iree_atomic_store_intptr(&cell->sequence,
+                           position + (intptr_t)queue->capacity_mask + 1,
+                           iree_memory_order_release);
+  return true;
+}
@@ -0,0 +1,94 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// NOTE: the best kind of synchronization is no synchronization; always try to
+// design your algorithm so that you don't need anything from this file :)
+// See https://travisdowns.github.io/blog/2020/07/06/concurrency-costs.html
+
+#ifndef IREE_BASE_INTERNAL_ATOMIC_MPMC_QUEUE_H_
+#define IREE_BASE_INTERNAL_ATOMIC_MPMC_QUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iree/base/alignment.h"
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// DO NOT USE: implementation detail.
+typedef struct iree_atomic_mpmc_queue_cell_t {
+  // Position of the enqueue or dequeue that may next access this cell.
+  iree_atomic_intptr_t sequence;
+  void* value;
+} iree_atomic_mpmc_queue_cell_t;
+
+// Bounded lock-free multi-producer/multi-consumer FIFO queue of pointers.
+// This is Dmitry Vyukov's bounded MPMC queue:
+// https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+//
+// Unlike iree_atomic_slist_t values are dequeued in the same order they were
+// enqueued (as ordered by the successful enqueue operations across all
+// producers). Each enqueue and dequeue is a single compare-exchange on the
+// respective position counter in the uncontended case and producers and
+// consumers never touch the same cache line unless the queue is nearly empty
+// or full.
+//
+// The queue has a fixed capacity established at initialization and enqueues
+// fail when the queue is full. Callers must have a fallback such as a slower
+// unbounded list or retrying after draining. Neither end ever blocks: a
+// producer that stalls between reserving a cell and publishing its value will
+// cause consumers to see the queue as empty until the value is published.
+typedef struct iree_atomic_mpmc_queue_t {
+  // Position of the next enqueue; modified by producers.
+  iree_alignas(iree_hardware_destructive_interference_size)
+      iree_atomic_intptr_t enqueue_position;
+  // Position of the next dequeue; modified by consumers.
+  iree_alignas(iree_hardware_destructive_interference_size)
+      iree_atomic_intptr_t dequeue_position;
+  // Immutable after initialization.
+  iree_alignas(iree_hardware_destructive_interference_size)
+      iree_host_size_t capacity_mask;
+  iree_atomic_mpmc_queue_cell_t* cells;
+  iree_allocator_t host_allocator;
+} iree_atomic_mpmc_queue_t;
+
+// Initializes a queue able to hold up to |capacity| values in |out_queue|.
+// |capacity| must be a power of two >= 2.
+iree_status_t iree_atomic_mpmc_queue_initialize(
+    iree_host_size_t capacity, iree_allocator_t host_allocator,
+    iree_atomic_mpmc_queue_t* out_queue);
+
+// Deinitializes |queue| and releases its storage.
+// Any values remaining in the queue are discarded.
+void iree_atomic_mpmc_queue_deinitialize(iree_atomic_mpmc_queue_t* queue);
+
+// Returns the maximum number of values the queue can hold.
+static inline iree_host_size_t iree_atomic_mpmc_queue_capacity(
+    const iree_atomic_mpmc_queue_t* queue) {
+  return queue->capacity_mask + 1;
+}
+
+// Enqueues |value| at the tail of the queue.
+// Returns false if the queue is full and the value was not enqueued.
+bool iree_atomic_mpmc_queue_try_enqueue(iree_atomic_mpmc_queue_t* queue,
+                                        void* value);
+
+// Dequeues the value at the head of the queue into |out_value|.
+// Returns false if the queue is empty (or the producer of the head value has
+// not yet published it).
+bool iree_atomic_mpmc_queue_try_dequeue(iree_atomic_mpmc_queue_t* queue,
+                                        void** out_value);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // IREE_BASE_INTERNAL_ATOMIC_MPMC_QUEUE_H_
@@ -0,0 +1,89 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstddef>
+#include <deque>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/internal/atomic_mpmc_queue.h"
+#include "iree/base/internal/atomic_slist.h"
+#include "iree/base/internal/synchronization.h"
+
+namespace {
+
+// Each benchmark thread alternates between producing and consuming a value
+// such that the queue stays shallow and all threads contend on both ends. This
+// models many client threads submitting work to a single shared queue.
+
+//==============================================================================
+// iree_atomic_mpmc_queue_t
+//==============================================================================
+
+void BM_AtomicMPMCQueue(benchmark::State& state) {
+  static iree_atomic_mpmc_queue_t* queue = ([]() {
+    auto* queue = new iree_atomic_mpmc_queue_t();
+    IREE_CHECK_OK(iree_atomic_mpmc_queue_initialize(
+        1024, iree_allocator_system(), queue));
+    return queue;
+  })();
+  for (auto _ : state) {
+    while (!iree_atomic_mpmc_queue_try_enqueue(queue, (void*)queue)) {
+    }
+    void* value = NULL;
+    while (!iree_atomic_mpmc_queue_try_dequeue(queue, &value)) {
+    }
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK(BM_AtomicMPMCQueue)->UseRealTime()->Threads(1)->ThreadPerCpu();
+
+//==============================================================================
+// iree_atomic_slist_t (LIFO; for comparison)
+//==============================================================================
+
+void BM_AtomicSList(benchmark::State& state) {
+  static iree_atomic_slist_t* list = ([]() {
+    auto* list = new iree_atomic_slist_t();
+    iree_atomic_slist_initialize(list);
+    return list;
+  })();
+  iree_atomic_slist_entry_t entry;
+  for (auto _ : state) {
+    iree_atomic_slist_push(list, &entry);
+    iree_atomic_slist_entry_t* popped = NULL;
+    while (!(popped = iree_atomic_slist_pop(list))) {
+    }
+    benchmark::DoNotOptimize(popped);
+  }
+}
+BENCHMARK(BM_AtomicSList)->UseRealTime()->Threads(1)->ThreadPerCpu();
+
+//==============================================================================
+// iree_slim_mutex_t + std::deque (for comparison)
+//==============================================================================
+
+void BM_SlimMutexDeque(benchmark::State& state) {
+  static iree_slim_mutex_t* mu = ([]() {
+    auto* mu = new iree_slim_mutex_t();
+    iree_slim_mutex_initialize(mu);
+    return mu;
+  })();
+  static std::deque<void*>* deque = new std::deque<void*>();
+  for (auto _ : state) {
+    iree_slim_mutex_lock(mu);
+    deque->push_back((void*)deque);
+    iree_slim_mutex_unlock(mu);
+    void* value = NULL;
+    iree_slim_mutex_lock(mu);
+    value = deque->front();
+    deque->pop_front();
+    iree_slim_mutex_unlock(mu);
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK(BM_SlimMutexDeque)->UseRealTime()->Threads(1)->ThreadPerCpu();
+
+}  // namespace
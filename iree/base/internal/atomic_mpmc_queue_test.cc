@@ -0,0 +1,145 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/atomic_mpmc_queue.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// Values are encoded as non-NULL pointers to make NULL handling obvious.
+void* MakeValue(uintptr_t value) { return (void*)(value + 1); }
+uintptr_t GetValue(void* value) { return (uintptr_t)value - 1; }
+
+TEST(AtomicMPMCQueue, Lifetime) {
+  iree_atomic_mpmc_queue_t queue;
+  IREE_ASSERT_OK(
+      iree_atomic_mpmc_queue_initialize(16, iree_allocator_system(), &queue));
+  EXPECT_EQ(16, iree_atomic_mpmc_queue_capacity(&queue));
+  iree_atomic_mpmc_queue_deinitialize(&queue);
+}
+
+TEST(AtomicMPMCQueue, InvalidCapacity) {
+  iree_atomic_mpmc_queue_t queue;
+  iree_status_t status =
+      iree_atomic_mpmc_queue_initialize(0, iree_allocator_system(), &queue);
+  EXPECT_TRUE(iree_status_is_invalid_argument(status));
+  iree_status_ignore(status);
+  status =
+      iree_atomic_mpmc_queue_initialize(12, iree_allocator_system(), &queue);
+  EXPECT_TRUE(iree_status_is_invalid_argument(status));
+  iree_status_ignore(status);
+}
+
+TEST(AtomicMPMCQueue, FIFO) {
+  iree_atomic_mpmc_queue_t queue;
+  IREE_ASSERT_OK(
+      iree_atomic_mpmc_queue_initialize(4, iree_allocator_system(), &queue));
+
+  // Queue starts empty.
+  void* value = NULL;
+  EXPECT_FALSE(iree_atomic_mpmc_queue_try_dequeue(&queue, &value));
+
+  // Fill the queue; the next enqueue must fail.
+  for (uintptr_t i = 0; i < 4; ++i) {
+    EXPECT_TRUE(iree_atomic_mpmc_queue_try_enqueue(&queue, MakeValue(i)));
+  }
+  EXPECT_FALSE(iree_atomic_mpmc_queue_try_enqueue(&queue, MakeValue(4)));
+
+  // Values come out in the order they went in.
+  for (uintptr_t i = 0; i < 4; ++i) {
+    ASSERT_TRUE(iree_atomic_mpmc_queue_try_dequeue(&queue, &value));
+    EXPECT_EQ(i, GetValue(value));
+  }
+  EXPECT_FALSE(iree_atomic_mpmc_queue_try_dequeue(&queue, &value));
+
+  iree_atomic_mpmc_queue_deinitialize(&queue);
+}
+
+TEST(AtomicMPMCQueue, WrapAround) {
+  iree_atomic_mpmc_queue_t queue;
+  IREE_ASSERT_OK(
+      iree_atomic_mpmc_queue_initialize(4, iree_allocator_system(), &queue));
+  // Interleave enqueues and dequeues such that many laps are made around the
+  // ring while it is partially full.
+  uintptr_t next_enqueue = 0;
+  uintptr_t next_dequeue = 0;
+  for (int lap = 0; lap < 100; ++lap) {
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(iree_atomic_mpmc_queue_try_enqueue(
+          &queue, MakeValue(next_enqueue++)));
+    }
+    for (int i = 0; i < 2; ++i) {
+      void* value = NULL;
+      ASSERT_TRUE(iree_atomic_mpmc_queue_try_dequeue(&queue, &value));
+      EXPECT_EQ(next_dequeue++, GetValue(value));
+    }
+    void* value = NULL;
+    ASSERT_TRUE(iree_atomic_mpmc_queue_try_dequeue(&queue, &value));
+    EXPECT_EQ(next_dequeue++, GetValue(value));
+  }
+  iree_atomic_mpmc_queue_deinitialize(&queue);
+}
+
+// Multiple producers publish sequences tagged with their producer ID and
+// multiple consumers drain them. Every value must be received exactly once and
+// each consumer must observe the values of any one producer in order.
+TEST(AtomicMPMCQueue, MultipleProducersConsumers) {
+  static constexpr int kProducerCount = 4;
+  static constexpr int kConsumerCount = 4;
+  static constexpr uintptr_t kValuesPerProducer = 10000;
+  iree_atomic_mpmc_queue_t queue;
+  IREE_ASSERT_OK(
+      iree_atomic_mpmc_queue_initialize(64, iree_allocator_system(), &queue));
+
+  std::vector<std::atomic<int>> received(kProducerCount * kValuesPerProducer);
+  for (auto& count : received) count = 0;
+  std::atomic<uintptr_t> total_received = {0};
+  std::atomic<bool> order_violated = {false};
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducerCount; ++p) {
+    threads.emplace_back([&, p]() {
+      for (uintptr_t i = 0; i < kValuesPerProducer; ++i) {
+        void* value = MakeValue(p * kValuesPerProducer + i);
+        while (!iree_atomic_mpmc_queue_try_enqueue(&queue, value)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int c = 0; c < kConsumerCount; ++c) {
+    threads.emplace_back([&]() {
+      std::vector<intptr_t> last_seen(kProducerCount, -1);
+      while (total_received.load() < kProducerCount * kValuesPerProducer) {
+        void* value = NULL;
+        if (!iree_atomic_mpmc_queue_try_dequeue(&queue, &value)) {
+          std::this_thread::yield();
+          continue;
+        }
+        uintptr_t index = GetValue(value);
+        uintptr_t producer = index / kValuesPerProducer;
+        intptr_t sequence = (intptr_t)(index % kValuesPerProducer);
+        if (sequence <= last_seen[producer]) order_violated = true;
+        last_seen[producer] = sequence;
+        ++received[index];
+        ++total_received;
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  EXPECT_FALSE(order_violated);
+  for (auto& count : received) EXPECT_EQ(1, count.load());
+  iree_atomic_mpmc_queue_deinitialize(&queue);
+}
+
+}  // namespace
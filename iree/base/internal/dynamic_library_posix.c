@@ -23,12 +23,34 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+#include <sys/syscall.h>
+#if defined(SYS_memfd_create)
+// memfd_create is only exposed by glibc 2.27+ and bionic API 30+ but the
+// syscall has been available since Linux 3.17.
+#define IREE_DYNAMIC_LIBRARY_HAVE_MEMFD 1
+#if !defined(MFD_CLOEXEC)
+#define MFD_CLOEXEC 0x0001U
+#endif  // !MFD_CLOEXEC
+#endif  // SYS_memfd_create
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
+#if defined(IREE_PLATFORM_ANDROID) && __ANDROID_API__ >= 21
+#include <android/dlext.h>
+#define IREE_DYNAMIC_LIBRARY_HAVE_ANDROID_DLOPEN_EXT 1
+#endif  // IREE_PLATFORM_ANDROID && __ANDROID_API__ >= 21
+
 struct iree_dynamic_library_t {
   iree_atomic_ref_count_t ref_count;
   iree_allocator_t allocator;
 
   // dlopen shared object handle.
   void* handle;
+
+  // In-memory file the library was loaded from or -1 if loaded from disk.
+  // Kept open for the lifetime of the library so that tools inspecting the
+  // process (debuggers, profilers) can still resolve /proc/self/fd/N.
+  int memfd;
 };
 
 // Returns true if the temp files we extract should be kept after the library
@@ -150,6 +172,7 @@ static iree_status_t iree_dynamic_library_create(
   iree_atomic_ref_count_init(&library->ref_count);
   library->allocator = allocator;
   library->handle = handle;
+  library->memfd = -1;
 
   *out_library = library;
   return iree_ok_status();
@@ -196,10 +219,108 @@ iree_status_t iree_dynamic_library_load_from_files(
   return status;
 }
 
-// TODO(#3845): use dlopen on an fd with either dlopen(/proc/self/fd/NN),
-// fdlopen, or android_dlopen_ext to avoid needing to write the file to disk.
-// Can fallback to memfd_create + dlopen where available, and fallback from
-// that to disk (maybe just windows/mac).
+#if defined(IREE_DYNAMIC_LIBRARY_HAVE_MEMFD)
+
+// Creates an anonymous in-memory file containing |source_data|.
+// The file is named after |identifier| (truncated) in |name| in order to make
+// it easier to identify in /proc/self/maps and tools.
+static iree_status_t iree_dynamic_library_write_memfd(
+    iree_string_view_t identifier, iree_const_byte_span_t source_data,
+    char* name, iree_host_size_t name_capacity, int* out_fd) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  *out_fd = -1;
+
+  snprintf(name, name_capacity, "iree_dylib_%.*s", (int)identifier.size,
+           identifier.data);
+  int fd = (int)syscall(SYS_memfd_create, name, MFD_CLOEXEC);
+  if (fd < 0) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "unable to memfd_create");
+  }
+
+  // Write all file bytes; large writes may be split.
+  const uint8_t* data = source_data.data;
+  iree_host_size_t remaining = source_data.data_length;
+  while (remaining > 0) {
+    ssize_t written = write(fd, data, remaining);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      iree_status_t status = iree_make_status(
+          iree_status_code_from_errno(errno),
+          "unable to write memfd span of %zu bytes", source_data.data_length);
+      close(fd);
+      IREE_TRACE_ZONE_END(z0);
+      return status;
+    }
+    data += written;
+    remaining -= (iree_host_size_t)written;
+  }
+
+  *out_fd = fd;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+// Loads a shared object from the in-memory file |fd| named |name|.
+static void* iree_dynamic_library_dlopen_fd(int fd, const char* name) {
+#if defined(IREE_DYNAMIC_LIBRARY_HAVE_ANDROID_DLOPEN_EXT)
+  // The Android linker may be prevented from opening /proc/self/fd paths by
+  // SELinux policy but can load directly from the fd.
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ANDROID_DLEXT_USE_LIBRARY_FD;
+  extinfo.library_fd = fd;
+  return android_dlopen_ext(name, RTLD_LAZY | RTLD_LOCAL, &extinfo);
+#else
+  char fd_path[32];
+  snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", fd);
+  return dlopen(fd_path, RTLD_LAZY | RTLD_LOCAL);
+#endif  // IREE_DYNAMIC_LIBRARY_HAVE_ANDROID_DLOPEN_EXT
+}
+
+// Loads |buffer| from an anonymous in-memory file without touching the
+// filesystem. Fails if memfd is unavailable (old kernels, seccomp policies,
+// no /proc mount, etc) or the library cannot be loaded from it.
+static iree_status_t iree_dynamic_library_load_from_memfd(
+    iree_string_view_t identifier, iree_const_byte_span_t buffer,
+    iree_allocator_t allocator, iree_dynamic_library_t** out_library) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  char name[64];
+  int fd = -1;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_dynamic_library_write_memfd(identifier, buffer, name,
+                                           sizeof(name), &fd));
+
+  void* handle = iree_dynamic_library_dlopen_fd(fd, name);
+  if (!handle) {
+    close(fd);
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "unable to dlopen memfd: %s", dlerror());
+  }
+
+  iree_dynamic_library_t* library = NULL;
+  iree_status_t status =
+      iree_dynamic_library_create(handle, allocator, &library);
+  if (iree_status_is_ok(status)) {
+    library->memfd = fd;
+    *out_library = library;
+  } else {
+    dlclose(handle);
+    close(fd);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+#endif  // IREE_DYNAMIC_LIBRARY_HAVE_MEMFD
+
+// Loads from an in-memory file on Linux/Android and falls back to writing the
+// library to a temp file elsewhere or when that fails.
+// TODO: use fdlopen where available (FreeBSD); Apple platforms have no
+// equivalent and always need the temp file.
 iree_status_t iree_dynamic_library_load_from_memory(
     iree_string_view_t identifier, iree_const_byte_span_t buffer,
     iree_dynamic_library_flags_t flags, iree_allocator_t allocator,
@@ -208,6 +329,20 @@ iree_status_t iree_dynamic_library_load_from_memory(
   IREE_ASSERT_ARGUMENT(out_library);
   *out_library = NULL;
 
+#if defined(IREE_DYNAMIC_LIBRARY_HAVE_MEMFD)
+  // Tools that need to find the library on disk after it has been closed
+  // still get a temp file when preservation is requested.
+  if (!iree_dynamic_library_should_preserve_temp_files()) {
+    iree_status_t status = iree_dynamic_library_load_from_memfd(
+        identifier, buffer, allocator, out_library);
+    if (iree_status_is_ok(status)) {
+      IREE_TRACE_ZONE_END(z0);
+      return status;
+    }
+    iree_status_ignore(status);
+  }
+#endif  // IREE_DYNAMIC_LIBRARY_HAVE_MEMFD
+
   // Extract the library to a temp file.
   char* temp_path = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -247,6 +382,9 @@ static void iree_dynamic_library_delete(iree_dynamic_library_t* library) {
   if (library->handle != NULL) {
     dlclose(library->handle);
   }
+  if (library->memfd >= 0) {
+    close(library->memfd);
+  }
 #endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
   iree_allocator_free(allocator, library);
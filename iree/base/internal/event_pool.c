@@ -135,18 +135,21 @@ void iree_event_pool_release(iree_event_pool_t* event_pool,
   // the ones that won't fit.
   iree_host_size_t remaining_count = event_count;
 
+  // Reset the events so that they are ready to be acquired again. Resetting
+  // may require a syscall per event and we do it prior to taking the lock so
+  // that concurrent acquires/releases don't wait on them. This wastes a reset
+  // on events that end up not fitting in the pool but that should be rare.
+  for (iree_host_size_t i = 0; i < event_count; ++i) {
+    iree_event_reset(&events[i]);
+  }
+
   // Try first to release to the pool.
-  // Note that we reset the events we add back to the pool so that they are
-  // ready to be acquired again.
   iree_slim_mutex_lock(&event_pool->mutex);
   iree_host_size_t to_pool_count =
       iree_min(event_pool->available_capacity - event_pool->available_count,
                event_count);
   if (to_pool_count > 0) {
     iree_host_size_t pool_base_index = event_pool->available_count;
-    for (iree_host_size_t i = 0; i < to_pool_count; ++i) {
-      iree_event_reset(&events[i]);
-    }
     memcpy(&event_pool->available_list[pool_base_index], events,
            to_pool_count * sizeof(iree_event_t));
     event_pool->available_count += to_pool_count;
@@ -154,8 +157,7 @@ void iree_event_pool_release(iree_event_pool_t* event_pool,
   }
   iree_slim_mutex_unlock(&event_pool->mutex);
 
-  // Deallocate the rest of the events. We don't bother resetting them as we are
-  // getting rid of them.
+  // Deallocate the rest of the events.
   if (remaining_count > 0) {
     IREE_TRACE_ZONE_BEGIN(z0);
     for (iree_host_size_t i = 0; i < remaining_count; ++i) {
@@ -33,11 +33,15 @@ void iree_event_pool_free(iree_event_pool_t* event_pool);
 // The returned events will be unsignaled and ready for use. Callers may set and
 // reset the events as much as they want prior to releasing them back to the
 // pool with iree_event_pool_release.
+//
+// The pool lock is taken once per call and callers needing multiple events
+// should acquire them all together instead of one at a time.
 iree_status_t iree_event_pool_acquire(iree_event_pool_t* event_pool,
                                       iree_host_size_t event_count,
                                       iree_event_t* out_events);
 
-// Releases one or more events back to the block pool.
+// Releases one or more events back to the pool. As with acquisition the pool
+// lock is taken once per call and batching releases is preferred.
 void iree_event_pool_release(iree_event_pool_t* event_pool,
                              iree_host_size_t event_count,
                              iree_event_t* events);
@@ -27,6 +27,16 @@
 #define IREE_SET_BINARY_MODE(handle) ((void)0)
 #endif  // IREE_PLATFORM_WINDOWS
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
+    defined(IREE_PLATFORM_LINUX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define IREE_FILE_MAP_POSIX 1
+#elif defined(IREE_PLATFORM_WINDOWS)
+#define IREE_FILE_MAP_WIN32 1
+#endif  // IREE_PLATFORM_*
+
 iree_status_t iree_file_exists(const char* path) {
   IREE_ASSERT_ARGUMENT(path);
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -105,6 +115,204 @@ iree_status_t iree_file_read_contents(const char* path,
   return status;
 }
 
+#if defined(IREE_FILE_MAP_POSIX) || defined(IREE_FILE_MAP_WIN32)
+
+// A live file mapping. Used as the |self| of the deallocator returned from
+// iree_file_map_contents so that the mapping can be released with
+// iree_allocator_free.
+typedef struct iree_file_mapping_t {
+  iree_allocator_t host_allocator;
+  void* base;
+  iree_host_size_t length;
+} iree_file_mapping_t;
+
+static iree_status_t iree_file_mapping_ctl(void* self,
+                                           iree_allocator_command_t command,
+                                           const void* params,
+                                           void** inout_ptr) {
+  if (command != IREE_ALLOCATOR_COMMAND_FREE) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "file mappings can only be freed");
+  }
+  iree_file_mapping_t* mapping = (iree_file_mapping_t*)self;
+  IREE_TRACE_ZONE_BEGIN(z0);
+#if defined(IREE_FILE_MAP_POSIX)
+  munmap(mapping->base, mapping->length);
+#else
+  UnmapViewOfFile(mapping->base);
+#endif  // IREE_FILE_MAP_POSIX
+  iree_allocator_free(mapping->host_allocator, mapping);
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+// Advises the system of the expected |access_hint| for the mapped pages.
+// Failures are ignored as the hints are purely advisory.
+static void iree_file_map_advise(void* base, iree_host_size_t length,
+                                 iree_file_access_hint_t access_hint) {
+#if defined(IREE_FILE_MAP_POSIX)
+  int advice = MADV_NORMAL;
+  switch (access_hint) {
+    default:
+    case IREE_FILE_ACCESS_HINT_DEFAULT:
+      return;
+    case IREE_FILE_ACCESS_HINT_SEQUENTIAL:
+      advice = MADV_SEQUENTIAL;
+      break;
+    case IREE_FILE_ACCESS_HINT_RANDOM:
+      advice = MADV_RANDOM;
+      break;
+    case IREE_FILE_ACCESS_HINT_WILL_NEED:
+      advice = MADV_WILLNEED;
+      break;
+  }
+  madvise(base, length, advice);
+#else
+  // TODO(benvanik): use PrefetchVirtualMemory for WILL_NEED on Windows 8+.
+  (void)base;
+  (void)length;
+  (void)access_hint;
+#endif  // IREE_FILE_MAP_POSIX
+}
+
+// Maps the entire file at |path| into memory as read-only.
+// Returns IREE_STATUS_OUT_OF_RANGE if the file is empty as zero-length
+// mappings are not supported by the platforms.
+static iree_status_t iree_file_map_platform(const char* path, void** out_base,
+                                            iree_host_size_t* out_length) {
+#if defined(IREE_FILE_MAP_POSIX)
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open file '%s'", path);
+  }
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) == -1) {
+    close(fd);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "size query of file '%s'", path);
+  }
+  iree_host_size_t length = (iree_host_size_t)stat_buf.st_size;
+  if (length == 0) {
+    close(fd);
+    return iree_status_from_code(IREE_STATUS_OUT_OF_RANGE);
+  }
+  void* base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  if (base == MAP_FAILED) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to map %zu bytes of file '%s'", length,
+                            path);
+  }
+  *out_base = base;
+  *out_length = length;
+  return iree_ok_status();
+#else
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return iree_make_status(iree_status_code_from_win32_error(GetLastError()),
+                            "failed to open file '%s'", path);
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    iree_status_t status =
+        iree_make_status(iree_status_code_from_win32_error(GetLastError()),
+                         "size query of file '%s'", path);
+    CloseHandle(file);
+    return status;
+  }
+  iree_host_size_t length = (iree_host_size_t)file_size.QuadPart;
+  if (length == 0) {
+    CloseHandle(file);
+    return iree_status_from_code(IREE_STATUS_OUT_OF_RANGE);
+  }
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  void* base =
+      mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, length) : NULL;
+  iree_status_t status = iree_ok_status();
+  if (!base) {
+    status =
+        iree_make_status(iree_status_code_from_win32_error(GetLastError()),
+                         "failed to map %zu bytes of file '%s'", length, path);
+  }
+  // The view keeps its own references to the mapping and file.
+  if (mapping) CloseHandle(mapping);
+  CloseHandle(file);
+  IREE_RETURN_IF_ERROR(status);
+  *out_base = base;
+  *out_length = length;
+  return iree_ok_status();
+#endif  // IREE_FILE_MAP_POSIX
+}
+
+iree_status_t iree_file_map_contents(const char* path,
+                                     iree_file_access_hint_t access_hint,
+                                     iree_allocator_t host_allocator,
+                                     iree_const_byte_span_t* out_contents,
+                                     iree_allocator_t* out_deallocator) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(out_contents);
+  IREE_ASSERT_ARGUMENT(out_deallocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  *out_contents = iree_make_const_byte_span(NULL, 0);
+  *out_deallocator = iree_allocator_null();
+
+  iree_file_mapping_t* mapping = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*mapping),
+                                (void**)&mapping));
+  mapping->host_allocator = host_allocator;
+  iree_status_t status =
+      iree_file_map_platform(path, &mapping->base, &mapping->length);
+  if (iree_status_is_ok(status)) {
+    iree_file_map_advise(mapping->base, mapping->length, access_hint);
+    *out_contents = iree_make_const_byte_span(mapping->base, mapping->length);
+    out_deallocator->self = mapping;
+    out_deallocator->ctl = iree_file_mapping_ctl;
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+  iree_allocator_free(host_allocator, mapping);
+
+  if (iree_status_is_out_of_range(status)) {
+    // Empty files can't be mapped; read them instead to get a valid pointer.
+    iree_status_ignore(status);
+    iree_byte_span_t contents = iree_make_byte_span(NULL, 0);
+    status = iree_file_read_contents(path, host_allocator, &contents);
+    if (iree_status_is_ok(status)) {
+      *out_contents =
+          iree_make_const_byte_span(contents.data, contents.data_length);
+      *out_deallocator = host_allocator;
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+#else
+
+iree_status_t iree_file_map_contents(const char* path,
+                                     iree_file_access_hint_t access_hint,
+                                     iree_allocator_t host_allocator,
+                                     iree_const_byte_span_t* out_contents,
+                                     iree_allocator_t* out_deallocator) {
+  IREE_ASSERT_ARGUMENT(out_contents);
+  IREE_ASSERT_ARGUMENT(out_deallocator);
+  // No file mapping support on this platform; read it all into memory.
+  iree_byte_span_t contents = iree_make_byte_span(NULL, 0);
+  IREE_RETURN_IF_ERROR(
+      iree_file_read_contents(path, host_allocator, &contents));
+  *out_contents =
+      iree_make_const_byte_span(contents.data, contents.data_length);
+  *out_deallocator = host_allocator;
+  return iree_ok_status();
+}
+
+#endif  // IREE_FILE_MAP_POSIX || IREE_FILE_MAP_WIN32
+
 iree_status_t iree_file_write_contents(const char* path,
                                        iree_const_byte_span_t content) {
   IREE_ASSERT_ARGUMENT(path);
@@ -183,6 +391,14 @@ iree_status_t iree_file_read_contents(const char* path,
   return iree_make_status(IREE_STATUS_UNAVAILABLE, "File I/O is disabled");
 }
 
+iree_status_t iree_file_map_contents(const char* path,
+                                     iree_file_access_hint_t access_hint,
+                                     iree_allocator_t host_allocator,
+                                     iree_const_byte_span_t* out_contents,
+                                     iree_allocator_t* out_deallocator) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE, "File I/O is disabled");
+}
+
 iree_status_t iree_file_write_contents(const char* path,
                                        iree_const_byte_span_t content) {
   return iree_make_status(IREE_STATUS_UNAVAILABLE, "File I/O is disabled");
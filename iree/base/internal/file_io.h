@@ -29,6 +29,38 @@ iree_status_t iree_file_read_contents(const char* path,
                                       iree_allocator_t allocator,
                                       iree_byte_span_t* out_contents);
 
+// Describes how the contents of a mapped file are expected to be accessed.
+// Hints are advisory and ignored on platforms that do not support them.
+typedef enum iree_file_access_hint_e {
+  // No particular access pattern; the system default read-ahead is used.
+  IREE_FILE_ACCESS_HINT_DEFAULT = 0,
+  // Contents will be read front-to-back (such as when parsing or hashing).
+  IREE_FILE_ACCESS_HINT_SEQUENTIAL,
+  // Contents will be accessed in no particular order and read-ahead is
+  // unlikely to help (such as sparsely used rodata).
+  IREE_FILE_ACCESS_HINT_RANDOM,
+  // The entire contents will be needed soon and should be read in eagerly.
+  IREE_FILE_ACCESS_HINT_WILL_NEED,
+} iree_file_access_hint_t;
+
+// Maps a file's contents into memory read-only.
+//
+// Pages are loaded on demand by the system as they are accessed and may be
+// shared with other processes mapping the same file. Large regions that are
+// never touched (such as unused rodata) are never read from disk and resident
+// pages can be evicted under memory pressure. Platforms without file mapping
+// support fall back to reading the file into memory from |host_allocator|.
+// |access_hint| is passed along to the system (madvise) to tune paging.
+//
+// Returns the contents of the file in |out_contents| and an allocator in
+// |out_deallocator| that must be used to free the contents data pointer with
+// iree_allocator_free. The allocator supports no other operations.
+iree_status_t iree_file_map_contents(const char* path,
+                                     iree_file_access_hint_t access_hint,
+                                     iree_allocator_t host_allocator,
+                                     iree_const_byte_span_t* out_contents,
+                                     iree_allocator_t* out_deallocator);
+
 // Synchronously writes a byte buffer into a file.
 // Existing contents are overwritten.
 iree_status_t iree_file_write_contents(const char* path,
@@ -0,0 +1,217 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/lz4.h"
+
+#include <string.h>
+
+// Shortest match that can be encoded.
+#define IREE_LZ4_MIN_MATCH 4
+// The last 5 bytes of a block are always literals.
+#define IREE_LZ4_LAST_LITERALS 5
+// The last match must start at least 12 bytes before the end of the block.
+#define IREE_LZ4_MF_LIMIT 12
+// Largest match offset representable in a sequence.
+#define IREE_LZ4_MAX_OFFSET 65535
+// Number of entries in the compressor hash table of recent positions.
+#define IREE_LZ4_HASH_LOG 12
+
+static inline uint32_t iree_lz4_read32(const uint8_t* ptr) {
+  uint32_t value;
+  memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+static inline uint32_t iree_lz4_hash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - IREE_LZ4_HASH_LOG);
+}
+
+// Writes the variable-length continuation of a length field that overflowed
+// its 4-bit token nibble. Returns NULL if |op| would pass |op_end|.
+static uint8_t* iree_lz4_write_length(uint8_t* op, const uint8_t* op_end,
+                                      iree_host_size_t length) {
+  for (; length >= 255; length -= 255) {
+    if (op >= op_end) return NULL;
+    *op++ = 255;
+  }
+  if (op >= op_end) return NULL;
+  *op++ = (uint8_t)length;
+  return op;
+}
+
+// Writes a sequence of |literal_length| literals from |literals| followed by a
+// match of |match_length| at |offset|. A |match_length| of 0 writes the final
+// literal-only sequence. Returns NULL if |op| would pass |op_end|.
+static uint8_t* iree_lz4_write_sequence(uint8_t* op, const uint8_t* op_end,
+                                        const uint8_t* literals,
+                                        iree_host_size_t literal_length,
+                                        iree_host_size_t offset,
+                                        iree_host_size_t match_length) {
+  if (op >= op_end) return NULL;
+  uint8_t* token = op++;
+  if (literal_length >= 15) {
+    *token = 15 << 4;
+    op = iree_lz4_write_length(op, op_end, literal_length - 15);
+    if (!op) return NULL;
+  } else {
+    *token = (uint8_t)(literal_length << 4);
+  }
+  if ((iree_host_size_t)(op_end - op) < literal_length) return NULL;
+  memcpy(op, literals, literal_length);
+  op += literal_length;
+  if (!match_length) return op;
+
+  if (op_end - op < 2) return NULL;
+  *op++ = (uint8_t)(offset & 0xFF);
+  *op++ = (uint8_t)(offset >> 8);
+  iree_host_size_t match_code = match_length - IREE_LZ4_MIN_MATCH;
+  if (match_code >= 15) {
+    *token |= 15;
+    op = iree_lz4_write_length(op, op_end, match_code - 15);
+  } else {
+    *token |= (uint8_t)match_code;
+  }
+  return op;
+}
+
+iree_host_size_t iree_lz4_compress(iree_const_byte_span_t source,
+                                   iree_byte_span_t target) {
+  const uint8_t* src = source.data;
+  const iree_host_size_t src_length = source.data_length;
+  uint8_t* op = target.data;
+  const uint8_t* op_end = target.data + target.data_length;
+
+  // Positions (relative to |src|) of the most recent occurrence of each hashed
+  // 4-byte sequence. Stale or colliding entries are rejected by comparing the
+  // actual bytes so a zeroed table is valid.
+  uint32_t hash_table[1 << IREE_LZ4_HASH_LOG];
+  memset(hash_table, 0, sizeof(hash_table));
+
+  iree_host_size_t anchor = 0;
+  if (src_length > IREE_LZ4_MF_LIMIT) {
+    const iree_host_size_t match_start_limit = src_length - IREE_LZ4_MF_LIMIT;
+    const iree_host_size_t match_end_limit =
+        src_length - IREE_LZ4_LAST_LITERALS;
+    iree_host_size_t ip = 0;
+    while (ip < match_start_limit) {
+      uint32_t sequence = iree_lz4_read32(src + ip);
+      uint32_t hash = iree_lz4_hash(sequence);
+      iree_host_size_t candidate = hash_table[hash];
+      hash_table[hash] = (uint32_t)ip;
+      if (candidate >= ip || ip - candidate > IREE_LZ4_MAX_OFFSET ||
+          iree_lz4_read32(src + candidate) != sequence) {
+        ++ip;
+        continue;
+      }
+
+      // Extend the match as far as allowed.
+      iree_host_size_t match_length = IREE_LZ4_MIN_MATCH;
+      while (ip + match_length < match_end_limit &&
+             src[candidate + match_length] == src[ip + match_length]) {
+        ++match_length;
+      }
+      op = iree_lz4_write_sequence(op, op_end, src + anchor, ip - anchor,
+                                   ip - candidate, match_length);
+      if (!op) return 0;
+      ip += match_length;
+      anchor = ip;
+    }
+  }
+
+  op = iree_lz4_write_sequence(op, op_end, src + anchor, src_length - anchor,
+                               /*offset=*/0, /*match_length=*/0);
+  if (!op) return 0;
+  return (iree_host_size_t)(op - target.data);
+}
+
+// Reads the continuation of a length field whose token nibble was 15.
+static iree_status_t iree_lz4_read_length(const uint8_t** ip,
+                                          const uint8_t* ip_end,
+                                          iree_host_size_t* length) {
+  uint8_t byte = 0;
+  do {
+    if (IREE_UNLIKELY(*ip >= ip_end)) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "lz4 block truncated in length field");
+    }
+    byte = *(*ip)++;
+    *length += byte;
+  } while (byte == 255);
+  return iree_ok_status();
+}
+
+iree_status_t iree_lz4_decompress(iree_const_byte_span_t source,
+                                  iree_byte_span_t target) {
+  const uint8_t* ip = source.data;
+  const uint8_t* ip_end = source.data + source.data_length;
+  uint8_t* op = target.data;
+  uint8_t* op_end = target.data + target.data_length;
+
+  for (;;) {
+    if (IREE_UNLIKELY(ip >= ip_end)) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "lz4 block truncated before a sequence");
+    }
+    const uint8_t token = *ip++;
+
+    // Literals.
+    iree_host_size_t literal_length = token >> 4;
+    if (literal_length == 15) {
+      IREE_RETURN_IF_ERROR(iree_lz4_read_length(&ip, ip_end, &literal_length));
+    }
+    if (IREE_UNLIKELY(literal_length > (iree_host_size_t)(ip_end - ip) ||
+                      literal_length > (iree_host_size_t)(op_end - op))) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "lz4 literal run out of bounds");
+    }
+    memcpy(op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+
+    // The final sequence has only literals.
+    if (ip == ip_end) break;
+
+    // Match.
+    if (IREE_UNLIKELY(ip_end - ip < 2)) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "lz4 block truncated in match offset");
+    }
+    const iree_host_size_t offset = (iree_host_size_t)ip[0] |
+                                    ((iree_host_size_t)ip[1] << 8);
+    ip += 2;
+    if (IREE_UNLIKELY(offset == 0 ||
+                      offset > (iree_host_size_t)(op - target.data))) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "lz4 match offset out of bounds");
+    }
+    iree_host_size_t match_length = token & 15;
+    if (match_length == 15) {
+      IREE_RETURN_IF_ERROR(iree_lz4_read_length(&ip, ip_end, &match_length));
+    }
+    match_length += IREE_LZ4_MIN_MATCH;
+    if (IREE_UNLIKELY(match_length > (iree_host_size_t)(op_end - op))) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "lz4 match out of bounds");
+    }
+    const uint8_t* match = op - offset;
+    if (offset >= match_length) {
+      memcpy(op, match, match_length);
+      op += match_length;
+    } else {
+      // Overlapping copies repeat the pattern and must go byte by byte.
+      for (iree_host_size_t i = 0; i < match_length; ++i) *op++ = *match++;
+    }
+  }
+
+  if (IREE_UNLIKELY(op != op_end)) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS,
+                            "lz4 block decompressed to %" PRIhsz
+                            " bytes but %" PRIhsz " were expected",
+                            (iree_host_size_t)(op - target.data),
+                            target.data_length);
+  }
+  return iree_ok_status();
+}
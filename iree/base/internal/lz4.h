@@ -0,0 +1,50 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BASE_INTERNAL_LZ4_H_
+#define IREE_BASE_INTERNAL_LZ4_H_
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Minimal implementation of the LZ4 block format:
+// https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+//
+// Only raw blocks are supported (no frame headers, checksums, or dictionaries)
+// as the uncompressed size is always stored alongside the data by the
+// containers using it. Blocks produced by the compressor are decodable by the
+// reference LZ4 implementation and vice versa.
+//
+// The decompressor is intended for loading untrusted data and bounds checks
+// all reads and writes. The compressor favors simplicity over ratio; it
+// produces output similar to the reference implementation's fast mode.
+
+// Returns the maximum size of the compressed form of |source_length| bytes.
+static inline iree_host_size_t iree_lz4_compress_bound(
+    iree_host_size_t source_length) {
+  return source_length + source_length / 255 + 16;
+}
+
+// Compresses |source| into |target| and returns the compressed size in bytes.
+// Returns 0 if |target| is too small to hold the compressed data; a target of
+// at least iree_lz4_compress_bound bytes always succeeds.
+iree_host_size_t iree_lz4_compress(iree_const_byte_span_t source,
+                                   iree_byte_span_t target);
+
+// Decompresses the LZ4 block in |source| into |target|.
+// The block must decompress to exactly |target|.data_length bytes.
+// Returns IREE_STATUS_DATA_LOSS if the block is malformed.
+iree_status_t iree_lz4_decompress(iree_const_byte_span_t source,
+                                  iree_byte_span_t target);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // IREE_BASE_INTERNAL_LZ4_H_
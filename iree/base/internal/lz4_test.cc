@@ -0,0 +1,118 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/lz4.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+std::vector<uint8_t> Compress(const std::vector<uint8_t>& data) {
+  std::vector<uint8_t> compressed(iree_lz4_compress_bound(data.size()));
+  iree_host_size_t compressed_length = iree_lz4_compress(
+      iree_make_const_byte_span(data.data(), data.size()),
+      iree_make_byte_span(compressed.data(), compressed.size()));
+  compressed.resize(compressed_length);
+  return compressed;
+}
+
+iree_status_t Decompress(const std::vector<uint8_t>& compressed,
+                         iree_host_size_t length, std::vector<uint8_t>* out) {
+  out->resize(length);
+  return iree_lz4_decompress(
+      iree_make_const_byte_span(compressed.data(), compressed.size()),
+      iree_make_byte_span(out->data(), out->size()));
+}
+
+void ExpectRoundTrip(const std::vector<uint8_t>& data) {
+  auto compressed = Compress(data);
+  ASSERT_FALSE(compressed.empty());
+  std::vector<uint8_t> decompressed;
+  IREE_ASSERT_OK(Decompress(compressed, data.size(), &decompressed));
+  EXPECT_EQ(decompressed, data);
+}
+
+TEST(LZ4Test, RoundTripSmall) {
+  // Blocks shorter than the match limits are stored as literals.
+  for (size_t length = 0; length < 32; ++length) {
+    std::vector<uint8_t> data(length);
+    for (size_t i = 0; i < length; ++i) data[i] = static_cast<uint8_t>(i % 3);
+    ExpectRoundTrip(data);
+  }
+}
+
+TEST(LZ4Test, RoundTripRepetitive) {
+  std::vector<uint8_t> zeros(1024 * 1024);
+  auto compressed = Compress(zeros);
+  EXPECT_LT(compressed.size(), zeros.size() / 200);
+  ExpectRoundTrip(zeros);
+
+  std::vector<uint8_t> pattern(256 * 1024);
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    pattern[i] = static_cast<uint8_t>((i / 7) ^ (i % 13));
+  }
+  ExpectRoundTrip(pattern);
+}
+
+TEST(LZ4Test, RoundTripIncompressible) {
+  std::vector<uint8_t> data(64 * 1024);
+  uint32_t state = 1;
+  for (auto& value : data) {
+    state = state * 1664525u + 1013904223u;
+    value = static_cast<uint8_t>(state >> 24);
+  }
+  auto compressed = Compress(data);
+  EXPECT_LE(compressed.size(), iree_lz4_compress_bound(data.size()));
+  ExpectRoundTrip(data);
+}
+
+TEST(LZ4Test, CompressFailsWhenTargetTooSmall) {
+  std::vector<uint8_t> data(1024, 0xCD);
+  std::vector<uint8_t> compressed(4);
+  EXPECT_EQ(0, iree_lz4_compress(
+                   iree_make_const_byte_span(data.data(), data.size()),
+                   iree_make_byte_span(compressed.data(), compressed.size())));
+}
+
+TEST(LZ4Test, DecompressReferenceBlock) {
+  // 'a' literal + overlapping match of length 8 at offset 1 + 5 literals.
+  std::vector<uint8_t> block = {0x14, 'a', 0x01, 0x00, 0x50,
+                                'b',  'c', 'd',  'e',  'f'};
+  std::vector<uint8_t> decompressed;
+  IREE_ASSERT_OK(Decompress(block, 14, &decompressed));
+  EXPECT_EQ(0, std::memcmp(decompressed.data(), "aaaaaaaaabcdef", 14));
+}
+
+TEST(LZ4Test, DecompressRejectsMalformedBlocks) {
+  std::vector<uint8_t> decompressed;
+  // Empty block.
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_DATA_LOSS,
+                        Decompress({}, 0, &decompressed));
+  // Literal run past the end of the block.
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_DATA_LOSS,
+                        Decompress({0x40, 'a', 'b'}, 4, &decompressed));
+  // Match offset before the start of the output.
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DATA_LOSS,
+      Decompress({0x10, 'a', 0x02, 0x00, 0x00}, 5, &decompressed));
+  // Zero match offset.
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DATA_LOSS,
+      Decompress({0x10, 'a', 0x00, 0x00, 0x00}, 5, &decompressed));
+  // Output size mismatch.
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_DATA_LOSS,
+                        Decompress({0x30, 'a', 'b', 'c'}, 4, &decompressed));
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_DATA_LOSS,
+                        Decompress({0x30, 'a', 'b', 'c'}, 2, &decompressed));
+}
+
+}  // namespace
@@ -265,6 +265,45 @@ static inline uint64_t iree_math_round_up_to_pow2_u64(uint64_t n) {
 #endif  // 1
 }
 
+//==============================================================================
+// Division by invariant integers
+//==============================================================================
+
+// A precomputed unsigned 32-bit divisor allowing division by multiplication.
+// Useful when the same runtime divisor is used many times (such as when
+// decomposing linear indices into multi-dimensional ones) as the hardware
+// divide is 20-90 cycles on most cores while the multiply-shift is ~4.
+//
+// Uses the round-up method from "Division by Invariant Integers using
+// Multiplication" (Granlund and Montgomery, 1994), figure 4.1:
+// https://gmplib.org/~tege/divcnst-pldi94.pdf
+typedef struct iree_math_fast_divisor_u32_t {
+  uint32_t multiplier;
+  uint8_t shift1;
+  uint8_t shift2;
+} iree_math_fast_divisor_u32_t;
+
+// Precomputes the magic numbers for dividing by |divisor|, which must be > 0.
+static inline iree_math_fast_divisor_u32_t iree_math_fast_divisor_u32(
+    uint32_t divisor) {
+  // l = ceil(log2(d)), computed such that d=1 yields 0.
+  const uint32_t l =
+      divisor > 1 ? 32 - iree_math_count_leading_zeros_u32(divisor - 1) : 0;
+  iree_math_fast_divisor_u32_t result;
+  result.multiplier = (uint32_t)(
+      ((((uint64_t)1 << l) - divisor) << 32) / divisor + 1);
+  result.shift1 = (uint8_t)(l < 1 ? l : 1);
+  result.shift2 = (uint8_t)(l > 1 ? l - 1 : 0);
+  return result;
+}
+
+// Returns |n| / d for the divisor d that |divisor| was initialized with.
+static inline uint32_t iree_math_fast_divide_u32(
+    uint32_t n, iree_math_fast_divisor_u32_t divisor) {
+  const uint32_t t = (uint32_t)(((uint64_t)divisor.multiplier * n) >> 32);
+  return (t + ((n - t) >> divisor.shift1)) >> divisor.shift2;
+}
+
 //==============================================================================
 // FP16 support
 //==============================================================================
@@ -163,6 +163,37 @@ TEST(RoundingTest, UpToNextPow264) {
   EXPECT_EQ(0ull, iree_math_round_up_to_pow2_u64(kUint64Max));
 }
 
+//==============================================================================
+// Division by invariant integers
+//==============================================================================
+
+TEST(FastDivisorTest, SmallDivisors) {
+  for (uint32_t d = 1; d < 1024; ++d) {
+    iree_math_fast_divisor_u32_t divisor = iree_math_fast_divisor_u32(d);
+    for (uint32_t n = 0; n < 4096; ++n) {
+      ASSERT_EQ(n / d, iree_math_fast_divide_u32(n, divisor)) << n << "/" << d;
+    }
+    ASSERT_EQ(UINT32_MAX / d, iree_math_fast_divide_u32(UINT32_MAX, divisor));
+  }
+}
+
+TEST(FastDivisorTest, LargeDivisors) {
+  const uint32_t divisors[] = {
+      65535u,      65536u,      65537u,      0x7FFFFFFFu,
+      0x80000000u, 0x80000001u, 0xFFFFFFFEu, 0xFFFFFFFFu,
+  };
+  const uint32_t numerators[] = {
+      0u,          1u,          65535u,      65536u,      65537u,
+      0x7FFFFFFFu, 0x80000000u, 0x80000001u, 0xFFFFFFFEu, 0xFFFFFFFFu,
+  };
+  for (uint32_t d : divisors) {
+    iree_math_fast_divisor_u32_t divisor = iree_math_fast_divisor_u32(d);
+    for (uint32_t n : numerators) {
+      EXPECT_EQ(n / d, iree_math_fast_divide_u32(n, divisor)) << n << "/" << d;
+    }
+  }
+}
+
 //==============================================================================
 // FP16 support
 //==============================================================================
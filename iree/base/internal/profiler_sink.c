@@ -0,0 +1,265 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/profiler_sink.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+struct iree_profiler_file_sink_t {
+  iree_allocator_t host_allocator;
+  iree_profiler_t profiler;
+  iree_profiler_file_format_t format;
+  // Guards all fields below.
+  iree_slim_mutex_t mutex;
+  FILE* file;
+  // Number of records written, including chrome trace metadata.
+  iree_host_size_t event_count;
+  // Bitmask of worker indices that have had their chrome trace lane named.
+  uint64_t named_worker_mask;
+  // Timestamps are written relative to when the sink was opened.
+  iree_time_t base_time_ns;
+};
+
+iree_profiler_file_format_t iree_profiler_file_format_from_path(
+    iree_string_view_t path) {
+  return iree_string_view_ends_with(path, IREE_SV(".json"))
+             ? IREE_PROFILER_FILE_FORMAT_CHROME_TRACE
+             : IREE_PROFILER_FILE_FORMAT_CSV;
+}
+
+// Writes |value| as a JSON/CSV-safe string body (without quotes).
+// Event names are identifiers in practice but we escape anyway to avoid
+// producing unparseable files.
+static void iree_profiler_file_sink_write_escaped(FILE* file,
+                                                  iree_string_view_t value) {
+  for (iree_host_size_t i = 0; i < value.size; ++i) {
+    char c = value.data[i];
+    if (c == '"' || c == '\\') {
+      fputc('\\', file);
+      fputc(c, file);
+    } else if ((unsigned char)c < 0x20 || c == ',') {
+      fputc('_', file);
+    } else {
+      fputc(c, file);
+    }
+  }
+}
+
+static void iree_profiler_file_sink_write_csv(
+    iree_profiler_file_sink_t* sink, const iree_profiler_event_t* event) {
+  iree_string_view_t type_name = iree_profiler_event_type_name(event->type);
+  fprintf(sink->file, "%.*s,%" PRId64 ",%" PRIu64 ",", (int)type_name.size,
+          type_name.data, event->timestamp_ns, event->id);
+  iree_profiler_file_sink_write_escaped(sink->file, event->name);
+  fprintf(sink->file, ",%" PRIu64 "\n", event->value);
+}
+
+// Chrome trace thread lanes events are grouped into.
+enum {
+  IREE_PROFILER_CHROME_TRACE_TID_INVOKE = 1,
+  IREE_PROFILER_CHROME_TRACE_TID_DISPATCH = 2,
+  IREE_PROFILER_CHROME_TRACE_TID_SUBMIT = 3,
+  IREE_PROFILER_CHROME_TRACE_TID_WAIT = 4,
+  IREE_PROFILER_CHROME_TRACE_TID_ALLOCATION = 5,
+  // Worker lanes are this plus the worker index.
+  IREE_PROFILER_CHROME_TRACE_TID_WORKER_BASE = 100,
+};
+
+static void iree_profiler_file_sink_write_separator(
+    iree_profiler_file_sink_t* sink) {
+  if (sink->event_count++ > 0) fputs(",\n", sink->file);
+}
+
+static void iree_profiler_file_sink_write_lane_name(
+    iree_profiler_file_sink_t* sink, int tid, const char* name,
+    uint64_t index) {
+  iree_profiler_file_sink_write_separator(sink);
+  fprintf(sink->file,
+          "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+          "\"tid\":%d,\"args\":{\"name\":\"%s",
+          tid, name);
+  if (tid >= IREE_PROFILER_CHROME_TRACE_TID_WORKER_BASE) {
+    fprintf(sink->file, " %" PRIu64, index);
+  }
+  fputs("\"}}", sink->file);
+}
+
+static void iree_profiler_file_sink_write_chrome_trace(
+    iree_profiler_file_sink_t* sink, const iree_profiler_event_t* event) {
+  const char* category = "";
+  const char* default_name = "";
+  const char* phase = "i";
+  int tid = 0;
+  switch (event->type) {
+    case IREE_PROFILER_EVENT_TYPE_INVOKE_BEGIN:
+    case IREE_PROFILER_EVENT_TYPE_INVOKE_END:
+      category = "vm";
+      default_name = "invoke";
+      phase = event->type == IREE_PROFILER_EVENT_TYPE_INVOKE_BEGIN ? "b" : "e";
+      tid = IREE_PROFILER_CHROME_TRACE_TID_INVOKE;
+      break;
+    case IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN:
+    case IREE_PROFILER_EVENT_TYPE_DISPATCH_END:
+      category = default_name = "dispatch";
+      phase =
+          event->type == IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN ? "b" : "e";
+      tid = IREE_PROFILER_CHROME_TRACE_TID_DISPATCH;
+      break;
+    case IREE_PROFILER_EVENT_TYPE_TILES_BEGIN:
+    case IREE_PROFILER_EVENT_TYPE_TILES_END:
+      // Tile ranges never overlap on a worker so they are emitted as
+      // synchronous slices on a lane per worker.
+      category = default_name = "tiles";
+      phase = event->type == IREE_PROFILER_EVENT_TYPE_TILES_BEGIN ? "B" : "E";
+      tid = IREE_PROFILER_CHROME_TRACE_TID_WORKER_BASE + (int)event->id;
+      if (event->id < 64 && !(sink->named_worker_mask & (1ull << event->id))) {
+        sink->named_worker_mask |= 1ull << event->id;
+        iree_profiler_file_sink_write_lane_name(sink, tid, "worker",
+                                                event->id);
+      }
+      break;
+    case IREE_PROFILER_EVENT_TYPE_SUBMIT:
+      category = default_name = "submit";
+      tid = IREE_PROFILER_CHROME_TRACE_TID_SUBMIT;
+      break;
+    case IREE_PROFILER_EVENT_TYPE_WAIT_BEGIN:
+    case IREE_PROFILER_EVENT_TYPE_WAIT_END:
+      category = default_name = "wait";
+      phase = event->type == IREE_PROFILER_EVENT_TYPE_WAIT_BEGIN ? "b" : "e";
+      tid = IREE_PROFILER_CHROME_TRACE_TID_WAIT;
+      break;
+    case IREE_PROFILER_EVENT_TYPE_ALLOCATE:
+    case IREE_PROFILER_EVENT_TYPE_FREE:
+      category = "allocation";
+      default_name = event->type == IREE_PROFILER_EVENT_TYPE_ALLOCATE
+                         ? "allocate"
+                         : "free";
+      tid = IREE_PROFILER_CHROME_TRACE_TID_ALLOCATION;
+      break;
+    default:
+      return;
+  }
+
+  // Async begin/end slices are paired by category, name, and id. Hooks report
+  // the same name for both halves.
+  int64_t relative_ns = event->timestamp_ns - sink->base_time_ns;
+  iree_profiler_file_sink_write_separator(sink);
+  fputs("{\"name\":\"", sink->file);
+  if (iree_string_view_is_empty(event->name)) {
+    fputs(default_name, sink->file);
+  } else {
+    iree_profiler_file_sink_write_escaped(sink->file, event->name);
+  }
+  fprintf(sink->file,
+          "\",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%" PRId64 ".%03d,"
+          "\"pid\":0,\"tid\":%d,\"id\":\"0x%" PRIx64 "\"",
+          category, phase, relative_ns / 1000, (int)(relative_ns % 1000), tid,
+          event->id);
+  if (phase[0] == 'i') fputs(",\"s\":\"p\"", sink->file);
+  fprintf(sink->file, ",\"args\":{\"value\":%" PRIu64 "}}", event->value);
+}
+
+static void iree_profiler_file_sink_record(void* user_data,
+                                           const iree_profiler_event_t* event) {
+  iree_profiler_file_sink_t* sink = (iree_profiler_file_sink_t*)user_data;
+  iree_slim_mutex_lock(&sink->mutex);
+  switch (sink->format) {
+    case IREE_PROFILER_FILE_FORMAT_CSV:
+      iree_profiler_file_sink_write_csv(sink, event);
+      ++sink->event_count;
+      break;
+    case IREE_PROFILER_FILE_FORMAT_CHROME_TRACE:
+      iree_profiler_file_sink_write_chrome_trace(sink, event);
+      break;
+  }
+  iree_slim_mutex_unlock(&sink->mutex);
+}
+
+iree_status_t iree_profiler_file_sink_open(
+    const char* path, iree_profiler_file_format_t format,
+    iree_profiler_event_mask_t event_mask, iree_allocator_t host_allocator,
+    iree_profiler_file_sink_t** out_sink) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(out_sink);
+  *out_sink = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open profiler output file '%s'", path);
+  }
+
+  iree_profiler_file_sink_t* sink = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, sizeof(*sink), (void**)&sink);
+  if (iree_status_is_ok(status)) {
+    sink->host_allocator = host_allocator;
+    sink->profiler.fn = iree_profiler_file_sink_record;
+    sink->profiler.user_data = sink;
+    sink->profiler.event_mask = event_mask;
+    sink->format = format;
+    iree_slim_mutex_initialize(&sink->mutex);
+    sink->file = file;
+    sink->event_count = 0;
+    sink->named_worker_mask = 0;
+    sink->base_time_ns = iree_time_now();
+    switch (format) {
+      case IREE_PROFILER_FILE_FORMAT_CSV:
+        fputs("type,timestamp_ns,id,name,value\n", file);
+        break;
+      case IREE_PROFILER_FILE_FORMAT_CHROME_TRACE:
+        fputs("{\"traceEvents\":[\n", file);
+        iree_profiler_file_sink_write_lane_name(
+            sink, IREE_PROFILER_CHROME_TRACE_TID_INVOKE, "vm invocations", 0);
+        iree_profiler_file_sink_write_lane_name(
+            sink, IREE_PROFILER_CHROME_TRACE_TID_DISPATCH, "dispatches", 0);
+        iree_profiler_file_sink_write_lane_name(
+            sink, IREE_PROFILER_CHROME_TRACE_TID_SUBMIT, "submissions", 0);
+        iree_profiler_file_sink_write_lane_name(
+            sink, IREE_PROFILER_CHROME_TRACE_TID_WAIT, "waits", 0);
+        iree_profiler_file_sink_write_lane_name(
+            sink, IREE_PROFILER_CHROME_TRACE_TID_ALLOCATION, "allocations", 0);
+        break;
+    }
+    *out_sink = sink;
+  } else {
+    fclose(file);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_profiler_file_sink_close(iree_profiler_file_sink_t* sink) {
+  if (!sink) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  if (iree_profiler_get() == &sink->profiler) {
+    iree_profiler_set(NULL);
+  }
+
+  if (sink->format == IREE_PROFILER_FILE_FORMAT_CHROME_TRACE) {
+    fputs("\n],\"displayTimeUnit\":\"ns\"}\n", sink->file);
+  }
+  fclose(sink->file);
+  iree_slim_mutex_deinitialize(&sink->mutex);
+  iree_allocator_free(sink->host_allocator, sink);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+const iree_profiler_t* iree_profiler_file_sink_profiler(
+    iree_profiler_file_sink_t* sink) {
+  IREE_ASSERT_ARGUMENT(sink);
+  return &sink->profiler;
+}
@@ -0,0 +1,58 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BASE_INTERNAL_PROFILER_SINK_H_
+#define IREE_BASE_INTERNAL_PROFILER_SINK_H_
+
+#include "iree/base/api.h"
+#include "iree/base/profiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// File format written by a profiler file sink.
+typedef enum iree_profiler_file_format_e {
+  // One `type,timestamp_ns,id,name,value` row per event with a header row.
+  IREE_PROFILER_FILE_FORMAT_CSV = 0,
+  // Chrome trace event JSON loadable in chrome://tracing and Perfetto.
+  // Begin/end pairs are emitted as async slices keyed by event id.
+  IREE_PROFILER_FILE_FORMAT_CHROME_TRACE,
+} iree_profiler_file_format_t;
+
+// Writes profiler events to a file as they are recorded.
+// Events from all threads are serialized through a lock; this is intended for
+// diagnostics and not for sustained high-rate production sampling.
+typedef struct iree_profiler_file_sink_t iree_profiler_file_sink_t;
+
+// Opens |path| for writing (truncating any existing file) and returns a sink
+// that records events in |event_mask| in the given |format|.
+// The sink is not registered; use iree_profiler_set with
+// iree_profiler_file_sink_profiler to start receiving events.
+iree_status_t iree_profiler_file_sink_open(
+    const char* path, iree_profiler_file_format_t format,
+    iree_profiler_event_mask_t event_mask, iree_allocator_t host_allocator,
+    iree_profiler_file_sink_t** out_sink);
+
+// Closes the file and frees the sink.
+// If the sink is the registered profiler it is unregistered first; callers
+// must ensure no other threads are still recording events.
+void iree_profiler_file_sink_close(iree_profiler_file_sink_t* sink);
+
+// Returns the profiler that records into |sink|, valid until it is closed.
+const iree_profiler_t* iree_profiler_file_sink_profiler(
+    iree_profiler_file_sink_t* sink);
+
+// Returns the format implied by the extension of |path|: `.json` selects
+// IREE_PROFILER_FILE_FORMAT_CHROME_TRACE and anything else CSV.
+iree_profiler_file_format_t iree_profiler_file_format_from_path(
+    iree_string_view_t path);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BASE_INTERNAL_PROFILER_SINK_H_
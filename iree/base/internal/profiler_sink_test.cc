@@ -0,0 +1,98 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/profiler_sink.h"
+
+#include <cstdlib>
+#include <string>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/base/profiler.h"
+#include "iree/testing/gtest.h"
+
+#if IREE_FILE_IO_ENABLE && IREE_PROFILER_ENABLE
+
+namespace {
+
+std::string GetUniquePath(const char* unique_name) {
+  const char* test_tmpdir = getenv("TEST_TMPDIR");
+  if (!test_tmpdir) test_tmpdir = getenv("TMPDIR");
+  if (!test_tmpdir) test_tmpdir = "/tmp";
+  return test_tmpdir + std::string("/iree_test_") + unique_name;
+}
+
+// Records a dispatch with its tiles and an allocation into a sink writing
+// |path|.
+std::string RecordToFile(const std::string& path,
+                         iree_profiler_file_format_t format) {
+  iree_profiler_file_sink_t* sink = NULL;
+  IREE_CHECK_OK(iree_profiler_file_sink_open(
+      path.c_str(), format,
+      IREE_PROFILER_EVENT_MASK_DISPATCH | IREE_PROFILER_EVENT_MASK_TILES,
+      iree_allocator_system(), &sink));
+  iree_profiler_set(iree_profiler_file_sink_profiler(sink));
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN, 0x10,
+                       IREE_SV("matmul"), 8);
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_TILES_BEGIN, 3,
+                       iree_string_view_empty(), 0);
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_TILES_END, 3,
+                       iree_string_view_empty(), 8);
+  // Not in the mask and should be dropped.
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_ALLOCATE, 0x20,
+                       iree_string_view_empty(), 4096);
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_DISPATCH_END, 0x10,
+                       IREE_SV("matmul"), 8);
+  iree_profiler_file_sink_close(sink);
+  EXPECT_EQ(iree_profiler_get(), nullptr);
+
+  iree_byte_span_t contents = iree_make_byte_span(NULL, 0);
+  IREE_CHECK_OK(iree_file_read_contents(path.c_str(), iree_allocator_system(),
+                                        &contents));
+  std::string result(reinterpret_cast<const char*>(contents.data),
+                     contents.data_length);
+  iree_allocator_free(iree_allocator_system(), contents.data);
+  return result;
+}
+
+TEST(ProfilerFileSinkTest, FormatFromPath) {
+  EXPECT_EQ(iree_profiler_file_format_from_path(IREE_SV("a/trace.json")),
+            IREE_PROFILER_FILE_FORMAT_CHROME_TRACE);
+  EXPECT_EQ(iree_profiler_file_format_from_path(IREE_SV("a/trace.csv")),
+            IREE_PROFILER_FILE_FORMAT_CSV);
+}
+
+TEST(ProfilerFileSinkTest, WritesCSV) {
+  std::string contents = RecordToFile(GetUniquePath("profiler_sink.csv"),
+                                      IREE_PROFILER_FILE_FORMAT_CSV);
+  EXPECT_EQ(contents.rfind("type,timestamp_ns,id,name,value\n", 0), 0);
+  EXPECT_NE(contents.find("dispatch_begin,"), std::string::npos);
+  EXPECT_NE(contents.find(",16,matmul,8\n"), std::string::npos);
+  EXPECT_NE(contents.find("dispatch_end,"), std::string::npos);
+  EXPECT_NE(contents.find("tiles_end,"), std::string::npos);
+  EXPECT_EQ(contents.find("allocate"), std::string::npos);
+}
+
+TEST(ProfilerFileSinkTest, WritesChromeTrace) {
+  std::string contents = RecordToFile(GetUniquePath("profiler_sink.json"),
+                                      IREE_PROFILER_FILE_FORMAT_CHROME_TRACE);
+  EXPECT_EQ(contents.rfind("{\"traceEvents\":[", 0), 0);
+  EXPECT_NE(
+      contents.find("\"name\":\"matmul\",\"cat\":\"dispatch\",\"ph\":\"b\""),
+      std::string::npos);
+  EXPECT_NE(contents.find("\"ph\":\"e\""), std::string::npos);
+  EXPECT_NE(contents.find("\"id\":\"0x10\""), std::string::npos);
+  // Tiles are placed on a named lane per worker.
+  EXPECT_NE(contents.find("\"name\":\"worker 3\""), std::string::npos);
+  EXPECT_NE(contents.find("\"ph\":\"B\",\"ts\""), std::string::npos);
+  EXPECT_NE(contents.find("\"tid\":103"), std::string::npos);
+  EXPECT_EQ(contents.find("\"cat\":\"allocation\""), std::string::npos);
+  EXPECT_NE(contents.find("]"), std::string::npos);
+}
+
+}  // namespace
+
+#endif  // IREE_FILE_IO_ENABLE && IREE_PROFILER_ENABLE
@@ -9,6 +9,8 @@
 #include <assert.h>
 #include <string.h>
 
+#include "iree/base/internal/math.h"
+
 #if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
 
 // Disabled.
@@ -47,6 +49,52 @@
 #define IREE_DISABLE_THREAD_SAFETY_ANALYSIS \
   IREE_THREAD_ANNOTATION_ATTRIBUTE(no_thread_safety_analysis)
 
+//==============================================================================
+// Adaptive spinning
+//==============================================================================
+
+// Hints to the processor that we are in a spin-wait loop. This reduces power
+// and frees up execution resources for a sibling hyperthread (which may be the
+// one we are waiting on).
+static inline void iree_spin_pause(void) {
+#if defined(IREE_COMPILER_MSVC) && defined(IREE_PLATFORM_WINDOWS)
+  YieldProcessor();
+#elif defined(IREE_ARCH_X86_32) || defined(IREE_ARCH_X86_64)
+  __builtin_ia32_pause();
+#elif defined(IREE_ARCH_ARM_32) || defined(IREE_ARCH_ARM_64)
+  __asm__ __volatile__("yield");
+#endif  // IREE_ARCH_*
+}
+
+// Returns the number of spins a wait should attempt before parking given the
+// |spin_estimate| of recent waits on the same primitive.
+// The limit is allowed to grow past the estimate so that waits that take a bit
+// longer than usual still have a chance to be satisfied without parking.
+static inline int32_t iree_adaptive_spin_limit(
+    iree_atomic_int32_t* spin_estimate, int32_t max_spin_count) {
+  int32_t estimate =
+      iree_atomic_load_int32(spin_estimate, iree_memory_order_relaxed);
+  int32_t limit = estimate * 2 + IREE_SYNCHRONIZATION_MIN_SPIN_COUNT;
+  return limit < max_spin_count ? limit : max_spin_count;
+}
+
+// Updates |spin_estimate| with the result of a wait that spun |spin_count|
+// times and was either |satisfied| while spinning or had to park.
+// The estimate is an exponential moving average (1/8 weight per sample) of the
+// spins waits needed; waits that had to park contribute a sample of 0 so that
+// primitives that are rarely signaled quickly stop burning cycles.
+//
+// The update is racy (concurrent waiters may lose samples) but the estimate is
+// only a heuristic and losing samples is harmless.
+static inline void iree_adaptive_spin_record(
+    iree_atomic_int32_t* spin_estimate, int32_t spin_count, bool satisfied) {
+  int32_t estimate =
+      iree_atomic_load_int32(spin_estimate, iree_memory_order_relaxed);
+  int32_t sample = satisfied ? spin_count : 0;
+  estimate += (sample - estimate) / 8;
+  iree_atomic_store_int32(spin_estimate, estimate, iree_memory_order_relaxed);
+}
+
 //==============================================================================
 // Cross-platform futex mappings (where supported)
 //==============================================================================
@@ -146,6 +194,47 @@ static inline void iree_futex_wake(void* address, int32_t count) {
 
 #endif  // IREE_PLATFORM_HAS_FUTEX
 
+#if defined(IREE_PLATFORM_HAS_FUTEX_BITSET)
+
+#ifndef FUTEX_CLOCK_REALTIME
+#define FUTEX_CLOCK_REALTIME 256
+#endif  // !FUTEX_CLOCK_REALTIME
+
+// Waits in the OS for the value at the specified |address| to change as with
+// iree_futex_wait but only wakes if a waker specifies a bitset that intersects
+// |bitset|. |deadline_ns| is an absolute time on the same clock as
+// iree_time_now.
+static inline iree_status_code_t iree_futex_wait_bitset(void* address,
+                                                        uint32_t expected_value,
+                                                        iree_time_t deadline_ns,
+                                                        uint32_t bitset) {
+  struct timespec deadline = {
+      .tv_sec = (time_t)(deadline_ns / 1000000000ull),
+      .tv_nsec = (long)(deadline_ns % 1000000000ull),
+  };
+  int rc = syscall(
+      SYS_futex, address,
+      FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME,
+      expected_value,
+      deadline_ns == IREE_TIME_INFINITE_FUTURE ? NULL : &deadline, NULL,
+      bitset);
+  if (IREE_LIKELY(rc == 0) || errno == EAGAIN) {
+    return IREE_STATUS_OK;
+  } else if (errno == ETIMEDOUT) {
+    return IREE_STATUS_DEADLINE_EXCEEDED;
+  }
+  return IREE_STATUS_UNAVAILABLE;
+}
+
+// Wakes all threads waiting on |address| with a wait bitset that intersects
+// |bitset|.
+static inline void iree_futex_wake_bitset(void* address, uint32_t bitset) {
+  syscall(SYS_futex, address, FUTEX_WAKE_BITSET | FUTEX_PRIVATE_FLAG, INT32_MAX,
+          NULL, NULL, bitset);
+}
+
+#endif  // IREE_PLATFORM_HAS_FUTEX_BITSET
+
 //==============================================================================
 // iree_mutex_t
 //==============================================================================
@@ -433,19 +522,25 @@ void iree_slim_mutex_lock(iree_slim_mutex_t* mutex)
         // Successfully took the lock.
         return;
       }
+    }
 
-      // Spin a small amount to give us a tiny chance of falling through to the
-      // wait. We can tune this value based on likely contention, however 10-60
-      // is the recommended value and we should keep it in that order of
-      // magnitude. A way to think of this is "how many spins would we have to
-      // do to equal one call to iree_futex_wait" - if it's faster just to do
-      // a futex wait then we shouldn't be spinning!
-      // TODO(benvanik): measure on real workload on ARM; maybe remove entirely.
-      int spin_count = 100;
-      for (int i = 0; i < spin_count && iree_slim_mutex_is_locked(value); ++i) {
-        value =
-            iree_atomic_load_int32(&mutex->value, iree_memory_order_relaxed);
-      }
+    // While the lock is unavailable: spin a small amount to give the holder a
+    // chance to release it before we fall through to the wait. The amount is
+    // adapted to how long recent contended acquisitions took and capped at
+    // IREE_SLIM_MUTEX_MAX_SPIN_COUNT. A way to think of the cap is "how many
+    // spins would we have to do to equal one call to iree_futex_wait" - if
+    // it's faster just to do a futex wait then we shouldn't be spinning!
+    int32_t spin_limit = iree_adaptive_spin_limit(
+        &mutex->spin_estimate, IREE_SLIM_MUTEX_MAX_SPIN_COUNT);
+    int32_t spin_count = 0;
+    while (spin_count < spin_limit && iree_slim_mutex_is_locked(value)) {
+      iree_spin_pause();
+      value = iree_atomic_load_int32(&mutex->value, iree_memory_order_relaxed);
+      ++spin_count;
+    }
+    if (spin_limit > 0) {
+      iree_adaptive_spin_record(&mutex->spin_estimate, spin_count,
+                                !iree_slim_mutex_is_locked(value));
     }
 
     // While the lock is unavailable: wait for it to become available.
@@ -611,14 +706,39 @@ bool iree_notification_commit_wait(iree_notification_t* notification,
                                    iree_time_t deadline_ns) {
   bool result = true;
 
-  // Spin until notified and the epoch increments from what we captured during
+#if !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+  // Spin briefly before parking: if the notification is posted while we spin
+  // we avoid the syscalls required to park and wake the thread.
+  int32_t spin_limit = iree_adaptive_spin_limit(
+      &notification->spin_estimate, IREE_NOTIFICATION_MAX_SPIN_COUNT);
+  int32_t spin_count = 0;
+  bool posted = false;
+  for (; spin_count < spin_limit; ++spin_count) {
+    if ((iree_atomic_load_int64(&notification->value,
+                                iree_memory_order_acquire) >>
+         IREE_NOTIFICATION_EPOCH_SHIFT) != wait_token) {
+      posted = true;
+      break;
+    }
+    iree_spin_pause();
+  }
+  if (spin_limit > 0) {
+    iree_adaptive_spin_record(&notification->spin_estimate, spin_count,
+                              posted);
+  }
+#endif  // !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
+  // Wait until notified and the epoch increments from what we captured during
   // iree_notification_prepare_wait.
   while ((iree_atomic_load_int64(&notification->value,
                                  iree_memory_order_acquire) >>
           IREE_NOTIFICATION_EPOCH_SHIFT) == wait_token) {
     iree_status_code_t status_code = IREE_STATUS_OK;
 #if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
-    // TODO(benvanik): platform sleep? this spins.
+    // There are no other threads that could post the notification so the best
+    // we can do is sleep until the deadline instead of spinning.
+    iree_wait_until(deadline_ns);
+    status_code = IREE_STATUS_DEADLINE_EXCEEDED;
 #elif defined(IREE_PLATFORM_HAS_FUTEX)
     uint32_t timeout_ms = iree_absolute_deadline_to_timeout_ms(deadline_ns);
     status_code = iree_futex_wait(iree_notification_epoch_address(notification),
@@ -693,3 +813,143 @@ bool iree_notification_await(iree_notification_t* notification,
 
   return true;
 }
+
+//==============================================================================
+// iree_notification_set_t
+//==============================================================================
+
+#if defined(IREE_PLATFORM_HAS_FUTEX_BITSET)
+
+// Folds a 64-bit member mask into the 32-bit futex bitset space.
+static inline uint32_t iree_notification_set_fold_mask(uint64_t member_mask) {
+  return (uint32_t)member_mask | (uint32_t)(member_mask >> 32);
+}
+
+void iree_notification_set_initialize(iree_notification_set_t* out_set) {
+  memset(out_set, 0, sizeof(*out_set));
+}
+
+void iree_notification_set_deinitialize(iree_notification_set_t* set) {
+  // Assert no more waiters (callers must tear down waiters first).
+  SYNC_ASSERT(iree_atomic_load_int64(&set->waiter_mask,
+                                     iree_memory_order_seq_cst) == 0);
+}
+
+void iree_notification_set_post(iree_notification_set_t* set,
+                                uint64_t member_mask) {
+  iree_atomic_fetch_add_int32(&set->epoch, 1, iree_memory_order_acq_rel);
+  // Only go to the kernel if any of the members we are posting are waiting.
+  uint64_t waiting_mask =
+      (uint64_t)iree_atomic_load_int64(&set->waiter_mask,
+                                       iree_memory_order_seq_cst) &
+      member_mask;
+  if (IREE_UNLIKELY(waiting_mask)) {
+    iree_futex_wake_bitset(&set->epoch,
+                           iree_notification_set_fold_mask(waiting_mask));
+  }
+}
+
+iree_wait_token_t iree_notification_set_prepare_wait(
+    iree_notification_set_t* set, iree_host_size_t member_index) {
+  SYNC_ASSERT(member_index < IREE_NOTIFICATION_SET_CAPACITY);
+  iree_atomic_fetch_or_int64(&set->waiter_mask, 1ull << member_index,
+                             iree_memory_order_seq_cst);
+  return (iree_wait_token_t)iree_atomic_load_int32(&set->epoch,
+                                                   iree_memory_order_acquire);
+}
+
+bool iree_notification_set_commit_wait(iree_notification_set_t* set,
+                                       iree_host_size_t member_index,
+                                       iree_wait_token_t wait_token,
+                                       iree_time_t deadline_ns) {
+  bool result = true;
+
+  // Any post to the set changes the epoch and as such we may return early even
+  // if we weren't explicitly posted. That's fine as with iree_notification_t
+  // the caller needs to recheck their condition anyway.
+  const uint32_t bitset =
+      iree_notification_set_fold_mask(1ull << member_index);
+
+  // Spin briefly before parking as with iree_notification_commit_wait.
+  int32_t spin_limit = iree_adaptive_spin_limit(
+      &set->spin_estimate, IREE_NOTIFICATION_MAX_SPIN_COUNT);
+  int32_t spin_count = 0;
+  bool posted = false;
+  for (; spin_count < spin_limit; ++spin_count) {
+    if ((iree_wait_token_t)iree_atomic_load_int32(
+            &set->epoch, iree_memory_order_acquire) != wait_token) {
+      posted = true;
+      break;
+    }
+    iree_spin_pause();
+  }
+  if (spin_limit > 0) {
+    iree_adaptive_spin_record(&set->spin_estimate, spin_count, posted);
+  }
+
+  while ((iree_wait_token_t)iree_atomic_load_int32(
+             &set->epoch, iree_memory_order_acquire) == wait_token) {
+    iree_status_code_t status_code =
+        iree_futex_wait_bitset(&set->epoch, wait_token, deadline_ns, bitset);
+    if (status_code != IREE_STATUS_OK) {
+      result = false;
+      break;
+    }
+  }
+
+  iree_atomic_fetch_and_int64(&set->waiter_mask, ~(1ull << member_index),
+                              iree_memory_order_seq_cst);
+  return result;
+}
+
+void iree_notification_set_cancel_wait(iree_notification_set_t* set,
+                                       iree_host_size_t member_index) {
+  iree_atomic_fetch_and_int64(&set->waiter_mask, ~(1ull << member_index),
+                              iree_memory_order_seq_cst);
+}
+
+#else
+
+// Fallback using one notification per member; posts wake each member in turn.
+
+void iree_notification_set_initialize(iree_notification_set_t* out_set) {
+  for (iree_host_size_t i = 0; i < IREE_NOTIFICATION_SET_CAPACITY; ++i) {
+    iree_notification_initialize(&out_set->members[i]);
+  }
+}
+
+void iree_notification_set_deinitialize(iree_notification_set_t* set) {
+  for (iree_host_size_t i = 0; i < IREE_NOTIFICATION_SET_CAPACITY; ++i) {
+    iree_notification_deinitialize(&set->members[i]);
+  }
+}
+
+void iree_notification_set_post(iree_notification_set_t* set,
+                                uint64_t member_mask) {
+  while (member_mask) {
+    int member_index = iree_math_count_trailing_zeros_u64(member_mask);
+    member_mask &= member_mask - 1;
+    iree_notification_post(&set->members[member_index], 1);
+  }
+}
+
+iree_wait_token_t iree_notification_set_prepare_wait(
+    iree_notification_set_t* set, iree_host_size_t member_index) {
+  SYNC_ASSERT(member_index < IREE_NOTIFICATION_SET_CAPACITY);
+  return iree_notification_prepare_wait(&set->members[member_index]);
+}
+
+bool iree_notification_set_commit_wait(iree_notification_set_t* set,
+                                       iree_host_size_t member_index,
+                                       iree_wait_token_t wait_token,
+                                       iree_time_t deadline_ns) {
+  return iree_notification_commit_wait(&set->members[member_index], wait_token,
+                                       deadline_ns);
+}
+
+void iree_notification_set_cancel_wait(iree_notification_set_t* set,
+                                       iree_host_size_t member_index) {
+  iree_notification_cancel_wait(&set->members[member_index]);
+}
+
+#endif  // IREE_PLATFORM_HAS_FUTEX_BITSET
@@ -62,6 +62,14 @@
 #endif  // !IREE_SANITIZER_THREAD
 #endif  // IREE_PLATFORM_*
 
+// Linux futexes support waking a subset of the waiters on a single address with
+// FUTEX_WAKE_BITSET. Other platforms (WaitOnAddress, emscripten) have no
+// equivalent and must wake each address individually.
+#if defined(IREE_PLATFORM_HAS_FUTEX) && \
+    (defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX))
+#define IREE_PLATFORM_HAS_FUTEX_BITSET 1
+#endif  // IREE_PLATFORM_HAS_FUTEX && IREE_PLATFORM_*
+
 #if defined(IREE_PLATFORM_APPLE)
 #include <os/lock.h>
 #endif  // IREE_PLATFORM_APPLE
@@ -86,6 +94,39 @@ extern "C" {
 #define IREE_ALL_WAITERS INT32_MAX
 #define IREE_INFINITE_TIMEOUT_MS UINT32_MAX
 
+//==============================================================================
+// Spin-then-park policy
+//==============================================================================
+
+// Waits on slim mutexes and notifications spin for a short time before parking
+// the thread in the kernel: a wake that arrives while spinning avoids both the
+// park and the (much more expensive) unpark syscalls. The number of spins is
+// adapted per primitive based on how many spins recent waits needed before
+// being satisfied: primitives that are signaled shortly after a wait begins
+// spin longer while those that are rarely signaled quickly decay toward the
+// minimum. Define any of these to 0 to disable spinning.
+
+// Minimum number of spins a wait will attempt before parking regardless of
+// history. Keeping this above 0 allows the estimate to recover after a period
+// of long waits.
+#if !defined(IREE_SYNCHRONIZATION_MIN_SPIN_COUNT)
+#define IREE_SYNCHRONIZATION_MIN_SPIN_COUNT 16
+#endif  // !IREE_SYNCHRONIZATION_MIN_SPIN_COUNT
+
+// Maximum number of spins an iree_slim_mutex_t lock will attempt before
+// parking. Locks are expected to be held for short durations and this should
+// be on the order of the cost of one futex wait.
+#if !defined(IREE_SLIM_MUTEX_MAX_SPIN_COUNT)
+#define IREE_SLIM_MUTEX_MAX_SPIN_COUNT 100
+#endif  // !IREE_SLIM_MUTEX_MAX_SPIN_COUNT
+
+// Maximum number of spins an iree_notification_t or iree_notification_set_t
+// wait will attempt before parking. Workers waiting for new tasks are commonly
+// posted within a few microseconds when work is fanned out in waves.
+#if !defined(IREE_NOTIFICATION_MAX_SPIN_COUNT)
+#define IREE_NOTIFICATION_MAX_SPIN_COUNT 512
+#endif  // !IREE_NOTIFICATION_MAX_SPIN_COUNT
+
 //==============================================================================
 // iree_mutex_t
 //==============================================================================
@@ -223,6 +264,8 @@ typedef struct iree_slim_mutex_t IREE_THREAD_ANNOTATION_ATTRIBUTE(
   SRWLOCK value;
 #elif defined(IREE_PLATFORM_HAS_FUTEX)
   iree_atomic_int32_t value;
+  // Adaptive estimate of the spins needed to acquire the lock when contended.
+  iree_atomic_int32_t spin_estimate;
 #else
   iree_mutex_t impl;  // fallback
 #endif  // IREE_PLATFORM_*
@@ -293,20 +336,22 @@ typedef struct iree_notification_t {
   pthread_cond_t cond;
 #endif  // IREE_PLATFORM_*
   iree_atomic_int64_t value;
+  // Adaptive estimate of the spins needed before a wait is posted.
+  iree_atomic_int32_t spin_estimate;
 } iree_notification_t;
 
 #if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
 #define IREE_NOTIFICATION_INIT \
-  { IREE_ATOMIC_VAR_INIT(0) }
+  { IREE_ATOMIC_VAR_INIT(0), IREE_ATOMIC_VAR_INIT(0) }
 #elif !defined(IREE_PLATFORM_HAS_FUTEX)
 #define IREE_NOTIFICATION_INIT                           \
   {                                                      \
     PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, \
-        IREE_ATOMIC_VAR_INIT(0),                         \
+        IREE_ATOMIC_VAR_INIT(0), IREE_ATOMIC_VAR_INIT(0) \
   }
 #else
 #define IREE_NOTIFICATION_INIT \
-  { IREE_ATOMIC_VAR_INIT(0) }
+  { IREE_ATOMIC_VAR_INIT(0), IREE_ATOMIC_VAR_INIT(0) }
 #endif  // notification type
 
 // Initializes a notification to no waiters and an initial epoch of 0.
@@ -346,7 +391,8 @@ iree_wait_token_t iree_notification_prepare_wait(
 // Commits a pending wait operation when the caller has ensured it must wait.
 // Waiting will continue until a notification has been posted or |deadline_ns|
 // is reached. Returns false if the deadline is reached before a notification is
-// posted.
+// posted. The caller may spin briefly before parking (see
+// IREE_NOTIFICATION_MAX_SPIN_COUNT).
 //
 // Acts as (at least) a memory_order_acquire barrier:
 //   A load operation with this memory order performs the acquire operation on
@@ -365,6 +411,73 @@ bool iree_notification_commit_wait(iree_notification_t* notification,
 //   guaranteed.
 void iree_notification_cancel_wait(iree_notification_t* notification);
 
+//==============================================================================
+// iree_notification_set_t
+//==============================================================================
+
+// Maximum number of members in an iree_notification_set_t.
+#define IREE_NOTIFICATION_SET_CAPACITY 64
+
+// A fixed set of notifications that can be posted to in bulk.
+// Each member waits on its own index in the set and posters can wake any
+// subset of the members with a single call. This is useful when a single
+// producer needs to wake many consumers at once (such as when fanning out work
+// to a pool of threads) as the latency of the last consumer to wake does not
+// scale with the number of consumers woken before it.
+//
+// Where FUTEX_WAKE_BITSET is available all members wait on the same futex with
+// their member bit as their wait bitset and a post wakes all of the requested
+// members with a single syscall. Elsewhere each member has its own
+// iree_notification_t and posts wake each requested member in turn.
+//
+// Only one thread may wait on a particular member at a time. Members with
+// indices that alias in the 32-bit futex bitset (i and i+32) may observe
+// spurious wakes and callers must treat wakes as a hint to recheck state just
+// as with iree_notification_t.
+typedef struct iree_notification_set_t {
+#if defined(IREE_PLATFORM_HAS_FUTEX_BITSET)
+  // Incremented on every post; members wait for it to change.
+  iree_atomic_int32_t epoch;
+  // Bitmask of members that are (about to be) waiting.
+  iree_atomic_int64_t waiter_mask;
+  // Adaptive estimate of the spins needed before a member wait is posted.
+  // Shared by all members as they are usually peers (such as workers).
+  iree_atomic_int32_t spin_estimate;
+#else
+  iree_notification_t members[IREE_NOTIFICATION_SET_CAPACITY];
+#endif  // IREE_PLATFORM_HAS_FUTEX_BITSET
+} iree_notification_set_t;
+
+// Initializes a notification set with no waiters.
+void iree_notification_set_initialize(iree_notification_set_t* out_set);
+
+// Deinitializes |set|. No threads may be waiting on any member of the set.
+void iree_notification_set_deinitialize(iree_notification_set_t* set);
+
+// Notifies each member indicated by a set bit in |member_mask|. Members that
+// are not currently waiting are not notified. Has the same memory ordering
+// guarantees as iree_notification_post.
+void iree_notification_set_post(iree_notification_set_t* set,
+                                uint64_t member_mask);
+
+// Prepares for a wait operation on |member_index|, returning a token that must
+// be passed to iree_notification_set_commit_wait. See
+// iree_notification_prepare_wait.
+iree_wait_token_t iree_notification_set_prepare_wait(
+    iree_notification_set_t* set, iree_host_size_t member_index);
+
+// Commits a pending wait operation on |member_index| until the member is
+// posted or |deadline_ns| is reached. Returns false if the deadline is reached
+// before a notification is posted. See iree_notification_commit_wait.
+bool iree_notification_set_commit_wait(iree_notification_set_t* set,
+                                       iree_host_size_t member_index,
+                                       iree_wait_token_t wait_token,
+                                       iree_time_t deadline_ns);
+
+// Cancels a pending wait operation on |member_index| without blocking.
+void iree_notification_set_cancel_wait(iree_notification_set_t* set,
+                                       iree_host_size_t member_index);
+
 // Returns true if the condition is true.
 // |arg| is the |condition_arg| passed to the await function.
 // Implementations must ensure they are coherent with their state values.
@@ -249,8 +249,147 @@ BENCHMARK_TEMPLATE(BM_Contended, std::mutex)
 // iree_notification_t
 //==============================================================================
 
-// TODO(benvanik): benchmark this; it should in the worst case be as bad as
-// mutex/futex (as that's what is used), but at the moment we don't really
-// care beyond that.
+// Maximum number of threads any of the notification benchmarks run with.
+constexpr int kMaxNotificationThreads = 64;
+
+// A one-way channel from one thread to another. The receiver waits for the
+// sequence number to reach the value it expects and the sender bumps it and
+// posts the notification.
+struct NotificationChannel {
+  iree_notification_t notification;
+  iree_atomic_int64_t sequence;
+};
+
+struct NotificationChannelWait {
+  NotificationChannel* channel;
+  int64_t expected_sequence;
+};
+
+bool IsChannelReady(void* arg) {
+  auto* wait = static_cast<NotificationChannelWait*>(arg);
+  return iree_atomic_load_int64(&wait->channel->sequence,
+                                iree_memory_order_acquire) >=
+         wait->expected_sequence;
+}
+
+void AwaitChannel(NotificationChannel* channel, int64_t expected_sequence) {
+  NotificationChannelWait wait = {channel, expected_sequence};
+  iree_notification_await(&channel->notification, IsChannelReady, &wait,
+                          iree_infinite_timeout());
+}
+
+void SignalChannel(NotificationChannel* channel, int64_t sequence) {
+  iree_atomic_store_int64(&channel->sequence, sequence,
+                          iree_memory_order_release);
+  iree_notification_post(&channel->notification, IREE_ALL_WAITERS);
+}
+
+// Measures the round-trip wake latency between pairs of threads that
+// ping-pong through notifications. Each iteration is two waits and two posts.
+// The thread count is varied to measure how the latency changes as more cores
+// are parking and waking concurrently.
+void BM_NotificationPingPong(benchmark::State& state) {
+  struct Pair {
+    NotificationChannel ping;
+    NotificationChannel pong;
+  };
+  static Pair* pairs = new Pair[kMaxNotificationThreads / 2];
+  Pair* pair = &pairs[state.thread_index() / 2];
+  const bool is_pinger = (state.thread_index() % 2) == 0;
+  if (is_pinger) {
+    // Reset before the benchmark starts; all threads synchronize on entry to
+    // the loop below.
+    iree_notification_initialize(&pair->ping.notification);
+    iree_notification_initialize(&pair->pong.notification);
+    iree_atomic_store_int64(&pair->ping.sequence, 0, iree_memory_order_relaxed);
+    iree_atomic_store_int64(&pair->pong.sequence, 0, iree_memory_order_relaxed);
+  }
+  int64_t sequence = 0;
+  for (auto _ : state) {
+    ++sequence;
+    if (is_pinger) {
+      SignalChannel(&pair->ping, sequence);
+      AwaitChannel(&pair->pong, sequence);
+    } else {
+      AwaitChannel(&pair->ping, sequence);
+      SignalChannel(&pair->pong, sequence);
+    }
+  }
+}
+
+BENCHMARK(BM_NotificationPingPong)
+    ->UseRealTime()
+    // Threads are paired so counts must be even.
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16)
+    ->Threads(32)
+    ->Threads(64);
+
+// Measures the latency of waking a group of waiting threads and having all of
+// them respond as with a worker pool fanning out a wave of work. Thread 0 posts
+// members of an iree_notification_set_t and waits for all other threads to
+// acknowledge the post.
+void BM_NotificationSetFanOut(benchmark::State& state) {
+  struct Shared {
+    iree_notification_set_t set;
+    iree_atomic_int64_t epoch;
+    NotificationChannel acks;
+  };
+  static Shared* shared = new Shared();
+  const int member_count = state.threads() - 1;
+  const bool is_poster = state.thread_index() == 0;
+  if (is_poster) {
+    iree_notification_set_initialize(&shared->set);
+    iree_notification_initialize(&shared->acks.notification);
+    iree_atomic_store_int64(&shared->epoch, 0, iree_memory_order_relaxed);
+    iree_atomic_store_int64(&shared->acks.sequence, 0,
+                            iree_memory_order_relaxed);
+  }
+  const uint64_t member_mask =
+      member_count >= 64 ? ~0ull : ((1ull << member_count) - 1);
+  const iree_host_size_t member_index = state.thread_index() - 1;
+  int64_t epoch = 0;
+  for (auto _ : state) {
+    ++epoch;
+    if (is_poster) {
+      iree_atomic_store_int64(&shared->epoch, epoch, iree_memory_order_release);
+      iree_notification_set_post(&shared->set, member_mask);
+      AwaitChannel(&shared->acks, epoch * member_count);
+    } else {
+      while (iree_atomic_load_int64(&shared->epoch,
+                                    iree_memory_order_acquire) < epoch) {
+        iree_wait_token_t wait_token =
+            iree_notification_set_prepare_wait(&shared->set, member_index);
+        if (iree_atomic_load_int64(&shared->epoch,
+                                   iree_memory_order_acquire) >= epoch) {
+          iree_notification_set_cancel_wait(&shared->set, member_index);
+          break;
+        }
+        iree_notification_set_commit_wait(&shared->set, member_index,
+                                          wait_token,
+                                          IREE_TIME_INFINITE_FUTURE);
+      }
+      if (iree_atomic_fetch_add_int64(&shared->acks.sequence, 1,
+                                      iree_memory_order_acq_rel) +
+              1 ==
+          epoch * member_count) {
+        iree_notification_post(&shared->acks.notification, IREE_ALL_WAITERS);
+      }
+    }
+  }
+}
+
+BENCHMARK(BM_NotificationSetFanOut)
+    ->UseRealTime()
+    // One poster and N-1 members; the set supports at most 64 members.
+    ->Threads(2)
+    ->Threads(3)
+    ->Threads(5)
+    ->Threads(9)
+    ->Threads(17)
+    ->Threads(33)
+    ->Threads(kMaxNotificationThreads);
 
 }  // namespace
@@ -6,7 +6,9 @@
 
 #include "iree/base/internal/synchronization.h"
 
+#include <atomic>
 #include <thread>
+#include <vector>
 
 #include "iree/testing/gtest.h"
 
@@ -215,4 +217,71 @@ TEST(NotificationTest, Timeout) {
   iree_notification_deinitialize(&notification);
 }
 
+//==============================================================================
+// iree_notification_set_t
+//==============================================================================
+
+TEST(NotificationSetTest, Timeout) {
+  iree_notification_set_t set;
+  iree_notification_set_initialize(&set);
+
+  iree_time_t start_ns = iree_time_now();
+  iree_wait_token_t wait_token = iree_notification_set_prepare_wait(&set, 3);
+  EXPECT_FALSE(iree_notification_set_commit_wait(
+      &set, 3, wait_token, iree_time_now() + 100 * 1000000));
+  iree_duration_t delta_ms = (iree_time_now() - start_ns) / 1000000;
+  EXPECT_GE(delta_ms, 50);  // slop
+
+  iree_notification_set_deinitialize(&set);
+}
+
+TEST(NotificationSetTest, CancelWait) {
+  iree_notification_set_t set;
+  iree_notification_set_initialize(&set);
+  iree_notification_set_prepare_wait(&set, 7);
+  iree_notification_set_cancel_wait(&set, 7);
+  iree_notification_set_deinitialize(&set);
+}
+
+// Wakes a subset of members (including ones across the 32-bit fold) and
+// ensures each of them observes the post.
+TEST(NotificationSetTest, PostMask) {
+  iree_notification_set_t set;
+  iree_notification_set_initialize(&set);
+
+  const iree_host_size_t member_indices[] = {0, 5, 31, 32, 63};
+  std::atomic<int> posted_index{-1};
+  std::atomic<int> wake_count{0};
+  std::vector<std::thread> threads;
+  for (iree_host_size_t member_index : member_indices) {
+    threads.emplace_back([&, member_index]() {
+      // Wait until we have been posted; spurious wakes loop.
+      while (true) {
+        iree_wait_token_t wait_token =
+            iree_notification_set_prepare_wait(&set, member_index);
+        if (posted_index.load() >= (int)member_index) {
+          iree_notification_set_cancel_wait(&set, member_index);
+          break;
+        }
+        iree_notification_set_commit_wait(&set, member_index, wait_token,
+                                          IREE_TIME_INFINITE_FUTURE);
+      }
+      ++wake_count;
+    });
+  }
+
+  // Post all members at once.
+  posted_index = 63;
+  uint64_t member_mask = 0;
+  for (iree_host_size_t member_index : member_indices) {
+    member_mask |= 1ull << member_index;
+  }
+  iree_notification_set_post(&set, member_mask);
+
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(wake_count.load(), (int)IREE_ARRAYSIZE(member_indices));
+
+  iree_notification_set_deinitialize(&set);
+}
+
 }  // namespace
@@ -282,9 +282,10 @@ static void iree_thread_set_priority_class(
     iree_thread_t* thread, iree_thread_priority_class_t priority_class) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_EMSCRIPTEN)
+#if defined(IREE_PLATFORM_ANDROID)
   // TODO(benvanik): Some sort of solution on Android, if possible (see above)
-  // TODO(benvanik): Some sort of solution on Emscripten, if possible
+#elif defined(IREE_PLATFORM_EMSCRIPTEN)
+  // Web Workers have no priority controls; the browser schedules them.
 #else
   int policy = 0;
   struct sched_param param;
@@ -315,6 +316,11 @@ void iree_thread_override_end(iree_thread_override_t* override) {
 void iree_thread_request_affinity(iree_thread_t* thread,
                                   iree_thread_affinity_t affinity) {
   if (!affinity.specified) return;
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+  // Web Workers cannot be pinned to cores and the topology reported by the
+  // browser is only a logical core count, so affinity is ignored.
+  return;
+#else
   IREE_TRACE_ZONE_BEGIN(z0);
 
   cpu_set_t cpu_set;
@@ -333,13 +339,12 @@ void iree_thread_request_affinity(iree_thread_t* thread,
   pid_t tid = pthread_gettid_np(thread->handle);
   sched_setaffinity(tid, sizeof(cpu_set), &cpu_set);
 #endif  // __ANDROID_API__ >= 21
-#elif defined(IREE_PLATFORM_EMSCRIPTEN)
-  // TODO(benvanik): Some sort of solution on Emscripten, if possible
 #else
   pthread_setaffinity_np(thread->handle, sizeof(cpu_set), &cpu_set);
 #endif  // IREE_PLATFORM_*
 
   IREE_TRACE_ZONE_END(z0);
+#endif  // IREE_PLATFORM_EMSCRIPTEN
 }
 
 void iree_thread_resume(iree_thread_t* thread) {
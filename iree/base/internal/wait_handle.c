@@ -4,10 +4,23 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
-#include "iree/base/internal/wait_handle.h"
+// NOTE: must be first to ensure that we can define settings for all includes.
+#include "iree/base/internal/wait_handle_impl.h"
 
 #include <string.h>
 
+//===----------------------------------------------------------------------===//
+// iree_wait_set_t
+//===----------------------------------------------------------------------===//
+
+bool iree_wait_set_is_scalable(void) {
+#if IREE_WAIT_API == IREE_WAIT_API_EPOLL
+  return true;
+#else
+  return false;
+#endif  // IREE_WAIT_API
+}
+
 //===----------------------------------------------------------------------===//
 // iree_wait_handle_t
 //===----------------------------------------------------------------------===//
@@ -111,6 +111,13 @@ static inline iree_wait_handle_t* iree_wait_handle_from_source(
 // particular set at any time.
 typedef struct iree_wait_set_t iree_wait_set_t;
 
+// Returns true if the active wait set implementation registers handles with
+// the kernel on insertion such that waits scale with the number of signaled
+// handles instead of the total number of handles in the set (epoll).
+// Callers can use this to size their sets: poll-style and WFMO-based sets get
+// linearly slower (or are hard limited to 64 handles) as they grow.
+bool iree_wait_set_is_scalable(void);
+
 // Allocates a wait set with the maximum |capacity| of unique handles.
 iree_status_t iree_wait_set_allocate(iree_host_size_t capacity,
                                      iree_allocator_t allocator,
@@ -9,58 +9,399 @@
 
 #if IREE_WAIT_API == IREE_WAIT_API_EPOLL
 
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
 #include "iree/base/internal/wait_handle_posix.h"
 #include "iree/base/tracing.h"
 
+//===----------------------------------------------------------------------===//
+// Platform utilities
+//===----------------------------------------------------------------------===//
+
+// epoll lets us route the wait set operations right to the kernel: handles are
+// registered once when inserted into the set and each wait is then O(woken)
+// instead of the O(n) scan over the full handle list that poll/ppoll perform.
+// This matters when there are many outstanding waits that are repeatedly
+// waited on, such as the task poller in a pipeline with many in-flight
+// semaphores.
+//
+// epoll is not available on mac/ios so we still need poll (or kqueue) there.
+//
+// Documentation: https://man7.org/linux/man-pages/man7/epoll.7.html
+
+// Performs an epoll_wait with an absolute deadline, retrying on EINTR with an
+// updated timeout.
+//
+// NOTE: epoll_wait only has millisecond timeout granularity. epoll_pwait2 takes
+// a timespec but requires Linux 5.11 and a recent libc so we round up to the
+// next millisecond instead; the caller always rechecks deadlines after waking.
+static iree_status_t iree_syscall_epoll_wait(int epoll_fd,
+                                             struct epoll_event* events,
+                                             int max_events,
+                                             iree_time_t deadline_ns,
+                                             int* out_signaled_count) {
+  *out_signaled_count = 0;
+  int rv = -1;
+  do {
+    uint32_t timeout_ms = iree_absolute_deadline_to_timeout_ms(deadline_ns);
+    rv = epoll_wait(epoll_fd, events, max_events,
+                    timeout_ms == UINT32_MAX ? -1 : (int)timeout_ms);
+  } while (rv < 0 && errno == EINTR);
+  if (rv > 0) {
+    // One or more events set.
+    *out_signaled_count = rv;
+    return iree_ok_status();
+  } else if (IREE_UNLIKELY(rv < 0)) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "epoll_wait failure %d", errno);
+  }
+  // rv == 0
+  // Timeout; no events set.
+  return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+}
+
+// Performs a ppoll on a single fd with an absolute deadline, retrying on EINTR
+// with an updated timeout. Single waits don't benefit from epoll registration.
+static iree_status_t iree_syscall_ppoll_one(struct pollfd* poll_fd,
+                                            iree_time_t deadline_ns) {
+  int rv = -1;
+  do {
+    // See wait_handle_poll.c for details on the timeout conversion; it must be
+    // recomputed each iteration as a previous ppoll may have taken some time.
+    struct timespec timeout_ts;
+    struct timespec* tmo_p = &timeout_ts;
+    if (deadline_ns == IREE_TIME_INFINITE_PAST) {
+      memset(&timeout_ts, 0, sizeof(timeout_ts));
+    } else if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
+      tmo_p = NULL;
+    } else {
+      iree_duration_t timeout_ns = deadline_ns - iree_time_now();
+      if (timeout_ns < 0) {
+        memset(&timeout_ts, 0, sizeof(timeout_ts));
+      } else {
+        timeout_ts.tv_sec = (time_t)(timeout_ns / 1000000000ull);
+        timeout_ts.tv_nsec = (long)(timeout_ns % 1000000000ull);
+      }
+    }
+    rv = ppoll(poll_fd, 1, tmo_p, NULL);
+  } while (rv < 0 && errno == EINTR);
+  if (rv > 0) {
+    return iree_ok_status();
+  } else if (rv < 0) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "ppoll failure %d", errno);
+  }
+  return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+}
+
 //===----------------------------------------------------------------------===//
 // iree_wait_set_t
 //===----------------------------------------------------------------------===//
 
-// TODO(benvanik): iree_wait_set_s using an epoll fd.
-// epoll lets us route the wait set operations right to kernel and not need our
-// own duplicate data structure. epoll is great, just not available on mac/ios
-// so we still need poll for that. linux/android/bsd all have epoll, though.
+// A slot in the wait set holding a handle registered with the epoll fd.
+// Slots are stable for as long as the handle is in the set so that the slot
+// index can be stored in the epoll event data and used to map wakes back to
+// the user handle without any lookups.
+typedef struct iree_wait_set_slot_t {
+  // User-provided handle.
+  iree_wait_handle_t user_handle;
+  // Native fd registered with epoll or -1 if the handle has no fd (such as an
+  // immediate handle) and will never signal.
+  int fd;
+  // Number of times the handle has been inserted. 0 if the slot is free.
+  uint32_t ref_count;
+} iree_wait_set_slot_t;
+
 struct iree_wait_set_t {
-  // NOTE: we could in theory use the epoll handle directly (iree_wait_set_s
-  // then is just a pointer). Then allocate/free just go straight to the system.
-  int reserved;
+  iree_allocator_t allocator;
+
+  // epoll instance with all slot fds registered.
+  int epoll_fd;
+
+  // Total capacity of the slot list.
+  iree_host_size_t slot_capacity;
+
+  // Number of slots at the front of the slot list that have ever been used.
+  // Slots past this are known free and never need to be scanned.
+  iree_host_size_t slot_high_water_mark;
+
+  // Total number of slots that are in use. Note that a slot may represent
+  // multiple insertions of the same handle.
+  iree_host_size_t handle_count;
+
+  // Number of slots with an fd registered with epoll.
+  iree_host_size_t registered_count;
+
+  // Slots that have been freed and can be reused. These are stored as indices
+  // in a stack and popped on insertion to keep slot reuse LIFO (and hot).
+  iree_host_size_t free_count;
+  uint16_t* free_list;
+
+  // Slots up to slot_capacity; only those < slot_high_water_mark are valid.
+  iree_wait_set_slot_t* slots;
 };
 
 iree_status_t iree_wait_set_allocate(iree_host_size_t capacity,
                                      iree_allocator_t allocator,
                                      iree_wait_set_t** out_set) {
-  // TODO(benvanik): epoll_create()
+  IREE_ASSERT_ARGUMENT(out_set);
+
+  // Slot indices are stored in the 16-bit iree_wait_handle_t::set_internal.
+  if (capacity >= UINT16_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "wait set capacity of %zu is unreasonably large",
+                            capacity);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t slot_list_size =
+      capacity * iree_sizeof_struct(iree_wait_set_slot_t);
+  iree_host_size_t free_list_size = capacity * sizeof(uint16_t);
+  iree_host_size_t total_size =
+      iree_sizeof_struct(iree_wait_set_t) + slot_list_size + free_list_size;
+
+  iree_wait_set_t* set = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, total_size, (void**)&set));
+  set->allocator = allocator;
+  set->slot_capacity = capacity;
+  set->slots = (iree_wait_set_slot_t*)((uint8_t*)set +
+                                       iree_sizeof_struct(iree_wait_set_t));
+  set->free_list = (uint16_t*)((uint8_t*)set->slots + slot_list_size);
+
+  set->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (IREE_UNLIKELY(set->epoll_fd < 0)) {
+    iree_status_t status = iree_make_status(
+        iree_status_code_from_errno(errno), "epoll_create1 failed (%d)", errno);
+    iree_allocator_free(allocator, set);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  *out_set = set;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
 }
 
 void iree_wait_set_free(iree_wait_set_t* set) {
-  // TODO(benvanik): close()
+  if (!set) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  close(set->epoll_fd);
+  iree_allocator_free(set->allocator, set);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Returns the slot index holding |fd| or -1 if not found.
+// Uses the |hint_index| (from a prior wake) if it matches.
+static int iree_wait_set_find_slot(iree_wait_set_t* set, int fd,
+                                   iree_host_size_t hint_index) {
+  if (hint_index < set->slot_high_water_mark &&
+      set->slots[hint_index].ref_count > 0 &&
+      set->slots[hint_index].fd == fd) {
+    return (int)hint_index;
+  }
+  for (iree_host_size_t i = 0; i < set->slot_high_water_mark; ++i) {
+    if (set->slots[i].ref_count > 0 && set->slots[i].fd == fd) return (int)i;
+  }
+  return -1;
 }
 
 iree_status_t iree_wait_set_insert(iree_wait_set_t* set,
                                    iree_wait_handle_t handle) {
-  // TODO(benvanik): epoll_ctl(EPOLL_CTL_ADD)
+  // Handles sharing the same fd are reference counted as epoll only allows an
+  // fd to be registered once per epoll instance. Handles without fds are kept
+  // so that they are tracked for erasure but never registered.
+  int fd = iree_wait_primitive_get_read_fd(&handle);
+  if (fd >= 0) {
+    int existing_index = iree_wait_set_find_slot(set, fd, 0);
+    if (existing_index >= 0) {
+      ++set->slots[existing_index].ref_count;
+      return iree_ok_status();
+    }
+  }
+
+  iree_host_size_t index = 0;
+  if (set->free_count > 0) {
+    index = set->free_list[--set->free_count];
+  } else if (set->slot_high_water_mark < set->slot_capacity) {
+    index = set->slot_high_water_mark++;
+  } else {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "wait set capacity reached");
+  }
+
+  if (fd >= 0) {
+    // Level-triggered to match poll; handles stay signaled until reset.
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLPRI;  // implicit EPOLLERR | EPOLLHUP
+    event.data.u64 = index;
+    if (IREE_UNLIKELY(epoll_ctl(set->epoll_fd, EPOLL_CTL_ADD, fd, &event) <
+                      0)) {
+      set->free_list[set->free_count++] = (uint16_t)index;
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "epoll_ctl(EPOLL_CTL_ADD) failed (%d)", errno);
+    }
+    ++set->registered_count;
+  }
+
+  iree_wait_set_slot_t* slot = &set->slots[index];
+  IREE_IGNORE_ERROR(iree_wait_handle_wrap_primitive(handle.type, handle.value,
+                                                    &slot->user_handle));
+  slot->fd = fd;
+  slot->ref_count = 1;
+  ++set->handle_count;
+  return iree_ok_status();
+}
+
+// Releases the slot at |index|, unregistering its fd from epoll.
+static void iree_wait_set_release_slot(iree_wait_set_t* set,
+                                       iree_host_size_t index) {
+  iree_wait_set_slot_t* slot = &set->slots[index];
+  if (slot->fd >= 0) {
+    // NOTE: the event argument is ignored but must be non-NULL on kernels
+    // prior to 2.6.9.
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    epoll_ctl(set->epoll_fd, EPOLL_CTL_DEL, slot->fd, &event);
+    --set->registered_count;
+  }
+  memset(slot, 0, sizeof(*slot));
+  slot->fd = -1;
+  set->free_list[set->free_count++] = (uint16_t)index;
+  --set->handle_count;
 }
 
 void iree_wait_set_erase(iree_wait_set_t* set, iree_wait_handle_t handle) {
-  // TODO(benvanik): epoll_ctl(EPOLL_CTL_DEL)
+  int fd = iree_wait_primitive_get_read_fd(&handle);
+  int index = -1;
+  if (fd >= 0) {
+    index = iree_wait_set_find_slot(set, fd, handle.set_internal.index);
+  } else {
+    // Handles without fds can only be matched by identity.
+    for (iree_host_size_t i = 0; i < set->slot_high_water_mark; ++i) {
+      if (set->slots[i].ref_count > 0 &&
+          iree_wait_primitive_compare_identical(&set->slots[i].user_handle,
+                                                &handle)) {
+        index = (int)i;
+        break;
+      }
+    }
+  }
+  if (IREE_UNLIKELY(index < 0)) return;  // not in the set
+  if (--set->slots[index].ref_count == 0) {
+    iree_wait_set_release_slot(set, (iree_host_size_t)index);
+  }
 }
 
 void iree_wait_set_clear(iree_wait_set_t* set) {
-  // TODO(benvanik): close and reopen?
+  // NOTE: we unregister each fd instead of recreating the epoll fd so that
+  // clearing cannot fail. Sets are rarely cleared in bulk.
+  for (iree_host_size_t i = 0; i < set->slot_high_water_mark; ++i) {
+    if (set->slots[i].ref_count > 0) iree_wait_set_release_slot(set, i);
+  }
+  set->slot_high_water_mark = 0;
+  set->free_count = 0;
+}
+
+// Maps epoll events to a status (on failure) and an indicator of whether the
+// event was signaled.
+static iree_status_t iree_wait_set_resolve_epoll_events(uint32_t events,
+                                                        bool* out_signaled) {
+  if (events & EPOLLERR) {
+    return iree_make_status(IREE_STATUS_INTERNAL, "EPOLLERR on fd");
+  } else if (events & EPOLLHUP) {
+    return iree_make_status(IREE_STATUS_CANCELLED, "EPOLLHUP on fd");
+  }
+  *out_signaled = (events & (EPOLLIN | EPOLLPRI)) != 0;
+  return iree_ok_status();
 }
 
 iree_status_t iree_wait_all(iree_wait_set_t* set, iree_time_t deadline_ns) {
-  // TODO(benvanik): epoll_wait
+  // Make the syscall only when we have at least one valid fd.
+  // Don't use this as a sleep.
+  if (set->registered_count == 0) {
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // epoll has no wait-all mode and level-triggered registrations would keep
+  // reporting handles that have already signaled. Since all handles must be
+  // signaled for the wait to succeed and handles stay signaled until reset we
+  // can instead wait on each in turn with the same deadline: handles that are
+  // already signaled return immediately. Wait-all is rare compared to the
+  // wait-any the task poller uses so this isn't worth more machinery.
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0;
+       i < set->slot_high_water_mark && iree_status_is_ok(status); ++i) {
+    iree_wait_set_slot_t* slot = &set->slots[i];
+    if (slot->ref_count == 0 || slot->fd < 0) continue;
+    status = iree_wait_one(&slot->user_handle, deadline_ns);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 iree_status_t iree_wait_any(iree_wait_set_t* set, iree_time_t deadline_ns,
                             iree_wait_handle_t* out_wake_handle) {
-  // TODO(benvanik): epoll_wait
+  // Make the syscall only when we have at least one valid fd.
+  // Don't use this as a sleep.
+  if (set->registered_count == 0) {
+    memset(out_wake_handle, 0, sizeof(*out_wake_handle));
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // TODO(benvanik): see if we can use tracy's mutex tracking to make waits
+  // nicer (at least showing signal->wait relations).
+
+  // We only need a single signaled handle to return. The kernel rotates
+  // through ready fds across calls so that a handle that stays signaled won't
+  // starve others.
+  memset(out_wake_handle, 0, sizeof(*out_wake_handle));
+  struct epoll_event event;
+  int signaled_count = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_syscall_epoll_wait(set->epoll_fd, &event, 1, deadline_ns,
+                                  &signaled_count));
+
+  if (signaled_count > 0) {
+    bool signaled = false;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_wait_set_resolve_epoll_events(event.events, &signaled));
+    iree_host_size_t index = (iree_host_size_t)event.data.u64;
+    if (signaled && index < set->slot_high_water_mark) {
+      memcpy(out_wake_handle, &set->slots[index].user_handle,
+             sizeof(*out_wake_handle));
+      out_wake_handle->set_internal.index = index;
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
 }
 
 iree_status_t iree_wait_one(iree_wait_handle_t* handle,
                             iree_time_t deadline_ns) {
-  // TODO(benvanik): just use poll?
+  struct pollfd poll_fd;
+  poll_fd.fd = iree_wait_primitive_get_read_fd(handle);
+  if (poll_fd.fd == -1) return iree_ok_status();
+  poll_fd.events = POLLIN;
+  poll_fd.revents = 0;
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_syscall_ppoll_one(&poll_fd, deadline_ns);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 #endif  // IREE_WAIT_API == IREE_WAIT_API_EPOLL
@@ -53,8 +53,10 @@
 #define IREE_WAIT_API IREE_WAIT_API_INPROC
 #elif defined(IREE_PLATFORM_WINDOWS)
 #define IREE_WAIT_API IREE_WAIT_API_WIN32  // WFMO used in wait_handle_win32.c
+#elif defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID)
+#define IREE_WAIT_API IREE_WAIT_API_EPOLL  // epoll used in wait_handle_epoll.c
 #else
-// TODO(benvanik): EPOLL on android/linux/bsd/etc.
+// TODO(benvanik): EPOLL on bsd/etc.
 // TODO(benvanik): KQUEUE on mac/ios.
 // KQUEUE is not implemented yet. Use POLL for mac/ios
 // Android ppoll requires API version >= 21
@@ -12,6 +12,7 @@
 #include <cstddef>
 #include <cstring>
 #include <thread>
+#include <vector>
 
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
@@ -726,6 +727,56 @@ TEST(WaitSet, WaitAnyErase) {
   iree_event_deinitialize(&ev_set);
 }
 
+// Tests iree_wait_any with more handles than poll-style/WFMO sets support well.
+TEST(WaitSet, WaitAnyManyHandles) {
+  if (!iree_wait_set_is_scalable()) {
+    GTEST_SKIP() << "wait set implementation is not scalable";
+  }
+  static const iree_host_size_t kHandleCount = 256;
+  std::vector<iree_event_t> events(kHandleCount);
+  for (iree_host_size_t i = 0; i < kHandleCount; ++i) {
+    IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &events[i]));
+  }
+  iree_wait_set_t* wait_set = NULL;
+  IREE_ASSERT_OK(
+      iree_wait_set_allocate(kHandleCount, iree_allocator_system(), &wait_set));
+  for (iree_host_size_t i = 0; i < kHandleCount; ++i) {
+    IREE_ASSERT_OK(iree_wait_set_insert(wait_set, events[i]));
+  }
+
+  // Nothing signaled yet.
+  iree_wait_handle_t wake_handle;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+
+  // Signal one in the middle and ensure it's the one we wake on.
+  iree_event_t* ev_set = &events[kHandleCount / 2 + 1];
+  iree_event_set(ev_set);
+  IREE_ASSERT_OK(
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+  EXPECT_EQ(0,
+            memcmp(&ev_set->value, &wake_handle.value, sizeof(ev_set->value)));
+
+  // Erasing the woken handle should leave only unsignaled handles.
+  iree_wait_set_erase(wait_set, wake_handle);
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+
+  // Reinserting the signaled handle should reuse the freed slot.
+  IREE_ASSERT_OK(iree_wait_set_insert(wait_set, *ev_set));
+  IREE_ASSERT_OK(
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+  EXPECT_EQ(0,
+            memcmp(&ev_set->value, &wake_handle.value, sizeof(ev_set->value)));
+
+  iree_wait_set_free(wait_set);
+  for (iree_host_size_t i = 0; i < kHandleCount; ++i) {
+    iree_event_deinitialize(&events[i]);
+  }
+}
+
 // Tests that an iree_wait_any followed by an iree_wait_set_erase properly
 // chooses the right handle to erase (the tail one).
 TEST(WaitSet, WaitAnyEraseTail) {
@@ -0,0 +1,114 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/profiler.h"
+
+iree_atomic_int32_t iree_profiler_event_mask_ = IREE_ATOMIC_VAR_INIT(0);
+
+// Registered iree_profiler_t*, if any.
+static iree_atomic_intptr_t iree_profiler_ = IREE_ATOMIC_VAR_INIT(0);
+
+#if defined(IREE_COMPILER_MSVC)
+#define IREE_PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#define IREE_PROFILER_THREAD_LOCAL _Thread_local
+#endif  // IREE_COMPILER_MSVC
+
+// Source events without a name are attributed to on the current thread.
+static IREE_PROFILER_THREAD_LOCAL iree_string_view_t
+    iree_profiler_thread_source_ = {NULL, 0};
+
+IREE_API_EXPORT iree_string_view_t
+iree_profiler_event_type_name(iree_profiler_event_type_t type) {
+  switch (type) {
+    case IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN:
+      return IREE_SV("dispatch_begin");
+    case IREE_PROFILER_EVENT_TYPE_DISPATCH_END:
+      return IREE_SV("dispatch_end");
+    case IREE_PROFILER_EVENT_TYPE_SUBMIT:
+      return IREE_SV("submit");
+    case IREE_PROFILER_EVENT_TYPE_WAIT_BEGIN:
+      return IREE_SV("wait_begin");
+    case IREE_PROFILER_EVENT_TYPE_WAIT_END:
+      return IREE_SV("wait_end");
+    case IREE_PROFILER_EVENT_TYPE_ALLOCATE:
+      return IREE_SV("allocate");
+    case IREE_PROFILER_EVENT_TYPE_FREE:
+      return IREE_SV("free");
+    case IREE_PROFILER_EVENT_TYPE_INVOKE_BEGIN:
+      return IREE_SV("invoke_begin");
+    case IREE_PROFILER_EVENT_TYPE_INVOKE_END:
+      return IREE_SV("invoke_end");
+    case IREE_PROFILER_EVENT_TYPE_TILES_BEGIN:
+      return IREE_SV("tiles_begin");
+    case IREE_PROFILER_EVENT_TYPE_TILES_END:
+      return IREE_SV("tiles_end");
+    default:
+      return IREE_SV("unknown");
+  }
+}
+
+IREE_API_EXPORT void iree_profiler_set(const iree_profiler_t* profiler) {
+  // Clear the mask before swapping so that hooks stop entering the slow path
+  // for events the new profiler (if any) does not want.
+  iree_atomic_store_int32(&iree_profiler_event_mask_, 0,
+                          iree_memory_order_release);
+  iree_atomic_store_intptr(&iree_profiler_, (intptr_t)profiler,
+                           iree_memory_order_release);
+  if (profiler && profiler->fn) {
+    iree_atomic_store_int32(
+        &iree_profiler_event_mask_,
+        (int32_t)(profiler->event_mask & IREE_PROFILER_EVENT_MASK_ALL),
+        iree_memory_order_release);
+  }
+}
+
+IREE_API_EXPORT const iree_profiler_t* iree_profiler_get(void) {
+  return (const iree_profiler_t*)iree_atomic_load_intptr(
+      &iree_profiler_, iree_memory_order_acquire);
+}
+
+IREE_API_EXPORT iree_string_view_t
+iree_profiler_set_thread_source(iree_string_view_t source) {
+  iree_string_view_t previous = iree_profiler_thread_source_;
+  iree_profiler_thread_source_ = source;
+  return previous;
+}
+
+IREE_API_EXPORT void iree_profiler_record_event(iree_profiler_event_t event) {
+  // The mask may have been stale so recheck against the profiler itself.
+  const iree_profiler_t* profiler = iree_profiler_get();
+  if (!profiler || !profiler->fn) return;
+  if (!(profiler->event_mask & (1u << event.type))) return;
+  if (!event.timestamp_ns) event.timestamp_ns = iree_time_now();
+  if (iree_string_view_is_empty(event.name)) {
+    event.name = iree_profiler_thread_source_;
+  }
+  profiler->fn(profiler->user_data, &event);
+}
+
+IREE_API_EXPORT void iree_profiler_record_at(iree_profiler_event_type_t type,
+                                             iree_time_t timestamp_ns,
+                                             uint64_t id,
+                                             iree_string_view_t name,
+                                             uint64_t value) {
+  iree_profiler_event_t event = {
+      .type = type,
+      .timestamp_ns = timestamp_ns,
+      .id = id,
+      .name = name,
+      .value = value,
+      .flags = 0,
+  };
+  iree_profiler_record_event(event);
+}
+
+IREE_API_EXPORT void iree_profiler_record_slow(iree_profiler_event_type_t type,
+                                               uint64_t id,
+                                               iree_string_view_t name,
+                                               uint64_t value) {
+  iree_profiler_record_at(type, iree_time_now(), id, name, value);
+}
@@ -0,0 +1,220 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Lightweight structured event hooks for production monitoring.
+//
+// Unlike iree/base/tracing.h, which targets the Tracy profiler and is compiled
+// in only for special builds, these hooks are always available and report a
+// small fixed set of events (VM invocations, dispatch begin/end, worker tile
+// ranges, submissions, waits, and allocations) to a single profiler registered
+// at runtime. Applications can
+// sample the events into their own telemetry or use one of the sinks in
+// iree/base/internal/profiler_sink.h to write them to a file.
+//
+// When no profiler is registered each hook costs a relaxed atomic load and a
+// predicted branch. IREE_PROFILER_ENABLE=0 removes the hooks entirely.
+
+#ifndef IREE_BASE_PROFILER_H_
+#define IREE_BASE_PROFILER_H_
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_profiler_event_t
+//===----------------------------------------------------------------------===//
+
+// Identifies the operation an event was recorded for.
+typedef enum iree_profiler_event_type_e {
+  // A dispatch has begun executing.
+  // |id| is unique to the dispatch while it is in-flight and |value| is the
+  // total number of workgroups.
+  IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN = 0,
+  // A dispatch has completed executing.
+  // |id| matches the IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN event and |value|
+  // is the number of workgroups executed.
+  IREE_PROFILER_EVENT_TYPE_DISPATCH_END,
+  // Work has been submitted to a device queue.
+  // |name| is the device identifier and |value| is the number of command
+  // buffers submitted.
+  IREE_PROFILER_EVENT_TYPE_SUBMIT,
+  // A host thread has begun waiting on one or more semaphores.
+  // |id| identifies the wait and |value| is the payload waited on (or the
+  // number of semaphores when waiting on a list).
+  IREE_PROFILER_EVENT_TYPE_WAIT_BEGIN,
+  // A host thread has stopped waiting; |id| matches the begin event.
+  IREE_PROFILER_EVENT_TYPE_WAIT_END,
+  // A buffer has been allocated.
+  // |id| identifies the buffer until it is freed, |value| is its size in
+  // bytes, and |flags| is its iree_hal_memory_type_t.
+  IREE_PROFILER_EVENT_TYPE_ALLOCATE,
+  // A buffer has been freed; |id| matches the allocation event.
+  // Buffers wrapping externally-owned memory may report a free without a
+  // corresponding allocation.
+  IREE_PROFILER_EVENT_TYPE_FREE,
+  // A host thread has entered a VM function through the invocation API.
+  // |id| identifies the invocation and |name| is the function name.
+  IREE_PROFILER_EVENT_TYPE_INVOKE_BEGIN,
+  // A VM invocation has returned; |id| matches the begin event.
+  IREE_PROFILER_EVENT_TYPE_INVOKE_END,
+  // A task executor worker has begun executing a range of dispatch tiles.
+  // |id| is the worker index; ranges on the same worker never overlap.
+  IREE_PROFILER_EVENT_TYPE_TILES_BEGIN,
+  // A worker has finished executing tiles; |value| is the number executed
+  // when statistics are enabled and otherwise 0.
+  IREE_PROFILER_EVENT_TYPE_TILES_END,
+
+  IREE_PROFILER_EVENT_TYPE_COUNT,
+} iree_profiler_event_type_t;
+
+// Bitmask of (1 << iree_profiler_event_type_t) values.
+typedef uint32_t iree_profiler_event_mask_t;
+enum iree_profiler_event_mask_bits_t {
+  IREE_PROFILER_EVENT_MASK_NONE = 0u,
+  IREE_PROFILER_EVENT_MASK_DISPATCH =
+      (1u << IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN) |
+      (1u << IREE_PROFILER_EVENT_TYPE_DISPATCH_END),
+  IREE_PROFILER_EVENT_MASK_SUBMIT = 1u << IREE_PROFILER_EVENT_TYPE_SUBMIT,
+  IREE_PROFILER_EVENT_MASK_WAIT = (1u << IREE_PROFILER_EVENT_TYPE_WAIT_BEGIN) |
+                                  (1u << IREE_PROFILER_EVENT_TYPE_WAIT_END),
+  IREE_PROFILER_EVENT_MASK_ALLOCATION =
+      (1u << IREE_PROFILER_EVENT_TYPE_ALLOCATE) |
+      (1u << IREE_PROFILER_EVENT_TYPE_FREE),
+  IREE_PROFILER_EVENT_MASK_INVOKE =
+      (1u << IREE_PROFILER_EVENT_TYPE_INVOKE_BEGIN) |
+      (1u << IREE_PROFILER_EVENT_TYPE_INVOKE_END),
+  // Tile events are recorded per worker per dispatch and may be high volume.
+  IREE_PROFILER_EVENT_MASK_TILES =
+      (1u << IREE_PROFILER_EVENT_TYPE_TILES_BEGIN) |
+      (1u << IREE_PROFILER_EVENT_TYPE_TILES_END),
+  IREE_PROFILER_EVENT_MASK_ALL = (1u << IREE_PROFILER_EVENT_TYPE_COUNT) - 1,
+};
+
+// A single structured profiler event.
+// Events are only valid for the duration of the callback they are passed to
+// and any data (such as |name|) must be copied if retained.
+typedef struct iree_profiler_event_t {
+  iree_profiler_event_type_t type;
+  // Time the event occurred as returned by iree_time_now.
+  iree_time_t timestamp_ns;
+  // Correlates begin/end and allocate/free pairs. Opaque to profilers.
+  uint64_t id;
+  // Source of the event; may be empty. Not NUL terminated.
+  // Events recorded without a name of their own are attributed to the source
+  // set with iree_profiler_set_thread_source on the recording thread, if any.
+  iree_string_view_t name;
+  // Event-specific value; see iree_profiler_event_type_t.
+  uint64_t value;
+  // Event-specific flags; see iree_profiler_event_type_t.
+  uint32_t flags;
+} iree_profiler_event_t;
+
+// Returns a short stable name for |type| (such as `dispatch_begin`).
+IREE_API_EXPORT iree_string_view_t
+iree_profiler_event_type_name(iree_profiler_event_type_t type);
+
+//===----------------------------------------------------------------------===//
+// iree_profiler_t
+//===----------------------------------------------------------------------===//
+
+// Receives profiler events.
+// Called synchronously from the thread that recorded the event, which may be
+// any thread in the process including task executor workers. Implementations
+// must be thread-safe and should return quickly.
+typedef void(IREE_API_PTR* iree_profiler_event_fn_t)(
+    void* user_data, const iree_profiler_event_t* event);
+
+typedef struct iree_profiler_t {
+  // Function called for each recorded event in |event_mask|.
+  iree_profiler_event_fn_t fn;
+  // User data passed to |fn|.
+  void* user_data;
+  // Events to record; others are dropped at the hook site.
+  iree_profiler_event_mask_t event_mask;
+} iree_profiler_t;
+
+// Registers |profiler| as the process-wide event receiver, replacing any
+// existing one. Passing NULL unregisters the current profiler.
+//
+// |profiler| is not copied and must remain valid until it has been replaced and
+// all threads that may have been recording events have quiesced. The simplest
+// way to satisfy this is to only swap profilers while no devices are running.
+IREE_API_EXPORT void iree_profiler_set(const iree_profiler_t* profiler);
+
+// Returns the currently registered profiler, if any.
+IREE_API_EXPORT const iree_profiler_t* iree_profiler_get(void);
+
+// Attributes events recorded on the calling thread that have no name of their
+// own (such as allocations) to |source| and returns the prior source so that
+// callers can restore it. |source| must remain valid until it is replaced.
+// Used by higher layers like the VM to report which function caused an event.
+IREE_API_EXPORT iree_string_view_t
+iree_profiler_set_thread_source(iree_string_view_t source);
+
+// Records a fully populated |event|. A |timestamp_ns| of 0 is replaced with the
+// current time. Callers should check iree_profiler_is_enabled first.
+IREE_API_EXPORT void iree_profiler_record_event(iree_profiler_event_t event);
+
+// Records an event that occurred at |timestamp_ns|, which must have been
+// taken with iree_time_now. Used when whether an event happened is only known
+// after the fact. Callers should check iree_profiler_is_enabled first.
+IREE_API_EXPORT void iree_profiler_record_at(iree_profiler_event_type_t type,
+                                             iree_time_t timestamp_ns,
+                                             uint64_t id,
+                                             iree_string_view_t name,
+                                             uint64_t value);
+
+// Slow path of iree_profiler_record; prefer that.
+IREE_API_EXPORT void iree_profiler_record_slow(iree_profiler_event_type_t type,
+                                               uint64_t id,
+                                               iree_string_view_t name,
+                                               uint64_t value);
+
+#if IREE_PROFILER_ENABLE
+
+// Mask of events the registered profiler wants. Only for use by the inline
+// hooks below; use iree_profiler_set to change.
+extern iree_atomic_int32_t iree_profiler_event_mask_;
+
+// Returns true if a profiler is registered that records any event in |mask|.
+// Used to guard any expensive work needed to populate events.
+static inline bool iree_profiler_is_enabled(iree_profiler_event_mask_t mask) {
+  return IREE_UNLIKELY(
+      (iree_atomic_load_int32(&iree_profiler_event_mask_,
+                              iree_memory_order_relaxed) &
+       mask) != 0);
+}
+
+// Records an event of |type| if the registered profiler wants it.
+static inline void iree_profiler_record(iree_profiler_event_type_t type,
+                                        uint64_t id, iree_string_view_t name,
+                                        uint64_t value) {
+  if (iree_profiler_is_enabled(1u << type)) {
+    iree_profiler_record_slow(type, id, name, value);
+  }
+}
+
+#else
+
+static inline bool iree_profiler_is_enabled(iree_profiler_event_mask_t mask) {
+  return false;
+}
+
+static inline void iree_profiler_record(iree_profiler_event_type_t type,
+                                        uint64_t id, iree_string_view_t name,
+                                        uint64_t value) {}
+
+#endif  // IREE_PROFILER_ENABLE
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BASE_PROFILER_H_
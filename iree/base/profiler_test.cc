@@ -0,0 +1,86 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/profiler.h"
+
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+
+namespace {
+
+struct RecordedEvents {
+  static void Record(void* user_data, const iree_profiler_event_t* event) {
+    static_cast<RecordedEvents*>(user_data)->events.push_back(*event);
+  }
+  std::vector<iree_profiler_event_t> events;
+};
+
+class ProfilerTest : public ::testing::Test {
+ protected:
+  void TearDown() override { iree_profiler_set(NULL); }
+};
+
+TEST_F(ProfilerTest, DisabledByDefault) {
+  EXPECT_EQ(iree_profiler_get(), nullptr);
+  EXPECT_FALSE(iree_profiler_is_enabled(IREE_PROFILER_EVENT_MASK_ALL));
+  // Must be a no-op.
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_SUBMIT, 0,
+                       iree_string_view_empty(), 0);
+}
+
+#if IREE_PROFILER_ENABLE
+
+TEST_F(ProfilerTest, RecordsMaskedEvents) {
+  RecordedEvents recorded;
+  iree_profiler_t profiler = {
+      RecordedEvents::Record,
+      &recorded,
+      IREE_PROFILER_EVENT_MASK_DISPATCH,
+  };
+  iree_profiler_set(&profiler);
+  EXPECT_EQ(iree_profiler_get(), &profiler);
+  EXPECT_TRUE(iree_profiler_is_enabled(IREE_PROFILER_EVENT_MASK_DISPATCH));
+  EXPECT_FALSE(iree_profiler_is_enabled(IREE_PROFILER_EVENT_MASK_ALLOCATION));
+
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN, 123,
+                       IREE_SV("foo"), 64);
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_ALLOCATE, 456,
+                       iree_string_view_empty(), 1024);
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_DISPATCH_END, 123,
+                       IREE_SV("foo"), 64);
+
+  ASSERT_EQ(recorded.events.size(), 2);
+  EXPECT_EQ(recorded.events[0].type, IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN);
+  EXPECT_EQ(recorded.events[0].id, 123);
+  EXPECT_TRUE(iree_string_view_equal(recorded.events[0].name, IREE_SV("foo")));
+  EXPECT_EQ(recorded.events[0].value, 64);
+  EXPECT_EQ(recorded.events[1].type, IREE_PROFILER_EVENT_TYPE_DISPATCH_END);
+  EXPECT_LE(recorded.events[0].timestamp_ns, recorded.events[1].timestamp_ns);
+}
+
+TEST_F(ProfilerTest, Unregister) {
+  RecordedEvents recorded;
+  iree_profiler_t profiler = {
+      RecordedEvents::Record,
+      &recorded,
+      IREE_PROFILER_EVENT_MASK_ALL,
+  };
+  iree_profiler_set(&profiler);
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_SUBMIT, 0,
+                       iree_string_view_empty(), 1);
+  iree_profiler_set(NULL);
+  EXPECT_FALSE(iree_profiler_is_enabled(IREE_PROFILER_EVENT_MASK_ALL));
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_SUBMIT, 0,
+                       iree_string_view_empty(), 2);
+  ASSERT_EQ(recorded.events.size(), 1);
+  EXPECT_EQ(recorded.events[0].value, 1);
+}
+
+#endif  // IREE_PROFILER_ENABLE
+
+}  // namespace
@@ -7,6 +7,9 @@
 #include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
 #include "mlir/Dialect/Affine/Utils.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
@@ -23,6 +26,15 @@ namespace iree_compiler {
 namespace IREE {
 namespace ABI {
 
+static llvm::cl::list<std::string> clKnownDims(
+    "iree-abi-known-dims",
+    llvm::cl::desc("Comma-separated `name=value` sizes of dynamic entry point "
+                   "argument dimensions named with `iree.abi.dims` that are "
+                   "fixed for a deployment (e.g. 'batch=1,seq_len=128'). The "
+                   "dimensions are compiled as static and checked when "
+                   "called."),
+    llvm::cl::CommaSeparated);
+
 // Wraps all entry points in a function that is compatible with the
 // expected invocation semantics of bindings following the native IREE ABI.
 class WrapEntryPointsPass
@@ -46,6 +58,19 @@ class WrapEntryPointsPass
   void runOnOperation() override {
     auto moduleOp = getOperation();
 
+    knownDims.clear();
+    for (auto &knownDim : clKnownDims) {
+      auto nameValue = StringRef(knownDim).split('=');
+      int64_t value = 0;
+      if (nameValue.first.empty() ||
+          nameValue.second.trim().getAsInteger(10, value) || value < 0) {
+        moduleOp.emitError() << "invalid --iree-abi-known-dims entry '"
+                             << knownDim << "'; expected `name=size`";
+        return signalPassFailure();
+      }
+      knownDims[nameValue.first.trim()] = value;
+    }
+
     SmallVector<FuncOp, 4> entryFuncOps;
     for (auto funcOp : moduleOp.getOps<FuncOp>()) {
       if (funcOp.isPublic() && !funcOp->hasAttr("iree.abi.stub")) {
@@ -79,6 +104,29 @@ class WrapEntryPointsPass
   }
 
  private:
+  // Returns |tensorType| of argument |argIndex| of |entryFuncOp| with the
+  // dynamic dimensions named in its `iree.abi.dims` attribute replaced by
+  // their sizes in --iree-abi-known-dims. Dimensions are named by the strings
+  // in the array; unnamed dimensions use an empty string.
+  RankedTensorType refineKnownDims(FuncOp entryFuncOp, unsigned argIndex,
+                                   RankedTensorType tensorType) {
+    auto dimsAttr =
+        entryFuncOp.getArgAttrOfType<ArrayAttr>(argIndex, "iree.abi.dims");
+    if (!dimsAttr || knownDims.empty()) return tensorType;
+    SmallVector<int64_t> shape(tensorType.getShape().begin(),
+                               tensorType.getShape().end());
+    for (auto dimAttr : llvm::enumerate(dimsAttr)) {
+      if (dimAttr.index() >= shape.size()) break;
+      if (!tensorType.isDynamicDim(dimAttr.index())) continue;
+      auto nameAttr = dimAttr.value().dyn_cast<StringAttr>();
+      if (!nameAttr) continue;
+      auto it = knownDims.find(nameAttr.getValue());
+      if (it != knownDims.end()) shape[dimAttr.index()] = it->second;
+    }
+    return RankedTensorType::get(shape, tensorType.getElementType(),
+                                 tensorType.getEncoding());
+  }
+
   Type mapToABIType(Type type) {
     if (type.isa<TensorType>()) {
       return IREE::HAL::BufferViewType::get(type.getContext());
@@ -110,6 +158,28 @@ class WrapEntryPointsPass
     for (auto oldType : entryFuncType.getResults()) {
       resultTypes.push_back(mapToABIType(oldType));
     }
+
+    // Entry points with `iree.abi.output_storage` take a trailing !hal.buffer
+    // argument for each tensor result that does not already have storage
+    // bound with `iree.abi.output`. Callers preallocate the result storage
+    // (such as their response buffers) and the results are written into it
+    // instead of into buffers allocated on every call.
+    SmallVector<unsigned> trailingStorageResults;
+    if (entryFuncOp->hasAttr("iree.abi.output_storage")) {
+      llvm::SmallBitVector boundResults(resultTypes.size());
+      for (unsigned i = 0; i < entryFuncType.getNumInputs(); ++i) {
+        auto outputAttr =
+            entryFuncOp.getArgAttrOfType<IntegerAttr>(i, "iree.abi.output");
+        if (outputAttr) boundResults.set(outputAttr.getInt());
+      }
+      for (auto oldType : llvm::enumerate(entryFuncType.getResults())) {
+        if (!oldType.value().isa<TensorType>()) continue;
+        if (boundResults.test(oldType.index())) continue;
+        trailingStorageResults.push_back(oldType.index());
+        inputTypes.push_back(
+            IREE::HAL::BufferType::get(entryFuncOp.getContext()));
+      }
+    }
     auto wrapperFuncType =
         FunctionType::get(entryFuncOp.getContext(), inputTypes, resultTypes);
 
@@ -118,6 +188,8 @@ class WrapEntryPointsPass
 
     SmallVector<DictionaryAttr, 4> argAttrDict;
     entryFuncOp.getAllArgAttrs(argAttrDict);
+    argAttrDict.resize(inputTypes.size(),
+                       DictionaryAttr::get(entryFuncOp.getContext()));
     wrapperFuncOp.setAllArgAttrs(argAttrDict);
     SmallVector<DictionaryAttr, 4> resultAttrDict;
     entryFuncOp.getAllResultAttrs(resultAttrDict);
@@ -131,7 +203,7 @@ class WrapEntryPointsPass
     // Build a map of result value to the argument that has its backing storage.
     SmallVector<Value> resultStorages;
     resultStorages.resize(resultTypes.size());
-    for (unsigned i = 0; i < inputTypes.size(); ++i) {
+    for (unsigned i = 0; i < entryFuncType.getNumInputs(); ++i) {
       auto outputAttr =
           entryFuncOp.getArgAttrOfType<IntegerAttr>(i, "iree.abi.output");
       if (!outputAttr) continue;
@@ -146,16 +218,31 @@ class WrapEntryPointsPass
       }
       resultStorages[outputAttr.getInt()] = storageArg;
     }
+    for (auto resultIndex : llvm::enumerate(trailingStorageResults)) {
+      resultStorages[resultIndex.value()] = entryBlock->getArgument(
+          entryFuncType.getNumInputs() + resultIndex.index());
+    }
 
     // Marshal arguments.
     SmallVector<Value> arguments;
-    for (auto arg : llvm::enumerate(entryBlock->getArguments())) {
+    for (auto arg : llvm::enumerate(entryBlock->getArguments().take_front(
+             entryFuncType.getNumInputs()))) {
       auto oldType = entryFuncType.getInput(arg.index());
       if (auto tensorType = oldType.dyn_cast<RankedTensorType>()) {
+        // Dimensions known for the deployment are imported as static (and
+        // asserted against the buffer view at runtime) and cast back to the
+        // original type; canonicalization propagates the static sizes into
+        // the program so that dispatches are compiled for them.
         auto argLoc = arg.value().getLoc();
+        auto importType = refineKnownDims(entryFuncOp, arg.index(), tensorType);
         auto importOp = entryBuilder.create<IREE::HAL::TensorImportOp>(
-            argLoc, oldType, arg.value());
-        arguments.push_back(importOp.target());
+            argLoc, importType, arg.value());
+        Value argument = importOp.target();
+        if (importType != tensorType) {
+          argument =
+              entryBuilder.create<tensor::CastOp>(argLoc, oldType, argument);
+        }
+        arguments.push_back(argument);
       } else {
         arguments.push_back(arg.value());
       }
@@ -199,6 +286,9 @@ class WrapEntryPointsPass
       wrapperFuncOp->setAttr("iree.reflection", reflectionAttr);
     }
   }
+
+  // Sizes of named dimensions parsed from --iree-abi-known-dims.
+  llvm::StringMap<int64_t> knownDims;
 };
 
 std::unique_ptr<OperationPass<ModuleOp>> createWrapEntryPointsPass() {
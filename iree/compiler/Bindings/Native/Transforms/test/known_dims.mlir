@@ -0,0 +1,24 @@
+// RUN: iree-opt -iree-abi-wrap-entry-points -iree-abi-known-dims=batch=4,seq_len=128 %s | FileCheck %s
+
+// CHECK-LABEL: func @knownDims(
+//  CHECK-SAME:   %[[ARG0:.+]]: !hal.buffer_view {iree.abi.dims = ["batch", "seq_len", ""]}
+//  CHECK-SAME:   %[[ARG1:.+]]: !hal.buffer_view {iree.abi.dims = ["", "batch"]}
+//       CHECK:   %[[ARG0_TENSOR:.+]] = hal.tensor.import %[[ARG0]] : !hal.buffer_view -> tensor<4x128x?xf32>{%{{.+}}}
+//  CHECK-NEXT:   %[[ARG0_CAST:.+]] = tensor.cast %[[ARG0_TENSOR]] : tensor<4x128x?xf32> to tensor<?x?x?xf32>
+//       CHECK:   %[[ARG1_TENSOR:.+]] = hal.tensor.import %[[ARG1]] : !hal.buffer_view -> tensor<8x4xf32>
+//  CHECK-NEXT:   %[[ARG1_CAST:.+]] = tensor.cast %[[ARG1_TENSOR]] : tensor<8x4xf32> to tensor<8x?xf32>
+//  CHECK-NEXT:   call @_knownDims(%[[ARG0_CAST]], %[[ARG1_CAST]])
+
+// CHECK-LABEL: func private @_knownDims(
+func @knownDims(%arg0: tensor<?x?x?xf32> {iree.abi.dims = ["batch", "seq_len", ""]},
+                %arg1: tensor<8x?xf32> {iree.abi.dims = ["", "batch"]}) -> tensor<?x?x?xf32> {
+  return %arg0 : tensor<?x?x?xf32>
+}
+
+// CHECK-LABEL: func @unnamedDims(
+//  CHECK-NEXT:   %[[DIM:.+]] = hal.buffer_view.dim
+//  CHECK-NEXT:   hal.tensor.import %{{.+}} : !hal.buffer_view -> tensor<?xf32>{%[[DIM]]}
+//   CHECK-NOT:   tensor.cast
+func @unnamedDims(%arg0: tensor<?xf32>) -> tensor<?xf32> {
+  return %arg0 : tensor<?xf32>
+}
@@ -57,6 +57,29 @@ func @outputStorage(%arg0: tensor<?x8x8x3xf32>, %ret1: !hal.buffer {iree.abi.out
 
 // -----
 
+// CHECK-LABEL: func @allOutputStorage(
+//  CHECK-SAME:   %[[ARG0:.+]]: !hal.buffer_view,
+//  CHECK-SAME:   %[[RET2_STORAGE:.+]]: !hal.buffer {iree.abi.output = 2 : index},
+//  CHECK-SAME:   %[[RET0_STORAGE:.+]]: !hal.buffer
+//  CHECK-SAME: -> (
+//  CHECK-SAME:   !hal.buffer_view, i32, !hal.buffer_view
+//  CHECK-SAME: )
+//  CHECK-NEXT:   %[[ARG0_TENSOR:.+]] = hal.tensor.import %[[ARG0]] : !hal.buffer_view -> tensor<4xf32>
+//  CHECK-NEXT:   %[[RET:.+]]:3 = call @_allOutputStorage(%[[ARG0_TENSOR]], %[[RET2_STORAGE]])
+//  CHECK-NEXT:   %[[RET0_VIEW:.+]] = hal.tensor.export %[[RET]]#0 into %[[RET0_STORAGE]] : tensor<4xf32> -> !hal.buffer_view
+//  CHECK-NEXT:   %[[RET2_VIEW:.+]] = hal.tensor.export %[[RET]]#2 into %[[RET2_STORAGE]] : tensor<4xf32> -> !hal.buffer_view
+//  CHECK-NEXT:   return %[[RET0_VIEW]], %[[RET]]#1, %[[RET2_VIEW]] : !hal.buffer_view, i32, !hal.buffer_view
+//  CHECK-NEXT: }
+
+// CHECK-LABEL: func private @_allOutputStorage(
+func @allOutputStorage(%arg0: tensor<4xf32>, %ret2: !hal.buffer {iree.abi.output = 2 : index}) ->
+    (tensor<4xf32>, i32, tensor<4xf32>) attributes {iree.abi.output_storage} {
+  %c0 = arith.constant 0 : i32
+  return %arg0, %c0, %arg0 : tensor<4xf32>, i32, tensor<4xf32>
+}
+
+// -----
+
 // CHECK-LABEL: func @wrappedAlready
 //  CHECK-SAME: (%arg0: !hal.buffer_view) -> !hal.buffer_view
 //  CHECK-SAME: attributes {iree.abi.stub}
@@ -0,0 +1,320 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- FastMathApproximation.cpp ------------------------------------------===//
+//
+// Approximations of f32 math functions that are cheaper than the upstream
+// polynomial approximations, for targets that trade accuracy for throughput.
+// They apply to scalars and vectors alike and only use arithmetic available
+// on all backends. The maximum errors measured over the supported range are
+// documented in test/fast_math_approximation.mlir.
+//
+//===----------------------------------------------------------------------===//
+
+#include <limits>
+
+#include "iree/compiler/Codegen/Passes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/TypeUtilities.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Returns `elementType` with the shape of `type` if it is a vector.
+static Type getShapedLike(Type type, Type elementType) {
+  if (auto vectorType = type.dyn_cast<VectorType>()) {
+    return VectorType::get(vectorType.getShape(), elementType);
+  }
+  return elementType;
+}
+
+/// Returns a constant of `type` with all its elements set to `value`.
+static Value splatConstant(ImplicitLocOpBuilder &b, Type type,
+                           Attribute value) {
+  if (auto vectorType = type.dyn_cast<VectorType>()) {
+    value = DenseElementsAttr::get(vectorType, value);
+  }
+  return b.create<arith::ConstantOp>(value);
+}
+
+static Value f32Cst(ImplicitLocOpBuilder &b, Type type, float value) {
+  return splatConstant(b, type, b.getF32FloatAttr(value));
+}
+
+static Value i32Cst(ImplicitLocOpBuilder &b, Type type, int32_t value) {
+  return splatConstant(b, getShapedLike(type, b.getI32Type()),
+                       b.getI32IntegerAttr(value));
+}
+
+/// Evaluates the polynomial with `coefficients`, from the constant term up,
+/// at `x`.
+static Value evaluatePolynomial(ImplicitLocOpBuilder &b, Value x,
+                                ArrayRef<float> coefficients) {
+  Type type = x.getType();
+  Value result = f32Cst(b, type, coefficients.back());
+  for (float coefficient : llvm::reverse(coefficients.drop_back())) {
+    result = b.create<arith::AddFOp>(b.create<arith::MulFOp>(result, x),
+                                     f32Cst(b, type, coefficient));
+  }
+  return result;
+}
+
+/// Returns 2^n as an f32 for i32 `n` in [-126, 127].
+static Value createExp2(ImplicitLocOpBuilder &b, Type type, Value n) {
+  Value biased = b.create<arith::AddIOp>(n, i32Cst(b, type, 127));
+  Value bits = b.create<arith::ShLIOp>(biased, i32Cst(b, type, 23));
+  return b.create<arith::BitcastOp>(type, bits);
+}
+
+/// Returns `-x` where `condition` holds and `x` elsewhere.
+static Value negateIf(ImplicitLocOpBuilder &b, Value condition, Value x) {
+  return b.create<arith::SelectOp>(condition, b.create<arith::NegFOp>(x), x);
+}
+
+static Value cmpf(ImplicitLocOpBuilder &b, arith::CmpFPredicate predicate,
+                  Value lhs, Value rhs) {
+  return b.create<arith::CmpFOp>(predicate, lhs, rhs);
+}
+
+/// exp(x) = 2^n * exp(r) with n = round(x / ln(2)) and |r| <= ln(2) / 2,
+/// where exp(r) = 1 + r + r^2 * P(r). 2^n is applied as two factors so that
+/// results up to the largest finite float are reached without overflowing the
+/// exponent. Results below the smallest normal float are flushed to zero.
+static Value approximateExp(ImplicitLocOpBuilder &b, Value x) {
+  Type type = x.getType();
+  Value lowerBound = f32Cst(b, type, -87.3365402f);
+  Value upperBound = f32Cst(b, type, 88.7228394f);
+  Value clamped = b.create<arith::MinFOp>(
+      b.create<arith::MaxFOp>(x, lowerBound), upperBound);
+
+  Value nf = b.create<math::FloorOp>(b.create<arith::AddFOp>(
+      b.create<arith::MulFOp>(clamped, f32Cst(b, type, 1.44269502f)),
+      f32Cst(b, type, 0.5f)));
+  // ln(2) is split in two so that n * ln(2) is subtracted exactly.
+  Value r = b.create<arith::SubFOp>(
+      clamped, b.create<arith::MulFOp>(nf, f32Cst(b, type, 0.693359375f)));
+  r = b.create<arith::SubFOp>(
+      r, b.create<arith::MulFOp>(nf, f32Cst(b, type, -0.000212194442f)));
+  Value p = evaluatePolynomial(
+      b, r, {0.499997497f, 0.166666314f, 0.0418338031f, 0.00835719984f});
+  Value expR = b.create<arith::AddFOp>(
+      f32Cst(b, type, 1.0f),
+      b.create<arith::AddFOp>(
+          r, b.create<arith::MulFOp>(b.create<arith::MulFOp>(r, r), p)));
+
+  Value n =
+      b.create<arith::FPToSIOp>(getShapedLike(type, b.getI32Type()), nf);
+  Value nHalf = b.create<arith::ShRSIOp>(n, i32Cst(b, type, 1));
+  Value scaled = b.create<arith::MulFOp>(expR, createExp2(b, type, nHalf));
+  Value result = b.create<arith::MulFOp>(
+      scaled, createExp2(b, type, b.create<arith::SubIOp>(n, nHalf)));
+
+  result = b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::OLT, x, lowerBound), f32Cst(b, type, 0.0f),
+      result);
+  result = b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::OGT, x, upperBound),
+      f32Cst(b, type, std::numeric_limits<float>::infinity()), result);
+  return b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::UNO, x, x), x, result);
+}
+
+/// log(x) = e * ln(2) + log(m) with x = m * 2^e and sqrt(1/2) < m <= sqrt(2),
+/// where log(m) = f + f^2 * P(f) with f = m - 1. Denormal inputs are scaled
+/// into the normal range first.
+static Value approximateLog(ImplicitLocOpBuilder &b, Value x) {
+  Type type = x.getType();
+  Type i32Type = getShapedLike(type, b.getI32Type());
+  Value isDenormal = cmpf(b, arith::CmpFPredicate::OLT, x,
+                          f32Cst(b, type, 1.17549435e-38f));
+  Value normal = b.create<arith::SelectOp>(
+      isDenormal, b.create<arith::MulFOp>(x, f32Cst(b, type, 16777216.0f)),
+      x);
+
+  Value bits = b.create<arith::BitcastOp>(i32Type, normal);
+  Value e = b.create<arith::SubIOp>(
+      b.create<arith::ShRUIOp>(bits, i32Cst(b, type, 23)),
+      i32Cst(b, type, 127));
+  e = b.create<arith::SelectOp>(
+      isDenormal, b.create<arith::SubIOp>(e, i32Cst(b, type, 24)), e);
+  Value mantissaBits = b.create<arith::OrIOp>(
+      b.create<arith::AndIOp>(bits, i32Cst(b, type, 0x7fffff)),
+      i32Cst(b, type, 0x3f800000));
+  Value m = b.create<arith::BitcastOp>(type, mantissaBits);
+  Value isLarge = cmpf(b, arith::CmpFPredicate::OGT, m,
+                       f32Cst(b, type, 1.41421354f));
+  m = b.create<arith::SelectOp>(
+      isLarge, b.create<arith::MulFOp>(m, f32Cst(b, type, 0.5f)), m);
+  e = b.create<arith::SelectOp>(
+      isLarge, b.create<arith::AddIOp>(e, i32Cst(b, type, 1)), e);
+
+  Value f = b.create<arith::SubFOp>(m, f32Cst(b, type, 1.0f));
+  Value p = evaluatePolynomial(
+      b, f,
+      {-0.500000894f, 0.333341122f, -0.249824509f, 0.199290574f,
+       -0.171323866f, 0.159840956f, -0.101885863f});
+  Value result = b.create<arith::AddFOp>(
+      f, b.create<arith::MulFOp>(b.create<arith::MulFOp>(f, f), p));
+  Value ef = b.create<arith::SIToFPOp>(type, e);
+  result = b.create<arith::AddFOp>(
+      result, b.create<arith::MulFOp>(ef, f32Cst(b, type, -0.000212194442f)));
+  result = b.create<arith::AddFOp>(
+      result, b.create<arith::MulFOp>(ef, f32Cst(b, type, 0.693359375f)));
+
+  Value inf = f32Cst(b, type, std::numeric_limits<float>::infinity());
+  Value zero = f32Cst(b, type, 0.0f);
+  result = b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::OEQ, x, inf), inf, result);
+  result = b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::OEQ, x, zero),
+      f32Cst(b, type, -std::numeric_limits<float>::infinity()), result);
+  return b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::ULT, x, zero),
+      f32Cst(b, type, std::numeric_limits<float>::quiet_NaN()), result);
+}
+
+/// tanh(x) = x + x^3 * P(x^2) for |x| < 0.55 and
+/// sign(x) * (1 - 2 / (exp(2|x|) + 1)) elsewhere, with |x| clamped to 10
+/// beyond which tanh(x) rounds to 1.
+static Value approximateTanh(ImplicitLocOpBuilder &b, Value x) {
+  Type type = x.getType();
+  Value abs = b.create<math::AbsOp>(x);
+  Value x2 = b.create<arith::MulFOp>(x, x);
+  Value p = evaluatePolynomial(
+      b, x2, {-0.333332866f, 0.133284643f, -0.053146746f, 0.0172957517f});
+  Value small = b.create<arith::AddFOp>(
+      x, b.create<arith::MulFOp>(b.create<arith::MulFOp>(x, x2), p));
+
+  Value clamped = b.create<arith::MinFOp>(abs, f32Cst(b, type, 10.0f));
+  Value exp2x = approximateExp(
+      b, b.create<arith::MulFOp>(clamped, f32Cst(b, type, 2.0f)));
+  Value large = b.create<arith::SubFOp>(
+      f32Cst(b, type, 1.0f),
+      b.create<arith::DivFOp>(
+          f32Cst(b, type, 2.0f),
+          b.create<arith::AddFOp>(exp2x, f32Cst(b, type, 1.0f))));
+  large = negateIf(
+      b, cmpf(b, arith::CmpFPredicate::OLT, x, f32Cst(b, type, 0.0f)), large);
+  return b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::OLT, abs, f32Cst(b, type, 0.55f)), small,
+      large);
+}
+
+/// erf(x) = x * P(x^2) for |x| < 0.75 and
+/// sign(x) * (1 - t * Q(t) * exp(-x^2)) with t = 1 / (1 + 0.3275911 * |x|)
+/// elsewhere (Abramowitz and Stegun 7.1.26).
+static Value approximateErf(ImplicitLocOpBuilder &b, Value x) {
+  Type type = x.getType();
+  Value abs = b.create<math::AbsOp>(x);
+  Value x2 = b.create<arith::MulFOp>(x, x);
+  Value small = b.create<arith::MulFOp>(
+      x, evaluatePolynomial(b, x2,
+                            {1.12837911f, -0.376119494f, 0.112739176f,
+                             -0.0263653602f, 0.00416332949f}));
+
+  Value t = b.create<arith::DivFOp>(
+      f32Cst(b, type, 1.0f),
+      b.create<arith::AddFOp>(
+          f32Cst(b, type, 1.0f),
+          b.create<arith::MulFOp>(abs, f32Cst(b, type, 0.3275911f))));
+  Value q = b.create<arith::MulFOp>(
+      t, evaluatePolynomial(b, t,
+                            {0.254829592f, -0.284496736f, 1.421413741f,
+                             -1.453152027f, 1.061405429f}));
+  // exp is left to the other patterns so that targets with a native exp keep
+  // using it.
+  Value expNegX2 = b.create<math::ExpOp>(b.create<arith::NegFOp>(x2));
+  Value large = b.create<arith::SubFOp>(f32Cst(b, type, 1.0f),
+                                        b.create<arith::MulFOp>(q, expNegX2));
+  large = negateIf(
+      b, cmpf(b, arith::CmpFPredicate::OLT, x, f32Cst(b, type, 0.0f)), large);
+  return b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::OLT, abs, f32Cst(b, type, 0.75f)), small,
+      large);
+}
+
+/// rsqrt(x) is estimated from the bit pattern of x and refined with three
+/// Newton iterations. Denormal inputs are scaled into the normal range first.
+static Value approximateRsqrt(ImplicitLocOpBuilder &b, Value x) {
+  Type type = x.getType();
+  Type i32Type = getShapedLike(type, b.getI32Type());
+  Value isDenormal = cmpf(b, arith::CmpFPredicate::OLT, x,
+                          f32Cst(b, type, 1.17549435e-38f));
+  Value normal = b.create<arith::SelectOp>(
+      isDenormal, b.create<arith::MulFOp>(x, f32Cst(b, type, 16777216.0f)),
+      x);
+
+  Value bits = b.create<arith::BitcastOp>(i32Type, normal);
+  Value estimate = b.create<arith::BitcastOp>(
+      type, b.create<arith::SubIOp>(
+                i32Cst(b, type, 0x5f3759df),
+                b.create<arith::ShRUIOp>(bits, i32Cst(b, type, 1))));
+  Value halfX = b.create<arith::MulFOp>(normal, f32Cst(b, type, 0.5f));
+  for (int i = 0; i < 3; ++i) {
+    Value correction = b.create<arith::SubFOp>(
+        f32Cst(b, type, 1.5f),
+        b.create<arith::MulFOp>(
+            halfX, b.create<arith::MulFOp>(estimate, estimate)));
+    estimate = b.create<arith::MulFOp>(estimate, correction);
+  }
+  Value result = b.create<arith::SelectOp>(
+      isDenormal,
+      b.create<arith::MulFOp>(estimate, f32Cst(b, type, 4096.0f)), estimate);
+
+  Value inf = f32Cst(b, type, std::numeric_limits<float>::infinity());
+  Value zero = f32Cst(b, type, 0.0f);
+  result = b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::OEQ, x, inf), zero, result);
+  result = b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::OEQ, x, zero), inf, result);
+  return b.create<arith::SelectOp>(
+      cmpf(b, arith::CmpFPredicate::ULT, x, zero),
+      f32Cst(b, type, std::numeric_limits<float>::quiet_NaN()), result);
+}
+
+namespace {
+
+/// Rewrites f32 scalar and vector `OpTy` ops with `approximate`. These
+/// patterns have a higher benefit than the upstream approximations of the
+/// same ops.
+template <typename OpTy, Value (*approximate)(ImplicitLocOpBuilder &, Value)>
+struct FastMathApproximation : public OpRewritePattern<OpTy> {
+  explicit FastMathApproximation(MLIRContext *context)
+      : OpRewritePattern<OpTy>(context, /*benefit=*/2) {}
+
+  LogicalResult matchAndRewrite(OpTy op,
+                                PatternRewriter &rewriter) const override {
+    Type type = op.getType();
+    if (!type.isa<FloatType, VectorType>() ||
+        !getElementTypeOrSelf(type).isF32()) {
+      return rewriter.notifyMatchFailure(op, "expected f32 scalar or vector");
+    }
+    ImplicitLocOpBuilder b(op.getLoc(), rewriter);
+    rewriter.replaceOp(op, approximate(b, op->getOperand(0)));
+    return success();
+  }
+};
+
+}  // namespace
+
+void populateFastMathApproximationPatterns(RewritePatternSet &patterns,
+                                           bool nativeMath) {
+  MLIRContext *context = patterns.getContext();
+  patterns.add<FastMathApproximation<math::ErfOp, approximateErf>>(context);
+  if (nativeMath) return;
+  patterns.add<FastMathApproximation<math::ExpOp, approximateExp>,
+               FastMathApproximation<math::LogOp, approximateLog>,
+               FastMathApproximation<math::TanhOp, approximateTanh>,
+               FastMathApproximation<math::RsqrtOp, approximateRsqrt>>(
+      context);
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -26,8 +26,18 @@ namespace {
 /// math dialect elementry functions -> polynomial form.
 class PolynomialApproximationPass
     : public PolynomialApproximationPassBase<PolynomialApproximationPass> {
+ public:
+  PolynomialApproximationPass(bool fastMath) { this->fastMath = fastMath; }
+  PolynomialApproximationPass(const PolynomialApproximationPass &pass) {
+    fastMath = pass.fastMath;
+  }
+
   void runOnOperation() override {
     RewritePatternSet mathPatterns(&getContext());
+    if (fastMath) {
+      populateFastMathApproximationPatterns(mathPatterns,
+                                            clNativeMathPrecision);
+    }
     if (clNativeMathPrecision) {
       mathPatterns.add<math::ErfPolynomialApproximation>(&getContext());
     } else {
@@ -42,8 +52,9 @@ class PolynomialApproximationPass
 
 }  // namespace
 
-std::unique_ptr<OperationPass<>> createPolynomialApproximationPass() {
-  return std::make_unique<PolynomialApproximationPass>();
+std::unique_ptr<OperationPass<>> createPolynomialApproximationPass(
+    bool fastMath) {
+  return std::make_unique<PolynomialApproximationPass>(fastMath);
 }
 
 }  // namespace iree_compiler
@@ -0,0 +1,349 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/Common/TuningDatabase.h"
+
+#include <mutex>
+
+#include "iree/compiler/Codegen/Dialect/LoweringConfig.h"
+#include "iree/compiler/Codegen/Utils/Utils.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/IR/BuiltinAttributes.h"
+
+#define DEBUG_TYPE "iree-codegen-tuning-database"
+
+static llvm::cl::opt<std::string> clTuningDatabase(
+    "iree-codegen-tuning-database",
+    llvm::cl::desc("Path of a tuning database (JSON Lines) whose lowering "
+                   "configurations override the default heuristics for the "
+                   "dispatches they were recorded for"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> clTuningDatabaseRecord(
+    "iree-codegen-tuning-database-record",
+    llvm::cl::desc("Path of a file to which the lowering configuration "
+                   "selected for each dispatch is appended in tuning database "
+                   "format"),
+    llvm::cl::init(""));
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+// Lowering configuration of a single database entry.
+struct TuningEntry {
+  TileSizesListType tileSizes;
+  SmallVector<int64_t> nativeVectorSize;
+  IREE::Codegen::DispatchLoweringPassPipeline passPipeline;
+  SmallVector<int64_t> workloadPerWorkgroup;
+  SmallVector<int64_t> workgroupSize;
+  Optional<double> timeMs;
+};
+
+class TuningDatabase {
+ public:
+  // Returns the database selected with --iree-codegen-tuning-database. It is
+  // loaded once on first use and shared by all compilation threads.
+  static const TuningDatabase &getGlobal() {
+    static TuningDatabase database(clTuningDatabase);
+    return database;
+  }
+
+  // Returns a non-empty message if the database failed to load.
+  StringRef getLoadError() const { return loadError; }
+
+  const TuningEntry *lookup(StringRef target, StringRef key) const {
+    auto it = entries.find(getEntryName(target, key));
+    return it == entries.end() ? nullptr : &it->second;
+  }
+
+ private:
+  explicit TuningDatabase(StringRef path) : path(path.str()) { load(); }
+
+  static std::string getEntryName(StringRef target, StringRef key) {
+    return (target + "\n" + key).str();
+  }
+
+  void load();
+  LogicalResult parseEntry(const llvm::json::Object &object,
+                           std::string &errorMessage);
+
+  std::string path;
+  std::string loadError;
+  llvm::StringMap<TuningEntry> entries;
+};
+
+// Parses |value| into |values| if it is an array of integers. A missing
+// value is treated as an empty array.
+static LogicalResult parseIntegerArray(const llvm::json::Value *value,
+                                       SmallVectorImpl<int64_t> &values) {
+  if (!value) return success();
+  const llvm::json::Array *array = value->getAsArray();
+  if (!array) return failure();
+  for (const llvm::json::Value &element : *array) {
+    Optional<int64_t> integer = element.getAsInteger();
+    if (!integer) return failure();
+    values.push_back(*integer);
+  }
+  return success();
+}
+
+LogicalResult TuningDatabase::parseEntry(const llvm::json::Object &object,
+                                         std::string &errorMessage) {
+  Optional<StringRef> target = object.getString("target");
+  Optional<StringRef> key = object.getString("key");
+  Optional<StringRef> pipelineName = object.getString("pass_pipeline");
+  if (!target || !key || !pipelineName) {
+    errorMessage = "expected 'target', 'key' and 'pass_pipeline' strings";
+    return failure();
+  }
+
+  TuningEntry entry;
+  Optional<IREE::Codegen::DispatchLoweringPassPipeline> passPipeline =
+      IREE::Codegen::symbolizeDispatchLoweringPassPipeline(*pipelineName);
+  if (!passPipeline) {
+    errorMessage = ("unknown pass pipeline '" + *pipelineName + "'").str();
+    return failure();
+  }
+  entry.passPipeline = *passPipeline;
+
+  const llvm::json::Array *tileSizes = object.getArray("tile_sizes");
+  if (!tileSizes) {
+    errorMessage = "expected 'tile_sizes' to be a list of lists of integers";
+    return failure();
+  }
+  for (const llvm::json::Value &level : *tileSizes) {
+    if (failed(parseIntegerArray(&level, entry.tileSizes.emplace_back()))) {
+      errorMessage = "expected 'tile_sizes' to be a list of lists of integers";
+      return failure();
+    }
+  }
+  std::pair<StringRef, SmallVector<int64_t> *> integerArrays[] = {
+      {"native_vector_size", &entry.nativeVectorSize},
+      {"workload_per_wg", &entry.workloadPerWorkgroup},
+      {"workgroup_size", &entry.workgroupSize},
+  };
+  for (auto &integerArray : integerArrays) {
+    if (failed(parseIntegerArray(object.get(integerArray.first),
+                                 *integerArray.second))) {
+      errorMessage =
+          ("expected '" + integerArray.first + "' to be a list of integers")
+              .str();
+      return failure();
+    }
+  }
+  entry.timeMs = object.getNumber("time_ms");
+
+  // Keep the fastest entry; untimed entries replace earlier untimed ones.
+  std::string entryName = getEntryName(*target, *key);
+  auto it = entries.find(entryName);
+  if (it != entries.end() && it->second.timeMs &&
+      (!entry.timeMs || *entry.timeMs >= *it->second.timeMs)) {
+    return success();
+  }
+  entries[entryName] = std::move(entry);
+  return success();
+}
+
+void TuningDatabase::load() {
+  if (path.empty()) return;
+  auto fileOrErr = llvm::MemoryBuffer::getFile(path, /*IsText=*/true);
+  if (!fileOrErr) {
+    loadError = fileOrErr.getError().message();
+    return;
+  }
+  SmallVector<StringRef> lines;
+  (*fileOrErr)->getBuffer().split(lines, '\n');
+  for (auto line : llvm::enumerate(lines)) {
+    StringRef text = line.value().trim();
+    if (text.empty()) continue;
+    std::string lineError =
+        path + ":" + std::to_string(line.index() + 1) + ": ";
+    llvm::Expected<llvm::json::Value> value = llvm::json::parse(text);
+    if (!value) {
+      loadError = lineError + llvm::toString(value.takeError());
+      return;
+    }
+    const llvm::json::Object *object = value->getAsObject();
+    std::string errorMessage = "expected an object";
+    if (!object || failed(parseEntry(*object, errorMessage))) {
+      loadError = lineError + errorMessage;
+      return;
+    }
+  }
+  LLVM_DEBUG(llvm::dbgs() << "loaded " << entries.size()
+                          << " tuning database entries from " << path << "\n");
+}
+
+}  // namespace
+
+// Returns the printed executable target of |entryPointFn|.
+static std::string getTargetKey(FuncOp entryPointFn) {
+  auto variantOp =
+      entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  if (!variantOp) return "";
+  std::string target;
+  llvm::raw_string_ostream os(target);
+  variantOp.target().print(os);
+  return os.str();
+}
+
+// Prints |shape| with |elementType| in the form used by shaped types.
+static void printShape(ArrayRef<int64_t> shape, Type elementType,
+                       llvm::raw_ostream &os) {
+  for (int64_t dim : shape) {
+    if (ShapedType::isDynamic(dim)) {
+      os << "?x";
+    } else {
+      os << dim << "x";
+    }
+  }
+  os << elementType;
+}
+
+std::string getTuningDatabaseKey(Operation *rootOp,
+                                 ArrayRef<Operation *> computeOps) {
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  os << rootOp->getName();
+
+  // Attributes set by codegen itself would change the key after the fact.
+  SmallVector<NamedAttribute> attrs;
+  for (NamedAttribute attr : rootOp->getAttrs()) {
+    StringRef name = attr.getName().getValue();
+    if (name == "lowering.config" || name == "compilation.info" ||
+        name == "__internal_linalg_transform__") {
+      continue;
+    }
+    attrs.push_back(attr);
+  }
+  if (!attrs.empty()) {
+    os << DictionaryAttr::get(rootOp->getContext(), attrs);
+  }
+
+  // Operands are tiled at the flow level; use the shapes they were tiled from.
+  os << "(";
+  llvm::interleaveComma(rootOp->getOperands(), os, [&](Value operand) {
+    auto shapedType = operand.getType().dyn_cast<ShapedType>();
+    if (!shapedType || !shapedType.hasRank()) {
+      os << operand.getType();
+      return;
+    }
+    ArrayRef<int64_t> shape = getUntiledShape(operand);
+    if (static_cast<int64_t>(shape.size()) != shapedType.getRank()) {
+      shape = shapedType.getShape();
+    }
+    printShape(shape, shapedType.getElementType(), os);
+  });
+  os << ")";
+
+  if (auto linalgOp = dyn_cast<linalg::LinalgOp>(rootOp)) {
+    os << " {";
+    llvm::interleaveComma(linalgOp.getBlock()->getOperations(), os,
+                          [&](Operation &op) { os << op.getName(); });
+    os << "}";
+  }
+
+  os << " in (";
+  llvm::interleaveComma(computeOps, os,
+                        [&](Operation *op) { os << op->getName(); });
+  os << ")";
+  return os.str();
+}
+
+LogicalResult applyTuningDatabaseConfig(FuncOp entryPointFn,
+                                        ArrayRef<Operation *> computeOps) {
+  if (clTuningDatabase.empty()) return success();
+  const TuningDatabase &database = TuningDatabase::getGlobal();
+  if (!database.getLoadError().empty()) {
+    return entryPointFn.emitError("failed to load tuning database: ")
+           << database.getLoadError();
+  }
+
+  // Configurations from the input IR take precedence.
+  if (llvm::any_of(computeOps, [](Operation *op) {
+        return static_cast<bool>(getCompilationInfo(op));
+      })) {
+    return success();
+  }
+
+  std::string target = getTargetKey(entryPointFn);
+  for (Operation *op : computeOps) {
+    std::string key = getTuningDatabaseKey(op, computeOps);
+    const TuningEntry *entry = database.lookup(target, key);
+    if (!entry) continue;
+    LLVM_DEBUG(llvm::dbgs() << "using tuned configuration for " << key << "\n");
+    setCompilationInfo(
+        op, IREE::Codegen::CompilationInfoAttr::get(
+                entryPointFn.getContext(), entry->tileSizes,
+                entry->nativeVectorSize, entry->passPipeline,
+                entry->workloadPerWorkgroup, entry->workgroupSize));
+    return success();
+  }
+  return success();
+}
+
+LogicalResult recordTuningDatabaseConfig(FuncOp entryPointFn, Operation *rootOp,
+                                         ArrayRef<Operation *> computeOps) {
+  if (clTuningDatabaseRecord.empty() || !rootOp) return success();
+  IREE::Codegen::LoweringConfigAttr loweringConfig = getLoweringConfig(rootOp);
+  IREE::HAL::ExecutableEntryPointOp entryPointOp = getEntryPoint(entryPointFn);
+  if (!loweringConfig || !entryPointOp) return success();
+  IREE::Codegen::TranslationInfoAttr translationInfo =
+      getTranslationInfo(entryPointOp);
+  if (!translationInfo) return success();
+
+  auto toJSONArray = [](ArrayRef<int64_t> values) {
+    return llvm::json::Array(values);
+  };
+  llvm::json::Array tileSizes;
+  for (unsigned level = 0, e = loweringConfig.getTileSizes().size(); level < e;
+       ++level) {
+    tileSizes.push_back(toJSONArray(loweringConfig.getTileSizeVals(level)));
+  }
+  llvm::json::Object entry{
+      {"target", getTargetKey(entryPointFn)},
+      {"key", getTuningDatabaseKey(rootOp, computeOps)},
+      {"tile_sizes", std::move(tileSizes)},
+      {"native_vector_size",
+       toJSONArray(loweringConfig.getNativeVectorSizeVals())},
+      {"pass_pipeline", translationInfo.getPassPipeline().getValue()},
+      {"workload_per_wg",
+       toJSONArray(translationInfo.getWorkloadPerWorkgroupVals())},
+      {"workgroup_size", toJSONArray(getWorkgroupSize(entryPointOp))},
+  };
+  if (auto executableOp =
+          entryPointFn->getParentOfType<IREE::HAL::ExecutableOp>()) {
+    entry["dispatch"] = executableOp.sym_name();
+  }
+
+  // Executables may be translated concurrently.
+  static std::mutex recordMutex;
+  std::lock_guard<std::mutex> lock(recordMutex);
+  std::error_code error;
+  llvm::raw_fd_ostream os(clTuningDatabaseRecord, error,
+                          llvm::sys::fs::OF_Append | llvm::sys::fs::OF_Text);
+  if (error) {
+    return entryPointFn.emitError("failed to open tuning database record '")
+           << clTuningDatabaseRecord << "': " << error.message();
+  }
+  os << llvm::json::Value(std::move(entry)) << "\n";
+  return success();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
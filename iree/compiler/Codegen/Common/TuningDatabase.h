@@ -0,0 +1,68 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- TuningDatabase.h - Persisted lowering configurations ---------------===//
+//
+// A tuning database maps the root ops of dispatch regions on a particular
+// executable target to the lowering configuration that performed best for
+// them when benchmarked. The kernel configuration of each backend consults it
+// before falling back to its heuristics. The configurations picked by the
+// heuristics can also be recorded in the same format so that a tuning driver
+// (such as scripts/tune_lowering_configs.py) is able to derive candidates
+// from them.
+//
+// Databases are JSON Lines files with one entry per line:
+//
+//   {"target": "<printed #hal.executable.target>",
+//    "key": "<root op signature, see getTuningDatabaseKey>",
+//    "dispatch": "<hal.executable name, informational only>",
+//    "tile_sizes": [[...], ...], "native_vector_size": [...],
+//    "pass_pipeline": "<DispatchLoweringPassPipeline>",
+//    "workload_per_wg": [...], "workgroup_size": [...],
+//    "time_ms": <benchmarked time, optional>}
+//
+// When several entries share a target and key the fastest one is used, or the
+// last one if none of them are timed, so databases can be merged by
+// concatenating them.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef IREE_COMPILER_CODEGEN_COMMON_TUNINGDATABASE_H_
+#define IREE_COMPILER_CODEGEN_COMMON_TUNINGDATABASE_H_
+
+#include <string>
+
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Support/LogicalResult.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Returns the key under which the configuration of |rootOp| is stored. It is
+/// made of the op name, its attributes, the untiled shapes of its operands and
+/// the names of its payload ops, followed by the names of all the
+/// |computeOps| of the dispatch region.
+std::string getTuningDatabaseKey(Operation *rootOp,
+                                 ArrayRef<Operation *> computeOps);
+
+/// Sets the `compilation.info` found in the database selected with
+/// `--iree-codegen-tuning-database` on the op among |computeOps| it was
+/// recorded for. Does nothing if no database is selected, if there is no
+/// matching entry or if any op already has a `compilation.info` set.
+LogicalResult applyTuningDatabaseConfig(FuncOp entryPointFn,
+                                        ArrayRef<Operation *> computeOps);
+
+/// Appends the configuration selected for the |rootOp| of |entryPointFn| to
+/// the file selected with `--iree-codegen-tuning-database-record`. Does
+/// nothing if no file is selected or if no configuration was selected.
+LogicalResult recordTuningDatabaseConfig(FuncOp entryPointFn, Operation *rootOp,
+                                         ArrayRef<Operation *> computeOps);
+
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_CODEGEN_COMMON_TUNINGDATABASE_H_
@@ -0,0 +1,120 @@
+// RUN: iree-opt -split-input-file -iree-codegen-polynomial-approximation='fast-math=true' %s | FileCheck %s
+// RUN: iree-opt -split-input-file -iree-codegen-polynomial-approximation='fast-math=true' -iree-codegen-gpu-native-math-precision %s | FileCheck %s --check-prefix=NATIVE
+
+// Maximum errors of the fast approximations, in ulps of the correctly rounded
+// f32 result, measured with correctly rounded f32 arithmetic (no FMA):
+//
+//   exp    6 ulps  on [-87.34, 88.72]; 0 below, +inf above.
+//   log    5 ulps  on (0, +inf), denormals included.
+//   tanh   3 ulps  everywhere.
+//   erf    4 ulps  everywhere, when using the fast exp.
+//   rsqrt  3 ulps  on (0, +inf), denormals included.
+//
+// Sigmoid is expressed with exp by the frontends and inherits its bound.
+
+// CHECK-LABEL: func @exp_f32
+//  CHECK-SAME:   %[[X:.+]]: f32
+//   CHECK-NOT:   math.exp
+//       CHECK:   %[[MAX:.+]] = arith.maxf %[[X]], %[[LOWER:.+]] : f32
+//       CHECK:   arith.minf %[[MAX]], %[[UPPER:.+]] : f32
+//       CHECK:   math.floor
+//       CHECK:   arith.fptosi
+//       CHECK:   arith.shli
+//       CHECK:   arith.bitcast
+//       CHECK:   arith.cmpf olt, %[[X]], %[[LOWER]]
+//       CHECK:   arith.cmpf ogt, %[[X]], %[[UPPER]]
+//       CHECK:   arith.cmpf uno, %[[X]], %[[X]]
+//   CHECK-NOT:   math.exp
+//       CHECK:   return
+// NATIVE-LABEL: func @exp_f32
+//       NATIVE:   math.exp
+func @exp_f32(%x: f32) -> f32 {
+  %0 = math.exp %x : f32
+  return %0 : f32
+}
+
+// -----
+
+// CHECK-LABEL: func @log_vector
+//   CHECK-DAG:   arith.constant dense<8388607> : vector<4xi32>
+//   CHECK-DAG:   arith.constant dense<1065353216> : vector<4xi32>
+//       CHECK:   arith.bitcast %{{.+}} : vector<4xf32> to vector<4xi32>
+//       CHECK:   arith.sitofp %{{.+}} : vector<4xi32> to vector<4xf32>
+//   CHECK-NOT:   math.log
+//       CHECK:   return
+// NATIVE-LABEL: func @log_vector
+//       NATIVE:   math.log
+func @log_vector(%x: vector<4xf32>) -> vector<4xf32> {
+  %0 = math.log %x : vector<4xf32>
+  return %0 : vector<4xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @tanh_vector
+//   CHECK-NOT:   math.{{exp|tanh}}
+//       CHECK:   math.abs
+//   CHECK-NOT:   math.{{exp|tanh}}
+//       CHECK:   arith.divf
+//   CHECK-NOT:   math.{{exp|tanh}}
+//       CHECK:   return
+// NATIVE-LABEL: func @tanh_vector
+//       NATIVE:   math.tanh
+func @tanh_vector(%x: vector<8xf32>) -> vector<8xf32> {
+  %0 = math.tanh %x : vector<8xf32>
+  return %0 : vector<8xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @erf_f32
+//   CHECK-NOT:   math.{{erf|exp}}
+//       CHECK:   math.abs
+//   CHECK-NOT:   math.{{erf|exp}}
+//       CHECK:   arith.divf
+//   CHECK-NOT:   math.{{erf|exp}}
+//       CHECK:   return
+// NATIVE-LABEL: func @erf_f32
+//   NATIVE-NOT:   math.erf
+//       NATIVE:   arith.divf
+//   NATIVE-NOT:   math.erf
+//       NATIVE:   math.exp
+//   NATIVE-NOT:   math.erf
+//       NATIVE:   return
+func @erf_f32(%x: f32) -> f32 {
+  %0 = math.erf %x : f32
+  return %0 : f32
+}
+
+// -----
+
+// CHECK-LABEL: func @rsqrt_f32
+//   CHECK-DAG:   arith.constant 1597463007 : i32
+//       CHECK:   arith.shrui
+//       CHECK:   arith.subi
+//   CHECK-NOT:   math.rsqrt
+//       CHECK:   return
+// NATIVE-LABEL: func @rsqrt_f32
+//       NATIVE:   math.rsqrt
+func @rsqrt_f32(%x: f32) -> f32 {
+  %0 = math.rsqrt %x : f32
+  return %0 : f32
+}
+
+// -----
+
+// CHECK-LABEL: func @sigmoid_vector
+//   CHECK-NOT:   math.exp
+//       CHECK:   math.floor
+//   CHECK-NOT:   math.exp
+//       CHECK:   arith.divf
+//   CHECK-NOT:   math.exp
+//       CHECK:   return
+func @sigmoid_vector(%x: vector<4xf32>) -> vector<4xf32> {
+  %one = arith.constant dense<1.0> : vector<4xf32>
+  %neg = arith.negf %x : vector<4xf32>
+  %exp = math.exp %neg : vector<4xf32>
+  %den = arith.addf %one, %exp : vector<4xf32>
+  %0 = arith.divf %one, %den : vector<4xf32>
+  return %0 : vector<4xf32>
+}
@@ -317,8 +317,12 @@ class HALDispatchABI {
   // Equivalent to:
   //   iree_hal_executable_import_v0_t func_ptr = state->imports[ordinal];
   Value loadImportFuncPtr(Location loc, int64_t ordinal, OpBuilder &builder) {
+    return loadImportFuncPtr(loc, getIndexValue(loc, ordinal, builder),
+                             builder);
+  }
+  Value loadImportFuncPtr(Location loc, Value ordinalValue,
+                          OpBuilder &builder) {
     auto importsPtrValue = loadFieldValue(loc, Field::imports, builder);
-    auto ordinalValue = getIndexValue(loc, ordinal, builder);
     auto elementPtrValue = builder.createOrFold<LLVM::GEPOp>(
         loc, importsPtrValue.getType(), importsPtrValue, ordinalValue);
     return builder.createOrFold<LLVM::LoadOp>(loc, elementPtrValue);
@@ -343,8 +347,13 @@ class HALDispatchABI {
   // Returns 0 on success and non-zero otherwise.
   Value callImport(Location loc, unsigned importOrdinal, Value params,
                    OpBuilder &builder) {
+    return callImport(loc, getIndexValue(loc, importOrdinal, builder), params,
+                      builder);
+  }
+  Value callImport(Location loc, Value importOrdinalValue, Value params,
+                   OpBuilder &builder) {
     auto thunkPtrValue = loadFieldValue(loc, Field::import_thunk, builder);
-    auto importPtrValue = loadImportFuncPtr(loc, importOrdinal, builder);
+    auto importPtrValue = loadImportFuncPtr(loc, importOrdinalValue, builder);
     auto callOp =
         builder.create<LLVM::CallOp>(loc, TypeRange{builder.getI32Type()},
                                      ValueRange{
@@ -613,6 +622,127 @@ class ConvertHALInterfaceBindingSubspanOp : public ConvertToLLVMPattern {
   }
 };
 
+/// Rewrites calls to functions declared with the `hal.import` attribute into
+/// calls through the executable import table. The runtime provides the
+/// implementation of each import (see `iree/hal/local/executable_imports.h`).
+///
+/// Source:
+///
+/// ```
+/// func private @iree_hal_memcpy_v0(memref<?xi8>, memref<?xi8>, index)
+///     attributes {hal.import}
+/// call @iree_hal_memcpy_v0(%dst, %src, %length) : (...) -> ()
+/// ```
+///
+/// Operands are packed in order into a stack-allocated parameter struct:
+/// memrefs as a pointer to their first element and scalars as-is. The ordinal
+/// of the import in the library import table is only known once all
+/// executables have been linked and is loaded from a placeholder global
+/// tagged with `hal.import.name` that serialization resolves.
+/// If the declaration returns an i32 the call produces the import status.
+class ConvertHALImportCallOp : public ConvertToLLVMPattern {
+ public:
+  explicit ConvertHALImportCallOp(MLIRContext *context,
+                                  LLVMTypeConverter &converter)
+      : ConvertToLLVMPattern(mlir::CallOp::getOperationName(), context,
+                             converter, 100) {}
+
+  LogicalResult matchAndRewrite(
+      Operation *op, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto callOp = cast<mlir::CallOp>(op);
+    auto llvmFuncOp = op->getParentOfType<LLVM::LLVMFuncOp>();
+    if (!llvmFuncOp) return failure();
+    auto calleeOp = SymbolTable::lookupNearestSymbolFrom<FuncOp>(
+        op, callOp.getCalleeAttr());
+    if (!calleeOp || !calleeOp->hasAttr("hal.import")) return failure();
+    auto resultTypes = callOp.getResultTypes();
+    if (resultTypes.size() > 1 ||
+        (resultTypes.size() == 1 && !resultTypes[0].isInteger(32))) {
+      return rewriter.notifyMatchFailure(
+          op, "imports may only return an i32 status");
+    }
+    HALDispatchABI abi(llvmFuncOp, getTypeConverter());
+    Location loc = op->getLoc();
+
+    // Pack the operands into the parameter struct.
+    SmallVector<Value> fieldValues;
+    SmallVector<Type> fieldTypes;
+    for (auto it : llvm::zip(callOp.getOperands(), operands)) {
+      Value value = std::get<1>(it);
+      if (std::get<0>(it).getType().isa<MemRefType>()) {
+        MemRefDescriptor desc(value);
+        value = rewriter.create<LLVM::GEPOp>(
+            loc, desc.getElementPtrType(), desc.alignedPtr(rewriter, loc),
+            desc.offset(rewriter, loc));
+      } else if (!LLVM::isCompatibleType(value.getType()) ||
+                 value.getType().isa<LLVM::LLVMStructType>()) {
+        return rewriter.notifyMatchFailure(
+            op, "unsupported import operand type");
+      }
+      fieldValues.push_back(value);
+      fieldTypes.push_back(value.getType());
+    }
+    auto paramsType =
+        LLVM::LLVMStructType::getLiteral(rewriter.getContext(), fieldTypes);
+    Value paramsValue = rewriter.create<LLVM::UndefOp>(loc, paramsType);
+    for (auto field : llvm::enumerate(fieldValues)) {
+      paramsValue = rewriter.create<LLVM::InsertValueOp>(
+          loc, paramsType, paramsValue, field.value(),
+          rewriter.getI64ArrayAttr(field.index()));
+    }
+
+    // Allocate the parameter storage once in the entry block so that calls
+    // within loops do not grow the stack.
+    Value paramsPtrValue;
+    {
+      OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(&llvmFuncOp.front());
+      Value oneValue = rewriter.create<LLVM::ConstantOp>(
+          loc, rewriter.getI32Type(), rewriter.getI32IntegerAttr(1));
+      paramsPtrValue = rewriter.create<LLVM::AllocaOp>(
+          loc, LLVM::LLVMPointerType::get(paramsType), oneValue,
+          /*alignment=*/0);
+    }
+    rewriter.create<LLVM::StoreOp>(loc, paramsValue, paramsPtrValue);
+    Value opaqueParamsValue = rewriter.create<LLVM::BitcastOp>(
+        loc, LLVM::LLVMPointerType::get(rewriter.getI8Type()),
+        paramsPtrValue);
+
+    auto ordinalGlobalOp =
+        getOrCreateOrdinalGlobal(calleeOp.getName(), llvmFuncOp, rewriter);
+    Value ordinalValue = rewriter.create<LLVM::LoadOp>(
+        loc, rewriter.create<LLVM::AddressOfOp>(loc, ordinalGlobalOp));
+    Value statusValue =
+        abi.callImport(loc, ordinalValue, opaqueParamsValue, rewriter);
+    if (resultTypes.empty()) {
+      rewriter.eraseOp(op);
+    } else {
+      rewriter.replaceOp(op, statusValue);
+    }
+    return success();
+  }
+
+ private:
+  // Returns the placeholder global holding the ordinal of import |name|.
+  static LLVM::GlobalOp getOrCreateOrdinalGlobal(
+      StringRef name, LLVM::LLVMFuncOp llvmFuncOp,
+      ConversionPatternRewriter &rewriter) {
+    auto moduleOp = llvmFuncOp->getParentOfType<ModuleOp>();
+    std::string globalName = ("__import_ordinal_" + name).str();
+    if (auto globalOp = moduleOp.lookupSymbol<LLVM::GlobalOp>(globalName)) {
+      return globalOp;
+    }
+    OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPointToStart(moduleOp.getBody());
+    auto globalOp = rewriter.create<LLVM::GlobalOp>(
+        llvmFuncOp.getLoc(), rewriter.getI32Type(), /*isConstant=*/true,
+        LLVM::Linkage::Private, globalName, rewriter.getI32IntegerAttr(0));
+    globalOp->setAttr("hal.import.name", rewriter.getStringAttr(name));
+    return globalOp;
+  }
+};
+
 class ConvertToLLVMPass : public ConvertToLLVMBase<ConvertToLLVMPass> {
  public:
   ConvertToLLVMPass() = default;
@@ -732,7 +862,8 @@ void ConvertToLLVMPass::runOnOperation() {
     ConvertHALInterfaceWorkgroupSizeOp,
     ConvertHALInterfaceWorkgroupCountOp,
     ConvertHALInterfaceLoadConstant,
-    ConvertHALInterfaceBindingSubspanOp
+    ConvertHALInterfaceBindingSubspanOp,
+    ConvertHALImportCallOp
   >(&getContext(), converter);
   // clang-format on
 
@@ -764,6 +895,13 @@ void ConvertToLLVMPass::runOnOperation() {
     return;
   }
 
+  // Import declarations have been replaced by calls through the import table.
+  for (auto funcOp : llvm::make_early_inc_range(module.getOps<FuncOp>())) {
+    if (funcOp->hasAttr("hal.import") && funcOp.symbolKnownUseEmpty(module)) {
+      funcOp.erase();
+    }
+  }
+
   // Post conversion patterns.
   {
     RewritePatternSet postPatterns(&getContext());
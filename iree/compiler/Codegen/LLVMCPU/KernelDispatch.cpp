@@ -7,6 +7,7 @@
 #include "iree/compiler/Codegen/LLVMCPU/KernelDispatch.h"
 
 #include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtOps.h"
+#include "iree/compiler/Codegen/Common/TuningDatabase.h"
 #include "iree/compiler/Codegen/Transforms/Transforms.h"
 #include "iree/compiler/Codegen/Utils/MarkerUtils.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
@@ -20,6 +21,7 @@
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/Dialect/Utils/StructuredOpsUtils.h"
 #include "mlir/IR/Matchers.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
@@ -64,6 +66,10 @@ static llvm::cl::opt<int> defaultWorkgroupTileSize(
 
 using IREE::Codegen::DispatchLoweringPassPipeline;
 
+/// Number of vectors accumulated in parallel by innermost reductions, to hide
+/// the latency of the accumulation.
+static constexpr int64_t kReductionUnrollFactor = 4;
+
 static bool isVMVX(FuncOp entryPointFn) {
   auto variantOp =
       entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
@@ -521,6 +527,94 @@ static LogicalResult setRootConfig(
       DispatchLoweringPassPipeline::CPUTileFuseAndVectorize);
 }
 
+/// Sets the lowering configuration for dispatch region with a
+/// linalg.conv_2d_nhwc_hwcf root op. Statically shaped convolutions without
+/// dilation are computed directly instead of through an img2col buffer that is
+/// KH * KW times larger than the input. Each L1 tile is a register block of a
+/// few output pixels along the width by a multiple of 4 output channels, which
+/// is accumulated over the filter window one filter pixel and up to 4 input
+/// channels at a time. With the HWCF layout the output channels of each filter
+/// row are contiguous, so the filter tiles are read as vectors without
+/// repacking. Other convolutions use the default configuration.
+static LogicalResult setRootConfig(
+    FuncOp entryPointFn, linalg::Conv2DNhwcHwcfOp convOp,
+    ArrayRef<LoopTilingAndDistributionInfo> tiledLoops) {
+  // Vector width of the output channels used by the convolution vectorization
+  // patterns.
+  const int64_t kConvVectorWidth = 4;
+  // Number of output pixels along the width in a register block.
+  const int64_t kConvRegisterBlockWidth = 4;
+
+  if (auto dilations = convOp.dilations()) {
+    if (llvm::any_of(dilations.getValues<int64_t>(),
+                     [](int64_t dilation) { return dilation != 1; })) {
+      return success();
+    }
+  }
+  auto isStatic = [](ArrayRef<int64_t> shape) {
+    return !shape.empty() && llvm::none_of(shape, ShapedType::isDynamic);
+  };
+  ArrayRef<int64_t> inputShape = getUntiledShape(convOp.image());
+  ArrayRef<int64_t> filterShape = getUntiledShape(convOp.filter());
+  SmallVector<int64_t> outputShape = getUntiledResultShape(convOp, 0);
+  if (!isStatic(inputShape) || !isStatic(filterShape) ||
+      !isStatic(outputShape)) {
+    return success();
+  }
+  int64_t kh = filterShape[0], kw = filterShape[1];
+  int64_t ic = filterShape[2], oc = filterShape[3];
+  if (oc % kConvVectorWidth != 0 ||
+      (ic > kConvVectorWidth && ic % kConvVectorWidth != 0)) {
+    return success();
+  }
+
+  // Loops are (n, oh, ow, oc, kh, kw, ic). Keep the workgroup tiles of the
+  // output channels a multiple of the vector width.
+  auto interfaceOp =
+      cast<IREE::Flow::PartitionableLoopsInterface>(convOp.getOperation());
+  unsigned numLoops = interfaceOp.getNumLoops();
+  SmallVector<unsigned> partitionedLoops =
+      interfaceOp.getPartitionableLoops(kNumMaxParallelDims);
+  SmallVector<int64_t> vectorSizeVals(numLoops, 1);
+  vectorSizeVals[3] = kConvVectorWidth;
+  SmallVector<int64_t> workloadPerWorkgroup = getDefaultWorkloadPerWorkgroup(
+      tiledLoops, partitionedLoops, vectorSizeVals);
+  SmallVector<int64_t> flowTileSizes =
+      getDistributedTileSizes(interfaceOp, workloadPerWorkgroup);
+  auto getFlowTileSize = [&](unsigned dim) {
+    return flowTileSizes[dim] ? flowTileSizes[dim] : outputShape[dim];
+  };
+
+  // The reduction loops are only tiled if each tiled one takes several steps,
+  // so unit filter dimensions and input channels that fit in a single vector
+  // are left untiled.
+  int64_t vectorSize = getVectorSize(
+      entryPointFn,
+      convOp.getOutputOperand(0)->get().getType().cast<ShapedType>());
+  SmallVector<int64_t> l1TileSizes = {
+      1,
+      1,
+      getMaxTileSize(0, getFlowTileSize(2), kConvRegisterBlockWidth, 1),
+      getMaxTileSize(0, getFlowTileSize(3),
+                     std::max<int64_t>(2 * vectorSize, kConvVectorWidth),
+                     kConvVectorWidth),
+      kh == 1 ? 0 : 1,
+      kw == 1 ? 0 : 1,
+      ic <= kConvVectorWidth ? 0 : kConvVectorWidth};
+  // The convolution vectorization patterns produce vectors of the native
+  // width directly; use vector tile sizes that leave them unrolled as is.
+  SmallVector<int64_t> vectorTileSizes = l1TileSizes;
+
+  TileSizesListType tileSizes;
+  tileSizes.push_back(flowTileSizes);
+  tileSizes.push_back(l1TileSizes);
+  tileSizes.push_back(vectorTileSizes);
+  return setOpConfigAndEntryPointFnTranslation(
+      entryPointFn, convOp, tileSizes,
+      /*nativeVectorSizes=*/ArrayRef<int64_t>{},
+      DispatchLoweringPassPipeline::CPUTileFuseAndVectorize);
+}
+
 /// Sets the lowering configuration for dispatch region for linalg_ext.fft
 /// root op.
 static LogicalResult setRootConfig(
@@ -560,6 +654,20 @@ static LogicalResult setRootConfig(
       DispatchLoweringPassPipeline::CPUDefault);
 }
 
+/// Sets the lowering configuration for dispatch region for linalg_ext.attention
+/// root op. Each workgroup computes a block of query rows of a single batch so
+/// that the keys and values it streams through stay in cache.
+static LogicalResult setRootConfig(
+    FuncOp entryPointFn, IREE::LinalgExt::AttentionOp attentionOp,
+    ArrayRef<LoopTilingAndDistributionInfo> tiledLoops) {
+  SmallVector<int64_t> workgroupTileSizes = {1, defaultWorkgroupTileSize};
+  TileSizesListType tileSizes = {workgroupTileSizes};
+  return setOpConfigAndEntryPointFnTranslation(
+      entryPointFn, attentionOp, tileSizes,
+      /*nativeVectorSizes=*/ArrayRef<int64_t>{},
+      DispatchLoweringPassPipeline::CPUDefault);
+}
+
 /// Sets the lowering configuration for a generic op to use DoubleTilingExpert.
 static LogicalResult setRootConfig(
     FuncOp entryPointFn, linalg::GenericOp genericOp,
@@ -621,6 +729,22 @@ static LogicalResult setRootConfig(
     for (auto d : parallelDims) vectorTileSizes[d] = 0;
   }
 
+  // Innermost reductions are accumulated into vectors of the vector tile size
+  // before being reduced (see LLVMCPUSplitReduction), so use several vectors
+  // when they evenly divide the reduction.
+  if (genericOp.getNumReductionLoops() == 1 &&
+      isReductionIterator(genericOp.iterator_types().getValue().back())) {
+    int64_t reductionSize = genericOp.getStaticLoopRanges().back();
+    int64_t vectorSize = nativeVectorSize.back();
+    if (!ShapedType::isDynamic(reductionSize) && vectorSize > 1) {
+      int64_t tileSize = getMaxTileSize(
+          0, reductionSize, kReductionUnrollFactor * vectorSize, vectorSize);
+      if (tileSize != 0 && reductionSize % tileSize == 0) {
+        vectorTileSizes.back() = tileSize;
+      }
+    }
+  }
+
   TileSizesListType tileSizes;
   tileSizes.push_back({});  // Empty since nothing to do for first level tiling.
   tileSizes.push_back(l1TileSizes);
@@ -642,9 +766,11 @@ static LogicalResult setRootConfigImpl(
   auto setRootConfigFn = [&](Operation *op) -> LogicalResult {
     return TypeSwitch<Operation *, LogicalResult>(op)
         .Case<linalg::Mmt4DOp, linalg::ContractionOpInterface,
-              IREE::LinalgExt::FftOp>([&](auto op) {
-          return setRootConfig(entryPointFn, op, tiledLoops);
-        })
+              linalg::Conv2DNhwcHwcfOp, IREE::LinalgExt::AttentionOp,
+              IREE::LinalgExt::FftOp>(
+            [&](auto op) {
+              return setRootConfig(entryPointFn, op, tiledLoops);
+            })
         .Case<linalg::GenericOp>([&](auto genericOp) {
           if (genericOp.getNumLoops() == genericOp.getNumParallelLoops()) {
             // Ignore parallel elementwise operations now. They will be set as
@@ -760,10 +886,21 @@ LogicalResult initCPULaunchConfig(ModuleOp moduleOp) {
       return failure();
     }
 
+    if (failed(applyTuningDatabaseConfig(funcOp, computeOps))) {
+      return failure();
+    }
     if (failed(
             setTranslationInfoAndRootConfig(funcOp, computeOps, tiledLoops))) {
       return failure();
     }
+
+    auto rootOp = llvm::find_if(computeOps, [](Operation *op) {
+      return static_cast<bool>(getLoweringConfig(op));
+    });
+    if (rootOp != computeOps.end() &&
+        failed(recordTuningDatabaseConfig(funcOp, *rootOp, computeOps))) {
+      return failure();
+    }
   }
   return success();
 }
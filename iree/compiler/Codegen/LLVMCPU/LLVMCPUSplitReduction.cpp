@@ -0,0 +1,246 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- LLVMCPUSplitReduction.cpp ------------------------------------------===//
+//
+// Tiling an innermost reduction to the vector tile size and vectorizing the
+// tiles results in a horizontal reduction of a vector at every iteration of
+// the reduction loop. This pass instead splits such reductions into a loop
+// that accumulates vector-wide partial results elementwise, followed by a
+// single reduction of the partial results:
+//
+//   out[i] = combine(f(in[i, k]), out[i])             k in [0, K)
+//
+// becomes
+//
+//   acc[i, j] = identity
+//   acc[i, j] = combine(f(in[i, k + j]), acc[i, j])   k in [0, K) step T
+//   out[i] = combine(acc[i, j], out[i])               j in [0, T)
+//
+// where T is the vector tile size of the reduction. Floating point
+// reductions are reassociated.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Codegen/Dialect/LoweringConfig.h"
+#include "iree/compiler/Codegen/LLVMCPU/KernelDispatch.h"
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Utils/StructuredOpsUtils.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-llvmcpu-split-reduction"
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Returns the op combining the payload result with the output of `op` if
+/// `op` is a single result reduction of the form `out = combine(f(...), out)`.
+static Operation *getReductionCombiner(linalg::GenericOp op) {
+  if (op.getNumOutputs() != 1) return nullptr;
+  Block *body = op.getBlock();
+  Operation *combiner = body->getTerminator()->getOperand(0).getDefiningOp();
+  if (!combiner || combiner->getBlock() != body ||
+      combiner->getNumOperands() != 2 || combiner->getNumResults() != 1) {
+    return nullptr;
+  }
+  BlockArgument outputArg = body->getArguments().back();
+  if (!outputArg.hasOneUse() || *outputArg.user_begin() != combiner) {
+    return nullptr;
+  }
+  return combiner;
+}
+
+/// Returns the identity of the reduction performed by `combiner` on values of
+/// `type`, or a null attribute if the reduction is not supported.
+static Attribute getReductionIdentity(Operation *combiner, Type type) {
+  if (auto floatType = type.dyn_cast<FloatType>()) {
+    const llvm::fltSemantics &semantics = floatType.getFloatSemantics();
+    return TypeSwitch<Operation *, Attribute>(combiner)
+        .Case<arith::AddFOp>([&](auto) { return FloatAttr::get(type, 0.0); })
+        .Case<arith::MulFOp>([&](auto) { return FloatAttr::get(type, 1.0); })
+        .Case<arith::MaxFOp>([&](auto) {
+          return FloatAttr::get(type,
+                                APFloat::getInf(semantics, /*Negative=*/true));
+        })
+        .Case<arith::MinFOp>([&](auto) {
+          return FloatAttr::get(type, APFloat::getInf(semantics));
+        })
+        .Default([](Operation *) { return Attribute(); });
+  }
+  if (auto intType = type.dyn_cast<IntegerType>()) {
+    unsigned bitWidth = intType.getWidth();
+    return TypeSwitch<Operation *, Attribute>(combiner)
+        .Case<arith::AddIOp, arith::OrIOp, arith::XOrIOp, arith::MaxUIOp>(
+            [&](auto) { return IntegerAttr::get(type, 0); })
+        .Case<arith::MulIOp>([&](auto) { return IntegerAttr::get(type, 1); })
+        .Case<arith::AndIOp, arith::MinUIOp>([&](auto) {
+          return IntegerAttr::get(type, APInt::getAllOnes(bitWidth));
+        })
+        .Case<arith::MaxSIOp>([&](auto) {
+          return IntegerAttr::get(type, APInt::getSignedMinValue(bitWidth));
+        })
+        .Case<arith::MinSIOp>([&](auto) {
+          return IntegerAttr::get(type, APInt::getSignedMaxValue(bitWidth));
+        })
+        .Default([](Operation *) { return Attribute(); });
+  }
+  return Attribute();
+}
+
+/// Returns the slice [offset, offset + tileSize) of `source` along the
+/// dimension accessed by `dim` in `map`, or `source` if `dim` is not accessed.
+static Value getReductionTile(OpBuilder &builder, Location loc, Value source,
+                              AffineMap map, unsigned dim, Value offset,
+                              int64_t tileSize) {
+  auto sourceType = source.getType().dyn_cast<RankedTensorType>();
+  if (!sourceType) return source;
+  SmallVector<OpFoldResult> offsets, sizes, strides;
+  bool accessesDim = false;
+  for (auto expr : llvm::enumerate(map.getResults())) {
+    if (expr.value().cast<AffineDimExpr>().getPosition() == dim) {
+      offsets.push_back(offset);
+      sizes.push_back(builder.getIndexAttr(tileSize));
+      accessesDim = true;
+    } else {
+      offsets.push_back(builder.getIndexAttr(0));
+      sizes.push_back(
+          builder.getIndexAttr(sourceType.getDimSize(expr.index())));
+    }
+    strides.push_back(builder.getIndexAttr(1));
+  }
+  if (!accessesDim) return source;
+  return builder.create<tensor::ExtractSliceOp>(loc, source, offsets, sizes,
+                                                strides);
+}
+
+/// Splits `op` as described at the top of the file if its innermost loop is
+/// its only reduction loop and the vector tile size of that loop evenly
+/// divides it.
+static LogicalResult splitReduction(linalg::GenericOp op) {
+  unsigned numLoops = op.getNumLoops();
+  if (!op.hasTensorSemantics() || op.hasDynamicShape() ||
+      op.hasIndexSemantics() || op.getNumReductionLoops() != 1 ||
+      !isReductionIterator(op.iterator_types().getValue().back())) {
+    return failure();
+  }
+  SmallVector<int64_t> vectorTileSizes =
+      getTileSizes(op, static_cast<unsigned>(TilingLevel::VectorTiles));
+  if (vectorTileSizes.size() != numLoops) return failure();
+  int64_t tileSize = vectorTileSizes.back();
+  int64_t reductionSize = op.getStaticLoopRanges().back();
+  if (tileSize <= 1 || reductionSize <= tileSize ||
+      reductionSize % tileSize != 0) {
+    return failure();
+  }
+  if (!llvm::all_of(op.getIndexingMaps(), [](AffineMap map) {
+        return map.isProjectedPermutation();
+      })) {
+    return failure();
+  }
+  Operation *combiner = getReductionCombiner(op);
+  if (!combiner) return failure();
+  OpOperand *output = op.getOutputOperand(0);
+  auto outputType = output->get().getType().cast<RankedTensorType>();
+  Attribute identity =
+      getReductionIdentity(combiner, outputType.getElementType());
+  if (!identity) return failure();
+
+  OpBuilder builder(op);
+  Location loc = op.getLoc();
+  unsigned reductionDim = numLoops - 1;
+  AffineMap outputMap = op.getTiedIndexingMap(output);
+  SmallVector<AffineExpr> accExprs(outputMap.getResults().begin(),
+                                   outputMap.getResults().end());
+  accExprs.push_back(builder.getAffineDimExpr(reductionDim));
+  AffineMap accMap =
+      AffineMap::get(numLoops, /*symbolCount=*/0, accExprs, op.getContext());
+
+  Value identityValue = builder.create<arith::ConstantOp>(loc, identity);
+  Value lb = builder.create<arith::ConstantIndexOp>(loc, 0);
+  Value ub = builder.create<arith::ConstantIndexOp>(loc, reductionSize);
+  Value step = builder.create<arith::ConstantIndexOp>(loc, tileSize);
+  SmallVector<int64_t> accShape(outputType.getShape().begin(),
+                                outputType.getShape().end());
+  accShape.push_back(tileSize);
+  Value accInit = builder.create<linalg::InitTensorOp>(
+      loc, accShape, outputType.getElementType());
+  Value accFill =
+      builder.create<linalg::FillOp>(loc, identityValue, accInit).result();
+
+  // Accumulate tiles of the reduction elementwise. The payload is unchanged:
+  // it now combines its result with the accumulator.
+  SmallVector<AffineMap> partialMaps = op.getIndexingMaps();
+  partialMaps.back() = accMap;
+  SmallVector<StringRef> partialIterators(numLoops,
+                                          getParallelIteratorTypeName());
+  auto forOp = builder.create<scf::ForOp>(
+      loc, lb, ub, step, ValueRange{accFill},
+      [&](OpBuilder &b, Location loc, Value iv, ValueRange args) {
+        SmallVector<Value> inputs;
+        for (OpOperand *input : op.getInputOperands()) {
+          inputs.push_back(getReductionTile(b, loc, input->get(),
+                                            op.getTiedIndexingMap(input),
+                                            reductionDim, iv, tileSize));
+        }
+        auto partialOp = b.create<linalg::GenericOp>(
+            loc, args[0].getType(), inputs, args[0], partialMaps,
+            partialIterators);
+        BlockAndValueMapping mapping;
+        op.region().cloneInto(&partialOp.region(), mapping);
+        b.create<scf::YieldOp>(loc, partialOp.getResult(0));
+      });
+
+  // Reduce the partial results into the original output.
+  SmallVector<AffineMap> finalMaps = {accMap, outputMap};
+  SmallVector<StringRef> finalIterators = llvm::to_vector(
+      op.iterator_types().getAsValueRange<StringAttr>());
+  auto finalOp = builder.create<linalg::GenericOp>(
+      loc, outputType, forOp.getResult(0), output->get(), finalMaps,
+      finalIterators,
+      [&](OpBuilder &b, Location nestedLoc, ValueRange args) {
+        Operation *finalCombiner = b.clone(*combiner);
+        finalCombiner->setOperands(args);
+        b.create<linalg::YieldOp>(nestedLoc, finalCombiner->getResults());
+      });
+  op->replaceAllUsesWith(finalOp->getResults());
+  op.erase();
+  return success();
+}
+
+namespace {
+struct LLVMCPUSplitReductionPass
+    : public LLVMCPUSplitReductionBase<LLVMCPUSplitReductionPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, linalg::LinalgDialect,
+                    scf::SCFDialect, tensor::TensorDialect>();
+  }
+
+  void runOnOperation() override {
+    SmallVector<linalg::GenericOp> candidates;
+    getOperation().walk([&](linalg::GenericOp op) {
+      if (getLoweringConfig(op)) candidates.push_back(op);
+    });
+    for (linalg::GenericOp op : candidates) {
+      (void)splitReduction(op);
+    }
+  }
+};
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createLLVMCPUSplitReductionPass() {
+  return std::make_unique<LLVMCPUSplitReductionPass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
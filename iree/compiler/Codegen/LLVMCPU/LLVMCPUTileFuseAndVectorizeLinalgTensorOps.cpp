@@ -38,9 +38,15 @@ static llvm::cl::opt<bool> clMmt4dUseIntrinsics(
                    "Not for production use."),
     llvm::cl::init(false));
 
+/// Returns true if the reduction loops of `op` are tiled by this pass, i.e. if
+/// it is a contraction or a convolution computed directly.
+static bool hasTiledReductionLoops(Operation *op) {
+  return isa<linalg::ContractionOpInterface, linalg::Conv2DNhwcHwcfOp>(op);
+}
+
 namespace {
-// Could just be linalg::TilingPattern with a ContractionOpInterface filter, but
-// that is always templated on an op.
+// Could just be linalg::TilingPattern with a filter on the ops that have their
+// reduction loops tiled, but that is always templated on an op.
 struct TileWorkgroups : public linalg::LinalgTilingPattern {
   using Base = linalg::LinalgTilingPattern;
   TileWorkgroups(MLIRContext *context, linalg::LinalgTilingOptions options,
@@ -48,8 +54,7 @@ struct TileWorkgroups : public linalg::LinalgTilingPattern {
       : LinalgTilingPattern(context, options, marker) {}
   LogicalResult matchAndRewrite(linalg::LinalgOp linalgOp,
                                 PatternRewriter &rewriter) const override {
-    if (!isa<linalg::ContractionOpInterface>(linalgOp.getOperation()))
-      return failure();
+    if (!hasTiledReductionLoops(linalgOp)) return failure();
     return Base::returningMatchAndRewrite(linalgOp, rewriter);
   }
 };
@@ -78,6 +83,8 @@ LogicalResult applyTileAndFuseCanonicalizationPatterns(FuncOp funcOp) {
   auto context = funcOp.getContext();
   RewritePatternSet patterns(context);
   linalg::populateLinalgTilingCanonicalizationPatterns(patterns);
+  // Pad only the tiles of padded operands that the tiled ops read.
+  patterns.add<linalg::ExtractSliceOfPadTensorSwapPattern>(context);
   tensor::DimOp::getCanonicalizationPatterns(patterns, context);
   memref::DimOp::getCanonicalizationPatterns(patterns, context);
   memref::populateResolveRankedShapeTypeResultDimsPatterns(patterns);
@@ -171,12 +178,12 @@ void LLVMCPUTileFuseAndVectorizePass::runOnOperation() {
     // In this case, %c should be folded. Otherwise, it introduces memref.alloca
     // in bufferization.
     bool shouldTileReductionLoop = true;
-    funcOp.walk([&](linalg::ContractionOpInterface op) {
-      auto linalgOp = dyn_cast<linalg::LinalgOp>(op.getOperation());
+    funcOp.walk([&](linalg::LinalgOp linalgOp) {
+      if (!hasTiledReductionLoops(linalgOp)) return;
       auto loopRanges = linalgOp.getStaticLoopRanges();
       if (loopRanges) {
-        auto l1Tiles =
-            getTileSizes(op, static_cast<unsigned>(TilingLevel::L1Tiles));
+        auto l1Tiles = getTileSizes(
+            linalgOp, static_cast<unsigned>(TilingLevel::L1Tiles));
         for (int i = linalgOp.getNumParallelLoops(); i < l1Tiles.size(); ++i) {
           if (loopRanges.getValue()[i] != ShapedType::kDynamicSize &&
               l1Tiles[i] && loopRanges.getValue()[i] <= l1Tiles[i]) {
@@ -224,8 +231,8 @@ void LLVMCPUTileFuseAndVectorizePass::runOnOperation() {
     }
   }
 
-  funcOp.walk([&](linalg::ContractionOpInterface op) {
-    if (cast<linalg::LinalgOp>(op.getOperation()).hasDynamicShape()) {
+  funcOp.walk([&](linalg::LinalgOp op) {
+    if (hasTiledReductionLoops(op) && op.hasDynamicShape()) {
       lowerToVectors = false;
     }
   });
@@ -234,8 +241,10 @@ void LLVMCPUTileFuseAndVectorizePass::runOnOperation() {
     // Apply second level of tiling patterns if they are not vectorizable. This
     // will trigger LLVM auto-vectorization, which gains better performance.
     {
-      funcOp.walk([&](linalg::ContractionOpInterface op) {
-        setMarker(op, getWorkgroupL1TileMarker());
+      funcOp.walk([&](linalg::LinalgOp op) {
+        if (hasTiledReductionLoops(op)) {
+          setMarker(op, getWorkgroupL1TileMarker());
+        }
       });
       RewritePatternSet l2patterns(&getContext());
       l2patterns.insert<TileWorkgroups>(
@@ -274,6 +283,7 @@ void LLVMCPUTileFuseAndVectorizePass::runOnOperation() {
   {
     RewritePatternSet patterns(context);
     populateLinalgToVectorVectorizeMMT4dPatterns(context, patterns);
+    populateLinalgToVectorVectorizeConvPatterns(context, patterns);
     if (failed(applyPatternsAndFoldGreedily(funcOp, std::move(patterns)))) {
       return signalPassFailure();
     }
@@ -290,6 +300,9 @@ void LLVMCPUTileFuseAndVectorizePass::runOnOperation() {
     vectorizationPatterns.add<linalg::CopyVectorizationPattern>(context);
     vectorizationPatterns.add<linalg::LinalgVectorizationPattern>(
         &getContext(), f.addOpFilter<linalg::ContractionOpInterface>(), opt);
+    // Reads of padded tiles become transfer_reads with the padding value for
+    // the out-of-bounds elements.
+    linalg::populatePadOpVectorizationPatterns(vectorizationPatterns);
     vector::populateVectorTransferPermutationMapLoweringPatterns(
         vectorizationPatterns);
     vector::populateVectorReductionToContractPatterns(vectorizationPatterns);
@@ -34,6 +34,12 @@ static llvm::cl::opt<bool> clCheckIRBeforeLLVMConversion(
                    "before conversion to LLVM IR"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clFastMathApproximations(
+    "iree-llvmcpu-fast-math-approximations",
+    llvm::cl::desc("Use cheaper approximations of f32 math functions with "
+                   "bounded errors instead of the polynomial approximations"),
+    llvm::cl::init(false));
+
 //===---------------------------------------------------------------------===//
 // Default allocation functions for CPU backend
 //===---------------------------------------------------------------------===//
@@ -256,6 +262,10 @@ void addDoubleTilingExpertPassPipeline(OpPassManager &passManager) {
     passManager.addNestedPass<FuncOp>(createCSEPass());
   }
 
+  // Accumulate innermost reductions into vectors so that the reduction loops
+  // vectorize to elementwise ops.
+  passManager.addNestedPass<FuncOp>(createLLVMCPUSplitReductionPass());
+
   // Add the sandbox single tiling expert to tile and vectorize.
   {
     // The options are derived from sandbox codegen driver. hoistPadding options
@@ -356,7 +366,8 @@ static void addLowerToLLVMPasses(OpPassManager &passManager) {
   passManager.addPass(createFoldTensorExtractOpPass());
 
   // math dialect elementry functions -> polynomial form.
-  passManager.addNestedPass<FuncOp>(createPolynomialApproximationPass());
+  passManager.addNestedPass<FuncOp>(
+      createPolynomialApproximationPass(clFastMathApproximations));
 
   // (HAL, IREE, Linalg, STD) -> LLVM
   passManager.addNestedPass<FuncOp>(arith::createArithmeticExpandOpsPass());
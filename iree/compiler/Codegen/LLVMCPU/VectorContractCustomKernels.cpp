@@ -152,13 +152,14 @@ static Value getUnpromotedInput(Type unpromotedType, Type promotedType,
   if (unpromotedType == promotedType) {
     return promotedResult;
   }
-  // TODO: handle promotion of floating point types. Not doing it for now as
-  // it wouldn't be exercised.
-  auto extSIOp = promotedResult.getDefiningOp<arith::ExtSIOp>();
-  if (!extSIOp) {
+  Value extInput;
+  if (auto extSIOp = promotedResult.getDefiningOp<arith::ExtSIOp>()) {
+    extInput = extSIOp.getIn();
+  } else if (auto extFOp = promotedResult.getDefiningOp<arith::ExtFOp>()) {
+    extInput = extFOp.getIn();
+  } else {
     return nullptr;
   }
-  Value extInput = extSIOp.getIn();
   if (extInput.getType().cast<VectorType>().getElementType() !=
       unpromotedType) {
     return nullptr;
@@ -206,7 +207,7 @@ static Value flatten(PatternRewriter &rewriter, Location loc, Value vector) {
 // (2) Be explicit about the size of the vectors involved in the kernel's
 //         "calling convention".
 struct MMTKernel {
-  enum class ScalarType : int8_t { None, I8, I32, F32 };
+  enum class ScalarType : int8_t { None, I8, I32, BF16, F16, F32 };
   // Target architecture. Needed to generate inline asm constraints.
   CustomKernelTargetArch arch = CustomKernelTargetArch::None;
   // Element type of the LHS vectors.
@@ -567,6 +568,364 @@ MMTKernel MMTKernel_8x1x1_f32f32f32_Aarch64_Baseline_InlineAsm() {
   return kernel;
 }
 
+// i8*i8->i32 kernel for Aarch64 NEON +i8mm
+//
+// smmla multiplies a 2x8 LHS tile by a transposed 2x8 RHS tile, accumulating
+// into a 2x2 tile held in a single register. The accumulator in this kernel's
+// calling convention is row-major, so each pair of accumulator rows is
+// shuffled into 2x2 tiles (zip1/zip2 on 64-bit lanes) before the smmla's and
+// back afterwards. This is cheap compared to the 4x reduction in the number of
+// multiply-accumulate instructions relative to the +dotprod kernel.
+//
+// This kernel is needed because: at the moment, codegen doesn't know how to
+// make use of matrix multiply instructions.
+MMTKernel MMTKernel_8x8x8_i8i8i32_Aarch64I8mm_InlineAsm() {
+  MMTKernel kernel;
+  kernel.arch = CustomKernelTargetArch::Aarch64;
+  kernel.lhsType = MMTKernel::ScalarType::I8;
+  kernel.rhsType = MMTKernel::ScalarType::I8;
+  kernel.accType = MMTKernel::ScalarType::I32;
+  kernel.m0 = 8;  // shape: 8x8x8.
+  kernel.k0 = 8;
+  kernel.n0 = 8;
+  kernel.lhsRegSize = 16;  // LHS NEON register type: int8x16, 2 rows
+  kernel.rhsRegSize = 16;  // RHS NEON register type: int8x16, 2 rows
+  kernel.accRegSize = 4;   // Accum NEON register type: int32x4
+  kernel.lhsRegs = 4;      // = 8x8/16 for 8x8 LHS elems, 16 per register
+  kernel.rhsRegs = 4;      // = 8x8/16 for 8x8 RHS elems, 16 per register
+  kernel.accRegs = 16;     // = 8x8/4 for 8x8 Accum elems, 4 per register
+  kernel.asmImpl = R"ASM(
+      // Rows 0 and 1 of the accumulator.
+      zip1 v28.2d, $(acc:0).2d, $(acc:2).2d
+      zip2 v29.2d, $(acc:0).2d, $(acc:2).2d
+      zip1 v30.2d, $(acc:1).2d, $(acc:3).2d
+      zip2 v31.2d, $(acc:1).2d, $(acc:3).2d
+      smmla v28.4s, $(lhs:0).16b, $(rhs:0).16b
+      smmla v29.4s, $(lhs:0).16b, $(rhs:1).16b
+      smmla v30.4s, $(lhs:0).16b, $(rhs:2).16b
+      smmla v31.4s, $(lhs:0).16b, $(rhs:3).16b
+      zip1 $(acc:0).2d, v28.2d, v29.2d
+      zip2 $(acc:2).2d, v28.2d, v29.2d
+      zip1 $(acc:1).2d, v30.2d, v31.2d
+      zip2 $(acc:3).2d, v30.2d, v31.2d
+      // Rows 2 and 3 of the accumulator.
+      zip1 v28.2d, $(acc:4).2d, $(acc:6).2d
+      zip2 v29.2d, $(acc:4).2d, $(acc:6).2d
+      zip1 v30.2d, $(acc:5).2d, $(acc:7).2d
+      zip2 v31.2d, $(acc:5).2d, $(acc:7).2d
+      smmla v28.4s, $(lhs:1).16b, $(rhs:0).16b
+      smmla v29.4s, $(lhs:1).16b, $(rhs:1).16b
+      smmla v30.4s, $(lhs:1).16b, $(rhs:2).16b
+      smmla v31.4s, $(lhs:1).16b, $(rhs:3).16b
+      zip1 $(acc:4).2d, v28.2d, v29.2d
+      zip2 $(acc:6).2d, v28.2d, v29.2d
+      zip1 $(acc:5).2d, v30.2d, v31.2d
+      zip2 $(acc:7).2d, v30.2d, v31.2d
+      // Rows 4 and 5 of the accumulator.
+      zip1 v28.2d, $(acc:8).2d, $(acc:10).2d
+      zip2 v29.2d, $(acc:8).2d, $(acc:10).2d
+      zip1 v30.2d, $(acc:9).2d, $(acc:11).2d
+      zip2 v31.2d, $(acc:9).2d, $(acc:11).2d
+      smmla v28.4s, $(lhs:2).16b, $(rhs:0).16b
+      smmla v29.4s, $(lhs:2).16b, $(rhs:1).16b
+      smmla v30.4s, $(lhs:2).16b, $(rhs:2).16b
+      smmla v31.4s, $(lhs:2).16b, $(rhs:3).16b
+      zip1 $(acc:8).2d, v28.2d, v29.2d
+      zip2 $(acc:10).2d, v28.2d, v29.2d
+      zip1 $(acc:9).2d, v30.2d, v31.2d
+      zip2 $(acc:11).2d, v30.2d, v31.2d
+      // Rows 6 and 7 of the accumulator.
+      zip1 v28.2d, $(acc:12).2d, $(acc:14).2d
+      zip2 v29.2d, $(acc:12).2d, $(acc:14).2d
+      zip1 v30.2d, $(acc:13).2d, $(acc:15).2d
+      zip2 v31.2d, $(acc:13).2d, $(acc:15).2d
+      smmla v28.4s, $(lhs:3).16b, $(rhs:0).16b
+      smmla v29.4s, $(lhs:3).16b, $(rhs:1).16b
+      smmla v30.4s, $(lhs:3).16b, $(rhs:2).16b
+      smmla v31.4s, $(lhs:3).16b, $(rhs:3).16b
+      zip1 $(acc:12).2d, v28.2d, v29.2d
+      zip2 $(acc:14).2d, v28.2d, v29.2d
+      zip1 $(acc:13).2d, v30.2d, v31.2d
+      zip2 $(acc:15).2d, v30.2d, v31.2d
+    )ASM";
+  kernel.asmClobbers = "v28,v29,v30,v31";
+  return kernel;
+}
+
+// bf16*bf16->f32 kernel for Aarch64 NEON +bf16
+//
+// Same structure as the +i8mm kernel: bfmmla multiplies a 2x4 LHS tile by a
+// transposed 2x4 RHS tile, accumulating into a 2x2 f32 tile.
+//
+// This kernel is needed because: at the moment, codegen doesn't know how to
+// make use of bf16 instructions and instead promotes to f32 before
+// multiplying.
+MMTKernel MMTKernel_8x4x8_bf16bf16f32_Aarch64Bf16_InlineAsm() {
+  MMTKernel kernel;
+  kernel.arch = CustomKernelTargetArch::Aarch64;
+  kernel.lhsType = MMTKernel::ScalarType::BF16;
+  kernel.rhsType = MMTKernel::ScalarType::BF16;
+  kernel.accType = MMTKernel::ScalarType::F32;
+  kernel.m0 = 8;  // shape: 8x4x8.
+  kernel.k0 = 4;
+  kernel.n0 = 8;
+  kernel.lhsRegSize = 8;  // LHS NEON register type: bfloat16x8, 2 rows
+  kernel.rhsRegSize = 8;  // RHS NEON register type: bfloat16x8, 2 rows
+  kernel.accRegSize = 4;  // Accum NEON register type: float32x4
+  kernel.lhsRegs = 4;     // = 8x4/8 for 8x4 LHS elems, 8 per register
+  kernel.rhsRegs = 4;     // = 8x4/8 for 8x4 RHS elems, 8 per register
+  kernel.accRegs = 16;    // = 8x8/4 for 8x8 Accum elems, 4 per register
+  kernel.asmImpl = R"ASM(
+      // Rows 0 and 1 of the accumulator.
+      zip1 v28.2d, $(acc:0).2d, $(acc:2).2d
+      zip2 v29.2d, $(acc:0).2d, $(acc:2).2d
+      zip1 v30.2d, $(acc:1).2d, $(acc:3).2d
+      zip2 v31.2d, $(acc:1).2d, $(acc:3).2d
+      bfmmla v28.4s, $(lhs:0).8h, $(rhs:0).8h
+      bfmmla v29.4s, $(lhs:0).8h, $(rhs:1).8h
+      bfmmla v30.4s, $(lhs:0).8h, $(rhs:2).8h
+      bfmmla v31.4s, $(lhs:0).8h, $(rhs:3).8h
+      zip1 $(acc:0).2d, v28.2d, v29.2d
+      zip2 $(acc:2).2d, v28.2d, v29.2d
+      zip1 $(acc:1).2d, v30.2d, v31.2d
+      zip2 $(acc:3).2d, v30.2d, v31.2d
+      // Rows 2 and 3 of the accumulator.
+      zip1 v28.2d, $(acc:4).2d, $(acc:6).2d
+      zip2 v29.2d, $(acc:4).2d, $(acc:6).2d
+      zip1 v30.2d, $(acc:5).2d, $(acc:7).2d
+      zip2 v31.2d, $(acc:5).2d, $(acc:7).2d
+      bfmmla v28.4s, $(lhs:1).8h, $(rhs:0).8h
+      bfmmla v29.4s, $(lhs:1).8h, $(rhs:1).8h
+      bfmmla v30.4s, $(lhs:1).8h, $(rhs:2).8h
+      bfmmla v31.4s, $(lhs:1).8h, $(rhs:3).8h
+      zip1 $(acc:4).2d, v28.2d, v29.2d
+      zip2 $(acc:6).2d, v28.2d, v29.2d
+      zip1 $(acc:5).2d, v30.2d, v31.2d
+      zip2 $(acc:7).2d, v30.2d, v31.2d
+      // Rows 4 and 5 of the accumulator.
+      zip1 v28.2d, $(acc:8).2d, $(acc:10).2d
+      zip2 v29.2d, $(acc:8).2d, $(acc:10).2d
+      zip1 v30.2d, $(acc:9).2d, $(acc:11).2d
+      zip2 v31.2d, $(acc:9).2d, $(acc:11).2d
+      bfmmla v28.4s, $(lhs:2).8h, $(rhs:0).8h
+      bfmmla v29.4s, $(lhs:2).8h, $(rhs:1).8h
+      bfmmla v30.4s, $(lhs:2).8h, $(rhs:2).8h
+      bfmmla v31.4s, $(lhs:2).8h, $(rhs:3).8h
+      zip1 $(acc:8).2d, v28.2d, v29.2d
+      zip2 $(acc:10).2d, v28.2d, v29.2d
+      zip1 $(acc:9).2d, v30.2d, v31.2d
+      zip2 $(acc:11).2d, v30.2d, v31.2d
+      // Rows 6 and 7 of the accumulator.
+      zip1 v28.2d, $(acc:12).2d, $(acc:14).2d
+      zip2 v29.2d, $(acc:12).2d, $(acc:14).2d
+      zip1 v30.2d, $(acc:13).2d, $(acc:15).2d
+      zip2 v31.2d, $(acc:13).2d, $(acc:15).2d
+      bfmmla v28.4s, $(lhs:3).8h, $(rhs:0).8h
+      bfmmla v29.4s, $(lhs:3).8h, $(rhs:1).8h
+      bfmmla v30.4s, $(lhs:3).8h, $(rhs:2).8h
+      bfmmla v31.4s, $(lhs:3).8h, $(rhs:3).8h
+      zip1 $(acc:12).2d, v28.2d, v29.2d
+      zip2 $(acc:14).2d, v28.2d, v29.2d
+      zip1 $(acc:13).2d, v30.2d, v31.2d
+      zip2 $(acc:15).2d, v30.2d, v31.2d
+    )ASM";
+  kernel.asmClobbers = "v28,v29,v30,v31";
+  return kernel;
+}
+
+// f16*f16->f16 kernel for Aarch64 NEON +fullfp16
+//
+// Same structure as the f32 kernel, with twice as many lanes per register.
+// The by-element form of fmla on 16-bit lanes can only address v0--v15, so
+// the LHS is first copied to v15.
+//
+// This kernel is needed because: at the moment, the default vector.contract
+// lowerings broadcast each LHS element to a full register with a separate
+// instruction before each multiply-accumulate.
+MMTKernel MMTKernel_8x1x8_f16f16f16_Aarch64Fullfp16_InlineAsm() {
+  MMTKernel kernel;
+  kernel.arch = CustomKernelTargetArch::Aarch64;
+  kernel.lhsType = MMTKernel::ScalarType::F16;
+  kernel.rhsType = MMTKernel::ScalarType::F16;
+  kernel.accType = MMTKernel::ScalarType::F16;
+  kernel.m0 = 8;
+  kernel.k0 = 1;
+  kernel.n0 = 8;
+  kernel.lhsRegSize = 8;
+  kernel.rhsRegSize = 8;
+  kernel.accRegSize = 8;
+  kernel.lhsRegs = 1;
+  kernel.rhsRegs = 1;
+  kernel.accRegs = 8;
+  kernel.asmImpl = R"ASM(
+      mov v15.16b, $(lhs:0).16b
+      fmla $(acc:0).8h, $(rhs:0).8h, v15.h[0]
+      fmla $(acc:1).8h, $(rhs:0).8h, v15.h[1]
+      fmla $(acc:2).8h, $(rhs:0).8h, v15.h[2]
+      fmla $(acc:3).8h, $(rhs:0).8h, v15.h[3]
+      fmla $(acc:4).8h, $(rhs:0).8h, v15.h[4]
+      fmla $(acc:5).8h, $(rhs:0).8h, v15.h[5]
+      fmla $(acc:6).8h, $(rhs:0).8h, v15.h[6]
+      fmla $(acc:7).8h, $(rhs:0).8h, v15.h[7]
+    )ASM";
+  kernel.asmClobbers = "v15";
+  return kernel;
+}
+
+// i8*i8->i32 kernel for x86_64 AVX-512 VNNI
+//
+// vpdpbusd multiplies unsigned 8-bit values by signed 8-bit values, summing
+// groups of 4 products into 32-bit lanes. The signed LHS is biased to unsigned
+// by flipping its sign bits (adding 128), and the resulting excess of 128
+// times the sum of each RHS row is subtracted from the accumulators. Each LHS
+// row is in turn rotated to the bottom 32-bit lane (valignd) and broadcast:
+// there is no by-element form of vpdpbusd.
+//
+// Uses AT&T syntax like the other kernels: operands are in reverse order
+// relative to the Intel documentation and immediates are prefixed with $
+// (escaped as $$ in inline asm).
+//
+// This kernel is needed because: at the moment, codegen doesn't know how to
+// make use of VNNI instructions and instead promotes to i32 before
+// multiplying.
+MMTKernel MMTKernel_16x4x16_i8i8i32_X86_64Avx512Vnni_InlineAsm() {
+  MMTKernel kernel;
+  kernel.arch = CustomKernelTargetArch::X86_64;
+  kernel.lhsType = MMTKernel::ScalarType::I8;
+  kernel.rhsType = MMTKernel::ScalarType::I8;
+  kernel.accType = MMTKernel::ScalarType::I32;
+  kernel.m0 = 16;  // shape: 16x4x16.
+  kernel.k0 = 4;
+  kernel.n0 = 16;
+  kernel.lhsRegSize = 64;  // LHS register type: zmm as int8x64
+  kernel.rhsRegSize = 64;  // RHS register type: zmm as int8x64
+  kernel.accRegSize = 16;  // Accum register type: zmm as int32x16
+  kernel.lhsRegs = 1;
+  kernel.rhsRegs = 1;
+  kernel.accRegs = 16;  // = 16x16/16 for 16x16 Accum elems, 16 per register
+  kernel.asmImpl = R"ASM(
+      movl $$0x80808080, %eax
+      vpbroadcastd %eax, %zmm31
+      // zmm30 = LHS + 128 as unsigned 8-bit values.
+      vpxord %zmm31, $(lhs:0), %zmm30
+      // zmm29 = 128 * sum of each RHS row.
+      vpxord %zmm29, %zmm29, %zmm29
+      vpdpbusd $(rhs:0), %zmm31, %zmm29
+      vpbroadcastd %xmm30, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:0)
+      vpsubd %zmm29, $(acc:0), $(acc:0)
+      valignd $$1, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:1)
+      vpsubd %zmm29, $(acc:1), $(acc:1)
+      valignd $$2, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:2)
+      vpsubd %zmm29, $(acc:2), $(acc:2)
+      valignd $$3, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:3)
+      vpsubd %zmm29, $(acc:3), $(acc:3)
+      valignd $$4, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:4)
+      vpsubd %zmm29, $(acc:4), $(acc:4)
+      valignd $$5, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:5)
+      vpsubd %zmm29, $(acc:5), $(acc:5)
+      valignd $$6, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:6)
+      vpsubd %zmm29, $(acc:6), $(acc:6)
+      valignd $$7, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:7)
+      vpsubd %zmm29, $(acc:7), $(acc:7)
+      valignd $$8, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:8)
+      vpsubd %zmm29, $(acc:8), $(acc:8)
+      valignd $$9, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:9)
+      vpsubd %zmm29, $(acc:9), $(acc:9)
+      valignd $$10, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:10)
+      vpsubd %zmm29, $(acc:10), $(acc:10)
+      valignd $$11, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:11)
+      vpsubd %zmm29, $(acc:11), $(acc:11)
+      valignd $$12, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:12)
+      vpsubd %zmm29, $(acc:12), $(acc:12)
+      valignd $$13, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:13)
+      vpsubd %zmm29, $(acc:13), $(acc:13)
+      valignd $$14, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:14)
+      vpsubd %zmm29, $(acc:14), $(acc:14)
+      valignd $$15, %zmm30, %zmm30, %zmm28
+      vpbroadcastd %xmm28, %zmm28
+      vpdpbusd $(rhs:0), %zmm28, $(acc:15)
+      vpsubd %zmm29, $(acc:15), $(acc:15)
+    )ASM";
+  kernel.asmClobbers = "eax,zmm28,zmm29,zmm30,zmm31";
+  return kernel;
+}
+
+// A kernel along with the target features it requires.
+struct MMTKernelRegistration {
+  MMTKernel kernel;
+  // Features of the kernel's arch that must all be available.
+  SmallVector<CustomKernelTargetFeature> requiredFeatures;
+  // Relative preference of the kernel over others matching the same
+  // vector.contract: kernels using more powerful instructions are preferred.
+  unsigned benefit;
+};
+
+// Returns all known kernels. Kernels available for the same target that match
+// the same shape and data types must have distinct benefits in order for the
+// selection to be deterministic.
+static const SmallVector<MMTKernelRegistration> &getMMTKernelRegistry() {
+  static const SmallVector<MMTKernelRegistration> registry = {
+      // Aarch64 baseline.
+      {MMTKernel_8x1x8_f32f32f32_Aarch64_Baseline_InlineAsm(), {}, 1},
+      {MMTKernel_8x1x1_f32f32f32_Aarch64_Baseline_InlineAsm(), {}, 1},
+      {MMTKernel_8x1x8_i8i8i32_Aarch64_Baseline_InlineAsm(), {}, 1},
+      {MMTKernel_8x8x1_i8i8i32_Aarch64_Baseline_InlineAsm(), {}, 1},
+      // Aarch64 +dotprod.
+      {MMTKernel_8x4x8_i8i8i32_Aarch64Dotprod_InlineAsm(),
+       {CustomKernelTargetFeature::Aarch64Dotprod},
+       2},
+      {MMTKernel_8x4x1_i8i8i32_Aarch64Dotprod_InlineAsm(),
+       {CustomKernelTargetFeature::Aarch64Dotprod},
+       2},
+      // Aarch64 +i8mm.
+      {MMTKernel_8x8x8_i8i8i32_Aarch64I8mm_InlineAsm(),
+       {CustomKernelTargetFeature::Aarch64I8mm},
+       3},
+      // Aarch64 +bf16.
+      {MMTKernel_8x4x8_bf16bf16f32_Aarch64Bf16_InlineAsm(),
+       {CustomKernelTargetFeature::Aarch64Bf16},
+       2},
+      // Aarch64 +fullfp16.
+      {MMTKernel_8x1x8_f16f16f16_Aarch64Fullfp16_InlineAsm(),
+       {CustomKernelTargetFeature::Aarch64Fullfp16},
+       2},
+      // x86_64 +avx512vnni.
+      {MMTKernel_16x4x16_i8i8i32_X86_64Avx512Vnni_InlineAsm(),
+       {CustomKernelTargetFeature::X86_64Avx512Vnni},
+       2},
+  };
+  return registry;
+}
+
 // Constructs the mlir::Type corresponding to a scalar type.
 Type mlirType(MLIRContext *context, MMTKernel::ScalarType t) {
   switch (t) {
@@ -576,6 +935,10 @@ Type mlirType(MLIRContext *context, MMTKernel::ScalarType t) {
       return IntegerType::get(context, 8, IntegerType::Signless);
     case MMTKernel::ScalarType::I32:
       return IntegerType::get(context, 32, IntegerType::Signless);
+    case MMTKernel::ScalarType::BF16:
+      return FloatType::getBF16(context);
+    case MMTKernel::ScalarType::F16:
+      return FloatType::getF16(context);
     case MMTKernel::ScalarType::F32:
       return FloatType::getF32(context);
   }
@@ -650,6 +1013,8 @@ class MMTKernelGenerator {
     switch (kernel.arch) {
       case CustomKernelTargetArch::Aarch64:
         return "w";
+      case CustomKernelTargetArch::X86_64:
+        return "v";
       case CustomKernelTargetArch::None:
         break;
     }
@@ -800,8 +1165,10 @@ class MMTCustomKernelPattern : public OpRewritePattern<vector::ContractionOp> {
   MMTKernel kernel;
 
  public:
-  MMTCustomKernelPattern(MLIRContext *context, MMTKernel kernel)
-      : OpRewritePattern<vector::ContractionOp>(context), kernel(kernel) {}
+  MMTCustomKernelPattern(MLIRContext *context, MMTKernel kernel,
+                         PatternBenefit benefit = 1)
+      : OpRewritePattern<vector::ContractionOp>(context, benefit),
+        kernel(kernel) {}
 
   LogicalResult matchAndRewrite(vector::ContractionOp contractionOp,
                                 PatternRewriter &rewriter) const override {
@@ -837,8 +1204,8 @@ class MMTCustomKernelPattern : public OpRewritePattern<vector::ContractionOp> {
     Attribute resultInitializer;
     if (accElemType.isSignlessInteger()) {
       resultInitializer = DenseIntElementsAttr::get(flatAccVectorType, 0);
-    } else if (accElemType.isF32()) {
-      resultInitializer = DenseFPElementsAttr::get(flatAccVectorType, 0.f);
+    } else if (accElemType.isF32() || accElemType.isF16()) {
+      resultInitializer = rewriter.getZeroAttr(flatAccVectorType);
     } else {
       return failure();
     }
@@ -1049,30 +1416,28 @@ class VectorContractCustomKernelsPass
 void populateVectorContractCustomKernelsPatterns(
     const CustomKernelsTargetInfo &target_info, RewritePatternSet &patterns) {
   MLIRContext *context = patterns.getContext();
-  if (target_info.is(CustomKernelTargetArch::Aarch64)) {
-    // TODO: add a "kernel benefit" system whereby if two kernels are available
-    // for the same shape and same data types, the fastest one (ie the one
-    // using the most powerful available SIMD instructions) is selected.
-    // This is incidentally not needed at the moment because currently no two
-    // kernels share the exact same shape and data types.
-    patterns.add<MMTCustomKernelPattern>(
-        context, MMTKernel_8x1x8_f32f32f32_Aarch64_Baseline_InlineAsm());
-    patterns.add<MMTCustomKernelPattern>(
-        context, MMTKernel_8x1x1_f32f32f32_Aarch64_Baseline_InlineAsm());
-    patterns.add<MMTCustomKernelPattern>(
-        context, MMTKernel_8x1x8_i8i8i32_Aarch64_Baseline_InlineAsm());
-    patterns.add<MMTCustomKernelPattern>(
-        context, MMTKernel_8x8x1_i8i8i32_Aarch64_Baseline_InlineAsm());
-    if (target_info.has(CustomKernelTargetFeature::Aarch64Dotprod)) {
-      if (target_info.has(CustomKernelTargetFeature::Intrinsics)) {
-        patterns.add<MMT_8x4x8_i8i8i32_Aarch64Dotprod_Intrinsics>(context);
-      } else {
-        patterns.add<MMTCustomKernelPattern>(
-            context, MMTKernel_8x4x8_i8i8i32_Aarch64Dotprod_InlineAsm());
-        patterns.add<MMTCustomKernelPattern>(
-            context, MMTKernel_8x4x1_i8i8i32_Aarch64Dotprod_InlineAsm());
-      }
+  for (const auto &registration : getMMTKernelRegistry()) {
+    if (!target_info.is(registration.kernel.arch)) continue;
+    if (!llvm::all_of(registration.requiredFeatures,
+                      [&](CustomKernelTargetFeature feature) {
+                        return target_info.has(feature);
+                      })) {
+      continue;
     }
+    // The intrinsics variant of the +dotprod kernel replaces the inline asm
+    // kernels when requested.
+    if (target_info.has(CustomKernelTargetFeature::Intrinsics) &&
+        llvm::is_contained(registration.requiredFeatures,
+                           CustomKernelTargetFeature::Aarch64Dotprod)) {
+      continue;
+    }
+    patterns.add<MMTCustomKernelPattern>(context, registration.kernel,
+                                         registration.benefit);
+  }
+  if (target_info.has(CustomKernelTargetFeature::Aarch64Dotprod) &&
+      target_info.has(CustomKernelTargetFeature::Intrinsics)) {
+    patterns.add<MMT_8x4x8_i8i8i32_Aarch64Dotprod_Intrinsics>(
+        context, /*benefit=*/2);
   }
 }
 
@@ -0,0 +1,29 @@
+// RUN: iree-opt -iree-convert-to-llvm %s | FileCheck %s
+
+// CHECK: llvm.mlir.global private constant @__import_ordinal_iree_hal_memcpy_v0(0 : i32) {hal.import.name = "iree_hal_memcpy_v0"}
+// CHECK-NOT: func private @iree_hal_memcpy_v0
+func private @iree_hal_memcpy_v0(memref<?xi8>, memref<?xi8>, index) -> i32
+    attributes {hal.import}
+
+// CHECK-LABEL: llvm.func internal @call_import
+func @call_import() {
+  // CHECK: %[[PARAMS_PTR:.+]] = llvm.alloca %{{.+}} x !llvm.struct<(ptr<i8>, ptr<i8>, i64)>
+  // CHECK: llvm.getelementptr
+  // CHECK: llvm.getelementptr
+  // CHECK: %[[PARAMS:.+]] = llvm.insertvalue %{{.+}}, %{{.+}}[2]
+  // CHECK: llvm.store %[[PARAMS]], %[[PARAMS_PTR]]
+  // CHECK: %[[OPAQUE_PARAMS:.+]] = llvm.bitcast %[[PARAMS_PTR]] : !llvm.ptr<struct<(ptr<i8>, ptr<i8>, i64)>> to !llvm.ptr<i8>
+  // CHECK: %[[ORDINAL_PTR:.+]] = llvm.mlir.addressof @__import_ordinal_iree_hal_memcpy_v0
+  // CHECK: %[[ORDINAL:.+]] = llvm.load %[[ORDINAL_PTR]] : !llvm.ptr<i32>
+  // CHECK: %[[THUNK:.+]] = llvm.extractvalue %{{.+}}[7]
+  // CHECK: %[[IMPORTS:.+]] = llvm.extractvalue %{{.+}}[8]
+  // CHECK: %[[IMPORT_PTR:.+]] = llvm.getelementptr %[[IMPORTS]][%[[ORDINAL]]]
+  // CHECK: %[[IMPORT:.+]] = llvm.load %[[IMPORT_PTR]]
+  // CHECK: llvm.call %[[THUNK]](%[[IMPORT]], %[[OPAQUE_PARAMS]])
+  %c0 = arith.constant 0 : index
+  %c64 = arith.constant 64 : index
+  %dst = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) offset(%c0) : memref<?xi8>{%c64}
+  %src = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) offset(%c0) : memref<?xi8>{%c64}
+  %status = call @iree_hal_memcpy_v0(%dst, %src, %c64) : (memref<?xi8>, memref<?xi8>, index) -> i32
+  return
+}
@@ -875,6 +875,82 @@ hal.executable private @conv_static {
 
 // -----
 
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @conv_direct {
+  hal.executable.variant public @system_elf_x86_64, target = <"llvm", "system-elf-x86_64", {
+    data_layout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128",
+    native_vector_size = 16 : index,
+    target_triple = "x86_64-pc-linux-gnu"
+  }> {
+    hal.executable.entry_point public @conv_direct layout(#executable_layout)
+    builtin.module {
+      func @conv_direct() {
+        %cst = arith.constant 0.000000e+00 : f32
+        %c32 = arith.constant 32 : index
+        %c56 = arith.constant 56 : index
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:1x58x58x16xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:3x3x16x32xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<writeonly:1x56x56x32xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %workgroup_size_z = hal.interface.workgroup.size[2] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %workgroup_id_z = hal.interface.workgroup.id[2] : index
+        %workgroup_count_z = hal.interface.workgroup.count[2] : index
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_z, %workgroup_size_z]
+        %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_z, %workgroup_size_z]
+        scf.for %arg0 = %3 to %c56 step %4 {
+          %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_y, %workgroup_size_y]
+          %6 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_y, %workgroup_size_y]
+          scf.for %arg1 = %5 to %c56 step %6 {
+            %7 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+            %8 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+            scf.for %arg2 = %7 to %c32 step %8 {
+              %9 = affine.min affine_map<(d0)[s0] -> (s0 + 2, -d0 + 58)>(%arg0)[%workgroup_size_z]
+              %10 = affine.min affine_map<(d0)[s0] -> (s0 + 2, -d0 + 58)>(%arg1)[%workgroup_size_y]
+              %11 = flow.dispatch.tensor.load %0, offsets = [0, %arg0, %arg1, 0], sizes = [1, %9, %10, 16], strides = [1, 1, 1, 1] : !flow.dispatch.tensor<readonly:1x58x58x16xf32> -> tensor<1x?x?x16xf32>
+              %12 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 32)>(%arg2)[%workgroup_size_x]
+              %13 = flow.dispatch.tensor.load %1, offsets = [0, 0, 0, %arg2], sizes = [3, 3, 16, %12], strides = [1, 1, 1, 1] : !flow.dispatch.tensor<readonly:3x3x16x32xf32> -> tensor<3x3x16x?xf32>
+              %14 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 56)>(%arg0)[%workgroup_size_z]
+              %15 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 56)>(%arg1)[%workgroup_size_y]
+              %16 = linalg.init_tensor [1, %14, %15, %12] : tensor<1x?x?x?xf32>
+              %17 = linalg.fill(%cst, %16) : f32, tensor<1x?x?x?xf32> -> tensor<1x?x?x?xf32>
+              %18 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>} ins(%11, %13 : tensor<1x?x?x16xf32>, tensor<3x3x16x?xf32>) outs(%17 : tensor<1x?x?x?xf32>) -> tensor<1x?x?x?xf32>
+              flow.dispatch.tensor.store %18, %2, offsets = [0, %arg0, %arg1, %arg2], sizes = [1, %14, %15, %12], strides = [1, 1, 1, 1] : tensor<1x?x?x?xf32> -> !flow.dispatch.tensor<writeonly:1x56x56x32xf32>
+            }
+          }
+        }
+        return
+      }
+    }
+  }
+}
+
+//  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[0, 14, 14, 32, 0, 0, 0], [1, 1, 2, 8, 1, 1, 4], [1, 1, 2, 8, 1, 1, 4]{{\]}}, native_vector_size = []>
+//  CHECK-DAG: #[[MAP0:.+]] = affine_map<()[s0] -> (s0 ceildiv 32)>
+//  CHECK-DAG: #[[MAP1:.+]] = affine_map<()[s0] -> (s0 ceildiv 14)>
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"CPUTileFuseAndVectorize", workload_per_wg = [32, 14, 14]>
+//      CHECK: hal.executable.entry_point public @conv_direct
+// CHECK-SAME:     translation.info = #[[TRANSLATION]]
+// CHECK-NEXT:   ^bb0(%[[ARG0:[a-zA-Z0-9]+]]: index, %[[ARG1:[a-zA-Z0-9]+]]: index, %[[ARG2:[a-zA-Z0-9]+]]: index)
+//  CHECK-DAG:     %[[D0:.+]] = affine.apply #[[MAP0]]()[%[[ARG0]]
+//  CHECK-DAG:     %[[D1:.+]] = affine.apply #[[MAP1]]()[%[[ARG1]]
+//  CHECK-DAG:     %[[D2:.+]] = affine.apply #[[MAP1]]()[%[[ARG2]]
+//      CHECK:     hal.return %[[D0]], %[[D1]], %[[D2]]
+//      CHECK:     linalg.conv_2d_nhwc_hwcf
+// CHECK-SAME:       lowering.config = #[[CONFIG]]
+
+// -----
+
 #executable_layout = #hal.executable.layout<push_constants = 0, sets = [
   #hal.descriptor_set.layout<0, bindings = [
     #hal.descriptor_set.binding<0, storage_buffer>,
@@ -1697,3 +1773,95 @@ hal.executable private @gemm_unit_M {
 }
 //  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[], [4, 0, 0], [0, 1, 1]], native_vector_size = []>
 //  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"CPUDoubleTilingExpert", workload_per_wg = []>
+
+// -----
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+hal.executable private @row_sum {
+  hal.executable.variant public @system_elf_x86_64, target = <"llvm", "system-elf-x86_64", {
+    data_layout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128",
+    native_vector_size = 16 : index,
+    target_triple = "x86_64-pc-linux-gnu"
+  }> {
+    hal.executable.entry_point public @row_sum layout(#executable_layout)
+    builtin.module {
+      func @row_sum() {
+        %c128 = arith.constant 128 : index
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:128x4096xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<writeonly:128xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %2 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+        scf.for %arg0 = %2 to %c128 step %3 {
+          %4 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 128)>(%arg0)[%workgroup_size_x]
+          %5 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%4, 4096], strides = [1, 1] : !flow.dispatch.tensor<readonly:128x4096xf32> -> tensor<?x4096xf32>
+          %6 = linalg.init_tensor [%4] : tensor<?xf32>
+          %7 = linalg.fill(%cst, %6) : f32, tensor<?xf32> -> tensor<?xf32>
+          %8 = linalg.generic {
+              indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+              iterator_types = ["parallel", "reduction"]}
+              ins(%5 : tensor<?x4096xf32>) outs(%7 : tensor<?xf32>) {
+            ^bb0(%arg1: f32, %arg2: f32):
+              %9 = arith.addf %arg1, %arg2 : f32
+              linalg.yield %9 : f32
+            } -> tensor<?xf32>
+          flow.dispatch.tensor.store %8, %1, offsets = [%arg0], sizes = [%4], strides = [1] : tensor<?xf32> -> !flow.dispatch.tensor<writeonly:128xf32>
+        }
+        return
+      }
+    }
+  }
+}
+//  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[], [1, 0], [0, 16]], native_vector_size = []>
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"CPUDoubleTilingExpert", workload_per_wg = [64]>
+//      CHECK: hal.executable.entry_point public @row_sum
+// CHECK-SAME:     translation.info = #[[TRANSLATION]]
+//      CHECK:     linalg.generic
+//      CHECK:       lowering.config = #[[CONFIG]]
+
+// -----
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>,
+    #hal.descriptor_set.binding<3, storage_buffer>
+  ]>
+]>
+hal.executable private @attention {
+  hal.executable.variant @system_elf_x86_64, target = <"llvm", "system-elf-x86_64"> {
+    hal.executable.entry_point @attention layout(#executable_layout)
+    builtin.module {
+      builtin.func @attention() {
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:8x1024x64xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:8x1024x64xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<readonly:8x1024x64xf32>
+        %3 = hal.interface.binding.subspan set(0) binding(3) type(storage_buffer) : !flow.dispatch.tensor<writeonly:8x1024x64xf32>
+        %4 = flow.dispatch.tensor.load %0, offsets = [0, 0, 0], sizes = [8, 1024, 64], strides = [1, 1, 1] : !flow.dispatch.tensor<readonly:8x1024x64xf32> -> tensor<8x1024x64xf32>
+        %5 = flow.dispatch.tensor.load %1, offsets = [0, 0, 0], sizes = [8, 1024, 64], strides = [1, 1, 1] : !flow.dispatch.tensor<readonly:8x1024x64xf32> -> tensor<8x1024x64xf32>
+        %6 = flow.dispatch.tensor.load %2, offsets = [0, 0, 0], sizes = [8, 1024, 64], strides = [1, 1, 1] : !flow.dispatch.tensor<readonly:8x1024x64xf32> -> tensor<8x1024x64xf32>
+        %7 = linalg.init_tensor [8, 1024, 64] : tensor<8x1024x64xf32>
+        %8 = iree_linalg_ext.attention ins(%4, %5, %6 : tensor<8x1024x64xf32>, tensor<8x1024x64xf32>, tensor<8x1024x64xf32>) outs(%7 : tensor<8x1024x64xf32>) -> tensor<8x1024x64xf32>
+        flow.dispatch.tensor.store %8, %3, offsets = [0, 0, 0], sizes = [8, 1024, 64], strides = [1, 1, 1] : tensor<8x1024x64xf32> -> !flow.dispatch.tensor<writeonly:8x1024x64xf32>
+        return
+      }
+    }
+  }
+}
+
+//   CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[1, 64]{{\]}}, native_vector_size = []>
+//   CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"CPUDefault", workload_per_wg = [64, 1]>
+//       CHECK: hal.executable.entry_point public @attention
+//  CHECK-SAME:   translation.info = #[[TRANSLATION]]
+//       CHECK: func @attention()
+//       CHECK:   iree_linalg_ext.attention
+//  CHECK-SAME:     lowering.config = #[[CONFIG]]
@@ -0,0 +1,84 @@
+// RUN: iree-opt -split-input-file -iree-llvmcpu-split-reduction %s | FileCheck %s
+
+#config = #iree_codegen.lowering.config<tile_sizes = [[], [1, 0], [0, 16]], native_vector_size = []>
+func @row_sum(%input: tensor<1x4096xf32>, %init: tensor<1xf32>) -> tensor<1xf32> {
+  %0 = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+      iterator_types = ["parallel", "reduction"]}
+      ins(%input : tensor<1x4096xf32>) outs(%init : tensor<1xf32>)
+      attrs = {lowering.config = #config} {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %1 = arith.addf %arg0, %arg1 : f32
+      linalg.yield %1 : f32
+    } -> tensor<1xf32>
+  return %0 : tensor<1xf32>
+}
+//  CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1) -> (d0, d1)>
+//  CHECK-DAG: #[[MAP1:.+]] = affine_map<(d0, d1) -> (d0)>
+//      CHECK: func @row_sum
+// CHECK-SAME:     %[[INPUT:[a-zA-Z0-9_]+]]: tensor<1x4096xf32>
+// CHECK-SAME:     %[[INIT:[a-zA-Z0-9_]+]]: tensor<1xf32>
+//  CHECK-DAG:   %[[ZERO:.+]] = arith.constant 0.000000e+00 : f32
+//  CHECK-DAG:   %[[C4096:.+]] = arith.constant 4096 : index
+//  CHECK-DAG:   %[[C16:.+]] = arith.constant 16 : index
+//      CHECK:   %[[ACC_INIT:.+]] = linalg.init_tensor [1, 16] : tensor<1x16xf32>
+//      CHECK:   %[[ACC_FILL:.+]] = linalg.fill(%[[ZERO]], %[[ACC_INIT]])
+//      CHECK:   %[[ACC:.+]] = scf.for %[[IV:.+]] = %{{.+}} to %[[C4096]] step %[[C16]]
+// CHECK-SAME:       iter_args(%[[ARG:.+]] = %[[ACC_FILL]])
+//      CHECK:     %[[TILE:.+]] = tensor.extract_slice %[[INPUT]][0, %[[IV]]] [1, 16] [1, 1]
+//      CHECK:     %[[PARTIAL:.+]] = linalg.generic
+// CHECK-SAME:         indexing_maps = [#[[MAP0]], #[[MAP0]]]
+// CHECK-SAME:         iterator_types = ["parallel", "parallel"]
+// CHECK-SAME:         ins(%[[TILE]] : tensor<1x16xf32>) outs(%[[ARG]] : tensor<1x16xf32>)
+//      CHECK:       arith.addf
+//      CHECK:     scf.yield %[[PARTIAL]]
+//      CHECK:   %[[RESULT:.+]] = linalg.generic
+// CHECK-SAME:       indexing_maps = [#[[MAP0]], #[[MAP1]]]
+// CHECK-SAME:       iterator_types = ["parallel", "reduction"]
+// CHECK-SAME:       ins(%[[ACC]] : tensor<1x16xf32>) outs(%[[INIT]] : tensor<1xf32>)
+//      CHECK:     arith.addf
+//      CHECK:   return %[[RESULT]]
+
+// -----
+
+#config = #iree_codegen.lowering.config<tile_sizes = [[], [1, 0], [0, 8]], native_vector_size = []>
+func @row_max(%input: tensor<1x64xf32>, %init: tensor<1xf32>) -> tensor<1xf32> {
+  %0 = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+      iterator_types = ["parallel", "reduction"]}
+      ins(%input : tensor<1x64xf32>) outs(%init : tensor<1xf32>)
+      attrs = {lowering.config = #config} {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %1 = arith.maxf %arg0, %arg1 : f32
+      linalg.yield %1 : f32
+    } -> tensor<1xf32>
+  return %0 : tensor<1xf32>
+}
+//      CHECK: func @row_max
+//      CHECK:   %[[NEG_INF:.+]] = arith.constant 0xFF800000 : f32
+//      CHECK:   linalg.fill(%[[NEG_INF]], %{{.+}}) : f32, tensor<1x8xf32>
+//      CHECK:   scf.for
+//      CHECK:     arith.maxf
+//      CHECK:   linalg.generic
+//      CHECK:     arith.maxf
+
+// -----
+
+// The vector tile size does not divide the reduction: keep the reduction.
+#config = #iree_codegen.lowering.config<tile_sizes = [[], [1, 0], [0, 16]], native_vector_size = []>
+func @row_sum_not_divisible(%input: tensor<1x100xf32>, %init: tensor<1xf32>) -> tensor<1xf32> {
+  %0 = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+      iterator_types = ["parallel", "reduction"]}
+      ins(%input : tensor<1x100xf32>) outs(%init : tensor<1xf32>)
+      attrs = {lowering.config = #config} {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %1 = arith.addf %arg0, %arg1 : f32
+      linalg.yield %1 : f32
+    } -> tensor<1xf32>
+  return %0 : tensor<1xf32>
+}
+// CHECK-LABEL: func @row_sum_not_divisible
+//   CHECK-NOT:   scf.for
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       lowering.config
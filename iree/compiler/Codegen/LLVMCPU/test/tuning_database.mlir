@@ -0,0 +1,71 @@
+// RUN: rm -f %t
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{test-lowering-configuration=true}))' --iree-codegen-tuning-database-record=%t %s -o /dev/null
+// RUN: FileCheck %s --check-prefix=RECORD --input-file=%t
+// RUN: sed -e 's/\[4,4,60\]/[4,8,60]/' -e 's/"workload_per_wg":\[8,28\]/"workload_per_wg":[16,28]/' %t > %t.tuned
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{test-lowering-configuration=true}))' --iree-codegen-tuning-database=%t.tuned %s | FileCheck %s
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @matmul_static {
+  hal.executable.variant public @system_elf_arm_64, target = <"llvm", "system-elf-arm_64", {
+    data_layout = "e-m:e-i8:8:32-i16:16:32-i64:64-i128:128-n32:64-S128",
+    native_vector_size = 16 : index,
+    target_triple = "aarch64-none-linux-android30"
+  }> {
+    hal.executable.entry_point public @matmul_static layout(#executable_layout)
+    builtin.module {
+      func @matmul_static() {
+        %cst = arith.constant 0.000000e+00 : f32
+        %c196 = arith.constant 196 : index
+        %c40 = arith.constant 40 : index
+        %c0 = arith.constant 0 : index
+        %c8 = arith.constant 8 : index
+        %c28 = arith.constant 28 : index
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:196x240xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:240x40xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<writeonly:196x40xf32>
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_y, %workgroup_size_y]
+        %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_y, %workgroup_size_y]
+        scf.for %arg0 = %3 to %c196 step %4 {
+          %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+          %6 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+          scf.for %arg1 = %5 to %c40 step %6 {
+            %7 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [28, 240], strides = [1, 1] : !flow.dispatch.tensor<readonly:196x240xf32> -> tensor<28x240xf32>
+            %8 = tensor.cast %7 : tensor<28x240xf32> to tensor<?x240xf32>
+            %9 = flow.dispatch.tensor.load %1, offsets = [0, %arg1], sizes = [240, 8], strides = [1, 1] : !flow.dispatch.tensor<readonly:240x40xf32> -> tensor<240x8xf32>
+            %10 = tensor.cast %9 : tensor<240x8xf32> to tensor<240x?xf32>
+            %11 = linalg.init_tensor [%c28, %c8] : tensor<?x?xf32>
+            %12 = linalg.fill(%cst, %11) : f32, tensor<?x?xf32> -> tensor<?x?xf32>
+            %13 = linalg.matmul ins(%8, %10 : tensor<?x240xf32>, tensor<240x?xf32>) outs(%12 : tensor<?x?xf32>) -> tensor<?x?xf32>
+            flow.dispatch.tensor.store %13, %2, offsets = [%arg0, %arg1], sizes = [%c28, %c8], strides = [1, 1] : tensor<?x?xf32> -> !flow.dispatch.tensor<writeonly:196x40xf32>
+          }
+        }
+        return
+      }
+
+// RECORD: {"dispatch":"matmul_static",
+// RECORD-SAME: "key":"linalg.matmul{{.*}} {arith.mulf, arith.addf, linalg.yield} in (linalg.fill, linalg.matmul)",
+// RECORD-SAME: "native_vector_size":[4,4,4],
+// RECORD-SAME: "pass_pipeline":"CPUTileFuseAndVectorize",
+// RECORD-SAME: "target":"#hal.executable.target<\"llvm\", \"system-elf-arm_64\"
+// RECORD-SAME: "tile_sizes":{{\[}}[],[4,4,60],[4,4,4]],
+// RECORD-SAME: "workgroup_size":[],
+// RECORD-SAME: "workload_per_wg":[8,28]}
+
+//   CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[], [4, 8, 60], [4, 4, 4]{{\]}}, native_vector_size = [4, 4, 4]>
+//   CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"CPUTileFuseAndVectorize", workload_per_wg = [16, 28]>
+//       CHECK: hal.executable.entry_point public @matmul_static
+//  CHECK-SAME:     translation.info = #[[TRANSLATION]]
+//       CHECK: linalg.matmul
+//  CHECK-SAME:     lowering.config = #[[CONFIG]]
@@ -1,5 +1,8 @@
 // RUN: iree-opt -iree-llvmcpu-vector-contract-custom-kernels='arch=aarch64' %s | FileCheck %s -check-prefix=AARCH64-BASELINE
 // RUN: iree-opt -iree-llvmcpu-vector-contract-custom-kernels='arch=aarch64 features=+dotprod' %s | FileCheck %s -check-prefix=AARCH64-DOTPROD
+// RUN: iree-opt -iree-llvmcpu-vector-contract-custom-kernels='arch=aarch64 features=+dotprod,+i8mm' %s | FileCheck %s -check-prefix=AARCH64-I8MM
+// RUN: iree-opt -iree-llvmcpu-vector-contract-custom-kernels='arch=aarch64 features=+bf16' %s | FileCheck %s -check-prefix=AARCH64-BF16
+// RUN: iree-opt -iree-llvmcpu-vector-contract-custom-kernels='arch=aarch64 features=+fullfp16' %s | FileCheck %s -check-prefix=AARCH64-FULLFP16
 
 // There are two parts to this test: the "deep" part and the "wide part".
 
@@ -297,3 +300,67 @@ func @mmt_1x4x8_i8i8i32_vecmat(
 // AARCH64-DOTPROD-SAME:      {{((.*sdot){2})}}
 // AARCH64-DOTPROD-SAME:      "{{(\=w,){2}(w,){3}0,1}}"
 // AARCH64-DOTPROD-SAME:      {{\((vector<16xi8>, ){2}(vector<4xi8>, ){1}(vector<4xi32>(, )?){2}\)}}
+
+// -----
+func @mmt_8x8x8_i8i8i32(
+    %lhs: vector<8x8xi8>,
+    %rhs: vector<8x8xi8>,
+    %acc: vector<8x8xi32>) -> vector<8x8xi32> {
+  %lhs_wide = arith.extsi %lhs : vector<8x8xi8> to vector<8x8xi32>
+  %rhs_wide = arith.extsi %rhs : vector<8x8xi8> to vector<8x8xi32>
+  %res = vector.contract {
+      indexing_maps = [
+          affine_map<(d0, d1, d2) -> (d0, d2)>,
+          affine_map<(d0, d1, d2) -> (d1, d2)>,
+          affine_map<(d0, d1, d2) -> (d0, d1)>
+      ], iterator_types = ["parallel", "parallel", "reduction"], kind = #vector.kind<add>
+  } %lhs_wide, %rhs_wide, %acc : vector<8x8xi32>, vector<8x8xi32> into vector<8x8xi32>
+  return %res : vector<8x8xi32>
+}
+// AARCH64-I8MM-LABEL:  @mmt_8x8x8_i8i8i32(
+// AARCH64-I8MM:     llvm.inline_asm
+// AARCH64-I8MM-SAME:      {{((.*zip1.*zip2.*zip1.*zip2(.*smmla){4}.*zip1.*zip2.*zip1.*zip2){4})}}
+// AARCH64-I8MM-SAME:      "{{(\=w,){16}(w,){8}0,1,.*,15}},~{v28},~{v29},~{v30},~{v31}"
+// AARCH64-I8MM-SAME:      {{\((vector<16xi8>, ){8}(vector<4xi32>(, )?){16}\)}}
+
+// -----
+func @mmt_8x4x8_bf16bf16f32(
+    %lhs: vector<8x4xbf16>,
+    %rhs: vector<8x4xbf16>,
+    %acc: vector<8x8xf32>) -> vector<8x8xf32> {
+  %lhs_wide = arith.extf %lhs : vector<8x4xbf16> to vector<8x4xf32>
+  %rhs_wide = arith.extf %rhs : vector<8x4xbf16> to vector<8x4xf32>
+  %res = vector.contract {
+      indexing_maps = [
+          affine_map<(d0, d1, d2) -> (d0, d2)>,
+          affine_map<(d0, d1, d2) -> (d1, d2)>,
+          affine_map<(d0, d1, d2) -> (d0, d1)>
+      ], iterator_types = ["parallel", "parallel", "reduction"], kind = #vector.kind<add>
+  } %lhs_wide, %rhs_wide, %acc : vector<8x4xf32>, vector<8x4xf32> into vector<8x8xf32>
+  return %res : vector<8x8xf32>
+}
+// AARCH64-BF16-LABEL:  @mmt_8x4x8_bf16bf16f32(
+// AARCH64-BF16:     llvm.inline_asm
+// AARCH64-BF16-SAME:      {{((.*bfmmla){16})}}
+// AARCH64-BF16-SAME:      "{{(\=w,){16}(w,){8}0,1,.*,15}},~{v28},~{v29},~{v30},~{v31}"
+// AARCH64-BF16-SAME:      {{\((vector<8xbf16>, ){8}(vector<4xf32>(, )?){16}\)}}
+
+// -----
+func @mmt_8x1x8_f16f16f16(
+    %lhs: vector<8x1xf16>,
+    %rhs: vector<8x1xf16>,
+    %acc: vector<8x8xf16>) -> vector<8x8xf16> {
+  %res = vector.contract {
+      indexing_maps = [
+          affine_map<(d0, d1, d2) -> (d0, d2)>,
+          affine_map<(d0, d1, d2) -> (d1, d2)>,
+          affine_map<(d0, d1, d2) -> (d0, d1)>
+      ], iterator_types = ["parallel", "parallel", "reduction"], kind = #vector.kind<add>
+  } %lhs, %rhs, %acc : vector<8x1xf16>, vector<8x1xf16> into vector<8x8xf16>
+  return %res : vector<8x8xf16>
+}
+// AARCH64-FULLFP16-LABEL:  @mmt_8x1x8_f16f16f16(
+// AARCH64-FULLFP16:     llvm.inline_asm
+// AARCH64-FULLFP16-SAME:      {{(mov.*(.*fmla){8})}}
+// AARCH64-FULLFP16-SAME:      "{{(\=w,){8}(w,){2}0,1,.*,7}},~{v15}"
+// AARCH64-FULLFP16-SAME:      {{\((vector<8xf16>, ){2}(vector<8xf16>(, )?){8}\)}}
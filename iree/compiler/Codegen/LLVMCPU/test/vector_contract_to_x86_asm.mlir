@@ -0,0 +1,27 @@
+// RUN: iree-opt -iree-llvmcpu-vector-contract-custom-kernels='arch=x86_64' %s | FileCheck %s -check-prefix=X86-64-BASELINE
+// RUN: iree-opt -iree-llvmcpu-vector-contract-custom-kernels='arch=x86_64 features=+avx512vnni' %s | FileCheck %s -check-prefix=X86-64-AVX512VNNI
+
+// -----
+func @mmt_16x4x16_i8i8i32(
+    %lhs: vector<16x4xi8>,
+    %rhs: vector<16x4xi8>,
+    %acc: vector<16x16xi32>) -> vector<16x16xi32> {
+  %lhs_wide = arith.extsi %lhs : vector<16x4xi8> to vector<16x4xi32>
+  %rhs_wide = arith.extsi %rhs : vector<16x4xi8> to vector<16x4xi32>
+  %res = vector.contract {
+      indexing_maps = [
+          affine_map<(d0, d1, d2) -> (d0, d2)>,
+          affine_map<(d0, d1, d2) -> (d1, d2)>,
+          affine_map<(d0, d1, d2) -> (d0, d1)>
+      ], iterator_types = ["parallel", "parallel", "reduction"], kind = #vector.kind<add>
+  } %lhs_wide, %rhs_wide, %acc : vector<16x4xi32>, vector<16x4xi32> into vector<16x16xi32>
+  return %res : vector<16x16xi32>
+}
+// X86-64-BASELINE-LABEL:  @mmt_16x4x16_i8i8i32(
+// X86-64-BASELINE-NOT:     llvm.inline_asm
+// X86-64-BASELINE:         vector.contract
+// X86-64-AVX512VNNI-LABEL:  @mmt_16x4x16_i8i8i32(
+// X86-64-AVX512VNNI:     llvm.inline_asm
+// X86-64-AVX512VNNI-SAME:      {{((.*vpdpbusd){17})}}
+// X86-64-AVX512VNNI-SAME:      "{{(\=v,){16}(v,){2}0,1,.*,15}},~{eax},~{zmm28},~{zmm29},~{zmm30},~{zmm31}"
+// X86-64-AVX512VNNI-SAME:      {{\((vector<64xi8>, ){2}(vector<16xi32>(, )?){16}\)}}
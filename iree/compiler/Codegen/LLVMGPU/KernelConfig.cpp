@@ -9,6 +9,7 @@
 #include <numeric>
 
 #include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtOps.h"
+#include "iree/compiler/Codegen/Common/TuningDatabase.h"
 #include "iree/compiler/Codegen/Dialect/LoweringConfig.h"
 #include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
 #include "llvm/Support/Debug.h"
@@ -189,10 +190,17 @@ static LogicalResult setContractConfig(FuncOp entryPoint, linalg::LinalgOp op) {
         if (sizeK % config.tileSize[2] == 0 &&
             sizeN % config.tileSize[1] == 0 &&
             sizeM % config.tileSize[0] == 0) {
+          // Overlap the copies to workgroup memory with the computation over
+          // several iterations when the reduction is long enough.
+          auto pipeline = IREE::Codegen::DispatchLoweringPassPipeline::
+              LLVMGPUMatmulTensorCore;
+          if (sizeK / config.tileSize[2] >= kTensorCoreMultiStageDepth) {
+            pipeline = IREE::Codegen::DispatchLoweringPassPipeline::
+                LLVMGPUMatmulTensorCoreMultiStage;
+          }
           return setMatmulConfig(config.tileSize[0], config.tileSize[1],
                                  config.tileSize[2], config.workgroupSize,
-                                 IREE::Codegen::DispatchLoweringPassPipeline::
-                                     LLVMGPUMatmulTensorCore);
+                                 pipeline);
         }
       }
     }
@@ -257,6 +265,22 @@ static LogicalResult setFftConfig(FuncOp entryPoint,
       workgroupSize);
 }
 
+/// Each invocation computes the online softmax of one query row, such that
+/// the keys and values are read once per workgroup and shared by its
+/// invocations.
+static LogicalResult setAttentionConfig(FuncOp entryPoint,
+                                        IREE::LinalgExt::AttentionOp op) {
+  std::array<int64_t, 3> workgroupSize = {2 * cudaWarpSize, 1, 1};
+  SmallVector<int64_t> workgroupTileSizes = {1, workgroupSize[0]};
+  TileSizesListType tileSizes = {workgroupTileSizes};
+  return setOpConfigAndEntryPointFnTranslation(
+      entryPoint, op, tileSizes, /*nativeVectorSizes=*/ArrayRef<int64_t>{},
+      IREE::Codegen::DispatchLoweringPassPipeline::LLVMGPUDistribute,
+      workgroupSize);
+}
+
+/// Sort and top-k are serial along their sorted dimension; each invocation
+/// handles one slice along the innermost partitionable loop.
 static LogicalResult setSortConfig(FuncOp entryPoint, Operation *op) {
   TileSizesListType tileSizes;
   auto interfaceOp = cast<IREE::Flow::PartitionableLoopsInterface>(*op);
@@ -405,8 +429,11 @@ static LogicalResult setRootConfig(FuncOp entryPointFn, Operation *computeOp) {
   if (auto fftOp = dyn_cast<IREE::LinalgExt::FftOp>(computeOp)) {
     return setFftConfig(entryPointFn, fftOp);
   }
-  if (auto sortOp = dyn_cast<IREE::LinalgExt::SortOp>(computeOp)) {
-    return setSortConfig(entryPointFn, sortOp);
+  if (auto attentionOp = dyn_cast<IREE::LinalgExt::AttentionOp>(computeOp)) {
+    return setAttentionConfig(entryPointFn, attentionOp);
+  }
+  if (isa<IREE::LinalgExt::SortOp, IREE::LinalgExt::TopkOp>(computeOp)) {
+    return setSortConfig(entryPointFn, computeOp);
   }
   return setRootDefaultConfig(entryPointFn, computeOp);
 }
@@ -427,6 +454,9 @@ LogicalResult initGPULaunchConfig(ModuleOp moduleOp) {
     if (failed(getComputeOps(funcOp, computeOps, tiledLoops))) {
       return funcOp.emitOpError("failed to get compute ops");
     }
+    if (failed(applyTuningDatabaseConfig(funcOp, computeOps))) {
+      return failure();
+    }
 
     if (computeOps.empty()) {
       std::array<int64_t, 3> workgroupSize = {1, 1, 1};
@@ -500,6 +530,9 @@ LogicalResult initGPULaunchConfig(ModuleOp moduleOp) {
       if (op == rootOperation) continue;
       setLoweringConfig(op, config);
     }
+    if (failed(recordTuningDatabaseConfig(funcOp, rootOperation, computeOps))) {
+      return failure();
+    }
   }
   return success();
 }
@@ -12,6 +12,10 @@
 namespace mlir {
 namespace iree_compiler {
 
+/// Number of stages of the main loop of the LLVMGPUMatmulTensorCoreMultiStage
+/// pipeline.
+static constexpr unsigned kTensorCoreMultiStageDepth = 3;
+
 LogicalResult initGPULaunchConfig(ModuleOp moduleOp);
 
 }  // namespace iree_compiler
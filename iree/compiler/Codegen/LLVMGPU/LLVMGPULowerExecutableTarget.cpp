@@ -151,6 +151,11 @@ void LLVMGPULowerExecutableTargetPass::runOnOperation() {
       case IREE::Codegen::DispatchLoweringPassPipeline::LLVMGPUMatmulTensorCore:
         addGPUMatmulTensorCorePassPipeline(nestedModulePM);
         break;
+      case IREE::Codegen::DispatchLoweringPassPipeline::
+          LLVMGPUMatmulTensorCoreMultiStage:
+        addGPUMatmulTensorCorePassPipeline(nestedModulePM,
+                                           kTensorCoreMultiStageDepth);
+        break;
       default:
         llvm_unreachable("Unsupported pipeline on GPU target.");
     }
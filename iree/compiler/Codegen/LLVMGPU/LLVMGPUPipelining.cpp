@@ -7,9 +7,14 @@
 #include "iree/compiler/Codegen/PassDetail.h"
 #include "iree/compiler/Codegen/Passes.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
 #include "mlir/Dialect/GPU/Passes.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/Transforms.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/Support/MathExtras.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
 //====---------------------------------------------------------------------===//
@@ -21,6 +26,8 @@ namespace iree_compiler {
 
 static const StringLiteral kPipeliningLoopMarker = "__pipelining_K_loop__";
 static const StringLiteral kPipeliningGlobalLoad = "__pipelining_global_load__";
+static const StringLiteral kPipeliningSharedStore =
+    "__pipelining_shared_store__";
 
 /// Helper to recursively add operation dependencies within `block` to `dep`
 /// set.
@@ -33,45 +40,160 @@ static void addDepOps(llvm::SmallDenseSet<Operation*>& dep, Operation* op,
   }
 }
 
-/// Assign stages to the loop ops. Simple logic for now, put load from global
-/// memory in stage 0 and the rest in stage 1.
+/// Assign stages to the loop ops. With two stages, put load from global memory
+/// in stage 0 and the rest in stage 1. With more stages, put the store to
+/// shared memory in stage 1 and the computation in the last stage so that
+/// several copies are in flight while computing on an earlier one.
 static void getPipelineStages(
     scf::ForOp forOp, std::vector<std::pair<Operation*, unsigned>>& ops) {
-  if (!forOp->hasAttr(kPipeliningLoopMarker)) return;
+  auto depthAttr = forOp->getAttrOfType<IntegerAttr>(kPipeliningLoopMarker);
+  if (!depthAttr) return;
+  int64_t lastStage = depthAttr.getInt() - 1;
 
-  // Track dependencies of the global memory load.
+  // Track dependencies of the global memory load and of the shared memory
+  // store.
   llvm::SmallDenseSet<Operation*> loadDep;
+  llvm::SmallDenseSet<Operation*> storeDep;
   for (Operation& op : forOp.getBody()->getOperations()) {
     if (op.hasAttr(kPipeliningGlobalLoad)) {
       addDepOps(loadDep, &op, forOp.getBody());
     }
   }
+  if (lastStage > 1) {
+    for (Operation& op : forOp.getBody()->getOperations()) {
+      if (op.hasAttr(kPipeliningSharedStore)) {
+        addDepOps(storeDep, &op, forOp.getBody());
+      }
+    }
+  }
+  auto getStage = [&](Operation& op) -> int64_t {
+    if (loadDep.count(&op)) return 0;
+    if (storeDep.count(&op)) return 1;
+    return lastStage;
+  };
   // Create a modulo schedule with loads from global memory and the operations
-  // it depends on in stage 0. Store to shared memory and computation are in
-  // stage 1. In order to have a correct scheduling even with back edges we
-  // order stages in decreasing order.
-  for (Operation& op : forOp.getBody()->getOperations()) {
-    if (!loadDep.count(&op) && !isa<scf::YieldOp>(op))
-      ops.push_back(std::make_pair(&op, 1));
+  // it depends on in stage 0. Stores to shared memory and computation follow.
+  // In order to have a correct scheduling even with back edges we order
+  // stages in decreasing order.
+  for (int64_t stage = lastStage; stage >= 0; --stage) {
+    for (Operation& op : forOp.getBody()->getOperations()) {
+      if (getStage(op) == stage && !isa<scf::YieldOp>(op)) {
+        ops.push_back(std::make_pair(&op, stage));
+      }
+    }
   }
+}
+
+/// Returns the number of iterations of `forOp` if it is static.
+static Optional<int64_t> getStaticTripCount(scf::ForOp forOp) {
+  Optional<int64_t> lb = getConstantIntValue(forOp.getLowerBound());
+  Optional<int64_t> ub = getConstantIntValue(forOp.getUpperBound());
+  Optional<int64_t> step = getConstantIntValue(forOp.getStep());
+  if (!lb || !ub || !step || *step <= 0) return llvm::None;
+  return std::max<int64_t>(0, ceilDiv(*ub - *lb, *step));
+}
+
+/// Returns the workgroup memory allocations accessed within `forOp` if they
+/// can all be multi-buffered: they need to be statically shaped, only be
+/// accessed within the body of `forOp` and only through ops that don't derive
+/// a type from the accessed memref.
+static Optional<SmallVector<memref::AllocOp>> getMultiBufferableAllocs(
+    scf::ForOp forOp) {
+  SetVector<Operation*> allocs;
   for (Operation& op : forOp.getBody()->getOperations()) {
-    if (loadDep.count(&op)) ops.push_back(std::make_pair(&op, 0));
+    for (Value operand : op.getOperands()) {
+      auto memrefType = operand.getType().dyn_cast<MemRefType>();
+      if (!memrefType || memrefType.getMemorySpaceAsInt() != 3) continue;
+      auto allocOp = operand.getDefiningOp<memref::AllocOp>();
+      if (!allocOp || !memrefType.hasStaticShape()) return llvm::None;
+      allocs.insert(allocOp);
+    }
   }
+  SmallVector<memref::AllocOp> result;
+  for (Operation* allocOp : allocs) {
+    for (Operation* user : allocOp->getUsers()) {
+      if (user->getBlock() != forOp.getBody() ||
+          !isa<vector::TransferReadOp, vector::TransferWriteOp, memref::LoadOp,
+               memref::StoreOp, gpu::SubgroupMmaLoadMatrixOp>(user)) {
+        return llvm::None;
+      }
+    }
+    result.push_back(cast<memref::AllocOp>(allocOp));
+  }
+  return result;
+}
+
+/// Replaces `allocOp` by an allocation with `numBuffers` copies of it, and
+/// each of its uses within `forOp` by a subview of the copy used by the
+/// iteration it belongs to.
+static void multiBufferAlloc(memref::AllocOp allocOp, scf::ForOp forOp,
+                             unsigned numBuffers) {
+  MemRefType type = allocOp.getType();
+  SmallVector<int64_t> shape = {numBuffers};
+  shape.append(type.getShape().begin(), type.getShape().end());
+  auto multiBufferType = MemRefType::get(shape, type.getElementType(), {},
+                                         type.getMemorySpaceAsInt());
+  OpBuilder builder(allocOp);
+  Value multiBuffer = builder.create<memref::AllocOp>(
+      allocOp.getLoc(), multiBufferType, allocOp.alignmentAttr());
+
+  // The trip count is static so the lower bound and step are constants.
+  int64_t lb = *getConstantIntValue(forOp.getLowerBound());
+  int64_t step = *getConstantIntValue(forOp.getStep());
+  AffineExpr iv = builder.getAffineDimExpr(0);
+  AffineMap bufferIndexMap =
+      AffineMap::get(1, 0, ((iv - lb).floorDiv(step)) % numBuffers);
+
+  SmallVector<OpFoldResult> sizes = {builder.getIndexAttr(1)};
+  for (int64_t size : type.getShape()) {
+    sizes.push_back(builder.getIndexAttr(size));
+  }
+  SmallVector<OpFoldResult> strides(shape.size(), builder.getIndexAttr(1));
+  for (OpOperand& use : llvm::make_early_inc_range(allocOp->getUses())) {
+    // Each use gets its own index computation so that the pipeliner is able
+    // to place it in the stage of the use.
+    Operation* user = use.getOwner();
+    builder.setInsertionPoint(user);
+    Value bufferIndex = builder.create<AffineApplyOp>(
+        user->getLoc(), bufferIndexMap, forOp.getInductionVar());
+    SmallVector<OpFoldResult> offsets(shape.size(), builder.getIndexAttr(0));
+    offsets[0] = bufferIndex;
+    auto subviewType = memref::SubViewOp::inferRankReducedResultType(
+                           type.getRank(), multiBufferType, offsets, sizes,
+                           strides)
+                           .cast<MemRefType>();
+    Value subview = builder.create<memref::SubViewOp>(
+        user->getLoc(), subviewType, multiBuffer, offsets, sizes, strides);
+    use.set(subview);
+  }
+  allocOp.erase();
 }
 
 namespace {
 struct LLVMGPUPipeliningPass
     : public LLVMGPUPipeliningBase<LLVMGPUPipeliningPass> {
+  LLVMGPUPipeliningPass(unsigned depth) { this->depth = depth; }
+  LLVMGPUPipeliningPass(const LLVMGPUPipeliningPass& pass) {
+    depth = pass.depth;
+  }
+
   void runOnOperation() override {
+    if (depth < 2) return;
     auto funcOp = getOperation();
     MLIRContext* context = &getContext();
-    // Mark the loop with shared memory copy for pipelining.
-    funcOp.walk([](scf::ForOp forOp) {
+    // Mark the loop with shared memory copy for pipelining. Loops are gathered
+    // first as multi-buffering rewrites allocations outside of them.
+    SmallVector<scf::ForOp> forOps;
+    funcOp.walk([&](scf::ForOp forOp) { forOps.push_back(forOp); });
+    for (scf::ForOp forOp : forOps) {
       bool copyToWorkgroupMemory = false;
       OpBuilder builder(forOp.getContext());
       for (Operation& op : forOp.getBody()->getOperations()) {
         // Pipeline the most inner for op that should be a flat region.
-        if (op.getNumRegions() > 0) return;
+        if (op.getNumRegions() > 0) {
+          copyToWorkgroupMemory = false;
+          break;
+        }
         auto ld = dyn_cast<vector::TransferReadOp>(op);
         if (!ld) continue;
         unsigned ldAddSpace =
@@ -85,11 +207,28 @@ struct LLVMGPUPipeliningPass
         if (stAddSpace != 3) continue;
         copyToWorkgroupMemory = true;
         ld->setAttr(kPipeliningGlobalLoad, builder.getUnitAttr());
+        st->setAttr(kPipeliningSharedStore, builder.getUnitAttr());
       }
-      if (copyToWorkgroupMemory) {
-        forOp->setAttr(kPipeliningLoopMarker, builder.getUnitAttr());
+      if (!copyToWorkgroupMemory) continue;
+
+      // Going beyond two stages requires a copy of the workgroup memory for
+      // each iteration in flight between the store and the computation.
+      // Fall back to two stages when that isn't possible.
+      unsigned loopDepth = 2;
+      Optional<int64_t> tripCount = getStaticTripCount(forOp);
+      Optional<SmallVector<memref::AllocOp>> allocs;
+      if (depth > 2 && tripCount && *tripCount >= depth) {
+        allocs = getMultiBufferableAllocs(forOp);
+      }
+      if (allocs) {
+        loopDepth = depth;
+        for (memref::AllocOp allocOp : *allocs) {
+          multiBufferAlloc(allocOp, forOp, loopDepth - 1);
+        }
       }
-    });
+      forOp->setAttr(kPipeliningLoopMarker,
+                     builder.getI64IntegerAttr(loopDepth));
+    }
     scf::PipeliningOption options;
     options.getScheduleFn = getPipelineStages;
     RewritePatternSet pipeliningPatterns(context);
@@ -102,8 +241,9 @@ struct LLVMGPUPipeliningPass
 };
 }  // namespace
 
-std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass() {
-  return std::make_unique<LLVMGPUPipeliningPass>();
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass(
+    unsigned depth) {
+  return std::make_unique<LLVMGPUPipeliningPass>(depth);
 }
 
 }  // namespace iree_compiler
@@ -0,0 +1,128 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Interfaces/CallInterfaces.h"
+#include "mlir/Interfaces/ViewLikeInterface.h"
+
+//====---------------------------------------------------------------------===//
+// Pass to pad workgroup memory allocations to reduce bank conflicts.
+//====---------------------------------------------------------------------===//
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Returns true if the uses of `value`, looking through subviews, are able to
+/// access it through a different layout.
+static bool canChangeLayout(Value value) {
+  for (Operation *user : value.getUsers()) {
+    if (auto subviewOp = dyn_cast<memref::SubViewOp>(user)) {
+      if (!canChangeLayout(subviewOp.result())) return false;
+      continue;
+    }
+    if (isa<ViewLikeOpInterface>(user) || isa<CallOpInterface>(user) ||
+        isa<ReturnOp>(user)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Replaces the uses of `oldValue` by `newValue`, recreating the subviews of
+/// `oldValue` so that their result type follows the layout of `newValue`.
+static void replaceUsesAndPropagateLayout(OpBuilder &builder, Value oldValue,
+                                          Value newValue) {
+  for (OpOperand &use : llvm::make_early_inc_range(oldValue.getUses())) {
+    auto subviewOp = dyn_cast<memref::SubViewOp>(use.getOwner());
+    if (!subviewOp) {
+      use.set(newValue);
+      continue;
+    }
+    builder.setInsertionPoint(subviewOp);
+    auto sourceType = newValue.getType().cast<MemRefType>();
+    auto resultType = memref::SubViewOp::inferRankReducedResultType(
+                          subviewOp.getType().getRank(), sourceType,
+                          extractFromI64ArrayAttr(subviewOp.static_offsets()),
+                          extractFromI64ArrayAttr(subviewOp.static_sizes()),
+                          extractFromI64ArrayAttr(subviewOp.static_strides()))
+                          .cast<MemRefType>();
+    Value newSubview = builder.create<memref::SubViewOp>(
+        subviewOp.getLoc(), resultType, newValue, subviewOp.getMixedOffsets(),
+        subviewOp.getMixedSizes(), subviewOp.getMixedStrides());
+    replaceUsesAndPropagateLayout(builder, subviewOp.result(), newSubview);
+    subviewOp.erase();
+  }
+}
+
+/// Pads the innermost dimension of `allocOp` by `paddingBits` so that
+/// consecutive rows start on different banks, and replaces its uses by a
+/// subview of the padded allocation.
+static void padAlloc(memref::AllocOp allocOp, unsigned paddingBits) {
+  MemRefType type = allocOp.getType();
+  int64_t padding =
+      std::max<int64_t>(1, paddingBits / type.getElementTypeBitWidth());
+  SmallVector<int64_t> paddedShape(type.getShape().begin(),
+                                   type.getShape().end());
+  paddedShape.back() += padding;
+  auto paddedType = MemRefType::get(paddedShape, type.getElementType(), {},
+                                    type.getMemorySpaceAsInt());
+  OpBuilder builder(allocOp);
+  Value paddedAlloc = builder.create<memref::AllocOp>(
+      allocOp.getLoc(), paddedType, allocOp.alignmentAttr());
+
+  SmallVector<OpFoldResult> offsets(type.getRank(), builder.getIndexAttr(0));
+  SmallVector<OpFoldResult> sizes;
+  for (int64_t size : type.getShape()) {
+    sizes.push_back(builder.getIndexAttr(size));
+  }
+  SmallVector<OpFoldResult> strides(type.getRank(), builder.getIndexAttr(1));
+  Value subview = builder.create<memref::SubViewOp>(
+      allocOp.getLoc(), paddedAlloc, offsets, sizes, strides);
+  replaceUsesAndPropagateLayout(builder, allocOp.getResult(), subview);
+  allocOp.erase();
+}
+
+namespace {
+struct LLVMGPUReduceBankConflictsPass
+    : public LLVMGPUReduceBankConflictsBase<LLVMGPUReduceBankConflictsPass> {
+  LLVMGPUReduceBankConflictsPass(unsigned paddingBits) {
+    this->paddingBits = paddingBits;
+  }
+  LLVMGPUReduceBankConflictsPass(const LLVMGPUReduceBankConflictsPass &pass) {
+    paddingBits = pass.paddingBits;
+  }
+
+  void runOnOperation() override {
+    if (paddingBits == 0) return;
+    auto funcOp = getOperation();
+    SmallVector<memref::AllocOp> allocs;
+    funcOp.walk([&](memref::AllocOp allocOp) {
+      MemRefType type = allocOp.getType();
+      // Only rows of multi-dimensional allocations conflict with each other.
+      if (type.getMemorySpaceAsInt() == 3 && type.getRank() >= 2 &&
+          type.hasStaticShape() && type.getLayout().isIdentity() &&
+          type.getElementType().isIntOrFloat() &&
+          canChangeLayout(allocOp.getResult())) {
+        allocs.push_back(allocOp);
+      }
+    });
+    for (memref::AllocOp allocOp : allocs) padAlloc(allocOp, paddingBits);
+  }
+};
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUReduceBankConflictsPass(
+    unsigned paddingBits) {
+  return std::make_unique<LLVMGPUReduceBankConflictsPass>(paddingBits);
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -109,7 +109,8 @@ void addGPUMatmulSimtPassPipeline(OpPassManager &pm) {
   pm.addNestedPass<FuncOp>(createLLVMGPUPipeliningPass());
 }
 
-void addGPUMatmulTensorCorePassPipeline(OpPassManager &pm) {
+void addGPUMatmulTensorCorePassPipeline(OpPassManager &pm,
+                                        unsigned pipelineDepth) {
   //===--------------------------------------------------------------------===//
   // Initial clean up.
   //===--------------------------------------------------------------------===//
@@ -120,6 +121,11 @@ void addGPUMatmulTensorCorePassPipeline(OpPassManager &pm) {
   pm.addNestedPass<FuncOp>(
       createLLVMGPUTileAndDistribute(/*distributeToWarp=*/true));
   pm.addNestedPass<FuncOp>(createLLVMGPUDistributeSharedMemoryCopy());
+  if (pipelineDepth > 2) {
+    // Pad workgroup memory so that the MMA loads of consecutive rows don't
+    // conflict.
+    pm.addNestedPass<FuncOp>(createLLVMGPUReduceBankConflictsPass());
+  }
   pm.addPass(createCanonicalizerPass());
   pm.addPass(createCSEPass());
 
@@ -138,7 +144,7 @@ void addGPUMatmulTensorCorePassPipeline(OpPassManager &pm) {
   pm.addPass(createCSEPass());
 
   // Pipeline memory operations.
-  pm.addNestedPass<FuncOp>(createLLVMGPUPipeliningPass());
+  pm.addNestedPass<FuncOp>(createLLVMGPUPipeliningPass(pipelineDepth));
 }
 
 void addGPUSimpleDistributePassPipeline(OpPassManager &pm) {
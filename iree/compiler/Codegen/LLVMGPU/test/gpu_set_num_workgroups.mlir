@@ -113,6 +113,64 @@ hal.executable private @dot_dispatch_1  {
 
 // -----
 
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @dot_tensorcore_dispatch  {
+  hal.executable.variant @cuda, target = <"cuda", "cuda-nvptx-fb", {target_arch = "sm_80"}> {
+    hal.executable.entry_point @dot_tensorcore_dispatch layout(#executable_layout)
+    builtin.module {
+      func @dot_tensorcore_dispatch() {
+        %c0 = arith.constant 0 : index
+        %c64 = arith.constant 64 : index
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<64x128xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<128x64xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : memref<64x64xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_y, %workgroup_size_y]
+        %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_y, %workgroup_size_y]
+        scf.for %arg0 = %3 to %c64 step %4 {
+          %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+          %6 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+          scf.for %arg1 = %5 to %c64 step %6 {
+            %7 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 64)>(%arg0)[%workgroup_size_y]
+            %8 = memref.subview %0[%arg0, 0] [%7, 128] [1, 1] : memref<64x128xf32> to memref<?x128xf32, affine_map<(d0, d1)[s0] -> (d0 * 128 + s0 + d1)>>
+            %9 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 64)>(%arg1)[%workgroup_size_x]
+            %10 = memref.subview %1[0, %arg1] [128, %9] [1, 1] : memref<128x64xf32> to memref<128x?xf32, affine_map<(d0, d1)[s0] -> (d0 * 64 + s0 + d1)>>
+            %11 = memref.subview %2[%arg0, %arg1] [%7, %9] [1, 1] : memref<64x64xf32> to memref<?x?xf32, affine_map<(d0, d1)[s0] -> (d0 * 64 + s0 + d1)>>
+            linalg.fill(%cst, %11) : f32, memref<?x?xf32, affine_map<(d0, d1)[s0] -> (d0 * 64 + s0 + d1)>>
+            linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%8, %10 : memref<?x128xf32, affine_map<(d0, d1)[s0] -> (d0 * 128 + s0 + d1)>>, memref<128x?xf32, affine_map<(d0, d1)[s0] -> (d0 * 64 + s0 + d1)>>) outs(%11 : memref<?x?xf32, affine_map<(d0, d1)[s0] -> (d0 * 64 + s0 + d1)>>)
+          }
+        }
+        return
+      }
+    }
+  }
+}
+
+// The reduction spans 8 tiles so the copies to workgroup memory are pipelined
+// over several stages.
+//  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[32, 32, 16]{{\]}}, native_vector_size = []>
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"LLVMGPUMatmulTensorCoreMultiStage", workload_per_wg = [32, 32]>
+//      CHECK: hal.executable.entry_point public @dot_tensorcore_dispatch
+// CHECK-SAME:     translation.info = #[[TRANSLATION]]
+// CHECK-SAME:     workgroup_size = [64 : index, 2 : index, 1 : index]
+//      CHECK: func @dot_tensorcore_dispatch
+//      CHECK:   linalg.matmul
+// CHECK-SAME:       lowering.config = #[[CONFIG]]
+
+// -----
+
 #executable_layout = #hal.executable.layout<push_constants = 0, sets = [
   #hal.descriptor_set.layout<0, bindings = [
     #hal.descriptor_set.binding<0, storage_buffer>,
@@ -508,3 +566,99 @@ hal.executable private @sort_op {
 //       CHECK: func @sort_op()
 //       CHECK:   iree_linalg_ext.sort
 //  CHECK-SAME:     lowering.config = #[[CONFIG]]
+
+// -----
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @topk_op {
+  hal.executable.variant public @cuda_nvptx_fb, target = <"cuda", "cuda-nvptx-fb", {target_arch = "sm_35"}> {
+    hal.executable.entry_point public @topk_op layout(#executable_layout)
+    builtin.module {
+      func @topk_op() {
+        %c512 = arith.constant 512 : index
+        %c0 = arith.constant 0 : index
+        %cst = arith.constant 0xFF800000 : f32
+        %c0_i32 = arith.constant 0 : i32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) alignment(32) : !flow.dispatch.tensor<readonly:512x1024xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) alignment(32) : !flow.dispatch.tensor<writeonly:512x4xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) alignment(32) : !flow.dispatch.tensor<writeonly:512x4xi32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %3 = affine.apply affine_map<()[s0, s1] -> (s1 * s0)>()[%workgroup_size_x, %workgroup_id_x]
+        %4 = affine.apply affine_map<()[s0, s1] -> (s1 * s0)>()[%workgroup_size_x, %workgroup_count_x]
+        scf.for %arg0 = %3 to %c512 step %4 {
+          %5 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 512)>(%arg0)[%workgroup_size_x]
+          %6 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%5, 1024], strides = [1, 1] : !flow.dispatch.tensor<readonly:512x1024xf32> -> tensor<?x1024xf32>
+          %7 = linalg.init_tensor [%5, 4] : tensor<?x4xf32>
+          %8 = linalg.fill(%cst, %7) : f32, tensor<?x4xf32> -> tensor<?x4xf32>
+          %9 = linalg.init_tensor [%5, 4] : tensor<?x4xi32>
+          %10 = linalg.fill(%c0_i32, %9) : i32, tensor<?x4xi32> -> tensor<?x4xi32>
+          %11:2 = iree_linalg_ext.topk dimension(1) ins(%6 : tensor<?x1024xf32>) outs(%8, %10 : tensor<?x4xf32>, tensor<?x4xi32>) {
+          ^bb0(%arg1: f32, %arg2: f32):
+            %12 = arith.cmpf ogt, %arg1, %arg2 : f32
+            iree_linalg_ext.yield %12 : i1
+          } -> tensor<?x4xf32>, tensor<?x4xi32>
+          flow.dispatch.tensor.store %11#0, %1, offsets = [%arg0, 0], sizes = [%5, 4], strides = [1, 1] : tensor<?x4xf32> -> !flow.dispatch.tensor<writeonly:512x4xf32>
+          flow.dispatch.tensor.store %11#1, %2, offsets = [%arg0, 0], sizes = [%5, 4], strides = [1, 1] : tensor<?x4xi32> -> !flow.dispatch.tensor<writeonly:512x4xi32>
+        }
+        return
+      }
+    }
+  }
+}
+
+//   CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[64]{{\]}}, native_vector_size = []>
+//   CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"LLVMGPUDistribute", workload_per_wg = [64]>
+//       CHECK: hal.executable.entry_point public @topk_op
+//  CHECK-SAME:   translation.info = #[[TRANSLATION]]
+//  CHECK-SAME:   workgroup_size = [64 : index, 1 : index, 1 : index]
+//       CHECK: func @topk_op()
+//       CHECK:   iree_linalg_ext.topk
+//  CHECK-SAME:     lowering.config = #[[CONFIG]]
+
+// -----
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>,
+    #hal.descriptor_set.binding<3, storage_buffer>
+  ]>
+]>
+hal.executable private @attention {
+  hal.executable.variant @cuda, target = <"cuda", "cuda-nvptx-fb"> {
+    hal.executable.entry_point @attention layout(#executable_layout)
+    builtin.module {
+      builtin.func @attention() {
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:8x1024x64xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:8x1024x64xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<readonly:8x1024x64xf32>
+        %3 = hal.interface.binding.subspan set(0) binding(3) type(storage_buffer) : !flow.dispatch.tensor<writeonly:8x1024x64xf32>
+        %4 = flow.dispatch.tensor.load %0, offsets = [0, 0, 0], sizes = [8, 1024, 64], strides = [1, 1, 1] : !flow.dispatch.tensor<readonly:8x1024x64xf32> -> tensor<8x1024x64xf32>
+        %5 = flow.dispatch.tensor.load %1, offsets = [0, 0, 0], sizes = [8, 1024, 64], strides = [1, 1, 1] : !flow.dispatch.tensor<readonly:8x1024x64xf32> -> tensor<8x1024x64xf32>
+        %6 = flow.dispatch.tensor.load %2, offsets = [0, 0, 0], sizes = [8, 1024, 64], strides = [1, 1, 1] : !flow.dispatch.tensor<readonly:8x1024x64xf32> -> tensor<8x1024x64xf32>
+        %7 = linalg.init_tensor [8, 1024, 64] : tensor<8x1024x64xf32>
+        %8 = iree_linalg_ext.attention ins(%4, %5, %6 : tensor<8x1024x64xf32>, tensor<8x1024x64xf32>, tensor<8x1024x64xf32>) outs(%7 : tensor<8x1024x64xf32>) -> tensor<8x1024x64xf32>
+        flow.dispatch.tensor.store %8, %3, offsets = [0, 0, 0], sizes = [8, 1024, 64], strides = [1, 1, 1] : tensor<8x1024x64xf32> -> !flow.dispatch.tensor<writeonly:8x1024x64xf32>
+        return
+      }
+    }
+  }
+}
+
+//   CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[1, 64]{{\]}}, native_vector_size = []>
+//   CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"LLVMGPUDistribute", workload_per_wg = [64, 1]>
+//       CHECK: hal.executable.entry_point public @attention
+//  CHECK-SAME:   translation.info = #[[TRANSLATION]]
+//  CHECK-SAME:   workgroup_size = [64 : index, 1 : index, 1 : index]
+//       CHECK: func @attention()
+//       CHECK:   iree_linalg_ext.attention
+//  CHECK-SAME:     lowering.config = #[[CONFIG]]
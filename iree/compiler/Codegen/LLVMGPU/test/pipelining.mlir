@@ -0,0 +1,61 @@
+// RUN: iree-opt -iree-llvmgpu-pipelining %s | FileCheck %s
+// RUN: iree-opt -iree-llvmgpu-pipelining='depth=3' %s | FileCheck %s -check-prefix=MULTISTAGE
+
+func @copy_and_compute(%in: memref<128x32xf32>, %out: memref<32xf32>) {
+  %c0 = arith.constant 0 : index
+  %c4 = arith.constant 4 : index
+  %c128 = arith.constant 128 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  %init = arith.constant dense<0.000000e+00> : vector<4xf32>
+  %shared = memref.alloc() : memref<4x32xf32, 3>
+  %tid = gpu.thread_id x
+  %result = scf.for %k = %c0 to %c128 step %c4 iter_args(%acc = %init) -> (vector<4xf32>) {
+    gpu.barrier
+    %0 = vector.transfer_read %in[%k, %tid], %cst {in_bounds = [true]} : memref<128x32xf32>, vector<4xf32>
+    vector.transfer_write %0, %shared[%c0, %tid] {in_bounds = [true]} : vector<4xf32>, memref<4x32xf32, 3>
+    gpu.barrier
+    %1 = vector.transfer_read %shared[%c0, %tid], %cst {in_bounds = [true]} : memref<4x32xf32, 3>, vector<4xf32>
+    %2 = arith.addf %acc, %1 : vector<4xf32>
+    scf.yield %2 : vector<4xf32>
+  }
+  vector.transfer_write %result, %out[%c0] {in_bounds = [true]} : vector<4xf32>, memref<32xf32>
+  return
+}
+
+// Two stages: the load of the next iteration is issued before the store to
+// workgroup memory and the computation of the current one.
+//   CHECK-LABEL: func @copy_and_compute
+//         CHECK:   %[[SHARED:.+]] = memref.alloc() : memref<4x32xf32, 3>
+//         CHECK:   %[[LD0:.+]] = vector.transfer_read %{{.+}} : memref<128x32xf32>, vector<4xf32>
+//         CHECK:   scf.for {{.+}} iter_args(%{{.+}} = %{{.+}}, %[[LD:.+]] = %[[LD0]])
+//         CHECK:     gpu.barrier
+//         CHECK:     vector.transfer_write %[[LD]], %[[SHARED]]
+//         CHECK:     gpu.barrier
+//         CHECK:     vector.transfer_read %[[SHARED]]
+//         CHECK:     arith.addf
+//         CHECK:     vector.transfer_read %{{.+}} : memref<128x32xf32>, vector<4xf32>
+//         CHECK:     scf.yield
+//         CHECK:   gpu.barrier
+//         CHECK:   vector.transfer_write %{{.+}}, %[[SHARED]]
+//         CHECK:   gpu.barrier
+//         CHECK:   vector.transfer_read %[[SHARED]]
+//         CHECK:   arith.addf
+
+// Three stages: workgroup memory is double buffered so that the store of the
+// next iteration doesn't wait for the computation of the current one.
+//   MULTISTAGE-LABEL: func @copy_and_compute
+//         MULTISTAGE:   %[[SHARED:.+]] = memref.alloc() : memref<2x4x32xf32, 3>
+//         MULTISTAGE:   %[[LD0:.+]] = vector.transfer_read %{{.+}} : memref<128x32xf32>, vector<4xf32>
+//         MULTISTAGE:   %[[ST0:.+]] = memref.subview %[[SHARED]]
+//         MULTISTAGE:   vector.transfer_write %[[LD0]], %[[ST0]]
+//         MULTISTAGE:   %[[LD1:.+]] = vector.transfer_read %{{.+}} : memref<128x32xf32>, vector<4xf32>
+//         MULTISTAGE:   scf.for {{.+}} iter_args(%{{.+}} = %{{.+}}, %[[LD:.+]] = %[[LD1]])
+//         MULTISTAGE:     gpu.barrier
+//         MULTISTAGE:     gpu.barrier
+//         MULTISTAGE:     %[[READ:.+]] = memref.subview %[[SHARED]]
+//         MULTISTAGE:     vector.transfer_read %[[READ]]
+//         MULTISTAGE:     arith.addf
+//         MULTISTAGE:     %[[WRITE:.+]] = memref.subview %[[SHARED]]
+//         MULTISTAGE:     vector.transfer_write %[[LD]], %[[WRITE]]
+//         MULTISTAGE:     vector.transfer_read %{{.+}} : memref<128x32xf32>, vector<4xf32>
+//         MULTISTAGE:     scf.yield
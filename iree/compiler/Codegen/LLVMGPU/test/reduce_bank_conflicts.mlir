@@ -0,0 +1,42 @@
+// RUN: iree-opt -iree-llvmgpu-reduce-bank-conflicts -split-input-file %s | FileCheck %s
+
+#map = affine_map<(d0, d1) -> (d0 * 128 + d1)>
+func @pad_alloc(%out: memref<4xf32>) {
+  %c0 = arith.constant 0 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = memref.alloc() : memref<4x32x128xf32, 3>
+  %1 = memref.subview %0[0, 0, 0] [1, 32, 128] [1, 1, 1] : memref<4x32x128xf32, 3> to memref<32x128xf32, #map, 3>
+  %2 = vector.transfer_read %1[%c0, %c0], %cst {in_bounds = [true]} : memref<32x128xf32, #map, 3>, vector<4xf32>
+  vector.transfer_write %2, %out[%c0] {in_bounds = [true]} : vector<4xf32>, memref<4xf32>
+  return
+}
+
+//   CHECK-DAG: #[[$PADDED:.+]] = affine_map<(d0, d1, d2) -> (d0 * 4224 + d1 * 132 + d2)>
+//   CHECK-DAG: #[[$PADDED_ROWS:.+]] = affine_map<(d0, d1) -> (d0 * 132 + d1)>
+// CHECK-LABEL: func @pad_alloc
+//       CHECK:   %[[ALLOC:.+]] = memref.alloc() : memref<4x32x132xf32, 3>
+//       CHECK:   %[[PADDED:.+]] = memref.subview %[[ALLOC]][0, 0, 0] [4, 32, 128] [1, 1, 1]
+//  CHECK-SAME:     to memref<4x32x128xf32, #[[$PADDED]], 3>
+//       CHECK:   %[[ROWS:.+]] = memref.subview %[[PADDED]][0, 0, 0] [1, 32, 128] [1, 1, 1]
+//  CHECK-SAME:     to memref<32x128xf32, #[[$PADDED_ROWS]], 3>
+//       CHECK:   vector.transfer_read %[[ROWS]]
+
+// -----
+
+func private @external(memref<32x128xf16, 3>)
+
+func @skip_alloc(%out: memref<4xf32>) {
+  %c0 = arith.constant 0 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = memref.alloc() : memref<128xf32, 3>
+  %1 = vector.transfer_read %0[%c0], %cst {in_bounds = [true]} : memref<128xf32, 3>, vector<4xf32>
+  vector.transfer_write %1, %out[%c0] {in_bounds = [true]} : vector<4xf32>, memref<4xf32>
+  %2 = memref.alloc() : memref<32x128xf16, 3>
+  call @external(%2) : (memref<32x128xf16, 3>) -> ()
+  return
+}
+
+// Single rows and escaping allocations are left untouched.
+// CHECK-LABEL: func @skip_alloc
+//       CHECK:   memref.alloc() : memref<128xf32, 3>
+//       CHECK:   memref.alloc() : memref<32x128xf16, 3>
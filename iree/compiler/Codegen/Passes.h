@@ -126,8 +126,11 @@ createSetNumWorkgroupsPass(ArrayRef<int64_t> workgroupSize = {});
 /// Pass to optimize vector transfer_read and transfer_write.
 std::unique_ptr<OperationPass<FuncOp>> createOptimizeVectorTransferPass();
 
-/// Pass to convert math operations to their polynomial approximation.
-std::unique_ptr<OperationPass<>> createPolynomialApproximationPass();
+/// Pass to convert math operations to their polynomial approximation. With
+/// `fastMath`, f32 math operations use cheaper approximations with bounded
+/// errors instead.
+std::unique_ptr<OperationPass<>> createPolynomialApproximationPass(
+    bool fastMath = false);
 
 /// Creates a pass to convert memref.copy to linalg op.
 std::unique_ptr<OperationPass<FuncOp>> createMemrefCopyToLinalgPass();
@@ -140,6 +143,13 @@ std::unique_ptr<OperationPass<FuncOp>> createMemrefCopyToLinalgPass();
 void populateFoldAffineMinInDistributedLoopsPatterns(
     RewritePatternSet &patterns);
 
+/// Populates `patterns` with the fast approximations of f32 math operations,
+/// which take precedence over the polynomial approximations. With
+/// `nativeMath`, only the operations without a native GPU instruction are
+/// approximated.
+void populateFastMathApproximationPatterns(RewritePatternSet &patterns,
+                                           bool nativeMath);
+
 /// Populates `patterns` with a very specific pattern that vectorizes a
 /// linalg.conv op for a single thread. The linalg.conv should compute on
 /// static-sized subviews. To match, output shape must be 1x1xWoxCo, where Co
@@ -168,6 +178,10 @@ createLLVMCPUCheckIRBeforeLLVMConversionPass();
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
 createLLVMCPULowerExecutableTargetPass();
 
+/// Splits innermost reductions into loops accumulating vector-wide partial
+/// results, followed by a reduction of the partial results.
+std::unique_ptr<OperationPass<FuncOp>> createLLVMCPUSplitReductionPass();
+
 /// Synchronizes LLVM linkage with MLIR symbol visibility.
 std::unique_ptr<OperationPass<ModuleOp>>
 createLLVMCPUSynchronizeSymbolVisibilityPass();
@@ -253,8 +267,10 @@ LogicalResult verifyGPUMatmulSimtPassPipeline(
     ArrayRef<int64_t> workgroupSize = {});
 void addGPUMatmulSimtPassPipeline(OpPassManager &pm);
 
-/// Lowering using tensorcore operations.
-void addGPUMatmulTensorCorePassPipeline(OpPassManager &pm);
+/// Lowering using tensorcore operations. The main loop is software pipelined
+/// with `pipelineDepth` stages.
+void addGPUMatmulTensorCorePassPipeline(OpPassManager &pm,
+                                        unsigned pipelineDepth = 2);
 
 /// Simple lowering only distributute linalg ops on blocks and threads. This
 /// will result in scalar operations. Expects pass manager to be a module-level
@@ -294,8 +310,14 @@ std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUVectorLoweringPass();
 std::unique_ptr<OperationPass<FuncOp>>
 createLLVMGPUDistributeSharedMemoryCopy();
 
-/// Apply software pipelining.
-std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass();
+/// Apply software pipelining with `depth` stages.
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass(
+    unsigned depth = 2);
+
+/// Pad workgroup memory allocations by `paddingBits` along their innermost
+/// dimension to reduce bank conflicts.
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUReduceBankConflictsPass(
+    unsigned paddingBits = 128);
 
 //------------------------------------------------------------------------------
 // SPIR-V Passes
@@ -322,6 +344,11 @@ void addSPIRVTileAndVectorizePassPipeline(OpPassManager &pm);
 /// performs distribution to threads with vectorization.
 void addSPIRVTileAndVectorizeToCooperativeOpsPassPipeline(OpPassManager &pm);
 
+/// Pass pipeline to lower IREE HAL executables with workgroup tiled and
+/// distributed reductions to SPIR-V code that spreads each reduction across
+/// the invocations of a workgroup and combines them with subgroup operations.
+void addSPIRVSubgroupReducePassPipeline(OpPassManager &pm);
+
 /// Pass to perform the final conversion to SPIR-V dialect.
 ///
 /// This pass converts remaining interface ops into SPIR-V global variables,
@@ -354,6 +381,10 @@ createSPIRVTileAndVectorizeToCooperativeOpsPass();
 /// cooperative matrix ops when possible.
 std::unique_ptr<OperationPass<FuncOp>> createSPIRVVectorToCooperativeOpsPass();
 
+/// Pass to spread sum reductions with buffer semantics across the invocations
+/// of a workgroup and combine their partial results with subgroup operations.
+std::unique_ptr<OperationPass<FuncOp>> createSPIRVSubgroupReducePass();
+
 /// Pass to tile Linalg ops with tensor semantics to invocations.
 std::unique_ptr<OperationPass<FuncOp>> createSPIRVTilePass();
 
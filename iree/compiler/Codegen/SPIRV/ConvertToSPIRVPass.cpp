@@ -25,6 +25,7 @@
 #include "llvm/ADT/DenseMapInfo.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "mlir/Conversion/ArithmeticToSPIRV/ArithmeticToSPIRV.h"
 #include "mlir/Conversion/GPUToSPIRV/GPUToSPIRV.h"
@@ -40,6 +41,7 @@
 #include "mlir/Dialect/SPIRV/IR/SPIRVDialect.h"
 #include "mlir/Dialect/SPIRV/IR/SPIRVOps.h"
 #include "mlir/Dialect/SPIRV/IR/SPIRVTypes.h"
+#include "mlir/Dialect/SPIRV/IR/TargetAndABI.h"
 #include "mlir/Dialect/SPIRV/Transforms/SPIRVConversion.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Vector/IR/VectorOps.h"
@@ -48,6 +50,7 @@
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/TypeUtilities.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Support/LogicalResult.h"
 #include "mlir/Transforms/DialectConversion.h"
@@ -147,6 +150,185 @@ InterfaceResourceMap createResourceVariables(mlir::ModuleOp module) {
   return interfaceToResourceVars;
 }
 
+//===----------------------------------------------------------------------===//
+// Specialization constant utilities
+//===----------------------------------------------------------------------===//
+
+/// Returns the spv.SpecConstant named `name` in the module containing `op`,
+/// creating it with `specId` and `defaultValue` if it does not yet exist.
+spirv::SpecConstantOp getOrCreateSpecConstant(Operation *op, StringRef name,
+                                              uint32_t specId,
+                                              Attribute defaultValue) {
+  auto moduleOp = op->getParentOfType<ModuleOp>();
+  if (auto specOp = moduleOp.lookupSymbol<spirv::SpecConstantOp>(name)) {
+    return specOp;
+  }
+  auto builder = OpBuilder::atBlockBegin(moduleOp.getBody());
+  auto specOp =
+      builder.create<spirv::SpecConstantOp>(op->getLoc(), name, defaultValue);
+  specOp->setAttr(
+      spirv::SPIRVDialect::getAttributeName(spirv::Decoration::SpecId),
+      builder.getI32IntegerAttr(specId));
+  return specOp;
+}
+
+//===----------------------------------------------------------------------===//
+// Buffer device address utilities
+//===----------------------------------------------------------------------===//
+
+/// Returns the layout of the entry point in the executable variant containing
+/// `op`.
+IREE::HAL::ExecutableLayoutAttr getExecutableLayout(Operation *op) {
+  // TODO(#1519): this should look up the entry point information of the
+  // function containing `op`.
+  auto variantOp = op->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  auto entryPointOps = llvm::to_vector<1>(
+      variantOp.getOps<IREE::HAL::ExecutableEntryPointOp>());
+  assert(entryPointOps.size() == 1);
+  return entryPointOps.front().layout();
+}
+
+/// Returns the number of binding address slots reserved for `setLayoutAttr`:
+/// one for each binding ordinal up to the largest one used. Must match
+/// iree_hal_vulkan_native_descriptor_set_layout_binding_capacity.
+int64_t getBindingAddressCapacity(
+    IREE::HAL::DescriptorSetLayoutAttr setLayoutAttr) {
+  int64_t capacity = 0;
+  for (auto bindingAttr : setLayoutAttr.getBindings()) {
+    capacity = std::max(capacity, bindingAttr.getOrdinal() + 1);
+  }
+  return capacity;
+}
+
+/// Returns the index of the first 32-bit push constant word holding binding
+/// addresses. Addresses follow the user push constants aligned to 8 bytes.
+int64_t getBindingAddressBaseIndex(
+    IREE::HAL::ExecutableLayoutAttr layoutAttr) {
+  return llvm::alignTo(layoutAttr.getPushConstants(), 2);
+}
+
+/// Returns the total number of 32-bit push constant words used by executables
+/// with `layoutAttr`, including binding addresses if enabled.
+int64_t getPushConstantWordCount(IREE::HAL::ExecutableLayoutAttr layoutAttr,
+                                 bool useBufferDeviceAddresses) {
+  if (!useBufferDeviceAddresses) return layoutAttr.getPushConstants();
+  int64_t slotCount = 0;
+  for (auto setLayoutAttr : layoutAttr.getSetLayouts()) {
+    slotCount += getBindingAddressCapacity(setLayoutAttr);
+  }
+  return getBindingAddressBaseIndex(layoutAttr) + 2 * slotCount;
+}
+
+/// Returns the index of the push constant word holding the low 32 bits of the
+/// address of (`set`, `binding`); the high bits are in the following word.
+/// Sets are assigned slots in ordinal order as done by the Vulkan HAL.
+int64_t getBindingAddressIndex(IREE::HAL::ExecutableLayoutAttr layoutAttr,
+                               int64_t set, int64_t binding) {
+  int64_t slot = binding;
+  for (auto setLayoutAttr : layoutAttr.getSetLayouts()) {
+    if (setLayoutAttr.getOrdinal() < set) {
+      slot += getBindingAddressCapacity(setLayoutAttr);
+    }
+  }
+  return getBindingAddressBaseIndex(layoutAttr) + 2 * slot;
+}
+
+/// Marks `op` accessing a PhysicalStorageBuffer pointer to `valueType` as
+/// aligned to the size of its scalar elements, as required by SPIR-V.
+void setAlignedMemoryAccess(Operation *op, Type valueType) {
+  Builder builder(op->getContext());
+  unsigned bitWidth = getElementTypeOrSelf(valueType).getIntOrFloatBitWidth();
+  op->setAttr(spirv::attributeName<spirv::MemoryAccess>(),
+              builder.getI32IntegerAttr(
+                  static_cast<uint32_t>(spirv::MemoryAccess::Aligned)));
+  op->setAttr("alignment",
+              builder.getI32IntegerAttr(std::max(bitWidth / 8, 1u)));
+}
+
+/// Moves all users of `pointer`, which must be a PhysicalStorageBuffer pointer,
+/// into the PhysicalStorageBuffer storage class.
+LogicalResult updatePhysicalStorageBufferUsers(Value pointer) {
+  for (Operation *user : llvm::make_early_inc_range(pointer.getUsers())) {
+    if (auto accessChainOp = dyn_cast<spirv::AccessChainOp>(user)) {
+      auto resultType =
+          accessChainOp.getType().cast<spirv::PointerType>().getPointeeType();
+      accessChainOp.getResult().setType(spirv::PointerType::get(
+          resultType, spirv::StorageClass::PhysicalStorageBuffer));
+      if (failed(updatePhysicalStorageBufferUsers(accessChainOp.getResult()))) {
+        return failure();
+      }
+    } else if (auto loadOp = dyn_cast<spirv::LoadOp>(user)) {
+      setAlignedMemoryAccess(loadOp, loadOp.getType());
+    } else if (auto storeOp = dyn_cast<spirv::StoreOp>(user)) {
+      setAlignedMemoryAccess(storeOp, storeOp.value().getType());
+    } else {
+      return user->emitOpError(
+          "unsupported use of a binding with buffer device addresses");
+    }
+  }
+  return success();
+}
+
+/// Replaces all uses of the resource variables in `moduleOp` with pointers
+/// built from the buffer device addresses passed as push constants.
+LogicalResult convertResourcesToBufferDeviceAddresses(ModuleOp moduleOp) {
+  auto layoutAttr = getExecutableLayout(moduleOp);
+  int64_t wordCount =
+      getPushConstantWordCount(layoutAttr, /*useBufferDeviceAddresses=*/true);
+  StringRef setAttrName =
+      spirv::SPIRVDialect::getAttributeName(spirv::Decoration::DescriptorSet);
+  StringRef bindingAttrName =
+      spirv::SPIRVDialect::getAttributeName(spirv::Decoration::Binding);
+
+  SmallVector<spirv::AddressOfOp> addressOfOps;
+  moduleOp.walk([&](spirv::AddressOfOp addressOfOp) {
+    addressOfOps.push_back(addressOfOp);
+  });
+  for (auto addressOfOp : addressOfOps) {
+    auto varOp = SymbolTable::lookupNearestSymbolFrom<spirv::GlobalVariableOp>(
+        addressOfOp, addressOfOp.variableAttr());
+    if (!varOp) continue;
+    auto setAttr = varOp->getAttrOfType<IntegerAttr>(setAttrName);
+    auto bindingAttr = varOp->getAttrOfType<IntegerAttr>(bindingAttrName);
+    if (!setAttr || !bindingAttr) continue;
+
+    OpBuilder builder(addressOfOp);
+    Location loc = addressOfOp.getLoc();
+    auto i32Type = builder.getIntegerType(32);
+    auto i64Type = builder.getIntegerType(64);
+    int64_t index = getBindingAddressIndex(layoutAttr, setAttr.getInt(),
+                                           bindingAttr.getInt());
+    Value lo = spirv::getPushConstantValue(addressOfOp, wordCount, index,
+                                           i32Type, builder);
+    Value hi = spirv::getPushConstantValue(addressOfOp, wordCount, index + 1,
+                                           i32Type, builder);
+    lo = builder.create<spirv::UConvertOp>(loc, i64Type, lo);
+    hi = builder.create<spirv::UConvertOp>(loc, i64Type, hi);
+    Value shift = builder.create<spirv::ConstantOp>(
+        loc, i64Type, builder.getI64IntegerAttr(32));
+    hi = builder.create<spirv::ShiftLeftLogicalOp>(loc, i64Type, hi, shift);
+    Value address = builder.create<spirv::BitwiseOrOp>(loc, i64Type, lo, hi);
+
+    auto pointeeType =
+        addressOfOp.getType().cast<spirv::PointerType>().getPointeeType();
+    Value pointer = builder.create<spirv::ConvertUToPtrOp>(
+        loc,
+        spirv::PointerType::get(pointeeType,
+                                spirv::StorageClass::PhysicalStorageBuffer),
+        address);
+    addressOfOp.getResult().replaceAllUsesWith(pointer);
+    addressOfOp.erase();
+    if (failed(updatePhysicalStorageBufferUsers(pointer))) return failure();
+  }
+
+  // The resource variables are no longer referenced.
+  for (auto varOp : llvm::make_early_inc_range(
+           moduleOp.getOps<spirv::GlobalVariableOp>())) {
+    if (varOp->hasAttr(bindingAttrName)) varOp.erase();
+  }
+  return success();
+}
+
 }  // namespace
 
 //===----------------------------------------------------------------------===//
@@ -163,22 +345,39 @@ struct HALInterfaceLoadConstantConverter final
   LogicalResult matchAndRewrite(
       IREE::HAL::InterfaceConstantLoadOp loadOp, OpAdaptor adaptor,
       ConversionPatternRewriter &rewriter) const override {
-    // TODO(#1519): this conversion should look up the entry point information
-    // to get the total push constant count.
-    auto variantOp = loadOp->getParentOfType<IREE::HAL::ExecutableVariantOp>();
-    auto entryPointOps = llvm::to_vector<1>(
-        variantOp.getOps<IREE::HAL::ExecutableEntryPointOp>());
-    assert(entryPointOps.size() == 1);
-    auto layoutAttr = entryPointOps.front().layout();
-
-    uint64_t elementCount = layoutAttr.getPushConstants();
+    // All push constant loads must agree on the size of the push constant
+    // block, which includes binding addresses when they are used.
+    auto layoutAttr = getExecutableLayout(loadOp);
+    uint64_t elementCount = getPushConstantWordCount(
+        layoutAttr, usesSPIRVBufferDeviceAddresses(loadOp));
     unsigned index = loadOp.index().getZExtValue();
 
     // The following function generates SPIR-V ops with i32 types. So it does
     // type "conversion" (index -> i32) implicitly.
     auto i32Type = rewriter.getIntegerType(32);
-    auto value = spirv::getPushConstantValue(loadOp, elementCount, index,
-                                             i32Type, rewriter);
+    Value value = spirv::getPushConstantValue(loadOp, elementCount, index,
+                                              i32Type, rewriter);
+
+    // Read the value from a specialization constant in pipelines the runtime
+    // specialized for it. The select folds away once specialized.
+    if (index < kMaxSpecializedPushConstants &&
+        usesSPIRVSpecializedPushConstants(loadOp)) {
+      Location loc = loadOp.getLoc();
+      auto specializedOp = getOrCreateSpecConstant(
+          loadOp, "__push_constants_specialized__", /*specId=*/0,
+          rewriter.getBoolAttr(false));
+      auto specValueOp = getOrCreateSpecConstant(
+          loadOp, llvm::formatv("__push_constant_{0}__", index).str(),
+          /*specId=*/index + 1, rewriter.getI32IntegerAttr(0));
+      Value specialized = rewriter.create<spirv::ReferenceOfOp>(
+          loc, rewriter.getI1Type(),
+          SymbolRefAttr::get(rewriter.getContext(), specializedOp.sym_name()));
+      Value specValue = rewriter.create<spirv::ReferenceOfOp>(
+          loc, i32Type,
+          SymbolRefAttr::get(rewriter.getContext(), specValueOp.sym_name()));
+      value = rewriter.create<spirv::SelectOp>(loc, specialized, specValue,
+                                               value);
+    }
 
     rewriter.replaceOp(loadOp, value);
     return success();
@@ -324,6 +523,18 @@ void ConvertToSPIRVPass::runOnOperation() {
 
   spirv::TargetEnvAttr targetAttr = getSPIRVTargetEnvAttr(moduleOp);
   moduleOp->setAttr(spirv::getTargetEnvAttrName(), targetAttr);
+
+  bool useBufferDeviceAddresses = usesSPIRVBufferDeviceAddresses(moduleOp);
+  if (useBufferDeviceAddresses) {
+    spirv::TargetEnv targetEnv(targetAttr);
+    if (!targetEnv.allows(spirv::Capability::PhysicalStorageBufferAddresses) ||
+        !targetEnv.allows(spirv::Capability::Int64)) {
+      moduleOp.emitError(
+          "buffer device addresses require the PhysicalStorageBufferAddresses "
+          "and Int64 capabilities in the target environment");
+      return signalPassFailure();
+    }
+  }
   SPIRVTypeConverter typeConverter(targetAttr);
   RewritePatternSet patterns(&getContext());
   ScfToSPIRVContext scfToSPIRVContext;
@@ -411,10 +622,19 @@ void ConvertToSPIRVPass::runOnOperation() {
     }
   }
 
+  // Bindings are accessed through pointers built from the push constants
+  // instead of the descriptor set variables.
+  if (useBufferDeviceAddresses &&
+      failed(convertResourcesToBufferDeviceAddresses(moduleOp))) {
+    return signalPassFailure();
+  }
+
   // Collect all SPIR-V ops into a spv.module.
   auto builder = OpBuilder::atBlockBegin(moduleOp.getBody());
   auto spvModule = builder.create<spirv::ModuleOp>(
-      moduleOp.getLoc(), spirv::AddressingModel::Logical,
+      moduleOp.getLoc(),
+      useBufferDeviceAddresses ? spirv::AddressingModel::PhysicalStorageBuffer64
+                               : spirv::AddressingModel::Logical,
       spirv::MemoryModel::GLSL450);
   Block *body = spvModule.getBody();
   Dialect *spvDialect = spvModule->getDialect();
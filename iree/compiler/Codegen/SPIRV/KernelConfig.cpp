@@ -7,6 +7,7 @@
 #include "iree/compiler/Codegen/SPIRV/KernelConfig.h"
 
 #include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtOps.h"
+#include "iree/compiler/Codegen/Common/TuningDatabase.h"
 #include "iree/compiler/Codegen/Dialect/LoweringConfig.h"
 #include "iree/compiler/Codegen/SPIRV/Utils.h"
 #include "iree/compiler/Codegen/Transforms/Transforms.h"
@@ -258,6 +259,139 @@ LogicalResult setMatmulOpConfig(linalg::LinalgOp op,
 
 }  // namespace detail
 
+//===----------------------------------------------------------------------===//
+// Cooperative Matrix Default Configuration
+//===----------------------------------------------------------------------===//
+
+namespace detail {
+
+struct CooperativeMatrixSize {
+  int64_t m;
+  int64_t n;
+  int64_t k;
+};
+
+/// Returns the cooperative matrix (M, N, K) sizes that are supported by the
+/// target environment and match the given parameters.
+static Optional<CooperativeMatrixSize> getCooperativeMatrixSize(
+    spirv::ResourceLimitsAttr resourceLimits, Type lhsType, Type rhsType,
+    Type resultType, int64_t m, int64_t n, int64_t k) {
+  auto properties = resourceLimits.cooperative_matrix_properties_nv()
+                        .getAsRange<spirv::CooperativeMatrixPropertiesNVAttr>();
+  for (auto property : properties) {
+    if (property.a_type().getValue() == lhsType &&
+        property.b_type().getValue() == rhsType &&
+        property.c_type().getValue() == resultType &&
+        property.result_type().getValue() == resultType &&
+        property.scope().getValue() == spirv::Scope::Subgroup) {
+      int64_t matmulM = property.m_size().getValue().getZExtValue();
+      int64_t matmulN = property.n_size().getValue().getZExtValue();
+      int64_t matmulK = property.k_size().getValue().getZExtValue();
+      if (m % matmulM == 0 && n % matmulN == 0 && k % matmulK == 0) {
+        return CooperativeMatrixSize{matmulM, matmulN, matmulK};
+      }
+    }
+  }
+  return llvm::None;
+}
+
+LogicalResult setCooperativeMatrixConfig(const spirv::TargetEnv &targetEnv,
+                                         linalg::MatmulOp op) {
+  // This configuration is only for cooperative matrix.
+  if (!targetEnv.allows(spirv::Capability::CooperativeMatrixNV) ||
+      !targetEnv.allows(spirv::Extension::SPV_NV_cooperative_matrix)) {
+    return success();
+  }
+
+  Value lhs = op.inputs()[0], rhs = op.inputs()[1], init = op.outputs()[0];
+
+  ArrayRef<int64_t> lhsShape = getUntiledShape(lhs);
+  ArrayRef<int64_t> rhsShape = getUntiledShape(rhs);
+  if (llvm::any_of(lhsShape, ShapedType::isDynamic)) return success();
+  if (llvm::any_of(rhsShape, ShapedType::isDynamic)) return success();
+
+  // TODO: Cooperative matrix support is fairly restricted. We can only have
+  // a curated list of fused element wise ops as defined in the extension
+  // SPV_NV_cooperative_matrix. Check that once we move bufferization after
+  // vectorization.
+
+  auto getElementType = [](Value v) {
+    return v.getType().cast<ShapedType>().getElementType();
+  };
+
+  // The accumulation type follows the matmul result type, so f16 matmuls
+  // accumulate in f16 when the target lists such a configuration.
+  auto resourceLimits = targetEnv.getResourceLimits();
+  auto coopMatSize = getCooperativeMatrixSize(
+      resourceLimits, getElementType(lhs), getElementType(rhs),
+      getElementType(init), lhsShape[0], rhsShape[1], lhsShape[1]);
+  if (!coopMatSize) return success();
+
+  auto pipeline = IREE::Codegen::DispatchLoweringPassPipeline::
+      SPIRVVectorizeToCooperativeOps;
+
+  // For now only support one subgroup per workgroup because in the above
+  // configuration deduction step we only consider whether the input workload is
+  // perfectly divisible by some native cooperative matrix size.
+  //
+  // TODO: Use some heuristics to deduce how many subgroups should be used and
+  // the tile sizes for each subgroup, considering the input workload size and
+  // native cooperative matrix size choices.
+  int64_t subgroupSize = resourceLimits.subgroup_size().getInt();
+  std::array<int64_t, 3> workgroupSize = {subgroupSize, 1, 1};
+
+  TileSizesListType tileSizes;
+  // Again because we only consider whether the input workload is perfectly
+  // divisible by some native cooperative matrix size, not some multiples of it,
+  // need to make sure the subgroup tile sizes are the same as the workgroup
+  // one.
+  tileSizes.push_back({coopMatSize->m, coopMatSize->n, coopMatSize->k});
+  tileSizes.push_back({coopMatSize->m, coopMatSize->n, coopMatSize->k});
+
+  return setOpConfigAndEntryPointFnTranslation(op->getParentOfType<FuncOp>(),
+                                               op, tileSizes, {}, pipeline,
+                                               workgroupSize);
+}
+
+}  // namespace detail
+
+//===----------------------------------------------------------------------===//
+// Subgroup Reduction Default Configuration
+//===----------------------------------------------------------------------===//
+
+/// Sets the configuration spreading each reduction of `op` across the
+/// invocations of a workgroup, which are combined with subgroup operations.
+/// Does nothing if `op` is not a sum along its innermost loop or if the target
+/// does not support subgroup arithmetic.
+static LogicalResult setSubgroupReductionConfig(
+    const spirv::TargetEnv &targetEnv, linalg::GenericOp op) {
+  if (!targetEnv.allows(spirv::Capability::GroupNonUniformArithmetic) ||
+      !getSubgroupReductionCombiner(op)) {
+    return success();
+  }
+
+  // The reduction is not tiled at the Flow level so its size is static when
+  // the original one is. Use a serial loop for reductions too short to give
+  // every invocation some work.
+  const int64_t subgroupSize =
+      targetEnv.getResourceLimits().subgroup_size().getInt();
+  SmallVector<int64_t, 4> loopRanges = op.getStaticLoopRanges();
+  int64_t reductionSize = loopRanges.back();
+  if (ShapedType::isDynamic(reductionSize) || reductionSize < subgroupSize) {
+    return success();
+  }
+
+  // Each workgroup produces one output element.
+  SmallVector<int64_t> workgroupTileSizes(op.getNumLoops(), 1);
+  workgroupTileSizes.back() = 0;
+  TileSizesListType tileSizes = {workgroupTileSizes};
+  std::array<int64_t, 3> workgroupSize = {subgroupSize, 1, 1};
+  return setOpConfigAndEntryPointFnTranslation(
+      op->getParentOfType<FuncOp>(), op, tileSizes, {},
+      IREE::Codegen::DispatchLoweringPassPipeline::SPIRVSubgroupReduce,
+      workgroupSize);
+}
+
 //===----------------------------------------------------------------------===//
 // FFT Default Configuration
 //===----------------------------------------------------------------------===//
@@ -526,8 +660,35 @@ static LogicalResult setDefaultOpConfig(spirv::ResourceLimitsAttr limits,
 
 /// Sets the CodeGen configuration as attributes to the given `rootOp` if it's a
 /// known Linalg matmul/convolution op with good configurations.
+/// Propagates the configuration annotated in the incoming IR.
+static LogicalResult setUserConfig(
+    FuncOp entryPointFn, Operation *computeOp,
+    IREE::Codegen::CompilationInfoAttr compilationInfo) {
+  if (auto translationInfo = getTranslationInfo(entryPointFn)) {
+    return computeOp->emitOpError(
+        "multiple ops within dispatch trying to set the translation "
+        "info");
+  }
+
+  SmallVector<int64_t> workgroupSize = compilationInfo.getWorkgroupSizeVals();
+  setTranslationInfo(entryPointFn, compilationInfo.getTranslationInfo(),
+                     workgroupSize);
+  setLoweringConfig(computeOp, compilationInfo.getLoweringConfig());
+  eraseCompilationInfo(computeOp);
+  return success();
+}
+
 static LogicalResult setSPIRVOpConfig(const spirv::TargetEnv &targetEnv,
                                       Operation *rootOp) {
+  // Cooperative matrix configurations only depend on the matrix sizes the
+  // target reports, whichever vendor it is from.
+  if (auto matmulOp = dyn_cast<linalg::MatmulOp>(rootOp)) {
+    if (failed(detail::setCooperativeMatrixConfig(targetEnv, matmulOp))) {
+      return failure();
+    }
+    if (getLoweringConfig(rootOp)) return success();
+  }
+
   LogicalResult result = success();
   // First try to find a proper CodeGen configuration to tile and vectorize for
   // the current target architecture.
@@ -535,9 +696,6 @@ static LogicalResult setSPIRVOpConfig(const spirv::TargetEnv &targetEnv,
     case spirv::Vendor::ARM:
       result = detail::setMaliCodeGenConfig(targetEnv, rootOp);
       break;
-    case spirv::Vendor::NVIDIA:
-      result = detail::setNVIDIACodeGenConfig(targetEnv, rootOp);
-      break;
     case spirv::Vendor::Qualcomm:
       result = detail::setAdrenoCodeGenConfig(targetEnv, rootOp);
       break;
@@ -579,11 +737,15 @@ static LogicalResult setSPIRVOpConfig(const spirv::TargetEnv &targetEnv,
       .Case<IREE::LinalgExt::FftOp>([limits](IREE::LinalgExt::FftOp op) {
         return setFftOpConfig(limits, op);
       })
-      .Case<linalg::GenericOp>([limits](linalg::GenericOp op) {
+      .Case<linalg::GenericOp>([&targetEnv, limits](linalg::GenericOp op) {
         // If a generic op has reduction iterator types, it can be treated as a
-        // root op for configuration as well. Use the default configuration,
-        // which will mark it as a root.
+        // root op for configuration as well. Try to spread the reduction
+        // across a subgroup first, and otherwise use the default
+        // configuration, which will mark it as a root.
         if (op.getNumLoops() != op.getNumParallelLoops()) {
+          auto result = setSubgroupReductionConfig(targetEnv, op);
+          if (failed(result)) return result;
+          if (getLoweringConfig(op)) return result;
           return setDefaultOpConfig(limits, op);
         }
         return success();
@@ -616,12 +778,23 @@ LogicalResult initSPIRVLaunchConfig(ModuleOp module) {
     if (failed(getComputeOps(funcOp, computeOps, tiledLoops))) {
       return funcOp.emitOpError("failed to get compute ops");
     }
+    if (failed(applyTuningDatabaseConfig(funcOp, computeOps))) {
+      return failure();
+    }
 
     Operation *rootOperation = nullptr;
     // Try to find a configuration according to a matmul/convolution op and use
     // it as the root op.
     for (Operation *computeOp : computeOps) {
-      if (failed(setSPIRVOpConfig(targetEnv, computeOp))) return failure();
+      if (IREE::Codegen::CompilationInfoAttr compilationInfo =
+              getCompilationInfo(computeOp)) {
+        // Use the configuration coming from the IR and bypass the heuristics.
+        if (failed(setUserConfig(funcOp, computeOp, compilationInfo))) {
+          return failure();
+        }
+      } else if (failed(setSPIRVOpConfig(targetEnv, computeOp))) {
+        return failure();
+      }
 
       // Check if the op configuration was set.
       if (!getLoweringConfig(computeOp)) continue;
@@ -684,6 +857,9 @@ LogicalResult initSPIRVLaunchConfig(ModuleOp module) {
       if (op == rootOperation) continue;
       setLoweringConfig(op, config);
     }
+    if (failed(recordTuningDatabaseConfig(funcOp, rootOperation, computeOps))) {
+      return failure();
+    }
   }
   return success();
 }
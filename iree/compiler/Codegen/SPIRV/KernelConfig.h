@@ -17,7 +17,7 @@
 
 #include <array>
 
-#include "mlir/Dialect/Linalg/IR/LinalgInterfaces.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/SPIRV/IR/TargetAndABI.h"
 #include "mlir/IR/BuiltinOps.h"
 
@@ -39,6 +39,13 @@ LogicalResult setMatmulOpConfig(linalg::LinalgOp linalgOp,
                                 std::array<int64_t, 2> bestWorkgroupSizeXY,
                                 std::array<int64_t, 3> bestThreadTileSizeMNK);
 
+/// Sets CodeGen configurations via attributes to the given matmul `op` to use
+/// the cooperative matrix sizes supported by `targetEnv`. Does nothing if the
+/// target does not support cooperative matrices or none of its sizes divide
+/// the matmul.
+LogicalResult setCooperativeMatrixConfig(const spirv::TargetEnv &targetEnv,
+                                         linalg::MatmulOp op);
+
 /// Sets CodeGen configuration for GPUs from a specific vendor.
 ///
 /// If the given `rootOp` has known good CodeGen configuration, attaches a
@@ -53,8 +60,6 @@ LogicalResult setAdrenoCodeGenConfig(const spirv::TargetEnv &targetEnv,
                                      Operation *rootOp);
 LogicalResult setMaliCodeGenConfig(const spirv::TargetEnv &targetEnv,
                                    Operation *rootOp);
-LogicalResult setNVIDIACodeGenConfig(const spirv::TargetEnv &targetEnv,
-                                     Operation *rootOp);
 
 }  // namespace detail
 
@@ -17,6 +17,7 @@
 #include "iree/compiler/Codegen/PassDetail.h"
 #include "iree/compiler/Codegen/Passes.h"
 #include "iree/compiler/Codegen/SPIRV/MemorySpace.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "mlir/Conversion/AffineToStandard/AffineToStandard.h"
 #include "mlir/Dialect/Arithmetic/Transforms/Passes.h"
@@ -36,6 +37,12 @@
 namespace mlir {
 namespace iree_compiler {
 
+static llvm::cl::opt<bool> clFastMathApproximations(
+    "iree-spirv-fast-math-approximations",
+    llvm::cl::desc("Use cheaper approximations of f32 math functions with "
+                   "bounded errors instead of the polynomial approximations"),
+    llvm::cl::init(false));
+
 static Value gpuAllocationFunction(OpBuilder &builder, Location loc,
                                    ArrayRef<int64_t> staticShape,
                                    Type elementType,
@@ -86,7 +93,8 @@ static void addMemRefLoweringPasses(OpPassManager &pm) {
   pm.addPass(createCSEPass());
 
   // math dialect elementry functions -> polynomial form.
-  pm.addNestedPass<FuncOp>(createPolynomialApproximationPass());
+  pm.addNestedPass<FuncOp>(
+      createPolynomialApproximationPass(clFastMathApproximations));
 
   // Fold load/store from/to subview ops into the original memref when possible.
   // In SPIR-V we don't use memref descriptor so it's not possible to handle
@@ -174,6 +182,22 @@ void addSPIRVTileAndVectorizeToCooperativeOpsPassPipeline(OpPassManager &pm) {
   pm.addNestedPass<FuncOp>(createSPIRVVectorToCooperativeOpsPass());
 }
 
+void addSPIRVSubgroupReducePassPipeline(OpPassManager &pm) {
+  addLinalgBufferizePasses(pm, gpuAllocationFunction);
+
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(createCSEPass());
+
+  // Spread reductions across invocations and combine them across subgroups.
+  pm.addNestedPass<FuncOp>(createSPIRVSubgroupReducePass());
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(createCSEPass());
+
+  // Other ops in the dispatch, like the initialization of the output, are
+  // small and run on each invocation.
+  addLoopMaterializationPasses(pm);
+}
+
 void addSPIRVTileAndDistributePassPipeline(OpPassManager &pm) {
   addLinalgBufferizePasses(pm, gpuAllocationFunction);
 
@@ -116,6 +116,9 @@ void SPIRVLowerExecutableTargetPass::runOnOperation() {
           SPIRVVectorizeToCooperativeOps:
         addSPIRVTileAndVectorizeToCooperativeOpsPassPipeline(nestedModulePM);
         break;
+      case IREE::Codegen::DispatchLoweringPassPipeline::SPIRVSubgroupReduce:
+        addSPIRVSubgroupReducePassPipeline(nestedModulePM);
+        break;
       default:
         llvm_unreachable("Unsupported pipeline on GPU target.");
     }
@@ -0,0 +1,224 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- SPIRVSubgroupReduce.cpp --------------------------------------------===//
+//
+// This pass spreads sum reductions with buffer semantics across the
+// invocations of a workgroup. Each invocation accumulates a strided slice of
+// the reduction; the partial sums are then combined within each subgroup with
+// subgroup operations and across subgroups through workgroup memory.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Codegen/Dialect/LoweringConfig.h"
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Codegen/SPIRV/MemorySpace.h"
+#include "iree/compiler/Codegen/SPIRV/Utils.h"
+#include "iree/compiler/Codegen/Utils/Utils.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Dialect/SPIRV/IR/SPIRVDialect.h"
+#include "mlir/Dialect/SPIRV/IR/SPIRVOps.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/TypeUtilities.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-spirv-subgroup-reduce"
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Creates the same addition as `combiner` on `lhs` and `rhs`.
+static Value createCombine(OpBuilder &builder, Location loc,
+                           Operation *combiner, Value lhs, Value rhs) {
+  if (isa<arith::AddFOp>(combiner)) {
+    return builder.create<arith::AddFOp>(loc, lhs, rhs);
+  }
+  return builder.create<arith::AddIOp>(loc, lhs, rhs);
+}
+
+/// Creates the sum of `value` over the invocations of the current subgroup.
+static Value createSubgroupSum(OpBuilder &builder, Location loc,
+                               Operation *combiner, Value value) {
+  if (isa<arith::AddFOp>(combiner)) {
+    return builder.create<spirv::GroupNonUniformFAddOp>(
+        loc, value.getType(), spirv::Scope::Subgroup,
+        spirv::GroupOperation::Reduce, value, /*cluster_size=*/Value());
+  }
+  return builder.create<spirv::GroupNonUniformIAddOp>(
+      loc, value.getType(), spirv::Scope::Subgroup,
+      spirv::GroupOperation::Reduce, value, /*cluster_size=*/Value());
+}
+
+/// Creates a barrier across the workgroup. It also orders the accesses to the
+/// output buffers, which all invocations write to.
+static void createWorkgroupBarrier(OpBuilder &builder, Location loc) {
+  builder.create<spirv::ControlBarrierOp>(
+      loc, spirv::Scope::Workgroup, spirv::Scope::Workgroup,
+      spirv::MemorySemantics::AcquireRelease |
+          spirv::MemorySemantics::WorkgroupMemory |
+          spirv::MemorySemantics::UniformMemory);
+}
+
+/// Replaces `op`, whose payload result is accumulated into its output by
+/// `combiner`, with loops where the `workgroupSize` invocations of the
+/// workgroup compute each output element together.
+static void distributeReduction(linalg::GenericOp op, Operation *combiner,
+                                int64_t workgroupSize) {
+  OpBuilder builder(op);
+  Location loc = op.getLoc();
+  Type indexType = builder.getIndexType();
+  OpOperand *output = op.getOutputOperand(0);
+  Type elementType = getElementTypeOrSelf(output->get().getType());
+
+  Value zero = builder.create<arith::ConstantIndexOp>(loc, 0);
+  Value one = builder.create<arith::ConstantIndexOp>(loc, 1);
+  Value identity = builder.create<arith::ConstantOp>(
+      loc, builder.getZeroAttr(elementType));
+  Value threadId =
+      builder.create<gpu::ThreadIdOp>(loc, indexType, gpu::Dimension::x);
+  Value numThreads =
+      builder.create<arith::ConstantIndexOp>(loc, workgroupSize);
+  Value subgroupId = builder.create<gpu::SubgroupIdOp>(loc, indexType);
+  Value numSubgroups = builder.create<gpu::NumSubgroupsOp>(loc, indexType);
+
+  // The subgroup size is only known when the pipeline is created, but there
+  // are at most as many subgroups as invocations.
+  auto partialsType = MemRefType::get({workgroupSize}, elementType, {},
+                                      getWorkgroupMemorySpace());
+  Value partials = builder.create<memref::AllocOp>(loc, partialsType);
+
+  SmallVector<Range, 4> loopRanges = op.createLoopRanges(builder, loc);
+  Range reductionRange = loopRanges.pop_back_val();
+  SmallVector<Value> lbs, ubs, steps;
+  for (const Range &range : loopRanges) {
+    lbs.push_back(range.offset);
+    ubs.push_back(range.size);
+    steps.push_back(range.stride);
+  }
+  unsigned reductionDim = op.getNumLoops() - 1;
+  Block *body = op.getBlock();
+
+  scf::buildLoopNest(
+      builder, loc, lbs, ubs, steps,
+      [&](OpBuilder &b, Location loc, ValueRange ivs) {
+        auto getIndices = [&](OpOperand *operand, Value reductionIv) {
+          SmallVector<Value> indices;
+          for (AffineExpr expr : op.getTiedIndexingMap(operand).getResults()) {
+            unsigned dim = expr.cast<AffineDimExpr>().getPosition();
+            indices.push_back(dim == reductionDim ? reductionIv : ivs[dim]);
+          }
+          return indices;
+        };
+
+        // Read the initial value before the barrier below, after which the
+        // output is overwritten.
+        SmallVector<Value> outputIndices = getIndices(output, Value());
+        Value init =
+            b.create<memref::LoadOp>(loc, output->get(), outputIndices);
+
+        // Accumulate a strided slice of the reduction on each invocation.
+        Value lb =
+            b.create<arith::AddIOp>(loc, reductionRange.offset, threadId);
+        Value step =
+            b.create<arith::MulIOp>(loc, reductionRange.stride, numThreads);
+        auto forOp = b.create<scf::ForOp>(
+            loc, lb, reductionRange.size, step, ValueRange{identity},
+            [&](OpBuilder &b, Location loc, Value iv, ValueRange args) {
+              BlockAndValueMapping mapping;
+              for (OpOperand *input : op.getInputOperands()) {
+                Value value = input->get();
+                if (value.getType().isa<MemRefType>()) {
+                  value = b.create<memref::LoadOp>(loc, value,
+                                                   getIndices(input, iv));
+                }
+                mapping.map(body->getArgument(input->getOperandNumber()),
+                            value);
+              }
+              mapping.map(body->getArguments().back(), args[0]);
+              for (Operation &bodyOp : body->without_terminator()) {
+                b.clone(bodyOp, mapping);
+              }
+              b.create<scf::YieldOp>(loc,
+                                     mapping.lookup(combiner->getResult(0)));
+            });
+
+        // Combine the partial sums within each subgroup, then publish one
+        // per subgroup to workgroup memory.
+        Value subgroupSum =
+            createSubgroupSum(b, loc, combiner, forOp.getResult(0));
+        Value isElected = b.create<spirv::GroupNonUniformElectOp>(
+            loc, b.getI1Type(), spirv::Scope::Subgroup);
+        b.create<scf::IfOp>(loc, isElected, [&](OpBuilder &b, Location loc) {
+          b.create<memref::StoreOp>(loc, subgroupSum, partials, subgroupId);
+          b.create<scf::YieldOp>(loc);
+        });
+        createWorkgroupBarrier(b, loc);
+
+        // Every invocation computes the total and writes the same value.
+        auto totalOp = b.create<scf::ForOp>(
+            loc, zero, numSubgroups, one, ValueRange{identity},
+            [&](OpBuilder &b, Location loc, Value iv, ValueRange args) {
+              Value partial = b.create<memref::LoadOp>(loc, partials, iv);
+              b.create<scf::YieldOp>(
+                  loc, createCombine(b, loc, combiner, partial, args[0]));
+            });
+        Value result =
+            createCombine(b, loc, combiner, totalOp.getResult(0), init);
+        b.create<memref::StoreOp>(loc, result, output->get(), outputIndices);
+        // Keep the partial sums alive until all invocations have read them.
+        createWorkgroupBarrier(b, loc);
+      });
+}
+
+namespace {
+struct SPIRVSubgroupReducePass
+    : public SPIRVSubgroupReduceBase<SPIRVSubgroupReducePass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, gpu::GPUDialect,
+                    memref::MemRefDialect, scf::SCFDialect,
+                    spirv::SPIRVDialect>();
+  }
+
+  void runOnOperation() override {
+    FuncOp funcOp = getOperation();
+    auto entryPointOp = getEntryPoint(funcOp);
+    if (!entryPointOp) return;
+    SmallVector<int64_t> workgroupSize = getWorkgroupSize(entryPointOp);
+    if (workgroupSize.empty() ||
+        llvm::any_of(llvm::drop_begin(workgroupSize),
+                     [](int64_t size) { return size != 1; })) {
+      funcOp.emitError("expected a one-dimensional workgroup");
+      return signalPassFailure();
+    }
+
+    SmallVector<std::pair<linalg::GenericOp, Operation *>> reductions;
+    funcOp.walk([&](linalg::GenericOp op) {
+      if (!op.hasBufferSemantics() || !getLoweringConfig(op)) return;
+      if (Operation *combiner = getSubgroupReductionCombiner(op)) {
+        reductions.emplace_back(op, combiner);
+      }
+    });
+    for (auto reduction : reductions) {
+      distributeReduction(reduction.first, reduction.second,
+                          workgroupSize.front());
+      reduction.first.erase();
+    }
+  }
+};
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createSPIRVSubgroupReducePass() {
+  return std::make_unique<SPIRVSubgroupReducePass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
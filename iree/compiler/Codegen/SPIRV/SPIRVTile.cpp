@@ -17,6 +17,7 @@
 #include "iree/compiler/Codegen/Utils/MarkerUtils.h"
 #include "llvm/Support/Debug.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Linalg/Transforms/Transforms.h"
 #include "mlir/Dialect/SCF/SCF.h"
 #include "mlir/Dialect/SCF/Transforms.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
@@ -105,6 +106,8 @@ class SPIRVTilePass final : public SPIRVTileBase<SPIRVTilePass> {
     {
       RewritePatternSet patterns =
           linalg::getLinalgTilingCanonicalizationPatterns(context);
+      // Pad only the tiles of padded operands that each invocation reads.
+      patterns.add<linalg::ExtractSliceOfPadTensorSwapPattern>(context);
       // Pulling in upstream scf.for and affine.min canonicalization patterns.
       // They work on tiled (but not distributed) loops.
       scf::populateSCFForLoopCanonicalizationPatterns(patterns);
@@ -150,6 +153,8 @@ class SPIRVTilePass final : public SPIRVTileBase<SPIRVTilePass> {
     {
       RewritePatternSet patterns =
           linalg::getLinalgTilingCanonicalizationPatterns(context);
+      // Pad only the tiles of padded operands that each invocation reads.
+      patterns.add<linalg::ExtractSliceOfPadTensorSwapPattern>(context);
       // Pulling in upstream scf.for and affine.min canonicalization patterns.
       // They work on tiled (but not distributed) loops. We only tiled reduction
       // loops previously so this should be fine.
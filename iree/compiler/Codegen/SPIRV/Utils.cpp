@@ -13,10 +13,12 @@
 #include "iree/compiler/Codegen/SPIRV/Utils.h"
 
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/GPU/GPUDialect.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Utils/Utils.h"
 #include "mlir/Dialect/SPIRV/IR/TargetAndABI.h"
+#include "mlir/IR/TypeUtilities.h"
 #include "mlir/Support/LogicalResult.h"
 
 namespace mlir {
@@ -34,6 +36,35 @@ spirv::TargetEnvAttr getSPIRVTargetEnvAttr(Operation *op) {
   return config.getAs<spirv::TargetEnvAttr>(spirv::getTargetEnvAttrName());
 }
 
+const char *getSPIRVBufferDeviceAddressAttrName() {
+  return "buffer_device_address";
+}
+
+const char *getSPIRVSpecializePushConstantsAttrName() {
+  return "specialize_push_constants";
+}
+
+/// Returns true if the executable target configuration of `op` has a true
+/// BoolAttr named `name`.
+static bool hasTrueTargetConfig(Operation *op, StringRef name) {
+  auto variant = op->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  if (!variant) return false;
+  IREE::HAL::ExecutableTargetAttr targetAttr = variant.target();
+  if (!targetAttr) return false;
+  auto config = targetAttr.getConfiguration();
+  if (!config) return false;
+  auto attr = config.getAs<BoolAttr>(name);
+  return attr && attr.getValue();
+}
+
+bool usesSPIRVBufferDeviceAddresses(Operation *op) {
+  return hasTrueTargetConfig(op, getSPIRVBufferDeviceAddressAttrName());
+}
+
+bool usesSPIRVSpecializedPushConstants(Operation *op) {
+  return hasTrueTargetConfig(op, getSPIRVSpecializePushConstantsAttrName());
+}
+
 template <typename GPUIdOp, typename GPUCountOp>
 static linalg::ProcInfo getGPUProcessorIdAndCountImpl(OpBuilder &builder,
                                                       Location loc,
@@ -71,5 +102,41 @@ template SmallVector<linalg::ProcInfo, 2>
 getGPUProcessorIdsAndCounts<gpu::ThreadIdOp, gpu::BlockDimOp>(
     OpBuilder &builder, Location loc, unsigned numDims);
 
+Operation *getSubgroupReductionCombiner(linalg::GenericOp genericOp) {
+  if (genericOp.getNumOutputs() != 1 || genericOp.getNumReductionLoops() != 1 ||
+      genericOp.hasIndexSemantics()) {
+    return nullptr;
+  }
+  if (!isReductionIterator(genericOp.iterator_types().getValue().back())) {
+    return nullptr;
+  }
+  if (!llvm::all_of(genericOp.getIndexingMaps(), [](AffineMap map) {
+        return map.isProjectedPermutation();
+      })) {
+    return nullptr;
+  }
+  // Subgroup operations are only defined on 32-bit integers and floats here;
+  // narrower integers would need emulation.
+  auto isSupportedType = [](Type type) {
+    Type elementType = getElementTypeOrSelf(type);
+    return elementType.isF16() || elementType.isF32() ||
+           elementType.isInteger(32);
+  };
+  if (!llvm::all_of(genericOp->getOperandTypes(), isSupportedType)) {
+    return nullptr;
+  }
+
+  // The output must only be accumulated into by the final addition.
+  Block *body = genericOp.getBlock();
+  BlockArgument outputArg = body->getArguments().back();
+  Operation *combiner = body->getTerminator()->getOperand(0).getDefiningOp();
+  if (!combiner || !isa<arith::AddFOp, arith::AddIOp>(combiner) ||
+      combiner->getBlock() != body || !outputArg.hasOneUse() ||
+      outputArg.getUses().begin()->getOwner() != combiner) {
+    return nullptr;
+  }
+  return combiner;
+}
+
 }  // namespace iree_compiler
 }  // namespace mlir
@@ -25,6 +25,26 @@ static constexpr int kNumGPUDims = 3;
 /// Given an operation, return the `spv.target_env` attribute.
 spirv::TargetEnvAttr getSPIRVTargetEnvAttr(Operation *op);
 
+/// Returns the name of the executable target configuration attribute that
+/// requests bindings be accessed through buffer device addresses.
+const char *getSPIRVBufferDeviceAddressAttrName();
+
+/// Returns true if the executable target of `op` accesses bindings through
+/// buffer device addresses passed as push constants instead of descriptors.
+bool usesSPIRVBufferDeviceAddresses(Operation *op);
+
+/// Maximum number of push constants mirrored by specialization constants.
+/// Must match IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANTS in the runtime.
+static constexpr int kMaxSpecializedPushConstants = 16;
+
+/// Returns the name of the executable target configuration attribute that
+/// requests push constants also be readable from specialization constants.
+const char *getSPIRVSpecializePushConstantsAttrName();
+
+/// Returns true if the executable target of `op` reads push constants from
+/// specialization constants in pipelines specialized by the runtime.
+bool usesSPIRVSpecializedPushConstants(Operation *op);
+
 /// Returns the attribute name carrying information about distribution.
 const char *getSPIRVDistributeAttrName();
 
@@ -35,6 +55,11 @@ SmallVector<linalg::ProcInfo, 2> getGPUProcessorIdsAndCounts(OpBuilder &builder,
                                                              Location loc,
                                                              unsigned numDims);
 
+/// Returns the op combining the payload result of `genericOp` with its output
+/// if `genericOp` is a sum along its innermost loop that can be spread across
+/// the invocations of a subgroup. Returns nullptr otherwise.
+Operation *getSubgroupReductionCombiner(linalg::GenericOp genericOp);
+
 }  // namespace iree_compiler
 }  // namespace mlir
 
@@ -0,0 +1,117 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='hal.executable(hal.executable.variant(iree-spirv-lower-executable-target-pass{test-lowering-configuration=true}))' %s | FileCheck %s
+
+// Row sum: reduce across the subgroup.
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+
+hal.executable @row_sum {
+  hal.executable.variant @vulkan_spirv_fb, target = #hal.executable.target<"vulkan-spirv", "vulkan-spirv-fb", {
+      spv.target_env = #spv.target_env<#spv.vce<v1.4, [Shader, GroupNonUniform, GroupNonUniformArithmetic], []>, Unknown:IntegratedGPU, {
+        max_compute_shared_memory_size = 32768 : i32,
+        max_compute_workgroup_invocations = 512 : i32,
+        max_compute_workgroup_size = dense<512> : vector<3xi32>,
+        subgroup_size = 32 : i32}>
+    }> {
+    hal.executable.entry_point public @row_sum layout(#executable_layout)
+    builtin.module {
+      func @row_sum() {
+        %c0 = arith.constant 0 : index
+        %c16 = arith.constant 16 : index
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:16x4096xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<writeonly:16xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %2 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+        scf.for %arg0 = %2 to %c16 step %3 {
+          %4 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 16)>(%arg0)[%workgroup_size_x]
+          %5 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%4, 4096], strides = [1, 1] : !flow.dispatch.tensor<readonly:16x4096xf32> -> tensor<?x4096xf32>
+          %6 = linalg.init_tensor [%4] : tensor<?xf32>
+          %7 = linalg.fill(%cst, %6) : f32, tensor<?xf32> -> tensor<?xf32>
+          %8 = linalg.generic {
+            indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+            iterator_types = ["parallel", "reduction"]
+          } ins(%5 : tensor<?x4096xf32>) outs(%7 : tensor<?xf32>) {
+          ^bb0(%arg1: f32, %arg2: f32):  // no predecessors
+            %9 = arith.addf %arg1, %arg2 : f32
+            linalg.yield %9 : f32
+          } -> tensor<?xf32>
+          flow.dispatch.tensor.store %8, %1, offsets = [%arg0], sizes = [%4], strides = [1] : tensor<?xf32> -> !flow.dispatch.tensor<writeonly:16xf32>
+        }
+        return
+      }
+    }
+  }
+}
+
+//  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[1, 0]{{\]}}, native_vector_size = []>
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"SPIRVSubgroupReduce", workload_per_wg = [1]>
+//      CHECK: hal.executable.entry_point public @row_sum
+// CHECK-SAME:   translation.info = #[[TRANSLATION]]
+// CHECK-SAME:   workgroup_size = [32 : index, 1 : index, 1 : index]
+//      CHECK: func @row_sum()
+//      CHECK:   linalg.generic
+// CHECK-SAME:     lowering.config = #[[CONFIG]]
+
+// -----
+
+// Without subgroup arithmetic: fall back to the default configuration.
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+
+hal.executable @row_sum_no_subgroup_ops {
+  hal.executable.variant @vulkan_spirv_fb, target = #hal.executable.target<"vulkan-spirv", "vulkan-spirv-fb", {
+      spv.target_env = #spv.target_env<#spv.vce<v1.4, [Shader], []>, Unknown:IntegratedGPU, {
+        max_compute_shared_memory_size = 32768 : i32,
+        max_compute_workgroup_invocations = 512 : i32,
+        max_compute_workgroup_size = dense<512> : vector<3xi32>,
+        subgroup_size = 32 : i32}>
+    }> {
+    hal.executable.entry_point public @row_sum_no_subgroup_ops layout(#executable_layout)
+    builtin.module {
+      func @row_sum_no_subgroup_ops() {
+        %c0 = arith.constant 0 : index
+        %c16 = arith.constant 16 : index
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:16x4096xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<writeonly:16xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %2 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+        scf.for %arg0 = %2 to %c16 step %3 {
+          %4 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 16)>(%arg0)[%workgroup_size_x]
+          %5 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%4, 4096], strides = [1, 1] : !flow.dispatch.tensor<readonly:16x4096xf32> -> tensor<?x4096xf32>
+          %6 = linalg.init_tensor [%4] : tensor<?xf32>
+          %7 = linalg.fill(%cst, %6) : f32, tensor<?xf32> -> tensor<?xf32>
+          %8 = linalg.generic {
+            indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+            iterator_types = ["parallel", "reduction"]
+          } ins(%5 : tensor<?x4096xf32>) outs(%7 : tensor<?xf32>) {
+          ^bb0(%arg1: f32, %arg2: f32):  // no predecessors
+            %9 = arith.addf %arg1, %arg2 : f32
+            linalg.yield %9 : f32
+          } -> tensor<?xf32>
+          flow.dispatch.tensor.store %8, %1, offsets = [%arg0], sizes = [%4], strides = [1] : tensor<?xf32> -> !flow.dispatch.tensor<writeonly:16xf32>
+        }
+        return
+      }
+    }
+  }
+}
+
+//  CHECK-NOT: SPIRVSubgroupReduce
+//      CHECK: hal.executable.entry_point public @row_sum_no_subgroup_ops
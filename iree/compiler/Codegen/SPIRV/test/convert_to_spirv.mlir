@@ -253,3 +253,88 @@ hal.executable private @interface_wg_count {
 //       CHECK:     %[[ADDR2:.+]] = spv.mlir.addressof @[[WGCOUNT]]
 //       CHECK:     %[[VAL2:.+]] = spv.Load "Input" %[[ADDR2]]
 //       CHECK:     %[[WGIDY:.+]] = spv.CompositeExtract %[[VAL2]][1 : i32]
+
+// -----
+
+#executable_layout = #hal.executable.layout<push_constants = 1, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+hal.executable private @buffer_device_address {
+  hal.executable.variant @vulkan, target = <"vulkan-spirv", "vulkan-spirv-fb", {
+      buffer_device_address = true,
+      spv.target_env = #spv.target_env<#spv.vce<v1.5, [Shader, Int64, PhysicalStorageBufferAddresses], [SPV_KHR_physical_storage_buffer]>, {}>}> {
+    hal.executable.entry_point @buffer_device_address layout(#executable_layout) attributes {
+      workgroup_size = [32: index, 1: index, 1: index]
+    }
+    builtin.module {
+      // CHECK-LABEL: spv.module PhysicalStorageBuffer64 GLSL450
+      //   CHECK-NOT: bind(
+      //       CHECK: spv.GlobalVariable @__push_constant_var__ : !spv.ptr<!spv.struct<(!spv.array<6 x i32, stride=4> [0])>, PushConstant>
+      //       CHECK: spv.func @buffer_device_address()
+      func @buffer_device_address() {
+        %c0 = arith.constant 0 : index
+        // User push constants keep their indices.
+        //       CHECK: spv.Load "PushConstant"
+        %0 = hal.interface.constant.load[0] : index
+
+        // Binding 0 is in words 2-3 after aligning the push constants.
+        //       CHECK: spv.Constant 2 : i32
+        //       CHECK: %[[LO:.+]] = spv.Load "PushConstant" %{{.+}} : i32
+        //       CHECK: spv.Constant 3 : i32
+        //       CHECK: %[[HI:.+]] = spv.Load "PushConstant" %{{.+}} : i32
+        //       CHECK: %[[LO64:.+]] = spv.UConvert %[[LO]] : i32 to i64
+        //       CHECK: %[[HI64:.+]] = spv.UConvert %[[HI]] : i32 to i64
+        //       CHECK: %[[SHL:.+]] = spv.ShiftLeftLogical %[[HI64]]
+        //       CHECK: %[[ADDR:.+]] = spv.BitwiseOr %[[LO64]], %[[SHL]] : i64
+        //       CHECK: %[[PTR:.+]] = spv.ConvertUToPtr %[[ADDR]] : i64 to !spv.ptr<!spv.struct<(!spv.array<16 x f32, stride=4> [0])>, PhysicalStorageBuffer>
+        %1 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<16xf32>
+        //       CHECK: %[[AC:.+]] = spv.AccessChain %[[PTR]]{{.+}} -> !spv.ptr<f32, PhysicalStorageBuffer>
+        //       CHECK: spv.Load "PhysicalStorageBuffer" %[[AC]] ["Aligned", 4] : f32
+        %2 = memref.load %1[%c0] : memref<16xf32>
+
+        // Binding 1 is in words 4-5.
+        //       CHECK: spv.Constant 4 : i32
+        //       CHECK: spv.Constant 5 : i32
+        //       CHECK: spv.ConvertUToPtr
+        //       CHECK: spv.Store "PhysicalStorageBuffer" %{{.+}}, %{{.+}} ["Aligned", 4] : f32
+        %3 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<16xf32>
+        memref.store %2, %3[%c0] : memref<16xf32>
+        return
+      }
+    }
+  }
+}
+
+// -----
+
+#executable_layout = #hal.executable.layout<push_constants = 2, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+hal.executable private @specialized_push_constants {
+  hal.executable.variant @vulkan, target = <"vulkan-spirv", "vulkan-spirv-fb", {
+      specialize_push_constants = true,
+      spv.target_env = #spv.target_env<#spv.vce<v1.3, [Shader], []>, {}>}> {
+    hal.executable.entry_point @specialized_push_constants layout(#executable_layout) attributes {
+      workgroup_size = [32: index, 1: index, 1: index]
+    }
+    builtin.module {
+      // CHECK-LABEL: spv.module
+      //   CHECK-DAG: spv.SpecConstant @__push_constants_specialized__ spec_id(0) = false
+      //   CHECK-DAG: spv.SpecConstant @__push_constant_1__ spec_id(2) = 0 : i32
+      //       CHECK: spv.func @specialized_push_constants()
+      func @specialized_push_constants() {
+        //       CHECK: %[[PC:.+]] = spv.Load "PushConstant" %{{.+}} : i32
+        //       CHECK: %[[SPECIALIZED:.+]] = spv.mlir.referenceof @__push_constants_specialized__ : i1
+        //       CHECK: %[[VALUE:.+]] = spv.mlir.referenceof @__push_constant_1__ : i32
+        //       CHECK: spv.Select %[[SPECIALIZED]], %[[VALUE]], %[[PC]] : i1, i32
+        %0 = hal.interface.constant.load[1] : index
+        return
+      }
+    }
+  }
+}
@@ -0,0 +1,63 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='hal.executable(hal.executable.variant(builtin.module(builtin.func(iree-spirv-subgroup-reduce))))' %s | FileCheck %s
+
+#config = #iree_codegen.lowering.config<tile_sizes = [[1, 0]], native_vector_size = []>
+#translation = #iree_codegen.translation.info<"SPIRVSubgroupReduce", workload_per_wg = [1]>
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+hal.executable private @row_sum {
+  hal.executable.variant @vulkan, target = <"vulkan-spirv", "vulkan-spirv-fb"> {
+    hal.executable.entry_point @row_sum layout(#executable_layout) attributes {
+      workgroup_size = [64: index, 1: index, 1: index],
+      translation.info = #translation
+    }
+    builtin.module {
+      func @row_sum() {
+        %c0 = arith.constant 0 : index
+        %src = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<16x4096xf32>
+        %dst = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<16xf32>
+        %id = hal.interface.workgroup.id[0] : index
+        %0 = memref.subview %src[%id, 0] [1, 4096] [1, 1] : memref<16x4096xf32> to memref<1x4096xf32, affine_map<(d0, d1)[s0] -> (d0 * 4096 + s0 + d1)>>
+        %1 = memref.subview %dst[%id] [1] [1] : memref<16xf32> to memref<1xf32, affine_map<(d0)[s0] -> (d0 + s0)>>
+        linalg.generic {
+          indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+          iterator_types = ["parallel", "reduction"]
+        } ins(%0 : memref<1x4096xf32, affine_map<(d0, d1)[s0] -> (d0 * 4096 + s0 + d1)>>)
+          outs(%1 : memref<1xf32, affine_map<(d0)[s0] -> (d0 + s0)>>)
+          attrs = {lowering.config = #config} {
+        ^bb0(%arg0: f32, %arg1: f32):  // no predecessors
+          %2 = arith.addf %arg0, %arg1 : f32
+          linalg.yield %2 : f32
+        }
+        return
+      }
+    }
+  }
+}
+
+//   CHECK-LABEL: func @row_sum()
+//     CHECK-DAG:   %[[ZERO:.+]] = arith.constant 0.000000e+00 : f32
+//     CHECK-DAG:   %[[TID:.+]] = gpu.thread_id x
+//     CHECK-DAG:   %[[SGID:.+]] = gpu.subgroup_id
+//     CHECK-DAG:   %[[NUMSG:.+]] = gpu.num_subgroups
+//         CHECK:   %[[PARTIALS:.+]] = memref.alloc() : memref<64xf32, 3>
+//         CHECK:   scf.for %[[I:.+]] =
+//         CHECK:     %[[INIT:.+]] = memref.load %{{.+}}[%[[I]]]
+//         CHECK:     %[[SUM:.+]] = scf.for %[[K:.+]] = %{{.+}} to %{{.+}} step %{{.+}} iter_args(%[[ACC:.+]] = %[[ZERO]])
+//         CHECK:       %[[IN:.+]] = memref.load %{{.+}}[%[[I]], %[[K]]]
+//         CHECK:       %[[ADD:.+]] = arith.addf %[[IN]], %[[ACC]]
+//         CHECK:       scf.yield %[[ADD]]
+//         CHECK:     %[[SGSUM:.+]] = spv.GroupNonUniformFAdd "Subgroup" "Reduce" %[[SUM]]
+//         CHECK:     %[[ELECT:.+]] = spv.GroupNonUniformElect Subgroup
+//         CHECK:     scf.if %[[ELECT]]
+//         CHECK:       memref.store %[[SGSUM]], %[[PARTIALS]][%[[SGID]]]
+//         CHECK:     spv.ControlBarrier Workgroup, Workgroup, "AcquireRelease|WorkgroupMemory|UniformMemory"
+//         CHECK:     %[[TOTAL:.+]] = scf.for %[[S:.+]] = %{{.+}} to %[[NUMSG]]
+//         CHECK:       memref.load %[[PARTIALS]][%[[S]]]
+//         CHECK:     %[[RESULT:.+]] = arith.addf %[[TOTAL]], %[[INIT]]
+//         CHECK:     memref.store %[[RESULT]], %{{.+}}[%[[I]]]
+//         CHECK:     spv.ControlBarrier
+//     CHECK-NOT:   linalg.generic
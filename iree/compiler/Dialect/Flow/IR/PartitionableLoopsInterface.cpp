@@ -187,9 +187,10 @@ void registerPartitionableLoopsInterfaceModels(DialectRegistry &registry) {
   // clang-format on
 
   registerInterfaceForTiledOpInterfaceOps<
-      LinalgExt::FftOp, LinalgExt::ReverseOp, LinalgExt::ScanOp,
-      LinalgExt::ScatterOp, LinalgExt::SortOp, tensor::ExtractSliceOp,
-      tensor::InsertSliceOp>(registry);
+      LinalgExt::AttentionOp, LinalgExt::FftOp, LinalgExt::ReverseOp,
+      LinalgExt::ScanOp, LinalgExt::ScatterOp, LinalgExt::SortOp,
+      LinalgExt::TopkOp, tensor::ExtractSliceOp, tensor::InsertSliceOp>(
+      registry);
 }
 
 }  // namespace Flow
@@ -8,6 +8,7 @@
 
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/HAL/Utils/InferCustomKernelsTargetInfoFromParent.h"
 #include "iree/compiler/Utils/CustomKernelsTargetInfo.h"
 #include "llvm/ADT/Optional.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
@@ -348,7 +349,16 @@ LinalgMatmulOpToLinalgMmt4DOpPattern::chooseTileParams(Value lhs, Value rhs,
   if (target_info.is(CustomKernelTargetArch::Aarch64)) {
     if (lhsElemType.isSignlessInteger(8) && rhsElemType.isSignlessInteger(8) &&
         accElemType.isSignlessInteger(32)) {
-      if (target_info.has(CustomKernelTargetFeature::Aarch64Dotprod)) {
+      if (target_info.has(CustomKernelTargetFeature::Aarch64I8mm)) {
+        // There is no matrix*vector form of smmla; use the best dot-product
+        // form available instead.
+        if (target_info.has(CustomKernelTargetFeature::Aarch64Dotprod)) {
+          return chooseMatMulOrMatVec({8, 8, 8}, {8, 4, 1},
+                                      "i8*i8->i32, aarch64 +i8mm");
+        }
+        return chooseMatMulOrMatVec({8, 8, 8}, {8, 8, 1},
+                                    "i8*i8->i32, aarch64 +i8mm");
+      } else if (target_info.has(CustomKernelTargetFeature::Aarch64Dotprod)) {
         return chooseMatMulOrMatVec({8, 4, 8}, {8, 4, 1},
                                     "i8*i8->i32, aarch64 +dotprod");
       } else {
@@ -360,6 +370,24 @@ LinalgMatmulOpToLinalgMmt4DOpPattern::chooseTileParams(Value lhs, Value rhs,
       return chooseMatMulOrMatVec({8, 1, 8}, {8, 1, 1},
                                   "f32*f32->f32, aarch64");
     }
+    if (lhsElemType.isBF16() && rhsElemType.isBF16() && accElemType.isF32() &&
+        target_info.has(CustomKernelTargetFeature::Aarch64Bf16)) {
+      return chooseMatMulOrMatVec({8, 4, 8}, {8, 4, 1},
+                                  "bf16*bf16->f32, aarch64 +bf16");
+    }
+    if (lhsElemType.isF16() && rhsElemType.isF16() && accElemType.isF16() &&
+        target_info.has(CustomKernelTargetFeature::Aarch64Fullfp16)) {
+      return chooseMatMulOrMatVec({8, 1, 8}, {8, 1, 1},
+                                  "f16*f16->f16, aarch64 +fullfp16");
+    }
+  }
+  if (target_info.is(CustomKernelTargetArch::X86_64)) {
+    if (lhsElemType.isSignlessInteger(8) && rhsElemType.isSignlessInteger(8) &&
+        accElemType.isSignlessInteger(32) &&
+        target_info.has(CustomKernelTargetFeature::X86_64Avx512Vnni)) {
+      return chooseMatMulOrMatVec({16, 4, 16}, {16, 4, 1},
+                                  "i8*i8->i32, x86_64 +avx512vnni");
+    }
   }
   // enable_generic_slow is meant for tests only. It's just a way to get some
   // test coverage for Mmt4d where we do not currently have kernels.
@@ -430,11 +458,19 @@ class ConvertLinalgMatmulToMmt4DPass final
 
   void runOnOperation() override {
     MLIRContext *context = &getContext();
+    // Without an explicit arch the tile sizes are chosen for the CPU features
+    // shared by all devices the program is compiled for. The packed layout is
+    // baked into the program so it must be usable by every executable variant.
+    CustomKernelsTargetInfo targetInfo = target_info;
+    if (arch.empty()) {
+      (void)InferCustomKernelsTargetInfoFromDeviceTargets(getOperation(),
+                                                          targetInfo);
+    }
     // Main pattern.
     {
       RewritePatternSet patterns(&getContext());
       patterns.insert<LinalgMatmulOpToLinalgMmt4DOpPattern>(
-          context, target_info, enable_generic_slow);
+          context, targetInfo, enable_generic_slow);
       if (failed(applyPatternsAndFoldGreedily(getOperation(),
                                               std::move(patterns)))) {
         return signalPassFailure();
@@ -11,6 +11,7 @@
 #include "iree/compiler/Dialect/Flow/IR/FlowTypes.h"
 #include "iree/compiler/Dialect/Flow/IR/PartitionableLoopsInterface.h"
 #include "iree/compiler/Dialect/Flow/Transforms/DestructiveUpdateUtils.h"
+#include "iree/compiler/Dialect/Flow/Transforms/FusionCostModel.h"
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "llvm/ADT/STLExtras.h"
@@ -191,6 +192,12 @@ static bool isClonableIntoDispatchOp(Operation *op) {
       return true;
     }
   }
+  // Pads with a constant value are computed on the tiles read by the
+  // dispatch (see `swapExtractSliceOfPadOps`) instead of on the whole tensor.
+  if (auto padOp = dyn_cast<tensor::PadOp>(op)) {
+    Value paddingValue = padOp.getConstantPaddingValue();
+    return paddingValue && matchPattern(paddingValue, m_Constant());
+  }
   if (llvm::all_of(op->getOperands(),
                    [&](Value v) { return v.getType().isIntOrFloat(); }) &&
       llvm::all_of(op->getResults(),
@@ -438,6 +445,9 @@ static void getUsedValuesDefinedAboveAfterCloningOps(
     }
     clonedOps.push_back(definingOp);
     worklist.append(definingOp->operand_begin(), definingOp->operand_end());
+    llvm::SetVector<Value> capturedValues;
+    mlir::getUsedValuesDefinedAbove(definingOp->getRegions(), capturedValues);
+    worklist.append(capturedValues.begin(), capturedValues.end());
   }
   // The cloned operations form a DAG. Return the cloned operations so the
   // leaves come first, and can be cloned in-order into the dispatch region.
@@ -464,6 +474,46 @@ static void getUsedValuesDefinedAboveAfterCloningOps(
   std::swap(reversedValues, valuesDefinedAbove);
 }
 
+/// Swaps the tensor.extract_slice ops of tensor.pad ops within `dispatchOp`,
+/// so that each workgroup only pads the tile it reads instead of materializing
+/// the whole padded tensor.
+static LogicalResult swapExtractSliceOfPadOps(
+    IREE::Flow::DispatchWorkgroupsOp dispatchOp) {
+  MLIRContext *context = dispatchOp.getContext();
+  RewritePatternSet patterns(context);
+  patterns.insert<linalg::ExtractSliceOfPadTensorSwapPattern>(context);
+  return applyPatternsAndFoldGreedily(dispatchOp.body(), std::move(patterns));
+}
+
+/// Follows |dest| back through the destinations of in-place updates (such as
+/// tensor.insert_slice or the outs of linalg ops) to the
+/// flow.dispatch.tensor.load it originates from. Values updated along the way
+/// must have no other uses so that nothing observes them after the update.
+/// Returns nullptr if |dest| does not originate from a load.
+static IREE::Flow::DispatchTensorLoadOp getDestinationLoadOp(Value dest) {
+  while (dest) {
+    if (auto loadOp = dest.getDefiningOp<IREE::Flow::DispatchTensorLoadOp>()) {
+      return loadOp;
+    }
+    Operation *updateOp = dest.getDefiningOp();
+    if (!updateOp || !dest.hasOneUse()) return nullptr;
+    dest = TypeSwitch<Operation *, Value>(updateOp)
+               .Case<tensor::InsertSliceOp>(
+                   [&](tensor::InsertSliceOp insertOp) -> Value {
+                     return insertOp.dest();
+                   })
+               .Case<linalg::LinalgOp, IREE::LinalgExt::LinalgExtOp>(
+                   [&](auto linalgLikeOp) -> Value {
+                     unsigned resultIndex =
+                         dest.cast<OpResult>().getResultNumber();
+                     return linalgLikeOp.getOutputTensorOperands()[resultIndex]
+                         ->get();
+                   })
+               .Default([&](Operation *) -> Value { return nullptr; });
+  }
+  return nullptr;
+}
+
 /// Returns the tied operand for the given `resultArg`. Returns nullptr if error
 /// or not found.
 static BlockArgument getTiedOperandBlockArgument(BlockArgument resultArg) {
@@ -490,9 +540,7 @@ static BlockArgument getTiedOperandBlockArgument(BlockArgument resultArg) {
       TypeSwitch<Operation *, BlockArgument>(tieOp)
           .Case<tensor::InsertSliceOp>([&](tensor::InsertSliceOp insertOp)
                                            -> BlockArgument {
-            auto loadOp =
-                insertOp.dest()
-                    .template getDefiningOp<IREE::Flow::DispatchTensorLoadOp>();
+            auto loadOp = getDestinationLoadOp(insertOp.dest());
             if (!loadOp) return nullptr;
             return loadOp.source().dyn_cast<BlockArgument>();
           })
@@ -513,10 +561,8 @@ static BlockArgument getTiedOperandBlockArgument(BlockArgument resultArg) {
                                                   -> BlockArgument {
             unsigned resultIndex =
                 storeOp.value().cast<OpResult>().getResultNumber();
-            auto loadOp =
-                linalgLikeOp.getOutputTensorOperands()[resultIndex]
-                    ->get()
-                    .template getDefiningOp<IREE::Flow::DispatchTensorLoadOp>();
+            auto loadOp = getDestinationLoadOp(
+                linalgLikeOp.getOutputTensorOperands()[resultIndex]->get());
             if (!loadOp) return nullptr;
             return loadOp.source().template dyn_cast<BlockArgument>();
           })
@@ -895,8 +941,10 @@ struct TiledOpInterfacePattern
 /// with name `kFusionGroupsAttr`). Each dispatchable operation can be marked to
 /// fuse with multiple root operations (i.e. replicated). For now a very simple
 /// heuristic is used below, but the mechanism should be general enough to
-/// capture any heuristic.
-static unsigned decideFusableLinalgOps(FunctionOpInterface funcOp) {
+/// capture any heuristic. Legal fusions of roots with their consumers are
+/// only performed if |costModel| deems them profitable.
+static unsigned decideFusableLinalgOps(FunctionOpInterface funcOp,
+                                       FusionCostModel &costModel) {
   unsigned numRootOps = 0;
   MLIRContext *context = funcOp->getContext();
   OpBuilder builder(context);
@@ -958,6 +1006,7 @@ static unsigned decideFusableLinalgOps(FunctionOpInterface funcOp) {
                 return !consumer.getTiedIndexingMap(operand).isIdentity();
               }))
         continue;
+      if (!costModel.shouldFuseRootConsumer(linalgOp, consumer)) continue;
       int64_t rootNumber = getRootNumber(op);
       setRootAttribute(context, user, rootNumber);
       removeRootOpAttribute(op);
@@ -1117,6 +1166,13 @@ LogicalResult createDispatchRegionsFromRootOps(mlir::Operation *funcOp) {
           .wasInterrupted()) {
     return failure();
   }
+  if (funcOp
+          ->walk([&](IREE::Flow::DispatchWorkgroupsOp op) -> WalkResult {
+            return swapExtractSliceOfPadOps(op);
+          })
+          .wasInterrupted()) {
+    return failure();
+  }
 
   LLVM_DEBUG({
     llvm::dbgs() << "\n--- After dispatch op legalization ---\n";
@@ -1133,7 +1189,12 @@ void DispatchLinalgOnTensorsPass::runOnOperation() {
   MLIRContext *context = funcOp->getContext();
   context->allowUnregisteredDialects(true);
 
-  unsigned numRoots = decideFusableLinalgOps(funcOp);
+  std::unique_ptr<FusionCostModel> costModel = createFusionCostModel();
+  if (!costModel) {
+    funcOp->emitError() << "unknown --iree-flow-fusion-cost-model";
+    return signalPassFailure();
+  }
+  unsigned numRoots = decideFusableLinalgOps(funcOp, *costModel);
 
   LLVM_DEBUG({
     llvm::dbgs() << "\n--- After annotating linalg op fusion scheme ---\n";
@@ -9,10 +9,14 @@
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "llvm/ADT/DenseSet.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/Pass/Pass.h"
 
 namespace mlir {
@@ -24,6 +28,12 @@ namespace Flow {
 // placeholder constant inputs instead of arguments and removes the exported
 // attribute from the old functions.
 // The input are provided using util.globals.
+//
+// Additionally exports one function per flow.executable that performs a single
+// statically-shaped dispatch to it with placeholder inputs. These functions
+// carry the approximate number of bytes accessed and floating-point operations
+// performed by the dispatch in their reflection metadata so that the benchmark
+// tool can report throughput for each dispatch.
 class ExportBenchmarkFuncsPass
     : public ExportBenchmarkFuncsBase<ExportBenchmarkFuncsPass> {
  public:
@@ -43,12 +53,34 @@ class ExportBenchmarkFuncsPass
         entryFuncOps.push_back(entryFuncOp);
       }
     }
+
+    // Find one dispatch per executable that we are able to replay in isolation.
+    // Executables have been deduplicated so the first dispatch found is as good
+    // as any other.
+    SmallVector<DispatchOp> dispatchOps;
+    llvm::DenseSet<StringRef> seenExecutables;
+    for (auto funcOp : moduleOp.getOps<mlir::FuncOp>()) {
+      funcOp.walk([&](DispatchOp dispatchOp) {
+        auto executableName = dispatchOp.entry_point().getRootReference();
+        if (seenExecutables.contains(executableName.getValue())) return;
+        if (!isReplayableDispatch(dispatchOp)) return;
+        seenExecutables.insert(executableName.getValue());
+        dispatchOps.push_back(dispatchOp);
+      });
+    }
+
     for (auto entryFuncOp : entryFuncOps) {
       if (failed(createEntryPointBenchmarkFunc(moduleOp, entryFuncOp))) {
         signalPassFailure();
         return;
       }
     }
+    for (auto dispatchOp : dispatchOps) {
+      if (failed(createDispatchBenchmarkFunc(moduleOp, dispatchOp))) {
+        signalPassFailure();
+        return;
+      }
+    }
   }
 
  private:
@@ -122,6 +154,144 @@ class ExportBenchmarkFuncsPass
     return success();
   }
 
+  // Returns true if |dispatchOp| can be replayed with placeholder inputs: all
+  // shapes must be static and all non-tensor operands must be constants.
+  static bool isReplayableDispatch(DispatchOp dispatchOp) {
+    if (!dispatchOp.operand_dims().empty() ||
+        !dispatchOp.result_dims().empty()) {
+      return false;
+    }
+    for (auto value : dispatchOp.workgroup_count()) {
+      if (!matchPattern(value, m_Constant())) return false;
+    }
+    for (auto operand : dispatchOp.operands()) {
+      if (auto tensorType = operand.getType().dyn_cast<RankedTensorType>()) {
+        if (!tensorType.hasStaticShape()) return false;
+      } else if (!matchPattern(operand, m_Constant())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Returns the total number of bytes of all tensor operands and results.
+  static int64_t estimateDispatchBytes(DispatchOp dispatchOp) {
+    int64_t totalBytes = 0;
+    auto addBytes = [&](Type type) {
+      auto tensorType = type.dyn_cast<RankedTensorType>();
+      if (!tensorType || !tensorType.getElementType().isIntOrFloat()) return;
+      totalBytes += tensorType.getNumElements() *
+                    IREE::Util::getRoundedElementByteWidth(
+                        tensorType.getElementType());
+    };
+    for (auto type : dispatchOp.operands().getTypes()) addBytes(type);
+    for (auto type : dispatchOp.getResultTypes()) addBytes(type);
+    return totalBytes;
+  }
+
+  // Returns an estimate of the floating-point operations performed by all
+  // linalg ops within |executableOp|: the number of scalar ops in each payload
+  // multiplied by the iteration space size. Ops with dynamic iteration spaces
+  // are ignored.
+  static int64_t estimateExecutableFlops(ExecutableOp executableOp) {
+    int64_t totalFlops = 0;
+    executableOp.walk([&](linalg::LinalgOp linalgOp) {
+      auto staticLoopRanges = linalgOp.getStaticLoopRanges();
+      if (!staticLoopRanges) return;
+      int64_t iterationCount = 1;
+      for (int64_t range : *staticLoopRanges) {
+        if (ShapedType::isDynamic(range)) return;
+        iterationCount *= range;
+      }
+      int64_t payloadOpCount = 0;
+      for (auto& op : linalgOp->getRegion(0).front().without_terminator()) {
+        if (llvm::any_of(op.getResultTypes(), [](Type type) {
+              return type.isa<FloatType>();
+            })) {
+          ++payloadOpCount;
+        }
+      }
+      totalFlops += iterationCount * payloadOpCount;
+    });
+    return totalFlops;
+  }
+
+  LogicalResult createDispatchBenchmarkFunc(mlir::ModuleOp moduleOp,
+                                            DispatchOp dispatchOp) {
+    auto executableOp = SymbolTable::lookupNearestSymbolFrom<ExecutableOp>(
+        moduleOp, dispatchOp.entry_point().getRootReference());
+    if (!executableOp) return dispatchOp.emitOpError("unknown executable");
+
+    OpBuilder moduleBuilder(&getContext());
+    moduleBuilder.setInsertionPointToEnd(moduleOp.getBody());
+
+    // Create one dummy input variable per unique tensor operand.
+    Location loc = dispatchOp.getLoc();
+    llvm::SmallDenseMap<Value, IREE::Util::GlobalOp> dummyInputVariableOps;
+    for (auto operand : dispatchOp.operands()) {
+      if (!operand.getType().isa<RankedTensorType>() ||
+          dummyInputVariableOps.count(operand)) {
+        continue;
+      }
+      auto dummyVar =
+          createDummyInputVariableOp(loc, operand.getType(), moduleBuilder);
+      if (!dummyVar) return failure();
+      dummyInputVariableOps[operand] = dummyVar;
+    }
+
+    // Create a `() -> ()` entry point op the benchmark tool can run.
+    std::string funcName = std::string(executableOp.getName()) + "_benchmark";
+    auto funcOp = moduleBuilder.create<mlir::FuncOp>(
+        loc, funcName, moduleBuilder.getFunctionType({}, {}));
+    funcOp.setPublic();
+    funcOp->setAttr("iree.abi.stub", moduleBuilder.getUnitAttr());
+    SmallVector<NamedAttribute> reflectionAttrs = {
+        moduleBuilder.getNamedAttr("benchmark",
+                                   moduleBuilder.getStringAttr("dispatch")),
+        moduleBuilder.getNamedAttr(
+            "bytes", moduleBuilder.getStringAttr(
+                         std::to_string(estimateDispatchBytes(dispatchOp)))),
+    };
+    int64_t flops = estimateExecutableFlops(executableOp);
+    if (flops > 0) {
+      reflectionAttrs.push_back(moduleBuilder.getNamedAttr(
+          "flops", moduleBuilder.getStringAttr(std::to_string(flops))));
+    }
+    funcOp->setAttr("iree.reflection",
+                    moduleBuilder.getDictionaryAttr(reflectionAttrs));
+    Block* block = funcOp.addEntryBlock();
+
+    // Rematerialize the constant operands and load the dummy tensor operands.
+    auto blockBuilder = OpBuilder::atBlockBegin(block);
+    BlockAndValueMapping mapping;
+    auto mapConstant = [&](Value value) {
+      if (mapping.contains(value)) return;
+      auto* clonedOp = blockBuilder.clone(*value.getDefiningOp());
+      mapping.map(value, clonedOp->getResult(0));
+    };
+    for (auto value : dispatchOp.workgroup_count()) mapConstant(value);
+    for (auto operand : dispatchOp.operands()) {
+      auto dummyVar = dummyInputVariableOps.lookup(operand);
+      if (!dummyVar) {
+        mapConstant(operand);
+      } else if (!mapping.contains(operand)) {
+        mapping.map(operand,
+                    blockBuilder.createOrFold<IREE::Util::GlobalLoadOp>(
+                        loc, dummyVar));
+      }
+    }
+
+    // Dispatch and sink all results with do_not_optimize to ensure that DCE
+    // does not remove the dispatch.
+    auto* clonedOp = blockBuilder.clone(*dispatchOp.getOperation(), mapping);
+    for (auto result : clonedOp->getResults()) {
+      blockBuilder.create<IREE::Util::DoNotOptimizeOp>(loc, result);
+    }
+    blockBuilder.create<mlir::ReturnOp>(loc);
+
+    return success();
+  }
+
   int uniqueId = 0;
 };
 
@@ -0,0 +1,315 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/Transforms/FusionCostModel.h"
+
+#include <mutex>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MathExtras.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Diagnostics.h"
+
+static llvm::cl::opt<std::string> clFusionCostModel(
+    "iree-flow-fusion-cost-model",
+    llvm::cl::desc("Cost model deciding which tensor ops are fused into the "
+                   "same dispatch region (heuristic, roofline-cpu, "
+                   "roofline-gpu or a target registered model)"),
+    llvm::cl::init("heuristic"));
+
+static llvm::cl::opt<double> clFusionMachineBalance(
+    "iree-flow-fusion-machine-balance",
+    llvm::cl::desc("Overrides the number of scalar ops the target can execute "
+                   "in the time it takes to move one byte to or from memory in "
+                   "the roofline fusion cost models"),
+    llvm::cl::init(0.0));
+
+static llvm::cl::opt<int64_t> clFusionMaxBodyOps(
+    "iree-flow-fusion-max-body-ops",
+    llvm::cl::desc("Overrides the maximum number of payload ops of a fused op "
+                   "in the roofline fusion cost models"),
+    llvm::cl::init(0));
+
+static llvm::cl::opt<bool> clFusionRemarks(
+    "iree-flow-fusion-remarks",
+    llvm::cl::desc("Emits a remark explaining each fusion cost model decision"),
+    llvm::cl::init(false));
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+/// Extent assumed for dynamic dimensions when estimating costs.
+static constexpr int64_t kAssumedDynamicDimSize = 64;
+
+static int64_t estimateNumElements(ArrayRef<int64_t> shape) {
+  int64_t numElements = 1;
+  for (int64_t dim : shape) {
+    numElements *= ShapedType::isDynamic(dim) ? kAssumedDynamicDimSize : dim;
+  }
+  return numElements;
+}
+
+static int64_t getNumUsers(OpResult result) {
+  return std::distance(result.getUsers().begin(), result.getUsers().end());
+}
+
+bool FusionCostModel::shouldFuseElementwiseProducer(
+    OpResult producerResult, OpOperand &consumerOperand) {
+  FusionDecision decision =
+      decideElementwiseProducer(producerResult, consumerOperand);
+  explain("producer", producerResult.getOwner(), consumerOperand.getOwner(),
+          decision);
+  return decision.fuse;
+}
+
+bool FusionCostModel::shouldFuseRootConsumer(linalg::LinalgOp root,
+                                             linalg::LinalgOp consumer) {
+  FusionDecision decision = decideRootConsumer(root, consumer);
+  explain("root", root, consumer, decision);
+  return decision.fuse;
+}
+
+void FusionCostModel::explain(StringRef kind, Operation *producer,
+                              Operation *consumer,
+                              const FusionDecision &decision) {
+  if (!clFusionRemarks) return;
+  consumer->emitRemark() << "fusion cost model '" << name << "': "
+                         << (decision.fuse ? "fusing " : "not fusing ") << kind
+                         << " '" << producer->getName() << "': "
+                         << decision.reason;
+}
+
+// static
+int64_t FusionCostModel::estimateByteSize(Type type) {
+  auto shapedType = type.dyn_cast<ShapedType>();
+  Type elementType = shapedType ? shapedType.getElementType() : type;
+  int64_t bitWidth =
+      elementType.isIntOrFloat() ? elementType.getIntOrFloatBitWidth() : 32;
+  int64_t numElements = shapedType && shapedType.hasRank()
+                            ? estimateNumElements(shapedType.getShape())
+                            : 1;
+  return numElements * llvm::divideCeil(bitWidth, 8);
+}
+
+// static
+FusionCostModel::OpCost FusionCostModel::estimateCost(Operation *op) {
+  OpCost cost;
+  for (Type type : op->getResultTypes()) {
+    cost.bytesWritten += estimateByteSize(type);
+  }
+  auto linalgOp = dyn_cast<linalg::LinalgOp>(op);
+  if (!linalgOp) {
+    for (Value operand : op->getOperands()) {
+      cost.bytesRead += estimateByteSize(operand.getType());
+    }
+    return cost;
+  }
+  for (OpOperand *operand : linalgOp.getInputOperands()) {
+    cost.bytesRead += estimateByteSize(operand->get().getType());
+  }
+  // The terminator is not counted.
+  cost.bodyOps =
+      std::max<int64_t>(linalgOp.getBlock()->getOperations().size() - 1, 0);
+  cost.computeOps =
+      estimateNumElements(linalgOp.getStaticLoopRanges()) * cost.bodyOps;
+  return cost;
+}
+
+namespace {
+
+/// Fixed rules that never recompute expensive ops: a producer is only fused
+/// into its consumer if it has a single use or is cheap to recompute (a
+/// broadcast, a constant or produces i1 values). Consumers are always fused
+/// with roots.
+class HeuristicFusionCostModel : public FusionCostModel {
+ public:
+  HeuristicFusionCostModel() : FusionCostModel("heuristic") {}
+
+ protected:
+  FusionDecision decideElementwiseProducer(
+      OpResult producerResult, OpOperand &consumerOperand) override {
+    Operation *producer = producerResult.getOwner();
+    // Detect op that only broadcast input as fusing them makes the new op
+    // cheaper.
+    if (auto genericOp = dyn_cast<linalg::GenericOp>(producer)) {
+      if (genericOp.getNumParallelLoops() == genericOp.getNumLoops() &&
+          isa<linalg::YieldOp>(genericOp.getBody()->front())) {
+        for (OpOperand *opOperand : genericOp.getInputOperands()) {
+          AffineMap indexingMap = genericOp.getTiedIndexingMap(opOperand);
+          if (indexingMap.isProjectedPermutation() &&
+              indexingMap.getNumDims() != indexingMap.getNumResults()) {
+            return {true, "producer is a broadcast"};
+          }
+        }
+      }
+    }
+    if (isa<arith::ConstantOp>(producer)) {
+      return {true, "producer is a constant"};
+    }
+    bool hasI1ReturnType = llvm::any_of(producer->getResultTypes(), [](Type t) {
+      if (t.isInteger(1)) return true;
+      if (auto shapedType = t.dyn_cast<ShapedType>()) {
+        if (shapedType.getElementType().isInteger(1)) return true;
+      }
+      return false;
+    });
+    if (hasI1ReturnType) return {true, "producer returns i1 values"};
+    // Only fuse if it has a single user. It is a simplistic heuristic to
+    // avoid duplicating ops that may be expensive.
+    if (!llvm::hasSingleElement(producerResult.getUsers())) {
+      return {false, "producer has multiple users and would be recomputed"};
+    }
+    return {true, "producer has a single user"};
+  }
+
+  FusionDecision decideRootConsumer(linalg::LinalgOp root,
+                                    linalg::LinalgOp consumer) override {
+    return {true, "consumer is elementwise"};
+  }
+};
+
+/// Weighs the memory traffic removed by fusion against the compute that is
+/// duplicated when a producer is recomputed in multiple consumers. Compute is
+/// converted to bytes using the machine balance of the target: the number of
+/// scalar ops that can be executed in the time it takes to move one byte.
+/// Fused ops whose payloads exceed a size budget are rejected as they are
+/// likely to spill registers.
+class RooflineFusionCostModel : public FusionCostModel {
+ public:
+  RooflineFusionCostModel(StringRef name, double defaultMachineBalance,
+                          int64_t defaultMaxFusedBodyOps)
+      : FusionCostModel(name),
+        machineBalance(clFusionMachineBalance > 0.0
+                           ? clFusionMachineBalance.getValue()
+                           : defaultMachineBalance),
+        maxFusedBodyOps(clFusionMaxBodyOps > 0 ? clFusionMaxBodyOps.getValue()
+                                               : defaultMaxFusedBodyOps) {}
+
+ protected:
+  FusionDecision decideElementwiseProducer(
+      OpResult producerResult, OpOperand &consumerOperand) override {
+    OpCost producerCost = estimateCost(producerResult.getOwner());
+    OpCost consumerCost = estimateCost(consumerOperand.getOwner());
+    if (Optional<FusionDecision> decision =
+            checkFusedBodyOps(producerCost, consumerCost)) {
+      return *decision;
+    }
+
+    // Fusion removes the write of the intermediate and its read by each user
+    // but each user then reads the producer inputs and recomputes it.
+    int64_t numUsers = getNumUsers(producerResult);
+    int64_t bytesSaved = estimateByteSize(producerResult.getType()) *
+                             (1 + numUsers) -
+                         producerCost.bytesRead * (numUsers - 1);
+    int64_t duplicatedOps = producerCost.computeOps * (numUsers - 1);
+    if (bytesSaved <= 0) {
+      return {false,
+              llvm::formatv("fusion into {0} users increases memory traffic "
+                            "by {1} bytes",
+                            numUsers, -bytesSaved)
+                  .str()};
+    }
+    if (duplicatedOps > bytesSaved * machineBalance) {
+      return {false, llvm::formatv("recomputing {0} ops costs more than the "
+                                   "{1} bytes of memory traffic saved",
+                                   duplicatedOps, bytesSaved)
+                         .str()};
+    }
+    return {true, llvm::formatv("saves {0} bytes of memory traffic and "
+                                "recomputes {1} ops",
+                                bytesSaved, duplicatedOps)
+                       .str()};
+  }
+
+  FusionDecision decideRootConsumer(linalg::LinalgOp root,
+                                    linalg::LinalgOp consumer) override {
+    OpCost rootCost = estimateCost(root);
+    OpCost consumerCost = estimateCost(consumer);
+    if (Optional<FusionDecision> decision =
+            checkFusedBodyOps(rootCost, consumerCost)) {
+      return *decision;
+    }
+    // The root result is consumed in registers instead of being written and
+    // read back; nothing is recomputed.
+    return {true,
+            llvm::formatv("saves {0} bytes of memory traffic",
+                          2 * estimateByteSize(root->getResult(0).getType()))
+                .str()};
+  }
+
+ private:
+  Optional<FusionDecision> checkFusedBodyOps(const OpCost &producerCost,
+                                             const OpCost &consumerCost) {
+    int64_t fusedBodyOps = producerCost.bodyOps + consumerCost.bodyOps;
+    if (fusedBodyOps <= maxFusedBodyOps) return llvm::None;
+    return FusionDecision{
+        false, llvm::formatv("fused payload would have {0} ops, exceeding the "
+                             "budget of {1}",
+                             fusedBodyOps, maxFusedBodyOps)
+                   .str()};
+  }
+
+  double machineBalance;
+  int64_t maxFusedBodyOps;
+};
+
+struct FusionCostModelRegistry {
+  FusionCostModelRegistry() {
+    factories["heuristic"] = []() {
+      return std::make_unique<HeuristicFusionCostModel>();
+    };
+    // CPUs sustain roughly an order of magnitude more flops than bytes of
+    // DRAM bandwidth and have large register files relative to a thread.
+    factories["roofline-cpu"] = []() {
+      return std::make_unique<RooflineFusionCostModel>(
+          "roofline-cpu", /*machineBalance=*/8.0, /*maxFusedBodyOps=*/128);
+    };
+    // GPUs are more compute rich but spilling reduces occupancy sooner.
+    factories["roofline-gpu"] = []() {
+      return std::make_unique<RooflineFusionCostModel>(
+          "roofline-gpu", /*machineBalance=*/32.0, /*maxFusedBodyOps=*/64);
+    };
+  }
+
+  std::mutex mutex;
+  llvm::StringMap<FusionCostModelFactory> factories;
+};
+
+FusionCostModelRegistry &getRegistry() {
+  static FusionCostModelRegistry registry;
+  return registry;
+}
+
+}  // namespace
+
+void registerFusionCostModel(StringRef name, FusionCostModelFactory factory) {
+  auto &registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.factories[name] = std::move(factory);
+}
+
+std::unique_ptr<FusionCostModel> createFusionCostModel(StringRef name) {
+  auto &registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto it = registry.factories.find(name);
+  if (it == registry.factories.end()) return nullptr;
+  return it->second();
+}
+
+std::unique_ptr<FusionCostModel> createFusionCostModel() {
+  return createFusionCostModel(clFusionCostModel);
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
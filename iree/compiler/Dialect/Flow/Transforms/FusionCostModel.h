@@ -0,0 +1,110 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_FLOW_TRANSFORMS_FUSIONCOSTMODEL_H_
+#define IREE_COMPILER_DIALECT_FLOW_TRANSFORMS_FUSIONCOSTMODEL_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/IR/Operation.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+/// Result of a fusion query along with a human readable explanation of why
+/// the decision was made.
+struct FusionDecision {
+  bool fuse = false;
+  std::string reason;
+};
+
+/// Decides which legal fusions of tensor ops are profitable when forming
+/// dispatch regions. Callers check that a fusion is legal (and within hard
+/// limits such as the number of bindings) before querying the model; the
+/// model only weighs the benefit of fusing against its cost.
+///
+/// Decisions are explained as remarks on the consumer op when
+/// `--iree-flow-fusion-remarks` is set.
+class FusionCostModel {
+ public:
+  /// Estimated cost of executing a single op in isolation.
+  struct OpCost {
+    /// Number of scalar operations executed.
+    int64_t computeOps = 0;
+    /// Bytes read from the op inputs (excluding init tensors).
+    int64_t bytesRead = 0;
+    /// Bytes written to the op results.
+    int64_t bytesWritten = 0;
+    /// Number of ops in the payload region; a proxy for register pressure.
+    int64_t bodyOps = 0;
+  };
+
+  explicit FusionCostModel(StringRef name) : name(name.str()) {}
+  virtual ~FusionCostModel() = default;
+
+  StringRef getName() const { return name; }
+
+  /// Returns true if the elementwise |producerResult| should be fused into
+  /// the consumer owning |consumerOperand|. Producers with multiple users are
+  /// recomputed in each consumer they are fused into.
+  bool shouldFuseElementwiseProducer(OpResult producerResult,
+                                     OpOperand &consumerOperand);
+
+  /// Returns true if the elementwise |consumer| should be fused into the
+  /// dispatch region formed around the |root| op.
+  bool shouldFuseRootConsumer(linalg::LinalgOp root, linalg::LinalgOp consumer);
+
+  /// Estimates the cost of |op|. Dynamic dimensions are assumed to have a
+  /// fixed extent.
+  static OpCost estimateCost(Operation *op);
+
+  /// Returns the estimated number of bytes of a value of |type|.
+  static int64_t estimateByteSize(Type type);
+
+ protected:
+  virtual FusionDecision decideElementwiseProducer(
+      OpResult producerResult, OpOperand &consumerOperand) = 0;
+  virtual FusionDecision decideRootConsumer(linalg::LinalgOp root,
+                                            linalg::LinalgOp consumer) = 0;
+
+ private:
+  void explain(StringRef kind, Operation *producer, Operation *consumer,
+               const FusionDecision &decision);
+
+  std::string name;
+};
+
+using FusionCostModelFactory =
+    std::function<std::unique_ptr<FusionCostModel>()>;
+
+/// Registers a cost model that can be selected by |name| with
+/// `--iree-flow-fusion-cost-model`. Targets with different compute to
+/// bandwidth ratios may register their own models.
+void registerFusionCostModel(StringRef name, FusionCostModelFactory factory);
+
+/// Creates the registered cost model named |name| or returns nullptr if there
+/// is none. Builtin models are:
+///   heuristic: fixed rules avoiding any recomputation (the default).
+///   roofline-cpu, roofline-gpu: weigh the memory traffic saved by fusion
+///     against the compute duplicated and the size of the fused payload using
+///     the machine balance of the respective targets.
+std::unique_ptr<FusionCostModel> createFusionCostModel(StringRef name);
+
+/// Creates the cost model selected with `--iree-flow-fusion-cost-model`.
+std::unique_ptr<FusionCostModel> createFusionCostModel();
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_DIALECT_FLOW_TRANSFORMS_FUSIONCOSTMODEL_H_
@@ -12,6 +12,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "iree/compiler/Dialect/Flow/Transforms/FusionCostModel.h"
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
@@ -47,11 +48,19 @@ struct FusionOfTensorOpsPass
     Operation *op = getOperation();
     MLIRContext *context = op->getContext();
 
+    std::unique_ptr<FusionCostModel> costModel = createFusionCostModel();
+    if (!costModel) {
+      op->emitError() << "unknown --iree-flow-fusion-cost-model";
+      return signalPassFailure();
+    }
+
     // Only fuse operations where all uses of the producer are generic
     // operations. If an operation is used in a named op, it will be computed
-    // anyway, so the consumers can just use that value.
+    // anyway, so the consumers can just use that value. Whether legal fusions
+    // are profitable is left to the cost model.
     linalg::ControlElementwiseOpsFusionFn controlFn =
-        [](const OpResult &producerResult, OpOperand &consumerOperand) {
+        [&costModel](const OpResult &producerResult,
+                     OpOperand &consumerOperand) {
           Operation *producer = producerResult.getOwner();
           Operation *consumer = consumerOperand.getOwner();
 
@@ -79,42 +88,13 @@ struct FusionOfTensorOpsPass
                           consumer->operand_end());
           if (operands.size() >= kIreeMaxOperandCount) return false;
 
-          bool isBroadcast = false;
-          if (auto genericOp = dyn_cast<linalg::GenericOp>(producer)) {
-            // Detect op that only broadcast input as fusing them makes the new
-            // op cheaper.
-            if (genericOp.getNumParallelLoops() == genericOp.getNumLoops() &&
-                isa<linalg::YieldOp>(genericOp.getBody()->front())) {
-              for (OpOperand *opOperand : genericOp.getInputOperands()) {
-                AffineMap indexingMap = genericOp.getTiedIndexingMap(opOperand);
-                if (indexingMap.isProjectedPermutation() &&
-                    indexingMap.getNumDims() != indexingMap.getNumResults()) {
-                  isBroadcast = true;
-                  break;
-                }
-              }
-            }
-          }
-          // Only fuse if it has a single linalg generic user. It is a
-          // simplistic heuristic to avoid duplicating ops that may be
-          // expensive.
-          // TODO: Add a cost model to allow ops to be duplicated.
-          bool hasI1ReturnType =
-              llvm::any_of(producer->getResultTypes(), [](Type t) {
-                if (t.isInteger(1)) return true;
-                if (auto shapedType = t.dyn_cast<ShapedType>()) {
-                  if (shapedType.getElementType().isInteger(1)) return true;
-                }
-                return false;
-              });
-          if (!isBroadcast && !isa<arith::ConstantOp>(producer) &&
-              !hasI1ReturnType &&
-              !llvm::hasSingleElement(producerResult.getUsers())) {
+          if (!llvm::all_of(producerResult.getUsers(), [](Operation *user) {
+                return isa<linalg::GenericOp>(user);
+              })) {
             return false;
           }
-          return llvm::all_of(producerResult.getUsers(), [](Operation *user) {
-            return isa<linalg::GenericOp>(user);
-          });
+          return costModel->shouldFuseElementwiseProducer(producerResult,
+                                                          consumerOperand);
         };
     // Simple heuristic to decide if reshaope should be folded in the linalg.
     // If the source of the reshape is a linalg op fold to potentially allow the
@@ -0,0 +1,195 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===--- HorizontalFusion.cpp - Merges independent elementwise ops --------===//
+//
+// Merges independent elementwise linalg.generic ops that share an iteration
+// space into a single multi-result linalg.generic. Each such op would
+// otherwise form its own dispatch region; models with many parallel branches
+// (such as the heads of multi-head attention) end up with many tiny
+// dispatches that each pay launch overhead and underutilize the device.
+// The merged op is dispatched once with a workload covering all of them.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+
+#define DEBUG_TYPE "iree-flow-horizontal-fusion"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Hard limit of bindings passed down to HAL; matches
+// IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT.
+constexpr int64_t kIreeMaxOperandCount = 32;
+
+/// Returns true if |op| is an elementwise op that may be merged with others.
+/// Only ops with static iteration spaces are merged as the dispatch workload
+/// of the merged op must cover the iteration space of every merged op.
+static bool isHorizontalFusionCandidate(linalg::GenericOp op) {
+  if (!op.hasTensorSemantics()) return false;
+  if (op.getNumLoops() != op.getNumParallelLoops()) return false;
+  if (op->getParentOfType<DispatchWorkgroupsOp>()) return false;
+  return llvm::none_of(op.getStaticLoopRanges(), [](int64_t size) {
+    return ShapedType::isDynamic(size);
+  });
+}
+
+/// Returns true if |first| and the later op |second| in the same block can be
+/// merged into a single op at the position of |second|.
+static bool canMergeGenericOps(linalg::GenericOp first,
+                               linalg::GenericOp second) {
+  if (first.getStaticLoopRanges() != second.getStaticLoopRanges()) {
+    return false;
+  }
+
+  DenseSet<Value> operands;
+  operands.insert(first->operand_begin(), first->operand_end());
+  operands.insert(second->operand_begin(), second->operand_end());
+  if (operands.size() + first->getNumResults() + second->getNumResults() >=
+      kIreeMaxOperandCount) {
+    return false;
+  }
+
+  // The merged op replaces the results of |first| at the position of
+  // |second| so all users must come after it. This also ensures that
+  // |second| does not (transitively) depend on |first|.
+  Block *block = second->getBlock();
+  return llvm::all_of(first->getUsers(), [&](Operation *user) {
+    Operation *ancestor = block->findAncestorOpInBlock(*user);
+    return ancestor && second->isBeforeInBlock(ancestor);
+  });
+}
+
+/// Merges |first| and |second| into a single generic op computing the results
+/// of both and replaces them with it.
+static linalg::GenericOp mergeGenericOps(OpBuilder &builder,
+                                         linalg::GenericOp first,
+                                         linalg::GenericOp second) {
+  SmallVector<Value> inputs;
+  SmallVector<Value> outputs;
+  SmallVector<AffineMap> indexingMaps;
+  SmallVector<Type> resultTypes;
+  for (linalg::GenericOp op : {first, second}) {
+    for (OpOperand *operand : op.getInputOperands()) {
+      inputs.push_back(operand->get());
+      indexingMaps.push_back(op.getTiedIndexingMap(operand));
+    }
+  }
+  for (linalg::GenericOp op : {first, second}) {
+    for (OpOperand *operand : op.getOutputOperands()) {
+      outputs.push_back(operand->get());
+      indexingMaps.push_back(op.getTiedIndexingMap(operand));
+    }
+    llvm::append_range(resultTypes, op->getResultTypes());
+  }
+  SmallVector<StringRef> iteratorTypes(first.getNumLoops(),
+                                       getParallelIteratorTypeName());
+
+  builder.setInsertionPoint(second);
+  auto fusedLoc = builder.getFusedLoc({first.getLoc(), second.getLoc()});
+  auto mergedOp = builder.create<linalg::GenericOp>(
+      fusedLoc, resultTypes, inputs, outputs, indexingMaps, iteratorTypes,
+      [&](OpBuilder &nestedBuilder, Location nestedLoc, ValueRange args) {
+        // Block arguments are ordered as all inputs followed by all outputs.
+        unsigned numInputs = first.getNumInputs() + second.getNumInputs();
+        unsigned inputOffset = 0;
+        unsigned outputOffset = numInputs;
+        BlockAndValueMapping mapping;
+        SmallVector<Value> yieldedValues;
+        for (linalg::GenericOp op : {first, second}) {
+          Block *body = op.getBody();
+          for (unsigned i = 0; i < op.getNumInputs(); ++i) {
+            mapping.map(body->getArgument(i), args[inputOffset + i]);
+          }
+          for (unsigned i = 0; i < op.getNumOutputs(); ++i) {
+            mapping.map(body->getArgument(op.getNumInputs() + i),
+                        args[outputOffset + i]);
+          }
+          inputOffset += op.getNumInputs();
+          outputOffset += op.getNumOutputs();
+          for (Operation &bodyOp : body->without_terminator()) {
+            nestedBuilder.clone(bodyOp, mapping);
+          }
+          for (Value value : body->getTerminator()->getOperands()) {
+            yieldedValues.push_back(mapping.lookupOrDefault(value));
+          }
+        }
+        nestedBuilder.create<linalg::YieldOp>(nestedLoc, yieldedValues);
+      });
+
+  first->replaceAllUsesWith(
+      mergedOp->getResults().take_front(first->getNumResults()));
+  second->replaceAllUsesWith(
+      mergedOp->getResults().drop_front(first->getNumResults()));
+  first->erase();
+  second->erase();
+  return mergedOp;
+}
+
+struct HorizontalFusionPass
+    : public HorizontalFusionBase<HorizontalFusionPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect>();
+  }
+  HorizontalFusionPass() = default;
+  HorizontalFusionPass(const HorizontalFusionPass &pass) {}
+
+  void runOnOperation() override {
+    OpBuilder builder(&getContext());
+    getOperation()->walk([&](Block *block) {
+      SmallVector<linalg::GenericOp> candidates;
+      for (auto op : block->getOps<linalg::GenericOp>()) {
+        if (isHorizontalFusionCandidate(op)) candidates.push_back(op);
+      }
+
+      // Greedily merge each candidate into the earliest merged op it is
+      // compatible with. Candidates are visited in block order so the merged
+      // op always sits at the position of the latest op merged into it.
+      SmallVector<linalg::GenericOp> mergedOps;
+      for (linalg::GenericOp candidate : candidates) {
+        bool merged = false;
+        for (linalg::GenericOp &mergedOp : mergedOps) {
+          if (!canMergeGenericOps(mergedOp, candidate)) continue;
+          LLVM_DEBUG(llvm::dbgs() << "merging " << candidate << "\n  into "
+                                  << mergedOp << "\n");
+          mergedOp = mergeGenericOps(builder, mergedOp, candidate);
+          ++numMergedOps;
+          merged = true;
+          break;
+        }
+        if (!merged) mergedOps.push_back(candidate);
+      }
+    });
+  }
+
+ private:
+  Statistic numMergedOps{this, "number of merged ops",
+                         "Number of elementwise ops merged into another"};
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createHorizontalFusionPass() {
+  return std::make_unique<HorizontalFusionPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
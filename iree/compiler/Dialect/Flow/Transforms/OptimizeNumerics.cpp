@@ -7,6 +7,7 @@
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Debug.h"
 #include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
@@ -148,6 +149,88 @@ struct LinalgFillCast
   }
 };
 
+// Low precision integer types of the operands of a contraction.
+struct LowPContractionTypes {
+  bool isSigned;
+  Type lhsType;
+  Type rhsType;
+  Type accumType;
+};
+
+// Derives the low precision types of a contraction from the narrowing
+// annotations of its operands. Unsigned operands are widened to signed ones
+// when the operands mix signedness or when |requireSigned| is set because the
+// op only exists in a signed flavor.
+LogicalResult deriveLowPContractionTypes(Operation *op,
+                                         PatternRewriter &rewriter,
+                                         NarrowParams &lhsParams,
+                                         NarrowParams &rhsParams,
+                                         NarrowParams &accumParams,
+                                         bool requireSigned,
+                                         LowPContractionTypes &types) {
+  // TODO(#7987): This could be more flexible, allowing mix and match
+  // integer/float types.
+  if (!lhsParams.isFromFloat() || !rhsParams.isFromFloat()) {
+    return rewriter.notifyMatchFailure(op, "not from floating point");
+  }
+
+  // TODO(#7987): Could support partial conversion to integer.
+  if (!lhsParams.isToInteger() || !rhsParams.isToInteger() ||
+      !accumParams.isToInteger()) {
+    return rewriter.notifyMatchFailure(op, "not to an integer type");
+  }
+
+  int lhsBitWidth = lhsParams.getToBitWidth();
+  int rhsBitWidth = rhsParams.getToBitWidth();
+
+  // Handle signed/unsigned mismatch.
+  // TODO(#7987): Implement a proper unsigned->signed widening.
+  bool isSigned;
+  if (requireSigned || lhsParams.isToSigned() != rhsParams.isToSigned()) {
+    // Mixed signed/unsigned. Promote to signed.
+    isSigned = true;
+    if (!lhsParams.isToSigned()) {
+      lhsBitWidth += 1;
+    }
+    if (!rhsParams.isToSigned()) {
+      rhsBitWidth += 1;
+    }
+  } else {
+    // Uniform signed/unsigned.
+    isSigned = lhsParams.isToSigned();
+  }
+
+  // Round up to a suitable POT width.
+  lhsBitWidth = getNextPotBitWidth(lhsBitWidth);
+  rhsBitWidth = getNextPotBitWidth(rhsBitWidth);
+
+  // Promote accumulator to match signedness.
+  int accumBitWidth = accumParams.getToBitWidth();
+  if (isSigned && !accumParams.isToSigned()) {
+    // TODO(#7987): A proper unsigned widening based on range.
+    accumBitWidth += 1;
+  }
+
+  // Determine an appropriate accumulator size.
+  // TODO(#7987): Apply the clamp of:
+  // lhsBitWidth + rhsBitWidth + log2_ceil(contraction_dim + 1) to determine
+  // the accumulator size. Note: Can drop the +1 if one of lhs/rhs is signed
+  // and symmetric (i.e. does not use the asymmetric lower bound).
+  if (lhsBitWidth > 8 || rhsBitWidth > 8) {
+    return rewriter.notifyMatchFailure(op, "outside of low-p range");
+  }
+  accumBitWidth = getNextPotBitWidth(accumBitWidth, 32);
+  if (accumBitWidth > 32) {
+    return rewriter.notifyMatchFailure(op, "accumulator > 32 bits");
+  }
+
+  types.isSigned = isSigned;
+  types.lhsType = makeLowPType(lhsParams.fromType, lhsBitWidth);
+  types.rhsType = makeLowPType(rhsParams.fromType, rhsBitWidth);
+  types.accumType = makeLowPType(accumParams.fromType, accumBitWidth);
+  return success();
+}
+
 // For narrowable inputs, selects
 struct LinalgFpMatmulToLowP : public OpRewritePattern<linalg::MatmulOp> {
   using OpRewritePattern::OpRewritePattern;
@@ -162,74 +245,21 @@ struct LinalgFpMatmulToLowP : public OpRewritePattern<linalg::MatmulOp> {
     if (!lhsParams || !rhsParams || !accumParams) {
       return rewriter.notifyMatchFailure(matmulOp, "no narrowing annotations");
     }
-
-    // TODO(#7987): This could be more flexible, allowing mix and match
-    // integer/float types.
-    if (!lhsParams->isFromFloat() || !rhsParams->isFromFloat()) {
-      return rewriter.notifyMatchFailure(matmulOp, "not from floating point");
-    }
-
-    // TODO(#7987): Could support partial conversion to integer.
-    if (!lhsParams->isToInteger() || !rhsParams->isToInteger() ||
-        !accumParams->isToInteger()) {
-      return rewriter.notifyMatchFailure(matmulOp, "not to an integer type");
+    LowPContractionTypes types;
+    if (failed(deriveLowPContractionTypes(
+            matmulOp, rewriter, *lhsParams, *rhsParams, *accumParams,
+            /*requireSigned=*/false, types))) {
+      return failure();
     }
-
-    int lhsBitWidth = lhsParams->getToBitWidth();
-    int rhsBitWidth = rhsParams->getToBitWidth();
-
-    // Handle signed/unsigned mismatch.
-    // TODO(#7987): Implement a proper unsigned->signed widening.
-    bool isSigned;
-    if (lhsParams->isToSigned() != rhsParams->isToSigned()) {
-      // Mixed signed/unsigned. Promote to signed.
-      isSigned = true;
-      if (!lhsParams->isToSigned()) {
-        lhsBitWidth += 1;
-      }
-      if (!rhsParams->isToSigned()) {
-        rhsBitWidth += 1;
-      }
-    } else {
-      // Uniform signed/unsigned.
-      isSigned = lhsParams->isToSigned();
-    }
-
-    // Round up to a suitable POT width.
-    lhsBitWidth = getNextPotBitWidth(lhsBitWidth);
-    rhsBitWidth = getNextPotBitWidth(rhsBitWidth);
-
-    // Promote accumulator to match signedness.
-    int accumBitWidth = accumParams->getToBitWidth();
-    if (isSigned && !accumParams->isToSigned()) {
-      // TODO(#7987): A proper unsigned widening based on range.
-      accumBitWidth += 1;
-    }
-
-    // Determine an appropriate accumulator size.
-    // TODO(#7987): Apply the clamp of:
-    // lhsBitWidth + rhsBitWidth + log2_ceil(contraction_dim + 1) to determine
-    // the accumulator size. Note: Can drop the +1 if one of lhs/rhs is signed
-    // and symmetric (i.e. does not use the asymmetric lower bound).
-    if (lhsBitWidth > 8 || rhsBitWidth > 8) {
-      return rewriter.notifyMatchFailure(matmulOp, "outside of low-p range");
-    }
-    accumBitWidth = getNextPotBitWidth(accumBitWidth, 32);
-    if (accumBitWidth > 32) {
-      return rewriter.notifyMatchFailure(matmulOp, "accumulator > 32 bits");
-    }
-
-    Type lhsLowPType = makeLowPType(lhsParams->fromType, lhsBitWidth);
-    Type rhsLowPType = makeLowPType(rhsParams->fromType, rhsBitWidth);
-    Type accumLowPType = makeLowPType(accumParams->fromType, accumBitWidth);
+    bool isSigned = types.isSigned;
 
     // Replace the matmul op.
     Value newLhs =
-        castNumeric(lhsParams->producer, lhsLowPType, isSigned, rewriter);
+        castNumeric(lhsParams->producer, types.lhsType, isSigned, rewriter);
     Value newRhs =
-        castNumeric(rhsParams->producer, rhsLowPType, isSigned, rewriter);
+        castNumeric(rhsParams->producer, types.rhsType, isSigned, rewriter);
     Value newAccum =
-        castNumeric(accumParams->producer, accumLowPType, isSigned, rewriter);
+        castNumeric(accumParams->producer, types.accumType, isSigned, rewriter);
     Value newResult;
 
     if (isSigned) {
@@ -252,13 +282,152 @@ struct LinalgFpMatmulToLowP : public OpRewritePattern<linalg::MatmulOp> {
   }
 };
 
+// Same as LinalgFpMatmulToLowP for convolutions, which only exist in a
+// signed flavor: the image and filter are narrowed to i8 and accumulated in
+// i32.
+struct LinalgFpConvToLowP : public OpRewritePattern<linalg::Conv2DNhwcHwcfOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::Conv2DNhwcHwcfOp convOp,
+                                PatternRewriter &rewriter) const override {
+    Location loc = convOp.getLoc();
+    Type origResultType = convOp.getResult(0).getType();
+    auto imageParams = NarrowParams::forValue(convOp.inputs()[0]);
+    auto filterParams = NarrowParams::forValue(convOp.inputs()[1]);
+    auto accumParams = NarrowParams::forValue(convOp.outputs()[0]);
+    if (!imageParams || !filterParams || !accumParams) {
+      return rewriter.notifyMatchFailure(convOp, "no narrowing annotations");
+    }
+    LowPContractionTypes types;
+    if (failed(deriveLowPContractionTypes(
+            convOp, rewriter, *imageParams, *filterParams, *accumParams,
+            /*requireSigned=*/true, types))) {
+      return failure();
+    }
+
+    Value newImage = castNumeric(imageParams->producer, types.lhsType,
+                                 /*isSigned=*/true, rewriter);
+    Value newFilter = castNumeric(filterParams->producer, types.rhsType,
+                                  /*isSigned=*/true, rewriter);
+    Value newAccum = castNumeric(accumParams->producer, types.accumType,
+                                 /*isSigned=*/true, rewriter);
+    Value newResult = rewriter
+                          .create<linalg::Conv2DNhwcHwcfOp>(
+                              loc, TypeRange{newAccum.getType()},
+                              ValueRange{newImage, newFilter},
+                              ValueRange{newAccum}, convOp.strides(),
+                              convOp.dilations())
+                          .getResult(0);
+
+    // Cast back.
+    newResult =
+        castNumeric(newResult, origResultType, /*isSigned=*/true, rewriter);
+    rewriter.replaceOp(convOp, ValueRange{newResult});
+    return success();
+  }
+};
+
+// Truncates the f32 inputs of a contraction to |storageType| while keeping
+// its f32 accumulator: the op extends the inputs back to f32 in its payload.
+// Inputs that are constants, such as weights, are then hoisted into globals
+// stored in |storageType|, and producers of the other inputs write them in
+// |storageType|, halving the memory traffic of the contraction.
+template <typename OpTy>
+struct LinalgF32ContractionToLowPStorage : public OpRewritePattern<OpTy> {
+  LinalgF32ContractionToLowPStorage(MLIRContext *context, Type storageType)
+      : OpRewritePattern<OpTy>(context), storageType(storageType) {}
+
+  LogicalResult matchAndRewrite(OpTy op,
+                                PatternRewriter &rewriter) const override {
+    auto isF32 = [](Value value) {
+      return getElementTypeOrSelf(value.getType()).isF32();
+    };
+    if (!op.hasTensorSemantics() || !llvm::all_of(op.inputs(), isF32) ||
+        !llvm::all_of(op.outputs(), isF32)) {
+      return rewriter.notifyMatchFailure(op, "not an f32 contraction");
+    }
+    Location loc = op.getLoc();
+    SmallVector<Value> newInputs;
+    for (Value input : op.inputs()) {
+      newInputs.push_back(rewriter.create<arith::TruncFOp>(
+          loc, withNewElementType(input.getType(), storageType), input));
+    }
+    rewriter.replaceOp(op, createWithInputs(rewriter, op, newInputs));
+    return success();
+  }
+
+ private:
+  static Value createWithInputs(PatternRewriter &rewriter, OpTy op,
+                                ValueRange inputs);
+
+  Type storageType;
+};
+
+template <>
+Value LinalgF32ContractionToLowPStorage<linalg::MatmulOp>::createWithInputs(
+    PatternRewriter &rewriter, linalg::MatmulOp op, ValueRange inputs) {
+  return rewriter.create<linalg::MatmulOp>(op.getLoc(), inputs, op.outputs())
+      .getResult(0);
+}
+
+template <>
+Value LinalgF32ContractionToLowPStorage<linalg::BatchMatmulOp>::
+    createWithInputs(PatternRewriter &rewriter, linalg::BatchMatmulOp op,
+                     ValueRange inputs) {
+  return rewriter
+      .create<linalg::BatchMatmulOp>(op.getLoc(), inputs, op.outputs())
+      .getResult(0);
+}
+
+template <>
+Value LinalgF32ContractionToLowPStorage<linalg::Conv2DNhwcHwcfOp>::
+    createWithInputs(PatternRewriter &rewriter, linalg::Conv2DNhwcHwcfOp op,
+                     ValueRange inputs) {
+  return rewriter
+      .create<linalg::Conv2DNhwcHwcfOp>(op.getLoc(), op.getResultTypes(),
+                                        inputs, op.outputs(), op.strides(),
+                                        op.dilations())
+      .getResult(0);
+}
+
 class OptimizeNumericsPass : public OptimizeNumericsBase<OptimizeNumericsPass> {
+ public:
+  OptimizeNumericsPass(StringRef floatStorageType) {
+    this->floatStorageType = floatStorageType.str();
+  }
+  OptimizeNumericsPass(const OptimizeNumericsPass &pass) {
+    floatStorageType = pass.floatStorageType;
+    storageType = pass.storageType;
+  }
+
+  LogicalResult initialize(MLIRContext *context) override {
+    if (floatStorageType.empty()) return success();
+    storageType = llvm::StringSwitch<Type>(floatStorageType)
+                      .Case("f16", FloatType::getF16(context))
+                      .Case("bf16", FloatType::getBF16(context))
+                      .Default(Type());
+    if (!storageType) {
+      return emitError(UnknownLoc::get(context))
+             << "unsupported float storage type '" << floatStorageType
+             << "', expected f16 or bf16";
+    }
+    return success();
+  }
+
   void runOnOperation() override {
     MLIRContext *context = &getContext();
     RewritePatternSet patterns(context);
 
-    // Precision reduction.
-    patterns.insert<LinalgFpMatmulToLowP>(context);
+    // Precision reduction. Integer narrowing is preferred over reduced
+    // floating point storage.
+    patterns.insert<LinalgFpMatmulToLowP>(context, /*benefit=*/2);
+    patterns.insert<LinalgFpConvToLowP>(context, /*benefit=*/2);
+    if (storageType) {
+      patterns.insert<LinalgF32ContractionToLowPStorage<linalg::MatmulOp>,
+                      LinalgF32ContractionToLowPStorage<linalg::BatchMatmulOp>,
+                      LinalgF32ContractionToLowPStorage<
+                          linalg::Conv2DNhwcHwcfOp>>(context, storageType);
+    }
 
     // Cast propagation.
     patterns.insert<LinalgInitTensorCast>(context);
@@ -269,12 +438,15 @@ class OptimizeNumericsPass : public OptimizeNumericsBase<OptimizeNumericsPass> {
       return signalPassFailure();
     }
   }
+
+ private:
+  Type storageType;
 };
 
 }  // namespace
 
-std::unique_ptr<Pass> createOptimizeNumericsPass() {
-  return std::make_unique<OptimizeNumericsPass>();
+std::unique_ptr<Pass> createOptimizeNumericsPass(StringRef floatStorageType) {
+  return std::make_unique<OptimizeNumericsPass>(floatStorageType);
 }
 
 }  // namespace Flow
@@ -19,6 +19,7 @@
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
@@ -28,13 +29,33 @@ namespace IREE {
 namespace Flow {
 
 namespace {
+/// Returns true if `padTensorOp` pads with a constant and only feeds inputs of
+/// Linalg ops. Such pads can be fused into the dispatches of their consumers,
+/// which then only pad the tiles they read.
+static bool isFusableWithConsumers(tensor::PadOp padTensorOp) {
+  Value paddingValue = padTensorOp.getConstantPaddingValue();
+  if (!paddingValue || !matchPattern(paddingValue, m_Constant())) return false;
+  return llvm::all_of(padTensorOp->getUses(), [](OpOperand &use) {
+    auto linalgOp = dyn_cast<linalg::LinalgOp>(use.getOwner());
+    return linalgOp && !isa<linalg::FillOp>(use.getOwner()) &&
+           linalgOp.isInputTensor(&use);
+  });
+}
+
 /// Pattern to convert a linalg.pad_tensor operation into a fill + subtensor
-/// insert. This is needed till pad_tensor op can be fused with its consumers.
+/// insert. This is needed for pad_tensor ops that are not fused with their
+/// consumers.
 struct PadTensorOpConversion : public OpRewritePattern<tensor::PadOp> {
-  using OpRewritePattern<tensor::PadOp>::OpRewritePattern;
+  PadTensorOpConversion(MLIRContext *context, bool skipFusableOps)
+      : OpRewritePattern<tensor::PadOp>(context),
+        skipFusableOps(skipFusableOps) {}
 
   LogicalResult matchAndRewrite(tensor::PadOp padTensorOp,
                                 PatternRewriter &rewriter) const override {
+    if (skipFusableOps && isFusableWithConsumers(padTensorOp)) {
+      return failure();
+    }
+
     // Check that the region is just a yield operation which is returning a
     // scalar that is not one of the arguments of the linalg operation.
     Region &region = padTensorOp.region();
@@ -97,10 +118,20 @@ struct PadTensorOpConversion : public OpRewritePattern<tensor::PadOp> {
         padTensorOp, source, fill, lowPad, sourceShape, strides);
     return success();
   }
+
+ private:
+  bool skipFusableOps;
 };
 
 struct PadTensorToSubTensorInsertPass
     : public PadTensorToSubTensorInsertBase<PadTensorToSubTensorInsertPass> {
+  PadTensorToSubTensorInsertPass(bool skipFusableOps) {
+    this->skipFusableOps = skipFusableOps;
+  }
+  PadTensorToSubTensorInsertPass(const PadTensorToSubTensorInsertPass &pass) {
+    skipFusableOps = pass.skipFusableOps;
+  }
+
   void getDependentDialects(DialectRegistry &registry) const override {
     registry.insert<linalg::LinalgDialect, memref::MemRefDialect,
                     StandardOpsDialect, mlir::math::MathDialect,
@@ -110,7 +141,7 @@ struct PadTensorToSubTensorInsertPass
   void runOnOperation() override {
     MLIRContext *context = &getContext();
     RewritePatternSet patterns(context);
-    patterns.insert<PadTensorOpConversion>(context);
+    patterns.insert<PadTensorOpConversion>(context, skipFusableOps);
     if (failed(applyPatternsAndFoldGreedily(getOperation(),
                                             std::move(patterns)))) {
       return signalPassFailure();
@@ -120,8 +151,9 @@ struct PadTensorToSubTensorInsertPass
 
 }  // namespace
 
-std::unique_ptr<Pass> createPadTensorToSubTensorInsertPass() {
-  return std::make_unique<PadTensorToSubTensorInsertPass>();
+std::unique_ptr<Pass> createPadTensorToSubTensorInsertPass(
+    bool skipFusableOps) {
+  return std::make_unique<PadTensorToSubTensorInsertPass>(skipFusableOps);
 }
 
 }  // namespace Flow
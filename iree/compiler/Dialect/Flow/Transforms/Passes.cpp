@@ -10,6 +10,7 @@
 
 #include "iree/compiler/Dialect/Util/Transforms/Passes.h"
 #include "iree/compiler/Utils/PassUtils.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "mlir/Dialect/Linalg/Passes.h"
 #include "mlir/Dialect/MemRef/Transforms/Passes.h"
 #include "mlir/Pass/PassOptions.h"
@@ -54,8 +55,73 @@ static llvm::cl::opt<int> clLinalgOpsPaddingSize(
                    "flow-padding-size"),
     llvm::cl::init(4));
 
+static llvm::cl::opt<bool> clEnableFusePaddingIntoConsumerOps(
+    "iree-flow-enable-fuse-padding-into-consumer-ops",
+    llvm::cl::desc("Experimental: fuse tensor.pad ops with a constant value "
+                   "into the dispatches of their Linalg consumers, which pad "
+                   "each tile instead of materializing the padded tensor"),
+    llvm::cl::init(false));
+
 // TODO(#1159): enable by default or remove this option once it works on
 //              a broader set of programs
+static llvm::cl::opt<bool> clEnableHorizontalFusion(
+    "iree-flow-enable-horizontal-fusion",
+    llvm::cl::desc("Enable merging independent elementwise ops with the same "
+                   "iteration space into a single dispatch"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> clEnableMmt4d(
+    "iree-flow-enable-mmt4d",
+    llvm::cl::desc("Convert linalg.matmul ops to MMT4D ops when all target "
+                   "devices have kernels for them; packing of constant "
+                   "operands is hoisted into globals when const-expr "
+                   "hoisting is enabled."),
+    llvm::cl::init(true));
+
+static llvm::cl::opt<std::string> clMmt4dTargetOptions(
+    "iree-flow-mmt4d-target-options",
+    llvm::cl::desc("Overrides the architecture MMT4D tile sizes are chosen for "
+                   "instead of inferring it from the target devices (e.g. "
+                   "'arch=aarch64 features=+dotprod')."),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<bool> clEnableMmt4dLayoutPropagation(
+    "iree-flow-enable-mmt4d-layout-propagation",
+    llvm::cl::desc("Keep mmt4d results in their packed layout across "
+                   "elementwise ops and chained matmuls, unpacking only where "
+                   "a tensor leaves the packed ops."),
+    llvm::cl::init(true));
+
+static llvm::cl::opt<bool> clEnableSplitMatmulReduction(
+    "iree-flow-enable-split-matmul-reduction",
+    llvm::cl::desc("Split the reduction dimension of matmuls that produce too "
+                   "few output tiles to fill the target devices."),
+    llvm::cl::init(true));
+
+static llvm::cl::opt<std::string> clSplitMatmulReductionOptions(
+    "iree-flow-split-matmul-reduction-options",
+    llvm::cl::desc("Overrides the options of the matmul reduction splitting "
+                   "(e.g. 'parallelism=64 min-split-size=512')."),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<bool> clEnableSplitTopkReduction(
+    "iree-flow-enable-split-topk-reduction",
+    llvm::cl::desc("Split the reduced dimension of top-k ops into chunks that "
+                   "are reduced in parallel."),
+    llvm::cl::init(true));
+
+static llvm::cl::opt<std::string> clSplitTopkReductionOptions(
+    "iree-flow-split-topk-reduction-options",
+    llvm::cl::desc("Overrides the options of the top-k reduction splitting "
+                   "(e.g. 'min-split-size=1024 max-split=64')."),
+    llvm::cl::init(""));
+
+static llvm::cl::list<int64_t> clDispatchShapeBuckets(
+    "iree-flow-dispatch-shape-buckets",
+    llvm::cl::desc("Sizes to specialize dispatches with one dynamic dimension "
+                   "for; other sizes use the generic dispatch."),
+    llvm::cl::CommaSeparated);
+
 static llvm::cl::opt<bool> clEnableLinalgDetensorize(
     "iree-flow-enable-linalg-detensorize",
     llvm::cl::desc("Enable detensorizing linalg ops to operate on primitives"),
@@ -97,8 +163,12 @@ void buildGlobalOptimizationPassPipeline(
 
   if (transformOptions.numericPrecisionReduction) {
     pipeline.addPass(createInferNumericNarrowingPass());
-    pipeline.addPass(createOptimizeNumericsPass());
+    pipeline.addPass(
+        createOptimizeNumericsPass(transformOptions.numericFloatStorageType));
     pipeline.addPass(createCleanupNumericNarrowingPass());
+  } else if (!transformOptions.numericFloatStorageType.empty()) {
+    pipeline.addPass(
+        createOptimizeNumericsPass(transformOptions.numericFloatStorageType));
   }
 
   FunctionLikeNest(pipeline)
@@ -130,13 +200,57 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
       .addPass(createVerifyInputLegalityPass);
 
   passManager.addPass(mlir::createLinalgNamedOpConversionPass());
+
+  // Convert matmuls to their tiled mmt4d form ahead of global optimization
+  // such that the packing of weights is hoisted and evaluated at compile time
+  // instead of running on every invocation.
+  if (clEnableMmt4d) {
+    auto mmt4dPass = createConvertLinalgMatmulToMmt4DPass();
+    if (!clMmt4dTargetOptions.empty() &&
+        failed(mmt4dPass->initializeOptions(clMmt4dTargetOptions))) {
+      llvm::report_fatal_error("invalid --iree-flow-mmt4d-target-options");
+    }
+    passManager.addNestedPass<FuncOp>(std::move(mmt4dPass));
+    if (clEnableMmt4dLayoutPropagation) {
+      passManager.addNestedPass<FuncOp>(createPropagateMmt4DLayoutsPass());
+    }
+  }
+
+  // Matmuls left with a long reduction and few output tiles, such as the
+  // batch-1 matmuls of decoders, are split along their reduction so that they
+  // fill the device.
+  if (clEnableSplitMatmulReduction) {
+    auto splitPass = createSplitMatmulReductionPass();
+    if (!clSplitMatmulReductionOptions.empty() &&
+        failed(splitPass->initializeOptions(clSplitMatmulReductionOptions))) {
+      llvm::report_fatal_error(
+          "invalid --iree-flow-split-matmul-reduction-options");
+    }
+    passManager.addNestedPass<FuncOp>(std::move(splitPass));
+  }
+
+  // Top-k ops over a long dimension are otherwise reduced by a single
+  // workgroup per slice.
+  if (clEnableSplitTopkReduction) {
+    auto splitPass = createSplitTopkReductionPass();
+    if (!clSplitTopkReductionOptions.empty() &&
+        failed(splitPass->initializeOptions(clSplitTopkReductionOptions))) {
+      llvm::report_fatal_error(
+          "invalid --iree-flow-split-topk-reduction-options");
+    }
+    passManager.addNestedPass<FuncOp>(std::move(splitPass));
+  }
+
   buildGlobalOptimizationPassPipeline(passManager, transformOptions);
 
   // Perform cleanup after variable simplification as more canonicalizers may be
   // able to kick in.
   FunctionLikeNest(passManager)
       // Pad tensors.
-      .addPass(createPadTensorToSubTensorInsertPass)
+      .addPass([]() {
+        return createPadTensorToSubTensorInsertPass(
+            /*skipFusableOps=*/clEnableFusePaddingIntoConsumerOps);
+      })
 
       // Elementwise, fusion, tiling and distribution.
       .addPass(mlir::createConvertElementwiseToLinalgPass)
@@ -148,6 +262,7 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
       // Fusion.
       .addPass(createFusionOfTensorOpsPass)
       .addPass(mlir::createCSEPass)
+      .addPredicatedPass(clEnableHorizontalFusion, createHorizontalFusionPass)
       .addPredicatedPass(clEnableLinalgDetensorize,
                          mlir::createLinalgDetensorizePass)
       // Dispatch region formation.
@@ -159,6 +274,15 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
       .addPass(createConvertToFlowAfterDispatchFormation)
       .addPass(mlir::createCanonicalizerPass)
       .addPass(memref::createResolveShapedTypeResultDimsPass)
+      // Specialization of dynamically shaped dispatches for the shape buckets;
+      // canonicalization sinks the bucket sizes into the dispatch regions.
+      .addPredicatedPass(!clDispatchShapeBuckets.empty(),
+                         []() {
+                           SmallVector<int64_t> buckets(
+                               clDispatchShapeBuckets.begin(),
+                               clDispatchShapeBuckets.end());
+                           return createSpecializeDispatchShapesPass(buckets);
+                         })
 
       // Cleanup again?
       .addPass(createConvertToFlowAfterDispatchFormation)
@@ -8,6 +8,7 @@
 #define IREE_COMPILER_DIALECT_FLOW_TRANSFORMS_PASSES_H_
 
 #include <functional>
+#include <string>
 
 #include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
 #include "llvm/ADT/StringMap.h"
@@ -26,13 +27,18 @@ namespace Flow {
 //===----------------------------------------------------------------------===//
 
 struct TransformOptions : public PassPipelineOptions<TransformOptions> {
-  // Enables the iree-util-hoist-into-globals pass. This should eventually
-  // become the default.
+  // Enables the iree-util-hoist-into-globals pass. Weight-only computation
+  // (transposes, layout packing, dequantization) is hoisted into immutable
+  // globals that may then be evaluated by buildConstEvalPassPipeline.
   bool constExprHoisting = false;
 
   // Enables passes to perform numeric precision reduction.
   bool numericPrecisionReduction = false;
 
+  // Stores the inputs of f32 contractions in this floating point type (f16 or
+  // bf16) while still accumulating in f32. Disabled when empty.
+  std::string numericFloatStorageType;
+
   // Hook to populate a constant evaluation pass pipeline. If nullptr, then
   // no passes are added for constant evaluation. This must be injected in
   // because constant-evaluators can depend on the whole compiler, of which
@@ -74,15 +80,36 @@ std::unique_ptr<Pass> createConvertConv2DToImg2ColPass();
 
 // Pass to convert a linalg.pad_tensor operation into a linalg.fill +
 // subtensor_insert. This allows lowering the operation into a single kernel.
-std::unique_ptr<Pass> createPadTensorToSubTensorInsertPass();
+// With `skipFusableOps` the pads that can be fused into the dispatches of
+// their consumers are left as is.
+std::unique_ptr<Pass> createPadTensorToSubTensorInsertPass(
+    bool skipFusableOps = false);
 
 // Pass to convert a linalg.matmul into linalg.mmt4d given some target ISA
 // information currently passed as pass options.
 std::unique_ptr<OperationPass<FuncOp>> createConvertLinalgMatmulToMmt4DPass();
 
+// Keeps tensors produced by mmt4d ops in their packed layout through
+// elementwise consumers such that a mmt4d consuming them reads the packed
+// layout directly instead of unpacking and repacking it.
+std::unique_ptr<OperationPass<FuncOp>> createPropagateMmt4DLayoutsPass();
+
+// Splits the reduction dimension of matmuls that produce too few output tiles
+// to fill the target devices into a batch of partial matmuls followed by a
+// reduction of their results.
+std::unique_ptr<OperationPass<FuncOp>> createSplitMatmulReductionPass();
+
+// Splits the reduced dimension of top-k ops into chunks whose top-k are
+// computed in parallel, followed by a top-k of the partial results.
+std::unique_ptr<OperationPass<FuncOp>> createSplitTopkReductionPass();
+
 // Creates a pass to fuse Linalg operations on tensors.
 std::unique_ptr<Pass> createFusionOfTensorOpsPass();
 
+// Creates a pass to merge independent elementwise Linalg operations with the
+// same iteration space such that they are dispatched together.
+std::unique_ptr<Pass> createHorizontalFusionPass();
+
 // Infers and inserts util.numeric.optional_narrow ops at points that may be
 // beneficial.
 std::unique_ptr<Pass> createInferNumericNarrowingPass();
@@ -99,8 +126,11 @@ std::unique_ptr<Pass> createConvertToFlowBeforeDispatchFormation();
 std::unique_ptr<Pass> createConvertToFlowAfterDispatchFormation();
 
 // Optimizes numerics given annotations added via
-// iree-flow-infer-numeric-narrowing.
-std::unique_ptr<Pass> createOptimizeNumericsPass();
+// iree-flow-infer-numeric-narrowing. If |floatStorageType| is f16 or bf16, the
+// inputs of f32 contractions are also stored in that type while accumulating
+// in f32.
+std::unique_ptr<Pass> createOptimizeNumericsPass(
+    StringRef floatStorageType = "");
 
 // Strips the signed/unsigned portion off of tensors.
 std::unique_ptr<OperationPass<mlir::FuncOp>> createStripSignednessPass();
@@ -121,6 +151,12 @@ std::unique_ptr<Pass> createDispatchLinalgOnTensorsPass();
 // Captures dynamic shape dimensions required by dispatch operands.
 std::unique_ptr<Pass> createCaptureDispatchDynamicDimsPass();
 
+// Specializes dispatches with a single dynamic dimension for each of the
+// |buckets| sizes of that dimension, selected at runtime with a fallback to the
+// original dispatch for other sizes.
+std::unique_ptr<Pass> createSpecializeDispatchShapesPass(
+    ArrayRef<int64_t> buckets = {});
+
 // Outlines dispatch regions into executables.
 std::unique_ptr<OperationPass<mlir::ModuleOp>>
 createOutlineDispatchRegionsPass();
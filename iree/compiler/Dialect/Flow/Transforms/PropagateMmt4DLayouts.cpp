@@ -0,0 +1,262 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Permutation between the expanded 4D form of a 2D tensor ([M1, M0, N1, N0])
+// and its packed mmt4d form ([M1, N1, M0, N0]). It is its own inverse so that
+// the same transposition both packs and unpacks.
+static const unsigned kPackPermutation[] = {0, 2, 1, 3};
+
+// Returns the input indexing map of |genericOp| if it only copies a
+// permutation of its single input into its single output, or a null map.
+static AffineMap getTransposeMap(linalg::GenericOp genericOp) {
+  if (!genericOp || !genericOp.hasTensorSemantics()) return AffineMap();
+  if (genericOp.getNumInputs() != 1 || genericOp.getNumOutputs() != 1) {
+    return AffineMap();
+  }
+  if (genericOp.getNumParallelLoops() != genericOp.getNumLoops()) {
+    return AffineMap();
+  }
+  auto yieldOp = cast<linalg::YieldOp>(genericOp.getBody()->getTerminator());
+  if (yieldOp.values().size() != 1) return AffineMap();
+  auto blockArgument = yieldOp.values()[0].dyn_cast<BlockArgument>();
+  if (!blockArgument || blockArgument.getArgNumber() != 0) return AffineMap();
+  SmallVector<AffineMap> maps = genericOp.getIndexingMaps();
+  if (!maps[1].isIdentity() || !maps[0].isPermutation()) return AffineMap();
+  return maps[0];
+}
+
+// Returns true if |value| is a 4D tensor transposed by kPackPermutation.
+static bool isPackTranspose(Value value) {
+  auto genericOp = value.getDefiningOp<linalg::GenericOp>();
+  AffineMap map = getTransposeMap(genericOp);
+  return map && map == AffineMap::getPermutationMap(kPackPermutation,
+                                                     genericOp.getContext());
+}
+
+// Returns the packed 4D tensor that |value| was unpacked from, or a null value
+// if |value| is not the statically shaped result of
+//   collapse_shape(transpose(packed))
+// as produced by ConvertLinalgMatmulToMmt4D when the shapes are multiples of
+// the tile sizes.
+static Value getUnpackSource(Value value) {
+  auto collapseOp = value.getDefiningOp<tensor::CollapseShapeOp>();
+  if (!collapseOp) return Value();
+  auto resultType = collapseOp.getResultType();
+  if (resultType.getRank() != 2 || !resultType.hasStaticShape()) return Value();
+  auto reassociation = collapseOp.getReassociationIndices();
+  if (reassociation.size() != 2 || reassociation[0].size() != 2) {
+    return Value();
+  }
+  if (!isPackTranspose(collapseOp.src())) return Value();
+  return collapseOp.src().getDefiningOp<linalg::GenericOp>().inputs()[0];
+}
+
+// Creates a linalg.generic transposing |input| by kPackPermutation.
+static Value createPackTranspose(OpBuilder &builder, Location loc,
+                                 Value input) {
+  auto inputType = input.getType().cast<RankedTensorType>();
+  SmallVector<int64_t> shape;
+  for (unsigned index : kPackPermutation) {
+    shape.push_back(inputType.getDimSize(index));
+  }
+  Value init = builder.create<linalg::InitTensorOp>(
+      loc, shape, inputType.getElementType());
+  SmallVector<AffineMap> maps = {
+      AffineMap::getPermutationMap(kPackPermutation, builder.getContext()),
+      builder.getMultiDimIdentityMap(4)};
+  SmallVector<StringRef> iterators(4, getParallelIteratorTypeName());
+  return builder
+      .create<linalg::GenericOp>(
+          loc, init.getType(), input, init, maps, iterators,
+          [](OpBuilder &b, Location nestedLoc, ValueRange args) {
+            b.create<linalg::YieldOp>(nestedLoc, args[0]);
+          })
+      .getResult(0);
+}
+
+// Packs the 2D |value| into the mmt4d layout with tiles of |tileShape|.
+static Value pack(OpBuilder &builder, Location loc, Value value,
+                  ArrayRef<int64_t> tileShape) {
+  auto type = value.getType().cast<RankedTensorType>();
+  auto expandedType = RankedTensorType::get(
+      {type.getDimSize(0) / tileShape[0], tileShape[0],
+       type.getDimSize(1) / tileShape[1], tileShape[1]},
+      type.getElementType());
+  SmallVector<ReassociationIndices> reassociation = {{0, 1}, {2, 3}};
+  Value expanded = builder.create<tensor::ExpandShapeOp>(loc, expandedType,
+                                                         value, reassociation);
+  return createPackTranspose(builder, loc, expanded);
+}
+
+// Unpacks the 4D |value| in the mmt4d layout back into a 2D |type|.
+static Value unpack(OpBuilder &builder, Location loc, Value value,
+                    RankedTensorType type) {
+  Value transposed = createPackTranspose(builder, loc, value);
+  SmallVector<ReassociationIndices> reassociation = {{0, 1}, {2, 3}};
+  return builder.create<tensor::CollapseShapeOp>(loc, type, transposed,
+                                                 reassociation);
+}
+
+// Folds a transposition of a transposition that composes to the identity:
+//
+//   %0 = linalg.generic {transpose P} ins(%x)
+//   %1 = linalg.generic {transpose inverse(P)} ins(%0)
+//
+// into %x. This removes the unpack-then-pack between a mmt4d producing a
+// tensor and a mmt4d consuming it once the collapse/expand pair in between
+// has been canonicalized away.
+struct FoldTransposePairPattern : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::GenericOp genericOp,
+                                PatternRewriter &rewriter) const override {
+    AffineMap outerMap = getTransposeMap(genericOp);
+    if (!outerMap) return failure();
+    auto producerOp = genericOp.inputs()[0].getDefiningOp<linalg::GenericOp>();
+    AffineMap innerMap = getTransposeMap(producerOp);
+    if (!innerMap) return failure();
+    if (!innerMap.compose(outerMap).isIdentity()) return failure();
+    Value source = producerOp.inputs()[0];
+    if (source.getType() != genericOp.getResult(0).getType()) return failure();
+    rewriter.replaceOp(genericOp, source);
+    return success();
+  }
+};
+
+// Moves the unpacking of a mmt4d result below an elementwise op consuming it:
+//
+//   %0 = collapse_shape(transpose(%packed))
+//   %1 = linalg.generic {elementwise} ins(%0, %other) outs(%init)
+//
+// becomes
+//
+//   %p = linalg.generic {elementwise} ins(%packed, pack(%other))
+//                                     outs(pack(%init))
+//   %1 = collapse_shape(transpose(%p))
+//
+// so that the elementwise op (and the dispatch it is fused into) writes the
+// packed layout directly. When the result feeds another mmt4d the unpack is
+// then folded against that mmt4d's pack by FoldTransposePairPattern.
+//
+// Only statically shaped, rank-2 ops with identity indexing maps that do not
+// depend on the iteration indices are rewritten: the packed op must compute
+// the same values in a different order.
+struct PropagateUnpackThroughElementwisePattern
+    : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::GenericOp genericOp,
+                                PatternRewriter &rewriter) const override {
+    if (!genericOp.hasTensorSemantics()) return failure();
+    if (genericOp.getNumLoops() != 2 || genericOp.getNumOutputs() != 1) {
+      return failure();
+    }
+    if (genericOp.getNumParallelLoops() != genericOp.getNumLoops()) {
+      return failure();
+    }
+    if (!llvm::all_of(genericOp.getIndexingMaps(),
+                      [](AffineMap map) { return map.isIdentity(); })) {
+      return failure();
+    }
+    if (!genericOp.getBody()->getOps<linalg::IndexOp>().empty()) {
+      return failure();
+    }
+    for (Value operand : genericOp->getOperands()) {
+      auto type = operand.getType().dyn_cast<RankedTensorType>();
+      if (!type || !type.hasStaticShape()) return failure();
+    }
+
+    // Use the tiles of the first unpacked input.
+    Value packedInput;
+    for (Value input : genericOp.inputs()) {
+      if ((packedInput = getUnpackSource(input))) break;
+    }
+    if (!packedInput) return failure();
+    auto packedType = packedInput.getType().cast<RankedTensorType>();
+    SmallVector<int64_t> tileShape = {packedType.getDimSize(2),
+                                      packedType.getDimSize(3)};
+
+    Location loc = genericOp.getLoc();
+    auto packOperand = [&](Value operand) -> Value {
+      Value source = getUnpackSource(operand);
+      if (source && source.getType().cast<RankedTensorType>().getShape() ==
+                        packedType.getShape()) {
+        return source;
+      }
+      return pack(rewriter, loc, operand, tileShape);
+    };
+    SmallVector<Value> inputs;
+    for (Value input : genericOp.inputs()) inputs.push_back(packOperand(input));
+    Value output = genericOp.outputs()[0];
+    auto resultType = genericOp.getResult(0).getType().cast<RankedTensorType>();
+    auto packedResultType = RankedTensorType::get(packedType.getShape(),
+                                                  resultType.getElementType());
+    if (output.getDefiningOp<linalg::InitTensorOp>()) {
+      output = rewriter.create<linalg::InitTensorOp>(
+          loc, packedResultType.getShape(), packedResultType.getElementType());
+    } else {
+      output = packOperand(output);
+    }
+
+    SmallVector<AffineMap> maps(genericOp.getNumInputsAndOutputs(),
+                                rewriter.getMultiDimIdentityMap(4));
+    SmallVector<StringRef> iterators(4, getParallelIteratorTypeName());
+    auto packedOp = rewriter.create<linalg::GenericOp>(
+        loc, packedResultType, inputs, output, maps, iterators);
+    BlockAndValueMapping mapping;
+    genericOp.region().cloneInto(&packedOp.region(), mapping);
+    rewriter.replaceOp(genericOp, unpack(rewriter, loc, packedOp.getResult(0),
+                                         resultType));
+    return success();
+  }
+};
+
+class PropagateMmt4DLayoutsPass final
+    : public PropagateMmt4DLayoutsBase<PropagateMmt4DLayoutsPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect, tensor::TensorDialect>();
+  }
+
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    RewritePatternSet patterns(context);
+    patterns.insert<FoldTransposePairPattern,
+                    PropagateUnpackThroughElementwisePattern>(context);
+    // Folds the expand_shape(collapse_shape) between an unpack and a pack.
+    tensor::ExpandShapeOp::getCanonicalizationPatterns(patterns, context);
+    tensor::CollapseShapeOp::getCanonicalizationPatterns(patterns, context);
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createPropagateMmt4DLayoutsPass() {
+  return std::make_unique<PropagateMmt4DLayoutsPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
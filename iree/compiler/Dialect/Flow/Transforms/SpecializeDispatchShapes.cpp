@@ -0,0 +1,157 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/IR/FlowDialect.h"
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "llvm/ADT/SetVector.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Returns the only dynamic dimension of the operands and results of
+// |dispatchOp| that is not a constant, or nullptr if there are none or more
+// than one.
+static Value getSpecializableDim(DispatchWorkgroupsOp dispatchOp) {
+  llvm::SmallSetVector<Value, 4> dims;
+  for (auto dim : llvm::concat<Value>(dispatchOp.operand_dims(),
+                                      dispatchOp.result_dims())) {
+    if (!matchPattern(dim, m_Constant())) dims.insert(dim);
+  }
+  return dims.size() == 1 ? dims.front() : Value();
+}
+
+// Replaces |dispatchOp| with a chain of checks of |dim| against each of the
+// |buckets|, each branching to a copy of the dispatch where |dim| is the
+// constant size of the bucket. The original dispatch is kept as the fallback
+// for sizes outside of the buckets:
+//
+//   ^bb0:
+//     %is_bucket0 = arith.cmpi eq, %dim, %c_bucket0
+//     cf.cond_br %is_bucket0, ^bucket0, ^bb1
+//   ^bucket0:
+//     %0 = flow.dispatch.workgroups(..., %c_bucket0)
+//     cf.br ^exit(%0)
+//   ^bb1:
+//     ...
+//   ^fallback:
+//     %1 = flow.dispatch.workgroups(..., %dim)
+//     cf.br ^exit(%1)
+//   ^exit(%result):
+//
+// Canonicalization sinks the constants into the dispatch regions so that they
+// are compiled for static shapes; equivalent variants are deduplicated along
+// with the other executables.
+static void specializeDispatch(DispatchWorkgroupsOp dispatchOp, Value dim,
+                               ArrayRef<int64_t> buckets) {
+  Location loc = dispatchOp.getLoc();
+  OpBuilder builder(dispatchOp);
+
+  // Split the block after the dispatch such that all variants branch to the
+  // ops using its results.
+  auto *beforeBlock = dispatchOp->getBlock();
+  auto *afterBlock =
+      beforeBlock->splitBlock(std::next(dispatchOp->getIterator()));
+  SmallVector<Location> locs(dispatchOp.getNumResults(), loc);
+  auto finalValues = llvm::to_vector<4>(
+      afterBlock->addArguments(dispatchOp.getResultTypes(), locs));
+  dispatchOp->replaceAllUsesWith(finalValues);
+
+  auto *fallbackBlock = builder.createBlock(afterBlock);
+  dispatchOp->moveBefore(fallbackBlock, fallbackBlock->end());
+  builder.setInsertionPointToEnd(fallbackBlock);
+  builder.create<cf::BranchOp>(loc, afterBlock, dispatchOp.getResults());
+
+  auto *checkBlock = beforeBlock;
+  for (auto bucket : llvm::enumerate(buckets)) {
+    auto *matchBlock = builder.createBlock(fallbackBlock);
+    auto *nextBlock = bucket.index() + 1 < buckets.size()
+                          ? builder.createBlock(fallbackBlock)
+                          : fallbackBlock;
+
+    builder.setInsertionPointToEnd(checkBlock);
+    Value bucketSize =
+        builder.create<arith::ConstantIndexOp>(loc, bucket.value());
+    Value isMatch = builder.create<arith::CmpIOp>(
+        loc, arith::CmpIPredicate::eq, dim, bucketSize);
+    builder.create<cf::CondBranchOp>(loc, isMatch, matchBlock, nextBlock);
+
+    builder.setInsertionPointToEnd(matchBlock);
+    BlockAndValueMapping mapping;
+    mapping.map(dim, bucketSize);
+    auto *specializedOp = builder.clone(*dispatchOp, mapping);
+    builder.create<cf::BranchOp>(loc, afterBlock, specializedOp->getResults());
+
+    checkBlock = nextBlock;
+  }
+}
+
+class SpecializeDispatchShapesPass
+    : public SpecializeDispatchShapesBase<SpecializeDispatchShapesPass> {
+ public:
+  explicit SpecializeDispatchShapesPass(ArrayRef<int64_t> buckets) {
+    this->buckets = buckets;
+  }
+  SpecializeDispatchShapesPass(const SpecializeDispatchShapesPass &pass) {
+    this->buckets = SmallVector<int64_t>(pass.buckets.begin(),
+                                         pass.buckets.end());
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, cf::ControlFlowDialect,
+                    IREE::Flow::FlowDialect>();
+  }
+
+  void runOnOperation() override {
+    llvm::SmallSetVector<int64_t, 4> uniqueBuckets;
+    for (int64_t bucket : buckets) {
+      if (bucket < 0) {
+        getOperation()->emitError()
+            << "invalid dispatch shape bucket " << bucket;
+        return signalPassFailure();
+      }
+      uniqueBuckets.insert(bucket);
+    }
+    if (uniqueBuckets.empty()) return;
+
+    // Only dispatches in the CFG of the function itself are specialized;
+    // those nested in structured control flow would need to be outlined.
+    SmallVector<std::pair<DispatchWorkgroupsOp, Value>> candidates;
+    getOperation()->walk([&](DispatchWorkgroupsOp dispatchOp) {
+      if (dispatchOp->getParentOp() != getOperation()) return;
+      if (Value dim = getSpecializableDim(dispatchOp)) {
+        candidates.emplace_back(dispatchOp, dim);
+      }
+    });
+    for (auto candidate : candidates) {
+      specializeDispatch(candidate.first, candidate.second,
+                         uniqueBuckets.getArrayRef());
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createSpecializeDispatchShapesPass(
+    ArrayRef<int64_t> buckets) {
+  return std::make_unique<SpecializeDispatchShapesPass>(buckets);
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,219 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/HAL/IR/HALTypes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Support/MathExtras.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Number of workgroups needed to keep each kind of device busy. These are
+// rough estimates: a couple of workgroups per compute unit of typical GPUs and
+// a couple of tiles per core of typical CPUs.
+static constexpr int64_t kGPUParallelism = 128;
+static constexpr int64_t kCPUParallelism = 16;
+
+// Returns the number of workgroups needed to fill the devices that |op| is
+// compiled for, or 0 if no devices are specified.
+static int64_t inferParallelism(Operation *op) {
+  int64_t parallelism = 0;
+  for (auto targetAttr :
+       IREE::HAL::DeviceTargetAttr::lookupExecutableTargets(op)) {
+    StringRef backend = targetAttr.getBackend().getValue();
+    bool isCPU = backend == "llvm" || backend == "vmvx";
+    parallelism =
+        std::max(parallelism, isCPU ? kCPUParallelism : kGPUParallelism);
+  }
+  return parallelism;
+}
+
+// Splits the reduction of statically shaped matmuls that don't produce enough
+// output tiles to keep the device busy:
+//
+//   C[m, n] += A[m, k] * B[k, n]
+//
+// becomes a matmul batched over S slices of the reduction, followed by a
+// reduction of the partial results:
+//
+//   P[s, m, n] = A[m, s, k'] * B[s, k', n]
+//   C[m, n] += P[0, m, n] + ... + P[S - 1, m, n]
+//
+// Both ops form their own dispatch. Floating-point results are reassociated.
+class SplitMatmulReductionPattern : public OpRewritePattern<linalg::MatmulOp> {
+ public:
+  SplitMatmulReductionPattern(MLIRContext *context, int64_t parallelism,
+                              int64_t tileSize, int64_t minSplitSize,
+                              int64_t maxSplit)
+      : OpRewritePattern<linalg::MatmulOp>(context),
+        parallelism(parallelism),
+        tileSize(tileSize),
+        minSplitSize(minSplitSize),
+        maxSplit(maxSplit) {}
+
+  LogicalResult matchAndRewrite(linalg::MatmulOp matmulOp,
+                                PatternRewriter &rewriter) const override {
+    if (!matmulOp.hasTensorSemantics()) return failure();
+    Value lhs = matmulOp.getInputOperand(0)->get();
+    Value rhs = matmulOp.getInputOperand(1)->get();
+    Value out = matmulOp.getOutputOperand(0)->get();
+    auto lhsType = lhs.getType().dyn_cast<RankedTensorType>();
+    auto rhsType = rhs.getType().dyn_cast<RankedTensorType>();
+    auto outType = out.getType().dyn_cast<RankedTensorType>();
+    if (!lhsType || !rhsType || !outType || !lhsType.hasStaticShape() ||
+        !rhsType.hasStaticShape() || !outType.hasStaticShape()) {
+      return failure();
+    }
+    // Mixed precision matmuls extend their operands in the payload; only
+    // handle the plain ones.
+    Type elementType = outType.getElementType();
+    if (lhsType.getElementType() != elementType ||
+        rhsType.getElementType() != elementType ||
+        !elementType.isa<FloatType, IntegerType>()) {
+      return failure();
+    }
+
+    int64_t m = lhsType.getDimSize(0);
+    int64_t k = lhsType.getDimSize(1);
+    int64_t n = rhsType.getDimSize(1);
+    int64_t numTiles = ceilDiv(m, tileSize) * ceilDiv(n, tileSize);
+    int64_t split = 1;
+    while (numTiles * split < parallelism && split * 2 <= maxSplit &&
+           k % (split * 2) == 0 && k / (split * 2) >= minSplitSize) {
+      split *= 2;
+    }
+    if (split == 1) {
+      return rewriter.notifyMatchFailure(matmulOp,
+                                         "parallel enough or reduction too "
+                                         "short to split");
+    }
+    int64_t splitSize = k / split;
+
+    Location loc = matmulOp.getLoc();
+    auto expandedLhsType =
+        RankedTensorType::get({m, split, splitSize}, elementType);
+    Value expandedLhs = rewriter.create<tensor::ExpandShapeOp>(
+        loc, expandedLhsType, lhs,
+        SmallVector<ReassociationIndices>{{0}, {1, 2}});
+    auto expandedRhsType =
+        RankedTensorType::get({split, splitSize, n}, elementType);
+    Value expandedRhs = rewriter.create<tensor::ExpandShapeOp>(
+        loc, expandedRhsType, rhs,
+        SmallVector<ReassociationIndices>{{0, 1}, {2}});
+
+    Value zero = rewriter.create<arith::ConstantOp>(
+        loc, rewriter.getZeroAttr(elementType));
+    Value partialInit = rewriter.create<linalg::InitTensorOp>(
+        loc, ArrayRef<int64_t>{split, m, n}, elementType);
+    Value partialFill =
+        rewriter.create<linalg::FillOp>(loc, zero, partialInit).result();
+
+    bool isFloat = elementType.isa<FloatType>();
+    auto createAdd = [&](OpBuilder &b, Location loc, Value x, Value y) {
+      return isFloat ? b.create<arith::AddFOp>(loc, x, y).getResult()
+                     : b.create<arith::AddIOp>(loc, x, y).getResult();
+    };
+
+    // Partial matmuls over (s, m, n, k').
+    MLIRContext *context = rewriter.getContext();
+    AffineExpr s, d0, d1, r;
+    bindDims(context, s, d0, d1, r);
+    SmallVector<AffineMap> partialMaps = {
+        AffineMap::get(4, 0, {d0, s, r}, context),
+        AffineMap::get(4, 0, {s, r, d1}, context),
+        AffineMap::get(4, 0, {s, d0, d1}, context)};
+    SmallVector<StringRef> partialIterators = {
+        getParallelIteratorTypeName(), getParallelIteratorTypeName(),
+        getParallelIteratorTypeName(), getReductionIteratorTypeName()};
+    auto partialOp = rewriter.create<linalg::GenericOp>(
+        loc, partialFill.getType(), ValueRange{expandedLhs, expandedRhs},
+        partialFill, partialMaps, partialIterators,
+        [&](OpBuilder &b, Location nestedLoc, ValueRange args) {
+          Value mul =
+              isFloat
+                  ? b.create<arith::MulFOp>(nestedLoc, args[0], args[1])
+                        .getResult()
+                  : b.create<arith::MulIOp>(nestedLoc, args[0], args[1])
+                        .getResult();
+          b.create<linalg::YieldOp>(nestedLoc,
+                                    createAdd(b, nestedLoc, mul, args[2]));
+        });
+
+    // Reduction of the partial results over (m, n, s) into the original
+    // output.
+    bindDims(context, d0, d1, s);
+    SmallVector<AffineMap> reductionMaps = {
+        AffineMap::get(3, 0, {s, d0, d1}, context),
+        AffineMap::get(3, 0, {d0, d1}, context)};
+    SmallVector<StringRef> reductionIterators = {
+        getParallelIteratorTypeName(), getParallelIteratorTypeName(),
+        getReductionIteratorTypeName()};
+    rewriter.replaceOpWithNewOp<linalg::GenericOp>(
+        matmulOp, outType, partialOp.getResult(0), out, reductionMaps,
+        reductionIterators,
+        [&](OpBuilder &b, Location nestedLoc, ValueRange args) {
+          b.create<linalg::YieldOp>(nestedLoc,
+                                    createAdd(b, nestedLoc, args[0], args[1]));
+        });
+    return success();
+  }
+
+ private:
+  int64_t parallelism;
+  int64_t tileSize;
+  int64_t minSplitSize;
+  int64_t maxSplit;
+};
+
+class SplitMatmulReductionPass final
+    : public SplitMatmulReductionBase<SplitMatmulReductionPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, linalg::LinalgDialect,
+                    tensor::TensorDialect>();
+  }
+
+  void runOnOperation() override {
+    // Without an explicit parallelism the matmuls are split for the most
+    // parallel of the devices the program is compiled for.
+    int64_t targetParallelism = parallelism;
+    if (targetParallelism == 0) {
+      targetParallelism = inferParallelism(getOperation());
+    }
+    if (targetParallelism <= 1 || tileSize <= 0 || maxSplit < 2) return;
+
+    RewritePatternSet patterns(&getContext());
+    patterns.insert<SplitMatmulReductionPattern>(
+        &getContext(), targetParallelism, tileSize,
+        std::max<int64_t>(minSplitSize, 1), maxSplit);
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createSplitMatmulReductionPass() {
+  return std::make_unique<SplitMatmulReductionPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
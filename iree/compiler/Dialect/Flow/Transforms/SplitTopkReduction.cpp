@@ -0,0 +1,206 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtOps.h"
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Returns the value |tensor| is filled with, or nullptr if it is not the
+// result of a linalg.fill.
+static Value getFillValue(Value tensor) {
+  auto fillOp = tensor.getDefiningOp<linalg::FillOp>();
+  return fillOp ? fillOp.value() : Value();
+}
+
+// Returns |type| with the dimension |dim| split into |split| x |size|.
+static RankedTensorType getSplitType(RankedTensorType type, int64_t dim,
+                                     int64_t split, int64_t size) {
+  SmallVector<int64_t> shape(type.getShape().begin(), type.getShape().end());
+  shape[dim] = size;
+  shape.insert(shape.begin() + dim, split);
+  return RankedTensorType::get(shape, type.getElementType());
+}
+
+// Splits statically shaped top-k ops with a long reduced dimension into chunks
+// that are reduced in parallel, followed by a top-k of the partial results:
+//
+//   out[k] = topk(values[n])
+//
+// becomes
+//
+//   partial[s, k] = topk(values[s, n / s]) along the chunk dimension
+//   partial_indices[s, :] += s * (n / s)
+//   out[k] = topk(partial[s * k], partial_indices[s * k])
+//
+// The first top-k is distributed over the chunks instead of reducing the whole
+// dimension in a single workgroup. The partial outputs are initialized like
+// the original outputs, which must be filled with a splat value (usually the
+// sentinel that all the values compare true against).
+static LogicalResult splitTopkReduction(IREE::LinalgExt::TopkOp topkOp,
+                                        int64_t minSplitSize,
+                                        int64_t maxSplit) {
+  if (!topkOp.hasTensorSemantics()) return failure();
+  for (Value operand : topkOp->getOperands()) {
+    auto type = operand.getType().dyn_cast<RankedTensorType>();
+    if (!type || !type.hasStaticShape()) return failure();
+  }
+  Value valuesFill = getFillValue(topkOp.outputValues());
+  Value indicesFill = getFillValue(topkOp.outputIndices());
+  if (!valuesFill || !indicesFill) return failure();
+
+  int64_t dim = topkOp.dimension();
+  auto valuesType = topkOp.getInputType().cast<RankedTensorType>();
+  auto outValuesType =
+      topkOp.outputValues().getType().cast<RankedTensorType>();
+  auto outIndicesType =
+      topkOp.outputIndices().getType().cast<RankedTensorType>();
+  int64_t n = valuesType.getDimSize(dim);
+  int64_t k = outValuesType.getDimSize(dim);
+  int64_t minChunkSize = std::max(minSplitSize, k);
+  int64_t split = 1;
+  while (split * 2 <= maxSplit && n % (split * 2) == 0 &&
+         n / (split * 2) >= minChunkSize) {
+    split *= 2;
+  }
+  if (split == 1) return failure();
+  int64_t splitSize = n / split;
+
+  int64_t rank = valuesType.getRank();
+  SmallVector<ReassociationIndices> reassociation;
+  for (int64_t i = 0; i < rank; ++i) {
+    if (i < dim) {
+      reassociation.push_back({i});
+    } else if (i == dim) {
+      reassociation.push_back({i, i + 1});
+    } else {
+      reassociation.push_back({i + 1});
+    }
+  }
+
+  OpBuilder builder(topkOp);
+  Location loc = topkOp.getLoc();
+  SmallVector<Value> expandedInputs;
+  for (OpOperand *input : topkOp.getInputOperands()) {
+    auto type = input->get().getType().cast<RankedTensorType>();
+    expandedInputs.push_back(builder.create<tensor::ExpandShapeOp>(
+        loc, getSplitType(type, dim, split, splitSize), input->get(),
+        reassociation));
+  }
+
+  // Top-k of each chunk.
+  auto createFilledTensor = [&](RankedTensorType type, Value fillValue) {
+    auto partialType = getSplitType(type, dim, split, k);
+    Value init = builder.create<linalg::InitTensorOp>(
+        loc, partialType.getShape(), partialType.getElementType());
+    return builder.create<linalg::FillOp>(loc, fillValue, init).result();
+  };
+  Value partialValuesInit = createFilledTensor(outValuesType, valuesFill);
+  Value partialIndicesInit = createFilledTensor(outIndicesType, indicesFill);
+  auto partialOp = builder.create<IREE::LinalgExt::TopkOp>(
+      loc, TypeRange{partialValuesInit.getType(), partialIndicesInit.getType()},
+      expandedInputs, ValueRange{partialValuesInit, partialIndicesInit},
+      dim + 1);
+  BlockAndValueMapping partialMapping;
+  topkOp.region().cloneInto(&partialOp.region(), partialMapping);
+  Value partialValues = partialOp.getResult(0);
+  Value partialIndices = partialOp.getResult(1);
+
+  // Without explicit indices the partial top-k yields the positions within
+  // each chunk; offset them by the start of their chunk.
+  if (!topkOp.indices()) {
+    auto indicesType = partialIndices.getType().cast<RankedTensorType>();
+    int64_t partialRank = indicesType.getRank();
+    SmallVector<AffineMap> maps = {
+        builder.getMultiDimIdentityMap(partialRank)};
+    SmallVector<StringRef> iterators(partialRank,
+                                     getParallelIteratorTypeName());
+    partialIndices =
+        builder
+            .create<linalg::GenericOp>(
+                loc, indicesType, ValueRange{}, partialIndices, maps,
+                iterators,
+                [&](OpBuilder &b, Location nestedLoc, ValueRange args) {
+                  Value chunk = b.create<linalg::IndexOp>(nestedLoc, dim);
+                  Value chunkSize =
+                      b.create<arith::ConstantIndexOp>(nestedLoc, splitSize);
+                  Value offset =
+                      b.create<arith::MulIOp>(nestedLoc, chunk, chunkSize);
+                  offset = b.create<arith::IndexCastOp>(
+                      nestedLoc, indicesType.getElementType(), offset);
+                  Value index =
+                      b.create<arith::AddIOp>(nestedLoc, args[0], offset);
+                  b.create<linalg::YieldOp>(nestedLoc, index);
+                })
+            .getResult(0);
+  }
+
+  // Top-k of the partial results into the original outputs.
+  auto collapse = [&](Value value) -> Value {
+    auto type = value.getType().cast<RankedTensorType>();
+    SmallVector<int64_t> shape(type.getShape().begin(),
+                               type.getShape().end());
+    shape[dim] *= shape[dim + 1];
+    shape.erase(shape.begin() + dim + 1);
+    return builder.create<tensor::CollapseShapeOp>(
+        loc, RankedTensorType::get(shape, type.getElementType()), value,
+        reassociation);
+  };
+  auto mergeOp = builder.create<IREE::LinalgExt::TopkOp>(
+      loc, topkOp->getResultTypes(),
+      ValueRange{collapse(partialValues), collapse(partialIndices)},
+      topkOp.outputs(), dim);
+  BlockAndValueMapping mergeMapping;
+  topkOp.region().cloneInto(&mergeOp.region(), mergeMapping);
+
+  topkOp->replaceAllUsesWith(mergeOp->getResults());
+  topkOp->erase();
+  return success();
+}
+
+class SplitTopkReductionPass final
+    : public SplitTopkReductionBase<SplitTopkReductionPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, linalg::LinalgDialect,
+                    tensor::TensorDialect>();
+  }
+
+  void runOnOperation() override {
+    if (maxSplit < 2) return;
+    // The ops created by the split are not split again.
+    SmallVector<IREE::LinalgExt::TopkOp> topkOps;
+    getOperation().walk(
+        [&](IREE::LinalgExt::TopkOp topkOp) { topkOps.push_back(topkOp); });
+    for (auto topkOp : topkOps) {
+      (void)splitTopkReduction(topkOp, std::max<int64_t>(minSplitSize, 1),
+                               maxSplit);
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createSplitTopkReductionPass() {
+  return std::make_unique<SplitTopkReductionPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -1162,6 +1162,35 @@ func @extract_slice(%arg0 : tensor<?x?xf32>, %arg1 : index, %arg2 : index,
 
 // -----
 
+func @fuse_pad_with_conv(%input: tensor<1x56x56x16xf32>, %filter: tensor<3x3x16x32xf32>) -> tensor<1x56x56x32xf32> {
+  %cst = arith.constant 0.0 : f32
+  %0 = tensor.pad %input low[0, 1, 1, 0] high[0, 1, 1, 0]  {
+  ^bb0(%arg0: index, %arg1: index, %arg2: index, %arg3: index):
+    tensor.yield %cst : f32
+  } : tensor<1x56x56x16xf32> to tensor<1x58x58x16xf32>
+  %1 = linalg.init_tensor [1, 56, 56, 32] : tensor<1x56x56x32xf32>
+  %2 = linalg.fill(%cst, %1) : f32, tensor<1x56x56x32xf32> -> tensor<1x56x56x32xf32>
+  %3 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>}
+      ins(%0, %filter : tensor<1x58x58x16xf32>, tensor<3x3x16x32xf32>)
+      outs(%2 : tensor<1x56x56x32xf32>) -> tensor<1x56x56x32xf32>
+  return %3 : tensor<1x56x56x32xf32>
+}
+//      CHECK: func @fuse_pad_with_conv
+// CHECK-SAME:     %[[INPUT:[a-zA-Z0-9_]+]]: tensor<1x56x56x16xf32>
+//  CHECK-NOT:   tensor.pad
+//      CHECK:   flow.dispatch.workgroups
+// CHECK-SAME:       (%[[INPUT]],
+// CHECK-NEXT:     %[[INPUT_ARG:[a-zA-Z0-9]+]]: !flow.dispatch.tensor<readonly:1x56x56x16xf32>
+//      CHECK:       scf.for
+//      CHECK:         scf.for
+//      CHECK:           scf.for
+//      CHECK:             %[[LOAD:.+]] = flow.dispatch.tensor.load %[[INPUT_ARG]]
+//      CHECK:             %[[PAD:.+]] = tensor.pad %{{.+}}
+//      CHECK:             linalg.conv_2d_nhwc_hwcf
+// CHECK-SAME:                 ins(%[[PAD]],
+
+// -----
+
 func @inline_cst(%arg0 : tensor<4x32xi32>) -> tensor<32xi32> {
   %cst = arith.constant dense<0> : tensor<32xi32>
   %0 = linalg.generic {
@@ -1315,3 +1344,31 @@ func @unit_dim_generic(%arg0 : tensor<1x?x1x1x?x?x1x?xf32>,
 //      CHECK:           flow.dispatch.tensor.load %[[ARG2]]
 // CHECK-SAME:               offsets = [0, 0, 0, 0, %[[IV0]], %[[IV1]], 0, %[[IV2]]]
 // CHECK-SAME:               sizes = [1, %[[ARG3]], 1, 1, %[[TILE_Z]], %[[TILE_Y]], 1, %[[TILE_X]]]
+
+// -----
+
+// Tests that a result is tied to an operand when the stored value is produced
+// by a chain of in-place updates of the loaded operand.
+
+func @tie_update_chain(%arg0: tensor<4x8xf32>, %arg1: tensor<1x8xf32>) -> tensor<4x8xf32> {
+  %c1 = arith.constant 1 : index
+  %0 = flow.dispatch.workgroups[%c1, %c1, %c1](%arg0, %arg1) : (tensor<4x8xf32>, tensor<1x8xf32>) -> tensor<4x8xf32> = (
+    %cache: !flow.dispatch.tensor<readonly:4x8xf32>, %update: !flow.dispatch.tensor<readonly:1x8xf32>, %ret: !flow.dispatch.tensor<writeonly:4x8xf32>
+  ) {
+    %cache_value = flow.dispatch.tensor.load %cache, offsets=[0, 0], sizes=[4, 8], strides=[1, 1] : !flow.dispatch.tensor<readonly:4x8xf32> -> tensor<4x8xf32>
+    %update_value = flow.dispatch.tensor.load %update, offsets=[0, 0], sizes=[1, 8], strides=[1, 1] : !flow.dispatch.tensor<readonly:1x8xf32> -> tensor<1x8xf32>
+    %1 = tensor.insert_slice %update_value into %cache_value[0, 0] [1, 8] [1, 1] : tensor<1x8xf32> into tensor<4x8xf32>
+    %2 = tensor.insert_slice %update_value into %1[3, 0] [1, 8] [1, 1] : tensor<1x8xf32> into tensor<4x8xf32>
+    flow.dispatch.tensor.store %2, %ret, offsets=[0, 0], sizes=[4, 8], strides=[1, 1] : tensor<4x8xf32> -> !flow.dispatch.tensor<writeonly:4x8xf32>
+    flow.return
+  }
+  return %0 : tensor<4x8xf32>
+}
+//      CHECK: func @tie_update_chain
+// CHECK-SAME:     %[[ARG0:[a-zA-Z0-9_]+]]: tensor<4x8xf32>
+//      CHECK:   flow.dispatch.workgroups
+// CHECK-SAME:       -> %[[ARG0]]
+// CHECK-NEXT:     %[[CACHE:.+]]: !flow.dispatch.tensor<readwrite:4x8xf32>
+// CHECK-SAME:     %[[UPDATE:.+]]: !flow.dispatch.tensor<readonly:1x8xf32>
+//  CHECK-NOT:     writeonly
+//      CHECK:     flow.dispatch.tensor.store %{{.+}}, %[[CACHE]]
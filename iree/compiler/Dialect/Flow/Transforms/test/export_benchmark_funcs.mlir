@@ -41,3 +41,20 @@ func @while(%start: tensor<i32>, %bound: tensor<i32>) -> tensor<i32> {
 //     CHECK:   util.do_not_optimize(%[[RET0]]) : tensor<i32>
 //     CHECK:   return
 //     CHECK: }
+
+// -----
+
+func @matmul(%lhs: tensor<4x8xf32>, %rhs: tensor<8x16xf32>) -> tensor<4x16xf32> {
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<4x8xf32>, tensor<8x16xf32>) -> tensor<4x16xf32>
+  return %0 : tensor<4x16xf32>
+}
+
+//     CHECK: flow.executable private @[[EXECUTABLE:.+]] {
+//     CHECK: func @matmul_benchmark()
+//     CHECK: func @[[EXECUTABLE]]_benchmark()
+// CHECK-SAME:     iree.reflection = {benchmark = "dispatch", bytes = "{{[0-9]+}}", flops = "1024"}
+// CHECK-DAG:   util.global.load @{{.+}} : tensor<4x8xf32>
+// CHECK-DAG:   util.global.load @{{.+}} : tensor<8x16xf32>
+//     CHECK:   %[[RET:.+]] = flow.dispatch @[[EXECUTABLE]]::@{{.+}}
+//     CHECK:   util.do_not_optimize(%[[RET]]) : tensor<4x16xf32>
+//     CHECK:   return
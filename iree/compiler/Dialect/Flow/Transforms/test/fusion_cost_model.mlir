@@ -0,0 +1,60 @@
+// RUN: iree-opt -split-input-file -verify-diagnostics -iree-flow-fusion-cost-model=roofline-cpu -iree-flow-fusion-max-body-ops=3 -iree-flow-fusion-remarks -pass-pipeline="builtin.func(iree-flow-dispatch-linalg-on-tensors-pass)" %s | FileCheck %s
+
+func @fuse_matmul_bias_within_budget(%lhs : tensor<64x32xf32>, %rhs : tensor<32x16xf32>, %bias : tensor<16xf32>) -> tensor<64x16xf32> {
+  %cst = arith.constant 0.0 : f32
+  %init = linalg.init_tensor [64, 16] : tensor<64x16xf32>
+  %fill = linalg.fill(%cst, %init) : f32, tensor<64x16xf32> -> tensor<64x16xf32>
+  %matmul = linalg.matmul ins(%lhs, %rhs : tensor<64x32xf32>, tensor<32x16xf32>)
+      outs(%fill : tensor<64x16xf32>) -> tensor<64x16xf32>
+  // expected-remark @+1 {{fusion cost model 'roofline-cpu': fusing root 'linalg.matmul': saves 8192 bytes of memory traffic}}
+  %0 = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                       affine_map<(d0, d1) -> (d1)>,
+                       affine_map<(d0, d1) -> (d0, d1)>],
+      iterator_types = ["parallel", "parallel"]}
+      ins(%matmul, %bias : tensor<64x16xf32>, tensor<16xf32>)
+      outs(%init : tensor<64x16xf32>) {
+    ^bb0(%arg0 : f32, %arg1 : f32, %arg2 : f32):
+      %1 = arith.addf %arg0, %arg1 : f32
+      linalg.yield %1 : f32
+  } -> tensor<64x16xf32>
+  return %0 : tensor<64x16xf32>
+}
+// CHECK-LABEL: func @fuse_matmul_bias_within_budget
+//       CHECK:   flow.dispatch.workgroups
+//       CHECK:     linalg.matmul
+//       CHECK:     linalg.generic
+//       CHECK:     flow.return
+//   CHECK-NOT:   flow.dispatch.workgroups
+
+// -----
+
+func @split_matmul_bias_over_budget(%lhs : tensor<64x32xf32>, %rhs : tensor<32x16xf32>, %bias : tensor<16xf32>) -> tensor<64x16xf32> {
+  %cst = arith.constant 0.0 : f32
+  %init = linalg.init_tensor [64, 16] : tensor<64x16xf32>
+  %fill = linalg.fill(%cst, %init) : f32, tensor<64x16xf32> -> tensor<64x16xf32>
+  %matmul = linalg.matmul ins(%lhs, %rhs : tensor<64x32xf32>, tensor<32x16xf32>)
+      outs(%fill : tensor<64x16xf32>) -> tensor<64x16xf32>
+  // expected-remark @+1 {{fusion cost model 'roofline-cpu': not fusing root 'linalg.matmul': fused payload would have 4 ops, exceeding the budget of 3}}
+  %0 = linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                       affine_map<(d0, d1) -> (d1)>,
+                       affine_map<(d0, d1) -> (d0, d1)>],
+      iterator_types = ["parallel", "parallel"]}
+      ins(%matmul, %bias : tensor<64x16xf32>, tensor<16xf32>)
+      outs(%init : tensor<64x16xf32>) {
+    ^bb0(%arg0 : f32, %arg1 : f32, %arg2 : f32):
+      %1 = arith.addf %arg0, %arg1 : f32
+      %2 = math.tanh %1 : f32
+      linalg.yield %2 : f32
+  } -> tensor<64x16xf32>
+  return %0 : tensor<64x16xf32>
+}
+// CHECK-LABEL: func @split_matmul_bias_over_budget
+//       CHECK:   %[[MATMUL:.+]] = flow.dispatch.workgroups
+//       CHECK:     linalg.matmul
+//   CHECK-NOT:     linalg.generic
+//       CHECK:     flow.return
+//       CHECK:   flow.dispatch.workgroups
+//  CHECK-SAME:     %[[MATMUL]]
+//       CHECK:     linalg.generic
@@ -0,0 +1,85 @@
+// RUN: iree-opt -split-input-file -pass-pipeline="builtin.func(iree-flow-horizontal-fusion)" %s | FileCheck %s
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func @merge_independent_elementwise(%arg0 : tensor<4x8xf32>, %arg1 : tensor<4x8xf32>, %arg2 : tensor<4x8xi32>) -> (tensor<4x8xf32>, tensor<4x8xi32>) {
+  %init0 = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+  %0 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%arg0, %arg1 : tensor<4x8xf32>, tensor<4x8xf32>) outs(%init0 : tensor<4x8xf32>) {
+    ^bb0(%a : f32, %b : f32, %out : f32):
+      %1 = arith.addf %a, %b : f32
+      linalg.yield %1 : f32
+  } -> tensor<4x8xf32>
+  %init1 = linalg.init_tensor [4, 8] : tensor<4x8xi32>
+  %2 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%arg2 : tensor<4x8xi32>) outs(%init1 : tensor<4x8xi32>) {
+    ^bb0(%a : i32, %out : i32):
+      %3 = arith.muli %a, %a : i32
+      linalg.yield %3 : i32
+  } -> tensor<4x8xi32>
+  return %0, %2 : tensor<4x8xf32>, tensor<4x8xi32>
+}
+// CHECK-LABEL: func @merge_independent_elementwise
+//  CHECK-SAME:   %[[ARG0:[a-zA-Z0-9_]+]]: tensor<4x8xf32>
+//  CHECK-SAME:   %[[ARG1:[a-zA-Z0-9_]+]]: tensor<4x8xf32>
+//  CHECK-SAME:   %[[ARG2:[a-zA-Z0-9_]+]]: tensor<4x8xi32>
+//   CHECK-DAG:   %[[INIT0:.+]] = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+//   CHECK-DAG:   %[[INIT1:.+]] = linalg.init_tensor [4, 8] : tensor<4x8xi32>
+//       CHECK:   %[[RESULT:.+]]:2 = linalg.generic
+//  CHECK-SAME:       ins(%[[ARG0]], %[[ARG1]], %[[ARG2]] :
+//  CHECK-SAME:       outs(%[[INIT0]], %[[INIT1]] :
+//  CHECK-NEXT:     ^bb0(%[[A:[a-zA-Z0-9_]+]]: f32, %[[B:[a-zA-Z0-9_]+]]: f32, %[[C:[a-zA-Z0-9_]+]]: i32
+//   CHECK-DAG:       %[[ADD:.+]] = arith.addf %[[A]], %[[B]] : f32
+//   CHECK-DAG:       %[[MUL:.+]] = arith.muli %[[C]], %[[C]] : i32
+//       CHECK:       linalg.yield %[[ADD]], %[[MUL]] : f32, i32
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   return %[[RESULT]]#0, %[[RESULT]]#1
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func @no_merge_dependent(%arg0 : tensor<4x8xf32>) -> tensor<4x8xf32> {
+  %init = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+  %0 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%arg0 : tensor<4x8xf32>) outs(%init : tensor<4x8xf32>) {
+    ^bb0(%a : f32, %out : f32):
+      %1 = arith.negf %a : f32
+      linalg.yield %1 : f32
+  } -> tensor<4x8xf32>
+  %2 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%0 : tensor<4x8xf32>) outs(%init : tensor<4x8xf32>) {
+    ^bb0(%a : f32, %out : f32):
+      %3 = arith.mulf %a, %a : f32
+      linalg.yield %3 : f32
+  } -> tensor<4x8xf32>
+  return %2 : tensor<4x8xf32>
+}
+// CHECK-LABEL: func @no_merge_dependent
+//       CHECK:   %[[NEG:.+]] = linalg.generic
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       ins(%[[NEG]] :
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func @no_merge_different_iteration_space(%arg0 : tensor<4x8xf32>, %arg1 : tensor<8x4xf32>) -> (tensor<4x8xf32>, tensor<8x4xf32>) {
+  %init0 = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+  %0 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%arg0 : tensor<4x8xf32>) outs(%init0 : tensor<4x8xf32>) {
+    ^bb0(%a : f32, %out : f32):
+      %1 = arith.negf %a : f32
+      linalg.yield %1 : f32
+  } -> tensor<4x8xf32>
+  %init1 = linalg.init_tensor [8, 4] : tensor<8x4xf32>
+  %2 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%arg1 : tensor<8x4xf32>) outs(%init1 : tensor<8x4xf32>) {
+    ^bb0(%a : f32, %out : f32):
+      %3 = arith.negf %a : f32
+      linalg.yield %3 : f32
+  } -> tensor<8x4xf32>
+  return %0, %2 : tensor<4x8xf32>, tensor<8x4xf32>
+}
+// CHECK-LABEL: func @no_merge_different_iteration_space
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       ins(%{{.+}} : tensor<4x8xf32>)
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       ins(%{{.+}} : tensor<8x4xf32>)
@@ -1,6 +1,8 @@
 // RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d=enable_generic_slow %s | FileCheck %s
 // RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=aarch64' %s | FileCheck %s -check-prefix=AARCH64-BASELINE
 // RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=aarch64 features=+dotprod' %s | FileCheck %s -check-prefix=AARCH64-DOTPROD
+// RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=aarch64 features=+dotprod,+i8mm' %s | FileCheck %s -check-prefix=AARCH64-I8MM
+// RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=x86_64 features=+avx512vnni' %s | FileCheck %s -check-prefix=X86-64-AVX512VNNI
 
 // There are two parts to this test: the "deep" part and the "wide part".
 
@@ -193,6 +195,16 @@ func @check_target_specific_mmt4d_i8_dynamic(%arg0: tensor<?x?xi8>, %arg1: tenso
 // AARCH64-DOTPROD-SAME:     {comment = "i8*i8->i32, aarch64 +dotprod"}
 // AARCH64-DOTPROD-SAME:     ins({{.*}} : tensor<?x?x8x4xi8>, tensor<?x?x8x4xi8>) outs({{.*}} : tensor<?x?x8x8xi32>) -> tensor<?x?x8x8xi32>
 
+// AARCH64-I8MM-LABEL:  @check_target_specific_mmt4d_i8_dynamic(
+// AARCH64-I8MM:        linalg.mmt4d
+// AARCH64-I8MM-SAME:     {comment = "i8*i8->i32, aarch64 +i8mm"}
+// AARCH64-I8MM-SAME:     ins({{.*}} : tensor<?x?x8x8xi8>, tensor<?x?x8x8xi8>) outs({{.*}} : tensor<?x?x8x8xi32>) -> tensor<?x?x8x8xi32>
+
+// X86-64-AVX512VNNI-LABEL:  @check_target_specific_mmt4d_i8_dynamic(
+// X86-64-AVX512VNNI:        linalg.mmt4d
+// X86-64-AVX512VNNI-SAME:     {comment = "i8*i8->i32, x86_64 +avx512vnni"}
+// X86-64-AVX512VNNI-SAME:     ins({{.*}} : tensor<?x?x16x4xi8>, tensor<?x?x16x4xi8>) outs({{.*}} : tensor<?x?x16x16xi32>) -> tensor<?x?x16x16xi32>
+
 // -----
 func @check_target_specific_mmt4d_i8_dynamic_matvec(%arg0: tensor<?x?xi8>, %arg1: tensor<?x1xi8>, %arg2: tensor<?x1xi32>) -> tensor<?x1xi32> {
     %0 = linalg.matmul ins(%arg0, %arg1 : tensor<?x?xi8>, tensor<?x1xi8>) outs(%arg2 : tensor<?x1xi32>) -> tensor<?x1xi32>
@@ -208,6 +220,11 @@ func @check_target_specific_mmt4d_i8_dynamic_matvec(%arg0: tensor<?x?xi8>, %arg1
 // AARCH64-DOTPROD-SAME:     {comment = "i8*i8->i32, aarch64 +dotprod, matrix*vector"}
 // AARCH64-DOTPROD-SAME:     ins({{.*}} : tensor<?x?x8x4xi8>, tensor<1x?x1x4xi8>) outs({{.*}} : tensor<?x1x8x1xi32>) -> tensor<?x1x8x1xi32>
 
+// AARCH64-I8MM-LABEL:  @check_target_specific_mmt4d_i8_dynamic_matvec(
+// AARCH64-I8MM:        linalg.mmt4d
+// AARCH64-I8MM-SAME:     {comment = "i8*i8->i32, aarch64 +i8mm, matrix*vector"}
+// AARCH64-I8MM-SAME:     ins({{.*}} : tensor<?x?x8x4xi8>, tensor<1x?x1x4xi8>) outs({{.*}} : tensor<?x1x8x1xi32>) -> tensor<?x1x8x1xi32>
+
 // -----
 func @check_target_specific_mmt4d_i8_dynamic_vecmat(%arg0: tensor<1x?xi8>, %arg1: tensor<?x?xi8>, %arg2: tensor<1x?xi32>) -> tensor<1x?xi32> {
     %0 = linalg.matmul ins(%arg0, %arg1 : tensor<1x?xi8>, tensor<?x?xi8>) outs(%arg2 : tensor<1x?xi32>) -> tensor<1x?xi32>
@@ -0,0 +1,73 @@
+// RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d %s | FileCheck %s
+
+// Tests that tile sizes are chosen for the CPU features of the target devices
+// when no arch is specified on the pass.
+
+module attributes {hal.device.targets = [
+  #hal.device.target<"cpu", {
+    executable_targets = [
+      #hal.executable.target<"llvm", "embedded-elf-arm_64", {
+        cpu_features = "+neon,+dotprod",
+        target_triple = "aarch64-unknown-unknown-eabi-elf"
+      }>
+    ]
+  }>
+]} {
+func @device_target_dotprod(%arg0: tensor<?x?xi8>, %arg1: tensor<?x?xi8>, %arg2: tensor<?x?xi32>) -> tensor<?x?xi32> {
+    %0 = linalg.matmul ins(%arg0, %arg1 : tensor<?x?xi8>, tensor<?x?xi8>) outs(%arg2 : tensor<?x?xi32>) -> tensor<?x?xi32>
+    return %0 : tensor<?x?xi32>
+}
+}
+// CHECK-LABEL:  @device_target_dotprod(
+// CHECK:        linalg.mmt4d
+// CHECK-SAME:     {comment = "i8*i8->i32, aarch64 +dotprod"}
+// CHECK-SAME:     ins({{.*}} : tensor<?x?x8x4xi8>, tensor<?x?x8x4xi8>) outs({{.*}} : tensor<?x?x8x8xi32>) -> tensor<?x?x8x8xi32>
+
+// -----
+
+// Tests that the packed layout is only specialized for features all of the
+// executable variants share.
+
+module attributes {hal.device.targets = [
+  #hal.device.target<"cpu", {
+    executable_targets = [
+      #hal.executable.target<"llvm", "embedded-elf-arm_64", {
+        cpu_features = "+dotprod",
+        target_triple = "aarch64-unknown-unknown-eabi-elf"
+      }>,
+      #hal.executable.target<"llvm", "embedded-elf-arm_64", {
+        cpu_features = "",
+        target_triple = "aarch64-unknown-unknown-eabi-elf"
+      }>
+    ]
+  }>
+]} {
+func @device_target_variants(%arg0: tensor<?x?xi8>, %arg1: tensor<?x?xi8>, %arg2: tensor<?x?xi32>) -> tensor<?x?xi32> {
+    %0 = linalg.matmul ins(%arg0, %arg1 : tensor<?x?xi8>, tensor<?x?xi8>) outs(%arg2 : tensor<?x?xi32>) -> tensor<?x?xi32>
+    return %0 : tensor<?x?xi32>
+}
+}
+// CHECK-LABEL:  @device_target_variants(
+// CHECK:        linalg.mmt4d
+// CHECK-SAME:     {comment = "i8*i8->i32, aarch64"}
+// CHECK-SAME:     ins({{.*}} : tensor<?x?x8x1xi8>, tensor<?x?x8x1xi8>) outs({{.*}} : tensor<?x?x8x8xi32>) -> tensor<?x?x8x8xi32>
+
+// -----
+
+// Tests that matmuls are left alone when any device lacks mmt4d kernels.
+
+module attributes {hal.device.targets = [
+  #hal.device.target<"vulkan", {
+    executable_targets = [
+      #hal.executable.target<"vulkan", "vulkan-spirv-fb">
+    ]
+  }>
+]} {
+func @device_target_unsupported(%arg0: tensor<?x?xi8>, %arg1: tensor<?x?xi8>, %arg2: tensor<?x?xi32>) -> tensor<?x?xi32> {
+    %0 = linalg.matmul ins(%arg0, %arg1 : tensor<?x?xi8>, tensor<?x?xi8>) outs(%arg2 : tensor<?x?xi32>) -> tensor<?x?xi32>
+    return %0 : tensor<?x?xi32>
+}
+}
+// CHECK-LABEL:  @device_target_unsupported(
+// CHECK-NOT:    linalg.mmt4d
+// CHECK:        linalg.matmul
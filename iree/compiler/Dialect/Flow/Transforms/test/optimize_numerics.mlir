@@ -1,4 +1,6 @@
 // RUN: iree-opt -iree-flow-optimize-numerics %s | FileCheck %s
+// RUN: iree-opt -iree-flow-optimize-numerics='float-storage-type=f16' %s | FileCheck %s --check-prefix=F16
+// RUN: iree-opt -iree-flow-optimize-numerics='float-storage-type=bf16' %s | FileCheck %s --check-prefix=BF16
 
 // CHECK-LABEL: @matmul_i8_i8_i32_unsigned
 func @matmul_i8_i8_i32_unsigned(%arg0 : tensor<5x3xf32>, %arg1 : tensor<3x1xf32>, %arg2 : tensor<5x1xf32>) -> tensor<5x1xf32> {
@@ -15,6 +17,9 @@ func @matmul_i8_i8_i32_unsigned(%arg0 : tensor<5x3xf32>, %arg1 : tensor<3x1xf32>
 }
 
 // CHECK-LABEL: @matmul_i8_i8_i32_signed
+// Integer narrowing takes precedence over reduced float storage.
+// F16-LABEL: @matmul_i8_i8_i32_signed
+// F16: linalg.matmul ins(%{{.*}}, %{{.*}} : tensor<5x3xi8>, tensor<3x1xi8>) outs(%{{.*}} : tensor<5x1xi32>)
 func @matmul_i8_i8_i32_signed(%arg0 : tensor<5x3xf32>, %arg1 : tensor<3x1xf32>, %arg2 : tensor<5x1xf32>) -> tensor<5x1xf32> {
   // CHECK: %[[LHS:.*]] = arith.fptosi %arg0 : tensor<5x3xf32> to tensor<5x3xi8>
   // CHECK: %[[RHS:.*]] = arith.fptosi %arg1 : tensor<3x1xf32> to tensor<3x1xi8>
@@ -75,3 +80,59 @@ func @cast_init() -> tensor<5x9xi8> {
   %1 = arith.fptosi %0 : tensor<5x9xf32> to tensor<5x9xi8>
   return %1 : tensor<5x9xi8>
 }
+
+// CHECK-LABEL: @conv_i8_i8_i32
+// Convolutions only exist in a signed flavor so unsigned inputs are widened.
+func @conv_i8_i8_i32(%arg0 : tensor<1x4x4x3xf32>, %arg1 : tensor<1x1x3x8xf32>, %arg2 : tensor<1x4x4x8xf32>) -> tensor<1x4x4x8xf32> {
+  // CHECK: %[[IMAGE:.*]] = arith.fptosi %arg0 : tensor<1x4x4x3xf32> to tensor<1x4x4x3xi8>
+  // CHECK: %[[FILTER:.*]] = arith.fptosi %arg1 : tensor<1x1x3x8xf32> to tensor<1x1x3x8xi8>
+  // CHECK: %[[INIT:.*]] = arith.fptosi %arg2 : tensor<1x4x4x8xf32> to tensor<1x4x4x8xi32>
+  %image = util.numeric.optional_narrow %arg0 : tensor<1x4x4x3xf32> as ui7 {max_value = 127 : ui7, min_value = 0 : ui7}
+  %filter = util.numeric.optional_narrow %arg1 : tensor<1x1x3x8xf32> as si8 {max_value = 127 : si8, min_value = -127 : si8}
+  %init = util.numeric.optional_narrow %arg2 : tensor<1x4x4x8xf32> as ui0
+  // CHECK: %[[RESULT:.*]] = linalg.conv_2d_nhwc_hwcf {{.*}} ins(%[[IMAGE]], %[[FILTER]] : tensor<1x4x4x3xi8>, tensor<1x1x3x8xi8>) outs(%[[INIT]] : tensor<1x4x4x8xi32>)
+  %0 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>} ins(%image, %filter : tensor<1x4x4x3xf32>, tensor<1x1x3x8xf32>) outs(%init : tensor<1x4x4x8xf32>) -> tensor<1x4x4x8xf32>
+  // CHECK: arith.sitofp %[[RESULT]] : tensor<1x4x4x8xi32> to tensor<1x4x4x8xf32>
+  return %0 : tensor<1x4x4x8xf32>
+}
+
+// CHECK-LABEL: @conv_reject_ui8
+// CHECK-NOT: fpto
+func @conv_reject_ui8(%arg0 : tensor<1x4x4x3xf32>, %arg1 : tensor<1x1x3x8xf32>, %arg2 : tensor<1x4x4x8xf32>) -> tensor<1x4x4x8xf32> {
+  %image = util.numeric.optional_narrow %arg0 : tensor<1x4x4x3xf32> as ui8 {max_value = 255 : ui8, min_value = 0 : ui8}
+  %filter = util.numeric.optional_narrow %arg1 : tensor<1x1x3x8xf32> as si8 {max_value = 127 : si8, min_value = -127 : si8}
+  %init = util.numeric.optional_narrow %arg2 : tensor<1x4x4x8xf32> as ui0
+  // CHECK: linalg.conv_2d_nhwc_hwcf {{.*}} -> tensor<1x4x4x8xf32>
+  %0 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>} ins(%image, %filter : tensor<1x4x4x3xf32>, tensor<1x1x3x8xf32>) outs(%init : tensor<1x4x4x8xf32>) -> tensor<1x4x4x8xf32>
+  return %0 : tensor<1x4x4x8xf32>
+}
+
+// CHECK-LABEL: @matmul_float_storage
+// CHECK-NOT: truncf
+// F16-LABEL: @matmul_float_storage
+func @matmul_float_storage(%arg0 : tensor<5x3xf32>, %arg1 : tensor<3x1xf32>, %arg2 : tensor<5x1xf32>) -> tensor<5x1xf32> {
+  // F16: %[[LHS:.*]] = arith.truncf %arg0 : tensor<5x3xf32> to tensor<5x3xf16>
+  // F16: %[[RHS:.*]] = arith.truncf %arg1 : tensor<3x1xf32> to tensor<3x1xf16>
+  // F16: %[[RESULT:.*]] = linalg.matmul ins(%[[LHS]], %[[RHS]] : tensor<5x3xf16>, tensor<3x1xf16>) outs(%arg2 : tensor<5x1xf32>)
+  %0 = linalg.matmul ins(%arg0, %arg1 : tensor<5x3xf32>, tensor<3x1xf32>) outs(%arg2 : tensor<5x1xf32>) -> tensor<5x1xf32>
+  // F16: return %[[RESULT]]
+  return %0 : tensor<5x1xf32>
+}
+
+// BF16-LABEL: @batch_matmul_float_storage
+func @batch_matmul_float_storage(%arg0 : tensor<2x5x3xf32>, %arg1 : tensor<2x3x1xf32>, %arg2 : tensor<2x5x1xf32>) -> tensor<2x5x1xf32> {
+  // BF16: %[[LHS:.*]] = arith.truncf %arg0 : tensor<2x5x3xf32> to tensor<2x5x3xbf16>
+  // BF16: %[[RHS:.*]] = arith.truncf %arg1 : tensor<2x3x1xf32> to tensor<2x3x1xbf16>
+  // BF16: linalg.batch_matmul ins(%[[LHS]], %[[RHS]] : tensor<2x5x3xbf16>, tensor<2x3x1xbf16>) outs(%arg2 : tensor<2x5x1xf32>)
+  %0 = linalg.batch_matmul ins(%arg0, %arg1 : tensor<2x5x3xf32>, tensor<2x3x1xf32>) outs(%arg2 : tensor<2x5x1xf32>) -> tensor<2x5x1xf32>
+  return %0 : tensor<2x5x1xf32>
+}
+
+// BF16-LABEL: @conv_float_storage
+func @conv_float_storage(%arg0 : tensor<1x4x4x3xf32>, %arg1 : tensor<1x1x3x8xf32>, %arg2 : tensor<1x4x4x8xf32>) -> tensor<1x4x4x8xf32> {
+  // BF16: %[[IMAGE:.*]] = arith.truncf %arg0 : tensor<1x4x4x3xf32> to tensor<1x4x4x3xbf16>
+  // BF16: %[[FILTER:.*]] = arith.truncf %arg1 : tensor<1x1x3x8xf32> to tensor<1x1x3x8xbf16>
+  // BF16: linalg.conv_2d_nhwc_hwcf {{.*}} ins(%[[IMAGE]], %[[FILTER]] : tensor<1x4x4x3xbf16>, tensor<1x1x3x8xbf16>) outs(%arg2 : tensor<1x4x4x8xf32>)
+  %0 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>} ins(%arg0, %arg1 : tensor<1x4x4x3xf32>, tensor<1x1x3x8xf32>) outs(%arg2 : tensor<1x4x4x8xf32>) -> tensor<1x4x4x8xf32>
+  return %0 : tensor<1x4x4x8xf32>
+}
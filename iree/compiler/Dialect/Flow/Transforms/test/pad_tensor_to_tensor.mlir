@@ -1,4 +1,5 @@
 // RUN: iree-opt -split-input-file -iree-flow-pad-tensor-to-subtensor-insert -canonicalize %s | FileCheck %s
+// RUN: iree-opt -split-input-file -iree-flow-pad-tensor-to-subtensor-insert='skip-fusable-ops=true' -canonicalize %s | FileCheck %s --check-prefix=FUSE
 
 module  {
   func @pad_tensor(%arg0 : tensor<?x?xf32>, %arg1 : tensor<f32>, %arg2 : index, %arg3 : index) -> tensor<?x?xf32> {
@@ -56,3 +57,29 @@ module  {
 //       CHECK:   %[[FILL:.+]] = linalg.fill(%[[VAL]], %[[INIT]])
 //       CHECK:   %[[RESULT:.+]] = tensor.insert_slice %[[ARG0]] into %[[FILL]][4, 5] [12, 4] [1, 1]
 //       CHECK:   return %[[RESULT]]
+
+// -----
+
+func @pad_conv(%input: tensor<1x56x56x16xf32>, %filter: tensor<3x3x16x32xf32>) -> tensor<1x56x56x32xf32> {
+  %cst = arith.constant 0.0 : f32
+  %0 = tensor.pad %input low[0, 1, 1, 0] high[0, 1, 1, 0]  {
+  ^bb0(%arg0: index, %arg1: index, %arg2: index, %arg3: index):
+    tensor.yield %cst : f32
+  } : tensor<1x56x56x16xf32> to tensor<1x58x58x16xf32>
+  %1 = linalg.init_tensor [1, 56, 56, 32] : tensor<1x56x56x32xf32>
+  %2 = linalg.fill(%cst, %1) : f32, tensor<1x56x56x32xf32> -> tensor<1x56x56x32xf32>
+  %3 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>}
+      ins(%0, %filter : tensor<1x58x58x16xf32>, tensor<3x3x16x32xf32>)
+      outs(%2 : tensor<1x56x56x32xf32>) -> tensor<1x56x56x32xf32>
+  return %3 : tensor<1x56x56x32xf32>
+}
+// CHECK-LABEL: func @pad_conv
+//   CHECK-NOT:   tensor.pad
+//       CHECK:   tensor.insert_slice
+//       CHECK:   linalg.conv_2d_nhwc_hwcf
+//  FUSE-LABEL: func @pad_conv
+//   FUSE-SAME:   %[[INPUT:[a-zA-Z0-9_]+]]: tensor<1x56x56x16xf32>
+//       FUSE:   %[[PAD:.+]] = tensor.pad %[[INPUT]] low[0, 1, 1, 0] high[0, 1, 1, 0]
+//   FUSE-NOT:   tensor.insert_slice
+//       FUSE:   linalg.conv_2d_nhwc_hwcf
+//  FUSE-SAME:     ins(%[[PAD]],
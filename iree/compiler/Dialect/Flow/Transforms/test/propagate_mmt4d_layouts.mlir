@@ -0,0 +1,96 @@
+// RUN: iree-opt -split-input-file --iree-flow-propagate-mmt4d-layouts %s | FileCheck %s
+
+#map0 = affine_map<(d0, d1, d2, d3) -> (d0, d2, d1, d3)>
+#map1 = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+func @fold_unpack_pack(%packed: tensor<4x8x8x4xf32>) -> tensor<4x8x8x4xf32> {
+  %0 = linalg.init_tensor [4, 8, 8, 4] : tensor<4x8x8x4xf32>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      ins(%packed : tensor<4x8x8x4xf32>) outs(%0 : tensor<4x8x8x4xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      linalg.yield %arg0 : f32
+    } -> tensor<4x8x8x4xf32>
+  %2 = tensor.collapse_shape %1 [[0, 1], [2, 3]] : tensor<4x8x8x4xf32> into tensor<32x32xf32>
+  %3 = tensor.expand_shape %2 [[0, 1], [2, 3]] : tensor<32x32xf32> into tensor<4x8x8x4xf32>
+  %4 = linalg.init_tensor [4, 8, 8, 4] : tensor<4x8x8x4xf32>
+  %5 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      ins(%3 : tensor<4x8x8x4xf32>) outs(%4 : tensor<4x8x8x4xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      linalg.yield %arg0 : f32
+    } -> tensor<4x8x8x4xf32>
+  return %5 : tensor<4x8x8x4xf32>
+}
+//      CHECK: func @fold_unpack_pack
+// CHECK-SAME:   %[[PACKED:[a-zA-Z0-9]+]]: tensor<4x8x8x4xf32>
+//  CHECK-NOT:   linalg.generic
+//      CHECK:   return %[[PACKED]]
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2, d3) -> (d0, d2, d1, d3)>
+#map1 = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+#map2 = affine_map<(d0, d1) -> (d0, d1)>
+func @propagate_through_elementwise(%packed: tensor<4x8x8x4xf32>, %bias: tensor<32x32xf32>) -> tensor<4x8x8x4xf32> {
+  %0 = linalg.init_tensor [4, 8, 8, 4] : tensor<4x8x8x4xf32>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      ins(%packed : tensor<4x8x8x4xf32>) outs(%0 : tensor<4x8x8x4xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      linalg.yield %arg0 : f32
+    } -> tensor<4x8x8x4xf32>
+  %2 = tensor.collapse_shape %1 [[0, 1], [2, 3]] : tensor<4x8x8x4xf32> into tensor<32x32xf32>
+  %3 = linalg.init_tensor [32, 32] : tensor<32x32xf32>
+  %4 = linalg.generic {indexing_maps = [#map2, #map2, #map2], iterator_types = ["parallel", "parallel"]}
+      ins(%2, %bias : tensor<32x32xf32>, tensor<32x32xf32>) outs(%3 : tensor<32x32xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32, %arg2: f32):
+      %add = arith.addf %arg0, %arg1 : f32
+      linalg.yield %add : f32
+    } -> tensor<32x32xf32>
+  %5 = tensor.expand_shape %4 [[0, 1], [2, 3]] : tensor<32x32xf32> into tensor<4x8x8x4xf32>
+  %6 = linalg.init_tensor [4, 8, 8, 4] : tensor<4x8x8x4xf32>
+  %7 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      ins(%5 : tensor<4x8x8x4xf32>) outs(%6 : tensor<4x8x8x4xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      linalg.yield %arg0 : f32
+    } -> tensor<4x8x8x4xf32>
+  return %7 : tensor<4x8x8x4xf32>
+}
+//      CHECK: func @propagate_through_elementwise
+// CHECK-SAME:   %[[PACKED:[a-zA-Z0-9]+]]: tensor<4x8x8x4xf32>
+// CHECK-SAME:   %[[BIAS:[a-zA-Z0-9]+]]: tensor<32x32xf32>
+//      CHECK:   %[[EXPANDED_BIAS:.+]] = tensor.expand_shape %[[BIAS]] {{\[}}[0, 1], [2, 3]] : tensor<32x32xf32> into tensor<4x8x8x4xf32>
+//      CHECK:   %[[PACKED_BIAS:.+]] = linalg.generic
+// CHECK-SAME:       ins(%[[EXPANDED_BIAS]] : tensor<4x8x8x4xf32>)
+//      CHECK:   %[[INIT:.+]] = linalg.init_tensor [4, 8, 8, 4] : tensor<4x8x8x4xf32>
+//      CHECK:   %[[ADD:.+]] = linalg.generic
+// CHECK-SAME:       iterator_types = ["parallel", "parallel", "parallel", "parallel"]
+// CHECK-SAME:       ins(%[[PACKED]], %[[PACKED_BIAS]] : tensor<4x8x8x4xf32>, tensor<4x8x8x4xf32>)
+// CHECK-SAME:       outs(%[[INIT]] : tensor<4x8x8x4xf32>)
+//      CHECK:     arith.addf
+//  CHECK-NOT:   linalg.generic
+//      CHECK:   return %[[ADD]]
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2, d3) -> (d0, d2, d1, d3)>
+#map1 = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+func @no_fold_different_tiles(%packed: tensor<4x8x8x4xf32>) -> tensor<8x4x4x8xf32> {
+  %0 = linalg.init_tensor [4, 8, 8, 4] : tensor<4x8x8x4xf32>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      ins(%packed : tensor<4x8x8x4xf32>) outs(%0 : tensor<4x8x8x4xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      linalg.yield %arg0 : f32
+    } -> tensor<4x8x8x4xf32>
+  %2 = tensor.collapse_shape %1 [[0, 1], [2, 3]] : tensor<4x8x8x4xf32> into tensor<32x32xf32>
+  %3 = tensor.expand_shape %2 [[0, 1], [2, 3]] : tensor<32x32xf32> into tensor<8x4x4x8xf32>
+  %4 = linalg.init_tensor [8, 4, 4, 8] : tensor<8x4x4x8xf32>
+  %5 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      ins(%3 : tensor<8x4x4x8xf32>) outs(%4 : tensor<8x4x4x8xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      linalg.yield %arg0 : f32
+    } -> tensor<8x4x4x8xf32>
+  return %5 : tensor<8x4x4x8xf32>
+}
+//      CHECK: func @no_fold_different_tiles
+//      CHECK:   tensor.collapse_shape
+//      CHECK:   tensor.expand_shape
+//      CHECK:   linalg.generic
+//      CHECK:   return
@@ -0,0 +1,51 @@
+// RUN: iree-opt -split-input-file -iree-flow-specialize-dispatch-shapes='buckets=1,8' %s | FileCheck %s
+
+// Tests that a dispatch with a single dynamic dimension is cloned for each
+// bucket and that the original dispatch remains as the fallback.
+
+// CHECK-LABEL: @specializeDim
+//  CHECK-SAME: (%[[ARG0:.+]]: tensor<?x4xf32>, %[[DIM:.+]]: index)
+func @specializeDim(%arg0: tensor<?x4xf32>, %dim: index) -> tensor<?x4xf32> {
+  %c1 = arith.constant 1 : index
+  //      CHECK: %[[C1:.+]] = arith.constant 1 : index
+  //      CHECK: %[[SIZE1:.+]] = arith.constant 1 : index
+  // CHECK-NEXT: %[[IS_SIZE1:.+]] = arith.cmpi eq, %[[DIM]], %[[SIZE1]] : index
+  // CHECK-NEXT: cf.cond_br %[[IS_SIZE1]], ^[[BUCKET1:.+]], ^[[NEXT:.+]]
+  //      CHECK: ^[[BUCKET1]]:
+  // CHECK-NEXT: %[[RESULT1:.+]] = flow.dispatch.workgroups[%[[C1]], %[[C1]], %[[C1]]](%[[ARG0]], %[[SIZE1]]) : (tensor<?x4xf32>{%[[SIZE1]]}, index) -> tensor<?x4xf32>{%[[SIZE1]]}
+  //      CHECK: cf.br ^[[EXIT:.+]](%[[RESULT1]] : tensor<?x4xf32>)
+  //      CHECK: ^[[NEXT]]:
+  // CHECK-NEXT: %[[SIZE8:.+]] = arith.constant 8 : index
+  // CHECK-NEXT: %[[IS_SIZE8:.+]] = arith.cmpi eq, %[[DIM]], %[[SIZE8]] : index
+  // CHECK-NEXT: cf.cond_br %[[IS_SIZE8]], ^[[BUCKET8:.+]], ^[[FALLBACK:.+]]
+  //      CHECK: ^[[BUCKET8]]:
+  // CHECK-NEXT: %[[RESULT8:.+]] = flow.dispatch.workgroups[%[[C1]], %[[C1]], %[[C1]]](%[[ARG0]], %[[SIZE8]]) : (tensor<?x4xf32>{%[[SIZE8]]}, index) -> tensor<?x4xf32>{%[[SIZE8]]}
+  //      CHECK: cf.br ^[[EXIT]](%[[RESULT8]] : tensor<?x4xf32>)
+  //      CHECK: ^[[FALLBACK]]:
+  // CHECK-NEXT: %[[RESULT:.+]] = flow.dispatch.workgroups[%[[C1]], %[[C1]], %[[C1]]](%[[ARG0]], %[[DIM]]) : (tensor<?x4xf32>{%[[DIM]]}, index) -> tensor<?x4xf32>{%[[DIM]]}
+  //      CHECK: cf.br ^[[EXIT]](%[[RESULT]] : tensor<?x4xf32>)
+  %0 = flow.dispatch.workgroups[%c1, %c1, %c1](%arg0, %dim) : (tensor<?x4xf32>{%dim}, index) -> tensor<?x4xf32>{%dim} =
+      (%arg0_capture: !flow.dispatch.tensor<readonly:?x4xf32>, %dim_capture: index, %ret0_capture: !flow.dispatch.tensor<writeonly:?x4xf32>) {
+    flow.return
+  }
+  //      CHECK: ^[[EXIT]](%[[JOINED:.+]]: tensor<?x4xf32>):
+  // CHECK-NEXT: return %[[JOINED]]
+  return %0 : tensor<?x4xf32>
+}
+
+// -----
+
+// Tests that dispatches with more than one dynamic dimension are left as-is.
+
+// CHECK-LABEL: @multipleDims
+func @multipleDims(%arg0: tensor<?x?xf32>, %dim0: index, %dim1: index) -> tensor<?x?xf32> {
+  %c1 = arith.constant 1 : index
+  // CHECK-NOT: cf.cond_br
+  // CHECK: flow.dispatch.workgroups
+  // CHECK-NOT: flow.dispatch.workgroups
+  %0 = flow.dispatch.workgroups[%c1, %c1, %c1](%arg0, %dim0, %dim1) : (tensor<?x?xf32>{%dim0, %dim1}, index, index) -> tensor<?x?xf32>{%dim0, %dim1} =
+      (%arg0_capture: !flow.dispatch.tensor<readonly:?x?xf32>, %dim0_capture: index, %dim1_capture: index, %ret0_capture: !flow.dispatch.tensor<writeonly:?x?xf32>) {
+    flow.return
+  }
+  return %0 : tensor<?x?xf32>
+}
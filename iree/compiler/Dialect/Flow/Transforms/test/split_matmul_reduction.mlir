@@ -0,0 +1,121 @@
+// RUN: iree-opt -split-input-file --iree-flow-split-matmul-reduction='parallelism=128' %s | FileCheck %s
+// RUN: iree-opt -split-input-file --iree-flow-split-matmul-reduction %s | FileCheck %s -check-prefix=INFER
+
+func @skinny_matmul(%lhs: tensor<1x4096xf32>, %rhs: tensor<4096x64xf32>, %init: tensor<1x64xf32>) -> tensor<1x64xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<1x4096xf32>, tensor<4096x64xf32>) outs(%init : tensor<1x64xf32>) -> tensor<1x64xf32>
+  return %0 : tensor<1x64xf32>
+}
+//  CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1, d2, d3) -> (d1, d0, d3)>
+//  CHECK-DAG: #[[MAP1:.+]] = affine_map<(d0, d1, d2, d3) -> (d0, d3, d2)>
+//  CHECK-DAG: #[[MAP2:.+]] = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2)>
+//  CHECK-DAG: #[[MAP3:.+]] = affine_map<(d0, d1, d2) -> (d2, d0, d1)>
+//  CHECK-DAG: #[[MAP4:.+]] = affine_map<(d0, d1, d2) -> (d0, d1)>
+//      CHECK: func @skinny_matmul
+// CHECK-SAME:   %[[LHS:[a-zA-Z0-9]+]]: tensor<1x4096xf32>
+// CHECK-SAME:   %[[RHS:[a-zA-Z0-9]+]]: tensor<4096x64xf32>
+// CHECK-SAME:   %[[INIT:[a-zA-Z0-9]+]]: tensor<1x64xf32>
+//  CHECK-DAG:   %[[ZERO:.+]] = arith.constant 0.000000e+00 : f32
+//  CHECK-DAG:   %[[EXPANDED_LHS:.+]] = tensor.expand_shape %[[LHS]] {{\[}}[0], [1, 2]] : tensor<1x4096xf32> into tensor<1x16x256xf32>
+//  CHECK-DAG:   %[[EXPANDED_RHS:.+]] = tensor.expand_shape %[[RHS]] {{\[}}[0, 1], [2]] : tensor<4096x64xf32> into tensor<16x256x64xf32>
+//      CHECK:   %[[PARTIAL_INIT:.+]] = linalg.init_tensor [16, 1, 64] : tensor<16x1x64xf32>
+//      CHECK:   %[[PARTIAL_FILL:.+]] = linalg.fill(%[[ZERO]], %[[PARTIAL_INIT]])
+//      CHECK:   %[[PARTIAL:.+]] = linalg.generic
+// CHECK-SAME:       indexing_maps = [#[[MAP0]], #[[MAP1]], #[[MAP2]]]
+// CHECK-SAME:       iterator_types = ["parallel", "parallel", "parallel", "reduction"]
+// CHECK-SAME:       ins(%[[EXPANDED_LHS]], %[[EXPANDED_RHS]] : tensor<1x16x256xf32>, tensor<16x256x64xf32>)
+// CHECK-SAME:       outs(%[[PARTIAL_FILL]] : tensor<16x1x64xf32>)
+//      CHECK:     arith.mulf
+//      CHECK:     arith.addf
+//      CHECK:   %[[RESULT:.+]] = linalg.generic
+// CHECK-SAME:       indexing_maps = [#[[MAP3]], #[[MAP4]]]
+// CHECK-SAME:       iterator_types = ["parallel", "parallel", "reduction"]
+// CHECK-SAME:       ins(%[[PARTIAL]] : tensor<16x1x64xf32>)
+// CHECK-SAME:       outs(%[[INIT]] : tensor<1x64xf32>)
+//      CHECK:     arith.addf
+//      CHECK:   return %[[RESULT]]
+
+// Matmuls are only split when the parallelism is given or the target devices
+// are known.
+// INFER-LABEL: func @skinny_matmul
+//       INFER:   linalg.matmul
+
+// -----
+
+func @skinny_matmul_i32(%lhs: tensor<4x2048xi32>, %rhs: tensor<2048x512xi32>, %init: tensor<4x512xi32>) -> tensor<4x512xi32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<4x2048xi32>, tensor<2048x512xi32>) outs(%init : tensor<4x512xi32>) -> tensor<4x512xi32>
+  return %0 : tensor<4x512xi32>
+}
+// CHECK-LABEL: func @skinny_matmul_i32
+//       CHECK:   tensor.expand_shape {{.+}} : tensor<4x2048xi32> into tensor<4x8x256xi32>
+//       CHECK:   tensor.expand_shape {{.+}} : tensor<2048x512xi32> into tensor<8x256x512xi32>
+//       CHECK:   linalg.generic
+//       CHECK:     arith.muli
+//       CHECK:     arith.addi
+//       CHECK:   linalg.generic
+//       CHECK:     arith.addi
+
+// -----
+
+// Enough output tiles to fill the device.
+func @large_matmul(%lhs: tensor<512x4096xf32>, %rhs: tensor<4096x512xf32>, %init: tensor<512x512xf32>) -> tensor<512x512xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<512x4096xf32>, tensor<4096x512xf32>) outs(%init : tensor<512x512xf32>) -> tensor<512x512xf32>
+  return %0 : tensor<512x512xf32>
+}
+// CHECK-LABEL: func @large_matmul
+//   CHECK-NOT:   tensor.expand_shape
+//       CHECK:   linalg.matmul
+
+// -----
+
+// Reduction too short to split.
+func @short_reduction(%lhs: tensor<1x300xf32>, %rhs: tensor<300x64xf32>, %init: tensor<1x64xf32>) -> tensor<1x64xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<1x300xf32>, tensor<300x64xf32>) outs(%init : tensor<1x64xf32>) -> tensor<1x64xf32>
+  return %0 : tensor<1x64xf32>
+}
+// CHECK-LABEL: func @short_reduction
+//   CHECK-NOT:   tensor.expand_shape
+//       CHECK:   linalg.matmul
+
+// -----
+
+func @dynamic_matmul(%lhs: tensor<?x?xf32>, %rhs: tensor<?x?xf32>, %init: tensor<?x?xf32>) -> tensor<?x?xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<?x?xf32>, tensor<?x?xf32>) outs(%init : tensor<?x?xf32>) -> tensor<?x?xf32>
+  return %0 : tensor<?x?xf32>
+}
+// CHECK-LABEL: func @dynamic_matmul
+//   CHECK-NOT:   tensor.expand_shape
+//       CHECK:   linalg.matmul
+
+// -----
+
+// The parallelism is inferred from the most parallel of the target devices.
+module attributes {hal.device.targets = [
+  #hal.device.target<"vulkan", {
+    executable_targets = [#hal.executable.target<"vulkan", "vulkan-spirv-fb">]
+  }>
+]} {
+func @gpu_target(%lhs: tensor<1x2048xf32>, %rhs: tensor<2048x1024xf32>, %init: tensor<1x1024xf32>) -> tensor<1x1024xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<1x2048xf32>, tensor<2048x1024xf32>) outs(%init : tensor<1x1024xf32>) -> tensor<1x1024xf32>
+  return %0 : tensor<1x1024xf32>
+}
+}
+// INFER-LABEL: func @gpu_target
+//       INFER:   tensor.expand_shape {{.+}} : tensor<1x2048xf32> into tensor<1x4x512xf32>
+//       INFER:   linalg.generic
+//       INFER:   linalg.generic
+
+// -----
+
+module attributes {hal.device.targets = [
+  #hal.device.target<"cpu", {
+    executable_targets = [#hal.executable.target<"llvm", "embedded-elf-x86_64">]
+  }>
+]} {
+func @cpu_target(%lhs: tensor<1x2048xf32>, %rhs: tensor<2048x1024xf32>, %init: tensor<1x1024xf32>) -> tensor<1x1024xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<1x2048xf32>, tensor<2048x1024xf32>) outs(%init : tensor<1x1024xf32>) -> tensor<1x1024xf32>
+  return %0 : tensor<1x1024xf32>
+}
+}
+// INFER-LABEL: func @cpu_target
+//   INFER-NOT:   tensor.expand_shape
+//       INFER:   linalg.matmul
@@ -0,0 +1,99 @@
+// RUN: iree-opt -split-input-file --iree-flow-split-topk-reduction %s | FileCheck %s
+
+func @topk_split(%values: tensor<4x8192xf32>) -> (tensor<4x8xf32>, tensor<4x8xi32>) {
+  %neg_inf = arith.constant 0xFF800000 : f32
+  %zero = arith.constant 0 : i32
+  %init_values = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+  %fill_values = linalg.fill(%neg_inf, %init_values) : f32, tensor<4x8xf32> -> tensor<4x8xf32>
+  %init_indices = linalg.init_tensor [4, 8] : tensor<4x8xi32>
+  %fill_indices = linalg.fill(%zero, %init_indices) : i32, tensor<4x8xi32> -> tensor<4x8xi32>
+  %0:2 = iree_linalg_ext.topk dimension(1)
+    ins(%values : tensor<4x8192xf32>)
+    outs(%fill_values, %fill_indices : tensor<4x8xf32>, tensor<4x8xi32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %1 = arith.cmpf ogt, %arg0, %arg1 : f32
+      iree_linalg_ext.yield %1 : i1
+    } -> tensor<4x8xf32>, tensor<4x8xi32>
+  return %0#0, %0#1 : tensor<4x8xf32>, tensor<4x8xi32>
+}
+//      CHECK: func @topk_split
+// CHECK-SAME:   %[[VALUES:[a-zA-Z0-9]+]]: tensor<4x8192xf32>
+//  CHECK-DAG:   %[[NEG_INF:.+]] = arith.constant 0xFF800000 : f32
+//  CHECK-DAG:   %[[ZERO:.+]] = arith.constant 0 : i32
+//      CHECK:   %[[FILL_VALUES:.+]] = linalg.fill(%[[NEG_INF]]
+//      CHECK:   %[[FILL_INDICES:.+]] = linalg.fill(%[[ZERO]]
+//      CHECK:   %[[EXPANDED:.+]] = tensor.expand_shape %[[VALUES]] {{\[}}[0], [1, 2]] : tensor<4x8192xf32> into tensor<4x8x1024xf32>
+//      CHECK:   %[[PARTIAL_VALUES_INIT:.+]] = linalg.init_tensor [4, 8, 8] : tensor<4x8x8xf32>
+//      CHECK:   %[[PARTIAL_VALUES_FILL:.+]] = linalg.fill(%[[NEG_INF]], %[[PARTIAL_VALUES_INIT]])
+//      CHECK:   %[[PARTIAL_INDICES_INIT:.+]] = linalg.init_tensor [4, 8, 8] : tensor<4x8x8xi32>
+//      CHECK:   %[[PARTIAL_INDICES_FILL:.+]] = linalg.fill(%[[ZERO]], %[[PARTIAL_INDICES_INIT]])
+//      CHECK:   %[[PARTIAL:.+]]:2 = iree_linalg_ext.topk dimension(2)
+// CHECK-SAME:       ins(%[[EXPANDED]] : tensor<4x8x1024xf32>)
+// CHECK-SAME:       outs(%[[PARTIAL_VALUES_FILL]], %[[PARTIAL_INDICES_FILL]] : tensor<4x8x8xf32>, tensor<4x8x8xi32>)
+//      CHECK:     arith.cmpf ogt
+//      CHECK:   %[[OFFSET_INDICES:.+]] = linalg.generic
+// CHECK-SAME:       outs(%[[PARTIAL]]#1 : tensor<4x8x8xi32>)
+//      CHECK:     %[[CHUNK:.+]] = linalg.index 1 : index
+//      CHECK:     %[[OFFSET:.+]] = arith.muli %[[CHUNK]], %{{.+}} : index
+//      CHECK:     %[[OFFSET_I32:.+]] = arith.index_cast %[[OFFSET]] : index to i32
+//      CHECK:     arith.addi %{{.+}}, %[[OFFSET_I32]] : i32
+//      CHECK:   %[[COLLAPSED_VALUES:.+]] = tensor.collapse_shape %[[PARTIAL]]#0 {{\[}}[0], [1, 2]] : tensor<4x8x8xf32> into tensor<4x64xf32>
+//      CHECK:   %[[COLLAPSED_INDICES:.+]] = tensor.collapse_shape %[[OFFSET_INDICES]] {{\[}}[0], [1, 2]] : tensor<4x8x8xi32> into tensor<4x64xi32>
+//      CHECK:   %[[RESULT:.+]]:2 = iree_linalg_ext.topk dimension(1)
+// CHECK-SAME:       ins(%[[COLLAPSED_VALUES]], %[[COLLAPSED_INDICES]] : tensor<4x64xf32>, tensor<4x64xi32>)
+// CHECK-SAME:       outs(%[[FILL_VALUES]], %[[FILL_INDICES]] : tensor<4x8xf32>, tensor<4x8xi32>)
+//      CHECK:     arith.cmpf ogt
+//      CHECK:   return %[[RESULT]]#0, %[[RESULT]]#1
+
+// -----
+
+func @topk_split_with_indices(%values: tensor<8192xi32>, %indices: tensor<8192xi32>) -> (tensor<4xi32>, tensor<4xi32>) {
+  %min = arith.constant -2147483648 : i32
+  %zero = arith.constant 0 : i32
+  %init_values = linalg.init_tensor [4] : tensor<4xi32>
+  %fill_values = linalg.fill(%min, %init_values) : i32, tensor<4xi32> -> tensor<4xi32>
+  %init_indices = linalg.init_tensor [4] : tensor<4xi32>
+  %fill_indices = linalg.fill(%zero, %init_indices) : i32, tensor<4xi32> -> tensor<4xi32>
+  %0:2 = iree_linalg_ext.topk dimension(0)
+    ins(%values, %indices : tensor<8192xi32>, tensor<8192xi32>)
+    outs(%fill_values, %fill_indices : tensor<4xi32>, tensor<4xi32>) {
+    ^bb0(%arg0: i32, %arg1: i32):
+      %1 = arith.cmpi sgt, %arg0, %arg1 : i32
+      iree_linalg_ext.yield %1 : i1
+    } -> tensor<4xi32>, tensor<4xi32>
+  return %0#0, %0#1 : tensor<4xi32>, tensor<4xi32>
+}
+//      CHECK: func @topk_split_with_indices
+// CHECK-SAME:   %[[VALUES:[a-zA-Z0-9]+]]: tensor<8192xi32>
+// CHECK-SAME:   %[[INDICES:[a-zA-Z0-9]+]]: tensor<8192xi32>
+//  CHECK-DAG:   %[[EXPANDED_VALUES:.+]] = tensor.expand_shape %[[VALUES]] {{\[}}[0, 1]] : tensor<8192xi32> into tensor<8x1024xi32>
+//  CHECK-DAG:   %[[EXPANDED_INDICES:.+]] = tensor.expand_shape %[[INDICES]] {{\[}}[0, 1]] : tensor<8192xi32> into tensor<8x1024xi32>
+//      CHECK:   %[[PARTIAL:.+]]:2 = iree_linalg_ext.topk dimension(1)
+// CHECK-SAME:       ins(%[[EXPANDED_VALUES]], %[[EXPANDED_INDICES]] : tensor<8x1024xi32>, tensor<8x1024xi32>)
+//  CHECK-NOT:   linalg.generic
+//      CHECK:   %[[COLLAPSED_VALUES:.+]] = tensor.collapse_shape %[[PARTIAL]]#0 {{\[}}[0, 1]] : tensor<8x4xi32> into tensor<32xi32>
+//      CHECK:   %[[COLLAPSED_INDICES:.+]] = tensor.collapse_shape %[[PARTIAL]]#1 {{\[}}[0, 1]] : tensor<8x4xi32> into tensor<32xi32>
+//      CHECK:   %[[RESULT:.+]]:2 = iree_linalg_ext.topk dimension(0)
+// CHECK-SAME:       ins(%[[COLLAPSED_VALUES]], %[[COLLAPSED_INDICES]] : tensor<32xi32>, tensor<32xi32>)
+//      CHECK:   return %[[RESULT]]#0, %[[RESULT]]#1
+
+// -----
+
+func @topk_too_short(%values: tensor<4x512xf32>, %out_values: tensor<4x8xf32>, %out_indices: tensor<4x8xi32>) -> (tensor<4x8xf32>, tensor<4x8xi32>) {
+  %neg_inf = arith.constant 0xFF800000 : f32
+  %zero = arith.constant 0 : i32
+  %fill_values = linalg.fill(%neg_inf, %out_values) : f32, tensor<4x8xf32> -> tensor<4x8xf32>
+  %fill_indices = linalg.fill(%zero, %out_indices) : i32, tensor<4x8xi32> -> tensor<4x8xi32>
+  %0:2 = iree_linalg_ext.topk dimension(1)
+    ins(%values : tensor<4x512xf32>)
+    outs(%fill_values, %fill_indices : tensor<4x8xf32>, tensor<4x8xi32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %1 = arith.cmpf ogt, %arg0, %arg1 : f32
+      iree_linalg_ext.yield %1 : i1
+    } -> tensor<4x8xf32>, tensor<4x8xi32>
+  return %0#0, %0#1 : tensor<4x8xf32>, tensor<4x8xi32>
+}
+//      CHECK: func @topk_too_short
+//  CHECK-NOT:   tensor.expand_shape
+//      CHECK:   iree_linalg_ext.topk dimension(1)
+//  CHECK-NOT:   iree_linalg_ext.topk
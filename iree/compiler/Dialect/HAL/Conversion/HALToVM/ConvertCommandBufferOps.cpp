@@ -161,6 +161,10 @@ void populateHALCommandBufferToVMPatterns(MLIRContext *context,
       .insert<VMImportOpConversion<IREE::HAL::CommandBufferDispatchIndirectOp>>(
           context, importSymbols, typeConverter,
           "hal.command_buffer.dispatch.indirect");
+  patterns
+      .insert<VMImportOpConversion<IREE::HAL::CommandBufferDispatchBatchOp>>(
+          context, importSymbols, typeConverter,
+          "hal.command_buffer.dispatch.batch");
 }
 
 }  // namespace iree_compiler
@@ -114,6 +114,10 @@ void populateHALDeviceToVMPatterns(MLIRContext *context,
                                    RewritePatternSet &patterns) {
   patterns.insert<VMImportOpConversion<IREE::HAL::DeviceAllocatorOp>>(
       context, importSymbols, typeConverter, "hal.device.allocator");
+  patterns.insert<VMImportOpConversion<IREE::HAL::DeviceQueueAllocaOp>>(
+      context, importSymbols, typeConverter, "hal.device.queue.alloca");
+  patterns.insert<VMImportOpConversion<IREE::HAL::DeviceQueueDeallocaOp>>(
+      context, importSymbols, typeConverter, "hal.device.queue.dealloca");
 
   patterns.insert<DeviceQueryIntCastOpConversion>(context, typeConverter);
   patterns.insert<DeviceQueryI32OpConversion>(
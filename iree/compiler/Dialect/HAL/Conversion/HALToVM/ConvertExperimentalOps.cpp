@@ -17,8 +17,16 @@ void populateHALExperimentalToVMPatterns(MLIRContext *context,
                                          RewritePatternSet &patterns) {
   patterns.insert<VMImportOpConversion<IREE::HAL::ExSharedDeviceOp>>(
       context, importSymbols, typeConverter, "hal.ex.shared_device");
+  patterns.insert<VMImportOpConversion<IREE::HAL::ExDeviceOp>>(
+      context, importSymbols, typeConverter, "hal.ex.device");
+  patterns.insert<VMImportOpConversion<IREE::HAL::ExSubmitOp>>(
+      context, importSymbols, typeConverter, "hal.ex.submit");
   patterns.insert<VMImportOpConversion<IREE::HAL::ExSubmitAndWaitOp>>(
       context, importSymbols, typeConverter, "hal.ex.submit_and_wait");
+  patterns.insert<VMImportOpConversion<IREE::HAL::ExSubmitAwaitOp>>(
+      context, importSymbols, typeConverter, "hal.ex.submit_await");
+  patterns.insert<VMImportOpConversion<IREE::HAL::ExSubmitTimelineOp>>(
+      context, importSymbols, typeConverter, "hal.ex.submit_timeline");
 }
 
 }  // namespace iree_compiler
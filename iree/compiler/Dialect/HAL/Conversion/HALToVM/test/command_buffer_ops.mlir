@@ -161,3 +161,22 @@ func @command_buffer_dispatch_indirect(
       workgroups(%arg2 : !hal.buffer)[%c100]
   return
 }
+
+// -----
+
+// CHECK-LABEL: @command_buffer_dispatch_batch
+func @command_buffer_dispatch_batch(
+  %arg0: !hal.command_buffer,
+  %arg1: !hal.executable_layout,
+  %arg2: !hal.buffer,
+  %arg3: !hal.executable
+) {
+  // CHECK: %[[COMMANDS:.+]] = vm.rodata.inline {{.*}}: !vm.buffer = dense<[3, 2, 0, 1, 1, 1]> : vector<6xi32>
+  %commands = util.byte_buffer.constant {alignment = 4 : i64} : !util.byte_buffer = dense<[3, 2, 0, 1, 1, 1]> : vector<6xi32>
+  // CHECK: vm.call.variadic @hal.command_buffer.dispatch.batch(%arg0, %[[COMMANDS]], [%arg1, %arg2, %arg3]) : (!vm.ref<!hal.command_buffer>, !vm.buffer, !vm.ref<?> ...)
+  hal.command_buffer.dispatch.batch<%arg0 : !hal.command_buffer>
+      commands(%commands : !util.byte_buffer)
+      resources([%arg1, %arg2, %arg3])
+      : !hal.executable_layout, !hal.buffer, !hal.executable
+  return
+}
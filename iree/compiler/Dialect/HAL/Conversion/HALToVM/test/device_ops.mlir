@@ -10,6 +10,27 @@ func @device_allocator(%device: !hal.device) -> !hal.allocator {
 
 // -----
 
+// CHECK-LABEL: @device_queue_alloca
+// CHECK-SAME: (%[[DEVICE:.+]]: !vm.ref<!hal.device>)
+func @device_queue_alloca(%device: !hal.device) -> !hal.buffer {
+  %c1024 = arith.constant 1024 : index
+  // CHECK: %ref = vm.call @hal.device.queue.alloca(%[[DEVICE]], %c49, %c10, %c1024) : (!vm.ref<!hal.device>, i32, i32, i32) -> !vm.ref<!hal.buffer>
+  %0 = hal.device.queue.alloca<%device : !hal.device> type("Transient|DeviceLocal") usage("Transfer|Dispatch") : !hal.buffer{%c1024}
+  return %0 : !hal.buffer
+}
+
+// -----
+
+// CHECK-LABEL: @device_queue_dealloca
+// CHECK-SAME: (%[[DEVICE:.+]]: !vm.ref<!hal.device>, %[[BUFFER:.+]]: !vm.ref<!hal.buffer>)
+func @device_queue_dealloca(%device: !hal.device, %buffer: !hal.buffer) {
+  // CHECK: vm.call @hal.device.queue.dealloca(%[[DEVICE]], %[[BUFFER]]) : (!vm.ref<!hal.device>, !vm.ref<!hal.buffer>) -> ()
+  hal.device.queue.dealloca<%device : !hal.device> buffer(%buffer : !hal.buffer)
+  return
+}
+
+// -----
+
 // CHECK-LABEL: @device_query_i32
 // CHECK-SAME: (%[[DEVICE:.+]]: !vm.ref<!hal.device>)
 func @device_query_i32(%device: !hal.device) -> (i1, i32) {
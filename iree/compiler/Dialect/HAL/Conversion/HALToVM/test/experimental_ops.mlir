@@ -0,0 +1,42 @@
+// RUN: iree-opt -split-input-file -iree-convert-hal-to-vm -canonicalize %s | FileCheck %s
+
+// CHECK-LABEL: @ex_device
+// CHECK-SAME: (%[[ORDINAL:.+]]: i32)
+func @ex_device(%ordinal: index) -> !hal.device {
+  // CHECK: %[[DEVICE:.+]] = vm.call @hal.ex.device(%[[ORDINAL]]) {nosideeffects} : (i32) -> !vm.ref<!hal.device>
+  %device = hal.ex.device[%ordinal] : !hal.device
+  // CHECK: vm.return %[[DEVICE]]
+  return %device : !hal.device
+}
+
+// -----
+
+// CHECK-LABEL: @ex_submit
+// CHECK-SAME: (%[[DEVICE:.+]]: !vm.ref<!hal.device>, %[[CMD:.+]]: !vm.ref<!hal.command_buffer>, %[[WAIT:.+]]: i32)
+func @ex_submit(%device: !hal.device, %cmd: !hal.command_buffer, %wait: index) -> index {
+  // CHECK: %[[VALUE:.+]] = vm.call @hal.ex.submit(%[[DEVICE]], %[[CMD]], %[[WAIT]]) : (!vm.ref<!hal.device>, !vm.ref<!hal.command_buffer>, i32) -> i32
+  %value = hal.ex.submit %device, %cmd wait(%wait) : index
+  // CHECK: vm.return %[[VALUE]]
+  return %value : index
+}
+
+// -----
+
+// CHECK-LABEL: @ex_submit_await
+// CHECK-SAME: (%[[TIMEPOINT:.+]]: i32)
+func @ex_submit_await(%timepoint: index) {
+  // CHECK: vm.call @hal.ex.submit_await(%[[TIMEPOINT]]) : (i32) -> ()
+  hal.ex.submit_await %timepoint
+  return
+}
+
+// -----
+
+// CHECK-LABEL: @ex_submit_timeline
+// CHECK-SAME: (%[[TIMEPOINT:.+]]: i32)
+func @ex_submit_timeline(%timepoint: index) -> (!hal.semaphore, index) {
+  // CHECK: %[[TIMELINE:.+]]:2 = vm.call @hal.ex.submit_timeline(%[[TIMEPOINT]]) : (i32) -> (!vm.ref<!hal.semaphore>, i32)
+  %timeline:2 = hal.ex.submit_timeline[%timepoint] : !hal.semaphore, index
+  // CHECK: vm.return %[[TIMELINE]]#0, %[[TIMELINE]]#1
+  return %timeline#0, %timeline#1 : !hal.semaphore, index
+}
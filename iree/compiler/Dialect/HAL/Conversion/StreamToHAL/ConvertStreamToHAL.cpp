@@ -15,6 +15,7 @@
 #include "iree/compiler/Dialect/Stream/IR/StreamTypes.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/Transforms/DialectConversion.h"
 
 namespace mlir {
@@ -40,8 +41,18 @@ static Value makeEncodingType(Location loc, Attribute encodingType,
   return constantValue;
 }
 
+// Returns the device |op| has affinity with. Ops without an affinity or with
+// an affinity for device 0 use the shared device.
 static Value lookupDeviceFor(Operation *op, OpBuilder &builder) {
-  // TODO(benvanik): make this do multi-device lookup and other fancy things.
+  // TODO(benvanik): queue affinity and other fancy things.
+  auto affinityAttr = IREE::Stream::AffinityAttr::lookup(op);
+  if (affinityAttr && affinityAttr.getDeviceOrdinal() != 0) {
+    auto ordinal = builder.createOrFold<arith::ConstantIndexOp>(
+        op->getLoc(), affinityAttr.getDeviceOrdinal());
+    auto lookupOp =
+        builder.create<IREE::HAL::ExDeviceOp>(op->getLoc(), ordinal);
+    return lookupOp.result();
+  }
   auto lookupOp = builder.create<IREE::HAL::ExSharedDeviceOp>(op->getLoc());
   return lookupOp.result();
 }
@@ -53,6 +64,24 @@ static Value lookupAllocatorFor(Operation *op, OpBuilder &builder) {
   return allocatorOp.result();
 }
 
+// Blocks the caller until |timepoint| has been reached on the submission
+// timeline. Timepoints are values signaled by hal.ex.submit and 0 is always
+// reached.
+static void buildTimepointAwait(Location loc, Value timepoint,
+                                OpBuilder &builder) {
+  if (matchPattern(timepoint, m_Zero())) return;
+  builder.create<IREE::HAL::ExSubmitAwaitOp>(loc, timepoint);
+}
+
+// Returns true if the timepoint of |executeOp| is awaited by the op immediately
+// following it and there is nothing to gain by submitting asynchronously.
+static bool isExecuteImmediatelyAwaited(IREE::Stream::CmdExecuteOp executeOp) {
+  if (executeOp.await_timepoint()) return false;
+  auto awaitOp = dyn_cast_or_null<IREE::Stream::TimepointAwaitOp>(
+      executeOp->getNextNode());
+  return awaitOp && awaitOp.await_timepoint() == executeOp.result_timepoint();
+}
+
 // Scans all of the stream.cmd.* ops in the region to derive a command category.
 static IREE::HAL::CommandCategoryBitfield deriveCommandCategories(
     Region &region) {
@@ -246,7 +275,7 @@ struct ResourceAllocaOpPattern
   LogicalResult matchAndRewrite(
       IREE::Stream::ResourceAllocaOp allocaOp, OpAdaptor adaptor,
       ConversionPatternRewriter &rewriter) const override {
-    auto allocator = lookupAllocatorFor(allocaOp, rewriter);
+    auto device = lookupDeviceFor(allocaOp, rewriter);
     auto bufferType = rewriter.getType<IREE::HAL::BufferType>();
 
     // Transient allocations are device-local. Copies are required to get their
@@ -261,11 +290,12 @@ struct ResourceAllocaOpPattern
     auto bufferUsage = IREE::HAL::BufferUsageBitfield::Dispatch |
                        IREE::HAL::BufferUsageBitfield::Transfer;
 
-    auto allocateOp = rewriter.create<IREE::HAL::AllocatorAllocateOp>(
-        allocaOp.getLoc(), bufferType, allocator, memoryTypes, bufferUsage,
+    auto allocateOp = rewriter.create<IREE::HAL::DeviceQueueAllocaOp>(
+        allocaOp.getLoc(), bufferType, device, memoryTypes, bufferUsage,
         allocaOp.storage_size());
 
-    // TODO(benvanik): stream ordered allocations.
+    // Submissions are currently synchronous and the allocation is available
+    // immediately.
     auto resolvedTimepoint =
         rewriter.create<arith::ConstantIndexOp>(allocaOp.getLoc(), 0)
             .getResult();
@@ -281,7 +311,15 @@ struct ResourceDeallocaOpPattern
   LogicalResult matchAndRewrite(
       IREE::Stream::ResourceDeallocaOp deallocaOp, OpAdaptor adaptor,
       ConversionPatternRewriter &rewriter) const override {
-    // TODO(benvanik): stream ordered allocations.
+    // The transient buffer is immediately available for reuse once returned
+    // and as such all work using it must have completed.
+    if (adaptor.await_timepoint()) {
+      buildTimepointAwait(deallocaOp.getLoc(), adaptor.await_timepoint(),
+                          rewriter);
+    }
+    auto device = lookupDeviceFor(deallocaOp, rewriter);
+    rewriter.create<IREE::HAL::DeviceQueueDeallocaOp>(
+        deallocaOp.getLoc(), device, adaptor.operand());
     auto resolvedTimepoint =
         rewriter.create<arith::ConstantIndexOp>(deallocaOp.getLoc(), 0)
             .getResult();
@@ -914,11 +952,16 @@ struct CmdExecuteOpPattern
     auto loc = executeOp.getLoc();
     auto device = lookupDeviceFor(executeOp, rewriter);
 
-    // TODO(benvanik): disable inline execution once we have semaphores.
-    // We can look ahead to see if there's an await immediately to trigger the
-    // inline execution.
-    auto modes = IREE::HAL::CommandBufferModeBitfield::OneShot |
-                 IREE::HAL::CommandBufferModeBitfield::AllowInlineExecution;
+    // Executions that are immediately awaited are submitted synchronously and
+    // may execute inline during recording. All others are submitted
+    // asynchronously and must not begin executing until submitted as prior
+    // submissions may still be in flight.
+    bool isSynchronous = isExecuteImmediatelyAwaited(executeOp);
+    auto modes = IREE::HAL::CommandBufferModeBitfield::OneShot;
+    if (isSynchronous) {
+      modes =
+          modes | IREE::HAL::CommandBufferModeBitfield::AllowInlineExecution;
+    }
 
     // Derive the command buffer type based on the kind of operations present.
     // This can help the submission get routed to appropriate hardware queues
@@ -947,14 +990,23 @@ struct CmdExecuteOpPattern
     rewriter.mergeBlockBefore(&executeOp.body().front(), endOp,
                               adaptor.operands());
 
-    // TODO(benvanik): we should queue a submit here with the semaphore instead.
-    rewriter.create<IREE::HAL::ExSubmitAndWaitOp>(loc, device, commandBuffer);
-
-    // TODO(benvanik): propagate semaphore information.
-    auto resolvedTimepoint =
-        rewriter.create<arith::ConstantIndexOp>(loc, 0).getResult();
-
-    rewriter.replaceOp(executeOp, resolvedTimepoint);
+    // Submissions to the same device are ordered on the submission timeline
+    // and only wait on the await timepoint for work on other devices.
+    Value waitTimepoint = adaptor.await_timepoint();
+    if (!waitTimepoint) {
+      waitTimepoint = rewriter.create<arith::ConstantIndexOp>(loc, 0);
+    }
+    if (isSynchronous) {
+      rewriter.create<IREE::HAL::ExSubmitAndWaitOp>(loc, device, commandBuffer,
+                                                    waitTimepoint);
+      auto resolvedTimepoint =
+          rewriter.create<arith::ConstantIndexOp>(loc, 0).getResult();
+      rewriter.replaceOp(executeOp, resolvedTimepoint);
+      return success();
+    }
+    auto signalTimepoint = rewriter.create<IREE::HAL::ExSubmitOp>(
+        loc, rewriter.getIndexType(), device, commandBuffer, waitTimepoint);
+    rewriter.replaceOp(executeOp, signalTimepoint.signal_value());
     return success();
   }
 };
@@ -1049,14 +1101,18 @@ struct TimepointExportOpPattern
                                          "sequence value tuples are supported");
     }
 
-    auto loc = exportOp.getLoc();
-    auto device = lookupDeviceFor(exportOp, rewriter);
-
-    // TODO(benvanik): model timepoints as semaphores.
-    // For now we just create a signaled semaphore.
-    auto exportValue = rewriter.create<arith::ConstantIndexOp>(loc, 0);
-    auto exportSemaphore = rewriter.create<IREE::HAL::SemaphoreCreateOp>(
-        loc, rewriter.getType<IREE::HAL::SemaphoreType>(), device, exportValue);
+    // Timepoints are values on the submission timeline and are exported as a
+    // semaphore payload such that callers can wait on the work without
+    // blocking here (unless it spans multiple devices).
+    auto timelineOp = rewriter.create<IREE::HAL::ExSubmitTimelineOp>(
+        exportOp.getLoc(), rewriter.getType<IREE::HAL::SemaphoreType>(),
+        rewriter.getIndexType(), adaptor.await_timepoint());
+    Value exportSemaphore = timelineOp.semaphore();
+    Value exportValue = timelineOp.value();
+    if (exportOp.getResult(1).getType() != exportValue.getType()) {
+      exportValue = rewriter.create<arith::IndexCastOp>(
+          exportOp.getLoc(), exportOp.getResult(1).getType(), exportValue);
+    }
     rewriter.replaceOp(exportOp, {exportSemaphore, exportValue});
     return success();
   }
@@ -1068,11 +1124,18 @@ struct TimepointJoinOpPattern
   LogicalResult matchAndRewrite(
       IREE::Stream::TimepointJoinOp joinOp, OpAdaptor adaptor,
       ConversionPatternRewriter &rewriter) const override {
-    // TODO(benvanik): model timepoints as semaphores.
-    // This should be a max() of the operand timepoints. Could be done with
-    // affine expressions, but since everything is always 0 we just max(0,0)=0
-    // here :)
-    rewriter.replaceOpWithNewOp<arith::ConstantIndexOp>(joinOp, 0);
+    // Timeline values are reached in order and the join of timepoints is the
+    // latest of them.
+    auto loc = joinOp.getLoc();
+    auto timepoints = adaptor.await_timepoints();
+    Value result = timepoints.front();
+    for (auto timepoint : timepoints.drop_front()) {
+      auto isLater = rewriter.create<arith::CmpIOp>(
+          loc, arith::CmpIPredicate::ugt, timepoint, result);
+      result =
+          rewriter.create<arith::SelectOp>(loc, isLater, timepoint, result);
+    }
+    rewriter.replaceOp(joinOp, result);
     return success();
   }
 };
@@ -1083,7 +1146,8 @@ struct TimepointAwaitOpPattern
   LogicalResult matchAndRewrite(
       IREE::Stream::TimepointAwaitOp awaitOp, OpAdaptor adaptor,
       ConversionPatternRewriter &rewriter) const override {
-    // TODO(benvanik): model timepoints as semaphores.
+    buildTimepointAwait(awaitOp.getLoc(), adaptor.await_timepoint(),
+                        rewriter);
     rewriter.replaceOp(awaitOp, adaptor.operands());
     return success();
   }
@@ -1134,10 +1198,10 @@ void populateStreamToHALPatterns(MLIRContext *context,
 
   typeConverter.addConversion(
       [=](IREE::Stream::TimepointType type, SmallVectorImpl<Type> &results) {
-        // TODO(benvanik): model timepoints as semaphores.
-        // This may become a !hal.semaphore + index, or some !hal.timepoint that
-        // we then do more analysis on once we know what devices are in use
-        // where.
+        // Timepoints are values on the submission timeline semaphore. 0 is
+        // always reached.
+        // TODO(benvanik): model timepoints per-device once we know what
+        // devices are in use where.
         results.push_back(IndexType::get(context));
         return success();
       });
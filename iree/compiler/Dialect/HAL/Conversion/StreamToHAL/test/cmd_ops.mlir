@@ -1,7 +1,70 @@
 // RUN: iree-opt -split-input-file -iree-hal-conversion %s | FileCheck %s
 
-// TODO(#7277): add new streams->hal conversion tests.
-// CHECK: @todo
-func @todo() {
-  return
+// Executions whose results are not immediately awaited are submitted
+// asynchronously and return the submission timeline value.
+
+// CHECK-LABEL: @cmdExecuteAsync
+// CHECK-SAME: (%[[BUFFER:.+]]: !hal.buffer, %[[LENGTH:.+]]: index, %[[AWAIT:.+]]: index)
+func @cmdExecuteAsync(%arg0: !stream.resource<transient>, %arg1: index, %arg2: !stream.timepoint) -> !stream.timepoint {
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %c255_i32 = arith.constant 255 : i32
+  // CHECK: %[[DEVICE:.+]] = hal.ex.shared_device : !hal.device
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create device(%[[DEVICE]] : !hal.device)
+  // CHECK-SAME: mode(OneShot)
+  // CHECK-SAME: categories("Transfer|Dispatch")
+  %0 = stream.cmd.execute await(%arg2) => with(%arg0 as %arg3: !stream.resource<transient>{%arg1}) {
+    // CHECK: hal.command_buffer.fill_buffer<%[[CMD]] : !hal.command_buffer>
+    stream.cmd.fill %c255_i32, %arg3[%c0 for %c128] : i32 -> !stream.resource<transient>{%arg1}
+  } => !stream.timepoint
+  // CHECK: hal.command_buffer.end<%[[CMD]] : !hal.command_buffer>
+  // CHECK: %[[SIGNAL:.+]] = hal.ex.submit %[[DEVICE]], %[[CMD]] wait(%[[AWAIT]]) : index
+  // CHECK: return %[[SIGNAL]]
+  return %0 : !stream.timepoint
+}
+
+// -----
+
+// Executions with an affinity for a device other than the default are recorded
+// and submitted on that device.
+
+// CHECK-LABEL: @cmdExecuteAffinity
+// CHECK-SAME: (%[[BUFFER:.+]]: !hal.buffer, %[[LENGTH:.+]]: index, %[[AWAIT:.+]]: index)
+func @cmdExecuteAffinity(%arg0: !stream.resource<transient>, %arg1: index, %arg2: !stream.timepoint) -> !stream.timepoint {
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %c255_i32 = arith.constant 255 : i32
+  // CHECK: %[[ORDINAL:.+]] = arith.constant 1 : index
+  // CHECK: %[[DEVICE:.+]] = hal.ex.device[%[[ORDINAL]]] : !hal.device
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create device(%[[DEVICE]] : !hal.device)
+  %0 = stream.cmd.execute on(#stream.affinity<device = 1>) await(%arg2) => with(%arg0 as %arg3: !stream.resource<transient>{%arg1}) {
+    stream.cmd.fill %c255_i32, %arg3[%c0 for %c128] : i32 -> !stream.resource<transient>{%arg1}
+  } => !stream.timepoint
+  // CHECK: %[[SIGNAL:.+]] = hal.ex.submit %[[DEVICE]], %[[CMD]] wait(%[[AWAIT]]) : index
+  // CHECK: return %[[SIGNAL]]
+  return %0 : !stream.timepoint
+}
+
+// -----
+
+// Executions immediately awaited are submitted synchronously and may execute
+// inline.
+
+// CHECK-LABEL: @cmdExecuteSync
+// CHECK-SAME: (%[[BUFFER:.+]]: !hal.buffer, %[[LENGTH:.+]]: index)
+func @cmdExecuteSync(%arg0: !stream.resource<transient>, %arg1: index) -> !stream.resource<transient> {
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %c255_i32 = arith.constant 255 : i32
+  // CHECK: %[[DEVICE:.+]] = hal.ex.shared_device : !hal.device
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create device(%[[DEVICE]] : !hal.device)
+  // CHECK-SAME: mode("OneShot|AllowInlineExecution")
+  %0 = stream.cmd.execute with(%arg0 as %arg2: !stream.resource<transient>{%arg1}) {
+    stream.cmd.fill %c255_i32, %arg2[%c0 for %c128] : i32 -> !stream.resource<transient>{%arg1}
+  } => !stream.timepoint
+  // CHECK: hal.ex.submit_and_wait %[[DEVICE]], %[[CMD]] wait(%{{.+}})
+  // CHECK-NOT: hal.ex.submit_await
+  %1 = stream.timepoint.await %0 => %arg0 : !stream.resource<transient>{%arg1}
+  // CHECK: return %[[BUFFER]]
+  return %1 : !stream.resource<transient>
 }
@@ -1,7 +1,46 @@
 // RUN: iree-opt -split-input-file -iree-hal-conversion %s | FileCheck %s
 
-// TODO(#7277): add new streams->hal conversion tests.
-// CHECK: @todo
-func @todo() {
-  return
+// CHECK-LABEL: @timepointImmediate
+func @timepointImmediate() -> !stream.timepoint {
+  // CHECK: %[[TIMEPOINT:.+]] = arith.constant 0 : index
+  %0 = stream.timepoint.immediate => !stream.timepoint
+  // CHECK: return %[[TIMEPOINT]]
+  return %0 : !stream.timepoint
+}
+
+// -----
+
+// Timepoints are exported as semaphore payloads of the submission timeline.
+
+// CHECK-LABEL: @timepointExport
+// CHECK-SAME: (%[[TIMEPOINT:.+]]: index)
+func @timepointExport(%arg0: !stream.timepoint) -> (!hal.semaphore, index) {
+  // CHECK: %[[TIMELINE:.+]], %[[VALUE:.+]] = hal.ex.submit_timeline[%[[TIMEPOINT]]] : !hal.semaphore, index
+  %0:2 = stream.timepoint.export %arg0 => (!hal.semaphore, index)
+  // CHECK: return %[[TIMELINE]], %[[VALUE]]
+  return %0#0, %0#1 : !hal.semaphore, index
+}
+
+// -----
+
+// CHECK-LABEL: @timepointJoin
+// CHECK-SAME: (%[[TIMEPOINT0:.+]]: index, %[[TIMEPOINT1:.+]]: index)
+func @timepointJoin(%arg0: !stream.timepoint, %arg1: !stream.timepoint) -> !stream.timepoint {
+  // CHECK: %[[IS_LATER:.+]] = arith.cmpi ugt, %[[TIMEPOINT1]], %[[TIMEPOINT0]] : index
+  // CHECK: %[[JOIN:.+]] = arith.select %[[IS_LATER]], %[[TIMEPOINT1]], %[[TIMEPOINT0]] : index
+  %0 = stream.timepoint.join max(%arg0, %arg1) => !stream.timepoint
+  // CHECK: return %[[JOIN]]
+  return %0 : !stream.timepoint
+}
+
+// -----
+
+// CHECK-LABEL: @timepointAwait
+// CHECK-SAME: (%[[TIMEPOINT:.+]]: index, %[[RESOURCE:.+]]: !hal.buffer)
+func @timepointAwait(%arg0: !stream.timepoint, %arg1: !stream.resource<staging>) -> !stream.resource<staging> {
+  %c100 = arith.constant 100 : index
+  // CHECK: hal.ex.submit_await %[[TIMEPOINT]]
+  %0 = stream.timepoint.await %arg0 => %arg1 : !stream.resource<staging>{%c100}
+  // CHECK: return %[[RESOURCE]]
+  return %0 : !stream.resource<staging>
 }
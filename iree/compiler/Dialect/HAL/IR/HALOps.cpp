@@ -178,6 +178,36 @@ void ExSharedDeviceOp::getAsmResultNames(
   setNameFn(result(), "device");
 }
 
+//===----------------------------------------------------------------------===//
+// hal.ex.device
+//===----------------------------------------------------------------------===//
+
+void ExDeviceOp::getAsmResultNames(
+    function_ref<void(Value, StringRef)> setNameFn) {
+  setNameFn(result(), "device");
+}
+
+// static
+Optional<int64_t> ExDeviceOp::findDeviceOrdinal(Value device) {
+  if (device.getDefiningOp<ExSharedDeviceOp>()) return 0;
+  if (auto deviceOp = device.getDefiningOp<ExDeviceOp>()) {
+    APInt ordinal;
+    if (matchPattern(deviceOp.ordinal(), m_ConstantInt(&ordinal))) {
+      return ordinal.getSExtValue();
+    }
+  }
+  return llvm::None;
+}
+
+// static
+Value ExDeviceOp::buildDeviceLookup(Location loc, int64_t ordinal,
+                                    OpBuilder &builder) {
+  if (ordinal == 0) return builder.createOrFold<ExSharedDeviceOp>(loc);
+  auto ordinalValue =
+      builder.createOrFold<arith::ConstantIndexOp>(loc, ordinal);
+  return builder.createOrFold<ExDeviceOp>(loc, ordinalValue);
+}
+
 //===----------------------------------------------------------------------===//
 // hal.tensor.import/export
 //===----------------------------------------------------------------------===//
@@ -514,6 +544,21 @@ void DeviceAllocatorOp::getAsmResultNames(
   setNameFn(result(), "allocator");
 }
 
+//===----------------------------------------------------------------------===//
+// hal.device.queue.alloca
+//===----------------------------------------------------------------------===//
+
+void DeviceQueueAllocaOp::getAsmResultNames(
+    function_ref<void(Value, StringRef)> setNameFn) {
+  setNameFn(result(), "transient_buffer");
+}
+
+Value DeviceQueueAllocaOp::getOperandSize(unsigned idx) { return {}; }
+
+Value DeviceQueueAllocaOp::getResultSize(unsigned idx) {
+  return result_size();
+}
+
 //===----------------------------------------------------------------------===//
 // hal.device.query
 //===----------------------------------------------------------------------===//
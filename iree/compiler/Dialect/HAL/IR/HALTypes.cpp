@@ -590,14 +590,43 @@ void ExecutableTargetAttr::print(AsmPrinter &p) const {
   os << ">";
 }
 
+// Returns the optional list of device features (as StringAttrs) that must be
+// supported by a device in order for it to load executables of |targetAttr|.
+// Backends use this to produce multiple variants of the same format that are
+// specialized for different processor features.
+static ArrayAttr getRequiredDeviceFeatures(ExecutableTargetAttr targetAttr) {
+  auto configAttr = targetAttr.getConfiguration();
+  if (!configAttr) return {};
+  return configAttr.getAs<ArrayAttr>("device_features");
+}
+
 std::string ExecutableTargetAttr::getSymbolNameFragment() {
   auto format = getFormat().getValue().lower();
+  if (auto featuresAttr = getRequiredDeviceFeatures(*this)) {
+    // Features are named `arch.feature` and the arch is already part of the
+    // format so only the feature name is needed to disambiguate.
+    for (auto featureAttr : featuresAttr.getAsRange<StringAttr>()) {
+      auto nameParts = featureAttr.getValue().rsplit('.');
+      format += "_";
+      format += nameParts.second.empty() ? nameParts.first.lower()
+                                         : nameParts.second.lower();
+    }
+  }
   std::replace(format.begin(), format.end(), '-', '_');
   return format;
 }
 
 Attribute ExecutableTargetAttr::getMatchExpression() {
-  return DeviceMatchExecutableFormatAttr::get(getContext(), getFormat());
+  auto formatAttr =
+      DeviceMatchExecutableFormatAttr::get(getContext(), getFormat());
+  auto featuresAttr = getRequiredDeviceFeatures(*this);
+  if (!featuresAttr || featuresAttr.empty()) return formatAttr;
+  SmallVector<Attribute> conditionAttrs;
+  conditionAttrs.push_back(formatAttr);
+  for (auto featureAttr : featuresAttr.getAsRange<StringAttr>()) {
+    conditionAttrs.push_back(DeviceMatchFeatureAttr::get(featureAttr));
+  }
+  return MatchAllAttr::get(getContext(), conditionAttrs);
 }
 
 //===----------------------------------------------------------------------===//
@@ -10,6 +10,32 @@ func @device_allocator(%device: !hal.device) -> !hal.allocator {
 
 // -----
 
+// CHECK-LABEL: @device_queue_alloca
+// CHECK-SAME: (%[[DEVICE:.+]]: !hal.device)
+func @device_queue_alloca(%device: !hal.device) -> !hal.buffer {
+  // CHECK-DAG: %[[SIZE:.+]] = arith.constant 123
+  %size = arith.constant 123 : index
+  //      CHECK: %transient_buffer = hal.device.queue.alloca<%[[DEVICE]] : !hal.device>
+  // CHECK-SAME:   type("Transient|DeviceVisible|DeviceLocal")
+  // CHECK-SAME:   usage("Transfer|Dispatch")
+  // CHECK-SAME:   : !hal.buffer{%[[SIZE]]}
+  %buffer = hal.device.queue.alloca<%device : !hal.device>
+      type("Transient|DeviceLocal") usage("Transfer|Dispatch") : !hal.buffer{%size}
+  return %buffer : !hal.buffer
+}
+
+// -----
+
+// CHECK-LABEL: @device_queue_dealloca
+// CHECK-SAME: (%[[DEVICE:.+]]: !hal.device, %[[BUFFER:.+]]: !hal.buffer)
+func @device_queue_dealloca(%device: !hal.device, %buffer: !hal.buffer) {
+  // CHECK: hal.device.queue.dealloca<%[[DEVICE]] : !hal.device> buffer(%[[BUFFER]] : !hal.buffer)
+  hal.device.queue.dealloca<%device : !hal.device> buffer(%buffer : !hal.buffer)
+  return
+}
+
+// -----
+
 // CHECK-LABEL: @device_switch
 // CHECK-SAME: (%[[DEVICE:.+]]: !hal.device)
 func @device_switch(%device: !hal.device) -> i32 {
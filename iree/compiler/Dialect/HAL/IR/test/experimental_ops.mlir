@@ -9,11 +9,51 @@ func @shared_device() -> !hal.device {
 
 // -----
 
+// CHECK-LABEL: @device
+func @device(%arg0: index) -> !hal.device {
+  // CHECK: %device = hal.ex.device[%arg0] : !hal.device
+  %device = hal.ex.device[%arg0] : !hal.device
+  return %device : !hal.device
+}
+
+// -----
+
 // CHECK-LABEL: @submit_and_wait
 func @submit_and_wait() {
   %0 = "test_hal.device"() : () -> !hal.device
   %1 = "test_hal.command_buffer"() : () -> !hal.command_buffer
-  // CHECK: hal.ex.submit_and_wait %0, %1
-  hal.ex.submit_and_wait %0, %1
+  %c0 = arith.constant 0 : index
+  // CHECK: hal.ex.submit_and_wait %0, %1 wait(%c0)
+  hal.ex.submit_and_wait %0, %1 wait(%c0)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: @submit
+func @submit() -> index {
+  %0 = "test_hal.device"() : () -> !hal.device
+  %1 = "test_hal.command_buffer"() : () -> !hal.command_buffer
+  %c0 = arith.constant 0 : index
+  // CHECK: %2 = hal.ex.submit %0, %1 wait(%c0) : index
+  %2 = hal.ex.submit %0, %1 wait(%c0) : index
+  return %2 : index
+}
+
+// -----
+
+// CHECK-LABEL: @submit_await
+func @submit_await(%arg0: index) {
+  // CHECK: hal.ex.submit_await %arg0
+  hal.ex.submit_await %arg0
   return
 }
+
+// -----
+
+// CHECK-LABEL: @submit_timeline
+func @submit_timeline(%arg0: index) -> (!hal.semaphore, index) {
+  // CHECK: %0:2 = hal.ex.submit_timeline[%arg0] : !hal.semaphore, index
+  %0:2 = hal.ex.submit_timeline[%arg0] : !hal.semaphore, index
+  return %0#0, %0#1 : !hal.semaphore, index
+}
@@ -9,6 +9,7 @@
 #include "iree/compiler/Codegen/Dialect/IREECodegenDialect.h"
 #include "iree/compiler/Codegen/Passes.h"
 #include "iree/compiler/Dialect/HAL/Target/CUDA/LLVMPasses.h"
+#include "iree/compiler/Dialect/HAL/Target/CUDA/LibraryCalls.h"
 #include "iree/compiler/Dialect/HAL/Target/CUDA/libdevice.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Utils/FlatbufferUtils.h"
@@ -19,6 +20,10 @@
 #include "llvm/IR/Module.h"
 #include "llvm/Linker/Linker.h"
 #include "llvm/MC/TargetRegistry.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Program.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
@@ -45,6 +50,26 @@ static llvm::cl::opt<std::string> clTargetChip(
     "iree-cuda-llvm-target-arch", llvm::cl::desc("LLVM target chip"),
     llvm::cl::init("sm_35"));
 
+static llvm::cl::list<std::string> clCubinTargetChips(
+    "iree-hal-cuda-cubin-target-archs",
+    llvm::cl::desc("Comma-separated SM architectures (e.g. sm_70,sm_80) to "
+                   "embed precompiled cubins for alongside the PTX; requires "
+                   "ptxas"),
+    llvm::cl::CommaSeparated);
+
+static llvm::cl::opt<std::string> clPtxasPath(
+    "iree-hal-cuda-ptxas-path",
+    llvm::cl::desc("Path to the ptxas tool used to compile cubins; searched "
+                   "for on PATH if not specified"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<bool> clUseLibraryCalls(
+    "iree-hal-cuda-library-calls",
+    llvm::cl::desc("Dispatch matching operations (such as static f16/f32 "
+                   "matmuls) to vendor libraries like cuBLAS when available "
+                   "at runtime; kernels are still generated as a fallback"),
+    llvm::cl::init(false));
+
 namespace mlir {
 namespace iree_compiler {
 namespace IREE {
@@ -72,6 +97,68 @@ static std::string translateModuleToISA(llvm::Module &module,
   return targetISA;
 }
 
+/// Parses an `sm_XY` architecture name into its `XY` compute capability.
+static Optional<uint32_t> parseSmVersion(StringRef targetChip) {
+  uint32_t smVersion = 0;
+  if (!targetChip.consume_front("sm_") ||
+      targetChip.getAsInteger(10, smVersion)) {
+    return llvm::None;
+  }
+  return smVersion;
+}
+
+/// Compiles |ptx| to a cubin for |targetChip| by invoking ptxas.
+static FailureOr<std::string> compilePtxToCubin(Operation *op, StringRef ptx,
+                                                StringRef targetChip) {
+  std::string ptxasPath = clPtxasPath;
+  if (ptxasPath.empty()) {
+    auto foundPath = llvm::sys::findProgramByName("ptxas");
+    if (!foundPath) {
+      return op->emitError()
+             << "ptxas not found on PATH; specify it with "
+                "--iree-hal-cuda-ptxas-path to embed cubins";
+    }
+    ptxasPath = *foundPath;
+  }
+
+  llvm::SmallString<128> ptxPath;
+  llvm::SmallString<128> cubinPath;
+  if (llvm::sys::fs::createTemporaryFile("iree-cuda", "ptx", ptxPath) ||
+      llvm::sys::fs::createTemporaryFile("iree-cuda", "cubin", cubinPath)) {
+    return op->emitError() << "failed to create temporary files for ptxas";
+  }
+  llvm::FileRemover ptxRemover(ptxPath);
+  llvm::FileRemover cubinRemover(cubinPath);
+  {
+    std::error_code error;
+    llvm::raw_fd_ostream ptxStream(ptxPath, error);
+    if (error) {
+      return op->emitError() << "failed to write PTX to " << ptxPath << ": "
+                             << error.message();
+    }
+    ptxStream << ptx;
+  }
+
+  std::string archArg = ("-arch=" + targetChip).str();
+  llvm::StringRef args[] = {ptxasPath, archArg, "-o", cubinPath, ptxPath};
+  std::string errorMessage;
+  int exitCode =
+      llvm::sys::ExecuteAndWait(ptxasPath, args, /*Env=*/llvm::None,
+                                /*Redirects=*/{}, /*SecondsToWait=*/0,
+                                /*MemoryLimit=*/0, &errorMessage);
+  if (exitCode != 0) {
+    return op->emitError() << "ptxas failed compiling for " << targetChip
+                           << " (exit code " << exitCode
+                           << "): " << errorMessage;
+  }
+
+  auto cubinBuffer = llvm::MemoryBuffer::getFile(cubinPath);
+  if (!cubinBuffer) {
+    return op->emitError() << "failed to read ptxas output " << cubinPath;
+  }
+  return (*cubinBuffer)->getBuffer().str();
+}
+
 /// Return true if the moule contain any __nv function that require linking with
 /// libdevice module.
 static bool requiresDeviceLib(const llvm::Module &module) {
@@ -174,9 +261,24 @@ class CUDATargetBackend final : public TargetBackend {
   }
 
   void buildTranslationPassPipeline(OpPassManager &passManager) override {
+    // Library calls are matched before codegen rewrites the dispatch.
+    if (clUseLibraryCalls) {
+      passManager.addPass(createCUDAMatchLibraryCallsPass());
+    }
     buildLLVMGPUTransformPassPipeline(passManager, false);
   }
 
+  Optional<std::string> getSerializationCacheFingerprint() const override {
+    // Dumped PTX is a side-effect of serialization.
+    if (dumpPtx) return llvm::None;
+    std::string fingerprint;
+    llvm::raw_string_ostream os(fingerprint);
+    os << clTargetChip << ';' << (clDisableLoopNounrollWa ? 1 : 0) << ';'
+       << (clUseLibraryCalls ? 1 : 0) << ';' << clPtxasPath << ';';
+    for (const auto &chip : clCubinTargetChips) os << chip << ',';
+    return os.str();
+  }
+
   LogicalResult serializeExecutable(IREE::HAL::ExecutableVariantOp variantOp,
                                     OpBuilder &executableBuilder) override {
     // Perform the translation in a separate context to avoid any
@@ -213,6 +315,7 @@ class CUDATargetBackend final : public TargetBackend {
     }
     std::vector<std::array<int32_t, 3>> workgroupSizes;
     std::vector<std::string> entryPointNames;
+    SmallVector<DictionaryAttr> libraryCalls;
     for (auto func : innerModuleOp.getOps<LLVM::LLVMFuncOp>()) {
       auto *llvmFunc = llvmModule->getFunction(func.getName());
       if (llvmFunc->isDeclaration()) continue;
@@ -230,6 +333,8 @@ class CUDATargetBackend final : public TargetBackend {
         workgroup_size = {1, 1, 1};
       }
       workgroupSizes.push_back(workgroup_size);
+      libraryCalls.push_back(entryPointOp->getAttrOfType<DictionaryAttr>(
+          getCUDALibraryCallAttrName()));
       llvm::Metadata *llvmMetadata[] = {
           llvm::ValueAsMetadata::get(llvmFunc),
           llvm::MDString::get(llvmModule->getContext(), "kernel"),
@@ -272,9 +377,27 @@ class CUDATargetBackend final : public TargetBackend {
     if (dumpPtx) {
       llvm::dbgs() << targetISA;
     }
-    auto ptxCudeRef = flatbuffers_uint8_vec_create(
-        builder, reinterpret_cast<const uint8_t *>(targetISA.c_str()),
-        targetISA.size());
+    auto ptxCudeRef = builder.createString(targetISA);
+
+    // Optionally compile the PTX ahead of time for specific architectures so
+    // that the runtime can skip the driver JIT on matching devices.
+    SmallVector<iree_CUDACubinDef_ref_t> cubinRefs;
+    for (const std::string &cubinTargetChip : clCubinTargetChips) {
+      Optional<uint32_t> smVersion = parseSmVersion(cubinTargetChip);
+      if (!smVersion) {
+        return variantOp.emitError()
+               << "invalid cubin target arch '" << cubinTargetChip
+               << "'; expected sm_XY";
+      }
+      FailureOr<std::string> cubin =
+          compilePtxToCubin(variantOp, targetISA, cubinTargetChip);
+      if (failed(cubin)) return failure();
+      auto cubinImageRef = flatbuffers_uint8_vec_create(
+          builder, reinterpret_cast<const uint8_t *>(cubin->data()),
+          cubin->size());
+      cubinRefs.push_back(
+          iree_CUDACubinDef_create(builder, *smVersion, cubinImageRef));
+    }
 
     auto entryPointsRef = builder.createStringVec(entryPointNames);
 
@@ -287,9 +410,27 @@ class CUDATargetBackend final : public TargetBackend {
     }
     auto blockSizesRef = iree_CUDABlockSizeDef_vec_end(builder);
 
+    iree_CUDALibraryCallDef_vec_ref_t libraryCallsRef = 0;
+    if (llvm::any_of(libraryCalls, [](DictionaryAttr attr) { return attr; })) {
+      SmallVector<iree_CUDALibraryCallDef_ref_t> libraryCallRefs;
+      for (DictionaryAttr libraryCall : libraryCalls) {
+        libraryCallRefs.push_back(serializeLibraryCall(builder, libraryCall));
+      }
+      libraryCallsRef = iree_CUDALibraryCallDef_vec_create(
+          builder, libraryCallRefs.data(), libraryCallRefs.size());
+    }
+
     iree_CUDAExecutableDef_entry_points_add(builder, entryPointsRef);
     iree_CUDAExecutableDef_block_sizes_add(builder, blockSizesRef);
     iree_CUDAExecutableDef_ptx_image_add(builder, ptxCudeRef);
+    if (!cubinRefs.empty()) {
+      auto cubinsRef = iree_CUDACubinDef_vec_create(builder, cubinRefs.data(),
+                                                    cubinRefs.size());
+      iree_CUDAExecutableDef_cubin_images_add(builder, cubinsRef);
+    }
+    if (libraryCallsRef) {
+      iree_CUDAExecutableDef_library_calls_add(builder, libraryCallsRef);
+    }
     iree_CUDAExecutableDef_end_as_root(builder);
 
     // Add the binary data to the target executable.
@@ -304,6 +445,37 @@ class CUDATargetBackend final : public TargetBackend {
   }
 
  private:
+  // Serializes a library call annotation produced by
+  // createCUDAMatchLibraryCallsPass. Entry points without one get an empty
+  // entry so that the vector remains indexed by entry point ordinal.
+  static iree_CUDALibraryCallDef_ref_t serializeLibraryCall(
+      FlatbufferBuilder &builder, DictionaryAttr libraryCall) {
+    iree_CUDALibraryCallDef_start(builder);
+    if (libraryCall) {
+      auto getU32 = [&](StringRef name) {
+        return static_cast<uint32_t>(
+            libraryCall.getAs<IntegerAttr>(name).getInt());
+      };
+      iree_CUDALibraryCallDef_kind_add(builder,
+                                       iree_CUDALibraryCallKind_CUBLAS_GEMM);
+      iree_CUDALibraryCallDef_m_add(builder, getU32("m"));
+      iree_CUDALibraryCallDef_n_add(builder, getU32("n"));
+      iree_CUDALibraryCallDef_k_add(builder, getU32("k"));
+      iree_CUDALibraryCallDef_data_type_add(
+          builder, libraryCall.getAs<StringAttr>("data_type").getValue() ==
+                           "f16"
+                       ? iree_CUDALibraryDataType_F16
+                       : iree_CUDALibraryDataType_F32);
+      iree_CUDALibraryCallDef_accumulate_add(
+          builder, libraryCall.getAs<BoolAttr>("accumulate").getValue());
+      iree_CUDALibraryCallDef_lhs_binding_add(builder, getU32("lhs_binding"));
+      iree_CUDALibraryCallDef_rhs_binding_add(builder, getU32("rhs_binding"));
+      iree_CUDALibraryCallDef_result_binding_add(builder,
+                                                 getU32("result_binding"));
+    }
+    return iree_CUDALibraryCallDef_end(builder);
+  }
+
   ArrayAttr getExecutableTargets(MLIRContext *context) const {
     SmallVector<Attribute> targetAttrs;
     // If we had multiple target environments we would generate one target attr
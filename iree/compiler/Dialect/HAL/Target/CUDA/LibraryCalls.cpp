@@ -0,0 +1,221 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/HAL/Target/CUDA/LibraryCalls.h"
+
+#include <limits>
+
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+StringRef getCUDALibraryCallAttrName() { return "cuda.library_call"; }
+
+/// Returns the binding subspan `value` was loaded from in its entirety.
+static IREE::HAL::InterfaceBindingSubspanOp getWholeBindingLoad(Value value) {
+  auto loadOp = value.getDefiningOp<IREE::Flow::DispatchTensorLoadOp>();
+  if (!loadOp) return {};
+  auto sourceType =
+      loadOp.source().getType().dyn_cast<IREE::Flow::DispatchTensorType>();
+  auto resultType = loadOp.getType().dyn_cast<RankedTensorType>();
+  // A static load covering the full shape is in-bounds only with zero offsets
+  // and unit strides.
+  if (!sourceType || !resultType || !resultType.hasStaticShape() ||
+      sourceType.getShape() != resultType.getShape()) {
+    return {};
+  }
+  return loadOp.source().getDefiningOp<IREE::HAL::InterfaceBindingSubspanOp>();
+}
+
+/// Returns true if `subspanOp` starts at the beginning of its binding. Kernel
+/// arguments only hold the base address of bindings.
+static bool hasZeroByteOffset(IREE::HAL::InterfaceBindingSubspanOp subspanOp) {
+  return !subspanOp.byte_offset() ||
+         matchPattern(subspanOp.byte_offset(), m_Zero());
+}
+
+/// Returns the kernel argument ordinal of each binding used in `funcOp`.
+/// Matches the packing done by the LLVMGPU backend: bindings are sorted by set
+/// and binding ordinal and assigned dense argument ordinals.
+static DenseMap<std::pair<int64_t, int64_t>, int64_t> getKernelArgOrdinals(
+    FuncOp funcOp) {
+  SmallVector<std::pair<int64_t, int64_t>> bindings;
+  funcOp.walk([&](IREE::HAL::InterfaceBindingSubspanOp subspanOp) {
+    bindings.emplace_back(subspanOp.set().getSExtValue(),
+                          subspanOp.binding().getSExtValue());
+  });
+  llvm::sort(bindings);
+  bindings.erase(std::unique(bindings.begin(), bindings.end()),
+                 bindings.end());
+  DenseMap<std::pair<int64_t, int64_t>, int64_t> ordinals;
+  for (auto binding : llvm::enumerate(bindings)) {
+    ordinals[binding.value()] = binding.index();
+  }
+  return ordinals;
+}
+
+/// Matches a dispatch computing C = A * B or C += A * B with a single static
+/// f16 or f32 linalg.matmul over whole bindings and returns the cuBLAS GEMM
+/// performing it.
+static DictionaryAttr matchCublasGemm(FuncOp funcOp) {
+  linalg::MatmulOp matmulOp;
+  bool hasOtherComputation = false;
+  funcOp.walk([&](linalg::LinalgOp linalgOp) {
+    if (auto op = dyn_cast<linalg::MatmulOp>(linalgOp.getOperation())) {
+      if (matmulOp) hasOtherComputation = true;
+      matmulOp = op;
+    } else if (!isa<linalg::FillOp>(linalgOp.getOperation())) {
+      hasOtherComputation = true;
+    }
+  });
+  if (!matmulOp || hasOtherComputation || !matmulOp.hasTensorSemantics()) {
+    return {};
+  }
+
+  auto resultType = matmulOp.getResult(0).getType().cast<RankedTensorType>();
+  Type elementType = resultType.getElementType();
+  if (!elementType.isF16() && !elementType.isF32()) return {};
+  for (Value input : matmulOp.inputs()) {
+    if (input.getType().cast<RankedTensorType>().getElementType() !=
+        elementType) {
+      return {};
+    }
+  }
+
+  auto lhsOp = getWholeBindingLoad(matmulOp.inputs()[0]);
+  auto rhsOp = getWholeBindingLoad(matmulOp.inputs()[1]);
+  if (!lhsOp || !rhsOp) return {};
+
+  // The result must be stored to the whole output binding and nothing else.
+  if (!matmulOp.getResult(0).hasOneUse()) return {};
+  auto storeOp = dyn_cast<IREE::Flow::DispatchTensorStoreOp>(
+      *matmulOp.getResult(0).getUsers().begin());
+  if (!storeOp) return {};
+  auto targetType =
+      storeOp.target().getType().dyn_cast<IREE::Flow::DispatchTensorType>();
+  if (!targetType || !resultType.hasStaticShape() ||
+      targetType.getShape() != resultType.getShape()) {
+    return {};
+  }
+  auto resultOp =
+      storeOp.target().getDefiningOp<IREE::HAL::InterfaceBindingSubspanOp>();
+  if (!resultOp) return {};
+
+  // The output is either zero filled or the prior contents of the result.
+  bool accumulate = false;
+  Value outputInit = matmulOp.outputs()[0];
+  if (auto fillOp = outputInit.getDefiningOp<linalg::FillOp>()) {
+    FloatAttr fillValue;
+    if (!matchPattern(fillOp.value(), m_Constant(&fillValue)) ||
+        !fillValue.getValue().isZero()) {
+      return {};
+    }
+  } else if (auto initOp = getWholeBindingLoad(outputInit)) {
+    if (initOp.set() != resultOp.set() ||
+        initOp.binding() != resultOp.binding()) {
+      return {};
+    }
+    accumulate = true;
+  } else {
+    return {};
+  }
+
+  for (auto subspanOp : {lhsOp, rhsOp, resultOp}) {
+    if (!hasZeroByteOffset(subspanOp)) return {};
+  }
+  // The library reads and writes memory outside of the view of the kernel so
+  // aliasing operands are not supported.
+  auto getSetBinding = [](IREE::HAL::InterfaceBindingSubspanOp subspanOp) {
+    return std::make_pair(subspanOp.set().getSExtValue(),
+                          subspanOp.binding().getSExtValue());
+  };
+  auto lhsBinding = getSetBinding(lhsOp);
+  auto rhsBinding = getSetBinding(rhsOp);
+  auto resultBinding = getSetBinding(resultOp);
+  if (resultBinding == lhsBinding || resultBinding == rhsBinding) return {};
+
+  auto ordinals = getKernelArgOrdinals(funcOp);
+  ArrayRef<int64_t> lhsShape =
+      matmulOp.inputs()[0].getType().cast<RankedTensorType>().getShape();
+  int64_t m = resultType.getDimSize(0);
+  int64_t n = resultType.getDimSize(1);
+  int64_t k = lhsShape[1];
+  const int64_t kMaxDimSize = std::numeric_limits<int32_t>::max();
+  if (m > kMaxDimSize || n > kMaxDimSize || k > kMaxDimSize) return {};
+
+  Builder builder(funcOp.getContext());
+  SmallVector<NamedAttribute> items = {
+      builder.getNamedAttr("kind", builder.getStringAttr("cublas_gemm")),
+      builder.getNamedAttr("m", builder.getI64IntegerAttr(m)),
+      builder.getNamedAttr("n", builder.getI64IntegerAttr(n)),
+      builder.getNamedAttr("k", builder.getI64IntegerAttr(k)),
+      builder.getNamedAttr(
+          "data_type",
+          builder.getStringAttr(elementType.isF16() ? "f16" : "f32")),
+      builder.getNamedAttr("accumulate", builder.getBoolAttr(accumulate)),
+      builder.getNamedAttr("lhs_binding",
+                           builder.getI64IntegerAttr(ordinals[lhsBinding])),
+      builder.getNamedAttr("rhs_binding",
+                           builder.getI64IntegerAttr(ordinals[rhsBinding])),
+      builder.getNamedAttr("result_binding",
+                           builder.getI64IntegerAttr(ordinals[resultBinding])),
+  };
+  return builder.getDictionaryAttr(items);
+}
+
+namespace {
+
+class CUDAMatchLibraryCallsPass
+    : public PassWrapper<CUDAMatchLibraryCallsPass,
+                         OperationPass<IREE::HAL::ExecutableVariantOp>> {
+ public:
+  StringRef getArgument() const override {
+    return "iree-cuda-match-library-calls";
+  }
+
+  StringRef getDescription() const override {
+    return "Annotates entry points that can be dispatched as vendor library "
+           "calls";
+  }
+
+  void runOnOperation() override {
+    IREE::HAL::ExecutableVariantOp variantOp = getOperation();
+    ModuleOp innerModuleOp = variantOp.getInnerModule();
+    if (!innerModuleOp) return;
+    for (auto entryPointOp :
+         variantOp.getOps<IREE::HAL::ExecutableEntryPointOp>()) {
+      auto funcOp = innerModuleOp.lookupSymbol<FuncOp>(entryPointOp.sym_name());
+      if (!funcOp || funcOp.isExternal()) continue;
+      if (DictionaryAttr libraryCall = matchCublasGemm(funcOp)) {
+        entryPointOp->setAttr(getCUDALibraryCallAttrName(), libraryCall);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
+createCUDAMatchLibraryCallsPass() {
+  return std::make_unique<CUDAMatchLibraryCallsPass>();
+}
+
+static PassRegistration<CUDAMatchLibraryCallsPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,42 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_HAL_TARGET_CUDA_LIBRARYCALLS_H_
+#define IREE_COMPILER_DIALECT_HAL_TARGET_CUDA_LIBRARYCALLS_H_
+
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+/// Name of the dictionary attribute on hal.executable.entry_point ops
+/// describing the vendor library call that may perform dispatches of the entry
+/// point instead of its kernel.
+///
+/// Keys:
+///   kind: "cublas_gemm"
+///   m, n, k: static problem size
+///   data_type: "f16" or "f32"
+///   accumulate: whether the result is accumulated into the output
+///   lhs_binding, rhs_binding, result_binding: kernel argument ordinals
+StringRef getCUDALibraryCallAttrName();
+
+/// Creates a pass annotating entry points whose dispatch computes exactly one
+/// vendor library routine over whole bindings with the library call to use.
+/// Entry points are still compiled to kernels as the runtime falls back to them
+/// when the library is unavailable.
+std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
+createCUDAMatchLibraryCallsPass();
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_DIALECT_HAL_TARGET_CUDA_LIBRARYCALLS_H_
@@ -0,0 +1,120 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='hal.executable(hal.executable.variant(iree-cuda-match-library-calls))' %s | FileCheck %s
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable @matmul_fill {
+  hal.executable.variant @cuda, target = <"cuda", "cuda-nvptx-fb"> {
+    hal.executable.entry_point @matmul_fill layout(#executable_layout)
+    builtin.module {
+      func @matmul_fill() {
+        %c0 = arith.constant 0 : index
+        %cst = arith.constant 0.000000e+00 : f16
+        %0 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) offset(%c0) : !flow.dispatch.tensor<readonly:128x256xf16>
+        %1 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) offset(%c0) : !flow.dispatch.tensor<readonly:256x512xf16>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) offset(%c0) : !flow.dispatch.tensor<writeonly:128x512xf16>
+        %3 = flow.dispatch.tensor.load %0, offsets = [0, 0], sizes = [128, 256], strides = [1, 1] : !flow.dispatch.tensor<readonly:128x256xf16> -> tensor<128x256xf16>
+        %4 = flow.dispatch.tensor.load %1, offsets = [0, 0], sizes = [256, 512], strides = [1, 1] : !flow.dispatch.tensor<readonly:256x512xf16> -> tensor<256x512xf16>
+        %5 = linalg.init_tensor [128, 512] : tensor<128x512xf16>
+        %6 = linalg.fill(%cst, %5) : f16, tensor<128x512xf16> -> tensor<128x512xf16>
+        %7 = linalg.matmul ins(%3, %4 : tensor<128x256xf16>, tensor<256x512xf16>) outs(%6 : tensor<128x512xf16>) -> tensor<128x512xf16>
+        flow.dispatch.tensor.store %7, %2, offsets = [0, 0], sizes = [128, 512], strides = [1, 1] : tensor<128x512xf16> -> !flow.dispatch.tensor<writeonly:128x512xf16>
+        return
+      }
+    }
+  }
+}
+
+// CHECK-LABEL: hal.executable public @matmul_fill
+//       CHECK:   hal.executable.entry_point public @matmul_fill
+//  CHECK-SAME:     cuda.library_call = {
+//  CHECK-SAME:       accumulate = false
+//  CHECK-SAME:       data_type = "f16"
+//  CHECK-SAME:       k = 256 : i64
+//  CHECK-SAME:       kind = "cublas_gemm"
+//  CHECK-SAME:       lhs_binding = 1 : i64
+//  CHECK-SAME:       m = 128 : i64
+//  CHECK-SAME:       n = 512 : i64
+//  CHECK-SAME:       result_binding = 2 : i64
+//  CHECK-SAME:       rhs_binding = 0 : i64
+
+// -----
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable @matmul_accumulate {
+  hal.executable.variant @cuda, target = <"cuda", "cuda-nvptx-fb"> {
+    hal.executable.entry_point @matmul_accumulate layout(#executable_layout)
+    builtin.module {
+      func @matmul_accumulate() {
+        %c0 = arith.constant 0 : index
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) offset(%c0) : !flow.dispatch.tensor<readonly:64x32xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) offset(%c0) : !flow.dispatch.tensor<readonly:32x16xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) offset(%c0) : !flow.dispatch.tensor<readwrite:64x16xf32>
+        %3 = flow.dispatch.tensor.load %0, offsets = [0, 0], sizes = [64, 32], strides = [1, 1] : !flow.dispatch.tensor<readonly:64x32xf32> -> tensor<64x32xf32>
+        %4 = flow.dispatch.tensor.load %1, offsets = [0, 0], sizes = [32, 16], strides = [1, 1] : !flow.dispatch.tensor<readonly:32x16xf32> -> tensor<32x16xf32>
+        %5 = flow.dispatch.tensor.load %2, offsets = [0, 0], sizes = [64, 16], strides = [1, 1] : !flow.dispatch.tensor<readwrite:64x16xf32> -> tensor<64x16xf32>
+        %6 = linalg.matmul ins(%3, %4 : tensor<64x32xf32>, tensor<32x16xf32>) outs(%5 : tensor<64x16xf32>) -> tensor<64x16xf32>
+        flow.dispatch.tensor.store %6, %2, offsets = [0, 0], sizes = [64, 16], strides = [1, 1] : tensor<64x16xf32> -> !flow.dispatch.tensor<readwrite:64x16xf32>
+        return
+      }
+    }
+  }
+}
+
+// CHECK-LABEL: hal.executable public @matmul_accumulate
+//       CHECK:   hal.executable.entry_point public @matmul_accumulate
+//  CHECK-SAME:     cuda.library_call = {
+//  CHECK-SAME:       accumulate = true
+//  CHECK-SAME:       data_type = "f32"
+
+// -----
+
+// Matmuls fused with other computation are left to codegen.
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable @matmul_bias {
+  hal.executable.variant @cuda, target = <"cuda", "cuda-nvptx-fb"> {
+    hal.executable.entry_point @matmul_bias layout(#executable_layout)
+    builtin.module {
+      func @matmul_bias() {
+        %c0 = arith.constant 0 : index
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) offset(%c0) : !flow.dispatch.tensor<readonly:64x32xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) offset(%c0) : !flow.dispatch.tensor<readonly:32x16xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) offset(%c0) : !flow.dispatch.tensor<writeonly:64x16xf32>
+        %3 = flow.dispatch.tensor.load %0, offsets = [0, 0], sizes = [64, 32], strides = [1, 1] : !flow.dispatch.tensor<readonly:64x32xf32> -> tensor<64x32xf32>
+        %4 = flow.dispatch.tensor.load %1, offsets = [0, 0], sizes = [32, 16], strides = [1, 1] : !flow.dispatch.tensor<readonly:32x16xf32> -> tensor<32x16xf32>
+        %5 = linalg.init_tensor [64, 16] : tensor<64x16xf32>
+        %6 = linalg.fill(%cst, %5) : f32, tensor<64x16xf32> -> tensor<64x16xf32>
+        %7 = linalg.matmul ins(%3, %4 : tensor<64x32xf32>, tensor<32x16xf32>) outs(%6 : tensor<64x16xf32>) -> tensor<64x16xf32>
+        %8 = linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0, d1)>], iterator_types = ["parallel", "parallel"]} ins(%7 : tensor<64x16xf32>) outs(%5 : tensor<64x16xf32>) {
+        ^bb0(%arg0: f32, %arg1: f32):
+          %9 = arith.addf %arg0, %arg0 : f32
+          linalg.yield %9 : f32
+        } -> tensor<64x16xf32>
+        flow.dispatch.tensor.store %8, %2, offsets = [0, 0], sizes = [64, 16], strides = [1, 1] : tensor<64x16xf32> -> !flow.dispatch.tensor<writeonly:64x16xf32>
+        return
+      }
+    }
+  }
+}
+
+// CHECK-LABEL: hal.executable public @matmul_bias
+//       CHECK:   hal.executable.entry_point public @matmul_bias
+//   CHECK-NOT:     cuda.library_call
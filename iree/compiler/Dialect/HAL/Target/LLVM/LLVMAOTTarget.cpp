@@ -6,7 +6,9 @@
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LLVMAOTTarget.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <map>
 
 #include "iree/compiler/Codegen/Dialect/IREECodegenDialect.h"
 #include "iree/compiler/Codegen/Passes.h"
@@ -17,13 +19,23 @@
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LinkerTool.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/StaticLibraryGenerator.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Linker/Linker.h"
+#include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MemoryBufferRef.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "mlir/Dialect/ArmNeon/ArmNeonDialect.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
@@ -39,6 +51,166 @@ namespace HAL {
 static constexpr char kQueryFunctionName[] =
     "iree_hal_executable_library_query";
 
+// Trip count assumed for each loop when statically estimating the cost of a
+// workgroup. Most of our tiled loops have small constant trip counts and the
+// estimate only needs to separate cheap dispatches from expensive ones.
+static constexpr int64_t kAssumedLoopTripCount = 16;
+
+// Upper bound on the weight applied to instructions in deeply nested loops to
+// keep the estimate from overflowing.
+static constexpr int64_t kMaxInstructionWeight = 1ll << 40;
+
+// Returns the number of bytes loaded or stored by |inst| or 0 if it does not
+// access memory directly.
+static int64_t getMemoryAccessSize(const llvm::Instruction &inst) {
+  llvm::Type *type = nullptr;
+  if (auto *loadInst = llvm::dyn_cast<llvm::LoadInst>(&inst)) {
+    type = loadInst->getType();
+  } else if (auto *storeInst = llvm::dyn_cast<llvm::StoreInst>(&inst)) {
+    type = storeInst->getValueOperand()->getType();
+  } else {
+    return 0;
+  }
+  // Pointers report a size of 0; they are small and rare in our dispatches.
+  return std::max<int64_t>(type->getPrimitiveSizeInBits().getKnownMinSize() / 8,
+                           1);
+}
+
+// Returns the number of arithmetic operations (vector lanes included)
+// performed by |inst|.
+static int64_t getArithmeticOpCount(const llvm::Instruction &inst) {
+  bool isArithmetic = inst.isBinaryOp() || inst.isUnaryOp();
+  if (auto *intrinsicInst = llvm::dyn_cast<llvm::IntrinsicInst>(&inst)) {
+    switch (intrinsicInst->getIntrinsicID()) {
+      case llvm::Intrinsic::fma:
+      case llvm::Intrinsic::fmuladd:
+        isArithmetic = true;
+        break;
+      default:
+        break;
+    }
+  }
+  if (!isArithmetic) return 0;
+  if (auto *vectorType =
+          llvm::dyn_cast<llvm::FixedVectorType>(inst.getType())) {
+    return vectorType->getNumElements();
+  }
+  return 1;
+}
+
+// Populates the scheduling hints in |attrs| with a rough static estimate of the
+// work performed by a single workgroup invocation of |func|. Instructions are
+// weighted by their loop depth and the ratio of arithmetic to bytes accessed
+// decides whether the dispatch is likely to be memory or compute bound.
+static void estimateDispatchAttrs(llvm::Function &func,
+                                  LibraryBuilder::DispatchAttrs &attrs) {
+  llvm::DominatorTree domTree(func);
+  llvm::LoopInfo loopInfo(domTree);
+  int64_t totalOpCount = 0;
+  int64_t arithmeticOpCount = 0;
+  int64_t memoryByteCount = 0;
+  for (auto &block : func) {
+    int64_t weight = 1;
+    for (unsigned i = 0; i < loopInfo.getLoopDepth(&block) &&
+                         weight < kMaxInstructionWeight;
+         ++i) {
+      weight *= kAssumedLoopTripCount;
+    }
+    for (auto &inst : block) {
+      totalOpCount += weight;
+      arithmeticOpCount += weight * getArithmeticOpCount(inst);
+      memoryByteCount += weight * getMemoryAccessSize(inst);
+    }
+  }
+  attrs.workgroupCost = totalOpCount;
+
+  // Roughly matches the balance point of current CPUs: well under one
+  // operation per byte moved will be waiting on memory while several per byte
+  // will be waiting on the ALUs.
+  if (memoryByteCount > 0 && arithmeticOpCount * 2 < memoryByteCount) {
+    attrs.workloadClass = LibraryBuilder::WorkloadClass::MEMORY_BOUND;
+  } else if (arithmeticOpCount > memoryByteCount * 4) {
+    attrs.workloadClass = LibraryBuilder::WorkloadClass::COMPUTE_BOUND;
+  }
+}
+
+// Returns the library features required by code generated by
+// |targetMachine|. The runtime will refuse to load libraries requiring features
+// the host lacks. Features are mapped conservatively: using any part of an
+// extension group requires the entire group the runtime checks for.
+static LibraryBuilder::Features getRequiredLibraryFeatures(
+    const llvm::TargetMachine &targetMachine) {
+  const llvm::MCSubtargetInfo *subtargetInfo =
+      targetMachine.getMCSubtargetInfo();
+  uint32_t features = static_cast<uint32_t>(LibraryBuilder::Features::NONE);
+  auto addFeatureIfAny = [&](LibraryBuilder::Features feature,
+                             ArrayRef<StringRef> llvmFeatures) {
+    for (auto llvmFeature : llvmFeatures) {
+      if (subtargetInfo->checkFeatures(llvmFeature)) {
+        features |= static_cast<uint32_t>(feature);
+        return;
+      }
+    }
+  };
+  switch (targetMachine.getTargetTriple().getArch()) {
+    case llvm::Triple::ArchType::x86_64:
+      addFeatureIfAny(LibraryBuilder::Features::X86_64_SSE4_2,
+                      {"+ssse3", "+sse4.1", "+sse4.2", "+popcnt"});
+      addFeatureIfAny(LibraryBuilder::Features::X86_64_AVX2_FMA,
+                      {"+avx", "+avx2", "+fma"});
+      addFeatureIfAny(LibraryBuilder::Features::X86_64_AVX512, {"+avx512f"});
+      break;
+    case llvm::Triple::ArchType::aarch64:
+      addFeatureIfAny(LibraryBuilder::Features::ARM_64_DOTPROD, {"+dotprod"});
+      addFeatureIfAny(LibraryBuilder::Features::ARM_64_I8MM, {"+i8mm"});
+      addFeatureIfAny(LibraryBuilder::Features::ARM_64_SVE, {"+sve"});
+      break;
+    default:
+      break;
+  }
+  return static_cast<LibraryBuilder::Features>(features);
+}
+
+// Returns an LLVM feature string (`+a,+b,...`) listing every feature enabled
+// in |targetMachine|, including those implied by its CPU.
+static std::string getEnabledFeatureString(
+    const llvm::TargetMachine &targetMachine) {
+  const llvm::MCSubtargetInfo *subtargetInfo =
+      targetMachine.getMCSubtargetInfo();
+  SmallVector<std::string> enabledFeatures;
+  for (auto &featureKV : subtargetInfo->getAllProcessorFeatures()) {
+    std::string feature = std::string("+") + featureKV.Key;
+    if (subtargetInfo->checkFeatures(feature)) {
+      enabledFeatures.push_back(std::move(feature));
+    }
+  }
+  return llvm::join(enabledFeatures, ",");
+}
+
+// Returns the `hal.device.feature` names of each bit set in |features|.
+// These must match the names used by the runtime in
+// iree/hal/local/executable_environment.c.
+static SmallVector<std::string> getDeviceFeatureNames(
+    LibraryBuilder::Features features) {
+  static const std::pair<LibraryBuilder::Features, const char *>
+      kFeatureNames[] = {
+          {LibraryBuilder::Features::X86_64_SSE4_2, "x86_64.sse4_2"},
+          {LibraryBuilder::Features::X86_64_AVX2_FMA, "x86_64.avx2_fma"},
+          {LibraryBuilder::Features::X86_64_AVX512, "x86_64.avx512"},
+          {LibraryBuilder::Features::ARM_64_DOTPROD, "arm_64.dotprod"},
+          {LibraryBuilder::Features::ARM_64_I8MM, "arm_64.i8mm"},
+          {LibraryBuilder::Features::ARM_64_SVE, "arm_64.sve"},
+      };
+  SmallVector<std::string> names;
+  for (auto &featureName : kFeatureNames) {
+    if (static_cast<uint32_t>(features) &
+        static_cast<uint32_t>(featureName.first)) {
+      names.push_back(featureName.second);
+    }
+  }
+  return names;
+}
+
 static llvm::Optional<FileLineColLoc> findFirstFileLoc(Location baseLoc) {
   if (auto loc = baseLoc.dyn_cast<FusedLoc>()) {
     for (auto &childLoc : loc.getLocations()) {
@@ -63,6 +235,54 @@ static std::string guessModuleName(mlir::ModuleOp moduleOp) {
   }
 }
 
+// Folds private constant globals that only differ in name into one. Each
+// source executable carries its own copies of the constants it uses and once
+// linked into a single library they would otherwise all end up in its rodata.
+static void deduplicateConstantGlobals(mlir::ModuleOp moduleOp) {
+  DenseMap<DictionaryAttr, LLVM::GlobalOp> canonicalOps;
+  for (auto globalOp :
+       llvm::make_early_inc_range(moduleOp.getOps<LLVM::GlobalOp>())) {
+    if (!globalOp.constant() || !globalOp.isPrivate() ||
+        globalOp.getInitializerBlock()) {
+      continue;
+    }
+    NamedAttrList attrs(globalOp->getAttrDictionary());
+    attrs.erase(SymbolTable::getSymbolAttrName());
+    auto it = canonicalOps.try_emplace(
+        attrs.getDictionary(moduleOp.getContext()), globalOp);
+    if (it.second) continue;
+    if (failed(SymbolTable::replaceAllSymbolUses(
+            globalOp, it.first->second.sym_nameAttr(), moduleOp))) {
+      continue;
+    }
+    globalOp.erase();
+  }
+}
+
+// Assigns ordinals to the executable imports referenced by the placeholder
+// globals emitted when converting to LLVM (tagged with `hal.import.name`) and
+// returns the import names in ordinal order. Imports are sorted by name as the
+// runtime requires of the library import table.
+static SmallVector<std::string> assignImportOrdinals(mlir::ModuleOp moduleOp) {
+  std::map<std::string, SmallVector<LLVM::GlobalOp>> globalOps;
+  for (auto globalOp : moduleOp.getOps<LLVM::GlobalOp>()) {
+    auto nameAttr = globalOp->getAttrOfType<StringAttr>("hal.import.name");
+    if (!nameAttr) continue;
+    globalOps[nameAttr.getValue().str()].push_back(globalOp);
+  }
+  SmallVector<std::string> importNames;
+  auto i32Type = IntegerType::get(moduleOp.getContext(), 32);
+  for (auto &it : globalOps) {
+    auto ordinalAttr = IntegerAttr::get(i32Type, importNames.size());
+    for (auto globalOp : it.second) {
+      globalOp.valueAttr(ordinalAttr);
+      globalOp->removeAttr("hal.import.name");
+    }
+    importNames.push_back(it.first);
+  }
+  return importNames;
+}
+
 // Appends the |debugDatabase| to the end of |baseFile| and writes the footer
 // so the runtime can find it.
 static LogicalResult appendDebugDatabase(std::vector<int8_t> &baseFile,
@@ -131,6 +351,60 @@ static LogicalResult linkBuiltinLibrary(
   return success();
 }
 
+// Compiles |llvmModule| into one object file per partition of the module.
+// Partitions are compiled concurrently and each is round-tripped through
+// bitcode into its own LLVMContext as neither contexts nor target machines are
+// thread-safe. |objectDatas| receives the object files in partition order such
+// that the output is deterministic for a given |partitionCount|.
+static LogicalResult emitPartitionedObjectFiles(
+    Location loc, const LLVMTargetOptions &options, llvm::Module &llvmModule,
+    unsigned partitionCount, SmallVectorImpl<std::string> &objectDatas) {
+  // Splitting externalizes (as hidden) any internal symbols referenced across
+  // partitions so that the partitions can be linked back together.
+  SmallVector<SmallString<0>> partitionBitcodes;
+  llvm::SplitModule(llvmModule, partitionCount,
+                    [&](std::unique_ptr<llvm::Module> partitionModule) {
+                      SmallString<0> bitcode;
+                      llvm::raw_svector_ostream os(bitcode);
+                      llvm::WriteBitcodeToFile(*partitionModule, os);
+                      partitionBitcodes.push_back(std::move(bitcode));
+                    });
+
+  objectDatas.resize(partitionBitcodes.size());
+  SmallVector<std::string> errorMessages(partitionBitcodes.size());
+  llvm::ThreadPool threadPool(
+      llvm::hardware_concurrency(partitionBitcodes.size()));
+  for (size_t i = 0; i < partitionBitcodes.size(); ++i) {
+    threadPool.async([&, i]() {
+      llvm::LLVMContext context;
+      auto partitionModule = llvm::parseBitcodeFile(
+          llvm::MemoryBufferRef(partitionBitcodes[i], "partition"), context);
+      if (!partitionModule) {
+        errorMessages[i] = llvm::toString(partitionModule.takeError());
+        return;
+      }
+      auto targetMachine = createTargetMachine(options);
+      if (!targetMachine) {
+        errorMessages[i] = "failed to create target machine";
+        return;
+      }
+      if (failed(runEmitObjFilePasses(
+              targetMachine.get(), partitionModule->get(),
+              llvm::CGFT_ObjectFile, &objectDatas[i]))) {
+        errorMessages[i] = "failed to compile LLVM-IR to an object file";
+      }
+    });
+  }
+  threadPool.wait();
+
+  for (size_t i = 0; i < errorMessages.size(); ++i) {
+    if (errorMessages[i].empty()) continue;
+    return mlir::emitError(loc) << "code generation of module partition " << i
+                                << " failed: " << errorMessages[i];
+  }
+  return success();
+}
+
 class LLVMAOTTargetBackend final : public TargetBackend {
  public:
   explicit LLVMAOTTargetBackend(LLVMTargetOptions options)
@@ -173,9 +447,6 @@ class LLVMAOTTargetBackend final : public TargetBackend {
         llvm::to_vector<8>(moduleOp.getOps<IREE::HAL::ExecutableOp>());
     if (sourceExecutableOps.size() <= 1) return success();
 
-    // TODO(benvanik): rework linking to support multiple formats.
-    auto sharedTargetAttr = getExecutableTarget(builder.getContext());
-
     // Guess a module name, if needed, to make the output files readable.
     auto moduleName = guessModuleName(moduleOp);
 
@@ -187,18 +458,78 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     linkedExecutableOp.setVisibility(
         sourceExecutableOps.front().getVisibility());
 
-    // Add our hal.executable.variant with an empty module.
-    builder.setInsertionPointToStart(linkedExecutableOp.getBody());
-    auto linkedTargetOp = builder.create<IREE::HAL::ExecutableVariantOp>(
-        moduleOp.getLoc(), sharedTargetAttr.getSymbolNameFragment(),
-        sharedTargetAttr);
-    builder.setInsertionPoint(&linkedTargetOp.getBlock().back());
-    builder.create<ModuleOp>(moduleOp.getLoc());
-
-    // Try linking together all executables in moduleOp.
-    return linkExecutablesInto(
-        moduleOp, sourceExecutableOps, linkedExecutableOp, linkedTargetOp,
-        [](mlir::ModuleOp moduleOp) { return moduleOp; }, builder);
+    // Add a hal.executable.variant with an empty module for each target we
+    // produce. Specialized variants come first and the baseline last.
+    auto targetAttrs = getExecutableTargets(builder.getContext());
+    SmallVector<IREE::HAL::ExecutableVariantOp> linkedTargetOps;
+    for (auto targetAttr :
+         targetAttrs.getAsRange<IREE::HAL::ExecutableTargetAttr>()) {
+      builder.setInsertionPoint(&linkedExecutableOp.getBlock().back());
+      auto linkedTargetOp = builder.create<IREE::HAL::ExecutableVariantOp>(
+          moduleOp.getLoc(), targetAttr.getSymbolNameFragment(), targetAttr);
+      builder.setInsertionPoint(&linkedTargetOp.getBlock().back());
+      builder.create<ModuleOp>(moduleOp.getLoc());
+      linkedTargetOps.push_back(linkedTargetOp);
+    }
+
+    // Try linking together all executables in moduleOp. Specialized variants
+    // only take source variants produced for the same target while the
+    // baseline takes the rest (including any with custom configurations).
+    for (auto linkedTargetOp : linkedTargetOps) {
+      bool isBaseline = linkedTargetOp == linkedTargetOps.back();
+      auto symbolNameFragment = linkedTargetOp.target().getSymbolNameFragment();
+      // Source executables are erased as their last variant is linked so we
+      // need to gather the remaining ones for each target.
+      SmallVector<IREE::HAL::ExecutableOp> remainingExecutableOps;
+      for (auto executableOp : moduleOp.getOps<IREE::HAL::ExecutableOp>()) {
+        if (executableOp != linkedExecutableOp) {
+          remainingExecutableOps.push_back(executableOp);
+        }
+      }
+      auto filterFn = [&](IREE::HAL::ExecutableVariantOp variantOp) {
+        return isBaseline ||
+               variantOp.target().getSymbolNameFragment() == symbolNameFragment;
+      };
+      if (failed(linkExecutablesInto(
+              moduleOp, remainingExecutableOps, linkedExecutableOp,
+              linkedTargetOp, [](mlir::ModuleOp moduleOp) { return moduleOp; },
+              builder, filterFn))) {
+        return failure();
+      }
+    }
+
+    // Constants used by multiple source executables only need to be emitted
+    // once in the linked library.
+    if (auto executableOp = moduleOp.lookupSymbol<IREE::HAL::ExecutableOp>(
+            linkedExecutableName)) {
+      for (auto variantOp :
+           executableOp.getOps<IREE::HAL::ExecutableVariantOp>()) {
+        deduplicateConstantGlobals(variantOp.getInnerModule());
+      }
+    }
+    return success();
+  }
+
+  Optional<std::string> getSerializationCacheFingerprint() const override {
+    // Static libraries and preserved linker artifacts are written to disk as a
+    // side-effect of serialization and are not reproduced by cached binaries.
+    if (options_.linkStatic || options_.keepLinkerArtifacts) return llvm::None;
+    std::string fingerprint;
+    llvm::raw_string_ostream os(fingerprint);
+    os << options_.targetTriple << ';' << options_.targetCPU << ';'
+       << options_.targetCPUFeatures << ';';
+    const auto &tuningOptions = options_.pipelineTuningOptions;
+    os << tuningOptions.LoopInterleaving << tuningOptions.LoopVectorization
+       << tuningOptions.LoopUnrolling << tuningOptions.SLPVectorization << ';';
+    os << options_.optLevel.getSpeedupLevel()
+       << options_.optLevel.getSizeLevel() << ';';
+    os << options_.options.MCOptions.ABIName << ';'
+       << static_cast<int>(options_.options.FloatABIType) << ';';
+    os << options_.debugSymbols << static_cast<int>(options_.sanitizerKind)
+       << options_.flushDenormals << options_.linkEmbedded << ';'
+       << options_.linkerPath << ';' << options_.embeddedLinkerPath << ';'
+       << options_.codegenPartitions;
+    return os.str();
   }
 
   LogicalResult serializeExecutable(IREE::HAL::ExecutableVariantOp variantOp,
@@ -214,6 +545,17 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     auto libraryName =
         variantOp->getParentOfType<IREE::HAL::ExecutableOp>().getName().str();
 
+    // Each variant may be specialized for a different CPU and set of features.
+    LLVMTargetOptions options = options_;
+    if (auto configAttr = variantOp.target().getConfiguration()) {
+      if (auto cpuAttr = configAttr.getAs<StringAttr>("cpu")) {
+        options.targetCPU = cpuAttr.getValue().str();
+      }
+      if (auto cpuFeaturesAttr = configAttr.getAs<StringAttr>("cpu_features")) {
+        options.targetCPUFeatures = cpuFeaturesAttr.getValue().str();
+      }
+    }
+
     // Validate flags for output mode.
     if (options_.linkEmbedded && options_.linkStatic) {
       return variantOp.emitError()
@@ -228,6 +570,18 @@ class LLVMAOTTargetBackend final : public TargetBackend {
         LLVM::LLVMDialect::getTargetTripleAttrName(),
         executableBuilder.getStringAttr(targetTriple.str()));
 
+    // Create the target machine early as its final set of features determines
+    // the features the library requires at runtime.
+    auto targetMachine = createTargetMachine(options);
+    if (!targetMachine) {
+      return mlir::emitError(variantOp.getLoc())
+             << "failed to create target machine for target triple '"
+             << options_.targetTriple << "'";
+    }
+
+    // Resolve the import ordinals now that all executables have been linked.
+    auto importNames = assignImportOrdinals(variantOp.getInnerModule());
+
     // At this moment we are leaving MLIR LLVM dialect land translating module
     // into target independent LLVMIR.
     auto llvmModule = mlir::translateModuleToLLVMIR(variantOp.getInnerModule(),
@@ -253,6 +607,12 @@ class LLVMAOTTargetBackend final : public TargetBackend {
       // Our dispatches are all hot - that's kind of the point.
       // This may favor more aggressive optimizations.
       func.addFnAttr("hot");
+
+      // The runtime flushes denormals to zero while executing dispatches
+      // unless the library asks it not to.
+      if (options_.flushDenormals) {
+        func.addFnAttr("denormal-fp-math", "preserve-sign,preserve-sign");
+      }
     }
 
     // Build the IREE HAL executable library metadata. The runtime uses this to
@@ -274,6 +634,11 @@ class LLVMAOTTargetBackend final : public TargetBackend {
         }
       } break;
     }
+    libraryBuilder.addRequiredFeature(
+        getRequiredLibraryFeatures(*targetMachine));
+    for (auto &importName : importNames) {
+      libraryBuilder.addImport(importName, /*weak=*/false);
+    }
     for (auto entryPointOp :
          variantOp.getBlock().getOps<ExecutableEntryPointOp>()) {
       // Find the matching function in the LLVM module.
@@ -288,8 +653,12 @@ class LLVMAOTTargetBackend final : public TargetBackend {
                                     .getValueOr(APInt(64, 0))
                                     .getSExtValue();
 
-      libraryBuilder.addExport(entryPointOp.getName(), "",
-                               LibraryBuilder::DispatchAttrs{localMemorySize},
+      LibraryBuilder::DispatchAttrs dispatchAttrs;
+      dispatchAttrs.localMemorySize = localMemorySize;
+      dispatchAttrs.preserveDenormals = !options_.flushDenormals;
+      estimateDispatchAttrs(*llvmFunc, dispatchAttrs);
+
+      libraryBuilder.addExport(entryPointOp.getName(), "", dispatchAttrs,
                                llvmFunc);
     }
 
@@ -313,7 +682,7 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     std::unique_ptr<LinkerTool> linkerTool;
     if (!options_.linkStatic) {
       // Grab a linker tool based on the options (and target environment).
-      linkerTool = LinkerTool::getForTarget(targetTriple, options_);
+      linkerTool = LinkerTool::getForTarget(targetTriple, options);
       if (!linkerTool) {
         return mlir::emitError(variantOp.getLoc())
                << "failed to find a target linker for the given target triple '"
@@ -330,12 +699,6 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     }
 
     // Specialize the module to our target machine.
-    auto targetMachine = createTargetMachine(options_);
-    if (!targetMachine) {
-      return mlir::emitError(variantOp.getLoc())
-             << "failed to create target machine for target triple '"
-             << options_.targetTriple << "'";
-    }
     llvmModule->setDataLayout(targetMachine->createDataLayout());
     llvmModule->setTargetTriple(targetMachine->getTargetTriple().str());
 
@@ -370,7 +733,7 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     // LLVM opt passes that perform code generation optimizations/transformation
     // similar to what a frontend would do.
     if (failed(
-            runLLVMIRPasses(options_, targetMachine.get(), llvmModule.get()))) {
+            runLLVMIRPasses(options, targetMachine.get(), llvmModule.get()))) {
       return variantOp.emitError()
              << "failed to run LLVM-IR opt passes for IREE::HAL::ExecutableOp "
                 "targeting '"
@@ -400,26 +763,38 @@ class LLVMAOTTargetBackend final : public TargetBackend {
 
     SmallVector<Artifact> objectFiles;
 
-    // Emit the base object file containing the bulk of our code.
-    // This must come first such that we have the proper library linking order.
+    // Emit the base object files containing the bulk of our code.
+    // These must come first such that we have the proper library linking
+    // order. Large modules can be split into partitions to scale code
+    // generation across threads; static libraries only support one object
+    // file per library and always use a single partition.
     {
-      // NOTE: today we just use a single object file, however if we wanted to
-      // scale code generation and linking we'd want to generate one per
-      // function (or something like that). A single object file is also
-      // instrumental to static library generation (which only supports one
-      // object file per library).
-      std::string objectData;
-      if (failed(runEmitObjFilePasses(targetMachine.get(), llvmModule.get(),
-                                      llvm::CGFT_ObjectFile, &objectData))) {
-        return variantOp.emitError()
-               << "failed to compile LLVM-IR module to an object file";
+      SmallVector<std::string> objectDatas;
+      unsigned partitionCount =
+          options_.linkStatic ? 1 : std::max(options_.codegenPartitions, 1u);
+      if (partitionCount > 1) {
+        if (failed(emitPartitionedObjectFiles(variantOp.getLoc(), options,
+                                              *llvmModule, partitionCount,
+                                              objectDatas))) {
+          return failure();
+        }
+      } else {
+        std::string objectData;
+        if (failed(runEmitObjFilePasses(targetMachine.get(), llvmModule.get(),
+                                        llvm::CGFT_ObjectFile, &objectData))) {
+          return variantOp.emitError()
+                 << "failed to compile LLVM-IR module to an object file";
+        }
+        objectDatas.push_back(std::move(objectData));
+      }
+      for (auto &objectData : objectDatas) {
+        auto objectFile = Artifact::createTemporary(libraryName, "o");
+        auto &os = objectFile.outputFile->os();
+        os << objectData;
+        os.flush();
+        os.close();
+        objectFiles.push_back(std::move(objectFile));
       }
-      auto objectFile = Artifact::createTemporary(libraryName, "o");
-      auto &os = objectFile.outputFile->os();
-      os << objectData;
-      os.flush();
-      os.close();
-      objectFiles.push_back(std::move(objectFile));
     }
 
     // If we are keeping artifacts then let's also add the bitcode and
@@ -583,15 +958,35 @@ class LLVMAOTTargetBackend final : public TargetBackend {
   }
 
  private:
+  // Configuration of one executable target produced by this backend.
+  struct TargetConfiguration {
+    // LLVM target machine CPU the target is compiled for. Empty for the
+    // baseline target which uses the CPU from the options.
+    std::string cpu;
+    // LLVM target machine CPU features the target is compiled with.
+    std::string cpuFeatures;
+    // Library features required by code compiled with cpuFeatures.
+    LibraryBuilder::Features requiredFeatures = LibraryBuilder::Features::NONE;
+    // Device features to query at runtime when selecting the target. Empty
+    // for the baseline target that is used when no specialized target matches.
+    SmallVector<std::string> deviceFeatures;
+    std::string dataLayoutStr;
+    int64_t vectorSize = 0;
+  };
+
   ArrayAttr getExecutableTargets(MLIRContext *context) const {
     SmallVector<Attribute> targetAttrs;
-    // This is where we would multiversion.
-    targetAttrs.push_back(getExecutableTarget(context));
+    // Specialized variants come first so that they are preferred when the
+    // device supports their features; the baseline is the fallback.
+    for (auto &variantConfig : variantConfigs_) {
+      targetAttrs.push_back(getExecutableTarget(context, variantConfig));
+    }
+    targetAttrs.push_back(getExecutableTarget(context, baseConfig_));
     return ArrayAttr::get(context, targetAttrs);
   }
 
   IREE::HAL::ExecutableTargetAttr getExecutableTarget(
-      MLIRContext *context) const {
+      MLIRContext *context, const TargetConfiguration &targetConfig) const {
     std::string format;
     if (options_.linkStatic) {
       // Static libraries are just string references when serialized so we don't
@@ -665,16 +1060,30 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     addConfig("target_triple", StringAttr::get(context, options_.targetTriple));
 
     // Set data layout
-    addConfig("data_layout", StringAttr::get(context, config_.dataLayoutStr));
+    addConfig("data_layout",
+              StringAttr::get(context, targetConfig.dataLayoutStr));
 
     // Set the native vector size. This creates a dummy llvm module just to
     // build the TTI the right way.
     addConfig("native_vector_size",
-              IntegerAttr::get(IndexType::get(context), config_.vectorSize));
+              IntegerAttr::get(IndexType::get(context),
+                               targetConfig.vectorSize));
 
-    // Set target CPU features.
+    // Set target CPU and features.
+    if (!targetConfig.cpu.empty()) {
+      addConfig("cpu", StringAttr::get(context, targetConfig.cpu));
+    }
     addConfig("cpu_features",
-              StringAttr::get(context, options_.targetCPUFeatures));
+              StringAttr::get(context, targetConfig.cpuFeatures));
+
+    // Set the device features required to select this target, if any.
+    if (!targetConfig.deviceFeatures.empty()) {
+      SmallVector<Attribute> featureAttrs;
+      for (auto &feature : targetConfig.deviceFeatures) {
+        featureAttrs.push_back(StringAttr::get(context, feature));
+      }
+      addConfig("device_features", ArrayAttr::get(context, featureAttrs));
+    }
 
     return IREE::HAL::ExecutableTargetAttr::get(
         context, StringAttr::get(context, "llvm"),
@@ -682,11 +1091,54 @@ class LLVMAOTTargetBackend final : public TargetBackend {
   }
 
   void initConfiguration() {
-    auto targetMachine = createTargetMachine(options_);
+    baseConfig_ = buildConfiguration(/*cpu=*/"", options_.targetCPUFeatures);
+
+    // Static libraries are emitted as a single object file and header and
+    // only support the baseline target.
+    if (options_.linkStatic) return;
+    for (auto &variant : options_.targetCPUVariants) {
+      auto variantConfig = buildConfiguration(variant.cpu, variant.cpuFeatures);
+      // Only features not already required by the baseline need to be queried
+      // as the baseline can't run on a device that lacks them anyway.
+      variantConfig.deviceFeatures = getDeviceFeatureNames(
+          static_cast<LibraryBuilder::Features>(
+              static_cast<uint32_t>(variantConfig.requiredFeatures) &
+              ~static_cast<uint32_t>(baseConfig_.requiredFeatures)));
+      // Variants that can't be distinguished at runtime would never be
+      // selected over the ones before them (or the baseline).
+      if (variantConfig.deviceFeatures.empty()) continue;
+      if (llvm::any_of(variantConfigs_, [&](const TargetConfiguration &other) {
+            return other.deviceFeatures == variantConfig.deviceFeatures;
+          })) {
+        continue;
+      }
+      variantConfigs_.push_back(std::move(variantConfig));
+    }
+  }
+
+  // Builds the configuration of a target compiled for |cpu| (or the baseline
+  // CPU if empty) with the given |cpuFeatures|.
+  TargetConfiguration buildConfiguration(StringRef cpu,
+                                         StringRef cpuFeatures) const {
+    TargetConfiguration targetConfig;
+    targetConfig.cpu = cpu.str();
+    targetConfig.cpuFeatures = cpuFeatures.str();
+
+    LLVMTargetOptions options = options_;
+    if (!cpu.empty()) options.targetCPU = targetConfig.cpu;
+    options.targetCPUFeatures = targetConfig.cpuFeatures;
+    auto targetMachine = createTargetMachine(options);
+    targetConfig.requiredFeatures = getRequiredLibraryFeatures(*targetMachine);
+
+    // Codegen only sees the features so those implied by a specialized CPU
+    // are listed explicitly.
+    if (!cpu.empty()) {
+      targetConfig.cpuFeatures = getEnabledFeatureString(*targetMachine);
+    }
 
     // Data layout
     llvm::DataLayout DL = targetMachine->createDataLayout();
-    config_.dataLayoutStr = DL.getStringRepresentation();
+    targetConfig.dataLayoutStr = DL.getStringRepresentation();
 
     // Set the native vector size. This creates a dummy llvm module just to
     // build the TTI the right way.
@@ -700,28 +1152,30 @@ class LLVMAOTTargetBackend final : public TargetBackend {
         llvm::GlobalValue::ExternalLinkage, "dummy_func", *llvmModule);
     llvm::TargetTransformInfo tti =
         targetMachine->getTargetTransformInfo(*dummyFunc);
-    config_.vectorSize = tti.getRegisterBitWidth(
-                             llvm::TargetTransformInfo::RGK_FixedWidthVector) /
-                         8;
+    targetConfig.vectorSize =
+        tti.getRegisterBitWidth(
+            llvm::TargetTransformInfo::RGK_FixedWidthVector) /
+        8;
     LLVM_DEBUG({
       llvm::dbgs() << "CPU : " << targetMachine->getTargetCPU() << "\n";
       llvm::dbgs() << "Target Triple : "
                    << targetMachine->getTargetTriple().normalize() << "\n";
       llvm::dbgs() << "Target Feature string : "
                    << targetMachine->getTargetFeatureString() << "\n";
-      llvm::dbgs() << "Data Layout : " << config_.dataLayoutStr << "\n";
-      llvm::dbgs() << "Vector Width : " << config_.vectorSize << "\n";
+      llvm::dbgs() << "Data Layout : " << targetConfig.dataLayoutStr << "\n";
+      llvm::dbgs() << "Vector Width : " << targetConfig.vectorSize << "\n";
     });
+    return targetConfig;
   }
 
   LLVMTargetOptions options_;
 
   // Additional target information besides that is contained in
   // LLVMTargetOptions options_.
-  struct AdditionalConfigurationValues {
-    std::string dataLayoutStr;
-    int64_t vectorSize;
-  } config_;
+  TargetConfiguration baseConfig_;
+
+  // Targets specialized for other CPUs/features in order of preference.
+  SmallVector<TargetConfiguration> variantConfigs_;
 };
 
 void registerLLVMAOTTargetBackends(
@@ -76,6 +76,15 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::desc("LLVM target machine CPU features; use 'host' for your "
                      "host native CPU"),
       llvm::cl::init(""));
+  static llvm::cl::list<std::string> clTargetCPUVariants(
+      "iree-llvm-target-cpu-variant",
+      llvm::cl::desc(
+          "Additional LLVM target machine CPU to produce specialized "
+          "executable variants for as `cpu`, `cpu:features` or `:features` "
+          "(such as `x86-64-v4` or `:+avx2,+fma`); may be specified multiple "
+          "times with the most specialized first. Each is chosen at runtime "
+          "only if the host supports it"),
+      llvm::cl::ZeroOrMore);
 
   static llvm::cl::opt<bool> llvmLoopInterleaving(
       "iree-llvm-loop-interleaving", llvm::cl::init(false),
@@ -97,6 +106,14 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
   if (clTargetCPUFeatures != "host") {
     targetOptions.targetCPUFeatures = clTargetCPUFeatures;
   }
+  targetOptions.targetCPUVariants.clear();
+  for (llvm::StringRef variantStr : clTargetCPUVariants) {
+    auto variantParts = variantStr.split(':');
+    LLVMTargetOptions::TargetCPUVariant variant;
+    variant.cpu = variantParts.first.trim().str();
+    variant.cpuFeatures = variantParts.second.trim().str();
+    targetOptions.targetCPUVariants.push_back(std::move(variant));
+  }
 
   // LLVM opt options.
   targetOptions.pipelineTuningOptions.LoopInterleaving = llvmLoopInterleaving;
@@ -111,6 +128,14 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
                                   "Address sanitizer support")));
   targetOptions.sanitizerKind = clSanitizerKind;
 
+  static llvm::cl::opt<bool> clFlushDenormals(
+      "iree-llvm-flush-denormals",
+      llvm::cl::desc("Executes dispatches with denormal floating-point values "
+                     "flushed to zero; disable for models that depend on "
+                     "denormals"),
+      llvm::cl::init(targetOptions.flushDenormals));
+  targetOptions.flushDenormals = clFlushDenormals;
+
   static llvm::cl::opt<std::string> clTargetABI(
       "iree-llvm-target-abi",
       llvm::cl::desc("LLVM target machine ABI; specify for -mabi"),
@@ -157,6 +182,14 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::init(targetOptions.linkEmbedded));
   targetOptions.linkEmbedded = clLinkEmbedded;
 
+  static llvm::cl::opt<bool> clEmbeddedIdentityLayout(
+      "iree-llvm-embedded-linker-identity-layout",
+      llvm::cl::desc("Lays out embedded ELF segments in the file as they are "
+                     "in memory so they can be executed in place when mapped "
+                     "(for -iree-llvm-link-embedded=true)."),
+      llvm::cl::init(targetOptions.embeddedIdentityLayout));
+  targetOptions.embeddedIdentityLayout = clEmbeddedIdentityLayout;
+
   static llvm::cl::opt<bool> clLinkStatic(
       "iree-llvm-link-static",
       llvm::cl::desc(
@@ -171,6 +204,14 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::init(targetOptions.keepLinkerArtifacts));
   targetOptions.keepLinkerArtifacts = clKeepLinkerArtifacts;
 
+  static llvm::cl::opt<unsigned> clCodegenPartitions(
+      "iree-llvm-codegen-partitions",
+      llvm::cl::desc("Splits the LLVM module of each executable into the "
+                     "given number of partitions that are compiled to object "
+                     "files concurrently"),
+      llvm::cl::init(targetOptions.codegenPartitions));
+  targetOptions.codegenPartitions = clCodegenPartitions;
+
   static llvm::cl::opt<std::string> clStaticLibraryOutputPath(
       "iree-llvm-static-library-output-path",
       llvm::cl::desc(
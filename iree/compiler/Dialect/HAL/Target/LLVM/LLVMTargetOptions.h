@@ -7,6 +7,9 @@
 #ifndef IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMTARGETOPTIONS_H_
 #define IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMTARGETOPTIONS_H_
 
+#include <string>
+#include <vector>
+
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Target/TargetOptions.h"
 
@@ -28,6 +31,23 @@ struct LLVMTargetOptions {
   std::string targetCPU;
   std::string targetCPUFeatures;
 
+  // A CPU configuration to produce a specialized executable variant for.
+  struct TargetCPUVariant {
+    // LLVM target machine CPU (such as `x86-64-v3` or `cortex-a76`). If empty
+    // the baseline targetCPU is used.
+    std::string cpu;
+    // LLVM target machine CPU features in the same format as
+    // targetCPUFeatures. Features implied by |cpu| need not be listed.
+    std::string cpuFeatures;
+  };
+
+  // Additional CPU configurations to produce specialized executable variants
+  // for. Each variant is only selected at runtime if the host supports the
+  // processor features it requires and otherwise execution falls back to the
+  // baseline targetCPU/targetCPUFeatures variant. Listed in order of
+  // preference: most specialized first.
+  std::vector<TargetCPUVariant> targetCPUVariants;
+
   llvm::PipelineTuningOptions pipelineTuningOptions;
   llvm::OptimizationLevel optLevel;
   llvm::TargetOptions options;
@@ -41,6 +61,12 @@ struct LLVMTargetOptions {
   // Sanitizer Kind for CPU Kernels
   SanitizerKind sanitizerKind = SanitizerKind::kNone;
 
+  // Execute dispatches with denormal floating-point values flushed to zero.
+  // Denormal arithmetic is slow on many processors and few models depend on
+  // it. When disabled the runtime is told to preserve denormals while
+  // executing the dispatches of the library.
+  bool flushDenormals = true;
+
   // Tool to use for linking (like lld). Acts as a prefix to the command line
   // and can contain additional arguments.
   std::string linkerPath;
@@ -51,6 +77,11 @@ struct LLVMTargetOptions {
   // Build for the IREE embedded platform-agnostic ELF loader.
   bool linkEmbedded = true;
 
+  // Lay out embedded ELF segments in the file as they are in memory so that
+  // the runtime can execute them in place from a mapped file instead of
+  // copying them. Pads each segment to the page size in the file.
+  bool embeddedIdentityLayout = false;
+
   // Link any required runtime libraries into the produced binaries statically.
   // This increases resulting binary size but enables the binaries to be used on
   // any machine without requiring matching system libraries to be installed.
@@ -59,6 +90,13 @@ struct LLVMTargetOptions {
   // True to keep linker artifacts for debugging.
   bool keepLinkerArtifacts = false;
 
+  // Number of partitions the LLVM module of each executable is split into for
+  // code generation. Partitions are compiled concurrently into separate object
+  // files that are linked together in partition order so the output is
+  // deterministic for a given partition count. Only applies when producing
+  // dynamic libraries as static libraries require a single object file.
+  unsigned codegenPartitions = 1;
+
   // Build for IREE static library loading using this output path for
   // a "{staticLibraryOutput}.o" object file and "{staticLibraryOutput}.h"
   // header file.
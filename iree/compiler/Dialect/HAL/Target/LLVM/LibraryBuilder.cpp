@@ -6,7 +6,10 @@
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LibraryBuilder.h"
 
+#include <algorithm>
+
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/MathExtras.h"
 
 // =============================================================================
 //
@@ -28,6 +31,32 @@ static inline int64_t RoundUpToAlignment(int64_t value, int64_t alignment) {
   return (value + (alignment - 1)) & ~(alignment - 1);
 }
 
+// IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_PRESERVE_DENORMALS
+static const uint8_t kPreserveDenormalsFlag = 1u << 2;
+
+// IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_TILE_GROUPING_SHIFT
+static const unsigned kTileGroupingShift = 4;
+
+// Returns floor(log2(|value|)) clamped to |maxValue| or 0 if |value| <= 1.
+static uint8_t encodeLog2(int64_t value, unsigned maxValue) {
+  if (value <= 1) return 0;
+  return static_cast<uint8_t>(
+      std::min(llvm::Log2_64(static_cast<uint64_t>(value)), maxValue));
+}
+
+// Packs the workload class, FPU requirements and tile grouping of |attrs| into
+// an iree_hal_executable_dispatch_flags_v0_t.
+static uint8_t encodeDispatchFlags(const LibraryBuilder::DispatchAttrs &attrs) {
+  uint8_t flags = static_cast<uint8_t>(attrs.workloadClass);
+  if (attrs.preserveDenormals) flags |= kPreserveDenormalsFlag;
+  if (attrs.tileGrouping > 0) {
+    // Stored as log2(grouping) + 1 so that 0 can indicate no preference.
+    uint8_t grouping = encodeLog2(attrs.tileGrouping, 14) + 1;
+    flags |= grouping << kTileGroupingShift;
+  }
+  return flags;
+}
+
 //===----------------------------------------------------------------------===//
 // iree/hal/local/executable_library.h structure types
 //===----------------------------------------------------------------------===//
@@ -111,19 +140,22 @@ static llvm::FunctionType *makeDispatchFunctionType(
 
 // %struct.iree_hal_executable_dispatch_attrs_v0_t = type {
 //   i16,
-//   i16
+//   i8,
+//   i8
 // }
 static llvm::StructType *makeDispatchAttrsType(llvm::LLVMContext &context) {
   if (auto *existingType = llvm::StructType::getTypeByName(
           context, "iree_hal_executable_dispatch_attrs_v0_t")) {
     return existingType;
   }
+  auto *i8Type = llvm::IntegerType::getInt8Ty(context);
   auto *i16Type = llvm::IntegerType::getInt16Ty(context);
   auto *type =
       llvm::StructType::create(context,
                                {
                                    i16Type,
-                                   i16Type,
+                                   i8Type,
+                                   i8Type,
                                },
                                "iree_hal_executable_dispatch_attrs_v0_t",
                                /*isPacked=*/false);
@@ -345,7 +377,7 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
       llvm::find_if(exports, [](const Dispatch &dispatch) {
         return !dispatch.attrs.isDefault();
       }) != exports.end();
-  if (!hasNonDefaultAttrs) {
+  if (hasNonDefaultAttrs) {
     SmallVector<llvm::Constant *, 4> exportAttrValues;
     for (auto dispatch : exports) {
       exportAttrValues.push_back(llvm::ConstantStruct::get(
@@ -356,8 +388,12 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
                   i16Type, RoundUpToAlignment(dispatch.attrs.localMemorySize,
                                               kWorkgroupLocalMemoryPageSize) /
                                kWorkgroupLocalMemoryPageSize),
-              // reserved=
-              llvm::ConstantInt::get(i16Type, 0),
+              // workgroup_cost_log2=
+              llvm::ConstantInt::get(
+                  i8Type, encodeLog2(dispatch.attrs.workgroupCost, 255)),
+              // flags=
+              llvm::ConstantInt::get(i8Type,
+                                     encodeDispatchFlags(dispatch.attrs)),
           }));
     }
     auto *exportAttrsType =
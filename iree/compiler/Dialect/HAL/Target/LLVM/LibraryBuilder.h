@@ -52,6 +52,18 @@ class LibraryBuilder {
   enum class Features : uint32_t {
     // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE
     NONE = 0u,
+    // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_AVX2_FMA
+    X86_64_AVX2_FMA = 1u << 0,
+    // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_AVX512
+    X86_64_AVX512 = 1u << 1,
+    // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_SSE4_2
+    X86_64_SSE4_2 = 1u << 2,
+    // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_DOTPROD
+    ARM_64_DOTPROD = 1u << 8,
+    // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_I8MM
+    ARM_64_I8MM = 1u << 9,
+    // IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_SVE
+    ARM_64_SVE = 1u << 10,
   };
 
   // iree_hal_executable_library_sanitizer_kind_t
@@ -71,13 +83,37 @@ class LibraryBuilder {
   // IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE
   static const int64_t kWorkgroupLocalMemoryPageSize = 4096;
 
+  // iree_hal_executable_dispatch_flag_bits_v0_t
+  enum class WorkloadClass : uint8_t {
+    UNKNOWN = 0u,
+    // IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_MEMORY_BOUND
+    MEMORY_BOUND = 1u << 0,
+    // IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_COMPUTE_BOUND
+    COMPUTE_BOUND = 1u << 1,
+  };
+
   // iree_hal_executable_dispatch_attrs_v0_t
   struct DispatchAttrs {
     // Required workgroup local memory size, in bytes.
     int64_t localMemorySize = 0;
+    // Estimated number of operations performed by each workgroup or 0 if
+    // unknown.
+    int64_t workgroupCost = 0;
+    // Preferred number of workgroups to schedule together or 0 if the
+    // dispatch has no preference. Rounded down to a power of two.
+    int64_t tileGrouping = 0;
+    // Whether workgroups are expected to be bound by memory or compute.
+    WorkloadClass workloadClass = WorkloadClass::UNKNOWN;
+    // Whether workgroups must execute with denormals preserved instead of
+    // flushed to zero.
+    // IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_PRESERVE_DENORMALS
+    bool preserveDenormals = false;
 
     // True if all values are default and the attributes may be omitted.
-    constexpr bool isDefault() const { return localMemorySize == 0; }
+    constexpr bool isDefault() const {
+      return localMemorySize == 0 && workgroupCost == 0 && tileGrouping == 0 &&
+             workloadClass == WorkloadClass::UNKNOWN && !preserveDenormals;
+    }
   };
 
   LibraryBuilder(llvm::Module *module, Mode mode,
@@ -156,6 +156,12 @@ class EmbeddedLinkerTool : public LinkerTool {
     // runtime loader).
     flags.push_back("--hash-style=sysv");
 
+    // Place each segment at a file offset equal to its virtual address so
+    // that the runtime loader can use a mapped file directly.
+    if (targetOptions.embeddedIdentityLayout) {
+      flags.push_back("-z separate-loadable-segments");
+    }
+
     // Strip debug information (only, no relocations) when not requested.
     if (!targetOptions.debugSymbols) {
       flags.push_back("--strip-debug");
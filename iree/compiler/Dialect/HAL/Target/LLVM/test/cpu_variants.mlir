@@ -0,0 +1,11 @@
+// RUN: iree-opt -pass-pipeline='iree-hal-assign-target-devices{targets=dylib-llvm-aot}' -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf -iree-llvm-target-cpu=generic -iree-llvm-target-cpu-variant=x86-64-v4 -iree-llvm-target-cpu-variant=x86-64-v3 -iree-llvm-target-cpu-variant=x86-64-v2 %s | FileCheck %s
+
+// Specialized variants require the device features they use beyond the
+// baseline and are listed most specialized first with the baseline last.
+
+// CHECK-DAG: #[[V4:.+]] = #hal.executable.target<"llvm", "embedded-elf-x86_64", {cpu = "x86-64-v4", {{.+}}, device_features = ["x86_64.sse4_2", "x86_64.avx2_fma", "x86_64.avx512"]
+// CHECK-DAG: #[[V3:.+]] = #hal.executable.target<"llvm", "embedded-elf-x86_64", {cpu = "x86-64-v3", {{.+}}, device_features = ["x86_64.sse4_2", "x86_64.avx2_fma"]
+// CHECK-DAG: #[[V2:.+]] = #hal.executable.target<"llvm", "embedded-elf-x86_64", {cpu = "x86-64-v2", {{.+}}, device_features = ["x86_64.sse4_2"]
+// CHECK-DAG: #[[BASE:.+]] = #hal.executable.target<"llvm", "embedded-elf-x86_64", {cpu_features = ""
+// CHECK: #hal.device.target<"cpu", {executable_targets = [#[[V4]], #[[V3]], #[[V2]], #[[BASE]]]}>
+module @module {}
@@ -0,0 +1,53 @@
+// RUN: iree-opt -iree-hal-link-target-executables='target=llvm' -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf %s | FileCheck %s
+
+#executable_target_embedded_elf_x86_64_ = #hal.executable.target<"llvm", "embedded-elf-x86_64">
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+
+hal.executable private @dispatch_0 {
+  hal.executable.variant @embedded_elf_x86_64, target = #executable_target_embedded_elf_x86_64_ {
+    hal.executable.entry_point @dispatch_0 ordinal(0) layout(#executable_layout)
+    builtin.module {
+      llvm.mlir.global private constant @__constant_4xf32(dense<[1.0, 2.0, 3.0, 4.0]> : tensor<4xf32>) : !llvm.array<4 x f32>
+      llvm.func @dispatch_0() -> !llvm.ptr<array<4 x f32>> {
+        %0 = llvm.mlir.addressof @__constant_4xf32 : !llvm.ptr<array<4 x f32>>
+        llvm.return %0 : !llvm.ptr<array<4 x f32>>
+      }
+    }
+  }
+}
+hal.executable private @dispatch_1 {
+  hal.executable.variant @embedded_elf_x86_64, target = #executable_target_embedded_elf_x86_64_ {
+    hal.executable.entry_point @dispatch_1 ordinal(0) layout(#executable_layout)
+    builtin.module {
+      llvm.mlir.global private constant @__constant_4xf32_0(dense<[1.0, 2.0, 3.0, 4.0]> : tensor<4xf32>) : !llvm.array<4 x f32>
+      llvm.mlir.global private constant @__constant_4xf32_1(dense<[5.0, 6.0, 7.0, 8.0]> : tensor<4xf32>) : !llvm.array<4 x f32>
+      llvm.func @dispatch_1() -> !llvm.ptr<array<4 x f32>> {
+        %0 = llvm.mlir.addressof @__constant_4xf32_0 : !llvm.ptr<array<4 x f32>>
+        %1 = llvm.mlir.addressof @__constant_4xf32_1 : !llvm.ptr<array<4 x f32>>
+        llvm.return %0 : !llvm.ptr<array<4 x f32>>
+      }
+    }
+  }
+}
+
+// Both executables are linked into one library and the constant they share
+// is only emitted once.
+
+// CHECK-NOT: hal.executable private @dispatch_0
+// CHECK-NOT: hal.executable private @dispatch_1
+//     CHECK: hal.executable private @linking_linked_llvm
+//     CHECK:   hal.executable.entry_point public @dispatch_0 ordinal(0)
+//     CHECK:   hal.executable.entry_point public @dispatch_1 ordinal(1)
+//     CHECK:   builtin.module
+//     CHECK:     llvm.mlir.global private constant @[[CONST:__constant_4xf32]](dense<[1.000000e+00, 2.000000e+00, 3.000000e+00, 4.000000e+00]>
+//     CHECK:     llvm.func @dispatch_0
+//     CHECK:       llvm.mlir.addressof @[[CONST]]
+// CHECK-NOT:     llvm.mlir.global private constant @__constant_4xf32_0
+//     CHECK:     llvm.mlir.global private constant @[[OTHER:__constant_4xf32_1]](dense<[5.000000e+00
+//     CHECK:     llvm.func @dispatch_1
+//     CHECK:       llvm.mlir.addressof @[[CONST]]
+//     CHECK:       llvm.mlir.addressof @[[OTHER]]
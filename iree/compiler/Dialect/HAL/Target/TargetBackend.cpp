@@ -29,6 +29,24 @@ void TargetOptions::bindOptions(OptionsBinder &binder) {
       "iree-hal-target-backends", targets,
       llvm::cl::desc("Target backends for executable compilation"),
       llvm::cl::ZeroOrMore, llvm::cl::cat(halTargetOptionsCategory));
+
+  binder.opt<std::string>(
+      "iree-hal-executable-cache-dir", executableCacheDirectory,
+      llvm::cl::desc("Directory used to cache serialized executable binaries "
+                     "across compilations"),
+      llvm::cl::cat(halTargetOptionsCategory));
+
+  binder.opt<bool>(
+      "iree-hal-lazy-executable-creation", lazyExecutableCreation,
+      llvm::cl::desc("Creates executables on first use instead of during "
+                     "module initialization"),
+      llvm::cl::cat(halTargetOptionsCategory));
+
+  binder.opt<bool>(
+      "iree-hal-cache-static-command-buffers", cacheStaticCommandBuffers,
+      llvm::cl::desc("Records command buffers that only use constant values "
+                     "once during module initialization and reuses them"),
+      llvm::cl::cat(halTargetOptionsCategory));
 }
 
 // Renames |op| within |moduleOp| with a new name that is unique within both
@@ -157,7 +175,8 @@ LogicalResult TargetBackend::linkExecutablesInto(
     IREE::HAL::ExecutableOp linkedExecutableOp,
     IREE::HAL::ExecutableVariantOp linkedTargetOp,
     std::function<Operation *(mlir::ModuleOp moduleOp)> getInnerModuleFn,
-    OpBuilder &builder) {
+    OpBuilder &builder,
+    std::function<bool(IREE::HAL::ExecutableVariantOp variantOp)> filterFn) {
   int nextEntryPointOrdinal = 0;
   DenseMap<StringRef, Operation *> targetSymbolMap;
   DenseMap<Attribute, Attribute> entryPointRefReplacements;
@@ -172,6 +191,7 @@ LogicalResult TargetBackend::linkExecutablesInto(
     for (auto variantOp : variantOps) {
       // Only process targets matching our pattern.
       if (variantOp.target().getBackend().getValue() != name()) continue;
+      if (filterFn && !filterFn(variantOp)) continue;
 
       // Clone entry point ops and queue remapping ordinals and updating
       // symbol refs.
@@ -213,10 +233,13 @@ LogicalResult TargetBackend::linkExecutablesInto(
   // Update references to @executable::@target::@entry symbols.
   replaceEntryPointUses(moduleOp, entryPointRefReplacements);
 
-  // Remove if we didn't add anything.
+  // Remove if we didn't add anything. The linked executable may still contain
+  // other variants linked independently by the caller.
   if (linkedTargetOp.getOps<IREE::HAL::ExecutableEntryPointOp>().empty()) {
     linkedTargetOp.erase();
-    linkedExecutableOp.erase();
+    if (linkedExecutableOp.getOps<IREE::HAL::ExecutableVariantOp>().empty()) {
+      linkedExecutableOp.erase();
+    }
   }
 
   return success();
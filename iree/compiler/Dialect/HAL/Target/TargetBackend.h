@@ -30,6 +30,27 @@ struct TargetOptions {
   // TODO(benvanik): multiple targets of the same type, etc.
   std::vector<std::string> targets;
 
+  // Directory used to cache serialized executable binaries across
+  // compilations. Binaries are keyed by the contents of the executable variant
+  // and the backend options such that only executables that changed since a
+  // previous compilation are serialized again. Empty to disable caching.
+  //
+  // NOTE: cache entries do not track the compiler version and the directory
+  // must be cleared when switching compilers.
+  std::string executableCacheDirectory;
+
+  // Creates executables on first use instead of during module
+  // initialization. This reduces the time to first call of modules with many
+  // executables at the cost of a check on each executable lookup.
+  bool lazyExecutableCreation = false;
+
+  // Records command buffers that only reference values available at
+  // initialization time (constants and immutable globals) once during module
+  // initialization and resubmits them on each invocation. This removes the
+  // per-call recording overhead at the cost of retaining the command buffers
+  // and the resources they reference for the lifetime of the module.
+  bool cacheStaticCommandBuffers = false;
+
   // TODO(benvanik): flags for debug/optimization/etc.
   // The intent is that we can have a global debug/-ON flag that then each
   // target backend can have tickle it's own flags in the right way. Right now
@@ -207,16 +228,32 @@ class TargetBackend {
     return failure();
   }
 
+  // Returns a fingerprint of all backend options that influence the output of
+  // serializeExecutable beyond the contents of the executable variant (such as
+  // optimization levels or linker configuration). Serialized binaries are only
+  // cached across compilations for backends that return a fingerprint and the
+  // default of None disables caching. Backends with serialization side-effects
+  // (such as writing files intended for debugging) must return None while
+  // those are enabled.
+  virtual Optional<std::string> getSerializationCacheFingerprint() const {
+    return llvm::None;
+  }
+
  protected:
   // Links all executables for the current target found in |moduleOp| into
   // |linkedExecutableOp|. Functions will be cloned into |linkedModuleOp|.
+  // If provided |filterFn| further restricts which variants of the current
+  // target are linked into |linkedTargetOp|, allowing backends that produce
+  // multiple variants to link each of them independently.
   LogicalResult linkExecutablesInto(
       mlir::ModuleOp moduleOp,
       ArrayRef<IREE::HAL::ExecutableOp> sourceExecutableOps,
       IREE::HAL::ExecutableOp linkedExecutableOp,
       IREE::HAL::ExecutableVariantOp linkedTargetOp,
       std::function<Operation *(mlir::ModuleOp moduleOp)> getInnerModuleFn,
-      OpBuilder &builder);
+      OpBuilder &builder,
+      std::function<bool(IREE::HAL::ExecutableVariantOp variantOp)> filterFn =
+          nullptr);
 };
 
 }  // namespace HAL
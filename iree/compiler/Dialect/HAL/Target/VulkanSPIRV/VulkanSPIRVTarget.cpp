@@ -8,6 +8,7 @@
 
 #include "iree/compiler/Codegen/Dialect/IREECodegenDialect.h"
 #include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Codegen/SPIRV/Utils.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Dialect/Vulkan/IR/VulkanAttributes.h"
 #include "iree/compiler/Dialect/Vulkan/IR/VulkanDialect.h"
@@ -84,10 +85,30 @@ VulkanSPIRVTargetOptions getVulkanSPIRVTargetOptionsFromFlags() {
       llvm::cl::desc("Save SPIR-V shader modules to disk separately"),
       llvm::cl::init(false));
 
+  static llvm::cl::opt<bool> clVulkanBufferDeviceAddress(
+      "iree-vulkan-buffer-device-address",
+      llvm::cl::desc(
+          "Access bindings through buffer device addresses passed as push "
+          "constants instead of descriptor sets; requires the target "
+          "environment to include the PhysicalStorageBufferAddresses and "
+          "Int64 capabilities and the runtime device to be created with "
+          "buffer device addresses enabled"),
+      llvm::cl::init(false));
+
+  static llvm::cl::opt<bool> clVulkanSpecializePushConstants(
+      "iree-vulkan-specialize-push-constants",
+      llvm::cl::desc(
+          "Mirror push constants (such as dynamic dimensions) in "
+          "specialization constants so that the runtime can create and reuse "
+          "pipelines specialized for the values used by dispatches"),
+      llvm::cl::init(false));
+
   VulkanSPIRVTargetOptions targetOptions;
   targetOptions.vulkanTargetEnv = clVulkanTargetEnv;
   targetOptions.vulkanTargetTriple = clVulkanTargetTriple;
   targetOptions.keepShaderModules = clVulkanKeepShaderModules;
+  targetOptions.bufferDeviceAddress = clVulkanBufferDeviceAddress;
+  targetOptions.specializePushConstants = clVulkanSpecializePushConstants;
 
   return targetOptions;
 }
@@ -269,6 +290,14 @@ class VulkanSPIRVTargetBackend : public TargetBackend {
   }
 #endif
 
+  Optional<std::string> getSerializationCacheFingerprint() const override {
+    // Preserved shader modules are a side-effect of serialization.
+    if (options_.keepShaderModules) return llvm::None;
+    // The target environment is part of the variant and serialization has no
+    // other options.
+    return std::string();
+  }
+
   LogicalResult serializeExecutable(IREE::HAL::ExecutableVariantOp variantOp,
                                     OpBuilder &executableBuilder) override {
     ModuleOp innerModuleOp = variantOp.getInnerModule();
@@ -305,6 +334,36 @@ class VulkanSPIRVTargetBackend : public TargetBackend {
 
     iree_SpirVExecutableDef_entry_points_add(builder, entryPointsRef);
     iree_SpirVExecutableDef_code_add(builder, spvCodeRef);
+    if (auto config = variantOp.target().getConfiguration()) {
+      if (auto attr = config.getAs<BoolAttr>(
+              getSPIRVBufferDeviceAddressAttrName())) {
+        iree_SpirVExecutableDef_buffer_device_address_add(builder,
+                                                          attr.getValue());
+      }
+      auto specializeAttr =
+          config.getAs<BoolAttr>(getSPIRVSpecializePushConstantsAttrName());
+      if (specializeAttr && specializeAttr.getValue()) {
+        // Push constants below the limit of the SPIR-V conversion are mirrored
+        // by specialization constants in every entry point.
+        int64_t pushConstantCount = 0;
+        for (auto entryPointOp :
+             variantOp.getOps<IREE::HAL::ExecutableEntryPointOp>()) {
+          pushConstantCount = std::max(
+              pushConstantCount, entryPointOp.layout().getPushConstants());
+        }
+        pushConstantCount =
+            std::min<int64_t>(pushConstantCount, kMaxSpecializedPushConstants);
+        if (pushConstantCount > 0) {
+          SmallVector<uint32_t> ordinals;
+          for (int64_t i = 0; i < pushConstantCount; ++i) {
+            ordinals.push_back(static_cast<uint32_t>(i));
+          }
+          iree_SpirVExecutableDef_specialized_push_constants_add(
+              builder, flatbuffers_uint32_vec_create(builder, ordinals.data(),
+                                                     ordinals.size()));
+        }
+      }
+    }
     iree_SpirVExecutableDef_end_as_root(builder);
 
     // Add the binary data to the target executable.
@@ -336,6 +395,16 @@ class VulkanSPIRVTargetBackend : public TargetBackend {
 
     configItems.emplace_back(b.getStringAttr(spirv::getTargetEnvAttrName()),
                              targetEnv);
+    if (options_.bufferDeviceAddress) {
+      configItems.emplace_back(
+          b.getStringAttr(getSPIRVBufferDeviceAddressAttrName()),
+          b.getBoolAttr(true));
+    }
+    if (options_.specializePushConstants) {
+      configItems.emplace_back(
+          b.getStringAttr(getSPIRVSpecializePushConstantsAttrName()),
+          b.getBoolAttr(true));
+    }
 
     auto configAttr = b.getDictionaryAttr(configItems);
     return IREE::HAL::ExecutableTargetAttr::get(
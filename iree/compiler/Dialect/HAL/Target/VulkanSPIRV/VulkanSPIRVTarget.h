@@ -24,6 +24,14 @@ struct VulkanSPIRVTargetOptions {
 
   // True to keep shader modules for debugging.
   bool keepShaderModules;
+
+  // True to access bindings through buffer device addresses passed as push
+  // constants instead of descriptor sets.
+  bool bufferDeviceAddress;
+
+  // True to let the runtime create pipelines specialized for the push constant
+  // values of dispatches.
+  bool specializePushConstants;
 };
 
 // Returns a VulkanSPIRVTargetOptions struct initialized with Vulkan/SPIR-V
@@ -0,0 +1,214 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <utility>
+
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+namespace {
+
+// Command opcodes as decoded by the hal.command_buffer.dispatch.batch import.
+// This must be kept in sync with iree/modules/hal/module.c.
+enum class BatchOpcode : uint32_t {
+  // <source_stage_mask, target_stage_mask, flags>
+  ExecutionBarrier = 0,
+  // <executable_layout, offset, value_count, values...>
+  PushConstants = 1,
+  // <executable_layout, set, binding_count,
+  //  (binding, buffer, offset, length)...>
+  PushDescriptorSet = 2,
+  // <executable, entry_point, workgroup_x, workgroup_y, workgroup_z>
+  Dispatch = 3,
+};
+
+// Accumulates the encoded commands and resources of a single batch.
+class BatchEncoder {
+ public:
+  // Appends |op| to the batch if it can be encoded and returns false if it
+  // cannot (in which case the batch is unchanged).
+  bool append(Operation *op) {
+    size_t originalWordCount = words.size();
+    size_t originalResourceCount = resources.size();
+    bool didEncode =
+        TypeSwitch<Operation *, bool>(op)
+            .Case<CommandBufferExecutionBarrierOp>([&](auto op) {
+              emit(BatchOpcode::ExecutionBarrier);
+              words.push_back(static_cast<uint32_t>(op.source_stage_mask()));
+              words.push_back(static_cast<uint32_t>(op.target_stage_mask()));
+              words.push_back(static_cast<uint32_t>(op.flags()));
+              return true;
+            })
+            .Case<CommandBufferPushConstantsOp>([&](auto op) {
+              emit(BatchOpcode::PushConstants);
+              emitResource(op.executable_layout());
+              words.push_back(op.offset().getZExtValue());
+              words.push_back(op.values().size());
+              return llvm::all_of(op.values(),
+                                  [&](Value value) { return emitInt(value); });
+            })
+            .Case<CommandBufferPushDescriptorSetOp>([&](auto op) {
+              emit(BatchOpcode::PushDescriptorSet);
+              emitResource(op.executable_layout());
+              if (!emitInt(op.set())) return false;
+              words.push_back(op.binding_ordinals().size());
+              for (size_t i = 0; i < op.binding_ordinals().size(); ++i) {
+                if (!emitInt(op.binding_ordinals()[i])) return false;
+                emitResource(op.binding_buffers()[i]);
+                if (!emitInt(op.binding_offsets()[i]) ||
+                    !emitInt(op.binding_lengths()[i])) {
+                  return false;
+                }
+              }
+              return true;
+            })
+            .Case<CommandBufferDispatchOp>([&](auto op) {
+              emit(BatchOpcode::Dispatch);
+              emitResource(op.executable());
+              words.push_back(op.entry_point().getZExtValue());
+              return emitInt(op.workgroup_x()) && emitInt(op.workgroup_y()) &&
+                     emitInt(op.workgroup_z());
+            })
+            .Default([](Operation *op) { return false; });
+    if (!didEncode) {
+      words.resize(originalWordCount);
+      while (resources.size() > originalResourceCount) resources.pop_back();
+      return false;
+    }
+    ops.push_back(op);
+    return true;
+  }
+
+  bool empty() const { return ops.empty(); }
+
+  // Replaces the batched ops with a single hal.command_buffer.dispatch.batch.
+  // Batches of a single op are left as-is as there's no benefit in batching
+  // them.
+  void flush(Value commandBuffer) {
+    if (ops.size() >= 2) {
+      auto *lastOp = ops.back();
+      OpBuilder builder(lastOp);
+      auto loc = builder.getFusedLoc(llvm::to_vector<8>(
+          llvm::map_range(ops, [](Operation *op) { return op->getLoc(); })));
+      auto commandsAttr = DenseIntElementsAttr::get(
+          VectorType::get({static_cast<int64_t>(words.size())},
+                          builder.getI32Type()),
+          words);
+      auto commands = builder.create<IREE::Util::ByteBufferConstantOp>(
+          loc, builder.getType<IREE::Util::ByteBufferType>(), commandsAttr,
+          builder.getI64IntegerAttr(sizeof(uint32_t)));
+      builder.create<CommandBufferDispatchBatchOp>(
+          loc, commandBuffer, commands, resources.getArrayRef());
+      for (auto *op : ops) op->erase();
+    }
+    ops.clear();
+    words.clear();
+    resources.clear();
+  }
+
+ private:
+  void emit(BatchOpcode opcode) {
+    words.push_back(static_cast<uint32_t>(opcode));
+  }
+
+  // Emits the ordinal of |value| in the batch resource list.
+  void emitResource(Value value) {
+    resources.insert(value);
+    words.push_back(static_cast<uint32_t>(
+        std::distance(resources.begin(), llvm::find(resources, value))));
+  }
+
+  // Emits |value| if it is a constant representable as a 32-bit word.
+  bool emitInt(Value value) {
+    APInt intValue;
+    if (!matchPattern(value, m_ConstantInt(&intValue))) return false;
+    if (!intValue.isIntN(32)) return false;
+    words.push_back(static_cast<uint32_t>(intValue.getZExtValue()));
+    return true;
+  }
+
+  SmallVector<Operation *> ops;
+  SmallVector<uint32_t> words;
+  llvm::SetVector<Value> resources;
+};
+
+class BatchDispatchCommandsPass
+    : public PassWrapper<BatchDispatchCommandsPass, OperationPass<void>> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::HAL::HALDialect, IREE::Util::UtilDialect>();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-hal-batch-dispatch-commands";
+  }
+
+  StringRef getDescription() const override {
+    return "Batches runs of command buffer commands with constant parameters "
+           "into hal.command_buffer.dispatch.batch ops.";
+  }
+
+  void runOnOperation() override {
+    SmallVector<Block *> blocks;
+    getOperation()->walk([&](Block *block) { blocks.push_back(block); });
+    for (auto *block : blocks) batchBlock(*block);
+  }
+
+ private:
+  // Batches runs of commands recorded into the same command buffer. Ops with
+  // no side effects (such as constants and loads of immutable globals) may be
+  // interleaved with the commands; any other op ends the current batch.
+  void batchBlock(Block &block) {
+    BatchEncoder encoder;
+    Value commandBuffer;
+    for (auto &op : llvm::make_early_inc_range(block)) {
+      bool isCommand = isa<CommandBufferExecutionBarrierOp,
+                           CommandBufferPushConstantsOp,
+                           CommandBufferPushDescriptorSetOp,
+                           CommandBufferDispatchOp>(op);
+      if (!isCommand) {
+        if (MemoryEffectOpInterface::hasNoEffect(&op)) continue;
+        encoder.flush(commandBuffer);
+        continue;
+      }
+      auto opCommandBuffer = op.getOperand(0);
+      if (!encoder.empty() && opCommandBuffer != commandBuffer) {
+        encoder.flush(commandBuffer);
+      }
+      commandBuffer = opCommandBuffer;
+      if (!encoder.append(&op)) encoder.flush(commandBuffer);
+    }
+    encoder.flush(commandBuffer);
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<void>> createBatchDispatchCommandsPass() {
+  return std::make_unique<BatchDispatchCommandsPass>();
+}
+
+static PassRegistration<BatchDispatchCommandsPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -18,7 +18,8 @@ namespace {
 
 // A pass converting the IREE flow dialect into the IREE HAL dialect.
 class BenchmarkBatchDispatchesPass
-    : public PassWrapper<BenchmarkBatchDispatchesPass, OperationPass<FuncOp>> {
+    : public PassWrapper<BenchmarkBatchDispatchesPass,
+                         OperationPass<ModuleOp>> {
  public:
   explicit BenchmarkBatchDispatchesPass(unsigned repeatCount)
       : repeatCount_(repeatCount) {}
@@ -37,9 +38,9 @@ class BenchmarkBatchDispatchesPass
   }
 
   void runOnOperation() override {
-    FuncOp f = getOperation();
+    auto moduleOp = getOperation();
     SmallVector<HAL::CommandBufferDispatchOp> ops;
-    f.walk([&](HAL::CommandBufferDispatchOp op) { ops.push_back(op); });
+    moduleOp.walk([&](HAL::CommandBufferDispatchOp op) { ops.push_back(op); });
 
     for (auto op : ops) {
       OpBuilder builder(op);
@@ -60,6 +61,26 @@ class BenchmarkBatchDispatchesPass
             IREE::HAL::ExecutionBarrierFlagBitfield::None);
       }
     }
+    if (ops.empty()) return;
+
+    // Record the repeat count on all exported functions so that the benchmark
+    // tool can report per-dispatch timings without being told the batch size.
+    // Dispatches may be recorded in private functions called by the exports
+    // so every export is annotated.
+    Builder builder(moduleOp.getContext());
+    auto batchSizeAttr = builder.getStringAttr(std::to_string(repeatCount_));
+    for (auto funcOp : moduleOp.getOps<FuncOp>()) {
+      if (!funcOp.isPublic()) continue;
+      SmallVector<NamedAttribute> reflectionAttrs;
+      if (auto existingAttr =
+              funcOp->getAttrOfType<DictionaryAttr>("iree.reflection")) {
+        llvm::append_range(reflectionAttrs, existingAttr.getValue());
+      }
+      reflectionAttrs.push_back(
+          builder.getNamedAttr("batch_size", batchSizeAttr));
+      funcOp->setAttr("iree.reflection",
+                      builder.getDictionaryAttr(reflectionAttrs));
+    }
   }
 
  private:
@@ -68,7 +89,7 @@ class BenchmarkBatchDispatchesPass
 
 }  // namespace
 
-std::unique_ptr<OperationPass<FuncOp>> createBenchmarkBatchDispatchesPass(
+std::unique_ptr<OperationPass<ModuleOp>> createBenchmarkBatchDispatchesPass(
     unsigned repeatCount) {
   return std::make_unique<BenchmarkBatchDispatchesPass>(repeatCount);
 }
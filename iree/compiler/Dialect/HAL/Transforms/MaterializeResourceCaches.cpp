@@ -7,15 +7,20 @@
 #include <memory>
 #include <utility>
 
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
 #include "iree/compiler/Dialect/HAL/Utils/DeviceSwitchBuilder.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/IR/Attributes.h"
+#include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "mlir/Pass/Pass.h"
 
 namespace mlir {
@@ -42,6 +47,7 @@ class MaterializeResourceCachesPass
     auto moduleOp = getOperation();
     if (moduleOp.getBody()->empty()) return;
     moduleBuilder = OpBuilder(&moduleOp.getBody()->front());
+    symbolTable = std::make_unique<SymbolTable>(moduleOp);
 
     auto executableOps = llvm::to_vector<8>(moduleOp.getOps<ExecutableOp>());
 
@@ -56,15 +62,17 @@ class MaterializeResourceCachesPass
         for (auto entryPointOp :
              variantOp.getOps<IREE::HAL::ExecutableEntryPointOp>()) {
           defineExecutableLayoutOp(entryPointOp.getLoc(),
-                                   entryPointOp.layout());
+                                   entryPointOp.layout(),
+                                   /*deviceOrdinal=*/0);
         }
       }
     }
 
     // Declare executable variables so that we can reference them during lookup
-    // replacement.
+    // replacement. Caches for devices other than the shared device are
+    // declared as lookups on them are found.
     for (auto executableOp : executableOps) {
-      if (!defineExecutableOp(executableOp)) {
+      if (!defineExecutableOp(executableOp, /*deviceOrdinal=*/0)) {
         signalPassFailure();
         return;
       }
@@ -87,12 +95,40 @@ class MaterializeResourceCachesPass
         });
       }
     }
+
+    // Record command buffers that only reference initialization-time values
+    // once in an initializer and reuse them on each invocation.
+    if (targetOptions_.cacheStaticCommandBuffers) {
+      SmallVector<CommandBufferCreateOp> createOps;
+      for (auto funcOp : moduleOp.getOps<mlir::FuncOp>()) {
+        funcOp.walk([&](CommandBufferCreateOp createOp) {
+          createOps.push_back(createOp);
+        });
+      }
+      for (auto createOp : createOps) {
+        cacheStaticCommandBuffer(moduleOp, createOp);
+      }
+    }
   }
 
  private:
+  // Returns the ordinal of |device| that resources are looked up on.
+  // Devices that are not statically known are assumed to be the shared device.
+  static int64_t getDeviceOrdinal(Value device) {
+    return ExDeviceOp::findDeviceOrdinal(device).getValueOr(0);
+  }
+
+  // Returns a suffix for symbols of resources cached on |deviceOrdinal|.
+  static std::string getDeviceSuffix(int64_t deviceOrdinal) {
+    if (deviceOrdinal == 0) return "";
+    return "_device" + std::to_string(deviceOrdinal);
+  }
+
   IREE::Util::GlobalOp defineDescriptorSetLayoutOp(Location loc,
-                                                   ArrayAttr bindingAttrs) {
-    auto existingIt = descriptorSetLayoutCache_.find(bindingAttrs);
+                                                   ArrayAttr bindingAttrs,
+                                                   int64_t deviceOrdinal) {
+    auto cacheKey = std::make_pair(Attribute(bindingAttrs), deviceOrdinal);
+    auto existingIt = descriptorSetLayoutCache_.find(cacheKey);
     if (existingIt != descriptorSetLayoutCache_.end()) {
       return existingIt->second;
     }
@@ -106,12 +142,13 @@ class MaterializeResourceCachesPass
         loc, symbolName,
         /*isMutable=*/false, layoutType);
     globalOp.setPrivate();
-    descriptorSetLayoutCache_.try_emplace(bindingAttrs, globalOp);
+    descriptorSetLayoutCache_.try_emplace(cacheKey, globalOp);
 
     auto initializerOp = moduleBuilder.create<IREE::Util::InitializerOp>(loc);
     OpBuilder blockBuilder =
         OpBuilder::atBlockEnd(initializerOp.addEntryBlock());
-    auto deviceValue = blockBuilder.createOrFold<ExSharedDeviceOp>(loc);
+    auto deviceValue =
+        ExDeviceOp::buildDeviceLookup(loc, deviceOrdinal, blockBuilder);
     auto layoutUsage = IREE::HAL::DescriptorSetLayoutUsageType::PushOnly;
     auto layoutValue = blockBuilder.createOrFold<DescriptorSetLayoutCreateOp>(
         loc, layoutType, deviceValue, layoutUsage, bindingAttrs);
@@ -123,8 +160,10 @@ class MaterializeResourceCachesPass
   }
 
   IREE::Util::GlobalOp defineExecutableLayoutOp(
-      Location loc, IREE::HAL::ExecutableLayoutAttr layoutAttr) {
-    auto existingIt = executableLayoutCache_.find(layoutAttr);
+      Location loc, IREE::HAL::ExecutableLayoutAttr layoutAttr,
+      int64_t deviceOrdinal) {
+    auto cacheKey = std::make_pair(Attribute(layoutAttr), deviceOrdinal);
+    auto existingIt = executableLayoutCache_.find(cacheKey);
     if (existingIt != executableLayoutCache_.end()) {
       return existingIt->second;
     }
@@ -138,7 +177,7 @@ class MaterializeResourceCachesPass
         bindingAttrs.push_back(bindingAttr);
       }
       setLayoutGlobalOps.push_back(defineDescriptorSetLayoutOp(
-          loc, ArrayAttr::get(loc.getContext(), bindingAttrs)));
+          loc, ArrayAttr::get(loc.getContext(), bindingAttrs), deviceOrdinal));
     }
 
     auto symbolName = (StringRef("_executable_layout_") +
@@ -149,7 +188,7 @@ class MaterializeResourceCachesPass
     auto globalOp = moduleBuilder.create<IREE::Util::GlobalOp>(
         loc, symbolName, /*isMutable=*/false, layoutType);
     globalOp.setPrivate();
-    executableLayoutCache_.try_emplace(layoutAttr, globalOp);
+    executableLayoutCache_.try_emplace(cacheKey, globalOp);
 
     auto initializerOp = moduleBuilder.create<IREE::Util::InitializerOp>(loc);
     OpBuilder blockBuilder =
@@ -161,7 +200,8 @@ class MaterializeResourceCachesPass
           setLayoutGlobalOp.sym_name());
       setLayoutValues.push_back(setLayoutValue);
     }
-    auto deviceValue = blockBuilder.createOrFold<ExSharedDeviceOp>(loc);
+    auto deviceValue =
+        ExDeviceOp::buildDeviceLookup(loc, deviceOrdinal, blockBuilder);
     auto layoutValue = blockBuilder.createOrFold<ExecutableLayoutCreateOp>(
         loc, layoutType, deviceValue,
         blockBuilder.getIndexAttr(layoutAttr.getPushConstants()),
@@ -173,21 +213,14 @@ class MaterializeResourceCachesPass
     return globalOp;
   }
 
-  IREE::Util::GlobalOp defineExecutableOp(ExecutableOp executableOp) {
+  // Builds IR creating the executable for the variant matching the runtime
+  // device with |deviceOrdinal| or null if none matches.
+  Value buildExecutableCreate(ExecutableOp executableOp, int64_t deviceOrdinal,
+                              OpBuilder &blockBuilder) {
     auto loc = executableOp.getLoc();
-    auto symbolName =
-        (StringRef("_executable_") + executableOp.sym_name()).str();
-
     auto executableType = ExecutableType::get(executableOp.getContext());
-    auto globalOp = moduleBuilder.create<IREE::Util::GlobalOp>(
-        loc, symbolName, /*isMutable=*/false, executableType);
-    globalOp.setPrivate();
-    executableCache_.try_emplace(executableOp.sym_name(), globalOp);
-
-    auto initializerOp = moduleBuilder.create<IREE::Util::InitializerOp>(loc);
-    OpBuilder blockBuilder =
-        OpBuilder::atBlockEnd(initializerOp.addEntryBlock());
-    auto deviceValue = blockBuilder.createOrFold<ExSharedDeviceOp>(loc);
+    auto deviceValue =
+        ExDeviceOp::buildDeviceLookup(loc, deviceOrdinal, blockBuilder);
 
     // Create a switch statement with a case for each variant.
     // Each case should then cache only executables which contain a matching
@@ -209,7 +242,7 @@ class MaterializeResourceCachesPass
       for (auto entryPointOp :
            executableVariantOp.getOps<IREE::HAL::ExecutableEntryPointOp>()) {
         auto executableLayoutGlobalOp = defineExecutableLayoutOp(
-            executableOp.getLoc(), entryPointOp.layout());
+            executableOp.getLoc(), entryPointOp.layout(), deviceOrdinal);
         executableLayoutValues.push_back(
             caseBuilder.createOrFold<IREE::Util::GlobalLoadOp>(
                 loc, ExecutableLayoutType::get(loc.getContext()),
@@ -234,7 +267,44 @@ class MaterializeResourceCachesPass
     defaultBuilder.create<IREE::HAL::ReturnOp>(loc, nullValue);
 
     auto switchOp = switchBuilder.build();
-    auto executableValue = switchOp.getResult(0);
+    return switchOp.getResult(0);
+  }
+
+  IREE::Util::GlobalOp defineExecutableOp(ExecutableOp executableOp,
+                                          int64_t deviceOrdinal) {
+    auto loc = executableOp.getLoc();
+    auto symbolName = (StringRef("_executable_") + executableOp.sym_name() +
+                       getDeviceSuffix(deviceOrdinal))
+                          .str();
+
+    // Layouts must be initialized before the executable using them.
+    for (auto variantOp :
+         executableOp.getOps<IREE::HAL::ExecutableVariantOp>()) {
+      for (auto entryPointOp :
+           variantOp.getOps<IREE::HAL::ExecutableEntryPointOp>()) {
+        defineExecutableLayoutOp(entryPointOp.getLoc(), entryPointOp.layout(),
+                                 deviceOrdinal);
+      }
+    }
+
+    auto executableType = ExecutableType::get(executableOp.getContext());
+    auto globalOp = moduleBuilder.create<IREE::Util::GlobalOp>(
+        loc, symbolName,
+        /*isMutable=*/targetOptions_.lazyExecutableCreation, executableType);
+    globalOp.setPrivate();
+    executableCache_.try_emplace(
+        std::make_pair(executableOp.sym_name(), deviceOrdinal), globalOp);
+
+    if (targetOptions_.lazyExecutableCreation) {
+      defineExecutableLookupFuncOp(executableOp, deviceOrdinal, globalOp);
+      return globalOp;
+    }
+
+    auto initializerOp = moduleBuilder.create<IREE::Util::InitializerOp>(loc);
+    OpBuilder blockBuilder =
+        OpBuilder::atBlockEnd(initializerOp.addEntryBlock());
+    auto executableValue =
+        buildExecutableCreate(executableOp, deviceOrdinal, blockBuilder);
     blockBuilder.create<IREE::Util::GlobalStoreOp>(loc, executableValue,
                                                    globalOp.getName());
     blockBuilder.create<IREE::Util::InitializerReturnOp>(loc);
@@ -242,11 +312,56 @@ class MaterializeResourceCachesPass
     return globalOp;
   }
 
+  // Defines a function returning the executable cached in |globalOp| and
+  // creating it on first use. This keeps module initialization from
+  // preparing executables that may not be needed for a long time (or at all)
+  // such that the first call only waits on the executables it uses.
+  void defineExecutableLookupFuncOp(ExecutableOp executableOp,
+                                    int64_t deviceOrdinal,
+                                    IREE::Util::GlobalOp globalOp) {
+    auto loc = executableOp.getLoc();
+    auto executableType = ExecutableType::get(executableOp.getContext());
+    auto funcOp = moduleBuilder.create<mlir::FuncOp>(
+        loc, (globalOp.getName() + "_lookup").str(),
+        moduleBuilder.getFunctionType({}, {executableType}));
+    funcOp.setPrivate();
+    executableLookupFuncs_.try_emplace(
+        std::make_pair(executableOp.sym_name(), deviceOrdinal), funcOp);
+
+    auto *entryBlock = funcOp.addEntryBlock();
+    auto *createBlock = funcOp.addBlock();
+    auto *exitBlock = funcOp.addBlock();
+    auto exitArg = exitBlock->addArgument(executableType, loc);
+
+    auto entryBuilder = OpBuilder::atBlockBegin(entryBlock);
+    auto cachedValue = entryBuilder.create<IREE::Util::GlobalLoadOp>(
+        loc, executableType, globalOp.getName());
+    auto nullValue =
+        entryBuilder.create<IREE::Util::NullOp>(loc, executableType);
+    auto isNull = entryBuilder.create<IREE::Util::CmpEQOp>(
+        loc, entryBuilder.getI1Type(), cachedValue, nullValue);
+    entryBuilder.create<mlir::cf::CondBranchOp>(
+        loc, isNull, createBlock, ValueRange{}, exitBlock,
+        ValueRange{cachedValue});
+
+    auto createBuilder = OpBuilder::atBlockBegin(createBlock);
+    auto executableValue =
+        buildExecutableCreate(executableOp, deviceOrdinal, createBuilder);
+    createBuilder.create<IREE::Util::GlobalStoreOp>(loc, executableValue,
+                                                    globalOp.getName());
+    createBuilder.create<mlir::cf::BranchOp>(loc, exitBlock,
+                                             ValueRange{executableValue});
+
+    auto exitBuilder = OpBuilder::atBlockBegin(exitBlock);
+    exitBuilder.create<mlir::ReturnOp>(loc, ValueRange{exitArg});
+  }
+
   void replaceDescriptorSetLayoutLookupOp(
       DescriptorSetLayoutLookupOp &lookupOp) {
     OpBuilder builder(lookupOp);
     auto globalOp =
-        defineDescriptorSetLayoutOp(lookupOp.getLoc(), lookupOp.bindings());
+        defineDescriptorSetLayoutOp(lookupOp.getLoc(), lookupOp.bindings(),
+                                    getDeviceOrdinal(lookupOp.device()));
     auto loadOp = builder.create<IREE::Util::GlobalLoadOp>(
         lookupOp.getLoc(), DescriptorSetLayoutType::get(lookupOp.getContext()),
         globalOp.sym_name());
@@ -257,7 +372,8 @@ class MaterializeResourceCachesPass
   void replaceExecutableLayoutLookupOp(ExecutableLayoutLookupOp &lookupOp) {
     OpBuilder builder(lookupOp);
     auto globalOp =
-        defineExecutableLayoutOp(lookupOp.getLoc(), lookupOp.layout());
+        defineExecutableLayoutOp(lookupOp.getLoc(), lookupOp.layout(),
+                                 getDeviceOrdinal(lookupOp.device()));
     auto loadOp = builder.create<IREE::Util::GlobalLoadOp>(
         lookupOp.getLoc(), ExecutableLayoutType::get(lookupOp.getContext()),
         globalOp.sym_name());
@@ -267,10 +383,26 @@ class MaterializeResourceCachesPass
 
   void replaceExecutableLookupOp(ExecutableLookupOp &lookupOp) {
     OpBuilder builder(lookupOp);
-    auto executableIt = executableCache_.find(lookupOp.executable());
-    assert(executableIt != executableCache_.end() &&
-           "executable must have been cached");
+    auto cacheKey = std::make_pair(lookupOp.executable(),
+                                   getDeviceOrdinal(lookupOp.device()));
+    auto executableIt = executableCache_.find(cacheKey);
+    if (executableIt == executableCache_.end()) {
+      // First use of the executable on a device other than the shared device.
+      auto executableOp =
+          symbolTable->lookup<ExecutableOp>(lookupOp.executable());
+      assert(executableOp && "executable must exist");
+      defineExecutableOp(executableOp, cacheKey.second);
+      executableIt = executableCache_.find(cacheKey);
+    }
     auto globalOp = executableIt->second;
+    auto funcIt = executableLookupFuncs_.find(cacheKey);
+    if (funcIt != executableLookupFuncs_.end()) {
+      auto callOp =
+          builder.create<mlir::CallOp>(lookupOp.getLoc(), funcIt->second);
+      lookupOp.replaceAllUsesWith(callOp.getOperation());
+      lookupOp.erase();
+      return;
+    }
     auto loadOp = builder.create<IREE::Util::GlobalLoadOp>(
         lookupOp.getLoc(), ExecutableType::get(lookupOp.getContext()),
         globalOp.sym_name());
@@ -278,15 +410,151 @@ class MaterializeResourceCachesPass
     lookupOp.erase();
   }
 
+  // Returns true if |value| is produced by an op that can be rematerialized
+  // in an initializer and will produce the same value there.
+  static bool isInitializationTimeValue(Value value) {
+    auto *definingOp = value.getDefiningOp();
+    if (!definingOp) return false;
+    if (auto loadOp = dyn_cast<IREE::Util::GlobalLoadOp>(definingOp)) {
+      return loadOp.isGlobalImmutable();
+    }
+    return isa<ExSharedDeviceOp, IREE::Util::NullOp>(definingOp) ||
+           definingOp->hasTrait<OpTrait::ConstantLike>();
+  }
+
+  // Moves the recording of the command buffer created by |createOp| into an
+  // initializer if all of the commands recorded into it only depend on
+  // initialization-time values. The command buffer is created without
+  // OneShot so that it can be submitted on each invocation.
+  // Command buffers that capture any dynamic value are left as-is.
+  void cacheStaticCommandBuffer(ModuleOp moduleOp,
+                                CommandBufferCreateOp createOp) {
+    Value commandBuffer = createOp.result();
+    auto *block = createOp->getBlock();
+
+    // Find the recording range; both begin and end must be in the same block
+    // as the create so that all commands are recorded unconditionally.
+    CommandBufferBeginOp beginOp;
+    CommandBufferEndOp endOp;
+    for (auto *user : commandBuffer.getUsers()) {
+      if (auto op = dyn_cast<CommandBufferBeginOp>(user)) {
+        if (beginOp || op->getBlock() != block) return;
+        beginOp = op;
+      } else if (auto op = dyn_cast<CommandBufferEndOp>(user)) {
+        if (endOp || op->getBlock() != block) return;
+        endOp = op;
+      }
+    }
+    if (!beginOp || !endOp || !beginOp->isBeforeInBlock(endOp)) return;
+    SetVector<Operation *> rangeOps;
+    for (auto it = std::next(beginOp->getIterator());
+         it != endOp->getIterator(); ++it) {
+      rangeOps.insert(&*it);
+    }
+    auto isInRange = [&](Operation *op) {
+      auto *ancestorOp = block->findAncestorOpInBlock(*op);
+      return ancestorOp && rangeOps.contains(ancestorOp);
+    };
+
+    // All other uses of the command buffer (submissions, etc) must come after
+    // recording has ended.
+    for (auto *user : commandBuffer.getUsers()) {
+      if (user == beginOp || user == endOp || isInRange(user)) continue;
+      auto *ancestorOp = block->findAncestorOpInBlock(*user);
+      if (!ancestorOp || !endOp->isBeforeInBlock(ancestorOp)) return;
+    }
+
+    // Verify the recorded commands have no effects other than recording and
+    // gather the values they capture from outside of the range.
+    SetVector<Value> capturedValues;
+    if (!isInitializationTimeValue(createOp.device())) return;
+    capturedValues.insert(createOp.device());
+    for (auto *rangeOp : rangeOps) {
+      for (auto *user : rangeOp->getUsers()) {
+        if (!isInRange(user)) return;
+      }
+      auto walkResult = rangeOp->walk([&](Operation *op) -> WalkResult {
+        if (!isa_and_nonnull<HALDialect>(op->getDialect()) &&
+            !MemoryEffectOpInterface::hasNoEffect(op)) {
+          return WalkResult::interrupt();
+        }
+        for (auto operand : op->getOperands()) {
+          if (operand == commandBuffer) continue;
+          auto *definingOp = operand.getDefiningOp();
+          if (!definingOp) definingOp = operand.getParentBlock()->getParentOp();
+          if (isInRange(definingOp)) continue;
+          if (!isInitializationTimeValue(operand)) {
+            return WalkResult::interrupt();
+          }
+          capturedValues.insert(operand);
+        }
+        return WalkResult::advance();
+      });
+      if (walkResult.wasInterrupted()) return;
+    }
+
+    // Record the command buffer into a global during initialization. This is
+    // placed at the end of the module so that any global it references has
+    // been initialized first.
+    auto loc = createOp.getLoc();
+    auto commandBufferType = createOp.getType();
+    auto symbolName = (StringRef("_command_buffer_") +
+                       std::to_string(nextUniqueCommandBufferId++))
+                          .str();
+    auto endBuilder = OpBuilder::atBlockEnd(moduleOp.getBody());
+    auto globalOp = endBuilder.create<IREE::Util::GlobalOp>(
+        loc, symbolName, /*isMutable=*/false, commandBufferType);
+    globalOp.setPrivate();
+
+    auto initializerOp = endBuilder.create<IREE::Util::InitializerOp>(loc);
+    OpBuilder blockBuilder =
+        OpBuilder::atBlockEnd(initializerOp.addEntryBlock());
+    BlockAndValueMapping mapping;
+    for (auto capturedValue : capturedValues) {
+      if (mapping.contains(capturedValue)) continue;
+      blockBuilder.clone(*capturedValue.getDefiningOp(), mapping);
+    }
+    auto newCreateOp = blockBuilder.create<CommandBufferCreateOp>(
+        loc, commandBufferType, mapping.lookup(createOp.device()),
+        IREE::HAL::CommandBufferModeBitfield::None,
+        createOp.command_categories());
+    mapping.map(commandBuffer, newCreateOp.result());
+    blockBuilder.clone(*beginOp, mapping);
+    for (auto *rangeOp : rangeOps) blockBuilder.clone(*rangeOp, mapping);
+    blockBuilder.clone(*endOp, mapping);
+    blockBuilder.create<IREE::Util::GlobalStoreOp>(loc, newCreateOp.result(),
+                                                   globalOp.getName());
+    blockBuilder.create<IREE::Util::InitializerReturnOp>(loc);
+
+    // Replace the recording with a load of the cached command buffer. The
+    // captured values are left in place for cleanup to remove if unused.
+    endOp.erase();
+    for (auto *rangeOp : llvm::reverse(rangeOps)) rangeOp->erase();
+    beginOp.erase();
+    auto loadOp = OpBuilder(createOp).create<IREE::Util::GlobalLoadOp>(
+        loc, commandBufferType, globalOp.getName());
+    createOp.replaceAllUsesWith(loadOp.getOperation());
+    createOp.erase();
+  }
+
   TargetOptions targetOptions_;
 
   OpBuilder moduleBuilder{static_cast<MLIRContext *>(nullptr)};
-  DenseMap<Attribute, IREE::Util::GlobalOp> descriptorSetLayoutCache_;
-  DenseMap<Attribute, IREE::Util::GlobalOp> executableLayoutCache_;
-  DenseMap<StringRef, IREE::Util::GlobalOp> executableCache_;
+  std::unique_ptr<SymbolTable> symbolTable;
+
+  // Caches keyed by the resource and the ordinal of the device it is created
+  // on.
+  DenseMap<std::pair<Attribute, int64_t>, IREE::Util::GlobalOp>
+      descriptorSetLayoutCache_;
+  DenseMap<std::pair<Attribute, int64_t>, IREE::Util::GlobalOp>
+      executableLayoutCache_;
+  DenseMap<std::pair<StringRef, int64_t>, IREE::Util::GlobalOp>
+      executableCache_;
+  DenseMap<std::pair<StringRef, int64_t>, mlir::FuncOp> executableLookupFuncs_;
 
   int nextUniqueExecutableLayoutId = 0;
   int nextUniqueDescriptorSetLayoutId = 0;
+  int nextUniqueCommandBufferId = 0;
 };
 
 std::unique_ptr<OperationPass<ModuleOp>> createMaterializeResourceCachesPass(
@@ -22,8 +22,9 @@ namespace iree_compiler {
 namespace IREE {
 namespace HAL {
 
-// NOTE: this implementation is just for a single active device. As we start to
-// support multiple devices we'll need to change this to be per-device.
+// Queries are memoized per device as devices may differ in their answers
+// (such as when selecting executable variants). Devices that are not statically
+// known are assumed to be the shared device.
 class MemoizeDeviceQueriesPass
     : public PassWrapper<MemoizeDeviceQueriesPass, OperationPass<ModuleOp>> {
  public:
@@ -46,6 +47,8 @@ class MemoizeDeviceQueriesPass
       auto funcOp = llvm::dyn_cast<FunctionOpInterface>(funcLikeOp);
       if (!funcOp) continue;
       funcLikeOp.walk([&](IREE::HAL::DeviceQueryOp queryOp) {
+        int64_t deviceOrdinal =
+            ExDeviceOp::findDeviceOrdinal(queryOp.device()).getValueOr(0);
         auto fullKey = ArrayAttr::get(
             moduleOp.getContext(),
             {
@@ -53,6 +56,8 @@ class MemoizeDeviceQueriesPass
                                 queryOp.category() + queryOp.key()),
                 queryOp.default_value().hasValue() ? queryOp.default_valueAttr()
                                                    : Attribute{},
+                IntegerAttr::get(IndexType::get(moduleOp.getContext()),
+                                 deviceOrdinal),
             });
         auto lookup = deviceQueryOps.try_emplace(
             fullKey, std::vector<IREE::HAL::DeviceQueryOp>{});
@@ -92,8 +97,12 @@ class MemoizeDeviceQueriesPass
       auto initializerOp =
           moduleBuilder.create<IREE::Util::InitializerOp>(fusedLoc);
       auto funcBuilder = OpBuilder::atBlockBegin(initializerOp.addEntryBlock());
+      int64_t deviceOrdinal = queryKey.value()
+                                  .cast<ArrayAttr>()[2]
+                                  .cast<IntegerAttr>()
+                                  .getInt();
       auto device =
-          funcBuilder.createOrFold<IREE::HAL::ExSharedDeviceOp>(fusedLoc);
+          ExDeviceOp::buildDeviceLookup(fusedLoc, deviceOrdinal, funcBuilder);
       auto queryOp = funcBuilder.create<IREE::HAL::DeviceQueryOp>(
           fusedLoc, funcBuilder.getI1Type(), queryType, device,
           anyQueryOp.categoryAttr(), anyQueryOp.keyAttr(),
@@ -48,6 +48,14 @@ static llvm::cl::opt<unsigned> benchmarkDispatchRepeatCount{
         "structures.)"),
     llvm::cl::init(1)};
 
+static llvm::cl::opt<bool> batchDispatchCommands{
+    "iree-hal-batch-dispatch-commands",
+    llvm::cl::desc(
+        "Records runs of command buffer commands with constant parameters "
+        "using a single hal.command_buffer.dispatch.batch call. Requires a "
+        "runtime HAL module that provides the batch import."),
+    llvm::cl::init(false)};
+
 }  // namespace
 
 static void addCleanupPatterns(OpPassManager &passManager) {
@@ -180,7 +188,7 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
 
   // HACK: repeat dispatch ops for benchmarks.
   if (benchmarkDispatchRepeatCount != 1) {
-    passManager.addNestedPass<mlir::FuncOp>(
+    passManager.addPass(
         createBenchmarkBatchDispatchesPass(benchmarkDispatchRepeatCount));
   }
 
@@ -197,6 +205,14 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
   passManager.addPass(IREE::Util::createCombineInitializersPass());
   addCleanupPatterns(passManager);
 
+  // Batch command recording into as few calls as possible. This must happen
+  // after all command buffer optimizations as they operate on individual ops.
+  if (batchDispatchCommands) {
+    passManager.addNestedPass<IREE::Util::InitializerOp>(
+        createBatchDispatchCommandsPass());
+    passManager.addNestedPass<mlir::FuncOp>(createBatchDispatchCommandsPass());
+  }
+
   //----------------------------------------------------------------------------
   // Executable serialization
   //----------------------------------------------------------------------------
@@ -205,7 +221,8 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
   // contents not turned into a big base64 string.
   if (transformOptions.serializeExecutables) {
     passManager.addNestedPass<IREE::HAL::ExecutableOp>(
-        createSerializeExecutablesPass());
+        createSerializeExecutablesPass(
+            targetOptions.executableCacheDirectory));
 
     // NOTE: symbol DCE will destroy executable target contents, so only run it
     // if we serialized things.
@@ -99,12 +99,15 @@ std::unique_ptr<OperationPass<mlir::ModuleOp>> createLinkTargetExecutablesPass(
 std::unique_ptr<OperationPass<ModuleOp>> createResolveEntryPointOrdinalsPass();
 
 // Converts hal.executable.variants to one or more hal.executable.binary ops.
+// If |cacheDirectory| is provided serialized binaries are cached there and
+// reused by subsequent compilations of identical variants.
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableOp>>
-createSerializeExecutablesPass();
+createSerializeExecutablesPass(StringRef cacheDirectory = "");
 
 // Serializes executables for the specified |target| backend.
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableOp>>
-createSerializeTargetExecutablesPass(StringRef target);
+createSerializeTargetExecutablesPass(StringRef target,
+                                     StringRef cacheDirectory = "");
 
 //===----------------------------------------------------------------------===//
 // Resource initialization, caching, and optimization
@@ -126,9 +129,14 @@ std::unique_ptr<OperationPass<FuncOp>> createCSEVariableLoadsPass();
 // Elides stateful command buffer ops that set redundant state.
 std::unique_ptr<OperationPass<void>> createElideRedundantCommandsPass();
 
+// Combines runs of command buffer commands with constant parameters into
+// hal.command_buffer.dispatch.batch ops that record them with a single call.
+std::unique_ptr<OperationPass<void>> createBatchDispatchCommandsPass();
+
 // Repeats dispatches `iree-hal-repeat-dispatch-num` times, which is 1 by
-// default.
-std::unique_ptr<OperationPass<FuncOp>> createBenchmarkBatchDispatchesPass(
+// default, and records the repeat count as the `batch_size` reflection
+// attribute of all exported functions.
+std::unique_ptr<OperationPass<ModuleOp>> createBenchmarkBatchDispatchesPass(
     unsigned repeatCount);
 
 //===----------------------------------------------------------------------===//
@@ -139,6 +147,7 @@ inline void registerHALPasses() {
   registerHALTransformPassPipeline();
   auto targetOptions = TargetOptions::FromFlags::get();
   createAssignTargetDevicesPass({});
+  createBatchDispatchCommandsPass();
   createBenchmarkBatchDispatchesPass(/*repeatCount=*/1);
   createConvertToHALPass();
   createElideRedundantCommandsPass();
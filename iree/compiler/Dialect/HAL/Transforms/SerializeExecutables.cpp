@@ -11,10 +11,18 @@
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetBackend.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/OperationSupport.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
 
@@ -23,14 +31,188 @@ namespace iree_compiler {
 namespace IREE {
 namespace HAL {
 
+//===----------------------------------------------------------------------===//
+// Executable binary cache
+//===----------------------------------------------------------------------===//
+
+// Cache entries are files named by the cache key containing the
+// hal.executable.binary ops produced when serializing the keyed variant:
+//   magic[8] version:u32 binary_count:u32
+//   binary_count * {
+//     sym_name:string format:string has_mime_type:u8 [mime_type:string]
+//     data_length:u64 data[data_length]
+//   }
+// Strings are encoded as length:u32 chars[length] and all integers are little
+// endian.
+static constexpr char kCacheEntryMagic[8] = {'I', 'R', 'E', 'E',
+                                             'X', 'B', 'I', 'N'};
+// Bump when changing the entry format or what is included in the cache key.
+static constexpr uint32_t kCacheEntryVersion = 1;
+
+// Returns the path of the cache entry for |variantOp| in |cacheDirectory|.
+// The key covers the backend and its options |fingerprint| along with the
+// full IR of the variant (including locations, which may be embedded as debug
+// information).
+static std::string getCacheEntryPath(StringRef cacheDirectory,
+                                     TargetBackend &targetBackend,
+                                     StringRef fingerprint,
+                                     IREE::HAL::ExecutableVariantOp variantOp) {
+  std::string keyData;
+  llvm::raw_string_ostream os(keyData);
+  os << kCacheEntryVersion << '\0' << targetBackend.name() << '\0'
+     << fingerprint << '\0'
+     << variantOp->getParentOfType<IREE::HAL::ExecutableOp>().getName()
+     << '\0';
+  variantOp->print(os, OpPrintingFlags().enableDebugInfo().useLocalScope());
+  os.flush();
+  llvm::SHA1 hasher;
+  hasher.update(keyData);
+  SmallString<256> path(cacheDirectory);
+  llvm::sys::path::append(path,
+                          llvm::toHex(hasher.final(), /*LowerCase=*/true));
+  return path.str().str();
+}
+
+// Recreates the hal.executable.binary ops cached at |entryPath| with
+// |executableBuilder|. Fails without creating any ops if the entry does not
+// exist or is malformed.
+static LogicalResult loadCachedBinaries(
+    StringRef entryPath, IREE::HAL::ExecutableVariantOp variantOp,
+    OpBuilder &executableBuilder) {
+  auto fileOr = llvm::MemoryBuffer::getFile(entryPath, /*IsText=*/false,
+                                            /*RequiresNullTerminator=*/false);
+  if (!fileOr) return failure();
+  StringRef remaining = fileOr.get()->getBuffer();
+
+  bool malformed = false;
+  auto readBytes = [&](uint64_t length) -> StringRef {
+    if (malformed || remaining.size() < length) {
+      malformed = true;
+      return {};
+    }
+    StringRef bytes = remaining.take_front(length);
+    remaining = remaining.drop_front(length);
+    return bytes;
+  };
+  auto readU32 = [&]() -> uint32_t {
+    StringRef bytes = readBytes(sizeof(uint32_t));
+    if (malformed) return 0;
+    return llvm::support::endian::read32le(bytes.data());
+  };
+  auto readU64 = [&]() -> uint64_t {
+    StringRef bytes = readBytes(sizeof(uint64_t));
+    if (malformed) return 0;
+    return llvm::support::endian::read64le(bytes.data());
+  };
+  auto readString = [&]() -> StringRef { return readBytes(readU32()); };
+
+  if (readBytes(sizeof(kCacheEntryMagic)) !=
+          StringRef(kCacheEntryMagic, sizeof(kCacheEntryMagic)) ||
+      readU32() != kCacheEntryVersion) {
+    return failure();
+  }
+  struct CachedBinary {
+    StringRef symName;
+    StringRef format;
+    Optional<StringRef> mimeType;
+    StringRef data;
+  };
+  // Each binary takes at least 17 bytes; this bounds the count before
+  // allocating storage for a potentially corrupt entry.
+  uint32_t binaryCount = readU32();
+  if (malformed || binaryCount > remaining.size() / 17) return failure();
+  SmallVector<CachedBinary> binaries(binaryCount);
+  for (auto &binary : binaries) {
+    binary.symName = readString();
+    binary.format = readString();
+    if (readBytes(1) == StringRef("\1", 1)) binary.mimeType = readString();
+    binary.data = readBytes(readU64());
+  }
+  if (malformed || !remaining.empty() || binaries.empty()) return failure();
+
+  for (auto &binary : binaries) {
+    auto binaryOp = executableBuilder.create<IREE::HAL::ExecutableBinaryOp>(
+        variantOp.getLoc(), binary.symName, binary.format,
+        std::vector<uint8_t>(binary.data.bytes_begin(),
+                             binary.data.bytes_end()));
+    if (binary.mimeType) {
+      binaryOp.mime_typeAttr(
+          executableBuilder.getStringAttr(binary.mimeType.getValue()));
+    }
+  }
+  return success();
+}
+
+// Writes |binaryOps| to the cache entry at |entryPath|. The entry is written
+// to a temporary file and renamed into place so that concurrent compilations
+// sharing the cache never observe partial entries. Failures only produce a
+// warning as the cache is an optimization.
+static void storeCachedBinaries(
+    StringRef entryPath, IREE::HAL::ExecutableVariantOp variantOp,
+    ArrayRef<IREE::HAL::ExecutableBinaryOp> binaryOps) {
+  if (binaryOps.empty()) return;
+  for (auto binaryOp : binaryOps) {
+    // Splats store a single element and are not worth special casing.
+    if (binaryOp.data().isSplat()) return;
+  }
+
+  SmallString<256> tempPath;
+  int tempFD = -1;
+  if (auto error = llvm::sys::fs::createUniqueFile(
+          entryPath + ".tmp-%%%%%%%%", tempFD, tempPath)) {
+    variantOp.emitWarning() << "failed to create executable cache entry "
+                            << entryPath << ": " << error.message();
+    return;
+  }
+  {
+    llvm::raw_fd_ostream os(tempFD, /*shouldClose=*/true);
+    llvm::support::endian::Writer writer(os, llvm::support::little);
+    auto writeString = [&](StringRef value) {
+      writer.write<uint32_t>(value.size());
+      os << value;
+    };
+    os.write(kCacheEntryMagic, sizeof(kCacheEntryMagic));
+    writer.write<uint32_t>(kCacheEntryVersion);
+    writer.write<uint32_t>(binaryOps.size());
+    for (auto binaryOp : binaryOps) {
+      writeString(binaryOp.sym_name());
+      writeString(binaryOp.format());
+      auto mimeType = binaryOp.mime_type();
+      writer.write<uint8_t>(mimeType.hasValue() ? 1 : 0);
+      if (mimeType.hasValue()) writeString(mimeType.getValue());
+      auto rawData = binaryOp.data().getRawData();
+      writer.write<uint64_t>(rawData.size());
+      os.write(rawData.data(), rawData.size());
+    }
+    os.close();
+    if (os.has_error()) {
+      variantOp.emitWarning() << "failed to write executable cache entry "
+                              << entryPath << ": " << os.error().message();
+      os.clear_error();
+      llvm::sys::fs::remove(tempPath);
+      return;
+    }
+  }
+  if (auto error = llvm::sys::fs::rename(tempPath, entryPath)) {
+    variantOp.emitWarning() << "failed to write executable cache entry "
+                            << entryPath << ": " << error.message();
+    llvm::sys::fs::remove(tempPath);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Serialization passes
+//===----------------------------------------------------------------------===//
+
 class SerializeTargetExecutablesPass
     : public PassWrapper<SerializeTargetExecutablesPass,
                          OperationPass<IREE::HAL::ExecutableOp>> {
  public:
   SerializeTargetExecutablesPass() = default;
   SerializeTargetExecutablesPass(const SerializeTargetExecutablesPass &pass) {}
-  SerializeTargetExecutablesPass(StringRef target) {
+  SerializeTargetExecutablesPass(StringRef target, StringRef cacheDirectory) {
     this->target = target.str();
+    this->cacheDirectory = cacheDirectory.str();
   }
 
   StringRef getArgument() const override {
@@ -58,11 +240,46 @@ class SerializeTargetExecutablesPass
       return signalPassFailure();
     }
 
+    // Binaries are only cached for backends that can fingerprint their
+    // options.
+    Optional<std::string> cacheFingerprint;
+    if (!cacheDirectory.empty()) {
+      cacheFingerprint = targetBackend->getSerializationCacheFingerprint();
+      if (cacheFingerprint) {
+        if (auto error = llvm::sys::fs::create_directories(cacheDirectory)) {
+          executableOp.emitWarning()
+              << "failed to create executable cache directory "
+              << cacheDirectory << ": " << error.message();
+          cacheFingerprint = llvm::None;
+        }
+      }
+    }
+
     auto variantOps = llvm::to_vector<4>(
         executableOp.getBlock().getOps<IREE::HAL::ExecutableVariantOp>());
     for (auto variantOp : variantOps) {
       if (variantOp.target().getBackend().getValue() != target) continue;
       OpBuilder executableBuilder(variantOp);
+
+      std::string cacheEntryPath;
+      if (cacheFingerprint) {
+        cacheEntryPath =
+            getCacheEntryPath(cacheDirectory, *targetBackend,
+                              cacheFingerprint.getValue(), variantOp);
+        if (succeeded(loadCachedBinaries(cacheEntryPath, variantOp,
+                                         executableBuilder))) {
+          variantOp.erase();
+          continue;
+        }
+      }
+
+      // Track the binaries that serialization produces so they can be cached.
+      llvm::SmallPtrSet<Operation *, 4> existingBinaryOps;
+      for (auto binaryOp :
+           executableOp.getBlock().getOps<IREE::HAL::ExecutableBinaryOp>()) {
+        existingBinaryOps.insert(binaryOp);
+      }
+
       // Ask the target backend to serialize the executable. Note that it
       // may create one or more hal.executable.binary ops in the case of
       // multi-architecture binaries.
@@ -72,6 +289,18 @@ class SerializeTargetExecutablesPass
             << "failed to serialize executable for target backend " << target;
         return signalPassFailure();
       }
+
+      if (!cacheEntryPath.empty()) {
+        SmallVector<IREE::HAL::ExecutableBinaryOp> newBinaryOps;
+        for (auto binaryOp :
+             executableOp.getBlock().getOps<IREE::HAL::ExecutableBinaryOp>()) {
+          if (!existingBinaryOps.contains(binaryOp)) {
+            newBinaryOps.push_back(binaryOp);
+          }
+        }
+        storeCachedBinaries(cacheEntryPath, variantOp, newBinaryOps);
+      }
+
       variantOp.erase();
     }
   }
@@ -82,11 +311,17 @@ class SerializeTargetExecutablesPass
       llvm::cl::desc(
           "Target backend name whose executables will be serialized by "
           "this pass.")};
+  Option<std::string> cacheDirectory{
+      *this, "cache-dir",
+      llvm::cl::desc("Directory used to cache serialized executable binaries "
+                     "across compilations.")};
 };
 
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableOp>>
-createSerializeTargetExecutablesPass(StringRef target) {
-  return std::make_unique<SerializeTargetExecutablesPass>(target);
+createSerializeTargetExecutablesPass(StringRef target,
+                                     StringRef cacheDirectory) {
+  return std::make_unique<SerializeTargetExecutablesPass>(target,
+                                                          cacheDirectory);
 }
 
 static PassRegistration<SerializeTargetExecutablesPass> linkTargetPass([] {
@@ -98,6 +333,10 @@ class SerializeExecutablesPass
                          OperationPass<IREE::HAL::ExecutableOp>> {
  public:
   SerializeExecutablesPass() = default;
+  SerializeExecutablesPass(const SerializeExecutablesPass &pass) {}
+  SerializeExecutablesPass(StringRef cacheDirectory) {
+    this->cacheDirectory = cacheDirectory.str();
+  }
 
   StringRef getArgument() const override {
     return "iree-hal-serialize-executables";
@@ -111,18 +350,25 @@ class SerializeExecutablesPass
     auto executableOp = getOperation();
     OpPassManager passManager(executableOp.getOperationName());
     for (const auto &targetName : gatherExecutableTargetNames(executableOp)) {
-      passManager.addPass(createSerializeTargetExecutablesPass(targetName));
+      passManager.addPass(
+          createSerializeTargetExecutablesPass(targetName, cacheDirectory));
     }
     if (failed(runPipeline(passManager, executableOp))) {
       executableOp.emitError() << "failed to serialize executables";
       return signalPassFailure();
     }
   }
+
+ private:
+  Option<std::string> cacheDirectory{
+      *this, "cache-dir",
+      llvm::cl::desc("Directory used to cache serialized executable binaries "
+                     "across compilations.")};
 };
 
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableOp>>
-createSerializeExecutablesPass() {
-  return std::make_unique<SerializeExecutablesPass>();
+createSerializeExecutablesPass(StringRef cacheDirectory) {
+  return std::make_unique<SerializeExecutablesPass>(cacheDirectory);
 }
 
 static PassRegistration<SerializeExecutablesPass> linkPass([] {
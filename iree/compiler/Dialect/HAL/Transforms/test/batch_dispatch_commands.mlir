@@ -0,0 +1,57 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-hal-batch-dispatch-commands)' %s | FileCheck %s
+
+// CHECK-LABEL: @batchConstantCommands
+// CHECK-SAME: (%[[CMD:.+]]: !hal.command_buffer, %[[LAYOUT:.+]]: !hal.executable_layout, %[[BUFFER:.+]]: !hal.buffer, %[[EXE:.+]]: !hal.executable)
+func @batchConstantCommands(%cmd: !hal.command_buffer, %layout: !hal.executable_layout, %buffer: !hal.buffer, %exe: !hal.executable) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %c16 = arith.constant 16 : index
+  %c7_i32 = arith.constant 7 : i32
+  // CHECK-NOT: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)
+      offset(0)
+      values([%c7_i32]) : i32
+  // CHECK-NOT: hal.command_buffer.push_descriptor_set
+  hal.command_buffer.push_descriptor_set<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)[%c0]
+      bindings([
+        %c0 = (%buffer : !hal.buffer)[%c0, %c16]
+      ])
+  // CHECK-NOT: hal.command_buffer.dispatch<
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer> target(%exe : !hal.executable)[1] workgroups([%c4, %c1, %c1])
+  // CHECK-NOT: hal.command_buffer.execution_barrier
+  hal.command_buffer.execution_barrier<%cmd : !hal.command_buffer> source("Dispatch|CommandRetire") target("CommandIssue|Dispatch") flags("None")
+  // CHECK: %[[COMMANDS:.+]] = util.byte_buffer.constant {alignment = 4 : i64} : !util.byte_buffer = dense<[
+  // CHECK-SAME: 1, 0, 0, 1, 7,
+  // CHECK-SAME: 2, 0, 0, 1, 0, 1, 0, 16,
+  // CHECK-SAME: 3, 2, 1, 4, 1, 1,
+  // CHECK-SAME: 0, 20, 5, 0
+  // CHECK-SAME: ]> : vector<23xi32>
+  // CHECK: hal.command_buffer.dispatch.batch<%[[CMD]] : !hal.command_buffer>
+  // CHECK-SAME: commands(%[[COMMANDS]] : !util.byte_buffer)
+  // CHECK-SAME: resources([%[[LAYOUT]], %[[BUFFER]], %[[EXE]]])
+  // CHECK-SAME: : !hal.executable_layout, !hal.buffer, !hal.executable
+  return
+}
+
+// -----
+
+// Commands with dynamic parameters split batches and are recorded directly.
+
+// CHECK-LABEL: @dynamicCommandSplitsBatch
+// CHECK-SAME: (%[[CMD:.+]]: !hal.command_buffer, %[[EXE:.+]]: !hal.executable, %[[DIM:.+]]: index)
+func @dynamicCommandSplitsBatch(%cmd: !hal.command_buffer, %exe: !hal.executable, %dim: index) {
+  %c1 = arith.constant 1 : index
+  // CHECK: hal.command_buffer.dispatch.batch<%[[CMD]] : !hal.command_buffer>
+  // CHECK-SAME: resources([%[[EXE]]])
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer> target(%exe : !hal.executable)[0] workgroups([%c1, %c1, %c1])
+  hal.command_buffer.execution_barrier<%cmd : !hal.command_buffer> source("Dispatch|CommandRetire") target("CommandIssue|Dispatch") flags("None")
+  // CHECK-NEXT: hal.command_buffer.dispatch<%[[CMD]] : !hal.command_buffer> target(%[[EXE]] : !hal.executable)[1] workgroups([%[[DIM]], %c1, %c1])
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer> target(%exe : !hal.executable)[1] workgroups([%dim, %c1, %c1])
+  // CHECK-NEXT: hal.command_buffer.execution_barrier
+  hal.command_buffer.execution_barrier<%cmd : !hal.command_buffer> source("Dispatch|CommandRetire") target("CommandIssue|Dispatch") flags("None")
+  // CHECK-NEXT: return
+  return
+}
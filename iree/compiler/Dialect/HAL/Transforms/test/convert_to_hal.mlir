@@ -116,7 +116,8 @@ module attributes {hal.device.targets = [#device_target_cpu]}  {
     // CHECK: hal.command_buffer.end<%[[CMD]] : !hal.command_buffer>
     } => !stream.timepoint
 
-    // CHECK: hal.ex.submit_and_wait %[[DEVICE]], %[[CMD]]
+    // CHECK: hal.ex.submit_and_wait %[[DEVICE]], %[[CMD]] wait(%{{.+}})
+    // CHECK-NOT: hal.ex.submit_await
     %result_ready = stream.timepoint.await %timepoint => %result_resource : !stream.resource<external>{%c16}
 
     // CHECK: %[[RESULT_VIEW:.+]] = hal.buffer_view.create
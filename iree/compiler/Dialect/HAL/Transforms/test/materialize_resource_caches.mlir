@@ -170,3 +170,97 @@ func @exeLookup(%device : !hal.device) -> !hal.executable {
 }
 
 }
+
+// -----
+
+#executable_layout_0 = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+
+module attributes {hal.device.targets = [#hal.device.target<"cpu">]} {
+
+// Variants specialized for processor features are selected only if the device
+// supports them and otherwise fall back to the baseline variant.
+hal.executable @exe {
+  hal.executable.variant @embedded_elf_x86_64_avx512, target = <"llvm", "embedded-elf-x86_64", {
+    device_features = ["x86_64.avx512"]
+  }> {
+    hal.executable.entry_point @entry0 ordinal(0) layout(#executable_layout_0)
+  }
+  hal.executable.variant @embedded_elf_x86_64, target = <"llvm", "embedded-elf-x86_64"> {
+    hal.executable.entry_point @entry0 ordinal(0) layout(#executable_layout_0)
+  }
+}
+
+// CHECK: util.global private @_executable_exe : !hal.executable
+// CHECK-NEXT: util.initializer {
+// CHECK:   %[[DEV:.+]] = hal.ex.shared_device : !hal.device
+// CHECK:   %[[RET:.+]] = hal.device.switch<%[[DEV]] : !hal.device> -> !hal.executable
+// CHECK:   #hal.match.all<[#hal.device.match.executable.format<"embedded-elf-x86_64">, #hal.device.match.feature<"x86_64.avx512">]> {
+// CHECK:     %[[EXE_AVX512:.+]] = hal.executable.create
+// CHECK-SAME:  target(@exe::@embedded_elf_x86_64_avx512)
+// CHECK:     hal.return %[[EXE_AVX512]] : !hal.executable
+// CHECK:   },
+// CHECK:   #hal.device.match.executable.format<"embedded-elf-x86_64"> {
+// CHECK:     %[[EXE:.+]] = hal.executable.create
+// CHECK-SAME:  target(@exe::@embedded_elf_x86_64)
+// CHECK:     hal.return %[[EXE]] : !hal.executable
+// CHECK:   },
+
+}
+
+// -----
+
+#executable_layout_0 = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+
+module attributes {hal.device.targets = [#hal.device.target<"cpu">]} {
+
+// Executables looked up on devices other than the shared device are created
+// on those devices along with their layouts.
+hal.executable @exe {
+  hal.executable.variant @vmvx, target = <"vmvx", "vmvx-bytecode-fb"> {
+    hal.executable.entry_point @entry0 ordinal(0) layout(#executable_layout_0)
+  }
+}
+
+// CHECK: util.global private @_executable_exe : !hal.executable
+
+// CHECK: util.global private @_descriptor_set_layout_1 : !hal.descriptor_set_layout
+// CHECK-NEXT: util.initializer {
+// CHECK-NEXT:   %[[ORDINAL:.+]] = arith.constant 1 : index
+// CHECK-NEXT:   %[[DEVICE:.+]] = hal.ex.device[%[[ORDINAL]]] : !hal.device
+// CHECK-NEXT:   hal.descriptor_set_layout.create device(%[[DEVICE]] : !hal.device)
+
+// CHECK: util.global private @_executable_layout_1 : !hal.executable_layout
+// CHECK: hal.executable_layout.create
+
+// CHECK: util.global private @_executable_exe_device1 : !hal.executable
+// CHECK-NEXT: util.initializer {
+// CHECK:   %[[DEV:.+]] = hal.ex.device[%{{.+}}] : !hal.device
+// CHECK:   hal.device.switch<%[[DEV]] : !hal.device> -> !hal.executable
+// CHECK:     %[[LAYOUT:.+]] = util.global.load @_executable_layout_1 : !hal.executable_layout
+// CHECK:     hal.executable.create
+// CHECK-SAME:  device(%[[DEV]] : !hal.device)
+// CHECK-SAME:  layouts([%[[LAYOUT]]])
+
+// CHECK-LABEL: @exeLookupOnDevice
+func @exeLookupOnDevice() -> (!hal.executable, !hal.executable) {
+  %c1 = arith.constant 1 : index
+  %device0 = hal.ex.shared_device : !hal.device
+  %device1 = hal.ex.device[%c1] : !hal.device
+  // CHECK: util.global.load @_executable_exe : !hal.executable
+  %0 = hal.executable.lookup device(%device0 : !hal.device)
+                             executable(@exe) : !hal.executable
+  // CHECK: util.global.load @_executable_exe_device1 : !hal.executable
+  %1 = hal.executable.lookup device(%device1 : !hal.device)
+                             executable(@exe) : !hal.executable
+  return %0, %1 : !hal.executable, !hal.executable
+}
+
+}
@@ -0,0 +1,114 @@
+// RUN: iree-opt -split-input-file -iree-hal-materialize-resource-caches -iree-hal-cache-static-command-buffers %s | FileCheck %s
+
+#executable_layout_0 = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+
+module attributes {hal.device.targets = [#hal.device.target<"cpu">]} {
+
+hal.executable @exe {
+  hal.executable.variant @vmvx, target = <"vmvx", "vmvx-bytecode-fb"> {
+    hal.executable.entry_point @entry0 ordinal(0) layout(#executable_layout_0) attributes {
+      workgroup_size = [32 : index, 1 : index, 1 : index]
+    }
+  }
+}
+
+util.global private @constant_buffer : !hal.buffer
+util.initializer {
+  %c16 = arith.constant 16 : index
+  %device = hal.ex.shared_device : !hal.device
+  %allocator = hal.device.allocator<%device : !hal.device> : !hal.allocator
+  %buffer = hal.allocator.allocate<%allocator : !hal.allocator>
+      type(DeviceLocal) usage(Dispatch) : !hal.buffer{%c16}
+  util.global.store %buffer, @constant_buffer : !hal.buffer
+  util.initializer.return
+}
+
+// Command buffers that only reference constants and immutable globals are
+// recorded once during initialization and loaded from a global on each call.
+
+// CHECK-LABEL: @staticCommandBuffer
+func @staticCommandBuffer() {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c16 = arith.constant 16 : index
+  %device = hal.ex.shared_device : !hal.device
+  %buffer = util.global.load @constant_buffer : !hal.buffer
+  // CHECK: %[[CMD:.+]] = util.global.load @_command_buffer_0 : !hal.command_buffer
+  // CHECK-NOT: hal.command_buffer.begin
+  %cmd = hal.command_buffer.create device(%device : !hal.device) mode("OneShot|AllowInlineExecution") categories("Transfer|Dispatch") : !hal.command_buffer
+  hal.command_buffer.begin<%cmd : !hal.command_buffer>
+  %layout = hal.executable_layout.lookup device(%device : !hal.device)
+                                         layout(#executable_layout_0) : !hal.executable_layout
+  hal.command_buffer.push_descriptor_set<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)[%c0]
+      bindings([
+        %c0 = (%buffer : !hal.buffer)[%c0, %c16]
+      ])
+  %exe = hal.executable.lookup device(%device : !hal.device)
+                               executable(@exe) : !hal.executable
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer> target(%exe : !hal.executable)[0] workgroups([%c1, %c1, %c1])
+  hal.command_buffer.end<%cmd : !hal.command_buffer>
+  // CHECK: hal.ex.submit_and_wait %{{.+}}, %[[CMD]] wait(%{{.+}})
+  hal.ex.submit_and_wait %device, %cmd wait(%c0)
+  return
+}
+
+// Command buffers capturing dynamic values must be recorded on each call.
+
+// CHECK-LABEL: @dynamicCommandBuffer
+func @dynamicCommandBuffer(%buffer: !hal.buffer) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c16 = arith.constant 16 : index
+  %device = hal.ex.shared_device : !hal.device
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  // CHECK-SAME: mode("OneShot|AllowInlineExecution")
+  %cmd = hal.command_buffer.create device(%device : !hal.device) mode("OneShot|AllowInlineExecution") categories("Transfer|Dispatch") : !hal.command_buffer
+  // CHECK: hal.command_buffer.begin<%[[CMD]] : !hal.command_buffer>
+  hal.command_buffer.begin<%cmd : !hal.command_buffer>
+  %layout = hal.executable_layout.lookup device(%device : !hal.device)
+                                         layout(#executable_layout_0) : !hal.executable_layout
+  // CHECK: hal.command_buffer.push_descriptor_set<%[[CMD]] : !hal.command_buffer>
+  hal.command_buffer.push_descriptor_set<%cmd : !hal.command_buffer>
+      layout(%layout : !hal.executable_layout)[%c0]
+      bindings([
+        %c0 = (%buffer : !hal.buffer)[%c0, %c16]
+      ])
+  %exe = hal.executable.lookup device(%device : !hal.device)
+                               executable(@exe) : !hal.executable
+  // CHECK: hal.command_buffer.dispatch<%[[CMD]] : !hal.command_buffer>
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer> target(%exe : !hal.executable)[0] workgroups([%c1, %c1, %c1])
+  // CHECK: hal.command_buffer.end<%[[CMD]] : !hal.command_buffer>
+  hal.command_buffer.end<%cmd : !hal.command_buffer>
+  // CHECK: hal.ex.submit_and_wait %{{.+}}, %[[CMD]] wait(%{{.+}})
+  hal.ex.submit_and_wait %device, %cmd wait(%c0)
+  return
+}
+
+// The cached command buffer is recorded in an initializer at the end of the
+// module such that all referenced globals have been initialized.
+
+// CHECK: util.global private @_command_buffer_0 : !hal.command_buffer
+// CHECK-NEXT: util.initializer {
+// CHECK-DAG:   %[[DEVICE:.+]] = hal.ex.shared_device : !hal.device
+// CHECK-DAG:   %[[BUFFER:.+]] = util.global.load @constant_buffer : !hal.buffer
+// CHECK:       %[[CMD:.+]] = hal.command_buffer.create device(%[[DEVICE]] : !hal.device)
+// CHECK-SAME:    mode(None)
+// CHECK-SAME:    categories("Transfer|Dispatch")
+// CHECK:       hal.command_buffer.begin<%[[CMD]] : !hal.command_buffer>
+// CHECK:       %[[LAYOUT:.+]] = util.global.load @_executable_layout_0 : !hal.executable_layout
+// CHECK:       hal.command_buffer.push_descriptor_set<%[[CMD]] : !hal.command_buffer>
+// CHECK-SAME:    layout(%[[LAYOUT]] : !hal.executable_layout)
+// CHECK:         = (%[[BUFFER]] : !hal.buffer)
+// CHECK:       %[[EXE:.+]] = util.global.load @_executable_exe : !hal.executable
+// CHECK:       hal.command_buffer.dispatch<%[[CMD]] : !hal.command_buffer> target(%[[EXE]] : !hal.executable)[0]
+// CHECK:       hal.command_buffer.end<%[[CMD]] : !hal.command_buffer>
+// CHECK:       util.global.store %[[CMD]], @_command_buffer_0 : !hal.command_buffer
+// CHECK-NEXT:  util.initializer.return
+// CHECK-NEXT: }
+
+}
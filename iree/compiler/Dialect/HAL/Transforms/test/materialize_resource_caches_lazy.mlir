@@ -0,0 +1,50 @@
+// RUN: iree-opt -split-input-file -iree-hal-materialize-resource-caches -iree-hal-lazy-executable-creation %s | FileCheck %s
+
+#executable_layout_0 = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+
+module attributes {hal.device.targets = [#hal.device.target<"cpu">]} {
+
+hal.executable @exe {
+  hal.executable.variant @vmvx, target = <"vmvx", "vmvx-bytecode-fb"> {
+    hal.executable.entry_point @entry0 ordinal(0) layout(#executable_layout_0) attributes {
+      workgroup_size = [32 : index, 1 : index, 1 : index]
+    }
+  }
+}
+
+// Executables are not created during initialization but instead on the first
+// lookup and cached for subsequent ones.
+
+// CHECK: util.global private mutable @_executable_exe : !hal.executable
+// CHECK-NOT: util.initializer
+// CHECK: func private @_executable_exe_lookup() -> !hal.executable {
+// CHECK:   %[[CACHED:.+]] = util.global.load @_executable_exe : !hal.executable
+// CHECK:   %[[NULL:.+]] = util.null : !hal.executable
+// CHECK:   %[[IS_NULL:.+]] = util.cmp.eq %[[CACHED]], %[[NULL]] : !hal.executable
+// CHECK:   cf.cond_br %[[IS_NULL]], ^bb1, ^bb2(%[[CACHED]] : !hal.executable)
+// CHECK: ^bb1:
+// CHECK:   %[[DEV:.+]] = hal.ex.shared_device : !hal.device
+// CHECK:   %[[RET:.+]] = hal.device.switch<%[[DEV]] : !hal.device> -> !hal.executable
+// CHECK:     hal.executable.create
+// CHECK-SAME:  target(@exe::@vmvx)
+// CHECK:   util.global.store %[[RET]], @_executable_exe : !hal.executable
+// CHECK:   cf.br ^bb2(%[[RET]] : !hal.executable)
+// CHECK: ^bb2(%[[EXE:.+]]: !hal.executable):
+// CHECK:   return %[[EXE]] : !hal.executable
+// CHECK: }
+
+// CHECK-LABEL: @exeLookup
+func @exeLookup(%device : !hal.device) -> !hal.executable {
+  // CHECK: %[[EXE:.+]] = call @_executable_exe_lookup() : () -> !hal.executable
+  %0 = hal.executable.lookup device(%device : !hal.device)
+                             executable(@exe) : !hal.executable
+  // CHECK-NEXT: return %[[EXE]]
+  return %0 : !hal.executable
+}
+
+}
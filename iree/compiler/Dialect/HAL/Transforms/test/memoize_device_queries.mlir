@@ -36,3 +36,28 @@ func @device_matchers(%device : !hal.device) -> (i1, i1, i1, i1, i1, i1) {
 
   return %id0_a_ok, %id0_a, %id0_b_ok, %id0_b, %id1_a, %id1_b : i1, i1, i1, i1, i1, i1
 }
+
+// -----
+
+// Queries are memoized per device.
+
+//      CHECK: util.global private @_device_query_0 : i1
+//      CHECK:   %[[DEVICE0:.+]] = hal.ex.shared_device : !hal.device
+// CHECK-NEXT:   hal.device.query<%[[DEVICE0]] : !hal.device> key("hal.device.id" :: "cpu*")
+
+//      CHECK: util.global private @_device_query_1 : i1
+//      CHECK:   %[[ORDINAL:.+]] = arith.constant 1 : index
+// CHECK-NEXT:   %[[DEVICE1:.+]] = hal.ex.device[%[[ORDINAL]]] : !hal.device
+// CHECK-NEXT:   hal.device.query<%[[DEVICE1]] : !hal.device> key("hal.device.id" :: "cpu*")
+
+// CHECK-LABEL: func @per_device_matchers
+func @per_device_matchers() -> (i1, i1) {
+  %c1 = arith.constant 1 : index
+  %device0 = hal.ex.shared_device : !hal.device
+  %device1 = hal.ex.device[%c1] : !hal.device
+  // CHECK: = util.global.load @_device_query_0 : i1
+  %ok0, %value0 = hal.device.query<%device0 : !hal.device> key("hal.device.id" :: "cpu*") : i1, i1 = false
+  // CHECK: = util.global.load @_device_query_1 : i1
+  %ok1, %value1 = hal.device.query<%device1 : !hal.device> key("hal.device.id" :: "cpu*") : i1, i1 = false
+  return %value0, %value1 : i1, i1
+}
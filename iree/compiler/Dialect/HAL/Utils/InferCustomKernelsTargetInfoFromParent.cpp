@@ -8,25 +8,16 @@
 
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
 #include "iree/compiler/Utils/CustomKernelsTargetInfo.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 
 namespace mlir {
 namespace iree_compiler {
 
-LogicalResult InferCustomKernelsTargetInfoFromParent(
-    FuncOp entryPointFn, CustomKernelsTargetInfo &target_info) {
-  // Set the out-value to defaults early so that early returns produce
-  // consistent results and so that we can write simpler code below
-  // (for loop OR-ing booleans, assuming initial 'false' value).
+static LogicalResult InferCustomKernelsTargetInfoFromTarget(
+    IREE::HAL::ExecutableTargetAttr targetAttr,
+    CustomKernelsTargetInfo &target_info) {
   target_info = CustomKernelsTargetInfo();
-
-  // Try to find the parent ExecutableVariantOp and its relevant attributes.
-  auto variantOp =
-      entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
-  if (!variantOp) {
-    return failure();
-  }
-  IREE::HAL::ExecutableTargetAttr targetAttr = variantOp.target();
   if (!targetAttr) {
     return failure();
   }
@@ -50,5 +41,45 @@ LogicalResult InferCustomKernelsTargetInfoFromParent(
   return ParseCustomKernelsTargetInfo(archName, featuresStr, target_info);
 }
 
+LogicalResult InferCustomKernelsTargetInfoFromParent(
+    FuncOp entryPointFn, CustomKernelsTargetInfo &target_info) {
+  // Set the out-value to defaults early so that early returns produce
+  // consistent results and so that we can write simpler code below
+  // (for loop OR-ing booleans, assuming initial 'false' value).
+  target_info = CustomKernelsTargetInfo();
+
+  // Try to find the parent ExecutableVariantOp and its relevant attributes.
+  auto variantOp =
+      entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  if (!variantOp) {
+    return failure();
+  }
+  return InferCustomKernelsTargetInfoFromTarget(variantOp.target(),
+                                                target_info);
+}
+
+LogicalResult InferCustomKernelsTargetInfoFromDeviceTargets(
+    Operation *op, CustomKernelsTargetInfo &target_info) {
+  target_info = CustomKernelsTargetInfo();
+  auto targetAttrs = IREE::HAL::DeviceTargetAttr::lookupExecutableTargets(op);
+  if (targetAttrs.empty()) {
+    return failure();
+  }
+  for (auto targetAttr : llvm::enumerate(targetAttrs)) {
+    CustomKernelsTargetInfo info;
+    if (failed(InferCustomKernelsTargetInfoFromTarget(targetAttr.value(),
+                                                      info))) {
+      target_info = CustomKernelsTargetInfo();
+      return failure();
+    }
+    if (targetAttr.index() == 0) {
+      target_info = info;
+    } else {
+      target_info.intersect(info);
+    }
+  }
+  return success();
+}
+
 }  // namespace iree_compiler
 }  // namespace mlir
@@ -21,6 +21,13 @@ namespace iree_compiler {
 LogicalResult InferCustomKernelsTargetInfoFromParent(
     FuncOp entryPointFn, CustomKernelsTargetInfo &target_info);
 
+// Infers the target info common to all executable targets of the devices
+// specified in the `hal.device.targets` of |op| (or its ancestors). Fails if
+// no devices are specified or any of their executable targets lacks the
+// information, such as for non-CPU targets.
+LogicalResult InferCustomKernelsTargetInfoFromDeviceTargets(
+    Operation *op, CustomKernelsTargetInfo &target_info);
+
 }  // namespace iree_compiler
 }  // namespace mlir
 
@@ -11,11 +11,31 @@ vm.module @hal {
 vm.import @ex.shared_device() -> !vm.ref<!hal.device>
 attributes {nosideeffects}
 
+vm.import @ex.device(
+  %ordinal : i32
+) -> !vm.ref<!hal.device>
+attributes {nosideeffects}
+
+vm.import @ex.submit(
+  %device : !vm.ref<!hal.device>,
+  %command_buffer : !vm.ref<!hal.command_buffer>,
+  %wait_value : i32
+) -> i32
+
 vm.import @ex.submit_and_wait(
   %device : !vm.ref<!hal.device>,
-  %command_buffer : !vm.ref<!hal.command_buffer>
+  %command_buffer : !vm.ref<!hal.command_buffer>,
+  %wait_value : i32
+)
+
+vm.import @ex.submit_await(
+  %timeline_value : i32
 )
 
+vm.import @ex.submit_timeline(
+  %timeline_value : i32
+) -> (!vm.ref<!hal.semaphore>, i32)
+
 //===----------------------------------------------------------------------===//
 // iree_hal_allocator_t
 //===----------------------------------------------------------------------===//
@@ -270,6 +290,15 @@ vm.import @command_buffer.dispatch.indirect(
   %workgroups_offset : i32
 )
 
+// Records the sequence of commands encoded in |commands|. Resources used by the
+// commands are referenced by their ordinal in |resources|.
+// See iree/modules/hal/module.c for the command encoding.
+vm.import @command_buffer.dispatch.batch(
+  %command_buffer : !vm.ref<!hal.command_buffer>,
+  %commands : !vm.buffer,
+  %resources : !vm.ref<?> ...
+)
+
 //===----------------------------------------------------------------------===//
 // iree_hal_descriptor_set_t
 //===----------------------------------------------------------------------===//
@@ -314,6 +343,22 @@ vm.import @device.query.i32(
 ) -> (i32, i32)
 attributes {nosideeffects}
 
+// Allocates a transient buffer ordered with the work submitted to the device.
+// The buffer may reuse memory returned with @device.queue.dealloca.
+vm.import @device.queue.alloca(
+  %device : !vm.ref<!hal.device>,
+  %memory_types : i32,
+  %buffer_usage : i32,
+  %allocation_size : i32
+) -> !vm.ref<!hal.buffer>
+
+// Returns a transient buffer allocated with @device.queue.alloca to the device
+// for reuse by subsequent allocations.
+vm.import @device.queue.dealloca(
+  %device : !vm.ref<!hal.device>,
+  %buffer : !vm.ref<!hal.buffer>
+)
+
 //===----------------------------------------------------------------------===//
 // iree_hal_executable_t
 //===----------------------------------------------------------------------===//
@@ -49,13 +49,12 @@ class VMVXImportOpConversion : public OpConversionPattern<T> {
  public:
   VMVXImportOpConversion(MLIRContext *context, SymbolTable &importSymbols,
                          TypeConverter &typeConverter, StringRef importName)
-      : OpConversionPattern<T>(context),
+      : OpConversionPattern<T>(typeConverter, context),
         importSymbols(importSymbols),
-        typeConverter(typeConverter),
         importName(importName) {}
 
   LogicalResult matchAndRewrite(
-      T op, llvm::ArrayRef<Value> operands,
+      T op, typename T::Adaptor adaptor,
       ConversionPatternRewriter &rewriter) const override {
     std::string importFqName = importName + getImportSuffix(op);
     auto importOp =
@@ -65,8 +64,8 @@ class VMVXImportOpConversion : public OpConversionPattern<T> {
                      << importFqName;
       return failure();
     }
-    auto results =
-        rewriteToCall(op, Adaptor{operands}, importOp, typeConverter, rewriter);
+    auto results = rewriteToCall(op, adaptor, importOp,
+                                 *this->getTypeConverter(), rewriter);
     if (!results.hasValue()) return failure();
     rewriter.replaceOp(op, results.getValue());
     return success();
@@ -108,19 +107,53 @@ class VMVXImportOpConversion : public OpConversionPattern<T> {
 
  private:
   SymbolTable &importSymbols;
-  TypeConverter &typeConverter;
   std::string importName;
 };
 #define VMVX_IMPORT_OP(op_type, op_mnemonic)        \
   patterns.insert<VMVXImportOpConversion<op_type>>( \
       context, importSymbols, typeConverter, op_mnemonic);
 
+// Selects the import by the bit width of the elements: `.x32`.
+template <typename T>
+class VMVXSizedImportOpConversion : public VMVXImportOpConversion<T> {
+ public:
+  using VMVXImportOpConversion<T>::VMVXImportOpConversion;
+
+ protected:
+  std::string getImportSuffix(T op) const override {
+    return "." + this->getSizedTypeStr(op.getElementType());
+  }
+};
+
+// Selects the import by the type of the elements: `.f32`.
+template <typename T>
+class VMVXTypedImportOpConversion : public VMVXImportOpConversion<T> {
+ public:
+  using VMVXImportOpConversion<T>::VMVXImportOpConversion;
+
+ protected:
+  std::string getImportSuffix(T op) const override {
+    return "." + this->getTypedTypeStr(op.getElementType());
+  }
+};
+
 }  // namespace
 
 void populateVMVXToVMPatterns(MLIRContext *context,
                               TypeConverter &typeConverter,
                               SymbolTable &importSymbols,
-                              RewritePatternSet &patterns) {}
+                              RewritePatternSet &patterns) {
+  patterns.insert<VMVXSizedImportOpConversion<IREE::VMVX::CopyOp>>(
+      context, importSymbols, typeConverter, "vmvx.copy.2d");
+  patterns.insert<VMVXSizedImportOpConversion<IREE::VMVX::FillOp>>(
+      context, importSymbols, typeConverter, "vmvx.fill.2d");
+  patterns.insert<VMVXTypedImportOpConversion<IREE::VMVX::AddOp>>(
+      context, importSymbols, typeConverter, "vmvx.add.2d");
+  patterns.insert<VMVXTypedImportOpConversion<IREE::VMVX::MulOp>>(
+      context, importSymbols, typeConverter, "vmvx.mul.2d");
+  VMVX_IMPORT_OP(IREE::VMVX::ExpOp, "vmvx.exp.2d.f32");
+  VMVX_IMPORT_OP(IREE::VMVX::MatmulOp, "vmvx.matmul.f32f32f32");
+}
 
 }  // namespace iree_compiler
 }  // namespace mlir
@@ -10,6 +10,7 @@
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/SMLoc.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/OpImplementation.h"
@@ -21,7 +22,54 @@ namespace iree_compiler {
 namespace IREE {
 namespace VMVX {
 
-// (ops go here)
+//===----------------------------------------------------------------------===//
+// 2D strided microkernels
+//===----------------------------------------------------------------------===//
+
+// Folds memref.cast ops producing the buffer operands of |op|. The ops only
+// access the regions they are given and ignore the shapes of the buffers.
+static LogicalResult foldBufferCasts(Operation *op) {
+  bool folded = false;
+  for (OpOperand &operand : op->getOpOperands()) {
+    auto castOp = operand.get().getDefiningOp<memref::CastOp>();
+    if (!castOp) continue;
+    auto sourceType = castOp.source().getType().dyn_cast<MemRefType>();
+    if (!sourceType || sourceType.getRank() != 1) continue;
+    operand.set(castOp.source());
+    folded = true;
+  }
+  return success(folded);
+}
+
+LogicalResult CopyOp::fold(ArrayRef<Attribute> operands,
+                           SmallVectorImpl<OpFoldResult> &results) {
+  return foldBufferCasts(*this);
+}
+
+LogicalResult FillOp::fold(ArrayRef<Attribute> operands,
+                           SmallVectorImpl<OpFoldResult> &results) {
+  return foldBufferCasts(*this);
+}
+
+LogicalResult AddOp::fold(ArrayRef<Attribute> operands,
+                          SmallVectorImpl<OpFoldResult> &results) {
+  return foldBufferCasts(*this);
+}
+
+LogicalResult MulOp::fold(ArrayRef<Attribute> operands,
+                          SmallVectorImpl<OpFoldResult> &results) {
+  return foldBufferCasts(*this);
+}
+
+LogicalResult ExpOp::fold(ArrayRef<Attribute> operands,
+                          SmallVectorImpl<OpFoldResult> &results) {
+  return foldBufferCasts(*this);
+}
+
+LogicalResult MatmulOp::fold(ArrayRef<Attribute> operands,
+                             SmallVectorImpl<OpFoldResult> &results) {
+  return foldBufferCasts(*this);
+}
 
 }  // namespace VMVX
 }  // namespace IREE
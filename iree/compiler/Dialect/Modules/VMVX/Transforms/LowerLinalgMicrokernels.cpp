@@ -0,0 +1,468 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- LowerLinalgMicrokernels.cpp ----------------------------------------===//
+//
+// Lowers linalg ops with buffer semantics that match one of the VMVX
+// microkernels to the corresponding VMVX op instead of scalar loops. The
+// operands of the linalg ops must be (subviews of) identity layout buffers
+// with at most two dimensions so that they can be described as strided regions
+// of the flattened buffers:
+//
+//   region = {buffer, offset, [stride0, stride1], [size0, size1]}
+//
+// Ops that don't match are left untouched for the loop lowerings.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/Modules/VMVX/IR/VMVXDialect.h"
+#include "iree/compiler/Dialect/Modules/VMVX/IR/VMVXOps.h"
+#include "iree/compiler/Dialect/Modules/VMVX/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/TypeUtilities.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassRegistry.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace VMVX {
+
+namespace {
+
+// A strided region of a flattened buffer. Offsets and strides are in elements
+// and there is one stride and size per dimension of the original memref.
+struct StridedRegion {
+  Value buffer;
+  Value offset;
+  SmallVector<Value, 2> strides;
+  SmallVector<Value, 2> sizes;
+};
+
+}  // namespace
+
+static bool isConstantOne(OpFoldResult value) {
+  if (auto attr = value.dyn_cast<Attribute>()) {
+    return attr.cast<IntegerAttr>().getInt() == 1;
+  }
+  return matchPattern(value.get<Value>(), m_One());
+}
+
+static Value getIndexValue(OpBuilder &builder, Location loc,
+                           OpFoldResult value) {
+  if (auto attr = value.dyn_cast<Attribute>()) {
+    return builder.createOrFold<arith::ConstantIndexOp>(
+        loc, attr.cast<IntegerAttr>().getInt());
+  }
+  return value.get<Value>();
+}
+
+// Returns the identity layout buffer of rank 1 or 2 that |memref| is a chain of
+// |subviewOps| of, innermost first, or null if there is none or the dynamic
+// dimensions of the buffer are not known.
+static Value getRegionBase(Value memref,
+                           SmallVectorImpl<memref::SubViewOp> &subviewOps) {
+  Value base = memref;
+  while (auto subviewOp = base.getDefiningOp<memref::SubViewOp>()) {
+    if (subviewOp.getSourceType().getRank() != subviewOp.getType().getRank()) {
+      return Value();
+    }
+    subviewOps.push_back(subviewOp);
+    base = subviewOp.source();
+  }
+  auto baseType = base.getType().dyn_cast<MemRefType>();
+  if (!baseType || !baseType.getLayout().isIdentity() ||
+      baseType.getRank() < 1 || baseType.getRank() > 2) {
+    return Value();
+  }
+  if (baseType.getNumDynamicDims() != 0 &&
+      !isa_and_nonnull<IREE::HAL::InterfaceBindingSubspanOp, memref::AllocaOp,
+                       memref::AllocOp>(base.getDefiningOp())) {
+    return Value();
+  }
+  return base;
+}
+
+static bool hasStridedRegion(Value memref) {
+  SmallVector<memref::SubViewOp> subviewOps;
+  return static_cast<bool>(getRegionBase(memref, subviewOps));
+}
+
+// Returns true if the innermost dimension of the region of |memref| is
+// contiguous. Expects that |memref| has a strided region.
+static bool hasUnitInnerStride(Value memref) {
+  SmallVector<memref::SubViewOp> subviewOps;
+  Value base = getRegionBase(memref, subviewOps);
+  int64_t innerDim = base.getType().cast<MemRefType>().getRank() - 1;
+  return llvm::all_of(subviewOps, [&](memref::SubViewOp subviewOp) {
+    return isConstantOne(subviewOp.getMixedStrides()[innerDim]);
+  });
+}
+
+// Returns the dimensions of |base|. Expects that |base| is a region base.
+static SmallVector<Value, 2> getBaseDims(OpBuilder &builder, Location loc,
+                                         Value base) {
+  auto baseType = base.getType().cast<MemRefType>();
+  ValueRange dynamicDims;
+  Operation *baseOp = base.getDefiningOp();
+  if (auto subspanOp =
+          dyn_cast_or_null<IREE::HAL::InterfaceBindingSubspanOp>(baseOp)) {
+    dynamicDims = subspanOp.dynamic_dims();
+  } else if (auto allocaOp = dyn_cast_or_null<memref::AllocaOp>(baseOp)) {
+    dynamicDims = allocaOp.dynamicSizes();
+  } else if (auto allocOp = dyn_cast_or_null<memref::AllocOp>(baseOp)) {
+    dynamicDims = allocOp.dynamicSizes();
+  }
+  SmallVector<Value, 2> dims;
+  for (int64_t size : baseType.getShape()) {
+    if (ShapedType::isDynamic(size)) {
+      dims.push_back(dynamicDims.front());
+      dynamicDims = dynamicDims.drop_front();
+    } else {
+      dims.push_back(builder.createOrFold<arith::ConstantIndexOp>(loc, size));
+    }
+  }
+  return dims;
+}
+
+// Returns the region of the flattened buffer accessed through |memref|.
+// Expects that |memref| has a strided region.
+static StridedRegion getStridedRegion(OpBuilder &builder, Location loc,
+                                      Value memref) {
+  SmallVector<memref::SubViewOp> subviewOps;
+  Value base = getRegionBase(memref, subviewOps);
+  assert(base && "expected a strided region");
+  auto baseType = base.getType().cast<MemRefType>();
+  SmallVector<Value, 2> dims = getBaseDims(builder, loc, base);
+
+  StridedRegion region;
+  region.offset = builder.createOrFold<arith::ConstantIndexOp>(loc, 0);
+  region.strides.push_back(
+      builder.createOrFold<arith::ConstantIndexOp>(loc, 1));
+  if (baseType.getRank() == 2) {
+    region.strides.insert(region.strides.begin(), dims.back());
+  }
+  region.sizes = dims;
+
+  // Binding byte offsets are folded into the region offset so that the
+  // runtime receives the whole binding buffer. We assume that the byte offset
+  // is a multiple of the element byte width, as FlattenMemRefSubspan does.
+  Type elementType = baseType.getElementType();
+  if (auto subspanOp =
+          base.getDefiningOp<IREE::HAL::InterfaceBindingSubspanOp>()) {
+    Value byteOffset = subspanOp.byte_offset();
+    if (byteOffset && !matchPattern(byteOffset, m_Zero())) {
+      {
+        OpBuilder::InsertionGuard guard(builder);
+        builder.setInsertionPointAfter(subspanOp);
+        Value zero =
+            builder.create<arith::ConstantIndexOp>(subspanOp.getLoc(), 0);
+        base = builder.create<IREE::HAL::InterfaceBindingSubspanOp>(
+            subspanOp.getLoc(), subspanOp.getType(), subspanOp.set(),
+            subspanOp.binding(), subspanOp.type(), zero,
+            subspanOp.dynamic_dims(), subspanOp.alignmentAttr());
+      }
+      Value elementBytes = builder.createOrFold<arith::ConstantIndexOp>(
+          loc, IREE::Util::getRoundedElementByteWidth(elementType));
+      region.offset =
+          builder.createOrFold<arith::DivUIOp>(loc, byteOffset, elementBytes);
+    }
+  }
+
+  for (memref::SubViewOp subviewOp : llvm::reverse(subviewOps)) {
+    SmallVector<OpFoldResult> offsets = subviewOp.getMixedOffsets();
+    SmallVector<OpFoldResult> sizes = subviewOp.getMixedSizes();
+    SmallVector<OpFoldResult> strides = subviewOp.getMixedStrides();
+    for (unsigned i = 0; i < region.strides.size(); ++i) {
+      Value offset = builder.createOrFold<arith::MulIOp>(
+          loc, getIndexValue(builder, loc, offsets[i]), region.strides[i]);
+      region.offset =
+          builder.createOrFold<arith::AddIOp>(loc, region.offset, offset);
+      region.strides[i] = builder.createOrFold<arith::MulIOp>(
+          loc, getIndexValue(builder, loc, strides[i]), region.strides[i]);
+      region.sizes[i] = getIndexValue(builder, loc, sizes[i]);
+    }
+  }
+
+  // The VMVX ops take rank 1 buffers. FlattenMemRefSubspan later rewrites the
+  // cast to start from the flattened buffer, like the casts of HALToVMVX.
+  region.buffer = base;
+  if (baseType.getRank() != 1) {
+    auto flatType = MemRefType::get({ShapedType::kDynamicSize}, elementType);
+    region.buffer =
+        builder.create<UnrealizedConversionCastOp>(loc, flatType, base)
+            .getResult(0);
+  }
+  return region;
+}
+
+// Returns |region| as iterated by the loops of a linalg op where |map| is the
+// indexing map of the operand. Loops that don't index the operand broadcast it
+// with a stride of 0. A single loop is padded with an outer loop of size 1.
+static StridedRegion getLoopRegion(OpBuilder &builder, Location loc,
+                                   const StridedRegion &region,
+                                   AffineMap map) {
+  Value zero = builder.createOrFold<arith::ConstantIndexOp>(loc, 0);
+  Value one = builder.createOrFold<arith::ConstantIndexOp>(loc, 1);
+  StridedRegion loopRegion;
+  loopRegion.buffer = region.buffer;
+  loopRegion.offset = region.offset;
+  loopRegion.strides.assign(map.getNumDims(), zero);
+  loopRegion.sizes.assign(map.getNumDims(), one);
+  for (unsigned i = 0; i < map.getNumResults(); ++i) {
+    unsigned dim = map.getDimPosition(i);
+    loopRegion.strides[dim] = region.strides[i];
+    loopRegion.sizes[dim] = region.sizes[i];
+  }
+  if (map.getNumDims() == 1) {
+    loopRegion.strides.insert(loopRegion.strides.begin(), zero);
+    loopRegion.sizes.insert(loopRegion.sizes.begin(), one);
+  }
+  return loopRegion;
+}
+
+// Returns the 2D region of a memref accessed with an identity map.
+static StridedRegion getIdentityLoopRegion(OpBuilder &builder, Location loc,
+                                           Value memref) {
+  unsigned rank = memref.getType().cast<MemRefType>().getRank();
+  return getLoopRegion(
+      builder, loc, getStridedRegion(builder, loc, memref),
+      AffineMap::getMultiDimIdentityMap(rank, builder.getContext()));
+}
+
+// Returns true if |type| is one of the element types of VMVX buffers.
+static bool isBufferElementType(Type type) {
+  return type.isInteger(8) || type.isInteger(16) || type.isInteger(32) ||
+         type.isInteger(64) || type.isF32() || type.isF64();
+}
+
+static LogicalResult lowerFillOp(linalg::FillOp op) {
+  Value output = op.output();
+  auto outputType = output.getType().dyn_cast<MemRefType>();
+  if (!outputType || !hasStridedRegion(output)) return failure();
+  Type elementType = outputType.getElementType();
+  if (op.value().getType() != elementType ||
+      !(elementType.isInteger(8) || elementType.isInteger(16) ||
+        elementType.isInteger(32) || elementType.isF32())) {
+    return failure();
+  }
+
+  OpBuilder builder(op);
+  Location loc = op.getLoc();
+  Value value = op.value();
+  Type i32Type = builder.getI32Type();
+  if (elementType.isF32()) {
+    value = builder.create<arith::BitcastOp>(loc, i32Type, value);
+  } else if (!elementType.isInteger(32)) {
+    value = builder.create<arith::ExtUIOp>(loc, i32Type, value);
+  }
+  StridedRegion out = getIdentityLoopRegion(builder, loc, output);
+  builder.create<IREE::VMVX::FillOp>(loc, value, out.buffer, out.offset,
+                                     out.strides[0], out.strides[1],
+                                     out.sizes[0], out.sizes[1]);
+  op.erase();
+  return success();
+}
+
+namespace {
+
+// Elementwise computations with a VMVX microkernel.
+enum class ElementwiseKind { Copy, Add, Mul, Exp };
+
+}  // namespace
+
+// Returns the kind of the elementwise computation of |op| and its input
+// operands in the order the computation uses them.
+static Optional<ElementwiseKind> matchElementwisePayload(
+    linalg::GenericOp op, SmallVectorImpl<OpOperand *> &inputs) {
+  Block *body = op.getBlock();
+  if (!body->getArguments().back().use_empty()) return llvm::None;
+  auto getInput = [&](Value value) -> OpOperand * {
+    auto arg = value.dyn_cast<BlockArgument>();
+    if (!arg || arg.getOwner() != body ||
+        arg.getArgNumber() >= op.getNumInputs()) {
+      return nullptr;
+    }
+    return op.getInputOperand(arg.getArgNumber());
+  };
+
+  Type elementType = getElementTypeOrSelf(op.getOutputOperand(0)->get());
+  Operation *terminator = body->getTerminator();
+  Value yielded = terminator->getOperand(0);
+  if (OpOperand *input = getInput(yielded)) {
+    if (!isBufferElementType(elementType)) return llvm::None;
+    inputs.push_back(input);
+    return ElementwiseKind::Copy;
+  }
+
+  Operation *payloadOp = yielded.getDefiningOp();
+  if (!payloadOp || &body->front() != payloadOp ||
+      payloadOp->getNextNode() != terminator) {
+    return llvm::None;
+  }
+  for (Value operand : payloadOp->getOperands()) {
+    OpOperand *input = getInput(operand);
+    if (!input) return llvm::None;
+    inputs.push_back(input);
+  }
+  if (elementType.isF32()) {
+    if (isa<arith::AddFOp>(payloadOp)) return ElementwiseKind::Add;
+    if (isa<arith::MulFOp>(payloadOp)) return ElementwiseKind::Mul;
+    if (isa<math::ExpOp>(payloadOp)) return ElementwiseKind::Exp;
+  } else if (elementType.isInteger(32)) {
+    if (isa<arith::AddIOp>(payloadOp)) return ElementwiseKind::Add;
+    if (isa<arith::MulIOp>(payloadOp)) return ElementwiseKind::Mul;
+  }
+  return llvm::None;
+}
+
+static LogicalResult lowerGenericOp(linalg::GenericOp op) {
+  unsigned numLoops = op.getNumLoops();
+  if (!op.hasBufferSemantics() || op.hasIndexSemantics() ||
+      op.getNumOutputs() != 1 || numLoops < 1 || numLoops > 2 ||
+      op.getNumParallelLoops() != numLoops) {
+    return failure();
+  }
+  OpOperand *output = op.getOutputOperand(0);
+  if (!op.getTiedIndexingMap(output).isPermutation()) return failure();
+  Type elementType = getElementTypeOrSelf(output->get());
+  for (OpOperand *operand : op.getInputAndOutputOperands()) {
+    if (!operand->get().getType().isa<MemRefType>() ||
+        getElementTypeOrSelf(operand->get()) != elementType ||
+        !op.getTiedIndexingMap(operand).isProjectedPermutation() ||
+        !hasStridedRegion(operand->get())) {
+      return failure();
+    }
+  }
+  SmallVector<OpOperand *, 2> inputs;
+  Optional<ElementwiseKind> kind = matchElementwisePayload(op, inputs);
+  if (!kind) return failure();
+
+  OpBuilder builder(op);
+  Location loc = op.getLoc();
+  auto getRegion = [&](OpOperand *operand) {
+    return getLoopRegion(builder, loc,
+                         getStridedRegion(builder, loc, operand->get()),
+                         op.getTiedIndexingMap(operand));
+  };
+  StridedRegion out = getRegion(output);
+  SmallVector<StridedRegion, 2> ins;
+  for (OpOperand *input : inputs) ins.push_back(getRegion(input));
+  switch (*kind) {
+    case ElementwiseKind::Copy:
+      builder.create<IREE::VMVX::CopyOp>(
+          loc, ins[0].buffer, ins[0].offset, ins[0].strides[0],
+          ins[0].strides[1], out.buffer, out.offset, out.strides[0],
+          out.strides[1], out.sizes[0], out.sizes[1]);
+      break;
+    case ElementwiseKind::Add:
+      builder.create<IREE::VMVX::AddOp>(
+          loc, ins[0].buffer, ins[0].offset, ins[0].strides[0],
+          ins[0].strides[1], ins[1].buffer, ins[1].offset, ins[1].strides[0],
+          ins[1].strides[1], out.buffer, out.offset, out.strides[0],
+          out.strides[1], out.sizes[0], out.sizes[1]);
+      break;
+    case ElementwiseKind::Mul:
+      builder.create<IREE::VMVX::MulOp>(
+          loc, ins[0].buffer, ins[0].offset, ins[0].strides[0],
+          ins[0].strides[1], ins[1].buffer, ins[1].offset, ins[1].strides[0],
+          ins[1].strides[1], out.buffer, out.offset, out.strides[0],
+          out.strides[1], out.sizes[0], out.sizes[1]);
+      break;
+    case ElementwiseKind::Exp:
+      builder.create<IREE::VMVX::ExpOp>(
+          loc, ins[0].buffer, ins[0].offset, ins[0].strides[0],
+          ins[0].strides[1], out.buffer, out.offset, out.strides[0],
+          out.strides[1], out.sizes[0], out.sizes[1]);
+      break;
+  }
+  op.erase();
+  return success();
+}
+
+static LogicalResult lowerMatmulOp(linalg::MatmulOp op) {
+  if (!op.hasBufferSemantics()) return failure();
+  Value lhs = op.getInputOperand(0)->get();
+  Value rhs = op.getInputOperand(1)->get();
+  Value out = op.getOutputOperand(0)->get();
+  for (Value operand : {lhs, rhs, out}) {
+    if (!getElementTypeOrSelf(operand).isF32() ||
+        !hasStridedRegion(operand) || !hasUnitInnerStride(operand)) {
+      return failure();
+    }
+  }
+
+  OpBuilder builder(op);
+  Location loc = op.getLoc();
+  StridedRegion lhsRegion = getStridedRegion(builder, loc, lhs);
+  StridedRegion rhsRegion = getStridedRegion(builder, loc, rhs);
+  StridedRegion outRegion = getStridedRegion(builder, loc, out);
+  builder.create<IREE::VMVX::MatmulOp>(
+      loc, lhsRegion.buffer, lhsRegion.offset, lhsRegion.strides[0],
+      rhsRegion.buffer, rhsRegion.offset, rhsRegion.strides[0],
+      outRegion.buffer, outRegion.offset, outRegion.strides[0],
+      outRegion.sizes[0], outRegion.sizes[1], lhsRegion.sizes[1]);
+  op.erase();
+  return success();
+}
+
+namespace {
+
+class LowerLinalgMicrokernelsPass
+    : public PassWrapper<LowerLinalgMicrokernelsPass, OperationPass<FuncOp>> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::VMVX::VMVXDialect, arith::ArithmeticDialect>();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-vmvx-lower-linalg-microkernels";
+  }
+
+  StringRef getDescription() const override {
+    return "Lowers linalg ops to the VMVX microkernels they match";
+  }
+
+  void runOnOperation() override {
+    SmallVector<Operation *> candidates;
+    getOperation().walk([&](Operation *op) {
+      if (isa<linalg::FillOp, linalg::GenericOp, linalg::MatmulOp>(op)) {
+        candidates.push_back(op);
+      }
+    });
+    for (Operation *op : candidates) {
+      if (auto fillOp = dyn_cast<linalg::FillOp>(op)) {
+        (void)lowerFillOp(fillOp);
+      } else if (auto genericOp = dyn_cast<linalg::GenericOp>(op)) {
+        (void)lowerGenericOp(genericOp);
+      } else if (auto matmulOp = dyn_cast<linalg::MatmulOp>(op)) {
+        (void)lowerMatmulOp(matmulOp);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createLowerLinalgMicrokernelsPass() {
+  return std::make_unique<LowerLinalgMicrokernelsPass>();
+}
+
+static PassRegistration<LowerLinalgMicrokernelsPass> pass;
+
+}  // namespace VMVX
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
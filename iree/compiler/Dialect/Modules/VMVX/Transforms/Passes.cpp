@@ -45,10 +45,11 @@ static void buildVectorVMVXTransformPassPipeline(OpPassManager &passManager) {
   // nestedModulePM.addNestedPass<FuncOp>(
   //     createLinalgTileAndVectorizeWorkgroupsPass());
 
-  // Linalg -> SCF.
+  // Linalg -> VMVX microkernels, and SCF for the rest.
   nestedModulePM.addNestedPass<FuncOp>(
       IREE::LinalgExt::createLinalgExtToLoopsPass());
   nestedModulePM.addNestedPass<FuncOp>(createMemrefCopyToLinalgPass());
+  nestedModulePM.addNestedPass<FuncOp>(createLowerLinalgMicrokernelsPass());
   nestedModulePM.addNestedPass<FuncOp>(createConvertLinalgToLoopsPass());
   nestedModulePM.addNestedPass<FuncOp>(createCanonicalizerPass());
   nestedModulePM.addNestedPass<FuncOp>(createCSEPass());
@@ -37,6 +37,14 @@ void buildVMVXTransformPassPipeline(OpPassManager &passManager);
 
 void createVMVXTransformPassPipeline();
 
+//===----------------------------------------------------------------------===//
+// Microkernels
+//===----------------------------------------------------------------------===//
+
+// Lowers linalg ops with buffer semantics that match a VMVX microkernel (fill,
+// elementwise copy/add/mul/exp, and matmul) to the corresponding VMVX ops.
+std::unique_ptr<OperationPass<FuncOp>> createLowerLinalgMicrokernelsPass();
+
 //===----------------------------------------------------------------------===//
 // Dialect conversion
 //===----------------------------------------------------------------------===//
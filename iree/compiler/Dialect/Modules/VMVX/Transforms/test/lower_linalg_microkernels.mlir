@@ -0,0 +1,175 @@
+// RUN: iree-opt -split-input-file -iree-vmvx-lower-linalg-microkernels -canonicalize %s | FileCheck %s
+
+// CHECK-LABEL: func @fill_f32
+//   CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+//   CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+//   CHECK-DAG:   %[[C4:.+]] = arith.constant 4 : index
+//   CHECK-DAG:   %[[C8:.+]] = arith.constant 8 : index
+//   CHECK-DAG:   %[[BITS:.+]] = arith.constant 1065353216 : i32
+//       CHECK:   %[[SUBSPAN:.+]] = hal.interface.binding.subspan
+//       CHECK:   %[[BUFFER:.+]] = builtin.unrealized_conversion_cast %[[SUBSPAN]] : memref<4x8xf32> to memref<?xf32>
+//       CHECK:   vmvx.fill %[[BITS]] out(%[[BUFFER]] offset %[[C0]] strides [%[[C8]], %[[C1]]] : memref<?xf32>) sizes(%[[C4]], %[[C8]])
+//   CHECK-NOT:   linalg.fill
+func @fill_f32() {
+  %cst = arith.constant 1.0 : f32
+  %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<4x8xf32>
+  linalg.fill(%cst, %0) : f32, memref<4x8xf32>
+  return
+}
+
+// -----
+
+// Rank 1 buffers are used directly and the byte offset of the binding is
+// folded into the region offset.
+
+// CHECK-LABEL: func @fill_i8_offset
+//  CHECK-SAME:   %[[VALUE:.+]]: i8, %[[BYTE_OFFSET:.+]]: index, %[[SIZE:.+]]: index
+//   CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+//   CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+//       CHECK:   %[[SUBSPAN:.+]] = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) offset(%[[C0]]) : memref<?xi8>{%[[SIZE]]}
+//       CHECK:   %[[BITS:.+]] = arith.extui %[[VALUE]] : i8 to i32
+//       CHECK:   vmvx.fill %[[BITS]] out(%[[SUBSPAN]] offset %[[BYTE_OFFSET]] strides [%[[C0]], %[[C1]]] : memref<?xi8>) sizes(%[[C1]], %[[SIZE]])
+func @fill_i8_offset(%value: i8, %offset: index, %size: index) {
+  %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) offset(%offset) : memref<?xi8>{%size}
+  linalg.fill(%value, %0) : i8, memref<?xi8>
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func @add_broadcast_f32
+//   CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+//   CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+//   CHECK-DAG:   %[[C4:.+]] = arith.constant 4 : index
+//   CHECK-DAG:   %[[C8:.+]] = arith.constant 8 : index
+//   CHECK-DAG:   %[[LHS:.+]] = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<4x8xf32>
+//   CHECK-DAG:   %[[RHS:.+]] = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<8xf32>
+//   CHECK-DAG:   %[[OUT:.+]] = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : memref<4x8xf32>
+//   CHECK-DAG:   %[[OUT_BUFFER:.+]] = builtin.unrealized_conversion_cast %[[OUT]] : memref<4x8xf32> to memref<?xf32>
+//   CHECK-DAG:   %[[LHS_BUFFER:.+]] = builtin.unrealized_conversion_cast %[[LHS]] : memref<4x8xf32> to memref<?xf32>
+//       CHECK:   vmvx.add
+//  CHECK-SAME:     lhs(%[[LHS_BUFFER]] offset %[[C0]] strides [%[[C8]], %[[C1]]] : memref<?xf32>)
+//  CHECK-SAME:     rhs(%[[RHS]] offset %[[C0]] strides [%[[C0]], %[[C1]]] : memref<8xf32>)
+//  CHECK-SAME:     out(%[[OUT_BUFFER]] offset %[[C0]] strides [%[[C8]], %[[C1]]] : memref<?xf32>)
+//  CHECK-SAME:     sizes(%[[C4]], %[[C8]])
+//   CHECK-NOT:   linalg.generic
+func @add_broadcast_f32() {
+  %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<4x8xf32>
+  %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<8xf32>
+  %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : memref<4x8xf32>
+  linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                       affine_map<(d0, d1) -> (d1)>,
+                       affine_map<(d0, d1) -> (d0, d1)>],
+      iterator_types = ["parallel", "parallel"]}
+      ins(%0, %1 : memref<4x8xf32>, memref<8xf32>)
+      outs(%2 : memref<4x8xf32>) {
+  ^bb0(%lhs: f32, %rhs: f32, %out: f32):
+    %3 = arith.addf %lhs, %rhs : f32
+    linalg.yield %3 : f32
+  }
+  return
+}
+
+// -----
+
+// Copies of subviews are lowered with the strides of the subviews composed
+// with those of the buffer. Transposes swap the input strides.
+
+// CHECK-LABEL: func @copy_transpose_subview
+//  CHECK-SAME:   %[[I:.+]]: index
+//   CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+//   CHECK-DAG:   %[[C2:.+]] = arith.constant 2 : index
+//   CHECK-DAG:   %[[C8:.+]] = arith.constant 8 : index
+//       CHECK:   %[[IN_OFFSET:.+]] = arith.muli %[[I]], %[[C8]] : index
+//       CHECK:   vmvx.copy
+//  CHECK-SAME:     in(%{{.+}} offset %[[IN_OFFSET]] strides [%[[C1]], %[[C8]]] : memref<?xi32>)
+//  CHECK-SAME:     out(%{{.+}} offset %[[I]] strides [%[[C8]], %[[C2]]] : memref<?xi32>)
+//  CHECK-SAME:     sizes(%[[C8]], %[[C2]])
+func @copy_transpose_subview(%i: index) {
+  %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<4x8xi32>
+  %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<8x8xi32>
+  %2 = memref.subview %0[%i, 0] [2, 8] [1, 1] : memref<4x8xi32> to memref<2x8xi32, affine_map<(d0, d1)[s0] -> (d0 * 8 + s0 + d1)>>
+  %3 = memref.subview %1[0, %i] [8, 2] [1, 2] : memref<8x8xi32> to memref<8x2xi32, affine_map<(d0, d1)[s0] -> (d0 * 8 + s0 + d1 * 2)>>
+  linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d1, d0)>,
+                       affine_map<(d0, d1) -> (d0, d1)>],
+      iterator_types = ["parallel", "parallel"]}
+      ins(%2 : memref<2x8xi32, affine_map<(d0, d1)[s0] -> (d0 * 8 + s0 + d1)>>)
+      outs(%3 : memref<8x2xi32, affine_map<(d0, d1)[s0] -> (d0 * 8 + s0 + d1 * 2)>>) {
+  ^bb0(%in: i32, %out: i32):
+    linalg.yield %in : i32
+  }
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func @exp_f32
+//       CHECK:   vmvx.exp
+//  CHECK-SAME:     in(%{{.+}} : memref<16xf32>)
+//  CHECK-SAME:     out(%{{.+}} : memref<16xf32>)
+//   CHECK-NOT:   linalg.generic
+func @exp_f32() {
+  %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<16xf32>
+  %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<16xf32>
+  linalg.generic {
+      indexing_maps = [affine_map<(d0) -> (d0)>, affine_map<(d0) -> (d0)>],
+      iterator_types = ["parallel"]}
+      ins(%0 : memref<16xf32>) outs(%1 : memref<16xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    %2 = math.exp %in : f32
+    linalg.yield %2 : f32
+  }
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func @matmul_f32
+//  CHECK-SAME:   %[[M:.+]]: index, %[[N:.+]]: index, %[[K:.+]]: index
+//   CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+//   CHECK-DAG:   %[[LHS:.+]] = builtin.unrealized_conversion_cast %{{.+}} : memref<?x?xf32> to memref<?xf32>
+//   CHECK-DAG:   %[[RHS:.+]] = builtin.unrealized_conversion_cast %{{.+}} : memref<?x?xf32> to memref<?xf32>
+//   CHECK-DAG:   %[[OUT:.+]] = builtin.unrealized_conversion_cast %{{.+}} : memref<?x?xf32> to memref<?xf32>
+//       CHECK:   vmvx.matmul
+//  CHECK-SAME:     lhs(%[[LHS]] offset %[[C0]] row_stride %[[K]] : memref<?xf32>)
+//  CHECK-SAME:     rhs(%[[RHS]] offset %[[C0]] row_stride %[[N]] : memref<?xf32>)
+//  CHECK-SAME:     out(%[[OUT]] offset %[[C0]] row_stride %[[N]] : memref<?xf32>)
+//  CHECK-SAME:     mnk(%[[M]], %[[N]], %[[K]])
+//   CHECK-NOT:   linalg.matmul
+func @matmul_f32(%m: index, %n: index, %k: index) {
+  %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<?x?xf32>{%m, %k}
+  %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<?x?xf32>{%k, %n}
+  %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : memref<?x?xf32>{%m, %n}
+  linalg.matmul ins(%0, %1 : memref<?x?xf32>, memref<?x?xf32>) outs(%2 : memref<?x?xf32>)
+  return
+}
+
+// -----
+
+// Matmuls need contiguous rows and reductions have no microkernel.
+
+// CHECK-LABEL: func @not_lowered
+//   CHECK-NOT:   vmvx.
+//       CHECK:   linalg.matmul
+//       CHECK:   linalg.generic
+//   CHECK-NOT:   vmvx.
+func @not_lowered(%i: index) {
+  %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<8x8xf32>
+  %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<8xf32>
+  %2 = memref.subview %0[0, 0] [4, 4] [1, 2] : memref<8x8xf32> to memref<4x4xf32, affine_map<(d0, d1) -> (d0 * 8 + d1 * 2)>>
+  %3 = memref.subview %0[0, 1] [4, 8] [1, 1] : memref<8x8xf32> to memref<4x8xf32, affine_map<(d0, d1) -> (d0 * 8 + d1 + 1)>>
+  %4 = memref.subview %0[4, 0] [4, 8] [1, 1] : memref<8x8xf32> to memref<4x8xf32, affine_map<(d0, d1) -> (d0 * 8 + d1 + 32)>>
+  linalg.matmul ins(%2, %3 : memref<4x4xf32, affine_map<(d0, d1) -> (d0 * 8 + d1 * 2)>>, memref<4x8xf32, affine_map<(d0, d1) -> (d0 * 8 + d1 + 1)>>)
+                outs(%4 : memref<4x8xf32, affine_map<(d0, d1) -> (d0 * 8 + d1 + 32)>>)
+  linalg.generic {
+      indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+      iterator_types = ["parallel", "reduction"]}
+      ins(%0 : memref<8x8xf32>) outs(%1 : memref<8xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    %5 = arith.addf %in, %out : f32
+    linalg.yield %5 : f32
+  }
+  return
+}
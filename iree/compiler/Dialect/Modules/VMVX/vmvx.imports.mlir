@@ -26,7 +26,192 @@
 vm.module @vmvx {
 
 //===----------------------------------------------------------------------===//
-// VMVX Ops: TODO
+// VMVX Ops: 2D strided microkernels
 //===----------------------------------------------------------------------===//
+// Regions are given as element offsets and element strides into the buffers.
+// A stride of 0 broadcasts the dimension.
+
+// Copies a 2D region of elements of the given bit width.
+vm.import @copy.2d.x8(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @copy.2d.x16(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @copy.2d.x32(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @copy.2d.x64(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+// Fills a 2D region with the low bits of |value|.
+vm.import @fill.2d.x8(
+  %value : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @fill.2d.x16(
+  %value : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @fill.2d.x32(
+  %value : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+// Elementwise binary ops on 2D regions.
+vm.import @add.2d.f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @add.2d.i32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @mul.2d.f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @mul.2d.i32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride0 : i32,
+  %lhs_stride1 : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride0 : i32,
+  %rhs_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+// Elementwise unary ops on 2D regions.
+vm.import @exp.2d.f32(
+  %in_buffer : !vm.buffer,
+  %in_offset : i32,
+  %in_stride0 : i32,
+  %in_stride1 : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride0 : i32,
+  %out_stride1 : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+// Accumulates lhs[m, k] * rhs[k, n] into out[m, n] on row-major regions.
+vm.import @matmul.f32f32f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_row_stride : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_row_stride : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_row_stride : i32,
+  %m : i32,
+  %n : i32,
+  %k : i32
+)
 
 }  // module
@@ -6,9 +6,14 @@
 
 #include "iree/compiler/Dialect/Stream/Analysis/Partitioning.h"
 
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/IR/AsmState.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/PatternMatch.h"
 
 #define DEBUG_TYPE "iree-stream-partitioning"
@@ -153,6 +158,78 @@ void PartitionSet::topologicalSort() {
   partitions = std::move(sortedSet);
 }
 
+// Estimate used for dynamically-sized transfers.
+static constexpr int64_t kDynamicByteLengthEstimate = 1 * 1024 * 1024;
+// Estimate used for dynamic workgroup count dimensions.
+static constexpr int64_t kDynamicWorkgroupCountEstimate = 64;
+// Relative cost of executing a single workgroup in bytes-equivalent units.
+static constexpr int64_t kWorkgroupCost = 4 * 1024;
+
+static int64_t estimateByteLength(Value length) {
+  APInt lengthValue;
+  if (length && matchPattern(length, m_ConstantInt(&lengthValue))) {
+    return lengthValue.getSExtValue();
+  }
+  return kDynamicByteLengthEstimate;
+}
+
+static int64_t estimateWorkgroupCount(ValueRange workgroupCount) {
+  int64_t count = 1;
+  for (auto dim : workgroupCount) {
+    APInt dimValue;
+    count *= matchPattern(dim, m_ConstantInt(&dimValue))
+                 ? dimValue.getSExtValue()
+                 : kDynamicWorkgroupCountEstimate;
+  }
+  return count;
+}
+
+static int64_t estimateTotalResultLength(Operation *op) {
+  auto sizeAwareOp = dyn_cast<IREE::Util::SizeAwareOpInterface>(op);
+  if (!sizeAwareOp) return 0;
+  int64_t length = 0;
+  for (unsigned i = 0; i < op->getNumResults(); ++i) {
+    if (!op->getResult(i).getType().isa<IREE::Stream::ResourceType>()) {
+      continue;
+    }
+    length += estimateByteLength(sizeAwareOp.getResultSize(i));
+  }
+  return length;
+}
+
+int64_t estimateExecutionCost(Operation *op) {
+  if (auto streamableOp = dyn_cast<IREE::Stream::StreamableOpInterface>(op)) {
+    if (streamableOp.isMetadata()) return 0;
+  }
+  return TypeSwitch<Operation *, int64_t>(op)
+      .Case<IREE::Stream::AsyncDispatchOp>([&](auto op) {
+        return estimateWorkgroupCount(op.workgroup_count()) * kWorkgroupCost +
+               estimateTotalResultLength(op);
+      })
+      .Case<IREE::Stream::CmdDispatchOp>([&](auto op) {
+        int64_t length = 0;
+        for (auto resourceLength : op.resource_lengths()) {
+          length += estimateByteLength(resourceLength);
+        }
+        return estimateWorkgroupCount(op.workgroup_count()) * kWorkgroupCost +
+               length;
+      })
+      .Case<IREE::Stream::CmdFillOp>(
+          [&](auto op) { return estimateByteLength(op.target_length()); })
+      .Case<IREE::Stream::CmdCopyOp>(
+          [&](auto op) { return estimateByteLength(op.length()); })
+      .Default([&](Operation *op) { return estimateTotalResultLength(op); });
+}
+
+int64_t estimateWaveCost(int64_t totalCost, int64_t maxCost,
+                         int64_t deviceConcurrency) {
+  // A wave takes at least as long as its slowest op and at least as long as
+  // it takes to push all of its work through the device.
+  return std::max(maxCost,
+                  llvm::divideCeil(totalCost, std::max<int64_t>(
+                                                  deviceConcurrency, 1)));
+}
+
 PartitionSet partitionStreamableOps(IREE::Stream::PartitioningConfigAttr config,
                                     Block *block) {
   // Only one algorithm today.
@@ -161,7 +238,10 @@ PartitionSet partitionStreamableOps(IREE::Stream::PartitioningConfigAttr config,
 
 PartitionSet partitionRegionConcurrency(
     IREE::Stream::PartitioningConfigAttr config, Block *block) {
-  // Only one algorithm today.
+  if (config.getFavor().getValue() ==
+      IREE::Stream::Favor::BalancedConcurrency) {
+    return partitionRegionConcurrencyBalanced(config, block);
+  }
   return partitionRegionConcurrencyReference(config, block);
 }
 
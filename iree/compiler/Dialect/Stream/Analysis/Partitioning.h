@@ -22,6 +22,8 @@ namespace Stream {
 
 // A single slice of ops.
 struct Partition {
+  // Affinity of all ops in the partition, if any.
+  IREE::Stream::AffinityAttr affinity;
   // SSA values defined outside of the partition.
   // All values not defined by ops in the partition must be declared.
   // Multiple partitions may capture the same value.
@@ -60,6 +62,23 @@ struct PartitionSet {
   void topologicalSort();
 };
 
+//===----------------------------------------------------------------------===//
+// Cost estimation
+//===----------------------------------------------------------------------===//
+
+// Estimates the relative device time of executing |op| in bytes-equivalent
+// units: transfers are weighted by the number of bytes they touch and
+// dispatches additionally by their workgroup count. Dynamic values use fixed
+// estimates. Returns 0 for ops that perform no device work (like subviews).
+// Works on both stream.async.* and stream.cmd.* ops.
+int64_t estimateExecutionCost(Operation *op);
+
+// Returns the estimated time of a wave of ops with the given |totalCost| and
+// |maxCost| (the cost of the most expensive op in the wave) when executed on a
+// device able to run |deviceConcurrency| ops at full throughput concurrently.
+int64_t estimateWaveCost(int64_t totalCost, int64_t maxCost,
+                         int64_t deviceConcurrency);
+
 //===----------------------------------------------------------------------===//
 // Stream partitioning algorithms
 //===----------------------------------------------------------------------===//
@@ -123,6 +142,18 @@ PartitionSet partitionStreamableOpsReference(
 PartitionSet partitionRegionConcurrencyReference(
     IREE::Stream::PartitioningConfigAttr config, Block *block);
 
+//===----------------------------------------------------------------------===//
+// Cost-based partitioning
+//===----------------------------------------------------------------------===//
+
+// Produces waves of concurrently executable work like
+// partitionRegionConcurrencyReference but places each op in the wave where it
+// least increases the estimated wave time (see estimateWaveCost). Large
+// independent ops end up in separate waves they can dominate while small ops
+// fill in waves that are already bound by larger ones.
+PartitionSet partitionRegionConcurrencyBalanced(
+    IREE::Stream::PartitioningConfigAttr config, Block *block);
+
 }  // namespace Stream
 }  // namespace IREE
 }  // namespace iree_compiler
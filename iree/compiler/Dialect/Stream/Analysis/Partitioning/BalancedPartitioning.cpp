@@ -0,0 +1,181 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Stream/Analysis/Partitioning.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/IR/PatternMatch.h"
+
+#define DEBUG_TYPE "iree-stream-partitioning"
+
+static llvm::cl::opt<int64_t> clDeviceConcurrency(
+    "iree-stream-partitioning-device-concurrency",
+    llvm::cl::desc("Number of ops the target device can execute concurrently "
+                   "at full throughput; used to balance concurrent waves when "
+                   "favoring balanced-concurrency."),
+    llvm::cl::init(4));
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+
+// Mirrors partitionRegionConcurrencyReference with the difference being that
+// when an op may be placed in multiple waves we pick the one whose estimated
+// time increases the least. Ties are broken towards the earliest wave formed,
+// matching the max-concurrency behavior.
+PartitionSet partitionRegionConcurrencyBalanced(
+    IREE::Stream::PartitioningConfigAttr config, Block *block) {
+  PartitionSet waveSet;
+
+  struct PartitionBuilder {
+    unsigned ordinal;
+    // Ops present in the wave; ops may be present in multiple waves.
+    SetVector<Operation *> ops;
+    // Sum of the estimated cost of all ops in the wave.
+    int64_t totalCost = 0;
+    // Estimated cost of the most expensive op in the wave.
+    int64_t maxCost = 0;
+
+    int64_t getWaveCost() const {
+      return estimateWaveCost(totalCost, maxCost, clDeviceConcurrency);
+    }
+    int64_t getWaveCostWith(int64_t opCost) const {
+      return estimateWaveCost(totalCost + opCost, std::max(maxCost, opCost),
+                              clDeviceConcurrency);
+    }
+    void insert(Operation *op, int64_t opCost) {
+      ops.insert(op);
+      totalCost += opCost;
+      maxCost = std::max(maxCost, opCost);
+    }
+  };
+  SmallVector<std::unique_ptr<PartitionBuilder>> builders;
+
+  struct OpInfo {
+    // Which waves the op is contained within.
+    llvm::BitVector membership;
+    // Which waves transitively depend on this operation.
+    llvm::BitVector hazards;
+  };
+  DenseMap<Operation *, OpInfo> opInfos;
+
+  for (auto &op : llvm::reverse(*block)) {
+    // Skip constants; they just add noise (and since they are heavily CSE'd
+    // they have lots of users to test).
+    if (op.hasTrait<OpTrait::ConstantLike>()) {
+      LLVM_DEBUG(llvm::dbgs() << "(ignoring constant)\n");
+      continue;
+    }
+
+    // Track transitive hazards on each op; see
+    // partitionRegionConcurrencyReference for details.
+    auto &opInfo = opInfos[&op];
+    opInfo.hazards.reserve(builders.size() + 1);
+    opInfo.hazards.resize(builders.size(), /*t=*/false);
+
+    LLVM_DEBUG({
+      llvm::dbgs() << "====\nPartitioning op:\n";
+      op.dump();
+    });
+
+    for (auto user : op.getUsers()) {
+      auto &userInfo = opInfos[user];
+      opInfo.hazards |= userInfo.membership;
+      opInfo.hazards |= userInfo.hazards;
+    }
+    llvm::BitVector candidates(builders.size(), /*t=*/true);
+    candidates ^= opInfo.hazards;
+
+    // If this op is not streamable then bail here; we've still setup the hazard
+    // map for following iteration.
+    auto streamableOp = dyn_cast<IREE::Stream::StreamableOpInterface>(op);
+    if (!streamableOp || streamableOp.isMetadata()) {
+      LLVM_DEBUG(llvm::dbgs() << "Not streamable/is subview (skip)\n");
+      continue;
+    }
+
+    opInfo.membership.reserve(builders.size() + 1);
+    opInfo.membership.resize(builders.size(), /*t=*/false);
+
+    // Pick the candidate wave that the op least slows down.
+    int64_t opCost = estimateExecutionCost(&op);
+    int bestOrdinal = -1;
+    int64_t bestCostDelta = 0;
+    for (auto ordinal : candidates.set_bits()) {
+      auto &builder = builders[ordinal];
+      int64_t costDelta =
+          builder->getWaveCostWith(opCost) - builder->getWaveCost();
+      if (bestOrdinal == -1 || costDelta < bestCostDelta) {
+        bestOrdinal = ordinal;
+        bestCostDelta = costDelta;
+      }
+    }
+    if (bestOrdinal != -1) {
+      LLVM_DEBUG(llvm::dbgs()
+                 << "Moving to candidate wave " << bestOrdinal << " (cost "
+                 << opCost << ", wave cost +" << bestCostDelta
+                 << ") (continue)\n");
+      builders[bestOrdinal]->insert(&op, opCost);
+      opInfo.membership.set(bestOrdinal);
+      opInfo.hazards.set(0, bestOrdinal);
+      opInfo.hazards.reset(bestOrdinal);
+      continue;
+    }
+
+    // Mark the op as having hazards against all other waves.
+    opInfo.hazards.set(0, builders.size());
+
+    // Create a new wave just for this op.
+    opInfo.membership.resize(opInfo.membership.size() + 1, /*t=*/true);
+    auto builder = std::make_unique<PartitionBuilder>();
+    builder->ordinal = builders.size();
+    builder->insert(&op, opCost);
+    LLVM_DEBUG(llvm::dbgs() << "Created wave " << builder->ordinal << " (cost "
+                            << opCost << ")\n");
+    builders.push_back(std::move(builder));
+  }
+
+  // Emit waves in forward order (as they are topologically sorted in
+  // reverse order from our bottom-up walk).
+  for (auto &builder : llvm::reverse(builders)) {
+    Partition wave;
+
+    SetVector<Value> consumedValues;
+    SetVector<Value> producedValues;
+    SetVector<Value> escapingValues;
+    for (auto *op : llvm::reverse(builder->ops)) {
+      for (auto operand : op->getOperands()) {
+        consumedValues.insert(operand);
+      }
+      for (auto result : op->getResults()) {
+        producedValues.insert(result);
+        for (auto user : result.getUsers()) {
+          if (!builder->ops.contains(user)) {
+            escapingValues.insert(result);
+          }
+        }
+      }
+    }
+    consumedValues.set_subtract(producedValues);
+    wave.ins = consumedValues;
+    wave.outs = escapingValues;
+
+    wave.ops = std::move(builder->ops);
+    waveSet.partitions.push_back(std::move(wave));
+  }
+
+  LLVM_DEBUG(waveSet.dump(block->getParentOp()));
+
+  return waveSet;
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
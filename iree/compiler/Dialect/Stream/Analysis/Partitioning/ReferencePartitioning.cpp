@@ -188,6 +188,7 @@ PartitionSet partitionStreamableOpsReference(
   // reverse order from our bottom-up walk).
   for (auto &builder : llvm::reverse(builders)) {
     Partition partition;
+    partition.affinity = builder->affinity;
 
     SetVector<Value> consumedValues;
     SetVector<Value> producedValues;
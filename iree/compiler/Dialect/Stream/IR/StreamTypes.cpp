@@ -36,7 +36,11 @@ static llvm::cl::opt<Favor> partitioningFavor(
                    "additional concurrency."),
         clEnumValN(Favor::MaxConcurrency, "max-concurrency",
                    "Favor maximizing concurrency at the cost of additional "
-                   "memory consumption.")));
+                   "memory consumption."),
+        clEnumValN(Favor::BalancedConcurrency, "balanced-concurrency",
+                   "Favor concurrent waves of balanced estimated cost such "
+                   "that large work overlaps and small work does not "
+                   "fragment execution.")));
 
 //===----------------------------------------------------------------------===//
 // #stream.resource_config<...>
@@ -171,6 +175,32 @@ void TimepointAttr::print(AsmPrinter &p) const {
 // #stream.affinity
 //===----------------------------------------------------------------------===//
 
+// static
+Attribute AffinityAttr::parse(AsmParser &p, Type type) {
+  int64_t deviceOrdinal = 0;
+  if (succeeded(p.parseOptionalLess())) {
+    StringRef key;
+    if (failed(p.parseKeyword(&key)) || failed(p.parseEqual()) ||
+        failed(p.parseInteger(deviceOrdinal)) || failed(p.parseGreater())) {
+      return {};
+    }
+    if (key != "device") {
+      p.emitError(p.getNameLoc(), "unknown affinity key: ") << key;
+      return {};
+    }
+    if (deviceOrdinal < 0) {
+      p.emitError(p.getNameLoc(), "device ordinal must be non-negative");
+      return {};
+    }
+  }
+  return AffinityAttr::get(p.getContext(), deviceOrdinal);
+}
+
+void AffinityAttr::print(AsmPrinter &p) const {
+  if (getDeviceOrdinal() == 0) return;
+  p << "<device = " << getDeviceOrdinal() << ">";
+}
+
 AffinityAttr AffinityAttr::lookup(Operation *op) {
   auto attrId = StringAttr::get(op->getContext(), "stream.affinity");
   while (op) {
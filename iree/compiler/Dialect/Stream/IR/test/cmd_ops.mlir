@@ -92,3 +92,21 @@ func @cmdExecute(%arg0: !stream.resource<transient>, %arg1: index, %arg2: !strea
   } => !stream.timepoint
   return %0 : !stream.timepoint
 }
+
+// -----
+
+// CHECK-LABEL: @cmdExecuteAffinity
+func @cmdExecuteAffinity(%arg0: !stream.resource<transient>, %arg1: index) -> (!stream.timepoint, !stream.timepoint) {
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %c255_i32 = arith.constant 255 : i32
+  // CHECK: = stream.cmd.execute on(#stream.affinity) with
+  %0 = stream.cmd.execute on(#stream.affinity<device = 0>) with(%arg0 as %arg2: !stream.resource<transient>{%arg1}) {
+    stream.cmd.fill %c255_i32, %arg2[%c0 for %c128] : i32 -> !stream.resource<transient>{%arg1}
+  } => !stream.timepoint
+  // CHECK: = stream.cmd.execute on(#stream.affinity<device = 1>) with
+  %1 = stream.cmd.execute on(#stream.affinity<device = 1>) with(%arg0 as %arg2: !stream.resource<transient>{%arg1}) {
+    stream.cmd.fill %c255_i32, %arg2[%c0 for %c128] : i32 -> !stream.resource<transient>{%arg1}
+  } => !stream.timepoint
+  return %0, %1 : !stream.timepoint, !stream.timepoint
+}
@@ -6,6 +6,9 @@
 
 #include <utility>
 
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/Flow/IR/FlowTypes.h"
+#include "iree/compiler/Dialect/Stream/Analysis/Partitioning.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamTraits.h"
@@ -18,6 +21,7 @@
 #include "llvm/Support/Format.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Diagnostics.h"
@@ -160,6 +164,140 @@ struct Statistics {
   }
 };
 
+//===----------------------------------------------------------------------===//
+// Dispatch cost estimation
+//===----------------------------------------------------------------------===//
+
+// Returns the number of iterations of the parallel loops of |linalgOp|.
+// Ops within distributed loops operate on dynamically-sized tiles so the
+// iteration space is taken from the full tensor their result is stored into.
+static Optional<int64_t> estimateParallelIterations(linalg::LinalgOp linalgOp,
+                                                    ArrayRef<int64_t> ranges) {
+  int64_t iterations = 1;
+  bool isStatic = true;
+  for (auto it : llvm::enumerate(linalgOp.iterator_types())) {
+    if (!isParallelIterator(it.value())) continue;
+    int64_t range = ranges[it.index()];
+    if (ShapedType::isDynamic(range)) {
+      isStatic = false;
+      break;
+    }
+    iterations *= range;
+  }
+  if (isStatic) return iterations;
+  for (auto *user : linalgOp->getUsers()) {
+    auto storeOp = dyn_cast<IREE::Flow::DispatchTensorStoreOp>(user);
+    if (!storeOp) continue;
+    auto targetType =
+        storeOp.target().getType().cast<IREE::Flow::DispatchTensorType>();
+    if (targetType.hasStaticShape()) return targetType.getNumElements();
+  }
+  return llvm::None;
+}
+
+// Estimates the number of scalar arithmetic ops executed by a single dispatch
+// to |funcOp| as the payload size of each linalg op times its iteration count
+// (so a matmul is 2*M*N*K). Returns None if any iteration space is dynamic.
+static Optional<int64_t> estimateDispatchFlops(mlir::FuncOp funcOp) {
+  int64_t flops = 0;
+  bool isStatic = true;
+  funcOp.walk([&](linalg::LinalgOp linalgOp) {
+    // The terminator is not counted.
+    int64_t bodyOps = std::max<int64_t>(
+        linalgOp.getBlock()->getOperations().size() - 1, 0);
+    if (!bodyOps) return WalkResult::advance();
+    auto ranges = linalgOp.getStaticLoopRanges();
+    auto parallelIterations = estimateParallelIterations(linalgOp, ranges);
+    if (!parallelIterations) {
+      isStatic = false;
+      return WalkResult::interrupt();
+    }
+    int64_t reductionIterations = 1;
+    for (auto it : llvm::enumerate(linalgOp.iterator_types())) {
+      if (isParallelIterator(it.value())) continue;
+      if (ShapedType::isDynamic(ranges[it.index()])) {
+        isStatic = false;
+        return WalkResult::interrupt();
+      }
+      reductionIterations *= ranges[it.index()];
+    }
+    flops += parallelIterations.getValue() * reductionIterations * bodyOps;
+    return WalkResult::advance();
+  });
+  if (!isStatic) return llvm::None;
+  return flops;
+}
+
+// Estimated cost and memory traffic of a single stream.cmd.dispatch.
+// Values that cannot be determined statically are None.
+struct DispatchCost {
+  SmallVector<Optional<int64_t>, 3> workgroupCount;
+  Optional<int64_t> workgroups;
+  Optional<int64_t> flops;
+  // Bytes of the bindings the dispatch may read/write. Bindings that are both
+  // read and written count towards both.
+  Optional<int64_t> bytesRead;
+  Optional<int64_t> bytesWritten;
+  // Bytes of all bindings to transient resources.
+  Optional<int64_t> transientBytes;
+
+  void analyze(IREE::Stream::CmdDispatchOp dispatchOp,
+               Optional<int64_t> exportFlops) {
+    workgroups = 1;
+    for (auto dim : dispatchOp.workgroup_count()) {
+      APInt dimValue;
+      if (matchPattern(dim, m_ConstantInt(&dimValue))) {
+        workgroupCount.push_back(dimValue.getSExtValue());
+        if (workgroups) workgroups = *workgroups * dimValue.getSExtValue();
+      } else {
+        workgroupCount.push_back(llvm::None);
+        workgroups = llvm::None;
+      }
+    }
+    flops = exportFlops;
+
+    bytesRead = 0;
+    bytesWritten = 0;
+    transientBytes = 0;
+    auto accumulate = [](Optional<int64_t> &total, Optional<int64_t> value) {
+      total = total && value ? Optional<int64_t>(*total + *value) : llvm::None;
+    };
+    for (auto it : llvm::zip(dispatchOp.resources(),
+                             dispatchOp.resource_lengths(),
+                             dispatchOp.resource_accesses())) {
+      Optional<int64_t> length;
+      APInt lengthValue;
+      if (matchPattern(std::get<1>(it), m_ConstantInt(&lengthValue))) {
+        length = lengthValue.getSExtValue();
+      }
+      auto access = std::get<2>(it)
+                        .cast<IREE::Stream::ResourceAccessBitfieldAttr>()
+                        .getValue();
+      if (bitEnumContains(access, IREE::Stream::ResourceAccessBitfield::Read)) {
+        accumulate(bytesRead, length);
+      }
+      if (bitEnumContains(access,
+                          IREE::Stream::ResourceAccessBitfield::Write)) {
+        accumulate(bytesWritten, length);
+      }
+      auto resourceType =
+          std::get<0>(it).getType().cast<IREE::Stream::ResourceType>();
+      if (resourceType.getLifetime() == IREE::Stream::Lifetime::Transient) {
+        accumulate(transientBytes, length);
+      }
+    }
+  }
+
+  // Returns the ratio of estimated arithmetic ops to bytes of memory traffic.
+  // Dispatches with low intensity are likely to be bound by memory bandwidth.
+  Optional<double> getArithmeticIntensity() const {
+    if (!flops || !bytesRead || !bytesWritten) return llvm::None;
+    int64_t bytes = *bytesRead + *bytesWritten;
+    if (!bytes) return llvm::None;
+    return *flops / (double)bytes;
+  }
+};
+
 //===----------------------------------------------------------------------===//
 // Pretty printing
 //===----------------------------------------------------------------------===//
@@ -278,11 +416,53 @@ static void prettyPrintStreamInfo(const UsageInfo &usageInfo,
   os << "\n";
   os << "//\n";
 
+  size_t fillCount = 0;
+  size_t copyCount = 0;
+  size_t dispatchCount = 0;
+  size_t concurrentCount = 0;
+  SmallVector<IREE::Stream::CmdConcurrentOp> concurrentOps;
+  executeOp.walk([&](Operation *op) {
+    TypeSwitch<Operation *>(op)
+        .Case<IREE::Stream::CmdFillOp>([&](auto op) { ++fillCount; })
+        .Case<IREE::Stream::CmdCopyOp>([&](auto op) { ++copyCount; })
+        .Case<IREE::Stream::CmdDispatchOp>([&](auto op) { ++dispatchCount; })
+        .Case<IREE::Stream::CmdConcurrentOp>(
+            [&](auto op) { concurrentOps.push_back(op); });
+    if (isa<IREE::Stream::StreamableOpInterface>(op) &&
+        op->getParentOfType<IREE::Stream::CmdConcurrentOp>()) {
+      ++concurrentCount;
+    }
+  });
+  size_t commandCount = fillCount + copyCount + dispatchCount;
+  os << llvm::formatv("//   Commands: {0} fills, {1} copies, {2} dispatches\n",
+                      fillCount, copyCount, dispatchCount);
+  os << llvm::formatv("//      Waves: {0}, {1} of {2} commands concurrent\n",
+                      concurrentOps.size(), concurrentCount, commandCount);
+
+  // Estimated costs of each concurrent wave as produced by partitioning.
+  // Balance is the ratio of the total cost to the cost of running every
+  // command as slow as the slowest one: waves of similarly sized commands are
+  // close to 1 while waves bound by a single command are close to 0.
+  for (auto it : llvm::enumerate(concurrentOps)) {
+    size_t waveCommandCount = 0;
+    int64_t totalCost = 0;
+    int64_t maxCost = 0;
+    for (auto &op : it.value().body().front().without_terminator()) {
+      int64_t cost = estimateExecutionCost(&op);
+      ++waveCommandCount;
+      totalCost += cost;
+      maxCost = std::max(maxCost, cost);
+    }
+    double balance =
+        maxCost ? totalCost / (double)(waveCommandCount * maxCost) : 1.0;
+    os << llvm::formatv(
+        "//     Wave {0}: {1} commands, estimated cost {2} (slowest {3}), "
+        "balance {4:F2}\n",
+        it.index(), waveCommandCount, totalCost, maxCost, balance);
+  }
+
   // TODO(benvanik): print stream information (for each stream.cmd.execute):
   // - number of unique resources captured
-  // - number of commands of each type
-  // - % concurrently executable
-  os << "// TODO\n";
 }
 
 static void prettyPrintAllStreamInfo(const UsageInfo &usageInfo, bool verbose,
@@ -511,15 +691,82 @@ static void dumpAggregateJSONStructure(const UsageInfo &usageInfo,
   os << "  }\n";
 }
 
+// Formats |value| as a JSON number or null if it is unknown.
+static std::string formatJSONValue(Optional<int64_t> value) {
+  return value ? std::to_string(*value) : std::string("null");
+}
+
+// Formats a symbol name as a JSON string. Symbol names do not need escaping.
+static std::string formatJSONString(StringRef value) {
+  return ("\"" + value + "\"").str();
+}
+
+// Dumps the estimated cost of each dispatch. Entries are keyed by the
+// executable export name, which matches the entry point name reported by
+// runtime profiling, so that estimates can be correlated with measurements.
+static void dumpDispatchJSONStructures(const UsageInfo &usageInfo,
+                                       llvm::raw_fd_ostream &os) {
+  const char kvPair[] = "    \"{0}\": {1},\n";
+  const char kvPairNoComma[] = "    \"{0}\": {1}\n";
+
+  bool first = true;
+  for (auto it : usageInfo.exportDispatchOps) {
+    auto exportFlops = estimateDispatchFlops(it.first);
+    for (auto dispatchOp : it.second) {
+      DispatchCost cost;
+      cost.analyze(dispatchOp, exportFlops);
+      if (!first) os << ",\n";
+      first = false;
+
+      auto entryPoint = dispatchOp.entry_point();
+      auto callerOp = dispatchOp->getParentOfType<FunctionOpInterface>();
+      SmallVector<std::string, 3> workgroupCount;
+      for (auto dim : cost.workgroupCount) {
+        workgroupCount.push_back(formatJSONValue(dim));
+      }
+      os << "  {\n";
+      os << llvm::formatv(kvPair, "executable",
+                          formatJSONString(
+                              entryPoint.getRootReference().getValue()));
+      os << llvm::formatv(kvPair, "entry-point",
+                          formatJSONString(
+                              entryPoint.getLeafReference().getValue()));
+      os << llvm::formatv(
+          kvPair, "caller",
+          formatJSONString(SymbolTable::getSymbolName(callerOp).getValue()));
+      os << llvm::formatv(kvPair, "workgroup-count",
+                          "[" + llvm::join(workgroupCount, ", ") + "]");
+      os << llvm::formatv(kvPair, "workgroups",
+                          formatJSONValue(cost.workgroups));
+      os << llvm::formatv(kvPair, "estimated-flops",
+                          formatJSONValue(cost.flops));
+      os << llvm::formatv(kvPair, "bytes-read",
+                          formatJSONValue(cost.bytesRead));
+      os << llvm::formatv(kvPair, "bytes-written",
+                          formatJSONValue(cost.bytesWritten));
+      os << llvm::formatv(kvPair, "transient-bytes",
+                          formatJSONValue(cost.transientBytes));
+      auto intensity = cost.getArithmeticIntensity();
+      os << llvm::formatv(kvPairNoComma, "arithmetic-intensity",
+                          intensity ? llvm::formatv("{0:F4}", *intensity).str()
+                                    : std::string("null"));
+      os << "  }";
+    }
+  }
+  if (!first) os << "\n";
+}
+
 static void dumpJSONStructures(const UsageInfo &usageInfo,
                                llvm::raw_fd_ostream &os) {
   os << "{\n";
 
   os << "\"stream-aggregate\": {\n";
   dumpAggregateJSONStructure(usageInfo, os);
-  os << "}\n";
+  os << "},\n";
 
-  // TODO(antiagainst): dump per-execution data if needed.
+  os << "\"dispatches\": [\n";
+  dumpDispatchJSONStructures(usageInfo, os);
+  os << "]\n";
 
   os << "}\n";
 }
@@ -153,6 +153,158 @@ static void deduplicateOperands(
       [&](BlockArgument arg) { return deadArgMap.test(arg.getArgNumber()); });
 }
 
+// Splits |value| into a base value and a constant offset such that
+// |value| = base + offset. Constant values have a null base.
+static std::pair<Value, APInt> splitConstantOffset(Value value) {
+  APInt constantValue;
+  if (matchPattern(value, m_ConstantInt(&constantValue))) {
+    return {nullptr, constantValue};
+  }
+  if (auto addOp = value.getDefiningOp<arith::AddIOp>()) {
+    if (matchPattern(addOp.getRhs(), m_ConstantInt(&constantValue))) {
+      return {addOp.getLhs(), constantValue};
+    }
+    if (matchPattern(addOp.getLhs(), m_ConstantInt(&constantValue))) {
+      return {addOp.getRhs(), constantValue};
+    }
+  }
+  unsigned bitWidth = value.getType().isIndex()
+                          ? IndexType::kInternalStorageBitWidth
+                          : value.getType().getIntOrFloatBitWidth();
+  return {value, APInt(bitWidth, 0)};
+}
+
+// Folds operands that differ from an earlier operand by a constant delta that
+// is uniform across all dispatch sites. This commonly happens with the offsets
+// of fused bindings into resources (such as transient slabs) that have a
+// uniform layout across dispatches but are rebased per execution region.
+//
+// Example:
+//   stream.cmd.dispatch @foo(%c100, %c300 : index, index)
+//   stream.cmd.dispatch @foo(%c1100, %c1300 : index, index)
+// ->
+//   stream.cmd.dispatch @foo(%c100 : index)
+//   stream.cmd.dispatch @foo(%c1100 : index)
+// + %arg1 = %arg0 + 200 in the executable
+static void foldUniformDeltaOperands(
+    mlir::FuncOp funcOp,
+    SmallVector<IREE::Stream::CmdDispatchOp> &dispatchOps) {
+  auto &entryBlock = funcOp.front();
+  auto anyDispatchOp = dispatchOps.front();
+  unsigned operandCount = anyDispatchOp.operands().size();
+
+  // Only integer values (excluding i1) can be rebased.
+  llvm::BitVector candidateOperandMap(operandCount);
+  for (unsigned idx = 0; idx < operandCount; ++idx) {
+    auto type = anyDispatchOp.operands()[idx].getType();
+    if (type.isIndex() ||
+        (type.isa<IntegerType>() && type.getIntOrFloatBitWidth() > 1)) {
+      candidateOperandMap.set(idx);
+    }
+  }
+
+  // Split all operands at each dispatch site into base + offset.
+  SmallVector<SmallVector<std::pair<Value, APInt>>> splitOperands;
+  splitOperands.reserve(dispatchOps.size());
+  for (auto dispatchOp : dispatchOps) {
+    SmallVector<std::pair<Value, APInt>> splits;
+    for (unsigned idx = 0; idx < operandCount; ++idx) {
+      auto value = dispatchOp.operands()[idx];
+      splits.push_back(candidateOperandMap.test(idx)
+                           ? splitConstantOffset(value)
+                           : std::make_pair(value, APInt()));
+    }
+    splitOperands.push_back(std::move(splits));
+  }
+
+  // Find for each operand the first earlier operand of the same type that has
+  // the same base and a uniform delta at all sites.
+  static const int kUnrelated = -1;
+  SmallVector<int> baseOperands(operandCount, kUnrelated);
+  SmallVector<APInt> baseDeltas(operandCount);
+  for (unsigned j = 0; j < operandCount; ++j) {
+    if (!candidateOperandMap.test(j)) continue;
+    auto type = anyDispatchOp.operands()[j].getType();
+    for (unsigned i = 0; i < j; ++i) {
+      if (!candidateOperandMap.test(i) || baseOperands[i] != kUnrelated ||
+          anyDispatchOp.operands()[i].getType() != type) {
+        continue;
+      }
+      Optional<APInt> delta;
+      bool isUniform = true;
+      for (auto &splits : splitOperands) {
+        auto &base = splits[i];
+        auto &derived = splits[j];
+        if (base.first != derived.first) {
+          isUniform = false;
+          break;
+        }
+        APInt siteDelta = derived.second - base.second;
+        if (delta.hasValue() && delta.getValue() != siteDelta) {
+          isUniform = false;
+          break;
+        }
+        delta = siteDelta;
+      }
+      if (!isUniform) continue;
+      baseOperands[j] = i;
+      baseDeltas[j] = delta.getValue();
+      break;
+    }
+  }
+  if (llvm::all_of(baseOperands, [](int i) { return i == kUnrelated; })) {
+    // No-op.
+    return;
+  }
+
+  LLVM_DEBUG({
+    llvm::dbgs() << "foldUniformDeltaOperands for " << funcOp.sym_name()
+                 << "\n";
+    for (unsigned j = 0; j < operandCount; ++j) {
+      if (baseOperands[j] == kUnrelated) continue;
+      llvm::dbgs() << "  operand " << j << " = operand " << baseOperands[j]
+                   << " + " << baseDeltas[j] << "\n";
+    }
+  });
+
+  auto operandToArgMap =
+      IREE::Stream::CmdDispatchOp::makeOperandToArgMap(funcOp);
+
+  // Replace uses of the derived arguments with their base plus the delta.
+  llvm::BitVector deadOperandsMap(operandCount);
+  llvm::BitVector deadArgMap(funcOp.getNumArguments());
+  auto builder = OpBuilder::atBlockBegin(&entryBlock);
+  for (unsigned j = 0; j < operandCount; ++j) {
+    if (baseOperands[j] == kUnrelated) continue;
+    deadOperandsMap.set(j);
+    auto arg = entryBlock.getArgument(operandToArgMap[j]);
+    auto baseArg = entryBlock.getArgument(operandToArgMap[baseOperands[j]]);
+    deadArgMap.set(arg.getArgNumber());
+    Value replacement = baseArg;
+    if (!baseDeltas[j].isZero()) {
+      auto deltaOp = builder.create<arith::ConstantOp>(
+          arg.getLoc(), builder.getIntegerAttr(arg.getType(), baseDeltas[j]));
+      replacement =
+          builder.create<arith::AddIOp>(arg.getLoc(), baseArg, deltaOp);
+    }
+    arg.replaceAllUsesWith(replacement);
+  }
+
+  // Update each dispatch site to remove the derived operands.
+  SmallVector<unsigned> deadOperands;
+  for (auto idx : deadOperandsMap.set_bits()) deadOperands.push_back(idx);
+  for (auto dispatchOp : dispatchOps) {
+    for (auto idx : llvm::reverse(deadOperands)) {
+      dispatchOp.operandsMutable().erase(idx);
+    }
+  }
+
+  // Fixup function signature.
+  funcOp.setType(funcOp.getTypeWithoutArgsAndResults(deadArgMap, {}));
+  entryBlock.eraseArguments(
+      [&](BlockArgument arg) { return deadArgMap.test(arg.getArgNumber()); });
+}
+
 // Inlines constant values passed in at dispatch sites that are uniform across
 // all sites. These may be shape dimensions, resource offsets/sizes, or
 // user-provided values that folded to constants.
@@ -285,6 +437,12 @@ class FoldUniformOperandsPass
         // per dispatch site.
         deduplicateOperands(funcOp, dispatchOps);
 
+        // Rebase operands that are offset from another by a uniform delta.
+        // This runs before inlining so that operands that are uniform
+        // constants relative to each other but not absolutely are still
+        // folded.
+        foldUniformDeltaOperands(funcOp, dispatchOps);
+
         // Inline constants that have the same value at all sites.
         inlineUniformConstants(funcOp, dispatchOps);
       }
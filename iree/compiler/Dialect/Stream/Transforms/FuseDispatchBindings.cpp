@@ -368,23 +368,15 @@ static void fuseDispatchBindings(
     }
   });
 
-  // TODO(benvanik): some special handling for finding least-common-denominator
-  // or base values for constants passed in. We can end up with a lot of
-  // subranges into transient or constant resources that are all relatively
-  // correlated:
+  // NOTE: we can end up with a lot of subranges into transient or constant
+  // resources that are all relatively correlated:
   //   operand[0]: @storage0: offset 100
   //   operand[1]: @storage0: offset 200
   //   operand[2]: @storage0: offset 300
-  // ->
-  //   operand[0]: @storage0: offset +0
-  //   operand[1]: @storage0: offset +100
-  //   operand[2]: @storage0: offset +200
-  // Identifying these and using those relative offsets would make it cheaper to
-  // inline the values into the executables as they are not dispatch site
-  // specific. We'd do this by going per range and finding uniformly constant
-  // values. See the old MaterializeInterfaces.cpp pass for an earlier
-  // implementation that was special-cased for constant buffers only: here we
-  // can do it for everything.
+  // -iree-stream-fold-uniform-operands identifies offsets that differ by a
+  // uniform delta at all dispatch sites and passes only the base offset:
+  //   operand[0]: @storage0: offset 100
+  //   (operand[0] + 100, operand[0] + 200 in the executable)
 
   // Update the executable function to use the new bindings.
   auto funcOp = exportOp.getFunctionRef();
@@ -12,6 +12,7 @@
 #include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/Support/Debug.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/IR/AsmState.h"
@@ -29,12 +30,234 @@ namespace IREE {
 namespace Stream {
 namespace {
 
+//===----------------------------------------------------------------------===//
+// Transient slab reuse
+//===----------------------------------------------------------------------===//
+
+// A stream.resource.alloca and the stream.resource.dealloca ending its
+// lifetime within the same block.
+struct TransientSlab {
+  IREE::Stream::ResourceAllocaOp allocaOp;
+  IREE::Stream::ResourceDeallocaOp deallocaOp;
+  // Block-relative lifetime used as the slice interval of the slab.
+  int64_t lifetimeStart = 0;
+  int64_t lifetimeEnd = 0;
+};
+
+// Returns the dealloca that releases |allocaOp| if it is the only one and
+// lives in the same block as the alloca.
+static IREE::Stream::ResourceDeallocaOp findBlockDealloca(
+    IREE::Stream::ResourceAllocaOp allocaOp) {
+  IREE::Stream::ResourceDeallocaOp deallocaOp;
+  for (auto *user : allocaOp.result().getUsers()) {
+    auto userOp = dyn_cast<IREE::Stream::ResourceDeallocaOp>(user);
+    if (!userOp) continue;
+    if (deallocaOp || userOp->getBlock() != allocaOp->getBlock()) return {};
+    deallocaOp = userOp;
+  }
+  return deallocaOp;
+}
+
+// Returns true if |value| is defined in the same block as |insertionPoint|
+// and is available there.
+static bool isAvailableAt(Value value, Operation *insertionPoint) {
+  if (value.getParentBlock() != insertionPoint->getBlock()) return false;
+  auto *definingOp = value.getDefiningOp();
+  return !definingOp || definingOp->isBeforeInBlock(insertionPoint);
+}
+
+// Returns the peak number of bytes of |slabs| live at the same time or
+// None if any slab is dynamically sized. Slabs are live across their entire
+// (inclusive) lifetime interval.
+static Optional<int64_t> computePeakLiveBytes(ArrayRef<TransientSlab> slabs) {
+  SmallVector<std::pair<int64_t, int64_t>> events;
+  for (auto &slab : slabs) {
+    APInt size;
+    if (!matchPattern(slab.allocaOp.storage_size(), m_ConstantInt(&size))) {
+      return llvm::None;
+    }
+    events.push_back({slab.lifetimeStart, size.getSExtValue()});
+    events.push_back({slab.lifetimeEnd + 1, -size.getSExtValue()});
+  }
+  // Process releases before acquisitions at the same point.
+  llvm::sort(events);
+  int64_t liveBytes = 0;
+  int64_t peakBytes = 0;
+  for (auto &event : events) {
+    liveBytes += event.second;
+    peakBytes = std::max(peakBytes, liveBytes);
+  }
+  return peakBytes;
+}
+
+// Returns the sum of the sizes of |slabs| or None if any is dynamic.
+static Optional<int64_t> computeTotalBytes(ArrayRef<TransientSlab> slabs) {
+  int64_t totalBytes = 0;
+  for (auto &slab : slabs) {
+    APInt size;
+    if (!matchPattern(slab.allocaOp.storage_size(), m_ConstantInt(&size))) {
+      return llvm::None;
+    }
+    totalBytes += size.getSExtValue();
+  }
+  return totalBytes;
+}
+
+// Gathers the transient slabs in |block| that can be merged into a single
+// slab allocated at the position of the first one.
+static SmallVector<TransientSlab> gatherMergeableSlabs(Block &block) {
+  DenseMap<Operation *, int64_t> opOrdinals;
+  int64_t ordinal = 0;
+  for (auto &op : block) opOrdinals[&op] = ordinal++;
+
+  SmallVector<TransientSlab> slabs;
+  for (auto allocaOp : block.getOps<IREE::Stream::ResourceAllocaOp>()) {
+    auto deallocaOp = findBlockDealloca(allocaOp);
+    if (!deallocaOp ||
+        deallocaOp.operand_size() != allocaOp.storage_size()) {
+      continue;
+    }
+    if (!slabs.empty()) {
+      // All slabs must match the first one and have sizes available where it
+      // is allocated.
+      auto firstOp = slabs.front().allocaOp;
+      if (allocaOp.result().getType() != firstOp.result().getType() ||
+          allocaOp.affinityAttr() != firstOp.affinityAttr() ||
+          !isAvailableAt(allocaOp.storage_size(), firstOp)) {
+        continue;
+      }
+    }
+    TransientSlab slab;
+    slab.allocaOp = allocaOp;
+    slab.deallocaOp = deallocaOp;
+    slab.lifetimeStart = opOrdinals[allocaOp];
+    slab.lifetimeEnd = opOrdinals[deallocaOp];
+    slabs.push_back(slab);
+  }
+  return slabs;
+}
+
+// Replaces the transient |slabs| allocated within a block with subranges of a
+// single slab. Slabs with disjoint lifetimes (such as those of execution
+// regions that run one after another) are packed to the same offsets and the
+// memory is reused. Any slab that may reuse the memory of a slab released
+// before it is allocated waits for the release to be safe.
+static void mergeTransientSlabs(ArrayRef<TransientSlab> slabs) {
+  auto firstOp = slabs.front().allocaOp;
+  OpBuilder builder(firstOp);
+  auto loc = builder.getFusedLoc(llvm::to_vector<4>(llvm::map_range(
+      slabs,
+      [](const TransientSlab &slab) { return slab.allocaOp.getLoc(); })));
+  auto affinityAttr = firstOp.affinityAttr();
+  auto timepointType = firstOp.result_timepoint().getType();
+
+  SmallVector<int64_t> lifetimeIntervals;
+  SmallVector<Value> storageSizes;
+  for (auto &slab : slabs) {
+    lifetimeIntervals.push_back(slab.lifetimeStart);
+    lifetimeIntervals.push_back(slab.lifetimeEnd);
+    storageSizes.push_back(slab.allocaOp.storage_size());
+  }
+
+  // Allocate the shared slab where the first original slab was allocated.
+  auto indexType = builder.getIndexType();
+  SmallVector<Type> packedOffsetTypes(slabs.size(), indexType);
+  auto packOp = builder.create<IREE::Stream::ResourcePackOp>(
+      loc, indexType, packedOffsetTypes, /*offset=*/nullptr,
+      builder.getIndexArrayAttr(lifetimeIntervals), storageSizes,
+      affinityAttr);
+  auto slabSize = packOp.total_length();
+  auto newAllocaOp = builder.create<IREE::Stream::ResourceAllocaOp>(
+      loc, firstOp.result().getType(), timepointType, slabSize,
+      firstOp.await_timepoint(), affinityAttr);
+  auto slab = newAllocaOp.result();
+
+  // Replace each original slab with a subview that is available once the
+  // shared slab is, the original await is reached, and all slabs released
+  // prior have been deallocated.
+  for (auto it : llvm::zip(slabs, packOp.packed_offsets())) {
+    auto &originalSlab = std::get<0>(it);
+    auto allocaOp = originalSlab.allocaOp;
+    builder.setInsertionPoint(allocaOp);
+    auto subviewOp = builder.create<IREE::Stream::ResourceSubviewOp>(
+        allocaOp.getLoc(), slab, slabSize, std::get<1>(it),
+        allocaOp.storage_size());
+    SetVector<Value> awaitTimepoints;
+    awaitTimepoints.insert(newAllocaOp.result_timepoint());
+    if (allocaOp != firstOp && allocaOp.await_timepoint()) {
+      awaitTimepoints.insert(allocaOp.await_timepoint());
+    }
+    for (auto &priorSlab : slabs) {
+      if (priorSlab.lifetimeEnd < originalSlab.lifetimeStart &&
+          priorSlab.deallocaOp.await_timepoint()) {
+        awaitTimepoints.insert(priorSlab.deallocaOp.await_timepoint());
+      }
+    }
+    Value readyTimepoint = awaitTimepoints.front();
+    if (awaitTimepoints.size() > 1) {
+      readyTimepoint = builder.create<IREE::Stream::TimepointJoinOp>(
+          allocaOp.getLoc(), timepointType, awaitTimepoints.takeVector());
+    }
+    allocaOp.result().replaceAllUsesExcept(subviewOp.result(),
+                                           originalSlab.deallocaOp);
+    allocaOp.result_timepoint().replaceAllUsesWith(readyTimepoint);
+  }
+
+  // Release the shared slab after the last original slab is released and all
+  // work using any of the slabs has completed.
+  auto lastDeallocaOp = slabs.front().deallocaOp;
+  SetVector<Value> releaseTimepoints;
+  for (auto &originalSlab : slabs) {
+    auto deallocaOp = originalSlab.deallocaOp;
+    if (lastDeallocaOp->isBeforeInBlock(deallocaOp)) {
+      lastDeallocaOp = deallocaOp;
+    }
+    if (deallocaOp.await_timepoint()) {
+      releaseTimepoints.insert(deallocaOp.await_timepoint());
+    }
+  }
+  builder.setInsertionPoint(lastDeallocaOp);
+  Value releaseTimepoint;
+  if (releaseTimepoints.size() == 1) {
+    releaseTimepoint = releaseTimepoints.front();
+  } else if (releaseTimepoints.size() > 1) {
+    releaseTimepoint = builder.create<IREE::Stream::TimepointJoinOp>(
+        lastDeallocaOp.getLoc(), timepointType,
+        releaseTimepoints.takeVector());
+  }
+  auto newDeallocaOp = builder.create<IREE::Stream::ResourceDeallocaOp>(
+      lastDeallocaOp.getLoc(), slab, slabSize, releaseTimepoint, affinityAttr);
+
+  // Earlier releases are now no-ops that only carry their timepoint forward.
+  for (auto &originalSlab : slabs) {
+    auto deallocaOp = originalSlab.deallocaOp;
+    Value deallocaTimepoint = newDeallocaOp.result_timepoint();
+    if (deallocaOp != lastDeallocaOp) {
+      deallocaTimepoint = deallocaOp.await_timepoint();
+      if (!deallocaTimepoint) {
+        builder.setInsertionPoint(deallocaOp);
+        deallocaTimepoint = builder.create<IREE::Stream::TimepointImmediateOp>(
+            deallocaOp.getLoc());
+      }
+    }
+    deallocaOp.result_timepoint().replaceAllUsesWith(deallocaTimepoint);
+    deallocaOp.erase();
+  }
+  for (auto &originalSlab : slabs) originalSlab.allocaOp.erase();
+}
+
 //===----------------------------------------------------------------------===//
 // -iree-stream-pack-allocations
 //===----------------------------------------------------------------------===//
 
 class PackAllocationsPass : public PackAllocationsBase<PackAllocationsPass> {
  public:
+  PackAllocationsPass() = default;
+  PackAllocationsPass(const PackAllocationsPass &pass) {}
+  explicit PackAllocationsPass(bool reuseTransientSlabs) {
+    this->reuseTransientSlabs = reuseTransientSlabs;
+  }
+
   void getDependentDialects(DialectRegistry &registry) const override {
     registry.insert<mlir::StandardOpsDialect>();
     registry.insert<IREE::Stream::StreamDialect>();
@@ -104,13 +327,56 @@ class PackAllocationsPass : public PackAllocationsBase<PackAllocationsPass> {
 
       allocOp.erase();
     });
+
+    // Transients are allocated per execution region by the allocation
+    // scheduler and each region receives its own slab. Regions that are not
+    // live at the same time can share memory and packing all of the slabs in
+    // a block together lets us reuse it.
+    if (reuseTransientSlabs) {
+      for (auto &block : *parentOp.getCallableRegion()) {
+        auto slabs = gatherMergeableSlabs(block);
+        if (slabs.size() < 2) continue;
+        auto totalBytes = computeTotalBytes(slabs);
+        auto peakBytes = computePeakLiveBytes(slabs);
+        if (totalBytes && peakBytes) {
+          peakTransientBytesBefore += *totalBytes;
+          peakTransientBytesAfter += *peakBytes;
+        } else {
+          ++numDynamicSlabGroups;
+        }
+        LLVM_DEBUG({
+          llvm::dbgs() << "Merging " << slabs.size() << " transient slabs";
+          if (totalBytes && peakBytes) {
+            llvm::dbgs() << " (" << *totalBytes << " -> " << *peakBytes
+                         << " peak bytes)";
+          }
+          llvm::dbgs() << "\n";
+        });
+        numMergedSlabs += slabs.size();
+        mergeTransientSlabs(slabs);
+      }
+    }
   }
+
+ private:
+  Statistic numMergedSlabs{this, "merged transient slabs",
+                           "Number of transient slabs merged with others"};
+  Statistic numDynamicSlabGroups{
+      this, "dynamic transient slab groups",
+      "Number of merged slab groups with dynamic sizes (not in byte counts)"};
+  Statistic peakTransientBytesBefore{
+      this, "peak transient bytes before",
+      "Peak bytes of merged transient slabs without reuse"};
+  Statistic peakTransientBytesAfter{
+      this, "peak transient bytes after",
+      "Peak bytes of merged transient slabs live at once with reuse"};
 };
 
 }  // namespace
 
-std::unique_ptr<OperationPass<>> createPackAllocationsPass() {
-  return std::make_unique<PackAllocationsPass>();
+std::unique_ptr<OperationPass<>> createPackAllocationsPass(
+    bool reuseTransientSlabs) {
+  return std::make_unique<PackAllocationsPass>(reuseTransientSlabs);
 }
 
 }  // namespace Stream
@@ -350,6 +350,31 @@ static UploadResult buildStagingUpload(
   return uploadResult;
 }
 
+// Maps the storage resources directly as staging resources. The constant data
+// stays in host memory (usually the mapped module) and is only transferred to
+// devices when used.
+static UploadResult buildMappedStagingResources(
+    IREE::Stream::ResourceConstantsOp constantsOp,
+    IREE::Stream::ResourceType resourceType,
+    ArrayRef<StorageResource> storageResources, ArrayRef<Value> storageBuffers,
+    IndexSet &indexSet, OpBuilder &builder) {
+  UploadResult uploadResult;
+  for (auto it : llvm::zip(storageResources, storageBuffers)) {
+    auto &storageResource = std::get<0>(it);
+    auto storageBuffer = std::get<1>(it);
+    auto mapOp = builder.create<IREE::Stream::ResourceMapOp>(
+        storageResource.loc, resourceType, storageBuffer, indexSet.get(0),
+        indexSet.get(storageResource.totalSize), constantsOp.affinityAttr());
+    uploadResult.allocations.push_back({
+        mapOp.result(),
+        mapOp.result_size(),
+    });
+  }
+  uploadResult.timepoint =
+      builder.create<IREE::Stream::TimepointImmediateOp>(constantsOp.getLoc());
+  return uploadResult;
+}
+
 // Emits IR to first try mapping the storage resources directly into usable
 // constant resources. If the mapping fails (the target can't use the memory)
 // then fall back to staging uploads.
@@ -504,8 +529,9 @@ class PackConstantsPass : public PackConstantsBase<PackConstantsPass> {
       }
 
       // If this is producing constants (vs variables) we can try to go on a
-      // fast-path where we directly map the constant memory. If producing
-      // variables then we always need to stage and clone.
+      // fast-path where we directly map the constant memory. Staging
+      // constants (such as those paged in on use) are always mapped. If
+      // producing variables then we always need to stage and clone.
       auto anyResult = constantsOp.results().front();
       auto resourceType =
           anyResult.getType().cast<IREE::Stream::ResourceType>();
@@ -514,6 +540,11 @@ class PackConstantsPass : public PackConstantsBase<PackConstantsPass> {
         uploadResult = buildTryMapConstantResources(
             constantsOp, resourceType, storageResources, storageBuffers,
             indexSet, builder);
+      } else if (resourceType.getLifetime() ==
+                 IREE::Stream::Lifetime::Staging) {
+        uploadResult = buildMappedStagingResources(
+            constantsOp, resourceType, storageResources, storageBuffers,
+            indexSet, builder);
       } else {
         uploadResult =
             buildStagingUpload(constantsOp, resourceType, storageResources,
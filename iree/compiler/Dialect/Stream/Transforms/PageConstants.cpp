@@ -0,0 +1,186 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamTypes.h"
+#include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-stream-page-constants"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+namespace {
+
+//===----------------------------------------------------------------------===//
+// -iree-stream-page-constants
+//===----------------------------------------------------------------------===//
+
+// Loads and stores of a constant resource global.
+struct ConstantGlobal {
+  IREE::Util::GlobalOp globalOp;
+  SmallVector<IREE::Util::GlobalLoadOp> loadOps;
+  SmallVector<IREE::Util::GlobalStoreOp> storeOps;
+  // True if the global is accessed indirectly and can't be rewritten.
+  bool hasIndirectUses = false;
+};
+
+// Returns true if |user| can consume a staging resource directly or after an
+// explicit transfer is inserted before it.
+static bool isPageableUse(Operation *user) {
+  if (isa<IREE::Stream::ResourceSizeOp>(user) ||
+      isa<IREE::Stream::AsyncTransferOp>(user)) {
+    return true;
+  }
+  auto streamableOp = dyn_cast<IREE::Stream::StreamableOpInterface>(user);
+  return streamableOp && !streamableOp.isMetadata() &&
+         isa<IREE::Util::SizeAwareOpInterface>(user);
+}
+
+// Returns true if |global| is initialized once from a constant of at least
+// |minSize| bytes and all of its uses are able to page it in.
+static bool isPageableGlobal(ConstantGlobal &global, int64_t minSize) {
+  if (global.globalOp.isMutable() || global.hasIndirectUses ||
+      global.storeOps.size() != 1) {
+    return false;
+  }
+  auto constantOp = global.storeOps.front()
+                        .value()
+                        .getDefiningOp<IREE::Stream::AsyncConstantOp>();
+  if (!constantOp || !constantOp.result().hasOneUse()) return false;
+  APInt size;
+  if (!matchPattern(constantOp.result_size(), m_ConstantInt(&size)) ||
+      size.getSExtValue() < minSize) {
+    return false;
+  }
+  for (auto loadOp : global.loadOps) {
+    for (auto *user : loadOp.result().getUsers()) {
+      if (!isPageableUse(user)) return false;
+    }
+  }
+  return true;
+}
+
+// Changes |global| to a staging resource and inserts transfers to transient
+// device resources before each use. The constant data is never resident on
+// the device outside of the execution regions consuming it.
+static void pageGlobal(ConstantGlobal &global) {
+  auto constantOp = global.storeOps.front()
+                        .value()
+                        .getDefiningOp<IREE::Stream::AsyncConstantOp>();
+  auto stagingType = IREE::Stream::ResourceType::get(
+      constantOp.getContext(), IREE::Stream::Lifetime::Staging);
+  auto transientType = IREE::Stream::ResourceType::get(
+      constantOp.getContext(), IREE::Stream::Lifetime::Transient);
+  global.globalOp.typeAttr(TypeAttr::get(stagingType));
+  constantOp.result().setType(stagingType);
+
+  for (auto loadOp : global.loadOps) {
+    loadOp.result().setType(stagingType);
+    for (auto &use : llvm::make_early_inc_range(loadOp.result().getUses())) {
+      auto *user = use.getOwner();
+      if (isa<IREE::Stream::ResourceSizeOp>(user) ||
+          isa<IREE::Stream::AsyncTransferOp>(user)) {
+        continue;
+      }
+      // Each use gets its own transfer so that the scheduler is able to place
+      // it just ahead of its consumer and overlap it with prior work.
+      auto sizeAwareOp = cast<IREE::Util::SizeAwareOpInterface>(user);
+      auto size = sizeAwareOp.getOperandSize(use.getOperandNumber());
+      auto affinityAttr = IREE::Stream::AffinityAttr::lookup(user);
+      OpBuilder builder(user);
+      auto transferOp = builder.create<IREE::Stream::AsyncTransferOp>(
+          loadOp.getLoc(), transientType, use.get(), size, size,
+          /*source_affinity=*/affinityAttr,
+          /*result_affinity=*/affinityAttr);
+      use.set(transferOp.result());
+    }
+  }
+}
+
+class PageConstantsPass : public PageConstantsBase<PageConstantsPass> {
+ public:
+  PageConstantsPass() = default;
+  PageConstantsPass(const PageConstantsPass &pass) {}
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::Stream::StreamDialect>();
+    registry.insert<IREE::Util::UtilDialect>();
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+
+    // Gather all constant resource globals and their accessors.
+    SmallVector<ConstantGlobal> globals;
+    DenseMap<StringRef, size_t> globalOrdinals;
+    for (auto globalOp : moduleOp.getOps<IREE::Util::GlobalOp>()) {
+      auto resourceType =
+          globalOp.type().dyn_cast<IREE::Stream::ResourceType>();
+      if (!resourceType ||
+          resourceType.getLifetime() != IREE::Stream::Lifetime::Constant) {
+        continue;
+      }
+      globalOrdinals[globalOp.getName()] = globals.size();
+      globals.push_back({globalOp});
+    }
+    if (globals.empty()) return;
+    moduleOp.walk([&](Operation *op) {
+      if (auto loadOp = dyn_cast<IREE::Util::GlobalLoadOp>(op)) {
+        auto it = globalOrdinals.find(loadOp.global());
+        if (it != globalOrdinals.end()) {
+          globals[it->second].loadOps.push_back(loadOp);
+        }
+      } else if (auto storeOp = dyn_cast<IREE::Util::GlobalStoreOp>(op)) {
+        auto it = globalOrdinals.find(storeOp.global());
+        if (it != globalOrdinals.end()) {
+          globals[it->second].storeOps.push_back(storeOp);
+        }
+      } else if (auto addressOp = dyn_cast<IREE::Util::GlobalAddressOp>(op)) {
+        auto it = globalOrdinals.find(addressOp.global());
+        if (it != globalOrdinals.end()) {
+          globals[it->second].hasIndirectUses = true;
+        }
+      }
+    });
+
+    for (auto &global : globals) {
+      if (!isPageableGlobal(global, minSize)) continue;
+      LLVM_DEBUG(llvm::dbgs() << "paging constant global @"
+                              << global.globalOp.getName() << "\n");
+      pageGlobal(global);
+      ++numPagedGlobals;
+    }
+  }
+
+ private:
+  Statistic numPagedGlobals{this, "paged constant globals",
+                            "Number of constant globals paged from host"};
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createPageConstantsPass() {
+  return std::make_unique<PageConstantsPass>();
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
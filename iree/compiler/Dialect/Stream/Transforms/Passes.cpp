@@ -131,12 +131,26 @@ void buildStreamAsyncPassPipeline(OpPassManager &passManager,
       IREE::Stream::createMaterializeCopyOnWritePass());
   passManager.addPass(IREE::Stream::createElideAsyncCopiesPass());
 
+  // Place dispatches of executables pinned to a device and optionally small
+  // dispatches on a fallback device, transferring resources between devices
+  // where producers and consumers differ in placement. This happens before
+  // usage refinement so that the transfers are accounted for.
+  passManager.addPass(IREE::Stream::createPlaceExecutionPass(
+      transformOptions.fallbackDevice, transformOptions.fallbackMaxCost));
+
   // Refine lifetime of all resources across the module.
   // We do this after scheduling execution so that we know how the resources
   // move across devices. We do it before scheduling waves as lifetime doesn't
   // change and it makes the IR cleaner.
   passManager.addPass(IREE::Stream::createRefineUsagePass());
 
+  // Optionally keep large constants in host memory and page them onto devices
+  // as they are used. This lets models with more constant data than fits in
+  // device memory run at the cost of the transfers.
+  if (transformOptions.pageConstants) {
+    passManager.addPass(IREE::Stream::createPageConstantsPass());
+  }
+
   //----------------------------------------------------------------------------
   // Stream formation and scheduling
   //----------------------------------------------------------------------------
@@ -192,9 +206,11 @@ void buildStreamCmdPassPipeline(OpPassManager &passManager,
 
   // Pack fused allocations based on lifetime.
   passManager.addNestedPass<IREE::Util::InitializerOp>(
-      IREE::Stream::createPackAllocationsPass());
+      IREE::Stream::createPackAllocationsPass(
+          transformOptions.reuseTransientSlabs));
   passManager.addNestedPass<mlir::FuncOp>(
-      IREE::Stream::createPackAllocationsPass());
+      IREE::Stream::createPackAllocationsPass(
+          transformOptions.reuseTransientSlabs));
 
   // Layout packed slices to emit the arithmetic required for all resource
   // offsets. This enables us to propagate the subviews across the program
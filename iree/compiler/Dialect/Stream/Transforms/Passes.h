@@ -35,6 +35,38 @@ struct TransformOptions : public PassPipelineOptions<TransformOptions> {
       llvm::cl::init(true),
   };
 
+  Option<bool> pageConstants{
+      *this,
+      "page-constants",
+      llvm::cl::desc("Keeps large constants in host memory and transfers them "
+                     "to devices just ahead of their uses."),
+      llvm::cl::init(false),
+  };
+
+  Option<int64_t> fallbackDevice{
+      *this,
+      "fallback-device",
+      llvm::cl::desc("Ordinal of a device (such as a CPU) that small "
+                     "dispatches are placed on instead of the default device; "
+                     "-1 disables fallback placement."),
+      llvm::cl::init(-1),
+  };
+  Option<int64_t> fallbackMaxCost{
+      *this,
+      "fallback-max-cost",
+      llvm::cl::desc("Maximum estimated execution cost of a dispatch for it "
+                     "to be placed on the fallback device."),
+      llvm::cl::init(16384),
+  };
+
+  Option<bool> reuseTransientSlabs{
+      *this,
+      "reuse-transient-slabs",
+      llvm::cl::desc("Shares transient slabs across execution regions with "
+                     "disjoint transient lifetimes."),
+      llvm::cl::init(false),
+  };
+
   Option<DumpOutputFormat> dumpStatisticsFormat{
       *this,
       "dump-statistics-format",
@@ -46,7 +78,9 @@ struct TransformOptions : public PassPipelineOptions<TransformOptions> {
           clEnumValN(IREE::Stream::DumpOutputFormat::Verbose, "verbose",
                      "Pretty printed output with additional IR."),
           clEnumValN(IREE::Stream::DumpOutputFormat::CSV, "csv",
-                     "Comma separated values.")),
+                     "Comma separated values."),
+          clEnumValN(IREE::Stream::DumpOutputFormat::JSON, "json",
+                     "JSON output with structures for data exchange.")),
   };
   Option<std::string> dumpStatisticsFile{
       *this,
@@ -112,7 +146,10 @@ std::unique_ptr<OperationPass<>> createEncodeDeviceTensorsPass();
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createMaterializeBuiltinsPass();
 std::unique_ptr<OperationPass<>> createMaterializeCopyOnWritePass();
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createElideAsyncCopiesPass();
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createPlaceExecutionPass(
+    int64_t fallbackDevice = -1, int64_t fallbackMaxCost = 16384);
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createRefineUsagePass();
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createPageConstantsPass();
 
 //===----------------------------------------------------------------------===//
 // Stream formation and scheduling
@@ -130,7 +167,8 @@ std::unique_ptr<OperationPass<mlir::ModuleOp>> createPropagateTimepointsPass();
 std::unique_ptr<OperationPass<>> createScheduleAllocationPass();
 
 std::unique_ptr<OperationPass<>> createPackConstantsPass();
-std::unique_ptr<OperationPass<>> createPackAllocationsPass();
+std::unique_ptr<OperationPass<>> createPackAllocationsPass(
+    bool reuseTransientSlabs = false);
 std::unique_ptr<OperationPass<>> createLayoutSlicesPass();
 
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createPropagateSubviewsPass();
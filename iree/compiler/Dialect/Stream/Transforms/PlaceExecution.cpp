@@ -0,0 +1,187 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Stream/Analysis/Partitioning.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamTypes.h"
+#include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-stream-place-execution"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+namespace {
+
+//===----------------------------------------------------------------------===//
+// -iree-stream-place-execution
+//===----------------------------------------------------------------------===//
+
+// Returns the affinity of the device |value| is produced on or null for the
+// default device.
+static IREE::Stream::AffinityAttr lookupValueAffinity(Value value) {
+  if (auto transferOp = value.getDefiningOp<IREE::Stream::AsyncTransferOp>()) {
+    return transferOp.result_affinityAttr();
+  }
+  if (auto *definingOp = value.getDefiningOp()) {
+    return IREE::Stream::AffinityAttr::lookup(definingOp);
+  }
+  return IREE::Stream::AffinityAttr::lookup(
+      value.getParentBlock()->getParentOp());
+}
+
+// Returns true if |user| consumes resources without needing them to be on the
+// device it runs on.
+static bool isPlacementAgnosticUse(Operation *user) {
+  if (isa<IREE::Stream::ResourceSizeOp>(user) ||
+      isa<IREE::Stream::AsyncTransferOp>(user)) {
+    return true;
+  }
+  auto streamableOp = dyn_cast<IREE::Stream::StreamableOpInterface>(user);
+  return streamableOp && streamableOp.isMetadata();
+}
+
+class PlaceExecutionPass : public PlaceExecutionBase<PlaceExecutionPass> {
+ public:
+  PlaceExecutionPass() = default;
+  PlaceExecutionPass(const PlaceExecutionPass &pass) {}
+  PlaceExecutionPass(int64_t fallbackDevice, int64_t fallbackMaxCost) {
+    this->fallbackDevice = fallbackDevice;
+    this->fallbackMaxCost = fallbackMaxCost;
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::Stream::StreamDialect>();
+    registry.insert<IREE::Util::UtilDialect>();
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    SymbolTable symbolTable(moduleOp);
+
+    // Place all dispatches first so that transfers are only inserted between
+    // the final placements.
+    SmallVector<IREE::Stream::AsyncDispatchOp> placedOps;
+    moduleOp.walk([&](IREE::Stream::AsyncDispatchOp dispatchOp) {
+      if (IREE::Stream::AffinityAttr::lookup(dispatchOp)) return;
+      auto affinityAttr = selectAffinity(dispatchOp, symbolTable);
+      if (!affinityAttr) return;
+      LLVM_DEBUG(llvm::dbgs() << "placing " << dispatchOp.entry_point()
+                              << " on " << affinityAttr << "\n");
+      dispatchOp.affinityAttr(affinityAttr);
+      placedOps.push_back(dispatchOp);
+      ++numPlacedDispatches;
+    });
+
+    for (auto dispatchOp : placedOps) {
+      insertTransfers(dispatchOp);
+    }
+  }
+
+ private:
+  // Returns the affinity |dispatchOp| should be placed on or null if it should
+  // run on the default device.
+  IREE::Stream::AffinityAttr selectAffinity(
+      IREE::Stream::AsyncDispatchOp dispatchOp, SymbolTable &symbolTable) {
+    // Executables may be pinned to a device, such as when their contents are
+    // only supported by one of the targets.
+    auto executableOp = symbolTable.lookup<IREE::Stream::ExecutableOp>(
+        dispatchOp.entry_point().getRootReference().getValue());
+    if (executableOp) {
+      if (auto affinityAttr =
+              executableOp->getAttrOfType<IREE::Stream::AffinityAttr>(
+                  "stream.affinity")) {
+        return affinityAttr;
+      }
+    }
+
+    // Small dispatches with static workgroup counts are cheaper to run on the
+    // fallback device than to pay the launch overhead of the default device.
+    if (fallbackDevice < 0) return {};
+    for (auto workgroupCount : dispatchOp.workgroup_count()) {
+      if (!matchPattern(workgroupCount, m_Constant())) return {};
+    }
+    if (estimateExecutionCost(dispatchOp) > fallbackMaxCost) return {};
+    return IREE::Stream::AffinityAttr::get(dispatchOp.getContext(),
+                                           fallbackDevice);
+  }
+
+  // Inserts transfers of the resources |dispatchOp| consumes and produces
+  // where their producers or consumers are placed on other devices.
+  void insertTransfers(IREE::Stream::AsyncDispatchOp dispatchOp) {
+    auto affinityAttr = dispatchOp.affinityAttr();
+    auto sizeAwareOp =
+        cast<IREE::Util::SizeAwareOpInterface>(dispatchOp.getOperation());
+
+    OpBuilder beforeBuilder(dispatchOp);
+    for (auto &operand : dispatchOp->getOpOperands()) {
+      if (!operand.get().getType().isa<IREE::Stream::ResourceType>()) continue;
+      auto sourceAffinityAttr = lookupValueAffinity(operand.get());
+      if (sourceAffinityAttr == affinityAttr) continue;
+      auto size = sizeAwareOp.getOperandSize(operand.getOperandNumber());
+      auto transferOp = beforeBuilder.create<IREE::Stream::AsyncTransferOp>(
+          dispatchOp.getLoc(), operand.get().getType(), operand.get(), size,
+          size, sourceAffinityAttr, affinityAttr);
+      operand.set(transferOp.result());
+      ++numTransfers;
+    }
+
+    OpBuilder afterBuilder(dispatchOp);
+    afterBuilder.setInsertionPointAfter(dispatchOp);
+    for (auto result : dispatchOp.results()) {
+      auto size = sizeAwareOp.getResultSize(result.getResultNumber());
+      // One transfer per target device shared by all consumers on it.
+      DenseMap<Attribute, Value> transferredValues;
+      for (auto &use : llvm::make_early_inc_range(result.getUses())) {
+        auto *user = use.getOwner();
+        if (isPlacementAgnosticUse(user)) continue;
+        auto targetAffinityAttr = IREE::Stream::AffinityAttr::lookup(user);
+        if (targetAffinityAttr == affinityAttr) continue;
+        auto &transferredValue = transferredValues[targetAffinityAttr];
+        if (!transferredValue) {
+          transferredValue =
+              afterBuilder
+                  .create<IREE::Stream::AsyncTransferOp>(
+                      dispatchOp.getLoc(), result.getType(), result, size, size,
+                      affinityAttr, targetAffinityAttr)
+                  .result();
+          ++numTransfers;
+        }
+        use.set(transferredValue);
+      }
+    }
+  }
+
+  Statistic numPlacedDispatches{this, "placed dispatches",
+                                "Number of dispatches placed on a device"};
+  Statistic numTransfers{this, "inserted transfers",
+                         "Number of transfers inserted between devices"};
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createPlaceExecutionPass(
+    int64_t fallbackDevice, int64_t fallbackMaxCost) {
+  return std::make_unique<PlaceExecutionPass>(fallbackDevice, fallbackMaxCost);
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -1,5 +1,6 @@
 // RUN: iree-opt -split-input-file -pass-pipeline=iree-stream-dump-statistics{output-format=pretty} %s 2>&1 | FileCheck %s -check-prefix=CHECK-PRETTY
 // RUN: iree-opt -split-input-file -pass-pipeline=iree-stream-dump-statistics{output-format=csv} %s 2>&1 | FileCheck %s -check-prefix=CHECK-CSV
+// RUN: iree-opt -split-input-file -pass-pipeline=iree-stream-dump-statistics{output-format=json} %s 2>&1 | FileCheck %s -check-prefix=CHECK-JSON
 
 // CHECK-PRETTY: Aggregate Statistics
 // CHECK-PRETTY:   Constants: 1, 0 B
@@ -11,10 +12,39 @@
 // CHECK-PRETTY:  Dispatches: 3
 // CHECK-PRETTY: Executables: 2, 33% reuse
 
+// CHECK-PRETTY: Streams
+// CHECK-PRETTY: stream.cmd.execute
+// CHECK-PRETTY:   Commands: 0 fills, 1 copies, 0 dispatches
+// CHECK-PRETTY:      Waves: 0, 0 of 1 commands concurrent
+// CHECK-PRETTY:   Commands: 0 fills, 0 copies, 3 dispatches
+// CHECK-PRETTY:      Waves: 0, 0 of 3 commands concurrent
+
 // CHECK-CSV: ; Aggregate Statistics
 // CHECK-CSV: "Constants","Constant Size","Variables","Variable Size","Awaits","Submissions","Transient Size","Fills","Copies","Dispatches","Executables"
 // CHECK-CSV: 1,0,0,0,2,3,0,0,2,3,2
 
+// CHECK-JSON: "stream-aggregate": {
+// CHECK-JSON: "dispatch-count": 3
+// CHECK-JSON: "dispatches": [
+// CHECK-JSON-NEXT:   {
+// CHECK-JSON-NEXT:     "executable": "func_a_ex_0",
+// CHECK-JSON-NEXT:     "entry-point": "dispatch_0",
+// CHECK-JSON-NEXT:     "caller": "func_a",
+// CHECK-JSON-NEXT:     "workgroup-count": [4, 1, 1],
+// CHECK-JSON-NEXT:     "workgroups": 4,
+// CHECK-JSON-NEXT:     "estimated-flops": 4,
+// CHECK-JSON-NEXT:     "bytes-read": 32,
+// CHECK-JSON-NEXT:     "bytes-written": 16,
+// CHECK-JSON-NEXT:     "transient-bytes": 0,
+// CHECK-JSON-NEXT:     "arithmetic-intensity": 0.0833
+// CHECK-JSON-NEXT:   },
+// CHECK-JSON:          "entry-point": "dispatch_0",
+// CHECK-JSON:          "executable": "func_a_ex_1",
+// CHECK-JSON-NEXT:     "entry-point": "dispatch_1",
+// CHECK-JSON:          "estimated-flops": 3,
+// CHECK-JSON:        }
+// CHECK-JSON-NEXT: ]
+
 util.global private mutable @_constant__timepoint = #stream.timepoint<immediate>
 util.global private @_constant : !stream.resource<constant>
 util.initializer {
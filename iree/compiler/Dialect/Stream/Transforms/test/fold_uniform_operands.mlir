@@ -95,3 +95,64 @@ func @inlineConstantOperands(%a: i32) {
   } => !stream.timepoint
   return
 }
+
+// -----
+
+// Tests that operands that differ from an earlier operand by a uniform delta
+// at all dispatch sites are rebased on the earlier operand.
+//
+// In this test %b is always %a + 200 and folded, %c is %a + 300 at the first
+// site but %a + 400 at the second and kept, and %d is always %x + 16 and
+// folded onto %x.
+
+// CHECK-LABEL: @foldDeltaOperandsEx
+stream.executable private @foldDeltaOperandsEx {
+  stream.executable.export public @dispatch
+  builtin.module  {
+    // CHECK: func @dispatch(%[[BINDING:.+]]: !stream.binding, %[[A:.+]]: index, %[[C:.+]]: index, %[[X:.+]]: index)
+    func @dispatch(%binding: !stream.binding, %a: index, %b: index, %c: index, %x: index, %d: index) {
+      // CHECK-DAG: %[[C200:.+]] = arith.constant 200 : index
+      // CHECK-DAG: %[[B:.+]] = arith.addi %[[A]], %[[C200]] : index
+      // CHECK-DAG: %[[C16:.+]] = arith.constant 16 : index
+      // CHECK-DAG: %[[D:.+]] = arith.addi %[[X]], %[[C16]] : index
+      // CHECK: util.do_not_optimize(%[[A]]) : index
+      util.do_not_optimize(%a) : index
+      // CHECK-NEXT: util.do_not_optimize(%[[B]]) : index
+      util.do_not_optimize(%b) : index
+      // CHECK-NEXT: util.do_not_optimize(%[[C]]) : index
+      util.do_not_optimize(%c) : index
+      // CHECK-NEXT: util.do_not_optimize(%[[X]]) : index
+      util.do_not_optimize(%x) : index
+      // CHECK-NEXT: util.do_not_optimize(%[[D]]) : index
+      util.do_not_optimize(%d) : index
+      return
+    }
+  }
+}
+// CHECK: func @foldDeltaOperands(%[[X0:.+]]: index, %[[X1:.+]]: index)
+func @foldDeltaOperands(%x0: index, %x1: index) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c16 = arith.constant 16 : index
+  %c20 = arith.constant 20 : index
+  %c100 = arith.constant 100 : index
+  %c300 = arith.constant 300 : index
+  %c400 = arith.constant 400 : index
+  %c1100 = arith.constant 1100 : index
+  %c1300 = arith.constant 1300 : index
+  %c1500 = arith.constant 1500 : index
+  %d0 = arith.addi %x0, %c16 : index
+  %d1 = arith.addi %x1, %c16 : index
+  %alloc = stream.resource.alloc uninitialized : !stream.resource<transient>{%c20}
+  %result_timepoint = stream.cmd.execute with(%alloc as %capture: !stream.resource<transient>{%c20}) {
+    // CHECK: stream.cmd.dispatch {{.+}}(%c100, %c400, %[[X0]] : index, index, index)
+    stream.cmd.dispatch @foldDeltaOperandsEx::@dispatch[%c1, %c1, %c1](%c100, %c300, %c400, %x0, %d0 : index, index, index, index, index) {
+      rw %capture[%c0 for %c20] : !stream.resource<transient>{%c20}
+    }
+    // CHECK: stream.cmd.dispatch {{.+}}(%c1100, %c1500, %[[X1]] : index, index, index)
+    stream.cmd.dispatch @foldDeltaOperandsEx::@dispatch[%c1, %c1, %c1](%c1100, %c1300, %c1500, %x1, %d1 : index, index, index, index, index) {
+      rw %capture[%c0 for %c20] : !stream.resource<transient>{%c20}
+    }
+  } => !stream.timepoint
+  return
+}
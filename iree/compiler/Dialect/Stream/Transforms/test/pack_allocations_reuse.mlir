@@ -0,0 +1,69 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-stream-pack-allocations{reuse-transient-slabs=true})' %s | FileCheck %s
+
+// Tests that the transient slabs of execution regions that run one after
+// another are packed into a single slab with disjoint lifetime intervals so
+// that the memory is reused. The second region must wait on the first to
+// complete before reusing its memory.
+
+// CHECK-LABEL: @reuseTransientSlabs
+// CHECK-SAME: (%[[AWAIT_TIMEPOINT:.+]]: !stream.timepoint)
+func @reuseTransientSlabs(%await_timepoint: !stream.timepoint) -> !stream.timepoint {
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %c256 = arith.constant 256 : index
+  %c255_i32 = arith.constant 255 : i32
+
+  //      CHECK: %[[SLICES:.+]]:3 = stream.resource.pack slices({
+  // CHECK-NEXT:   [4, 6] = %c128,
+  // CHECK-NEXT:   [7, 9] = %c256
+  // CHECK-NEXT: }) : index
+  // CHECK-NEXT: %[[SLAB:.+]], %[[SLAB_TIMEPOINT:.+]] = stream.resource.alloca uninitialized await(%[[AWAIT_TIMEPOINT]]) => !stream.resource<transient>{%[[SLICES]]#0} => !stream.timepoint
+  // CHECK-NEXT: %[[SLICE0:.+]] = stream.resource.subview %[[SLAB]][%[[SLICES]]#1]
+  // CHECK-SAME: !stream.resource<transient>{%[[SLICES]]#0} -> !stream.resource<transient>{%c128}
+  %alloca0, %alloca0_timepoint = stream.resource.alloca uninitialized await(%await_timepoint) => !stream.resource<transient>{%c128} => !stream.timepoint
+  // CHECK: %[[EXEC0:.+]] = stream.cmd.execute await(%[[SLAB_TIMEPOINT]]) => with(%[[SLICE0]] as
+  %exec0 = stream.cmd.execute await(%alloca0_timepoint) => with(%alloca0 as %capture0: !stream.resource<transient>{%c128}) {
+    stream.cmd.fill %c255_i32, %capture0[%c0 for %c128] : i32 -> !stream.resource<transient>{%c128}
+  } => !stream.timepoint
+  // CHECK-NOT: stream.resource.dealloca
+  %dealloca0_timepoint = stream.resource.dealloca await(%exec0) => %alloca0 : !stream.resource<transient>{%c128} => !stream.timepoint
+
+  // CHECK: %[[SLICE1:.+]] = stream.resource.subview %[[SLAB]][%[[SLICES]]#2]
+  // CHECK-SAME: !stream.resource<transient>{%[[SLICES]]#0} -> !stream.resource<transient>{%c256}
+  // CHECK-NEXT: %[[READY1:.+]] = stream.timepoint.join max(%[[SLAB_TIMEPOINT]], %[[EXEC0]]) => !stream.timepoint
+  %alloca1, %alloca1_timepoint = stream.resource.alloca uninitialized await(%exec0) => !stream.resource<transient>{%c256} => !stream.timepoint
+  // CHECK: %[[EXEC1:.+]] = stream.cmd.execute await(%[[READY1]]) => with(%[[SLICE1]] as
+  %exec1 = stream.cmd.execute await(%alloca1_timepoint) => with(%alloca1 as %capture1: !stream.resource<transient>{%c256}) {
+    stream.cmd.fill %c255_i32, %capture1[%c0 for %c256] : i32 -> !stream.resource<transient>{%c256}
+  } => !stream.timepoint
+
+  // CHECK: %[[RELEASE:.+]] = stream.timepoint.join max(%[[EXEC0]], %[[EXEC1]]) => !stream.timepoint
+  // CHECK-NEXT: %[[DEALLOCA_TIMEPOINT:.+]] = stream.resource.dealloca await(%[[RELEASE]]) => %[[SLAB]] : !stream.resource<transient>{%[[SLICES]]#0} => !stream.timepoint
+  %dealloca1_timepoint = stream.resource.dealloca await(%exec1) => %alloca1 : !stream.resource<transient>{%c256} => !stream.timepoint
+
+  // CHECK: %[[JOIN:.+]] = stream.timepoint.join max(%[[EXEC0]], %[[DEALLOCA_TIMEPOINT]], %[[EXEC1]]) => !stream.timepoint
+  %join = stream.timepoint.join max(%dealloca0_timepoint, %dealloca1_timepoint, %exec1) => !stream.timepoint
+  // CHECK: return %[[JOIN]]
+  return %join : !stream.timepoint
+}
+
+// -----
+
+// Tests that slabs whose sizes are not available where the first slab is
+// allocated are left as-is.
+
+// CHECK-LABEL: @unavailableSlabSize
+func @unavailableSlabSize(%size0: index, %size1_base: index) {
+  %c255_i32 = arith.constant 255 : i32
+  // CHECK: stream.resource.alloca uninitialized : !stream.resource<transient>{%arg0}
+  %alloca0, %alloca0_timepoint = stream.resource.alloca uninitialized : !stream.resource<transient>{%size0} => !stream.timepoint
+  %dealloca0_timepoint = stream.resource.dealloca await(%alloca0_timepoint) => %alloca0 : !stream.resource<transient>{%size0} => !stream.timepoint
+  %size1 = arith.addi %size1_base, %size0 : index
+  // CHECK: stream.resource.alloca uninitialized : !stream.resource<transient>{%[[SIZE1:.+]]}
+  %alloca1, %alloca1_timepoint = stream.resource.alloca uninitialized : !stream.resource<transient>{%size1} => !stream.timepoint
+  %dealloca1_timepoint = stream.resource.dealloca await(%alloca1_timepoint) => %alloca1 : !stream.resource<transient>{%size1} => !stream.timepoint
+  // CHECK-NOT: stream.resource.pack
+  util.do_not_optimize(%dealloca0_timepoint) : !stream.timepoint
+  util.do_not_optimize(%dealloca1_timepoint) : !stream.timepoint
+  return
+}
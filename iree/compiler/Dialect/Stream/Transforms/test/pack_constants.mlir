@@ -109,3 +109,31 @@ func @splitResourceConstants() -> (!stream.resource<constant>, !stream.resource<
   // CHECK: return %[[RES0]], %[[RES1]], %[[IF]]#2
   return %0#0, %0#1, %0#2 : !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint
 }
+
+// -----
+
+// Tests that staging constants (such as those paged in on use) are directly
+// mapped from the host data and never uploaded.
+
+// CHECK-LABEL: @stagingResourceConstants
+func @stagingResourceConstants() -> (!stream.resource<staging>, !stream.resource<staging>, !stream.timepoint) {
+  %c4 = arith.constant 4 : index
+  %c8 = arith.constant 8 : index
+
+  // CHECK: %[[RODATA:.+]] = util.byte_buffer.constant {alignment = 32 : i64} : !util.byte_buffer = #composite_of_64b
+  %0:3 = stream.resource.constants :
+    !stream.resource<staging>{%c4} = dense<100> : tensor<1xi32>,
+    !stream.resource<staging>{%c8} = dense<[101, 102]> : tensor<2xi32>
+    => !stream.timepoint
+
+  // CHECK-NOT: stream.resource.try_map
+  // CHECK: %[[STAGING:.+]] = stream.resource.map %[[RODATA]][%c0] : !util.byte_buffer -> !stream.resource<staging>{%c64}
+  // CHECK-NEXT: %[[IMMEDIATE:.+]] = stream.timepoint.immediate => !stream.timepoint
+  // CHECK-NOT: stream.cmd.execute
+
+  // CHECK: %[[RES0:.+]] = stream.resource.subview %[[STAGING]][%c0] : !stream.resource<staging>{%c64} -> !stream.resource<staging>{%c4}
+  // CHECK: %[[RES1:.+]] = stream.resource.subview %[[STAGING]][%c32] : !stream.resource<staging>{%c64} -> !stream.resource<staging>{%c8}
+
+  // CHECK: return %[[RES0]], %[[RES1]], %[[IMMEDIATE]]
+  return %0#0, %0#1, %0#2 : !stream.resource<staging>, !stream.resource<staging>, !stream.timepoint
+}
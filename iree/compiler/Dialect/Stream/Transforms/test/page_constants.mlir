@@ -0,0 +1,64 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='iree-stream-page-constants{min-size=16}' %s | FileCheck %s
+
+// Tests that large constants are kept in host staging memory and transferred
+// to transient device resources ahead of each use.
+
+// CHECK: util.global private @large : !stream.resource<staging>
+util.global private @large : !stream.resource<constant>
+util.global private @large__size : index
+// CHECK: util.global private @small : !stream.resource<constant>
+util.global private @small : !stream.resource<constant>
+util.global private @small__size : index
+util.initializer {
+  %c4 = arith.constant 4 : index
+  %c32 = arith.constant 32 : index
+  // CHECK: stream.async.constant : !stream.resource<staging>{%c32}
+  %large = stream.async.constant : !stream.resource<constant>{%c32} = dense<1> : tensor<8xi32>
+  util.global.store %large, @large : !stream.resource<constant>
+  util.global.store %c32, @large__size : index
+  // CHECK: stream.async.constant : !stream.resource<constant>{%c4}
+  %small = stream.async.constant : !stream.resource<constant>{%c4} = dense<2> : tensor<1xi32>
+  util.global.store %small, @small : !stream.resource<constant>
+  util.global.store %c4, @small__size : index
+  util.initializer.return
+}
+
+// CHECK-LABEL: @pageConstants
+func @pageConstants() -> !stream.resource<external> {
+  %c1 = arith.constant 1 : index
+  %c128 = arith.constant 128 : index
+  // CHECK: %[[LARGE:.+]] = util.global.load @large : !stream.resource<staging>
+  %large = util.global.load @large : !stream.resource<constant>
+  %large_size = util.global.load @large__size : index
+  // CHECK: %[[SMALL:.+]] = util.global.load @small : !stream.resource<constant>
+  %small = util.global.load @small : !stream.resource<constant>
+  %small_size = util.global.load @small__size : index
+  // CHECK: %[[PAGE0:.+]] = stream.async.transfer %[[LARGE]] : !stream.resource<staging>{%[[LARGE_SIZE:.+]]} -> !stream.resource<transient>{%[[LARGE_SIZE]]}
+  // CHECK-NEXT: %[[RESULT0:.+]] = stream.async.dispatch @ex::@dispatch_0[%c1, %c1, %c1](%[[PAGE0]], %[[SMALL]])
+  %0 = stream.async.dispatch @ex::@dispatch_0[%c1, %c1, %c1](%large, %small) : (!stream.resource<constant>{%large_size}, !stream.resource<constant>{%small_size}) -> !stream.resource<transient>{%c128}
+  // CHECK: %[[PAGE1:.+]] = stream.async.transfer %[[LARGE]] : !stream.resource<staging>{%[[LARGE_SIZE]]} -> !stream.resource<transient>{%[[LARGE_SIZE]]}
+  // CHECK-NEXT: stream.async.dispatch @ex::@dispatch_1[%c1, %c1, %c1](%[[RESULT0]], %[[PAGE1]])
+  %1 = stream.async.dispatch @ex::@dispatch_1[%c1, %c1, %c1](%0, %large) : (!stream.resource<transient>{%c128}, !stream.resource<constant>{%large_size}) -> !stream.resource<external>{%c128}
+  return %1 : !stream.resource<external>
+}
+
+// -----
+
+// Tests that constants that escape through calls are left resident.
+
+// CHECK: util.global private @escaping : !stream.resource<constant>
+util.global private @escaping : !stream.resource<constant>
+util.initializer {
+  %c32 = arith.constant 32 : index
+  %0 = stream.async.constant : !stream.resource<constant>{%c32} = dense<1> : tensor<8xi32>
+  util.global.store %0, @escaping : !stream.resource<constant>
+  util.initializer.return
+}
+func private @consume(!stream.resource<constant>)
+// CHECK-LABEL: @escapingConstant
+func @escapingConstant() {
+  // CHECK: util.global.load @escaping : !stream.resource<constant>
+  %0 = util.global.load @escaping : !stream.resource<constant>
+  call @consume(%0) : (!stream.resource<constant>) -> ()
+  return
+}
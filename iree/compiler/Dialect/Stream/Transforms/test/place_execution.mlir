@@ -0,0 +1,60 @@
+// RUN: iree-opt -split-input-file -iree-stream-place-execution="fallback-device=1 fallback-max-cost=8192" %s | FileCheck %s
+
+// Tests that small dispatches are placed on the fallback device with transfers
+// to and from the dispatches that remain on the default device.
+
+// CHECK-LABEL: @placeSmallDispatches
+// CHECK-SAME: (%[[INPUT:.+]]: !stream.resource<*>, %[[INPUT_SIZE:.+]]: index)
+func @placeSmallDispatches(%input: !stream.resource<*>, %input_size: index) -> !stream.resource<*> {
+  %c1 = arith.constant 1 : index
+  %c64 = arith.constant 64 : index
+  %c128 = arith.constant 128 : index
+  // CHECK: %[[LARGE0:.+]] = stream.async.dispatch @ex::@large[%c64, %c1, %c1](%[[INPUT]])
+  %large0 = stream.async.dispatch @ex::@large[%c64, %c1, %c1](%input) : (!stream.resource<*>{%input_size}) -> !stream.resource<*>{%c128}
+  // CHECK: %[[TO_FALLBACK:.+]] = stream.async.transfer %[[LARGE0]] : !stream.resource<*>{%c128} -> to(#stream.affinity<device = 1>) !stream.resource<*>{%c128}
+  // CHECK: %[[SMALL:.+]] = stream.async.dispatch on(#stream.affinity<device = 1>) @ex::@small[%c1, %c1, %c1](%[[TO_FALLBACK]])
+  %small = stream.async.dispatch @ex::@small[%c1, %c1, %c1](%large0) : (!stream.resource<*>{%c128}) -> !stream.resource<*>{%c128}
+  // CHECK: %[[FROM_FALLBACK:.+]] = stream.async.transfer from(#stream.affinity<device = 1>) %[[SMALL]] : !stream.resource<*>{%c128} -> !stream.resource<*>{%c128}
+  // CHECK: %[[LARGE1:.+]] = stream.async.dispatch @ex::@large[%c64, %c1, %c1](%[[FROM_FALLBACK]])
+  %large1 = stream.async.dispatch @ex::@large[%c64, %c1, %c1](%small) : (!stream.resource<*>{%c128}) -> !stream.resource<*>{%c128}
+  // CHECK: return %[[LARGE1]]
+  return %large1 : !stream.resource<*>
+}
+
+// -----
+
+// Tests that dispatches with dynamic workgroup counts stay on the default
+// device as their cost is unknown.
+
+// CHECK-LABEL: @keepDynamicDispatches
+func @keepDynamicDispatches(%input: !stream.resource<*>, %input_size: index, %count: index) -> !stream.resource<*> {
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  // CHECK-NOT: stream.async.transfer
+  // CHECK: stream.async.dispatch @ex::@dynamic[%arg2, %c1, %c1]
+  %0 = stream.async.dispatch @ex::@dynamic[%count, %c1, %c1](%input) : (!stream.resource<*>{%input_size}) -> !stream.resource<*>{%c4}
+  return %0 : !stream.resource<*>
+}
+
+// -----
+
+// Tests that dispatches of executables pinned to a device are placed there
+// regardless of their cost.
+
+stream.executable private @pinned attributes {stream.affinity = #stream.affinity<device = 2>} {
+  stream.executable.export public @dispatch
+}
+
+// CHECK-LABEL: @placePinnedDispatches
+// CHECK-SAME: (%[[INPUT:.+]]: !stream.resource<*>, %[[INPUT_SIZE:.+]]: index)
+func @placePinnedDispatches(%input: !stream.resource<*>, %input_size: index) -> !stream.resource<*> {
+  %c1 = arith.constant 1 : index
+  %c64 = arith.constant 64 : index
+  %c128 = arith.constant 128 : index
+  // CHECK: %[[TO_PINNED:.+]] = stream.async.transfer %[[INPUT]] : !stream.resource<*>{%[[INPUT_SIZE]]} -> to(#stream.affinity<device = 2>) !stream.resource<*>{%[[INPUT_SIZE]]}
+  // CHECK: %[[PINNED:.+]] = stream.async.dispatch on(#stream.affinity<device = 2>) @pinned::@dispatch[%c64, %c1, %c1](%[[TO_PINNED]])
+  %0 = stream.async.dispatch @pinned::@dispatch[%c64, %c1, %c1](%input) : (!stream.resource<*>{%input_size}) -> !stream.resource<*>{%c128}
+  // CHECK: %[[FROM_PINNED:.+]] = stream.async.transfer from(#stream.affinity<device = 2>) %[[PINNED]]
+  // CHECK: return %[[FROM_PINNED]]
+  return %0 : !stream.resource<*>
+}
@@ -98,3 +98,43 @@ func @partitioningForMaxConcurrency(%arg0: !stream.resource<external>, %arg1: !s
   %0 = stream.timepoint.await %result_timepoint => %results : !stream.resource<external>{%c20}
   return %0 : !stream.resource<external>
 }
+
+// -----
+
+// Tests that when favor=balanced-concurrency independent ops are placed in the
+// wave they least slow down: the mid-sized dispatch overlaps with the large one
+// instead of with the small dispatch that depends on the large one.
+
+// CHECK-LABEL: @partitioningForBalancedConcurrency
+// CHECK-SAME: (%[[ARG0:.+]]: !stream.resource<external>)
+func @partitioningForBalancedConcurrency(%arg0: !stream.resource<external>) -> (!stream.resource<external>, !stream.resource<external>)
+    attributes {stream.partitioning = #stream.partitioning_config<"balanced-concurrency">} {
+  %c1 = arith.constant 1 : index
+  %c16 = arith.constant 16 : index
+  %c20 = arith.constant 20 : index
+  %c64 = arith.constant 64 : index
+  %c80 = arith.constant 80 : index
+  %c1280 = arith.constant 1280 : index
+  // CHECK: stream.async.execute
+  %results:2, %result_timepoint = stream.async.execute
+      // CHECK-SAME: with(%[[ARG0]] as %[[ARG0_CAPTURE:.+]]: !stream.resource<external>{%c80})
+      with(%arg0 as %arg1: !stream.resource<external>{%c80})
+      -> (!stream.resource<external>{%c1280}, !stream.resource<external>{%c20}) {
+
+    // CHECK: %[[CON0:.+]]:2 = stream.async.concurrent
+    // CHECK-SAME: with(%[[ARG0_CAPTURE]] as %[[ARG0_CON0_CAPTURE:.+]]: !stream.resource<external>{%c80})
+    // CHECK-NEXT: %[[MID:.+]] = stream.async.dispatch @ex::@mid[%c16, %c1, %c1](%[[ARG0_CON0_CAPTURE]])
+    // CHECK-NEXT: %[[LARGE:.+]] = stream.async.dispatch @ex::@large[%c64, %c1, %c1](%[[ARG0_CON0_CAPTURE]])
+    // CHECK-NEXT: stream.yield %[[MID]], %[[LARGE]]
+    %1 = stream.async.dispatch @ex::@mid[%c16, %c1, %c1](%arg1) : (!stream.resource<external>{%c80}) -> !stream.resource<external>{%c1280}
+    %2 = stream.async.dispatch @ex::@large[%c64, %c1, %c1](%arg1) : (!stream.resource<external>{%c80}) -> !stream.resource<transient>{%c1280}
+
+    // CHECK: %[[SMALL:.+]] = stream.async.dispatch @ex::@small[%c1, %c1, %c1](%[[CON0]]#1)
+    %3 = stream.async.dispatch @ex::@small[%c1, %c1, %c1](%2) : (!stream.resource<transient>{%c1280}) -> !stream.resource<external>{%c20}
+
+    // CHECK-NEXT: stream.yield %[[CON0]]#0, %[[SMALL]]
+    stream.yield %1, %3 : !stream.resource<external>{%c1280}, !stream.resource<external>{%c20}
+  } => !stream.timepoint
+  %0:2 = stream.timepoint.await %result_timepoint => %results#0, %results#1 : !stream.resource<external>{%c1280}, !stream.resource<external>{%c20}
+  return %0#0, %0#1 : !stream.resource<external>, !stream.resource<external>
+}
@@ -6,10 +6,13 @@
 
 #include "iree/compiler/Dialect/VM/Target/Bytecode/BytecodeEncoder.h"
 
+#include <algorithm>
+
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
 #include "iree/compiler/Dialect/VM/Analysis/RegisterAllocation.h"
 #include "iree/compiler/Dialect/VM/IR/VMDialect.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/TypeSwitch.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Diagnostics.h"
 
@@ -187,7 +190,18 @@ class V0BytecodeEncoder : public BytecodeEncoder {
     // this list is small :)
     auto srcDstRegs = registerAllocation_->remapSuccessorRegisters(
         currentOp_, successorIndex);
-    if (failed(ensureAlignment(2)) || failed(writeUint16(srcDstRegs.size()))) {
+
+    // The runtime expects all i32 remappings before all ref remappings so that
+    // it can process each bank without checking the register type. The banks
+    // never alias so a stable partition preserves hazard-free ordering.
+    auto refBegin = std::stable_partition(
+        srcDstRegs.begin(), srcDstRegs.end(),
+        [](const std::pair<Register, Register> &srcDstReg) {
+          return !srcDstReg.first.isRef();
+        });
+    size_t i32Count = std::distance(srcDstRegs.begin(), refBegin);
+    if (failed(ensureAlignment(2)) || failed(writeUint16(srcDstRegs.size())) ||
+        failed(writeUint16(i32Count))) {
       return failure();
     }
     for (auto srcDstReg : srcDstRegs) {
@@ -324,6 +338,56 @@ class V0BytecodeEncoder : public BytecodeEncoder {
   std::vector<std::pair<Block *, size_t>> blockOffsetFixups_;
 };
 
+//===----------------------------------------------------------------------===//
+// Superinstructions
+//===----------------------------------------------------------------------===//
+// Common op sequences are encoded as a single fused instruction so that the
+// interpreter only pays the dispatch overhead once. Fusion is only performed
+// when the intermediate values are not observable by any other op.
+
+// Returns the compare-and-branch opcode fusing |op| with the vm.cond_br
+// |nextOp| consuming its result, if any.
+static Optional<Opcode> matchCompareAndBranch(Operation *op,
+                                              Operation *nextOp) {
+  auto condBranchOp = dyn_cast_or_null<IREE::VM::CondBranchOp>(nextOp);
+  if (!condBranchOp || op->getNumResults() != 1 ||
+      condBranchOp.getCondition() != op->getResult(0) ||
+      !op->getResult(0).hasOneUse()) {
+    return llvm::None;
+  }
+  return llvm::TypeSwitch<Operation *, Optional<Opcode>>(op)
+      .Case([](IREE::VM::CmpEQI32Op) { return Opcode::CondBranchCmpEQI32; })
+      .Case([](IREE::VM::CmpNEI32Op) { return Opcode::CondBranchCmpNEI32; })
+      .Case([](IREE::VM::CmpLTI32SOp) { return Opcode::CondBranchCmpLTI32S; })
+      .Case([](IREE::VM::CmpLTI32UOp) { return Opcode::CondBranchCmpLTI32U; })
+      .Default([](Operation *) { return llvm::None; });
+}
+
+// Encodes |cmpOp| and |condBranchOp| as a compare-and-branch superinstruction:
+//   opcode, lhs, rhs, true branch, false branch
+// The comparison result is never written to a register.
+static LogicalResult encodeCompareAndBranch(
+    Opcode opcode, Operation *cmpOp, IREE::VM::CondBranchOp condBranchOp,
+    VMFuncEncoder &e) {
+  if (failed(e.beginOp(cmpOp)) ||
+      failed(e.encodeOpcode(stringifyOpcode(opcode),
+                            static_cast<int>(opcode))) ||
+      failed(e.encodeOperand(cmpOp->getOperand(0), 0)) ||
+      failed(e.encodeOperand(cmpOp->getOperand(1), 1)) ||
+      failed(e.endOp(cmpOp))) {
+    return failure();
+  }
+  if (failed(e.beginOp(condBranchOp)) ||
+      failed(e.encodeBranch(condBranchOp.getTrueDest(),
+                            condBranchOp.getTrueOperands(), 0)) ||
+      failed(e.encodeBranch(condBranchOp.getFalseDest(),
+                            condBranchOp.getFalseOperands(), 1)) ||
+      failed(e.endOp(condBranchOp))) {
+    return failure();
+  }
+  return success();
+}
+
 }  // namespace
 
 // static
@@ -349,7 +413,22 @@ Optional<EncodedBytecodeFunction> BytecodeEncoder::encodeFunction(
       return llvm::None;
     }
 
-    for (auto &op : block.getOperations()) {
+    for (auto opIt = block.begin(); opIt != block.end(); ++opIt) {
+      Operation &op = *opIt;
+      Operation *nextOp = op.getNextNode();
+      if (auto fusedOpcode = matchCompareAndBranch(&op, nextOp)) {
+        sourceMap.locations.push_back(
+            {static_cast<int32_t>(encoder.getOffset()), op.getLoc()});
+        if (failed(encodeCompareAndBranch(
+                fusedOpcode.getValue(), &op,
+                cast<IREE::VM::CondBranchOp>(nextOp), encoder))) {
+          op.emitOpError() << "failed to encode fused compare-and-branch";
+          return llvm::None;
+        }
+        ++opIt;
+        continue;
+      }
+
       auto serializableOp = dyn_cast<IREE::VM::VMSerializableOp>(op);
       if (!serializableOp) {
         op.emitOpError() << "is not serializable";
@@ -8,6 +8,7 @@
 
 #include <algorithm>
 
+#include "iree/base/internal/lz4.h"
 #include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
@@ -19,6 +20,7 @@
 #include "iree/compiler/Dialect/VM/Target/Bytecode/BytecodeEncoder.h"
 #include "iree/compiler/Dialect/VM/Transforms/Passes.h"
 #include "iree/compiler/Dialect/VM/Utils/CallingConvention.h"
+#include "iree/compiler/Utils/CompileTimeReport.h"
 #include "iree/compiler/Utils/FlatbufferUtils.h"
 #include "iree/compiler/Utils/TracingUtils.h"
 #include "iree/schemas/bytecode_module_def_builder.h"
@@ -57,6 +59,8 @@ struct SerializedConstantRef {
   flatbuffers_uint8_vec_ref_t ref = 0;
   int64_t totalSize = 0;
   uint32_t crc32 = 0;
+  // Size of the data once decompressed if it was compressed and otherwise 0.
+  uint64_t uncompressedSize = 0;
 };
 
 // Serializes a constant attribute to the FlatBuffer as a binary blob.
@@ -108,6 +112,52 @@ SerializedConstantRef serializeConstant(Location loc, Attribute valueAttr,
   };
 }
 
+// Rodata smaller than this is never compressed as the savings would not be
+// worth the decompression overhead and the loss of zero-copy access.
+static constexpr size_t kMinCompressedRodataSize = 4096;
+
+// Serializes a constant attribute to the FlatBuffer as an LZ4 block if it
+// compresses by at least 1/8th and otherwise as with serializeConstant.
+// The runtime decompresses the data at load time into 16-byte aligned storage.
+SerializedConstantRef serializeCompressedConstant(Location loc,
+                                                  Attribute valueAttr,
+                                                  size_t alignment,
+                                                  FlatbufferBuilder &fbb) {
+  auto value = valueAttr.dyn_cast<IREE::Util::SerializableAttrInterface>();
+  assert(value && "expected a serializable rodata value");
+  uint64_t actualSize = value.getStorageSize();
+  if (actualSize < kMinCompressedRodataSize || actualSize > SIZE_MAX ||
+      alignment > 16) {
+    return serializeConstant(loc, valueAttr, alignment,
+                             /*calculateCRC32=*/false, fbb);
+  }
+  size_t size = static_cast<size_t>(actualSize);
+  std::vector<uint8_t> uncompressedData(size);
+  if (failed(value.serializeToBuffer(
+          llvm::support::endianness::little,
+          ArrayRef<char>((char *)uncompressedData.data(), size)))) {
+    return {};
+  }
+  std::vector<uint8_t> compressedData(iree_lz4_compress_bound(size));
+  size_t compressedSize = iree_lz4_compress(
+      iree_make_const_byte_span(uncompressedData.data(), size),
+      iree_make_byte_span(compressedData.data(), compressedData.size()));
+  if (!compressedSize || compressedSize > size - size / 8) {
+    return serializeConstant(loc, valueAttr, alignment,
+                             /*calculateCRC32=*/false, fbb);
+  }
+
+  flatcc_builder_start_vector(fbb, 1, alignment, FLATBUFFERS_COUNT_MAX(1));
+  uint8_t *bytePtr = flatbuffers_uint8_vec_extend(fbb, compressedSize);
+  std::memcpy(bytePtr, compressedData.data(), compressedSize);
+  return SerializedConstantRef{
+      flatbuffers_uint8_vec_end(fbb),
+      static_cast<int64_t>(compressedSize),
+      /*crc32=*/0,
+      static_cast<uint64_t>(size),
+  };
+}
+
 LLVM_PACKED_START
 struct ZIPEndOfCentralDirectoryRecord {
   ulittle32_t signature;  // 0x06054B50
@@ -409,6 +459,7 @@ static LogicalResult canonicalizeModule(BytecodeTargetOptions targetOptions,
   mlir::applyPassManagerCLOptions(passManager);
   mlir::applyDefaultTimingPassManagerCLOptions(passManager);
   passManager.addInstrumentation(std::make_unique<PassTracing>());
+  CompileTimeReport::attach(passManager);
   auto &modulePasses = passManager.nest<IREE::VM::ModuleOp>();
 
   if (targetOptions.optimize) {
@@ -593,7 +644,7 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
   // were to serialize all rodata we'd have it in the opposite order as we do
   // in the IR. Though this it isn't required for correctness, enabling file
   // layout planning by preserving the order in the IR is useful.
-  SmallVector<flatbuffers_uint8_vec_ref_t, 8> rodataContentRefs;
+  SmallVector<SerializedConstantRef, 8> rodataContentRefs;
   rodataContentRefs.reserve(rodataOps.size());
 
   // All constants are defaulted to 16-byte aligned as that is the maximum
@@ -612,13 +663,18 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
             ? static_cast<size_t>(rodataOp.alignment().getValue())
             : 0;
     if (alignment == 0) alignment = kDefaultRodataAlignment;
+    // Entries in the ZIP must be stored uncompressed to be readable.
     auto constantRef =
-        serializeConstant(rodataOp.getLoc(), rodataOp.value(), alignment,
-                          /*calculateCRC32=*/includeInZIP, fbb);
+        targetOptions.compressRodata && !includeInZIP
+            ? serializeCompressedConstant(rodataOp.getLoc(), rodataOp.value(),
+                                          alignment, fbb)
+            : serializeConstant(rodataOp.getLoc(), rodataOp.value(),
+                                alignment,
+                                /*calculateCRC32=*/includeInZIP, fbb);
     if (!constantRef.ref) {
       return rodataOp.emitOpError() << "failed to encode";
     }
-    rodataContentRefs.push_back(constantRef.ref);
+    rodataContentRefs.push_back(constantRef);
 
     // Add the ZIP per-file header.
     if (includeInZIP) {
@@ -686,8 +742,18 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
   // Serialize metadata that should be near the front of the file.
   auto rodataSegmentRefs = llvm::to_vector<8>(
       llvm::map_range(rodataContentRefs, [&](auto rodataContentRef) {
+        iree_vm_CompressionTypeDef_union_ref_t compressionTypeRef = {0};
+        if (rodataContentRef.uncompressedSize) {
+          compressionTypeRef = iree_vm_CompressionTypeDef_as_LZ4BlockDataDef(
+              iree_vm_LZ4BlockDataDef_create(
+                  fbb, rodataContentRef.uncompressedSize));
+        }
         iree_vm_RodataSegmentDef_start(fbb);
-        iree_vm_RodataSegmentDef_data_add(fbb, rodataContentRef);
+        if (rodataContentRef.uncompressedSize) {
+          iree_vm_RodataSegmentDef_compression_type_add(fbb,
+                                                        compressionTypeRef);
+        }
+        iree_vm_RodataSegmentDef_data_add(fbb, rodataContentRef.ref);
         return iree_vm_RodataSegmentDef_end(fbb);
       }));
   SmallVector<iree_vm_RwdataSegmentDef_ref_t, 8> rwdataSegmentRefs;
@@ -912,6 +978,12 @@ void BytecodeTargetOptions::bindOptions(OptionsBinder &binder) {
   binder.opt<bool>("iree-vm-bytecode-module-strip-debug-ops", stripDebugOps,
                    llvm::cl::cat(vmBytecodeOptionsCategory),
                    llvm::cl::desc("Strips debug-only ops from the module"));
+  binder.opt<bool>(
+      "iree-vm-bytecode-module-compress-rodata", compressRodata,
+      llvm::cl::cat(vmBytecodeOptionsCategory),
+      llvm::cl::desc("Compresses large read-only data segments (constants and "
+                     "executables) with LZ4; they are decompressed when the "
+                     "module is loaded"));
   binder.opt<bool>(
       "iree-vm-emit-polyglot-zip", emitPolyglotZip,
       llvm::cl::cat(vmBytecodeOptionsCategory),
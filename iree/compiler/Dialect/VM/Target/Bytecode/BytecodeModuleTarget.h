@@ -50,6 +50,10 @@ struct BytecodeTargetOptions {
   // Strips vm ops with the VM_DebugOnly trait.
   bool stripDebugOps = false;
 
+  // Compresses large rodata segments to reduce the module size at the cost of
+  // decompressing them into memory when the module is loaded.
+  bool compressRodata = false;
+
   // Enables the output .vmfb to be inspected as a ZIP file.
   // This is only useful for debugging and should be disabled otherwise.
   bool emitPolyglotZip = false;
@@ -0,0 +1,27 @@
+// RUN: iree-translate -split-input-file -iree-vm-ir-to-bytecode-module -iree-vm-bytecode-module-output-format=flatbuffer-text -iree-vm-bytecode-module-compress-rodata %s | FileCheck %s
+
+// CHECK: "name": "compressed"
+vm.module @compressed {
+  vm.export @func
+  vm.func @func() {
+    vm.return
+  }
+
+  // CHECK: "rodata_segments": [{
+
+  // Small segments are stored uncompressed.
+  //  CHECK-NOT: "compression_type"
+  //      CHECK: "data": [
+  // CHECK-NEXT:   1,
+  // CHECK-NEXT:   2,
+  // CHECK-NEXT:   3
+  // CHECK-NEXT: ]
+  vm.rodata private @small dense<[1, 2, 3]> : tensor<3xi8>
+
+  // Large compressible segments are stored as LZ4 blocks.
+  //      CHECK: "compression_type_type": "LZ4BlockDataDef",
+  // CHECK-NEXT: "compression_type": {
+  // CHECK-NEXT:   "uncompressed_size": 16384
+  // CHECK-NEXT: },
+  vm.rodata private @large dense<0> : tensor<4096xi32>
+}
@@ -33,6 +33,7 @@ spirv::Vendor getVendor(const TargetTriple &triple) {
       return spirv::Vendor::Unknown;
     case TargetTripleArch::AMD_RDNAv1:
     case TargetTripleArch::AMD_RDNAv2:
+    case TargetTripleArch::AMD_RDNAv3:
       return spirv::Vendor::AMD;
     case TargetTripleArch::ARM_Valhall:
       return spirv::Vendor::ARM;
@@ -41,6 +42,8 @@ spirv::Vendor getVendor(const TargetTriple &triple) {
       return spirv::Vendor::NVIDIA;
     case TargetTripleArch::QC_Adreno:
       return spirv::Vendor::Qualcomm;
+    case TargetTripleArch::Intel_Arc:
+      return spirv::Vendor::Intel;
     case TargetTripleArch::CPU:
       switch (triple.getProduct()) {
         case TargetTripleProduct::SwiftShader:
@@ -63,8 +66,10 @@ spirv::DeviceType getDeviceType(const TargetTriple &triple) {
       return spirv::DeviceType::CPU;
     case TargetTripleArch::AMD_RDNAv1:
     case TargetTripleArch::AMD_RDNAv2:
+    case TargetTripleArch::AMD_RDNAv3:
     case TargetTripleArch::NV_Turing:
     case TargetTripleArch::NV_Ampere:
+    case TargetTripleArch::Intel_Arc:
       return spirv::DeviceType::DiscreteGPU;
     case TargetTripleArch::ARM_Valhall:
     case TargetTripleArch::QC_Adreno:
@@ -145,7 +150,10 @@ void getExtensions(const TargetTriple &triple,
       Extension::VK_KHR_variable_pointers};
 
   extensions.append(desktop.begin(), desktop.end());
-  if (getVendor(triple) == spirv::Vendor::NVIDIA) {
+  // Intel only exposes its matrix engines through VK_KHR_cooperative_matrix,
+  // which we cannot target yet.
+  if (getVendor(triple) == spirv::Vendor::NVIDIA ||
+      triple.getArch() == TargetTripleArch::AMD_RDNAv3) {
     extensions.push_back(Extension::VK_NV_cooperative_matrix);
   }
 }
@@ -209,6 +217,47 @@ CapabilitiesAttr getCapabilities(const TargetTriple &triple,
 
       variablePointers = variablePointersStorageBuffer = true;
       break;
+    case TargetTripleArch::AMD_RDNAv3: {
+      maxComputeSharedMemorySize = 65536;
+      maxComputeWorkGroupInvocations = 1024;
+      maxComputeWorkGroupSize = {1024, 1024, 1024};
+
+      subgroupSize = 64;
+      subgroupFeatures = SubgroupFeature::Basic | SubgroupFeature::Vote |
+                         SubgroupFeature::Arithmetic | SubgroupFeature::Ballot |
+                         SubgroupFeature::Shuffle |
+                         SubgroupFeature::ShuffleRelative |
+                         SubgroupFeature::Clustered | SubgroupFeature::Quad;
+
+      shaderFloat16 = shaderFloat64 = true;
+      shaderInt8 = shaderInt16 = shaderInt64 = true;
+
+      storageBuffer16BitAccess = storagePushConstant16 = true;
+      uniformAndStorageBuffer16BitAccess = true;
+      storageBuffer8BitAccess = true, storagePushConstant8 = true;
+      uniformAndStorageBuffer8BitAccess = true;
+
+      variablePointers = variablePointersStorageBuffer = true;
+
+      // WMMA instructions operate on 16x16x16 tiles and accumulate in either
+      // f16 or f32 for f16 inputs.
+      auto i32v16 = builder.getI32IntegerAttr(16);
+      auto i8t = TypeAttr::get(builder.getIntegerType(8));
+      auto i32t = TypeAttr::get(builder.getIntegerType(32));
+      auto f16t = TypeAttr::get(builder.getF16Type());
+      auto f32t = TypeAttr::get(builder.getF32Type());
+      auto scope = ScopeNVAttr::get(context, ScopeNV::Subgroup);
+
+      coopmatCases.push_back(CooperativeMatrixPropertiesNVAttr::get(
+          /*mSize=*/i32v16, /*nSize=*/i32v16, /*kSize=*/i32v16, /*aType=*/i8t,
+          /*bType=*/i8t, /*cType=*/i32t, /*resultType=*/i32t, scope, context));
+      coopmatCases.push_back(CooperativeMatrixPropertiesNVAttr::get(
+          /*mSize=*/i32v16, /*nSize=*/i32v16, /*kSize=*/i32v16, /*aType=*/f16t,
+          /*bType=*/f16t, /*cType=*/f16t, /*resultType=*/f16t, scope, context));
+      coopmatCases.push_back(CooperativeMatrixPropertiesNVAttr::get(
+          /*mSize=*/i32v16, /*nSize=*/i32v16, /*kSize=*/i32v16, /*aType=*/f16t,
+          /*bType=*/f16t, /*cType=*/f32t, /*resultType=*/f32t, scope, context));
+    } break;
     case TargetTripleArch::ARM_Valhall:
       // Example: https://vulkan.gpuinfo.org/displayreport.php?id=10312
       maxComputeSharedMemorySize = 32768;
@@ -300,6 +349,29 @@ CapabilitiesAttr getCapabilities(const TargetTriple &triple,
       shaderFloat16 = shaderInt8 = shaderInt16 = true;
 
       storageBuffer16BitAccess = true;
+      variablePointers = variablePointersStorageBuffer = true;
+      break;
+    case TargetTripleArch::Intel_Arc:
+      maxComputeSharedMemorySize = 65536;
+      maxComputeWorkGroupInvocations = 1024;
+      maxComputeWorkGroupSize = {1024, 1024, 64};
+
+      subgroupSize = 32;
+      subgroupFeatures = SubgroupFeature::Basic | SubgroupFeature::Vote |
+                         SubgroupFeature::Arithmetic | SubgroupFeature::Ballot |
+                         SubgroupFeature::Shuffle |
+                         SubgroupFeature::ShuffleRelative |
+                         SubgroupFeature::Clustered | SubgroupFeature::Quad;
+
+      // No native fp64 support.
+      shaderFloat16 = true;
+      shaderInt8 = shaderInt16 = shaderInt64 = true;
+
+      storageBuffer16BitAccess = storagePushConstant16 = true;
+      uniformAndStorageBuffer16BitAccess = true;
+      storageBuffer8BitAccess = true, storagePushConstant8 = true;
+      uniformAndStorageBuffer8BitAccess = true;
+
       variablePointers = variablePointersStorageBuffer = true;
       break;
   }
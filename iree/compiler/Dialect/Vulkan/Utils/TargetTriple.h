@@ -31,6 +31,8 @@ namespace Vulkan {
 /// For example:
 ///   ampere-rtx3080-windows
 ///   rdna1-5700xt-linux
+///   rdna3-7900xtx-linux
+///   arc-a770-linux
 ///   adreno-a650-android11
 ///   valhall-unknown-android11
 ///   cpu-swiftshader-unknown
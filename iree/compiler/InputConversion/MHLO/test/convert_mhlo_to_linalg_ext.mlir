@@ -239,6 +239,7 @@ func @scatter_update_scalar_1D(%arg0: tensor<8xi32>, %arg1: tensor<4x1xi32>,
 // CHECK:         %[[ARG1:[a-zA-Z0-9]+]]
 // CHECK:         %[[ARG2:[a-zA-Z0-9]+]]
 // CHECK:         %[[SCATTER:.+]] = iree_linalg_ext.scatter
+// CHECK-SAME:      {unique_indices = false}
 // CHECK-SAME:      ins(%[[ARG2]], %[[ARG1]] : tensor<4xi32>, tensor<4x1xi32>)
 // CHECK-SAME:      outs(%[[ARG0]] : tensor<8xi32>)
 // CHECK:           ^bb0(%[[V1:.+]]: i32, %[[V2:.+]]: i32):
@@ -7,6 +7,7 @@
 #include "iree/compiler/Translation/HALExecutable.h"
 
 #include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Utils/CompileTimeReport.h"
 #include "iree/compiler/Utils/TracingUtils.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/Pass/PassManager.h"
@@ -33,6 +34,7 @@ static LogicalResult translateFromMLIRToHALExecutable(
   mlir::applyPassManagerCLOptions(passManager);
   mlir::applyDefaultTimingPassManagerCLOptions(passManager);
   passManager.addInstrumentation(std::make_unique<PassTracing>());
+  CompileTimeReport::attach(passManager);
 
   IREE::HAL::buildHALTransformPassPipeline(passManager, executableOptions);
 
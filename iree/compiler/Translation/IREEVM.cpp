@@ -10,6 +10,7 @@
 #include "iree/compiler/Bindings/TFLite/Transforms/Passes.h"
 #include "iree/compiler/ConstEval/Passes.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Util/Transforms/Passes.h"
@@ -17,6 +18,7 @@
 #include "iree/compiler/InputConversion/Common/Passes.h"
 #include "iree/compiler/InputConversion/MHLO/Passes.h"
 #include "iree/compiler/InputConversion/TOSA/Passes.h"
+#include "iree/compiler/Utils/CompileTimeReport.h"
 #include "iree/compiler/Utils/PassUtils.h"
 #include "iree/compiler/Utils/TracingUtils.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -86,6 +88,11 @@ void HighLevelOptimizationOptions::bindOptions(OptionsBinder &binder) {
       llvm::cl::desc(
           "Reduces numeric precision to lower bit depths where possible."),
       llvm::cl::cat(category));
+  binder.opt<std::string>(
+      "iree-opt-numeric-float-storage-type", numericFloatStorageType,
+      llvm::cl::desc("Stores the inputs of f32 matmuls and convolutions in "
+                     "this type (f16 or bf16) while accumulating in f32."),
+      llvm::cl::cat(category));
   binder.opt<bool>("iree-opt-strip-assertions", stripAssertions,
                    llvm::cl::desc("Strips debug assertions after any useful "
                                   "information has been extracted."),
@@ -149,16 +156,29 @@ void buildIREEVMTransformPassPipeline(
     IREE::TFLite::buildTransformPassPipeline(passManager);
   }
 
+  // Assign the target devices ahead of the Flow pipeline so that target
+  // specific (but target dialect agnostic) transformations such as mmt4d
+  // packing can inspect them.
+  if (!executableOptions.targets.empty()) {
+    passManager.addPass(
+        IREE::HAL::createAssignTargetDevicesPass(executableOptions.targets));
+  }
+
   IREE::Flow::TransformOptions flowOptions;
   flowOptions.constExprHoisting =
       highLevelOptimizationOptions.constExprHoisting;
-  if (highLevelOptimizationOptions.constEval) {
+  // Const-eval compiles hoisted expressions for the vmvx backend so it is only
+  // available in compilers that include it.
+  if (highLevelOptimizationOptions.constEval &&
+      llvm::is_contained(IREE::HAL::getRegisteredTargetBackends(), "vmvx")) {
     flowOptions.buildConstEvalPassPipeline = [](OpPassManager &passManager) {
       passManager.addPass(ConstEval::createJitGlobalsPass());
     };
   }
   flowOptions.numericPrecisionReduction =
       highLevelOptimizationOptions.numericPrecisionReduction;
+  flowOptions.numericFloatStorageType =
+      highLevelOptimizationOptions.numericFloatStorageType;
 
   if (highLevelOptimizationOptions.stripAssertions) {
     // Strip std.assert & co after we perform optimizations; prior to this we
@@ -211,6 +231,7 @@ static LogicalResult translateFromMLIRToVM(
   mlir::applyPassManagerCLOptions(passManager);
   mlir::applyDefaultTimingPassManagerCLOptions(passManager);
   passManager.addInstrumentation(std::make_unique<PassTracing>());
+  CompileTimeReport::attach(passManager);
   buildIREEVMTransformPassPipeline(
       bindingOptions, inputOptions, highLevelOptimizationOptions,
       schedulingOptions, executableOptions, targetOptions, passManager);
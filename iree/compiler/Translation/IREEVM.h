@@ -63,15 +63,20 @@ struct InputDialectOptions {
 // Options controlling high level optimizations.
 struct HighLevelOptimizationOptions {
   // Enables const-expr hoisting into globals.
-  bool constExprHoisting = false;
+  bool constExprHoisting = true;
 
   // Enables recursive evaluation of immutable globals using the compiler
-  // and runtime.
-  bool constEval = false;
+  // and runtime. Requires the vmvx target backend to be registered and is
+  // skipped otherwise.
+  bool constEval = true;
 
   // Optimizations to reduce numeric precision where it is safe to do so.
   bool numericPrecisionReduction = false;
 
+  // Floating point type (f16 or bf16) the inputs of f32 contractions are
+  // stored in while accumulating in f32. Empty to keep f32.
+  std::string numericFloatStorageType;
+
   // Strips debug assertions after any useful information has been extracted.
   bool stripAssertions = false;
 
@@ -0,0 +1,189 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Utils/CompileTimeReport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/JSON.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/PassInstrumentation.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+std::atomic<CompileTimeReport *> globalReport{nullptr};
+
+using Clock = std::chrono::steady_clock;
+
+// A pass that is currently running on this thread.
+struct ActivePass {
+  Clock::time_point startTime;
+  // Time spent in passes run by this pass on this thread.
+  double childMs = 0.0;
+};
+thread_local llvm::SmallVector<ActivePass, 8> activePassStack;
+
+// Pass manager adaptors run nested pass managers and have their time
+// accounted for by the nested passes.
+bool isAdaptorPass(Pass *pass) {
+  return pass->getName().endswith("OpToOpPassAdaptor");
+}
+
+struct CompileTimeInstrumentation : public PassInstrumentation {
+  explicit CompileTimeInstrumentation(CompileTimeReport *report)
+      : report(report) {}
+
+  void runBeforePass(Pass *pass, Operation *op) override {
+    if (isAdaptorPass(pass)) return;
+    activePassStack.push_back({Clock::now()});
+  }
+  void runAfterPass(Pass *pass, Operation *op) override { endPass(pass, op); }
+  void runAfterPassFailed(Pass *pass, Operation *op) override {
+    endPass(pass, op);
+  }
+
+  void endPass(Pass *pass, Operation *op) {
+    if (isAdaptorPass(pass)) return;
+    ActivePass activePass = activePassStack.pop_back_val();
+    double totalMs = std::chrono::duration<double, std::milli>(
+                         Clock::now() - activePass.startTime)
+                         .count();
+    if (!activePassStack.empty()) activePassStack.back().childMs += totalMs;
+    report->recordPass(pass, op, totalMs - activePass.childMs);
+  }
+
+  CompileTimeReport *report;
+};
+
+// Rounds |ms| for display; the reports are meant to be human-scanned.
+double roundMs(double ms) { return std::round(ms * 1000.0) / 1000.0; }
+
+}  // namespace
+
+CompileTimeReport::CompileTimeReport(StringRef groupOpName)
+    : groupOpName(groupOpName.str()) {}
+
+// static
+void CompileTimeReport::setGlobal(CompileTimeReport *report) {
+  globalReport.store(report);
+}
+
+// static
+CompileTimeReport *CompileTimeReport::getGlobal() {
+  return globalReport.load();
+}
+
+// static
+void CompileTimeReport::attach(PassManager &passManager) {
+  auto *report = getGlobal();
+  if (!report) return;
+  passManager.addInstrumentation(
+      std::make_unique<CompileTimeInstrumentation>(report));
+}
+
+void CompileTimeReport::recordPass(Pass *pass, Operation *op,
+                                   double durationMs) {
+  StringAttr groupName;
+  for (Operation *it = op; it; it = it->getParentOp()) {
+    if (it->getName().getStringRef() == groupOpName) {
+      groupName =
+          it->getAttrOfType<StringAttr>(SymbolTable::getSymbolAttrName());
+      break;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &passStats = passes[pass->getName()];
+  if (passStats.count == 0) passStats.argument = pass->getArgument().str();
+  ++passStats.count;
+  passStats.totalMs += durationMs;
+  if (groupName) {
+    auto &groupStats = groups[groupName.getValue()];
+    groupStats.totalMs += durationMs;
+    groupStats.passMs[pass->getName()] += durationMs;
+  }
+}
+
+void CompileTimeReport::writeJSON(llvm::raw_ostream &os, double totalMs,
+                                  unsigned maxGroups,
+                                  unsigned maxPassesPerGroup) const {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // Sorts map entries by descending time, breaking ties by name so that the
+  // output is stable.
+  auto sortedByTime = [](auto &map, auto getMs) {
+    using Entry = decltype(&*map.begin());
+    llvm::SmallVector<Entry, 8> entries;
+    for (auto &entry : map) entries.push_back(&entry);
+    std::sort(entries.begin(), entries.end(), [&](Entry a, Entry b) {
+      double aMs = getMs(a->getValue()), bMs = getMs(b->getValue());
+      if (aMs != bMs) return aMs > bMs;
+      return a->getKey() < b->getKey();
+    });
+    return entries;
+  };
+
+  double groupsTotalMs = 0.0;
+  for (auto &group : groups) groupsTotalMs += group.getValue().totalMs;
+
+  llvm::json::OStream json(os, /*IndentSize=*/2);
+  json.object([&] {
+    json.attribute("total_ms", roundMs(totalMs));
+    json.attributeArray("passes", [&] {
+      for (auto *entry : sortedByTime(
+               passes, [](const PassStatistics &s) { return s.totalMs; })) {
+        const auto &stats = entry->getValue();
+        json.object([&] {
+          json.attribute("name", entry->getKey());
+          json.attribute("argument", stats.argument);
+          json.attribute("count", stats.count);
+          json.attribute("total_ms", roundMs(stats.totalMs));
+        });
+      }
+    });
+    json.attributeObject("groups", [&] {
+      json.attribute("op", groupOpName);
+      json.attribute("count", static_cast<int64_t>(groups.size()));
+      json.attribute("total_ms", roundMs(groupsTotalMs));
+      json.attributeArray("slowest", [&] {
+        unsigned groupCount = 0;
+        for (auto *entry : sortedByTime(
+                 groups, [](const GroupStatistics &s) { return s.totalMs; })) {
+          if (maxGroups && groupCount++ == maxGroups) break;
+          const auto &stats = entry->getValue();
+          json.object([&] {
+            json.attribute("name", entry->getKey());
+            json.attribute("total_ms", roundMs(stats.totalMs));
+            json.attributeArray("passes", [&] {
+              unsigned passCount = 0;
+              for (auto *passEntry :
+                   sortedByTime(stats.passMs, [](double ms) { return ms; })) {
+                if (passCount++ == maxPassesPerGroup) break;
+                json.object([&] {
+                  json.attribute("name", passEntry->getKey());
+                  json.attribute("total_ms", roundMs(passEntry->getValue()));
+                });
+              }
+            });
+          });
+        }
+      });
+    });
+  });
+  os << "\n";
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,86 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_UTILS_COMPILETIMEREPORT_H_
+#define IREE_COMPILER_UTILS_COMPILETIMEREPORT_H_
+
+#include <mutex>
+#include <string>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Pass/PassManager.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+// Aggregates the time spent in each pass across all pass managers the report
+// is attached to, along with the time spent on each group of ops (such as
+// executables) so that the slowest parts of a compilation can be identified.
+//
+// Times are exclusive: the time spent in passes that a pass runs as part of a
+// dynamic pipeline are attributed to those passes and not the parent. Pass
+// manager adaptors are not timed as their nested passes are. Passes running
+// concurrently on multiple threads each contribute their own time such that
+// the sum of all pass times may exceed the wall time of the compilation.
+//
+// Thread-safe; passes may run concurrently.
+//
+// Usage:
+//   CompileTimeReport report("hal.executable");
+//   CompileTimeReport::setGlobal(&report);
+//   ... compile; pass managers call CompileTimeReport::attach ...
+//   CompileTimeReport::setGlobal(nullptr);
+//   report.writeJSON(os, totalMs);
+class CompileTimeReport {
+ public:
+  // Creates a report grouping passes by the symbol name of the nearest
+  // enclosing op (including the op the pass runs on) named |groupOpName|.
+  explicit CompileTimeReport(StringRef groupOpName);
+
+  // Installs |report| as the process-wide report that compiler pass managers
+  // attach to with CompileTimeReport::attach. nullptr disables reporting.
+  // The report must remain live until it is uninstalled.
+  static void setGlobal(CompileTimeReport *report);
+
+  // Returns the process-wide report, if any.
+  static CompileTimeReport *getGlobal();
+
+  // Attaches instrumentation recording into the process-wide report to
+  // |passManager|. No-op if no report has been installed.
+  static void attach(PassManager &passManager);
+
+  // Records |durationMs| spent in |pass| running on |op|.
+  void recordPass(Pass *pass, Operation *op, double durationMs);
+
+  // Writes the report as JSON to |os|. |totalMs| is the wall time of the
+  // compilation. At most |maxGroups| of the slowest groups are listed (0 for
+  // all) and each lists at most |maxPassesPerGroup| of its slowest passes.
+  void writeJSON(llvm::raw_ostream &os, double totalMs, unsigned maxGroups = 0,
+                 unsigned maxPassesPerGroup = 5) const;
+
+ private:
+  struct PassStatistics {
+    std::string argument;
+    int64_t count = 0;
+    double totalMs = 0.0;
+  };
+  struct GroupStatistics {
+    double totalMs = 0.0;
+    llvm::StringMap<double> passMs;
+  };
+
+  std::string groupOpName;
+  mutable std::mutex mutex;
+  llvm::StringMap<PassStatistics> passes;
+  llvm::StringMap<GroupStatistics> groups;
+};
+
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_UTILS_COMPILETIMEREPORT_H_
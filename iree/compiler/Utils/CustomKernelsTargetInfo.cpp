@@ -22,10 +22,35 @@ LogicalResult ParseCustomKernelTargetFeaturesForAarch64(
     }
     if (f == "+dotprod") {
       target_info.add(CustomKernelTargetFeature::Aarch64Dotprod);
-    } else {
+    } else if (f == "+i8mm") {
+      target_info.add(CustomKernelTargetFeature::Aarch64I8mm);
+    } else if (f == "+bf16") {
+      target_info.add(CustomKernelTargetFeature::Aarch64Bf16);
+    } else if (f == "+fullfp16") {
+      target_info.add(CustomKernelTargetFeature::Aarch64Fullfp16);
+    } else if (!f.startswith("+") && !f.startswith("-")) {
       llvm::errs() << "Unhandled aarch64 CPU feature: " << f << "\n";
       return failure();
     }
+    // Other well-formed features (such as those in the cpu_features of a
+    // target) don't influence custom kernel selection and are ignored.
+  }
+  return success();
+}
+
+LogicalResult ParseCustomKernelTargetFeaturesForX86_64(
+    const llvm::SmallVector<llvm::StringRef> &features,
+    CustomKernelsTargetInfo &target_info) {
+  for (auto f : features) {
+    if (f.empty()) {
+      continue;
+    }
+    if (f == "+avx512vnni") {
+      target_info.add(CustomKernelTargetFeature::X86_64Avx512Vnni);
+    } else if (!f.startswith("+") && !f.startswith("-")) {
+      llvm::errs() << "Unhandled x86_64 CPU feature: " << f << "\n";
+      return failure();
+    }
   }
   return success();
 }
@@ -49,6 +74,11 @@ LogicalResult ParseCustomKernelsTargetInfo(
     return ParseCustomKernelTargetFeaturesForAarch64(features, target_info);
   }
 
+  if (archStr == "x86_64") {
+    target_info.init(CustomKernelTargetArch::X86_64);
+    return ParseCustomKernelTargetFeaturesForX86_64(features, target_info);
+  }
+
   // Currently, on unknown arch, we return success as long as no features
   // were specified (we wouldn't know how to parse features for an unknown arch)
   // as we don't necessarily know all the arch strings that IREE is being used
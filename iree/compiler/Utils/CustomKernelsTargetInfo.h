@@ -18,7 +18,7 @@ namespace iree_compiler {
 
 // Enumerates target ISAs that we care about. 'int8_t' because we somewhat
 // care because this is used in struct MMTKernel, which is passed by value.
-enum class CustomKernelTargetArch : int8_t { None, Aarch64 };
+enum class CustomKernelTargetArch : int8_t { None, Aarch64, X86_64 };
 
 // Enumerates arch-specific target features that we care about.
 // We explicitly want to stick to the default enumeration values (0, 1, 2, ...,
@@ -33,6 +33,11 @@ enum class CustomKernelTargetFeature {
   Intrinsics,
   // Aarch64 features.
   Aarch64Dotprod,
+  Aarch64I8mm,
+  Aarch64Bf16,
+  Aarch64Fullfp16,
+  // X86_64 features.
+  X86_64Avx512Vnni,
 };
 
 inline bool isFeatureForArch(CustomKernelTargetFeature feature,
@@ -41,7 +46,12 @@ inline bool isFeatureForArch(CustomKernelTargetFeature feature,
     case CustomKernelTargetFeature::Intrinsics:
       return true;
     case CustomKernelTargetFeature::Aarch64Dotprod:
+    case CustomKernelTargetFeature::Aarch64I8mm:
+    case CustomKernelTargetFeature::Aarch64Bf16:
+    case CustomKernelTargetFeature::Aarch64Fullfp16:
       return arch == CustomKernelTargetArch::Aarch64;
+    case CustomKernelTargetFeature::X86_64Avx512Vnni:
+      return arch == CustomKernelTargetArch::X86_64;
   }
   assert(false && "Unhandled CustomKernelTargetFeature value");
   return false;
@@ -70,6 +80,15 @@ class CustomKernelsTargetInfo {
     assert(isFeatureForArch(f, arch));
     features |= (1ull << static_cast<int>(f));
   }
+  // Restricts this to the arch and features shared with |other| such that
+  // code specialized for the result is valid for both.
+  void intersect(const CustomKernelsTargetInfo &other) {
+    if (arch != other.arch) {
+      *this = CustomKernelsTargetInfo();
+      return;
+    }
+    features &= other.features;
+  }
 
  private:
   CustomKernelTargetArch arch = CustomKernelTargetArch::None;
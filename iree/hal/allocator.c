@@ -6,9 +6,11 @@
 
 #include "iree/hal/allocator.h"
 
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdio.h>
 
+#include "iree/base/profiler.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/detail.h"
 #include "iree/hal/resource.h"
@@ -36,6 +38,56 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_statistics_format(
       statistics->device_bytes_freed,
       (statistics->device_bytes_allocated - statistics->device_bytes_freed)));
 
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder,
+      "  HOST_COUNT: %12" PRIu64 "  peak / %12" PRIu64
+      "  allocated / %12" PRIu64 "  freed / %12" PRIu64 "  live\n",
+      statistics->host_buffers_peak, statistics->host_buffers_allocated,
+      statistics->host_buffers_freed,
+      (statistics->host_buffers_allocated - statistics->host_buffers_freed)));
+
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder,
+      "DEVICE_COUNT: %12" PRIu64 "  peak / %12" PRIu64
+      "  allocated / %12" PRIu64 "  freed / %12" PRIu64 "  live\n",
+      statistics->device_buffers_peak, statistics->device_buffers_allocated,
+      statistics->device_buffers_freed,
+      (statistics->device_buffers_allocated -
+       statistics->device_buffers_freed)));
+
+  if (statistics->cache_hit_count || statistics->cache_miss_count) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder,
+        "       CACHE: %12" PRIu64 " hits / %12" PRIu64
+        " misses / %12" PRIdsz "B cached\n",
+        statistics->cache_hit_count, statistics->cache_miss_count,
+        statistics->cache_bytes));
+  }
+
+  // Only buckets with allocations are printed to keep the output compact.
+  if (statistics->host_buffers_allocated ||
+      statistics->device_buffers_allocated) {
+    IREE_RETURN_IF_ERROR(
+        iree_string_builder_append_cstring(builder, "   HISTOGRAM:\n"));
+  }
+  for (iree_host_size_t i = 0;
+       i < IREE_ARRAYSIZE(statistics->allocation_size_histogram); ++i) {
+    uint64_t count = statistics->allocation_size_histogram[i];
+    if (!count) continue;
+    if (i + 1 < IREE_ARRAYSIZE(statistics->allocation_size_histogram)) {
+      IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+          builder, "  <= %12" PRIu64 "B: %12" PRIu64 " allocations\n",
+          (uint64_t)1 << (IREE_HAL_ALLOCATOR_STATISTICS_HISTOGRAM_MIN_LOG2 + i),
+          count));
+    } else {
+      IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+          builder, "   > %12" PRIu64 "B: %12" PRIu64 " allocations\n",
+          (uint64_t)1 << (IREE_HAL_ALLOCATOR_STATISTICS_HISTOGRAM_MIN_LOG2 + i -
+                          1),
+          count));
+    }
+  }
+
 #else
   // No-op when disabled.
 #endif  // IREE_STATISTICS_ENABLE
@@ -115,6 +167,21 @@ iree_hal_allocator_query_buffer_compatibility(
       allocator, memory_type, allowed_usage, intended_usage, allocation_size);
 }
 
+// Reports an allocation event of |type| for |buffer| to the profiler, if any.
+static void iree_hal_allocator_profile_buffer(iree_profiler_event_type_t type,
+                                              iree_hal_buffer_t* buffer) {
+  if (!iree_profiler_is_enabled(1u << type)) return;
+  iree_profiler_event_t event = {
+      .type = type,
+      .timestamp_ns = 0,
+      .id = (uint64_t)(uintptr_t)buffer,
+      .name = iree_string_view_empty(),
+      .value = (uint64_t)iree_hal_buffer_allocation_size(buffer),
+      .flags = (uint32_t)iree_hal_buffer_memory_type(buffer),
+  };
+  iree_profiler_record_event(event);
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_allocator_allocate_buffer(
     iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
     iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
@@ -126,6 +193,10 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_allocate_buffer(
   iree_status_t status = _VTABLE_DISPATCH(allocator, allocate_buffer)(
       allocator, memory_type, allowed_usage, allocation_size, initial_data,
       out_buffer);
+  if (iree_status_is_ok(status)) {
+    iree_hal_allocator_profile_buffer(IREE_PROFILER_EVENT_TYPE_ALLOCATE,
+                                      *out_buffer);
+  }
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -135,6 +206,10 @@ IREE_API_EXPORT void iree_hal_allocator_deallocate_buffer(
   IREE_ASSERT_ARGUMENT(allocator);
   IREE_ASSERT_ARGUMENT(buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
+  // Subspans are routed here as well but were never reported as allocations.
+  if (iree_hal_buffer_allocated_buffer(buffer) == buffer) {
+    iree_hal_allocator_profile_buffer(IREE_PROFILER_EVENT_TYPE_FREE, buffer);
+  }
   _VTABLE_DISPATCH(allocator, deallocate_buffer)(allocator, buffer);
   IREE_TRACE_ZONE_END(z0);
 }
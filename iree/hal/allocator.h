@@ -11,6 +11,7 @@
 #include <stdint.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/math.h"
 #include "iree/hal/buffer.h"
 #include "iree/hal/resource.h"
 
@@ -164,6 +165,13 @@ typedef struct iree_hal_external_buffer_t {
 // Statistics/reporting
 //===----------------------------------------------------------------------===//
 
+// Allocations of this size or smaller are all counted in the first bucket of
+// the allocation size histogram.
+#define IREE_HAL_ALLOCATOR_STATISTICS_HISTOGRAM_MIN_LOG2 8
+// Number of power-of-two buckets in the allocation size histogram. The last
+// bucket counts all allocations larger than the preceding buckets.
+#define IREE_HAL_ALLOCATOR_STATISTICS_HISTOGRAM_BUCKET_COUNT 25
+
 // Aggregate allocation statistics.
 typedef struct iree_hal_allocator_statistics_t {
 #if IREE_STATISTICS_ENABLE
@@ -173,6 +181,27 @@ typedef struct iree_hal_allocator_statistics_t {
   iree_device_size_t device_bytes_peak;
   iree_device_size_t device_bytes_allocated;
   iree_device_size_t device_bytes_freed;
+  // Number of buffers allocated and freed. The difference is the number of
+  // buffers currently live.
+  uint64_t host_buffers_allocated;
+  uint64_t host_buffers_freed;
+  uint64_t device_buffers_allocated;
+  uint64_t device_buffers_freed;
+  // Peak number of buffers live at the same time.
+  uint64_t host_buffers_peak;
+  uint64_t device_buffers_peak;
+  // Number of allocations made of each size. Bucket 0 counts allocations of up
+  // to 2^IREE_HAL_ALLOCATOR_STATISTICS_HISTOGRAM_MIN_LOG2 bytes and each
+  // subsequent bucket i counts allocations larger than the previous bucket of
+  // up to 2^(IREE_HAL_ALLOCATOR_STATISTICS_HISTOGRAM_MIN_LOG2 + i) bytes.
+  uint64_t allocation_size_histogram
+      [IREE_HAL_ALLOCATOR_STATISTICS_HISTOGRAM_BUCKET_COUNT];
+  // Number of allocations served from memory cached by the allocator.
+  uint64_t cache_hit_count;
+  // Number of cacheable allocations that required new memory.
+  uint64_t cache_miss_count;
+  // Total size in bytes of freed memory currently retained for reuse.
+  iree_device_size_t cache_bytes;
   // TODO(benvanik): mapping information (discarded, mapping ranges,
   //                 flushed/invalidated, etc).
 #else
@@ -330,10 +359,40 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_export_buffer(
 // The buffers created from the allocator will use |host_allocator| for their
 // metadata and |data_allocator| for their device storage allocations. If the
 // two are the same the buffers will be allocated in a single flat slab.
+//
+// Storage of freed buffers of at least IREE_HAL_HEAP_ALLOCATOR_MIN_CACHED_SIZE
+// bytes is retained for reuse up to IREE_HAL_HEAP_ALLOCATOR_CACHE_LIMIT bytes
+// total. See iree_hal_allocator_create_heap_with_cache.
 IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap(
     iree_string_view_t identifier, iree_allocator_t data_allocator,
     iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
 
+// Default total size in bytes of the freed buffer storage retained by heap
+// allocators created with iree_hal_allocator_create_heap.
+#if !defined(IREE_HAL_HEAP_ALLOCATOR_CACHE_LIMIT)
+#define IREE_HAL_HEAP_ALLOCATOR_CACHE_LIMIT (64 * 1024 * 1024)
+#endif  // !IREE_HAL_HEAP_ALLOCATOR_CACHE_LIMIT
+
+// Allocations smaller than this are always made directly from the data
+// allocator as the system allocator is usually fast enough for them and
+// rounding up to size classes would only waste memory.
+#define IREE_HAL_HEAP_ALLOCATOR_MIN_CACHED_SIZE (64 * 1024)
+
+// Creates a heap allocator as with iree_hal_allocator_create_heap that retains
+// up to |cache_limit| bytes of freed buffer storage for reuse by later
+// allocations, or no storage if |cache_limit| is 0.
+//
+// Transient buffers allocated and freed on every invocation are common and
+// large ones would otherwise go to the system allocator (and often mmap,
+// munmap, and page faults) each time. Storage is cached in size classes and
+// when trimmed with iree_hal_allocator_trim the allocator frees storage that
+// went unused since the previous trim while keeping the working set. Cache
+// behavior is reported in iree_hal_allocator_query_statistics.
+IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap_with_cache(
+    iree_string_view_t identifier, iree_device_size_t cache_limit,
+    iree_allocator_t data_allocator, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_allocator_t implementation details
 //===----------------------------------------------------------------------===//
@@ -393,6 +452,18 @@ IREE_API_EXPORT void iree_hal_allocator_deallocate_buffer(
 
 #if IREE_STATISTICS_ENABLE
 
+// Returns the allocation size histogram bucket |allocation_size| is counted in.
+static inline iree_host_size_t iree_hal_allocator_statistics_histogram_bucket(
+    iree_device_size_t allocation_size) {
+  const iree_device_size_t min_size =
+      (iree_device_size_t)1 << IREE_HAL_ALLOCATOR_STATISTICS_HISTOGRAM_MIN_LOG2;
+  if (allocation_size <= min_size) return 0;
+  iree_host_size_t size_log2 =
+      64 - iree_math_count_leading_zeros_u64((uint64_t)allocation_size - 1);
+  return iree_min(size_log2 - IREE_HAL_ALLOCATOR_STATISTICS_HISTOGRAM_MIN_LOG2,
+                  IREE_HAL_ALLOCATOR_STATISTICS_HISTOGRAM_BUCKET_COUNT - 1);
+}
+
 // Records a buffer allocation to |statistics|.
 static inline void iree_hal_allocator_statistics_record_alloc(
     iree_hal_allocator_statistics_t* statistics,
@@ -402,12 +473,23 @@ static inline void iree_hal_allocator_statistics_record_alloc(
     statistics->host_bytes_peak =
         iree_max(statistics->host_bytes_peak, statistics->host_bytes_allocated -
                                                   statistics->host_bytes_freed);
+    ++statistics->host_buffers_allocated;
+    statistics->host_buffers_peak = iree_max(
+        statistics->host_buffers_peak,
+        statistics->host_buffers_allocated - statistics->host_buffers_freed);
   } else {
     statistics->device_bytes_allocated += allocation_size;
     statistics->device_bytes_peak = iree_max(
         statistics->device_bytes_peak,
         statistics->device_bytes_allocated - statistics->device_bytes_freed);
+    ++statistics->device_buffers_allocated;
+    statistics->device_buffers_peak =
+        iree_max(statistics->device_buffers_peak,
+                 statistics->device_buffers_allocated -
+                     statistics->device_buffers_freed);
   }
+  ++statistics->allocation_size_histogram
+        [iree_hal_allocator_statistics_histogram_bucket(allocation_size)];
 }
 
 // Records a buffer deallocation to |statistics|.
@@ -416,8 +498,10 @@ static inline void iree_hal_allocator_statistics_record_free(
     iree_hal_memory_type_t memory_type, iree_device_size_t allocation_size) {
   if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_LOCAL)) {
     statistics->host_bytes_freed += allocation_size;
+    ++statistics->host_buffers_freed;
   } else {
     statistics->device_bytes_freed += allocation_size;
+    ++statistics->device_buffers_freed;
   }
 }
 
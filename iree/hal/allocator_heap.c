@@ -12,12 +12,17 @@
 #include "iree/hal/buffer.h"
 #include "iree/hal/buffer_heap_impl.h"
 #include "iree/hal/resource.h"
+#include "iree/hal/utils/allocation_cache.h"
 
 typedef struct iree_hal_heap_allocator_t {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
   iree_allocator_t data_allocator;
   iree_string_view_t identifier;
+
+  // Freed buffer storage retained for reuse.
+  iree_hal_allocation_cache_t cache;
+
   IREE_STATISTICS(iree_hal_heap_allocator_statistics_t statistics;)
 } iree_hal_heap_allocator_t;
 
@@ -28,9 +33,26 @@ iree_hal_heap_allocator_t* iree_hal_heap_allocator_cast(
   return (iree_hal_heap_allocator_t*)base_value;
 }
 
+// Frees storage evicted from the cache back to the data allocator.
+static void iree_hal_heap_allocator_cache_free(
+    void* user_data, iree_host_size_t heap,
+    iree_hal_cached_allocation_t allocation) {
+  iree_hal_heap_allocator_t* allocator = (iree_hal_heap_allocator_t*)user_data;
+  iree_allocator_free(allocator->data_allocator, allocation.host_ptr);
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap(
     iree_string_view_t identifier, iree_allocator_t data_allocator,
     iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  return iree_hal_allocator_create_heap_with_cache(
+      identifier, IREE_HAL_HEAP_ALLOCATOR_CACHE_LIMIT, data_allocator,
+      host_allocator, out_allocator);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap_with_cache(
+    iree_string_view_t identifier, iree_device_size_t cache_limit,
+    iree_allocator_t data_allocator, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator) {
   IREE_ASSERT_ARGUMENT(out_allocator);
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -47,6 +69,13 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_create_heap(
     iree_string_view_append_to_buffer(
         identifier, &allocator->identifier,
         (char*)allocator + iree_sizeof_struct(*allocator));
+    iree_hal_allocation_cache_free_callback_t free_callback = {
+        .fn = iree_hal_heap_allocator_cache_free,
+        .user_data = allocator,
+    };
+    iree_hal_allocation_cache_initialize(cache_limit, /*heap_count=*/1,
+                                         free_callback, host_allocator,
+                                         &allocator->cache);
 
     IREE_STATISTICS({
       // All start initialized to zero.
@@ -67,6 +96,7 @@ static void iree_hal_heap_allocator_destroy(
   iree_allocator_t host_allocator = allocator->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_allocation_cache_deinitialize(&allocator->cache);
   IREE_STATISTICS(iree_slim_mutex_deinitialize(&allocator->statistics.mutex));
 
   iree_allocator_free(host_allocator, allocator);
@@ -83,6 +113,9 @@ static iree_allocator_t iree_hal_heap_allocator_host_allocator(
 
 static iree_status_t iree_hal_heap_allocator_trim(
     iree_hal_allocator_t* base_allocator) {
+  iree_hal_heap_allocator_t* allocator =
+      iree_hal_heap_allocator_cast(base_allocator);
+  iree_hal_allocation_cache_trim_unused(&allocator->cache);
   return iree_ok_status();
 }
 
@@ -96,6 +129,12 @@ static void iree_hal_heap_allocator_query_statistics(
     memcpy(out_statistics, &allocator->statistics.base,
            sizeof(*out_statistics));
     iree_slim_mutex_unlock(&allocator->statistics.mutex);
+    iree_hal_allocation_cache_statistics_t cache_statistics;
+    iree_hal_allocation_cache_query_statistics(&allocator->cache,
+                                               &cache_statistics);
+    out_statistics->cache_hit_count = cache_statistics.hit_count;
+    out_statistics->cache_miss_count = cache_statistics.miss_count;
+    out_statistics->cache_bytes = cache_statistics.cache_size;
   });
 }
 
@@ -163,14 +202,19 @@ static iree_status_t iree_hal_heap_allocator_allocate_buffer(
   IREE_RETURN_IF_ERROR(iree_hal_heap_allocator_make_compatible(
       &memory_type, &allowed_access, &allowed_usage));
 
-  // Allocate the buffer (both the wrapper and the contents).
+  // Allocate the buffer (both the wrapper and the contents). Large buffers
+  // reuse the storage of previously freed buffers when possible.
   iree_hal_heap_allocator_statistics_t* statistics = NULL;
   IREE_STATISTICS(statistics = &allocator->statistics);
   iree_hal_buffer_t* buffer = NULL;
+  iree_hal_allocation_cache_t* cache =
+      allocation_size >= IREE_HAL_HEAP_ALLOCATOR_MIN_CACHED_SIZE
+          ? &allocator->cache
+          : NULL;
   IREE_RETURN_IF_ERROR(iree_hal_heap_buffer_create(
-      base_allocator, statistics, memory_type, allowed_access, allowed_usage,
-      allocation_size, allocator->data_allocator, allocator->host_allocator,
-      &buffer));
+      base_allocator, statistics, cache, memory_type, allowed_access,
+      allowed_usage, allocation_size, allocator->data_allocator,
+      allocator->host_allocator, &buffer));
 
   iree_status_t status = iree_ok_status();
   if (!iree_const_byte_span_is_empty(initial_data)) {
@@ -21,6 +21,9 @@ typedef struct iree_hal_heap_buffer_t {
   iree_byte_span_t data;
   iree_allocator_t data_allocator;
 
+  // Optional cache the storage is returned to when the buffer is destroyed.
+  iree_hal_allocation_cache_t* cache;
+
   // Optional statistics shared with the allocator.
   IREE_STATISTICS(iree_hal_heap_allocator_statistics_t* statistics;)
 } iree_hal_heap_buffer_t;
@@ -68,9 +71,51 @@ static iree_status_t iree_hal_heap_buffer_allocate_slab(
   return iree_ok_status();
 }
 
+// Allocates a buffer with the metadata and storage split with the storage
+// coming from |cache| when possible. Storage of a new allocation is rounded up
+// to the |size_class| so that it can be reused by any allocation of the class.
+static iree_status_t iree_hal_heap_buffer_allocate_cached(
+    iree_hal_allocation_cache_t* cache,
+    const iree_hal_allocation_cache_class_t* size_class,
+    iree_device_size_t allocation_size, iree_allocator_t data_allocator,
+    iree_allocator_t host_allocator, iree_hal_heap_buffer_t** out_buffer,
+    iree_byte_span_t* out_data) {
+  iree_hal_cached_allocation_t allocation;
+  if (!iree_hal_allocation_cache_acquire(cache, /*heap=*/0, size_class,
+                                         &allocation)) {
+    // Storage contents are undefined and cached storage is not cleared on
+    // reuse so there's no need to pay for zeroing it here.
+    iree_status_t status = iree_allocator_malloc_uninitialized(
+        data_allocator, size_class->size, &allocation.host_ptr);
+    if (iree_status_is_resource_exhausted(status)) {
+      // Cached blocks of other size classes may be what is keeping us from
+      // allocating; return them and try once more.
+      iree_status_ignore(status);
+      iree_hal_allocation_cache_trim(cache);
+      status = iree_allocator_malloc_uninitialized(
+          data_allocator, size_class->size, &allocation.host_ptr);
+    }
+    IREE_RETURN_IF_ERROR(status);
+  }
+  *out_data = iree_make_byte_span(allocation.host_ptr, allocation_size);
+
+  // Allocate the host metadata wrapper.
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(**out_buffer), (void**)out_buffer);
+  if (!iree_status_is_ok(status)) {
+    // Need to return the storage we just acquired.
+    if (!iree_hal_allocation_cache_release(cache, /*heap=*/0, size_class,
+                                           allocation)) {
+      iree_allocator_free(data_allocator, allocation.host_ptr);
+    }
+  }
+  return status;
+}
+
 iree_status_t iree_hal_heap_buffer_create(
     iree_hal_allocator_t* allocator,
     iree_hal_heap_allocator_statistics_t* statistics,
+    iree_hal_allocation_cache_t* cache,
     iree_hal_memory_type_t memory_type, iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
     iree_allocator_t data_allocator, iree_allocator_t host_allocator,
@@ -85,14 +130,30 @@ iree_status_t iree_hal_heap_buffer_create(
   bool same_allocator =
       memcmp(&data_allocator, &host_allocator, sizeof(data_allocator)) == 0;
 
+  // Cached storage is always split from the metadata as it outlives the
+  // buffer.
+  iree_hal_allocation_cache_class_t size_class;
+  if (cache &&
+      !iree_hal_allocation_cache_lookup_class(cache, allocation_size,
+                                              &size_class)) {
+    cache = NULL;
+  }
+
   iree_hal_heap_buffer_t* buffer = NULL;
   iree_byte_span_t data = iree_make_byte_span(NULL, 0);
-  iree_status_t status =
-      same_allocator
-          ? iree_hal_heap_buffer_allocate_slab(allocation_size, host_allocator,
-                                               &buffer, &data)
-          : iree_hal_heap_buffer_allocate_split(allocation_size, data_allocator,
+  iree_status_t status = iree_ok_status();
+  if (cache) {
+    status = iree_hal_heap_buffer_allocate_cached(
+        cache, &size_class, allocation_size, data_allocator, host_allocator,
+        &buffer, &data);
+    same_allocator = false;
+  } else if (same_allocator) {
+    status = iree_hal_heap_buffer_allocate_slab(allocation_size,
                                                 host_allocator, &buffer, &data);
+  } else {
+    status = iree_hal_heap_buffer_allocate_split(
+        allocation_size, data_allocator, host_allocator, &buffer, &data);
+  }
 
   if (iree_status_is_ok(status)) {
     iree_hal_buffer_initialize(host_allocator, allocator, &buffer->base,
@@ -102,6 +163,7 @@ iree_status_t iree_hal_heap_buffer_create(
     buffer->data = data;
     buffer->data_allocator =
         same_allocator ? iree_allocator_null() : data_allocator;
+    buffer->cache = cache;
 
     IREE_STATISTICS({
       if (statistics != NULL) {
@@ -142,6 +204,7 @@ IREE_API_EXPORT iree_status_t iree_hal_heap_buffer_wrap(
                                &iree_hal_heap_buffer_vtable, &buffer->base);
     buffer->data = data;
     buffer->data_allocator = data_allocator;
+    buffer->cache = NULL;
     *out_buffer = &buffer->base;
   }
 
@@ -164,6 +227,21 @@ static void iree_hal_heap_buffer_destroy(iree_hal_buffer_t* base_buffer) {
     }
   });
 
+  // Return cached storage for reuse by future allocations.
+  iree_hal_allocation_cache_class_t size_class;
+  if (buffer->cache &&
+      iree_hal_allocation_cache_lookup_class(
+          buffer->cache, base_buffer->allocation_size, &size_class)) {
+    iree_hal_cached_allocation_t allocation = {
+        .device_ptr = 0,
+        .host_ptr = buffer->data.data,
+    };
+    if (iree_hal_allocation_cache_release(buffer->cache, /*heap=*/0,
+                                          &size_class, allocation)) {
+      buffer->data.data = NULL;
+    }
+  }
+
   iree_allocator_free(buffer->data_allocator, buffer->data.data);
   iree_allocator_free(host_allocator, buffer);
 
@@ -10,6 +10,7 @@
 #include "iree/base/api.h"
 #include "iree/base/internal/synchronization.h"
 #include "iree/hal/buffer.h"
+#include "iree/hal/utils/allocation_cache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,10 +30,17 @@ typedef struct iree_hal_heap_allocator_statistics_t {
 // Allocates a new heap buffer from the specified |data_allocator|.
 // |host_allocator| is used for the iree_hal_buffer_t metadata. If both
 // |data_allocator| and |host_allocator| are the same the buffer will be created
-// as a flat slab. |out_buffer| must be released by the caller.
+// as a flat slab.
+//
+// If a |cache| is provided and the allocation size is cacheable the storage
+// will be acquired from the cache (or allocated from |data_allocator| with the
+// size of its size class) and returned to it when the buffer is destroyed.
+// The cache uses a single heap and frees its allocations with
+// |data_allocator|. |out_buffer| must be released by the caller.
 iree_status_t iree_hal_heap_buffer_create(
     iree_hal_allocator_t* allocator,
     iree_hal_heap_allocator_statistics_t* statistics,
+    iree_hal_allocation_cache_t* cache,
     iree_hal_memory_type_t memory_type, iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
     iree_allocator_t data_allocator, iree_allocator_t host_allocator,
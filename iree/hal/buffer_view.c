@@ -7,11 +7,17 @@
 #include "iree/hal/buffer_view.h"
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/allocator.h"
 #include "iree/hal/buffer_view_util.h"
 #include "iree/hal/resource.h"
 
+// Minimum number of shape dimensions allocated inline with each buffer view.
+// Views of lower rank are padded such that they can be reused for views of
+// any rank up to this without reallocation.
+#define IREE_HAL_BUFFER_VIEW_MIN_SHAPE_CAPACITY 6
+
 struct iree_hal_buffer_view_t {
   iree_atomic_ref_count_t ref_count;
   iree_allocator_t host_allocator;
@@ -19,10 +25,33 @@ struct iree_hal_buffer_view_t {
   iree_hal_element_type_t element_type;
   iree_hal_encoding_type_t encoding_type;
   iree_device_size_t byte_length;
+  iree_host_size_t shape_capacity;
   iree_host_size_t shape_rank;
   iree_hal_dim_t shape[];
 };
 
+// Assigns the view contents; the shape must fit within the view capacity.
+static void iree_hal_buffer_view_assign(
+    iree_hal_buffer_view_t* buffer_view, iree_hal_buffer_t* buffer,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type) {
+  if (buffer_view->buffer != buffer) {
+    iree_hal_buffer_retain(buffer);
+    iree_hal_buffer_release(buffer_view->buffer);
+    buffer_view->buffer = buffer;
+  }
+  buffer_view->element_type = element_type;
+  buffer_view->encoding_type = encoding_type;
+  buffer_view->byte_length =
+      iree_hal_element_dense_byte_count(buffer_view->element_type);
+  buffer_view->shape_rank = shape_rank;
+  for (iree_host_size_t i = 0; i < shape_rank; ++i) {
+    buffer_view->shape[i] = shape[i];
+    buffer_view->byte_length *= shape[i];
+  }
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
     iree_hal_buffer_t* buffer, const iree_hal_dim_t* shape,
     iree_host_size_t shape_rank, iree_hal_element_type_t element_type,
@@ -41,25 +70,20 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
 
   // Allocate and initialize the iree_hal_buffer_view_t struct.
   // Note that we have the dynamically-sized shape dimensions on the end.
+  iree_host_size_t shape_capacity =
+      iree_max(shape_rank, IREE_HAL_BUFFER_VIEW_MIN_SHAPE_CAPACITY);
   iree_hal_buffer_view_t* buffer_view = NULL;
   iree_status_t status = iree_allocator_malloc(
       host_allocator,
-      sizeof(*buffer_view) + sizeof(iree_hal_dim_t) * shape_rank,
+      sizeof(*buffer_view) + sizeof(iree_hal_dim_t) * shape_capacity,
       (void**)&buffer_view);
   if (iree_status_is_ok(status)) {
     iree_atomic_ref_count_init(&buffer_view->ref_count);
     buffer_view->host_allocator = host_allocator;
-    buffer_view->buffer = buffer;
-    iree_hal_buffer_retain(buffer_view->buffer);
-    buffer_view->element_type = element_type;
-    buffer_view->encoding_type = encoding_type;
-    buffer_view->byte_length =
-        iree_hal_element_dense_byte_count(buffer_view->element_type);
-    buffer_view->shape_rank = shape_rank;
-    for (iree_host_size_t i = 0; i < shape_rank; ++i) {
-      buffer_view->shape[i] = shape[i];
-      buffer_view->byte_length *= shape[i];
-    }
+    buffer_view->buffer = NULL;
+    buffer_view->shape_capacity = shape_capacity;
+    iree_hal_buffer_view_assign(buffer_view, buffer, shape, shape_rank,
+                                element_type, encoding_type);
     *out_buffer_view = buffer_view;
   }
 
@@ -67,6 +91,46 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
   return status;
 }
 
+IREE_API_EXPORT bool iree_hal_buffer_view_is_equivalent(
+    const iree_hal_buffer_view_t* buffer_view, const iree_hal_buffer_t* buffer,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type) {
+  IREE_ASSERT_ARGUMENT(buffer_view);
+  if (buffer_view->buffer != buffer ||
+      buffer_view->element_type != element_type ||
+      buffer_view->encoding_type != encoding_type ||
+      buffer_view->shape_rank != shape_rank) {
+    return false;
+  }
+  for (iree_host_size_t i = 0; i < shape_rank; ++i) {
+    if (buffer_view->shape[i] != shape[i]) return false;
+  }
+  return true;
+}
+
+IREE_API_EXPORT bool iree_hal_buffer_view_try_update(
+    iree_hal_buffer_view_t* buffer_view, iree_hal_buffer_t* buffer,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type) {
+  IREE_ASSERT_ARGUMENT(buffer_view);
+  IREE_ASSERT_ARGUMENT(buffer);
+  if (shape_rank > buffer_view->shape_capacity) return false;
+  if (shape_rank > 0 && !shape) return false;
+
+  // If the caller holds the only reference no other thread can acquire one
+  // and it's safe to mutate the view.
+  if (iree_atomic_load_int32(&buffer_view->ref_count,
+                             iree_memory_order_acquire) != 1) {
+    return false;
+  }
+
+  iree_hal_buffer_view_assign(buffer_view, buffer, shape, shape_rank,
+                              element_type, encoding_type);
+  return true;
+}
+
 IREE_API_EXPORT void iree_hal_buffer_view_retain(
     iree_hal_buffer_view_t* buffer_view) {
   if (IREE_LIKELY(buffer_view)) {
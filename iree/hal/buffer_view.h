@@ -174,6 +174,27 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
     iree_hal_encoding_type_t encoding_type, iree_allocator_t host_allocator,
     iree_hal_buffer_view_t** out_buffer_view);
 
+// Returns true if |buffer_view| is a view of |buffer| with the given shape and
+// types such that it could be used in place of a newly created view.
+IREE_API_EXPORT bool iree_hal_buffer_view_is_equivalent(
+    const iree_hal_buffer_view_t* buffer_view, const iree_hal_buffer_t* buffer,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type);
+
+// Updates |buffer_view| in place to view |buffer| with the given shape and
+// types. This avoids the allocation of a new view when the caller holds the
+// only reference to an existing one that is no longer needed (such as a view
+// from a prior invocation that has since been released by its user).
+//
+// Returns false and leaves the view unchanged if there are other outstanding
+// references to the view or the shape exceeds the rank it was allocated with.
+IREE_API_EXPORT bool iree_hal_buffer_view_try_update(
+    iree_hal_buffer_view_t* buffer_view, iree_hal_buffer_t* buffer,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type);
+
 // Retains the given |buffer_view| for the caller.
 IREE_API_EXPORT void iree_hal_buffer_view_retain(
     iree_hal_buffer_view_t* buffer_view);
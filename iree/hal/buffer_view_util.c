@@ -584,43 +584,187 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_format(
   return status;
 }
 
-// TODO(benvanik): streaming all the way down (needs string_util updates).
-IREE_API_EXPORT iree_status_t iree_hal_buffer_view_fprint(
-    FILE* file, const iree_hal_buffer_view_t* buffer_view,
-    iree_host_size_t max_element_count, iree_allocator_t host_allocator) {
-  IREE_ASSERT_ARGUMENT(file);
-  IREE_ASSERT_ARGUMENT(buffer_view);
-  IREE_TRACE_ZONE_BEGIN(z0);
+// Fixed-size staging buffer for streaming formatted output to a FILE.
+// Elements are formatted directly into the staging buffer and it is flushed
+// as it fills such that printing large buffer views needs neither a length
+// query pass nor a heap allocation sized to the entire formatted output.
+typedef struct iree_hal_buffer_view_fprint_stream_t {
+  FILE* file;
+  iree_host_size_t length;
+  char buffer[4096];
+} iree_hal_buffer_view_fprint_stream_t;
+
+static iree_status_t iree_hal_buffer_view_fprint_stream_flush(
+    iree_hal_buffer_view_fprint_stream_t* stream) {
+  if (stream->length == 0) return iree_ok_status();
+  size_t written = fwrite(stream->buffer, 1, stream->length, stream->file);
+  bool failed = written != stream->length;
+  stream->length = 0;
+  if (IREE_UNLIKELY(failed)) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS,
+                            "failed to write formatted output to file");
+  }
+  return iree_ok_status();
+}
 
-  // Query the string length (in characters).
-  iree_host_size_t buffer_length = 0;
-  iree_status_t status = iree_hal_buffer_view_format(
-      buffer_view, max_element_count, 0, NULL, &buffer_length);
-  if (!iree_status_is_out_of_range(status)) {
-    IREE_TRACE_ZONE_END(z0);
-    return status;
+static iree_status_t iree_hal_buffer_view_fprint_stream_append_char(
+    iree_hal_buffer_view_fprint_stream_t* stream, char c) {
+  if (stream->length == IREE_ARRAYSIZE(stream->buffer)) {
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_view_fprint_stream_flush(stream));
   }
+  stream->buffer[stream->length++] = c;
+  return iree_ok_status();
+}
 
-  // Allocate scratch space to format in to.
-  // We should be streaming.
-  iree_host_size_t buffer_capacity = buffer_length + 1;  // NUL
-  char* buffer = NULL;
-  status =
-      iree_allocator_malloc(host_allocator, buffer_capacity, (void**)&buffer);
+static iree_status_t iree_hal_buffer_view_fprint_stream_append_element(
+    iree_hal_buffer_view_fprint_stream_t* stream, iree_const_byte_span_t data,
+    iree_hal_element_type_t element_type) {
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    iree_host_size_t element_length = 0;
+    iree_status_t status = iree_hal_format_element(
+        data, element_type, IREE_ARRAYSIZE(stream->buffer) - stream->length,
+        stream->buffer + stream->length, &element_length);
+    if (iree_status_is_ok(status)) {
+      stream->length += element_length;
+      return iree_ok_status();
+    } else if (!iree_status_is_out_of_range(status) || stream->length == 0) {
+      return status;
+    }
+    // Didn't fit in the remaining staging space; flush and try again.
+    iree_status_ignore(status);
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_view_fprint_stream_flush(stream));
+  }
+  return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                          "element too large to format");
+}
 
-  // Format the buffer into the string storage.
-  if (iree_status_is_ok(status)) {
-    status =
-        iree_hal_buffer_view_format(buffer_view, max_element_count,
-                                    buffer_capacity, buffer, &buffer_length);
+// Streaming equivalent of iree_hal_format_buffer_elements producing identical
+// output.
+static iree_status_t iree_hal_buffer_view_fprint_elements_recursive(
+    iree_hal_buffer_view_fprint_stream_t* stream, iree_const_byte_span_t data,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type, iree_host_size_t* max_element_count) {
+  iree_device_size_t element_stride =
+      iree_hal_element_dense_byte_count(element_type);
+  if (shape_rank == 0) {
+    // Scalar value; recurse to get on to the leaf dimension path.
+    const iree_hal_dim_t one = 1;
+    return iree_hal_buffer_view_fprint_elements_recursive(
+        stream, data, &one, 1, element_type, max_element_count);
+  } else if (shape_rank > 1) {
+    // Nested dimension; recurse into the next innermost dimension.
+    iree_hal_dim_t dim_length = 1;
+    for (iree_host_size_t i = 1; i < shape_rank; ++i) {
+      dim_length *= shape[i];
+    }
+    iree_device_size_t dim_stride = dim_length * element_stride;
+    if (data.data_length < dim_stride * shape[0]) {
+      return iree_make_status(
+          IREE_STATUS_OUT_OF_RANGE,
+          "input data underflow: data_length=%zu < expected=%zu",
+          data.data_length, (iree_host_size_t)(dim_stride * shape[0]));
+    }
+    iree_const_byte_span_t subdata =
+        iree_make_const_byte_span(data.data, dim_stride);
+    for (iree_hal_dim_t i = 0; i < shape[0]; ++i) {
+      IREE_RETURN_IF_ERROR(
+          iree_hal_buffer_view_fprint_stream_append_char(stream, '['));
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_view_fprint_elements_recursive(
+          stream, subdata, shape + 1, shape_rank - 1, element_type,
+          max_element_count));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_buffer_view_fprint_stream_append_char(stream, ']'));
+      subdata.data += dim_stride;
+    }
+    return iree_ok_status();
+  }
+
+  // Leaf dimension; output data.
+  iree_host_size_t max_count =
+      iree_min(*max_element_count, (iree_host_size_t)shape[0]);
+  if (data.data_length < max_count * element_stride) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "input data underflow; data_length=%zu < expected=%zu",
+        data.data_length, (iree_host_size_t)(max_count * element_stride));
+  }
+  *max_element_count -= max_count;
+  iree_const_byte_span_t subdata =
+      iree_make_const_byte_span(data.data, element_stride);
+  for (iree_host_size_t i = 0; i < max_count; ++i) {
+    if (i > 0) {
+      IREE_RETURN_IF_ERROR(
+          iree_hal_buffer_view_fprint_stream_append_char(stream, ' '));
+    }
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_view_fprint_stream_append_element(
+        stream, subdata, element_type));
+    subdata.data += element_stride;
+  }
+  if (max_count < shape[0]) {
+    for (int i = 0; i < 3; ++i) {
+      IREE_RETURN_IF_ERROR(
+          iree_hal_buffer_view_fprint_stream_append_char(stream, '.'));
+    }
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_buffer_view_fprint_impl(
+    iree_hal_buffer_view_fprint_stream_t* stream,
+    const iree_hal_buffer_view_t* buffer_view,
+    iree_host_size_t max_element_count) {
+  const iree_hal_dim_t* shape = iree_hal_buffer_view_shape_dims(buffer_view);
+  iree_host_size_t shape_rank = iree_hal_buffer_view_shape_rank(buffer_view);
+  iree_hal_element_type_t element_type =
+      iree_hal_buffer_view_element_type(buffer_view);
+
+  // Shape: 1x2x3
+  for (iree_host_size_t i = 0; i < shape_rank; ++i) {
+    if (IREE_UNLIKELY(fprintf(stream->file, "%dx", shape[i]) < 0)) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "failed to write shape to file");
+    }
   }
 
-  // Dump to the file.
+  // Element type: f32
+  // The staging buffer is empty and always large enough for the type name.
+  IREE_RETURN_IF_ERROR(iree_hal_format_element_type(
+      element_type, IREE_ARRAYSIZE(stream->buffer), stream->buffer,
+      &stream->length));
+
+  // Separator: <meta>=<value>
+  IREE_RETURN_IF_ERROR(
+      iree_hal_buffer_view_fprint_stream_append_char(stream, '='));
+
+  // Buffer contents: 0 1 2 3 ...
+  iree_hal_buffer_mapping_t buffer_mapping = {{0}};
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+      iree_hal_buffer_view_buffer(buffer_view), IREE_HAL_MAPPING_MODE_SCOPED,
+      IREE_HAL_MEMORY_ACCESS_READ, 0, IREE_WHOLE_BUFFER, &buffer_mapping));
+  iree_status_t status = iree_hal_buffer_view_fprint_elements_recursive(
+      stream,
+      iree_make_const_byte_span(buffer_mapping.contents.data,
+                                buffer_mapping.contents.data_length),
+      shape, shape_rank, element_type, &max_element_count);
+  status =
+      iree_status_join(status, iree_hal_buffer_unmap_range(&buffer_mapping));
   if (iree_status_is_ok(status)) {
-    fprintf(file, "%.*s", (int)buffer_length, buffer);
+    status = iree_hal_buffer_view_fprint_stream_flush(stream);
   }
+  return status;
+}
 
-  iree_allocator_free(host_allocator, buffer);
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_fprint(
+    FILE* file, const iree_hal_buffer_view_t* buffer_view,
+    iree_host_size_t max_element_count, iree_allocator_t host_allocator) {
+  IREE_ASSERT_ARGUMENT(file);
+  IREE_ASSERT_ARGUMENT(buffer_view);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_buffer_view_fprint_stream_t stream;
+  stream.file = file;
+  stream.length = 0;
+  iree_status_t status =
+      iree_hal_buffer_view_fprint_impl(&stream, buffer_view, max_element_count);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -245,6 +245,77 @@ TEST_P(command_buffer_test, CopySubBuffer) {
   iree_hal_buffer_release(host_buffer);
 }
 
+// Records a chain of dependent transfers interleaved with independent ones and
+// verifies that barriers order only the operations that touch the same memory.
+TEST_P(command_buffer_test, BarrierOrdersDependentTransfers) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+
+  iree_hal_buffer_t* buffers[3] = {NULL};
+  for (size_t i = 0; i < IREE_ARRAYSIZE(buffers); ++i) {
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, iree_const_byte_span_empty(),
+        &buffers[i]));
+  }
+
+  uint8_t a_val = 0xAA;
+  uint8_t b_val = 0xBB;
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  // A = 0xAA, B = 0xBB (concurrently).
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, buffers[0], /*target_offset=*/0, /*length=*/kBufferSize,
+      &a_val, /*pattern_length=*/sizeof(a_val)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, buffers[1], /*target_offset=*/0, /*length=*/kBufferSize,
+      &b_val, /*pattern_length=*/sizeof(b_val)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+      IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      /*memory_barrier_count=*/0, NULL, /*buffer_barrier_count=*/0, NULL));
+  // C = A (reads A after the fill).
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, /*source_buffer=*/buffers[0], /*source_offset=*/0,
+      /*target_buffer=*/buffers[2], /*target_offset=*/0,
+      /*length=*/kBufferSize));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+      IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      /*memory_barrier_count=*/0, NULL, /*buffer_barrier_count=*/0, NULL));
+  // A[0:half] = B[0:half] (overwrites A only after C has read it).
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, /*source_buffer=*/buffers[1], /*source_offset=*/0,
+      /*target_buffer=*/buffers[0], /*target_offset=*/0,
+      /*length=*/kBufferSize / 2));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  IREE_ASSERT_OK(SubmitCommandBufferAndWait(IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+                                            command_buffer));
+
+  std::vector<uint8_t> reference_a(kBufferSize, a_val);
+  std::memset(reference_a.data(), b_val, kBufferSize / 2);
+  std::vector<uint8_t> reference_c(kBufferSize, a_val);
+  std::vector<uint8_t> actual_data(kBufferSize);
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(buffers[0], /*source_offset=*/0,
+                                           /*target_buffer=*/actual_data.data(),
+                                           /*data_length=*/kBufferSize));
+  EXPECT_THAT(actual_data, ContainerEq(reference_a));
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(buffers[2], /*source_offset=*/0,
+                                           /*target_buffer=*/actual_data.data(),
+                                           /*data_length=*/kBufferSize));
+  EXPECT_THAT(actual_data, ContainerEq(reference_c));
+
+  // Must release the command buffer before resources used by it.
+  iree_hal_command_buffer_release(command_buffer);
+  for (size_t i = 0; i < IREE_ARRAYSIZE(buffers); ++i) {
+    iree_hal_buffer_release(buffers[i]);
+  }
+}
+
 TEST_P(command_buffer_test, FillBuffer_pattern1_size1_offset0_length1) {
   iree_device_size_t buffer_size = 1;
   iree_device_size_t target_offset = 0;
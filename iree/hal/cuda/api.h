@@ -27,11 +27,16 @@ typedef enum iree_hal_cuda_command_buffer_mode_e {
 // Parameters configuring an iree_hal_cuda_device_t.
 // Must be initialized with iree_hal_cuda_device_params_initialize prior to use.
 typedef struct iree_hal_cuda_device_params_t {
-  // Number of queues exposed on the device.
+  // Number of queues exposed on the device; each is backed by its own stream.
   // Each queue acts as a separate synchronization scope where all work executes
-  // concurrently unless prohibited by semaphores.
+  // concurrently unless prohibited by semaphores. Queue affinity bits select
+  // queues modulo this count. At most 64 are supported.
   iree_host_size_t queue_count;
 
+  // Creates an additional queue used for submissions containing only transfer
+  // commands so that copies can overlap with dispatches on the general queues.
+  bool dedicated_transfer_queue;
+
   // Total size of each block in the device shared block pool.
   // Larger sizes will lower overhead and ensure the heap isn't hit for
   // transient allocations while also increasing memory consumption.
@@ -40,10 +45,35 @@ typedef struct iree_hal_cuda_device_params_t {
   // Specifies how command buffers are recorded and executed.
   iree_hal_cuda_command_buffer_mode_t command_buffer_mode;
 
+  // Maximum number of instantiated CUDA graphs retained after the command
+  // buffers that recorded them are released. Graph command buffers recorded
+  // with the same structure as a retained graph update it in place instead of
+  // instantiating a new one. 0 disables reuse.
+  iree_host_size_t graph_exec_cache_capacity;
+
   // Allow executing command buffers against CUDA streams as they are recorded.
   // Only command buffers produced by the compiler that have the
   // IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION bit set will use this.
   bool allow_inline_execution;
+
+  // Maximum total size in bytes of freed allocations the device allocator
+  // retains for reuse. Allocations are rounded up to size classes and served
+  // from the cache when possible to avoid the cost and implicit device
+  // synchronization of cuMemAlloc/cuMemFree. iree_hal_allocator_trim returns
+  // all cached memory to CUDA. 0 disables the cache.
+  iree_device_size_t allocation_cache_limit;
+
+  // Size in bytes of each slot of the pinned staging ring used to transfer
+  // between host memory and device-local buffers that cannot be mapped.
+  // Transfers larger than a slot are pipelined through multiple slots.
+  // 0 disables the ring and allocates staging buffers per transfer.
+  iree_device_size_t staging_ring_slot_size;
+
+  // Existing directory where PTX JIT compilation results are cached across
+  // processes for executables that do not embed a cubin compatible with the
+  // device. Entries are keyed by the PTX contents, device architecture, and
+  // driver version. Empty to leave caching to the CUDA driver.
+  iree_string_view_t jit_cache_path;
 } iree_hal_cuda_device_params_t;
 
 // Initializes |out_params| to default values.
@@ -75,6 +105,29 @@ IREE_API_EXPORT iree_status_t iree_hal_cuda_driver_create(
 
 // TODO(thomasraoux): Support importing a CUcontext from app.
 
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_allocator_t
+//===----------------------------------------------------------------------===//
+
+// Statistics of the allocation cache of a CUDA device allocator.
+typedef struct iree_hal_cuda_allocation_cache_statistics_t {
+  // Number of allocations served from cached memory.
+  uint64_t hit_count;
+  // Number of cacheable allocations that required a new CUDA allocation.
+  uint64_t miss_count;
+  // Number of times the cache was trimmed, either explicitly or in response to
+  // CUDA running out of memory.
+  uint64_t trim_count;
+  // Total size in bytes of the memory currently held in the cache.
+  iree_device_size_t cache_size;
+} iree_hal_cuda_allocation_cache_statistics_t;
+
+// Queries the allocation cache statistics of |allocator|, which must be the
+// allocator of a CUDA device (see iree_hal_device_allocator).
+IREE_API_EXPORT iree_status_t iree_hal_cuda_allocator_query_cache_statistics(
+    iree_hal_allocator_t* allocator,
+    iree_hal_cuda_allocation_cache_statistics_t* out_statistics);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
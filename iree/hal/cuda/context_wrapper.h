@@ -17,6 +17,8 @@ typedef struct iree_hal_cuda_context_wrapper_t {
   CUcontext cu_context;
   iree_allocator_t host_allocator;
   iree_hal_cuda_dynamic_symbols_t* syms;
+  // Vendor library state; see library_calls.h.
+  struct iree_hal_cuda_library_state_t* library_state;
 } iree_hal_cuda_context_wrapper_t;
 
 #endif  // IREE_HAL_CUDA_CONTEXT_WRAPPER_H_
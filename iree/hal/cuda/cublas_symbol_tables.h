@@ -0,0 +1,15 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// cuBLAS entry points used for library call dispatches. Enum arguments
+// (operations, data types, compute types, and algorithms) are passed as ints
+// so that the cuBLAS headers are not required to build the driver.
+CUBLAS_PFN_DECL(cublasCreate_v2, iree_hal_cuda_cublas_handle_t*)
+CUBLAS_PFN_DECL(cublasDestroy_v2, iree_hal_cuda_cublas_handle_t)
+CUBLAS_PFN_DECL(cublasSetStream_v2, iree_hal_cuda_cublas_handle_t, CUstream)
+CUBLAS_PFN_DECL(cublasGemmEx, iree_hal_cuda_cublas_handle_t, int, int, int,
+                int, int, const void*, const void*, int, int, const void*,
+                int, int, const void*, void*, int, int, int, int)
@@ -13,6 +13,23 @@
 #include "iree/hal/cuda/cuda_buffer.h"
 #include "iree/hal/cuda/dynamic_symbols.h"
 #include "iree/hal/cuda/status_util.h"
+#include "iree/hal/utils/allocation_cache.h"
+
+//===----------------------------------------------------------------------===//
+// Allocation cache
+//===----------------------------------------------------------------------===//
+
+// Physical heaps that freed allocations are cached for. Managed memory is not
+// cached as its residency is tied to the prefetches issued at allocation time.
+typedef enum iree_hal_cuda_cache_heap_e {
+  // cuMemAlloc.
+  IREE_HAL_CUDA_CACHE_HEAP_DEVICE = 0,
+  // cuMemHostAlloc with CU_MEMHOSTALLOC_WRITECOMBINED.
+  IREE_HAL_CUDA_CACHE_HEAP_HOST_WRITE_COMBINED,
+  // cuMemHostAlloc without CU_MEMHOSTALLOC_WRITECOMBINED.
+  IREE_HAL_CUDA_CACHE_HEAP_HOST_CACHED,
+  IREE_HAL_CUDA_CACHE_HEAP_COUNT,
+} iree_hal_cuda_cache_heap_t;
 
 typedef struct iree_hal_cuda_allocator_t {
   iree_hal_resource_t resource;
@@ -22,6 +39,9 @@ typedef struct iree_hal_cuda_allocator_t {
   CUstream stream;
   bool supports_concurrent_managed_access;
 
+  // Freed device-only and pinned host allocations retained for reuse.
+  iree_hal_allocation_cache_t cache;
+
   IREE_STATISTICS(iree_hal_allocator_statistics_t statistics;)
 } iree_hal_cuda_allocator_t;
 
@@ -33,9 +53,44 @@ static iree_hal_cuda_allocator_t* iree_hal_cuda_allocator_cast(
   return (iree_hal_cuda_allocator_t*)base_value;
 }
 
+// Returns the heap allocations of |memory_type| are made from in |out_heap|.
+// Returns false if allocations of the type are not cached.
+static bool iree_hal_cuda_cache_heap(iree_hal_memory_type_t memory_type,
+                                     iree_hal_cuda_cache_heap_t* out_heap) {
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+      return false;
+    }
+    *out_heap = IREE_HAL_CUDA_CACHE_HEAP_DEVICE;
+  } else if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_CACHED)) {
+    *out_heap = IREE_HAL_CUDA_CACHE_HEAP_HOST_CACHED;
+  } else {
+    *out_heap = IREE_HAL_CUDA_CACHE_HEAP_HOST_WRITE_COMBINED;
+  }
+  return true;
+}
+
+// Frees a cached allocation evicted from the cache back to CUDA.
+static void iree_hal_cuda_cache_free(void* user_data, iree_host_size_t heap,
+                                     iree_hal_cached_allocation_t allocation) {
+  iree_hal_cuda_allocator_t* allocator = (iree_hal_cuda_allocator_t*)user_data;
+  if (heap == IREE_HAL_CUDA_CACHE_HEAP_DEVICE) {
+    CUDA_IGNORE_ERROR(allocator->context->syms,
+                      cuMemFree((CUdeviceptr)allocation.device_ptr));
+  } else {
+    CUDA_IGNORE_ERROR(allocator->context->syms,
+                      cuMemFreeHost(allocation.host_ptr));
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_allocator_t
+//===----------------------------------------------------------------------===//
+
 iree_status_t iree_hal_cuda_allocator_create(
     iree_hal_device_t* base_device, iree_hal_cuda_context_wrapper_t* context,
-    CUdevice device, CUstream stream, iree_hal_allocator_t** out_allocator) {
+    CUdevice device, CUstream stream, iree_device_size_t cache_limit,
+    iree_hal_allocator_t** out_allocator) {
   IREE_ASSERT_ARGUMENT(base_device);
   IREE_ASSERT_ARGUMENT(context);
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -65,6 +120,7 @@ iree_status_t iree_hal_cuda_allocator_create(
   iree_status_t status = iree_allocator_malloc(
       context->host_allocator, sizeof(*allocator), (void**)&allocator);
   if (iree_status_is_ok(status)) {
+    memset(allocator, 0, sizeof(*allocator));
     iree_hal_resource_initialize(&iree_hal_cuda_allocator_vtable,
                                  &allocator->resource);
     allocator->base_device = base_device;
@@ -73,6 +129,13 @@ iree_status_t iree_hal_cuda_allocator_create(
     allocator->stream = stream;
     allocator->supports_concurrent_managed_access =
         supports_concurrent_managed_access != 0;
+    iree_hal_allocation_cache_free_callback_t free_callback = {
+        .fn = iree_hal_cuda_cache_free,
+        .user_data = allocator,
+    };
+    iree_hal_allocation_cache_initialize(
+        cache_limit, IREE_HAL_CUDA_CACHE_HEAP_COUNT, free_callback,
+        context->host_allocator, &allocator->cache);
     *out_allocator = (iree_hal_allocator_t*)allocator;
   }
 
@@ -80,6 +143,13 @@ iree_status_t iree_hal_cuda_allocator_create(
   return status;
 }
 
+iree_hal_device_t* iree_hal_cuda_allocator_device(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+  return allocator->base_device;
+}
+
 static void iree_hal_cuda_allocator_destroy(
     iree_hal_allocator_t* base_allocator) {
   iree_hal_cuda_allocator_t* allocator =
@@ -87,6 +157,7 @@ static void iree_hal_cuda_allocator_destroy(
   iree_allocator_t host_allocator = allocator->context->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_allocation_cache_deinitialize(&allocator->cache);
   iree_allocator_free(host_allocator, allocator);
 
   IREE_TRACE_ZONE_END(z0);
@@ -101,6 +172,29 @@ static iree_allocator_t iree_hal_cuda_allocator_host_allocator(
 
 static iree_status_t iree_hal_cuda_allocator_trim(
     iree_hal_allocator_t* base_allocator) {
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+  iree_hal_allocation_cache_trim(&allocator->cache);
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_cuda_allocator_query_cache_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_cuda_allocation_cache_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  if (!iree_hal_resource_is(base_allocator, &iree_hal_cuda_allocator_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocator is not a CUDA allocator");
+  }
+  iree_hal_cuda_allocator_t* allocator =
+      (iree_hal_cuda_allocator_t*)base_allocator;
+  iree_hal_allocation_cache_statistics_t statistics;
+  iree_hal_allocation_cache_query_statistics(&allocator->cache, &statistics);
+  out_statistics->hit_count = statistics.hit_count;
+  out_statistics->miss_count = statistics.miss_count;
+  out_statistics->trim_count = statistics.trim_count;
+  out_statistics->cache_size = statistics.cache_size;
   return iree_ok_status();
 }
 
@@ -111,6 +205,12 @@ static void iree_hal_cuda_allocator_query_statistics(
     iree_hal_cuda_allocator_t* allocator =
         iree_hal_cuda_allocator_cast(base_allocator);
     memcpy(out_statistics, &allocator->statistics, sizeof(*out_statistics));
+    iree_hal_allocation_cache_statistics_t cache_statistics;
+    iree_hal_allocation_cache_query_statistics(&allocator->cache,
+                                               &cache_statistics);
+    out_statistics->cache_hit_count = cache_statistics.hit_count;
+    out_statistics->cache_miss_count = cache_statistics.miss_count;
+    out_statistics->cache_bytes = cache_statistics.cache_size;
   });
 }
 
@@ -158,6 +258,77 @@ static void iree_hal_cuda_buffer_free(iree_hal_cuda_context_wrapper_t* context,
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Allocates |allocation_size| bytes of |memory_type| from CUDA.
+// Returns the raw CUDA result so that callers can handle out-of-memory errors.
+static CUresult iree_hal_cuda_buffer_allocate(
+    iree_hal_cuda_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_device_size_t allocation_size, CUdeviceptr* out_device_ptr,
+    void** out_host_ptr) {
+  iree_hal_cuda_dynamic_symbols_t* syms = allocator->context->syms;
+  CUresult result = CUDA_SUCCESS;
+  void* host_ptr = NULL;
+  CUdeviceptr device_ptr = 0;
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_cuda_buffer_allocate");
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    // Device local case.
+    if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+      result = syms->cuMemAllocManaged(&device_ptr, allocation_size,
+                                       CU_MEM_ATTACH_GLOBAL);
+      if (result == CUDA_SUCCESS) {
+        // Prefetch the buffer on the GPU device.
+        result = syms->cuMemPrefetchAsync(device_ptr, allocation_size,
+                                          allocator->device, allocator->stream);
+        if (result != CUDA_SUCCESS) syms->cuMemFree(device_ptr);
+      }
+      host_ptr = (void*)device_ptr;
+    } else {
+      // Device only.
+      result = syms->cuMemAlloc(&device_ptr, allocation_size);
+    }
+  } else {
+    unsigned int flags = CU_MEMHOSTALLOC_DEVICEMAP;
+    if (!iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_CACHED)) {
+      flags |= CU_MEMHOSTALLOC_WRITECOMBINED;
+    }
+    result = syms->cuMemHostAlloc(&host_ptr, allocation_size, flags);
+    if (result == CUDA_SUCCESS) {
+      result = syms->cuMemHostGetDevicePointer(&device_ptr, host_ptr,
+                                               /*flags=*/0);
+      if (result != CUDA_SUCCESS) syms->cuMemFreeHost(host_ptr);
+    }
+  }
+  if (result == CUDA_SUCCESS) {
+    *out_device_ptr = device_ptr;
+    *out_host_ptr = host_ptr;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return result;
+}
+
+// Returns the memory backing a buffer of |allocation_size| bytes to the cache
+// or frees it if it cannot be cached.
+static void iree_hal_cuda_allocator_release_memory(
+    iree_hal_cuda_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_device_size_t allocation_size, CUdeviceptr device_ptr,
+    void* host_ptr) {
+  iree_hal_cuda_cache_heap_t cache_heap = IREE_HAL_CUDA_CACHE_HEAP_DEVICE;
+  iree_hal_allocation_cache_class_t size_class;
+  if (iree_hal_cuda_cache_heap(memory_type, &cache_heap) &&
+      iree_hal_allocation_cache_lookup_class(&allocator->cache,
+                                             allocation_size, &size_class)) {
+    iree_hal_cached_allocation_t allocation = {
+        .device_ptr = (uint64_t)device_ptr,
+        .host_ptr = host_ptr,
+    };
+    if (iree_hal_allocation_cache_release(&allocator->cache, cache_heap,
+                                          &size_class, allocation)) {
+      return;
+    }
+  }
+  iree_hal_cuda_buffer_free(allocator->context, memory_type, device_ptr,
+                            host_ptr);
+}
+
 static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
     iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
     iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
@@ -183,45 +354,41 @@ static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
         IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
   }
 
+  // Cacheable allocations are rounded up to their size class so that the
+  // memory can be reused by any other allocation in the same class once freed.
+  iree_hal_cuda_cache_heap_t cache_heap = IREE_HAL_CUDA_CACHE_HEAP_DEVICE;
+  iree_hal_allocation_cache_class_t size_class = {
+      .index = 0,
+      .size = allocation_size,
+  };
+  const bool cacheable =
+      iree_hal_cuda_cache_heap(memory_type, &cache_heap) &&
+      iree_hal_allocation_cache_lookup_class(&allocator->cache,
+                                             allocation_size, &size_class);
+  const iree_device_size_t class_size = size_class.size;
+
   iree_status_t status = iree_ok_status();
   void* host_ptr = NULL;
   CUdeviceptr device_ptr = 0;
-  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_cuda_buffer_allocate");
-  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
-    // Device local case.
-    if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
-      status =
-          CU_RESULT_TO_STATUS(allocator->context->syms,
-                              cuMemAllocManaged(&device_ptr, allocation_size,
-                                                CU_MEM_ATTACH_GLOBAL));
-      if (iree_status_is_ok(status)) {
-        // Prefetch the buffer on the GPU device.
-        status = CU_RESULT_TO_STATUS(
-            allocator->context->syms,
-            cuMemPrefetchAsync(device_ptr, allocation_size, allocator->device,
-                               allocator->stream));
-      }
-      host_ptr = (void*)device_ptr;
-    } else {
-      // Device only.
-      status = CU_RESULT_TO_STATUS(allocator->context->syms,
-                                   cuMemAlloc(&device_ptr, allocation_size));
-    }
+  iree_hal_cached_allocation_t cached_allocation;
+  if (cacheable && iree_hal_allocation_cache_acquire(
+                       &allocator->cache, cache_heap, &size_class,
+                       &cached_allocation)) {
+    device_ptr = (CUdeviceptr)cached_allocation.device_ptr;
+    host_ptr = cached_allocation.host_ptr;
   } else {
-    unsigned int flags = CU_MEMHOSTALLOC_DEVICEMAP;
-    if (!iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_CACHED)) {
-      flags |= CU_MEMHOSTALLOC_WRITECOMBINED;
-    }
-    status =
-        CU_RESULT_TO_STATUS(allocator->context->syms,
-                            cuMemHostAlloc(&host_ptr, allocation_size, flags));
-    if (iree_status_is_ok(status)) {
-      status = CU_RESULT_TO_STATUS(
-          allocator->context->syms,
-          cuMemHostGetDevicePointer(&device_ptr, host_ptr, /*flags=*/0));
+    CUresult result = iree_hal_cuda_buffer_allocate(
+        allocator, memory_type, class_size, &device_ptr, &host_ptr);
+    if (result == CUDA_ERROR_OUT_OF_MEMORY) {
+      // Cached blocks of other size classes may be what is keeping us from
+      // allocating; return them to CUDA and try once more.
+      iree_hal_allocation_cache_trim(&allocator->cache);
+      result = iree_hal_cuda_buffer_allocate(allocator, memory_type, class_size,
+                                             &device_ptr, &host_ptr);
     }
+    status = iree_hal_cuda_result_to_status(allocator->context->syms, result,
+                                            __FILE__, __LINE__);
   }
-  IREE_TRACE_ZONE_END(z0);
 
   iree_hal_buffer_t* buffer = NULL;
   if (iree_status_is_ok(status)) {
@@ -250,8 +417,10 @@ static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
     *out_buffer = buffer;
   } else {
     if (!buffer) {
-      iree_hal_cuda_buffer_free(allocator->context, memory_type, device_ptr,
-                                host_ptr);
+      if (device_ptr || host_ptr) {
+        iree_hal_cuda_allocator_release_memory(
+            allocator, memory_type, allocation_size, device_ptr, host_ptr);
+      }
     } else {
       iree_hal_buffer_release(buffer);
     }
@@ -264,9 +433,10 @@ static void iree_hal_cuda_allocator_deallocate_buffer(
   iree_hal_cuda_allocator_t* allocator =
       iree_hal_cuda_allocator_cast(base_allocator);
   iree_hal_memory_type_t memory_type = iree_hal_buffer_memory_type(base_buffer);
-  iree_hal_cuda_buffer_free(allocator->context, memory_type,
-                            iree_hal_cuda_buffer_device_pointer(base_buffer),
-                            iree_hal_cuda_buffer_host_pointer(base_buffer));
+  iree_hal_cuda_allocator_release_memory(
+      allocator, memory_type, iree_hal_buffer_allocation_size(base_buffer),
+      iree_hal_cuda_buffer_device_pointer(base_buffer),
+      iree_hal_cuda_buffer_host_pointer(base_buffer));
 
   IREE_STATISTICS(iree_hal_allocator_statistics_record_free(
       &allocator->statistics, memory_type,
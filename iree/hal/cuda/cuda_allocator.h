@@ -9,6 +9,7 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/hal/cuda/api.h"
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/status_util.h"
 
@@ -17,9 +18,17 @@ extern "C" {
 #endif  // __cplusplus
 
 // Create a cuda allocator.
+// Up to |cache_limit| bytes of freed device-only and pinned host allocations
+// are retained for reuse by later allocations of a similar size; 0 disables
+// caching. Buffers must not be in use by the device when they are freed.
 iree_status_t iree_hal_cuda_allocator_create(
     iree_hal_device_t* base_device, iree_hal_cuda_context_wrapper_t* context,
-    CUdevice device, CUstream stream, iree_hal_allocator_t** out_allocator);
+    CUdevice device, CUstream stream, iree_device_size_t cache_limit,
+    iree_hal_allocator_t** out_allocator);
+
+// Returns the device |allocator| was created for. Unretained.
+iree_hal_device_t* iree_hal_cuda_allocator_device(
+    iree_hal_allocator_t* allocator);
 
 #ifdef __cplusplus
 }  // extern "C"
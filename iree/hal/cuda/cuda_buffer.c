@@ -12,6 +12,8 @@
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/cuda/cuda_allocator.h"
+#include "iree/hal/utils/buffer_transfer.h"
 
 typedef struct iree_hal_cuda_buffer_t {
   iree_hal_buffer_t base;
@@ -71,10 +73,16 @@ static iree_status_t iree_hal_cuda_buffer_map_range(
     iree_hal_buffer_mapping_t* mapping) {
   iree_hal_cuda_buffer_t* buffer = iree_hal_cuda_buffer_cast(base_buffer);
 
-  // TODO(benvanik): add upload/download for unmapped buffers.
-  IREE_RETURN_IF_ERROR(iree_hal_buffer_validate_memory_type(
-      iree_hal_buffer_memory_type(base_buffer),
-      IREE_HAL_MEMORY_TYPE_HOST_VISIBLE));
+  // Device-only memory is mapped by staging a copy of the range in host memory
+  // that is transferred to and from the device.
+  if (!iree_all_bits_set(iree_hal_buffer_memory_type(base_buffer),
+                         IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    return iree_hal_buffer_emulated_map_range(
+        iree_hal_cuda_allocator_device(base_buffer->device_allocator),
+        base_buffer, mapping_mode, memory_access, local_byte_offset,
+        local_byte_length, mapping);
+  }
+
   IREE_RETURN_IF_ERROR(
       iree_hal_buffer_validate_usage(iree_hal_buffer_allowed_usage(base_buffer),
                                      IREE_HAL_BUFFER_USAGE_MAPPING));
@@ -97,6 +105,12 @@ static iree_status_t iree_hal_cuda_buffer_map_range(
 static iree_status_t iree_hal_cuda_buffer_unmap_range(
     iree_hal_buffer_t* base_buffer, iree_device_size_t local_byte_offset,
     iree_device_size_t local_byte_length, iree_hal_buffer_mapping_t* mapping) {
+  if (!iree_all_bits_set(iree_hal_buffer_memory_type(base_buffer),
+                         IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    return iree_hal_buffer_emulated_unmap_range(
+        iree_hal_cuda_allocator_device(base_buffer->device_allocator),
+        base_buffer, local_byte_offset, local_byte_length, mapping);
+  }
   // Nothing to do (today).
   return iree_ok_status();
 }
@@ -11,6 +11,9 @@
 #include <string.h>
 
 #include "iree/base/internal/arena.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/math.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/cuda_allocator.h"
@@ -20,12 +23,135 @@
 #include "iree/hal/cuda/event_semaphore.h"
 #include "iree/hal/cuda/executable_layout.h"
 #include "iree/hal/cuda/graph_command_buffer.h"
+#include "iree/hal/cuda/library_calls.h"
 #include "iree/hal/cuda/nop_executable_cache.h"
 #include "iree/hal/cuda/status_util.h"
 #include "iree/hal/cuda/stream_command_buffer.h"
 #include "iree/hal/utils/buffer_transfer.h"
 #include "iree/hal/utils/deferred_command_buffer.h"
 
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_deferred_submission_t
+//===----------------------------------------------------------------------===//
+
+// A submission batch that could not be issued to the stream at the time it
+// was submitted as one or more of its waits had no device signal enqueued yet.
+// Retains all semaphores and command buffers referenced by the batch.
+typedef struct iree_hal_cuda_deferred_submission_t {
+  struct iree_hal_cuda_deferred_submission_t* next;
+  // Copy of the batch with lists pointing into the trailing storage.
+  iree_hal_submission_batch_t batch;
+  // Status of the submission once it has been retired from the queue. If not
+  // OK the signal semaphores are failed with it.
+  iree_status_t status;
+} iree_hal_cuda_deferred_submission_t;
+
+static iree_status_t iree_hal_cuda_deferred_submission_create(
+    const iree_hal_submission_batch_t* batch, iree_allocator_t host_allocator,
+    iree_hal_cuda_deferred_submission_t** out_submission) {
+  *out_submission = NULL;
+  const iree_hal_semaphore_list_t* wait_list = &batch->wait_semaphores;
+  const iree_hal_semaphore_list_t* signal_list = &batch->signal_semaphores;
+  const iree_host_size_t value_count = wait_list->count + signal_list->count;
+  const iree_host_size_t pointer_count =
+      value_count + batch->command_buffer_count;
+
+  iree_hal_cuda_deferred_submission_t* submission = NULL;
+  iree_host_size_t total_size = iree_sizeof_struct(*submission) +
+                                value_count * sizeof(uint64_t) +
+                                pointer_count * sizeof(void*);
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(host_allocator, total_size, (void**)&submission));
+  submission->next = NULL;
+  submission->status = iree_ok_status();
+
+  // Values first to keep them 8-byte aligned followed by the pointers.
+  uint8_t* storage = (uint8_t*)submission + iree_sizeof_struct(*submission);
+  uint64_t* wait_values = (uint64_t*)storage;
+  uint64_t* signal_values = wait_values + wait_list->count;
+  iree_hal_semaphore_t** wait_semaphores =
+      (iree_hal_semaphore_t**)(signal_values + signal_list->count);
+  iree_hal_semaphore_t** signal_semaphores =
+      wait_semaphores + wait_list->count;
+  iree_hal_command_buffer_t** command_buffers =
+      (iree_hal_command_buffer_t**)(signal_semaphores + signal_list->count);
+
+  for (iree_host_size_t i = 0; i < wait_list->count; ++i) {
+    wait_semaphores[i] = wait_list->semaphores[i];
+    wait_values[i] = wait_list->payload_values[i];
+    iree_hal_semaphore_retain(wait_semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < signal_list->count; ++i) {
+    signal_semaphores[i] = signal_list->semaphores[i];
+    signal_values[i] = signal_list->payload_values[i];
+    iree_hal_semaphore_retain(signal_semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < batch->command_buffer_count; ++i) {
+    command_buffers[i] = batch->command_buffers[i];
+    iree_hal_command_buffer_retain(command_buffers[i]);
+  }
+
+  submission->batch.wait_semaphores.count = wait_list->count;
+  submission->batch.wait_semaphores.semaphores = wait_semaphores;
+  submission->batch.wait_semaphores.payload_values = wait_values;
+  submission->batch.command_buffer_count = batch->command_buffer_count;
+  submission->batch.command_buffers = command_buffers;
+  submission->batch.signal_semaphores.count = signal_list->count;
+  submission->batch.signal_semaphores.semaphores = signal_semaphores;
+  submission->batch.signal_semaphores.payload_values = signal_values;
+
+  *out_submission = submission;
+  return iree_ok_status();
+}
+
+// Fails the signal semaphores of |submission| if it did not complete
+// successfully and releases all of its resources.
+static void iree_hal_cuda_deferred_submission_retire(
+    iree_hal_cuda_deferred_submission_t* submission,
+    iree_allocator_t host_allocator) {
+  const iree_hal_submission_batch_t* batch = &submission->batch;
+  if (!iree_status_is_ok(submission->status)) {
+    for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+      iree_hal_semaphore_fail(batch->signal_semaphores.semaphores[i],
+                              iree_status_clone(submission->status));
+    }
+    iree_status_free(submission->status);
+  }
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    iree_hal_semaphore_release(batch->wait_semaphores.semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+    iree_hal_semaphore_release(batch->signal_semaphores.semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < batch->command_buffer_count; ++i) {
+    iree_hal_command_buffer_release(batch->command_buffers[i]);
+  }
+  iree_allocator_free(host_allocator, submission);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_queue_t
+//===----------------------------------------------------------------------===//
+
+// A CUDA stream and the state used to issue submissions to it.
+// Work on different queues executes concurrently unless ordered by semaphores.
+typedef struct iree_hal_cuda_queue_t {
+  CUstream stream;
+
+  // Cache of the direct stream command buffer initialized when in stream mode.
+  iree_hal_command_buffer_t* stream_command_buffer;
+
+  // Guards issuing work to |stream| and the deferred submission queue.
+  // Must be acquired before any semaphore mutex.
+  iree_slim_mutex_t submission_mutex;
+
+  // FIFO of submissions waiting on semaphores that have neither been reached
+  // nor had a device signal enqueued. Submissions are issued in order as host
+  // signals make their waits ready.
+  iree_hal_cuda_deferred_submission_t* deferred_head;
+  iree_hal_cuda_deferred_submission_t* deferred_tail;
+} iree_hal_cuda_queue_t;
+
 //===----------------------------------------------------------------------===//
 // iree_hal_cuda_device_t
 //===----------------------------------------------------------------------===//
@@ -47,14 +173,36 @@ typedef struct iree_hal_cuda_device_t {
 
   CUdevice device;
 
-  // TODO: support multiple streams.
-  CUstream stream;
   iree_hal_cuda_context_wrapper_t context_wrapper;
   iree_hal_allocator_t* device_allocator;
 
-  // Cache of the direct stream command buffer initialized when in stream mode.
-  // TODO: have one cached per stream once there are multiple streams.
-  iree_hal_command_buffer_t* stream_command_buffer;
+  // Device properties used when loading executables. The JIT cache path is
+  // stored in the trailing allocation.
+  iree_hal_cuda_native_executable_options_t executable_options;
+
+  // State shared by all semaphores created from the device.
+  iree_hal_cuda_semaphore_state_t semaphore_state;
+
+  // Instantiated graphs reused by graph command buffers.
+  iree_hal_cuda_graph_exec_cache_t graph_exec_cache;
+
+  // Vendor library handles used by library call dispatches.
+  iree_hal_cuda_library_state_t library_state;
+
+  // Pinned staging memory for transfers to and from device-local buffers.
+  iree_hal_transfer_staging_ring_t staging_ring;
+
+  // Queues selected by queue affinity for general work.
+  // Stored in the trailing allocation along with |transfer_queue|.
+  iree_host_size_t queue_count;
+  iree_hal_cuda_queue_t* queues;
+
+  // Queue used for submissions containing only transfer commands so that they
+  // can overlap with dispatches, or NULL if transfers use |queues|.
+  iree_hal_cuda_queue_t* transfer_queue;
+
+  // Incremented by each submission to spread work across |queues|.
+  iree_atomic_int32_t queue_ordinal;
 } iree_hal_cuda_device_t;
 
 static const iree_hal_device_vtable_t iree_hal_cuda_device_vtable;
@@ -69,10 +217,18 @@ void iree_hal_cuda_device_params_initialize(
     iree_hal_cuda_device_params_t* out_params) {
   out_params->arena_block_size = 32 * 1024;
   out_params->queue_count = 8;
+  out_params->dedicated_transfer_queue = true;
   out_params->command_buffer_mode = IREE_HAL_CUDA_COMMAND_BUFFER_MODE_GRAPH;
   out_params->allow_inline_execution = false;
+  out_params->allocation_cache_limit = 256 * 1024 * 1024;
+  out_params->staging_ring_slot_size =
+      IREE_HAL_TRANSFER_STAGING_RING_DEFAULT_SLOT_SIZE;
+  out_params->jit_cache_path = iree_string_view_empty();
+  out_params->graph_exec_cache_capacity = 32;
 }
 
+static void iree_hal_cuda_device_flush_deferred_submissions(void* user_data);
+
 static iree_status_t iree_hal_cuda_device_check_params(
     const iree_hal_cuda_device_params_t* params) {
   if (params->arena_block_size < 4096) {
@@ -83,45 +239,144 @@ static iree_status_t iree_hal_cuda_device_check_params(
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "at least one queue is required");
   }
+  if (params->queue_count > 64) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "at most 64 queues can be addressed by affinity");
+  }
   return iree_ok_status();
 }
 
+static iree_status_t iree_hal_cuda_queue_initialize(
+    iree_hal_cuda_device_t* device, iree_hal_cuda_queue_t* queue) {
+  IREE_RETURN_IF_ERROR(CU_RESULT_TO_STATUS(
+      device->context_wrapper.syms,
+      cuStreamCreate(&queue->stream, CU_STREAM_NON_BLOCKING),
+      "cuStreamCreate"));
+  if (device->params.command_buffer_mode ==
+      IREE_HAL_CUDA_COMMAND_BUFFER_MODE_STREAM) {
+    IREE_RETURN_IF_ERROR(iree_hal_cuda_stream_command_buffer_create(
+        (iree_hal_device_t*)device, &device->context_wrapper,
+        IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
+        IREE_HAL_COMMAND_CATEGORY_ANY, queue->stream, /*block_pool=*/NULL,
+        &queue->stream_command_buffer));
+  }
+  return iree_ok_status();
+}
+
+static void iree_hal_cuda_queue_deinitialize(iree_hal_cuda_device_t* device,
+                                             iree_hal_cuda_queue_t* queue) {
+  // Drop any submissions still waiting on semaphores that were never
+  // signaled; their work was never issued.
+  iree_hal_cuda_deferred_submission_t* submission = queue->deferred_head;
+  while (submission) {
+    iree_hal_cuda_deferred_submission_t* next = submission->next;
+    iree_hal_cuda_deferred_submission_retire(
+        submission, device->context_wrapper.host_allocator);
+    submission = next;
+  }
+  queue->deferred_head = queue->deferred_tail = NULL;
+
+  iree_hal_command_buffer_release(queue->stream_command_buffer);
+  if (queue->stream) {
+    CUDA_IGNORE_ERROR(device->context_wrapper.syms,
+                      cuStreamDestroy(queue->stream));
+  }
+  iree_slim_mutex_deinitialize(&queue->submission_mutex);
+}
+
 static iree_status_t iree_hal_cuda_device_create_internal(
     iree_hal_driver_t* driver, iree_string_view_t identifier,
     const iree_hal_cuda_device_params_t* params, CUdevice cu_device,
-    CUstream stream, CUcontext context, iree_hal_cuda_dynamic_symbols_t* syms,
+    CUcontext context, iree_hal_cuda_dynamic_symbols_t* syms,
     iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
   iree_hal_cuda_device_t* device = NULL;
-  iree_host_size_t total_size = iree_sizeof_struct(*device) + identifier.size;
+  iree_host_size_t total_queue_count =
+      params->queue_count + (params->dedicated_transfer_queue ? 1 : 0);
+  iree_host_size_t total_size = iree_sizeof_struct(*device) +
+                                total_queue_count * sizeof(*device->queues) +
+                                identifier.size + params->jit_cache_path.size;
   IREE_RETURN_IF_ERROR(
       iree_allocator_malloc(host_allocator, total_size, (void**)&device));
   memset(device, 0, total_size);
   iree_hal_resource_initialize(&iree_hal_cuda_device_vtable, &device->resource);
   device->driver = driver;
   iree_hal_driver_retain(device->driver);
-  iree_string_view_append_to_buffer(
-      identifier, &device->identifier,
-      (char*)device + iree_sizeof_struct(*device));
+  uint8_t* buffer_ptr = (uint8_t*)device + iree_sizeof_struct(*device);
+  device->queue_count = params->queue_count;
+  device->queues = (iree_hal_cuda_queue_t*)buffer_ptr;
+  if (params->dedicated_transfer_queue) {
+    device->transfer_queue = &device->queues[params->queue_count];
+  }
+  buffer_ptr += total_queue_count * sizeof(*device->queues);
+  buffer_ptr += iree_string_view_append_to_buffer(
+      identifier, &device->identifier, (char*)buffer_ptr);
   device->params = *params;
+  iree_string_view_append_to_buffer(params->jit_cache_path,
+                                    &device->params.jit_cache_path,
+                                    (char*)buffer_ptr);
+  device->executable_options.jit_cache_path = device->params.jit_cache_path;
   device->device = cu_device;
-  device->stream = stream;
   device->context_wrapper.cu_context = context;
   device->context_wrapper.host_allocator = host_allocator;
   iree_arena_block_pool_initialize(params->arena_block_size, host_allocator,
                                    &device->block_pool);
   device->context_wrapper.syms = syms;
+  iree_hal_cuda_library_state_initialize(&device->library_state);
+  device->context_wrapper.library_state = &device->library_state;
+  iree_hal_cuda_semaphore_callback_t host_signal_callback = {
+      .fn = iree_hal_cuda_device_flush_deferred_submissions,
+      .user_data = device,
+  };
+  iree_hal_cuda_semaphore_state_initialize(host_signal_callback,
+                                           &device->semaphore_state);
+  iree_hal_cuda_graph_exec_cache_initialize(&device->context_wrapper,
+                                            params->graph_exec_cache_capacity,
+                                            &device->graph_exec_cache);
+  iree_hal_transfer_staging_ring_initialize((iree_hal_device_t*)device,
+                                            params->staging_ring_slot_size,
+                                            &device->staging_ring);
+  for (iree_host_size_t i = 0; i < total_queue_count; ++i) {
+    iree_slim_mutex_initialize(&device->queues[i].submission_mutex);
+  }
 
-  iree_status_t status = iree_hal_cuda_allocator_create(
-      (iree_hal_device_t*)device, &device->context_wrapper, cu_device, stream,
-      &device->device_allocator);
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < total_queue_count; ++i) {
+    status = iree_hal_cuda_queue_initialize(device, &device->queues[i]);
+    if (!iree_status_is_ok(status)) break;
+  }
 
-  if (iree_status_is_ok(status) &&
-      params->command_buffer_mode == IREE_HAL_CUDA_COMMAND_BUFFER_MODE_STREAM) {
-    status = iree_hal_cuda_stream_command_buffer_create(
-        (iree_hal_device_t*)device, &device->context_wrapper,
-        IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
-        IREE_HAL_COMMAND_CATEGORY_ANY, device->stream, /*block_pool=*/NULL,
-        &device->stream_command_buffer);
+  // Executables embed cubins for specific architectures and JIT compile their
+  // PTX for all others; the JIT cache is keyed by the architecture and driver.
+  int sm_major = 0;
+  int sm_minor = 0;
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        syms,
+        cuDeviceGetAttribute(&sm_major,
+                             CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR,
+                             cu_device),
+        "cuDeviceGetAttribute");
+  }
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        syms,
+        cuDeviceGetAttribute(&sm_minor,
+                             CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR,
+                             cu_device),
+        "cuDeviceGetAttribute");
+  }
+  if (iree_status_is_ok(status)) {
+    device->executable_options.sm_version = sm_major * 10 + sm_minor;
+    status = CU_RESULT_TO_STATUS(
+        syms, cuDriverGetVersion(&device->executable_options.driver_version),
+        "cuDriverGetVersion");
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_allocator_create(
+        (iree_hal_device_t*)device, &device->context_wrapper, cu_device,
+        device->queues[0].stream, params->allocation_cache_limit,
+        &device->device_allocator);
   }
 
   if (iree_status_is_ok(status)) {
@@ -144,37 +399,43 @@ iree_status_t iree_hal_cuda_device_create(
   CUcontext context;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, CU_RESULT_TO_STATUS(syms, cuCtxCreate(&context, 0, device)));
-  CUstream stream;
-  iree_status_t status = CU_RESULT_TO_STATUS(
-      syms, cuStreamCreate(&stream, CU_STREAM_NON_BLOCKING));
 
-  if (iree_status_is_ok(status)) {
-    status = iree_hal_cuda_device_create_internal(driver, identifier, params,
-                                                  device, stream, context, syms,
-                                                  host_allocator, out_device);
-  }
+  iree_status_t status = iree_hal_cuda_device_create_internal(
+      driver, identifier, params, device, context, syms, host_allocator,
+      out_device);
   if (!iree_status_is_ok(status)) {
-    if (stream) {
-      syms->cuStreamDestroy(stream);
-    }
     syms->cuCtxDestroy(context);
   }
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
 
+static iree_host_size_t iree_hal_cuda_device_total_queue_count(
+    iree_hal_cuda_device_t* device) {
+  return device->queue_count + (device->transfer_queue ? 1 : 0);
+}
+
 static void iree_hal_cuda_device_destroy(iree_hal_device_t* base_device) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // The staging ring holds a buffer from the allocator.
+  iree_hal_transfer_staging_ring_deinitialize(&device->staging_ring);
+
   // There should be no more buffers live that use the allocator.
-  iree_hal_command_buffer_release(device->stream_command_buffer);
+  const iree_host_size_t total_queue_count =
+      iree_hal_cuda_device_total_queue_count(device);
+  for (iree_host_size_t i = 0; i < total_queue_count; ++i) {
+    iree_hal_cuda_queue_deinitialize(device, &device->queues[i]);
+  }
   iree_hal_allocator_release(device->device_allocator);
-  CUDA_IGNORE_ERROR(device->context_wrapper.syms,
-                    cuStreamDestroy(device->stream));
+  iree_hal_cuda_graph_exec_cache_deinitialize(&device->graph_exec_cache);
+  iree_hal_cuda_library_state_deinitialize(&device->context_wrapper,
+                                           &device->library_state);
 
   iree_arena_block_pool_deinitialize(&device->block_pool);
+  iree_hal_cuda_semaphore_state_deinitialize(&device->semaphore_state);
 
   // Finally, destroy the device.
   iree_hal_driver_release(device->driver);
@@ -205,6 +466,7 @@ static iree_hal_allocator_t* iree_hal_cuda_device_allocator(
 static iree_status_t iree_hal_cuda_device_trim(iree_hal_device_t* base_device) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
   iree_arena_block_pool_trim(&device->block_pool);
+  iree_hal_transfer_staging_ring_trim(&device->staging_ring);
   return iree_hal_allocator_trim(device->device_allocator);
 }
 
@@ -229,6 +491,67 @@ static iree_status_t iree_hal_cuda_device_query_i32(
       (int)category.size, category.data, (int)key.size, key.data);
 }
 
+// Returns a bitmask of the queues in a list of |queue_count| queues that
+// |queue_affinity| allows. Each bit in the affinity selects the queue at that
+// index modulo the queue count so that any affinity selects at least one queue.
+static uint64_t iree_hal_cuda_device_queue_affinity_mask(
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t queue_count) {
+  uint64_t queue_mask = queue_affinity;
+  if (queue_count < 64) {
+    queue_mask = 0;
+    for (iree_host_size_t i = 0; i < 64; ++i) {
+      if (queue_affinity & (1ull << i)) queue_mask |= 1ull << (i % queue_count);
+    }
+  }
+  if (!queue_mask) {
+    // An empty affinity places no constraints on the queue.
+    queue_mask = queue_count >= 64 ? UINT64_MAX : (1ull << queue_count) - 1;
+  }
+  return queue_mask;
+}
+
+// Returns the queue to issue work to based on the |queue_affinity|.
+// Work that only contains transfer commands goes to the dedicated transfer
+// queue, if any, and everything else goes to the general queues. If the
+// affinity allows more than one queue we spread submissions across them
+// round-robin; the HAL only orders work across submissions with semaphores so
+// this is safe and lets independent submissions (and sessions sharing the
+// device) execute concurrently.
+static iree_hal_cuda_queue_t* iree_hal_cuda_device_select_queue(
+    iree_hal_cuda_device_t* device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity) {
+  if (device->transfer_queue &&
+      command_categories == IREE_HAL_COMMAND_CATEGORY_TRANSFER) {
+    return device->transfer_queue;
+  }
+  uint64_t queue_mask = iree_hal_cuda_device_queue_affinity_mask(
+      queue_affinity, device->queue_count);
+  if (iree_math_count_ones_u64(queue_mask) == 1) {
+    return &device->queues[iree_math_count_trailing_zeros_u64(queue_mask)];
+  }
+  uint32_t ordinal = (uint32_t)iree_atomic_fetch_add_int32(
+      &device->queue_ordinal, 1, iree_memory_order_relaxed);
+  for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
+    iree_host_size_t queue_index = (ordinal + i) % device->queue_count;
+    if (queue_mask & (1ull << queue_index)) {
+      return &device->queues[queue_index];
+    }
+  }
+  return &device->queues[0];  // unreachable; the mask always has a bit set
+}
+
+// Returns the queue that owns |stream|.
+static iree_hal_cuda_queue_t* iree_hal_cuda_device_lookup_queue(
+    iree_hal_cuda_device_t* device, CUstream stream) {
+  const iree_host_size_t total_queue_count =
+      iree_hal_cuda_device_total_queue_count(device);
+  for (iree_host_size_t i = 0; i < total_queue_count; ++i) {
+    if (device->queues[i].stream == stream) return &device->queues[i];
+  }
+  return NULL;
+}
+
 static iree_status_t iree_hal_cuda_device_create_command_buffer(
     iree_hal_device_t* base_device, iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
@@ -242,15 +565,20 @@ static iree_status_t iree_hal_cuda_device_create_command_buffer(
     // recorded, implying that the command buffer cannot be reused and doesn't
     // need to be persisted. This lets us lower the execution delay as we can
     // directly route commands to a CUDA stream and let it eagerly flush.
+    // The command buffer must be submitted to the same queue as it executes
+    // on; queue_submit routes it there regardless of the submit affinity.
+    iree_hal_cuda_queue_t* queue = iree_hal_cuda_device_select_queue(
+        device, command_categories, queue_affinity);
     return iree_hal_cuda_stream_command_buffer_create(
         base_device, &device->context_wrapper, mode, command_categories,
-        device->stream, &device->block_pool, out_command_buffer);
+        queue->stream, &device->block_pool, out_command_buffer);
   }
   switch (device->params.command_buffer_mode) {
     case IREE_HAL_CUDA_COMMAND_BUFFER_MODE_GRAPH:
       return iree_hal_cuda_graph_command_buffer_create(
-          base_device, &device->context_wrapper, mode, command_categories,
-          queue_affinity, &device->block_pool, out_command_buffer);
+          base_device, &device->context_wrapper, &device->graph_exec_cache,
+          mode, command_categories, queue_affinity, &device->block_pool,
+          out_command_buffer);
     case IREE_HAL_CUDA_COMMAND_BUFFER_MODE_STREAM:
       return iree_hal_deferred_command_buffer_create(
           base_device, mode, command_categories, &device->block_pool,
@@ -294,7 +622,8 @@ static iree_status_t iree_hal_cuda_device_create_executable_cache(
     iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
   return iree_hal_cuda_nop_executable_cache_create(
-      &device->context_wrapper, identifier, out_executable_cache);
+      &device->context_wrapper, &device->executable_options, identifier,
+      out_executable_cache);
 }
 
 static iree_status_t iree_hal_cuda_device_create_executable_layout(
@@ -312,8 +641,147 @@ static iree_status_t iree_hal_cuda_device_create_semaphore(
     iree_hal_device_t* base_device, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
-  return iree_hal_cuda_semaphore_create(&device->context_wrapper, initial_value,
-                                        out_semaphore);
+  return iree_hal_cuda_semaphore_create(
+      &device->context_wrapper, &device->semaphore_state, initial_value,
+      out_semaphore);
+}
+
+static iree_status_t iree_hal_cuda_device_transfer_range(
+    iree_hal_device_t* base_device, iree_hal_transfer_buffer_t source,
+    iree_device_size_t source_offset, iree_hal_transfer_buffer_t target,
+    iree_device_size_t target_offset, iree_device_size_t data_length,
+    iree_hal_transfer_buffer_flags_t flags, iree_timeout_t timeout) {
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  return iree_hal_device_transfer_staged_range(
+      base_device, &device->staging_ring, source, source_offset, target,
+      target_offset, data_length, flags, timeout);
+}
+
+// Returns true in |out_is_ready| if all waits of |batch| can be enqueued on
+// the stream. Returns IREE_STATUS_ABORTED if any wait semaphore has failed.
+static iree_status_t iree_hal_cuda_device_is_batch_ready(
+    const iree_hal_submission_batch_t* batch, bool* out_is_ready) {
+  *out_is_ready = true;
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    bool is_ready = false;
+    IREE_RETURN_IF_ERROR(iree_hal_cuda_semaphore_is_wait_ready(
+        batch->wait_semaphores.semaphores[i],
+        batch->wait_semaphores.payload_values[i], &is_ready));
+    if (!is_ready) {
+      *out_is_ready = false;
+      break;
+    }
+  }
+  return iree_ok_status();
+}
+
+// Enqueues the waits, command buffers, and signals of |batch| on the stream of
+// |queue|. The batch must be ready as reported by
+// iree_hal_cuda_device_is_batch_ready and the queue submission mutex must be
+// held.
+static iree_status_t iree_hal_cuda_device_issue_batch(
+    iree_hal_cuda_device_t* device, iree_hal_cuda_queue_t* queue,
+    const iree_hal_submission_batch_t* batch) {
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_cuda_semaphore_enqueue_wait(
+        batch->wait_semaphores.semaphores[i], queue->stream,
+        batch->wait_semaphores.payload_values[i]));
+  }
+  for (iree_host_size_t i = 0; i < batch->command_buffer_count; ++i) {
+    iree_hal_command_buffer_t* command_buffer = batch->command_buffers[i];
+    if (iree_hal_cuda_stream_command_buffer_isa(command_buffer)) {
+      // Nothing to do for an inline command buffer; all the work has already
+      // been submitted. We still signal its completion below but do not have
+      // to worry about any waits: if there were waits we wouldn't have been
+      // able to execute inline!
+    } else if (iree_hal_cuda_graph_command_buffer_isa(command_buffer)) {
+      CUgraphExec exec =
+          iree_hal_cuda_graph_command_buffer_exec(command_buffer);
+      CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
+                           cuGraphLaunch(exec, queue->stream),
+                           "cuGraphLaunch");
+    } else {
+      IREE_RETURN_IF_ERROR(iree_hal_deferred_command_buffer_apply(
+          command_buffer, queue->stream_command_buffer));
+    }
+  }
+  for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_cuda_semaphore_enqueue_signal(
+        batch->signal_semaphores.semaphores[i], queue->stream,
+        batch->signal_semaphores.payload_values[i]));
+  }
+  return iree_ok_status();
+}
+
+// Issues the deferred submissions of |queue| in order until one is found that
+// is not yet ready.
+static void iree_hal_cuda_queue_flush_deferred_submissions(
+    iree_hal_cuda_device_t* device, iree_hal_cuda_queue_t* queue) {
+  // Submissions are popped under the lock but retired outside of it as
+  // failing signal semaphores calls back into the device.
+  iree_hal_cuda_deferred_submission_t* retired_head = NULL;
+  iree_hal_cuda_deferred_submission_t* retired_tail = NULL;
+  iree_slim_mutex_lock(&queue->submission_mutex);
+  while (queue->deferred_head) {
+    iree_hal_cuda_deferred_submission_t* submission = queue->deferred_head;
+    bool is_ready = false;
+    submission->status =
+        iree_hal_cuda_device_is_batch_ready(&submission->batch, &is_ready);
+    if (iree_status_is_ok(submission->status)) {
+      if (!is_ready) break;
+      submission->status =
+          iree_hal_cuda_device_issue_batch(device, queue, &submission->batch);
+    }
+    queue->deferred_head = submission->next;
+    if (!queue->deferred_head) queue->deferred_tail = NULL;
+    submission->next = NULL;
+    if (retired_tail) {
+      retired_tail->next = submission;
+    } else {
+      retired_head = submission;
+    }
+    retired_tail = submission;
+  }
+  iree_slim_mutex_unlock(&queue->submission_mutex);
+
+  while (retired_head) {
+    iree_hal_cuda_deferred_submission_t* next = retired_head->next;
+    iree_hal_cuda_deferred_submission_retire(
+        retired_head, device->context_wrapper.host_allocator);
+    retired_head = next;
+  }
+}
+
+// Issues ready deferred submissions on all queues. Called by semaphores after
+// they are signaled or failed from the host.
+static void iree_hal_cuda_device_flush_deferred_submissions(void* user_data) {
+  iree_hal_cuda_device_t* device = (iree_hal_cuda_device_t*)user_data;
+  const iree_host_size_t total_queue_count =
+      iree_hal_cuda_device_total_queue_count(device);
+  for (iree_host_size_t i = 0; i < total_queue_count; ++i) {
+    iree_hal_cuda_queue_flush_deferred_submissions(device, &device->queues[i]);
+  }
+}
+
+// Returns the queue a submission of |batches| must be issued to. Batches
+// containing inline command buffers must go to the queue whose stream the
+// commands were already issued against.
+static iree_hal_cuda_queue_t* iree_hal_cuda_device_select_submit_queue(
+    iree_hal_cuda_device_t* device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches) {
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    for (iree_host_size_t j = 0; j < batches[i].command_buffer_count; ++j) {
+      iree_hal_command_buffer_t* command_buffer = batches[i].command_buffers[j];
+      if (!iree_hal_cuda_stream_command_buffer_isa(command_buffer)) continue;
+      iree_hal_cuda_queue_t* queue = iree_hal_cuda_device_lookup_queue(
+          device, iree_hal_cuda_stream_command_buffer_stream(command_buffer));
+      if (queue) return queue;
+    }
+  }
+  return iree_hal_cuda_device_select_queue(device, command_categories,
+                                           queue_affinity);
 }
 
 static iree_status_t iree_hal_cuda_device_queue_submit(
@@ -322,32 +790,45 @@ static iree_status_t iree_hal_cuda_device_queue_submit(
     iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
     const iree_hal_submission_batch_t* batches) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
-  for (int i = 0; i < batch_count; i++) {
-    for (int j = 0; j < batches[i].command_buffer_count; j++) {
-      iree_hal_command_buffer_t* command_buffer = batches[i].command_buffers[j];
-      if (iree_hal_cuda_stream_command_buffer_isa(command_buffer)) {
-        // Nothing to do for an inline command buffer; all the work has already
-        // been submitted. When we support semaphores we'll still need to signal
-        // their completion but do not have to worry about any waits: if there
-        // were waits we wouldn't have been able to execute inline!
-      } else if (iree_hal_cuda_graph_command_buffer_isa(command_buffer)) {
-        CUgraphExec exec = iree_hal_cuda_graph_command_buffer_exec(
-            batches[i].command_buffers[j]);
-        CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
-                             cuGraphLaunch(exec, device->stream),
-                             "cuGraphLaunch");
+  iree_allocator_t host_allocator = device->context_wrapper.host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_cuda_queue_t* queue = iree_hal_cuda_device_select_submit_queue(
+      device, command_categories, queue_affinity, batch_count, batches);
+
+  // Batches are issued directly to the stream when all of their waits have
+  // device signals enqueued (or are already reached). Otherwise they are
+  // deferred until host signals make them ready; any batches submitted after
+  // must be deferred as well to preserve submission order.
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&queue->submission_mutex);
+  for (iree_host_size_t i = 0; i < batch_count && iree_status_is_ok(status);
+       ++i) {
+    bool is_ready = false;
+    if (!queue->deferred_head) {
+      status = iree_hal_cuda_device_is_batch_ready(&batches[i], &is_ready);
+    }
+    if (!iree_status_is_ok(status)) break;
+    if (is_ready) {
+      status = iree_hal_cuda_device_issue_batch(device, queue, &batches[i]);
+      continue;
+    }
+    iree_hal_cuda_deferred_submission_t* submission = NULL;
+    status = iree_hal_cuda_deferred_submission_create(
+        &batches[i], host_allocator, &submission);
+    if (iree_status_is_ok(status)) {
+      if (queue->deferred_tail) {
+        queue->deferred_tail->next = submission;
       } else {
-        IREE_RETURN_IF_ERROR(iree_hal_deferred_command_buffer_apply(
-            batches[i].command_buffers[j], device->stream_command_buffer));
+        queue->deferred_head = submission;
       }
+      queue->deferred_tail = submission;
     }
   }
-  // TODO(thomasraoux): implement semaphores - for now this conservatively
-  // synchronizes after every submit.
-  CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
-                       cuStreamSynchronize(device->stream),
-                       "cuStreamSynchronize");
-  return iree_ok_status();
+  iree_slim_mutex_unlock(&queue->submission_mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 static iree_status_t iree_hal_cuda_device_submit_and_wait(
@@ -368,19 +849,24 @@ static iree_status_t iree_hal_cuda_device_submit_and_wait(
 static iree_status_t iree_hal_cuda_device_wait_semaphores(
     iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "semaphore not implemented");
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  return iree_hal_cuda_semaphore_multi_wait(&device->semaphore_state,
+                                            wait_mode, semaphore_list, timeout);
 }
 
 static iree_status_t iree_hal_cuda_device_wait_idle(
     iree_hal_device_t* base_device, iree_timeout_t timeout) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
-  // Wait until the stream is done.
+  // Wait until all streams are done.
   // TODO(thomasraoux): CUDA doesn't support a deadline for wait, figure out how
   // to handle it better.
-  CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
-                       cuStreamSynchronize(device->stream),
-                       "cuStreamSynchronize");
+  const iree_host_size_t total_queue_count =
+      iree_hal_cuda_device_total_queue_count(device);
+  for (iree_host_size_t i = 0; i < total_queue_count; ++i) {
+    CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
+                         cuStreamSynchronize(device->queues[i].stream),
+                         "cuStreamSynchronize");
+  }
   return iree_ok_status();
 }
 
@@ -399,7 +885,7 @@ static const iree_hal_device_vtable_t iree_hal_cuda_device_vtable = {
     .create_executable_cache = iree_hal_cuda_device_create_executable_cache,
     .create_executable_layout = iree_hal_cuda_device_create_executable_layout,
     .create_semaphore = iree_hal_cuda_device_create_semaphore,
-    .transfer_range = iree_hal_device_submit_transfer_range_and_wait,
+    .transfer_range = iree_hal_cuda_device_transfer_range,
     .queue_submit = iree_hal_cuda_device_queue_submit,
     .submit_and_wait = iree_hal_cuda_device_submit_and_wait,
     .wait_semaphores = iree_hal_cuda_device_wait_semaphores,
@@ -10,6 +10,12 @@ CU_PFN_DECL(cuDeviceGet, CUdevice*, int)
 CU_PFN_DECL(cuDeviceGetCount, int*)
 CU_PFN_DECL(cuDeviceGetName, char*, int, CUdevice)
 CU_PFN_DECL(cuDeviceGetAttribute, int *, CUdevice_attribute, CUdevice)
+CU_PFN_DECL(cuDriverGetVersion, int*)
+CU_PFN_DECL(cuEventCreate, CUevent*, unsigned int)
+CU_PFN_DECL(cuEventDestroy, CUevent)
+CU_PFN_DECL(cuEventQuery, CUevent)
+CU_PFN_DECL(cuEventRecord, CUevent, CUstream)
+CU_PFN_DECL(cuEventSynchronize, CUevent)
 CU_PFN_DECL(cuGetErrorName, CUresult, const char**)
 CU_PFN_DECL(cuGetErrorString, CUresult, const char**)
 CU_PFN_DECL(cuGraphAddMemcpyNode, CUgraphNode*, CUgraph, const CUgraphNode*,
@@ -18,14 +24,34 @@ CU_PFN_DECL(cuGraphAddMemsetNode, CUgraphNode*, CUgraph, const CUgraphNode*,
             size_t, const CUDA_MEMSET_NODE_PARAMS*, CUcontext)
 CU_PFN_DECL(cuGraphAddKernelNode, CUgraphNode*, CUgraph, const CUgraphNode*,
             size_t, const CUDA_KERNEL_NODE_PARAMS*)
+CU_PFN_DECL(cuGraphAddChildGraphNode, CUgraphNode*, CUgraph, const CUgraphNode*,
+            size_t, CUgraph)
+CU_PFN_DECL(cuGraphChildGraphNodeGetGraph, CUgraphNode, CUgraph*)
 CU_PFN_DECL(cuGraphCreate, CUgraph*, unsigned int)
 CU_PFN_DECL(cuGraphDestroy, CUgraph)
 CU_PFN_DECL(cuGraphExecDestroy, CUgraphExec)
+CU_PFN_DECL(cuGraphExecChildGraphNodeSetParams, CUgraphExec, CUgraphNode,
+            CUgraph)
+CU_PFN_DECL(cuGraphExecKernelNodeSetParams, CUgraphExec, CUgraphNode,
+            const CUDA_KERNEL_NODE_PARAMS*)
+CU_PFN_DECL(cuGraphExecMemcpyNodeSetParams, CUgraphExec, CUgraphNode,
+            const CUDA_MEMCPY3D*, CUcontext)
+CU_PFN_DECL(cuGraphExecMemsetNodeSetParams, CUgraphExec, CUgraphNode,
+            const CUDA_MEMSET_NODE_PARAMS*, CUcontext)
 CU_PFN_DECL(cuGraphGetNodes, CUgraph, CUgraphNode*, size_t*)
 CU_PFN_DECL(cuGraphInstantiate, CUgraphExec*, CUgraph, CUgraphNode*, char*,
             size_t)
 CU_PFN_DECL(cuGraphLaunch, CUgraphExec, CUstream)
+CU_PFN_DECL(cuGraphKernelNodeGetParams, CUgraphNode, CUDA_KERNEL_NODE_PARAMS*)
+CU_PFN_DECL(cuGraphMemcpyNodeGetParams, CUgraphNode, CUDA_MEMCPY3D*)
+CU_PFN_DECL(cuGraphMemsetNodeGetParams, CUgraphNode, CUDA_MEMSET_NODE_PARAMS*)
+CU_PFN_DECL(cuGraphNodeGetType, CUgraphNode, CUgraphNodeType*)
 CU_PFN_DECL(cuInit, unsigned int)
+CU_PFN_DECL(cuLinkAddData, CUlinkState, CUjitInputType, void*, size_t,
+            const char*, unsigned int, CUjit_option*, void**)
+CU_PFN_DECL(cuLinkComplete, CUlinkState, void**, size_t*)
+CU_PFN_DECL(cuLinkCreate, unsigned int, CUjit_option*, void**, CUlinkState*)
+CU_PFN_DECL(cuLinkDestroy, CUlinkState)
 CU_PFN_DECL(cuMemAllocManaged, CUdeviceptr*, size_t, unsigned int)
 CU_PFN_DECL(cuMemPrefetchAsync, CUdeviceptr, size_t, CUdevice, CUstream)
 CU_PFN_DECL(cuMemAlloc, CUdeviceptr*, size_t)
@@ -34,11 +60,14 @@ CU_PFN_DECL(cuMemFreeHost, void*)
 CU_PFN_DECL(cuMemHostAlloc, void**, size_t, unsigned int)
 CU_PFN_DECL(cuMemHostGetDevicePointer, CUdeviceptr*, void*, unsigned int)
 CU_PFN_DECL(cuModuleGetFunction, CUfunction*, CUmodule, const char*)
+CU_PFN_DECL(cuModuleLoadData, CUmodule*, const void*)
 CU_PFN_DECL(cuModuleLoadDataEx, CUmodule*, const void*, unsigned int,
             CUjit_option*, void**)
 CU_PFN_DECL(cuModuleUnload, CUmodule)
+CU_PFN_DECL(cuStreamBeginCapture, CUstream, CUstreamCaptureMode)
 CU_PFN_DECL(cuStreamCreate, CUstream*, unsigned int)
 CU_PFN_DECL(cuStreamDestroy, CUstream)
+CU_PFN_DECL(cuStreamEndCapture, CUstream, CUgraph*)
 CU_PFN_DECL(cuStreamSynchronize, CUstream)
 CU_PFN_DECL(cuStreamWaitEvent, CUstream, CUevent, unsigned int)
 CU_PFN_DECL(cuMemsetD32Async, unsigned long long, unsigned int, size_t,
@@ -20,6 +20,17 @@ static const char* kCUDALoaderSearchNames[] = {
 #endif
 };
 
+static const char* kCUBLASLoaderSearchNames[] = {
+#if defined(IREE_PLATFORM_WINDOWS)
+    "cublas64_12.dll",
+    "cublas64_11.dll",
+#else
+    "libcublas.so",
+    "libcublas.so.12",
+    "libcublas.so.11",
+#endif
+};
+
 #define concat(A, B) A B
 
 // Load CUDA entry points, prefer _v2 version if it exists.
@@ -40,6 +51,41 @@ static iree_status_t iree_hal_cuda_dynamic_symbols_resolve_all(
   return iree_ok_status();
 }
 
+// Loads cuBLAS entry points. All must be present for the library to be used.
+static iree_status_t iree_hal_cuda_dynamic_symbols_resolve_cublas(
+    iree_hal_cuda_dynamic_symbols_t* syms) {
+#define CUBLAS_PFN_DECL(cublasSymbolName, ...)                           \
+  {                                                                      \
+    static const char* kName = #cublasSymbolName;                        \
+    IREE_RETURN_IF_ERROR(iree_dynamic_library_lookup_symbol(             \
+        syms->cublas_library, kName, (void**)&syms->cublasSymbolName)); \
+  }
+#include "iree/hal/cuda/cublas_symbol_tables.h"  // IWYU pragma: keep
+#undef CUBLAS_PFN_DECL
+  return iree_ok_status();
+}
+
+// Loads the optional cuBLAS library. Failures leave the library unavailable.
+static void iree_hal_cuda_dynamic_symbols_load_cublas(
+    iree_allocator_t allocator, iree_hal_cuda_dynamic_symbols_t* syms) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_dynamic_library_load_from_files(
+      IREE_ARRAYSIZE(kCUBLASLoaderSearchNames), kCUBLASLoaderSearchNames,
+      IREE_DYNAMIC_LIBRARY_FLAG_NONE, allocator, &syms->cublas_library);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_dynamic_symbols_resolve_cublas(syms);
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(status);
+    iree_dynamic_library_release(syms->cublas_library);
+    syms->cublas_library = NULL;
+#define CUBLAS_PFN_DECL(cublasSymbolName, ...) syms->cublasSymbolName = NULL;
+#include "iree/hal/cuda/cublas_symbol_tables.h"  // IWYU pragma: keep
+#undef CUBLAS_PFN_DECL
+  }
+  IREE_TRACE_ZONE_END(z0);
+}
+
 iree_status_t iree_hal_cuda_dynamic_symbols_initialize(
     iree_allocator_t allocator, iree_hal_cuda_dynamic_symbols_t* out_syms) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -56,6 +102,9 @@ iree_status_t iree_hal_cuda_dynamic_symbols_initialize(
   if (iree_status_is_ok(status)) {
     status = iree_hal_cuda_dynamic_symbols_resolve_all(out_syms);
   }
+  if (iree_status_is_ok(status)) {
+    iree_hal_cuda_dynamic_symbols_load_cublas(allocator, out_syms);
+  }
   if (!iree_status_is_ok(status)) {
     iree_hal_cuda_dynamic_symbols_deinitialize(out_syms);
   }
@@ -66,6 +115,7 @@ iree_status_t iree_hal_cuda_dynamic_symbols_initialize(
 void iree_hal_cuda_dynamic_symbols_deinitialize(
     iree_hal_cuda_dynamic_symbols_t* syms) {
   IREE_TRACE_ZONE_BEGIN(z0);
+  iree_dynamic_library_release(syms->cublas_library);
   iree_dynamic_library_release(syms->loader_library);
   memset(syms, 0, sizeof(*syms));
   IREE_TRACE_ZONE_END(z0);
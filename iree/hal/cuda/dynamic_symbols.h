@@ -15,6 +15,10 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Opaque cuBLAS library handle. Matches cublasHandle_t without requiring the
+// cuBLAS headers.
+typedef struct cublasContext* iree_hal_cuda_cublas_handle_t;
+
 // DynamicSymbols allow loading dynamically a subset of CUDA driver API. It
 // loads all the function declared in `dynamic_symbol_tables.def` and fail if
 // any of the symbol is not available. The functions signatures are matching
@@ -26,9 +30,21 @@ typedef struct iree_hal_cuda_dynamic_symbols_t {
   CUresult (*cudaSymbolName)(__VA_ARGS__);
 #include "iree/hal/cuda/dynamic_symbol_tables.h"  // IWYU pragma: export
 #undef CU_PFN_DECL
+
+  // cuBLAS library used for library call dispatches, if available.
+  // When the library could not be loaded this is NULL and all of the cuBLAS
+  // function pointers are NULL; see iree_hal_cuda_dynamic_symbols_has_cublas.
+  iree_dynamic_library_t* cublas_library;
+
+#define CUBLAS_PFN_DECL(cublasSymbolName, ...) \
+  int (*cublasSymbolName)(__VA_ARGS__);
+#include "iree/hal/cuda/cublas_symbol_tables.h"  // IWYU pragma: export
+#undef CUBLAS_PFN_DECL
 } iree_hal_cuda_dynamic_symbols_t;
 
 // Initializes |out_syms| in-place with dynamically loaded CUDA symbols.
+// Optional vendor libraries such as cuBLAS are loaded if present and are
+// otherwise left unavailable without failing.
 // iree_hal_cuda_dynamic_symbols_deinitialize must be used to release the
 // library resources.
 iree_status_t iree_hal_cuda_dynamic_symbols_initialize(
@@ -40,6 +56,12 @@ iree_status_t iree_hal_cuda_dynamic_symbols_initialize(
 void iree_hal_cuda_dynamic_symbols_deinitialize(
     iree_hal_cuda_dynamic_symbols_t* syms);
 
+// Returns true if the cuBLAS symbols in |syms| were loaded.
+static inline bool iree_hal_cuda_dynamic_symbols_has_cublas(
+    const iree_hal_cuda_dynamic_symbols_t* syms) {
+  return syms->cublas_library != NULL;
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
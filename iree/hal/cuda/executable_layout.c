@@ -120,6 +120,23 @@ iree_host_size_t iree_hal_cuda_executable_layout_num_constants(
   return executable_layout->push_constant_count;
 }
 
+iree_host_size_t iree_hal_cuda_executable_layout_constant_offset(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_cuda_executable_layout_t* executable_layout =
+      iree_hal_cuda_executable_layout_cast(base_executable_layout);
+  return iree_hal_cuda_kernel_arg_binding_offset(
+      executable_layout->push_constant_base_index);
+}
+
+iree_host_size_t iree_hal_cuda_executable_layout_kernel_args_size(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_cuda_executable_layout_t* executable_layout =
+      iree_hal_cuda_executable_layout_cast(base_executable_layout);
+  return iree_hal_cuda_executable_layout_constant_offset(
+             base_executable_layout) +
+         executable_layout->push_constant_count * sizeof(uint32_t);
+}
+
 static const iree_hal_executable_layout_vtable_t
     iree_hal_cuda_executable_layout_vtable = {
         .destroy = iree_hal_cuda_executable_layout_destroy,
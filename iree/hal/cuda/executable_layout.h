@@ -36,6 +36,30 @@ iree_host_size_t iree_hal_cuda_push_constant_index(
 iree_host_size_t iree_hal_cuda_executable_layout_num_constants(
     iree_hal_executable_layout_t* base_executable_layout);
 
+// Kernel arguments are packed into one contiguous buffer matching the parameter
+// layout of kernels generated by the LLVMGPU backend: a CUdeviceptr for each
+// binding in kernel argument order followed by a 32-bit value for each push
+// constant. The buffer is passed to the driver with
+// CU_LAUNCH_PARAM_BUFFER_POINTER so that launches copy a single block instead
+// of following a pointer per argument.
+
+// Returns the byte offset of the binding at kernel argument |index| in the
+// packed kernel arguments.
+static inline iree_host_size_t iree_hal_cuda_kernel_arg_binding_offset(
+    iree_host_size_t index) {
+  return index * sizeof(CUdeviceptr);
+}
+
+// Returns the byte offset of the push constants in the packed kernel arguments
+// of kernels using |executable_layout|.
+iree_host_size_t iree_hal_cuda_executable_layout_constant_offset(
+    iree_hal_executable_layout_t* executable_layout);
+
+// Returns the total size in bytes of the packed kernel arguments of kernels
+// using |executable_layout|.
+iree_host_size_t iree_hal_cuda_executable_layout_kernel_args_size(
+    iree_hal_executable_layout_t* executable_layout);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
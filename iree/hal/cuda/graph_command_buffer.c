@@ -9,26 +9,53 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/cuda/cuda_buffer.h"
 #include "iree/hal/cuda/dynamic_symbols.h"
 #include "iree/hal/cuda/executable_layout.h"
+#include "iree/hal/cuda/graph_exec_cache.h"
+#include "iree/hal/cuda/library_calls.h"
 #include "iree/hal/cuda/native_executable.h"
 #include "iree/hal/cuda/status_util.h"
+#include "iree/hal/utils/graph_dependency_tracker.h"
 #include "iree/hal/utils/resource_set.h"
 
 #define IREE_HAL_CUDA_MAX_BINDING_COUNT 64
 // Kernel arguments contains binding and push constants.
 #define IREE_HAL_CUDA_MAX_KERNEL_ARG 128
 
+// Kinds of non-kernel graph nodes mixed into the structure hash. Kernel nodes
+// use their CUfunction, which never collides with these small values.
+#define IREE_HAL_CUDA_GRAPH_NODE_KIND_FILL 1
+#define IREE_HAL_CUDA_GRAPH_NODE_KIND_UPDATE 2
+#define IREE_HAL_CUDA_GRAPH_NODE_KIND_COPY 3
+
+// Device memory range bound to a kernel argument by push_descriptor_set.
+typedef struct iree_hal_cuda_graph_binding_range_t {
+  CUdeviceptr begin;
+  CUdeviceptr end;
+} iree_hal_cuda_graph_binding_range_t;
+
 // Command buffer implementation that directly maps to cuda graph.
 // This records the commands on the calling thread without additional threading
 // indirection.
+//
+// Graph edges are derived from barriers: every node depends on all nodes added
+// before the most recent barrier (or event wait) that precedes it. Nodes
+// within the same barrier scope are independent and may execute concurrently
+// unless they access overlapping device memory with at least one write, in
+// which case an edge is added between them to preserve recording order.
+//
+// The node kinds and edges are hashed as they are recorded so that an exec
+// instantiated by an earlier recording with the same structure can be reused
+// from the device |exec_cache| by only updating node parameters.
 typedef struct iree_hal_cuda_graph_command_buffer_t {
   iree_hal_command_buffer_t base;
   iree_hal_cuda_context_wrapper_t* context;
+  iree_hal_cuda_graph_exec_cache_t* exec_cache;
 
   // Maintains a reference to all resources used within the command buffer.
   // Reset on each begin.
@@ -39,15 +66,22 @@ typedef struct iree_hal_cuda_graph_command_buffer_t {
   // asynchronous operations.
   iree_arena_allocator_t arena;
 
+  // Graph being recorded between begin and end.
   CUgraph graph;
-  CUgraphExec exec;
+  // Instantiated graph acquired from |exec_cache| when recording ends.
+  iree_hal_cuda_graph_exec_t* exec;
+
+  // Derives the edges of the nodes added to |graph|.
+  iree_hal_graph_dependency_tracker_t dependency_tracker;
+
+  // Ranges of the currently pushed bindings indexed by kernel argument.
+  iree_hal_cuda_graph_binding_range_t
+      binding_ranges[IREE_HAL_CUDA_MAX_KERNEL_ARG];
 
-  // Keep track of the last node added to the command buffer as we are currently
-  // serializing all the nodes (each node depends on the previous one).
-  CUgraphNode last_node;
   int32_t push_constant[IREE_HAL_CUDA_MAX_PUSH_CONSTANT_COUNT];
-  // Keep track of the current set of kernel arguments.
-  void* current_descriptor[];
+  // Current kernel arguments packed as described in executable_layout.h.
+  iree_alignas(16) uint8_t
+      kernel_args[IREE_HAL_CUDA_MAX_KERNEL_ARG * sizeof(CUdeviceptr)];
 } iree_hal_cuda_graph_command_buffer_t;
 
 static const iree_hal_command_buffer_vtable_t
@@ -61,38 +95,34 @@ iree_hal_cuda_graph_command_buffer_cast(iree_hal_command_buffer_t* base_value) {
 
 iree_status_t iree_hal_cuda_graph_command_buffer_create(
     iree_hal_device_t* device, iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_graph_exec_cache_t* exec_cache,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_arena_block_pool_t* block_pool,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(exec_cache);
   IREE_ASSERT_ARGUMENT(block_pool);
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_cuda_graph_command_buffer_t* command_buffer = NULL;
-  size_t total_size = sizeof(*command_buffer) +
-                      IREE_HAL_CUDA_MAX_KERNEL_ARG * sizeof(void*) +
-                      IREE_HAL_CUDA_MAX_KERNEL_ARG * sizeof(CUdeviceptr);
+  size_t total_size = sizeof(*command_buffer);
   iree_status_t status = iree_allocator_malloc(
       context->host_allocator, total_size, (void**)&command_buffer);
   if (iree_status_is_ok(status)) {
+    memset(command_buffer, 0, total_size);
     iree_hal_command_buffer_initialize(
         device, mode, command_categories, queue_affinity,
         &iree_hal_cuda_graph_command_buffer_vtable, &command_buffer->base);
     command_buffer->context = context;
+    command_buffer->exec_cache = exec_cache;
     iree_arena_initialize(block_pool, &command_buffer->arena);
     command_buffer->graph = NULL;
     command_buffer->exec = NULL;
-    command_buffer->last_node = NULL;
-
-    CUdeviceptr* device_ptrs =
-        (CUdeviceptr*)(command_buffer->current_descriptor +
-                       IREE_HAL_CUDA_MAX_KERNEL_ARG);
-    for (size_t i = 0; i < IREE_HAL_CUDA_MAX_KERNEL_ARG; i++) {
-      command_buffer->current_descriptor[i] = &device_ptrs[i];
-    }
+    iree_hal_graph_dependency_tracker_initialize(
+        context->host_allocator, &command_buffer->dependency_tracker);
 
     status = iree_hal_resource_set_allocate(block_pool,
                                             &command_buffer->resource_set);
@@ -115,13 +145,15 @@ static void iree_hal_cuda_graph_command_buffer_reset(
     command_buffer->graph = NULL;
   }
 
-  if (command_buffer->exec != NULL) {
-    CUDA_IGNORE_ERROR(command_buffer->context->syms,
-                      cuGraphExecDestroy(command_buffer->exec));
-    command_buffer->exec = NULL;
-  }
+  // Return the exec so that a later recording with the same structure can
+  // reuse it. Any launches still in flight are unaffected.
+  iree_hal_cuda_graph_exec_cache_release(command_buffer->exec_cache,
+                                         command_buffer->exec);
+  command_buffer->exec = NULL;
 
-  command_buffer->last_node = NULL;
+  iree_hal_graph_dependency_tracker_reset(&command_buffer->dependency_tracker);
+  memset(command_buffer->binding_ranges, 0,
+         sizeof(command_buffer->binding_ranges));
 
   iree_hal_resource_set_reset(command_buffer->resource_set);
   iree_arena_reset(&command_buffer->arena);
@@ -136,18 +168,14 @@ static void iree_hal_cuda_graph_command_buffer_destroy(
   iree_hal_cuda_graph_command_buffer_reset(command_buffer);
   iree_hal_resource_set_free(command_buffer->resource_set);
   iree_arena_deinitialize(&command_buffer->arena);
-  iree_allocator_free(command_buffer->context->host_allocator, command_buffer);
+  iree_allocator_t host_allocator = command_buffer->context->host_allocator;
+  iree_hal_graph_dependency_tracker_deinitialize(
+      &command_buffer->dependency_tracker);
+  iree_allocator_free(host_allocator, command_buffer);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
-CUgraphExec iree_hal_cuda_graph_command_buffer_handle(
-    iree_hal_command_buffer_t* base_command_buffer) {
-  iree_hal_cuda_graph_command_buffer_t* command_buffer =
-      iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
-  return command_buffer->exec;
-}
-
 bool iree_hal_cuda_graph_command_buffer_isa(
     iree_hal_command_buffer_t* command_buffer) {
   return iree_hal_command_buffer_dyn_cast(
@@ -184,25 +212,21 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_end(
   iree_hal_cuda_graph_command_buffer_t* command_buffer =
       iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
 
+  // Compile the graph or update a cached exec of the same structure. The cache
+  // takes ownership of the graph either way.
+  CUgraph graph = command_buffer->graph;
+  command_buffer->graph = NULL;
+  iree_status_t status = iree_hal_cuda_graph_exec_cache_acquire(
+      command_buffer->exec_cache,
+      command_buffer->dependency_tracker.structure_hash, graph,
+      command_buffer->dependency_tracker.node_count,
+      (const CUgraphNode*)command_buffer->dependency_tracker.nodes,
+      &command_buffer->exec);
+
   // Reset state used during recording.
-  command_buffer->last_node = NULL;
-
-  // Compile the graph.
-  CUgraphNode error_node = NULL;
-  iree_status_t status =
-      CU_RESULT_TO_STATUS(command_buffer->context->syms,
-                          cuGraphInstantiate(&command_buffer->exec,
-                                             command_buffer->graph, &error_node,
-                                             /*logBuffer=*/NULL,
-                                             /*bufferSize=*/0));
-  if (iree_status_is_ok(status)) {
-    // No longer need the source graph used for construction.
-    CUDA_IGNORE_ERROR(command_buffer->context->syms,
-                      cuGraphDestroy(command_buffer->graph));
-    command_buffer->graph = NULL;
-  }
+  iree_hal_graph_dependency_tracker_reset(&command_buffer->dependency_tracker);
 
-  return iree_ok_status();
+  return status;
 }
 
 static void iree_hal_cuda_graph_command_buffer_begin_debug_group(
@@ -226,24 +250,26 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_execution_barrier(
     const iree_hal_memory_barrier_t* memory_barriers,
     iree_host_size_t buffer_barrier_count,
     const iree_hal_buffer_barrier_t* buffer_barriers) {
-  // TODO: Implement barrier with Graph edges. Right now all the nodes are
-  // serialized.
+  iree_hal_cuda_graph_command_buffer_t* command_buffer =
+      iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
+  // TODO: use the memory and buffer barriers to only depend on the nodes that
+  // touched the barriered ranges.
+  iree_hal_graph_dependency_tracker_insert_barrier(
+      &command_buffer->dependency_tracker);
   return iree_ok_status();
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_signal_event(
     iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
     iree_hal_execution_stage_t source_stage_mask) {
-  // TODO: Implement barrier with Graph edges. Right now all the nodes are
-  // serialized.
+  // Events are only waited on within the same command buffer and waits are
+  // implemented as full barriers so there's nothing to record here.
   return iree_ok_status();
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_reset_event(
     iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
     iree_hal_execution_stage_t source_stage_mask) {
-  // TODO: Implement barrier with Graph edges. Right now all the nodes are
-  // serialized.
   return iree_ok_status();
 }
 
@@ -256,8 +282,12 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_wait_events(
     const iree_hal_memory_barrier_t* memory_barriers,
     iree_host_size_t buffer_barrier_count,
     const iree_hal_buffer_barrier_t* buffer_barriers) {
-  // TODO: Implement barrier with Graph edges. Right now all the nodes are
-  // serialized.
+  iree_hal_cuda_graph_command_buffer_t* command_buffer =
+      iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
+  // TODO: track the scope each event was signaled in and only depend on the
+  // nodes recorded before the signal.
+  iree_hal_graph_dependency_tracker_insert_barrier(
+      &command_buffer->dependency_tracker);
   return iree_ok_status();
 }
 
@@ -313,16 +343,25 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_fill_buffer(
       .height = 1,
       .value = dword_pattern,
   };
-  // Serialize all the nodes for now.
-  CUgraphNode dep[] = {command_buffer->last_node};
-  size_t numNode = command_buffer->last_node ? 1 : 0;
+  iree_hal_graph_access_t accesses[1] = {
+      iree_hal_graph_make_access(target_device_buffer + target_offset,
+                                      length, /*is_write=*/true),
+  };
+  iree_host_size_t dependency_count = 0;
+  const iree_hal_graph_node_t* dependencies = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_graph_dependency_tracker_gather(
+      &command_buffer->dependency_tracker, IREE_ARRAYSIZE(accesses), accesses,
+      &dependency_count, &dependencies));
+  CUgraphNode node = NULL;
   CUDA_RETURN_IF_ERROR(
       command_buffer->context->syms,
-      cuGraphAddMemsetNode(&command_buffer->last_node, command_buffer->graph,
-                           dep, numNode, &params,
-                           command_buffer->context->cu_context),
+      cuGraphAddMemsetNode(&node, command_buffer->graph,
+                           (const CUgraphNode*)dependencies, dependency_count,
+                           &params, command_buffer->context->cu_context),
       "cuGraphAddMemsetNode");
-  return iree_ok_status();
+  return iree_hal_graph_dependency_tracker_append(
+      &command_buffer->dependency_tracker, node,
+      IREE_HAL_CUDA_GRAPH_NODE_KIND_FILL, IREE_ARRAYSIZE(accesses), accesses);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_update_buffer(
@@ -360,16 +399,24 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_update_buffer(
       .Height = 1,
       .Depth = 1,
   };
-  // Serialize all the nodes for now.
-  CUgraphNode dep[] = {command_buffer->last_node};
-  size_t numNode = command_buffer->last_node ? 1 : 0;
+  iree_hal_graph_access_t accesses[1] = {
+      iree_hal_graph_make_access(dst, length, /*is_write=*/true),
+  };
+  iree_host_size_t dependency_count = 0;
+  const iree_hal_graph_node_t* dependencies = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_graph_dependency_tracker_gather(
+      &command_buffer->dependency_tracker, IREE_ARRAYSIZE(accesses), accesses,
+      &dependency_count, &dependencies));
+  CUgraphNode node = NULL;
   CUDA_RETURN_IF_ERROR(
       command_buffer->context->syms,
-      cuGraphAddMemcpyNode(&command_buffer->last_node, command_buffer->graph,
-                           dep, numNode, &params,
-                           command_buffer->context->cu_context),
+      cuGraphAddMemcpyNode(&node, command_buffer->graph,
+                           (const CUgraphNode*)dependencies, dependency_count,
+                           &params, command_buffer->context->cu_context),
       "cuGraphAddMemcpyNode");
-  return iree_ok_status();
+  return iree_hal_graph_dependency_tracker_append(
+      &command_buffer->dependency_tracker, node,
+      IREE_HAL_CUDA_GRAPH_NODE_KIND_UPDATE, IREE_ARRAYSIZE(accesses), accesses);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_copy_buffer(
@@ -401,16 +448,27 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_copy_buffer(
       .Height = 1,
       .Depth = 1,
   };
-  // Serialize all the nodes for now.
-  CUgraphNode dep[] = {command_buffer->last_node};
-  size_t numNode = command_buffer->last_node ? 1 : 0;
+  iree_hal_graph_access_t accesses[2] = {
+      iree_hal_graph_make_access(source_device_buffer + source_offset,
+                                      length, /*is_write=*/false),
+      iree_hal_graph_make_access(target_device_buffer + target_offset,
+                                      length, /*is_write=*/true),
+  };
+  iree_host_size_t dependency_count = 0;
+  const iree_hal_graph_node_t* dependencies = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_graph_dependency_tracker_gather(
+      &command_buffer->dependency_tracker, IREE_ARRAYSIZE(accesses), accesses,
+      &dependency_count, &dependencies));
+  CUgraphNode node = NULL;
   CUDA_RETURN_IF_ERROR(
       command_buffer->context->syms,
-      cuGraphAddMemcpyNode(&command_buffer->last_node, command_buffer->graph,
-                           dep, numNode, &params,
-                           command_buffer->context->cu_context),
+      cuGraphAddMemcpyNode(&node, command_buffer->graph,
+                           (const CUgraphNode*)dependencies, dependency_count,
+                           &params, command_buffer->context->cu_context),
       "cuGraphAddMemcpyNode");
-  return iree_ok_status();
+  return iree_hal_graph_dependency_tracker_append(
+      &command_buffer->dependency_tracker, node,
+      IREE_HAL_CUDA_GRAPH_NODE_KIND_COPY, IREE_ARRAYSIZE(accesses), accesses);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_push_constants(
@@ -472,12 +530,19 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_push_descriptor_set(
         iree_hal_cuda_buffer_device_pointer(
             iree_hal_buffer_allocated_buffer(binding->buffer)) +
         iree_hal_buffer_byte_offset(binding->buffer) + binding->offset;
-    *((CUdeviceptr*)command_buffer->current_descriptor[i + base_binding]) =
-        device_ptr;
-    IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
-        command_buffer->resource_set, 1, &binding->buffer));
+    memcpy(command_buffer->kernel_args +
+               iree_hal_cuda_kernel_arg_binding_offset(i + base_binding),
+           &device_ptr, sizeof(device_ptr));
+    iree_device_size_t length = binding->length;
+    if (length == IREE_WHOLE_BUFFER) {
+      length = iree_hal_buffer_byte_length(binding->buffer) - binding->offset;
+    }
+    command_buffer->binding_ranges[i + base_binding].begin = device_ptr;
+    command_buffer->binding_ranges[i + base_binding].end = device_ptr + length;
   }
-  return iree_ok_status();
+  return iree_hal_resource_set_insert_span(command_buffer->resource_set,
+                                           binding_count, &bindings[0].buffer,
+                                           sizeof(bindings[0]));
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_bind_descriptor_set(
@@ -502,36 +567,77 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_dispatch(
       iree_hal_cuda_executable_get_layout(executable, entry_point);
   iree_host_size_t num_constants =
       iree_hal_cuda_executable_layout_num_constants(layout);
-  iree_host_size_t constant_base_index =
-      iree_hal_cuda_push_constant_index(layout);
   // Patch the push constants in the kernel arguments.
-  for (iree_host_size_t i = 0; i < num_constants; i++) {
-    *((uint32_t*)command_buffer->current_descriptor[i + constant_base_index]) =
-        command_buffer->push_constant[i];
+  memcpy(command_buffer->kernel_args +
+             iree_hal_cuda_executable_layout_constant_offset(layout),
+         command_buffer->push_constant, num_constants * sizeof(uint32_t));
+
+  // The HAL doesn't tell us how each binding is accessed so conservatively
+  // treat all of them as written.
+  iree_hal_graph_access_t accesses[IREE_HAL_CUDA_MAX_KERNEL_ARG];
+  iree_host_size_t access_count = 0;
+  for (iree_host_size_t i = 0; i < IREE_HAL_CUDA_MAX_KERNEL_ARG; ++i) {
+    const iree_hal_cuda_graph_binding_range_t* range =
+        &command_buffer->binding_ranges[i];
+    if (range->begin == range->end) continue;
+    accesses[access_count++] = iree_hal_graph_make_access(
+        range->begin, range->end - range->begin, /*is_write=*/true);
+  }
+  iree_host_size_t dependency_count = 0;
+  const iree_hal_graph_node_t* dependencies = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_graph_dependency_tracker_gather(
+      &command_buffer->dependency_tracker, access_count, accesses,
+      &dependency_count, &dependencies));
+  CUfunction func =
+      iree_hal_cuda_native_executable_for_entry_point(executable, entry_point);
+  CUgraphNode node = NULL;
+
+  // Prefer the vendor library when the compiler selected one for the entry
+  // point. The workgroup count only applies to the kernel.
+  const iree_hal_cuda_library_call_t* library_call =
+      iree_hal_cuda_native_executable_library_call(executable, entry_point);
+  if (library_call && iree_hal_cuda_library_call_is_available(
+                          command_buffer->context, library_call)) {
+    IREE_RETURN_IF_ERROR(iree_hal_cuda_library_call_record_graph(
+        command_buffer->context, library_call, command_buffer->kernel_args,
+        command_buffer->graph, (const CUgraphNode*)dependencies,
+        dependency_count, &node));
+    return iree_hal_graph_dependency_tracker_append(
+        &command_buffer->dependency_tracker, node,
+        (uint64_t)(uintptr_t)library_call, access_count, accesses);
   }
+
   int32_t block_size_x, block_size_y, block_size_z;
   IREE_RETURN_IF_ERROR(iree_hal_cuda_native_executable_block_size(
       executable, entry_point, &block_size_x, &block_size_y, &block_size_z));
+  // The packed arguments are copied into the node when it is added.
+  size_t kernel_args_size =
+      iree_hal_cuda_executable_layout_kernel_args_size(layout);
+  void* launch_config[] = {
+      CU_LAUNCH_PARAM_BUFFER_POINTER, command_buffer->kernel_args,
+      CU_LAUNCH_PARAM_BUFFER_SIZE,    &kernel_args_size,
+      CU_LAUNCH_PARAM_END,
+  };
   CUDA_KERNEL_NODE_PARAMS params = {
-      .func = iree_hal_cuda_native_executable_for_entry_point(executable,
-                                                              entry_point),
+      .func = func,
       .blockDimX = block_size_x,
       .blockDimY = block_size_y,
       .blockDimZ = block_size_z,
       .gridDimX = workgroup_x,
       .gridDimY = workgroup_y,
       .gridDimZ = workgroup_z,
-      .kernelParams = command_buffer->current_descriptor,
+      .kernelParams = NULL,
+      .extra = launch_config,
   };
-  // Serialize all the nodes for now.
-  CUgraphNode dep[] = {command_buffer->last_node};
-  size_t numNodes = command_buffer->last_node ? 1 : 0;
   CUDA_RETURN_IF_ERROR(
       command_buffer->context->syms,
-      cuGraphAddKernelNode(&command_buffer->last_node, command_buffer->graph,
-                           dep, numNodes, &params),
+      cuGraphAddKernelNode(&node, command_buffer->graph,
+                           (const CUgraphNode*)dependencies, dependency_count,
+                           &params),
       "cuGraphAddKernelNode");
-  return iree_ok_status();
+  return iree_hal_graph_dependency_tracker_append(
+      &command_buffer->dependency_tracker, node, (uint64_t)(uintptr_t)func,
+      access_count, accesses);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_dispatch_indirect(
@@ -549,7 +655,7 @@ CUgraphExec iree_hal_cuda_graph_command_buffer_exec(
       (iree_hal_cuda_graph_command_buffer_t*)iree_hal_command_buffer_dyn_cast(
           base_command_buffer, &iree_hal_cuda_graph_command_buffer_vtable);
   IREE_ASSERT_TRUE(command_buffer);
-  return command_buffer->exec;
+  return command_buffer->exec ? command_buffer->exec->exec : NULL;
 }
 
 static const iree_hal_command_buffer_vtable_t
@@ -12,6 +12,7 @@
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/cuda_headers.h"
 #include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/graph_exec_cache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,11 +21,14 @@ extern "C" {
 typedef struct iree_arena_block_pool_t iree_arena_block_pool_t;
 
 // Creates a command buffer that records into a CUDA graph.
+// Graphs are instantiated through |exec_cache| so that re-recording a command
+// buffer with the same structure only updates node parameters.
 //
-// NOTE: the |block_pool| must remain live for the lifetime of the command
-// buffers that use it.
+// NOTE: the |exec_cache| and |block_pool| must remain live for the lifetime of
+// the command buffers that use them.
 iree_status_t iree_hal_cuda_graph_command_buffer_create(
     iree_hal_device_t* device, iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_graph_exec_cache_t* exec_cache,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
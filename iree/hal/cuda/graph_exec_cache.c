@@ -0,0 +1,217 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/cuda/graph_exec_cache.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/status_util.h"
+
+void iree_hal_cuda_graph_exec_cache_initialize(
+    iree_hal_cuda_context_wrapper_t* context, iree_host_size_t capacity,
+    iree_hal_cuda_graph_exec_cache_t* out_cache) {
+  memset(out_cache, 0, sizeof(*out_cache));
+  out_cache->context = context;
+  out_cache->capacity = capacity;
+  iree_slim_mutex_initialize(&out_cache->mutex);
+}
+
+static void iree_hal_cuda_graph_exec_destroy(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_graph_exec_t* exec) {
+  if (exec->exec) {
+    CUDA_IGNORE_ERROR(context->syms, cuGraphExecDestroy(exec->exec));
+  }
+  if (exec->graph) {
+    CUDA_IGNORE_ERROR(context->syms, cuGraphDestroy(exec->graph));
+  }
+  iree_allocator_free(context->host_allocator, exec);
+}
+
+void iree_hal_cuda_graph_exec_cache_deinitialize(
+    iree_hal_cuda_graph_exec_cache_t* cache) {
+  iree_hal_cuda_graph_exec_t* exec = cache->head;
+  while (exec) {
+    iree_hal_cuda_graph_exec_t* next = exec->next;
+    iree_hal_cuda_graph_exec_destroy(cache->context, exec);
+    exec = next;
+  }
+  cache->head = NULL;
+  cache->count = 0;
+  iree_slim_mutex_deinitialize(&cache->mutex);
+}
+
+// Updates the parameters of all nodes in |exec| to those of |nodes|, which
+// must have been recorded in the same order with the same structure.
+// Fails if CUDA does not support the particular update in which case |exec|
+// may be partially updated and must be discarded.
+static iree_status_t iree_hal_cuda_graph_exec_update(
+    iree_hal_cuda_context_wrapper_t* context, iree_hal_cuda_graph_exec_t* exec,
+    const CUgraphNode* nodes) {
+  iree_hal_cuda_dynamic_symbols_t* syms = context->syms;
+  for (iree_host_size_t i = 0; i < exec->node_count; ++i) {
+    CUgraphNodeType type;
+    CUDA_RETURN_IF_ERROR(syms, cuGraphNodeGetType(nodes[i], &type),
+                         "cuGraphNodeGetType");
+    switch (type) {
+      case CU_GRAPH_NODE_TYPE_KERNEL: {
+        CUDA_KERNEL_NODE_PARAMS params;
+        CUDA_RETURN_IF_ERROR(syms,
+                             cuGraphKernelNodeGetParams(nodes[i], &params),
+                             "cuGraphKernelNodeGetParams");
+        CUDA_RETURN_IF_ERROR(syms,
+                             cuGraphExecKernelNodeSetParams(
+                                 exec->exec, exec->nodes[i], &params),
+                             "cuGraphExecKernelNodeSetParams");
+        break;
+      }
+      case CU_GRAPH_NODE_TYPE_MEMCPY: {
+        CUDA_MEMCPY3D params;
+        CUDA_RETURN_IF_ERROR(syms,
+                             cuGraphMemcpyNodeGetParams(nodes[i], &params),
+                             "cuGraphMemcpyNodeGetParams");
+        CUDA_RETURN_IF_ERROR(
+            syms,
+            cuGraphExecMemcpyNodeSetParams(exec->exec, exec->nodes[i], &params,
+                                           context->cu_context),
+            "cuGraphExecMemcpyNodeSetParams");
+        break;
+      }
+      case CU_GRAPH_NODE_TYPE_MEMSET: {
+        CUDA_MEMSET_NODE_PARAMS params;
+        CUDA_RETURN_IF_ERROR(syms,
+                             cuGraphMemsetNodeGetParams(nodes[i], &params),
+                             "cuGraphMemsetNodeGetParams");
+        CUDA_RETURN_IF_ERROR(
+            syms,
+            cuGraphExecMemsetNodeSetParams(exec->exec, exec->nodes[i], &params,
+                                           context->cu_context),
+            "cuGraphExecMemsetNodeSetParams");
+        break;
+      }
+      case CU_GRAPH_NODE_TYPE_GRAPH: {
+        // Library calls captured from streams.
+        CUgraph child_graph = NULL;
+        CUDA_RETURN_IF_ERROR(
+            syms, cuGraphChildGraphNodeGetGraph(nodes[i], &child_graph),
+            "cuGraphChildGraphNodeGetGraph");
+        CUDA_RETURN_IF_ERROR(syms,
+                             cuGraphExecChildGraphNodeSetParams(
+                                 exec->exec, exec->nodes[i], child_graph),
+                             "cuGraphExecChildGraphNodeSetParams");
+        break;
+      }
+      default:
+        return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                                "graph node type %d cannot be updated",
+                                (int)type);
+    }
+  }
+  return iree_ok_status();
+}
+
+// Instantiates |graph| into a new exec. Takes ownership of |graph|.
+static iree_status_t iree_hal_cuda_graph_exec_instantiate(
+    iree_hal_cuda_context_wrapper_t* context, uint64_t structure_hash,
+    CUgraph graph, iree_host_size_t node_count, const CUgraphNode* nodes,
+    iree_hal_cuda_graph_exec_t** out_exec) {
+  iree_hal_cuda_graph_exec_t* exec = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      context->host_allocator, sizeof(*exec) + node_count * sizeof(CUgraphNode),
+      (void**)&exec);
+  if (!iree_status_is_ok(status)) {
+    CUDA_IGNORE_ERROR(context->syms, cuGraphDestroy(graph));
+    return status;
+  }
+  exec->next = NULL;
+  exec->structure_hash = structure_hash;
+  exec->graph = graph;
+  exec->exec = NULL;
+  exec->node_count = node_count;
+  memcpy(exec->nodes, nodes, node_count * sizeof(CUgraphNode));
+
+  CUgraphNode error_node = NULL;
+  status = CU_RESULT_TO_STATUS(
+      context->syms,
+      cuGraphInstantiate(&exec->exec, graph, &error_node, /*logBuffer=*/NULL,
+                         /*bufferSize=*/0),
+      "cuGraphInstantiate");
+  if (iree_status_is_ok(status)) {
+    *out_exec = exec;
+  } else {
+    iree_hal_cuda_graph_exec_destroy(context, exec);
+  }
+  return status;
+}
+
+iree_status_t iree_hal_cuda_graph_exec_cache_acquire(
+    iree_hal_cuda_graph_exec_cache_t* cache, uint64_t structure_hash,
+    CUgraph graph, iree_host_size_t node_count, const CUgraphNode* nodes,
+    iree_hal_cuda_graph_exec_t** out_exec) {
+  IREE_ASSERT_ARGUMENT(cache);
+  IREE_ASSERT_ARGUMENT(graph);
+  IREE_ASSERT_ARGUMENT(out_exec);
+  *out_exec = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Take an unused exec recorded with the same structure, if any.
+  iree_hal_cuda_graph_exec_t* exec = NULL;
+  iree_slim_mutex_lock(&cache->mutex);
+  for (iree_hal_cuda_graph_exec_t** it = &cache->head; *it != NULL;
+       it = &(*it)->next) {
+    if ((*it)->structure_hash == structure_hash &&
+        (*it)->node_count == node_count) {
+      exec = *it;
+      *it = exec->next;
+      exec->next = NULL;
+      --cache->count;
+      break;
+    }
+  }
+  iree_slim_mutex_unlock(&cache->mutex);
+
+  if (exec) {
+    iree_status_t status =
+        iree_hal_cuda_graph_exec_update(cache->context, exec, nodes);
+    if (iree_status_is_ok(status)) {
+      // The exec now matches |graph|, which is no longer needed.
+      IREE_TRACE_ZONE_APPEND_TEXT(z0, "updated");
+      CUDA_IGNORE_ERROR(cache->context->syms, cuGraphDestroy(graph));
+      *out_exec = exec;
+      IREE_TRACE_ZONE_END(z0);
+      return iree_ok_status();
+    }
+    // The hash matched but the graphs differ in ways CUDA cannot update (or
+    // the hash collided); instantiate the new graph instead.
+    iree_status_ignore(status);
+    iree_hal_cuda_graph_exec_destroy(cache->context, exec);
+  }
+
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, "instantiated");
+  iree_status_t status = iree_hal_cuda_graph_exec_instantiate(
+      cache->context, structure_hash, graph, node_count, nodes, out_exec);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_cuda_graph_exec_cache_release(
+    iree_hal_cuda_graph_exec_cache_t* cache, iree_hal_cuda_graph_exec_t* exec) {
+  if (!exec) return;
+  iree_slim_mutex_lock(&cache->mutex);
+  bool cached = false;
+  if (cache->count < cache->capacity) {
+    exec->next = cache->head;
+    cache->head = exec;
+    ++cache->count;
+    cached = true;
+  }
+  iree_slim_mutex_unlock(&cache->mutex);
+  if (!cached) iree_hal_cuda_graph_exec_destroy(cache->context, exec);
+}
@@ -0,0 +1,83 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_CUDA_GRAPH_EXEC_CACHE_H_
+#define IREE_HAL_CUDA_GRAPH_EXEC_CACHE_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/api.h"
+#include "iree/hal/cuda/context_wrapper.h"
+#include "iree/hal/cuda/cuda_headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// An instantiated CUDA graph along with the graph it was instantiated from.
+// Owned by a single command buffer at a time.
+typedef struct iree_hal_cuda_graph_exec_t {
+  struct iree_hal_cuda_graph_exec_t* next;
+  // Hash of the topology and node kinds of |graph|.
+  uint64_t structure_hash;
+  // Graph |exec| was instantiated from. Kept alive as its nodes are used to
+  // address the nodes of |exec| when updating it.
+  CUgraph graph;
+  CUgraphExec exec;
+  // Nodes of |graph| in the order they were recorded.
+  iree_host_size_t node_count;
+  CUgraphNode nodes[];
+} iree_hal_cuda_graph_exec_t;
+
+// A cache of instantiated graphs that are no longer used by any command
+// buffer. Instantiation is the dominant CPU cost of graph command buffers and
+// command buffers are frequently re-recorded with the same structure but
+// different buffers and dispatch parameters; in that case a cached exec is
+// updated in place with cuGraphExec*NodeSetParams instead of instantiating the
+// new graph.
+typedef struct iree_hal_cuda_graph_exec_cache_t {
+  iree_hal_cuda_context_wrapper_t* context;
+  // Maximum number of execs retained; 0 disables caching.
+  iree_host_size_t capacity;
+
+  iree_slim_mutex_t mutex;
+  // Unused execs, most recently released first.
+  iree_host_size_t count;
+  iree_hal_cuda_graph_exec_t* head;
+} iree_hal_cuda_graph_exec_cache_t;
+
+// Initializes |out_cache| to retain up to |capacity| unused execs.
+void iree_hal_cuda_graph_exec_cache_initialize(
+    iree_hal_cuda_context_wrapper_t* context, iree_host_size_t capacity,
+    iree_hal_cuda_graph_exec_cache_t* out_cache);
+
+// Destroys all cached execs. No execs acquired from the cache may be live.
+void iree_hal_cuda_graph_exec_cache_deinitialize(
+    iree_hal_cuda_graph_exec_cache_t* cache);
+
+// Returns an exec of |graph| whose |nodes| were recorded in order.
+// A cached exec with a matching |structure_hash| is updated to the parameters
+// of |graph| if possible and otherwise |graph| is instantiated. Takes
+// ownership of |graph| in all cases. The returned exec must be released back
+// to the cache with iree_hal_cuda_graph_exec_cache_release.
+iree_status_t iree_hal_cuda_graph_exec_cache_acquire(
+    iree_hal_cuda_graph_exec_cache_t* cache, uint64_t structure_hash,
+    CUgraph graph, iree_host_size_t node_count, const CUgraphNode* nodes,
+    iree_hal_cuda_graph_exec_t** out_exec);
+
+// Returns |exec| to the cache for reuse by later recordings or destroys it if
+// the cache is full. Launches of the exec that are still in flight are not
+// affected by later updates.
+void iree_hal_cuda_graph_exec_cache_release(
+    iree_hal_cuda_graph_exec_cache_t* cache, iree_hal_cuda_graph_exec_t* exec);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_CUDA_GRAPH_EXEC_CACHE_H_
@@ -0,0 +1,199 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/cuda/library_calls.h"
+
+#include <string.h>
+
+#include "iree/base/tracing.h"
+#include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/executable_layout.h"
+#include "iree/hal/cuda/status_util.h"
+
+// Values of the cuBLAS and CUDA runtime enums used by library calls. These are
+// part of the stable ABI of the libraries.
+#define IREE_CUBLAS_STATUS_SUCCESS 0
+#define IREE_CUBLAS_OP_N 0
+#define IREE_CUDA_R_32F 0
+#define IREE_CUDA_R_16F 2
+#define IREE_CUBLAS_COMPUTE_32F 68
+#define IREE_CUBLAS_GEMM_DEFAULT -1
+
+static iree_status_t iree_hal_cuda_cublas_result_to_status(
+    int result, const char* symbol) {
+  if (IREE_LIKELY(result == IREE_CUBLAS_STATUS_SUCCESS)) {
+    return iree_ok_status();
+  }
+  return iree_make_status(IREE_STATUS_INTERNAL, "%s failed with status %d",
+                          symbol, result);
+}
+
+// IREE_RETURN_IF_ERROR for cuBLAS calls.
+//
+// Usage:
+//   CUBLAS_RETURN_IF_ERROR(syms, cublasDoThing, ...);
+#define CUBLAS_RETURN_IF_ERROR(syms, symbol, ...)             \
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_cublas_result_to_status( \
+      (syms)->symbol(__VA_ARGS__), #symbol))
+
+void iree_hal_cuda_library_state_initialize(
+    iree_hal_cuda_library_state_t* out_state) {
+  memset(out_state, 0, sizeof(*out_state));
+  iree_slim_mutex_initialize(&out_state->mutex);
+}
+
+void iree_hal_cuda_library_state_deinitialize(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_library_state_t* state) {
+  if (state->cublas_handle) {
+    IREE_IGNORE_ERROR(iree_hal_cuda_cublas_result_to_status(
+        context->syms->cublasDestroy_v2(state->cublas_handle),
+        "cublasDestroy_v2"));
+  }
+  if (state->capture_stream) {
+    CUDA_IGNORE_ERROR(context->syms, cuStreamDestroy(state->capture_stream));
+  }
+  iree_slim_mutex_deinitialize(&state->mutex);
+  memset(state, 0, sizeof(*state));
+}
+
+bool iree_hal_cuda_library_call_is_available(
+    iree_hal_cuda_context_wrapper_t* context,
+    const iree_hal_cuda_library_call_t* call) {
+  switch (call->kind) {
+    case IREE_HAL_CUDA_LIBRARY_CALL_KIND_CUBLAS_GEMM:
+      return context->library_state &&
+             iree_hal_cuda_dynamic_symbols_has_cublas(context->syms);
+    default:
+      return false;
+  }
+}
+
+static CUdeviceptr iree_hal_cuda_library_call_binding(
+    const uint8_t* kernel_args, uint32_t binding) {
+  CUdeviceptr device_ptr = 0;
+  memcpy(&device_ptr,
+         kernel_args + iree_hal_cuda_kernel_arg_binding_offset(binding),
+         sizeof(device_ptr));
+  return device_ptr;
+}
+
+// Enqueues a cuBLAS GEMM on |stream|. Must be called with the state mutex held.
+//
+// cuBLAS is column-major and a row-major matrix is its column-major transpose
+// so C = A * B is computed as C^T = B^T * A^T without any transposition.
+static iree_status_t iree_hal_cuda_library_call_cublas_gemm(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_library_state_t* state,
+    const iree_hal_cuda_library_call_t* call, const uint8_t* kernel_args,
+    CUstream stream) {
+  iree_hal_cuda_dynamic_symbols_t* syms = context->syms;
+  if (!state->cublas_handle) {
+    CUBLAS_RETURN_IF_ERROR(syms, cublasCreate_v2, &state->cublas_handle);
+  }
+  CUBLAS_RETURN_IF_ERROR(syms, cublasSetStream_v2, state->cublas_handle,
+                         stream);
+  int data_type = call->data_type == IREE_HAL_CUDA_LIBRARY_DATA_TYPE_F16
+                      ? IREE_CUDA_R_16F
+                      : IREE_CUDA_R_32F;
+  const float alpha = 1.0f;
+  const float beta = call->accumulate ? 1.0f : 0.0f;
+  CUdeviceptr lhs =
+      iree_hal_cuda_library_call_binding(kernel_args, call->lhs_binding);
+  CUdeviceptr rhs =
+      iree_hal_cuda_library_call_binding(kernel_args, call->rhs_binding);
+  CUdeviceptr result =
+      iree_hal_cuda_library_call_binding(kernel_args, call->result_binding);
+  CUBLAS_RETURN_IF_ERROR(
+      syms, cublasGemmEx, state->cublas_handle, IREE_CUBLAS_OP_N,
+      IREE_CUBLAS_OP_N, (int)call->n, (int)call->m, (int)call->k, &alpha,
+      (const void*)rhs, data_type, (int)call->n, (const void*)lhs, data_type,
+      (int)call->k, &beta, (void*)result, data_type, (int)call->n,
+      IREE_CUBLAS_COMPUTE_32F, IREE_CUBLAS_GEMM_DEFAULT);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_cuda_library_call_record_stream_locked(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_library_state_t* state,
+    const iree_hal_cuda_library_call_t* call, const uint8_t* kernel_args,
+    CUstream stream) {
+  switch (call->kind) {
+    case IREE_HAL_CUDA_LIBRARY_CALL_KIND_CUBLAS_GEMM:
+      return iree_hal_cuda_library_call_cublas_gemm(context, state, call,
+                                                    kernel_args, stream);
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unsupported library call kind %d",
+                              (int)call->kind);
+  }
+}
+
+iree_status_t iree_hal_cuda_library_call_record_stream(
+    iree_hal_cuda_context_wrapper_t* context,
+    const iree_hal_cuda_library_call_t* call, const uint8_t* kernel_args,
+    CUstream stream) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_cuda_library_state_t* state = context->library_state;
+  iree_slim_mutex_lock(&state->mutex);
+  iree_status_t status = iree_hal_cuda_library_call_record_stream_locked(
+      context, state, call, kernel_args, stream);
+  iree_slim_mutex_unlock(&state->mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Libraries only enqueue work on streams so calls are captured from a private
+// stream into a child graph of |graph|.
+iree_status_t iree_hal_cuda_library_call_record_graph(
+    iree_hal_cuda_context_wrapper_t* context,
+    const iree_hal_cuda_library_call_t* call, const uint8_t* kernel_args,
+    CUgraph graph, const CUgraphNode* dependencies, size_t dependency_count,
+    CUgraphNode* out_node) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_cuda_dynamic_symbols_t* syms = context->syms;
+  iree_hal_cuda_library_state_t* state = context->library_state;
+  iree_slim_mutex_lock(&state->mutex);
+
+  iree_status_t status = iree_ok_status();
+  if (!state->capture_stream) {
+    status = CU_RESULT_TO_STATUS(
+        syms, cuStreamCreate(&state->capture_stream, CU_STREAM_NON_BLOCKING),
+        "cuStreamCreate");
+  }
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        syms,
+        cuStreamBeginCapture(state->capture_stream,
+                             CU_STREAM_CAPTURE_MODE_RELAXED),
+        "cuStreamBeginCapture");
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_cuda_library_call_record_stream_locked(
+          context, state, call, kernel_args, state->capture_stream);
+      // Capture must always be ended to return the stream to normal use.
+      CUgraph child_graph = NULL;
+      iree_status_t end_status = CU_RESULT_TO_STATUS(
+          syms, cuStreamEndCapture(state->capture_stream, &child_graph),
+          "cuStreamEndCapture");
+      status = iree_status_join(status, end_status);
+      if (iree_status_is_ok(status)) {
+        // The child graph is cloned into |graph|.
+        status = CU_RESULT_TO_STATUS(
+            syms,
+            cuGraphAddChildGraphNode(out_node, graph, dependencies,
+                                     dependency_count, child_graph),
+            "cuGraphAddChildGraphNode");
+      }
+      if (child_graph) {
+        CUDA_IGNORE_ERROR(syms, cuGraphDestroy(child_graph));
+      }
+    }
+  }
+
+  iree_slim_mutex_unlock(&state->mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
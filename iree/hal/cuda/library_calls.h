@@ -0,0 +1,100 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_CUDA_LIBRARY_CALLS_H_
+#define IREE_HAL_CUDA_LIBRARY_CALLS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/cuda/context_wrapper.h"
+#include "iree/hal/cuda/cuda_headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Library calls let the compiler mark entry points that are better served by a
+// vendor library than by the generated kernel (such as large fp16 GEMMs). The
+// kernel is always compiled as well and is launched instead whenever the
+// library is not available on the system.
+
+// Matches iree_CUDALibraryCallKind_enum_t.
+typedef enum iree_hal_cuda_library_call_kind_e {
+  IREE_HAL_CUDA_LIBRARY_CALL_KIND_NONE = 0,
+  // Row-major GEMM computing C[m, n] (+)= A[m, k] * B[k, n] with cuBLAS.
+  IREE_HAL_CUDA_LIBRARY_CALL_KIND_CUBLAS_GEMM = 1,
+} iree_hal_cuda_library_call_kind_t;
+
+// Matches iree_CUDALibraryDataType_enum_t.
+typedef enum iree_hal_cuda_library_data_type_e {
+  IREE_HAL_CUDA_LIBRARY_DATA_TYPE_F32 = 0,
+  IREE_HAL_CUDA_LIBRARY_DATA_TYPE_F16 = 1,
+} iree_hal_cuda_library_data_type_t;
+
+// A library call performing a dispatch of an entry point.
+typedef struct iree_hal_cuda_library_call_t {
+  iree_hal_cuda_library_call_kind_t kind;
+  uint32_t m;
+  uint32_t n;
+  uint32_t k;
+  iree_hal_cuda_library_data_type_t data_type;
+  // True if the result is accumulated into the existing contents of C.
+  bool accumulate;
+  // Kernel argument ordinals of the A, B, and C buffers.
+  uint32_t lhs_binding;
+  uint32_t rhs_binding;
+  uint32_t result_binding;
+} iree_hal_cuda_library_call_t;
+
+// Per-context state shared by all library calls.
+typedef struct iree_hal_cuda_library_state_t {
+  // Guards the library handles, which must not be used concurrently.
+  iree_slim_mutex_t mutex;
+  // cuBLAS handle created on first use.
+  iree_hal_cuda_cublas_handle_t cublas_handle;
+  // Stream used to capture library calls into graphs created on first use.
+  CUstream capture_stream;
+} iree_hal_cuda_library_state_t;
+
+// Initializes |out_state| for use with the context it is assigned to.
+void iree_hal_cuda_library_state_initialize(
+    iree_hal_cuda_library_state_t* out_state);
+
+// Releases the library resources of |state| created within |context|.
+void iree_hal_cuda_library_state_deinitialize(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_library_state_t* state);
+
+// Returns true if |call| can be performed in |context|. Callers must launch the
+// entry point kernel when it cannot.
+bool iree_hal_cuda_library_call_is_available(
+    iree_hal_cuda_context_wrapper_t* context,
+    const iree_hal_cuda_library_call_t* call);
+
+// Enqueues |call| on |stream|. |kernel_args| are the packed kernel arguments
+// the entry point kernel would have been launched with.
+iree_status_t iree_hal_cuda_library_call_record_stream(
+    iree_hal_cuda_context_wrapper_t* context,
+    const iree_hal_cuda_library_call_t* call, const uint8_t* kernel_args,
+    CUstream stream);
+
+// Adds a node performing |call| to |graph| depending on |dependencies|.
+// |kernel_args| are the packed kernel arguments the entry point kernel would
+// have been launched with.
+iree_status_t iree_hal_cuda_library_call_record_graph(
+    iree_hal_cuda_context_wrapper_t* context,
+    const iree_hal_cuda_library_call_t* call, const uint8_t* kernel_args,
+    CUgraph graph, const CUgraphNode* dependencies, size_t dependency_count,
+    CUgraphNode* out_node);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_CUDA_LIBRARY_CALLS_H_
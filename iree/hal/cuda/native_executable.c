@@ -6,9 +6,13 @@
 
 #include "iree/hal/cuda/native_executable.h"
 
+#include <inttypes.h>
 #include <stddef.h>
+#include <stdio.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/base/internal/file_path.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/cuda/dynamic_symbols.h"
 #include "iree/hal/cuda/executable_layout.h"
@@ -24,6 +28,8 @@ typedef struct iree_hal_cuda_native_executable_function_t {
   uint32_t block_size_x;
   uint32_t block_size_y;
   uint32_t block_size_z;
+  // Kind NONE if the kernel is always launched.
+  iree_hal_cuda_library_call_t library_call;
 } iree_hal_cuda_native_executable_function_t;
 
 typedef struct iree_hal_cuda_native_executable_t {
@@ -44,11 +50,312 @@ static iree_hal_cuda_native_executable_t* iree_hal_cuda_native_executable_cast(
   return (iree_hal_cuda_native_executable_t*)base_value;
 }
 
+//===----------------------------------------------------------------------===//
+// PTX JIT cache
+//===----------------------------------------------------------------------===//
+
+// 'IUCJ'
+#define IREE_HAL_CUDA_JIT_CACHE_MAGIC 0x4A435549u
+
+// Header prepended to each cubin stored in the JIT cache. Entries are only used
+// if they were produced from the same PTX for the same device architecture and
+// driver version; anything else (including truncated files from a concurrent
+// writer) is ignored and overwritten. Padded to 64 bytes so that the cubin
+// following it remains suitably aligned for loading.
+typedef struct iree_hal_cuda_jit_cache_header_t {
+  uint32_t magic;
+  uint32_t sm_version;
+  int32_t driver_version;
+  uint32_t reserved0;
+  uint64_t ptx_hash;
+  uint64_t ptx_length;
+  uint64_t cubin_length;
+  uint64_t reserved1[3];
+} iree_hal_cuda_jit_cache_header_t;
+
+// 64-bit FNV-1a. PTX is hashed once each time a module is loaded and this is
+// negligible relative to loading it.
+static uint64_t iree_hal_cuda_ptx_hash(iree_const_byte_span_t data) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (iree_host_size_t i = 0; i < data.data_length; ++i) {
+    hash ^= data.data[i];
+    hash *= 0x100000001B3ull;
+  }
+  return hash;
+}
+
+// Returns the path of the JIT cache entry for the PTX described by |header|.
+// Callers must free |out_path| with |host_allocator|.
+static iree_status_t iree_hal_cuda_jit_cache_entry_path(
+    const iree_hal_cuda_native_executable_options_t* options,
+    const iree_hal_cuda_jit_cache_header_t* header,
+    iree_allocator_t host_allocator, char** out_path) {
+  char file_name[64];
+  snprintf(file_name, sizeof(file_name), "%016" PRIx64 "_sm%u_%d.cubin",
+           header->ptx_hash, header->sm_version, header->driver_version);
+  return iree_file_path_join(options->jit_cache_path,
+                             iree_make_cstring_view(file_name), host_allocator,
+                             out_path);
+}
+
+// Loads the module for the PTX described by |header| from the JIT cache.
+// Returns OK with a NULL |out_module| if there is no usable cache entry.
+static iree_status_t iree_hal_cuda_jit_cache_load(
+    iree_hal_cuda_context_wrapper_t* context, const char* path,
+    const iree_hal_cuda_jit_cache_header_t* header, CUmodule* out_module) {
+  *out_module = NULL;
+  iree_byte_span_t contents = iree_make_byte_span(NULL, 0);
+  iree_status_t status =
+      iree_file_read_contents(path, context->host_allocator, &contents);
+  if (!iree_status_is_ok(status)) {
+    // Missing or unreadable entries are misses.
+    iree_status_ignore(status);
+    return iree_ok_status();
+  }
+
+  const iree_hal_cuda_jit_cache_header_t* entry_header =
+      (const iree_hal_cuda_jit_cache_header_t*)contents.data;
+  if (contents.data_length >= sizeof(*entry_header) &&
+      entry_header->magic == header->magic &&
+      entry_header->sm_version == header->sm_version &&
+      entry_header->driver_version == header->driver_version &&
+      entry_header->ptx_hash == header->ptx_hash &&
+      entry_header->ptx_length == header->ptx_length &&
+      entry_header->cubin_length ==
+          contents.data_length - sizeof(*entry_header)) {
+    // A failure to load a valid-looking entry is treated as a miss so that it
+    // is replaced by a fresh compilation.
+    CUresult result = context->syms->cuModuleLoadData(
+        out_module, contents.data + sizeof(*entry_header));
+    if (result != CUDA_SUCCESS) *out_module = NULL;
+  }
+
+  iree_allocator_free(context->host_allocator, contents.data);
+  return status;
+}
+
+// Writes |cubin| to the JIT cache. Failures are ignored as the cache is only an
+// optimization.
+static void iree_hal_cuda_jit_cache_store(
+    iree_hal_cuda_context_wrapper_t* context, const char* path,
+    const iree_hal_cuda_jit_cache_header_t* header,
+    iree_const_byte_span_t cubin) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_host_size_t total_size = sizeof(*header) + cubin.data_length;
+  uint8_t* contents = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      context->host_allocator, total_size, (void**)&contents);
+  if (iree_status_is_ok(status)) {
+    memcpy(contents, header, sizeof(*header));
+    ((iree_hal_cuda_jit_cache_header_t*)contents)->cubin_length =
+        cubin.data_length;
+    memcpy(contents + sizeof(*header), cubin.data, cubin.data_length);
+    status = iree_file_write_contents(
+        path, iree_make_const_byte_span(contents, total_size));
+  }
+  iree_allocator_free(context->host_allocator, contents);
+  iree_status_ignore(status);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// JIT compiles |ptx_image| into a cubin, loads it, and stores it in the JIT
+// cache at |cache_path| if not NULL.
+static iree_status_t iree_hal_cuda_jit_compile(
+    iree_hal_cuda_context_wrapper_t* context, iree_const_byte_span_t ptx_image,
+    const char* cache_path, const iree_hal_cuda_jit_cache_header_t* header,
+    CUmodule* out_module) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  CUlinkState link_state = NULL;
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      context->syms, cuLinkCreate(0, NULL, NULL, &link_state), "cuLinkCreate");
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        context->syms,
+        cuLinkAddData(link_state, CU_JIT_INPUT_PTX, (void*)ptx_image.data,
+                      ptx_image.data_length, "ptx_image", 0, NULL, NULL),
+        "cuLinkAddData");
+  }
+  void* cubin = NULL;
+  size_t cubin_size = 0;
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        context->syms, cuLinkComplete(link_state, &cubin, &cubin_size),
+        "cuLinkComplete");
+  }
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(context->syms,
+                                 cuModuleLoadData(out_module, cubin),
+                                 "cuModuleLoadData");
+  }
+  if (iree_status_is_ok(status) && cache_path) {
+    iree_hal_cuda_jit_cache_store(context, cache_path, header,
+                                  iree_make_const_byte_span(cubin, cubin_size));
+  }
+  // The cubin is owned by the link state.
+  if (link_state) {
+    CUDA_IGNORE_ERROR(context->syms, cuLinkDestroy(link_state));
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_native_executable_t
+//===----------------------------------------------------------------------===//
+
+// Returns the embedded cubin that best matches |sm_version| or NULL if none is
+// compatible. cubins run on devices of the same major architecture version
+// with an equal or newer minor version so the newest compatible one is chosen.
+static iree_CUDACubinDef_table_t iree_hal_cuda_native_executable_select_cubin(
+    iree_CUDAExecutableDef_table_t executable_def, uint32_t sm_version) {
+  iree_CUDACubinDef_vec_t cubins_vec =
+      iree_CUDAExecutableDef_cubin_images_get(executable_def);
+  iree_CUDACubinDef_table_t best_cubin = NULL;
+  uint32_t best_sm_version = 0;
+  for (iree_host_size_t i = 0; i < iree_CUDACubinDef_vec_len(cubins_vec);
+       ++i) {
+    iree_CUDACubinDef_table_t cubin = iree_CUDACubinDef_vec_at(cubins_vec, i);
+    uint32_t cubin_sm_version = iree_CUDACubinDef_sm_version_get(cubin);
+    if (cubin_sm_version / 10 != sm_version / 10 ||
+        cubin_sm_version > sm_version) {
+      continue;
+    }
+    if (!best_cubin || cubin_sm_version > best_sm_version) {
+      best_cubin = cubin;
+      best_sm_version = cubin_sm_version;
+    }
+  }
+  return best_cubin;
+}
+
+// Loads the module of |executable_def| preferring, in order: a compatible
+// embedded cubin, a cached JIT compilation of the PTX, and JIT compiling the
+// PTX.
+static iree_status_t iree_hal_cuda_native_executable_load_module(
+    iree_hal_cuda_context_wrapper_t* context,
+    const iree_hal_cuda_native_executable_options_t* options,
+    iree_CUDAExecutableDef_table_t executable_def, CUmodule* out_module) {
+  *out_module = NULL;
+
+  iree_CUDACubinDef_table_t cubin =
+      iree_hal_cuda_native_executable_select_cubin(executable_def,
+                                                   options->sm_version);
+  if (cubin) {
+    IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_cuda_load_cubin");
+    CUresult result = context->syms->cuModuleLoadData(
+        out_module, iree_CUDACubinDef_image_get(cubin));
+    IREE_TRACE_ZONE_END(z0);
+    // The driver may still reject the cubin (for example if it was produced by
+    // a newer toolkit than the driver supports); fall back to the PTX.
+    if (result == CUDA_SUCCESS) return iree_ok_status();
+    *out_module = NULL;
+  }
+
+  // flatbuffers strings are NUL terminated and the terminator must be included
+  // in the PTX passed to the driver.
+  flatbuffers_string_t ptx_image =
+      iree_CUDAExecutableDef_ptx_image_get(executable_def);
+  iree_const_byte_span_t ptx_span = iree_make_const_byte_span(
+      ptx_image, flatbuffers_string_len(ptx_image) + 1);
+  if (iree_string_view_is_empty(options->jit_cache_path)) {
+    IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_cuda_jit_ptx");
+    iree_status_t status = CU_RESULT_TO_STATUS(
+        context->syms,
+        cuModuleLoadDataEx(out_module, ptx_image, 0, NULL, NULL),
+        "cuModuleLoadDataEx");
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  iree_hal_cuda_jit_cache_header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic = IREE_HAL_CUDA_JIT_CACHE_MAGIC;
+  header.sm_version = options->sm_version;
+  header.driver_version = options->driver_version;
+  header.ptx_hash = iree_hal_cuda_ptx_hash(ptx_span);
+  header.ptx_length = ptx_span.data_length;
+  char* cache_path = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_jit_cache_entry_path(
+      options, &header, context->host_allocator, &cache_path));
+
+  iree_status_t status =
+      iree_hal_cuda_jit_cache_load(context, cache_path, &header, out_module);
+  if (iree_status_is_ok(status) && !*out_module) {
+    status = iree_hal_cuda_jit_compile(context, ptx_span, cache_path, &header,
+                                       out_module);
+  }
+  iree_allocator_free(context->host_allocator, cache_path);
+  return status;
+}
+
+// Populates |out_call| from |library_call_def| after verifying it against the
+// executable layout of the entry point.
+static iree_status_t iree_hal_cuda_native_executable_parse_library_call(
+    iree_CUDALibraryCallDef_table_t library_call_def,
+    iree_hal_executable_layout_t* executable_layout,
+    iree_hal_cuda_library_call_t* out_call) {
+  memset(out_call, 0, sizeof(*out_call));
+  if (!library_call_def) return iree_ok_status();
+  iree_CUDALibraryCallKind_enum_t kind =
+      iree_CUDALibraryCallDef_kind_get(library_call_def);
+  switch (kind) {
+    case iree_CUDALibraryCallKind_NONE:
+      return iree_ok_status();
+    case iree_CUDALibraryCallKind_CUBLAS_GEMM:
+      out_call->kind = IREE_HAL_CUDA_LIBRARY_CALL_KIND_CUBLAS_GEMM;
+      break;
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unknown library call kind %u", (uint32_t)kind);
+  }
+  switch (iree_CUDALibraryCallDef_data_type_get(library_call_def)) {
+    case iree_CUDALibraryDataType_F32:
+      out_call->data_type = IREE_HAL_CUDA_LIBRARY_DATA_TYPE_F32;
+      break;
+    case iree_CUDALibraryDataType_F16:
+      out_call->data_type = IREE_HAL_CUDA_LIBRARY_DATA_TYPE_F16;
+      break;
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unknown library call data type");
+  }
+  out_call->m = iree_CUDALibraryCallDef_m_get(library_call_def);
+  out_call->n = iree_CUDALibraryCallDef_n_get(library_call_def);
+  out_call->k = iree_CUDALibraryCallDef_k_get(library_call_def);
+  out_call->accumulate =
+      iree_CUDALibraryCallDef_accumulate_get(library_call_def);
+  out_call->lhs_binding =
+      iree_CUDALibraryCallDef_lhs_binding_get(library_call_def);
+  out_call->rhs_binding =
+      iree_CUDALibraryCallDef_rhs_binding_get(library_call_def);
+  out_call->result_binding =
+      iree_CUDALibraryCallDef_result_binding_get(library_call_def);
+  if (out_call->m > INT32_MAX || out_call->n > INT32_MAX ||
+      out_call->k > INT32_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "library call GEMM size %ux%ux%u out of range",
+                            out_call->m, out_call->n, out_call->k);
+  }
+  iree_host_size_t binding_count =
+      iree_hal_cuda_push_constant_index(executable_layout);
+  if (out_call->lhs_binding >= binding_count ||
+      out_call->rhs_binding >= binding_count ||
+      out_call->result_binding >= binding_count) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "library call bindings out of range of the %zu layout bindings",
+        binding_count);
+  }
+  return iree_ok_status();
+}
+
 iree_status_t iree_hal_cuda_native_executable_create(
     iree_hal_cuda_context_wrapper_t* context,
+    const iree_hal_cuda_native_executable_options_t* options,
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(options);
   IREE_ASSERT_ARGUMENT(executable_spec);
   IREE_ASSERT_ARGUMENT(out_executable);
   *out_executable = NULL;
@@ -61,13 +368,22 @@ iree_status_t iree_hal_cuda_native_executable_create(
       iree_CUDAExecutableDef_as_root(executable_spec->executable_data.data);
 
   // Create the kernel module.
-  flatbuffers_string_t ptx_image =
-      iree_CUDAExecutableDef_ptx_image_get(executable_def);
   flatbuffers_string_vec_t entry_points_vec =
       iree_CUDAExecutableDef_entry_points_get(executable_def);
   iree_CUDABlockSizeDef_vec_t block_sizes_vec =
       iree_CUDAExecutableDef_block_sizes_get(executable_def);
   iree_host_size_t entry_count = flatbuffers_string_vec_len(entry_points_vec);
+  iree_CUDALibraryCallDef_vec_t library_calls_vec =
+      iree_CUDAExecutableDef_library_calls_get(executable_def);
+  iree_host_size_t library_call_count =
+      iree_CUDALibraryCallDef_vec_len(library_calls_vec);
+  if (library_call_count != 0 && library_call_count != entry_count) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "executable has %zu library calls for %zu entry "
+                            "points",
+                            library_call_count, entry_count);
+  }
   iree_host_size_t total_size =
       sizeof(*executable) +
       entry_count * sizeof(iree_hal_cuda_native_executable_function_t) +
@@ -78,19 +394,19 @@ iree_status_t iree_hal_cuda_native_executable_create(
   if (iree_status_is_ok(status)) {
     iree_hal_resource_initialize(&iree_hal_cuda_native_executable_vtable,
                                  &executable->resource);
-    executable->module = module;
+    executable->module = NULL;
     executable->context = context;
+    executable->entry_count = 0;
 
     executable->executable_layouts =
         (void*)((char*)executable + sizeof(*executable) +
                 entry_count *
                     sizeof(iree_hal_cuda_native_executable_function_t));
-    status = CU_RESULT_TO_STATUS(
-        context->syms, cuModuleLoadDataEx(&module, ptx_image, 0, NULL, NULL),
-        "cuModuleLoadDataEx");
+    status = iree_hal_cuda_native_executable_load_module(
+        context, options, executable_def, &module);
+    executable->module = module;
   }
 
-  executable->entry_count = entry_count;
   for (iree_host_size_t i = 0; i < entry_count; i++) {
     if (iree_status_is_ok(status)) {
       CUfunction function = NULL;
@@ -105,12 +421,21 @@ iree_status_t iree_hal_cuda_native_executable_create(
       executable->executable_layouts[i] =
           executable_spec->executable_layouts[i];
       iree_hal_executable_layout_retain(executable_spec->executable_layouts[i]);
+      executable->entry_count = i + 1;
+    }
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_cuda_native_executable_parse_library_call(
+          library_call_count
+              ? iree_CUDALibraryCallDef_vec_at(library_calls_vec, i)
+              : NULL,
+          executable_spec->executable_layouts[i],
+          &executable->entry_functions[i].library_call);
     }
   }
 
   if (iree_status_is_ok(status)) {
     *out_executable = (iree_hal_executable_t*)executable;
-  } else {
+  } else if (executable) {
     iree_hal_executable_destroy((iree_hal_executable_t*)executable);
   }
 
@@ -128,6 +453,10 @@ static void iree_hal_cuda_native_executable_destroy(
   for (iree_host_size_t i = 0; i < executable->entry_count; ++i) {
     iree_hal_executable_layout_release(executable->executable_layouts[i]);
   }
+  if (executable->module) {
+    CUDA_IGNORE_ERROR(executable->context->syms,
+                      cuModuleUnload(executable->module));
+  }
   iree_allocator_free(host_allocator, executable);
 
   IREE_TRACE_ZONE_END(z0);
@@ -151,6 +480,18 @@ iree_status_t iree_hal_cuda_native_executable_block_size(
   return iree_ok_status();
 }
 
+const iree_hal_cuda_library_call_t*
+iree_hal_cuda_native_executable_library_call(
+    iree_hal_executable_t* base_executable, int32_t entry_point) {
+  iree_hal_cuda_native_executable_t* executable =
+      iree_hal_cuda_native_executable_cast(base_executable);
+  const iree_hal_cuda_library_call_t* library_call =
+      &executable->entry_functions[entry_point].library_call;
+  return library_call->kind != IREE_HAL_CUDA_LIBRARY_CALL_KIND_NONE
+             ? library_call
+             : NULL;
+}
+
 iree_hal_executable_layout_t* iree_hal_cuda_executable_get_layout(
     iree_hal_executable_t* base_executable, int32_t entry_point) {
   iree_hal_cuda_native_executable_t* executable =
@@ -13,15 +13,33 @@
 #include "iree/hal/api.h"
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/cuda_headers.h"
+#include "iree/hal/cuda/library_calls.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
+// Describes the device executables are loaded for.
+typedef struct iree_hal_cuda_native_executable_options_t {
+  // Compute capability of the device encoded as major * 10 + minor.
+  uint32_t sm_version;
+  // CUDA driver version as returned by cuDriverGetVersion.
+  int driver_version;
+  // Directory used to persist PTX JIT compilation results across processes.
+  // Empty to always JIT compile PTX when no compatible cubin is embedded.
+  iree_string_view_t jit_cache_path;
+} iree_hal_cuda_native_executable_options_t;
+
 // Creates an executable from a PTX module. The module may contain several
 // kernels that can be extracted along with the associated block size.
+//
+// If the executable embeds a cubin compatible with |options|->sm_version it is
+// loaded directly. Otherwise the PTX is JIT compiled by the driver and, if a
+// |options|->jit_cache_path is provided, the result is cached on disk keyed by
+// the PTX contents, device architecture, and driver version.
 iree_status_t iree_hal_cuda_native_executable_create(
     iree_hal_cuda_context_wrapper_t* context,
+    const iree_hal_cuda_native_executable_options_t* options,
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable);
 
@@ -33,6 +51,12 @@ iree_status_t iree_hal_cuda_native_executable_block_size(
     iree_hal_executable_t* executable, int32_t entry_point, uint32_t* x,
     uint32_t* y, uint32_t* z);
 
+// Returns the library call that may be performed instead of launching the
+// kernel of |entry_point| or NULL if the entry point has none.
+const iree_hal_cuda_library_call_t*
+iree_hal_cuda_native_executable_library_call(iree_hal_executable_t* executable,
+                                             int32_t entry_point);
+
 /// Return the layout associated with the entry point.
 iree_hal_executable_layout_t* iree_hal_cuda_executable_get_layout(
     iree_hal_executable_t* executable, int32_t entry_point);
@@ -10,6 +10,7 @@
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/cuda/context_wrapper.h"
+#include "iree/hal/cuda/native_executable.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,9 +18,12 @@ extern "C" {
 
 // Creates a no-op executable cache that does not cache at all.
 // This is useful to isolate pipeline caching behavior and verify compilation
-// behavior.
+// behavior. Executables are created with |executable_options|, which must
+// remain valid for the lifetime of the cache.
 iree_status_t iree_hal_cuda_nop_executable_cache_create(
-    iree_hal_cuda_context_wrapper_t* context, iree_string_view_t identifier,
+    iree_hal_cuda_context_wrapper_t* context,
+    const iree_hal_cuda_native_executable_options_t* executable_options,
+    iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache);
 
 #ifdef __cplusplus
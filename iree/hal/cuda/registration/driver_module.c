@@ -26,6 +26,20 @@ IREE_FLAG(bool, cuda_allow_inline_execution, false,
           "Allow command buffers to execute inline against CUDA streams when "
           "possible.");
 
+IREE_FLAG(int32_t, cuda_queue_count, 8,
+          "Number of CUDA streams used as queues on each device.");
+
+IREE_FLAG(bool, cuda_dedicated_transfer_queue, true,
+          "Use a separate CUDA stream for transfer-only submissions.");
+
+IREE_FLAG(string, cuda_jit_cache_path, "",
+          "Existing directory used to cache PTX JIT compilation results across "
+          "runs.");
+
+IREE_FLAG(int64_t, cuda_allocation_cache_limit, 256 * 1024 * 1024,
+          "Maximum bytes of freed CUDA allocations cached for reuse (0 to "
+          "disable).");
+
 static iree_status_t iree_hal_cuda_driver_factory_enumerate(
     void* self, const iree_hal_driver_info_t** out_driver_infos,
     iree_host_size_t* out_driver_info_count) {
@@ -60,6 +74,16 @@ static iree_status_t iree_hal_cuda_driver_factory_try_create(
         IREE_HAL_CUDA_COMMAND_BUFFER_MODE_STREAM;
   }
   default_params.allow_inline_execution = FLAG_cuda_allow_inline_execution;
+  if (FLAG_cuda_queue_count > 0) {
+    default_params.queue_count = (iree_host_size_t)FLAG_cuda_queue_count;
+  }
+  default_params.dedicated_transfer_queue = FLAG_cuda_dedicated_transfer_queue;
+  default_params.jit_cache_path =
+      iree_make_cstring_view(FLAG_cuda_jit_cache_path);
+  if (FLAG_cuda_allocation_cache_limit >= 0) {
+    default_params.allocation_cache_limit =
+        (iree_device_size_t)FLAG_cuda_allocation_cache_limit;
+  }
 
   iree_hal_cuda_driver_options_t driver_options;
   iree_hal_cuda_driver_options_initialize(&driver_options);
@@ -10,6 +10,7 @@
 #include "iree/hal/cuda/cuda_buffer.h"
 #include "iree/hal/cuda/cuda_event.h"
 #include "iree/hal/cuda/executable_layout.h"
+#include "iree/hal/cuda/library_calls.h"
 #include "iree/hal/cuda/native_executable.h"
 #include "iree/hal/cuda/status_util.h"
 
@@ -30,9 +31,9 @@ typedef struct {
   iree_arena_allocator_t arena;
 
   int32_t push_constant[IREE_HAL_CUDA_MAX_PUSH_CONSTANT_COUNT];
-  // Keep track of the current set of kernel arguments.
-  void* current_descriptor[IREE_HAL_CUDA_MAX_KERNEL_ARG];
-  CUdeviceptr* device_ptrs[IREE_HAL_CUDA_MAX_KERNEL_ARG];
+  // Current kernel arguments packed as described in executable_layout.h.
+  iree_alignas(16) uint8_t
+      kernel_args[IREE_HAL_CUDA_MAX_KERNEL_ARG * sizeof(CUdeviceptr)];
 } iree_hal_cuda_stream_command_buffer_t;
 
 static const iree_hal_command_buffer_vtable_t
@@ -68,9 +69,6 @@ iree_status_t iree_hal_cuda_stream_command_buffer_create(
     command_buffer->context = context;
     command_buffer->stream = stream;
     iree_arena_initialize(block_pool, &command_buffer->arena);
-    for (size_t i = 0; i < IREE_HAL_CUDA_MAX_KERNEL_ARG; i++) {
-      command_buffer->current_descriptor[i] = &command_buffer->device_ptrs[i];
-    }
   }
 
   *out_command_buffer = &command_buffer->base;
@@ -96,6 +94,13 @@ bool iree_hal_cuda_stream_command_buffer_isa(
       command_buffer, &iree_hal_cuda_stream_command_buffer_vtable);
 }
 
+CUstream iree_hal_cuda_stream_command_buffer_stream(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_cuda_stream_command_buffer_t* command_buffer =
+      iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
+  return command_buffer->stream;
+}
+
 static void* iree_hal_cuda_stream_command_buffer_dyn_cast(
     iree_hal_command_buffer_t* command_buffer, const void* vtable) {
   if (vtable == &iree_hal_cuda_stream_command_buffer_vtable) {
@@ -324,8 +329,9 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_push_descriptor_set(
         iree_hal_cuda_buffer_device_pointer(
             iree_hal_buffer_allocated_buffer(binding.buffer)) +
         iree_hal_buffer_byte_offset(binding.buffer) + binding.offset;
-    *((CUdeviceptr*)command_buffer->current_descriptor[i + base_binding]) =
-        device_ptr;
+    memcpy(command_buffer->kernel_args +
+               iree_hal_cuda_kernel_arg_binding_offset(i + base_binding),
+           &device_ptr, sizeof(device_ptr));
   }
   return iree_ok_status();
 }
@@ -350,12 +356,20 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_dispatch(
       iree_hal_cuda_executable_get_layout(executable, entry_point);
   iree_host_size_t num_constants =
       iree_hal_cuda_executable_layout_num_constants(layout);
-  iree_host_size_t constant_base_index =
-      iree_hal_cuda_push_constant_index(layout);
   // Patch the push constants in the kernel arguments.
-  for (iree_host_size_t i = 0; i < num_constants; i++) {
-    *((uint32_t*)command_buffer->current_descriptor[i + constant_base_index]) =
-        command_buffer->push_constant[i];
+  memcpy(command_buffer->kernel_args +
+             iree_hal_cuda_executable_layout_constant_offset(layout),
+         command_buffer->push_constant, num_constants * sizeof(uint32_t));
+
+  // Prefer the vendor library when the compiler selected one for the entry
+  // point. The workgroup count only applies to the kernel.
+  const iree_hal_cuda_library_call_t* library_call =
+      iree_hal_cuda_native_executable_library_call(executable, entry_point);
+  if (library_call && iree_hal_cuda_library_call_is_available(
+                          command_buffer->context, library_call)) {
+    return iree_hal_cuda_library_call_record_stream(
+        command_buffer->context, library_call, command_buffer->kernel_args,
+        command_buffer->stream);
   }
 
   int32_t block_size_x, block_size_y, block_size_z;
@@ -363,11 +377,19 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_dispatch(
       executable, entry_point, &block_size_x, &block_size_y, &block_size_z));
   CUfunction func =
       iree_hal_cuda_native_executable_for_entry_point(executable, entry_point);
+  // The driver copies the packed arguments as a single block.
+  size_t kernel_args_size =
+      iree_hal_cuda_executable_layout_kernel_args_size(layout);
+  void* launch_config[] = {
+      CU_LAUNCH_PARAM_BUFFER_POINTER, command_buffer->kernel_args,
+      CU_LAUNCH_PARAM_BUFFER_SIZE,    &kernel_args_size,
+      CU_LAUNCH_PARAM_END,
+  };
   CUDA_RETURN_IF_ERROR(
       command_buffer->context->syms,
       cuLaunchKernel(func, workgroup_x, workgroup_y, workgroup_z, block_size_x,
                      block_size_y, block_size_z, 0, command_buffer->stream,
-                     command_buffer->current_descriptor, NULL),
+                     /*kernelParams=*/NULL, launch_config),
       "cuLaunchKernel");
   return iree_ok_status();
 }
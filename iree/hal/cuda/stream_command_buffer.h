@@ -39,6 +39,10 @@ iree_status_t iree_hal_cuda_stream_command_buffer_create(
 bool iree_hal_cuda_stream_command_buffer_isa(
     iree_hal_command_buffer_t* command_buffer);
 
+// Returns the stream that |command_buffer| issues commands against.
+CUstream iree_hal_cuda_stream_command_buffer_stream(
+    iree_hal_command_buffer_t* command_buffer);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -6,6 +6,7 @@
 
 #include "iree/hal/device.h"
 
+#include "iree/base/profiler.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/allocator.h"
 #include "iree/hal/buffer.h"
@@ -278,6 +279,29 @@ static iree_status_t iree_hal_device_validate_submission(
   return iree_ok_status();
 }
 
+// Reports a submission of |batches| to the registered profiler, if any.
+static void iree_hal_device_profile_submission(
+    iree_hal_device_t* device, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches) {
+  if (!iree_profiler_is_enabled(IREE_PROFILER_EVENT_MASK_SUBMIT)) return;
+  uint64_t command_buffer_count = 0;
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    command_buffer_count += batches[i].command_buffer_count;
+  }
+  iree_profiler_record_slow(IREE_PROFILER_EVENT_TYPE_SUBMIT,
+                            (uint64_t)(uintptr_t)device,
+                            iree_hal_device_id(device), command_buffer_count);
+}
+
+// Reports |type| for a wait on |semaphore_list| to the registered profiler.
+static void iree_hal_device_profile_wait(
+    iree_profiler_event_type_t type, iree_hal_device_t* device,
+    const iree_hal_semaphore_list_t* semaphore_list) {
+  if (!iree_profiler_is_enabled(1u << type)) return;
+  iree_profiler_record_slow(type, (uint64_t)(uintptr_t)semaphore_list,
+                            iree_hal_device_id(device), semaphore_list->count);
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_device_queue_submit(
     iree_hal_device_t* device, iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
@@ -287,6 +311,7 @@ IREE_API_EXPORT iree_status_t iree_hal_device_queue_submit(
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_device_validate_submission(batch_count, batches));
+  iree_hal_device_profile_submission(device, batch_count, batches);
   iree_status_t status = _VTABLE_DISPATCH(device, queue_submit)(
       device, command_categories, queue_affinity, batch_count, batches);
   IREE_TRACE_ZONE_END(z0);
@@ -304,6 +329,7 @@ IREE_API_EXPORT iree_status_t iree_hal_device_submit_and_wait(
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_device_validate_submission(batch_count, batches));
+  iree_hal_device_profile_submission(device, batch_count, batches);
   iree_status_t status = _VTABLE_DISPATCH(device, submit_and_wait)(
       device, command_categories, queue_affinity, batch_count, batches,
       wait_semaphore, wait_value, timeout);
@@ -317,8 +343,12 @@ IREE_API_EXPORT iree_status_t iree_hal_device_wait_semaphores(
   IREE_ASSERT_ARGUMENT(device);
   if (!semaphore_list || semaphore_list->count == 0) return iree_ok_status();
   IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_device_profile_wait(IREE_PROFILER_EVENT_TYPE_WAIT_BEGIN, device,
+                               semaphore_list);
   iree_status_t status = _VTABLE_DISPATCH(device, wait_semaphores)(
       device, wait_mode, semaphore_list, timeout);
+  iree_hal_device_profile_wait(IREE_PROFILER_EVENT_TYPE_WAIT_END, device,
+                               semaphore_list);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
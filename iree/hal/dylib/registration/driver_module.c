@@ -11,6 +11,7 @@
 
 #include "iree/base/api.h"
 #include "iree/base/internal/flags.h"
+#include "iree/hal/local/executable_imports.h"
 #include "iree/hal/local/executable_loader.h"
 #include "iree/hal/local/loaders/embedded_library_loader.h"
 #include "iree/hal/local/loaders/system_library_loader.h"
@@ -62,12 +63,12 @@ static iree_status_t iree_hal_dylib_driver_factory_try_create(
   iree_host_size_t loader_count = 0;
   if (iree_status_is_ok(status)) {
     status = iree_hal_embedded_library_loader_create(
-        iree_hal_executable_import_provider_null(), host_allocator,
+        iree_hal_executable_host_import_provider_default(), host_allocator,
         &loaders[loader_count++]);
   }
   if (iree_status_is_ok(status)) {
     status = iree_hal_system_library_loader_create(
-        iree_hal_executable_import_provider_null(), host_allocator,
+        iree_hal_executable_host_import_provider_default(), host_allocator,
         &loaders[loader_count++]);
   }
 
@@ -14,6 +14,14 @@
 #include "iree/hal/local/elf/arch.h"
 #include "iree/hal/local/elf/platform.h"
 
+// IREE_ELF_LARGE_PAGES can be defined externally to 0 to always load modules
+// into normal pages. Otherwise modules spanning at least one large page are
+// reserved with IREE_MEMORY_VIEW_FLAG_LARGE_PAGES so that large code and data
+// segments can be backed by large pages where the platform supports it.
+#if !defined(IREE_ELF_LARGE_PAGES)
+#define IREE_ELF_LARGE_PAGES 1
+#endif  // !IREE_ELF_LARGE_PAGES
+
 //==============================================================================
 // Verification and section/info caching
 //==============================================================================
@@ -31,6 +39,9 @@ typedef struct iree_elf_module_load_state_t {
   iree_elf_addr_t init;               // DT_INIT
   const iree_elf_addr_t* init_array;  // DT_INIT_ARRAY
   iree_host_size_t init_array_count;  // DT_INIT_ARRAYSZ
+
+  // True if any of DT_RELSZ/DT_RELASZ/DT_PLTRELSZ are non-zero.
+  bool has_relocations;
 } iree_elf_module_load_state_t;
 
 // Verifies the ELF file header and machine class.
@@ -241,11 +252,20 @@ static iree_status_t iree_elf_module_load_segments(
 
   // Reserve virtual address space in the host memory space. This memory is
   // uncommitted by default as the ELF may only sparsely use the address space.
+  // Modules large enough to fill a large page get a large page aligned base so
+  // that the interiors of their segments can be backed by large pages.
   module->vaddr_size = iree_page_align_end(
       vaddr_range.length, load_state->memory_info.normal_page_size);
-  IREE_RETURN_IF_ERROR(iree_memory_view_reserve(
-      IREE_MEMORY_VIEW_FLAG_MAY_EXECUTE, module->vaddr_size,
-      module->host_allocator, (void**)&module->vaddr_base));
+  iree_memory_view_flags_t view_flags = IREE_MEMORY_VIEW_FLAG_MAY_EXECUTE;
+  const iree_memory_info_t* memory_info = &load_state->memory_info;
+  if (IREE_ELF_LARGE_PAGES &&
+      memory_info->large_page_granularity > memory_info->normal_page_size &&
+      module->vaddr_size >= memory_info->large_page_granularity) {
+    view_flags |= IREE_MEMORY_VIEW_FLAG_LARGE_PAGES;
+  }
+  IREE_RETURN_IF_ERROR(iree_memory_view_reserve(view_flags, module->vaddr_size,
+                                                module->host_allocator,
+                                                (void**)&module->vaddr_base));
   module->vaddr_bias = module->vaddr_base - vaddr_range.offset;
 
   // Commit and load all of the segments.
@@ -288,6 +308,62 @@ static iree_status_t iree_elf_module_load_segments(
   return iree_ok_status();
 }
 
+// Returns true if the ELF can execute in place from |mapped_data|.
+// This requires that every DT_LOAD segment is laid out in the file exactly as
+// it is in memory (such as produced by lld -z separate-loadable-segments) and
+// that no two segments share a host page so that their protection can be
+// changed independently.
+static bool iree_elf_module_can_map_in_place(
+    iree_byte_span_t mapped_data, iree_elf_module_load_state_t* load_state) {
+  iree_host_size_t page_size = load_state->memory_info.normal_page_size;
+  if ((uintptr_t)mapped_data.data % page_size != 0) return false;
+  // NOTE: PT_LOAD segments are sorted by p_vaddr per the spec.
+  iree_elf_addr_t prev_page_end = IREE_ELF_ADDR_MIN;
+  for (iree_elf_half_t i = 0; i < load_state->ehdr->e_phnum; ++i) {
+    const iree_elf_phdr_t* phdr = &load_state->phdr_table[i];
+    if (phdr->p_type != IREE_ELF_PT_LOAD) continue;
+    if (phdr->p_offset != phdr->p_vaddr || phdr->p_filesz != phdr->p_memsz ||
+        iree_page_align_start(phdr->p_vaddr, page_size) < prev_page_end) {
+      return false;
+    }
+    prev_page_end =
+        iree_page_align_end(phdr->p_vaddr + phdr->p_memsz, page_size);
+  }
+  return true;
+}
+
+// Uses the DT_LOAD segments directly from |mapped_data| instead of loading
+// them into a new host virtual address space reservation.
+static void iree_elf_module_map_segments_in_place(
+    iree_byte_span_t mapped_data, iree_elf_module_load_state_t* load_state,
+    iree_elf_module_t* module) {
+  iree_byte_range_t vaddr_range =
+      iree_elf_module_calculate_vaddr_range(load_state);
+  module->is_in_place = true;
+  module->vaddr_base = mapped_data.data + vaddr_range.offset;
+  module->vaddr_size = vaddr_range.length;
+  module->vaddr_bias = mapped_data.data;
+}
+
+// Makes all DT_LOAD segments writeable so that relocations can be applied.
+// Only needed when executing in place as loaded segments are committed with
+// write access.
+static iree_status_t iree_elf_module_unprotect_segments(
+    iree_elf_module_load_state_t* load_state, iree_elf_module_t* module) {
+  for (iree_elf_half_t i = 0; i < load_state->ehdr->e_phnum; ++i) {
+    const iree_elf_phdr_t* phdr = &load_state->phdr_table[i];
+    if (phdr->p_type != IREE_ELF_PT_LOAD) continue;
+    iree_byte_range_t byte_range = {
+        .offset = phdr->p_vaddr,
+        .length = phdr->p_memsz,
+    };
+    IREE_RETURN_IF_ERROR(iree_memory_view_protect_ranges(
+        module->vaddr_bias, 1, &byte_range,
+        IREE_MEMORY_ACCESS_READ | IREE_MEMORY_ACCESS_WRITE));
+  }
+  return iree_ok_status();
+}
+
 // Applies segment memory protection attributes.
 // This will make pages read-only and must only be performed after relocation
 // (which writes to pages of all types). Executable pages will be flushed from
@@ -349,8 +425,9 @@ static iree_status_t iree_elf_module_protect_segments(
 // Unloads the ELF segments from memory and releases the host virtual address
 // space reservation.
 static void iree_elf_module_unload_segments(iree_elf_module_t* module) {
-  // Decommit/unreserve the entire memory space.
-  if (module->vaddr_base != NULL) {
+  // Decommit/unreserve the entire memory space. Modules executing in place do
+  // not own their memory and the pages retain their final protection.
+  if (module->vaddr_base != NULL && !module->is_in_place) {
     iree_memory_view_release(module->vaddr_base, module->vaddr_size,
                              module->host_allocator);
   }
@@ -433,6 +510,11 @@ static iree_status_t iree_elf_module_parse_dynamic_tables(
         load_state->init_array_count = dyn->d_un.d_val;
         break;
 
+      case IREE_ELF_DT_RELSZ:
+      case IREE_ELF_DT_RELASZ:
+      case IREE_ELF_DT_PLTRELSZ:
+        if (dyn->d_un.d_val != 0) load_state->has_relocations = true;
+        break;
       case IREE_ELF_DT_RELENT:
         if (dyn->d_un.d_val != sizeof(iree_elf_rel_t)) {
           return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
@@ -493,6 +575,9 @@ static iree_status_t iree_elf_module_verify_no_imports(
 // Applies symbol and address base relocations to the loaded sections.
 static iree_status_t iree_elf_module_apply_relocations(
     iree_elf_module_load_state_t* load_state, iree_elf_module_t* module) {
+  // Relocation-free modules (no data pointers) need no fixups at all.
+  if (!load_state->has_relocations) return iree_ok_status();
+
   // Redirect to the architecture-specific handler.
   iree_elf_relocation_state_t reloc_state;
   memset(&reloc_state, 0, sizeof(reloc_state));
@@ -569,14 +654,12 @@ static const iree_elf_sym_t* iree_elf_module_lookup_global_symbol(
 // API
 //==============================================================================
 
-iree_status_t iree_elf_module_initialize_from_memory(
-    iree_const_byte_span_t raw_data,
+// Initializes |out_module| from |raw_data|. If |mapped_data| is non-empty it
+// aliases |raw_data| and the segments execute in place when possible.
+static iree_status_t iree_elf_module_initialize(
+    iree_const_byte_span_t raw_data, iree_byte_span_t mapped_data,
     const iree_elf_import_table_t* import_table,
     iree_allocator_t host_allocator, iree_elf_module_t* out_module) {
-  IREE_ASSERT_ARGUMENT(raw_data.data);
-  IREE_ASSERT_ARGUMENT(out_module);
-  IREE_TRACE_ZONE_BEGIN(z0);
-
   // Parse the ELF headers and verify that it's something we can handle.
   // Temporary state required during loading such as references to subtables
   // within the ELF are tracked here on the stack while persistent fields are
@@ -586,10 +669,17 @@ iree_status_t iree_elf_module_initialize_from_memory(
       iree_elf_module_parse_headers(raw_data, &load_state, out_module);
   out_module->host_allocator = host_allocator;
 
-  // Allocate and load the ELF into memory.
+  // Use the mapped segments directly when the layout allows it or otherwise
+  // allocate and load the ELF into memory.
   iree_memory_jit_context_begin();
   if (iree_status_is_ok(status)) {
-    status = iree_elf_module_load_segments(raw_data, &load_state, out_module);
+    if (mapped_data.data &&
+        iree_elf_module_can_map_in_place(mapped_data, &load_state)) {
+      iree_elf_module_map_segments_in_place(mapped_data, &load_state,
+                                            out_module);
+    } else {
+      status = iree_elf_module_load_segments(raw_data, &load_state, out_module);
+    }
   }
 
   // Parse required dynamic symbol tables in loaded memory. These are used for
@@ -604,7 +694,12 @@ iree_status_t iree_elf_module_initialize_from_memory(
     status = iree_elf_module_verify_no_imports(&load_state, out_module);
   }
 
-  // Apply relocations to the loaded pages.
+  // Apply relocations to the loaded pages. Pages used in place must first be
+  // made writeable; relocation-free modules leave them untouched.
+  if (iree_status_is_ok(status) && out_module->is_in_place &&
+      load_state.has_relocations) {
+    status = iree_elf_module_unprotect_segments(&load_state, out_module);
+  }
   if (iree_status_is_ok(status)) {
     status = iree_elf_module_apply_relocations(&load_state, out_module);
   }
@@ -626,6 +721,32 @@ iree_status_t iree_elf_module_initialize_from_memory(
     // memory during the partial initialization.
     iree_elf_module_deinitialize(out_module);
   }
+  return status;
+}
+
+iree_status_t iree_elf_module_initialize_from_memory(
+    iree_const_byte_span_t raw_data,
+    const iree_elf_import_table_t* import_table,
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module) {
+  IREE_ASSERT_ARGUMENT(raw_data.data);
+  IREE_ASSERT_ARGUMENT(out_module);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_elf_module_initialize(
+      raw_data, iree_make_byte_span(NULL, 0), import_table, host_allocator,
+      out_module);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_elf_module_initialize_from_mapped_memory(
+    iree_byte_span_t mapped_data, const iree_elf_import_table_t* import_table,
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module) {
+  IREE_ASSERT_ARGUMENT(mapped_data.data);
+  IREE_ASSERT_ARGUMENT(out_module);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_elf_module_initialize(
+      iree_make_const_byte_span(mapped_data.data, mapped_data.data_length),
+      mapped_data, import_table, host_allocator, out_module);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
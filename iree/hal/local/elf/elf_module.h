@@ -49,6 +49,11 @@ typedef struct iree_elf_module_t {
   // host page granularity was larger than the ELF's defined granularity.
   uint8_t* vaddr_bias;
 
+  // True if the module executes in place from the memory it was initialized
+  // from with iree_elf_module_initialize_from_mapped_memory and does not own
+  // the virtual address range.
+  bool is_in_place;
+
   // Dynamic symbol string table (.dynstr).
   const char* dynstr;            // DT_STRTAB
   iree_host_size_t dynstr_size;  // DT_STRSZ (bytes)
@@ -77,6 +82,24 @@ iree_status_t iree_elf_module_initialize_from_memory(
     const iree_elf_import_table_t* import_table,
     iree_allocator_t host_allocator, iree_elf_module_t* out_module);
 
+// Initializes an ELF module from the ELF |mapped_data| in memory executing it
+// in place when possible. This avoids allocating and copying the segments and
+// when the ELF is relocation-free also avoids writing to any of the pages.
+//
+// In-place execution requires that |mapped_data| is aligned to the host page
+// size and that the segments are laid out in the file as they are in memory
+// starting on host page boundaries (such as ELFs produced with
+// --iree-llvm-embedded-linker-identity-layout). Other ELFs are loaded as with
+// iree_elf_module_initialize_from_memory.
+//
+// |mapped_data| must remain valid until the module is deinitialized and the
+// protection of its pages may be changed as it is treated as owned by the
+// module. File mappings should be private (copy-on-write) so that relocations
+// only dirty the pages they touch.
+iree_status_t iree_elf_module_initialize_from_mapped_memory(
+    iree_byte_span_t mapped_data, const iree_elf_import_table_t* import_table,
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module);
+
 // Deinitializes a |module|, releasing any allocated executable or data pages.
 // Invalidates all symbol pointers previous retrieved from the module and any
 // pointer to data that may have been in the module text or rwdata.
@@ -50,15 +50,20 @@ static iree_status_t query_arch_test_file_data(
                           "the application for the current target platform");
 }
 
-static iree_status_t run_test() {
-  iree_const_byte_span_t file_data;
-  IREE_RETURN_IF_ERROR(query_arch_test_file_data(&file_data));
-
+// Runs the test module with the ELF loaded from |file_data| or, if
+// |mapped_data| is provided, from mapped memory.
+static iree_status_t run_test(iree_const_byte_span_t file_data,
+                              iree_byte_span_t mapped_data) {
   iree_elf_import_table_t import_table;
   memset(&import_table, 0, sizeof(import_table));
   iree_elf_module_t module;
-  IREE_RETURN_IF_ERROR(iree_elf_module_initialize_from_memory(
-      file_data, &import_table, iree_allocator_system(), &module));
+  if (mapped_data.data) {
+    IREE_RETURN_IF_ERROR(iree_elf_module_initialize_from_mapped_memory(
+        mapped_data, &import_table, iree_allocator_system(), &module));
+  } else {
+    IREE_RETURN_IF_ERROR(iree_elf_module_initialize_from_memory(
+        file_data, &import_table, iree_allocator_system(), &module));
+  }
 
   void* query_fn_ptr = NULL;
   IREE_RETURN_IF_ERROR(iree_elf_module_lookup_export(
@@ -71,7 +76,7 @@ static iree_status_t run_test() {
   library.header =
       (const iree_hal_executable_library_header_t**)iree_elf_call_p_ip(
           query_fn_ptr, IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
-          /*reserved=*/NULL);
+          /*environment=*/NULL);
   if (library.header == NULL) {
     return iree_make_status(IREE_STATUS_NOT_FOUND, "library header is empty");
   }
@@ -142,8 +147,24 @@ static iree_status_t run_test() {
   return status;
 }
 
+static iree_status_t run_tests() {
+  iree_const_byte_span_t file_data;
+  IREE_RETURN_IF_ERROR(query_arch_test_file_data(&file_data));
+  IREE_RETURN_IF_ERROR(run_test(file_data, iree_make_byte_span(NULL, 0)));
+
+  // Mapped memory is owned by the module and needs to be mutable. The embedded
+  // test files are not laid out for in-place execution and get loaded.
+  iree_byte_span_t mapped_data =
+      iree_make_byte_span(NULL, file_data.data_length);
+  IREE_RETURN_IF_ERROR(iree_allocator_clone(iree_allocator_system(), file_data,
+                                            (void**)&mapped_data.data));
+  iree_status_t status = run_test(file_data, mapped_data);
+  iree_allocator_free(iree_allocator_system(), mapped_data.data);
+  return status;
+}
+
 int main() {
-  const iree_status_t result = run_test();
+  const iree_status_t result = run_tests();
   int ret = (int)iree_status_code(result);
   if (!iree_status_is_ok(result)) {
     iree_status_fprint(stderr, result);
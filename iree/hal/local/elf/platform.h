@@ -72,7 +72,8 @@ typedef struct iree_memory_info_t {
 
   // The minimum page size and granularity for large pages or 0 if unavailable.
   // To use large pages the size and alignment must be a multiple of this value
-  // and the IREE_MEMORY_VIEW_FLAG_LARGE_PAGES must be set.
+  // and the IREE_MEMORY_VIEW_FLAG_LARGE_PAGES must be set. May be equal to the
+  // normal page size if large pages are not supported.
   iree_host_size_t large_page_granularity;
 
   // Indicates whether executable pages may be allocated within the process.
@@ -128,6 +129,11 @@ enum iree_memory_view_flag_bits_t {
   // Indicates that the memory may be used to execute code.
   // May be used to ask for special privileges (like MAP_JIT on MacOS).
   IREE_MEMORY_VIEW_FLAG_MAY_EXECUTE = 1u << 10,
+
+  // Requests that the view be backed by large pages to reduce TLB pressure.
+  // The reservation will be aligned to the large page granularity. This is a
+  // hint: platforms or systems without support use normal pages.
+  IREE_MEMORY_VIEW_FLAG_LARGE_PAGES = 1u << 11,
 };
 typedef uint32_t iree_memory_view_flags_t;
 
@@ -153,7 +159,7 @@ void iree_memory_view_release(void* base_address, iree_host_size_t total_length,
 // Commits pages overlapping the byte ranges defined by |byte_ranges|.
 // Ranges will be adjusted to the page granularity of the view.
 //
-// Implemented by VirtualAlloc+MEM_COMMIT/mmap+!PROT_NONE.
+// Implemented by VirtualAlloc+MEM_COMMIT/mprotect+!PROT_NONE.
 iree_status_t iree_memory_view_commit_ranges(
     void* base_address, iree_host_size_t range_count,
     const iree_byte_range_t* ranges, iree_memory_access_t initial_access);
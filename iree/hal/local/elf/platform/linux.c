@@ -14,6 +14,9 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+// Size of transparent huge pages used for IREE_MEMORY_VIEW_FLAG_LARGE_PAGES.
+#define IREE_MEMORY_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
 //==============================================================================
 // Memory subsystem information and control
 //==============================================================================
@@ -25,14 +28,14 @@ void iree_memory_query_info(iree_memory_info_t* out_info) {
   out_info->normal_page_size = page_size;
   out_info->normal_page_granularity = page_size;
 
-  // Large pages arent't currently used so we aren't introducing the build goo
-  // to detect and use them yet.
-  // https://linux.die.net/man/3/gethugepagesizes
-  // http://manpages.ubuntu.com/manpages/bionic/man3/gethugepagesize.3.html
-  // Would be:
-  //   #include <hugetlbfs.h>
-  //   out_info->large_page_granularity = gethugepagesize();
+  // Large pages are transparent huge pages requested with madvise. These are
+  // PMD-sized (2MB) on all architectures we care about. We don't use hugetlbfs
+  // as it requires pools to be reserved by the system administrator.
+#if defined(MADV_HUGEPAGE)
+  out_info->large_page_granularity = IREE_MEMORY_HUGE_PAGE_SIZE;
+#else
   out_info->large_page_granularity = page_size;
+#endif  // MADV_HUGEPAGE
 
   out_info->can_allocate_executable_pages = true;
 }
@@ -63,13 +66,43 @@ iree_status_t iree_memory_view_reserve(iree_memory_view_flags_t flags,
   int mmap_prot = PROT_NONE;
   int mmap_flags = MAP_PRIVATE | MAP_ANON | MAP_NORESERVE;
 
+  // Huge pages can only back huge page aligned ranges so we over-reserve and
+  // trim the reservation to the required alignment.
+  iree_host_size_t alignment = getpagesize();
+#if defined(MADV_HUGEPAGE)
+  if (flags & IREE_MEMORY_VIEW_FLAG_LARGE_PAGES) {
+    alignment = IREE_MEMORY_HUGE_PAGE_SIZE;
+  }
+#endif  // MADV_HUGEPAGE
+  iree_host_size_t reserved_length = total_length;
+  if (alignment > (iree_host_size_t)getpagesize()) {
+    reserved_length += alignment;
+  }
+
   iree_status_t status = iree_ok_status();
-  void* base_address = mmap(NULL, total_length, mmap_prot, mmap_flags, -1, 0);
+  uint8_t* base_address =
+      mmap(NULL, reserved_length, mmap_prot, mmap_flags, -1, 0);
   if (base_address == MAP_FAILED) {
+    base_address = NULL;
     status = iree_make_status(iree_status_code_from_errno(errno),
                               "mmap reservation failed");
   }
 
+  if (iree_status_is_ok(status) && reserved_length != total_length) {
+    uint8_t* aligned_address =
+        (uint8_t*)iree_host_align((uintptr_t)base_address, alignment);
+    iree_host_size_t head_length = aligned_address - base_address;
+    iree_host_size_t tail_length = reserved_length - head_length - total_length;
+    if (head_length) munmap(base_address, head_length);
+    if (tail_length) munmap(aligned_address + total_length, tail_length);
+    base_address = aligned_address;
+#if defined(MADV_HUGEPAGE)
+    // Best-effort: the memory works either way, just with more TLB misses.
+    // The advice applies to the pages later committed within the reservation.
+    madvise(base_address, total_length, MADV_HUGEPAGE);
+#endif  // MADV_HUGEPAGE
+  }
+
   *out_base_address = base_address;
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -91,19 +124,20 @@ iree_status_t iree_memory_view_commit_ranges(
   IREE_TRACE_ZONE_BEGIN(z0);
 
   int mmap_prot = iree_memory_access_to_prot(initial_access);
-  int mmap_flags = MAP_PRIVATE | MAP_ANON | MAP_FIXED;
 
+  // NOTE: the pages of the reservation are committed in place (instead of
+  // being remapped) so that they retain any advice given to the reservation.
+  // Pages are only backed by memory once touched.
   iree_status_t status = iree_ok_status();
   for (iree_host_size_t i = 0; i < range_count; ++i) {
     void* range_start = NULL;
     iree_host_size_t aligned_length = 0;
     iree_page_align_range(base_address, ranges[i], getpagesize(), &range_start,
                           &aligned_length);
-    void* result =
-        mmap(range_start, aligned_length, mmap_prot, mmap_flags, -1, 0);
-    if (result == MAP_FAILED) {
+    int ret = mprotect(range_start, aligned_length, mmap_prot);
+    if (ret != 0) {
       status = iree_make_status(iree_status_code_from_errno(errno),
-                                "mmap commit failed");
+                                "mprotect commit failed");
       break;
     }
   }
@@ -0,0 +1,251 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/executable_environment.h"
+
+#include <string.h>
+
+#if defined(IREE_ARCH_X86_64)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // _MSC_VER
+#elif defined(IREE_ARCH_ARM_64)
+#if defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID)
+#include <sys/auxv.h>
+#elif defined(IREE_PLATFORM_APPLE)
+#include <sys/sysctl.h>
+#endif  // IREE_PLATFORM_*
+#endif  // IREE_ARCH_*
+
+//===----------------------------------------------------------------------===//
+// Feature names
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_executable_library_feature_name_t {
+  iree_hal_executable_library_features_t feature;
+  const char* name;
+} iree_hal_executable_library_feature_name_t;
+
+// Canonical names of each feature bit. The compiler emits the same names when
+// building conditions for selecting executable variants.
+static const iree_hal_executable_library_feature_name_t
+    iree_hal_executable_library_feature_names[] = {
+        {IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_SSE4_2, "x86_64.sse4_2"},
+        {IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_AVX2_FMA,
+         "x86_64.avx2_fma"},
+        {IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_AVX512, "x86_64.avx512"},
+        {IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_DOTPROD, "arm_64.dotprod"},
+        {IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_I8MM, "arm_64.i8mm"},
+        {IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_SVE, "arm_64.sve"},
+};
+
+iree_hal_executable_library_features_t
+iree_hal_executable_library_feature_from_name(iree_string_view_t name) {
+  for (iree_host_size_t i = 0;
+       i < IREE_ARRAYSIZE(iree_hal_executable_library_feature_names); ++i) {
+    if (iree_string_view_equal(
+            name, iree_make_cstring_view(
+                      iree_hal_executable_library_feature_names[i].name))) {
+      return iree_hal_executable_library_feature_names[i].feature;
+    }
+  }
+  return IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE;
+}
+
+static const char* iree_hal_executable_library_feature_name(
+    iree_hal_executable_library_features_t features) {
+  for (iree_host_size_t i = 0;
+       i < IREE_ARRAYSIZE(iree_hal_executable_library_feature_names); ++i) {
+    const iree_hal_executable_library_feature_name_t* entry =
+        &iree_hal_executable_library_feature_names[i];
+    if (iree_any_bit_set(features, entry->feature)) return entry->name;
+  }
+  return "unknown";
+}
+
+//===----------------------------------------------------------------------===//
+// Host feature detection
+//===----------------------------------------------------------------------===//
+
+#if defined(IREE_ARCH_X86_64)
+
+static void iree_hal_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* out_eax,
+                           uint32_t* out_ebx, uint32_t* out_ecx,
+                           uint32_t* out_edx) {
+#if defined(_MSC_VER)
+  int regs[4] = {0};
+  __cpuidex(regs, (int)leaf, (int)subleaf);
+  *out_eax = (uint32_t)regs[0];
+  *out_ebx = (uint32_t)regs[1];
+  *out_ecx = (uint32_t)regs[2];
+  *out_edx = (uint32_t)regs[3];
+#else
+  __cpuid_count(leaf, subleaf, *out_eax, *out_ebx, *out_ecx, *out_edx);
+#endif  // _MSC_VER
+}
+
+// Returns the XCR0 register indicating which register state the OS saves.
+// Only valid to call if CPUID reports OSXSAVE.
+static uint64_t iree_hal_xgetbv0(void) {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+#endif  // _MSC_VER
+}
+
+static iree_hal_executable_library_features_t
+iree_hal_executable_environment_query_processor_features(void) {
+  iree_hal_executable_library_features_t features =
+      IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE;
+
+  uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+  iree_hal_cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+  const uint32_t max_leaf = eax;
+  if (max_leaf < 1) return features;
+
+  iree_hal_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+  // SSSE3, SSE4.1, SSE4.2, POPCNT.
+  const uint32_t sse4_2_mask =
+      (1u << 9) | (1u << 19) | (1u << 20) | (1u << 23);
+  if ((ecx & sse4_2_mask) == sse4_2_mask) {
+    features |= IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_SSE4_2;
+  }
+  const bool has_fma = (ecx >> 12) & 1;
+  const bool has_osxsave = (ecx >> 27) & 1;
+  const bool has_avx = (ecx >> 28) & 1;
+  if (!has_osxsave || !has_avx) return features;
+
+  // The processor supporting an extension is not enough: the OS must also
+  // save/restore the wider register state across context switches.
+  const uint64_t xcr0 = iree_hal_xgetbv0();
+  const bool os_saves_ymm = (xcr0 & 0x06) == 0x06;
+  const bool os_saves_zmm = (xcr0 & 0xE6) == 0xE6;
+  if (!os_saves_ymm || max_leaf < 7) return features;
+
+  iree_hal_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+  const bool has_avx2 = (ebx >> 5) & 1;
+  if (has_avx2 && has_fma) {
+    features |= IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_AVX2_FMA;
+  }
+
+  // F, DQ, CD, BW, VL: the common subset since Skylake-SP.
+  const uint32_t avx512_mask =
+      (1u << 16) | (1u << 17) | (1u << 28) | (1u << 30) | (1u << 31);
+  if (os_saves_zmm && (ebx & avx512_mask) == avx512_mask) {
+    features |= IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_AVX512;
+  }
+
+  return features;
+}
+
+#elif defined(IREE_ARCH_ARM_64) && \
+    (defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID))
+
+// Values from the Linux kernel arch/arm64/include/uapi/asm/hwcap.h; defined
+// here as older libc headers may not declare them.
+#define IREE_HAL_ARM64_HWCAP_ASIMDDP (1ul << 20)
+#define IREE_HAL_ARM64_HWCAP_SVE (1ul << 22)
+#define IREE_HAL_ARM64_HWCAP2_I8MM (1ul << 13)
+#if !defined(AT_HWCAP2)
+#define AT_HWCAP2 26
+#endif  // !AT_HWCAP2
+
+static iree_hal_executable_library_features_t
+iree_hal_executable_environment_query_processor_features(void) {
+  iree_hal_executable_library_features_t features =
+      IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE;
+  const unsigned long hwcap = getauxval(AT_HWCAP);
+  const unsigned long hwcap2 = getauxval(AT_HWCAP2);
+  if (hwcap & IREE_HAL_ARM64_HWCAP_ASIMDDP) {
+    features |= IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_DOTPROD;
+  }
+  if (hwcap2 & IREE_HAL_ARM64_HWCAP2_I8MM) {
+    features |= IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_I8MM;
+  }
+  if (hwcap & IREE_HAL_ARM64_HWCAP_SVE) {
+    features |= IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_SVE;
+  }
+  return features;
+}
+
+#elif defined(IREE_ARCH_ARM_64) && defined(IREE_PLATFORM_APPLE)
+
+static bool iree_hal_sysctl_flag(const char* name) {
+  int value = 0;
+  size_t value_size = sizeof(value);
+  if (sysctlbyname(name, &value, &value_size, NULL, 0) != 0) return false;
+  return value != 0;
+}
+
+static iree_hal_executable_library_features_t
+iree_hal_executable_environment_query_processor_features(void) {
+  iree_hal_executable_library_features_t features =
+      IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE;
+  if (iree_hal_sysctl_flag("hw.optional.arm.FEAT_DotProd")) {
+    features |= IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_DOTPROD;
+  }
+  if (iree_hal_sysctl_flag("hw.optional.arm.FEAT_I8MM")) {
+    features |= IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_I8MM;
+  }
+  return features;
+}
+
+#else
+
+// TODO: query features on other platforms (Windows on arm64 via
+// IsProcessorFeaturePresent, RISC-V extensions, etc).
+static iree_hal_executable_library_features_t
+iree_hal_executable_environment_query_processor_features(void) {
+  return IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE;
+}
+
+#endif  // IREE_ARCH_*
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_environment_v0_t
+//===----------------------------------------------------------------------===//
+
+void iree_hal_executable_environment_initialize(
+    iree_hal_executable_environment_v0_t* out_environment) {
+  IREE_ASSERT_ARGUMENT(out_environment);
+  memset(out_environment, 0, sizeof(*out_environment));
+  out_environment->supported_features =
+      iree_hal_executable_environment_query_processor_features();
+}
+
+bool iree_hal_executable_environment_supports_feature(
+    const iree_hal_executable_environment_v0_t* environment,
+    iree_string_view_t name) {
+  IREE_ASSERT_ARGUMENT(environment);
+  iree_hal_executable_library_features_t feature =
+      iree_hal_executable_library_feature_from_name(name);
+  return feature != IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE &&
+         iree_all_bits_set(environment->supported_features, feature);
+}
+
+iree_status_t iree_hal_executable_environment_verify_library(
+    const iree_hal_executable_environment_v0_t* environment,
+    const iree_hal_executable_library_header_t* header) {
+  IREE_ASSERT_ARGUMENT(environment);
+  IREE_ASSERT_ARGUMENT(header);
+  iree_hal_executable_library_features_t missing_features =
+      header->features & ~environment->supported_features;
+  if (IREE_UNLIKELY(missing_features)) {
+    return iree_make_status(
+        IREE_STATUS_UNAVAILABLE,
+        "executable library '%s' requires processor features not supported "
+        "by the host (missing 0x%08X, including '%s'); compile with a variant "
+        "targeting a less specialized processor",
+        header->name ? header->name : "", missing_features,
+        iree_hal_executable_library_feature_name(missing_features));
+  }
+  return iree_ok_status();
+}
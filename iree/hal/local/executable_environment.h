@@ -0,0 +1,53 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_EXECUTABLE_ENVIRONMENT_H_
+#define IREE_HAL_LOCAL_EXECUTABLE_ENVIRONMENT_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/local/executable_library.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_environment_v0_t
+//===----------------------------------------------------------------------===//
+
+// Initializes |out_environment| to describe the host the runtime is executing
+// on. Processor features are queried from the hardware (CPUID on x86-64) or
+// the OS (HWCAP/sysctl on arm64). Features that cannot be detected on the
+// current platform are reported as unsupported.
+void iree_hal_executable_environment_initialize(
+    iree_hal_executable_environment_v0_t* out_environment);
+
+// Returns the library feature bit with the given canonical |name| (such as
+// `x86_64.avx512` or `arm_64.dotprod`) or
+// IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE if the name is not recognized.
+// These names are used by compiled programs when querying the
+// `hal.device.feature` category to select between executable variants.
+iree_hal_executable_library_features_t
+iree_hal_executable_library_feature_from_name(iree_string_view_t name);
+
+// Returns true if |environment| supports the feature with the given canonical
+// |name|. Unknown feature names are reported as unsupported.
+bool iree_hal_executable_environment_supports_feature(
+    const iree_hal_executable_environment_v0_t* environment,
+    iree_string_view_t name);
+
+// Verifies that all processor features required by the library |header| are
+// supported in |environment|. Returns IREE_STATUS_UNAVAILABLE naming the first
+// missing feature if the library cannot be used on the host.
+iree_status_t iree_hal_executable_environment_verify_library(
+    const iree_hal_executable_environment_v0_t* environment,
+    const iree_hal_executable_library_header_t* header);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_EXECUTABLE_ENVIRONMENT_H_
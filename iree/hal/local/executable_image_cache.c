@@ -0,0 +1,162 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/executable_image_cache.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+//===----------------------------------------------------------------------===//
+// Process-wide cache
+//===----------------------------------------------------------------------===//
+
+// The number of distinct executables in a process is small (tens to low
+// hundreds) and lookups only happen when executables are prepared so a list is
+// sufficient.
+typedef struct iree_hal_executable_image_cache_t {
+  iree_slim_mutex_t mutex;
+  iree_host_size_t count;
+  iree_hal_executable_image_t* head;
+} iree_hal_executable_image_cache_t;
+
+static iree_hal_executable_image_cache_t iree_hal_executable_image_cache_;
+static iree_once_flag iree_hal_executable_image_cache_flag_ =
+    IREE_ONCE_FLAG_INIT;
+static void iree_hal_executable_image_cache_initialize(void) {
+  memset(&iree_hal_executable_image_cache_, 0,
+         sizeof(iree_hal_executable_image_cache_));
+  iree_slim_mutex_initialize(&iree_hal_executable_image_cache_.mutex);
+}
+
+static iree_hal_executable_image_cache_t* iree_hal_executable_image_cache(
+    void) {
+  iree_call_once(&iree_hal_executable_image_cache_flag_,
+                 iree_hal_executable_image_cache_initialize);
+  return &iree_hal_executable_image_cache_;
+}
+
+// 64-bit FNV-1a. Executables are hashed once each time they are prepared and
+// this is negligible relative to loading them.
+static uint64_t iree_hal_executable_image_hash(iree_const_byte_span_t data) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (iree_host_size_t i = 0; i < data.data_length; ++i) {
+    hash ^= data.data[i];
+    hash *= 0x100000001B3ull;
+  }
+  return hash;
+}
+
+// Returns a retained image matching the key or NULL if not found.
+// Must be called with the cache lock held.
+static iree_hal_executable_image_t* iree_hal_executable_image_cache_find(
+    iree_hal_executable_image_cache_t* cache, const void* kind,
+    uint64_t content_hash, iree_host_size_t content_length) {
+  for (iree_hal_executable_image_t* image = cache->head; image != NULL;
+       image = image->next) {
+    if (image->kind == kind && image->content_hash == content_hash &&
+        image->content_length == content_length) {
+      ++image->ref_count;
+      return image;
+    }
+  }
+  return NULL;
+}
+
+iree_status_t iree_hal_executable_image_cache_acquire(
+    const void* kind, iree_const_byte_span_t data,
+    iree_hal_executable_image_load_fn_t load_fn, void* user_data,
+    iree_hal_executable_image_t** out_image) {
+  IREE_ASSERT_ARGUMENT(load_fn);
+  IREE_ASSERT_ARGUMENT(out_image);
+  *out_image = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_executable_image_cache_t* cache = iree_hal_executable_image_cache();
+  const uint64_t content_hash = iree_hal_executable_image_hash(data);
+
+  // Fast path: already loaded.
+  iree_slim_mutex_lock(&cache->mutex);
+  iree_hal_executable_image_t* image = iree_hal_executable_image_cache_find(
+      cache, kind, content_hash, data.data_length);
+  iree_slim_mutex_unlock(&cache->mutex);
+  if (image) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "hit");
+    *out_image = image;
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+
+  // Load outside of the lock; this may take a while.
+  iree_hal_executable_image_t* new_image = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(z0,
+                                    load_fn(user_data, data, &new_image));
+  new_image->ref_count = 1;
+  new_image->kind = kind;
+  new_image->content_hash = content_hash;
+  new_image->content_length = data.data_length;
+  new_image->next = NULL;
+
+  // Insert unless another thread beat us to it.
+  iree_slim_mutex_lock(&cache->mutex);
+  image = iree_hal_executable_image_cache_find(cache, kind, content_hash,
+                                              data.data_length);
+  if (!image) {
+    new_image->next = cache->head;
+    cache->head = new_image;
+    ++cache->count;
+    image = new_image;
+    new_image = NULL;
+  }
+  iree_slim_mutex_unlock(&cache->mutex);
+  if (new_image) new_image->destroy(new_image);
+
+  *out_image = image;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_hal_executable_image_retain(iree_hal_executable_image_t* image) {
+  if (!image) return;
+  iree_hal_executable_image_cache_t* cache = iree_hal_executable_image_cache();
+  iree_slim_mutex_lock(&cache->mutex);
+  ++image->ref_count;
+  iree_slim_mutex_unlock(&cache->mutex);
+}
+
+void iree_hal_executable_image_release(iree_hal_executable_image_t* image) {
+  if (!image) return;
+  iree_hal_executable_image_cache_t* cache = iree_hal_executable_image_cache();
+
+  // The count is changed under the lock so that lookups never resurrect an
+  // image that is being destroyed.
+  iree_slim_mutex_lock(&cache->mutex);
+  bool should_destroy = --image->ref_count == 0;
+  if (should_destroy) {
+    iree_hal_executable_image_t** link = &cache->head;
+    while (*link != image) link = &(*link)->next;
+    *link = image->next;
+    --cache->count;
+  }
+  iree_slim_mutex_unlock(&cache->mutex);
+
+  if (should_destroy) {
+    IREE_TRACE_ZONE_BEGIN(z0);
+    image->destroy(image);
+    IREE_TRACE_ZONE_END(z0);
+  }
+}
+
+iree_host_size_t iree_hal_executable_image_cache_count(void) {
+  iree_hal_executable_image_cache_t* cache = iree_hal_executable_image_cache();
+  iree_slim_mutex_lock(&cache->mutex);
+  iree_host_size_t count = cache->count;
+  iree_slim_mutex_unlock(&cache->mutex);
+  return count;
+}
@@ -0,0 +1,93 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_EXECUTABLE_IMAGE_CACHE_H_
+#define IREE_HAL_LOCAL_EXECUTABLE_IMAGE_CACHE_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_image_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_executable_image_t iree_hal_executable_image_t;
+
+typedef void(IREE_API_PTR* iree_hal_executable_image_destroy_fn_t)(
+    iree_hal_executable_image_t* image);
+
+// A loaded executable image (relocated ELF module, dlopen'ed library, etc)
+// shared by all executables created from identical binary contents.
+//
+// Executables themselves are bound to the device-specific layouts they are
+// created with and cannot be shared; the image holds the expensive part of
+// loading that is independent of the device. Loaders define their own image
+// types with this as the first field.
+//
+// Images live in a process-wide cache and must be allocated from
+// iree_allocator_system() (or another allocator that outlives all devices).
+struct iree_hal_executable_image_t {
+  // Guarded by the cache lock; images are only destroyed by the cache.
+  int32_t ref_count;
+
+  // Called when the last reference to the image is released.
+  iree_hal_executable_image_destroy_fn_t destroy;
+
+  // Loader-defined tag partitioning the cache such that different loaders
+  // accepting the same bytes (embedded-elf vs system-elf) don't alias.
+  const void* kind;
+
+  // Cache key derived from the binary contents the image was loaded from.
+  uint64_t content_hash;
+  iree_host_size_t content_length;
+
+  // Intrusive link in the cache list.
+  iree_hal_executable_image_t* next;
+};
+
+// Loads a new image from |data| and returns it in |out_image| with only the
+// |destroy| field populated (the remaining fields are owned by the cache).
+typedef iree_status_t(IREE_API_PTR* iree_hal_executable_image_load_fn_t)(
+    void* user_data, iree_const_byte_span_t data,
+    iree_hal_executable_image_t** out_image);
+
+// Returns a retained image of the given |kind| loaded from |data| in
+// |out_image|. If an image from identical contents was already loaded in the
+// process it is reused and otherwise |load_fn| is called to load a new one.
+//
+// Images are keyed by a hash of their contents. As executables are trusted
+// code (loading one implies running it) collisions are not guarded against
+// beyond also comparing the content length.
+//
+// Thread-safe. Loading happens outside of the cache lock so that executables
+// with different contents load concurrently; if two threads race loading the
+// same contents one image wins and the other is discarded.
+iree_status_t iree_hal_executable_image_cache_acquire(
+    const void* kind, iree_const_byte_span_t data,
+    iree_hal_executable_image_load_fn_t load_fn, void* user_data,
+    iree_hal_executable_image_t** out_image);
+
+// Retains the given |image| for the caller.
+void iree_hal_executable_image_retain(iree_hal_executable_image_t* image);
+
+// Releases the given |image| from the caller. The image is removed from the
+// cache and destroyed when the last reference is released.
+void iree_hal_executable_image_release(iree_hal_executable_image_t* image);
+
+// Returns the total number of images resident in the process-wide cache.
+// Intended for testing and diagnostics.
+iree_host_size_t iree_hal_executable_image_cache_count(void);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_EXECUTABLE_IMAGE_CACHE_H_
@@ -0,0 +1,142 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/executable_image_cache.h"
+
+#include <cstdint>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using namespace iree::testing::status;
+
+// Test image that counts loads and destroys.
+struct TestImage {
+  iree_hal_executable_image_t base;
+  int* destroy_count;
+};
+
+struct TestLoader {
+  int load_count = 0;
+  int destroy_count = 0;
+};
+
+static void TestImageDestroy(iree_hal_executable_image_t* base_image) {
+  TestImage* image = (TestImage*)base_image;
+  ++*image->destroy_count;
+  iree_allocator_free(iree_allocator_system(), image);
+}
+
+static iree_status_t TestImageLoad(void* user_data,
+                                   iree_const_byte_span_t data,
+                                   iree_hal_executable_image_t** out_image) {
+  TestLoader* loader = (TestLoader*)user_data;
+  TestImage* image = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      iree_allocator_system(), sizeof(*image), (void**)&image));
+  image->base.destroy = TestImageDestroy;
+  image->destroy_count = &loader->destroy_count;
+  ++loader->load_count;
+  *out_image = &image->base;
+  return iree_ok_status();
+}
+
+static iree_status_t FailingImageLoad(void* user_data,
+                                      iree_const_byte_span_t data,
+                                      iree_hal_executable_image_t** out_image) {
+  return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "bad image");
+}
+
+static const char kTestKind = 0;
+static const char kOtherKind = 0;
+
+static iree_const_byte_span_t MakeSpan(const uint8_t* data, size_t length) {
+  return iree_make_const_byte_span(data, length);
+}
+
+TEST(ExecutableImageCacheTest, SharesIdenticalContents) {
+  const uint8_t a[] = {1, 2, 3, 4};
+  const uint8_t a_copy[] = {1, 2, 3, 4};
+  TestLoader loader;
+  iree_host_size_t base_count = iree_hal_executable_image_cache_count();
+
+  iree_hal_executable_image_t* image0 = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_image_cache_acquire(
+      &kTestKind, MakeSpan(a, sizeof(a)), TestImageLoad, &loader, &image0));
+  iree_hal_executable_image_t* image1 = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_image_cache_acquire(
+      &kTestKind, MakeSpan(a_copy, sizeof(a_copy)), TestImageLoad, &loader,
+      &image1));
+  EXPECT_EQ(image0, image1);
+  EXPECT_EQ(1, loader.load_count);
+  EXPECT_EQ(base_count + 1, iree_hal_executable_image_cache_count());
+
+  iree_hal_executable_image_release(image0);
+  EXPECT_EQ(0, loader.destroy_count);
+  iree_hal_executable_image_release(image1);
+  EXPECT_EQ(1, loader.destroy_count);
+  EXPECT_EQ(base_count, iree_hal_executable_image_cache_count());
+}
+
+TEST(ExecutableImageCacheTest, DistinctContentsAndKinds) {
+  const uint8_t a[] = {1, 2, 3, 4};
+  const uint8_t b[] = {4, 3, 2, 1};
+  TestLoader loader;
+
+  iree_hal_executable_image_t* image_a = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_image_cache_acquire(
+      &kTestKind, MakeSpan(a, sizeof(a)), TestImageLoad, &loader, &image_a));
+  iree_hal_executable_image_t* image_b = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_image_cache_acquire(
+      &kTestKind, MakeSpan(b, sizeof(b)), TestImageLoad, &loader, &image_b));
+  iree_hal_executable_image_t* image_other = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_image_cache_acquire(
+      &kOtherKind, MakeSpan(a, sizeof(a)), TestImageLoad, &loader,
+      &image_other));
+  EXPECT_NE(image_a, image_b);
+  EXPECT_NE(image_a, image_other);
+  EXPECT_EQ(3, loader.load_count);
+
+  iree_hal_executable_image_release(image_a);
+  iree_hal_executable_image_release(image_b);
+  iree_hal_executable_image_release(image_other);
+  EXPECT_EQ(3, loader.destroy_count);
+}
+
+TEST(ExecutableImageCacheTest, ReloadsAfterRelease) {
+  const uint8_t a[] = {5, 6, 7};
+  TestLoader loader;
+
+  iree_hal_executable_image_t* image = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_image_cache_acquire(
+      &kTestKind, MakeSpan(a, sizeof(a)), TestImageLoad, &loader, &image));
+  iree_hal_executable_image_retain(image);
+  iree_hal_executable_image_release(image);
+  EXPECT_EQ(0, loader.destroy_count);
+  iree_hal_executable_image_release(image);
+  EXPECT_EQ(1, loader.destroy_count);
+
+  IREE_ASSERT_OK(iree_hal_executable_image_cache_acquire(
+      &kTestKind, MakeSpan(a, sizeof(a)), TestImageLoad, &loader, &image));
+  EXPECT_EQ(2, loader.load_count);
+  iree_hal_executable_image_release(image);
+}
+
+TEST(ExecutableImageCacheTest, LoadFailure) {
+  const uint8_t a[] = {9, 9, 9};
+  iree_host_size_t base_count = iree_hal_executable_image_cache_count();
+  iree_hal_executable_image_t* image = NULL;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_INVALID_ARGUMENT,
+      iree_hal_executable_image_cache_acquire(
+          &kTestKind, MakeSpan(a, sizeof(a)), FailingImageLoad, NULL, &image));
+  EXPECT_EQ(NULL, image);
+  EXPECT_EQ(base_count, iree_hal_executable_image_cache_count());
+}
+
+}  // namespace
@@ -0,0 +1,100 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/executable_imports.h"
+
+#include <string.h>
+
+//===----------------------------------------------------------------------===//
+// Reference host imports
+//===----------------------------------------------------------------------===//
+
+static int iree_hal_memcpy_v0(void* import_params) {
+  const iree_hal_memcpy_v0_params_t* params =
+      (const iree_hal_memcpy_v0_params_t*)import_params;
+  memcpy(params->dst, params->src, params->length);
+  return 0;
+}
+
+static int iree_hal_sgemm_v0(void* import_params) {
+  const iree_hal_sgemm_v0_params_t* params =
+      (const iree_hal_sgemm_v0_params_t*)import_params;
+  // i-k-j order keeps the inner loop contiguous in both |rhs| and |out|.
+  for (size_t i = 0; i < params->m; ++i) {
+    float* out_row = params->out + i * params->out_stride;
+    const float* lhs_row = params->lhs + i * params->lhs_stride;
+    for (size_t k = 0; k < params->k; ++k) {
+      const float lhs_value = lhs_row[k];
+      const float* rhs_row = params->rhs + k * params->rhs_stride;
+      for (size_t j = 0; j < params->n; ++j) {
+        out_row[j] += lhs_value * rhs_row[j];
+      }
+    }
+  }
+  return 0;
+}
+
+static const iree_hal_executable_host_import_t
+    iree_hal_executable_host_imports_default[] = {
+        {"iree_hal_memcpy_v0", iree_hal_memcpy_v0},
+        {"iree_hal_sgemm_v0", iree_hal_sgemm_v0},
+};
+
+static const iree_hal_executable_host_import_table_t
+    iree_hal_executable_host_import_table_default_storage = {
+        IREE_ARRAYSIZE(iree_hal_executable_host_imports_default),
+        iree_hal_executable_host_imports_default,
+        NULL,
+};
+
+const iree_hal_executable_host_import_table_t*
+iree_hal_executable_host_import_table_default(void) {
+  return &iree_hal_executable_host_import_table_default_storage;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_host_import_table_t
+//===----------------------------------------------------------------------===//
+
+iree_hal_executable_import_v0_t iree_hal_executable_host_import_table_lookup(
+    const iree_hal_executable_host_import_table_t* table,
+    iree_string_view_t symbol_name) {
+  for (; table != NULL; table = table->fallback) {
+    for (iree_host_size_t i = 0; i < table->count; ++i) {
+      const iree_hal_executable_host_import_t* import = &table->imports[i];
+      if (iree_string_view_equal(symbol_name,
+                                 iree_make_cstring_view(import->symbol_name))) {
+        return import->fn_ptr;
+      }
+    }
+  }
+  return NULL;
+}
+
+static iree_status_t iree_hal_executable_host_import_provider_resolve(
+    void* self, iree_string_view_t symbol_name, void** out_fn_ptr) {
+  const iree_hal_executable_host_import_table_t* table =
+      (const iree_hal_executable_host_import_table_t*)self;
+  iree_hal_executable_import_v0_t fn_ptr =
+      iree_hal_executable_host_import_table_lookup(table, symbol_name);
+  if (!fn_ptr) {
+    return iree_make_status(IREE_STATUS_NOT_FOUND,
+                            "host import '%.*s' not provided",
+                            (int)symbol_name.size, symbol_name.data);
+  }
+  *out_fn_ptr = (void*)fn_ptr;
+  return iree_ok_status();
+}
+
+iree_hal_executable_import_provider_t
+iree_hal_executable_host_import_provider(
+    const iree_hal_executable_host_import_table_t* table) {
+  iree_hal_executable_import_provider_t provider = {
+      (void*)table,
+      iree_hal_executable_host_import_provider_resolve,
+  };
+  return provider;
+}
@@ -0,0 +1,109 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_EXECUTABLE_IMPORTS_H_
+#define IREE_HAL_LOCAL_EXECUTABLE_IMPORTS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/local/executable_library.h"
+#include "iree/hal/local/executable_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// Host import ABI
+//===----------------------------------------------------------------------===//
+// Functions the runtime makes available to executables through the import
+// table. Each import is called via the dispatch state import_thunk with a
+// pointer to its parameter struct and returns 0 on success.
+//
+// The compiler packs the operands of the import call in declaration order:
+// buffers are passed as a pointer to their first element and index values as
+// pointer-sized integers. The parameter structs below must match that layout
+// and any change to them requires a new versioned symbol name.
+
+// `iree_hal_memcpy_v0`: copies |length| bytes from |src| to |dst|.
+// The ranges must not overlap.
+typedef struct iree_hal_memcpy_v0_params_t {
+  void* dst;
+  const void* src;
+  size_t length;
+} iree_hal_memcpy_v0_params_t;
+
+// `iree_hal_sgemm_v0`: accumulates out[m, n] += lhs[m, k] * rhs[k, n] on
+// row-major f32 matrices. Strides are the number of elements between rows.
+typedef struct iree_hal_sgemm_v0_params_t {
+  float* out;
+  const float* lhs;
+  const float* rhs;
+  size_t m;
+  size_t n;
+  size_t k;
+  size_t out_stride;
+  size_t lhs_stride;
+  size_t rhs_stride;
+} iree_hal_sgemm_v0_params_t;
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_host_import_table_t
+//===----------------------------------------------------------------------===//
+
+// A host function exported to executables under |symbol_name|.
+typedef struct iree_hal_executable_host_import_t {
+  const char* symbol_name;
+  iree_hal_executable_import_v0_t fn_ptr;
+} iree_hal_executable_host_import_t;
+
+// A table of host functions that can be used to resolve executable imports.
+// Tables can be chained so that hand-tuned implementations (vendor BLAS
+// libraries, platform-specific memcpy, etc) can override a subset of the
+// builtin functions by listing them in their own table and using the default
+// table as the |fallback|.
+typedef struct iree_hal_executable_host_import_table_t {
+  // Number of entries in |imports|.
+  iree_host_size_t count;
+  // Functions provided by this table. Lookup is a linear scan.
+  const iree_hal_executable_host_import_t* imports;
+  // Optional table consulted for symbols not present in |imports|.
+  const struct iree_hal_executable_host_import_table_t* fallback;
+} iree_hal_executable_host_import_table_t;
+
+// Returns the table of reference implementations of all host imports declared
+// above. The table is statically allocated and valid for the lifetime of the
+// process.
+const iree_hal_executable_host_import_table_t*
+iree_hal_executable_host_import_table_default(void);
+
+// Returns the function in |table| (or its fallbacks) with the given
+// |symbol_name| or NULL if it is not provided.
+iree_hal_executable_import_v0_t iree_hal_executable_host_import_table_lookup(
+    const iree_hal_executable_host_import_table_t* table,
+    iree_string_view_t symbol_name);
+
+// Returns an import provider that resolves symbols from |table|.
+// The table must remain valid for the lifetime of any loader using the
+// provider.
+iree_hal_executable_import_provider_t
+iree_hal_executable_host_import_provider(
+    const iree_hal_executable_host_import_table_t* table);
+
+// Returns an import provider that resolves symbols from the default table.
+static inline iree_hal_executable_import_provider_t
+iree_hal_executable_host_import_provider_default(void) {
+  return iree_hal_executable_host_import_provider(
+      iree_hal_executable_host_import_table_default());
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_EXECUTABLE_IMPORTS_H_
@@ -0,0 +1,87 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/executable_imports.h"
+
+#include <cstring>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using namespace iree::testing::status;
+
+static void* Resolve(iree_hal_executable_import_provider_t provider,
+                     const char* symbol_name) {
+  void* fn_ptr = NULL;
+  IREE_CHECK_OK(iree_hal_executable_import_provider_resolve(
+      provider, iree_make_cstring_view(symbol_name), &fn_ptr));
+  return fn_ptr;
+}
+
+TEST(ExecutableImportsTest, ResolvesDefaultImports) {
+  auto provider = iree_hal_executable_host_import_provider_default();
+  EXPECT_NE(nullptr, Resolve(provider, "iree_hal_memcpy_v0"));
+  EXPECT_NE(nullptr, Resolve(provider, "iree_hal_sgemm_v0"));
+}
+
+TEST(ExecutableImportsTest, MissingImports) {
+  auto provider = iree_hal_executable_host_import_provider_default();
+  void* fn_ptr = NULL;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_NOT_FOUND,
+      iree_hal_executable_import_provider_resolve(
+          provider, iree_make_cstring_view("iree_hal_unknown_v0"), &fn_ptr));
+  EXPECT_EQ(nullptr, fn_ptr);
+  // Weak imports resolve to NULL.
+  EXPECT_EQ(nullptr, Resolve(provider, "iree_hal_unknown_v0?"));
+}
+
+static int OverrideSgemm(void* params) { return 0; }
+
+TEST(ExecutableImportsTest, OverridesFallBackToDefault) {
+  static const iree_hal_executable_host_import_t overrides[] = {
+      {"iree_hal_sgemm_v0", OverrideSgemm},
+  };
+  iree_hal_executable_host_import_table_t table = {
+      IREE_ARRAYSIZE(overrides), overrides,
+      iree_hal_executable_host_import_table_default()};
+  auto provider = iree_hal_executable_host_import_provider(&table);
+  EXPECT_EQ((void*)OverrideSgemm, Resolve(provider, "iree_hal_sgemm_v0"));
+  EXPECT_EQ(Resolve(iree_hal_executable_host_import_provider_default(),
+                    "iree_hal_memcpy_v0"),
+            Resolve(provider, "iree_hal_memcpy_v0"));
+}
+
+TEST(ExecutableImportsTest, Memcpy) {
+  auto fn = (iree_hal_executable_import_v0_t)Resolve(
+      iree_hal_executable_host_import_provider_default(), "iree_hal_memcpy_v0");
+  const char src[] = "hello";
+  char dst[sizeof(src)] = {0};
+  iree_hal_memcpy_v0_params_t params = {dst, src, sizeof(src)};
+  EXPECT_EQ(0, fn(&params));
+  EXPECT_EQ(0, std::memcmp(src, dst, sizeof(src)));
+}
+
+TEST(ExecutableImportsTest, Sgemm) {
+  auto fn = (iree_hal_executable_import_v0_t)Resolve(
+      iree_hal_executable_host_import_provider_default(), "iree_hal_sgemm_v0");
+  // 2x3 * 3x2 with a padded output row to exercise the strides.
+  const float lhs[2 * 3] = {1, 2, 3, 4, 5, 6};
+  const float rhs[3 * 2] = {7, 8, 9, 10, 11, 12};
+  float out[2 * 3] = {1, 1, -1, 1, 1, -1};
+  iree_hal_sgemm_v0_params_t params = {out, lhs, rhs, 2, 2, 3, 3, 3, 2};
+  EXPECT_EQ(0, fn(&params));
+  EXPECT_EQ(59, out[0]);
+  EXPECT_EQ(65, out[1]);
+  EXPECT_EQ(-1, out[2]);
+  EXPECT_EQ(140, out[3]);
+  EXPECT_EQ(155, out[4]);
+  EXPECT_EQ(-1, out[5]);
+}
+
+}  // namespace
@@ -38,8 +38,29 @@
 //===----------------------------------------------------------------------===//
 
 // Defines a bitfield of features that the library requires or supports.
+//
+// Processor features are architecture-specific and describe the instruction
+// set extensions the library was compiled to use. A library requiring a
+// feature the host processor lacks must not be loaded; executables carrying
+// variants specialized for multiple microarchitectures rely on this to have
+// the runtime pick the most specialized variant the host supports.
 enum iree_hal_executable_library_feature_bits_t {
   IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE = 0u,
+
+  // x86-64: AVX, AVX2 and FMA3 (Haswell/Zen and newer, x86-64-v3).
+  IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_AVX2_FMA = 1u << 0,
+  // x86-64: AVX-512 F/CD/BW/DQ/VL (Skylake-SP/Zen 4 and newer, x86-64-v4).
+  IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_AVX512 = 1u << 1,
+  // x86-64: SSSE3, SSE4.1, SSE4.2 and POPCNT (Nehalem and newer, x86-64-v2).
+  IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_X86_64_SSE4_2 = 1u << 2,
+
+  // arm64: SDOT/UDOT dot product instructions (FEAT_DotProd).
+  IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_DOTPROD = 1u << 8,
+  // arm64: SMMLA/UMMLA int8 matrix multiply instructions (FEAT_I8MM).
+  IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_I8MM = 1u << 9,
+  // arm64: Scalable Vector Extension (FEAT_SVE).
+  IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_ARM_64_SVE = 1u << 10,
+
   // TODO(benvanik): declare features for debugging/coverage/printf/etc.
   // These will control which symbols are injected into the library at runtime.
 };
@@ -109,13 +130,28 @@ typedef struct iree_hal_executable_library_header_t {
   iree_hal_executable_library_sanitizer_kind_t sanitizer;
 } iree_hal_executable_library_header_t;
 
+// Describes the host environment a library is being loaded into.
+// Libraries may use this to select between implementations specialized for
+// different hosts. Only ever extended by appending fields and guarded by the
+// version passed alongside it to the query function.
+typedef struct iree_hal_executable_environment_v0_t {
+  // Processor features supported by the host. Libraries must not return a
+  // library from the query function that requires features outside this set.
+  iree_hal_executable_library_features_t supported_features;
+} iree_hal_executable_environment_v0_t;
+
 // Exported function from dynamic libraries for querying library information.
 // The provided |max_version| is the maximum version the caller supports;
 // callees must return NULL if their lowest available version is greater
 // than the max version supported by the caller.
+//
+// |environment| describes the host and may be NULL when queried by older
+// runtimes; libraries that do not care about the host may ignore it. Runtimes
+// still verify the features the returned library header declares as required.
 typedef const iree_hal_executable_library_header_t** (
     *iree_hal_executable_library_query_fn_t)(
-    iree_hal_executable_library_version_t max_version, void* reserved);
+    iree_hal_executable_library_version_t max_version,
+    const iree_hal_executable_environment_v0_t* environment);
 
 // Function name exported from dynamic libraries (pass to dlsym).
 #define IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME \
@@ -239,11 +275,11 @@ typedef struct iree_hal_executable_dispatch_state_v0_t {
 // The same |dispatch_state| is passed to all workgroups in a dispatch while
 // |workgroup_id| and |local_memory| will vary for each workgroup.
 //
-// If a non-zero value was specified for |local_memory_page| then scratch memory
-// will be available for use by the invocation of at least the size specified.
-// This memory is transient and exclusive to the workgroup. The provided pointer
-// may be NULL if no workgroup local memory was requested and otherwise will
-// point to memory of the size specified.
+// If a non-zero value was specified for |local_memory_pages| then scratch
+// memory will be available for use by the invocation of at least the size
+// specified. This memory is transient and exclusive to the workgroup. The
+// provided pointer may be NULL if no workgroup local memory was requested and
+// otherwise will point to memory of the size specified.
 //
 // Returns 0 on success and non-zero on failure. Failures will cause device loss
 // and should only be used to communicate serious issues that should abort all
@@ -259,6 +295,33 @@ typedef int (*iree_hal_executable_dispatch_v0_t)(
 // This is chosen to match the common page size of devices.
 #define IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE 4096
 
+// Flags for exported dispatch functions. Unless noted otherwise these are
+// scheduling hints that only influence how the runtime distributes workgroups
+// and never change the results; runtimes are free to ignore them.
+enum iree_hal_executable_dispatch_flag_bits_v0_t {
+  IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_NONE = 0u,
+  // Workgroups are expected to be limited by memory bandwidth. Spreading them
+  // across more cores than needed mostly adds contention.
+  IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_MEMORY_BOUND = 1u << 0,
+  // Workgroups are expected to be limited by arithmetic throughput and scale
+  // with the number of cores processing them.
+  IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_COMPUTE_BOUND = 1u << 1,
+  // Workgroups must execute with denormal floating-point values preserved.
+  // By default runtimes flush denormals to zero (and treat denormal inputs as
+  // zero) where the processor supports it as denormal arithmetic may be
+  // implemented in microcode and orders of magnitude slower. Not a hint:
+  // runtimes must honor it. The FPU state is changed once per dispatch and not
+  // per workgroup.
+  IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_PRESERVE_DENORMALS = 1u << 2,
+};
+typedef uint8_t iree_hal_executable_dispatch_flags_v0_t;
+
+// Bits [4, 8) of iree_hal_executable_dispatch_flags_v0_t encode the preferred
+// number of workgroups scheduled together as a group as log2(count) + 1 or 0 if
+// the dispatch has no preference.
+#define IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_TILE_GROUPING_SHIFT 4
+#define IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_TILE_GROUPING_MASK 0xF0u
+
 // Attributes for exported dispatch functions defining how they are to be
 // executed. 0 defaults are well-specified and the entire attributes table may
 // be omitted if no dispatch functions require these fields.
@@ -267,9 +330,13 @@ typedef struct iree_hal_executable_dispatch_attrs_v0_t {
   // indicating how much workgroup local memory is required for the dispatch.
   // This is the size of the buffer referenced by the `local_memory` argument.
   uint16_t local_memory_pages;
-  // Must be 0. May be used in the future for flags controlling the dispatch
-  // behavior/synchronization requirements.
-  uint16_t reserved;
+  // Estimated cost of a single workgroup as log2 of the number of operations
+  // it performs, or 0 if unknown. This is a rough static estimate used to
+  // decide how finely to split a dispatch and not a promise.
+  uint8_t workgroup_cost_log2;
+  // Bitfield of iree_hal_executable_dispatch_flag_bits_v0_t plus the packed
+  // preferred tile grouping. Libraries that predate these hints leave it 0.
+  iree_hal_executable_dispatch_flags_v0_t flags;
 } iree_hal_executable_dispatch_attrs_v0_t;
 static_assert(sizeof(iree_hal_executable_dispatch_attrs_v0_t) == 4, "uint32_t");
 
@@ -18,8 +18,19 @@
 #include "iree/hal/local/local_descriptor_set_layout.h"
 #include "iree/hal/local/local_executable.h"
 #include "iree/hal/local/local_executable_layout.h"
+#include "iree/task/executor.h"
+#include "iree/task/scope.h"
+#include "iree/task/task.h"
+#include "iree/task/topology.h"
 #include "iree/testing/benchmark.h"
 
+#if defined(IREE_PLATFORM_LINUX)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // IREE_PLATFORM_LINUX
+
 IREE_FLAG(string, executable_format, "",
           "Format of the executable file being loaded.");
 IREE_FLAG(string, executable_file, "",
@@ -45,6 +56,33 @@ IREE_FLAG(int32_t, workgroup_size_y, 1,
 IREE_FLAG(int32_t, workgroup_size_z, 1,
           "Z dimension of the workgroup size passed to the executable.");
 
+IREE_FLAG(int64_t, flops, 0,
+          "Floating-point operations performed by a single dispatch of the\n"
+          "entry point. When 0 the operation count is estimated from the\n"
+          "workgroup cost emitted by the compiler, if any.");
+IREE_FLAG(int64_t, bytes, 0,
+          "Bytes of memory accessed by a single dispatch of the entry point.\n"
+          "When 0 the total length of all bindings is used.");
+IREE_FLAG(double, peak_gflops, 0.0,
+          "Peak compute throughput of the machine in GFLOP/s. When provided\n"
+          "the achieved throughput is reported as a percentage of it.");
+IREE_FLAG(double, peak_gbps, 0.0,
+          "Peak memory bandwidth of the machine in GB/s. When provided the\n"
+          "achieved bandwidth is reported as a percentage of it and, along\n"
+          "with --peak_gflops, the percentage of the attainable roofline\n"
+          "throughput at the dispatch arithmetic intensity.");
+
+IREE_FLAG(bool, perf_counters, false,
+          "Collects hardware performance counters (cycles, instructions, and\n"
+          "cache references/misses) while benchmarking. Linux only and\n"
+          "subject to the kernel.perf_event_paranoid setting.");
+
+IREE_FLAG(string, task_worker_counts, "",
+          "Comma-separated list of worker counts to sweep by distributing the\n"
+          "workgroups through a task executor with that many workers, e.g.\n"
+          "`1,2,4,8`. When empty the workgroups are run inline on the\n"
+          "benchmark thread.");
+
 // Total number of bindings we (currently) allow any executable to have.
 #define IREE_HAL_LOCAL_MAX_TOTAL_BINDING_COUNT \
   (IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *   \
@@ -200,6 +238,191 @@ static iree_status_t iree_file_read_contents(const char* path,
   return status;
 }
 
+//===----------------------------------------------------------------------===//
+// Hardware performance counters
+//===----------------------------------------------------------------------===//
+
+typedef enum iree_perf_counter_e {
+  IREE_PERF_COUNTER_CYCLES = 0,
+  IREE_PERF_COUNTER_INSTRUCTIONS,
+  IREE_PERF_COUNTER_CACHE_REFERENCES,
+  IREE_PERF_COUNTER_CACHE_MISSES,
+  IREE_PERF_COUNTER_COUNT,
+} iree_perf_counter_t;
+
+// Per-process hardware counters. Counters are inherited by threads created
+// after they are opened so that work performed by task executor workers is
+// included.
+typedef struct iree_perf_counters_t {
+  int fds[IREE_PERF_COUNTER_COUNT];
+  uint64_t values[IREE_PERF_COUNTER_COUNT];
+} iree_perf_counters_t;
+
+static void iree_perf_counters_close(iree_perf_counters_t* counters);
+
+#if defined(IREE_PLATFORM_LINUX)
+
+static iree_status_t iree_perf_counters_open(iree_perf_counters_t* counters) {
+  static const uint64_t configs[IREE_PERF_COUNTER_COUNT] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_REFERENCES,
+      PERF_COUNT_HW_CACHE_MISSES,
+  };
+  memset(counters, 0, sizeof(*counters));
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) counters->fds[i] = -1;
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    counters->fds[i] = (int)syscall(__NR_perf_event_open, &attr, /*pid=*/0,
+                                    /*cpu=*/-1, /*group_fd=*/-1, /*flags=*/0);
+    if (counters->fds[i] == -1) {
+      iree_status_t status = iree_make_status(
+          iree_status_code_from_errno(errno),
+          "unable to open perf event %d; check "
+          "/proc/sys/kernel/perf_event_paranoid",
+          i);
+      iree_perf_counters_close(counters);
+      return status;
+    }
+  }
+  return iree_ok_status();
+}
+
+static void iree_perf_counters_close(iree_perf_counters_t* counters) {
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) {
+    if (counters->fds[i] != -1) close(counters->fds[i]);
+    counters->fds[i] = -1;
+  }
+}
+
+static void iree_perf_counters_start(iree_perf_counters_t* counters) {
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) {
+    ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+    ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+static iree_status_t iree_perf_counters_stop(iree_perf_counters_t* counters) {
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) {
+    ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+  }
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) {
+    if (read(counters->fds[i], &counters->values[i],
+             sizeof(counters->values[i])) != sizeof(counters->values[i])) {
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "unable to read perf event %d", i);
+    }
+  }
+  return iree_ok_status();
+}
+
+#else
+
+static iree_status_t iree_perf_counters_open(iree_perf_counters_t* counters) {
+  memset(counters, 0, sizeof(*counters));
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "hardware performance counters are only available "
+                          "on Linux");
+}
+
+static void iree_perf_counters_close(iree_perf_counters_t* counters) {}
+
+static void iree_perf_counters_start(iree_perf_counters_t* counters) {}
+
+static iree_status_t iree_perf_counters_stop(iree_perf_counters_t* counters) {
+  return iree_ok_status();
+}
+
+#endif  // IREE_PLATFORM_LINUX
+
+// Reports the collected |counters| averaged across all iterations.
+static void iree_perf_counters_report(const iree_perf_counters_t* counters,
+                                      iree_benchmark_state_t* benchmark_state) {
+  const uint64_t* values = counters->values;
+  iree_benchmark_set_counter(benchmark_state, "cycles",
+                             (double)values[IREE_PERF_COUNTER_CYCLES],
+                             IREE_BENCHMARK_COUNTER_FLAG_AVERAGE_ITERATIONS);
+  iree_benchmark_set_counter(benchmark_state, "instructions",
+                             (double)values[IREE_PERF_COUNTER_INSTRUCTIONS],
+                             IREE_BENCHMARK_COUNTER_FLAG_AVERAGE_ITERATIONS);
+  iree_benchmark_set_counter(benchmark_state, "cache_misses",
+                             (double)values[IREE_PERF_COUNTER_CACHE_MISSES],
+                             IREE_BENCHMARK_COUNTER_FLAG_AVERAGE_ITERATIONS);
+  if (values[IREE_PERF_COUNTER_CYCLES]) {
+    iree_benchmark_set_counter(benchmark_state, "IPC",
+                               (double)values[IREE_PERF_COUNTER_INSTRUCTIONS] /
+                                   values[IREE_PERF_COUNTER_CYCLES],
+                               IREE_BENCHMARK_COUNTER_FLAG_NONE);
+  }
+  if (values[IREE_PERF_COUNTER_CACHE_REFERENCES]) {
+    iree_benchmark_set_counter(
+        benchmark_state, "cache_miss%",
+        100.0 * values[IREE_PERF_COUNTER_CACHE_MISSES] /
+            values[IREE_PERF_COUNTER_CACHE_REFERENCES],
+        IREE_BENCHMARK_COUNTER_FLAG_NONE);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Task executor dispatch
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_executable_library_task_dispatch_t {
+  iree_hal_local_executable_t* executable;
+  const iree_hal_executable_dispatch_state_v0_t* dispatch_state;
+} iree_hal_executable_library_task_dispatch_t;
+
+static iree_status_t iree_hal_executable_library_dispatch_tile(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  const iree_hal_executable_library_task_dispatch_t* dispatch =
+      (const iree_hal_executable_library_task_dispatch_t*)user_context;
+  return iree_hal_local_executable_issue_call(
+      dispatch->executable, FLAG_entry_point, dispatch->dispatch_state,
+      (const iree_hal_vec3_t*)tile_context->workgroup_xyz,
+      tile_context->local_memory);
+}
+
+// Distributes a full dispatch of the entry point across the workers of
+// |executor| and waits for it to complete.
+static iree_status_t iree_hal_executable_library_dispatch_task(
+    iree_task_executor_t* executor, iree_task_scope_t* scope,
+    iree_hal_executable_library_task_dispatch_t* dispatch,
+    iree_host_size_t local_memory_size) {
+  iree_task_dispatch_t dispatch_task;
+  iree_task_dispatch_initialize(
+      scope,
+      iree_task_make_dispatch_closure(iree_hal_executable_library_dispatch_tile,
+                                      dispatch),
+      dispatch->dispatch_state->workgroup_size.value,
+      dispatch->dispatch_state->workgroup_count.value, &dispatch_task);
+  dispatch_task.local_memory_size = (uint32_t)local_memory_size;
+
+  iree_task_fence_t* fence = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_task_executor_acquire_fence(executor, scope, &fence));
+  iree_task_set_completion_task(&dispatch_task.header, &fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch_task.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  return iree_task_scope_wait_idle(scope, IREE_TIME_INFINITE_FUTURE);
+}
+
+//===----------------------------------------------------------------------===//
+// Benchmark
+//===----------------------------------------------------------------------===//
+
 // NOTE: error handling is here just for better diagnostics: it is not tracking
 // allocations correctly and will leak. Don't use this as an example for how to
 // write robust code.
@@ -304,26 +527,139 @@ static iree_status_t iree_hal_executable_library_run(
       .imports = NULL,       // not yet implemented
   };
 
+  // Total bytes accessed by each dispatch, defaulting to each binding being
+  // touched exactly once.
+  int64_t dispatch_bytes = FLAG_bytes;
+  if (dispatch_bytes <= 0) {
+    dispatch_bytes = 0;
+    for (iree_host_size_t i = 0; i < dispatch_params.binding_count; ++i) {
+      dispatch_bytes += (int64_t)binding_lengths[i];
+    }
+  }
+
+  // Total operations performed by each dispatch, defaulting to the compiler
+  // estimate of the per-workgroup cost when available.
+  int64_t workgroup_count_total = (int64_t)dispatch_state.workgroup_count.x *
+                                  dispatch_state.workgroup_count.y *
+                                  dispatch_state.workgroup_count.z;
+  int64_t dispatch_flops = FLAG_flops;
+  if (dispatch_flops <= 0) {
+    uint8_t cost_log2 =
+        local_executable->dispatch_attrs
+            ? local_executable->dispatch_attrs[FLAG_entry_point]
+                  .workgroup_cost_log2
+            : 0;
+    dispatch_flops =
+        cost_log2 ? workgroup_count_total * (1ll << iree_min(cost_log2, 62))
+                  : 0;
+  }
+
+  // Counters must be opened prior to creating any worker threads so that they
+  // are inherited by them.
+  iree_perf_counters_t perf_counters;
+  memset(&perf_counters, 0, sizeof(perf_counters));
+  if (FLAG_perf_counters) {
+    IREE_RETURN_IF_ERROR(iree_perf_counters_open(&perf_counters));
+  }
+
+  // Create the task executor when sweeping worker counts. Each dispatch is
+  // then split into tiles across the workers as with the local-task driver.
+  iree_host_size_t worker_count = (iree_host_size_t)benchmark_def->user_data;
+  iree_task_executor_t* executor = NULL;
+  iree_task_scope_t scope;
+  iree_hal_executable_library_task_dispatch_t task_dispatch = {
+      .executable = local_executable,
+      .dispatch_state = &dispatch_state,
+  };
+  if (worker_count > 0) {
+    iree_task_executor_options_t options;
+    iree_task_executor_options_initialize(&options);
+    options.worker_local_memory_size = local_memory_size;
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(worker_count, &topology);
+    iree_status_t status = iree_task_executor_create(
+        &options, &topology, host_allocator, &executor);
+    iree_task_topology_deinitialize(&topology);
+    IREE_RETURN_IF_ERROR(status);
+    iree_task_scope_initialize(iree_make_cstring_view("benchmark"), &scope);
+  }
+
   // Execute benchmark the workgroup invocation.
   // Note that each iteration runs through the whole grid as it's important that
   // we are testing the memory access patterns: if we just ran the same single
   // tile processing the same exact region of memory over and over we are not
   // testing cache effects.
   int64_t dispatch_count = 0;
+  if (FLAG_perf_counters) iree_perf_counters_start(&perf_counters);
+  iree_time_t start_time_ns = iree_time_now();
   while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
-    IREE_RETURN_IF_ERROR(iree_hal_local_executable_issue_dispatch_inline(
-        local_executable, FLAG_entry_point, &dispatch_state, local_memory));
+    if (executor) {
+      IREE_RETURN_IF_ERROR(iree_hal_executable_library_dispatch_task(
+          executor, &scope, &task_dispatch, local_memory_size));
+    } else {
+      IREE_RETURN_IF_ERROR(iree_hal_local_executable_issue_dispatch_inline(
+          local_executable, FLAG_entry_point, &dispatch_state, local_memory));
+    }
     ++dispatch_count;
   }
+  iree_time_t elapsed_ns = iree_time_now() - start_time_ns;
+  if (FLAG_perf_counters) {
+    IREE_RETURN_IF_ERROR(iree_perf_counters_stop(&perf_counters));
+    iree_perf_counters_report(&perf_counters, benchmark_state);
+    iree_perf_counters_close(&perf_counters);
+  }
+
+  if (executor) {
+    iree_task_scope_deinitialize(&scope);
+    iree_task_executor_release(executor);
+  }
 
   // To get a total time per invocation we set the item count to the total
   // invocations dispatched. That gives us both total dispatch and single
   // invocation times in the reporter output.
-  int64_t total_invocations =
-      dispatch_count * dispatch_state.workgroup_count.x *
-      dispatch_state.workgroup_count.y * dispatch_state.workgroup_count.z;
+  int64_t total_invocations = dispatch_count * workgroup_count_total;
   iree_benchmark_set_items_processed(benchmark_state, total_invocations);
 
+  // Report throughput relative to the machine peaks. Bytes and FLOPs per
+  // nanosecond are GB/s and GFLOP/s.
+  iree_benchmark_set_bytes_processed(benchmark_state,
+                                     dispatch_count * dispatch_bytes);
+  if (dispatch_flops > 0) {
+    iree_benchmark_set_counter(
+        benchmark_state, "FLOP/s", (double)dispatch_flops,
+        IREE_BENCHMARK_COUNTER_FLAG_RATE |
+            IREE_BENCHMARK_COUNTER_FLAG_ITERATION_INVARIANT);
+  }
+  if (elapsed_ns > 0 && dispatch_count > 0) {
+    double achieved_gbps =
+        (double)dispatch_count * dispatch_bytes / (double)elapsed_ns;
+    double achieved_gflops =
+        (double)dispatch_count * dispatch_flops / (double)elapsed_ns;
+    if (FLAG_peak_gbps > 0.0) {
+      iree_benchmark_set_counter(benchmark_state, "peak_bw%",
+                                 100.0 * achieved_gbps / FLAG_peak_gbps,
+                                 IREE_BENCHMARK_COUNTER_FLAG_NONE);
+    }
+    if (FLAG_peak_gflops > 0.0 && dispatch_flops > 0) {
+      iree_benchmark_set_counter(benchmark_state, "peak_compute%",
+                                 100.0 * achieved_gflops / FLAG_peak_gflops,
+                                 IREE_BENCHMARK_COUNTER_FLAG_NONE);
+    }
+    if (FLAG_peak_gbps > 0.0 && FLAG_peak_gflops > 0.0 && dispatch_flops > 0 &&
+        dispatch_bytes > 0) {
+      // Attainable throughput is bounded by either compute or bandwidth at the
+      // arithmetic intensity of the dispatch.
+      double intensity = (double)dispatch_flops / (double)dispatch_bytes;
+      double attainable_gflops =
+          iree_min(FLAG_peak_gflops, intensity * FLAG_peak_gbps);
+      iree_benchmark_set_counter(benchmark_state, "FLOP/byte", intensity,
+                                 IREE_BENCHMARK_COUNTER_FLAG_NONE);
+      iree_benchmark_set_counter(benchmark_state, "roofline%",
+                                 100.0 * achieved_gflops / attainable_gflops,
+                                 IREE_BENCHMARK_COUNTER_FLAG_NONE);
+    }
+  }
+
   // Deallocate buffers.
   for (iree_host_size_t i = 0; i < dispatch_params.binding_count; ++i) {
     iree_hal_buffer_view_release(buffer_views[i]);
@@ -354,6 +690,11 @@ int main(int argc, char** argv) {
       "executables (bypassing all of the IREE VM, HAL APIs, task system,\n"
       "etc).\n"
       "\n"
+      "Pass --flops/--bytes (or rely on the compiler-emitted workgroup cost)\n"
+      "along with --peak_gflops/--peak_gbps to report where the dispatch\n"
+      "lands relative to the machine roofline. --task_worker_counts=1,2,4\n"
+      "sweeps distributing the workgroups through the task system.\n"
+      "\n"
       "Example --flagfile:\n"
       "  --executable_format=EX_ELF\n"
       "  --executable_file=iree/hal/local/elf/testdata/"
@@ -382,7 +723,28 @@ int main(int argc, char** argv) {
       .iteration_count = 0,
       .run = iree_hal_executable_library_run,
   };
-  iree_benchmark_register(iree_make_cstring_view("dispatch"), &benchmark_def);
+  iree_string_view_t worker_counts =
+      iree_make_cstring_view(FLAG_task_worker_counts);
+  if (iree_string_view_is_empty(worker_counts)) {
+    iree_benchmark_register(iree_make_cstring_view("dispatch"), &benchmark_def);
+  }
+  while (!iree_string_view_is_empty(worker_counts)) {
+    iree_string_view_t worker_count_str = iree_string_view_empty();
+    iree_string_view_split(worker_counts, ',', &worker_count_str,
+                           &worker_counts);
+    uint32_t worker_count = 0;
+    if (!iree_string_view_atoi_uint32(iree_string_view_trim(worker_count_str),
+                                      &worker_count) ||
+        worker_count == 0) {
+      fprintf(stderr, "invalid --task_worker_counts value '%.*s'\n",
+              (int)worker_count_str.size, worker_count_str.data);
+      return 1;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "dispatch/workers:%u", worker_count);
+    benchmark_def.user_data = (const void*)(uintptr_t)worker_count;
+    iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+  }
 
   iree_benchmark_run_specified();
   return 0;
@@ -43,7 +43,8 @@ typedef union {
 //       bindings: 0
 //
 const iree_hal_executable_library_header_t** demo_executable_library_query(
-    iree_hal_executable_library_version_t max_version, void* reserved);
+    iree_hal_executable_library_version_t max_version,
+    const iree_hal_executable_environment_v0_t* environment);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -7,6 +7,7 @@
 #include "iree/hal/local/executable_loader.h"
 
 #include "iree/base/api.h"
+#include "iree/hal/local/executable_environment.h"
 
 iree_status_t iree_hal_executable_import_provider_resolve(
     const iree_hal_executable_import_provider_t import_provider,
@@ -46,6 +47,7 @@ void iree_hal_executable_loader_initialize(
   iree_atomic_ref_count_init(&out_base_loader->ref_count);
   out_base_loader->vtable = vtable;
   out_base_loader->import_provider = import_provider;
+  iree_hal_executable_environment_initialize(&out_base_loader->environment);
 }
 
 void iree_hal_executable_loader_retain(
@@ -13,6 +13,7 @@
 #include "iree/base/api.h"
 #include "iree/base/internal/atomics.h"
 #include "iree/hal/api.h"
+#include "iree/hal/local/executable_library.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -75,6 +76,9 @@ typedef struct iree_hal_executable_loader_t {
   iree_atomic_ref_count_t ref_count;
   const iree_hal_executable_loader_vtable_t* vtable;
   iree_hal_executable_import_provider_t import_provider;
+  // Host environment passed to libraries when querying them and used to
+  // verify that the features they require are available.
+  iree_hal_executable_environment_v0_t environment;
 } iree_hal_executable_loader_t;
 
 // Initializes the base iree_hal_executable_loader_t type.
@@ -28,6 +28,13 @@ typedef struct iree_hal_inline_command_buffer_t {
   iree_hal_command_buffer_t base;
   iree_allocator_t host_allocator;
 
+  // Arena used for transient dispatch state such as workgroup local memory.
+  // Reset with the command buffer.
+  iree_arena_allocator_t arena;
+
+  // Optional pool used to distribute large dispatches.
+  iree_hal_inline_worker_pool_t* worker_pool;
+
   struct {
     // A flattened list of all available descriptor set bindings.
     // As descriptor sets are pushed/bound the bindings will be updated to
@@ -40,6 +47,14 @@ typedef struct iree_hal_inline_command_buffer_t {
     size_t full_binding_lengths[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
                                 IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
 
+    // The buffer ranges the full bindings were mapped from. Pushing the same
+    // range again reuses the existing mapping. Buffers are not retained as the
+    // HAL contract requires them to remain valid while the command buffer is
+    // in use.
+    iree_hal_descriptor_set_binding_t
+        full_binding_sources[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+                             IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
+
     // Packed bindings scratch space used during dispatch. Executable bindings
     // are packed into a dense list with unused bindings removed.
     void* packed_bindings[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
@@ -47,6 +62,16 @@ typedef struct iree_hal_inline_command_buffer_t {
     size_t packed_binding_lengths[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
                                   IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
 
+    // The used binding mask the packed bindings were produced for. Consecutive
+    // dispatches using the same bindings skip repacking until a descriptor set
+    // is pushed that changes a binding.
+    bool packed_bindings_valid;
+    iree_hal_local_binding_mask_t packed_binding_mask;
+
+    // Workgroup local memory allocated from the arena and reused by all
+    // dispatches. Grown as dispatches require more.
+    iree_byte_span_t local_memory;
+
     // All available push constants updated each time push_constants is called.
     // Reset only with the command buffer and otherwise will maintain its values
     // during recording to allow for partial push_constants updates.
@@ -70,6 +95,7 @@ static iree_hal_inline_command_buffer_t* iree_hal_inline_command_buffer_cast(
 
 static void iree_hal_inline_command_buffer_reset(
     iree_hal_inline_command_buffer_t* command_buffer) {
+  iree_arena_reset(&command_buffer->arena);
   memset(&command_buffer->state, 0, sizeof(command_buffer->state));
 
   // Setup the cached dispatch state pointers that don't change.
@@ -84,8 +110,11 @@ static void iree_hal_inline_command_buffer_reset(
 iree_status_t iree_hal_inline_command_buffer_create(
     iree_hal_device_t* device, iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
-    iree_hal_queue_affinity_t queue_affinity, iree_allocator_t host_allocator,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_arena_block_pool_t* block_pool,
+    iree_hal_inline_worker_pool_t* worker_pool, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer) {
+  IREE_ASSERT_ARGUMENT(block_pool);
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
   if (!iree_all_bits_set(
@@ -109,6 +138,8 @@ iree_status_t iree_hal_inline_command_buffer_create(
         device, mode, command_categories, queue_affinity,
         &iree_hal_inline_command_buffer_vtable, &command_buffer->base);
     command_buffer->host_allocator = host_allocator;
+    iree_arena_initialize(block_pool, &command_buffer->arena);
+    command_buffer->worker_pool = worker_pool;
     iree_hal_inline_command_buffer_reset(command_buffer);
 
     *out_command_buffer = &command_buffer->base;
@@ -126,6 +157,7 @@ static void iree_hal_inline_command_buffer_destroy(
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_inline_command_buffer_reset(command_buffer);
+  iree_arena_deinitialize(&command_buffer->arena);
   iree_allocator_free(host_allocator, command_buffer);
 
   IREE_TRACE_ZONE_END(z0);
@@ -344,6 +376,16 @@ static iree_status_t iree_hal_inline_command_buffer_push_descriptor_set(
     }
     iree_host_size_t binding_ordinal = binding_base + bindings[i].binding;
 
+    // Reuse the existing mapping when the same range is pushed again.
+    iree_hal_descriptor_set_binding_t* source =
+        &command_buffer->state.full_binding_sources[binding_ordinal];
+    if (command_buffer->state.full_bindings[binding_ordinal] &&
+        source->buffer == bindings[i].buffer &&
+        source->offset == bindings[i].offset &&
+        source->length == bindings[i].length) {
+      continue;
+    }
+
     // TODO(benvanik): track mapping so we can properly map/unmap/flush/etc.
     iree_hal_buffer_mapping_t buffer_mapping = {{0}};
     IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
@@ -354,6 +396,8 @@ static iree_status_t iree_hal_inline_command_buffer_push_descriptor_set(
         buffer_mapping.contents.data;
     command_buffer->state.full_binding_lengths[binding_ordinal] =
         buffer_mapping.contents.data_length;
+    *source = bindings[i];
+    command_buffer->state.packed_bindings_valid = false;
   }
 
   return iree_ok_status();
@@ -422,51 +466,75 @@ static iree_status_t iree_hal_inline_command_buffer_dispatch(
   // no ownership/retaining/etc - it's part of the HAL contract that buffers are
   // kept valid for the duration they may be in use.
   iree_hal_local_binding_mask_t used_binding_mask = local_layout->used_bindings;
-  iree_host_size_t used_binding_count =
-      iree_math_count_ones_u64(used_binding_mask);
-  dispatch_state->binding_count = used_binding_count;
-  void** binding_ptrs = (void**)dispatch_state->binding_ptrs;
-  size_t* binding_lengths = (size_t*)dispatch_state->binding_lengths;
-  iree_host_size_t binding_base = 0;
-  for (iree_host_size_t i = 0; i < used_binding_count; ++i) {
-    int mask_offset = iree_math_count_trailing_zeros_u64(used_binding_mask);
-    int binding_ordinal = binding_base + mask_offset;
-    binding_base += mask_offset + 1;
-    used_binding_mask = iree_shr(used_binding_mask, mask_offset + 1);
-    binding_ptrs[i] = command_buffer->state.full_bindings[binding_ordinal];
-    if (!binding_ptrs[i]) {
-      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
-                              "(flat) binding %d is NULL", binding_ordinal);
+  if (!command_buffer->state.packed_bindings_valid ||
+      command_buffer->state.packed_binding_mask != used_binding_mask) {
+    iree_host_size_t used_binding_count =
+        iree_math_count_ones_u64(used_binding_mask);
+    dispatch_state->binding_count = used_binding_count;
+    void** binding_ptrs = (void**)dispatch_state->binding_ptrs;
+    size_t* binding_lengths = (size_t*)dispatch_state->binding_lengths;
+    iree_host_size_t binding_base = 0;
+    for (iree_host_size_t i = 0; i < used_binding_count; ++i) {
+      int mask_offset = iree_math_count_trailing_zeros_u64(used_binding_mask);
+      int binding_ordinal = binding_base + mask_offset;
+      binding_base += mask_offset + 1;
+      used_binding_mask = iree_shr(used_binding_mask, mask_offset + 1);
+      binding_ptrs[i] = command_buffer->state.full_bindings[binding_ordinal];
+      if (!binding_ptrs[i]) {
+        command_buffer->state.packed_bindings_valid = false;
+        return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                                "(flat) binding %d is NULL", binding_ordinal);
+      }
+      binding_lengths[i] =
+          command_buffer->state.full_binding_lengths[binding_ordinal];
     }
-    binding_lengths[i] =
-        command_buffer->state.full_binding_lengths[binding_ordinal];
+    command_buffer->state.packed_bindings_valid = true;
+    command_buffer->state.packed_binding_mask = local_layout->used_bindings;
   }
 
-  // TODO(benvanik): plumb through an arena or fixed-size reservation to use.
-  // For now when deploying to devices where you want something like the
-  // inline command buffer you probably don't want 256KB of transient memory
-  // getting allocated and retained implicitly - this should be a compiler
-  // option. For now we just malloc here to make things work and strongly
-  // encourage the kind of user who wants synchronous inline execution to not
-  // also want tons of scratch memory.
-  iree_byte_span_t local_memory = iree_make_byte_span(NULL, local_memory_size);
-  if (local_memory_size > 0) {
-    IREE_RETURN_IF_ERROR(iree_allocator_malloc(command_buffer->host_allocator,
-                                               local_memory_size,
-                                               (void**)&local_memory.data));
+  // Large dispatches are distributed across the worker pool (if any) with
+  // each participating thread receiving its own slice of local memory.
+  const bool distribute =
+      command_buffer->worker_pool &&
+      iree_hal_inline_worker_pool_should_distribute(
+          command_buffer->worker_pool, dispatch_state->workgroup_count);
+  iree_host_size_t total_local_memory_size =
+      distribute ? local_memory_size * iree_hal_inline_worker_pool_concurrency(
+                                           command_buffer->worker_pool)
+                 : local_memory_size;
+
+  // Workgroup local memory is allocated from the command buffer arena and
+  // reused across dispatches. The arena only grows when a dispatch requires
+  // more than any before it and the storage is released when the command
+  // buffer is reset.
+  if (total_local_memory_size >
+      command_buffer->state.local_memory.data_length) {
+    uint8_t* local_memory_data = NULL;
+    IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                             total_local_memory_size,
+                                             (void**)&local_memory_data));
+    command_buffer->state.local_memory =
+        iree_make_byte_span(local_memory_data, total_local_memory_size);
   }
+  iree_byte_span_t local_memory = iree_make_byte_span(
+      total_local_memory_size ? command_buffer->state.local_memory.data : NULL,
+      total_local_memory_size);
 
   // Since we are running on a borrowed thread, we know nothing about the
-  // floating point state. Reset it.
-  iree_fpu_state_t fpu_state =
-      iree_fpu_state_push(IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
-  iree_status_t status = iree_hal_local_executable_issue_dispatch_inline(
-      local_executable, entry_point, dispatch_state, local_memory);
+  // floating point state. Reset it to what the entry point expects.
+  iree_fpu_state_t fpu_state = iree_fpu_state_push(
+      iree_hal_local_executable_fpu_state_flags(local_executable, entry_point));
+  iree_status_t status = iree_ok_status();
+  if (distribute) {
+    status = iree_hal_inline_worker_pool_issue_dispatch(
+        command_buffer->worker_pool, local_executable, entry_point,
+        dispatch_state, local_memory, local_memory_size);
+  } else {
+    status = iree_hal_local_executable_issue_dispatch_inline(
+        local_executable, entry_point, dispatch_state, local_memory);
+  }
   iree_fpu_state_pop(fpu_state);
 
-  if (local_memory.data) {
-    iree_allocator_free(command_buffer->host_allocator, local_memory.data);
-  }
   return status;
 }
 
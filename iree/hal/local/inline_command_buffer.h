@@ -8,7 +8,9 @@
 #define IREE_HAL_LOCAL_INLINE_COMMAND_BUFFER_H_
 
 #include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
 #include "iree/hal/api.h"
+#include "iree/hal/local/inline_worker_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,11 +24,21 @@ extern "C" {
 //
 // Executes all work on the calling thread synchronously (today).
 //
+// Transient dispatch state such as workgroup local memory is allocated from
+// |block_pool| and returned to it when the command buffer is reset. The pool
+// must remain valid for the lifetime of the command buffer.
+//
+// If |worker_pool| is provided then dispatches large enough to benefit are
+// distributed across its workers with the calling thread participating. The
+// pool must remain valid for the lifetime of the command buffer.
+//
 // Must have IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION set.
 iree_status_t iree_hal_inline_command_buffer_create(
     iree_hal_device_t* device, iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
-    iree_hal_queue_affinity_t queue_affinity, iree_allocator_t host_allocator,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_arena_block_pool_t* block_pool,
+    iree_hal_inline_worker_pool_t* worker_pool, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer);
 
 // Returns true if |command_buffer| is an inline command buffer.
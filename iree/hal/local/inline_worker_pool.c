@@ -0,0 +1,305 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/inline_worker_pool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/fpu_state.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+#include "iree/base/tracing.h"
+
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
+iree_status_t iree_hal_inline_worker_pool_create(
+    iree_host_size_t worker_count, iree_host_size_t min_workgroup_count,
+    iree_allocator_t host_allocator, iree_hal_inline_worker_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(out_pool);
+  *out_pool = NULL;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "worker pools require threading support");
+}
+
+void iree_hal_inline_worker_pool_free(iree_hal_inline_worker_pool_t* pool) {}
+
+iree_host_size_t iree_hal_inline_worker_pool_concurrency(
+    const iree_hal_inline_worker_pool_t* pool) {
+  return 1;
+}
+
+bool iree_hal_inline_worker_pool_should_distribute(
+    const iree_hal_inline_worker_pool_t* pool,
+    iree_hal_vec3_t workgroup_count) {
+  return false;
+}
+
+iree_status_t iree_hal_inline_worker_pool_issue_dispatch(
+    iree_hal_inline_worker_pool_t* pool,
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    iree_byte_span_t local_memory, iree_host_size_t local_memory_size) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "worker pools require threading support");
+}
+
+#else
+
+typedef struct iree_hal_inline_worker_t {
+  iree_hal_inline_worker_pool_t* pool;
+  // Index of the local memory slice used by the worker. The calling thread
+  // uses slice 0.
+  iree_host_size_t slice_index;
+  iree_thread_t* thread;
+  // Result of the worker's share of the current dispatch.
+  iree_status_t status;
+} iree_hal_inline_worker_t;
+
+struct iree_hal_inline_worker_pool_t {
+  iree_allocator_t host_allocator;
+  iree_host_size_t min_workgroup_count;
+
+  // Held by the calling thread for the duration of a dispatch.
+  iree_slim_mutex_t dispatch_mutex;
+
+  // Incremented each time a dispatch is published or the workers are asked to
+  // exit. Workers wait on |work_notification| for it to change.
+  iree_atomic_int32_t epoch;
+  iree_atomic_int32_t exit_requested;
+  iree_notification_t work_notification;
+
+  // Number of workers still executing the current dispatch. The last worker
+  // to finish posts |done_notification|.
+  iree_atomic_int32_t pending_worker_count;
+  iree_notification_t done_notification;
+
+  // The current dispatch. Written by the calling thread before the epoch is
+  // incremented and read-only while workers are executing it.
+  struct {
+    iree_hal_local_executable_t* executable;
+    iree_host_size_t ordinal;
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state;
+    iree_byte_span_t local_memory;
+    iree_host_size_t local_memory_size;
+    int64_t workgroup_total_count;
+    // Linearized index of the next workgroup to execute.
+    iree_atomic_int64_t next_workgroup;
+  } dispatch;
+
+  iree_host_size_t worker_count;
+  iree_hal_inline_worker_t workers[];
+};
+
+// Executes workgroups of the current dispatch until none remain.
+static iree_status_t iree_hal_inline_worker_pool_run(
+    iree_hal_inline_worker_pool_t* pool, iree_host_size_t slice_index) {
+  iree_host_size_t local_memory_size = pool->dispatch.local_memory_size;
+  iree_byte_span_t local_memory = iree_make_byte_span(
+      local_memory_size ? pool->dispatch.local_memory.data +
+                              slice_index * local_memory_size
+                        : NULL,
+      local_memory_size);
+  const iree_hal_vec3_t workgroup_count =
+      pool->dispatch.dispatch_state->workgroup_count;
+  const int64_t workgroup_xy_count =
+      (int64_t)workgroup_count.x * workgroup_count.y;
+  iree_status_t status = iree_ok_status();
+  for (;;) {
+    int64_t i = iree_atomic_fetch_add_int64(&pool->dispatch.next_workgroup, 1,
+                                            iree_memory_order_relaxed);
+    if (i >= pool->dispatch.workgroup_total_count) break;
+    int64_t xy = i % workgroup_xy_count;
+    iree_hal_vec3_t workgroup_id;
+    workgroup_id.x = (uint32_t)(xy % workgroup_count.x);
+    workgroup_id.y = (uint32_t)(xy / workgroup_count.x);
+    workgroup_id.z = (uint32_t)(i / workgroup_xy_count);
+    status = iree_hal_local_executable_issue_call(
+        pool->dispatch.executable, pool->dispatch.ordinal,
+        pool->dispatch.dispatch_state, &workgroup_id, local_memory);
+    if (!iree_status_is_ok(status)) {
+      // Skip all remaining workgroups.
+      iree_atomic_store_int64(&pool->dispatch.next_workgroup,
+                              pool->dispatch.workgroup_total_count,
+                              iree_memory_order_relaxed);
+      break;
+    }
+  }
+  return status;
+}
+
+static int iree_hal_inline_worker_main(void* entry_arg) {
+  iree_hal_inline_worker_t* worker = (iree_hal_inline_worker_t*)entry_arg;
+  iree_hal_inline_worker_pool_t* pool = worker->pool;
+  int32_t last_epoch = 0;
+  for (;;) {
+    iree_wait_token_t wait_token =
+        iree_notification_prepare_wait(&pool->work_notification);
+    int32_t epoch =
+        iree_atomic_load_int32(&pool->epoch, iree_memory_order_acquire);
+    if (epoch == last_epoch) {
+      iree_notification_commit_wait(&pool->work_notification, wait_token,
+                                    IREE_TIME_INFINITE_FUTURE);
+      continue;
+    }
+    iree_notification_cancel_wait(&pool->work_notification);
+    last_epoch = epoch;
+    if (iree_atomic_load_int32(&pool->exit_requested,
+                               iree_memory_order_acquire)) {
+      break;
+    }
+
+    // Workers have no idea what the floating point state is; match what the
+    // calling thread uses for the dispatch.
+    iree_fpu_state_t fpu_state =
+        iree_fpu_state_push(iree_hal_local_executable_fpu_state_flags(
+            pool->dispatch.executable, pool->dispatch.ordinal));
+    worker->status = iree_hal_inline_worker_pool_run(pool, worker->slice_index);
+    iree_fpu_state_pop(fpu_state);
+
+    if (iree_atomic_fetch_sub_int32(&pool->pending_worker_count, 1,
+                                    iree_memory_order_acq_rel) == 1) {
+      iree_notification_post(&pool->done_notification, IREE_ALL_WAITERS);
+    }
+  }
+  return 0;
+}
+
+iree_status_t iree_hal_inline_worker_pool_create(
+    iree_host_size_t worker_count, iree_host_size_t min_workgroup_count,
+    iree_allocator_t host_allocator, iree_hal_inline_worker_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(out_pool);
+  *out_pool = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_inline_worker_pool_t* pool = NULL;
+  iree_host_size_t total_size =
+      sizeof(*pool) + worker_count * sizeof(pool->workers[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&pool));
+  memset(pool, 0, total_size);
+  pool->host_allocator = host_allocator;
+  pool->min_workgroup_count = min_workgroup_count;
+  iree_slim_mutex_initialize(&pool->dispatch_mutex);
+  iree_notification_initialize(&pool->work_notification);
+  iree_notification_initialize(&pool->done_notification);
+
+  iree_thread_create_params_t thread_params;
+  memset(&thread_params, 0, sizeof(thread_params));
+  thread_params.name = iree_make_cstring_view("iree-inline-worker");
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < worker_count; ++i) {
+    iree_hal_inline_worker_t* worker = &pool->workers[i];
+    worker->pool = pool;
+    worker->slice_index = i + 1;
+    worker->status = iree_ok_status();
+    status = iree_thread_create(iree_hal_inline_worker_main, worker,
+                                thread_params, host_allocator, &worker->thread);
+    if (!iree_status_is_ok(status)) break;
+    ++pool->worker_count;
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_pool = pool;
+  } else {
+    iree_hal_inline_worker_pool_free(pool);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_inline_worker_pool_free(iree_hal_inline_worker_pool_t* pool) {
+  if (!pool) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Wake all workers and have them exit. Releasing the threads joins them.
+  iree_atomic_store_int32(&pool->exit_requested, 1, iree_memory_order_release);
+  iree_atomic_fetch_add_int32(&pool->epoch, 1, iree_memory_order_acq_rel);
+  iree_notification_post(&pool->work_notification, IREE_ALL_WAITERS);
+  for (iree_host_size_t i = 0; i < pool->worker_count; ++i) {
+    iree_thread_release(pool->workers[i].thread);
+  }
+
+  iree_notification_deinitialize(&pool->done_notification);
+  iree_notification_deinitialize(&pool->work_notification);
+  iree_slim_mutex_deinitialize(&pool->dispatch_mutex);
+  iree_allocator_free(pool->host_allocator, pool);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_host_size_t iree_hal_inline_worker_pool_concurrency(
+    const iree_hal_inline_worker_pool_t* pool) {
+  return pool->worker_count + 1;
+}
+
+bool iree_hal_inline_worker_pool_should_distribute(
+    const iree_hal_inline_worker_pool_t* pool,
+    iree_hal_vec3_t workgroup_count) {
+  if (pool->worker_count == 0) return false;
+  uint64_t total_count =
+      (uint64_t)workgroup_count.x * workgroup_count.y * workgroup_count.z;
+  return total_count >= pool->min_workgroup_count;
+}
+
+static bool iree_hal_inline_worker_pool_is_idle(void* arg) {
+  iree_hal_inline_worker_pool_t* pool = (iree_hal_inline_worker_pool_t*)arg;
+  return iree_atomic_load_int32(&pool->pending_worker_count,
+                                iree_memory_order_acquire) == 0;
+}
+
+iree_status_t iree_hal_inline_worker_pool_issue_dispatch(
+    iree_hal_inline_worker_pool_t* pool,
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    iree_byte_span_t local_memory, iree_host_size_t local_memory_size) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_ASSERT_ARGUMENT(executable);
+  IREE_ASSERT_ARGUMENT(dispatch_state);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Publish the dispatch to the workers.
+  iree_slim_mutex_lock(&pool->dispatch_mutex);
+  pool->dispatch.executable = executable;
+  pool->dispatch.ordinal = ordinal;
+  pool->dispatch.dispatch_state = dispatch_state;
+  pool->dispatch.local_memory = local_memory;
+  pool->dispatch.local_memory_size = local_memory_size;
+  pool->dispatch.workgroup_total_count =
+      (int64_t)dispatch_state->workgroup_count.x *
+      dispatch_state->workgroup_count.y * dispatch_state->workgroup_count.z;
+  iree_atomic_store_int64(&pool->dispatch.next_workgroup, 0,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int32(&pool->pending_worker_count,
+                          (int32_t)pool->worker_count,
+                          iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int32(&pool->epoch, 1, iree_memory_order_acq_rel);
+  iree_notification_post(&pool->work_notification, IREE_ALL_WAITERS);
+
+  // Execute alongside the workers and wait for them to drain.
+  iree_status_t status = iree_hal_inline_worker_pool_run(pool, 0);
+  iree_notification_await(&pool->done_notification,
+                          iree_hal_inline_worker_pool_is_idle, pool,
+                          iree_infinite_timeout());
+
+  for (iree_host_size_t i = 0; i < pool->worker_count; ++i) {
+    iree_hal_inline_worker_t* worker = &pool->workers[i];
+    if (iree_status_is_ok(status)) {
+      status = worker->status;
+    } else {
+      iree_status_ignore(worker->status);
+    }
+    worker->status = iree_ok_status();
+  }
+  iree_slim_mutex_unlock(&pool->dispatch_mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+#endif  // IREE_SYNCHRONIZATION_DISABLE_UNSAFE
@@ -0,0 +1,64 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_INLINE_WORKER_POOL_H_
+#define IREE_HAL_LOCAL_INLINE_WORKER_POOL_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/local/executable_library.h"
+#include "iree/hal/local/local_executable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A small fixed-size pool of threads used to distribute the workgroups of
+// large dispatches issued by inline command buffers. This is a middle ground
+// between executing everything on the calling thread and the full task
+// executor: there is no scheduling beyond a single dispatch and the calling
+// thread always participates and blocks until the dispatch completes.
+//
+// A single dispatch may be in flight at a time and dispatches issued from
+// multiple threads are serialized.
+typedef struct iree_hal_inline_worker_pool_t iree_hal_inline_worker_pool_t;
+
+// Creates a pool with |worker_count| threads in addition to the calling thread.
+// Dispatches with fewer than |min_workgroup_count| workgroups are not worth
+// waking the workers for and should be executed on the calling thread.
+// Returns IREE_STATUS_UNAVAILABLE if threading is disabled in the build.
+iree_status_t iree_hal_inline_worker_pool_create(
+    iree_host_size_t worker_count, iree_host_size_t min_workgroup_count,
+    iree_allocator_t host_allocator, iree_hal_inline_worker_pool_t** out_pool);
+
+// Joins all worker threads and frees the pool.
+void iree_hal_inline_worker_pool_free(iree_hal_inline_worker_pool_t* pool);
+
+// Returns the number of threads that execute dispatches including the caller.
+iree_host_size_t iree_hal_inline_worker_pool_concurrency(
+    const iree_hal_inline_worker_pool_t* pool);
+
+// Returns true if a dispatch of |workgroup_count| is large enough to be
+// distributed across the pool.
+bool iree_hal_inline_worker_pool_should_distribute(
+    const iree_hal_inline_worker_pool_t* pool, iree_hal_vec3_t workgroup_count);
+
+// Issues all workgroups of the dispatch described by |dispatch_state| across
+// the pool workers and the calling thread and returns once all have completed.
+// |local_memory| must contain one |local_memory_size| slice per thread as
+// returned by iree_hal_inline_worker_pool_concurrency.
+// Returns the first failure of any workgroup; once a workgroup fails the
+// remaining workgroups are skipped.
+iree_status_t iree_hal_inline_worker_pool_issue_dispatch(
+    iree_hal_inline_worker_pool_t* pool,
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    iree_byte_span_t local_memory, iree_host_size_t local_memory_size);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_INLINE_WORKER_POOL_H_
@@ -13,55 +13,62 @@
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/elf/elf_module.h"
+#include "iree/hal/local/executable_environment.h"
+#include "iree/hal/local/executable_image_cache.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable.h"
 #include "iree/hal/local/local_executable_layout.h"
 
 //===----------------------------------------------------------------------===//
-// iree_hal_elf_executable_t
+// iree_hal_elf_image_t
 //===----------------------------------------------------------------------===//
 
-typedef struct iree_hal_elf_executable_t {
-  iree_hal_local_executable_t base;
+// A loaded ELF module shared by all executables created from the same ELF
+// contents across all devices in the process.
+typedef struct iree_hal_elf_image_t {
+  iree_hal_executable_image_t base;
 
   // Loaded ELF module.
   iree_elf_module_t module;
 
-  // Name used for the file field in tracy and debuggers.
-  iree_string_view_t identifier;
-
   // Queried metadata from the library.
   union {
     const iree_hal_executable_library_header_t** header;
     const iree_hal_executable_library_v0_t* v0;
   } library;
+} iree_hal_elf_image_t;
 
-  iree_hal_local_executable_layout_t* layouts[];
-} iree_hal_elf_executable_t;
+// Unique address used as the image cache kind for ELF images.
+static const char iree_hal_elf_image_kind = 0;
 
-static const iree_hal_local_executable_vtable_t iree_hal_elf_executable_vtable;
+static void iree_hal_elf_image_destroy(
+    iree_hal_executable_image_t* base_image) {
+  iree_hal_elf_image_t* image = (iree_hal_elf_image_t*)base_image;
+  iree_elf_module_deinitialize(&image->module);
+  iree_allocator_free(iree_allocator_system(), image);
+}
 
-static iree_status_t iree_hal_elf_executable_query_library(
-    iree_hal_elf_executable_t* executable) {
+static iree_status_t iree_hal_elf_image_query_library(
+    iree_hal_elf_image_t* image,
+    const iree_hal_executable_environment_v0_t* environment) {
   // Get the exported symbol used to get the library metadata.
   iree_hal_executable_library_query_fn_t query_fn = NULL;
   IREE_RETURN_IF_ERROR(iree_elf_module_lookup_export(
-      &executable->module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
+      &image->module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
       (void**)&query_fn));
 
   // Query for a compatible version of the library.
-  executable->library.header =
+  image->library.header =
       (const iree_hal_executable_library_header_t**)iree_elf_call_p_ip(
           query_fn, IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
-          /*reserved=*/NULL);
-  if (!executable->library.header) {
+          (void*)environment);
+  if (!image->library.header) {
     return iree_make_status(
         IREE_STATUS_FAILED_PRECONDITION,
         "executable does not support this version of the runtime (%d)",
         IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION);
   }
-  const iree_hal_executable_library_header_t* header =
-      *executable->library.header;
+  const iree_hal_executable_library_header_t* header = *image->library.header;
 
   // Ensure that if the library is built for a particular sanitizer that we also
   // were compiled with that sanitizer enabled.
@@ -79,15 +86,74 @@ static iree_status_t iree_hal_elf_executable_query_library(
                               (uint32_t)header->sanitizer);
   }
 
-  executable->identifier = iree_make_cstring_view(header->name);
+  return iree_ok_status();
+}
+
+// Loads an ELF image; called by the image cache when the contents have not
+// been loaded before.
+static iree_status_t iree_hal_elf_image_load(
+    void* user_data, iree_const_byte_span_t elf_data,
+    iree_hal_executable_image_t** out_image) {
+  const iree_hal_executable_environment_v0_t* environment =
+      (const iree_hal_executable_environment_v0_t*)user_data;
+  IREE_TRACE_ZONE_BEGIN(z0);
 
-  executable->base.dispatch_attrs = executable->library.v0->exports.attrs;
+  // Images outlive the device that first loaded them and must use an
+  // allocator that outlives all devices.
+  iree_hal_elf_image_t* image = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(iree_allocator_system(), sizeof(*image),
+                                (void**)&image));
+  image->base.destroy = iree_hal_elf_image_destroy;
+
+  // Attempt to load the ELF module.
+  iree_status_t status = iree_elf_module_initialize_from_memory(
+      elf_data, /*import_table=*/NULL, iree_allocator_system(), &image->module);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(iree_allocator_system(), image);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
 
-  return iree_ok_status();
+  // Query metadata and get the entry point function pointers.
+  status = iree_hal_elf_image_query_library(image, environment);
+
+  if (iree_status_is_ok(status)) {
+    *out_image = &image->base;
+  } else {
+    iree_hal_elf_image_destroy(&image->base);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
+//===----------------------------------------------------------------------===//
+// iree_hal_elf_executable_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_elf_executable_t {
+  iree_hal_local_executable_t base;
+
+  // Shared ELF image; retained for the lifetime of the executable.
+  iree_hal_elf_image_t* image;
+
+  // Name used for the file field in tracy and debuggers.
+  iree_string_view_t identifier;
+
+  // Queried metadata from the library (owned by |image|).
+  union {
+    const iree_hal_executable_library_header_t** header;
+    const iree_hal_executable_library_v0_t* v0;
+  } library;
+
+  iree_hal_local_executable_layout_t* layouts[];
+} iree_hal_elf_executable_t;
+
+static const iree_hal_local_executable_vtable_t iree_hal_elf_executable_vtable;
+
 // Resolves all of the imports declared by the executable using the given
-// |import_provider|.
+// |import_provider|. Imports are resolved per executable as providers may
+// differ across loaders even when the image is shared.
 static iree_status_t iree_hal_elf_executable_resolve_imports(
     iree_hal_elf_executable_t* executable,
     const iree_hal_executable_import_provider_t import_provider) {
@@ -129,6 +195,7 @@ static iree_status_t iree_hal_elf_executable_create(
     iree_const_byte_span_t elf_data, iree_host_size_t executable_layout_count,
     iree_hal_executable_layout_t* const* executable_layouts,
     const iree_hal_executable_import_provider_t import_provider,
+    const iree_hal_executable_environment_v0_t* environment,
     iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(elf_data.data && elf_data.data_length);
   IREE_ASSERT_ARGUMENT(!executable_layout_count || executable_layouts);
@@ -136,9 +203,13 @@ static iree_status_t iree_hal_elf_executable_create(
   *out_executable = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // TODO(benvanik): rework this so that we load and query the library before
-  // allocating so that we know the import count. Today since we allocate first
-  // we need an additional allocation once we've seen the import table.
+  // Load the ELF (or reuse the image already loaded from the same contents).
+  iree_hal_executable_image_t* image = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_executable_image_cache_acquire(
+              &iree_hal_elf_image_kind, elf_data, iree_hal_elf_image_load,
+              (void*)environment, &image));
+
   iree_hal_elf_executable_t* executable = NULL;
   iree_host_size_t total_size =
       sizeof(*executable) +
@@ -150,15 +221,19 @@ static iree_status_t iree_hal_elf_executable_create(
         &iree_hal_elf_executable_vtable, executable_layout_count,
         executable_layouts, &executable->layouts[0], host_allocator,
         &executable->base);
+    executable->image = (iree_hal_elf_image_t*)image;
+    executable->library.header = executable->image->library.header;
+    executable->identifier =
+        iree_make_cstring_view((*executable->library.header)->name);
+    executable->base.dispatch_attrs = executable->library.v0->exports.attrs;
+  } else {
+    iree_hal_executable_image_release(image);
   }
   if (iree_status_is_ok(status)) {
-    // Attempt to load the ELF module.
-    status = iree_elf_module_initialize_from_memory(
-        elf_data, /*import_table=*/NULL, host_allocator, &executable->module);
-  }
-  if (iree_status_is_ok(status)) {
-    // Query metadata and get the entry point function pointers.
-    status = iree_hal_elf_executable_query_library(executable);
+    // Ensure the host supports the processor features the library was
+    // compiled to use.
+    status = iree_hal_executable_environment_verify_library(
+        environment, *executable->library.header);
   }
   if (iree_status_is_ok(status)) {
     // Resolve imports, if any.
@@ -182,7 +257,7 @@ static iree_status_t iree_hal_elf_executable_create(
 
   if (iree_status_is_ok(status)) {
     *out_executable = (iree_hal_executable_t*)executable;
-  } else {
+  } else if (executable) {
     iree_hal_executable_release((iree_hal_executable_t*)executable);
   }
   IREE_TRACE_ZONE_END(z0);
@@ -196,12 +271,12 @@ static void iree_hal_elf_executable_destroy(
   iree_allocator_t host_allocator = executable->base.host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_elf_module_deinitialize(&executable->module);
-
   if (executable->base.imports != NULL) {
     iree_allocator_free(host_allocator, (void*)executable->base.imports);
   }
 
+  iree_hal_executable_image_release(&executable->image->base);
+
   iree_hal_local_executable_deinitialize(
       (iree_hal_local_executable_t*)base_executable);
   iree_allocator_free(host_allocator, executable);
@@ -332,7 +407,8 @@ static iree_status_t iree_hal_embedded_library_loader_try_load(
       executable_spec->executable_layout_count,
       executable_spec->executable_layouts,
       base_executable_loader->import_provider,
-      executable_loader->host_allocator, out_executable);
+      &base_executable_loader->environment, executable_loader->host_allocator,
+      out_executable);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -13,6 +13,7 @@
 
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
+#include "iree/hal/local/executable_environment.h"
 #include "iree/hal/local/local_executable.h"
 #include "iree/hal/local/local_executable_layout.h"
 
@@ -248,19 +249,38 @@ static iree_status_t iree_hal_static_library_loader_try_load(
   // worth optimizing. We could sort the libraries list by name on loader
   // creation to perform a binary-search fairly easily, though, at the cost of
   // the additional code size.
+  //
+  // Multiple libraries may be registered with the same name when they are
+  // variants specialized for different processors. Registration order is
+  // treated as preference order and the first one the host supports is used.
+  iree_status_t unavailable_status = iree_ok_status();
   for (iree_host_size_t i = 0; i < executable_loader->library_count; ++i) {
     const iree_hal_executable_library_header_t* header =
         *executable_loader->libraries[i];
-    if (iree_string_view_equal(library_name,
-                               iree_make_cstring_view(header->name))) {
-      return iree_hal_static_executable_create(
-          executable_loader->libraries[i],
-          executable_spec->executable_layout_count,
-          executable_spec->executable_layouts,
-          base_executable_loader->import_provider,
-          executable_loader->host_allocator, out_executable);
+    if (!iree_string_view_equal(library_name,
+                                iree_make_cstring_view(header->name))) {
+      continue;
     }
+    iree_status_t status = iree_hal_executable_environment_verify_library(
+        &base_executable_loader->environment, header);
+    if (!iree_status_is_ok(status)) {
+      // Keep the first failure around to report if no variant is usable.
+      if (iree_status_is_ok(unavailable_status)) {
+        unavailable_status = status;
+      } else {
+        iree_status_ignore(status);
+      }
+      continue;
+    }
+    iree_status_ignore(unavailable_status);
+    return iree_hal_static_executable_create(
+        executable_loader->libraries[i],
+        executable_spec->executable_layout_count,
+        executable_spec->executable_layouts,
+        base_executable_loader->import_provider,
+        executable_loader->host_allocator, out_executable);
   }
+  if (!iree_status_is_ok(unavailable_status)) return unavailable_status;
   return iree_make_status(IREE_STATUS_NOT_FOUND,
                           "no static library with the name '%.*s' registered",
                           (int)library_name.size, library_name.data);
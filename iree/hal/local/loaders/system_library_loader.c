@@ -13,6 +13,8 @@
 #include "iree/base/internal/dynamic_library.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
+#include "iree/hal/local/executable_environment.h"
+#include "iree/hal/local/executable_image_cache.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable.h"
 #include "iree/hal/local/local_executable_layout.h"
@@ -71,36 +73,39 @@ iree_hal_system_executable_try_query_footer(
 }
 
 //===----------------------------------------------------------------------===//
-// iree_hal_system_executable_t
+// iree_hal_system_image_t
 //===----------------------------------------------------------------------===//
 
-typedef struct iree_hal_system_executable_t {
-  iree_hal_local_executable_t base;
+// A loaded platform dynamic library shared by all executables created from the
+// same library contents across all devices in the process.
+typedef struct iree_hal_system_image_t {
+  iree_hal_executable_image_t base;
 
   // Loaded platform dynamic library.
   iree_dynamic_library_t* handle;
 
-  // Name used for the file field in tracy and debuggers.
-  iree_string_view_t identifier;
-
   // Queried metadata from the library.
   union {
     const iree_hal_executable_library_header_t** header;
     const iree_hal_executable_library_v0_t* v0;
   } library;
+} iree_hal_system_image_t;
 
-  iree_hal_local_executable_layout_t* layouts[];
-} iree_hal_system_executable_t;
+// Unique address used as the image cache kind for system library images.
+static const char iree_hal_system_image_kind = 0;
 
-static const iree_hal_local_executable_vtable_t
-    iree_hal_system_executable_vtable;
+static void iree_hal_system_image_destroy(
+    iree_hal_executable_image_t* base_image) {
+  iree_hal_system_image_t* image = (iree_hal_system_image_t*)base_image;
+  iree_dynamic_library_release(image->handle);
+  iree_allocator_free(iree_allocator_system(), image);
+}
 
-// Loads the executable and optional debug database from the given
-// |executable_data| in memory. The memory must remain live for the lifetime
-// of the executable.
-static iree_status_t iree_hal_system_executable_load(
-    iree_hal_system_executable_t* executable,
-    iree_const_byte_span_t executable_data, iree_allocator_t host_allocator) {
+// Loads the library and optional debug database from the given
+// |executable_data| in memory. The contents are copied out by the platform
+// loader and the memory need not remain live after this returns.
+static iree_status_t iree_hal_system_image_load_library(
+    iree_hal_system_image_t* image, iree_const_byte_span_t executable_data) {
   // Check to see if the library has a footer indicating embedded debug data.
   iree_const_byte_span_t library_data = iree_make_const_byte_span(NULL, 0);
   iree_const_byte_span_t debug_data = iree_make_const_byte_span(NULL, 0);
@@ -127,35 +132,35 @@ static iree_status_t iree_hal_system_executable_load(
 
   IREE_RETURN_IF_ERROR(iree_dynamic_library_load_from_memory(
       iree_make_cstring_view("aot"), library_data,
-      IREE_DYNAMIC_LIBRARY_FLAG_NONE, host_allocator, &executable->handle));
+      IREE_DYNAMIC_LIBRARY_FLAG_NONE, iree_allocator_system(), &image->handle));
 
   if (debug_data.data_length > 0) {
     IREE_RETURN_IF_ERROR(iree_dynamic_library_attach_symbols_from_memory(
-        executable->handle, debug_data));
+        image->handle, debug_data));
   }
 
   return iree_ok_status();
 }
 
-static iree_status_t iree_hal_system_executable_query_library(
-    iree_hal_system_executable_t* executable) {
+static iree_status_t iree_hal_system_image_query_library(
+    iree_hal_system_image_t* image,
+    const iree_hal_executable_environment_v0_t* environment) {
   // Get the exported symbol used to get the library metadata.
   iree_hal_executable_library_query_fn_t query_fn = NULL;
   IREE_RETURN_IF_ERROR(iree_dynamic_library_lookup_symbol(
-      executable->handle, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
+      image->handle, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
       (void**)&query_fn));
 
   // Query for a compatible version of the library.
-  executable->library.header =
-      query_fn(IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION, /*reserved=*/NULL);
-  if (!executable->library.header) {
+  image->library.header =
+      query_fn(IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION, environment);
+  if (!image->library.header) {
     return iree_make_status(
         IREE_STATUS_FAILED_PRECONDITION,
         "executable does not support this version of the runtime (%d)",
         IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION);
   }
-  const iree_hal_executable_library_header_t* header =
-      *executable->library.header;
+  const iree_hal_executable_library_header_t* header = *image->library.header;
 
   // Ensure that if the library is built for a particular sanitizer that we also
   // were compiled with that sanitizer enabled.
@@ -186,13 +191,68 @@ static iree_status_t iree_hal_system_executable_query_library(
           (uint32_t)header->sanitizer);
   }
 
-  executable->identifier = iree_make_cstring_view(header->name);
+  return iree_ok_status();
+}
+
+// Loads a system library image; called by the image cache when the contents
+// have not been loaded before.
+static iree_status_t iree_hal_system_image_load(
+    void* user_data, iree_const_byte_span_t executable_data,
+    iree_hal_executable_image_t** out_image) {
+  const iree_hal_executable_environment_v0_t* environment =
+      (const iree_hal_executable_environment_v0_t*)user_data;
+  IREE_TRACE_ZONE_BEGIN(z0);
 
-  executable->base.dispatch_attrs = executable->library.v0->exports.attrs;
+  // Images outlive the device that first loaded them and must use an
+  // allocator that outlives all devices.
+  iree_hal_system_image_t* image = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(iree_allocator_system(), sizeof(*image),
+                                (void**)&image));
+  image->base.destroy = iree_hal_system_image_destroy;
 
-  return iree_ok_status();
+  // Attempt to extract the embedded library and load it.
+  iree_status_t status =
+      iree_hal_system_image_load_library(image, executable_data);
+  if (iree_status_is_ok(status)) {
+    // Query metadata and get the entry point function pointers.
+    status = iree_hal_system_image_query_library(image, environment);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_image = &image->base;
+  } else {
+    iree_hal_system_image_destroy(&image->base);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
+//===----------------------------------------------------------------------===//
+// iree_hal_system_executable_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_system_executable_t {
+  iree_hal_local_executable_t base;
+
+  // Shared library image; retained for the lifetime of the executable.
+  iree_hal_system_image_t* image;
+
+  // Name used for the file field in tracy and debuggers.
+  iree_string_view_t identifier;
+
+  // Queried metadata from the library (owned by |image|).
+  union {
+    const iree_hal_executable_library_header_t** header;
+    const iree_hal_executable_library_v0_t* v0;
+  } library;
+
+  iree_hal_local_executable_layout_t* layouts[];
+} iree_hal_system_executable_t;
+
+static const iree_hal_local_executable_vtable_t
+    iree_hal_system_executable_vtable;
+
 static int iree_hal_system_executable_import_thunk_v0(
     iree_hal_executable_import_v0_t fn_ptr, void* import_params) {
   return fn_ptr(import_params);
@@ -239,6 +299,7 @@ static iree_status_t iree_hal_system_executable_create(
     iree_host_size_t executable_layout_count,
     iree_hal_executable_layout_t* const* executable_layouts,
     const iree_hal_executable_import_provider_t import_provider,
+    const iree_hal_executable_environment_v0_t* environment,
     iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(executable_data.data && executable_data.data_length);
   IREE_ASSERT_ARGUMENT(!executable_layout_count || executable_layouts);
@@ -246,6 +307,14 @@ static iree_status_t iree_hal_system_executable_create(
   *out_executable = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Load the library (or reuse the image already loaded from the same
+  // contents).
+  iree_hal_executable_image_t* image = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_executable_image_cache_acquire(
+              &iree_hal_system_image_kind, executable_data,
+              iree_hal_system_image_load, (void*)environment, &image));
+
   iree_hal_system_executable_t* executable = NULL;
   iree_host_size_t total_size =
       sizeof(*executable) +
@@ -257,15 +326,19 @@ static iree_status_t iree_hal_system_executable_create(
         &iree_hal_system_executable_vtable, executable_layout_count,
         executable_layouts, &executable->layouts[0], host_allocator,
         &executable->base);
+    executable->image = (iree_hal_system_image_t*)image;
+    executable->library.header = executable->image->library.header;
+    executable->identifier =
+        iree_make_cstring_view((*executable->library.header)->name);
+    executable->base.dispatch_attrs = executable->library.v0->exports.attrs;
+  } else {
+    iree_hal_executable_image_release(image);
   }
   if (iree_status_is_ok(status)) {
-    // Attempt to extract the embedded library and load it.
-    status = iree_hal_system_executable_load(executable, executable_data,
-                                             host_allocator);
-  }
-  if (iree_status_is_ok(status)) {
-    // Query metadata and get the entry point function pointers.
-    status = iree_hal_system_executable_query_library(executable);
+    // Ensure the host supports the processor features the library was
+    // compiled to use.
+    status = iree_hal_executable_environment_verify_library(
+        environment, *executable->library.header);
   }
   if (iree_status_is_ok(status)) {
     // Resolve imports, if any.
@@ -286,7 +359,7 @@ static iree_status_t iree_hal_system_executable_create(
 
   if (iree_status_is_ok(status)) {
     *out_executable = (iree_hal_executable_t*)executable;
-  } else {
+  } else if (executable) {
     iree_hal_executable_release((iree_hal_executable_t*)executable);
   }
   IREE_TRACE_ZONE_END(z0);
@@ -300,7 +373,11 @@ static void iree_hal_system_executable_destroy(
   iree_allocator_t host_allocator = executable->base.host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_dynamic_library_release(executable->handle);
+  if (executable->base.imports != NULL) {
+    iree_allocator_free(host_allocator, (void*)executable->base.imports);
+  }
+
+  iree_hal_executable_image_release(&executable->image->base);
 
   iree_hal_local_executable_deinitialize(
       (iree_hal_local_executable_t*)base_executable);
@@ -443,6 +520,7 @@ static iree_status_t iree_hal_system_library_loader_try_load(
               executable_spec->executable_layout_count,
               executable_spec->executable_layouts,
               base_executable_loader->import_provider,
+              &base_executable_loader->environment,
               executable_loader->host_allocator, out_executable));
 
   IREE_TRACE_ZONE_END(z0);
@@ -154,51 +154,109 @@ static void iree_hal_vmvx_executable_destroy(
   IREE_TRACE_ZONE_END(z0);
 }
 
-static iree_status_t iree_hal_vmvx_executable_issue_call(
-    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+// Call arguments of an entry point. We've verified the signature on creation
+// and know the exact format we can assume here.
+//
+//   func @entry(
+//       %local_memory: !vmvx.buffer,
+//       %constants: !vmvx.buffer,
+//       %bindings: !util.list<!vmvx.buffer>,
+//       %workgroup_x: index,
+//       %workgroup_y: index,
+//       %workgroup_z: index,
+//       %workgroup_size_x: index,
+//       %workgroup_size_y: index,
+//       %workgroup_size_z: index,
+//       %workgroup_count_x: index,
+//       %workgroup_count_y: index,
+//       %workgroup_count_z: index
+//    )
+//
+// NOTE: this level of the VM ABI is supported - but may change in the future.
+// Users should prefer to use the invocation API that is more stable.
+typedef struct iree_hal_vmvx_call_args_t {
+  iree_vm_ref_t local_memory;
+  iree_vm_ref_t constants;
+  iree_vm_ref_t bindings;
+  uint32_t workgroup_x;
+  uint32_t workgroup_y;
+  uint32_t workgroup_z;
+  uint32_t workgroup_size_x;
+  uint32_t workgroup_size_y;
+  uint32_t workgroup_size_z;
+  uint32_t workgroup_count_x;
+  uint32_t workgroup_count_y;
+  uint32_t workgroup_count_z;
+} iree_hal_vmvx_call_args_t;
+
+// Interface of a dispatch shared by all of the workgroups issued with it.
+// The bindings, push constants, and local memory are wrapped in VM types once
+// and only the workgroup ID changes between calls.
+typedef struct iree_hal_vmvx_dispatch_t {
+  iree_vm_function_t entry_fn;
+  iree_host_size_t binding_count;
+  iree_vm_buffer_t* binding_buffers;
+  iree_vm_list_t* binding_list;
+  iree_vm_buffer_t local_memory_buffer;
+  iree_vm_buffer_t constants_buffer;
+  iree_hal_vmvx_call_args_t call_args;
+} iree_hal_vmvx_dispatch_t;
+
+// Returns the size of the storage required by a dispatch with |binding_count|
+// bindings.
+static iree_host_size_t iree_hal_vmvx_dispatch_storage_size(
+    iree_host_size_t binding_count) {
+  iree_vm_type_def_t buffer_type =
+      iree_vm_type_def_make_ref_type(iree_vm_buffer_type_id());
+  return iree_host_align(iree_vm_list_storage_size(&buffer_type, binding_count),
+                         iree_max_align_t) +
+         binding_count * sizeof(iree_vm_buffer_t);
+}
+
+// Initializes |out_dispatch| in |storage| of at least
+// iree_hal_vmvx_dispatch_storage_size bytes. The dispatch must be
+// deinitialized with iree_hal_vmvx_dispatch_deinitialize, even on failure.
+static iree_status_t iree_hal_vmvx_dispatch_initialize(
+    iree_hal_vmvx_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
-    const iree_hal_vec3_t* workgroup_id, iree_byte_span_t local_memory) {
-  iree_hal_vmvx_executable_t* executable =
-      (iree_hal_vmvx_executable_t*)base_executable;
+    iree_byte_span_t local_memory, iree_byte_span_t storage,
+    iree_hal_vmvx_dispatch_t* out_dispatch) {
+  memset(out_dispatch, 0, sizeof(*out_dispatch));
+
+  // Acquire workgroup local memory for the dispatch.
+  iree_vm_buffer_initialize(
+      IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
+      local_memory, iree_allocator_null(), &out_dispatch->local_memory_buffer);
+
+  // Map the push constant memory directly from the dispatch state.
+  iree_vm_buffer_initialize(
+      IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
+      iree_make_byte_span(
+          (void*)dispatch_state->push_constants,
+          sizeof(uint32_t) * dispatch_state->push_constant_count),
+      iree_allocator_null(), &out_dispatch->constants_buffer);
 
   if (IREE_UNLIKELY(ordinal >= executable->entry_fn_count)) {
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "entry point ordinal out of bounds");
   }
-  iree_vm_function_t entry_fn = executable->entry_fns[ordinal];
-
-#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
-  iree_string_view_t entry_point_name = iree_vm_function_name(&entry_fn);
-  if (iree_string_view_is_empty(entry_point_name)) {
-    entry_point_name = iree_make_cstring_view("unknown_vmvx_call");
-  }
-  IREE_TRACE_ZONE_BEGIN_NAMED_DYNAMIC(z0, entry_point_name.data,
-                                      entry_point_name.size);
-#endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+  out_dispatch->entry_fn = executable->entry_fns[ordinal];
 
-  // On-stack interface local to this invocation.
-  // Note that we _could_ share this across all invocations in a dispatch, but
-  // it's tricky to find a good place when threading is happening and it's
-  // intentionally fairly cheap to construct by matching the dispatch_state.
-  // The list would only need to be constructed once and we could avoid the
-  // extraneous retain/releases and mappings.
+  // Interface list local to this dispatch.
   iree_vm_type_def_t buffer_type =
       iree_vm_type_def_make_ref_type(iree_vm_buffer_type_id());
-  iree_host_size_t binding_list_size =
-      iree_vm_list_storage_size(&buffer_type, dispatch_state->binding_count);
-  void* binding_list_storage = iree_alloca(binding_list_size);
-  iree_vm_list_t* binding_list = NULL;
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_vm_list_initialize(
-              iree_make_byte_span(binding_list_storage, binding_list_size),
-              &buffer_type, dispatch_state->binding_count, &binding_list));
-  iree_vm_list_retain(binding_list);  // for call
-
-  // Map bindings into on-stack VMVX buffers.
-  iree_vm_buffer_t* binding_buffers = (iree_vm_buffer_t*)iree_alloca(
-      dispatch_state->binding_count * sizeof(iree_vm_buffer_t));
+  iree_host_size_t binding_list_size = iree_host_align(
+      iree_vm_list_storage_size(&buffer_type, dispatch_state->binding_count),
+      iree_max_align_t);
+  IREE_RETURN_IF_ERROR(iree_vm_list_initialize(
+      iree_make_byte_span(storage.data, binding_list_size), &buffer_type,
+      dispatch_state->binding_count, &out_dispatch->binding_list));
+
+  // Map bindings into VMVX buffers.
+  out_dispatch->binding_buffers =
+      (iree_vm_buffer_t*)(storage.data + binding_list_size);
   for (iree_host_size_t i = 0; i < dispatch_state->binding_count; ++i) {
-    iree_vm_buffer_t* binding_buffer = &binding_buffers[i];
+    iree_vm_buffer_t* binding_buffer = &out_dispatch->binding_buffers[i];
     // TODO(benvanik): executable layout contains the required access
     // information. We will likely want to encode a bitmap of mutable bindings
     // such that we can quickly set the access bit, though.
@@ -209,121 +267,158 @@ static iree_status_t iree_hal_vmvx_executable_issue_call(
         iree_make_byte_span(dispatch_state->binding_ptrs[i],
                             dispatch_state->binding_lengths[i]),
         iree_allocator_null(), binding_buffer);
+    ++out_dispatch->binding_count;
     iree_vm_ref_t ref = {0};
-    IREE_RETURN_AND_END_ZONE_IF_ERROR(
-        z0, iree_vm_ref_wrap_assign(binding_buffer, iree_vm_buffer_type_id(),
-                                    &ref));
-    IREE_RETURN_AND_END_ZONE_IF_ERROR(
-        z0, iree_vm_list_push_ref_retain(binding_list, &ref));
+    IREE_RETURN_IF_ERROR(iree_vm_ref_wrap_assign(
+        binding_buffer, iree_vm_buffer_type_id(), &ref));
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_push_ref_retain(out_dispatch->binding_list, &ref));
   }
 
-  // Acquire workgroup local memory for the dispatch.
-  iree_vm_buffer_t local_memory_buffer;
-  iree_vm_buffer_initialize(
-      IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
-      local_memory, iree_allocator_null(), &local_memory_buffer);
-  iree_vm_buffer_retain(&local_memory_buffer);  // for call
+  iree_hal_vmvx_call_args_t* call_args = &out_dispatch->call_args;
+  call_args->local_memory.type = iree_vm_buffer_type_id();
+  call_args->local_memory.ptr = &out_dispatch->local_memory_buffer;
+  call_args->constants.type = iree_vm_buffer_type_id();
+  call_args->constants.ptr = &out_dispatch->constants_buffer;
+  call_args->bindings.type = iree_vm_list_type_id();
+  call_args->bindings.ptr = out_dispatch->binding_list;
+  call_args->workgroup_size_x = dispatch_state->workgroup_size.x;
+  call_args->workgroup_size_y = dispatch_state->workgroup_size.y;
+  call_args->workgroup_size_z = dispatch_state->workgroup_size.z;
+  call_args->workgroup_count_x = dispatch_state->workgroup_count.x;
+  call_args->workgroup_count_y = dispatch_state->workgroup_count.y;
+  call_args->workgroup_count_z = dispatch_state->workgroup_count.z;
+  return iree_ok_status();
+}
 
-  // Map the push constant memory directly from the dispatch state.
-  iree_vm_buffer_t constants_buffer;
-  iree_vm_buffer_initialize(
-      IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
-      iree_make_byte_span(
-          (void*)dispatch_state->push_constants,
-          sizeof(uint32_t) * dispatch_state->push_constant_count),
-      iree_allocator_null(), &constants_buffer);
-  iree_vm_buffer_retain(&constants_buffer);  // for call
-
-  // Prepare call argument buffer. We've verified the signature on creation and
-  // know the exact format we can assume here.
-  //
-  //   func @entry(
-  //       %local_memory: !vmvx.buffer,
-  //       %constants: !vmvx.buffer,
-  //       %bindings: !util.list<!vmvx.buffer>,
-  //       %workgroup_x: index,
-  //       %workgroup_y: index,
-  //       %workgroup_z: index,
-  //       %workgroup_size_x: index,
-  //       %workgroup_size_y: index,
-  //       %workgroup_size_z: index,
-  //       %workgroup_count_x: index,
-  //       %workgroup_count_y: index,
-  //       %workgroup_count_z: index
-  //    )
-  //
-  // NOTE: this level of the VM ABI is supported - but may change in the future.
-  // Users should prefer to use the invocation API that is more stable.
-  struct {
-    iree_vm_ref_t local_memory;
-    iree_vm_ref_t constants;
-    iree_vm_ref_t bindings;
-    uint32_t workgroup_x;
-    uint32_t workgroup_y;
-    uint32_t workgroup_z;
-    uint32_t workgroup_size_x;
-    uint32_t workgroup_size_y;
-    uint32_t workgroup_size_z;
-    uint32_t workgroup_count_x;
-    uint32_t workgroup_count_y;
-    uint32_t workgroup_count_z;
-  } call_args = {
-      .local_memory =
-          {
-              .type = iree_vm_buffer_type_id(),
-              .ptr = &local_memory_buffer,
-              .offsetof_counter = 0,
-          },
-      .constants =
-          {
-              .type = iree_vm_buffer_type_id(),
-              .ptr = &constants_buffer,
-              .offsetof_counter = 0,
-          },
-      .bindings =
-          {
-              .type = iree_vm_list_type_id(),
-              .ptr = binding_list,
-              .offsetof_counter = 0,
-          },
-      .workgroup_x = workgroup_id->x,
-      .workgroup_y = workgroup_id->y,
-      .workgroup_z = workgroup_id->z,
-      .workgroup_size_x = dispatch_state->workgroup_size.x,
-      .workgroup_size_y = dispatch_state->workgroup_size.y,
-      .workgroup_size_z = dispatch_state->workgroup_size.z,
-      .workgroup_count_x = dispatch_state->workgroup_count.x,
-      .workgroup_count_y = dispatch_state->workgroup_count.y,
-      .workgroup_count_z = dispatch_state->workgroup_count.z,
-  };
-
-  // On-stack stack. We really do abuse the stack too much here.
-  // TODO(benvanik): pass in an iree_arena_t that can be used for this.
-  IREE_VM_INLINE_STACK_INITIALIZE(
-      stack, IREE_VM_INVOCATION_FLAG_NONE,
-      iree_vm_context_state_resolver(executable->context),
-      executable->base.host_allocator);
+static void iree_hal_vmvx_dispatch_deinitialize(
+    iree_hal_vmvx_dispatch_t* dispatch) {
+  iree_vm_buffer_deinitialize(&dispatch->local_memory_buffer);
+  iree_vm_buffer_deinitialize(&dispatch->constants_buffer);
+  if (dispatch->binding_list) {
+    iree_vm_list_deinitialize(dispatch->binding_list);
+  }
+  for (iree_host_size_t i = 0; i < dispatch->binding_count; ++i) {
+    iree_vm_buffer_deinitialize(&dispatch->binding_buffers[i]);
+  }
+}
+
+// Calls the entry point of |dispatch| for |workgroup_id| on |stack|.
+static iree_status_t iree_hal_vmvx_dispatch_issue_workgroup(
+    iree_hal_vmvx_dispatch_t* dispatch, iree_vm_stack_t* stack,
+    const iree_hal_vec3_t* workgroup_id) {
+  iree_vm_function_t entry_fn = dispatch->entry_fn;
+
+#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+  iree_string_view_t entry_point_name = iree_vm_function_name(&entry_fn);
+  if (iree_string_view_is_empty(entry_point_name)) {
+    entry_point_name = iree_make_cstring_view("unknown_vmvx_call");
+  }
+  IREE_TRACE_ZONE_BEGIN_NAMED_DYNAMIC(z0, entry_point_name.data,
+                                      entry_point_name.size);
+#endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+
+  // The call consumes a reference to each of the arguments.
+  iree_vm_buffer_retain(&dispatch->local_memory_buffer);
+  iree_vm_buffer_retain(&dispatch->constants_buffer);
+  iree_vm_list_retain(dispatch->binding_list);
+
+  iree_hal_vmvx_call_args_t* call_args = &dispatch->call_args;
+  call_args->workgroup_x = workgroup_id->x;
+  call_args->workgroup_y = workgroup_id->y;
+  call_args->workgroup_z = workgroup_id->z;
 
   // Direct call interface.
   iree_vm_function_call_t call;
   memset(&call, 0, sizeof(call));
   call.function = entry_fn;
-  call.arguments = iree_make_byte_span(&call_args, sizeof(call_args));
+  call.arguments = iree_make_byte_span(call_args, sizeof(*call_args));
   call.results = iree_make_byte_span(NULL, 0);
   iree_vm_execution_result_t result;
   iree_status_t status =
       entry_fn.module->begin_call(entry_fn.module->self, stack, &call, &result);
 
-  iree_vm_stack_deinitialize(stack);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
 
-  iree_vm_buffer_deinitialize(&local_memory_buffer);
-  iree_vm_buffer_deinitialize(&constants_buffer);
-  iree_vm_list_deinitialize(binding_list);
-  for (iree_host_size_t i = 0; i < dispatch_state->binding_count; ++i) {
-    iree_vm_buffer_deinitialize(&binding_buffers[i]);
+static iree_status_t iree_hal_vmvx_executable_issue_call(
+    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_vec3_t* workgroup_id, iree_byte_span_t local_memory) {
+  iree_hal_vmvx_executable_t* executable =
+      (iree_hal_vmvx_executable_t*)base_executable;
+
+  // On-stack interface local to this invocation. Dispatches issued inline
+  // share it across all workgroups (see issue_dispatch_inline) but it's tricky
+  // to find a good place when threading is happening and it's intentionally
+  // fairly cheap to construct by matching the dispatch_state.
+  iree_host_size_t storage_size =
+      iree_hal_vmvx_dispatch_storage_size(dispatch_state->binding_count);
+  iree_byte_span_t storage =
+      iree_make_byte_span(iree_alloca(storage_size), storage_size);
+  iree_hal_vmvx_dispatch_t dispatch;
+  iree_status_t status = iree_hal_vmvx_dispatch_initialize(
+      executable, ordinal, dispatch_state, local_memory, storage, &dispatch);
+
+  if (iree_status_is_ok(status)) {
+    // On-stack stack. We really do abuse the stack too much here.
+    // TODO(benvanik): pass in an iree_arena_t that can be used for this.
+    IREE_VM_INLINE_STACK_INITIALIZE(
+        stack, IREE_VM_INVOCATION_FLAG_NONE,
+        iree_vm_context_state_resolver(executable->context),
+        executable->base.host_allocator);
+    status =
+        iree_hal_vmvx_dispatch_issue_workgroup(&dispatch, stack, workgroup_id);
+    iree_vm_stack_deinitialize(stack);
   }
 
-  IREE_TRACE_ZONE_END(z0);
+  iree_hal_vmvx_dispatch_deinitialize(&dispatch);
+  return status;
+}
+
+static iree_status_t iree_hal_vmvx_executable_issue_dispatch_inline(
+    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    iree_byte_span_t local_memory) {
+  iree_hal_vmvx_executable_t* executable =
+      (iree_hal_vmvx_executable_t*)base_executable;
+
+  // The interface and the VM stack are set up once and reused by all
+  // workgroups as they are issued sequentially.
+  iree_host_size_t storage_size =
+      iree_hal_vmvx_dispatch_storage_size(dispatch_state->binding_count);
+  iree_byte_span_t storage =
+      iree_make_byte_span(iree_alloca(storage_size), storage_size);
+  iree_hal_vmvx_dispatch_t dispatch;
+  iree_status_t status = iree_hal_vmvx_dispatch_initialize(
+      executable, ordinal, dispatch_state, local_memory, storage, &dispatch);
+
+  if (iree_status_is_ok(status)) {
+    IREE_VM_INLINE_STACK_INITIALIZE(
+        stack, IREE_VM_INVOCATION_FLAG_NONE,
+        iree_vm_context_state_resolver(executable->context),
+        executable->base.host_allocator);
+    const iree_hal_vec3_t workgroup_count = dispatch_state->workgroup_count;
+    iree_hal_vec3_t workgroup_id;
+    for (workgroup_id.z = 0;
+         workgroup_id.z < workgroup_count.z && iree_status_is_ok(status);
+         ++workgroup_id.z) {
+      for (workgroup_id.y = 0;
+           workgroup_id.y < workgroup_count.y && iree_status_is_ok(status);
+           ++workgroup_id.y) {
+        for (workgroup_id.x = 0;
+             workgroup_id.x < workgroup_count.x && iree_status_is_ok(status);
+             ++workgroup_id.x) {
+          status = iree_hal_vmvx_dispatch_issue_workgroup(&dispatch, stack,
+                                                          &workgroup_id);
+        }
+      }
+    }
+    iree_vm_stack_deinitialize(stack);
+  }
+
+  iree_hal_vmvx_dispatch_deinitialize(&dispatch);
   return status;
 }
 
@@ -334,6 +429,7 @@ static const iree_hal_local_executable_vtable_t
                 .destroy = iree_hal_vmvx_executable_destroy,
             },
         .issue_call = iree_hal_vmvx_executable_issue_call,
+        .issue_dispatch_inline = iree_hal_vmvx_executable_issue_dispatch_inline,
 };
 
 //===----------------------------------------------------------------------===//
@@ -78,6 +78,15 @@ iree_status_t iree_hal_local_executable_issue_dispatch_inline(
   IREE_TRACE_ZONE_APPEND_TEXT_STRING_VIEW(z0, xyz_string, xyz_string_length);
 #endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
+  const iree_hal_local_executable_vtable_t* vtable =
+      (const iree_hal_local_executable_vtable_t*)executable->resource.vtable;
+  if (vtable->issue_dispatch_inline) {
+    iree_status_t status = vtable->issue_dispatch_inline(
+        executable, ordinal, dispatch_state, local_memory);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
   iree_status_t status = iree_ok_status();
 
   iree_hal_vec3_t workgroup_id;
@@ -97,3 +106,13 @@ iree_status_t iree_hal_local_executable_issue_dispatch_inline(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+iree_fpu_state_flags_t iree_hal_local_executable_fpu_state_flags(
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal) {
+  if (executable->dispatch_attrs &&
+      (executable->dispatch_attrs[ordinal].flags &
+       IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_PRESERVE_DENORMALS)) {
+    return IREE_FPU_STATE_DEFAULT;
+  }
+  return IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO;
+}
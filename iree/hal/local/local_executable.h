@@ -8,6 +8,7 @@
 #define IREE_HAL_LOCAL_LOCAL_EXECUTABLE_H_
 
 #include "iree/base/api.h"
+#include "iree/base/internal/fpu_state.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable_layout.h"
@@ -43,6 +44,14 @@ typedef struct iree_hal_local_executable_vtable_t {
       iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
       const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
       const iree_hal_vec3_t* workgroup_id, iree_byte_span_t local_memory);
+
+  // Optional; issues all workgroups of a dispatch in order on the calling
+  // thread. Executables with per-call setup costs can share the setup across
+  // the workgroups. When NULL each workgroup is issued with |issue_call|.
+  iree_status_t(IREE_API_PTR* issue_dispatch_inline)(
+      iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
+      const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+      iree_byte_span_t local_memory);
 } iree_hal_local_executable_vtable_t;
 
 // Initializes the local executable base type.
@@ -73,6 +82,12 @@ iree_status_t iree_hal_local_executable_issue_dispatch_inline(
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
     iree_byte_span_t local_memory);
 
+// Returns the FPU state the workgroups of entry point |ordinal| must be
+// executed with. Denormals are flushed to zero unless the entry point requests
+// that they are preserved.
+iree_fpu_state_flags_t iree_hal_local_executable_fpu_state_flags(
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
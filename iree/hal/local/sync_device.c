@@ -10,8 +10,12 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "iree/base/internal/arena.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/local/executable_environment.h"
 #include "iree/hal/local/inline_command_buffer.h"
+#include "iree/hal/local/inline_worker_pool.h"
 #include "iree/hal/local/local_descriptor_set.h"
 #include "iree/hal/local/local_descriptor_set_layout.h"
 #include "iree/hal/local/local_executable_cache.h"
@@ -19,6 +23,7 @@
 #include "iree/hal/local/sync_event.h"
 #include "iree/hal/local/sync_semaphore.h"
 #include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/utils/deferred_command_buffer.h"
 
 typedef struct iree_hal_sync_device_t {
   iree_hal_resource_t resource;
@@ -27,7 +32,11 @@ typedef struct iree_hal_sync_device_t {
   iree_allocator_t host_allocator;
   iree_hal_allocator_t* device_allocator;
 
-  iree_hal_sync_semaphore_state_t semaphore_state;
+  // Block pool used for command buffer transient allocations.
+  iree_arena_block_pool_t large_block_pool;
+
+  // Optional pool used to distribute large dispatches; NULL if disabled.
+  iree_hal_inline_worker_pool_t* worker_pool;
 
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t* loaders[];
@@ -44,10 +53,17 @@ static iree_hal_sync_device_t* iree_hal_sync_device_cast(
 void iree_hal_sync_device_params_initialize(
     iree_hal_sync_device_params_t* out_params) {
   memset(out_params, 0, sizeof(*out_params));
+  out_params->arena_block_size = 32 * 1024;
+  out_params->worker_count = 0;
+  out_params->worker_min_workgroup_count = 16;
 }
 
 static iree_status_t iree_hal_sync_device_check_params(
     const iree_hal_sync_device_params_t* params) {
+  if (params->arena_block_size < 4096) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "arena block size too small (< 4096 bytes)");
+  }
   return iree_ok_status();
 }
 
@@ -82,13 +98,22 @@ iree_status_t iree_hal_sync_device_create(
     device->device_allocator = device_allocator;
     iree_hal_allocator_retain(device_allocator);
 
+    iree_arena_block_pool_initialize(params->arena_block_size, host_allocator,
+                                     &device->large_block_pool);
+
+#if !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+    if (params->worker_count > 0) {
+      status = iree_hal_inline_worker_pool_create(
+          params->worker_count, params->worker_min_workgroup_count,
+          host_allocator, &device->worker_pool);
+    }
+#endif  // !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
     device->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < device->loader_count; ++i) {
       device->loaders[i] = loaders[i];
       iree_hal_executable_loader_retain(device->loaders[i]);
     }
-
-    iree_hal_sync_semaphore_state_initialize(&device->semaphore_state);
   }
 
   if (iree_status_is_ok(status)) {
@@ -105,11 +130,11 @@ static void iree_hal_sync_device_destroy(iree_hal_device_t* base_device) {
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_hal_sync_semaphore_state_deinitialize(&device->semaphore_state);
-
   for (iree_host_size_t i = 0; i < device->loader_count; ++i) {
     iree_hal_executable_loader_release(device->loaders[i]);
   }
+  iree_hal_inline_worker_pool_free(device->worker_pool);
+  iree_arena_block_pool_deinitialize(&device->large_block_pool);
   iree_hal_allocator_release(device->device_allocator);
   iree_allocator_free(host_allocator, device);
 
@@ -136,6 +161,7 @@ static iree_hal_allocator_t* iree_hal_sync_device_allocator(
 
 static iree_status_t iree_hal_sync_device_trim(iree_hal_device_t* base_device) {
   iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  iree_arena_block_pool_trim(&device->large_block_pool);
   return iree_hal_allocator_trim(device->device_allocator);
 }
 
@@ -153,6 +179,17 @@ static iree_status_t iree_hal_sync_device_query_i32(
             ? 1
             : 0;
     return iree_ok_status();
+  } else if (iree_string_view_equal(
+                 category, iree_make_cstring_view("hal.device.feature"))) {
+    // Processor features are used to select between executable variants
+    // specialized for different CPU microarchitectures.
+    iree_hal_executable_environment_v0_t environment;
+    iree_hal_executable_environment_initialize(&environment);
+    *out_value =
+        iree_hal_executable_environment_supports_feature(&environment, key)
+            ? 1
+            : 0;
+    return iree_ok_status();
   }
 
   return iree_make_status(
@@ -166,11 +203,22 @@ static iree_status_t iree_hal_sync_device_create_command_buffer(
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_command_buffer_t** out_command_buffer) {
-  // TODO(#4680): implement a non-inline command buffer that stores its commands
-  // and can be submitted later on/multiple-times.
-  return iree_hal_inline_command_buffer_create(
-      base_device, mode, command_categories, queue_affinity,
-      iree_hal_device_host_allocator(base_device), out_command_buffer);
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  if (iree_all_bits_set(
+          mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT |
+                    IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION)) {
+    // The caller is ok with us executing the commands as they are recorded.
+    return iree_hal_inline_command_buffer_create(
+        base_device, mode, command_categories, queue_affinity,
+        &device->large_block_pool, device->worker_pool, device->host_allocator,
+        out_command_buffer);
+  }
+  // Record the commands and replay them against an inline command buffer when
+  // submitted. This allows the command buffer to be submitted later and, if
+  // not one-shot, multiple times.
+  return iree_hal_deferred_command_buffer_create(
+      base_device, mode, command_categories, &device->large_block_pool,
+      device->host_allocator, out_command_buffer);
 }
 
 static iree_status_t iree_hal_sync_device_create_descriptor_set(
@@ -223,8 +271,41 @@ static iree_status_t iree_hal_sync_device_create_semaphore(
     iree_hal_device_t* base_device, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore) {
   iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
-  return iree_hal_sync_semaphore_create(&device->semaphore_state, initial_value,
-                                        device->host_allocator, out_semaphore);
+  return iree_hal_sync_semaphore_create(initial_value, device->host_allocator,
+                                        out_semaphore);
+}
+
+// Replays all deferred command buffers in |command_buffers| on the calling
+// thread. Inline command buffers have already executed during recording.
+static iree_status_t iree_hal_sync_device_apply_deferred_command_buffers(
+    iree_hal_sync_device_t* device, iree_host_size_t command_buffer_count,
+    iree_hal_command_buffer_t* const* command_buffers) {
+  for (iree_host_size_t i = 0; i < command_buffer_count; ++i) {
+    iree_hal_command_buffer_t* command_buffer = command_buffers[i];
+    if (!iree_hal_deferred_command_buffer_isa(command_buffer)) continue;
+    IREE_TRACE_ZONE_BEGIN(z0);
+
+    // NOTE: the transient inline command buffer shares the device block pool
+    // so replaying does not hit the system allocator for local memory once
+    // the pool has warmed up.
+    iree_hal_command_buffer_t* inline_command_buffer = NULL;
+    iree_status_t status = iree_hal_inline_command_buffer_create(
+        (iree_hal_device_t*)device,
+        IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT |
+            IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
+        iree_hal_command_buffer_allowed_categories(command_buffer),
+        IREE_HAL_QUEUE_AFFINITY_ANY, &device->large_block_pool,
+        device->worker_pool, device->host_allocator, &inline_command_buffer);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_deferred_command_buffer_apply(command_buffer,
+                                                      inline_command_buffer);
+    }
+    iree_hal_command_buffer_release(inline_command_buffer);
+
+    IREE_TRACE_ZONE_END(z0);
+    IREE_RETURN_IF_ERROR(status);
+  }
+  return iree_ok_status();
 }
 
 static iree_status_t iree_hal_sync_device_queue_submit(
@@ -237,22 +318,24 @@ static iree_status_t iree_hal_sync_device_queue_submit(
   // TODO(#4680): there is some better error handling here needed; we should
   // propagate failures to all signal semaphores. Today we aren't as there
   // shouldn't be any failures or if there are there's not much we'd be able to
-  // do - we already executed everything inline!
+  // do - everything executes synchronously on this thread!
 
   for (iree_host_size_t i = 0; i < batch_count; ++i) {
     const iree_hal_submission_batch_t* batch = &batches[i];
 
     // Wait for semaphores to be signaled before performing any work.
     IREE_RETURN_IF_ERROR(iree_hal_sync_semaphore_multi_wait(
-        &device->semaphore_state, IREE_HAL_WAIT_MODE_ALL,
-        &batch->wait_semaphores, iree_infinite_timeout()));
+        IREE_HAL_WAIT_MODE_ALL, &batch->wait_semaphores,
+        iree_infinite_timeout()));
 
-    // TODO(#4680): if we were doing deferred submissions we would issue them
-    // here. With only inline command buffers we have nothing to do here.
+    // Replay any deferred command buffers now that their dependencies have
+    // been satisfied. Inline command buffers already executed.
+    IREE_RETURN_IF_ERROR(iree_hal_sync_device_apply_deferred_command_buffers(
+        device, batch->command_buffer_count, batch->command_buffers));
 
     // Signal all semaphores now that batch work has completed.
-    IREE_RETURN_IF_ERROR(iree_hal_sync_semaphore_multi_signal(
-        &device->semaphore_state, &batch->signal_semaphores));
+    IREE_RETURN_IF_ERROR(
+        iree_hal_sync_semaphore_multi_signal(&batch->signal_semaphores));
   }
 
   return iree_ok_status();
@@ -276,9 +359,7 @@ static iree_status_t iree_hal_sync_device_submit_and_wait(
 static iree_status_t iree_hal_sync_device_wait_semaphores(
     iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
-  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
-  return iree_hal_sync_semaphore_multi_wait(&device->semaphore_state, wait_mode,
-                                            semaphore_list, timeout);
+  return iree_hal_sync_semaphore_multi_wait(wait_mode, semaphore_list, timeout);
 }
 
 static iree_status_t iree_hal_sync_device_wait_idle(
@@ -18,7 +18,21 @@ extern "C" {
 // Parameters configuring an iree_hal_sync_device_t.
 // Must be initialized with iree_hal_sync_device_params_initialize prior to use.
 typedef struct iree_hal_sync_device_params_t {
-  int reserved;
+  // Total size of each block in the device shared block pool used for
+  // transient command buffer state such as workgroup local memory.
+  // Larger sizes will lower overhead and ensure the heap isn't hit for
+  // transient allocations while also increasing memory consumption.
+  iree_host_size_t arena_block_size;
+
+  // Number of worker threads used to distribute large dispatches in addition
+  // to the thread issuing the submission. 0 executes all dispatches on the
+  // issuing thread. Ignored if threading is disabled in the build.
+  iree_host_size_t worker_count;
+
+  // Minimum number of workgroups a dispatch must have to be distributed across
+  // the workers. Smaller dispatches execute on the issuing thread as waking
+  // the workers would cost more than it saves.
+  iree_host_size_t worker_min_workgroup_count;
 } iree_hal_sync_device_params_t;
 
 // Initializes |out_params| to default values.
@@ -26,7 +40,9 @@ void iree_hal_sync_device_params_initialize(
     iree_hal_sync_device_params_t* out_params);
 
 // Creates a new synchronous local CPU device that performs execution inline
-// on threads issuing submissions. |loaders| is the set of executable
+// on threads issuing submissions. Command buffers allowed to execute inline
+// run while being recorded and all others are recorded and replayed when
+// submitted. |loaders| is the set of executable
 // loaders that are available for loading in the device context.
 iree_status_t iree_hal_sync_device_create(
     iree_string_view_t identifier, const iree_hal_sync_device_params_t* params,
@@ -17,20 +17,26 @@
 #define IREE_HAL_SYNC_SEMAPHORE_FAILURE_VALUE UINT64_MAX
 
 //===----------------------------------------------------------------------===//
-// iree_hal_sync_semaphore_state_t
+// iree_hal_sync_semaphore_waiter_t
 //===----------------------------------------------------------------------===//
 
-void iree_hal_sync_semaphore_state_initialize(
-    iree_hal_sync_semaphore_state_t* out_shared_state) {
-  memset(out_shared_state, 0, sizeof(*out_shared_state));
-  iree_notification_initialize(&out_shared_state->notification);
-}
-
-void iree_hal_sync_semaphore_state_deinitialize(
-    iree_hal_sync_semaphore_state_t* shared_state) {
-  iree_notification_deinitialize(&shared_state->notification);
-  memset(shared_state, 0, sizeof(*shared_state));
-}
+// A thread waiting on one or more semaphores. Lives on the stack of the waiting
+// thread for the duration of the wait.
+typedef struct iree_hal_sync_semaphore_waiter_t {
+  // Posted by any semaphore the waiter is registered with when it reaches the
+  // registered value (or fails).
+  iree_notification_t notification;
+} iree_hal_sync_semaphore_waiter_t;
+
+// Registration of a waiter with a single semaphore.
+// Each semaphore has a doubly-linked list of these guarded by its mutex.
+typedef struct iree_hal_sync_semaphore_wait_entry_t {
+  struct iree_hal_sync_semaphore_wait_entry_t* next;
+  struct iree_hal_sync_semaphore_wait_entry_t* prev;
+  // Value the semaphore must reach before the waiter is notified.
+  uint64_t minimum_value;
+  iree_hal_sync_semaphore_waiter_t* waiter;
+} iree_hal_sync_semaphore_wait_entry_t;
 
 //===----------------------------------------------------------------------===//
 // iree_hal_sync_semaphore_t
@@ -40,9 +46,6 @@ typedef struct iree_hal_sync_semaphore_t {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
 
-  // Shared across all semaphores.
-  iree_hal_sync_semaphore_state_t* shared_state;
-
   // Guards all mutable fields. We expect low contention on semaphores and since
   // iree_slim_mutex_t is (effectively) just a CAS this keeps things simpler
   // than trying to make the entire structure lock-free.
@@ -55,6 +58,10 @@ typedef struct iree_hal_sync_semaphore_t {
 
   // OK or the status passed to iree_hal_semaphore_fail. Owned by the semaphore.
   iree_status_t failure_status;
+
+  // Waiters registered on this semaphore. Only those waiting on a value this
+  // semaphore reaches are notified when it is signaled.
+  iree_hal_sync_semaphore_wait_entry_t* wait_list_head;
 } iree_hal_sync_semaphore_t;
 
 static const iree_hal_semaphore_vtable_t iree_hal_sync_semaphore_vtable;
@@ -66,9 +73,8 @@ static iree_hal_sync_semaphore_t* iree_hal_sync_semaphore_cast(
 }
 
 iree_status_t iree_hal_sync_semaphore_create(
-    iree_hal_sync_semaphore_state_t* shared_state, uint64_t initial_value,
-    iree_allocator_t host_allocator, iree_hal_semaphore_t** out_semaphore) {
-  IREE_ASSERT_ARGUMENT(shared_state);
+    uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore) {
   IREE_ASSERT_ARGUMENT(out_semaphore);
   *out_semaphore = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -80,11 +86,11 @@ iree_status_t iree_hal_sync_semaphore_create(
     iree_hal_resource_initialize(&iree_hal_sync_semaphore_vtable,
                                  &semaphore->resource);
     semaphore->host_allocator = host_allocator;
-    semaphore->shared_state = shared_state;
 
     iree_slim_mutex_initialize(&semaphore->mutex);
     semaphore->current_value = initial_value;
     semaphore->failure_status = iree_ok_status();
+    semaphore->wait_list_head = NULL;
 
     *out_semaphore = (iree_hal_semaphore_t*)semaphore;
   }
@@ -100,6 +106,8 @@ static void iree_hal_sync_semaphore_destroy(
   iree_allocator_t host_allocator = semaphore->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Waiters must have a reference to the semaphore so none can be registered.
+  IREE_ASSERT(!semaphore->wait_list_head);
   iree_status_free(semaphore->failure_status);
   iree_slim_mutex_deinitialize(&semaphore->mutex);
   iree_allocator_free(host_allocator, semaphore);
@@ -132,7 +140,6 @@ static iree_status_t iree_hal_sync_semaphore_signal_unsafe(
     iree_hal_sync_semaphore_t* semaphore, uint64_t new_value) {
   if (new_value <= semaphore->current_value) {
     uint64_t current_value IREE_ATTRIBUTE_UNUSED = semaphore->current_value;
-    iree_slim_mutex_unlock(&semaphore->mutex);
     return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
                             "semaphore values must be monotonically "
                             "increasing; current_value=%" PRIu64
@@ -143,6 +150,15 @@ static iree_status_t iree_hal_sync_semaphore_signal_unsafe(
   // Update to the new value.
   semaphore->current_value = new_value;
 
+  // Notify only the waiters that are now satisfied. Waiters remove their
+  // entries themselves under the lock and it's safe to post while holding it.
+  for (iree_hal_sync_semaphore_wait_entry_t* entry = semaphore->wait_list_head;
+       entry != NULL; entry = entry->next) {
+    if (entry->minimum_value <= new_value) {
+      iree_notification_post(&entry->waiter->notification, IREE_ALL_WAITERS);
+    }
+  }
+
   return iree_ok_status();
 }
 
@@ -155,15 +171,6 @@ static iree_status_t iree_hal_sync_semaphore_signal(
   iree_status_t status =
       iree_hal_sync_semaphore_signal_unsafe(semaphore, new_value);
   iree_slim_mutex_unlock(&semaphore->mutex);
-
-  if (iree_status_is_ok(status)) {
-    // Post a global notification so that any waiter will wake.
-    // TODO(#4680): make notifications per-semaphore; would make multi-wait
-    // impossible with iree_notification_t and we'd have to use wait handles.
-    iree_notification_post(&semaphore->shared_state->notification,
-                           IREE_ALL_WAITERS);
-  }
-
   return status;
 }
 
@@ -187,14 +194,16 @@ static void iree_hal_sync_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
   semaphore->current_value = IREE_HAL_SYNC_SEMAPHORE_FAILURE_VALUE;
   semaphore->failure_status = status;
 
-  iree_slim_mutex_unlock(&semaphore->mutex);
+  // Wake all waiters so they can observe the failure.
+  for (iree_hal_sync_semaphore_wait_entry_t* entry = semaphore->wait_list_head;
+       entry != NULL; entry = entry->next) {
+    iree_notification_post(&entry->waiter->notification, IREE_ALL_WAITERS);
+  }
 
-  iree_notification_post(&semaphore->shared_state->notification,
-                         IREE_ALL_WAITERS);
+  iree_slim_mutex_unlock(&semaphore->mutex);
 }
 
 iree_status_t iree_hal_sync_semaphore_multi_signal(
-    iree_hal_sync_semaphore_state_t* shared_state,
     const iree_hal_semaphore_list_t* semaphore_list) {
   // Try to signal all semaphores, stopping if we encounter any issues.
   iree_status_t status = iree_ok_status();
@@ -207,80 +216,6 @@ iree_status_t iree_hal_sync_semaphore_multi_signal(
     iree_slim_mutex_unlock(&semaphore->mutex);
     if (!iree_status_is_ok(status)) break;
   }
-
-  // Notify all waiters that we've updated semaphores. They'll wake and check
-  // to see if they are satisfied.
-  // NOTE: we do this even if there was a failure as we may have signaled some
-  // of the list.
-  iree_notification_post(&shared_state->notification, IREE_ALL_WAITERS);
-
-  return status;
-}
-
-typedef struct iree_hal_sync_semaphore_notify_state_t {
-  iree_hal_sync_semaphore_t* semaphore;
-  uint64_t value;
-} iree_hal_sync_semaphore_notify_state_t;
-
-static bool iree_hal_sync_semaphore_is_signaled(
-    iree_hal_sync_semaphore_notify_state_t* state) {
-  iree_hal_sync_semaphore_t* semaphore = state->semaphore;
-  iree_slim_mutex_lock(&semaphore->mutex);
-  bool is_signaled = semaphore->current_value >= state->value ||
-                     !iree_status_is_ok(semaphore->failure_status);
-  iree_slim_mutex_unlock(&semaphore->mutex);
-  return is_signaled;
-}
-
-static iree_status_t iree_hal_sync_semaphore_wait(
-    iree_hal_semaphore_t* base_semaphore, uint64_t value,
-    iree_timeout_t timeout) {
-  iree_hal_sync_semaphore_t* semaphore =
-      iree_hal_sync_semaphore_cast(base_semaphore);
-
-  // Try to see if we can return immediately.
-  iree_slim_mutex_lock(&semaphore->mutex);
-  if (!iree_status_is_ok(semaphore->failure_status)) {
-    // Fastest path: failed; return an error to tell callers to query for it.
-    iree_slim_mutex_unlock(&semaphore->mutex);
-    return iree_status_from_code(IREE_STATUS_ABORTED);
-  } else if (semaphore->current_value >= value) {
-    // Fast path: already satisfied.
-    iree_slim_mutex_unlock(&semaphore->mutex);
-    return iree_ok_status();
-  } else if (iree_timeout_is_immediate(timeout)) {
-    // Not satisfied but a poll, so can avoid the expensive wait handle work.
-    iree_slim_mutex_unlock(&semaphore->mutex);
-    return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
-  }
-  iree_slim_mutex_unlock(&semaphore->mutex);
-
-  // TODO(#4680): we should be checking for DEADLINE_EXCEEDED here. This is
-  // easy when it's iree_timeout_is_infinite (we can just use the notification
-  // as below) but if it's an actual deadline we'll need to probably switch to
-  // iree_wait_handle_t.
-
-  // Perform wait on the global notification. Will wait forever.
-  iree_hal_sync_semaphore_state_t* shared_state = semaphore->shared_state;
-  iree_hal_sync_semaphore_notify_state_t notify_state = {
-      .semaphore = semaphore,
-      .value = value,
-  };
-  iree_notification_await(
-      &shared_state->notification,
-      (iree_condition_fn_t)iree_hal_sync_semaphore_is_signaled,
-      (void*)&notify_state, timeout);
-
-  iree_status_t status = iree_ok_status();
-  iree_slim_mutex_lock(&semaphore->mutex);
-  if (!iree_status_is_ok(semaphore->failure_status)) {
-    // Semaphore has failed.
-    status = iree_status_from_code(IREE_STATUS_ABORTED);
-  } else if (semaphore->current_value < value) {
-    // Deadline expired before the semaphore was signaled.
-    status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
-  }
-  iree_slim_mutex_unlock(&semaphore->mutex);
   return status;
 }
 
@@ -361,8 +296,112 @@ static iree_status_t iree_hal_sync_semaphore_result_from_state(
   }
 }
 
+// Registers |entry| for |waiter| with |semaphore| to be notified when it
+// reaches |minimum_value|.
+static void iree_hal_sync_semaphore_register_waiter(
+    iree_hal_sync_semaphore_t* semaphore, uint64_t minimum_value,
+    iree_hal_sync_semaphore_waiter_t* waiter,
+    iree_hal_sync_semaphore_wait_entry_t* entry) {
+  entry->minimum_value = minimum_value;
+  entry->waiter = waiter;
+  entry->prev = NULL;
+  iree_slim_mutex_lock(&semaphore->mutex);
+  entry->next = semaphore->wait_list_head;
+  if (entry->next) entry->next->prev = entry;
+  semaphore->wait_list_head = entry;
+  iree_slim_mutex_unlock(&semaphore->mutex);
+}
+
+// Unregisters |entry| from |semaphore|. Once this returns the semaphore will
+// no longer touch the waiter.
+static void iree_hal_sync_semaphore_unregister_waiter(
+    iree_hal_sync_semaphore_t* semaphore,
+    iree_hal_sync_semaphore_wait_entry_t* entry) {
+  iree_slim_mutex_lock(&semaphore->mutex);
+  if (entry->prev) {
+    entry->prev->next = entry->next;
+  } else {
+    semaphore->wait_list_head = entry->next;
+  }
+  if (entry->next) entry->next->prev = entry->prev;
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  entry->next = NULL;
+  entry->prev = NULL;
+}
+
+// Blocks the caller until the |semaphore_list| is satisfied based on
+// |wait_mode| or |timeout| elapses. The caller is registered with only the
+// semaphores in the list and is only woken when one of them reaches the
+// requested value or fails.
+static iree_status_t iree_hal_sync_semaphore_wait_list(
+    iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  iree_hal_sync_semaphore_waiter_t waiter;
+  iree_notification_initialize(&waiter.notification);
+  iree_hal_sync_semaphore_wait_entry_t* entries =
+      (iree_hal_sync_semaphore_wait_entry_t*)iree_alloca(
+          semaphore_list->count * sizeof(*entries));
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    iree_hal_sync_semaphore_register_waiter(
+        iree_hal_sync_semaphore_cast(semaphore_list->semaphores[i]),
+        semaphore_list->payload_values[i], &waiter, &entries[i]);
+  }
+
+  // Any signal after registration will post the notification so the await
+  // can't miss a wake between checking the condition and waiting. A timeout
+  // is detected below by checking the state.
+  iree_notification_await(
+      &waiter.notification,
+      wait_mode == IREE_HAL_WAIT_MODE_ALL
+          ? (iree_condition_fn_t)iree_hal_sync_semaphore_all_signaled
+          : (iree_condition_fn_t)iree_hal_sync_semaphore_any_signaled,
+      (void*)semaphore_list, timeout);
+
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    iree_hal_sync_semaphore_unregister_waiter(
+        iree_hal_sync_semaphore_cast(semaphore_list->semaphores[i]),
+        &entries[i]);
+  }
+  iree_notification_deinitialize(&waiter.notification);
+
+  // We may have been successful - or may have a partial failure or timeout.
+  return iree_hal_sync_semaphore_result_from_state(wait_mode, semaphore_list);
+}
+
+static iree_status_t iree_hal_sync_semaphore_wait(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    iree_timeout_t timeout) {
+  iree_hal_sync_semaphore_t* semaphore =
+      iree_hal_sync_semaphore_cast(base_semaphore);
+
+  // Try to see if we can return immediately.
+  iree_slim_mutex_lock(&semaphore->mutex);
+  if (!iree_status_is_ok(semaphore->failure_status)) {
+    // Fastest path: failed; return an error to tell callers to query for it.
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return iree_status_from_code(IREE_STATUS_ABORTED);
+  } else if (semaphore->current_value >= value) {
+    // Fast path: already satisfied.
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return iree_ok_status();
+  } else if (iree_timeout_is_immediate(timeout)) {
+    // Not satisfied but a poll, so can avoid registering a waiter.
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+
+  // Slow path: wait on only this semaphore.
+  iree_hal_semaphore_list_t semaphore_list = {
+      .count = 1,
+      .semaphores = &base_semaphore,
+      .payload_values = &value,
+  };
+  return iree_hal_sync_semaphore_wait_list(IREE_HAL_WAIT_MODE_ALL,
+                                           &semaphore_list, timeout);
+}
+
 iree_status_t iree_hal_sync_semaphore_multi_wait(
-    iree_hal_sync_semaphore_state_t* shared_state,
     iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
   IREE_ASSERT_ARGUMENT(semaphore_list);
@@ -376,25 +415,15 @@ iree_status_t iree_hal_sync_semaphore_multi_wait(
 
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Fast-path for polling; we'll never wait and can just do a quick query.
-  if (iree_timeout_is_immediate(timeout)) {
-    iree_status_t status =
-        iree_hal_sync_semaphore_result_from_state(wait_mode, semaphore_list);
-    IREE_TRACE_ZONE_END(z0);
-    return status;
-  }
-
-  // Perform wait on the global notification.
-  iree_notification_await(
-      &shared_state->notification,
-      wait_mode == IREE_HAL_WAIT_MODE_ALL
-          ? (iree_condition_fn_t)iree_hal_sync_semaphore_all_signaled
-          : (iree_condition_fn_t)iree_hal_sync_semaphore_any_signaled,
-      (void*)semaphore_list, iree_infinite_timeout());
-
-  // We may have been successful - or may have a partial failure.
+  // Fast-path for polling or already satisfied; this avoids registering with
+  // all of the semaphores.
   iree_status_t status =
       iree_hal_sync_semaphore_result_from_state(wait_mode, semaphore_list);
+  if (iree_status_is_deadline_exceeded(status) &&
+      !iree_timeout_is_immediate(timeout)) {
+    status = iree_hal_sync_semaphore_wait_list(wait_mode, semaphore_list,
+                                               timeout);
+  }
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -17,20 +17,83 @@
 #include "iree/hal/local/local_descriptor_set_layout.h"
 #include "iree/hal/local/local_executable.h"
 #include "iree/hal/local/local_executable_layout.h"
+#include "iree/hal/local/transfer_kernels.h"
 #include "iree/hal/utils/resource_set.h"
 #include "iree/task/affinity_set.h"
 #include "iree/task/list.h"
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
 
+//===----------------------------------------------------------------------===//
+// Recording-time dependency tracking
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_task_cmd_node_t iree_hal_task_cmd_node_t;
+
+// A dependency edge from a node to one of the nodes that must execute after it.
+typedef struct iree_hal_task_cmd_edge_t {
+  struct iree_hal_task_cmd_edge_t* next;
+  iree_hal_task_cmd_node_t* target;
+} iree_hal_task_cmd_edge_t;
+
+// Recording-time bookkeeping for a single task emitted into the DAG.
+// Allocated from the command buffer arena and only valid until the command
+// buffer is reset.
+struct iree_hal_task_cmd_node_t {
+  // Next node in recording order.
+  iree_hal_task_cmd_node_t* next;
+  // Task emitted for the command.
+  iree_task_t* task;
+  // Barrier epoch the node was recorded in.
+  uint32_t barrier_epoch;
+  // Total number of nodes that must complete before this node can execute.
+  uint32_t predecessor_count;
+  // Total number of entries in |successors|.
+  uint32_t successor_count;
+  // All nodes that depend on this node, most recently added first.
+  iree_hal_task_cmd_edge_t* successors;
+  // Barrier used to fork out to |successors| when there is more than one.
+  // The barrier dependent task list is allocated along with it in end().
+  iree_task_barrier_t* fork_barrier;
+  // Task flags as recorded, used to restore the task when re-armed.
+  iree_task_flags_t task_flags;
+  // Workgroup count pointer of indirect dispatches as recorded.
+  const uint32_t* workgroup_count_ptr;
+};
+
+// A memory access performed by a node on a byte range of an allocation.
+typedef struct iree_hal_task_cmd_access_t {
+  // Next older access in the command buffer.
+  struct iree_hal_task_cmd_access_t* prev;
+  // Node performing the access.
+  iree_hal_task_cmd_node_t* node;
+  // Allocated buffer the access is performed on; subspans are resolved to
+  // their allocation so that aliasing ranges are detected.
+  const iree_hal_buffer_t* allocation;
+  // Absolute byte range [begin, end) within |allocation|.
+  iree_device_size_t begin;
+  iree_device_size_t end;
+  // True if the node may write to the range.
+  bool is_write;
+} iree_hal_task_cmd_access_t;
+
+// Describes one buffer range used by a command prior to it being recorded.
+typedef struct iree_hal_task_cmd_range_t {
+  iree_hal_buffer_t* buffer;
+  iree_device_size_t offset;
+  iree_device_size_t length;
+  bool is_write;
+} iree_hal_task_cmd_range_t;
+
 //===----------------------------------------------------------------------===//
 // iree_hal_task_command_buffer_t
 //===----------------------------------------------------------------------===//
 
 // iree/task/-based command buffer.
 // We track a minimal amount of state here and incrementally build out the task
-// DAG that we can submit to the task system directly. There's no intermediate
-// data structures and we produce the iree_task_ts directly. In the steady state
+// DAG that we can submit to the task system directly. The only intermediate
+// data structures are the recording-time nodes used to track buffer hazards
+// across barriers and we produce the iree_task_ts directly. In the steady state
 // all allocations are served from a shared per-device block pool with no
 // additional allocations required during recording or execution. That means our
 // command buffer here is essentially just a builder for the task system types
@@ -41,6 +104,9 @@ typedef struct iree_hal_task_command_buffer_t {
 
   iree_task_scope_t* scope;
 
+  // Controls the slicing of fill and copy commands.
+  iree_hal_task_transfer_params_t transfer_params;
+
   // Arena used for all allocations; references the shared device block pool.
   iree_arena_allocator_t arena;
 
@@ -53,31 +119,45 @@ typedef struct iree_hal_task_command_buffer_t {
   // ready task set in the submission.
   iree_task_list_t root_tasks;
 
-  // One or more tasks at the leaves of the DAG.
+  // Zero or more tasks at the leaves of the DAG that have no dependent tasks.
   // Only once all these tasks have completed execution will the command buffer
-  // be considered completed as a whole.
-  //
-  // An empty list indicates that root_tasks are also the leaves.
-  iree_task_list_t leaf_tasks;
+  // be considered completed as a whole. A task may be both a root and a leaf
+  // and since the intrusive task list pointer is used by |root_tasks| the
+  // leaves are stored as an arena-allocated array populated during end().
+  iree_task_t** leaf_tasks;
+  iree_host_size_t leaf_task_count;
+
+  // All nodes recorded in the command buffer in recording order. Only retained
+  // after end() for reusable command buffers where they are used to re-arm the
+  // tasks prior to each issue.
+  iree_hal_task_cmd_node_t* nodes;
+
+  // Reusable command buffers join all leaves on this task prior to the retire
+  // task so that we know when the task graph can be re-armed. Non-zero while
+  // an issued execution of a reusable command buffer is in-flight.
+  iree_task_nop_t tail_task;
+  iree_atomic_int32_t in_flight;
 
   // TODO(benvanik): move this out of the struct and allocate from the arena -
   // we only need this during recording and it's ~4KB of waste otherwise.
   // State tracked within the command buffer during recording only.
   struct {
-    // The last global barrier that was inserted, if any.
-    // The barrier is allocated and inserted into the DAG when requested but the
-    // actual barrier dependency list is only allocated and set on flushes.
-    // This lets us allocate the appropriately sized barrier task list from the
-    // arena even though when the barrier is recorded we don't yet know what
-    // other tasks we'll be emitting as we walk the command stream.
-    iree_task_barrier_t* open_barrier;
-
-    // The number of tasks in the open barrier (|open_tasks|), used to quickly
-    // allocate storage for the task list without needing to walk the list.
-    iree_host_size_t open_task_count;
-
-    // All execution tasks emitted that must execute after |open_barrier|.
-    iree_task_list_t open_tasks;
+    // All nodes recorded in the command buffer in recording order.
+    // Dependency edges between nodes are accumulated during recording and only
+    // translated into task completion/barrier edges on end() once the full set
+    // of dependents of each node is known.
+    iree_hal_task_cmd_node_t* node_head;
+    iree_hal_task_cmd_node_t* node_tail;
+    iree_host_size_t node_count;
+
+    // Most recent memory access recorded; accesses are linked newest to oldest
+    // so that hazard scans can stop at the most recent covering write.
+    iree_hal_task_cmd_access_t* access_head;
+
+    // Incremented each time an execution barrier is recorded. Accesses within
+    // the same epoch are allowed to execute concurrently per the HAL
+    // execution model and only accesses from prior epochs introduce edges.
+    uint32_t barrier_epoch;
 
     // A flattened list of all available descriptor set bindings.
     // As descriptor sets are pushed/bound the bindings will be updated to
@@ -90,6 +170,16 @@ typedef struct iree_hal_task_command_buffer_t {
         binding_lengths[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
                         IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
 
+    // The buffers bound to each binding ordinal used for hazard tracking.
+    // The binding offsets are taken relative to the allocated buffer so that
+    // subspans aliasing the same allocation are treated as overlapping.
+    iree_hal_buffer_t* binding_buffers
+        [IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+         IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
+    iree_device_size_t
+        binding_offsets[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+                        IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
+
     // All available push constants updated each time push_constants is called.
     // Reset only with the command buffer and otherwise will maintain its values
     // during recording to allow for partial push_constants updates.
@@ -111,24 +201,12 @@ iree_status_t iree_hal_task_command_buffer_create(
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_task_transfer_params_t* transfer_params,
     iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer) {
+  IREE_ASSERT_ARGUMENT(transfer_params);
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
-  if (!iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
-    // If we want reuse we'd need to support duplicating the task DAG after
-    // recording or have some kind of copy-on-submit behavior that does so if
-    // a command buffer is submitted for execution twice. Allowing for the same
-    // command buffer to be enqueued multiple times would be fine so long as
-    // execution doesn't overlap (`cmdbuf|cmdbuf` vs
-    // `cmdbuf -> semaphore -> cmdbuf`) though we'd still need to be careful
-    // that we did the enqueuing and reset of the task structures at the right
-    // times. Definitely something that'll be useful in the future... but not
-    // today :)
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "only one-shot command buffer usage is supported");
-  }
-
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_task_command_buffer_t* command_buffer = NULL;
@@ -140,9 +218,14 @@ iree_status_t iree_hal_task_command_buffer_create(
         &iree_hal_task_command_buffer_vtable, &command_buffer->base);
     command_buffer->host_allocator = host_allocator;
     command_buffer->scope = scope;
+    command_buffer->transfer_params = *transfer_params;
     iree_arena_initialize(block_pool, &command_buffer->arena);
     iree_task_list_initialize(&command_buffer->root_tasks);
-    iree_task_list_initialize(&command_buffer->leaf_tasks);
+    command_buffer->leaf_tasks = NULL;
+    command_buffer->leaf_task_count = 0;
+    command_buffer->nodes = NULL;
+    iree_atomic_store_int32(&command_buffer->in_flight, 0,
+                            iree_memory_order_relaxed);
     memset(&command_buffer->state, 0, sizeof(command_buffer->state));
     status = iree_hal_resource_set_allocate(block_pool,
                                             &command_buffer->resource_set);
@@ -160,7 +243,9 @@ iree_status_t iree_hal_task_command_buffer_create(
 static void iree_hal_task_command_buffer_reset(
     iree_hal_task_command_buffer_t* command_buffer) {
   memset(&command_buffer->state, 0, sizeof(command_buffer->state));
-  iree_task_list_discard(&command_buffer->leaf_tasks);
+  command_buffer->leaf_tasks = NULL;
+  command_buffer->leaf_task_count = 0;
+  command_buffer->nodes = NULL;
   iree_task_list_discard(&command_buffer->root_tasks);
   iree_hal_resource_set_reset(command_buffer->resource_set);
   iree_arena_reset(&command_buffer->arena);
@@ -200,9 +285,6 @@ static void* iree_hal_task_command_buffer_dyn_cast(
 // iree_hal_task_command_buffer_t recording
 //===----------------------------------------------------------------------===//
 
-static iree_status_t iree_hal_task_command_buffer_flush_tasks(
-    iree_hal_task_command_buffer_t* command_buffer);
-
 static iree_status_t iree_hal_task_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_task_command_buffer_t* command_buffer =
@@ -211,138 +293,251 @@ static iree_status_t iree_hal_task_command_buffer_begin(
   return iree_ok_status();
 }
 
+// Links the task dependencies of all |nodes| and populates the root task list.
+// Nodes with a single dependent use the base task completion edge while those
+// with multiple dependents fork through their barrier.
+static void iree_hal_task_command_buffer_arm(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_task_cmd_node_t* nodes) {
+  for (iree_hal_task_cmd_node_t* node = nodes; node != NULL;
+       node = node->next) {
+    if (node->successor_count == 1) {
+      // Special-case: only one dependent task so we can avoid the additional
+      // barrier overhead by using the completion task.
+      iree_task_set_completion_task(node->task, node->successors->target->task);
+    } else if (node->successor_count > 1) {
+      iree_task_barrier_t* barrier = node->fork_barrier;
+      iree_task_barrier_initialize(command_buffer->scope, node->successor_count,
+                                   barrier->dependent_tasks, barrier);
+      iree_task_set_completion_task(node->task, &barrier->header);
+    }
+    if (node->predecessor_count == 0) {
+      iree_task_list_push_back(&command_buffer->root_tasks, node->task);
+    }
+  }
+}
+
+// Restores the task of |node| to the state it was in when recorded so that it
+// can be armed and executed again. Must only be called once the task and all
+// tasks that depend on it have retired.
+static void iree_hal_task_command_buffer_reset_node_task(
+    iree_hal_task_cmd_node_t* node) {
+  iree_task_t* task = node->task;
+  task->next_task = NULL;
+  task->completion_task = NULL;
+  iree_atomic_store_int32(&task->pending_dependency_count, 0,
+                          iree_memory_order_relaxed);
+  task->flags = node->task_flags;
+  switch (task->type) {
+    case IREE_TASK_TYPE_CALL: {
+      iree_task_call_t* call_task = (iree_task_call_t*)task;
+      iree_atomic_store_intptr(&call_task->status, 0,
+                               iree_memory_order_relaxed);
+      break;
+    }
+    case IREE_TASK_TYPE_DISPATCH: {
+      // Indirect dispatches overwrite their workgroup count pointer with the
+      // sampled value when issued so we restore it here.
+      iree_task_dispatch_t* dispatch_task = (iree_task_dispatch_t*)task;
+      if (iree_all_bits_set(node->task_flags,
+                            IREE_TASK_FLAG_DISPATCH_INDIRECT)) {
+        dispatch_task->workgroup_count.ptr = node->workgroup_count_ptr;
+      }
+      iree_atomic_store_intptr(&dispatch_task->status, 0,
+                               iree_memory_order_relaxed);
+      memset(&dispatch_task->statistics, 0, sizeof(dispatch_task->statistics));
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Prepares the recorded nodes for execution: any fork barriers required by
+// nodes with multiple dependents are allocated and the nodes with no dependents
+// are gathered as leaves to be joined on the retire task when issued. One-shot
+// command buffers are armed immediately while reusable ones are re-armed prior
+// to each issue.
 static iree_status_t iree_hal_task_command_buffer_end(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)command_buffer->state.node_count);
 
-  // Flush any open barriers.
-  IREE_RETURN_IF_ERROR(
-      iree_hal_task_command_buffer_flush_tasks(command_buffer));
-
-  // Move the tasks from the leaf list (tail) to the root list (head) if this
-  // was the first set of tasks recorded.
-  if (iree_task_list_is_empty(&command_buffer->root_tasks) &&
-      !iree_task_list_is_empty(&command_buffer->leaf_tasks)) {
-    iree_task_list_move(&command_buffer->leaf_tasks,
-                        &command_buffer->root_tasks);
+  iree_host_size_t leaf_task_count = 0;
+  for (iree_hal_task_cmd_node_t* node = command_buffer->state.node_head;
+       node != NULL; node = node->next) {
+    if (node->successor_count == 0) ++leaf_task_count;
+  }
+  iree_task_t** leaf_tasks = NULL;
+  if (leaf_task_count > 0) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_arena_allocate(&command_buffer->arena,
+                                leaf_task_count * sizeof(*leaf_tasks),
+                                (void**)&leaf_tasks));
   }
 
-  return iree_ok_status();
-}
-
-// Flushes all open tasks to the previous barrier and prepares for more
-// recording. The root tasks are also populated here when required as this is
-// the one place where we can see both halves of the most recent synchronization
-// event: those tasks recorded prior (if any) and the task that marks the set of
-// tasks that will be recorded after (if any).
-static iree_status_t iree_hal_task_command_buffer_flush_tasks(
-    iree_hal_task_command_buffer_t* command_buffer) {
-  iree_task_barrier_t* open_barrier = command_buffer->state.open_barrier;
-  if (open_barrier != NULL) {
-    // There is an open barrier we need to fixup the fork out to all of the open
-    // tasks that were recorded after it.
-    iree_task_t* task_head =
-        iree_task_list_front(&command_buffer->state.open_tasks);
-    iree_host_size_t dependent_task_count =
-        command_buffer->state.open_task_count;
-    if (dependent_task_count == 1) {
-      // Special-case: only one open task so we can avoid the additional barrier
-      // overhead by reusing the completion task.
-      iree_task_set_completion_task(&open_barrier->header, task_head);
-    } else if (dependent_task_count > 1) {
-      // Allocate the list of tasks we'll stash back on the previous barrier.
-      // Since we couldn't know at the time how many tasks would end up in the
-      // barrier we had to defer it until now.
-      iree_task_t** dependent_tasks = NULL;
-      IREE_RETURN_IF_ERROR(iree_arena_allocate(
-          &command_buffer->arena, dependent_task_count * sizeof(iree_task_t*),
-          (void**)&dependent_tasks));
-      iree_task_t* task = task_head;
-      for (iree_host_size_t i = 0; i < dependent_task_count; ++i) {
-        dependent_tasks[i] = task;
-        task = task->next_task;
+  iree_host_size_t leaf_task_index = 0;
+  for (iree_hal_task_cmd_node_t* node = command_buffer->state.node_head;
+       node != NULL; node = node->next) {
+    node->task_flags = node->task->flags;
+    if (node->task->type == IREE_TASK_TYPE_DISPATCH &&
+        iree_all_bits_set(node->task_flags, IREE_TASK_FLAG_DISPATCH_INDIRECT)) {
+      node->workgroup_count_ptr =
+          ((iree_task_dispatch_t*)node->task)->workgroup_count.ptr;
+    }
+    if (node->successor_count == 0) {
+      leaf_tasks[leaf_task_index++] = node->task;
+    } else if (node->successor_count > 1) {
+      // The barrier is allocated together with its dependent task list.
+      iree_task_barrier_t* barrier = NULL;
+      IREE_RETURN_AND_END_ZONE_IF_ERROR(
+          z0, iree_arena_allocate(
+                  &command_buffer->arena,
+                  sizeof(*barrier) +
+                      node->successor_count * sizeof(iree_task_t*),
+                  (void**)&barrier));
+      iree_task_t** dependent_tasks = (iree_task_t**)(barrier + 1);
+      iree_host_size_t dependent_task_index = node->successor_count;
+      for (iree_hal_task_cmd_edge_t* edge = node->successors; edge != NULL;
+           edge = edge->next) {
+        // Edges are stored newest first; store them in recording order.
+        dependent_tasks[--dependent_task_index] = edge->target->task;
       }
-      iree_task_barrier_set_dependent_tasks(open_barrier, dependent_task_count,
-                                            dependent_tasks);
+      iree_task_barrier_initialize_empty(command_buffer->scope, barrier);
+      barrier->dependent_tasks = dependent_tasks;
+      node->fork_barrier = barrier;
     }
   }
-  command_buffer->state.open_barrier = NULL;
-
-  // Move the open tasks to the tail as they represent the first half of the
-  // *next* barrier that will be inserted.
-  if (command_buffer->state.open_task_count > 0) {
-    iree_task_list_move(&command_buffer->state.open_tasks,
-                        &command_buffer->leaf_tasks);
-    command_buffer->state.open_task_count = 0;
+  command_buffer->leaf_tasks = leaf_tasks;
+  command_buffer->leaf_task_count = leaf_task_count;
+
+  if (iree_all_bits_set(command_buffer->base.mode,
+                        IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
+    iree_hal_task_command_buffer_arm(command_buffer,
+                                     command_buffer->state.node_head);
+  } else {
+    command_buffer->nodes = command_buffer->state.node_head;
   }
 
+  // Recording state is no longer needed and references arena memory.
+  command_buffer->state.node_head = NULL;
+  command_buffer->state.node_tail = NULL;
+  command_buffer->state.node_count = 0;
+  command_buffer->state.access_head = NULL;
+
+  IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
 }
 
-// Emits a global barrier, splitting execution into all prior recorded tasks
-// and all subsequent recorded tasks. This is currently the critical piece that
-// limits our concurrency: changing to fine-grained barriers (via barrier
-// buffers or events) will allow more work to overlap at the cost of more brain
-// to build out the proper task graph.
-static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
+// Emits an execution barrier splitting execution into all prior recorded tasks
+// and all subsequent recorded tasks. Unlike a global join-fork barrier only
+// subsequent tasks that have a memory hazard with prior tasks will be made to
+// wait on them; independent work is free to overlap across the barrier.
+static iree_status_t iree_hal_task_command_buffer_emit_barrier(
     iree_hal_task_command_buffer_t* command_buffer) {
-  // Flush open tasks to the previous barrier. This resets our state such that
-  // we can assign the new open barrier and start recording tasks for it.
-  // Previous tasks will be moved into the leaf_tasks list.
-  IREE_RETURN_IF_ERROR(
-      iree_hal_task_command_buffer_flush_tasks(command_buffer));
-
-  // Allocate the new open barrier.
-  // As we are recording forward we can't yet assign the dependent tasks (the
-  // second half of the synchronization domain) and instead are just inserting
-  // it so we can setup the join from previous tasks (the first half of the
-  // synchronization domain).
-  iree_task_barrier_t* barrier = NULL;
-  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
-                                           sizeof(*barrier), (void**)&barrier));
-  iree_task_barrier_initialize_empty(command_buffer->scope, barrier);
+  ++command_buffer->state.barrier_epoch;
+  return iree_ok_status();
+}
 
-  // If there were previous tasks then join them to the barrier.
-  for (iree_task_t* task = iree_task_list_front(&command_buffer->leaf_tasks);
-       task != NULL; task = task->next_task) {
-    iree_task_set_completion_task(task, &barrier->header);
+// Adds a dependency edge from |source| to |target| if one does not exist.
+static iree_status_t iree_hal_task_command_buffer_add_edge(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_task_cmd_node_t* source, iree_hal_task_cmd_node_t* target) {
+  // Edges for |target| are all added while it is being recorded and are
+  // prepended so we only need to check the most recent edge for duplicates.
+  if (source->successors && source->successors->target == target) {
+    return iree_ok_status();
   }
+  iree_hal_task_cmd_edge_t* edge = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                           sizeof(*edge), (void**)&edge));
+  edge->target = target;
+  edge->next = source->successors;
+  source->successors = edge;
+  ++source->successor_count;
+  ++target->predecessor_count;
+  return iree_ok_status();
+}
 
-  // Move the tasks from the leaf list (tail) to the root list (head) if this
-  // was the first set of tasks recorded.
-  if (iree_task_list_is_empty(&command_buffer->root_tasks) &&
-      !iree_task_list_is_empty(&command_buffer->leaf_tasks)) {
-    iree_task_list_move(&command_buffer->leaf_tasks,
-                        &command_buffer->root_tasks);
+// Records an access by |node| to |range| and adds dependency edges from any
+// prior accesses recorded before the last barrier that conflict with it.
+static iree_status_t iree_hal_task_command_buffer_track_access(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_task_cmd_node_t* node, const iree_hal_task_cmd_range_t* range) {
+  iree_hal_buffer_t* allocation =
+      iree_hal_buffer_allocated_buffer(range->buffer);
+  iree_device_size_t begin =
+      iree_hal_buffer_byte_offset(range->buffer) + range->offset;
+  iree_device_size_t length = range->length;
+  if (length == IREE_WHOLE_BUFFER) {
+    length = iree_hal_buffer_byte_length(range->buffer) - range->offset;
+  }
+  iree_device_size_t end = begin + length;
+
+  // Walk prior accesses from newest to oldest. Once we hit a write from a
+  // prior epoch that fully covers our range we can stop as that write itself
+  // was made to depend on anything older that overlaps it.
+  for (iree_hal_task_cmd_access_t* prior = command_buffer->state.access_head;
+       prior != NULL; prior = prior->prev) {
+    if (prior->allocation != allocation || prior->end <= begin ||
+        prior->begin >= end) {
+      continue;  // no overlap
+    }
+    if (!prior->is_write && !range->is_write) {
+      continue;  // read-after-read
+    }
+    if (prior->node == node ||
+        prior->node->barrier_epoch == node->barrier_epoch) {
+      // Accesses within the same barrier epoch are not ordered.
+      continue;
+    }
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_add_edge(
+        command_buffer, prior->node, node));
+    if (prior->is_write && prior->begin <= begin && prior->end >= end) {
+      break;  // covering write
+    }
   }
 
-  // Reset the tail of the command buffer to the barrier. This leaves us in a
-  // consistent state if the recording ends immediate after this (the barrier
-  // will be the last task).
-  iree_task_list_initialize(&command_buffer->leaf_tasks);
-  iree_task_list_push_back(&command_buffer->leaf_tasks, &barrier->header);
-
-  // NOTE: all new tasks emitted will be executed after this barrier.
-  command_buffer->state.open_barrier = barrier;
-  command_buffer->state.open_task_count = 0;
-
+  iree_hal_task_cmd_access_t* access = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                           sizeof(*access), (void**)&access));
+  access->node = node;
+  access->allocation = allocation;
+  access->begin = begin;
+  access->end = end;
+  access->is_write = range->is_write;
+  access->prev = command_buffer->state.access_head;
+  command_buffer->state.access_head = access;
   return iree_ok_status();
 }
 
-// Emits a the given execution |task| into the current open synchronization
-// scope (after state.open_barrier and before the next barrier).
+// Emits the given execution |task| into the DAG. The task will be scheduled to
+// execute after any previously recorded tasks from prior barrier epochs that
+// access any of the buffer |ranges| in a conflicting way.
 static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
-    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task) {
-  if (command_buffer->state.open_barrier == NULL) {
-    // If there is no open barrier then we are at the head and going right into
-    // the task DAG.
-    iree_task_list_push_back(&command_buffer->leaf_tasks, task);
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task,
+    iree_host_size_t range_count, const iree_hal_task_cmd_range_t* ranges) {
+  iree_hal_task_cmd_node_t* node = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                           sizeof(*node), (void**)&node));
+  memset(node, 0, sizeof(*node));
+  node->task = task;
+  node->barrier_epoch = command_buffer->state.barrier_epoch;
+
+  for (iree_host_size_t i = 0; i < range_count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_track_access(
+        command_buffer, node, &ranges[i]));
+  }
+
+  if (command_buffer->state.node_tail) {
+    command_buffer->state.node_tail->next = node;
   } else {
-    // Append to the open task list that will be flushed to the open barrier.
-    iree_task_list_push_back(&command_buffer->state.open_tasks, task);
-    ++command_buffer->state.open_task_count;
+    command_buffer->state.node_head = node;
   }
+  command_buffer->state.node_tail = node;
+  ++command_buffer->state.node_count;
   return iree_ok_status();
 }
 
@@ -350,6 +545,18 @@ static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
 // iree_hal_task_command_buffer_t execution
 //===----------------------------------------------------------------------===//
 
+// Cleanup for the tail task of reusable command buffers that marks the command
+// buffer as available for re-arming once all of its tasks have retired.
+static void iree_hal_task_command_buffer_tail_cleanup(
+    iree_task_t* task, iree_status_code_t status_code) {
+  iree_hal_task_command_buffer_t* command_buffer =
+      (iree_hal_task_command_buffer_t*)((uint8_t*)task -
+                                        offsetof(iree_hal_task_command_buffer_t,
+                                                 tail_task));
+  iree_atomic_store_int32(&command_buffer->in_flight, 0,
+                          iree_memory_order_release);
+}
+
 iree_status_t iree_hal_task_command_buffer_issue(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
@@ -359,27 +566,44 @@ iree_status_t iree_hal_task_command_buffer_issue(
                                        &iree_hal_task_command_buffer_vtable);
   IREE_ASSERT_TRUE(command_buffer);
 
+  // Reusable command buffers retain their task graph after execution and only
+  // need to have the task state reset and the dependency edges relinked. No
+  // allocations are required.
+  iree_task_t* completion_task = retire_task;
+  if (command_buffer->nodes != NULL) {
+    if (iree_atomic_exchange_int32(&command_buffer->in_flight, 1,
+                                   iree_memory_order_acq_rel) != 0) {
+      return iree_make_status(
+          IREE_STATUS_FAILED_PRECONDITION,
+          "reusable command buffer issued while a prior execution is still "
+          "in-flight; executions must be ordered with semaphores");
+    }
+    for (iree_hal_task_cmd_node_t* node = command_buffer->nodes; node != NULL;
+         node = node->next) {
+      iree_hal_task_command_buffer_reset_node_task(node);
+    }
+    iree_hal_task_command_buffer_arm(command_buffer, command_buffer->nodes);
+
+    // Join all leaves on the tail task so we know when we can re-arm.
+    iree_task_nop_initialize(command_buffer->scope, &command_buffer->tail_task);
+    iree_task_set_cleanup_fn(&command_buffer->tail_task.header,
+                             iree_hal_task_command_buffer_tail_cleanup);
+    iree_task_set_completion_task(&command_buffer->tail_task.header,
+                                  retire_task);
+    completion_task = &command_buffer->tail_task.header;
+  }
+
   // If the command buffer is empty (valid!) then we are a no-op.
   bool has_root_tasks = !iree_task_list_is_empty(&command_buffer->root_tasks);
   if (!has_root_tasks) {
     return iree_ok_status();
   }
 
-  bool has_leaf_tasks = !iree_task_list_is_empty(&command_buffer->leaf_tasks);
-  if (has_leaf_tasks) {
-    // Chain the retire task onto the leaf tasks as their completion indicates
-    // that all commands have completed.
-    for (iree_task_t* task = command_buffer->leaf_tasks.head; task != NULL;
-         task = task->next_task) {
-      iree_task_set_completion_task(task, retire_task);
-    }
-  } else {
-    // If we have no leaf tasks it means that this is a single layer DAG and
-    // after the root tasks complete the entire command buffer has completed.
-    for (iree_task_t* task = command_buffer->root_tasks.head; task != NULL;
-         task = task->next_task) {
-      iree_task_set_completion_task(task, retire_task);
-    }
+  // Chain the retire task onto the leaf tasks as their completion indicates
+  // that all commands have completed.
+  for (iree_host_size_t i = 0; i < command_buffer->leaf_task_count; ++i) {
+    iree_task_set_completion_task(command_buffer->leaf_tasks[i],
+                                  completion_task);
   }
 
   // Enqueue all root tasks that are ready to run immediately.
@@ -387,7 +611,10 @@ iree_status_t iree_hal_task_command_buffer_issue(
   // we need to ensure the command buffer doesn't try to discard them.
   iree_task_submission_enqueue_list(pending_submission,
                                     &command_buffer->root_tasks);
-  iree_task_list_initialize(&command_buffer->leaf_tasks);
+  if (command_buffer->nodes == NULL) {
+    command_buffer->leaf_tasks = NULL;
+    command_buffer->leaf_task_count = 0;
+  }
 
   return iree_ok_status();
 }
@@ -424,9 +651,10 @@ static iree_status_t iree_hal_task_command_buffer_execution_barrier(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
-  // TODO(benvanik): actual DAG construction. Right now we are just doing simple
-  // global barriers each time and forcing a join-fork point.
-  return iree_hal_task_command_buffer_emit_global_barrier(command_buffer);
+  // NOTE: we don't yet use the memory/buffer barriers to further scope the
+  // barrier; the dependency DAG is built from the buffer ranges used by each
+  // command instead.
+  return iree_hal_task_command_buffer_emit_barrier(command_buffer);
 }
 
 //===----------------------------------------------------------------------===//
@@ -436,7 +664,7 @@ static iree_status_t iree_hal_task_command_buffer_execution_barrier(
 static iree_status_t iree_hal_task_command_buffer_signal_event(
     iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
     iree_hal_execution_stage_t source_stage_mask) {
-  // TODO(#4518): implement events. For now we just insert global barriers.
+  // TODO(#4518): implement events. For now we just insert barriers.
   return iree_ok_status();
 }
 
@@ -447,7 +675,7 @@ static iree_status_t iree_hal_task_command_buffer_signal_event(
 static iree_status_t iree_hal_task_command_buffer_reset_event(
     iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
     iree_hal_execution_stage_t source_stage_mask) {
-  // TODO(#4518): implement events. For now we just insert global barriers.
+  // TODO(#4518): implement events. For now we just insert barriers.
   return iree_ok_status();
 }
 
@@ -466,8 +694,8 @@ static iree_status_t iree_hal_task_command_buffer_wait_events(
     const iree_hal_buffer_barrier_t* buffer_barriers) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
-  // TODO(#4518): implement events. For now we just insert global barriers.
-  return iree_hal_task_command_buffer_emit_global_barrier(command_buffer);
+  // TODO(#4518): implement events. For now we just insert barriers.
+  return iree_hal_task_command_buffer_emit_barrier(command_buffer);
 }
 
 //===----------------------------------------------------------------------===//
@@ -480,22 +708,53 @@ static iree_status_t iree_hal_task_command_buffer_discard_buffer(
 }
 
 //===----------------------------------------------------------------------===//
-// iree_hal_command_buffer_fill_buffer
+// Transfer slicing
 //===----------------------------------------------------------------------===//
-// NOTE: for large copies we dispatch this as tiles for parallelism.
-// We'd want to do some measurement for when it's worth it; filling a 200KB
-// buffer: maybe not, filling a 200MB buffer: yeah. For now we just do
-// arbitrarily sized chunks.
+// NOTE: fills and copies are dispatched as tiles of slice_length bytes for
+// parallelism. The slice length is chosen by the device from the cache sizes
+// such that each tile stays within the cache of the worker executing it.
+
+// Returns the workgroup size and count used to dispatch a transfer of |length|.
+static void iree_hal_task_command_buffer_transfer_workgroups(
+    iree_hal_task_command_buffer_t* command_buffer, iree_device_size_t length,
+    uint32_t out_workgroup_size[3], uint32_t out_workgroup_count[3]) {
+  iree_device_size_t slice_length =
+      command_buffer->transfer_params.slice_length;
+  out_workgroup_size[0] = (uint32_t)slice_length;
+  out_workgroup_size[1] = 1;
+  out_workgroup_size[2] = 1;
+  // Empty transfers still produce a single (empty) tile so that the command
+  // participates in the DAG like any other.
+  out_workgroup_count[0] =
+      (uint32_t)iree_max(1, (length + slice_length - 1) / slice_length);
+  out_workgroup_count[1] = 1;
+  out_workgroup_count[2] = 1;
+}
 
-// TODO(benvanik): make this a configurable setting. Must be aligned to pattern
-// length so pick a power of two.
-#define IREE_HAL_CMD_FILL_SLICE_LENGTH (128 * 1024)
+// Returns the range of the transfer of |length| bytes handled by a tile.
+static void iree_hal_task_transfer_tile_range(
+    const iree_task_tile_context_t* tile_context, iree_device_size_t length,
+    iree_device_size_t* out_slice_offset,
+    iree_device_size_t* out_slice_length) {
+  iree_device_size_t length_per_slice = tile_context->workgroup_size[0];
+  iree_device_size_t slice_offset =
+      (iree_device_size_t)tile_context->workgroup_xyz[0] * length_per_slice;
+  *out_slice_offset = slice_offset;
+  *out_slice_length =
+      slice_offset < length ? iree_min(length_per_slice, length - slice_offset)
+                            : 0;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_command_buffer_fill_buffer
+//===----------------------------------------------------------------------===//
 
 typedef struct iree_hal_cmd_fill_buffer_t {
   iree_task_dispatch_t task;
   iree_hal_buffer_t* target_buffer;
   iree_device_size_t target_offset;
   iree_device_size_t length;
+  bool nontemporal;
   uint32_t pattern_length;
   uint8_t pattern[8];
 } iree_hal_cmd_fill_buffer_t;
@@ -505,19 +764,25 @@ static iree_status_t iree_hal_cmd_fill_tile(
     iree_task_submission_t* pending_submission) {
   const iree_hal_cmd_fill_buffer_t* cmd =
       (const iree_hal_cmd_fill_buffer_t*)user_context;
+  iree_device_size_t slice_offset = 0;
+  iree_device_size_t slice_length = 0;
+  iree_hal_task_transfer_tile_range(tile_context, cmd->length, &slice_offset,
+                                    &slice_length);
+  if (!slice_length) return iree_ok_status();
   IREE_TRACE_ZONE_BEGIN(z0);
-
-  uint32_t length_per_slice = tile_context->workgroup_size[0];
-  iree_device_size_t slice_offset =
-      tile_context->workgroup_xyz[0] * length_per_slice;
-  iree_device_size_t remaining_length = cmd->length - slice_offset;
-  iree_device_size_t slice_length =
-      iree_min(length_per_slice, remaining_length);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)slice_length);
 
-  iree_status_t status = iree_hal_buffer_fill(
-      cmd->target_buffer, cmd->target_offset + slice_offset, slice_length,
-      cmd->pattern, cmd->pattern_length);
+  iree_hal_buffer_mapping_t target_mapping;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_buffer_map_range(
+              cmd->target_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+              IREE_HAL_MEMORY_ACCESS_DISCARD_WRITE,
+              cmd->target_offset + slice_offset, slice_length,
+              &target_mapping));
+  iree_hal_local_fill_memory(target_mapping.contents.data,
+                             target_mapping.contents.data_length, cmd->pattern,
+                             cmd->pattern_length, cmd->nontemporal);
+  iree_status_t status = iree_hal_buffer_unmap_range(&target_mapping);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -538,16 +803,10 @@ static iree_status_t iree_hal_task_command_buffer_fill_buffer(
   IREE_RETURN_IF_ERROR(
       iree_arena_allocate(&command_buffer->arena, sizeof(*cmd), (void**)&cmd));
 
-  const uint32_t workgroup_size[3] = {
-      /*x=*/IREE_HAL_CMD_FILL_SLICE_LENGTH,
-      /*y=*/1,
-      /*z=*/1,
-  };
-  const uint32_t workgroup_count[3] = {
-      /*x=*/length / workgroup_size[0] + 1,
-      /*y=*/1,
-      /*z=*/1,
-  };
+  uint32_t workgroup_size[3];
+  uint32_t workgroup_count[3];
+  iree_hal_task_command_buffer_transfer_workgroups(
+      command_buffer, length, workgroup_size, workgroup_count);
   iree_task_dispatch_initialize(
       command_buffer->scope,
       iree_task_make_dispatch_closure(iree_hal_cmd_fill_tile, (void*)cmd),
@@ -555,11 +814,16 @@ static iree_status_t iree_hal_task_command_buffer_fill_buffer(
   cmd->target_buffer = target_buffer;
   cmd->target_offset = target_offset;
   cmd->length = length;
+  cmd->nontemporal =
+      length >= command_buffer->transfer_params.nontemporal_threshold;
   memcpy(cmd->pattern, pattern, pattern_length);
   cmd->pattern_length = pattern_length;
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  const iree_hal_task_cmd_range_t ranges[1] = {
+      {target_buffer, target_offset, length, /*is_write=*/true},
+  };
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, IREE_ARRAYSIZE(ranges), ranges);
 }
 
 //===----------------------------------------------------------------------===//
@@ -614,21 +878,16 @@ static iree_status_t iree_hal_task_command_buffer_update_buffer(
   memcpy(cmd->source_buffer, (const uint8_t*)source_buffer + source_offset,
          cmd->length);
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  const iree_hal_task_cmd_range_t ranges[1] = {
+      {target_buffer, target_offset, length, /*is_write=*/true},
+  };
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, IREE_ARRAYSIZE(ranges), ranges);
 }
 
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_copy_buffer
 //===----------------------------------------------------------------------===//
-// NOTE: for large copies we dispatch this as tiles for parallelism.
-// We'd want to do some measurement for when it's worth it; copying a 200KB
-// buffer: maybe not, copying a 200MB buffer: yeah. For now we just do
-// arbitrarily sized chunks.
-
-// TODO(benvanik): make this a configurable setting. Must be aligned to pattern
-// length so pick a power of two.
-#define IREE_HAL_CMD_COPY_SLICE_LENGTH (128 * 1024)
 
 typedef struct iree_hal_cmd_copy_buffer_t {
   iree_task_dispatch_t task;
@@ -637,6 +896,7 @@ typedef struct iree_hal_cmd_copy_buffer_t {
   iree_hal_buffer_t* target_buffer;
   iree_device_size_t target_offset;
   iree_device_size_t length;
+  bool nontemporal;
 } iree_hal_cmd_copy_buffer_t;
 
 static iree_status_t iree_hal_cmd_copy_tile(
@@ -644,19 +904,33 @@ static iree_status_t iree_hal_cmd_copy_tile(
     iree_task_submission_t* pending_submission) {
   const iree_hal_cmd_copy_buffer_t* cmd =
       (const iree_hal_cmd_copy_buffer_t*)user_context;
+  iree_device_size_t slice_offset = 0;
+  iree_device_size_t slice_length = 0;
+  iree_hal_task_transfer_tile_range(tile_context, cmd->length, &slice_offset,
+                                    &slice_length);
+  if (!slice_length) return iree_ok_status();
   IREE_TRACE_ZONE_BEGIN(z0);
-
-  uint32_t length_per_slice = tile_context->workgroup_size[0];
-  iree_device_size_t slice_offset =
-      tile_context->workgroup_xyz[0] * length_per_slice;
-  iree_device_size_t remaining_length = cmd->length - slice_offset;
-  iree_device_size_t slice_length =
-      iree_min(length_per_slice, remaining_length);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)slice_length);
 
-  iree_status_t status = iree_hal_buffer_copy_data(
-      cmd->source_buffer, cmd->source_offset + slice_offset, cmd->target_buffer,
-      cmd->target_offset + slice_offset, slice_length);
+  iree_hal_buffer_mapping_t source_mapping;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_buffer_map_range(
+              cmd->source_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+              IREE_HAL_MEMORY_ACCESS_READ, cmd->source_offset + slice_offset,
+              slice_length, &source_mapping));
+  iree_hal_buffer_mapping_t target_mapping;
+  iree_status_t status = iree_hal_buffer_map_range(
+      cmd->target_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+      IREE_HAL_MEMORY_ACCESS_DISCARD_WRITE, cmd->target_offset + slice_offset,
+      slice_length, &target_mapping);
+  if (iree_status_is_ok(status)) {
+    iree_hal_local_copy_memory(
+        target_mapping.contents.data, source_mapping.contents.data,
+        target_mapping.contents.data_length, cmd->nontemporal);
+    status = iree_hal_buffer_unmap_range(&target_mapping);
+  }
+  status =
+      iree_status_join(status, iree_hal_buffer_unmap_range(&source_mapping));
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -678,16 +952,10 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
   IREE_RETURN_IF_ERROR(
       iree_arena_allocate(&command_buffer->arena, sizeof(*cmd), (void**)&cmd));
 
-  const uint32_t workgroup_size[3] = {
-      /*x=*/IREE_HAL_CMD_COPY_SLICE_LENGTH,
-      /*y=*/1,
-      /*z=*/1,
-  };
-  const uint32_t workgroup_count[3] = {
-      /*x=*/length / workgroup_size[0] + 1,
-      /*y=*/1,
-      /*z=*/1,
-  };
+  uint32_t workgroup_size[3];
+  uint32_t workgroup_count[3];
+  iree_hal_task_command_buffer_transfer_workgroups(
+      command_buffer, length, workgroup_size, workgroup_count);
   iree_task_dispatch_initialize(
       command_buffer->scope,
       iree_task_make_dispatch_closure(iree_hal_cmd_copy_tile, (void*)cmd),
@@ -697,9 +965,15 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
   cmd->target_buffer = target_buffer;
   cmd->target_offset = target_offset;
   cmd->length = length;
+  cmd->nontemporal =
+      length >= command_buffer->transfer_params.nontemporal_threshold;
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  const iree_hal_task_cmd_range_t ranges[2] = {
+      {source_buffer, source_offset, length, /*is_write=*/false},
+      {target_buffer, target_offset, length, /*is_write=*/true},
+  };
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, IREE_ARRAYSIZE(ranges), ranges);
 }
 
 //===----------------------------------------------------------------------===//
@@ -745,6 +1019,10 @@ static iree_status_t iree_hal_task_command_buffer_push_descriptor_set(
                             "set %u out of bounds", set);
   }
 
+  IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert_span(
+      command_buffer->resource_set, binding_count, &bindings[0].buffer,
+      sizeof(bindings[0])));
+
   iree_host_size_t binding_base =
       set * IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT;
   for (iree_host_size_t i = 0; i < binding_count; ++i) {
@@ -755,10 +1033,6 @@ static iree_status_t iree_hal_task_command_buffer_push_descriptor_set(
     }
     iree_host_size_t binding_ordinal = binding_base + bindings[i].binding;
 
-    // TODO(benvanik): batch insert by getting the resources in their own list.
-    IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
-        command_buffer->resource_set, 1, &bindings[i].buffer));
-
     // TODO(benvanik): track mapping so we can properly map/unmap/flush/etc.
     iree_hal_buffer_mapping_t buffer_mapping = {{0}};
     IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
@@ -769,6 +1043,8 @@ static iree_status_t iree_hal_task_command_buffer_push_descriptor_set(
         buffer_mapping.contents.data;
     command_buffer->state.binding_lengths[binding_ordinal] =
         buffer_mapping.contents.data_length;
+    command_buffer->state.binding_buffers[binding_ordinal] = bindings[i].buffer;
+    command_buffer->state.binding_offsets[binding_ordinal] = bindings[i].offset;
   }
 
   return iree_ok_status();
@@ -853,10 +1129,49 @@ static iree_status_t iree_hal_cmd_dispatch_tile(
   return status;
 }
 
+// Translates the compiler-provided |attrs| of an entry point into the
+// scheduling parameters and execution requirements of |dispatch_task|.
+static void iree_hal_task_command_buffer_apply_dispatch_attrs(
+    const iree_hal_executable_dispatch_attrs_v0_t* attrs,
+    iree_task_dispatch_t* dispatch_task) {
+  // Tell the task system how much workgroup local memory is required for the
+  // dispatch; each invocation of the entry point will have at least as much
+  // scratch memory available during execution.
+  dispatch_task->local_memory_size =
+      attrs->local_memory_pages * IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE;
+
+  // The estimated workgroup cost lets the task system avoid spreading cheap
+  // dispatches across more workers than can usefully participate. Memory-bound
+  // workgroups stop scaling once bandwidth is saturated so we under-report
+  // their cost to keep them on fewer workers.
+  uint32_t cost_log2 = iree_min(attrs->workgroup_cost_log2, 31);
+  if (cost_log2 > 1 &&
+      (attrs->flags & IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_MEMORY_BOUND)) {
+    --cost_log2;
+  }
+  dispatch_task->tile_cost = cost_log2 ? (1u << cost_log2) : 0;
+
+  // Preferred grouping maps directly to the number of tiles each shard
+  // reserves at a time; dispatches with no preference use the executor value.
+  uint32_t grouping =
+      (attrs->flags &
+       IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_TILE_GROUPING_MASK) >>
+      IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_TILE_GROUPING_SHIFT;
+  dispatch_task->preferred_tiles_per_reservation =
+      grouping ? (1u << (grouping - 1)) : 0;
+
+  // Unlike the hints above this must be honored; workers flush denormals
+  // unless told otherwise.
+  if (attrs->flags & IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_PRESERVE_DENORMALS) {
+    dispatch_task->header.flags |= IREE_TASK_FLAG_DISPATCH_PRESERVE_DENORMALS;
+  }
+}
+
 static iree_status_t iree_hal_task_command_buffer_build_dispatch(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_t* executable, int32_t entry_point,
     uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z,
+    const iree_hal_task_cmd_range_t* workgroups_range,
     iree_hal_cmd_dispatch_t** out_cmd) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
@@ -898,14 +1213,10 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
       iree_task_make_dispatch_closure(iree_hal_cmd_dispatch_tile, (void*)cmd),
       workgroup_size, workgroup_count, &cmd->task);
 
-  // Tell the task system how much workgroup local memory is required for the
-  // dispatch; each invocation of the entry point will have at least as much
-  // scratch memory available during execution.
-  cmd->task.local_memory_size =
-      local_executable->dispatch_attrs
-          ? local_executable->dispatch_attrs[entry_point].local_memory_pages *
-                IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE
-          : 0;
+  if (local_executable->dispatch_attrs) {
+    iree_hal_task_command_buffer_apply_dispatch_attrs(
+        &local_executable->dispatch_attrs[entry_point], &cmd->task);
+  }
 
   // Copy only the push constant range used by the executable.
   uint8_t* cmd_ptr = (uint8_t*)cmd + sizeof(*cmd);
@@ -926,6 +1237,13 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
   cmd_ptr += used_binding_count * sizeof(*binding_ptrs);
   size_t* binding_lengths = (size_t*)cmd_ptr;
   cmd_ptr += used_binding_count * sizeof(*binding_lengths);
+
+  // Each binding is treated as read/write unless the buffer bound disallows
+  // writes as we don't (yet) know the access performed by the executable.
+  iree_hal_task_cmd_range_t ranges[IREE_HAL_LOCAL_BINDING_MASK_BITS + 1];
+  iree_host_size_t range_count = 0;
+  if (workgroups_range) ranges[range_count++] = *workgroups_range;
+
   iree_host_size_t binding_base = 0;
   for (iree_host_size_t i = 0; i < used_binding_count; ++i) {
     int mask_offset = iree_math_count_trailing_zeros_u64(used_binding_mask);
@@ -938,11 +1256,21 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
       return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
                               "(flat) binding %d is NULL", binding_ordinal);
     }
+    iree_hal_buffer_t* binding_buffer =
+        command_buffer->state.binding_buffers[binding_ordinal];
+    ranges[range_count++] = (iree_hal_task_cmd_range_t){
+        .buffer = binding_buffer,
+        .offset = command_buffer->state.binding_offsets[binding_ordinal],
+        .length = binding_lengths[i],
+        .is_write = iree_all_bits_set(
+            iree_hal_buffer_allowed_access(binding_buffer),
+            IREE_HAL_MEMORY_ACCESS_WRITE),
+    };
   }
 
   *out_cmd = cmd;
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, range_count, ranges);
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch(
@@ -956,7 +1284,7 @@ static iree_status_t iree_hal_task_command_buffer_dispatch(
   iree_hal_cmd_dispatch_t* cmd = NULL;
   return iree_hal_task_command_buffer_build_dispatch(
       base_command_buffer, executable, entry_point, workgroup_x, workgroup_y,
-      workgroup_z, &cmd);
+      workgroup_z, /*workgroups_range=*/NULL, &cmd);
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
@@ -978,9 +1306,16 @@ static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
       IREE_HAL_MEMORY_ACCESS_READ, workgroups_offset, 3 * sizeof(uint32_t),
       &buffer_mapping));
 
+  // The workgroup count is read immediately prior to the dispatch being issued
+  // and must be ordered after any prior writes.
+  const iree_hal_task_cmd_range_t workgroups_range = {
+      workgroups_buffer, workgroups_offset, 3 * sizeof(uint32_t),
+      /*is_write=*/false};
+
   iree_hal_cmd_dispatch_t* cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_build_dispatch(
-      base_command_buffer, executable, entry_point, 0, 0, 0, &cmd));
+      base_command_buffer, executable, entry_point, 0, 0, 0, &workgroups_range,
+      &cmd));
   cmd->task.workgroup_count.ptr = (const uint32_t*)buffer_mapping.contents.data;
   cmd->task.header.flags |= IREE_TASK_FLAG_DISPATCH_INDIRECT;
   return iree_ok_status();
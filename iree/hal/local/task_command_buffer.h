@@ -18,11 +18,36 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Controls how fill and copy commands are executed.
+typedef struct iree_hal_task_transfer_params_t {
+  // Length in bytes of the slices that transfers are split into. Each slice is
+  // executed as a tile of a dispatch so that large transfers are spread across
+  // workers. Must be a power of two of at least 4 bytes (the largest fill
+  // pattern) so that slices remain pattern aligned.
+  iree_device_size_t slice_length;
+  // Transfers of at least this many bytes use non-temporal stores that bypass
+  // the cache as they would otherwise evict the working set of the device
+  // without any of the data they write still being resident when next read.
+  // IREE_HAL_TASK_TRANSFER_NONTEMPORAL_NEVER disables non-temporal stores.
+  iree_device_size_t nontemporal_threshold;
+} iree_hal_task_transfer_params_t;
+
+// Disables non-temporal stores when used as the nontemporal_threshold.
+#define IREE_HAL_TASK_TRANSFER_NONTEMPORAL_NEVER (~(iree_device_size_t)0)
+
+// Creates a command buffer that records directly into a task DAG.
+//
+// Command buffers without IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT are reusable:
+// the task graph is built once when recording ends and re-armed on each issue
+// without any additional allocations. Executions of a reusable command buffer
+// must not overlap; each must be ordered after the previous one has retired
+// (such as by waiting on a semaphore signaled by the prior submission).
 iree_status_t iree_hal_task_command_buffer_create(
     iree_hal_device_t* device, iree_task_scope_t* scope,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_task_transfer_params_t* transfer_params,
     iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer);
 
@@ -46,6 +71,9 @@ bool iree_hal_task_command_buffer_isa(
 //
 // |pending_submission| will receive the ready list of commands and must be
 // submitted to the executor (or discarded on failure) by the caller.
+//
+// Returns IREE_STATUS_FAILED_PRECONDITION if the command buffer is reusable and
+// a prior issue of it is still executing.
 iree_status_t iree_hal_task_command_buffer_issue(
     iree_hal_command_buffer_t* command_buffer,
     iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
@@ -0,0 +1,195 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/task_command_buffer.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/task_device.h"
+#include "iree/task/executor.h"
+#include "iree/task/topology.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using namespace iree::testing::status;
+
+constexpr iree_device_size_t kBufferSize = 1024;
+
+// Slices small enough that fills are split across several tiles.
+constexpr iree_device_size_t kSliceLength = 64;
+
+// Issues task command buffers directly into a threadless executor so that
+// nothing executes until the test donates its thread. This lets tests issue
+// while a prior issue is known to still be pending.
+class TaskCommandBufferTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    iree_allocator_t host_allocator = iree_allocator_system();
+
+    // An empty topology creates the executor in threadless mode.
+    iree_task_executor_options_t options;
+    iree_task_executor_options_initialize(&options);
+    iree_task_topology_t topology;
+    iree_task_topology_initialize(&topology);
+    IREE_ASSERT_OK(iree_task_executor_create(&options, &topology,
+                                             host_allocator, &executor_));
+    iree_task_topology_deinitialize(&topology);
+
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("heap"), host_allocator, host_allocator,
+        &device_allocator_));
+    iree_hal_task_device_params_t params;
+    iree_hal_task_device_params_initialize(&params);
+    IREE_ASSERT_OK(iree_hal_task_device_create(
+        iree_make_cstring_view("task"), &params, executor_,
+        /*loader_count=*/0, /*loaders=*/NULL, device_allocator_,
+        host_allocator, &device_));
+
+    iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope_);
+    iree_arena_block_pool_initialize(4096, host_allocator, &block_pool_);
+    iree_arena_initialize(&block_pool_, &arena_);
+    iree_hal_task_queue_state_initialize(&queue_state_);
+
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_,
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING,
+        kBufferSize, iree_const_byte_span_empty(), &buffer_));
+  }
+
+  virtual void TearDown() {
+    iree_hal_buffer_release(buffer_);
+    iree_hal_task_queue_state_deinitialize(&queue_state_);
+    iree_arena_deinitialize(&arena_);
+    iree_arena_block_pool_deinitialize(&block_pool_);
+    iree_task_scope_deinitialize(&scope_);
+    iree_hal_device_release(device_);
+    iree_hal_allocator_release(device_allocator_);
+    iree_task_executor_release(executor_);
+  }
+
+  // Records a reusable command buffer that fills |buffer_| with |pattern|.
+  iree_hal_command_buffer_t* CreateReusableFill(uint32_t pattern) {
+    iree_hal_task_transfer_params_t transfer_params = {
+        kSliceLength,
+        IREE_HAL_TASK_TRANSFER_NONTEMPORAL_NEVER,
+    };
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    IREE_CHECK_OK(iree_hal_task_command_buffer_create(
+        device_, &scope_, /*mode=*/0,
+        IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+        &transfer_params, &block_pool_, iree_allocator_system(),
+        &command_buffer));
+    IREE_CHECK_OK(iree_hal_command_buffer_begin(command_buffer));
+    IREE_CHECK_OK(iree_hal_command_buffer_fill_buffer(
+        command_buffer, buffer_, 0, kBufferSize, &pattern, sizeof(pattern)));
+    IREE_CHECK_OK(iree_hal_command_buffer_end(command_buffer));
+    return command_buffer;
+  }
+
+  // Issues |command_buffer| into |submission| retiring on a new fence that
+  // keeps |scope_| active until the execution has completed.
+  iree_status_t Issue(iree_hal_command_buffer_t* command_buffer,
+                      iree_task_submission_t* submission) {
+    iree_task_fence_t* fence = NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_task_executor_acquire_fence(executor_, &scope_, &fence));
+    iree_status_t status = iree_hal_task_command_buffer_issue(
+        command_buffer, &queue_state_, &fence->header, &arena_, submission);
+    if (!iree_status_is_ok(status)) {
+      iree_task_list_t discard_worklist;
+      iree_task_list_initialize(&discard_worklist);
+      iree_task_discard(&fence->header, &discard_worklist);
+      iree_task_list_discard(&discard_worklist);
+    }
+    return status;
+  }
+
+  // Submits |submission| and executes it to completion on the calling thread.
+  void Execute(iree_task_submission_t* submission) {
+    iree_task_executor_submit(executor_, submission);
+    IREE_ASSERT_OK(iree_task_executor_donate_caller(
+        executor_, iree_task_scope_await_idle(&scope_),
+        iree_infinite_timeout()));
+    IREE_ASSERT_OK(iree_task_scope_consume_status(&scope_));
+  }
+
+  // Returns the contents of |buffer_| as 32-bit words.
+  std::vector<uint32_t> ReadBuffer() {
+    std::vector<uint32_t> data(kBufferSize / sizeof(uint32_t));
+    IREE_CHECK_OK(
+        iree_hal_buffer_read_data(buffer_, 0, data.data(), kBufferSize));
+    return data;
+  }
+
+  iree_task_executor_t* executor_ = NULL;
+  iree_hal_allocator_t* device_allocator_ = NULL;
+  iree_hal_device_t* device_ = NULL;
+  iree_task_scope_t scope_;
+  iree_arena_block_pool_t block_pool_;
+  iree_arena_allocator_t arena_;
+  iree_hal_task_queue_state_t queue_state_;
+  iree_hal_buffer_t* buffer_ = NULL;
+};
+
+// Tests that a reusable command buffer produces its results on each of several
+// sequential executions.
+TEST_F(TaskCommandBufferTest, ReissueSequentially) {
+  const uint32_t pattern = 0xCAFEF00Du;
+  iree_hal_command_buffer_t* command_buffer = CreateReusableFill(pattern);
+  for (int i = 0; i < 2; ++i) {
+    IREE_ASSERT_OK(iree_hal_buffer_zero(buffer_, 0, kBufferSize));
+
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    IREE_ASSERT_OK(Issue(command_buffer, &submission));
+    Execute(&submission);
+
+    EXPECT_EQ(ReadBuffer(), std::vector<uint32_t>(kBufferSize / 4, pattern))
+        << "execution " << i;
+  }
+  iree_hal_command_buffer_release(command_buffer);
+}
+
+// Tests that issuing a reusable command buffer while a prior issue has not yet
+// retired fails instead of corrupting the in-flight task graph.
+TEST_F(TaskCommandBufferTest, ReissueWhileInFlight) {
+  const uint32_t pattern = 0x12345678u;
+  iree_hal_command_buffer_t* command_buffer = CreateReusableFill(pattern);
+  IREE_ASSERT_OK(iree_hal_buffer_zero(buffer_, 0, kBufferSize));
+
+  // Nothing runs on the threadless executor until we donate so the first
+  // issue is still pending when we try to issue again.
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  IREE_ASSERT_OK(Issue(command_buffer, &submission));
+
+  iree_task_submission_t overlapping_submission;
+  iree_task_submission_initialize(&overlapping_submission);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_FAILED_PRECONDITION,
+                        Issue(command_buffer, &overlapping_submission));
+  EXPECT_TRUE(iree_task_submission_is_empty(&overlapping_submission));
+
+  // The rejected issue must not have disturbed the pending one.
+  Execute(&submission);
+  EXPECT_EQ(ReadBuffer(), std::vector<uint32_t>(kBufferSize / 4, pattern));
+
+  // Once retired the command buffer can be issued again.
+  IREE_ASSERT_OK(iree_hal_buffer_zero(buffer_, 0, kBufferSize));
+  iree_task_submission_initialize(&submission);
+  IREE_ASSERT_OK(Issue(command_buffer, &submission));
+  Execute(&submission);
+  EXPECT_EQ(ReadBuffer(), std::vector<uint32_t>(kBufferSize / 4, pattern));
+
+  iree_hal_command_buffer_release(command_buffer);
+}
+
+}  // namespace
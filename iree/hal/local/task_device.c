@@ -12,6 +12,7 @@
 
 #include "iree/base/internal/arena.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/local/executable_environment.h"
 #include "iree/hal/local/local_descriptor_set.h"
 #include "iree/hal/local/local_descriptor_set_layout.h"
 #include "iree/hal/local/local_executable_cache.h"
@@ -21,6 +22,7 @@
 #include "iree/hal/local/task_queue.h"
 #include "iree/hal/local/task_semaphore.h"
 #include "iree/hal/utils/buffer_transfer.h"
+#include "iree/task/topology_cpuinfo.h"
 
 typedef struct iree_hal_task_device_t {
   iree_hal_resource_t resource;
@@ -41,6 +43,9 @@ typedef struct iree_hal_task_device_t {
   iree_allocator_t host_allocator;
   iree_hal_allocator_t* device_allocator;
 
+  // Transfer parameters with all automatic values resolved.
+  iree_hal_task_transfer_params_t transfer_params;
+
   iree_host_size_t queue_count;
   iree_hal_task_queue_t queues[];
 } iree_hal_task_device_t;
@@ -57,6 +62,11 @@ void iree_hal_task_device_params_initialize(
     iree_hal_task_device_params_t* out_params) {
   out_params->arena_block_size = 32 * 1024;
   out_params->queue_count = 8;
+  out_params->queue_priority = IREE_TASK_PRIORITY_NORMAL;
+  out_params->worker_mask = iree_task_affinity_for_any_worker();
+  out_params->max_concurrency = 0;
+  out_params->transfer.slice_length = 0;
+  out_params->transfer.nontemporal_threshold = 0;
 }
 
 static iree_status_t iree_hal_task_device_check_params(
@@ -69,9 +79,73 @@ static iree_status_t iree_hal_task_device_check_params(
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "at least one queue is required");
   }
+  if (params->queue_priority > IREE_TASK_PRIORITY_HIGH) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "queue priority %d out of range",
+                            (int)params->queue_priority);
+  }
+  if (params->worker_mask == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "worker mask must include at least one worker");
+  }
+  iree_device_size_t slice_length = params->transfer.slice_length;
+  if (slice_length != 0 &&
+      (slice_length < 4 || (slice_length & (slice_length - 1)) != 0 ||
+       slice_length > UINT32_MAX)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "transfer slice length %" PRIdsz
+                            " must be a power of two between 4 and 2^31",
+                            slice_length);
+  }
   return iree_ok_status();
 }
 
+// Slice length used when cache sizes are unknown.
+#define IREE_HAL_TASK_DEFAULT_TRANSFER_SLICE_LENGTH (128 * 1024)
+// Bounds on slice lengths derived from cache sizes. Smaller slices spend more
+// time in tile overhead than transferring and larger ones limit parallelism.
+#define IREE_HAL_TASK_MIN_TRANSFER_SLICE_LENGTH (64 * 1024)
+#define IREE_HAL_TASK_MAX_TRANSFER_SLICE_LENGTH (1024 * 1024)
+// Non-temporal threshold used when the last level cache size is unknown.
+#define IREE_HAL_TASK_DEFAULT_TRANSFER_NONTEMPORAL_THRESHOLD (16 * 1024 * 1024)
+
+// Resolves the automatic values in |params| from the cache sizes of the
+// machine. Slices fill half of the L2 so that the source and target of a copy
+// slice both fit. Transfers larger than the last level cache can't be resident
+// when done and are written with non-temporal stores.
+static void iree_hal_task_device_resolve_transfer_params(
+    const iree_hal_task_transfer_params_t* params,
+    iree_hal_task_transfer_params_t* out_params) {
+  *out_params = *params;
+  if (out_params->slice_length && out_params->nontemporal_threshold) return;
+
+  iree_task_cache_sizes_t cache_sizes;
+  iree_task_topology_query_cache_sizes(&cache_sizes);
+
+  if (!out_params->slice_length) {
+    iree_device_size_t slice_length =
+        IREE_HAL_TASK_DEFAULT_TRANSFER_SLICE_LENGTH;
+    if (cache_sizes.l2) {
+      // Round down to a power of two to keep slices pattern aligned.
+      slice_length = IREE_HAL_TASK_MIN_TRANSFER_SLICE_LENGTH;
+      while (slice_length * 2 <= cache_sizes.l2 / 2 &&
+             slice_length < IREE_HAL_TASK_MAX_TRANSFER_SLICE_LENGTH) {
+        slice_length *= 2;
+      }
+    }
+    out_params->slice_length = slice_length;
+  }
+
+  if (!out_params->nontemporal_threshold) {
+    iree_host_size_t last_level_cache_size =
+        cache_sizes.l3 ? cache_sizes.l3 : cache_sizes.l2;
+    out_params->nontemporal_threshold =
+        last_level_cache_size
+            ? last_level_cache_size
+            : IREE_HAL_TASK_DEFAULT_TRANSFER_NONTEMPORAL_THRESHOLD;
+  }
+}
+
 iree_status_t iree_hal_task_device_create(
     iree_string_view_t identifier, const iree_hal_task_device_params_t* params,
     iree_task_executor_t* executor, iree_host_size_t loader_count,
@@ -104,6 +178,8 @@ iree_status_t iree_hal_task_device_create(
     device->host_allocator = host_allocator;
     device->device_allocator = device_allocator;
     iree_hal_allocator_retain(device_allocator);
+    iree_hal_task_device_resolve_transfer_params(&params->transfer,
+                                                 &device->transfer_params);
 
     iree_arena_block_pool_initialize(4096, host_allocator,
                                      &device->small_block_pool);
@@ -129,6 +205,11 @@ iree_status_t iree_hal_task_device_create(
       iree_hal_task_queue_initialize(device->identifier, device->executor,
                                      &device->small_block_pool,
                                      &device->queues[i]);
+      iree_task_scope_set_priority(&device->queues[i].scope,
+                                   params->queue_priority);
+      iree_task_scope_set_worker_affinity(&device->queues[i].scope,
+                                          params->worker_mask,
+                                          params->max_concurrency);
     }
   }
 
@@ -201,6 +282,17 @@ static iree_status_t iree_hal_task_device_query_i32(
             ? 1
             : 0;
     return iree_ok_status();
+  } else if (iree_string_view_equal(
+                 category, iree_make_cstring_view("hal.device.feature"))) {
+    // Processor features are used to select between executable variants
+    // specialized for different CPU microarchitectures.
+    iree_hal_executable_environment_v0_t environment;
+    iree_hal_executable_environment_initialize(&environment);
+    *out_value =
+        iree_hal_executable_environment_supports_feature(&environment, key)
+            ? 1
+            : 0;
+    return iree_ok_status();
   }
 
   return iree_make_status(
@@ -233,8 +325,8 @@ static iree_status_t iree_hal_task_device_create_command_buffer(
       device, command_categories, queue_affinity);
   return iree_hal_task_command_buffer_create(
       base_device, &device->queues[queue_index].scope, mode, command_categories,
-      queue_affinity, &device->large_block_pool, device->host_allocator,
-      out_command_buffer);
+      queue_affinity, &device->transfer_params, &device->large_block_pool,
+      device->host_allocator, out_command_buffer);
 }
 
 static iree_status_t iree_hal_task_device_create_descriptor_set(
@@ -287,9 +379,8 @@ static iree_status_t iree_hal_task_device_create_semaphore(
     iree_hal_device_t* base_device, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
-  return iree_hal_task_semaphore_create(
-      iree_task_executor_event_pool(device->executor), initial_value,
-      device->host_allocator, out_semaphore);
+  return iree_hal_task_semaphore_create(device->executor, initial_value,
+                                        device->host_allocator, out_semaphore);
 }
 
 static iree_status_t iree_hal_task_device_queue_submit(
@@ -323,10 +414,9 @@ static iree_status_t iree_hal_task_device_wait_semaphores(
     iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
-  return iree_hal_task_semaphore_multi_wait(
-      wait_mode, semaphore_list, timeout,
-      iree_task_executor_event_pool(device->executor),
-      &device->large_block_pool);
+  return iree_hal_task_semaphore_multi_wait(wait_mode, semaphore_list, timeout,
+                                            device->executor,
+                                            &device->large_block_pool);
 }
 
 static iree_status_t iree_hal_task_device_wait_idle(
@@ -10,6 +10,7 @@
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/task_command_buffer.h"
 #include "iree/task/executor.h"
 
 #ifdef __cplusplus
@@ -28,6 +29,27 @@ typedef struct iree_hal_task_device_params_t {
   // Larger sizes will lower overhead and ensure the heap isn't hit for
   // transient allocations while also increasing memory consumption.
   iree_host_size_t arena_block_size;
+
+  // Scheduling priority of all work submitted to the device queues relative to
+  // other devices sharing the same executor. Latency-sensitive devices can use
+  // IREE_TASK_PRIORITY_HIGH to have their dispatches preempt those of batch
+  // devices at tile reservation granularity.
+  iree_task_priority_t queue_priority;
+
+  // Workers of the executor the device queues may execute on. Devices sharing
+  // an executor can be given disjoint masks to partition its workers between
+  // them. Defaults to all workers.
+  iree_task_affinity_set_t worker_mask;
+
+  // Maximum number of workers any single dispatch of the device may occupy
+  // concurrently or 0 for no limit beyond the |worker_mask|.
+  iree_host_size_t max_concurrency;
+
+  // Controls the execution of fill and copy commands. Fields left as 0 are
+  // derived from the cache sizes of the machine: slices are sized to fit
+  // within half of the L2 cache and non-temporal stores are used for
+  // transfers larger than the L3 cache.
+  iree_hal_task_transfer_params_t transfer;
 } iree_hal_task_device_params_t;
 
 // Initializes |out_params| to default values.
@@ -120,14 +120,9 @@ static iree_status_t iree_hal_task_queue_wait_cmd(
   iree_hal_task_queue_wait_cmd_t* cmd = (iree_hal_task_queue_wait_cmd_t*)task;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_status_t status = iree_ok_status();
-  for (iree_host_size_t i = 0; i < cmd->wait_semaphores.count; ++i) {
-    status = iree_hal_task_semaphore_enqueue_timepoint(
-        cmd->wait_semaphores.semaphores[i],
-        cmd->wait_semaphores.payload_values[i],
-        cmd->task.header.completion_task, cmd->arena, pending_submission);
-    if (IREE_UNLIKELY(!iree_status_is_ok(status))) break;
-  }
+  iree_status_t status = iree_hal_task_semaphore_enqueue_timepoints(
+      &cmd->wait_semaphores, cmd->task.header.completion_task, cmd->arena,
+      pending_submission);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -401,7 +396,7 @@ void iree_hal_task_queue_deinitialize(iree_hal_task_queue_t* queue) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_status_ignore(
-      iree_task_scope_wait_idle(&queue->scope, IREE_TIME_INFINITE_FUTURE));
+      iree_hal_task_queue_wait_idle(queue, iree_infinite_timeout()));
 
   iree_slim_mutex_lock(&queue->mutex);
   IREE_ASSERT(!queue->tail_issue_task);
@@ -537,9 +532,7 @@ iree_status_t iree_hal_task_queue_submit_and_wait(
       iree_hal_task_queue_submit_batches(queue, batch_count, batches);
   if (iree_status_is_ok(status)) {
     // Flush the pending submissions and begin processing, then wait until idle.
-    // TODO(benvanik): get a wait_handle we can pass to
-    // iree_task_executor_donate_caller - it'll flush + do work.
-    iree_task_executor_flush(queue->executor);
+    // Waiting donates the caller to the executor so it'll flush + do work.
     status = iree_hal_task_queue_wait_idle(queue, timeout);
   }
 
@@ -550,8 +543,8 @@ iree_status_t iree_hal_task_queue_submit_and_wait(
 iree_status_t iree_hal_task_queue_wait_idle(iree_hal_task_queue_t* queue,
                                             iree_timeout_t timeout) {
   IREE_TRACE_ZONE_BEGIN(z0);
-  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
-  iree_status_t status = iree_task_scope_wait_idle(&queue->scope, deadline_ns);
+  iree_status_t status = iree_task_executor_donate_caller(
+      queue->executor, iree_task_scope_await_idle(&queue->scope), timeout);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
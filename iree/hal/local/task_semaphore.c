@@ -133,6 +133,10 @@ static void iree_hal_task_timepoint_list_notify_ready(
 typedef struct iree_hal_task_semaphore_t {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
+
+  // Executor that waiters donate themselves to while blocked on the semaphore.
+  // This is required for threadless executors to make progress.
+  iree_task_executor_t* executor;
   iree_event_pool_t* event_pool;
 
   // Guards all mutable fields. We expect low contention on semaphores and since
@@ -167,9 +171,9 @@ static iree_hal_task_semaphore_t* iree_hal_task_semaphore_cast(
 }
 
 iree_status_t iree_hal_task_semaphore_create(
-    iree_event_pool_t* event_pool, uint64_t initial_value,
+    iree_task_executor_t* executor, uint64_t initial_value,
     iree_allocator_t host_allocator, iree_hal_semaphore_t** out_semaphore) {
-  IREE_ASSERT_ARGUMENT(event_pool);
+  IREE_ASSERT_ARGUMENT(executor);
   IREE_ASSERT_ARGUMENT(out_semaphore);
   *out_semaphore = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -181,7 +185,9 @@ iree_status_t iree_hal_task_semaphore_create(
     iree_hal_resource_initialize(&iree_hal_task_semaphore_vtable,
                                  &semaphore->resource);
     semaphore->host_allocator = host_allocator;
-    semaphore->event_pool = event_pool;
+    semaphore->executor = executor;
+    iree_task_executor_retain(executor);
+    semaphore->event_pool = iree_task_executor_event_pool(executor);
 
     iree_slim_mutex_initialize(&semaphore->mutex);
     semaphore->current_value = initial_value;
@@ -206,6 +212,7 @@ static void iree_hal_task_semaphore_destroy(
   iree_status_free(semaphore->failure_status);
   iree_notification_deinitialize(&semaphore->notification);
   iree_slim_mutex_deinitialize(&semaphore->mutex);
+  iree_task_executor_release(semaphore->executor);
   iree_allocator_free(host_allocator, semaphore);
 
   IREE_TRACE_ZONE_END(z0);
@@ -298,18 +305,33 @@ static void iree_hal_task_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
   iree_hal_task_timepoint_list_notify_ready(&ready_list);
 }
 
+// Inserts a timepoint waiting for the given value that will signal |event|.
+// |out_timepoint| is owned by the caller and must be kept live until the
+// timepoint has been reached (or it is cancelled by the caller). The caller
+// retains ownership of |event| and must release it back to the pool.
+// Must be called with the semaphore lock held.
+static void iree_hal_task_semaphore_insert_timepoint(
+    iree_hal_task_semaphore_t* semaphore, uint64_t minimum_value,
+    iree_event_t event, iree_hal_task_timepoint_t* out_timepoint) {
+  memset(out_timepoint, 0, sizeof(*out_timepoint));
+  out_timepoint->payload_value = minimum_value;
+  out_timepoint->event = event;
+  iree_hal_task_timepoint_list_append(&semaphore->timepoint_list,
+                                      out_timepoint);
+}
+
 // Acquires a timepoint waiting for the given value.
 // |out_timepoint| is owned by the caller and must be kept live until the
 // timepoint has been reached (or it is cancelled by the caller).
+// Must be called with the semaphore lock held.
 static iree_status_t iree_hal_task_semaphore_acquire_timepoint(
     iree_hal_task_semaphore_t* semaphore, uint64_t minimum_value,
     iree_hal_task_timepoint_t* out_timepoint) {
-  memset(out_timepoint, 0, sizeof(*out_timepoint));
-  out_timepoint->payload_value = minimum_value;
+  iree_event_t event;
   IREE_RETURN_IF_ERROR(
-      iree_event_pool_acquire(semaphore->event_pool, 1, &out_timepoint->event));
-  iree_hal_task_timepoint_list_append(&semaphore->timepoint_list,
-                                      out_timepoint);
+      iree_event_pool_acquire(semaphore->event_pool, 1, &event));
+  iree_hal_task_semaphore_insert_timepoint(semaphore, minimum_value, event,
+                                           out_timepoint);
   return iree_ok_status();
 }
 
@@ -336,6 +358,29 @@ static void iree_hal_task_semaphore_wait_cmd_cleanup(
   }
 }
 
+// Enqueues a wait task for |issue_task| that waits on |event| being signaled
+// by a timepoint inserted for |minimum_value|. Ownership of |event| transfers
+// to the wait task if this succeeds and otherwise remains with the caller.
+// Must be called with the semaphore lock held.
+static iree_status_t iree_hal_task_semaphore_enqueue_wait_cmd(
+    iree_hal_task_semaphore_t* semaphore, uint64_t minimum_value,
+    iree_event_t event, iree_task_t* issue_task, iree_arena_allocator_t* arena,
+    iree_task_submission_t* submission) {
+  iree_hal_task_semaphore_wait_cmd_t* cmd = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(arena, sizeof(*cmd), (void**)&cmd));
+  iree_hal_task_semaphore_insert_timepoint(semaphore, minimum_value, event,
+                                           &cmd->timepoint);
+  iree_task_wait_initialize(issue_task->scope,
+                            iree_event_await(&cmd->timepoint.event),
+                            IREE_TIME_INFINITE_FUTURE, &cmd->task);
+  iree_task_set_cleanup_fn(&cmd->task.header,
+                           iree_hal_task_semaphore_wait_cmd_cleanup);
+  iree_task_set_completion_task(&cmd->task.header, issue_task);
+  cmd->semaphore = semaphore;
+  iree_task_submission_enqueue(submission, &cmd->task.header);
+  return iree_ok_status();
+}
+
 iree_status_t iree_hal_task_semaphore_enqueue_timepoint(
     iree_hal_semaphore_t* base_semaphore, uint64_t minimum_value,
     iree_task_t* issue_task, iree_arena_allocator_t* arena,
@@ -350,25 +395,88 @@ iree_status_t iree_hal_task_semaphore_enqueue_timepoint(
     // Fast path: already satisfied.
   } else {
     // Slow path: acquire a system wait handle and perform a full wait.
-    iree_hal_task_semaphore_wait_cmd_t* cmd = NULL;
-    status = iree_arena_allocate(arena, sizeof(*cmd), (void**)&cmd);
+    iree_event_t event;
+    status = iree_event_pool_acquire(semaphore->event_pool, 1, &event);
     if (iree_status_is_ok(status)) {
-      status = iree_hal_task_semaphore_acquire_timepoint(
-          semaphore, minimum_value, &cmd->timepoint);
+      status = iree_hal_task_semaphore_enqueue_wait_cmd(
+          semaphore, minimum_value, event, issue_task, arena, submission);
+      if (!iree_status_is_ok(status)) {
+        iree_event_pool_release(semaphore->event_pool, 1, &event);
+      }
+    }
+  }
+
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return status;
+}
+
+iree_status_t iree_hal_task_semaphore_enqueue_timepoints(
+    const iree_hal_semaphore_list_t* semaphore_list, iree_task_t* issue_task,
+    iree_arena_allocator_t* arena, iree_task_submission_t* submission) {
+  // Events are acquired lazily in one batch when the first unsatisfied
+  // semaphore is found: the common case of chained submissions on the same
+  // queue has all waits satisfied and never touches the event pool. The batch
+  // is sized for all remaining semaphores and any surplus is returned to the
+  // pool in a single release.
+  iree_event_pool_t* event_pool = NULL;
+  iree_event_t* events = NULL;
+  iree_host_size_t event_capacity = 0;
+  iree_host_size_t event_count = 0;
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    iree_hal_task_semaphore_t* semaphore =
+        iree_hal_task_semaphore_cast(semaphore_list->semaphores[i]);
+    uint64_t minimum_value = semaphore_list->payload_values[i];
+    iree_slim_mutex_lock(&semaphore->mutex);
+    if (semaphore->current_value >= minimum_value) {
+      // Fast path: already satisfied.
+      iree_slim_mutex_unlock(&semaphore->mutex);
+      continue;
+    }
+
+    // Slow path: take an event for the timepoint from the batch.
+    if (!events) {
+      event_pool = semaphore->event_pool;
+      event_capacity = semaphore_list->count - i;
+      status = iree_arena_allocate(arena, event_capacity * sizeof(events[0]),
+                                   (void**)&events);
+      if (iree_status_is_ok(status)) {
+        status = iree_event_pool_acquire(event_pool, event_capacity, events);
+      }
+      if (!iree_status_is_ok(status)) {
+        events = NULL;
+        event_capacity = 0;
+      }
     }
     if (iree_status_is_ok(status)) {
-      iree_task_wait_initialize(issue_task->scope,
-                                iree_event_await(&cmd->timepoint.event),
-                                IREE_TIME_INFINITE_FUTURE, &cmd->task);
-      iree_task_set_cleanup_fn(&cmd->task.header,
-                               iree_hal_task_semaphore_wait_cmd_cleanup);
-      iree_task_set_completion_task(&cmd->task.header, issue_task);
-      cmd->semaphore = semaphore;
-      iree_task_submission_enqueue(submission, &cmd->task.header);
+      if (semaphore->event_pool == event_pool) {
+        status = iree_hal_task_semaphore_enqueue_wait_cmd(
+            semaphore, minimum_value, events[event_count], issue_task, arena,
+            submission);
+        if (iree_status_is_ok(status)) ++event_count;
+      } else {
+        // Semaphore from another executor; its events must come from its own
+        // pool.
+        iree_slim_mutex_unlock(&semaphore->mutex);
+        status = iree_hal_task_semaphore_enqueue_timepoint(
+            semaphore_list->semaphores[i], minimum_value, issue_task, arena,
+            submission);
+        if (!iree_status_is_ok(status)) break;
+        continue;
+      }
     }
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  // Return any events we didn't end up needing. Those that were used are owned
+  // by the wait tasks and released when they are cleaned up.
+  if (event_count < event_capacity) {
+    iree_event_pool_release(event_pool, event_capacity - event_count,
+                            &events[event_count]);
   }
 
-  iree_slim_mutex_unlock(&semaphore->mutex);
   return status;
 }
 
@@ -404,10 +512,13 @@ static iree_status_t iree_hal_task_semaphore_wait(
   iree_slim_mutex_unlock(&semaphore->mutex);
   if (IREE_UNLIKELY(!iree_status_is_ok(status))) return status;
 
-  // Wait until the timepoint resolves.
+  // Wait until the timepoint resolves, donating the caller to the executor in
+  // the meantime (as the tasks that will signal us may need the thread).
   // If satisfied the timepoint is automatically cleaned up and we are done. If
   // the deadline is reached before satisfied then we have to clean it up.
-  status = iree_wait_one(&timepoint.event, deadline_ns);
+  status = iree_task_executor_donate_caller(semaphore->executor,
+                                            iree_event_await(&timepoint.event),
+                                            iree_make_deadline(deadline_ns));
   if (!iree_status_is_ok(status)) {
     iree_slim_mutex_lock(&semaphore->mutex);
     iree_hal_task_timepoint_list_erase(&semaphore->timepoint_list, &timepoint);
@@ -417,10 +528,50 @@ static iree_status_t iree_hal_task_semaphore_wait(
   return status;
 }
 
+// Wait source control function for waiting on a wait set.
+// |self| is the iree_wait_set_t and |data| is the iree_hal_wait_mode_t.
+// This allows multi-waits to be performed as a single wait source that can be
+// passed to iree_task_executor_donate_caller.
+static iree_status_t iree_hal_task_semaphore_wait_set_ctl(
+    iree_wait_source_t wait_source, iree_wait_source_command_t command,
+    const void* params, void** inout_ptr) {
+  iree_wait_set_t* wait_set = (iree_wait_set_t*)wait_source.self;
+  iree_hal_wait_mode_t wait_mode = (iree_hal_wait_mode_t)wait_source.data;
+  iree_time_t deadline_ns = IREE_TIME_INFINITE_PAST;
+  switch (command) {
+    case IREE_WAIT_SOURCE_COMMAND_QUERY:
+      // Poll: a deadline exceeded indicates unresolved.
+      deadline_ns = IREE_TIME_INFINITE_PAST;
+      break;
+    case IREE_WAIT_SOURCE_COMMAND_WAIT_ONE:
+      deadline_ns = iree_timeout_as_deadline_ns(
+          ((const iree_wait_source_wait_params_t*)params)->timeout);
+      break;
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "wait set wait sources cannot be exported");
+  }
+
+  iree_status_t status =
+      wait_mode == IREE_HAL_WAIT_MODE_ANY
+          ? iree_wait_any(wait_set, deadline_ns, /*out_wake_handle=*/NULL)
+          : iree_wait_all(wait_set, deadline_ns);
+  if (command == IREE_WAIT_SOURCE_COMMAND_QUERY) {
+    iree_status_code_t* out_wait_status_code = (iree_status_code_t*)inout_ptr;
+    if (iree_status_is_deadline_exceeded(status)) {
+      *out_wait_status_code = IREE_STATUS_DEFERRED;
+      return iree_status_ignore(status);
+    }
+    if (!iree_status_is_ok(status)) return status;
+    *out_wait_status_code = IREE_STATUS_OK;
+  }
+  return status;
+}
+
 iree_status_t iree_hal_task_semaphore_multi_wait(
     iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout,
-    iree_event_pool_t* event_pool, iree_arena_block_pool_t* block_pool) {
+    iree_task_executor_t* executor, iree_arena_block_pool_t* block_pool) {
   IREE_ASSERT_ARGUMENT(semaphore_list);
   if (semaphore_list->count == 0) {
     return iree_ok_status();
@@ -442,15 +593,20 @@ iree_status_t iree_hal_task_semaphore_multi_wait(
       semaphore_list->count, iree_arena_allocator(&arena), &wait_set);
 
   // Acquire a wait handle for each semaphore timepoint we are to wait on.
-  // TODO(benvanik): flip this API around so we can batch request events from
-  // the event pool. We should be acquiring all required time points in one
-  // call.
+  // Events are acquired from the executor pool in one batch upon reaching the
+  // first unsatisfied semaphore, sized for it and all that follow; surplus
+  // events are released along with the used ones below.
+  iree_event_pool_t* event_pool = iree_task_executor_event_pool(executor);
   iree_host_size_t timepoint_count = 0;
   iree_hal_task_timepoint_t* timepoints = NULL;
+  iree_event_t* events = NULL;
+  iree_host_size_t event_capacity = 0;
   iree_host_size_t total_timepoint_size =
       semaphore_list->count * sizeof(timepoints[0]);
-  status =
-      iree_arena_allocate(&arena, total_timepoint_size, (void**)&timepoints);
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_arena_allocate(&arena, total_timepoint_size, (void**)&timepoints);
+  }
   if (iree_status_is_ok(status)) {
     memset(timepoints, 0, total_timepoint_size);
     for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
@@ -461,10 +617,27 @@ iree_status_t iree_hal_task_semaphore_multi_wait(
         // Fast path: already satisfied.
       } else {
         // Slow path: get a native wait handle for the timepoint.
-        iree_hal_task_timepoint_t* timepoint = &timepoints[timepoint_count++];
-        status = iree_hal_task_semaphore_acquire_timepoint(
-            semaphore, semaphore_list->payload_values[i], timepoint);
+        if (!events) {
+          iree_host_size_t remaining_count = semaphore_list->count - i;
+          status = iree_arena_allocate(&arena,
+                                       remaining_count * sizeof(events[0]),
+                                       (void**)&events);
+          if (iree_status_is_ok(status)) {
+            status =
+                iree_event_pool_acquire(event_pool, remaining_count, events);
+          }
+          if (iree_status_is_ok(status)) {
+            event_capacity = remaining_count;
+          } else {
+            events = NULL;
+          }
+        }
         if (iree_status_is_ok(status)) {
+          iree_hal_task_timepoint_t* timepoint = &timepoints[timepoint_count];
+          iree_hal_task_semaphore_insert_timepoint(
+              semaphore, semaphore_list->payload_values[i],
+              events[timepoint_count], timepoint);
+          ++timepoint_count;
           status = iree_wait_set_insert(wait_set, timepoint->event);
         }
       }
@@ -473,21 +646,19 @@ iree_status_t iree_hal_task_semaphore_multi_wait(
     }
   }
 
-  // Perform the wait.
+  // Perform the wait, donating the caller to the executor in the meantime.
   if (iree_status_is_ok(status)) {
-    if (wait_mode == IREE_HAL_WAIT_MODE_ANY) {
-      status = iree_wait_any(wait_set, deadline_ns, /*out_wake_handle=*/NULL);
-    } else {
-      status = iree_wait_all(wait_set, deadline_ns);
-    }
+    iree_wait_source_t wait_source = {
+        {{wait_set, (uint64_t)wait_mode}},
+        iree_hal_task_semaphore_wait_set_ctl,
+    };
+    status = iree_task_executor_donate_caller(executor, wait_source,
+                                              iree_make_deadline(deadline_ns));
   }
 
-  if (timepoints != NULL) {
-    // TODO(benvanik): if we flip the API to multi-acquire events from the pool
-    // above then we can multi-release here too.
-    for (iree_host_size_t i = 0; i < timepoint_count; ++i) {
-      iree_event_pool_release(event_pool, 1, &timepoints[i].event);
-    }
+  // Release all events (used or not) back to the pool in one batch.
+  if (events != NULL) {
+    iree_event_pool_release(event_pool, event_capacity, events);
   }
   iree_wait_set_free(wait_set);
   iree_arena_deinitialize(&arena);
@@ -0,0 +1,146 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/transfer_kernels.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/target_platform.h"
+
+#if defined(IREE_ARCH_X86_64)
+#include <emmintrin.h>
+#define IREE_HAL_LOCAL_TRANSFER_NONTEMPORAL 1
+#else
+#define IREE_HAL_LOCAL_TRANSFER_NONTEMPORAL 0
+#endif  // IREE_ARCH_X86_64
+
+// Replicates the 1, 2, or 4 byte |pattern| to 32 bits.
+static uint32_t iree_hal_local_splat_pattern(const void* pattern,
+                                             iree_host_size_t pattern_length) {
+  switch (pattern_length) {
+    case 1:
+      return *(const uint8_t*)pattern * 0x01010101u;
+    case 2:
+      return *(const uint16_t*)pattern * 0x00010001u;
+    default:
+      return *(const uint32_t*)pattern;
+  }
+}
+
+// Fills with regular stores. |target| and |length| are pattern aligned so the
+// pattern phase is the same at every 4-byte aligned address.
+static void iree_hal_local_fill_memory_cached(uint8_t* target,
+                                              iree_host_size_t length,
+                                              uint32_t value,
+                                              iree_host_size_t pattern_length) {
+  if (pattern_length == 1) {
+    memset(target, (int)(value & 0xFF), length);
+    return;
+  }
+  // Peel off the head until 4-byte aligned.
+  while (length > 0 && ((uintptr_t)target & 3) != 0) {
+    memcpy(target, &value, pattern_length);
+    target += pattern_length;
+    length -= pattern_length;
+  }
+  for (; length >= 4; target += 4, length -= 4) {
+    memcpy(target, &value, 4);
+  }
+  if (length > 0) memcpy(target, &value, length);
+}
+
+#if IREE_HAL_LOCAL_TRANSFER_NONTEMPORAL
+
+// Fills 16-byte aligned |target| with non-temporal stores. |length| must be a
+// multiple of 16.
+static void iree_hal_local_fill_memory_nontemporal(uint8_t* target,
+                                                   iree_host_size_t length,
+                                                   uint32_t value) {
+  const __m128i splat = _mm_set1_epi32((int)value);
+  for (; length >= 64; target += 64, length -= 64) {
+    _mm_stream_si128((__m128i*)(target + 0), splat);
+    _mm_stream_si128((__m128i*)(target + 16), splat);
+    _mm_stream_si128((__m128i*)(target + 32), splat);
+    _mm_stream_si128((__m128i*)(target + 48), splat);
+  }
+  for (; length >= 16; target += 16, length -= 16) {
+    _mm_stream_si128((__m128i*)target, splat);
+  }
+}
+
+// Copies to 16-byte aligned |target| with non-temporal stores. |length| must
+// be a multiple of 16. |source| may be unaligned.
+static void iree_hal_local_copy_memory_nontemporal(uint8_t* target,
+                                                   const uint8_t* source,
+                                                   iree_host_size_t length) {
+  for (; length >= 64; target += 64, source += 64, length -= 64) {
+    __m128i v0 = _mm_loadu_si128((const __m128i*)(source + 0));
+    __m128i v1 = _mm_loadu_si128((const __m128i*)(source + 16));
+    __m128i v2 = _mm_loadu_si128((const __m128i*)(source + 32));
+    __m128i v3 = _mm_loadu_si128((const __m128i*)(source + 48));
+    _mm_stream_si128((__m128i*)(target + 0), v0);
+    _mm_stream_si128((__m128i*)(target + 16), v1);
+    _mm_stream_si128((__m128i*)(target + 32), v2);
+    _mm_stream_si128((__m128i*)(target + 48), v3);
+  }
+  for (; length >= 16; target += 16, source += 16, length -= 16) {
+    _mm_stream_si128((__m128i*)target,
+                     _mm_loadu_si128((const __m128i*)source));
+  }
+}
+
+#endif  // IREE_HAL_LOCAL_TRANSFER_NONTEMPORAL
+
+void iree_hal_local_fill_memory(void* target, iree_host_size_t length,
+                                const void* pattern,
+                                iree_host_size_t pattern_length,
+                                bool nontemporal) {
+  uint8_t* target_ptr = (uint8_t*)target;
+  uint32_t value = iree_hal_local_splat_pattern(pattern, pattern_length);
+#if IREE_HAL_LOCAL_TRANSFER_NONTEMPORAL
+  if (nontemporal && length >= 64) {
+    // The head is a multiple of the pattern length as |target| is pattern
+    // aligned and so the pattern phase is unchanged for the streamed body.
+    iree_host_size_t head_length = (16 - ((uintptr_t)target_ptr & 15)) & 15;
+    iree_hal_local_fill_memory_cached(target_ptr, head_length, value,
+                                      pattern_length);
+    target_ptr += head_length;
+    length -= head_length;
+    iree_host_size_t body_length = length & ~(iree_host_size_t)15;
+    iree_hal_local_fill_memory_nontemporal(target_ptr, body_length, value);
+    target_ptr += body_length;
+    length -= body_length;
+    // Non-temporal stores are weakly ordered; fence so that they are visible
+    // before any subsequent signal of completion.
+    _mm_sfence();
+  }
+#endif  // IREE_HAL_LOCAL_TRANSFER_NONTEMPORAL
+  iree_hal_local_fill_memory_cached(target_ptr, length, value, pattern_length);
+}
+
+void iree_hal_local_copy_memory(void* target, const void* source,
+                                iree_host_size_t length, bool nontemporal) {
+  uint8_t* target_ptr = (uint8_t*)target;
+  const uint8_t* source_ptr = (const uint8_t*)source;
+#if IREE_HAL_LOCAL_TRANSFER_NONTEMPORAL
+  if (nontemporal && length >= 64) {
+    iree_host_size_t head_length = (16 - ((uintptr_t)target_ptr & 15)) & 15;
+    memcpy(target_ptr, source_ptr, head_length);
+    target_ptr += head_length;
+    source_ptr += head_length;
+    length -= head_length;
+    iree_host_size_t body_length = length & ~(iree_host_size_t)15;
+    iree_hal_local_copy_memory_nontemporal(target_ptr, source_ptr,
+                                           body_length);
+    target_ptr += body_length;
+    source_ptr += body_length;
+    length -= body_length;
+    _mm_sfence();
+  }
+#endif  // IREE_HAL_LOCAL_TRANSFER_NONTEMPORAL
+  memcpy(target_ptr, source_ptr, length);
+}
@@ -0,0 +1,43 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_TRANSFER_KERNELS_H_
+#define IREE_HAL_LOCAL_TRANSFER_KERNELS_H_
+
+#include <stdbool.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Host memory fill and copy routines used to execute transfer commands.
+//
+// When |nontemporal| is set stores bypass the cache where the architecture
+// supports it (currently x86-64 with SSE2). This avoids evicting the working
+// set of other dispatches when transferring ranges far larger than the cache
+// that would not be resident by the time they were next read anyway. Callers
+// should only use it for such ranges as it is significantly slower when the
+// data is read back soon after. Other architectures use regular stores.
+
+// Fills |length| bytes at |target| with the |pattern_length| byte |pattern|.
+// |pattern_length| must be 1, 2, or 4 and |target| and |length| must be
+// aligned to it.
+void iree_hal_local_fill_memory(void* target, iree_host_size_t length,
+                                const void* pattern,
+                                iree_host_size_t pattern_length,
+                                bool nontemporal);
+
+// Copies |length| bytes from |source| to |target|. The ranges must not overlap.
+void iree_hal_local_copy_memory(void* target, const void* source,
+                                iree_host_size_t length, bool nontemporal);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_TRANSFER_KERNELS_H_
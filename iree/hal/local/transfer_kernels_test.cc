@@ -0,0 +1,77 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/transfer_kernels.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+
+namespace {
+
+// Sizes and offsets chosen to cover unaligned heads, the 64-byte unrolled
+// body, the 16-byte remainder loop, and unaligned tails.
+static const iree_host_size_t kLengths[] = {0, 4, 60, 64, 100, 1028, 4096 + 12};
+static const iree_host_size_t kOffsets[] = {0, 4, 8, 12};
+static const iree_host_size_t kGuardLength = 32;
+static const uint8_t kGuardValue = 0xCD;
+
+class TransferKernelsTest : public ::testing::TestWithParam<bool> {};
+
+TEST_P(TransferKernelsTest, Fill) {
+  const bool nontemporal = GetParam();
+  const uint32_t pattern = 0x11223344u;
+  for (iree_host_size_t pattern_length : {1, 2, 4}) {
+    for (iree_host_size_t length : kLengths) {
+      for (iree_host_size_t offset : kOffsets) {
+        std::vector<uint8_t> storage(offset + length + kGuardLength * 2 + 16,
+                                     kGuardValue);
+        // Align the base to 16 so that |offset| controls the alignment.
+        uint8_t* base = storage.data() +
+                        ((16 - ((uintptr_t)storage.data() & 15)) & 15);
+        uint8_t* target = base + kGuardLength + offset;
+        iree_hal_local_fill_memory(target, length, &pattern, pattern_length,
+                                   nontemporal);
+        for (iree_host_size_t i = 0; i < length; ++i) {
+          ASSERT_EQ(target[i], ((const uint8_t*)&pattern)[i % pattern_length])
+              << "pattern_length=" << pattern_length << " length=" << length
+              << " offset=" << offset << " i=" << i;
+        }
+        EXPECT_EQ(target[-1], kGuardValue);
+        EXPECT_EQ(target[length], kGuardValue);
+      }
+    }
+  }
+}
+
+TEST_P(TransferKernelsTest, Copy) {
+  const bool nontemporal = GetParam();
+  for (iree_host_size_t length : kLengths) {
+    for (iree_host_size_t offset : kOffsets) {
+      std::vector<uint8_t> source(length + 3);
+      for (iree_host_size_t i = 0; i < source.size(); ++i) {
+        source[i] = (uint8_t)(i * 7 + 1);
+      }
+      std::vector<uint8_t> storage(offset + length + kGuardLength * 2,
+                                   kGuardValue);
+      uint8_t* target = storage.data() + kGuardLength + offset;
+      // Offset the source so that it is misaligned relative to the target.
+      const uint8_t* source_ptr = source.data() + 3;
+      iree_hal_local_copy_memory(target, source_ptr, length, nontemporal);
+      ASSERT_EQ(0, std::memcmp(target, source_ptr, length))
+          << "length=" << length << " offset=" << offset;
+      EXPECT_EQ(target[-1], kGuardValue);
+      EXPECT_EQ(target[length], kGuardValue);
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(CachedAndNontemporal, TransferKernelsTest,
+                         ::testing::Bool());
+
+}  // namespace
@@ -8,6 +8,7 @@
 
 #include <stddef.h>
 
+#include "iree/base/profiler.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/detail.h"
 #include "iree/hal/device.h"
@@ -66,8 +67,14 @@ IREE_API_EXPORT iree_status_t iree_hal_semaphore_wait(
     iree_hal_semaphore_t* semaphore, uint64_t value, iree_timeout_t timeout) {
   IREE_ASSERT_ARGUMENT(semaphore);
   IREE_TRACE_ZONE_BEGIN(z0);
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_WAIT_BEGIN,
+                       (uint64_t)(uintptr_t)semaphore, iree_string_view_empty(),
+                       value);
   iree_status_t status =
       _VTABLE_DISPATCH(semaphore, wait)(semaphore, value, timeout);
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_WAIT_END,
+                       (uint64_t)(uintptr_t)semaphore, iree_string_view_empty(),
+                       value);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
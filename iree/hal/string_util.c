@@ -6,12 +6,14 @@
 
 #include "iree/hal/string_util.h"
 
-#include <ctype.h>
+#include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "iree/base/api.h"
@@ -306,6 +308,114 @@ IREE_API_EXPORT iree_status_t iree_hal_parse_element(
   return iree_hal_parse_element_unsafe(data_str, element_type, data_ptr.data);
 }
 
+// Parses a single element directly out of the source string without first
+// copying it into NUL-terminated scratch memory as iree_string_view_atoi_* do.
+// The caller must ensure that |token| is followed by a separator character
+// within the same string such that the C library routines stop prior to
+// reading past the token. Parsing semantics match iree_hal_parse_element.
+static iree_status_t iree_hal_parse_element_in_place(
+    const char* token, iree_host_size_t token_length,
+    iree_hal_element_type_t element_type, uint8_t* out_data) {
+  char* end = NULL;
+  errno = 0;
+  switch (element_type) {
+    case IREE_HAL_ELEMENT_TYPE_INT_8:
+    case IREE_HAL_ELEMENT_TYPE_SINT_8:
+    case IREE_HAL_ELEMENT_TYPE_INT_16:
+    case IREE_HAL_ELEMENT_TYPE_SINT_16:
+    case IREE_HAL_ELEMENT_TYPE_INT_32:
+    case IREE_HAL_ELEMENT_TYPE_SINT_32: {
+      long parsed_value = strtol(token, &end, 0);
+      if (end == token || (parsed_value == 0 && errno != 0) ||
+          ((parsed_value == LONG_MIN || parsed_value == LONG_MAX) &&
+           errno == ERANGE)) {
+        break;
+      }
+      int32_t value = (int32_t)parsed_value;
+      switch (iree_hal_element_bit_count(element_type)) {
+        case 8:
+          if (value > INT8_MAX) break;
+          *(int8_t*)out_data = (int8_t)value;
+          return iree_ok_status();
+        case 16:
+          if (value > INT16_MAX) break;
+          *(int16_t*)out_data = (int16_t)value;
+          return iree_ok_status();
+        default:
+          *(int32_t*)out_data = value;
+          return iree_ok_status();
+      }
+      break;
+    }
+    case IREE_HAL_ELEMENT_TYPE_UINT_8:
+    case IREE_HAL_ELEMENT_TYPE_UINT_16:
+    case IREE_HAL_ELEMENT_TYPE_UINT_32: {
+      unsigned long parsed_value = strtoul(token, &end, 0);
+      if (end == token || (parsed_value == 0 && errno != 0) ||
+          (parsed_value == ULONG_MAX && errno == ERANGE)) {
+        break;
+      }
+      uint32_t value = (uint32_t)parsed_value;
+      switch (iree_hal_element_bit_count(element_type)) {
+        case 8:
+          if (value > UINT8_MAX) break;
+          *(uint8_t*)out_data = (uint8_t)value;
+          return iree_ok_status();
+        case 16:
+          if (value > UINT16_MAX) break;
+          *(uint16_t*)out_data = (uint16_t)value;
+          return iree_ok_status();
+        default:
+          *(uint32_t*)out_data = value;
+          return iree_ok_status();
+      }
+      break;
+    }
+    case IREE_HAL_ELEMENT_TYPE_INT_64:
+    case IREE_HAL_ELEMENT_TYPE_SINT_64: {
+      long long parsed_value = strtoll(token, &end, 0);
+      if (end == token || (parsed_value == 0 && errno != 0) ||
+          ((parsed_value == LLONG_MIN || parsed_value == LLONG_MAX) &&
+           errno == ERANGE)) {
+        break;
+      }
+      *(int64_t*)out_data = (int64_t)parsed_value;
+      return iree_ok_status();
+    }
+    case IREE_HAL_ELEMENT_TYPE_UINT_64: {
+      unsigned long long parsed_value = strtoull(token, &end, 0);
+      if (end == token || (parsed_value == 0 && errno != 0) ||
+          (parsed_value == ULLONG_MAX && errno == ERANGE)) {
+        break;
+      }
+      *(uint64_t*)out_data = (uint64_t)parsed_value;
+      return iree_ok_status();
+    }
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_16:
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_32: {
+      float value = strtof(token, &end);
+      if (end == token || (value == 0 && errno != 0)) break;
+      if (element_type == IREE_HAL_ELEMENT_TYPE_FLOAT_16) {
+        *(uint16_t*)out_data = iree_math_f32_to_f16(value);
+      } else {
+        *(float*)out_data = value;
+      }
+      return iree_ok_status();
+    }
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_64: {
+      double value = strtod(token, &end);
+      if (end == token || (value == 0 && errno != 0)) break;
+      *(double*)out_data = value;
+      return iree_ok_status();
+    }
+    default:
+      // Opaque hex elements never needed the scratch copy.
+      return iree_hal_parse_element_unsafe(
+          iree_make_string_view(token, token_length), element_type, out_data);
+  }
+  return iree_status_from_code(IREE_STATUS_INVALID_ARGUMENT);
+}
+
 // Converts a sequence of bytes into hex number strings.
 static void iree_hal_bytes_to_hex_string(const uint8_t* src, char* dest,
                                          ptrdiff_t num) {
@@ -333,6 +443,36 @@ static void iree_hal_bytes_to_hex_string(const uint8_t* src, char* dest,
   }
 }
 
+// Formats |magnitude| as a decimal integer with an optional leading '-'.
+// Matches snprintf in returning the full formatted length even if it would
+// not fit in |buffer_capacity| but only writes to |buffer| when it fits.
+// Integer elements are common enough in large tensors that the format string
+// handling in snprintf dominates the cost of formatting them.
+static int iree_hal_format_integer(uint64_t magnitude, bool negative,
+                                   iree_host_size_t buffer_capacity,
+                                   char* buffer) {
+  char digits[20];
+  int digit_count = 0;
+  do {
+    digits[digit_count++] = (char)('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude);
+  int n = digit_count + (negative ? 1 : 0);
+  if (buffer && buffer_capacity > (iree_host_size_t)n) {
+    if (negative) *buffer++ = '-';
+    while (digit_count) *buffer++ = digits[--digit_count];
+    *buffer = 0;
+  }
+  return n;
+}
+
+static int iree_hal_format_signed_integer(int64_t value,
+                                          iree_host_size_t buffer_capacity,
+                                          char* buffer) {
+  uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+  return iree_hal_format_integer(magnitude, value < 0, buffer_capacity, buffer);
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_format_element(
     iree_const_byte_span_t data, iree_hal_element_type_t element_type,
     iree_host_size_t buffer_capacity, char* buffer,
@@ -349,39 +489,39 @@ IREE_API_EXPORT iree_status_t iree_hal_format_element(
   switch (element_type) {
     case IREE_HAL_ELEMENT_TYPE_INT_8:
     case IREE_HAL_ELEMENT_TYPE_SINT_8:
-      n = snprintf(buffer, buffer ? buffer_capacity : 0, "%" PRIi8,
-                   *(const int8_t*)data.data);
+      n = iree_hal_format_signed_integer(*(const int8_t*)data.data,
+                                         buffer_capacity, buffer);
       break;
     case IREE_HAL_ELEMENT_TYPE_UINT_8:
-      n = snprintf(buffer, buffer ? buffer_capacity : 0, "%" PRIu8,
-                   *(const uint8_t*)data.data);
+      n = iree_hal_format_integer(*(const uint8_t*)data.data, false,
+                                  buffer_capacity, buffer);
       break;
     case IREE_HAL_ELEMENT_TYPE_INT_16:
     case IREE_HAL_ELEMENT_TYPE_SINT_16:
-      n = snprintf(buffer, buffer ? buffer_capacity : 0, "%" PRIi16,
-                   *(const int16_t*)data.data);
+      n = iree_hal_format_signed_integer(*(const int16_t*)data.data,
+                                         buffer_capacity, buffer);
       break;
     case IREE_HAL_ELEMENT_TYPE_UINT_16:
-      n = snprintf(buffer, buffer ? buffer_capacity : 0, "%" PRIu16,
-                   *(const uint16_t*)data.data);
+      n = iree_hal_format_integer(*(const uint16_t*)data.data, false,
+                                  buffer_capacity, buffer);
       break;
     case IREE_HAL_ELEMENT_TYPE_INT_32:
     case IREE_HAL_ELEMENT_TYPE_SINT_32:
-      n = snprintf(buffer, buffer ? buffer_capacity : 0, "%" PRIi32,
-                   *(const int32_t*)data.data);
+      n = iree_hal_format_signed_integer(*(const int32_t*)data.data,
+                                         buffer_capacity, buffer);
       break;
     case IREE_HAL_ELEMENT_TYPE_UINT_32:
-      n = snprintf(buffer, buffer ? buffer_capacity : 0, "%" PRIu32,
-                   *(const uint32_t*)data.data);
+      n = iree_hal_format_integer(*(const uint32_t*)data.data, false,
+                                  buffer_capacity, buffer);
       break;
     case IREE_HAL_ELEMENT_TYPE_INT_64:
     case IREE_HAL_ELEMENT_TYPE_SINT_64:
-      n = snprintf(buffer, buffer ? buffer_capacity : 0, "%" PRIi64,
-                   *(const int64_t*)data.data);
+      n = iree_hal_format_signed_integer(*(const int64_t*)data.data,
+                                         buffer_capacity, buffer);
       break;
     case IREE_HAL_ELEMENT_TYPE_UINT_64:
-      n = snprintf(buffer, buffer ? buffer_capacity : 0, "%" PRIu64,
-                   *(const uint64_t*)data.data);
+      n = iree_hal_format_integer(*(const uint64_t*)data.data, false,
+                                  buffer_capacity, buffer);
       break;
     case IREE_HAL_ELEMENT_TYPE_FLOAT_16:
       n = snprintf(buffer, buffer ? buffer_capacity : 0, "%G",
@@ -416,6 +556,18 @@ IREE_API_EXPORT iree_status_t iree_hal_format_element(
                 : iree_status_from_code(IREE_STATUS_OUT_OF_RANGE);
 }
 
+// Lookup table of characters separating elements: whitespace, ',', '[', ']'.
+// Unlike isspace this is not locale-dependent and avoids a call per character.
+static const bool iree_hal_element_separator_table[256] = {
+    ['\t'] = true, ['\n'] = true, ['\v'] = true, ['\f'] = true,
+    ['\r'] = true, [' '] = true,  [','] = true,  ['['] = true,
+    [']'] = true,
+};
+
+static inline bool iree_hal_is_element_separator(char c) {
+  return iree_hal_element_separator_table[(uint8_t)c];
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_parse_buffer_elements(
     iree_string_view_t data_str, iree_hal_element_type_t element_type,
     iree_byte_span_t data_ptr) {
@@ -426,45 +578,40 @@ IREE_API_EXPORT iree_status_t iree_hal_parse_buffer_elements(
     memset(data_ptr.data, 0, data_ptr.data_length);
     return iree_ok_status();
   }
-  size_t src_i = 0;
-  size_t dst_i = 0;
-  size_t token_start = IREE_STRING_VIEW_NPOS;
-  while (src_i < data_str.size) {
-    char c = data_str.data[src_i++];
-    bool is_separator = isspace(c) || c == ',' || c == '[' || c == ']';
-    if (token_start == IREE_STRING_VIEW_NPOS) {
-      if (!is_separator) {
-        token_start = src_i - 1;
-      }
-      continue;
-    } else if (token_start != IREE_STRING_VIEW_NPOS && !is_separator) {
+  const char* data = data_str.data;
+  const iree_host_size_t data_size = data_str.size;
+  iree_host_size_t src_i = 0;
+  iree_host_size_t dst_i = 0;
+  uint8_t* dst_ptr = data_ptr.data;
+  while (src_i < data_size) {
+    // Skip the run of separators preceding the next token.
+    if (iree_hal_is_element_separator(data[src_i])) {
+      ++src_i;
       continue;
     }
+    iree_host_size_t token_start = src_i;
+    while (src_i < data_size && !iree_hal_is_element_separator(data[src_i])) {
+      ++src_i;
+    }
     if (dst_i >= element_capacity) {
       return iree_make_status(
           IREE_STATUS_OUT_OF_RANGE,
           "output data buffer overflow: element_capacity=%zu < dst_i=%zu+",
           element_capacity, dst_i);
     }
-    IREE_RETURN_IF_ERROR(iree_hal_parse_element_unsafe(
-        iree_make_string_view(data_str.data + token_start,
-                              src_i - 2 - token_start + 1),
-        element_type, data_ptr.data + dst_i * element_size));
-    ++dst_i;
-    token_start = IREE_STRING_VIEW_NPOS;
-  }
-  if (token_start != IREE_STRING_VIEW_NPOS) {
-    if (dst_i >= element_capacity) {
-      return iree_make_status(
-          IREE_STATUS_OUT_OF_RANGE,
-          "output data overflow: element_capacity=%zu < dst_i=%zu",
-          element_capacity, dst_i);
+    if (src_i < data_size) {
+      // A separator follows the token so it can be parsed in-place.
+      IREE_RETURN_IF_ERROR(iree_hal_parse_element_in_place(
+          data + token_start, src_i - token_start, element_type, dst_ptr));
+    } else {
+      // The final token may run up to the end of the (likely not
+      // NUL-terminated) string and must be copied before parsing.
+      IREE_RETURN_IF_ERROR(iree_hal_parse_element_unsafe(
+          iree_make_string_view(data + token_start, src_i - token_start),
+          element_type, dst_ptr));
     }
-    IREE_RETURN_IF_ERROR(iree_hal_parse_element_unsafe(
-        iree_make_string_view(data_str.data + token_start,
-                              data_str.size - token_start),
-        element_type, data_ptr.data + dst_i * element_size));
     ++dst_i;
+    dst_ptr += element_size;
   }
   if (dst_i == 1 && element_capacity > 1) {
     // Splat the single value we got to the entire buffer.
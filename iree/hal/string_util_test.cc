@@ -817,6 +817,34 @@ TEST(BufferElementsStringUtilTest, ParseBufferElementsInvalid) {
               StatusIs(StatusCode::kOutOfRange));
 }
 
+TEST(BufferElementsStringUtilTest, ParseBufferElementsSeparators) {
+  // Elements followed by separators are parsed in-place while the final
+  // element is not; both must produce the same results.
+  std::vector<int32_t> buffer4i32(4);
+  IREE_EXPECT_OK(ParseBufferElements<int32_t>(
+      "[[1,\t-2]\n[0x10  , 4]]", iree::span<int32_t>(buffer4i32)));
+  EXPECT_THAT(buffer4i32, Eq(std::vector<int32_t>{1, -2, 16, 4}));
+  IREE_EXPECT_OK(ParseBufferElements<int32_t>("5 6 7 8",
+                                              iree::span<int32_t>(buffer4i32)));
+  EXPECT_THAT(buffer4i32, Eq(std::vector<int32_t>{5, 6, 7, 8}));
+  std::vector<float> buffer3f32(3);
+  IREE_EXPECT_OK(ParseBufferElements<float>("1.5,-2e3,0.25",
+                                            iree::span<float>(buffer3f32)));
+  EXPECT_THAT(buffer3f32, Eq(std::vector<float>{1.5f, -2e3f, 0.25f}));
+  std::vector<uint64_t> buffer2u64(2);
+  IREE_EXPECT_OK(ParseBufferElements<uint64_t>(
+      "18446744073709551615 1", iree::span<uint64_t>(buffer2u64)));
+  EXPECT_THAT(buffer2u64, Eq(std::vector<uint64_t>{UINT64_MAX, 1}));
+  // Out of range values are rejected regardless of position.
+  std::vector<int8_t> buffer2(2);
+  EXPECT_THAT(ParseBufferElements("128 1", iree::span<int8_t>(buffer2)),
+              StatusIs(StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParseBufferElements("1 128", iree::span<int8_t>(buffer2)),
+              StatusIs(StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParseBufferElements("abc 1", iree::span<int8_t>(buffer2)),
+              StatusIs(StatusCode::kInvalidArgument));
+}
+
 TEST(BufferElementsStringUtilTest, ParseBufferElementsShaped) {
   // Empty:
   EXPECT_THAT(ParseBufferElements<int8_t>("", Shape{2, 4}),
@@ -883,6 +911,18 @@ TEST(BufferElementsStringUtilTest, FormatBufferElements) {
           "-99]"));
 }
 
+TEST(BufferElementsStringUtilTest, FormatBufferElementsIntegerLimits) {
+  EXPECT_THAT(FormatBufferElements<int8_t>({INT8_MIN, 0, INT8_MAX}, Shape{3}),
+              IsOkAndHolds("-128 0 127"));
+  EXPECT_THAT(FormatBufferElements<uint16_t>({0, UINT16_MAX}, Shape{2}),
+              IsOkAndHolds("0 65535"));
+  EXPECT_THAT(
+      FormatBufferElements<int64_t>({INT64_MIN, -1, INT64_MAX}, Shape{3}),
+      IsOkAndHolds("-9223372036854775808 -1 9223372036854775807"));
+  EXPECT_THAT(FormatBufferElements<uint64_t>({UINT64_MAX}, Shape{1}),
+              IsOkAndHolds("18446744073709551615"));
+}
+
 TEST(BufferElementsStringUtilTest, FormatBufferElementsElided) {
   EXPECT_THAT(FormatBufferElements<int8_t>({1}, Shape{}, 0),
               IsOkAndHolds("..."));
@@ -0,0 +1,238 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/allocation_cache.h"
+
+#include <string.h>
+
+#include "iree/base/internal/math.h"
+#include "iree/base/tracing.h"
+
+// A freed allocation retained for reuse.
+struct iree_hal_allocation_cache_block_t {
+  struct iree_hal_allocation_cache_block_t* next;
+  iree_hal_cached_allocation_t allocation;
+};
+
+void iree_hal_allocation_cache_initialize(
+    iree_device_size_t limit, iree_host_size_t heap_count,
+    iree_hal_allocation_cache_free_callback_t free_callback,
+    iree_allocator_t host_allocator, iree_hal_allocation_cache_t* out_cache) {
+  IREE_ASSERT_ARGUMENT(out_cache);
+  IREE_ASSERT_LE(heap_count, IREE_HAL_ALLOCATION_CACHE_MAX_HEAP_COUNT);
+  memset(out_cache, 0, sizeof(*out_cache));
+  out_cache->host_allocator = host_allocator;
+  out_cache->limit = limit;
+  out_cache->heap_count = heap_count;
+  out_cache->free_callback = free_callback;
+  iree_slim_mutex_initialize(&out_cache->mutex);
+}
+
+void iree_hal_allocation_cache_deinitialize(
+    iree_hal_allocation_cache_t* cache) {
+  iree_hal_allocation_cache_trim(cache);
+  iree_slim_mutex_deinitialize(&cache->mutex);
+}
+
+bool iree_hal_allocation_cache_lookup_class(
+    const iree_hal_allocation_cache_t* cache, iree_device_size_t size,
+    iree_hal_allocation_cache_class_t* out_class) {
+  if (cache->limit == 0) return false;
+  const iree_device_size_t min_size =
+      1ull << IREE_HAL_ALLOCATION_CACHE_MIN_SIZE_LOG2;
+  if (size <= min_size) {
+    out_class->index = 0;
+    out_class->size = min_size;
+    return true;
+  }
+  // |size| is in (2^size_log2, 2^(size_log2+1)].
+  const int size_log2 = 63 - iree_math_count_leading_zeros_u64(size - 1);
+  if (size_log2 >= IREE_HAL_ALLOCATION_CACHE_MAX_SIZE_LOG2) return false;
+  const iree_device_size_t base_size = 1ull << size_log2;
+  const iree_device_size_t step =
+      base_size >> IREE_HAL_ALLOCATION_CACHE_CLASSES_PER_POW2_LOG2;
+  const iree_host_size_t step_count = (size - base_size + step - 1) / step;
+  out_class->index = ((size_log2 - IREE_HAL_ALLOCATION_CACHE_MIN_SIZE_LOG2)
+                      << IREE_HAL_ALLOCATION_CACHE_CLASSES_PER_POW2_LOG2) +
+                     step_count;
+  out_class->size = base_size + step_count * step;
+  return true;
+}
+
+// Returns the size of every block in the size class with the given |index|.
+// This is the inverse of iree_hal_allocation_cache_lookup_class.
+static iree_device_size_t iree_hal_allocation_cache_class_size(
+    iree_host_size_t index) {
+  const iree_host_size_t classes_per_pow2 =
+      1 << IREE_HAL_ALLOCATION_CACHE_CLASSES_PER_POW2_LOG2;
+  if (index == 0) return 1ull << IREE_HAL_ALLOCATION_CACHE_MIN_SIZE_LOG2;
+  const iree_host_size_t size_log2 =
+      IREE_HAL_ALLOCATION_CACHE_MIN_SIZE_LOG2 + (index - 1) / classes_per_pow2;
+  const iree_host_size_t step_count = (index - 1) % classes_per_pow2 + 1;
+  const iree_device_size_t base_size = 1ull << size_log2;
+  return base_size +
+         step_count *
+             (base_size >> IREE_HAL_ALLOCATION_CACHE_CLASSES_PER_POW2_LOG2);
+}
+
+bool iree_hal_allocation_cache_acquire(
+    iree_hal_allocation_cache_t* cache, iree_host_size_t heap,
+    const iree_hal_allocation_cache_class_t* size_class,
+    iree_hal_cached_allocation_t* out_allocation) {
+  IREE_ASSERT_LT(heap, cache->heap_count);
+  iree_slim_mutex_lock(&cache->mutex);
+  iree_hal_allocation_cache_block_t* block =
+      cache->blocks[heap][size_class->index];
+  if (block) {
+    cache->blocks[heap][size_class->index] = block->next;
+    cache->size -= size_class->size;
+    cache->low_watermark = iree_min(cache->low_watermark, cache->size);
+    *out_allocation = block->allocation;
+    block->next = cache->unused_nodes;
+    cache->unused_nodes = block;
+    ++cache->statistics.hit_count;
+    IREE_TRACE_PLOT_VALUE_I64("iree_hal_allocation_cache::hits",
+                              cache->statistics.hit_count);
+  } else {
+    ++cache->statistics.miss_count;
+    IREE_TRACE_PLOT_VALUE_I64("iree_hal_allocation_cache::misses",
+                              cache->statistics.miss_count);
+  }
+  IREE_TRACE_PLOT_VALUE_I64("iree_hal_allocation_cache::size", cache->size);
+  iree_slim_mutex_unlock(&cache->mutex);
+  return block != NULL;
+}
+
+bool iree_hal_allocation_cache_release(
+    iree_hal_allocation_cache_t* cache, iree_host_size_t heap,
+    const iree_hal_allocation_cache_class_t* size_class,
+    iree_hal_cached_allocation_t allocation) {
+  IREE_ASSERT_LT(heap, cache->heap_count);
+  bool cached = false;
+  iree_slim_mutex_lock(&cache->mutex);
+  if (cache->size + size_class->size <= cache->limit) {
+    iree_hal_allocation_cache_block_t* block = cache->unused_nodes;
+    if (block) {
+      cache->unused_nodes = block->next;
+    } else {
+      iree_status_ignore(iree_allocator_malloc(
+          cache->host_allocator, sizeof(*block), (void**)&block));
+    }
+    if (block) {
+      block->allocation = allocation;
+      block->next = cache->blocks[heap][size_class->index];
+      cache->blocks[heap][size_class->index] = block;
+      cache->size += size_class->size;
+      cached = true;
+    }
+  }
+  IREE_TRACE_PLOT_VALUE_I64("iree_hal_allocation_cache::size", cache->size);
+  iree_slim_mutex_unlock(&cache->mutex);
+  return cached;
+}
+
+// Frees the blocks in each of the |heap_blocks| lists and their allocations.
+// Must be called without the cache lock held.
+static void iree_hal_allocation_cache_free_blocks(
+    iree_hal_allocation_cache_t* cache,
+    iree_hal_allocation_cache_block_t**
+        heap_blocks /*[IREE_HAL_ALLOCATION_CACHE_MAX_HEAP_COUNT]*/) {
+  for (iree_host_size_t heap = 0; heap < cache->heap_count; ++heap) {
+    iree_hal_allocation_cache_block_t* block = heap_blocks[heap];
+    while (block) {
+      iree_hal_allocation_cache_block_t* next = block->next;
+      cache->free_callback.fn(cache->free_callback.user_data, heap,
+                              block->allocation);
+      iree_allocator_free(cache->host_allocator, block);
+      block = next;
+    }
+  }
+}
+
+void iree_hal_allocation_cache_trim(iree_hal_allocation_cache_t* cache) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Steal all cached blocks so that the (potentially slow) frees happen
+  // outside of the lock.
+  iree_hal_allocation_cache_block_t*
+      heap_blocks[IREE_HAL_ALLOCATION_CACHE_MAX_HEAP_COUNT] = {NULL};
+  iree_slim_mutex_lock(&cache->mutex);
+  for (iree_host_size_t heap = 0; heap < cache->heap_count; ++heap) {
+    for (iree_host_size_t i = 0; i < IREE_HAL_ALLOCATION_CACHE_CLASS_COUNT;
+         ++i) {
+      iree_hal_allocation_cache_block_t* block = cache->blocks[heap][i];
+      while (block) {
+        iree_hal_allocation_cache_block_t* next = block->next;
+        block->next = heap_blocks[heap];
+        heap_blocks[heap] = block;
+        block = next;
+      }
+      cache->blocks[heap][i] = NULL;
+    }
+  }
+  cache->size = 0;
+  cache->low_watermark = 0;
+  iree_hal_allocation_cache_block_t* unused_nodes = cache->unused_nodes;
+  cache->unused_nodes = NULL;
+  ++cache->statistics.trim_count;
+  IREE_TRACE_PLOT_VALUE_I64("iree_hal_allocation_cache::size", 0);
+  iree_slim_mutex_unlock(&cache->mutex);
+
+  iree_hal_allocation_cache_free_blocks(cache, heap_blocks);
+  while (unused_nodes) {
+    iree_hal_allocation_cache_block_t* next = unused_nodes->next;
+    iree_allocator_free(cache->host_allocator, unused_nodes);
+    unused_nodes = next;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_hal_allocation_cache_trim_unused(
+    iree_hal_allocation_cache_t* cache) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Steal blocks starting from the largest size classes until we've taken at
+  // least as much as sat unused since the last trim. As with a full trim the
+  // frees happen outside of the lock.
+  iree_hal_allocation_cache_block_t*
+      heap_blocks[IREE_HAL_ALLOCATION_CACHE_MAX_HEAP_COUNT] = {NULL};
+  iree_slim_mutex_lock(&cache->mutex);
+  iree_device_size_t unused_size = cache->low_watermark;
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, unused_size);
+  for (iree_host_size_t i = IREE_HAL_ALLOCATION_CACHE_CLASS_COUNT;
+       i-- > 0 && unused_size > 0;) {
+    const iree_device_size_t class_size =
+        iree_hal_allocation_cache_class_size(i);
+    for (iree_host_size_t heap = 0; heap < cache->heap_count; ++heap) {
+      while (unused_size > 0 && cache->blocks[heap][i]) {
+        iree_hal_allocation_cache_block_t* block = cache->blocks[heap][i];
+        cache->blocks[heap][i] = block->next;
+        block->next = heap_blocks[heap];
+        heap_blocks[heap] = block;
+        cache->size -= class_size;
+        unused_size -= iree_min(unused_size, class_size);
+      }
+    }
+  }
+  cache->low_watermark = cache->size;
+  ++cache->statistics.trim_count;
+  IREE_TRACE_PLOT_VALUE_I64("iree_hal_allocation_cache::size", cache->size);
+  iree_slim_mutex_unlock(&cache->mutex);
+
+  iree_hal_allocation_cache_free_blocks(cache, heap_blocks);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_hal_allocation_cache_query_statistics(
+    iree_hal_allocation_cache_t* cache,
+    iree_hal_allocation_cache_statistics_t* out_statistics) {
+  iree_slim_mutex_lock(&cache->mutex);
+  *out_statistics = cache->statistics;
+  out_statistics->cache_size = cache->size;
+  iree_slim_mutex_unlock(&cache->mutex);
+}
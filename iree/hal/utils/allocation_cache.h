@@ -0,0 +1,163 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_ALLOCATION_CACHE_H_
+#define IREE_HAL_UTILS_ALLOCATION_CACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Allocations are rounded up to size classes spaced at quarter powers of two
+// so that a cached block wastes at most 25% of its size.
+#define IREE_HAL_ALLOCATION_CACHE_CLASSES_PER_POW2_LOG2 2
+// Allocations of this size or smaller all share the smallest size class.
+#define IREE_HAL_ALLOCATION_CACHE_MIN_SIZE_LOG2 8
+// Allocations larger than this are never cached.
+#define IREE_HAL_ALLOCATION_CACHE_MAX_SIZE_LOG2 32
+#define IREE_HAL_ALLOCATION_CACHE_CLASS_COUNT                 \
+  (((IREE_HAL_ALLOCATION_CACHE_MAX_SIZE_LOG2 -                \
+     IREE_HAL_ALLOCATION_CACHE_MIN_SIZE_LOG2)                 \
+    << IREE_HAL_ALLOCATION_CACHE_CLASSES_PER_POW2_LOG2) +     \
+   1)
+
+// Maximum number of physical heaps a single cache can track.
+#define IREE_HAL_ALLOCATION_CACHE_MAX_HEAP_COUNT 4
+
+// A device allocation as returned by the backend allocation APIs.
+// |device_ptr| holds the device address (CUdeviceptr, hipDeviceptr_t, etc) and
+// |host_ptr| the host mapping of the allocation, if any.
+typedef struct iree_hal_cached_allocation_t {
+  uint64_t device_ptr;
+  void* host_ptr;
+} iree_hal_cached_allocation_t;
+
+// Frees |allocation| made from |heap| back to the backend.
+typedef void(IREE_API_PTR* iree_hal_allocation_cache_free_fn_t)(
+    void* user_data, iree_host_size_t heap,
+    iree_hal_cached_allocation_t allocation);
+
+typedef struct iree_hal_allocation_cache_free_callback_t {
+  iree_hal_allocation_cache_free_fn_t fn;
+  void* user_data;
+} iree_hal_allocation_cache_free_callback_t;
+
+// Size class an allocation is rounded up to when cached.
+typedef struct iree_hal_allocation_cache_class_t {
+  // Index of the class in the per-heap free lists.
+  iree_host_size_t index;
+  // Size of every block in the class; allocations that may be cached must be
+  // made with this size.
+  iree_device_size_t size;
+} iree_hal_allocation_cache_class_t;
+
+// Statistics of an allocation cache.
+typedef struct iree_hal_allocation_cache_statistics_t {
+  // Number of allocations served from cached memory.
+  uint64_t hit_count;
+  // Number of cacheable allocations that required a new backend allocation.
+  uint64_t miss_count;
+  // Number of times the cache was trimmed.
+  uint64_t trim_count;
+  // Total size in bytes of the memory currently held in the cache.
+  iree_device_size_t cache_size;
+} iree_hal_allocation_cache_statistics_t;
+
+typedef struct iree_hal_allocation_cache_block_t
+    iree_hal_allocation_cache_block_t;
+
+// A cache of freed device allocations shared by the GPU HAL drivers.
+// Backend allocators route cacheable allocations through the cache by size
+// class and physical heap so that allocation-heavy workloads avoid the cost of
+// the backend allocation APIs (which often synchronize the device). The
+// backend defines what its heaps are and frees evicted memory through the
+// |free_callback|.
+//
+// Thread-safe; allocations and deallocations may happen from any thread.
+typedef struct iree_hal_allocation_cache_t {
+  iree_allocator_t host_allocator;
+  // Maximum total size of all cached blocks; 0 disables the cache.
+  iree_device_size_t limit;
+  iree_host_size_t heap_count;
+  iree_hal_allocation_cache_free_callback_t free_callback;
+
+  // Guards all state below.
+  iree_slim_mutex_t mutex;
+  // Total size of all blocks in |blocks|.
+  iree_device_size_t size;
+  // Lowest |size| observed since the cache was last trimmed. Blocks totaling
+  // this size were never needed in that interval.
+  iree_device_size_t low_watermark;
+  // Singly-linked free lists of cached blocks for each heap and size class.
+  iree_hal_allocation_cache_block_t*
+      blocks[IREE_HAL_ALLOCATION_CACHE_MAX_HEAP_COUNT]
+            [IREE_HAL_ALLOCATION_CACHE_CLASS_COUNT];
+  // Block list nodes that are not currently tracking an allocation.
+  iree_hal_allocation_cache_block_t* unused_nodes;
+  iree_hal_allocation_cache_statistics_t statistics;
+} iree_hal_allocation_cache_t;
+
+// Initializes |out_cache| to retain up to |limit| bytes of allocations made
+// from |heap_count| heaps. |free_callback| is used to free allocations that
+// are evicted or trimmed from the cache.
+void iree_hal_allocation_cache_initialize(
+    iree_device_size_t limit, iree_host_size_t heap_count,
+    iree_hal_allocation_cache_free_callback_t free_callback,
+    iree_allocator_t host_allocator, iree_hal_allocation_cache_t* out_cache);
+
+// Frees all cached allocations and deinitializes |cache|.
+void iree_hal_allocation_cache_deinitialize(iree_hal_allocation_cache_t* cache);
+
+// Returns the size class allocations of |size| bytes are cached in.
+// Returns false if the cache is disabled or the size is too large to cache in
+// which case allocations must be made with their exact size.
+bool iree_hal_allocation_cache_lookup_class(
+    const iree_hal_allocation_cache_t* cache, iree_device_size_t size,
+    iree_hal_allocation_cache_class_t* out_class);
+
+// Pops a cached allocation of |size_class| from |heap| into |out_allocation|.
+// Returns false on a cache miss.
+bool iree_hal_allocation_cache_acquire(
+    iree_hal_allocation_cache_t* cache, iree_host_size_t heap,
+    const iree_hal_allocation_cache_class_t* size_class,
+    iree_hal_cached_allocation_t* out_allocation);
+
+// Pushes |allocation| of |size_class| made from |heap| into the cache.
+// Returns false if the cache is full and the allocation must be freed by the
+// caller.
+bool iree_hal_allocation_cache_release(
+    iree_hal_allocation_cache_t* cache, iree_host_size_t heap,
+    const iree_hal_allocation_cache_class_t* size_class,
+    iree_hal_cached_allocation_t allocation);
+
+// Frees all cached allocations back to the backend.
+void iree_hal_allocation_cache_trim(iree_hal_allocation_cache_t* cache);
+
+// Frees cached allocations that went unused since the previous trim back to
+// the backend, starting with the largest size classes.
+// The cache tracks the lowest amount of memory it held between trims (its low
+// watermark) and only that much is freed: memory that was reused is treated
+// as part of the working set and retained. Calling this periodically (such as
+// from iree_hal_allocator_trim) lets the cache follow changes in the workload
+// without discarding memory that is about to be reused.
+void iree_hal_allocation_cache_trim_unused(iree_hal_allocation_cache_t* cache);
+
+// Queries the current statistics of |cache|.
+void iree_hal_allocation_cache_query_statistics(
+    iree_hal_allocation_cache_t* cache,
+    iree_hal_allocation_cache_statistics_t* out_statistics);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_ALLOCATION_CACHE_H_
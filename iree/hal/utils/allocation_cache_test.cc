@@ -0,0 +1,209 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/allocation_cache.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+struct FreedAllocation {
+  iree_host_size_t heap;
+  uint64_t device_ptr;
+};
+
+static void RecordFree(void* user_data, iree_host_size_t heap,
+                       iree_hal_cached_allocation_t allocation) {
+  auto* freed = reinterpret_cast<std::vector<FreedAllocation>*>(user_data);
+  freed->push_back({heap, allocation.device_ptr});
+}
+
+class AllocationCacheTest : public ::testing::Test {
+ protected:
+  void Initialize(iree_device_size_t limit) {
+    iree_hal_allocation_cache_free_callback_t free_callback;
+    free_callback.fn = RecordFree;
+    free_callback.user_data = &freed_;
+    iree_hal_allocation_cache_initialize(limit, /*heap_count=*/2,
+                                         free_callback,
+                                         iree_allocator_system(), &cache_);
+  }
+
+  void TearDown() override { iree_hal_allocation_cache_deinitialize(&cache_); }
+
+  iree_hal_allocation_cache_class_t LookupClass(iree_device_size_t size) {
+    iree_hal_allocation_cache_class_t size_class;
+    EXPECT_TRUE(
+        iree_hal_allocation_cache_lookup_class(&cache_, size, &size_class));
+    return size_class;
+  }
+
+  static iree_hal_cached_allocation_t MakeAllocation(uint64_t device_ptr) {
+    iree_hal_cached_allocation_t allocation;
+    allocation.device_ptr = device_ptr;
+    allocation.host_ptr = NULL;
+    return allocation;
+  }
+
+  iree_hal_allocation_cache_t cache_;
+  std::vector<FreedAllocation> freed_;
+};
+
+TEST_F(AllocationCacheTest, SizeClasses) {
+  Initialize(/*limit=*/1024 * 1024);
+  EXPECT_EQ(LookupClass(1).size, 256);
+  EXPECT_EQ(LookupClass(256).size, 256);
+  EXPECT_EQ(LookupClass(257).size, 320);
+  EXPECT_EQ(LookupClass(320).size, 320);
+  EXPECT_EQ(LookupClass(321).size, 384);
+  EXPECT_EQ(LookupClass(512).size, 512);
+  EXPECT_EQ(LookupClass(1000).size, 1024);
+  // Classes are strictly increasing with size.
+  EXPECT_LT(LookupClass(256).index, LookupClass(257).index);
+  EXPECT_LT(LookupClass(320).index, LookupClass(321).index);
+  EXPECT_LT(LookupClass(512).index, LookupClass(1000).index);
+  // The largest cacheable class is still in range.
+  EXPECT_LT(LookupClass(1ull << 32).index,
+            IREE_HAL_ALLOCATION_CACHE_CLASS_COUNT);
+  // Larger allocations are not cached.
+  iree_hal_allocation_cache_class_t size_class;
+  EXPECT_FALSE(iree_hal_allocation_cache_lookup_class(
+      &cache_, (1ull << 32) + 1, &size_class));
+}
+
+TEST_F(AllocationCacheTest, DisabledWithZeroLimit) {
+  Initialize(/*limit=*/0);
+  iree_hal_allocation_cache_class_t size_class;
+  EXPECT_FALSE(iree_hal_allocation_cache_lookup_class(&cache_, 1024,
+                                                      &size_class));
+}
+
+TEST_F(AllocationCacheTest, ReuseWithinClassAndHeap) {
+  Initialize(/*limit=*/1024 * 1024);
+  iree_hal_allocation_cache_class_t size_class = LookupClass(1000);
+  iree_hal_cached_allocation_t allocation;
+  EXPECT_FALSE(iree_hal_allocation_cache_acquire(&cache_, /*heap=*/0,
+                                                 &size_class, &allocation));
+  EXPECT_TRUE(iree_hal_allocation_cache_release(&cache_, /*heap=*/0,
+                                                &size_class,
+                                                MakeAllocation(0x1000)));
+
+  // Other heaps and classes miss.
+  EXPECT_FALSE(iree_hal_allocation_cache_acquire(&cache_, /*heap=*/1,
+                                                 &size_class, &allocation));
+  iree_hal_allocation_cache_class_t other_class = LookupClass(4096);
+  EXPECT_FALSE(iree_hal_allocation_cache_acquire(&cache_, /*heap=*/0,
+                                                 &other_class, &allocation));
+
+  // Any size in the same class hits.
+  iree_hal_allocation_cache_class_t same_class = LookupClass(900);
+  ASSERT_EQ(same_class.index, size_class.index);
+  ASSERT_TRUE(iree_hal_allocation_cache_acquire(&cache_, /*heap=*/0,
+                                                &same_class, &allocation));
+  EXPECT_EQ(allocation.device_ptr, 0x1000);
+  EXPECT_FALSE(iree_hal_allocation_cache_acquire(&cache_, /*heap=*/0,
+                                                 &size_class, &allocation));
+
+  iree_hal_allocation_cache_statistics_t statistics;
+  iree_hal_allocation_cache_query_statistics(&cache_, &statistics);
+  EXPECT_EQ(statistics.hit_count, 1);
+  EXPECT_EQ(statistics.miss_count, 4);
+  EXPECT_EQ(statistics.cache_size, 0);
+  EXPECT_TRUE(freed_.empty());
+}
+
+TEST_F(AllocationCacheTest, ReleaseFailsOverLimit) {
+  Initialize(/*limit=*/2048);
+  iree_hal_allocation_cache_class_t size_class = LookupClass(1024);
+  EXPECT_TRUE(iree_hal_allocation_cache_release(&cache_, /*heap=*/0,
+                                                &size_class,
+                                                MakeAllocation(0x1000)));
+  EXPECT_TRUE(iree_hal_allocation_cache_release(&cache_, /*heap=*/0,
+                                                &size_class,
+                                                MakeAllocation(0x2000)));
+  EXPECT_FALSE(iree_hal_allocation_cache_release(&cache_, /*heap=*/0,
+                                                 &size_class,
+                                                 MakeAllocation(0x3000)));
+  iree_hal_allocation_cache_statistics_t statistics;
+  iree_hal_allocation_cache_query_statistics(&cache_, &statistics);
+  EXPECT_EQ(statistics.cache_size, 2048);
+}
+
+TEST_F(AllocationCacheTest, TrimFreesToBackend) {
+  Initialize(/*limit=*/1024 * 1024);
+  iree_hal_allocation_cache_class_t size_class = LookupClass(1024);
+  EXPECT_TRUE(iree_hal_allocation_cache_release(&cache_, /*heap=*/0,
+                                                &size_class,
+                                                MakeAllocation(0x1000)));
+  EXPECT_TRUE(iree_hal_allocation_cache_release(&cache_, /*heap=*/1,
+                                                &size_class,
+                                                MakeAllocation(0x2000)));
+  iree_hal_allocation_cache_trim(&cache_);
+  ASSERT_EQ(freed_.size(), 2);
+  EXPECT_EQ(freed_[0].heap, 0);
+  EXPECT_EQ(freed_[0].device_ptr, 0x1000);
+  EXPECT_EQ(freed_[1].heap, 1);
+  EXPECT_EQ(freed_[1].device_ptr, 0x2000);
+
+  iree_hal_allocation_cache_statistics_t statistics;
+  iree_hal_allocation_cache_query_statistics(&cache_, &statistics);
+  EXPECT_EQ(statistics.trim_count, 1);
+  EXPECT_EQ(statistics.cache_size, 0);
+
+  iree_hal_cached_allocation_t allocation;
+  EXPECT_FALSE(iree_hal_allocation_cache_acquire(&cache_, /*heap=*/0,
+                                                 &size_class, &allocation));
+}
+
+TEST_F(AllocationCacheTest, TrimUnusedRetainsWorkingSet) {
+  Initialize(/*limit=*/1024 * 1024);
+  iree_hal_allocation_cache_class_t small_class = LookupClass(1024);
+  iree_hal_allocation_cache_class_t large_class = LookupClass(4096);
+  EXPECT_TRUE(iree_hal_allocation_cache_release(&cache_, /*heap=*/0,
+                                                &small_class,
+                                                MakeAllocation(0x1000)));
+  EXPECT_TRUE(iree_hal_allocation_cache_release(&cache_, /*heap=*/1,
+                                                &large_class,
+                                                MakeAllocation(0x2000)));
+
+  // Nothing has been cached for a full interval yet.
+  iree_hal_allocation_cache_trim_unused(&cache_);
+  EXPECT_TRUE(freed_.empty());
+
+  // Reuse the small allocation; only the large one went unused.
+  iree_hal_cached_allocation_t allocation;
+  ASSERT_TRUE(iree_hal_allocation_cache_acquire(&cache_, /*heap=*/0,
+                                                &small_class, &allocation));
+  EXPECT_TRUE(iree_hal_allocation_cache_release(&cache_, /*heap=*/0,
+                                                &small_class, allocation));
+  iree_hal_allocation_cache_trim_unused(&cache_);
+  ASSERT_EQ(freed_.size(), 1);
+  EXPECT_EQ(freed_[0].heap, 1);
+  EXPECT_EQ(freed_[0].device_ptr, 0x2000);
+
+  iree_hal_allocation_cache_statistics_t statistics;
+  iree_hal_allocation_cache_query_statistics(&cache_, &statistics);
+  EXPECT_EQ(statistics.cache_size, 1024);
+
+  // The small allocation is freed once it also goes a full interval unused.
+  iree_hal_allocation_cache_trim_unused(&cache_);
+  ASSERT_EQ(freed_.size(), 2);
+  EXPECT_EQ(freed_[1].heap, 0);
+  EXPECT_EQ(freed_[1].device_ptr, 0x1000);
+  iree_hal_allocation_cache_query_statistics(&cache_, &statistics);
+  EXPECT_EQ(statistics.trim_count, 3);
+  EXPECT_EQ(statistics.cache_size, 0);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
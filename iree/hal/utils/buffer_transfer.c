@@ -6,12 +6,25 @@
 
 #include "iree/hal/utils/buffer_transfer.h"
 
+#include <string.h>
+
 #include "iree/base/tracing.h"
 
 //===----------------------------------------------------------------------===//
 // iree_hal_device_transfer_range implementations
 //===----------------------------------------------------------------------===//
 
+// Returns true if |buffer| is host memory or a device buffer that can be
+// mapped into host memory.
+static bool iree_hal_transfer_buffer_is_mappable(
+    iree_hal_transfer_buffer_t buffer) {
+  return !buffer.device_buffer ||
+         (iree_all_bits_set(iree_hal_buffer_memory_type(buffer.device_buffer),
+                            IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) &&
+          iree_all_bits_set(iree_hal_buffer_allowed_usage(buffer.device_buffer),
+                            IREE_HAL_BUFFER_USAGE_MAPPING));
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_device_submit_transfer_range_and_wait(
     iree_hal_device_t* device, iree_hal_transfer_buffer_t source,
     iree_device_size_t source_offset, iree_hal_transfer_buffer_t target,
@@ -24,19 +37,8 @@ IREE_API_EXPORT iree_status_t iree_hal_device_submit_transfer_range_and_wait(
   // device-local host-visible memory we'd be performing the transfer by pulling
   // all the memory to the CPU and pushing it back again.
   // TODO(benvanik): check for device-local -> device-local and avoid mapping.
-  bool is_source_mappable =
-      !source.device_buffer ||
-      (iree_all_bits_set(iree_hal_buffer_memory_type(source.device_buffer),
-                         IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) &&
-       iree_all_bits_set(iree_hal_buffer_allowed_usage(source.device_buffer),
-                         IREE_HAL_BUFFER_USAGE_MAPPING));
-  bool is_target_mappable =
-      !target.device_buffer ||
-      (iree_all_bits_set(iree_hal_buffer_memory_type(target.device_buffer),
-                         IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) &&
-       iree_all_bits_set(iree_hal_buffer_allowed_usage(target.device_buffer),
-                         IREE_HAL_BUFFER_USAGE_MAPPING));
-  if (is_source_mappable && is_target_mappable) {
+  if (iree_hal_transfer_buffer_is_mappable(source) &&
+      iree_hal_transfer_buffer_is_mappable(target)) {
     return iree_hal_device_transfer_mappable_range(
         device, source, source_offset, target, target_offset, data_length,
         flags, timeout);
@@ -205,6 +207,310 @@ IREE_API_EXPORT iree_status_t iree_hal_device_transfer_mappable_range(
   return status;
 }
 
+//===----------------------------------------------------------------------===//
+// iree_hal_transfer_staging_ring_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT void iree_hal_transfer_staging_ring_initialize(
+    iree_hal_device_t* device, iree_device_size_t slot_size,
+    iree_hal_transfer_staging_ring_t* out_ring) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(out_ring);
+  memset(out_ring, 0, sizeof(*out_ring));
+  out_ring->device = device;
+  out_ring->slot_size = slot_size;
+  iree_slim_mutex_initialize(&out_ring->mutex);
+}
+
+static iree_status_t iree_hal_transfer_staging_ring_retire_all(
+    iree_hal_transfer_staging_ring_t* ring, iree_status_t status,
+    iree_timeout_t timeout);
+
+IREE_API_EXPORT void iree_hal_transfer_staging_ring_deinitialize(
+    iree_hal_transfer_staging_ring_t* ring) {
+  iree_status_ignore(iree_hal_transfer_staging_ring_retire_all(
+      ring, iree_ok_status(), iree_infinite_timeout()));
+  iree_hal_buffer_release(ring->buffer);
+  iree_hal_semaphore_release(ring->semaphore);
+  iree_slim_mutex_deinitialize(&ring->mutex);
+  memset(ring, 0, sizeof(*ring));
+}
+
+IREE_API_EXPORT void iree_hal_transfer_staging_ring_trim(
+    iree_hal_transfer_staging_ring_t* ring) {
+  iree_slim_mutex_lock(&ring->mutex);
+  // The device may still be reading uploaded chunks from the buffer.
+  iree_status_ignore(iree_hal_transfer_staging_ring_retire_all(
+      ring, iree_ok_status(), iree_infinite_timeout()));
+  iree_hal_buffer_t* buffer = ring->buffer;
+  ring->buffer = NULL;
+  iree_slim_mutex_unlock(&ring->mutex);
+  iree_hal_buffer_release(buffer);
+}
+
+// Allocates the staging buffer and semaphore of |ring| if needed.
+// Must be called with the ring lock held.
+static iree_status_t iree_hal_transfer_staging_ring_reserve(
+    iree_hal_transfer_staging_ring_t* ring) {
+  if (!ring->buffer) {
+    IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(ring->device),
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING,
+        ring->slot_size * IREE_HAL_TRANSFER_STAGING_RING_SLOT_COUNT,
+        iree_const_byte_span_empty(), &ring->buffer));
+  }
+  if (!ring->semaphore) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_semaphore_create(ring->device, 0ull, &ring->semaphore));
+    ring->semaphore_value = 0ull;
+  }
+  return iree_ok_status();
+}
+
+// Submits a transfer of |slot| between the ring staging buffer and
+// |device_buffer| that signals the ring semaphore when it completes.
+static iree_status_t iree_hal_transfer_staging_ring_submit_slot(
+    iree_hal_transfer_staging_ring_t* ring, iree_hal_buffer_t* device_buffer,
+    iree_device_size_t device_offset, iree_hal_transfer_staging_slot_t* slot) {
+  iree_hal_transfer_command_t transfer_command = {
+      .type = IREE_HAL_TRANSFER_COMMAND_TYPE_COPY,
+  };
+  if (slot->host_ptr) {
+    transfer_command.copy.source_buffer = device_buffer;
+    transfer_command.copy.source_offset = device_offset;
+    transfer_command.copy.target_buffer = ring->buffer;
+    transfer_command.copy.target_offset = slot->slot_offset;
+  } else {
+    transfer_command.copy.source_buffer = ring->buffer;
+    transfer_command.copy.source_offset = slot->slot_offset;
+    transfer_command.copy.target_buffer = device_buffer;
+    transfer_command.copy.target_offset = device_offset;
+  }
+  transfer_command.copy.length = slot->length;
+
+  // The submission has no waits and may execute inline.
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_create_transfer_command_buffer(
+      ring->device,
+      IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT |
+          IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
+      IREE_HAL_QUEUE_AFFINITY_ANY, 1, &transfer_command, &command_buffer));
+
+  uint64_t signal_value = ring->semaphore_value + 1;
+  iree_hal_submission_batch_t batch = {
+      .wait_semaphores = {0},
+      .command_buffer_count = 1,
+      .command_buffers = &command_buffer,
+      .signal_semaphores =
+          {
+              .count = 1,
+              .semaphores = &ring->semaphore,
+              .payload_values = &signal_value,
+          },
+  };
+  iree_status_t status = iree_hal_device_queue_submit(
+      ring->device, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+      IREE_HAL_QUEUE_AFFINITY_ANY, 1, &batch);
+  if (iree_status_is_ok(status)) {
+    ring->semaphore_value = signal_value;
+    slot->command_buffer = command_buffer;
+    slot->signal_value = signal_value;
+  } else {
+    iree_hal_command_buffer_release(command_buffer);
+  }
+  return status;
+}
+
+// Waits for the transfer of |slot| to complete and, if |copy_out| is set and
+// the slot is a download, copies its contents out to host memory. The slot is
+// idle upon return.
+static iree_status_t iree_hal_transfer_staging_ring_retire_slot(
+    iree_hal_transfer_staging_ring_t* ring,
+    iree_hal_transfer_staging_slot_t* slot, bool copy_out,
+    iree_timeout_t timeout) {
+  if (!slot->command_buffer) return iree_ok_status();
+  iree_status_t status =
+      iree_hal_semaphore_wait(ring->semaphore, slot->signal_value, timeout);
+  if (iree_status_is_ok(status) && copy_out && slot->host_ptr) {
+    status = iree_hal_buffer_read_data(ring->buffer, slot->slot_offset,
+                                       slot->host_ptr, slot->length);
+  }
+  iree_hal_command_buffer_release(slot->command_buffer);
+  memset(slot, 0, sizeof(*slot));
+  return status;
+}
+
+// Retires all slots of |ring| oldest first, joining their status with
+// |status|. Downloads are only copied out while the status is OK but even on
+// failure we must wait for in-flight chunks before the staging buffer can be
+// reused. Must be called with the ring lock held.
+static iree_status_t iree_hal_transfer_staging_ring_retire_all(
+    iree_hal_transfer_staging_ring_t* ring, iree_status_t status,
+    iree_timeout_t timeout) {
+  for (iree_host_size_t i = 0; i < IREE_HAL_TRANSFER_STAGING_RING_SLOT_COUNT;
+       ++i) {
+    status = iree_status_join(
+        status, iree_hal_transfer_staging_ring_retire_slot(
+                    ring, &ring->slots[ring->next_slot],
+                    /*copy_out=*/iree_status_is_ok(status), timeout));
+    ring->next_slot =
+        (ring->next_slot + 1) % IREE_HAL_TRANSFER_STAGING_RING_SLOT_COUNT;
+  }
+  return status;
+}
+
+// Drops the staging resources of |ring| after a failed transfer. We can't be
+// sure the device is done with them (or that the semaphore is usable); the
+// next transfer will allocate new ones. Must be called with the ring lock held.
+static void iree_hal_transfer_staging_ring_reset(
+    iree_hal_transfer_staging_ring_t* ring) {
+  for (iree_host_size_t i = 0; i < IREE_HAL_TRANSFER_STAGING_RING_SLOT_COUNT;
+       ++i) {
+    iree_hal_command_buffer_release(ring->slots[i].command_buffer);
+  }
+  memset(ring->slots, 0, sizeof(ring->slots));
+  ring->next_slot = 0;
+  iree_hal_buffer_release(ring->buffer);
+  ring->buffer = NULL;
+  iree_hal_semaphore_release(ring->semaphore);
+  ring->semaphore = NULL;
+}
+
+// Pipelines the chunks of a transfer through the slots of |ring|: while the
+// device transfers one chunk the host fills (or drains) the slot of another.
+// The last chunks are left in flight. Must be called with the ring lock held.
+static iree_status_t iree_hal_transfer_staging_ring_pipeline(
+    iree_hal_transfer_staging_ring_t* ring, bool is_upload,
+    iree_hal_transfer_buffer_t source, iree_device_size_t source_offset,
+    iree_hal_transfer_buffer_t target, iree_device_size_t target_offset,
+    iree_device_size_t data_length, iree_timeout_t timeout) {
+  IREE_RETURN_IF_ERROR(iree_hal_transfer_staging_ring_reserve(ring));
+  for (iree_device_size_t offset = 0; offset < data_length;
+       offset += ring->slot_size) {
+    iree_hal_transfer_staging_slot_t* slot = &ring->slots[ring->next_slot];
+    IREE_RETURN_IF_ERROR(iree_hal_transfer_staging_ring_retire_slot(
+        ring, slot, /*copy_out=*/true, timeout));
+    slot->slot_offset = ring->next_slot * ring->slot_size;
+    slot->length = iree_min(ring->slot_size, data_length - offset);
+    ring->next_slot =
+        (ring->next_slot + 1) % IREE_HAL_TRANSFER_STAGING_RING_SLOT_COUNT;
+    if (is_upload) {
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_write_data(
+          ring->buffer, slot->slot_offset,
+          (const uint8_t*)source.host_buffer.data + source_offset + offset,
+          slot->length));
+      IREE_RETURN_IF_ERROR(iree_hal_transfer_staging_ring_submit_slot(
+          ring, target.device_buffer, target_offset + offset, slot));
+    } else {
+      slot->host_ptr = target.host_buffer.data + target_offset + offset;
+      IREE_RETURN_IF_ERROR(iree_hal_transfer_staging_ring_submit_slot(
+          ring, source.device_buffer, source_offset + offset, slot));
+    }
+  }
+  return iree_ok_status();
+}
+
+// Returns true if the transfer is between host memory and an unmappable device
+// buffer and should go through |ring|. Small uploads are cheaper to perform as
+// command buffer updates.
+static bool iree_hal_transfer_staging_ring_should_stage(
+    iree_hal_transfer_staging_ring_t* ring, iree_hal_transfer_buffer_t source,
+    iree_hal_transfer_buffer_t target, iree_device_size_t data_length,
+    bool* out_is_upload) {
+  bool is_upload = !source.device_buffer &&
+                   !iree_hal_transfer_buffer_is_mappable(target) &&
+                   data_length > IREE_HAL_COMMAND_BUFFER_MAX_UPDATE_SIZE;
+  bool is_download = !target.device_buffer &&
+                     !iree_hal_transfer_buffer_is_mappable(source);
+  *out_is_upload = is_upload;
+  return (is_upload || is_download) && data_length != IREE_WHOLE_BUFFER &&
+         ring->slot_size != 0;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_device_transfer_staged_range(
+    iree_hal_device_t* device, iree_hal_transfer_staging_ring_t* ring,
+    iree_hal_transfer_buffer_t source, iree_device_size_t source_offset,
+    iree_hal_transfer_buffer_t target, iree_device_size_t target_offset,
+    iree_device_size_t data_length, iree_hal_transfer_buffer_flags_t flags,
+    iree_timeout_t timeout) {
+  bool is_upload = false;
+  if (!iree_hal_transfer_staging_ring_should_stage(ring, source, target,
+                                                   data_length, &is_upload)) {
+    return iree_hal_device_submit_transfer_range_and_wait(
+        device, source, source_offset, target, target_offset, data_length,
+        flags, timeout);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, is_upload ? "h2d" : "d2h");
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)data_length);
+
+  // Each chunk waits on the previous use of its slot so the timeout must
+  // apply to the transfer as a whole.
+  iree_convert_timeout_to_absolute(&timeout);
+
+  iree_slim_mutex_lock(&ring->mutex);
+  iree_status_t status = iree_hal_transfer_staging_ring_pipeline(
+      ring, is_upload, source, source_offset, target, target_offset,
+      data_length, timeout);
+  status = iree_hal_transfer_staging_ring_retire_all(ring, status, timeout);
+  if (!iree_status_is_ok(status)) {
+    iree_hal_transfer_staging_ring_reset(ring);
+  }
+  iree_slim_mutex_unlock(&ring->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_device_transfer_staged_range_async(
+    iree_hal_device_t* device, iree_hal_transfer_staging_ring_t* ring,
+    iree_hal_transfer_buffer_t source, iree_device_size_t source_offset,
+    iree_hal_transfer_buffer_t target, iree_device_size_t target_offset,
+    iree_device_size_t data_length, iree_hal_transfer_buffer_flags_t flags,
+    iree_timeout_t timeout, iree_hal_semaphore_t** out_semaphore,
+    uint64_t* out_value) {
+  IREE_ASSERT_ARGUMENT(out_semaphore);
+  IREE_ASSERT_ARGUMENT(out_value);
+  *out_semaphore = NULL;
+  *out_value = 0ull;
+
+  // Downloads must wait for the device anyway before the host can read them.
+  bool is_upload = false;
+  if (!iree_hal_transfer_staging_ring_should_stage(ring, source, target,
+                                                   data_length, &is_upload) ||
+      !is_upload) {
+    return iree_hal_device_transfer_staged_range(
+        device, ring, source, source_offset, target, target_offset,
+        data_length, flags, timeout);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)data_length);
+
+  iree_convert_timeout_to_absolute(&timeout);
+
+  iree_slim_mutex_lock(&ring->mutex);
+  iree_status_t status = iree_hal_transfer_staging_ring_pipeline(
+      ring, is_upload, source, source_offset, target, target_offset,
+      data_length, timeout);
+  if (iree_status_is_ok(status)) {
+    // Chunks are submitted in order on the ring timeline so the last signal
+    // covers the whole transfer.
+    iree_hal_semaphore_retain(ring->semaphore);
+    *out_semaphore = ring->semaphore;
+    *out_value = ring->semaphore_value;
+  } else {
+    status = iree_hal_transfer_staging_ring_retire_all(ring, status, timeout);
+    iree_hal_transfer_staging_ring_reset(ring);
+  }
+  iree_slim_mutex_unlock(&ring->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_buffer_map_range implementations
 //===----------------------------------------------------------------------===//
@@ -238,7 +544,7 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_emulated_map_range(
   // No implementation should be using this emulated method with memory that is
   // allocated as mappable.
   if (IREE_UNLIKELY(iree_all_bits_set(iree_hal_buffer_memory_type(buffer),
-                                      IREE_HAL_BUFFER_USAGE_MAPPING))) {
+                                      IREE_HAL_MEMORY_TYPE_HOST_VISIBLE))) {
     return iree_make_status(
         IREE_STATUS_FAILED_PRECONDITION,
         "emulated buffer mapping should not be used with mappable buffers");
@@ -274,10 +580,10 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_emulated_map_range(
   // to map.
   if (iree_status_is_ok(status) &&
       !iree_all_bits_set(memory_access, IREE_HAL_MEMORY_ACCESS_DISCARD)) {
-    // Download (device->host) the data.
+    // Download (device->host) the data. Note that |local_byte_offset| is
+    // relative to |buffer| and not the (possibly subspan) mapped buffer.
     status = iree_hal_device_transfer_range(
-        device, iree_hal_make_device_transfer_buffer(mapping->buffer),
-        local_byte_offset,
+        device, iree_hal_make_device_transfer_buffer(buffer), local_byte_offset,
         iree_hal_make_device_transfer_buffer(
             emulation_state->host_local_buffer),
         0, local_byte_length, IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
@@ -342,9 +648,9 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_emulated_unmap_range(
         device,
         iree_hal_make_device_transfer_buffer(
             emulation_state->host_local_buffer),
-        0, iree_hal_make_device_transfer_buffer(mapping->buffer),
-        local_byte_offset, local_byte_length,
-        IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, iree_infinite_timeout());
+        0, iree_hal_make_device_transfer_buffer(buffer), local_byte_offset,
+        local_byte_length, IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
+        iree_infinite_timeout());
   }
 
   // Deallocate the scratch buffer and our emulation state.
@@ -8,6 +8,7 @@
 #define IREE_HAL_UTILS_BUFFER_TRANSFER_H_
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/hal/api.h"
 
 #ifdef __cplusplus
@@ -43,6 +44,111 @@ IREE_API_EXPORT iree_status_t iree_hal_device_transfer_mappable_range(
     iree_device_size_t target_offset, iree_device_size_t data_length,
     iree_hal_transfer_buffer_flags_t flags, iree_timeout_t timeout);
 
+//===----------------------------------------------------------------------===//
+// iree_hal_transfer_staging_ring_t
+//===----------------------------------------------------------------------===//
+
+// Number of slots in a staging ring. Two is enough to overlap copying one
+// chunk to or from host memory with the device transfer of the next.
+#define IREE_HAL_TRANSFER_STAGING_RING_SLOT_COUNT 2
+
+// Default size of each staging ring slot in bytes.
+#define IREE_HAL_TRANSFER_STAGING_RING_DEFAULT_SLOT_SIZE (4 * 1024 * 1024)
+
+// A chunk of a staged transfer occupying one slot of a staging ring.
+typedef struct iree_hal_transfer_staging_slot_t {
+  // Command buffer performing the chunk transfer; NULL if the slot is idle.
+  iree_hal_command_buffer_t* command_buffer;
+  // Ring semaphore value signaled when the chunk transfer completes.
+  uint64_t signal_value;
+  // Offset of the slot in the ring staging buffer.
+  iree_device_size_t slot_offset;
+  // Host memory the chunk is downloaded into or NULL for uploads.
+  uint8_t* host_ptr;
+  iree_device_size_t length;
+} iree_hal_transfer_staging_slot_t;
+
+// A ring of host-local device-visible staging slots used to transfer between
+// host memory and device buffers that cannot be mapped. The staging buffer is
+// allocated from the device allocator on first use and reused by all later
+// transfers so that each transfer does not pay for a (possibly pinned)
+// allocation. Transfers larger than a slot are split into chunks that are
+// pipelined through the slots.
+//
+// Chunks of asynchronous uploads may still be in flight when the next
+// transfer starts; it waits for the slots it reuses only.
+//
+// Transfers through the ring are serialized; the ring is intended to be owned
+// by a device and used to implement iree_hal_device_transfer_range.
+typedef struct iree_hal_transfer_staging_ring_t {
+  // Device the ring allocates from and submits to. Unretained as the ring is
+  // owned by the device.
+  iree_hal_device_t* device;
+  iree_device_size_t slot_size;
+
+  iree_slim_mutex_t mutex;
+  // Staging buffer of IREE_HAL_TRANSFER_STAGING_RING_SLOT_COUNT slots or NULL
+  // if not yet allocated.
+  iree_hal_buffer_t* buffer;
+  // Timeline signaled as each chunk transfer completes and the value of the
+  // last signal submitted.
+  iree_hal_semaphore_t* semaphore;
+  uint64_t semaphore_value;
+  // Chunks in flight per slot and the slot the next chunk is staged in; the
+  // slot after it holds the oldest chunk.
+  iree_hal_transfer_staging_slot_t
+      slots[IREE_HAL_TRANSFER_STAGING_RING_SLOT_COUNT];
+  iree_host_size_t next_slot;
+} iree_hal_transfer_staging_ring_t;
+
+// Initializes |out_ring| to stage transfers on |device| through slots of
+// |slot_size| bytes. No device resources are allocated until first use.
+IREE_API_EXPORT void iree_hal_transfer_staging_ring_initialize(
+    iree_hal_device_t* device, iree_device_size_t slot_size,
+    iree_hal_transfer_staging_ring_t* out_ring);
+
+// Releases the staging resources of |ring| after waiting for the chunks of
+// asynchronous uploads still in flight. No transfers may be in progress.
+IREE_API_EXPORT void iree_hal_transfer_staging_ring_deinitialize(
+    iree_hal_transfer_staging_ring_t* ring);
+
+// Releases the staging buffer of |ring| once the chunks still in flight have
+// completed. It will be reallocated on the next transfer that requires it.
+IREE_API_EXPORT void iree_hal_transfer_staging_ring_trim(
+    iree_hal_transfer_staging_ring_t* ring);
+
+// Performs a transfer between host memory and a device buffer that cannot be
+// mapped through |ring| and waits for it to complete. Transfers of other
+// kinds fall back to iree_hal_device_submit_transfer_range_and_wait.
+//
+// Precondition: source and target do not overlap.
+IREE_API_EXPORT iree_status_t iree_hal_device_transfer_staged_range(
+    iree_hal_device_t* device, iree_hal_transfer_staging_ring_t* ring,
+    iree_hal_transfer_buffer_t source, iree_device_size_t source_offset,
+    iree_hal_transfer_buffer_t target, iree_device_size_t target_offset,
+    iree_device_size_t data_length, iree_hal_transfer_buffer_flags_t flags,
+    iree_timeout_t timeout);
+
+// Performs a transfer like iree_hal_device_transfer_staged_range but returns
+// without waiting for the device transfer of uploads to complete.
+// |out_semaphore| (retained) reaches |out_value| once the target contents are
+// available; work reading the target must wait on it. The source host memory
+// may be reused upon return as all of it has been copied into staging memory
+// by then: the host copy of each chunk overlaps with the device transfer of
+// the previous one and only the last chunks remain in flight.
+//
+// Transfers other than uploads through the ring complete before returning and
+// |out_semaphore| is then set to NULL.
+//
+// Precondition: source and target do not overlap.
+IREE_API_EXPORT iree_status_t iree_hal_device_transfer_staged_range_async(
+    iree_hal_device_t* device, iree_hal_transfer_staging_ring_t* ring,
+    iree_hal_transfer_buffer_t source, iree_device_size_t source_offset,
+    iree_hal_transfer_buffer_t target, iree_device_size_t target_offset,
+    iree_device_size_t data_length, iree_hal_transfer_buffer_flags_t flags,
+    iree_timeout_t timeout, iree_hal_semaphore_t** out_semaphore,
+    uint64_t* out_value);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_buffer_map_range implementations
 //===----------------------------------------------------------------------===//
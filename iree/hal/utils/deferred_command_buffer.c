@@ -186,6 +186,12 @@ IREE_API_EXPORT iree_status_t iree_hal_deferred_command_buffer_create(
   return status;
 }
 
+IREE_API_EXPORT bool iree_hal_deferred_command_buffer_isa(
+    iree_hal_command_buffer_t* command_buffer) {
+  return iree_hal_command_buffer_dyn_cast(
+      command_buffer, &iree_hal_deferred_command_buffer_vtable);
+}
+
 static void iree_hal_deferred_command_buffer_destroy(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_deferred_command_buffer_t* command_buffer =
@@ -638,10 +644,9 @@ static iree_status_t iree_hal_deferred_command_buffer_push_descriptor_set(
   iree_hal_cmd_list_t* cmd_list = &command_buffer->cmd_list;
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, 1, &executable_layout));
-  for (iree_host_size_t i = 0; i < binding_count; ++i) {
-    IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
-        command_buffer->resource_set, 1, &bindings[i].buffer));
-  }
+  IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert_span(
+      command_buffer->resource_set, binding_count, &bindings[0].buffer,
+      sizeof(bindings[0])));
   iree_hal_cmd_push_descriptor_set_t* cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_cmd_list_append_command(
       cmd_list, IREE_HAL_CMD_PUSH_DESCRIPTOR_SET,
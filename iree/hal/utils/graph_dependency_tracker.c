@@ -0,0 +1,170 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/graph_dependency_tracker.h"
+
+#include <string.h>
+
+// FNV-1a offset basis used to seed |structure_hash|.
+#define IREE_HAL_GRAPH_STRUCTURE_HASH_SEED 0xCBF29CE484222325ull
+
+// Tags distinguishing the values mixed into the structure hash so that
+// different structures cannot produce the same sequence.
+typedef enum iree_hal_graph_hash_tag_e {
+  // Range of barrier nodes a node depends on.
+  IREE_HAL_GRAPH_HASH_TAG_BARRIER_BEGIN = 1,
+  IREE_HAL_GRAPH_HASH_TAG_BARRIER_END,
+  // Ordinal of a node in the same scope a node depends on.
+  IREE_HAL_GRAPH_HASH_TAG_DEPENDENCY,
+  // Kind of a node; ends the values of the node.
+  IREE_HAL_GRAPH_HASH_TAG_NODE,
+} iree_hal_graph_hash_tag_t;
+
+// Mixes |tag| and |value| into the structure hash of |tracker|.
+static void iree_hal_graph_dependency_tracker_hash(
+    iree_hal_graph_dependency_tracker_t* tracker, iree_hal_graph_hash_tag_t tag,
+    uint64_t value) {
+  uint64_t hash = tracker->structure_hash;
+  hash ^= (uint64_t)tag;
+  hash *= 0x100000001B3ull;
+  for (int i = 0; i < 8; ++i) {
+    hash ^= (value >> (i * 8)) & 0xFF;
+    hash *= 0x100000001B3ull;
+  }
+  tracker->structure_hash = hash;
+}
+
+void iree_hal_graph_dependency_tracker_initialize(
+    iree_allocator_t host_allocator,
+    iree_hal_graph_dependency_tracker_t* out_tracker) {
+  memset(out_tracker, 0, sizeof(*out_tracker));
+  out_tracker->host_allocator = host_allocator;
+  out_tracker->structure_hash = IREE_HAL_GRAPH_STRUCTURE_HASH_SEED;
+}
+
+void iree_hal_graph_dependency_tracker_deinitialize(
+    iree_hal_graph_dependency_tracker_t* tracker) {
+  iree_allocator_free(tracker->host_allocator, tracker->nodes);
+  iree_allocator_free(tracker->host_allocator, tracker->scope_accesses);
+  iree_allocator_free(tracker->host_allocator, tracker->dependencies);
+  memset(tracker, 0, sizeof(*tracker));
+}
+
+void iree_hal_graph_dependency_tracker_reset(
+    iree_hal_graph_dependency_tracker_t* tracker) {
+  tracker->node_count = 0;
+  tracker->barrier_node_begin = 0;
+  tracker->barrier_node_end = 0;
+  tracker->scope_node_begin = 0;
+  tracker->scope_access_count = 0;
+  tracker->structure_hash = IREE_HAL_GRAPH_STRUCTURE_HASH_SEED;
+}
+
+// Grows |*storage| of |element_size| elements to hold at least
+// |minimum_capacity| elements.
+static iree_status_t iree_hal_graph_dependency_tracker_reserve(
+    iree_hal_graph_dependency_tracker_t* tracker, iree_host_size_t element_size,
+    iree_host_size_t minimum_capacity, iree_host_size_t* capacity,
+    void** storage) {
+  if (minimum_capacity <= *capacity) return iree_ok_status();
+  iree_host_size_t new_capacity = iree_max(16, *capacity * 2);
+  new_capacity = iree_max(new_capacity, minimum_capacity);
+  IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+      tracker->host_allocator, new_capacity * element_size, storage));
+  *capacity = new_capacity;
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_graph_dependency_tracker_gather(
+    iree_hal_graph_dependency_tracker_t* tracker,
+    iree_host_size_t access_count, const iree_hal_graph_access_t* accesses,
+    iree_host_size_t* out_dependency_count,
+    const iree_hal_graph_node_t** out_dependencies) {
+  *out_dependency_count = 0;
+  *out_dependencies = NULL;
+  const iree_host_size_t barrier_node_count =
+      tracker->barrier_node_end - tracker->barrier_node_begin;
+  IREE_RETURN_IF_ERROR(iree_hal_graph_dependency_tracker_reserve(
+      tracker, sizeof(iree_hal_graph_node_t),
+      barrier_node_count + tracker->node_count - tracker->scope_node_begin,
+      &tracker->dependency_capacity, (void**)&tracker->dependencies));
+  iree_hal_graph_node_t* dependencies = tracker->dependencies;
+  if (barrier_node_count > 0) {
+    memcpy(dependencies, tracker->nodes + tracker->barrier_node_begin,
+           barrier_node_count * sizeof(iree_hal_graph_node_t));
+  }
+  iree_host_size_t dependency_count = barrier_node_count;
+  iree_hal_graph_dependency_tracker_hash(tracker,
+                                         IREE_HAL_GRAPH_HASH_TAG_BARRIER_BEGIN,
+                                         tracker->barrier_node_begin);
+  iree_hal_graph_dependency_tracker_hash(
+      tracker, IREE_HAL_GRAPH_HASH_TAG_BARRIER_END, tracker->barrier_node_end);
+
+  // Nodes in the current scope are all distinct from the barrier nodes so we
+  // only need to dedupe among themselves; graph APIs reject duplicate edges.
+  iree_host_size_t scope_base = dependency_count;
+  for (iree_host_size_t i = 0; i < tracker->scope_access_count; ++i) {
+    const iree_hal_graph_access_t* prior = &tracker->scope_accesses[i];
+    bool is_hazard = false;
+    for (iree_host_size_t j = 0; j < access_count && !is_hazard; ++j) {
+      is_hazard = (prior->is_write || accesses[j].is_write) &&
+                  prior->begin < accesses[j].end &&
+                  accesses[j].begin < prior->end;
+    }
+    if (!is_hazard) continue;
+    iree_hal_graph_node_t prior_node = tracker->nodes[prior->node_ordinal];
+    bool is_duplicate = false;
+    for (iree_host_size_t j = scope_base; j < dependency_count; ++j) {
+      if (dependencies[j] == prior_node) {
+        is_duplicate = true;
+        break;
+      }
+    }
+    if (is_duplicate) continue;
+    dependencies[dependency_count++] = prior_node;
+    iree_hal_graph_dependency_tracker_hash(
+        tracker, IREE_HAL_GRAPH_HASH_TAG_DEPENDENCY, prior->node_ordinal);
+  }
+
+  *out_dependency_count = dependency_count;
+  *out_dependencies = dependencies;
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_graph_dependency_tracker_append(
+    iree_hal_graph_dependency_tracker_t* tracker, iree_hal_graph_node_t node,
+    uint64_t node_kind, iree_host_size_t access_count,
+    iree_hal_graph_access_t* accesses) {
+  IREE_RETURN_IF_ERROR(iree_hal_graph_dependency_tracker_reserve(
+      tracker, sizeof(iree_hal_graph_node_t), tracker->node_count + 1,
+      &tracker->node_capacity, (void**)&tracker->nodes));
+  IREE_RETURN_IF_ERROR(iree_hal_graph_dependency_tracker_reserve(
+      tracker, sizeof(iree_hal_graph_access_t),
+      tracker->scope_access_count + access_count,
+      &tracker->scope_access_capacity, (void**)&tracker->scope_accesses));
+  iree_host_size_t node_ordinal = tracker->node_count++;
+  tracker->nodes[node_ordinal] = node;
+  iree_hal_graph_dependency_tracker_hash(tracker, IREE_HAL_GRAPH_HASH_TAG_NODE,
+                                         node_kind);
+  for (iree_host_size_t i = 0; i < access_count; ++i) {
+    accesses[i].node_ordinal = node_ordinal;
+    tracker->scope_accesses[tracker->scope_access_count++] = accesses[i];
+  }
+  return iree_ok_status();
+}
+
+void iree_hal_graph_dependency_tracker_insert_barrier(
+    iree_hal_graph_dependency_tracker_t* tracker) {
+  // An empty scope keeps depending on the prior barrier nodes.
+  if (tracker->scope_node_begin == tracker->node_count) return;
+
+  // The nodes in the scope transitively depend on the prior barrier nodes so
+  // they become the only dependencies of the next scope.
+  tracker->barrier_node_begin = tracker->scope_node_begin;
+  tracker->barrier_node_end = tracker->node_count;
+  tracker->scope_node_begin = tracker->node_count;
+  tracker->scope_access_count = 0;
+}
@@ -0,0 +1,124 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_GRAPH_DEPENDENCY_TRACKER_H_
+#define IREE_HAL_UTILS_GRAPH_DEPENDENCY_TRACKER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Opaque handle of a node in a backend graph (CUgraphNode, hipGraphNode_t).
+typedef void* iree_hal_graph_node_t;
+
+// Device memory range [begin, end) accessed by a graph node.
+typedef struct iree_hal_graph_access_t {
+  // Index of the node in recording order; assigned by the tracker.
+  iree_host_size_t node_ordinal;
+  uint64_t begin;
+  uint64_t end;
+  bool is_write;
+} iree_hal_graph_access_t;
+
+// Returns an access of |length| bytes of device memory starting at |begin|.
+static inline iree_hal_graph_access_t iree_hal_graph_make_access(
+    uint64_t begin, iree_device_size_t length, bool is_write) {
+  iree_hal_graph_access_t access;
+  access.node_ordinal = 0;
+  access.begin = begin;
+  access.end = begin + length;
+  access.is_write = is_write;
+  return access;
+}
+
+// Derives the edges of a graph as command buffers record their nodes.
+// Shared by the GPU HAL drivers that record command buffers into native
+// graphs; the drivers create the nodes with the dependencies produced here.
+//
+// Edges are derived from barriers: every node depends on all nodes added
+// before the most recent barrier that precedes it. Nodes within the same
+// barrier scope are independent and may execute concurrently unless they
+// access overlapping device memory with at least one write, in which case an
+// edge is added between them to preserve recording order.
+//
+// The node kinds and edges are hashed as they are recorded so that backends
+// can identify graphs with the same structure (and reuse their instantiations).
+typedef struct iree_hal_graph_dependency_tracker_t {
+  iree_allocator_t host_allocator;
+
+  // All nodes added in recording order.
+  iree_host_size_t node_count;
+  iree_host_size_t node_capacity;
+  iree_hal_graph_node_t* nodes;
+
+  // Nodes [barrier_node_begin, barrier_node_end) were added in the scope
+  // preceding the most recent barrier and new nodes depend on all of them.
+  iree_host_size_t barrier_node_begin;
+  iree_host_size_t barrier_node_end;
+
+  // Nodes [scope_node_begin, node_count) were added since the most recent
+  // barrier.
+  iree_host_size_t scope_node_begin;
+
+  // Memory accessed by the nodes added since the most recent barrier.
+  iree_host_size_t scope_access_count;
+  iree_host_size_t scope_access_capacity;
+  iree_hal_graph_access_t* scope_accesses;
+
+  // Scratch storage for the dependencies of the node being added.
+  iree_host_size_t dependency_capacity;
+  iree_hal_graph_node_t* dependencies;
+
+  // Hash of the kinds and edges of all nodes recorded so far.
+  uint64_t structure_hash;
+} iree_hal_graph_dependency_tracker_t;
+
+// Initializes an empty |out_tracker|.
+void iree_hal_graph_dependency_tracker_initialize(
+    iree_allocator_t host_allocator,
+    iree_hal_graph_dependency_tracker_t* out_tracker);
+
+// Releases all storage of |tracker|.
+void iree_hal_graph_dependency_tracker_deinitialize(
+    iree_hal_graph_dependency_tracker_t* tracker);
+
+// Forgets all recorded nodes so that a new graph can be recorded. Storage is
+// retained for reuse.
+void iree_hal_graph_dependency_tracker_reset(
+    iree_hal_graph_dependency_tracker_t* tracker);
+
+// Gathers the dependencies of a new node performing |accesses|: all nodes
+// before the most recent barrier and any node since then with a conflicting
+// access. The returned list has no duplicates and remains valid until the
+// next call on |tracker|.
+iree_status_t iree_hal_graph_dependency_tracker_gather(
+    iree_hal_graph_dependency_tracker_t* tracker,
+    iree_host_size_t access_count, const iree_hal_graph_access_t* accesses,
+    iree_host_size_t* out_dependency_count,
+    const iree_hal_graph_node_t** out_dependencies);
+
+// Records that |node| of |node_kind| was added to the current barrier scope
+// and performs |accesses|. |node_kind| distinguishes nodes that cannot be
+// updated into one another, such as kernel nodes of different functions.
+iree_status_t iree_hal_graph_dependency_tracker_append(
+    iree_hal_graph_dependency_tracker_t* tracker, iree_hal_graph_node_t node,
+    uint64_t node_kind, iree_host_size_t access_count,
+    iree_hal_graph_access_t* accesses);
+
+// Makes all nodes added after this point depend on all nodes added before.
+void iree_hal_graph_dependency_tracker_insert_barrier(
+    iree_hal_graph_dependency_tracker_t* tracker);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_GRAPH_DEPENDENCY_TRACKER_H_
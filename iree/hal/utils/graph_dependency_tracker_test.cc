@@ -0,0 +1,133 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/graph_dependency_tracker.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+class GraphDependencyTrackerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_hal_graph_dependency_tracker_initialize(iree_allocator_system(),
+                                                 &tracker_);
+  }
+
+  void TearDown() override {
+    iree_hal_graph_dependency_tracker_deinitialize(&tracker_);
+  }
+
+  // Adds a node performing |accesses| and returns its dependencies. Nodes are
+  // identified by their 1-based recording order.
+  std::vector<uintptr_t> AddNode(std::vector<iree_hal_graph_access_t> accesses,
+                                 uint64_t node_kind = 1) {
+    iree_host_size_t dependency_count = 0;
+    const iree_hal_graph_node_t* dependencies = NULL;
+    IREE_CHECK_OK(iree_hal_graph_dependency_tracker_gather(
+        &tracker_, accesses.size(), accesses.data(), &dependency_count,
+        &dependencies));
+    std::vector<uintptr_t> result;
+    for (iree_host_size_t i = 0; i < dependency_count; ++i) {
+      result.push_back((uintptr_t)dependencies[i]);
+    }
+    iree_hal_graph_node_t node =
+        (iree_hal_graph_node_t)(uintptr_t)(tracker_.node_count + 1);
+    IREE_CHECK_OK(iree_hal_graph_dependency_tracker_append(
+        &tracker_, node, node_kind, accesses.size(), accesses.data()));
+    return result;
+  }
+
+  void Barrier() {
+    iree_hal_graph_dependency_tracker_insert_barrier(&tracker_);
+  }
+
+  static iree_hal_graph_access_t Read(uint64_t begin, uint64_t length) {
+    return iree_hal_graph_make_access(begin, length, /*is_write=*/false);
+  }
+  static iree_hal_graph_access_t Write(uint64_t begin, uint64_t length) {
+    return iree_hal_graph_make_access(begin, length, /*is_write=*/true);
+  }
+
+  iree_hal_graph_dependency_tracker_t tracker_;
+};
+
+TEST_F(GraphDependencyTrackerTest, DisjointNodesAreIndependent) {
+  EXPECT_THAT(AddNode({Write(0, 16)}), IsEmpty());
+  EXPECT_THAT(AddNode({Write(16, 16)}), IsEmpty());
+  EXPECT_THAT(AddNode({Read(0, 16), Read(16, 16)}), ElementsAre(1, 2));
+}
+
+TEST_F(GraphDependencyTrackerTest, ReadsDoNotConflict) {
+  EXPECT_THAT(AddNode({Read(0, 16)}), IsEmpty());
+  EXPECT_THAT(AddNode({Read(0, 16)}), IsEmpty());
+  EXPECT_THAT(AddNode({Write(8, 4)}), ElementsAre(1, 2));
+}
+
+TEST_F(GraphDependencyTrackerTest, HazardsAreDeduplicated) {
+  EXPECT_THAT(AddNode({Write(0, 16), Write(32, 16)}), IsEmpty());
+  EXPECT_THAT(AddNode({Read(0, 64)}), ElementsAre(1));
+}
+
+TEST_F(GraphDependencyTrackerTest, BarrierOrdersScopes) {
+  EXPECT_THAT(AddNode({Write(0, 16)}), IsEmpty());
+  EXPECT_THAT(AddNode({Write(16, 16)}), IsEmpty());
+  Barrier();
+  // Every node in the next scope depends on the whole previous scope even
+  // without overlapping accesses.
+  EXPECT_THAT(AddNode({Write(64, 16)}), UnorderedElementsAre(1, 2));
+  EXPECT_THAT(AddNode({Write(96, 16)}), UnorderedElementsAre(1, 2));
+  Barrier();
+  // Only the nodes of the most recent scope are needed as the earlier ones are
+  // transitively ordered before them.
+  EXPECT_THAT(AddNode({Read(0, 16)}), UnorderedElementsAre(3, 4));
+}
+
+TEST_F(GraphDependencyTrackerTest, EmptyScopeKeepsPriorBarrier) {
+  EXPECT_THAT(AddNode({Write(0, 16)}), IsEmpty());
+  Barrier();
+  Barrier();
+  EXPECT_THAT(AddNode({Write(64, 16)}), ElementsAre(1));
+}
+
+TEST_F(GraphDependencyTrackerTest, StructureHash) {
+  AddNode({Write(0, 16)}, /*node_kind=*/7);
+  AddNode({Read(0, 16)}, /*node_kind=*/8);
+  uint64_t hash = tracker_.structure_hash;
+
+  // Different buffers with the same structure hash the same.
+  iree_hal_graph_dependency_tracker_reset(&tracker_);
+  AddNode({Write(1024, 16)}, /*node_kind=*/7);
+  AddNode({Read(1024, 16)}, /*node_kind=*/8);
+  EXPECT_EQ(tracker_.structure_hash, hash);
+
+  // Different edges hash differently.
+  iree_hal_graph_dependency_tracker_reset(&tracker_);
+  AddNode({Write(0, 16)}, /*node_kind=*/7);
+  AddNode({Read(64, 16)}, /*node_kind=*/8);
+  EXPECT_NE(tracker_.structure_hash, hash);
+
+  // Different node kinds hash differently.
+  iree_hal_graph_dependency_tracker_reset(&tracker_);
+  AddNode({Write(0, 16)}, /*node_kind=*/7);
+  AddNode({Read(0, 16)}, /*node_kind=*/9);
+  EXPECT_NE(tracker_.structure_hash, hash);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -0,0 +1,199 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/lazy_executable.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_lazy_executable_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+
+  // Cache used to prepare the executable on first resolve.
+  iree_hal_executable_cache_t* executable_cache;
+
+  // Captured spec with the format, data (unless aliased), and layouts stored
+  // in trailing storage.
+  iree_hal_executable_spec_t spec;
+
+  // Guards preparation so that it happens only once.
+  iree_slim_mutex_t mutex;
+
+  // Prepared iree_hal_executable_t* or 0 if not yet prepared. Written once
+  // under |mutex| and read without it.
+  iree_atomic_intptr_t prepared;
+} iree_hal_lazy_executable_t;
+
+static const iree_hal_executable_vtable_t iree_hal_lazy_executable_vtable;
+
+static iree_hal_lazy_executable_t* iree_hal_lazy_executable_cast(
+    iree_hal_executable_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_lazy_executable_vtable);
+  return (iree_hal_lazy_executable_t*)base_value;
+}
+
+iree_status_t iree_hal_lazy_executable_create(
+    iree_hal_executable_cache_t* executable_cache,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
+  IREE_ASSERT_ARGUMENT(executable_cache);
+  IREE_ASSERT_ARGUMENT(executable_spec);
+  IREE_ASSERT_ARGUMENT(out_executable);
+  *out_executable = NULL;
+
+  // Catch unsupported formats immediately as they would never resolve.
+  if (!iree_hal_executable_cache_can_prepare_format(
+          executable_cache, executable_spec->caching_mode,
+          executable_spec->executable_format)) {
+    return iree_make_status(IREE_STATUS_NOT_FOUND,
+                            "no executable loader registered for format '%.*s'",
+                            (int)executable_spec->executable_format.size,
+                            executable_spec->executable_format.data);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  const bool alias_data =
+      iree_all_bits_set(executable_spec->caching_mode,
+                        IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA);
+  const iree_host_size_t layouts_size =
+      executable_spec->executable_layout_count *
+      sizeof(executable_spec->executable_layouts[0]);
+  const iree_host_size_t format_size =
+      executable_spec->executable_format.size;
+  const iree_host_size_t data_size =
+      alias_data ? 0 : executable_spec->executable_data.data_length;
+  const iree_host_size_t total_size =
+      iree_host_align(sizeof(iree_hal_lazy_executable_t), iree_max_align_t) +
+      iree_host_align(data_size, iree_max_align_t) + layouts_size +
+      format_size;
+
+  iree_hal_lazy_executable_t* executable = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, total_size, (void**)&executable);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_lazy_executable_vtable,
+                                 &executable->resource);
+    executable->host_allocator = host_allocator;
+    executable->executable_cache = executable_cache;
+    iree_hal_executable_cache_retain(executable_cache);
+    iree_slim_mutex_initialize(&executable->mutex);
+    iree_atomic_store_intptr(&executable->prepared, 0,
+                             iree_memory_order_relaxed);
+
+    // Trailing storage: [data] [layouts] [format]. Data goes first so that it
+    // keeps the max alignment some loaders require.
+    uint8_t* storage_ptr =
+        (uint8_t*)executable +
+        iree_host_align(sizeof(iree_hal_lazy_executable_t), iree_max_align_t);
+    executable->spec = *executable_spec;
+    if (!alias_data) {
+      memcpy(storage_ptr, executable_spec->executable_data.data, data_size);
+      executable->spec.executable_data =
+          iree_make_const_byte_span(storage_ptr, data_size);
+      storage_ptr += iree_host_align(data_size, iree_max_align_t);
+    }
+    iree_hal_executable_layout_t** layouts =
+        (iree_hal_executable_layout_t**)storage_ptr;
+    for (iree_host_size_t i = 0; i < executable_spec->executable_layout_count;
+         ++i) {
+      layouts[i] = executable_spec->executable_layouts[i];
+      iree_hal_executable_layout_retain(layouts[i]);
+    }
+    executable->spec.executable_layouts = layouts;
+    storage_ptr += layouts_size;
+    memcpy(storage_ptr, executable_spec->executable_format.data, format_size);
+    executable->spec.executable_format =
+        iree_make_string_view((const char*)storage_ptr, format_size);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_executable = (iree_hal_executable_t*)executable;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_lazy_executable_destroy(
+    iree_hal_executable_t* base_executable) {
+  iree_hal_lazy_executable_t* executable =
+      iree_hal_lazy_executable_cast(base_executable);
+  iree_allocator_t host_allocator = executable->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_executable_release((iree_hal_executable_t*)iree_atomic_load_intptr(
+      &executable->prepared, iree_memory_order_acquire));
+  for (iree_host_size_t i = 0; i < executable->spec.executable_layout_count;
+       ++i) {
+    iree_hal_executable_layout_release(executable->spec.executable_layouts[i]);
+  }
+  iree_hal_executable_cache_release(executable->executable_cache);
+  iree_slim_mutex_deinitialize(&executable->mutex);
+  iree_allocator_free(host_allocator, executable);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+bool iree_hal_lazy_executable_isa(iree_hal_executable_t* executable) {
+  return iree_hal_resource_is(executable, &iree_hal_lazy_executable_vtable);
+}
+
+bool iree_hal_lazy_executable_is_prepared(iree_hal_executable_t* executable) {
+  if (!iree_hal_lazy_executable_isa(executable)) return true;
+  iree_hal_lazy_executable_t* lazy_executable =
+      iree_hal_lazy_executable_cast(executable);
+  return iree_atomic_load_intptr(&lazy_executable->prepared,
+                                 iree_memory_order_acquire) != 0;
+}
+
+iree_status_t iree_hal_lazy_executable_resolve(
+    iree_hal_executable_t* executable,
+    iree_hal_executable_t** out_prepared_executable) {
+  IREE_ASSERT_ARGUMENT(out_prepared_executable);
+  if (!iree_hal_lazy_executable_isa(executable)) {
+    *out_prepared_executable = executable;
+    return iree_ok_status();
+  }
+  iree_hal_lazy_executable_t* lazy_executable =
+      iree_hal_lazy_executable_cast(executable);
+
+  // Fast path: already prepared.
+  iree_hal_executable_t* prepared =
+      (iree_hal_executable_t*)iree_atomic_load_intptr(
+          &lazy_executable->prepared, iree_memory_order_acquire);
+  if (IREE_LIKELY(prepared)) {
+    *out_prepared_executable = prepared;
+    return iree_ok_status();
+  }
+
+  // Slow path: prepare under the lock unless another thread beat us to it.
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&lazy_executable->mutex);
+  prepared = (iree_hal_executable_t*)iree_atomic_load_intptr(
+      &lazy_executable->prepared, iree_memory_order_acquire);
+  if (!prepared) {
+    status = iree_hal_executable_cache_prepare_executable(
+        lazy_executable->executable_cache, &lazy_executable->spec, &prepared);
+    if (iree_status_is_ok(status)) {
+      iree_atomic_store_intptr(&lazy_executable->prepared, (intptr_t)prepared,
+                               iree_memory_order_release);
+    }
+  }
+  iree_slim_mutex_unlock(&lazy_executable->mutex);
+  *out_prepared_executable = iree_status_is_ok(status) ? prepared : NULL;
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static const iree_hal_executable_vtable_t iree_hal_lazy_executable_vtable = {
+    .destroy = iree_hal_lazy_executable_destroy,
+};
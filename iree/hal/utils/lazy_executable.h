@@ -0,0 +1,56 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_LAZY_EXECUTABLE_H_
+#define IREE_HAL_UTILS_LAZY_EXECUTABLE_H_
+
+#include <stdbool.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates an executable that defers preparation with |executable_cache| until
+// it is first resolved with iree_hal_lazy_executable_resolve. Only the format
+// is checked up front; any other preparation errors are reported on resolve.
+//
+// The spec is captured: executable data is copied unless the caching mode has
+// IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA set, in which case the
+// caller must keep it valid for the lifetime of the lazy executable, and the
+// executable layouts are retained.
+//
+// Lazy executables are placeholders and cannot be passed directly to command
+// buffers; callers must resolve them to the prepared executable first.
+iree_status_t iree_hal_lazy_executable_create(
+    iree_hal_executable_cache_t* executable_cache,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable);
+
+// Returns true if |executable| is a lazy executable.
+bool iree_hal_lazy_executable_isa(iree_hal_executable_t* executable);
+
+// Returns true if |executable| is not lazy or has already been prepared.
+bool iree_hal_lazy_executable_is_prepared(iree_hal_executable_t* executable);
+
+// Resolves |executable| to the prepared executable, preparing it on first use.
+// Non-lazy executables are returned as-is. The returned executable is owned by
+// |executable| and is not retained for the caller.
+//
+// Thread-safe: concurrent resolves of the same executable prepare it once and
+// resolves after the first are a single atomic load. Preparation failures are
+// not memoized and preparation will be retried on the next resolve.
+iree_status_t iree_hal_lazy_executable_resolve(
+    iree_hal_executable_t* executable,
+    iree_hal_executable_t** out_prepared_executable);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_LAZY_EXECUTABLE_H_
@@ -0,0 +1,178 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/lazy_executable.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+// Executable returned by the fake cache; holds a copy of the spec data.
+struct FakeExecutable {
+  iree_hal_resource_t resource;
+  std::string data;
+
+  static void Destroy(iree_hal_executable_t* base_executable) {
+    delete reinterpret_cast<FakeExecutable*>(base_executable);
+  }
+};
+
+const iree_hal_executable_vtable_t kFakeExecutableVTable = {
+    FakeExecutable::Destroy,
+};
+
+// Executable cache counting the number of preparations. Preparation fails
+// while |fail| is set.
+struct FakeExecutableCache {
+  iree_hal_resource_t resource;
+  int prepare_count = 0;
+  bool fail = false;
+
+  static FakeExecutableCache* Cast(iree_hal_executable_cache_t* base_cache) {
+    return reinterpret_cast<FakeExecutableCache*>(base_cache);
+  }
+
+  static void Destroy(iree_hal_executable_cache_t* base_cache) {}
+
+  static bool CanPrepareFormat(iree_hal_executable_cache_t* base_cache,
+                               iree_hal_executable_caching_mode_t caching_mode,
+                               iree_string_view_t executable_format) {
+    return iree_string_view_equal(executable_format, IREE_SV("fake"));
+  }
+
+  static iree_status_t PrepareExecutable(
+      iree_hal_executable_cache_t* base_cache,
+      const iree_hal_executable_spec_t* executable_spec,
+      iree_hal_executable_t** out_executable) {
+    FakeExecutableCache* cache = Cast(base_cache);
+    ++cache->prepare_count;
+    if (cache->fail) {
+      return iree_make_status(IREE_STATUS_UNAVAILABLE, "injected failure");
+    }
+    auto* executable = new FakeExecutable();
+    iree_hal_resource_initialize(&kFakeExecutableVTable, &executable->resource);
+    executable->data.assign(
+        reinterpret_cast<const char*>(executable_spec->executable_data.data),
+        executable_spec->executable_data.data_length);
+    *out_executable = reinterpret_cast<iree_hal_executable_t*>(executable);
+    return iree_ok_status();
+  }
+};
+
+const iree_hal_executable_cache_vtable_t kFakeExecutableCacheVTable = {
+    FakeExecutableCache::Destroy,
+    FakeExecutableCache::CanPrepareFormat,
+    FakeExecutableCache::PrepareExecutable,
+};
+
+class LazyExecutableTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_hal_resource_initialize(&kFakeExecutableCacheVTable,
+                                 &fake_cache_.resource);
+  }
+
+  iree_hal_executable_cache_t* cache() {
+    return reinterpret_cast<iree_hal_executable_cache_t*>(&fake_cache_);
+  }
+
+  iree_hal_executable_spec_t MakeSpec(const char* format, const char* data) {
+    iree_hal_executable_spec_t spec;
+    iree_hal_executable_spec_initialize(&spec);
+    spec.executable_format = iree_make_cstring_view(format);
+    spec.executable_data = iree_make_const_byte_span(data, strlen(data));
+    return spec;
+  }
+
+  FakeExecutableCache fake_cache_;
+};
+
+TEST_F(LazyExecutableTest, PreparesOnceOnFirstResolve) {
+  char data[] = "kernel";
+  iree_hal_executable_spec_t spec = MakeSpec("fake", data);
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(iree_hal_lazy_executable_create(
+      cache(), &spec, iree_allocator_system(), &executable));
+  EXPECT_TRUE(iree_hal_lazy_executable_isa(executable));
+  EXPECT_FALSE(iree_hal_lazy_executable_is_prepared(executable));
+  EXPECT_EQ(fake_cache_.prepare_count, 0);
+
+  // The data is copied as the spec did not allow aliasing.
+  data[0] = 'X';
+
+  iree_hal_executable_t* prepared = NULL;
+  IREE_ASSERT_OK(iree_hal_lazy_executable_resolve(executable, &prepared));
+  ASSERT_NE(prepared, nullptr);
+  EXPECT_NE(prepared, executable);
+  EXPECT_FALSE(iree_hal_lazy_executable_isa(prepared));
+  EXPECT_EQ(reinterpret_cast<FakeExecutable*>(prepared)->data, "kernel");
+  EXPECT_TRUE(iree_hal_lazy_executable_is_prepared(executable));
+
+  iree_hal_executable_t* prepared_again = NULL;
+  IREE_ASSERT_OK(iree_hal_lazy_executable_resolve(executable, &prepared_again));
+  EXPECT_EQ(prepared_again, prepared);
+  EXPECT_EQ(fake_cache_.prepare_count, 1);
+
+  iree_hal_executable_release(executable);
+}
+
+TEST_F(LazyExecutableTest, RetriesAfterFailure) {
+  iree_hal_executable_spec_t spec = MakeSpec("fake", "kernel");
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(iree_hal_lazy_executable_create(
+      cache(), &spec, iree_allocator_system(), &executable));
+
+  fake_cache_.fail = true;
+  iree_hal_executable_t* prepared = NULL;
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_UNAVAILABLE,
+                        iree_hal_lazy_executable_resolve(executable, &prepared));
+  EXPECT_EQ(prepared, nullptr);
+  EXPECT_FALSE(iree_hal_lazy_executable_is_prepared(executable));
+
+  fake_cache_.fail = false;
+  IREE_ASSERT_OK(iree_hal_lazy_executable_resolve(executable, &prepared));
+  EXPECT_NE(prepared, nullptr);
+  EXPECT_EQ(fake_cache_.prepare_count, 2);
+
+  iree_hal_executable_release(executable);
+}
+
+TEST_F(LazyExecutableTest, UnsupportedFormatFailsOnCreate) {
+  iree_hal_executable_spec_t spec = MakeSpec("other", "kernel");
+  iree_hal_executable_t* executable = NULL;
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_NOT_FOUND,
+                        iree_hal_lazy_executable_create(
+                            cache(), &spec, iree_allocator_system(),
+                            &executable));
+  EXPECT_EQ(executable, nullptr);
+  EXPECT_EQ(fake_cache_.prepare_count, 0);
+}
+
+TEST_F(LazyExecutableTest, NonLazyResolvesToItself) {
+  iree_hal_executable_spec_t spec = MakeSpec("fake", "kernel");
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_prepare_executable(cache(), &spec,
+                                                              &executable));
+  EXPECT_FALSE(iree_hal_lazy_executable_isa(executable));
+  EXPECT_TRUE(iree_hal_lazy_executable_is_prepared(executable));
+  iree_hal_executable_t* resolved = NULL;
+  IREE_ASSERT_OK(iree_hal_lazy_executable_resolve(executable, &resolved));
+  EXPECT_EQ(resolved, executable);
+  iree_hal_executable_release(executable);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -0,0 +1,428 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/memory_timeline.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+// Initial capacity of the live allocation table; must be a power of two.
+#define IREE_HAL_MEMORY_TIMELINE_INITIAL_CAPACITY 256
+
+// A live allocation.
+typedef struct iree_hal_memory_timeline_entry_t {
+  // Profiler event id of the allocation; 0 indicates an empty slot.
+  uint64_t id;
+  iree_device_size_t size;
+  // Index into the timeline sources the allocation is attributed to.
+  iree_host_size_t source_index;
+} iree_hal_memory_timeline_entry_t;
+
+struct iree_hal_memory_timeline_t {
+  iree_allocator_t host_allocator;
+  iree_profiler_t profiler;
+  const iree_profiler_t* next_profiler;
+  iree_time_t base_time_ns;
+
+  // Guards all state below.
+  iree_slim_mutex_t mutex;
+  // Open-addressed table of live allocations keyed by id using linear probing.
+  // Capacity is a power of two and kept at most half full.
+  iree_hal_memory_timeline_entry_t* entries;
+  iree_host_size_t entry_capacity;
+  iree_host_size_t entry_count;
+  // Sources in the order they were first seen; names are owned by the
+  // timeline.
+  iree_hal_memory_timeline_source_t* sources;
+  iree_host_size_t source_capacity;
+  iree_hal_memory_timeline_statistics_t statistics;
+};
+
+static iree_host_size_t iree_hal_memory_timeline_hash(
+    const iree_hal_memory_timeline_t* timeline, uint64_t id) {
+  // Ids are usually pointers and need their low bits mixed in.
+  uint64_t hash = id * 0x9E3779B97F4A7C15ull;
+  hash ^= hash >> 32;
+  return (iree_host_size_t)hash & (timeline->entry_capacity - 1);
+}
+
+// Returns the slot of |id| or the empty slot it would be inserted in.
+static iree_host_size_t iree_hal_memory_timeline_find_slot(
+    const iree_hal_memory_timeline_t* timeline, uint64_t id) {
+  const iree_host_size_t mask = timeline->entry_capacity - 1;
+  iree_host_size_t slot = iree_hal_memory_timeline_hash(timeline, id);
+  while (timeline->entries[slot].id && timeline->entries[slot].id != id) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+// Grows the live allocation table so that another entry can be inserted
+// without exceeding the load factor.
+static iree_status_t iree_hal_memory_timeline_reserve_entry(
+    iree_hal_memory_timeline_t* timeline) {
+  if ((timeline->entry_count + 1) * 2 <= timeline->entry_capacity) {
+    return iree_ok_status();
+  }
+  iree_host_size_t new_capacity =
+      timeline->entry_capacity ? timeline->entry_capacity * 2
+                               : IREE_HAL_MEMORY_TIMELINE_INITIAL_CAPACITY;
+  iree_hal_memory_timeline_entry_t* new_entries = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      timeline->host_allocator, new_capacity * sizeof(*new_entries),
+      (void**)&new_entries));
+  memset(new_entries, 0, new_capacity * sizeof(*new_entries));
+
+  iree_hal_memory_timeline_entry_t* old_entries = timeline->entries;
+  iree_host_size_t old_capacity = timeline->entry_capacity;
+  timeline->entries = new_entries;
+  timeline->entry_capacity = new_capacity;
+  for (iree_host_size_t i = 0; i < old_capacity; ++i) {
+    if (!old_entries[i].id) continue;
+    iree_host_size_t slot =
+        iree_hal_memory_timeline_find_slot(timeline, old_entries[i].id);
+    timeline->entries[slot] = old_entries[i];
+  }
+  iree_allocator_free(timeline->host_allocator, old_entries);
+  return iree_ok_status();
+}
+
+// Removes the entry in |slot| and shifts back any entries that probed past it
+// so that lookups never need tombstones.
+static void iree_hal_memory_timeline_remove_slot(
+    iree_hal_memory_timeline_t* timeline, iree_host_size_t slot) {
+  const iree_host_size_t mask = timeline->entry_capacity - 1;
+  iree_host_size_t hole = slot;
+  iree_host_size_t next = slot;
+  while (true) {
+    next = (next + 1) & mask;
+    if (!timeline->entries[next].id) break;
+    iree_host_size_t home =
+        iree_hal_memory_timeline_hash(timeline, timeline->entries[next].id);
+    // The entry may fill the hole if its home slot is not cyclically within
+    // (hole, next].
+    bool home_in_range = hole <= next ? (home > hole && home <= next)
+                                      : (home > hole || home <= next);
+    if (!home_in_range) {
+      timeline->entries[hole] = timeline->entries[next];
+      hole = next;
+    }
+  }
+  timeline->entries[hole].id = 0;
+  --timeline->entry_count;
+}
+
+// Returns the index of the source with |name|, adding it if needed.
+static iree_status_t iree_hal_memory_timeline_intern_source(
+    iree_hal_memory_timeline_t* timeline, iree_string_view_t name,
+    iree_host_size_t* out_index) {
+  const iree_host_size_t source_count = timeline->statistics.source_count;
+  for (iree_host_size_t i = 0; i < source_count; ++i) {
+    if (iree_string_view_equal(timeline->sources[i].name, name)) {
+      *out_index = i;
+      return iree_ok_status();
+    }
+  }
+
+  if (source_count == timeline->source_capacity) {
+    iree_host_size_t new_capacity =
+        iree_max(16, timeline->source_capacity * 2);
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        timeline->host_allocator, new_capacity * sizeof(*timeline->sources),
+        (void**)&timeline->sources));
+    timeline->source_capacity = new_capacity;
+  }
+
+  // Names are only valid for the duration of the event and must be copied.
+  char* name_storage = NULL;
+  if (name.size) {
+    IREE_RETURN_IF_ERROR(iree_allocator_clone(
+        timeline->host_allocator,
+        iree_make_const_byte_span(name.data, name.size),
+        (void**)&name_storage));
+  }
+  iree_hal_memory_timeline_source_t* source = &timeline->sources[source_count];
+  memset(source, 0, sizeof(*source));
+  source->name = iree_make_string_view(name_storage, name.size);
+  *out_index = timeline->statistics.source_count++;
+  return iree_ok_status();
+}
+
+static void iree_hal_memory_timeline_free_entry(
+    iree_hal_memory_timeline_t* timeline, iree_host_size_t slot) {
+  iree_hal_memory_timeline_entry_t* entry = &timeline->entries[slot];
+  timeline->sources[entry->source_index].live_bytes -= entry->size;
+  timeline->statistics.live_bytes -= entry->size;
+  ++timeline->statistics.free_count;
+  iree_hal_memory_timeline_remove_slot(timeline, slot);
+}
+
+static iree_status_t iree_hal_memory_timeline_allocate_entry(
+    iree_hal_memory_timeline_t* timeline, const iree_profiler_event_t* event) {
+  // An allocation reusing a live id means the free was missed (such as when
+  // the profiler was registered while the buffer was live).
+  if (timeline->entry_capacity) {
+    iree_host_size_t slot =
+        iree_hal_memory_timeline_find_slot(timeline, event->id);
+    if (timeline->entries[slot].id) {
+      iree_hal_memory_timeline_free_entry(timeline, slot);
+    }
+  }
+
+  iree_host_size_t source_index = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_memory_timeline_intern_source(
+      timeline, event->name, &source_index));
+  IREE_RETURN_IF_ERROR(iree_hal_memory_timeline_reserve_entry(timeline));
+
+  iree_device_size_t size = (iree_device_size_t)event->value;
+  iree_host_size_t slot =
+      iree_hal_memory_timeline_find_slot(timeline, event->id);
+  timeline->entries[slot].id = event->id;
+  timeline->entries[slot].size = size;
+  timeline->entries[slot].source_index = source_index;
+  ++timeline->entry_count;
+
+  iree_hal_memory_timeline_source_t* source = &timeline->sources[source_index];
+  source->memory_types |= (iree_hal_memory_type_t)event->flags;
+  ++source->allocation_count;
+  source->allocated_bytes += size;
+  source->live_bytes += size;
+  source->peak_live_bytes =
+      iree_max(source->peak_live_bytes, source->live_bytes);
+
+  iree_hal_memory_timeline_statistics_t* statistics = &timeline->statistics;
+  ++statistics->allocation_count;
+  statistics->live_bytes += size;
+  if (statistics->live_bytes > statistics->peak_live_bytes) {
+    statistics->peak_live_bytes = statistics->live_bytes;
+    statistics->peak_time_ns = event->timestamp_ns - timeline->base_time_ns;
+  }
+  return iree_ok_status();
+}
+
+static void iree_hal_memory_timeline_record(
+    void* user_data, const iree_profiler_event_t* event) {
+  iree_hal_memory_timeline_t* timeline = (iree_hal_memory_timeline_t*)user_data;
+  if (event->type == IREE_PROFILER_EVENT_TYPE_ALLOCATE) {
+    iree_slim_mutex_lock(&timeline->mutex);
+    iree_status_t status =
+        iree_hal_memory_timeline_allocate_entry(timeline, event);
+    if (!iree_status_is_ok(status)) {
+      // Events cannot fail; note that the statistics are incomplete instead.
+      iree_status_ignore(status);
+      ++timeline->statistics.dropped_count;
+    }
+    iree_slim_mutex_unlock(&timeline->mutex);
+  } else if (event->type == IREE_PROFILER_EVENT_TYPE_FREE) {
+    iree_slim_mutex_lock(&timeline->mutex);
+    if (timeline->entry_capacity) {
+      iree_host_size_t slot =
+          iree_hal_memory_timeline_find_slot(timeline, event->id);
+      if (timeline->entries[slot].id) {
+        iree_hal_memory_timeline_free_entry(timeline, slot);
+      }
+    }
+    iree_slim_mutex_unlock(&timeline->mutex);
+  }
+
+  const iree_profiler_t* next_profiler = timeline->next_profiler;
+  if (next_profiler && next_profiler->fn &&
+      (next_profiler->event_mask & (1u << event->type))) {
+    next_profiler->fn(next_profiler->user_data, event);
+  }
+}
+
+iree_status_t iree_hal_memory_timeline_create(
+    const iree_profiler_t* next_profiler, iree_allocator_t host_allocator,
+    iree_hal_memory_timeline_t** out_timeline) {
+  IREE_ASSERT_ARGUMENT(out_timeline);
+  *out_timeline = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_memory_timeline_t* timeline = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*timeline),
+                                (void**)&timeline));
+  memset(timeline, 0, sizeof(*timeline));
+  timeline->host_allocator = host_allocator;
+  timeline->profiler.fn = iree_hal_memory_timeline_record;
+  timeline->profiler.user_data = timeline;
+  timeline->profiler.event_mask = IREE_PROFILER_EVENT_MASK_ALLOCATION;
+  if (next_profiler && next_profiler->fn) {
+    timeline->next_profiler = next_profiler;
+    timeline->profiler.event_mask |= next_profiler->event_mask;
+  }
+  timeline->base_time_ns = iree_time_now();
+  iree_slim_mutex_initialize(&timeline->mutex);
+
+  *out_timeline = timeline;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_hal_memory_timeline_free(iree_hal_memory_timeline_t* timeline) {
+  if (!timeline) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator = timeline->host_allocator;
+
+  if (iree_profiler_get() == &timeline->profiler) {
+    iree_profiler_set(NULL);
+  }
+
+  for (iree_host_size_t i = 0; i < timeline->statistics.source_count; ++i) {
+    iree_allocator_free(host_allocator, (void*)timeline->sources[i].name.data);
+  }
+  iree_allocator_free(host_allocator, timeline->sources);
+  iree_allocator_free(host_allocator, timeline->entries);
+  iree_slim_mutex_deinitialize(&timeline->mutex);
+  iree_allocator_free(host_allocator, timeline);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+const iree_profiler_t* iree_hal_memory_timeline_profiler(
+    iree_hal_memory_timeline_t* timeline) {
+  IREE_ASSERT_ARGUMENT(timeline);
+  return &timeline->profiler;
+}
+
+void iree_hal_memory_timeline_query_statistics(
+    iree_hal_memory_timeline_t* timeline,
+    iree_hal_memory_timeline_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(timeline);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  iree_slim_mutex_lock(&timeline->mutex);
+  *out_statistics = timeline->statistics;
+  iree_slim_mutex_unlock(&timeline->mutex);
+}
+
+bool iree_hal_memory_timeline_lookup_source(
+    iree_hal_memory_timeline_t* timeline, iree_string_view_t name,
+    iree_hal_memory_timeline_source_t* out_source) {
+  IREE_ASSERT_ARGUMENT(timeline);
+  IREE_ASSERT_ARGUMENT(out_source);
+  bool found = false;
+  iree_slim_mutex_lock(&timeline->mutex);
+  for (iree_host_size_t i = 0; i < timeline->statistics.source_count; ++i) {
+    if (iree_string_view_equal(timeline->sources[i].name, name)) {
+      *out_source = timeline->sources[i];
+      found = true;
+      break;
+    }
+  }
+  iree_slim_mutex_unlock(&timeline->mutex);
+  return found;
+}
+
+static int iree_hal_memory_timeline_compare_sources(const void* lhs_ptr,
+                                                    const void* rhs_ptr) {
+  const iree_hal_memory_timeline_source_t* lhs =
+      (const iree_hal_memory_timeline_source_t*)lhs_ptr;
+  const iree_hal_memory_timeline_source_t* rhs =
+      (const iree_hal_memory_timeline_source_t*)rhs_ptr;
+  if (lhs->peak_live_bytes != rhs->peak_live_bytes) {
+    return lhs->peak_live_bytes > rhs->peak_live_bytes ? -1 : 1;
+  }
+  if (lhs->allocated_bytes != rhs->allocated_bytes) {
+    return lhs->allocated_bytes > rhs->allocated_bytes ? -1 : 1;
+  }
+  return 0;
+}
+
+static iree_status_t iree_hal_memory_timeline_format(
+    const iree_hal_memory_timeline_statistics_t* statistics,
+    const iree_hal_memory_timeline_source_t* sources,
+    iree_host_size_t max_source_count, iree_string_builder_t* builder) {
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder,
+      "  PEAK: %12" PRIdsz "B at %.3fms / %12" PRIdsz "B live / %" PRIu64
+      " allocations / %" PRIu64 " frees\n",
+      statistics->peak_live_bytes, statistics->peak_time_ns / 1000000.0,
+      statistics->live_bytes, statistics->allocation_count,
+      statistics->free_count));
+  if (statistics->dropped_count) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "  WARNING: %" PRIu64 " allocations could not be tracked\n",
+        statistics->dropped_count));
+  }
+
+  iree_host_size_t source_count =
+      iree_min(max_source_count, statistics->source_count);
+  if (!source_count) return iree_ok_status();
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder, "  TOP %" PRIhsz " OF %" PRIhsz " SOURCES BY PEAK:\n",
+      source_count, statistics->source_count));
+  for (iree_host_size_t i = 0; i < source_count; ++i) {
+    const iree_hal_memory_timeline_source_t* source = &sources[i];
+    iree_bitfield_string_temp_t temp;
+    iree_string_view_t memory_types =
+        iree_hal_memory_type_format(source->memory_types, &temp);
+    iree_string_view_t name = iree_string_view_is_empty(source->name)
+                                  ? IREE_SV("(unattributed)")
+                                  : source->name;
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder,
+        "    %12" PRIdsz "B peak / %12" PRIdsz "B allocated / %8" PRIu64
+        " allocations / %12" PRIdsz "B live: %.*s (%.*s)\n",
+        source->peak_live_bytes, source->allocated_bytes,
+        source->allocation_count, source->live_bytes, (int)name.size,
+        name.data, (int)memory_types.size, memory_types.data));
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_memory_timeline_fprint(
+    FILE* file, iree_hal_memory_timeline_t* timeline,
+    iree_host_size_t max_source_count) {
+  IREE_ASSERT_ARGUMENT(file);
+  IREE_ASSERT_ARGUMENT(timeline);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Snapshot the sources so that they can be sorted and formatted without
+  // blocking recording. Source names remain valid until the timeline is freed.
+  iree_hal_memory_timeline_statistics_t statistics;
+  iree_hal_memory_timeline_source_t* sources = NULL;
+  iree_slim_mutex_lock(&timeline->mutex);
+  statistics = timeline->statistics;
+  iree_status_t status = iree_ok_status();
+  if (statistics.source_count) {
+    status = iree_allocator_clone(
+        timeline->host_allocator,
+        iree_make_const_byte_span(
+            timeline->sources,
+            statistics.source_count * sizeof(*timeline->sources)),
+        (void**)&sources);
+  }
+  iree_slim_mutex_unlock(&timeline->mutex);
+
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(timeline->host_allocator, &builder);
+  if (iree_status_is_ok(status)) {
+    if (sources) {
+      qsort(sources, statistics.source_count, sizeof(*sources),
+            iree_hal_memory_timeline_compare_sources);
+    }
+    status = iree_string_builder_append_cstring(
+        &builder, "[[ iree_hal_memory_timeline_t memory usage ]]\n");
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_memory_timeline_format(&statistics, sources,
+                                             max_source_count, &builder);
+  }
+  if (iree_status_is_ok(status)) {
+    fprintf(file, "%.*s", (int)iree_string_builder_size(&builder),
+            iree_string_builder_buffer(&builder));
+  }
+  iree_string_builder_deinitialize(&builder);
+  iree_allocator_free(timeline->host_allocator, sources);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
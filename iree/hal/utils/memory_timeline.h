@@ -0,0 +1,103 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_MEMORY_TIMELINE_H_
+#define IREE_HAL_UTILS_MEMORY_TIMELINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "iree/base/api.h"
+#include "iree/base/profiler.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Memory usage of all allocations attributed to a single source.
+typedef struct iree_hal_memory_timeline_source_t {
+  // Name of the source as reported with the allocation events (usually the VM
+  // function that made the allocations). Empty for unattributed allocations.
+  iree_string_view_t name;
+  // Union of the memory types of all allocations made by the source.
+  iree_hal_memory_type_t memory_types;
+  // Total number of allocations made.
+  uint64_t allocation_count;
+  // Total size in bytes of all allocations made.
+  iree_device_size_t allocated_bytes;
+  // Size in bytes of allocations that have not yet been freed.
+  iree_device_size_t live_bytes;
+  // Highest |live_bytes| observed.
+  iree_device_size_t peak_live_bytes;
+} iree_hal_memory_timeline_source_t;
+
+// Memory usage across all sources.
+typedef struct iree_hal_memory_timeline_statistics_t {
+  // Total number of allocations and frees observed. Frees of buffers whose
+  // allocation was not observed (such as imported buffers) are not counted.
+  uint64_t allocation_count;
+  uint64_t free_count;
+  // Size in bytes of allocations that have not yet been freed.
+  iree_device_size_t live_bytes;
+  // Highest |live_bytes| observed and when it was first reached relative to
+  // the creation of the timeline.
+  iree_device_size_t peak_live_bytes;
+  iree_duration_t peak_time_ns;
+  // Number of distinct allocation sources.
+  iree_host_size_t source_count;
+  // Number of allocations that could not be tracked due to host allocation
+  // failures. Non-zero values indicate the statistics are incomplete.
+  uint64_t dropped_count;
+} iree_hal_memory_timeline_statistics_t;
+
+// Tracks live device memory over time from the allocation events reported to
+// iree/base/profiler.h by HAL allocators.
+//
+// The timeline is itself a profiler that must be registered with
+// iree_profiler_set. Since only one profiler may be registered at a time all
+// events are forwarded to an optional |next_profiler| (such as a file sink) so
+// that the timeline can be used alongside other profiling.
+//
+// Thread-safe; events may be recorded from any thread.
+typedef struct iree_hal_memory_timeline_t iree_hal_memory_timeline_t;
+
+// Creates a memory timeline forwarding events to |next_profiler|, if not NULL.
+// |next_profiler| must remain valid for the lifetime of the timeline.
+iree_status_t iree_hal_memory_timeline_create(
+    const iree_profiler_t* next_profiler, iree_allocator_t host_allocator,
+    iree_hal_memory_timeline_t** out_timeline);
+
+// Frees |timeline|, unregistering it first if it is the current profiler.
+void iree_hal_memory_timeline_free(iree_hal_memory_timeline_t* timeline);
+
+// Returns the profiler to register with iree_profiler_set to record events.
+const iree_profiler_t* iree_hal_memory_timeline_profiler(
+    iree_hal_memory_timeline_t* timeline);
+
+// Queries the current statistics across all sources of |timeline|.
+void iree_hal_memory_timeline_query_statistics(
+    iree_hal_memory_timeline_t* timeline,
+    iree_hal_memory_timeline_statistics_t* out_statistics);
+
+// Queries the current usage of the source with |name|.
+// Returns false if no allocations have been attributed to the source.
+bool iree_hal_memory_timeline_lookup_source(
+    iree_hal_memory_timeline_t* timeline, iree_string_view_t name,
+    iree_hal_memory_timeline_source_t* out_source);
+
+// Prints a summary of |timeline| to |file| including the overall peak memory
+// usage and up to |max_source_count| sources ordered by their peak usage.
+iree_status_t iree_hal_memory_timeline_fprint(
+    FILE* file, iree_hal_memory_timeline_t* timeline,
+    iree_host_size_t max_source_count);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_MEMORY_TIMELINE_H_
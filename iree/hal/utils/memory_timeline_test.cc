@@ -0,0 +1,169 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/memory_timeline.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+#if IREE_PROFILER_ENABLE
+
+class MemoryTimelineTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_memory_timeline_create(
+        /*next_profiler=*/NULL, iree_allocator_system(), &timeline_));
+    iree_profiler_set(iree_hal_memory_timeline_profiler(timeline_));
+  }
+
+  void TearDown() override {
+    iree_hal_memory_timeline_free(timeline_);
+    EXPECT_EQ(iree_profiler_get(), nullptr);
+  }
+
+  static void Allocate(uint64_t id, iree_device_size_t size,
+                       iree_string_view_t source,
+                       iree_hal_memory_type_t memory_type) {
+    iree_profiler_event_t event;
+    event.type = IREE_PROFILER_EVENT_TYPE_ALLOCATE;
+    event.timestamp_ns = 0;
+    event.id = id;
+    event.name = iree_string_view_empty();
+    event.value = size;
+    event.flags = memory_type;
+    iree_string_view_t previous_source =
+        iree_profiler_set_thread_source(source);
+    iree_profiler_record_event(event);
+    iree_profiler_set_thread_source(previous_source);
+  }
+
+  static void Free(uint64_t id) {
+    iree_profiler_record(IREE_PROFILER_EVENT_TYPE_FREE, id,
+                         iree_string_view_empty(), 0);
+  }
+
+  iree_hal_memory_timeline_statistics_t QueryStatistics() {
+    iree_hal_memory_timeline_statistics_t statistics;
+    iree_hal_memory_timeline_query_statistics(timeline_, &statistics);
+    return statistics;
+  }
+
+  iree_hal_memory_timeline_t* timeline_ = NULL;
+};
+
+TEST_F(MemoryTimelineTest, Empty) {
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(statistics.allocation_count, 0);
+  EXPECT_EQ(statistics.peak_live_bytes, 0);
+  EXPECT_EQ(statistics.source_count, 0);
+  IREE_EXPECT_OK(iree_hal_memory_timeline_fprint(stdout, timeline_, 10));
+}
+
+TEST_F(MemoryTimelineTest, TracksPeakAcrossSources) {
+  Allocate(0x100, 1000, IREE_SV("main"), IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL);
+  Allocate(0x200, 500, IREE_SV("conv"), IREE_HAL_MEMORY_TYPE_HOST_VISIBLE);
+  Free(0x100);
+  Allocate(0x300, 200, IREE_SV("main"), IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL);
+  // Frees of untracked buffers (such as imported ones) are ignored.
+  Free(0x400);
+
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(statistics.allocation_count, 3);
+  EXPECT_EQ(statistics.free_count, 1);
+  EXPECT_EQ(statistics.live_bytes, 700);
+  EXPECT_EQ(statistics.peak_live_bytes, 1500);
+  EXPECT_EQ(statistics.source_count, 2);
+  EXPECT_EQ(statistics.dropped_count, 0);
+
+  iree_hal_memory_timeline_source_t source;
+  ASSERT_TRUE(iree_hal_memory_timeline_lookup_source(
+      timeline_, IREE_SV("main"), &source));
+  EXPECT_EQ(source.allocation_count, 2);
+  EXPECT_EQ(source.allocated_bytes, 1200);
+  EXPECT_EQ(source.live_bytes, 200);
+  EXPECT_EQ(source.peak_live_bytes, 1000);
+  EXPECT_EQ(source.memory_types, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL);
+  ASSERT_TRUE(iree_hal_memory_timeline_lookup_source(
+      timeline_, IREE_SV("conv"), &source));
+  EXPECT_EQ(source.live_bytes, 500);
+  EXPECT_FALSE(iree_hal_memory_timeline_lookup_source(
+      timeline_, IREE_SV("other"), &source));
+
+  IREE_EXPECT_OK(iree_hal_memory_timeline_fprint(stdout, timeline_, 1));
+}
+
+// Exercises growth and removal of the live allocation table with many
+// interleaved allocations.
+TEST_F(MemoryTimelineTest, ManyAllocations) {
+  static const uint64_t kCount = 4096;
+  for (uint64_t i = 1; i <= kCount; ++i) {
+    Allocate(i * 64, 16, iree_string_view_empty(),
+             IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL);
+  }
+  for (uint64_t i = 1; i <= kCount; i += 2) Free(i * 64);
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(statistics.live_bytes, kCount / 2 * 16);
+  for (uint64_t i = 2; i <= kCount; i += 2) Free(i * 64);
+  // Frees of already freed ids must not be found.
+  Free(64);
+  statistics = QueryStatistics();
+  EXPECT_EQ(statistics.live_bytes, 0);
+  EXPECT_EQ(statistics.free_count, kCount);
+  EXPECT_EQ(statistics.peak_live_bytes, kCount * 16);
+}
+
+struct ForwardedEvents {
+  static void Record(void* user_data, const iree_profiler_event_t* event) {
+    static_cast<ForwardedEvents*>(user_data)->types.push_back(event->type);
+  }
+  std::vector<iree_profiler_event_type_t> types;
+};
+
+TEST(MemoryTimelineForwardingTest, ForwardsToNextProfiler) {
+  ForwardedEvents forwarded;
+  iree_profiler_t next_profiler = {
+      ForwardedEvents::Record,
+      &forwarded,
+      IREE_PROFILER_EVENT_MASK_DISPATCH,
+  };
+  iree_hal_memory_timeline_t* timeline = NULL;
+  IREE_ASSERT_OK(iree_hal_memory_timeline_create(
+      &next_profiler, iree_allocator_system(), &timeline));
+  iree_profiler_set(iree_hal_memory_timeline_profiler(timeline));
+  EXPECT_TRUE(iree_profiler_is_enabled(IREE_PROFILER_EVENT_MASK_DISPATCH));
+
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN, 1,
+                       iree_string_view_empty(), 0);
+  // Tracked but not forwarded as the next profiler did not request it.
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_ALLOCATE, 2,
+                       iree_string_view_empty(), 64);
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_DISPATCH_END, 1,
+                       iree_string_view_empty(), 0);
+
+  ASSERT_EQ(forwarded.types.size(), 2);
+  EXPECT_EQ(forwarded.types[0], IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN);
+  EXPECT_EQ(forwarded.types[1], IREE_PROFILER_EVENT_TYPE_DISPATCH_END);
+  iree_hal_memory_timeline_statistics_t statistics;
+  iree_hal_memory_timeline_query_statistics(timeline, &statistics);
+  EXPECT_EQ(statistics.live_bytes, 64);
+
+  iree_hal_memory_timeline_free(timeline);
+  EXPECT_EQ(iree_profiler_get(), nullptr);
+}
+
+#endif  // IREE_PROFILER_ENABLE
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
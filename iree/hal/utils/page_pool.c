@@ -0,0 +1,288 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/page_pool.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+// Maximum rank of the page shape of buffer views over the whole pool.
+#define IREE_HAL_PAGE_POOL_MAX_PAGE_SHAPE_RANK 7
+
+struct iree_hal_page_pool_t {
+  iree_allocator_t host_allocator;
+  iree_hal_buffer_t* buffer;
+  iree_device_size_t page_size;
+  iree_host_size_t page_count;
+
+  // Guards all state below.
+  iree_slim_mutex_t mutex;
+  // Stack of free page indices; the top |free_count| entries are free.
+  iree_hal_page_index_t* free_pages;
+  iree_host_size_t free_count;
+  // Per-page flag set while the page is acquired.
+  uint8_t* acquired;
+};
+
+iree_status_t iree_hal_page_pool_create(
+    iree_hal_allocator_t* device_allocator,
+    iree_hal_page_pool_params_t params, iree_allocator_t host_allocator,
+    iree_hal_page_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(device_allocator);
+  IREE_ASSERT_ARGUMENT(out_pool);
+  *out_pool = NULL;
+  if (params.page_size == 0 || params.page_count == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "page pools require a non-zero page size and "
+                            "count");
+  }
+  if (params.page_count > UINT32_MAX ||
+      params.page_size > IREE_DEVICE_SIZE_MAX / params.page_count) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "page pool of %" PRIhsz " pages of %" PRIdsz
+                            " bytes is too large",
+                            params.page_count, params.page_size);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_page_pool_t* pool = NULL;
+  iree_host_size_t total_size =
+      sizeof(*pool) + params.page_count * sizeof(iree_hal_page_index_t) +
+      params.page_count * sizeof(uint8_t);
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, total_size, (void**)&pool);
+  if (iree_status_is_ok(status)) {
+    memset(pool, 0, total_size);
+    pool->host_allocator = host_allocator;
+    pool->page_size = params.page_size;
+    pool->page_count = params.page_count;
+    iree_slim_mutex_initialize(&pool->mutex);
+    pool->free_pages = (iree_hal_page_index_t*)((uint8_t*)pool + sizeof(*pool));
+    pool->acquired = (uint8_t*)(pool->free_pages + params.page_count);
+    // Page 0 is on top of the stack so pages are handed out in order.
+    pool->free_count = params.page_count;
+    for (iree_host_size_t i = 0; i < params.page_count; ++i) {
+      pool->free_pages[i] = (iree_hal_page_index_t)(params.page_count - 1 - i);
+    }
+    status = iree_hal_allocator_allocate_buffer(
+        device_allocator, params.memory_type, params.usage,
+        params.page_size * params.page_count, iree_const_byte_span_empty(),
+        &pool->buffer);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_pool = pool;
+  } else if (pool) {
+    iree_hal_page_pool_free(pool);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_page_pool_free(iree_hal_page_pool_t* pool) {
+  if (!pool) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_buffer_release(pool->buffer);
+  iree_slim_mutex_deinitialize(&pool->mutex);
+  iree_allocator_free(pool->host_allocator, pool);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_hal_buffer_t* iree_hal_page_pool_buffer(const iree_hal_page_pool_t* pool) {
+  IREE_ASSERT_ARGUMENT(pool);
+  return pool->buffer;
+}
+
+iree_device_size_t iree_hal_page_pool_page_size(
+    const iree_hal_page_pool_t* pool) {
+  IREE_ASSERT_ARGUMENT(pool);
+  return pool->page_size;
+}
+
+iree_host_size_t iree_hal_page_pool_page_count(
+    const iree_hal_page_pool_t* pool) {
+  IREE_ASSERT_ARGUMENT(pool);
+  return pool->page_count;
+}
+
+iree_host_size_t iree_hal_page_pool_free_page_count(
+    iree_hal_page_pool_t* pool) {
+  IREE_ASSERT_ARGUMENT(pool);
+  iree_slim_mutex_lock(&pool->mutex);
+  iree_host_size_t free_count = pool->free_count;
+  iree_slim_mutex_unlock(&pool->mutex);
+  return free_count;
+}
+
+iree_status_t iree_hal_page_pool_acquire(iree_hal_page_pool_t* pool,
+                                         iree_host_size_t count,
+                                         iree_hal_page_index_t* out_pages) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_ASSERT_ARGUMENT(!count || out_pages);
+  iree_slim_mutex_lock(&pool->mutex);
+  if (count > pool->free_count) {
+    iree_host_size_t free_count = pool->free_count;
+    iree_slim_mutex_unlock(&pool->mutex);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "page pool has %" PRIhsz
+                            " free pages but %" PRIhsz " were requested",
+                            free_count, count);
+  }
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_hal_page_index_t page = pool->free_pages[--pool->free_count];
+    pool->acquired[page] = 1;
+    out_pages[i] = page;
+  }
+  iree_slim_mutex_unlock(&pool->mutex);
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_page_pool_release(iree_hal_page_pool_t* pool,
+                                         iree_host_size_t count,
+                                         const iree_hal_page_index_t* pages) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_ASSERT_ARGUMENT(!count || pages);
+  iree_slim_mutex_lock(&pool->mutex);
+
+  // Validate all pages before releasing any so that a bad page table leaves
+  // the pool untouched. Duplicates within |pages| are caught by marking pages
+  // as they are checked and restoring the marks afterward.
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t checked_count = 0;
+  for (; checked_count < count; ++checked_count) {
+    iree_hal_page_index_t page = pages[checked_count];
+    if (page >= pool->page_count) {
+      status = iree_make_status(
+          IREE_STATUS_OUT_OF_RANGE,
+          "page %u out of range of a pool of %" PRIhsz " pages", page,
+          pool->page_count);
+      break;
+    }
+    if (!pool->acquired[page]) {
+      status = iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                                "page %u released but not acquired", page);
+      break;
+    }
+    pool->acquired[page] = 0;
+  }
+  if (!iree_status_is_ok(status)) {
+    for (iree_host_size_t i = 0; i < checked_count; ++i) {
+      pool->acquired[pages[i]] = 1;
+    }
+  } else {
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      pool->free_pages[pool->free_count++] = pages[i];
+    }
+  }
+
+  iree_slim_mutex_unlock(&pool->mutex);
+  return status;
+}
+
+// Returns the size in bytes of |shape| elements of |element_type|.
+static iree_status_t iree_hal_page_pool_shape_byte_length(
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type, iree_device_size_t* out_length) {
+  if (!iree_hal_element_is_byte_aligned(element_type)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "page element types must be byte aligned");
+  }
+  iree_device_size_t length = iree_hal_element_dense_byte_count(element_type);
+  for (iree_host_size_t i = 0; i < shape_rank; ++i) {
+    if (shape[i] < 0) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "page shape dimension %" PRIhsz
+                              " is negative (%d)",
+                              i, shape[i]);
+    }
+    iree_device_size_t dim = (iree_device_size_t)shape[i];
+    if (dim != 0 && length > IREE_DEVICE_SIZE_MAX / dim) {
+      return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "page shape byte length overflows");
+    }
+    length *= dim;
+  }
+  *out_length = length;
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_page_pool_page_buffer_view(
+    iree_hal_page_pool_t* pool, iree_hal_page_index_t page,
+    const iree_hal_dim_t* page_shape, iree_host_size_t page_shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_buffer_view_t** out_buffer_view) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_ASSERT_ARGUMENT(!page_shape_rank || page_shape);
+  IREE_ASSERT_ARGUMENT(out_buffer_view);
+  *out_buffer_view = NULL;
+  if (page >= pool->page_count) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "page %u out of range of a pool of %" PRIhsz " pages", page,
+        pool->page_count);
+  }
+  iree_device_size_t byte_length = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_page_pool_shape_byte_length(
+      page_shape, page_shape_rank, element_type, &byte_length));
+  if (byte_length > pool->page_size) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "page shape of %" PRIdsz
+                            " bytes does not fit in a %" PRIdsz " byte page",
+                            byte_length, pool->page_size);
+  }
+
+  iree_hal_buffer_t* page_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_subspan(
+      pool->buffer, (iree_device_size_t)page * pool->page_size, byte_length,
+      &page_buffer));
+  iree_status_t status = iree_hal_buffer_view_create(
+      page_buffer, page_shape, page_shape_rank, element_type,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, pool->host_allocator,
+      out_buffer_view);
+  iree_hal_buffer_release(page_buffer);
+  return status;
+}
+
+iree_status_t iree_hal_page_pool_buffer_view(
+    iree_hal_page_pool_t* pool, const iree_hal_dim_t* page_shape,
+    iree_host_size_t page_shape_rank, iree_hal_element_type_t element_type,
+    iree_hal_buffer_view_t** out_buffer_view) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_ASSERT_ARGUMENT(!page_shape_rank || page_shape);
+  IREE_ASSERT_ARGUMENT(out_buffer_view);
+  *out_buffer_view = NULL;
+  if (page_shape_rank > IREE_HAL_PAGE_POOL_MAX_PAGE_SHAPE_RANK) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "page shape rank %" PRIhsz
+                            " exceeds the maximum of %d",
+                            page_shape_rank,
+                            IREE_HAL_PAGE_POOL_MAX_PAGE_SHAPE_RANK);
+  }
+  iree_device_size_t byte_length = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_page_pool_shape_byte_length(
+      page_shape, page_shape_rank, element_type, &byte_length));
+  if (byte_length != pool->page_size) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "page shape of %" PRIdsz
+                            " bytes does not fill a %" PRIdsz " byte page",
+                            byte_length, pool->page_size);
+  }
+
+  iree_hal_dim_t shape[IREE_HAL_PAGE_POOL_MAX_PAGE_SHAPE_RANK + 1];
+  shape[0] = (iree_hal_dim_t)pool->page_count;
+  for (iree_host_size_t i = 0; i < page_shape_rank; ++i) {
+    shape[i + 1] = page_shape[i];
+  }
+  return iree_hal_buffer_view_create(
+      pool->buffer, shape, page_shape_rank + 1, element_type,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, pool->host_allocator,
+      out_buffer_view);
+}
@@ -0,0 +1,112 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_PAGE_POOL_H_
+#define IREE_HAL_UTILS_PAGE_POOL_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Index of a page within a page pool.
+typedef uint32_t iree_hal_page_index_t;
+
+typedef struct iree_hal_page_pool_params_t {
+  // Memory type and usage of the buffer backing all pages.
+  iree_hal_memory_type_t memory_type;
+  iree_hal_buffer_usage_t usage;
+  // Size in bytes of each page.
+  iree_device_size_t page_size;
+  // Total number of pages in the pool.
+  iree_host_size_t page_count;
+} iree_hal_page_pool_params_t;
+
+// A fixed set of equally sized pages suballocated from a single device buffer.
+//
+// Intended for state that grows in small increments per invocation and is
+// owned by independent sequences, such as the key/value caches of
+// autoregressive decoders: each sequence acquires pages as it grows and
+// releases them when it finishes, and programs address the pool through a
+// page table (a tensor of page indices per sequence) with gather/scatter
+// dispatches over iree_hal_page_pool_buffer_view. Sequences of different
+// lengths can then be batched together and updated in place without copying
+// or reallocating their state on every step.
+//
+// The backing buffer is allocated once on creation; acquiring and releasing
+// pages only updates host-side bookkeeping. Pages released last are acquired
+// first so that recently used memory is reused while it is still resident in
+// caches.
+//
+// Thread-safe; pages may be acquired and released from any thread.
+typedef struct iree_hal_page_pool_t iree_hal_page_pool_t;
+
+// Creates a pool of |params.page_count| pages of |params.page_size| bytes
+// allocated from |device_allocator|.
+iree_status_t iree_hal_page_pool_create(
+    iree_hal_allocator_t* device_allocator,
+    iree_hal_page_pool_params_t params, iree_allocator_t host_allocator,
+    iree_hal_page_pool_t** out_pool);
+
+// Frees |pool| and releases its backing buffer. Buffer views created from the
+// pool retain the buffer and remain valid.
+void iree_hal_page_pool_free(iree_hal_page_pool_t* pool);
+
+// Returns the buffer backing all pages in |pool|. Page |i| starts at byte
+// offset |i| * page size.
+iree_hal_buffer_t* iree_hal_page_pool_buffer(const iree_hal_page_pool_t* pool);
+
+// Returns the size in bytes of each page in |pool|.
+iree_device_size_t iree_hal_page_pool_page_size(
+    const iree_hal_page_pool_t* pool);
+
+// Returns the total number of pages in |pool|.
+iree_host_size_t iree_hal_page_pool_page_count(
+    const iree_hal_page_pool_t* pool);
+
+// Returns the number of pages in |pool| that are not acquired.
+iree_host_size_t iree_hal_page_pool_free_page_count(iree_hal_page_pool_t* pool);
+
+// Acquires |count| pages from |pool| and stores their indices in |out_pages|.
+// Either all pages are acquired or, if fewer than |count| pages are free,
+// none are and IREE_STATUS_RESOURCE_EXHAUSTED is returned so that callers can
+// defer the sequences that need them (or preempt others) and retry.
+iree_status_t iree_hal_page_pool_acquire(iree_hal_page_pool_t* pool,
+                                         iree_host_size_t count,
+                                         iree_hal_page_index_t* out_pages);
+
+// Releases |count| previously acquired |pages| back to |pool|.
+// Fails without releasing any page if a page is out of range or not acquired.
+iree_status_t iree_hal_page_pool_release(iree_hal_page_pool_t* pool,
+                                         iree_host_size_t count,
+                                         const iree_hal_page_index_t* pages);
+
+// Creates a buffer view of |page| shaped as |page_shape| elements of
+// |element_type|. The shape must fit within a page.
+iree_status_t iree_hal_page_pool_page_buffer_view(
+    iree_hal_page_pool_t* pool, iree_hal_page_index_t page,
+    const iree_hal_dim_t* page_shape, iree_host_size_t page_shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_buffer_view_t** out_buffer_view);
+
+// Creates a buffer view of the whole pool shaped as
+// [page count, page_shape...] elements of |element_type|. This is the operand
+// that dispatches gathering from or scattering into pages by page table index.
+// The page shape must fill a page exactly.
+iree_status_t iree_hal_page_pool_buffer_view(
+    iree_hal_page_pool_t* pool, const iree_hal_dim_t* page_shape,
+    iree_host_size_t page_shape_rank, iree_hal_element_type_t element_type,
+    iree_hal_buffer_view_t** out_buffer_view);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_PAGE_POOL_H_
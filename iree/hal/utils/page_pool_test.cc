@@ -0,0 +1,173 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/page_pool.h"
+
+#include <cstdint>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+class PagePoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("heap"), iree_allocator_system(),
+        iree_allocator_system(), &device_allocator_));
+  }
+
+  void TearDown() override { iree_hal_allocator_release(device_allocator_); }
+
+  iree_hal_page_pool_params_t MakeParams(iree_device_size_t page_size,
+                                         iree_host_size_t page_count) {
+    iree_hal_page_pool_params_t params;
+    params.memory_type =
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+    params.usage = IREE_HAL_BUFFER_USAGE_ALL;
+    params.page_size = page_size;
+    params.page_count = page_count;
+    return params;
+  }
+
+  iree_hal_allocator_t* device_allocator_ = NULL;
+};
+
+TEST_F(PagePoolTest, AcquiresAndReleasesPages) {
+  iree_hal_page_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_page_pool_create(
+      device_allocator_, MakeParams(256, 4), iree_allocator_system(), &pool));
+  EXPECT_EQ(iree_hal_page_pool_page_count(pool), 4);
+  EXPECT_EQ(iree_hal_page_pool_free_page_count(pool), 4);
+  EXPECT_GE(iree_hal_buffer_byte_length(iree_hal_page_pool_buffer(pool)),
+            4 * 256);
+
+  // Pages are handed out in order from a fresh pool.
+  iree_hal_page_index_t pages[3] = {0};
+  IREE_ASSERT_OK(iree_hal_page_pool_acquire(pool, 3, pages));
+  EXPECT_EQ(pages[0], 0);
+  EXPECT_EQ(pages[1], 1);
+  EXPECT_EQ(pages[2], 2);
+  EXPECT_EQ(iree_hal_page_pool_free_page_count(pool), 1);
+
+  // The most recently released page is reused first.
+  IREE_ASSERT_OK(iree_hal_page_pool_release(pool, 1, &pages[1]));
+  iree_hal_page_index_t page = 0;
+  IREE_ASSERT_OK(iree_hal_page_pool_acquire(pool, 1, &page));
+  EXPECT_EQ(page, 1);
+
+  IREE_ASSERT_OK(iree_hal_page_pool_release(pool, 3, pages));
+  EXPECT_EQ(iree_hal_page_pool_free_page_count(pool), 4);
+  iree_hal_page_pool_free(pool);
+}
+
+TEST_F(PagePoolTest, ExhaustionAcquiresNothing) {
+  iree_hal_page_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_page_pool_create(
+      device_allocator_, MakeParams(256, 2), iree_allocator_system(), &pool));
+  iree_hal_page_index_t pages[3] = {0};
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_RESOURCE_EXHAUSTED,
+                        iree_hal_page_pool_acquire(pool, 3, pages));
+  EXPECT_EQ(iree_hal_page_pool_free_page_count(pool), 2);
+  IREE_ASSERT_OK(iree_hal_page_pool_acquire(pool, 2, pages));
+  IREE_ASSERT_OK(iree_hal_page_pool_release(pool, 2, pages));
+  iree_hal_page_pool_free(pool);
+}
+
+TEST_F(PagePoolTest, InvalidReleaseLeavesPoolUntouched) {
+  iree_hal_page_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_page_pool_create(
+      device_allocator_, MakeParams(256, 4), iree_allocator_system(), &pool));
+  iree_hal_page_index_t pages[2] = {0};
+  IREE_ASSERT_OK(iree_hal_page_pool_acquire(pool, 2, pages));
+
+  iree_hal_page_index_t out_of_range[2] = {pages[0], 4};
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_OUT_OF_RANGE,
+                        iree_hal_page_pool_release(pool, 2, out_of_range));
+  iree_hal_page_index_t duplicate[2] = {pages[0], pages[0]};
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_FAILED_PRECONDITION,
+                        iree_hal_page_pool_release(pool, 2, duplicate));
+  iree_hal_page_index_t not_acquired = 3;
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_FAILED_PRECONDITION,
+                        iree_hal_page_pool_release(pool, 1, &not_acquired));
+  EXPECT_EQ(iree_hal_page_pool_free_page_count(pool), 2);
+
+  IREE_ASSERT_OK(iree_hal_page_pool_release(pool, 2, pages));
+  iree_hal_page_pool_free(pool);
+}
+
+TEST_F(PagePoolTest, OverflowingPoolSizeIsRejected) {
+  iree_hal_page_pool_t* pool = NULL;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_OUT_OF_RANGE,
+      iree_hal_page_pool_create(device_allocator_,
+                                MakeParams(IREE_DEVICE_SIZE_MAX / 2 + 1, 2),
+                                iree_allocator_system(), &pool));
+  EXPECT_EQ(pool, nullptr);
+}
+
+TEST_F(PagePoolTest, BufferViews) {
+  iree_hal_page_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_page_pool_create(
+      device_allocator_, MakeParams(16 * 4 * sizeof(float), 8),
+      iree_allocator_system(), &pool));
+
+  // A single page viewed as 16 tokens of 4 floats.
+  const iree_hal_dim_t page_shape[2] = {16, 4};
+  iree_hal_buffer_view_t* page_view = NULL;
+  IREE_ASSERT_OK(iree_hal_page_pool_page_buffer_view(
+      pool, 5, page_shape, 2, IREE_HAL_ELEMENT_TYPE_FLOAT_32, &page_view));
+  EXPECT_EQ(iree_hal_buffer_byte_offset(iree_hal_buffer_view_buffer(page_view)),
+            5 * 16 * 4 * sizeof(float));
+  EXPECT_EQ(iree_hal_buffer_view_byte_length(page_view),
+            16 * 4 * sizeof(float));
+  iree_hal_buffer_view_release(page_view);
+
+  // Shapes larger than a page are rejected.
+  const iree_hal_dim_t large_shape[2] = {32, 4};
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_OUT_OF_RANGE,
+      iree_hal_page_pool_page_buffer_view(pool, 0, large_shape, 2,
+                                          IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+                                          &page_view));
+
+  // Shapes whose byte length overflows are rejected instead of wrapping.
+  const iree_hal_dim_t overflowing_shape[4] = {65536, 65536, 65536, 65536};
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_OUT_OF_RANGE,
+      iree_hal_page_pool_page_buffer_view(pool, 0, overflowing_shape, 4,
+                                          IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+                                          &page_view));
+
+  // Negative dimensions are rejected.
+  const iree_hal_dim_t negative_shape[2] = {-1, 4};
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_INVALID_ARGUMENT,
+      iree_hal_page_pool_page_buffer_view(pool, 0, negative_shape, 2,
+                                          IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+                                          &page_view));
+
+  // The whole pool viewed as [page, token, channel] for page table gathers.
+  iree_hal_buffer_view_t* pool_view = NULL;
+  IREE_ASSERT_OK(iree_hal_page_pool_buffer_view(
+      pool, page_shape, 2, IREE_HAL_ELEMENT_TYPE_FLOAT_32, &pool_view));
+  ASSERT_EQ(iree_hal_buffer_view_shape_rank(pool_view), 3);
+  EXPECT_EQ(iree_hal_buffer_view_shape_dim(pool_view, 0), 8);
+  EXPECT_EQ(iree_hal_buffer_view_shape_dim(pool_view, 1), 16);
+  EXPECT_EQ(iree_hal_buffer_view_shape_dim(pool_view, 2), 4);
+  iree_hal_buffer_view_release(pool_view);
+
+  iree_hal_page_pool_free(pool);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
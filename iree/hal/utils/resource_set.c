@@ -6,6 +6,7 @@
 
 #include "iree/hal/utils/resource_set.h"
 
+#include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 
 // Inlines the first chunk into the block using all of the remaining space.
@@ -192,7 +193,9 @@ static iree_status_t iree_hal_resource_set_insert_retain(
 // single cache line, do all the scanning and shifting in registers, and then
 // store back to the single cache line.
 //
-// Today, though, we leave this as an exercise to whoever comes across this :)
+// Today we get most of the way there portably: the scan is a fixed-length
+// branchless compare producing a bitmask of hits that compilers vectorize into
+// the compare/or sequences below and the update is a single memmove.
 // Notes:
 //   As the MRU is a fixed size we can unroll it entirely and avoid any looping.
 //   On a 32-bit system with uint32x4_t we only need 4 registers.
@@ -232,12 +235,18 @@ static iree_status_t iree_hal_resource_set_insert_retain(
 //   https://github.com/simd-everywhere/simde/blob/master/simde/arm/neon/ceq.h#L591
 static iree_status_t iree_hal_resource_set_insert_1(
     iree_hal_resource_set_t* set, iree_hal_resource_t* resource) {
-  // Scan and hope for a hit.
+  // Scan and hope for a hit. The scan always covers the entire MRU so that the
+  // loop can be fully unrolled and vectorized; since the MRU holds unique
+  // pointers at most one bit will be set (NULL entries are never scanned for).
+  uint32_t hit_mask = 0;
   for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(set->mru); ++i) {
-    if (set->mru[i] != resource) continue;
+    hit_mask |= (uint32_t)(set->mru[i] == resource) << i;
+  }
+  if (hit_mask) {
     // Hit - keep the list sorted by most->least recently used.
     // We shift the MRU down to make room at index 0 and store the
     // resource there.
+    int i = iree_math_count_trailing_zeros_u32(hit_mask);
     if (i > 0) {
       memmove(&set->mru[1], &set->mru[0], sizeof(set->mru[0]) * i);
       set->mru[0] = resource;
@@ -261,16 +270,22 @@ static iree_status_t iree_hal_resource_set_insert_1(
 IREE_API_EXPORT iree_status_t
 iree_hal_resource_set_insert(iree_hal_resource_set_t* set,
                              iree_host_size_t count, const void* resources) {
-  // For now we process one at a time. We should have a stride that lets us
-  // amortize the cost of doing the MRU update and insertion allocation by
-  // say slicing off 4/8/16/32 resources at a time etc. Today each miss that
-  // requires a full insertion goes down the whole path of checking chunk
-  // capacity and such.
-  iree_hal_resource_t* const* typed_resources =
-      (iree_hal_resource_t* const*)resources;
-  for (iree_host_size_t i = 0; i < count; ++i) {
-    IREE_RETURN_IF_ERROR(
-        iree_hal_resource_set_insert_1(set, typed_resources[i]));
+  return iree_hal_resource_set_insert_span(set, count, resources,
+                                           sizeof(iree_hal_resource_t*));
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_resource_set_insert_span(
+    iree_hal_resource_set_t* set, iree_host_size_t count,
+    const void* first_resource, iree_host_size_t stride) {
+  // Each resource is deduplicated against the MRU as it is scanned so that
+  // repeated resources within the span (such as the same buffer bound to
+  // multiple bindings) only hit the main list once. Misses still retain one at
+  // a time but will usually land in the same chunk.
+  const uint8_t* resource_ptr = (const uint8_t*)first_resource;
+  for (iree_host_size_t i = 0; i < count; ++i, resource_ptr += stride) {
+    iree_hal_resource_t* resource = *(iree_hal_resource_t* const*)resource_ptr;
+    if (IREE_UNLIKELY(!resource)) continue;
+    IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert_1(set, resource));
   }
   return iree_ok_status();
 }
@@ -62,7 +62,8 @@ typedef struct iree_hal_resource_set_chunk_t {
 // Values for the platforms we specify for:
 //   32-bit: 64 / 4 = 16x4b ptrs (4 x uint32x4_t)
 //   64-bit: 64 / 8 = 8x8b ptrs (4 x uint64x2_t)
-// We could scale this up if we wanted but being able to unroll is nice.
+// We could scale this up if we wanted but being able to unroll is nice. The
+// MRU scan produces a 32-bit hit mask and the size must not exceed 32.
 #define IREE_HAL_RESOURCE_SET_MRU_SIZE \
   (iree_hardware_constructive_interference_size / sizeof(uintptr_t))
 
@@ -132,6 +133,17 @@ IREE_API_EXPORT iree_status_t
 iree_hal_resource_set_insert(iree_hal_resource_set_t* set,
                              iree_host_size_t count, const void* resources);
 
+// Inserts zero or more resources into the set from a strided span.
+// |first_resource| points at the first resource pointer and each subsequent
+// pointer is located |stride| bytes after the previous one. This allows
+// resources embedded in other structures (such as the buffers of
+// iree_hal_descriptor_set_binding_t) to be inserted in a single call without
+// first gathering them into their own list. NULL resources are ignored.
+// Each resource will be retained for at least the lifetime of the set.
+IREE_API_EXPORT iree_status_t iree_hal_resource_set_insert_span(
+    iree_hal_resource_set_t* set, iree_host_size_t count,
+    const void* first_resource, iree_host_size_t stride);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -203,6 +203,108 @@ static iree_status_t iree_hal_resource_set_benchmark_randomized_n(
   return iree_ok_status();
 }
 
+// Binding structure matching the layout of iree_hal_descriptor_set_binding_t
+// so that we exercise the same strided access as command buffers.
+typedef struct iree_hal_test_binding_t {
+  uint32_t binding;
+  iree_hal_resource_t* resource;
+  iree_device_size_t offset;
+  iree_device_size_t length;
+} iree_hal_test_binding_t;
+
+// Number of bindings in each simulated dispatch.
+#define IREE_HAL_TEST_BINDINGS_PER_DISPATCH 4
+
+// Tests insertion of descriptor set bindings as performed when recording
+// dispatches. Each dispatch binds a sliding window of resources such that
+// each dispatch consumes the results of the one before it, which is the most
+// common pattern produced by the compiler, and every other dispatch reuses the
+// same buffer for multiple bindings.
+//
+// user_data is a count of unique resources the bindings are drawn from.
+static iree_status_t iree_hal_resource_set_benchmark_bindings(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state, bool use_span) {
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  // Initialize the block pool we'll be serving from.
+  // Sized like we usually do it in the runtime for ~512-1024 elements.
+  iree_arena_block_pool_t block_pool;
+  iree_arena_block_pool_initialize(4096, host_allocator, &block_pool);
+
+  // Allocate the resources we'll be using - we keep them live so that we are
+  // measuring just the retain/release and set times instead of the timing of
+  // resource creation/deletion.
+  uint32_t count = (uint32_t)(uintptr_t)benchmark_def->user_data;
+  iree_hal_resource_t** resources = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(host_allocator,
+                                      sizeof(iree_hal_resource_t*) * count,
+                                      (void**)&resources));
+  for (uint32_t i = 0; i < count; ++i) {
+    IREE_CHECK_OK(iree_hal_test_resource_create(host_allocator, &resources[i]));
+  }
+
+  iree_hal_resource_set_t* set = NULL;
+  IREE_CHECK_OK(iree_hal_resource_set_allocate(&block_pool, &set));
+
+  // Record 64 dispatches per batch.
+  uint32_t dispatch_ordinal = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/64)) {
+    for (uint32_t i = 0; i < 64; ++i, ++dispatch_ordinal) {
+      iree_hal_test_binding_t bindings[IREE_HAL_TEST_BINDINGS_PER_DISPATCH];
+      for (uint32_t j = 0; j < IREE_ARRAYSIZE(bindings); ++j) {
+        uint32_t resource_idx = (dispatch_ordinal + j) % count;
+        if ((dispatch_ordinal & 1) && j == IREE_ARRAYSIZE(bindings) - 1) {
+          resource_idx = dispatch_ordinal % count;
+        }
+        bindings[j] = (iree_hal_test_binding_t){
+            .binding = j,
+            .resource = resources[resource_idx],
+            .offset = 0,
+            .length = IREE_WHOLE_BUFFER,
+        };
+      }
+      if (use_span) {
+        IREE_CHECK_OK(iree_hal_resource_set_insert_span(
+            set, IREE_ARRAYSIZE(bindings), &bindings[0].resource,
+            sizeof(bindings[0])));
+      } else {
+        for (uint32_t j = 0; j < IREE_ARRAYSIZE(bindings); ++j) {
+          IREE_CHECK_OK(
+              iree_hal_resource_set_insert(set, 1, &bindings[j].resource));
+        }
+      }
+    }
+  }
+
+  // Cleanup.
+  iree_hal_resource_set_free(set);
+  for (uint32_t i = 0; i < count; ++i) {
+    iree_hal_resource_release(resources[i]);
+  }
+  iree_allocator_free(host_allocator, resources);
+  iree_arena_block_pool_deinitialize(&block_pool);
+
+  return iree_ok_status();
+}
+
+// Inserts each binding individually as command buffers did prior to having
+// iree_hal_resource_set_insert_span.
+static iree_status_t iree_hal_resource_set_benchmark_bindings_each_n(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  return iree_hal_resource_set_benchmark_bindings(
+      benchmark_def, benchmark_state, /*use_span=*/false);
+}
+
+// Inserts all bindings of each dispatch with a single strided insertion.
+static iree_status_t iree_hal_resource_set_benchmark_bindings_span_n(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  return iree_hal_resource_set_benchmark_bindings(
+      benchmark_def, benchmark_state, /*use_span=*/true);
+}
+
 int main(int argc, char** argv) {
   iree_benchmark_initialize(&argc, argv);
 
@@ -282,6 +384,48 @@ int main(int argc, char** argv) {
                             &benchmark_def);
   }
 
+  // iree_hal_resource_set_benchmark_bindings_each_n
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_hal_resource_set_benchmark_bindings_each_n,
+    };
+    benchmark_def.user_data = (void*)4u;
+    iree_benchmark_register(iree_make_cstring_view("bindings_each_4"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)16u;
+    iree_benchmark_register(iree_make_cstring_view("bindings_each_16"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)256u;
+    iree_benchmark_register(iree_make_cstring_view("bindings_each_256"),
+                            &benchmark_def);
+  }
+
+  // iree_hal_resource_set_benchmark_bindings_span_n
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_hal_resource_set_benchmark_bindings_span_n,
+    };
+    benchmark_def.user_data = (void*)4u;
+    iree_benchmark_register(iree_make_cstring_view("bindings_span_4"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)16u;
+    iree_benchmark_register(iree_make_cstring_view("bindings_span_16"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)256u;
+    iree_benchmark_register(iree_make_cstring_view("bindings_span_256"),
+                            &benchmark_def);
+  }
+
   iree_benchmark_run_specified();
   return 0;
 }
@@ -176,6 +176,47 @@ TEST_F(ResourceSetTest, InsertionGrowth) {
   EXPECT_EQ(live_bitmap, 0u);
 }
 
+// Tests inserting resources embedded in other structures with a stride, as is
+// done with descriptor set bindings.
+TEST_F(ResourceSetTest, InsertSpan) {
+  auto resource_set = make_resource_set(&block_pool);
+
+  iree_hal_resource_t* resources[3] = {NULL};
+  uint32_t live_bitmap = 0u;
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(resources); ++i) {
+    IREE_ASSERT_OK(iree_hal_test_resource_create(
+        i, &live_bitmap, host_allocator, &resources[i]));
+  }
+  EXPECT_EQ(live_bitmap, 0x7u);
+
+  // Bindings reference a resource more than once and leave one slot unused.
+  struct binding_t {
+    uint32_t ordinal;
+    iree_hal_resource_t* resource;
+    uint64_t offset;
+  } bindings[5] = {
+      {0, resources[0], 0}, {1, resources[1], 16}, {2, resources[0], 32},
+      {3, NULL, 0},         {4, resources[2], 0},
+  };
+  IREE_ASSERT_OK(iree_hal_resource_set_insert_span(
+      resource_set.get(), IREE_ARRAYSIZE(bindings), &bindings[0].resource,
+      sizeof(bindings[0])));
+  EXPECT_EQ(resource_set->mru[0], resources[2]);
+  EXPECT_EQ(resource_set->mru[1], resources[0]);
+  EXPECT_EQ(resource_set->mru[2], resources[1]);
+  EXPECT_EQ(resource_set->mru[3], nullptr);
+
+  // Release all of the resources - they should still be owned by the set.
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(resources); ++i) {
+    iree_hal_resource_release(resources[i]);
+  }
+  EXPECT_EQ(live_bitmap, 0x7u);
+
+  // Ensure the set releases the resources.
+  resource_set.reset();
+  EXPECT_EQ(live_bitmap, 0u);
+}
+
 // Tests insertion of resources multiple times to verify the MRU works.
 TEST_F(ResourceSetTest, RedundantInsertion) {
   auto resource_set = make_resource_set(&block_pool);
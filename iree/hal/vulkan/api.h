@@ -16,6 +16,7 @@
 // clang-format on
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
@@ -47,6 +48,14 @@ enum iree_hal_vulkan_feature_bits_t {
   // identify slow dispatches and refine from there; be wary of whole-program
   // tracing with this enabled.
   IREE_HAL_VULKAN_FEATURE_ENABLE_TRACING = 1u << 2,
+
+  // Requires VK_KHR_buffer_device_address and passes dispatch bindings to
+  // shaders as 64-bit buffer device addresses in push constants instead of
+  // through descriptor sets. This removes the per-dispatch descriptor updates
+  // but requires that all executables loaded on the device were compiled for
+  // it (`--iree-vulkan-buffer-device-address`). Executables compiled for one
+  // binding model are rejected by devices using the other.
+  IREE_HAL_VULKAN_FEATURE_ENABLE_BUFFER_DEVICE_ADDRESSES = 1u << 3,
 };
 typedef uint32_t iree_hal_vulkan_features_t;
 
@@ -156,12 +165,42 @@ enum iree_hal_vulkan_device_flag_bits_t {
   // May be removed in future versions when timeline semaphores can be assumed
   // present on all platforms (looking at you, Android ಠ_ಠ).
   IREE_HAL_VULKAN_DEVICE_FORCE_TIMELINE_SEMAPHORE_EMULATION = 1u << 0,
+
+  // Disables the device VkPipelineCache such that all pipelines are compiled
+  // by the driver when executables are prepared. Useful for isolating pipeline
+  // caching behavior and verifying compilation.
+  IREE_HAL_VULKAN_DEVICE_DISABLE_PIPELINE_CACHE = 1u << 1,
+
+  // Writes timestamp queries around each dispatch and aggregates the GPU
+  // durations per executable entry point. The results can be queried with
+  // iree_hal_vulkan_device_query_dispatch_profile. Adds a small overhead to
+  // each dispatch. Dispatches are not serialized so the durations of those
+  // that overlap on the GPU include each other.
+  IREE_HAL_VULKAN_DEVICE_ENABLE_DISPATCH_PROFILING = 1u << 2,
 };
 typedef uint32_t iree_hal_vulkan_device_flags_t;
 
 typedef struct iree_hal_vulkan_device_options_t {
   // Flags controlling device behavior.
   iree_hal_vulkan_device_flags_t flags;
+
+  // Optional initial contents of the device pipeline cache as returned by
+  // iree_hal_vulkan_device_serialize_pipeline_cache from a prior run. Data
+  // produced by a different driver version or physical device is ignored.
+  // Only needs to remain valid for the duration of the device (or driver)
+  // creation call.
+  iree_const_byte_span_t pipeline_cache_data;
+
+  // Optional file path used to persist the device pipeline cache across runs.
+  // If the file exists its contents are used to seed the pipeline cache when
+  // the device is created (taking precedence over |pipeline_cache_data|) and
+  // the cache is written back to the file when the device is destroyed.
+  iree_string_view_t pipeline_cache_path;
+
+  // Optional file path the dispatch profile is written to when the device is
+  // destroyed if IREE_HAL_VULKAN_DEVICE_ENABLE_DISPATCH_PROFILING is set.
+  // `-` writes to stderr.
+  iree_string_view_t dispatch_profile_path;
 } iree_hal_vulkan_device_options_t;
 
 IREE_API_EXPORT void iree_hal_vulkan_device_options_initialize(
@@ -205,6 +244,56 @@ IREE_API_EXPORT iree_status_t iree_hal_vulkan_wrap_device(
     const iree_hal_vulkan_queue_set_t* transfer_queue_set,
     iree_allocator_t host_allocator, iree_hal_device_t** out_device);
 
+// Serializes the pipeline cache of a Vulkan HAL |device| into a new allocation
+// from |host_allocator| returned in |out_data|. The data can be provided as
+// iree_hal_vulkan_device_options_t::pipeline_cache_data on future runs to skip
+// driver shader compilation. The caller must free the data with
+// |host_allocator|.
+//
+// Fails with IREE_STATUS_FAILED_PRECONDITION if the device was created with
+// IREE_HAL_VULKAN_DEVICE_DISABLE_PIPELINE_CACHE.
+IREE_API_EXPORT iree_status_t iree_hal_vulkan_device_serialize_pipeline_cache(
+    iree_hal_device_t* device, iree_allocator_t host_allocator,
+    iree_byte_span_t* out_data);
+
+// GPU timings of all profiled dispatches of an executable entry point.
+typedef struct iree_hal_vulkan_dispatch_profile_entry_t {
+  // Name of the entry point within its executable.
+  iree_string_view_t name;
+  // Number of dispatches that completed and had their timestamps read back.
+  uint64_t dispatch_count;
+  // Sum, minimum, and maximum of the dispatch durations in nanoseconds.
+  uint64_t total_duration_ns;
+  uint64_t min_duration_ns;
+  uint64_t max_duration_ns;
+} iree_hal_vulkan_dispatch_profile_entry_t;
+
+// Queries the dispatch profile of a Vulkan HAL |device| sorted by descending
+// total duration. Timestamps of a command buffer are read back when it is
+// reset or destroyed after its submissions have completed.
+//
+// |entry_capacity| defines the number of elements available in |out_entries|
+// and |out_entry_count| will be set with the actual number of entries. If
+// |entry_capacity| is too small then IREE_STATUS_OUT_OF_RANGE will be returned
+// with the required capacity in |out_entry_count|. The entry names remain
+// valid until the profile is reset or the device is destroyed.
+//
+// Fails with IREE_STATUS_FAILED_PRECONDITION if the device was created without
+// IREE_HAL_VULKAN_DEVICE_ENABLE_DISPATCH_PROFILING.
+IREE_API_EXPORT iree_status_t iree_hal_vulkan_device_query_dispatch_profile(
+    iree_hal_device_t* device, iree_host_size_t entry_capacity,
+    iree_hal_vulkan_dispatch_profile_entry_t* out_entries,
+    iree_host_size_t* out_entry_count);
+
+// Drops all entries of the dispatch profile of |device|, if enabled.
+IREE_API_EXPORT void iree_hal_vulkan_device_reset_dispatch_profile(
+    iree_hal_device_t* device);
+
+// Prints the dispatch profile of |device| to |file| as a table.
+// Does nothing if dispatch profiling is not enabled.
+IREE_API_EXPORT iree_status_t iree_hal_vulkan_device_dispatch_profile_fprint(
+    FILE* file, iree_hal_device_t* device);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_vulkan_driver_t
 //===----------------------------------------------------------------------===//
@@ -91,8 +91,10 @@ iree_status_t BuiltinExecutables::InitializeExecutables() {
 
   // Create pipeline layout.
   if (iree_status_is_ok(status)) {
+    // Builtin shaders always use descriptor sets.
     status = iree_hal_vulkan_native_executable_layout_create(
-        logical_device_, IREE_HAL_VULKAN_BUILTIN_PUSH_CONSTANT_COUNT / 4,
+        logical_device_, /*use_buffer_device_addresses=*/false,
+        IREE_HAL_VULKAN_BUILTIN_PUSH_CONSTANT_COUNT / 4,
         IREE_HAL_VULKAN_BUILTIN_DESCRIPTOR_SET_COUNT, descriptor_set_layouts_,
         &executable_layout_);
   }
@@ -186,12 +188,14 @@ iree_status_t BuiltinExecutables::FillBufferUnaligned(
   logical_device_->syms()->vkCmdDispatch(command_buffer, 1, 1, 1);
 
   // Restore push constants.
-  logical_device_->syms()->vkCmdPushConstants(
-      command_buffer,
-      iree_hal_vulkan_native_executable_layout_handle(executable_layout_),
-      VK_SHADER_STAGE_COMPUTE_BIT, /*offset=*/0,
-      sizeof(iree_hal_vulkan_builtin_fill_unaligned_constants_t),
-      push_constants_to_restore);
+  if (push_constants_to_restore) {
+    logical_device_->syms()->vkCmdPushConstants(
+        command_buffer,
+        iree_hal_vulkan_native_executable_layout_handle(executable_layout_),
+        VK_SHADER_STAGE_COMPUTE_BIT, /*offset=*/0,
+        sizeof(iree_hal_vulkan_builtin_fill_unaligned_constants_t),
+        push_constants_to_restore);
+  }
 
   return iree_ok_status();
 }
@@ -44,8 +44,10 @@ class BuiltinExecutables {
   // This only implements the unaligned edges of fills, vkCmdFillBuffer should
   // be used for the aligned interior (if any).
   //
-  // |push_constants_to_restore| will be pushed using vkCmdPushConstants over
-  // the bytes used by this call.
+  // If provided |push_constants_to_restore| will be pushed using
+  // vkCmdPushConstants over the bytes used by this call. Callers that track
+  // their bound state can instead pass NULL and re-push their constants (and
+  // rebind their pipeline and descriptor sets) lazily on their next dispatch.
   iree_status_t FillBufferUnaligned(
       VkCommandBuffer command_buffer, DescriptorSetArena* descriptor_set_arena,
       iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
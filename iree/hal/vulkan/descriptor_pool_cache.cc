@@ -8,6 +8,7 @@
 
 #include <array>
 #include <cstdint>
+#include <iterator>
 #include <ostream>
 
 #include "iree/base/logging.h"
@@ -44,14 +45,36 @@ iree_status_t DescriptorSetGroup::Reset() {
 }
 
 DescriptorPoolCache::DescriptorPoolCache(VkDeviceHandle* logical_device)
-    : logical_device_(logical_device) {}
+    : logical_device_(logical_device) {
+  iree_slim_mutex_initialize(&mutex_);
+}
+
+DescriptorPoolCache::~DescriptorPoolCache() {
+  Trim();
+  iree_slim_mutex_deinitialize(&mutex_);
+}
 
 iree_status_t DescriptorPoolCache::AcquireDescriptorPool(
-    VkDescriptorType descriptor_type, int max_descriptor_count,
+    VkDescriptorType descriptor_type, uint32_t max_descriptor_count,
     DescriptorPool* out_descriptor_pool) {
   IREE_TRACE_SCOPE0("DescriptorPoolCache::AcquireDescriptorPool");
 
-  // TODO(benvanik): lookup in cache.
+  // Reuse a pool of the same shape if one has been released.
+  iree_slim_mutex_lock(&mutex_);
+  for (auto it = free_pools_.rbegin(); it != free_pools_.rend(); ++it) {
+    if (it->descriptor_type == descriptor_type &&
+        it->max_descriptor_count == max_descriptor_count) {
+      *out_descriptor_pool = *it;
+      free_pools_.erase(std::next(it).base());
+      ++hit_count_;
+      IREE_TRACE_PLOT_VALUE_I64("DescriptorPoolCache::hits", hit_count_);
+      iree_slim_mutex_unlock(&mutex_);
+      return iree_ok_status();
+    }
+  }
+  ++miss_count_;
+  IREE_TRACE_PLOT_VALUE_I64("DescriptorPoolCache::misses", miss_count_);
+  iree_slim_mutex_unlock(&mutex_);
 
   VkDescriptorPoolCreateInfo create_info;
   create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -66,6 +89,7 @@ iree_status_t DescriptorPoolCache::AcquireDescriptorPool(
 
   DescriptorPool descriptor_pool;
   descriptor_pool.descriptor_type = descriptor_type;
+  descriptor_pool.max_descriptor_count = max_descriptor_count;
   descriptor_pool.handle = VK_NULL_HANDLE;
 
   VK_RETURN_IF_ERROR(syms().vkCreateDescriptorPool(
@@ -88,13 +112,38 @@ iree_status_t DescriptorPoolCache::ReleaseDescriptorPools(
     VK_RETURN_IF_ERROR(syms().vkResetDescriptorPool(*logical_device_,
                                                     descriptor_pool.handle, 0),
                        "vkResetDescriptorPool");
+  }
+
+  iree_slim_mutex_lock(&mutex_);
+  free_pools_.insert(free_pools_.end(), descriptor_pools.begin(),
+                     descriptor_pools.end());
+  iree_slim_mutex_unlock(&mutex_);
 
-    // TODO(benvanik): release to cache.
+  return iree_ok_status();
+}
+
+void DescriptorPoolCache::Trim() {
+  IREE_TRACE_SCOPE0("DescriptorPoolCache::Trim");
+
+  std::vector<DescriptorPool> free_pools;
+  iree_slim_mutex_lock(&mutex_);
+  free_pools.swap(free_pools_);
+  iree_slim_mutex_unlock(&mutex_);
+
+  for (const auto& descriptor_pool : free_pools) {
     syms().vkDestroyDescriptorPool(*logical_device_, descriptor_pool.handle,
                                    logical_device_->allocator());
   }
+}
 
-  return iree_ok_status();
+DescriptorPoolCacheStatistics DescriptorPoolCache::QueryStatistics() {
+  DescriptorPoolCacheStatistics statistics;
+  iree_slim_mutex_lock(&mutex_);
+  statistics.hit_count = hit_count_;
+  statistics.miss_count = miss_count_;
+  statistics.free_count = free_pools_.size();
+  iree_slim_mutex_unlock(&mutex_);
+  return statistics;
 }
 
 }  // namespace vulkan
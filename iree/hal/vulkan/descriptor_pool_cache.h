@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
 #include "iree/hal/vulkan/handle_util.h"
 #include "iree/hal/vulkan/util/ref_ptr.h"
@@ -28,6 +29,9 @@ class DescriptorPoolCache;
 struct DescriptorPool {
   // Type of the descriptor in the set.
   VkDescriptorType descriptor_type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+  // Maximum number of descriptors per set the pool was sized for. Together
+  // with |descriptor_type| this is the key pools are recycled under.
+  uint32_t max_descriptor_count = 0;
   // Pool handle.
   VkDescriptorPool handle = VK_NULL_HANDLE;
 };
@@ -60,15 +64,30 @@ class DescriptorSetGroup final {
   std::vector<DescriptorPool> descriptor_pools_;
 };
 
+// Counters tracking DescriptorPoolCache reuse.
+struct DescriptorPoolCacheStatistics {
+  // Number of acquisitions satisfied by a recycled pool.
+  uint64_t hit_count = 0;
+  // Number of acquisitions that had to create a new pool.
+  uint64_t miss_count = 0;
+  // Number of pools currently available for reuse.
+  uint64_t free_count = 0;
+};
+
 // A "cache" (or really, pool) of descriptor pools. These pools are allocated
 // as needed to satisfy different descriptor size requirements and are given
 // to command buffers during recording to write descriptor updates and bind
 // resources. After the descriptors in the pool are no longer used (all
 // command buffers using descriptor sets allocated from the pool have retired)
-// the pool is returned here to be reused in the future.
+// the pool is reset and returned here to be reused in the future.
+//
+// Pools are recycled by descriptor type and per-set descriptor count (the
+// bucket the arenas derive from the set layout) so a reused pool always has
+// the same capacity as a newly created one. Thread-safe.
 class DescriptorPoolCache final {
  public:
   explicit DescriptorPoolCache(VkDeviceHandle* logical_device);
+  ~DescriptorPoolCache();
 
   VkDeviceHandle* logical_device() const { return logical_device_; }
   const DynamicSymbols& syms() const { return *logical_device_->syms(); }
@@ -78,7 +97,7 @@ class DescriptorPoolCache final {
   // When all sets allocated from the pool are no longer in use it must be
   // returned to the cache with ReleaseDescriptorPool.
   iree_status_t AcquireDescriptorPool(VkDescriptorType descriptor_type,
-                                      int max_descriptor_count,
+                                      uint32_t max_descriptor_count,
                                       DescriptorPool* out_descriptor_pool);
 
   // Releases descriptor pools back to the cache. The pools will be reset
@@ -86,8 +105,22 @@ class DescriptorPoolCache final {
   iree_status_t ReleaseDescriptorPools(
       const std::vector<DescriptorPool>& descriptor_pools);
 
+  // Destroys all pools available for reuse. Pools still in use are unaffected
+  // and will be recycled when released.
+  void Trim();
+
+  // Returns a snapshot of the cache reuse counters.
+  DescriptorPoolCacheStatistics QueryStatistics();
+
  private:
   VkDeviceHandle* logical_device_;
+
+  iree_slim_mutex_t mutex_;
+  // Reset pools available for reuse; searched from the back so that the most
+  // recently retired (and likely still warm) pools are reused first.
+  std::vector<DescriptorPool> free_pools_;
+  uint64_t hit_count_ = 0;
+  uint64_t miss_count_ = 0;
 };
 
 }  // namespace vulkan
@@ -8,6 +8,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "iree/base/api.h"
 #include "iree/base/internal/inline_array.h"
@@ -28,6 +29,54 @@
 
 using namespace iree::hal::vulkan;
 
+// Maximum number of descriptor sets whose bindings are tracked for eliding
+// redundant binds. Matches the common `maxBoundDescriptorSets` limit.
+#define IREE_HAL_VULKAN_MAX_TRACKED_DESCRIPTOR_SETS 4
+// Maximum number of bindings per descriptor set tracked; sets with more are
+// always rebound.
+#define IREE_HAL_VULKAN_MAX_TRACKED_DESCRIPTOR_BINDINGS 16
+// Maximum number of 32-bit push constant words tracked; pushes beyond this are
+// never elided.
+#define IREE_HAL_VULKAN_MAX_TRACKED_PUSH_CONSTANT_WORDS 64
+
+// Bindings last bound to a descriptor set.
+typedef struct iree_hal_vulkan_bound_descriptor_set_t {
+  // False if the set state is unknown (never bound or disturbed).
+  bool valid;
+  // Descriptor set object bound with bind_descriptor_set or VK_NULL_HANDLE if
+  // the set was pushed with |bindings|.
+  VkDescriptorSet handle;
+  iree_host_size_t binding_count;
+  iree_hal_descriptor_set_binding_t
+      bindings[IREE_HAL_VULKAN_MAX_TRACKED_DESCRIPTOR_BINDINGS];
+  iree_host_size_t dynamic_offset_count;
+  iree_device_size_t
+      dynamic_offsets[IREE_HAL_VULKAN_MAX_TRACKED_DESCRIPTOR_BINDINGS];
+} iree_hal_vulkan_bound_descriptor_set_t;
+
+// Shadow of the state bound on a VkCommandBuffer used to elide commands that
+// would not change it. Cleared on begin and whenever builtin executables
+// record commands that disturb the state.
+typedef struct iree_hal_vulkan_bound_state_t {
+  VkPipeline pipeline;
+
+  // Layout the tracked descriptor sets were bound with. Binding sets with a
+  // different layout may disturb the other sets so all are invalidated.
+  VkPipelineLayout descriptor_set_layout;
+  iree_hal_vulkan_bound_descriptor_set_t
+      descriptor_sets[IREE_HAL_VULKAN_MAX_TRACKED_DESCRIPTOR_SETS];
+
+  // Layout push constants were last pushed with and their values. Bits in
+  // |push_constant_valid_words| indicate which words have known values.
+  VkPipelineLayout push_constant_layout;
+  uint64_t push_constant_valid_words;
+  uint32_t push_constants[IREE_HAL_VULKAN_MAX_TRACKED_PUSH_CONSTANT_WORDS];
+  // True if the push constants on the command buffer no longer match
+  // |push_constants| (as a builtin overwrote them) and must be pushed again
+  // before the next dispatch.
+  bool push_constants_disturbed;
+} iree_hal_vulkan_bound_state_t;
+
 // Command buffer implementation that directly maps to VkCommandBuffer.
 // This records the commands on the calling thread without additional threading
 // indirection.
@@ -42,10 +91,25 @@ typedef struct iree_hal_vulkan_direct_command_buffer_t {
 
   DynamicSymbols* syms;
 
+  // Pipeline stages and access types valid on the queues the command buffer
+  // may be submitted to. Command buffers that only contain transfer commands
+  // may be executed on dedicated transfer queues that support neither.
+  VkPipelineStageFlags supported_stage_mask;
+  VkAccessFlags supported_access_mask;
+
+  // Used to allocate scratch buffers for unaligned fills.
+  iree_hal_allocator_t* device_allocator;
+
   // Maintains a reference to all resources used within the command buffer.
   // Reset on each begin.
   iree_hal_resource_set_t* resource_set;
 
+  // Scratch buffer used by unaligned fills in transfer-only command buffers,
+  // if any, and the offset of the next unused pattern slot within it. Retained
+  // by |resource_set|.
+  iree_hal_buffer_t* fill_scratch_buffer;
+  iree_device_size_t fill_scratch_offset;
+
   // TODO(benvanik): may grow large - should try to reclaim or reuse.
   DescriptorSetArena descriptor_set_arena;
 
@@ -56,12 +120,15 @@ typedef struct iree_hal_vulkan_direct_command_buffer_t {
 
   BuiltinExecutables* builtin_executables;
 
-  // Shadow copy of push constants used during normal operation, for restoring
-  // after builtin_executables uses vkCmdPushConstants. Size must be greater
-  // than or equal to the push constant memory used by builtin_executables.
-  // TODO(scotttodd): use [maxPushConstantsSize - 16, maxPushConstantsSize]
-  //                  instead of [0, 16] to reduce frequency of updates
-  uint8_t push_constants_storage[IREE_HAL_VULKAN_BUILTIN_PUSH_CONSTANT_COUNT];
+  // State bound on |handle| used to elide redundant commands. Push constants
+  // overwritten by builtin_executables are restored from it lazily.
+  iree_hal_vulkan_bound_state_t bound_state;
+
+  // Writes timestamps around dispatches if dispatch profiling is enabled.
+  iree_hal_vulkan_dispatch_recorder_t dispatch_recorder;
+
+  IREE_STATISTICS(
+      iree_hal_vulkan_direct_command_buffer_statistics_t statistics;)
 } iree_hal_vulkan_direct_command_buffer_t;
 
 namespace {
@@ -77,6 +144,36 @@ iree_hal_vulkan_direct_command_buffer_cast(
   return (iree_hal_vulkan_direct_command_buffer_t*)base_value;
 }
 
+// Clears all tracked state; the next commands will bind everything again.
+static void iree_hal_vulkan_direct_command_buffer_reset_bound_state(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer) {
+  iree_hal_vulkan_bound_state_t* state = &command_buffer->bound_state;
+  state->pipeline = VK_NULL_HANDLE;
+  state->descriptor_set_layout = VK_NULL_HANDLE;
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(state->descriptor_sets);
+       ++i) {
+    state->descriptor_sets[i].valid = false;
+  }
+  state->push_constant_layout = VK_NULL_HANDLE;
+  state->push_constant_valid_words = 0;
+  state->push_constants_disturbed = false;
+}
+
+// Invalidates the tracked state after a builtin executable bound its own
+// pipeline, descriptor set, and push constants. Push constants the user has
+// pushed are kept so they can be restored before the next user dispatch.
+static void iree_hal_vulkan_direct_command_buffer_disturb_bound_state(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer) {
+  iree_hal_vulkan_bound_state_t* state = &command_buffer->bound_state;
+  state->pipeline = VK_NULL_HANDLE;
+  state->descriptor_set_layout = VK_NULL_HANDLE;
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(state->descriptor_sets);
+       ++i) {
+    state->descriptor_sets[i].valid = false;
+  }
+  state->push_constants_disturbed = state->push_constant_valid_words != 0;
+}
+
 iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     iree_hal_device_t* device,
     iree::hal::vulkan::VkDeviceHandle* logical_device,
@@ -87,6 +184,7 @@ iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     iree_hal_vulkan_tracing_context_t* tracing_context,
     iree::hal::vulkan::DescriptorPoolCache* descriptor_pool_cache,
     iree::hal::vulkan::BuiltinExecutables* builtin_executables,
+    iree_hal_vulkan_dispatch_profiler_t* dispatch_profiler,
     iree_arena_block_pool_t* block_pool,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(logical_device);
@@ -121,12 +219,33 @@ iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     command_buffer->command_pool = command_pool;
     command_buffer->handle = handle;
     command_buffer->syms = logical_device->syms().get();
+    if (iree_all_bits_set(command_categories,
+                          IREE_HAL_COMMAND_CATEGORY_DISPATCH)) {
+      command_buffer->supported_stage_mask = ~0u;
+      command_buffer->supported_access_mask = ~0u;
+    } else {
+      command_buffer->supported_stage_mask =
+          VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT |
+          VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT;
+      command_buffer->supported_access_mask =
+          VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+          VK_ACCESS_HOST_READ_BIT | VK_ACCESS_HOST_WRITE_BIT |
+          VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    }
+    command_buffer->device_allocator = iree_hal_device_allocator(device);
+    command_buffer->fill_scratch_buffer = NULL;
+    command_buffer->fill_scratch_offset = 0;
 
     new (&command_buffer->descriptor_set_arena)
         DescriptorSetArena(descriptor_pool_cache);
     new (&command_buffer->descriptor_set_group) DescriptorSetGroup();
 
     command_buffer->builtin_executables = builtin_executables;
+    iree_hal_vulkan_direct_command_buffer_reset_bound_state(command_buffer);
+    iree_hal_vulkan_dispatch_recorder_initialize(
+        dispatch_profiler, &command_buffer->dispatch_recorder);
+    IREE_STATISTICS(memset(&command_buffer->statistics, 0,
+                           sizeof(command_buffer->statistics)));
     status = iree_hal_resource_set_allocate(block_pool,
                                             &command_buffer->resource_set);
   }
@@ -145,8 +264,16 @@ static void iree_hal_vulkan_direct_command_buffer_reset(
     iree_hal_vulkan_direct_command_buffer_t* command_buffer) {
   // NOTE: we require that command buffers not be recorded while they are
   // in-flight so this is safe.
+  // The recorded entry point names are owned by executables in the resource
+  // set so the timestamps must be collected first.
+  iree_hal_vulkan_dispatch_recorder_collect(&command_buffer->dispatch_recorder);
   IREE_IGNORE_ERROR(command_buffer->descriptor_set_group.Reset());
   iree_hal_resource_set_reset(command_buffer->resource_set);
+  command_buffer->fill_scratch_buffer = NULL;
+  command_buffer->fill_scratch_offset = 0;
+  iree_hal_vulkan_direct_command_buffer_reset_bound_state(command_buffer);
+  IREE_STATISTICS(memset(&command_buffer->statistics, 0,
+                         sizeof(command_buffer->statistics)));
 }
 
 bool iree_hal_vulkan_direct_command_buffer_isa(
@@ -173,6 +300,8 @@ static void iree_hal_vulkan_direct_command_buffer_destroy(
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_vulkan_direct_command_buffer_reset(command_buffer);
+  iree_hal_vulkan_dispatch_recorder_deinitialize(
+      &command_buffer->dispatch_recorder);
   command_buffer->command_pool->Free(command_buffer->handle);
 
   command_buffer->descriptor_set_group.~DescriptorSetGroup();
@@ -194,6 +323,15 @@ VkCommandBuffer iree_hal_vulkan_direct_command_buffer_handle(
   return command_buffer->handle;
 }
 
+void iree_hal_vulkan_direct_command_buffer_query_statistics(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_vulkan_direct_command_buffer_statistics_t* out_statistics) {
+  iree_hal_vulkan_direct_command_buffer_t* command_buffer =
+      iree_hal_vulkan_direct_command_buffer_cast(base_command_buffer);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  IREE_STATISTICS(*out_statistics = command_buffer->statistics);
+}
+
 static iree_status_t iree_hal_vulkan_direct_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_vulkan_direct_command_buffer_t* command_buffer =
@@ -239,6 +377,14 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_end(
   command_buffer->descriptor_set_group =
       command_buffer->descriptor_set_arena.Flush();
 
+  IREE_STATISTICS({
+    IREE_TRACE_PLOT_VALUE_I64(
+        "iree_hal_vulkan_direct_command_buffer_elided_commands",
+        (int64_t)(command_buffer->statistics.elided_pipeline_binds +
+                  command_buffer->statistics.elided_push_constants +
+                  command_buffer->statistics.elided_descriptor_set_binds));
+  });
+
   return iree_ok_status();
 }
 
@@ -285,7 +431,11 @@ static void iree_hal_vulkan_direct_command_buffer_end_debug_group(
                              command_buffer->handle);
 }
 
+// Converts |stage_mask| to the stages supported by |command_buffer|. Stages the
+// queue doesn't support can't have any work in them and are dropped; if none
+// remain we conservatively use all commands as Vulkan requires a non-zero mask.
 static VkPipelineStageFlags iree_hal_vulkan_convert_pipeline_stage_flags(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
     iree_hal_execution_stage_t stage_mask) {
   VkPipelineStageFlags flags = 0;
   flags |= iree_any_bit_set(stage_mask, IREE_HAL_EXECUTION_STAGE_COMMAND_ISSUE)
@@ -307,10 +457,12 @@ static VkPipelineStageFlags iree_hal_vulkan_convert_pipeline_stage_flags(
   flags |= iree_any_bit_set(stage_mask, IREE_HAL_EXECUTION_STAGE_HOST)
                ? VK_PIPELINE_STAGE_HOST_BIT
                : 0;
-  return flags;
+  flags &= command_buffer->supported_stage_mask;
+  return flags ? flags : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 }
 
 static VkAccessFlags iree_hal_vulkan_convert_access_mask(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
     iree_hal_access_scope_t access_mask) {
   VkAccessFlags flags = 0;
   flags |=
@@ -344,7 +496,7 @@ static VkAccessFlags iree_hal_vulkan_convert_access_mask(
   flags |= iree_any_bit_set(access_mask, IREE_HAL_ACCESS_SCOPE_MEMORY_WRITE)
                ? VK_ACCESS_MEMORY_WRITE_BIT
                : 0;
-  return flags;
+  return flags & command_buffer->supported_access_mask;
 }
 
 static iree_status_t iree_hal_vulkan_direct_command_buffer_execution_barrier(
@@ -368,10 +520,10 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_execution_barrier(
     VkMemoryBarrier* info = iree_inline_array_at(memory_barrier_infos, i);
     info->sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
     info->pNext = NULL;
-    info->srcAccessMask =
-        iree_hal_vulkan_convert_access_mask(memory_barrier.source_scope);
-    info->dstAccessMask =
-        iree_hal_vulkan_convert_access_mask(memory_barrier.target_scope);
+    info->srcAccessMask = iree_hal_vulkan_convert_access_mask(
+        command_buffer, memory_barrier.source_scope);
+    info->dstAccessMask = iree_hal_vulkan_convert_access_mask(
+        command_buffer, memory_barrier.target_scope);
   }
 
   iree_inline_array(VkBufferMemoryBarrier, buffer_barrier_infos,
@@ -381,10 +533,10 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_execution_barrier(
     VkBufferMemoryBarrier* info = iree_inline_array_at(buffer_barrier_infos, i);
     info->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
     info->pNext = NULL;
-    info->srcAccessMask =
-        iree_hal_vulkan_convert_access_mask(buffer_barrier.source_scope);
-    info->dstAccessMask =
-        iree_hal_vulkan_convert_access_mask(buffer_barrier.target_scope);
+    info->srcAccessMask = iree_hal_vulkan_convert_access_mask(
+        command_buffer, buffer_barrier.source_scope);
+    info->dstAccessMask = iree_hal_vulkan_convert_access_mask(
+        command_buffer, buffer_barrier.target_scope);
     info->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     info->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     info->buffer = iree_hal_vulkan_vma_buffer_handle(
@@ -395,8 +547,10 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_execution_barrier(
 
   command_buffer->syms->vkCmdPipelineBarrier(
       command_buffer->handle,
-      iree_hal_vulkan_convert_pipeline_stage_flags(source_stage_mask),
-      iree_hal_vulkan_convert_pipeline_stage_flags(target_stage_mask),
+      iree_hal_vulkan_convert_pipeline_stage_flags(command_buffer,
+                                                   source_stage_mask),
+      iree_hal_vulkan_convert_pipeline_stage_flags(command_buffer,
+                                                   target_stage_mask),
       /*dependencyFlags=*/0, (uint32_t)memory_barrier_count,
       iree_inline_array_data(memory_barrier_infos),
       (uint32_t)buffer_barrier_count,
@@ -419,7 +573,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_signal_event(
 
   command_buffer->syms->vkCmdSetEvent(
       command_buffer->handle, iree_hal_vulkan_native_event_handle(event),
-      iree_hal_vulkan_convert_pipeline_stage_flags(source_stage_mask));
+      iree_hal_vulkan_convert_pipeline_stage_flags(command_buffer,
+                                                   source_stage_mask));
 
   return iree_ok_status();
 }
@@ -435,7 +590,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_reset_event(
 
   command_buffer->syms->vkCmdResetEvent(
       command_buffer->handle, iree_hal_vulkan_native_event_handle(event),
-      iree_hal_vulkan_convert_pipeline_stage_flags(source_stage_mask));
+      iree_hal_vulkan_convert_pipeline_stage_flags(command_buffer,
+                                                   source_stage_mask));
 
   return iree_ok_status();
 }
@@ -470,10 +626,10 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_wait_events(
     VkMemoryBarrier* info = iree_inline_array_at(memory_barrier_infos, i);
     info->sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
     info->pNext = NULL;
-    info->srcAccessMask =
-        iree_hal_vulkan_convert_access_mask(memory_barrier.source_scope);
-    info->dstAccessMask =
-        iree_hal_vulkan_convert_access_mask(memory_barrier.target_scope);
+    info->srcAccessMask = iree_hal_vulkan_convert_access_mask(
+        command_buffer, memory_barrier.source_scope);
+    info->dstAccessMask = iree_hal_vulkan_convert_access_mask(
+        command_buffer, memory_barrier.target_scope);
   }
 
   iree_inline_array(VkBufferMemoryBarrier, buffer_barrier_infos,
@@ -483,10 +639,10 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_wait_events(
     VkBufferMemoryBarrier* info = iree_inline_array_at(buffer_barrier_infos, i);
     info->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
     info->pNext = NULL;
-    info->srcAccessMask =
-        iree_hal_vulkan_convert_access_mask(buffer_barrier.source_scope);
-    info->dstAccessMask =
-        iree_hal_vulkan_convert_access_mask(buffer_barrier.target_scope);
+    info->srcAccessMask = iree_hal_vulkan_convert_access_mask(
+        command_buffer, buffer_barrier.source_scope);
+    info->dstAccessMask = iree_hal_vulkan_convert_access_mask(
+        command_buffer, buffer_barrier.target_scope);
     info->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     info->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     info->buffer = iree_hal_vulkan_vma_buffer_handle(
@@ -498,8 +654,10 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_wait_events(
   command_buffer->syms->vkCmdWaitEvents(
       command_buffer->handle, (uint32_t)event_count,
       iree_inline_array_data(event_handles),
-      iree_hal_vulkan_convert_pipeline_stage_flags(source_stage_mask),
-      iree_hal_vulkan_convert_pipeline_stage_flags(target_stage_mask),
+      iree_hal_vulkan_convert_pipeline_stage_flags(command_buffer,
+                                                   source_stage_mask),
+      iree_hal_vulkan_convert_pipeline_stage_flags(command_buffer,
+                                                   target_stage_mask),
       (uint32_t)memory_barrier_count,
       iree_inline_array_data(memory_barrier_infos),
       (uint32_t)buffer_barrier_count,
@@ -540,6 +698,68 @@ static uint32_t iree_hal_vulkan_splat_pattern(const void* pattern,
   }
 }
 
+// Size of the scratch buffers used for unaligned fills in transfer-only command
+// buffers. Each unaligned fill uses one 4-byte slot.
+#define IREE_HAL_VULKAN_FILL_SCRATCH_BUFFER_SIZE 1024
+
+// Copies |length| (< 4) bytes of |pattern| into |target_device_buffer| at the
+// unaligned |target_offset| without using a dispatch. vkCmdFillBuffer requires
+// 4 byte alignment but vkCmdCopyBuffer does not so the pattern is splatted
+// into a scratch slot and copied from there. |target_offset| must be aligned to
+// the pattern length so that the copy starts at the beginning of the pattern.
+static iree_status_t iree_hal_vulkan_direct_command_buffer_fill_unaligned(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
+    VkBuffer target_device_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length, uint32_t dword_pattern) {
+  if (length == 0) return iree_ok_status();
+
+  if (!command_buffer->fill_scratch_buffer ||
+      command_buffer->fill_scratch_offset + 4 >
+          IREE_HAL_VULKAN_FILL_SCRATCH_BUFFER_SIZE) {
+    iree_hal_buffer_t* scratch_buffer = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+        command_buffer->device_allocator, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+        IREE_HAL_BUFFER_USAGE_TRANSFER,
+        IREE_HAL_VULKAN_FILL_SCRATCH_BUFFER_SIZE, iree_const_byte_span_empty(),
+        &scratch_buffer));
+    iree_status_t status = iree_hal_resource_set_insert(
+        command_buffer->resource_set, 1, &scratch_buffer);
+    iree_hal_buffer_release(scratch_buffer);
+    IREE_RETURN_IF_ERROR(status);
+    command_buffer->fill_scratch_buffer = scratch_buffer;
+    command_buffer->fill_scratch_offset = 0;
+  }
+  VkBuffer scratch_device_buffer = iree_hal_vulkan_vma_buffer_handle(
+      iree_hal_buffer_allocated_buffer(command_buffer->fill_scratch_buffer));
+  VkDeviceSize scratch_offset =
+      iree_hal_buffer_byte_offset(command_buffer->fill_scratch_buffer) +
+      command_buffer->fill_scratch_offset;
+  command_buffer->fill_scratch_offset += 4;
+
+  command_buffer->syms->vkCmdFillBuffer(command_buffer->handle,
+                                        scratch_device_buffer, scratch_offset,
+                                        4, dword_pattern);
+
+  VkMemoryBarrier barrier;
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.pNext = NULL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  command_buffer->syms->vkCmdPipelineBarrier(
+      command_buffer->handle, VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT, /*dependencyFlags=*/0, 1, &barrier, 0,
+      NULL, 0, NULL);
+
+  VkBufferCopy region;
+  region.srcOffset = scratch_offset;
+  region.dstOffset = target_offset;
+  region.size = length;
+  command_buffer->syms->vkCmdCopyBuffer(command_buffer->handle,
+                                        scratch_device_buffer,
+                                        target_device_buffer, 1, &region);
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_vulkan_direct_command_buffer_fill_buffer(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
@@ -557,6 +777,31 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_fill_buffer(
   // length. We use a polyfill here that fills the unaligned start and end of
   // fill operations, if needed.
 
+  if ((target_offset % 4 != 0 || length % 4 != 0) &&
+      !iree_all_bits_set(command_buffer->base.allowed_categories,
+                         IREE_HAL_COMMAND_CATEGORY_DISPATCH)) {
+    // Transfer-only command buffers may execute on queues that can't run the
+    // builtin fill dispatch so copy the unaligned start and end instead.
+    target_offset += iree_hal_buffer_byte_offset(target_buffer);
+    uint32_t dword_pattern =
+        iree_hal_vulkan_splat_pattern(pattern, pattern_length);
+    iree_device_size_t target_end = target_offset + length;
+    iree_device_size_t head_end =
+        iree_min(iree_device_align(target_offset, 4), target_end);
+    iree_device_size_t tail_offset = iree_max(head_end, (target_end / 4) * 4);
+    IREE_RETURN_IF_ERROR(iree_hal_vulkan_direct_command_buffer_fill_unaligned(
+        command_buffer, target_device_buffer, target_offset,
+        head_end - target_offset, dword_pattern));
+    if (tail_offset > head_end) {
+      command_buffer->syms->vkCmdFillBuffer(
+          command_buffer->handle, target_device_buffer, head_end,
+          tail_offset - head_end, dword_pattern);
+    }
+    return iree_hal_vulkan_direct_command_buffer_fill_unaligned(
+        command_buffer, target_device_buffer, tail_offset,
+        target_end - tail_offset, dword_pattern);
+  }
+
   if (target_offset % 4 != 0 || length % 4 != 0) {
     // TODO(scotttodd): only restore push constants that have been modified?
     //                  (this can pass uninitialized memory right now, which
@@ -565,7 +810,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_fill_buffer(
         command_buffer->builtin_executables->FillBufferUnaligned(
             command_buffer->handle, &(command_buffer->descriptor_set_arena),
             target_buffer, target_offset, length, pattern, pattern_length,
-            command_buffer->push_constants_storage));
+            /*push_constants_to_restore=*/NULL));
+    iree_hal_vulkan_direct_command_buffer_disturb_bound_state(command_buffer);
 
     // Continue using vkCmdFillBuffer below, but only for the inner aligned
     // portion of the fill operation.
@@ -658,26 +904,181 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_copy_buffer(
   return iree_ok_status();
 }
 
+// Binds |pipeline| for compute unless it is already bound.
+static void iree_hal_vulkan_direct_command_buffer_bind_pipeline(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
+    VkPipeline pipeline) {
+  if (command_buffer->bound_state.pipeline == pipeline) {
+    IREE_STATISTICS(++command_buffer->statistics.elided_pipeline_binds);
+    return;
+  }
+  command_buffer->syms->vkCmdBindPipeline(
+      command_buffer->handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+  command_buffer->bound_state.pipeline = pipeline;
+}
+
+// Pushes the tracked push constants again if a builtin executable overwrote
+// them since they were pushed.
+static void iree_hal_vulkan_direct_command_buffer_restore_push_constants(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer) {
+  iree_hal_vulkan_bound_state_t* state = &command_buffer->bound_state;
+  if (!state->push_constants_disturbed) return;
+  state->push_constants_disturbed = false;
+
+  // Push each contiguous run of known words.
+  uint64_t words = state->push_constant_valid_words;
+  while (words) {
+    int first_word = iree_math_count_trailing_zeros_u64(words);
+    uint64_t run = ~(words >> first_word);
+    int word_count =
+        run ? iree_math_count_trailing_zeros_u64(run) : 64 - first_word;
+    command_buffer->syms->vkCmdPushConstants(
+        command_buffer->handle, state->push_constant_layout,
+        VK_SHADER_STAGE_COMPUTE_BIT, (uint32_t)(first_word * sizeof(uint32_t)),
+        (uint32_t)(word_count * sizeof(uint32_t)),
+        &state->push_constants[first_word]);
+    uint64_t run_mask =
+        word_count == 64 ? ~0ull : ((1ull << word_count) - 1) << first_word;
+    words &= ~run_mask;
+  }
+}
+
+// Returns the tracked state of descriptor |set| when bound with
+// |layout_handle| or NULL if the set can't be tracked.
+static iree_hal_vulkan_bound_descriptor_set_t*
+iree_hal_vulkan_direct_command_buffer_lookup_bound_descriptor_set(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
+    VkPipelineLayout layout_handle, uint32_t set) {
+  iree_hal_vulkan_bound_state_t* state = &command_buffer->bound_state;
+  if (state->descriptor_set_layout != layout_handle) {
+    // Binding with a different layout may disturb sets bound with the prior
+    // one; we don't check for layout compatibility and just forget them all.
+    for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(state->descriptor_sets);
+         ++i) {
+      state->descriptor_sets[i].valid = false;
+    }
+    state->descriptor_set_layout = layout_handle;
+  }
+  if (set >= IREE_ARRAYSIZE(state->descriptor_sets)) return NULL;
+  return &state->descriptor_sets[set];
+}
+
+static bool iree_hal_vulkan_descriptor_set_bindings_equal(
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* lhs,
+    const iree_hal_descriptor_set_binding_t* rhs) {
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    if (lhs[i].binding != rhs[i].binding || lhs[i].buffer != rhs[i].buffer ||
+        lhs[i].offset != rhs[i].offset || lhs[i].length != rhs[i].length) {
+      return false;
+    }
+  }
+  return true;
+}
+
 static iree_status_t iree_hal_vulkan_direct_command_buffer_push_constants(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
     const void* values, iree_host_size_t values_length) {
   iree_hal_vulkan_direct_command_buffer_t* command_buffer =
       iree_hal_vulkan_direct_command_buffer_cast(base_command_buffer);
+  iree_hal_vulkan_bound_state_t* state = &command_buffer->bound_state;
+  VkPipelineLayout layout_handle =
+      iree_hal_vulkan_native_executable_layout_handle(executable_layout);
+
+  // Only whole words within the tracked range are tracked. Vulkan requires
+  // push constant offsets and sizes to be multiples of 4 anyway.
+  bool is_tracked =
+      offset % sizeof(uint32_t) == 0 && values_length % sizeof(uint32_t) == 0 &&
+      offset + values_length <= sizeof(state->push_constants);
+  uint64_t word_mask = 0;
+  if (is_tracked && values_length > 0) {
+    iree_host_size_t word_count = values_length / sizeof(uint32_t);
+    word_mask = (word_count == 64 ? ~0ull : ((1ull << word_count) - 1))
+                << (offset / sizeof(uint32_t));
+  }
 
-  iree_host_size_t storage_size =
-      IREE_ARRAYSIZE(command_buffer->push_constants_storage);
-  if (offset < storage_size) {
-    memcpy(command_buffer->push_constants_storage + offset, values,
-           std::min(values_length, storage_size) - offset);
+  if (state->push_constant_layout != layout_handle) {
+    // Values pushed with another layout are not guaranteed to be preserved.
+    state->push_constant_layout = layout_handle;
+    state->push_constant_valid_words = 0;
+    state->push_constants_disturbed = false;
+  } else if (is_tracked && !state->push_constants_disturbed &&
+             iree_all_bits_set(state->push_constant_valid_words, word_mask) &&
+             memcmp((const uint8_t*)state->push_constants + offset, values,
+                    values_length) == 0) {
+    IREE_STATISTICS(++command_buffer->statistics.elided_push_constants);
+    return iree_ok_status();
   }
+  iree_hal_vulkan_direct_command_buffer_restore_push_constants(command_buffer);
 
   command_buffer->syms->vkCmdPushConstants(
-      command_buffer->handle,
-      iree_hal_vulkan_native_executable_layout_handle(executable_layout),
-      VK_SHADER_STAGE_COMPUTE_BIT, (uint32_t)offset, (uint32_t)values_length,
-      values);
+      command_buffer->handle, layout_handle, VK_SHADER_STAGE_COMPUTE_BIT,
+      (uint32_t)offset, (uint32_t)values_length, values);
+
+  if (is_tracked) {
+    memcpy((uint8_t*)state->push_constants + offset, values, values_length);
+    state->push_constant_valid_words |= word_mask;
+  }
+
+  return iree_ok_status();
+}
 
+// Maximum number of binding addresses pushed with a single vkCmdPushConstants.
+#define IREE_HAL_VULKAN_MAX_PUSHED_BINDING_ADDRESSES 16
+
+// Pushes the device addresses of |bindings| into the push constant slots of
+// |set| for executable layouts using buffer device addresses. Bindings with
+// consecutive slots are pushed together and values matching those already
+// pushed are elided like any other push constants.
+static iree_status_t
+iree_hal_vulkan_direct_command_buffer_push_binding_addresses(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert_span(
+      command_buffer->resource_set, binding_count, &bindings[0].buffer,
+      sizeof(bindings[0])));
+
+  uint64_t run_addresses[IREE_HAL_VULKAN_MAX_PUSHED_BINDING_ADDRESSES];
+  iree_host_size_t run_length = 0;
+  uint32_t run_offset = 0;
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    uint32_t offset = 0;
+    IREE_RETURN_IF_ERROR(
+        iree_hal_vulkan_native_executable_layout_binding_address_offset(
+            executable_layout, set, bindings[i].binding, &offset));
+    uint64_t address = 0;
+    if (bindings[i].buffer) {
+      VkBufferDeviceAddressInfoKHR address_info;
+      address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
+      address_info.pNext = NULL;
+      address_info.buffer = iree_hal_vulkan_vma_buffer_handle(
+          iree_hal_buffer_allocated_buffer(bindings[i].buffer));
+      address = command_buffer->syms->vkGetBufferDeviceAddressKHR(
+                    *command_buffer->logical_device, &address_info) +
+                iree_hal_buffer_byte_offset(bindings[i].buffer) +
+                bindings[i].offset;
+    }
+
+    // Flush the pending run if this binding doesn't extend it.
+    if (run_length > 0 &&
+        (offset != run_offset + run_length * sizeof(uint64_t) ||
+         run_length == IREE_ARRAYSIZE(run_addresses))) {
+      IREE_RETURN_IF_ERROR(iree_hal_vulkan_direct_command_buffer_push_constants(
+          &command_buffer->base, executable_layout, run_offset, run_addresses,
+          run_length * sizeof(uint64_t)));
+      run_length = 0;
+    }
+    if (run_length == 0) run_offset = offset;
+    run_addresses[run_length++] = address;
+  }
+  if (run_length > 0) {
+    IREE_RETURN_IF_ERROR(iree_hal_vulkan_direct_command_buffer_push_constants(
+        &command_buffer->base, executable_layout, run_offset, run_addresses,
+        run_length * sizeof(uint64_t)));
+  }
   return iree_ok_status();
 }
 
@@ -689,16 +1090,46 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_push_descriptor_set(
   iree_hal_vulkan_direct_command_buffer_t* command_buffer =
       iree_hal_vulkan_direct_command_buffer_cast(base_command_buffer);
 
-  // TODO(benvanik): batch insert by getting the resources in their own list.
-  for (iree_host_size_t i = 0; i < binding_count; ++i) {
-    IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
-        command_buffer->resource_set, 1, &bindings[i].buffer));
+  if (iree_hal_vulkan_native_executable_layout_uses_buffer_device_addresses(
+          executable_layout)) {
+    return iree_hal_vulkan_direct_command_buffer_push_binding_addresses(
+        command_buffer, executable_layout, set, binding_count, bindings);
+  }
+
+  // If the same bindings are already bound to the set there's no need to bind
+  // again (or to insert the resources, which are already retained).
+  iree_hal_vulkan_bound_descriptor_set_t* bound_set =
+      iree_hal_vulkan_direct_command_buffer_lookup_bound_descriptor_set(
+          command_buffer,
+          iree_hal_vulkan_native_executable_layout_handle(executable_layout),
+          set);
+  if (bound_set && bound_set->valid && bound_set->handle == VK_NULL_HANDLE &&
+      bound_set->binding_count == binding_count &&
+      iree_hal_vulkan_descriptor_set_bindings_equal(
+          binding_count, bound_set->bindings, bindings)) {
+    IREE_STATISTICS(++command_buffer->statistics.elided_descriptor_set_binds);
+    return iree_ok_status();
   }
 
+  IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert_span(
+      command_buffer->resource_set, binding_count, &bindings[0].buffer,
+      sizeof(bindings[0])));
+
   // Either allocate, update, and bind a descriptor set or use push descriptor
   // sets to use the command buffer pool when supported.
-  return command_buffer->descriptor_set_arena.BindDescriptorSet(
-      command_buffer->handle, executable_layout, set, binding_count, bindings);
+  if (bound_set) bound_set->valid = false;
+  IREE_RETURN_IF_ERROR(command_buffer->descriptor_set_arena.BindDescriptorSet(
+      command_buffer->handle, executable_layout, set, binding_count, bindings));
+  if (bound_set &&
+      binding_count <= IREE_ARRAYSIZE(bound_set->bindings)) {
+    bound_set->valid = true;
+    bound_set->handle = VK_NULL_HANDLE;
+    bound_set->binding_count = binding_count;
+    memcpy(bound_set->bindings, bindings,
+           binding_count * sizeof(bound_set->bindings[0]));
+    bound_set->dynamic_offset_count = 0;
+  }
+  return iree_ok_status();
 }
 
 static iree_status_t iree_hal_vulkan_direct_command_buffer_bind_descriptor_set(
@@ -712,6 +1143,32 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_bind_descriptor_set(
   iree_allocator_t host_allocator =
       command_buffer->logical_device->host_allocator();
 
+  if (iree_hal_vulkan_native_executable_layout_uses_buffer_device_addresses(
+          executable_layout)) {
+    // Descriptor set objects don't retain their bindings so there are no
+    // addresses to push.
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "descriptor set objects are not supported with "
+                            "buffer device address bindings; use "
+                            "push_descriptor_set");
+  }
+
+  VkDescriptorSet descriptor_set_handle =
+      iree_hal_vulkan_native_descriptor_set_handle(descriptor_set);
+  iree_hal_vulkan_bound_descriptor_set_t* bound_set =
+      iree_hal_vulkan_direct_command_buffer_lookup_bound_descriptor_set(
+          command_buffer,
+          iree_hal_vulkan_native_executable_layout_handle(executable_layout),
+          set);
+  if (bound_set && bound_set->valid &&
+      bound_set->handle == descriptor_set_handle &&
+      bound_set->dynamic_offset_count == dynamic_offset_count &&
+      memcmp(bound_set->dynamic_offsets, dynamic_offsets,
+             dynamic_offset_count * sizeof(dynamic_offsets[0])) == 0) {
+    IREE_STATISTICS(++command_buffer->statistics.elided_descriptor_set_binds);
+    return iree_ok_status();
+  }
+
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, 1, &descriptor_set));
 
@@ -724,7 +1181,7 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_bind_descriptor_set(
   }
 
   VkDescriptorSet descriptor_sets[1] = {
-      iree_hal_vulkan_native_descriptor_set_handle(descriptor_set),
+      descriptor_set_handle,
   };
   command_buffer->syms->vkCmdBindDescriptorSets(
       command_buffer->handle, VK_PIPELINE_BIND_POINT_COMPUTE,
@@ -735,9 +1192,39 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_bind_descriptor_set(
 
   iree_inline_array_deinitialize(dynamic_offsets_i32);
 
+  if (bound_set) {
+    bound_set->valid =
+        dynamic_offset_count <= IREE_ARRAYSIZE(bound_set->dynamic_offsets);
+    bound_set->handle = descriptor_set_handle;
+    bound_set->binding_count = 0;
+    bound_set->dynamic_offset_count = dynamic_offset_count;
+    if (bound_set->valid) {
+      memcpy(bound_set->dynamic_offsets, dynamic_offsets,
+             dynamic_offset_count * sizeof(dynamic_offsets[0]));
+    }
+  }
+
   return iree_ok_status();
 }
 
+// Writes the starting timestamp of a dispatch of |entry_point| if dispatch
+// profiling is enabled.
+static iree_status_t
+iree_hal_vulkan_direct_command_buffer_begin_profiled_dispatch(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point) {
+  if (!iree_hal_vulkan_dispatch_recorder_is_enabled(
+          &command_buffer->dispatch_recorder)) {
+    return iree_ok_status();
+  }
+  iree_hal_vulkan_source_location_t source_location;
+  iree_hal_vulkan_native_executable_entry_point_source_location(
+      executable, entry_point, &source_location);
+  return iree_hal_vulkan_dispatch_recorder_begin_dispatch(
+      &command_buffer->dispatch_recorder, command_buffer->handle,
+      source_location.func_name);
+}
+
 static iree_status_t iree_hal_vulkan_direct_command_buffer_dispatch(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_t* executable, int32_t entry_point,
@@ -760,16 +1247,25 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_dispatch(
       command_buffer->resource_set, 1, &executable));
 
   // Get the compiled and linked pipeline for the specified entry point and
-  // bind it to the command buffer.
+  // bind it to the command buffer. Executables may have pipelines specialized
+  // for the push constant values last pushed.
+  iree_hal_vulkan_bound_state_t* state = &command_buffer->bound_state;
   VkPipeline pipeline_handle = VK_NULL_HANDLE;
-  IREE_RETURN_IF_ERROR(
-      iree_hal_vulkan_native_executable_pipeline_for_entry_point(
-          executable, entry_point, &pipeline_handle));
-  command_buffer->syms->vkCmdBindPipeline(
-      command_buffer->handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_handle);
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_native_executable_pipeline_for_dispatch(
+      executable, entry_point, IREE_ARRAYSIZE(state->push_constants),
+      state->push_constants, state->push_constant_valid_words,
+      &pipeline_handle));
+  iree_hal_vulkan_direct_command_buffer_bind_pipeline(command_buffer,
+                                                      pipeline_handle);
+  iree_hal_vulkan_direct_command_buffer_restore_push_constants(command_buffer);
 
+  IREE_RETURN_IF_ERROR(
+      iree_hal_vulkan_direct_command_buffer_begin_profiled_dispatch(
+          command_buffer, executable, entry_point));
   command_buffer->syms->vkCmdDispatch(command_buffer->handle, workgroup_x,
                                       workgroup_y, workgroup_z);
+  iree_hal_vulkan_dispatch_recorder_end_dispatch(
+      &command_buffer->dispatch_recorder, command_buffer->handle);
 
   IREE_VULKAN_TRACE_ZONE_END(command_buffer->tracing_context,
                              command_buffer->handle);
@@ -799,19 +1295,28 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_dispatch_indirect(
       source_location.func_name.data, source_location.func_name.size);
 
   // Get the compiled and linked pipeline for the specified entry point and
-  // bind it to the command buffer.
+  // bind it to the command buffer. Executables may have pipelines specialized
+  // for the push constant values last pushed.
+  iree_hal_vulkan_bound_state_t* state = &command_buffer->bound_state;
   VkPipeline pipeline_handle = VK_NULL_HANDLE;
-  IREE_RETURN_IF_ERROR(
-      iree_hal_vulkan_native_executable_pipeline_for_entry_point(
-          executable, entry_point, &pipeline_handle));
-  command_buffer->syms->vkCmdBindPipeline(
-      command_buffer->handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_handle);
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_native_executable_pipeline_for_dispatch(
+      executable, entry_point, IREE_ARRAYSIZE(state->push_constants),
+      state->push_constants, state->push_constant_valid_words,
+      &pipeline_handle));
+  iree_hal_vulkan_direct_command_buffer_bind_pipeline(command_buffer,
+                                                      pipeline_handle);
+  iree_hal_vulkan_direct_command_buffer_restore_push_constants(command_buffer);
 
   VkBuffer workgroups_device_buffer = iree_hal_vulkan_vma_buffer_handle(
       iree_hal_buffer_allocated_buffer(workgroups_buffer));
   workgroups_offset += iree_hal_buffer_byte_offset(workgroups_buffer);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_vulkan_direct_command_buffer_begin_profiled_dispatch(
+          command_buffer, executable, entry_point));
   command_buffer->syms->vkCmdDispatchIndirect(
       command_buffer->handle, workgroups_device_buffer, workgroups_offset);
+  iree_hal_vulkan_dispatch_recorder_end_dispatch(
+      &command_buffer->dispatch_recorder, command_buffer->handle);
 
   IREE_VULKAN_TRACE_ZONE_END(command_buffer->tracing_context,
                              command_buffer->handle);
@@ -11,6 +11,7 @@
 #include "iree/hal/api.h"
 #include "iree/hal/vulkan/builtin_executables.h"
 #include "iree/hal/vulkan/descriptor_pool_cache.h"
+#include "iree/hal/vulkan/dispatch_profiler.h"
 #include "iree/hal/vulkan/handle_util.h"
 #include "iree/hal/vulkan/tracing.h"
 
@@ -22,8 +23,11 @@ typedef struct iree_arena_block_pool_t iree_arena_block_pool_t;
 
 // Creates a command buffer that directly records into a VkCommandBuffer.
 //
-// NOTE: the |block_pool| must remain live for the lifetime of the command
-// buffers that use it.
+// If |dispatch_profiler| is provided timestamps are written around each
+// dispatch and reported to it when the command buffer is reset or destroyed.
+//
+// NOTE: the |block_pool| and |dispatch_profiler| must remain live for the
+// lifetime of the command buffers that use them.
 iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     iree_hal_device_t* device,
     iree::hal::vulkan::VkDeviceHandle* logical_device,
@@ -34,9 +38,28 @@ iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     iree_hal_vulkan_tracing_context_t* tracing_context,
     iree::hal::vulkan::DescriptorPoolCache* descriptor_pool_cache,
     iree::hal::vulkan::BuiltinExecutables* builtin_executables,
+    iree_hal_vulkan_dispatch_profiler_t* dispatch_profiler,
     iree_arena_block_pool_t* block_pool,
     iree_hal_command_buffer_t** out_command_buffer);
 
+// Counts of commands the command buffer elided because they would not have
+// changed the state bound on the VkCommandBuffer. Only tracked when
+// IREE_STATISTICS_ENABLE is set.
+typedef struct iree_hal_vulkan_direct_command_buffer_statistics_t {
+  // vkCmdBindPipeline calls for the pipeline that was already bound.
+  uint64_t elided_pipeline_binds;
+  // vkCmdPushConstants calls for values that were already pushed.
+  uint64_t elided_push_constants;
+  // Descriptor set binds/pushes for sets that were already bound.
+  uint64_t elided_descriptor_set_binds;
+} iree_hal_vulkan_direct_command_buffer_statistics_t;
+
+// Returns the statistics of the current (or last) recording of
+// |command_buffer|. All counters are zero if statistics are disabled.
+void iree_hal_vulkan_direct_command_buffer_query_statistics(
+    iree_hal_command_buffer_t* command_buffer,
+    iree_hal_vulkan_direct_command_buffer_statistics_t* out_statistics);
+
 // Returns the native Vulkan VkCommandBuffer handle.
 VkCommandBuffer iree_hal_vulkan_direct_command_buffer_handle(
     iree_hal_command_buffer_t* command_buffer);
@@ -22,101 +22,143 @@ namespace vulkan {
 
 DirectCommandQueue::DirectCommandQueue(
     VkDeviceHandle* logical_device,
-    iree_hal_command_category_t supported_categories, VkQueue queue)
-    : CommandQueue(logical_device, supported_categories, queue) {}
+    iree_hal_command_category_t supported_categories, VkQueue queue,
+    iree_arena_block_pool_t* block_pool)
+    : CommandQueue(logical_device, supported_categories, queue) {
+  iree_arena_initialize(block_pool, &arena_);
+}
+
+DirectCommandQueue::~DirectCommandQueue() { iree_arena_deinitialize(&arena_); }
+
+// Returns the storage size of an array of |count| elements of type T. Arrays
+// are padded so that each one carved from aligned storage starts aligned.
+template <typename T>
+static iree_host_size_t SubmitArraySize(iree_host_size_t count) {
+  return iree_host_align(count * sizeof(T), iree_max_align_t);
+}
 
-DirectCommandQueue::~DirectCommandQueue() = default;
+// Carves an array of |count| elements of type T from |*storage|.
+template <typename T>
+static T* CarveSubmitArray(uint8_t** storage, iree_host_size_t count) {
+  T* array = reinterpret_cast<T*>(*storage);
+  *storage += SubmitArraySize<T>(count);
+  return array;
+}
+
+// Returns the storage required by TranslateBatchInfo for |batch|.
+static iree_host_size_t CalculateBatchStorageSize(
+    const iree_hal_submission_batch_t* batch) {
+  return SubmitArraySize<VkSemaphore>(batch->wait_semaphores.count) +
+         SubmitArraySize<uint64_t>(batch->wait_semaphores.count) +
+         SubmitArraySize<VkPipelineStageFlags>(batch->wait_semaphores.count) +
+         SubmitArraySize<VkSemaphore>(batch->signal_semaphores.count) +
+         SubmitArraySize<uint64_t>(batch->signal_semaphores.count) +
+         SubmitArraySize<VkCommandBuffer>(batch->command_buffer_count);
+}
 
-iree_status_t DirectCommandQueue::TranslateBatchInfo(
+void DirectCommandQueue::TranslateBatchInfo(
     const iree_hal_submission_batch_t* batch, VkSubmitInfo* submit_info,
-    VkTimelineSemaphoreSubmitInfo* timeline_submit_info, Arena* arena) {
+    VkTimelineSemaphoreSubmitInfo* timeline_submit_info, uint8_t** storage) {
   // TODO(benvanik): see if we can go to finer-grained stages.
   // For example, if this was just queue ownership transfers then we can use
   // the pseudo-stage of VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT.
   VkPipelineStageFlags dst_stage_mask =
       VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 
-  auto wait_semaphore_handles =
-      arena->AllocateSpan<VkSemaphore>(batch->wait_semaphores.count);
-  auto wait_semaphore_values =
-      arena->AllocateSpan<uint64_t>(batch->wait_semaphores.count);
-  auto wait_dst_stage_masks =
-      arena->AllocateSpan<VkPipelineStageFlags>(batch->wait_semaphores.count);
-  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+  const iree_host_size_t wait_count = batch->wait_semaphores.count;
+  VkSemaphore* wait_semaphore_handles =
+      CarveSubmitArray<VkSemaphore>(storage, wait_count);
+  uint64_t* wait_semaphore_values =
+      CarveSubmitArray<uint64_t>(storage, wait_count);
+  VkPipelineStageFlags* wait_dst_stage_masks =
+      CarveSubmitArray<VkPipelineStageFlags>(storage, wait_count);
+  for (iree_host_size_t i = 0; i < wait_count; ++i) {
     wait_semaphore_handles[i] = iree_hal_vulkan_native_semaphore_handle(
         batch->wait_semaphores.semaphores[i]);
     wait_semaphore_values[i] = batch->wait_semaphores.payload_values[i];
     wait_dst_stage_masks[i] = dst_stage_mask;
   }
 
-  auto signal_semaphore_handles =
-      arena->AllocateSpan<VkSemaphore>(batch->signal_semaphores.count);
-  auto signal_semaphore_values =
-      arena->AllocateSpan<uint64_t>(batch->signal_semaphores.count);
-  for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+  const iree_host_size_t signal_count = batch->signal_semaphores.count;
+  VkSemaphore* signal_semaphore_handles =
+      CarveSubmitArray<VkSemaphore>(storage, signal_count);
+  uint64_t* signal_semaphore_values =
+      CarveSubmitArray<uint64_t>(storage, signal_count);
+  for (iree_host_size_t i = 0; i < signal_count; ++i) {
     signal_semaphore_handles[i] = iree_hal_vulkan_native_semaphore_handle(
         batch->signal_semaphores.semaphores[i]);
     signal_semaphore_values[i] = batch->signal_semaphores.payload_values[i];
   }
 
-  auto command_buffer_handles =
-      arena->AllocateSpan<VkCommandBuffer>(batch->command_buffer_count);
-  for (iree_host_size_t i = 0; i < batch->command_buffer_count; ++i) {
+  const iree_host_size_t command_buffer_count = batch->command_buffer_count;
+  VkCommandBuffer* command_buffer_handles =
+      CarveSubmitArray<VkCommandBuffer>(storage, command_buffer_count);
+  for (iree_host_size_t i = 0; i < command_buffer_count; ++i) {
     command_buffer_handles[i] =
         iree_hal_vulkan_direct_command_buffer_handle(batch->command_buffers[i]);
   }
 
   submit_info->sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
   submit_info->pNext = timeline_submit_info;
-  submit_info->waitSemaphoreCount =
-      static_cast<uint32_t>(wait_semaphore_handles.size());
-  submit_info->pWaitSemaphores = wait_semaphore_handles.data();
-  submit_info->pWaitDstStageMask = wait_dst_stage_masks.data();
+  submit_info->waitSemaphoreCount = static_cast<uint32_t>(wait_count);
+  submit_info->pWaitSemaphores = wait_semaphore_handles;
+  submit_info->pWaitDstStageMask = wait_dst_stage_masks;
   submit_info->commandBufferCount =
-      static_cast<uint32_t>(command_buffer_handles.size());
-  submit_info->pCommandBuffers = command_buffer_handles.data();
-  submit_info->signalSemaphoreCount =
-      static_cast<uint32_t>(signal_semaphore_handles.size());
-  submit_info->pSignalSemaphores = signal_semaphore_handles.data();
+      static_cast<uint32_t>(command_buffer_count);
+  submit_info->pCommandBuffers = command_buffer_handles;
+  submit_info->signalSemaphoreCount = static_cast<uint32_t>(signal_count);
+  submit_info->pSignalSemaphores = signal_semaphore_handles;
 
   timeline_submit_info->sType =
       VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
   timeline_submit_info->pNext = nullptr;
   timeline_submit_info->waitSemaphoreValueCount =
-      static_cast<uint32_t>(wait_semaphore_values.size());
-  timeline_submit_info->pWaitSemaphoreValues = wait_semaphore_values.data();
+      static_cast<uint32_t>(wait_count);
+  timeline_submit_info->pWaitSemaphoreValues = wait_semaphore_values;
   timeline_submit_info->signalSemaphoreValueCount =
-      static_cast<uint32_t>(signal_semaphore_values.size());
-  timeline_submit_info->pSignalSemaphoreValues = signal_semaphore_values.data();
-
-  return iree_ok_status();
+      static_cast<uint32_t>(signal_count);
+  timeline_submit_info->pSignalSemaphoreValues = signal_semaphore_values;
 }
 
 iree_status_t DirectCommandQueue::Submit(
     iree_host_size_t batch_count, const iree_hal_submission_batch_t* batches) {
   IREE_TRACE_SCOPE0("DirectCommandQueue::Submit");
 
-  // Map the submission batches to VkSubmitInfos.
-  // Note that we must keep all arrays referenced alive until submission
-  // completes and since there are a bunch of them we use an arena.
-  Arena arena(4 * 1024);
-  auto submit_infos = arena.AllocateSpan<VkSubmitInfo>(batch_count);
-  auto timeline_submit_infos =
-      arena.AllocateSpan<VkTimelineSemaphoreSubmitInfo>(batch_count);
-  for (int i = 0; i < batch_count; ++i) {
-    IREE_RETURN_IF_ERROR(TranslateBatchInfo(&batches[i], &submit_infos[i],
-                                            &timeline_submit_infos[i], &arena));
+  // Map the submission batches to VkSubmitInfos. Everything referenced only
+  // needs to remain live for the duration of vkQueueSubmit and is allocated
+  // as a single chunk sized from the batches. The arena is reset afterward so
+  // in the steady state the blocks are reused from the pool and no heap
+  // allocations are made.
+  iree_host_size_t storage_size =
+      SubmitArraySize<VkSubmitInfo>(batch_count) +
+      SubmitArraySize<VkTimelineSemaphoreSubmitInfo>(batch_count);
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    storage_size += CalculateBatchStorageSize(&batches[i]);
   }
 
   iree_slim_mutex_lock(&queue_mutex_);
-  iree_status_t status = VK_RESULT_TO_STATUS(
-      syms()->vkQueueSubmit(queue_, static_cast<uint32_t>(submit_infos.size()),
-                            submit_infos.data(), VK_NULL_HANDLE),
-      "vkQueueSubmit");
+  uint8_t* storage = NULL;
+  iree_status_t status =
+      iree_arena_allocate(&arena_, storage_size, (void**)&storage);
+  if (iree_status_is_ok(status)) {
+    VkSubmitInfo* submit_infos =
+        CarveSubmitArray<VkSubmitInfo>(&storage, batch_count);
+    VkTimelineSemaphoreSubmitInfo* timeline_submit_infos =
+        CarveSubmitArray<VkTimelineSemaphoreSubmitInfo>(&storage,
+                                                        batch_count);
+    for (iree_host_size_t i = 0; i < batch_count; ++i) {
+      TranslateBatchInfo(&batches[i], &submit_infos[i],
+                         &timeline_submit_infos[i], &storage);
+    }
+    status = VK_RESULT_TO_STATUS(
+        syms()->vkQueueSubmit(queue_, static_cast<uint32_t>(batch_count),
+                              submit_infos, VK_NULL_HANDLE),
+        "vkQueueSubmit");
+  }
+  iree_arena_reset(&arena_);
   iree_slim_mutex_unlock(&queue_mutex_);
-  IREE_RETURN_IF_ERROR(status);
 
-  return iree_ok_status();
+  return status;
 }
 
 iree_status_t DirectCommandQueue::WaitIdle(iree_timeout_t timeout) {
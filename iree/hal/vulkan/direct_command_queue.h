@@ -8,21 +8,24 @@
 #define IREE_HAL_VULKAN_DIRECT_COMMAND_QUEUE_H_
 
 #include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
 #include "iree/hal/api.h"
 #include "iree/hal/vulkan/command_queue.h"
 #include "iree/hal/vulkan/handle_util.h"
-#include "iree/hal/vulkan/util/arena.h"
 
 namespace iree {
 namespace hal {
 namespace vulkan {
 
 // Command queue implementation directly maps to VkQueue.
+//
+// The |block_pool| is used for the per-submission bookkeeping and must remain
+// valid for the lifetime of the queue.
 class DirectCommandQueue final : public CommandQueue {
  public:
   DirectCommandQueue(VkDeviceHandle* logical_device,
                      iree_hal_command_category_t supported_categories,
-                     VkQueue queue);
+                     VkQueue queue, iree_arena_block_pool_t* block_pool);
   ~DirectCommandQueue() override;
 
   iree_status_t Submit(iree_host_size_t batch_count,
@@ -31,9 +34,17 @@ class DirectCommandQueue final : public CommandQueue {
   iree_status_t WaitIdle(iree_timeout_t timeout) override;
 
  private:
-  iree_status_t TranslateBatchInfo(
-      const iree_hal_submission_batch_t* batch, VkSubmitInfo* submit_info,
-      VkTimelineSemaphoreSubmitInfo* timeline_submit_info, Arena* arena);
+  // Translates |batch| into |submit_info| and |timeline_submit_info| with the
+  // arrays they reference carved from |*storage|, which is advanced past them.
+  void TranslateBatchInfo(const iree_hal_submission_batch_t* batch,
+                          VkSubmitInfo* submit_info,
+                          VkTimelineSemaphoreSubmitInfo* timeline_submit_info,
+                          uint8_t** storage);
+
+  // Arena the submit infos and the arrays they reference are allocated from
+  // while translating a submission. Reset after each vkQueueSubmit so that its
+  // blocks are returned to the shared pool.
+  iree_arena_allocator_t arena_ IREE_GUARDED_BY(queue_mutex_);
 };
 
 }  // namespace vulkan
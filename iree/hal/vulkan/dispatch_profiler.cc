@@ -0,0 +1,420 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/vulkan/dispatch_profiler.h"
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/vulkan/dynamic_symbols.h"
+#include "iree/hal/vulkan/status_util.h"
+
+using namespace iree::hal::vulkan;
+
+// Number of dispatches whose begin/end timestamps are stored in each query
+// pool. Small enough that the results of one pool can be read onto the stack.
+#define IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES 64
+
+//===----------------------------------------------------------------------===//
+// iree_hal_vulkan_dispatch_profiler_t
+//===----------------------------------------------------------------------===//
+
+struct iree_hal_vulkan_dispatch_profiler_t {
+  VkDeviceHandle* logical_device;
+  iree_allocator_t host_allocator;
+
+  // Nanoseconds per timestamp tick.
+  double timestamp_period;
+  // Mask of the valid bits of timestamps written on the queue family.
+  uint64_t timestamp_mask;
+
+  // Guards all entries. Each entry name is a separate allocation so that the
+  // names returned from queries remain valid when |entries| grows.
+  iree_slim_mutex_t mutex;
+  iree_host_size_t entry_count;
+  iree_host_size_t entry_capacity;
+  iree_hal_vulkan_dispatch_profile_entry_t* entries;
+};
+
+iree_status_t iree_hal_vulkan_dispatch_profiler_create(
+    VkDeviceHandle* logical_device, VkPhysicalDevice physical_device,
+    uint32_t queue_family_index, iree_allocator_t host_allocator,
+    iree_hal_vulkan_dispatch_profiler_t** out_profiler) {
+  IREE_ASSERT_ARGUMENT(logical_device);
+  IREE_ASSERT_ARGUMENT(out_profiler);
+  *out_profiler = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  const auto& syms = logical_device->syms();
+  uint32_t queue_family_count = 0;
+  syms->vkGetPhysicalDeviceQueueFamilyProperties(physical_device,
+                                                 &queue_family_count, NULL);
+  VkQueueFamilyProperties* queue_family_properties =
+      (VkQueueFamilyProperties*)iree_alloca(queue_family_count *
+                                            sizeof(VkQueueFamilyProperties));
+  syms->vkGetPhysicalDeviceQueueFamilyProperties(
+      physical_device, &queue_family_count, queue_family_properties);
+  uint32_t timestamp_valid_bits =
+      queue_family_index < queue_family_count
+          ? queue_family_properties[queue_family_index].timestampValidBits
+          : 0;
+  if (timestamp_valid_bits == 0) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "queue family %u does not support timestamp "
+                            "queries required for dispatch profiling",
+                            queue_family_index);
+  }
+
+  VkPhysicalDeviceProperties properties;
+  syms->vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+  iree_hal_vulkan_dispatch_profiler_t* profiler = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*profiler),
+                                (void**)&profiler));
+  profiler->logical_device = logical_device;
+  profiler->host_allocator = host_allocator;
+  profiler->timestamp_period = properties.limits.timestampPeriod;
+  profiler->timestamp_mask = timestamp_valid_bits >= 64
+                                 ? UINT64_MAX
+                                 : (1ull << timestamp_valid_bits) - 1;
+  iree_slim_mutex_initialize(&profiler->mutex);
+  profiler->entry_count = 0;
+  profiler->entry_capacity = 0;
+  profiler->entries = NULL;
+
+  *out_profiler = profiler;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_hal_vulkan_dispatch_profiler_destroy(
+    iree_hal_vulkan_dispatch_profiler_t* profiler) {
+  if (!profiler) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator = profiler->host_allocator;
+  iree_hal_vulkan_dispatch_profiler_reset(profiler);
+  iree_allocator_free(host_allocator, profiler->entries);
+  iree_slim_mutex_deinitialize(&profiler->mutex);
+  iree_allocator_free(host_allocator, profiler);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Returns the entry for |name|, inserting a new one if needed.
+// Must be called with the profiler lock held.
+static iree_status_t iree_hal_vulkan_dispatch_profiler_lookup_entry(
+    iree_hal_vulkan_dispatch_profiler_t* profiler, iree_string_view_t name,
+    iree_hal_vulkan_dispatch_profile_entry_t** out_entry) {
+  // Executables have tens to hundreds of entry points; a scan is sufficient.
+  for (iree_host_size_t i = 0; i < profiler->entry_count; ++i) {
+    if (iree_string_view_equal(profiler->entries[i].name, name)) {
+      *out_entry = &profiler->entries[i];
+      return iree_ok_status();
+    }
+  }
+
+  if (profiler->entry_count == profiler->entry_capacity) {
+    iree_host_size_t new_capacity =
+        profiler->entry_capacity ? profiler->entry_capacity * 2 : 32;
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        profiler->host_allocator, new_capacity * sizeof(profiler->entries[0]),
+        (void**)&profiler->entries));
+    profiler->entry_capacity = new_capacity;
+  }
+  char* name_storage = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      profiler->host_allocator, name.size + /*NUL=*/1, (void**)&name_storage));
+  memcpy(name_storage, name.data, name.size);
+  name_storage[name.size] = 0;
+
+  iree_hal_vulkan_dispatch_profile_entry_t* entry =
+      &profiler->entries[profiler->entry_count++];
+  entry->name = iree_make_string_view(name_storage, name.size);
+  entry->dispatch_count = 0;
+  entry->total_duration_ns = 0;
+  entry->min_duration_ns = UINT64_MAX;
+  entry->max_duration_ns = 0;
+  *out_entry = entry;
+  return iree_ok_status();
+}
+
+// Adds a dispatch of |name| that took |duration_ticks| timestamp ticks.
+// Must be called with the profiler lock held.
+static iree_status_t iree_hal_vulkan_dispatch_profiler_record(
+    iree_hal_vulkan_dispatch_profiler_t* profiler, iree_string_view_t name,
+    uint64_t duration_ticks) {
+  iree_hal_vulkan_dispatch_profile_entry_t* entry = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_vulkan_dispatch_profiler_lookup_entry(profiler, name, &entry));
+  uint64_t duration_ns =
+      (uint64_t)((double)duration_ticks * profiler->timestamp_period);
+  ++entry->dispatch_count;
+  entry->total_duration_ns += duration_ns;
+  entry->min_duration_ns = iree_min(entry->min_duration_ns, duration_ns);
+  entry->max_duration_ns = iree_max(entry->max_duration_ns, duration_ns);
+  return iree_ok_status();
+}
+
+static int iree_hal_vulkan_dispatch_profile_entry_compare(const void* lhs_ptr,
+                                                          const void* rhs_ptr) {
+  const iree_hal_vulkan_dispatch_profile_entry_t* lhs =
+      (const iree_hal_vulkan_dispatch_profile_entry_t*)lhs_ptr;
+  const iree_hal_vulkan_dispatch_profile_entry_t* rhs =
+      (const iree_hal_vulkan_dispatch_profile_entry_t*)rhs_ptr;
+  if (lhs->total_duration_ns != rhs->total_duration_ns) {
+    return lhs->total_duration_ns > rhs->total_duration_ns ? -1 : 1;
+  }
+  return iree_string_view_compare(lhs->name, rhs->name);
+}
+
+iree_status_t iree_hal_vulkan_dispatch_profiler_query(
+    iree_hal_vulkan_dispatch_profiler_t* profiler, iree_host_size_t capacity,
+    iree_hal_vulkan_dispatch_profile_entry_t* out_entries,
+    iree_host_size_t* out_count) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_ASSERT_ARGUMENT(out_count);
+  iree_slim_mutex_lock(&profiler->mutex);
+  iree_host_size_t count = profiler->entry_count;
+  *out_count = count;
+  if (capacity < count) {
+    iree_slim_mutex_unlock(&profiler->mutex);
+    return iree_status_from_code(IREE_STATUS_OUT_OF_RANGE);
+  }
+  if (count > 0) {
+    memcpy(out_entries, profiler->entries, count * sizeof(out_entries[0]));
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+  if (count > 0) {
+    qsort(out_entries, count, sizeof(out_entries[0]),
+          iree_hal_vulkan_dispatch_profile_entry_compare);
+  }
+  return iree_ok_status();
+}
+
+void iree_hal_vulkan_dispatch_profiler_reset(
+    iree_hal_vulkan_dispatch_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  iree_slim_mutex_lock(&profiler->mutex);
+  for (iree_host_size_t i = 0; i < profiler->entry_count; ++i) {
+    iree_allocator_free(profiler->host_allocator,
+                        (void*)profiler->entries[i].name.data);
+  }
+  profiler->entry_count = 0;
+  iree_slim_mutex_unlock(&profiler->mutex);
+}
+
+iree_status_t iree_hal_vulkan_dispatch_profiler_fprint(
+    FILE* file, iree_hal_vulkan_dispatch_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(file);
+  IREE_ASSERT_ARGUMENT(profiler);
+
+  // Entries may be added between the size query and the copy.
+  iree_hal_vulkan_dispatch_profile_entry_t* entries = NULL;
+  iree_host_size_t capacity = 0;
+  iree_host_size_t count = 0;
+  iree_status_t status = iree_ok_status();
+  do {
+    status = iree_hal_vulkan_dispatch_profiler_query(profiler, capacity,
+                                                     entries, &count);
+    if (iree_status_code(status) != IREE_STATUS_OUT_OF_RANGE) break;
+    iree_status_ignore(status);
+    capacity = count;
+    status = iree_allocator_realloc(profiler->host_allocator,
+                                    capacity * sizeof(entries[0]),
+                                    (void**)&entries);
+  } while (iree_status_is_ok(status));
+
+  if (iree_status_is_ok(status)) {
+    fprintf(file, "[[ iree_hal_vulkan_device_t dispatch profile ]]\n");
+    fprintf(file, "%10s %14s %12s %12s %12s  %s\n", "count", "total ms",
+            "avg us", "min us", "max us", "entry point");
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      const iree_hal_vulkan_dispatch_profile_entry_t* entry = &entries[i];
+      fprintf(file, "%10" PRIu64 " %14.3f %12.3f %12.3f %12.3f  %.*s\n",
+              entry->dispatch_count, entry->total_duration_ns / 1e6,
+              entry->total_duration_ns / 1e3 / entry->dispatch_count,
+              entry->min_duration_ns / 1e3, entry->max_duration_ns / 1e3,
+              (int)entry->name.size, entry->name.data);
+    }
+  }
+
+  // NOTE: the entry names in the copies are owned by the profiler.
+  iree_allocator_free(profiler->host_allocator, entries);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_vulkan_dispatch_recorder_t
+//===----------------------------------------------------------------------===//
+
+void iree_hal_vulkan_dispatch_recorder_initialize(
+    iree_hal_vulkan_dispatch_profiler_t* profiler,
+    iree_hal_vulkan_dispatch_recorder_t* out_recorder) {
+  memset(out_recorder, 0, sizeof(*out_recorder));
+  out_recorder->profiler = profiler;
+}
+
+void iree_hal_vulkan_dispatch_recorder_deinitialize(
+    iree_hal_vulkan_dispatch_recorder_t* recorder) {
+  iree_hal_vulkan_dispatch_profiler_t* profiler = recorder->profiler;
+  if (!profiler) return;
+  iree_hal_vulkan_dispatch_recorder_collect(recorder);
+  VkDeviceHandle* logical_device = profiler->logical_device;
+  for (iree_host_size_t i = 0; i < recorder->pool_count; ++i) {
+    logical_device->syms()->vkDestroyQueryPool(
+        *logical_device, recorder->pools[i], logical_device->allocator());
+  }
+  iree_allocator_free(profiler->host_allocator, recorder->pools);
+  iree_allocator_free(profiler->host_allocator, recorder->dispatch_names);
+  memset(recorder, 0, sizeof(*recorder));
+}
+
+// Ensures the query pool at |pool_index| exists, creating it if needed.
+static iree_status_t iree_hal_vulkan_dispatch_recorder_ensure_pool(
+    iree_hal_vulkan_dispatch_recorder_t* recorder,
+    iree_host_size_t pool_index) {
+  if (pool_index < recorder->pool_count) return iree_ok_status();
+  iree_hal_vulkan_dispatch_profiler_t* profiler = recorder->profiler;
+  VkDeviceHandle* logical_device = profiler->logical_device;
+
+  if (recorder->pool_count == recorder->pool_capacity) {
+    iree_host_size_t new_capacity =
+        recorder->pool_capacity ? recorder->pool_capacity * 2 : 4;
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        profiler->host_allocator, new_capacity * sizeof(recorder->pools[0]),
+        (void**)&recorder->pools));
+    recorder->pool_capacity = new_capacity;
+  }
+
+  VkQueryPoolCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  create_info.pNext = NULL;
+  create_info.flags = 0;
+  create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  create_info.queryCount =
+      IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES * 2;
+  create_info.pipelineStatistics = 0;
+  VkQueryPool pool = VK_NULL_HANDLE;
+  VK_RETURN_IF_ERROR(
+      logical_device->syms()->vkCreateQueryPool(
+          *logical_device, &create_info, logical_device->allocator(), &pool),
+      "vkCreateQueryPool");
+  recorder->pools[recorder->pool_count++] = pool;
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_vulkan_dispatch_recorder_begin_dispatch(
+    iree_hal_vulkan_dispatch_recorder_t* recorder,
+    VkCommandBuffer command_buffer, iree_string_view_t name) {
+  iree_hal_vulkan_dispatch_profiler_t* profiler = recorder->profiler;
+  if (!profiler) return iree_ok_status();
+
+  if (recorder->dispatch_count == recorder->dispatch_capacity) {
+    iree_host_size_t new_capacity =
+        recorder->dispatch_capacity
+            ? recorder->dispatch_capacity * 2
+            : IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES;
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        profiler->host_allocator,
+        new_capacity * sizeof(recorder->dispatch_names[0]),
+        (void**)&recorder->dispatch_names));
+    recorder->dispatch_capacity = new_capacity;
+  }
+
+  const iree_host_size_t dispatch_index = recorder->dispatch_count;
+  const iree_host_size_t pool_index =
+      dispatch_index / IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES;
+  const uint32_t query_index =
+      (uint32_t)(dispatch_index %
+                 IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES) *
+      2;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_vulkan_dispatch_recorder_ensure_pool(recorder, pool_index));
+  VkQueryPool pool = recorder->pools[pool_index];
+
+  const auto& syms = profiler->logical_device->syms();
+  if (query_index == 0) {
+    // Queries must be reset before each use; the reset is recorded so that it
+    // is ordered with the timestamp writes of this recording.
+    syms->vkCmdResetQueryPool(
+        command_buffer, pool, 0,
+        IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES * 2);
+  }
+  syms->vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            pool, query_index);
+  recorder->dispatch_names[recorder->dispatch_count++] = name;
+  return iree_ok_status();
+}
+
+void iree_hal_vulkan_dispatch_recorder_end_dispatch(
+    iree_hal_vulkan_dispatch_recorder_t* recorder,
+    VkCommandBuffer command_buffer) {
+  iree_hal_vulkan_dispatch_profiler_t* profiler = recorder->profiler;
+  if (!profiler) return;
+  const iree_host_size_t dispatch_index = recorder->dispatch_count - 1;
+  VkQueryPool pool =
+      recorder->pools[dispatch_index /
+                      IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES];
+  const uint32_t query_index =
+      (uint32_t)(dispatch_index %
+                 IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES) *
+          2 +
+      1;
+  profiler->logical_device->syms()->vkCmdWriteTimestamp(
+      command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool, query_index);
+}
+
+void iree_hal_vulkan_dispatch_recorder_collect(
+    iree_hal_vulkan_dispatch_recorder_t* recorder) {
+  iree_hal_vulkan_dispatch_profiler_t* profiler = recorder->profiler;
+  if (!profiler || recorder->dispatch_count == 0) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)recorder->dispatch_count);
+  VkDeviceHandle* logical_device = profiler->logical_device;
+
+  // Each query result is a (timestamp, availability) pair.
+  uint64_t results[IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES * 2 * 2];
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&profiler->mutex);
+  for (iree_host_size_t base_index = 0;
+       base_index < recorder->dispatch_count && iree_status_is_ok(status);
+       base_index += IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES) {
+    iree_host_size_t pool_dispatch_count =
+        iree_min(recorder->dispatch_count - base_index,
+                 IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES);
+    VkResult result = logical_device->syms()->vkGetQueryPoolResults(
+        *logical_device,
+        recorder->pools[base_index /
+                        IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES],
+        0, (uint32_t)(pool_dispatch_count * 2),
+        pool_dispatch_count * 2 * 2 * sizeof(results[0]), results,
+        2 * sizeof(results[0]),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    // VK_NOT_READY only indicates some queries are unavailable.
+    if (result != VK_SUCCESS && result != VK_NOT_READY) break;
+    for (iree_host_size_t i = 0;
+         i < pool_dispatch_count && iree_status_is_ok(status); ++i) {
+      const uint64_t* begin = &results[i * 4 + 0];
+      const uint64_t* end = &results[i * 4 + 2];
+      if (!begin[1] || !end[1]) continue;  // not executed
+      uint64_t duration_ticks =
+          (end[0] - begin[0]) & profiler->timestamp_mask;
+      status = iree_hal_vulkan_dispatch_profiler_record(
+          profiler, recorder->dispatch_names[base_index + i], duration_ticks);
+    }
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+  // Profiling is best-effort; running out of memory only drops samples.
+  iree_status_ignore(status);
+
+  recorder->dispatch_count = 0;
+  IREE_TRACE_ZONE_END(z0);
+}
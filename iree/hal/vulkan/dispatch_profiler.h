@@ -0,0 +1,123 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_VULKAN_DISPATCH_PROFILER_H_
+#define IREE_HAL_VULKAN_DISPATCH_PROFILER_H_
+
+#include <stdio.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/vulkan/api.h"
+#include "iree/hal/vulkan/handle_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_vulkan_dispatch_profiler_t
+//===----------------------------------------------------------------------===//
+
+// Aggregates GPU durations of dispatches by executable entry point name.
+// Durations are measured with timestamp queries written into command buffers
+// by iree_hal_vulkan_dispatch_recorder_t and do not require Tracy.
+//
+// Thread-safe; command buffers recorded and reset on any thread may report
+// into the same profiler.
+typedef struct iree_hal_vulkan_dispatch_profiler_t
+    iree_hal_vulkan_dispatch_profiler_t;
+
+// Creates a dispatch profiler for command buffers recorded for queues in
+// |queue_family_index|. Fails with IREE_STATUS_UNAVAILABLE if the queue family
+// does not support timestamp queries.
+iree_status_t iree_hal_vulkan_dispatch_profiler_create(
+    iree::hal::vulkan::VkDeviceHandle* logical_device,
+    VkPhysicalDevice physical_device, uint32_t queue_family_index,
+    iree_allocator_t host_allocator,
+    iree_hal_vulkan_dispatch_profiler_t** out_profiler);
+
+// Destroys |profiler|. All recorders using it must have been deinitialized.
+void iree_hal_vulkan_dispatch_profiler_destroy(
+    iree_hal_vulkan_dispatch_profiler_t* profiler);
+
+// Copies the aggregated entries sorted by descending total duration into
+// |out_entries|. See iree_hal_vulkan_device_query_dispatch_profile.
+iree_status_t iree_hal_vulkan_dispatch_profiler_query(
+    iree_hal_vulkan_dispatch_profiler_t* profiler, iree_host_size_t capacity,
+    iree_hal_vulkan_dispatch_profile_entry_t* out_entries,
+    iree_host_size_t* out_count);
+
+// Drops all aggregated entries.
+void iree_hal_vulkan_dispatch_profiler_reset(
+    iree_hal_vulkan_dispatch_profiler_t* profiler);
+
+// Prints a table of the aggregated entries to |file|.
+iree_status_t iree_hal_vulkan_dispatch_profiler_fprint(
+    FILE* file, iree_hal_vulkan_dispatch_profiler_t* profiler);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_vulkan_dispatch_recorder_t
+//===----------------------------------------------------------------------===//
+
+// Per-command buffer state writing timestamps around each dispatch.
+// Query pools are created on demand and reused across recordings. Results are
+// read back when the recording is collected which must happen after all
+// submissions of the command buffer have completed; dispatches whose queries
+// are not yet available are dropped.
+typedef struct iree_hal_vulkan_dispatch_recorder_t {
+  // Profiler the results are reported into or NULL if profiling is disabled.
+  iree_hal_vulkan_dispatch_profiler_t* profiler;
+  // Query pools of IREE_HAL_VULKAN_DISPATCH_RECORDER_POOL_DISPATCHES
+  // begin/end timestamp pairs each.
+  iree_host_size_t pool_count;
+  iree_host_size_t pool_capacity;
+  VkQueryPool* pools;
+  // Entry point names of each dispatch in the current recording. The names
+  // are unowned and must remain valid until the recording is collected.
+  iree_host_size_t dispatch_count;
+  iree_host_size_t dispatch_capacity;
+  iree_string_view_t* dispatch_names;
+} iree_hal_vulkan_dispatch_recorder_t;
+
+// Initializes |out_recorder| reporting into |profiler|. If |profiler| is NULL
+// the recorder does nothing.
+void iree_hal_vulkan_dispatch_recorder_initialize(
+    iree_hal_vulkan_dispatch_profiler_t* profiler,
+    iree_hal_vulkan_dispatch_recorder_t* out_recorder);
+
+// Collects any pending results and releases all recorder resources.
+void iree_hal_vulkan_dispatch_recorder_deinitialize(
+    iree_hal_vulkan_dispatch_recorder_t* recorder);
+
+// Returns true if the recorder writes timestamps.
+static inline bool iree_hal_vulkan_dispatch_recorder_is_enabled(
+    const iree_hal_vulkan_dispatch_recorder_t* recorder) {
+  return recorder->profiler != NULL;
+}
+
+// Writes the starting timestamp of a dispatch of entry point |name| into
+// |command_buffer|. Must be followed by
+// iree_hal_vulkan_dispatch_recorder_end_dispatch after the dispatch command.
+iree_status_t iree_hal_vulkan_dispatch_recorder_begin_dispatch(
+    iree_hal_vulkan_dispatch_recorder_t* recorder,
+    VkCommandBuffer command_buffer, iree_string_view_t name);
+
+// Writes the ending timestamp of the dispatch started with
+// iree_hal_vulkan_dispatch_recorder_begin_dispatch.
+void iree_hal_vulkan_dispatch_recorder_end_dispatch(
+    iree_hal_vulkan_dispatch_recorder_t* recorder,
+    VkCommandBuffer command_buffer);
+
+// Reads back the timestamps of the current recording, reports them to the
+// profiler, and prepares the recorder for a new recording.
+void iree_hal_vulkan_dispatch_recorder_collect(
+    iree_hal_vulkan_dispatch_recorder_t* recorder);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_VULKAN_DISPATCH_PROFILER_H_
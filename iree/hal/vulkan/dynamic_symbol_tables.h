@@ -217,6 +217,7 @@ namespace vulkan {
   DEV_PFN(EXCLUDED, vkGetAccelerationStructureHandleNV)                 \
   DEV_PFN(EXCLUDED, vkGetAccelerationStructureMemoryRequirementsNV)     \
   DEV_PFN(EXCLUDED, vkGetBufferDeviceAddressEXT)                        \
+  DEV_PFN(OPTIONAL, vkGetBufferDeviceAddressKHR)                        \
   DEV_PFN(REQUIRED, vkGetBufferMemoryRequirements)                      \
   DEV_PFN(EXCLUDED, vkGetBufferMemoryRequirements2)                     \
   DEV_PFN(EXCLUDED, vkGetBufferMemoryRequirements2KHR)                  \
@@ -244,7 +245,7 @@ namespace vulkan {
   DEV_PFN(EXCLUDED, vkGetImageViewHandleNVX)                            \
   DEV_PFN(EXCLUDED, vkGetMemoryFdKHR)                                   \
   DEV_PFN(EXCLUDED, vkGetMemoryFdPropertiesKHR)                         \
-  DEV_PFN(EXCLUDED, vkGetMemoryHostPointerPropertiesEXT)                \
+  DEV_PFN(OPTIONAL, vkGetMemoryHostPointerPropertiesEXT)                \
   DEV_PFN(EXCLUDED, vkGetPastPresentationTimingGOOGLE)                  \
   DEV_PFN(REQUIRED, vkGetPipelineCacheData)                             \
   DEV_PFN(REQUIRED, vkGetQueryPoolResults)                              \
@@ -344,8 +345,8 @@ namespace vulkan {
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceMultisamplePropertiesEXT)        \
   INS_PFN(EXCLUDED, vkGetPhysicalDevicePresentRectanglesKHR)            \
   INS_PFN(REQUIRED, vkGetPhysicalDeviceProperties)                      \
-  INS_PFN(EXCLUDED, vkGetPhysicalDeviceProperties2)                     \
-  INS_PFN(EXCLUDED, vkGetPhysicalDeviceProperties2KHR)                  \
+  INS_PFN(OPTIONAL, vkGetPhysicalDeviceProperties2)                     \
+  INS_PFN(OPTIONAL, vkGetPhysicalDeviceProperties2KHR)                  \
   INS_PFN(REQUIRED, vkGetPhysicalDeviceQueueFamilyProperties)           \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceQueueFamilyProperties2)          \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceQueueFamilyProperties2KHR)       \
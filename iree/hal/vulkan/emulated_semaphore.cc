@@ -65,6 +65,11 @@ class EmulatedTimelineSemaphore final {
 
   void Fail(iree_status_t status);
 
+  // Informs the timeline that a queue submission signaling one of its time
+  // points was submitted to the GPU. Deferred submissions on other queues
+  // waiting on this timeline may now be able to submit.
+  iree_status_t NotifySignalSubmitted();
+
   // Gets a binary semaphore for waiting on the timeline to advance to the given
   // |value|. The semaphore returned won't be waited by anyone else. Returns
   // VK_NULL_HANDLE if no available semaphores for the given |value|.
@@ -105,6 +110,12 @@ class EmulatedTimelineSemaphore final {
 
   mutable iree_slim_mutex_t mutex_;
 
+  // Posted whenever the timeline may have made progress that is not observable
+  // with a fence: a new time point being added for a pending submission, the
+  // host signaling a value, or the timeline failing. Waiters that have no fence
+  // to wait on yet sleep on this instead of polling.
+  iree_notification_t notification_;
+
   // A list of outstanding semaphores used to emulate time points.
   //
   // The life time of each semaphore is in one of the following state:
@@ -145,6 +156,7 @@ EmulatedTimelineSemaphore::EmulatedTimelineSemaphore(
       command_queue_count_(command_queue_count),
       command_queues_(command_queues) {
   iree_slim_mutex_initialize(&mutex_);
+  iree_notification_initialize(&notification_);
 }
 
 EmulatedTimelineSemaphore::~EmulatedTimelineSemaphore() {
@@ -158,6 +170,7 @@ EmulatedTimelineSemaphore::~EmulatedTimelineSemaphore() {
          "outstanding signals";
   iree_status_free(status_);
   iree_slim_mutex_unlock(&mutex_);
+  iree_notification_deinitialize(&notification_);
   iree_slim_mutex_deinitialize(&mutex_);
 }
 
@@ -187,6 +200,9 @@ iree_status_t EmulatedTimelineSemaphore::Signal(uint64_t value) {
       << "Attempting to signal a timeline value out of order; trying " << value
       << " but " << signaled_value << " already signaled";
 
+  // Wake host waiters that had no time point to wait on.
+  iree_notification_post(&notification_, IREE_ALL_WAITERS);
+
   // Inform the device to make progress given we have a new value signaled now.
   for (iree_host_size_t i = 0; i < command_queue_count_; ++i) {
     IREE_RETURN_IF_ERROR(((SerializingCommandQueue*)command_queues_[i])
@@ -203,50 +219,73 @@ iree_status_t EmulatedTimelineSemaphore::Wait(uint64_t value,
 
   iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
 
-  VkFence fence = VK_NULL_HANDLE;
-  do {
+  ref_ptr<TimePointFence> fence;
+  while (!fence) {
     IREE_TRACE_SCOPE0("EmulatedTimelineSemaphore::Wait#loop");
+    // Prepare the wait before checking the timeline so that a time point added
+    // (or a host signal made) after the check below is not missed.
+    iree_wait_token_t wait_token =
+        iree_notification_prepare_wait(&notification_);
+
     // First try to advance the timeline without blocking to see whether we've
     // already reached the desired value.
     bool reached_desired_value = false;
-    IREE_RETURN_IF_ERROR(TryToAdvanceTimeline(value, &reached_desired_value));
-    if (reached_desired_value) return iree_ok_status();
+    iree_status_t status = TryToAdvanceTimeline(value, &reached_desired_value);
+    if (!iree_status_is_ok(status) || reached_desired_value) {
+      iree_notification_cancel_wait(&notification_);
+      return status;
+    }
 
     // We must wait now. Find the first emulated time point that has a value >=
     // the desired value so we can wait on its associated signal fence to make
     // sure the timeline is advanced to the desired value.
-    RAIILock locker(&mutex_);
-    auto semaphore = outstanding_semaphores_.begin();
-    for (; semaphore != outstanding_semaphores_.end(); ++semaphore) {
-      if ((*semaphore)->value >= value) break;
-    }
-    if (semaphore != outstanding_semaphores_.end()) {
-      if (!(*semaphore)->signal_fence) {
-        return iree_make_status(IREE_STATUS_INTERNAL,
-                                "timeline should have a signal fence for the "
-                                "first time point beyond the signaled value");
+    {
+      RAIILock locker(&mutex_);
+      auto semaphore = outstanding_semaphores_.begin();
+      for (; semaphore != outstanding_semaphores_.end(); ++semaphore) {
+        if ((*semaphore)->value >= value) break;
       }
-      IREE_DVLOG(2) << "Found timepoint semaphore " << *semaphore
-                    << " (value: " << (*semaphore)->value
-                    << ") to wait for desired timeline value: " << value;
-      fence = (*semaphore)->signal_fence->value();
-      // Found; we can break the loop and proceed to waiting now.
+      if (semaphore != outstanding_semaphores_.end()) {
+        if (!(*semaphore)->signal_fence) {
+          iree_notification_cancel_wait(&notification_);
+          return iree_make_status(IREE_STATUS_INTERNAL,
+                                  "timeline should have a signal fence for the "
+                                  "first time point beyond the signaled value");
+        }
+        IREE_DVLOG(2) << "Found timepoint semaphore " << *semaphore
+                      << " (value: " << (*semaphore)->value
+                      << ") to wait for desired timeline value: " << value;
+        // Retain the fence so that it is not recycled while we wait on it
+        // without holding the lock.
+        fence = add_ref((*semaphore)->signal_fence);
+      }
+    }
+    if (fence) {
+      iree_notification_cancel_wait(&notification_);
       break;
     }
-    // TODO(antiagainst): figure out a better way instead of the busy loop here.
-  } while (iree_time_now() < deadline_ns);
 
-  if (fence == VK_NULL_HANDLE) {
-    // NOTE: not an error; it may be expected that the semaphore is not ready.
-    return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    // No submission that can signal the desired value has been made yet: the
+    // value will either be signaled from the host or by a submission that is
+    // still deferred. Sleep until one of those happens (or we time out).
+    if (!iree_notification_commit_wait(&notification_, wait_token,
+                                       deadline_ns)) {
+      // NOTE: not an error; it may be expected that the semaphore is not ready.
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
   }
 
   uint64_t timeout_ns =
       static_cast<uint64_t>(iree_absolute_deadline_to_timeout_ns(deadline_ns));
-  VK_RETURN_IF_ERROR(logical_device_->syms()->vkWaitForFences(
-                         *logical_device_, /*fenceCount=*/1, &fence,
-                         /*waitAll=*/true, timeout_ns),
-                     "vkWaitForFences");
+  VkFence fence_handle = fence->value();
+  VkResult result = logical_device_->syms()->vkWaitForFences(
+      *logical_device_, /*fenceCount=*/1, &fence_handle,
+      /*waitAll=*/true, timeout_ns);
+  fence.reset();
+  if (result == VK_TIMEOUT) {
+    return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+  }
+  VK_RETURN_IF_ERROR(result, "vkWaitForFences");
 
   return TryToAdvanceTimeline(value, /*out_reached_upper_value=*/NULL);
 }
@@ -257,6 +296,16 @@ void EmulatedTimelineSemaphore::Fail(iree_status_t status) {
   if (status_) return;
   status_ = status;
   signaled_value_.store(UINT64_MAX);
+  iree_notification_post(&notification_, IREE_ALL_WAITERS);
+}
+
+iree_status_t EmulatedTimelineSemaphore::NotifySignalSubmitted() {
+  IREE_TRACE_SCOPE0("EmulatedTimelineSemaphore::NotifySignalSubmitted");
+  for (iree_host_size_t i = 0; i < command_queue_count_; ++i) {
+    IREE_RETURN_IF_ERROR(((SerializingCommandQueue*)command_queues_[i])
+                             ->AdvanceQueueSubmission());
+  }
+  return iree_ok_status();
 }
 
 VkSemaphore EmulatedTimelineSemaphore::GetWaitSemaphore(
@@ -268,7 +317,9 @@ VkSemaphore EmulatedTimelineSemaphore::GetWaitSemaphore(
 
   VkSemaphore semaphore = VK_NULL_HANDLE;
   for (TimePointSemaphore* point : outstanding_semaphores_) {
-    if (point->value > value && point->wait_fence) {
+    // Binary semaphores can only be waited on once so skip time points that
+    // already have a waiter.
+    if (point->value >= value && !point->wait_fence) {
       point->wait_fence = add_ref(wait_fence);
       semaphore = point->semaphore;
       break;
@@ -320,6 +371,7 @@ iree_status_t EmulatedTimelineSemaphore::GetSignalSemaphore(
   auto insertion_point = outstanding_semaphores_.begin();
   while (insertion_point != outstanding_semaphores_.end()) {
     if ((*insertion_point)->value > value) break;
+    ++insertion_point;
   }
 
   TimePointSemaphore* semaphore = NULL;
@@ -337,6 +389,9 @@ iree_status_t EmulatedTimelineSemaphore::GetSignalSemaphore(
                 << "): " << semaphore
                 << " (binary VkSemaphore: " << semaphore->semaphore << ")";
 
+  // Host waiters that had no time point to wait on can now wait on the fence.
+  iree_notification_post(&notification_, IREE_ALL_WAITERS);
+
   *out_handle = semaphore->semaphore;
   return iree_ok_status();
 }
@@ -399,7 +454,6 @@ iree_status_t EmulatedTimelineSemaphore::TryToAdvanceTimeline(
       };
 
   bool keep_resolving = true;
-  bool reached_desired_value = false;
   while (keep_resolving && !outstanding_semaphores_.empty()) {
     auto* semaphore = outstanding_semaphores_.front();
     IREE_DVLOG(3) << "Looking at timepoint semaphore " << semaphore << "..";
@@ -414,7 +468,6 @@ iree_status_t EmulatedTimelineSemaphore::TryToAdvanceTimeline(
     // fences as fast/faster than another thread can consume them.
     if (semaphore->value > to_upper_value) {
       keep_resolving = false;
-      reached_desired_value = true;
       break;
     }
 
@@ -499,7 +552,9 @@ iree_status_t EmulatedTimelineSemaphore::TryToAdvanceTimeline(
     return status_;
   }
 
-  if (out_reached_upper_value) *out_reached_upper_value = reached_desired_value;
+  if (out_reached_upper_value) {
+    *out_reached_upper_value = signaled_value_.load() >= to_upper_value;
+  }
   return iree_ok_status();
 }
 
@@ -590,6 +645,13 @@ iree_status_t iree_hal_vulkan_emulated_semaphore_acquire_signal_handle(
   return semaphore->GetSignalSemaphore(value, signal_fence, out_handle);
 }
 
+iree_status_t iree_hal_vulkan_emulated_semaphore_notify_signal_submitted(
+    iree_hal_semaphore_t* base_semaphore) {
+  EmulatedTimelineSemaphore* semaphore =
+      iree_hal_vulkan_emulated_semaphore_cast(base_semaphore);
+  return semaphore->NotifySignalSubmitted();
+}
+
 static iree_status_t iree_hal_vulkan_emulated_semaphore_query(
     iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
   EmulatedTimelineSemaphore* semaphore =
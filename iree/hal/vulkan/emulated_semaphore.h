@@ -143,6 +143,13 @@ iree_status_t iree_hal_vulkan_emulated_semaphore_acquire_signal_handle(
     const iree::ref_ptr<iree::hal::vulkan::TimePointFence>& signal_fence,
     VkSemaphore* out_handle);
 
+// Notifies the timeline that a queue submission signaling it has been submitted
+// to the GPU. This gives queues with deferred submissions waiting on the
+// timeline a chance to submit them now that binary semaphores for them to wait
+// on exist, instead of waiting for the host to observe the signal.
+iree_status_t iree_hal_vulkan_emulated_semaphore_notify_signal_submitted(
+    iree_hal_semaphore_t* semaphore);
+
 // Performs a multi-wait on one or more semaphores.
 // By default this is an all-wait but |wait_flags| may contain
 // VK_SEMAPHORE_WAIT_ANY_BIT to change to an any-wait.
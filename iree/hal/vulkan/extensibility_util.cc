@@ -207,6 +207,12 @@ iree_hal_vulkan_populate_enabled_device_extensions(
     } else if (strcmp(extension_name,
                       VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0) {
       extensions.calibrated_timestamps = true;
+    } else if (strcmp(extension_name,
+                      VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME) == 0) {
+      extensions.external_memory_host = true;
+    } else if (strcmp(extension_name,
+                      VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME) == 0) {
+      extensions.buffer_device_address = true;
     }
   }
   return extensions;
@@ -229,5 +235,8 @@ iree_hal_vulkan_infer_enabled_device_extensions(
   if (device_syms->vkGetCalibratedTimestampsEXT) {
     extensions.calibrated_timestamps = true;
   }
+  if (device_syms->vkGetMemoryHostPointerPropertiesEXT) {
+    extensions.external_memory_host = true;
+  }
   return extensions;
 }
@@ -80,6 +80,12 @@ typedef struct iree_hal_vulkan_device_extensions_t {
   bool host_query_reset : 1;
   // VK_EXT_calibrated_timestamps is enabled.
   bool calibrated_timestamps : 1;
+  // VK_EXT_external_memory_host is enabled.
+  bool external_memory_host : 1;
+  // VK_KHR_buffer_device_address is enabled and dispatch bindings are passed
+  // as buffer device addresses. Never inferred from symbols as it changes the
+  // binding model executables must be compiled for.
+  bool buffer_device_address : 1;
 } iree_hal_vulkan_device_extensions_t;
 
 // Returns a bitfield with all of the provided extension names.
@@ -22,6 +22,8 @@ typedef struct iree_hal_vulkan_native_descriptor_set_layout_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
   VkDescriptorSetLayout handle;
+  // One more than the highest binding ordinal in the layout.
+  uint32_t binding_capacity;
 } iree_hal_vulkan_native_descriptor_set_layout_t;
 
 namespace {
@@ -120,6 +122,11 @@ iree_status_t iree_hal_vulkan_native_descriptor_set_layout_create(
         &descriptor_set_layout->resource);
     descriptor_set_layout->logical_device = logical_device;
     descriptor_set_layout->handle = handle;
+    descriptor_set_layout->binding_capacity = 0;
+    for (iree_host_size_t i = 0; i < binding_count; ++i) {
+      descriptor_set_layout->binding_capacity = iree_max(
+          descriptor_set_layout->binding_capacity, bindings[i].binding + 1);
+    }
     *out_descriptor_set_layout =
         (iree_hal_descriptor_set_layout_t*)descriptor_set_layout;
   } else {
@@ -154,6 +161,14 @@ VkDescriptorSetLayout iree_hal_vulkan_native_descriptor_set_layout_handle(
   return descriptor_set_layout->handle;
 }
 
+uint32_t iree_hal_vulkan_native_descriptor_set_layout_binding_capacity(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_vulkan_native_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_vulkan_native_descriptor_set_layout_cast(
+          base_descriptor_set_layout);
+  return descriptor_set_layout->binding_capacity;
+}
+
 namespace {
 const iree_hal_descriptor_set_layout_vtable_t
     iree_hal_vulkan_native_descriptor_set_layout_vtable = {
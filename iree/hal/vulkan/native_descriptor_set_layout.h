@@ -27,6 +27,10 @@ iree_status_t iree_hal_vulkan_native_descriptor_set_layout_create(
 VkDescriptorSetLayout iree_hal_vulkan_native_descriptor_set_layout_handle(
     iree_hal_descriptor_set_layout_t* base_descriptor_set_layout);
 
+// Returns one more than the highest binding ordinal in the layout.
+uint32_t iree_hal_vulkan_native_descriptor_set_layout_binding_capacity(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
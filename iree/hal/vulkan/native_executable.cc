@@ -11,6 +11,7 @@
 #include <cstring>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/vulkan/dynamic_symbol_tables.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
@@ -26,11 +27,58 @@
 
 using namespace iree::hal::vulkan;
 
+// Maximum number of push constants that may be specialized per executable.
+#define IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANTS 16
+
+// Maximum number of specialized pipelines created per entry point. Dispatches
+// with values beyond those already specialized use the generic pipeline.
+#define IREE_HAL_VULKAN_MAX_PIPELINE_VARIANTS 8
+
 typedef struct iree_hal_vulkan_entry_point_t {
+  // Generic pipeline reading all push constants.
   VkPipeline pipeline;
   iree_string_view_t name;
+  // Layout the pipelines are created with. |layout| is only retained if
+  // specialized variants may be created after the executable is created.
+  VkPipelineLayout layout_handle;
+  iree_hal_executable_layout_t* layout;
+  // Number of valid variants in the specialization cache. Guarded by the
+  // specialization cache mutex.
+  iree_host_size_t variant_count;
 } iree_hal_vulkan_entry_point_t;
 
+// A pipeline specialized for a set of push constant values.
+typedef struct iree_hal_vulkan_pipeline_variant_t {
+  VkPipeline pipeline;
+  uint32_t values[IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANTS];
+} iree_hal_vulkan_pipeline_variant_t;
+
+// Specialization constants of an executable and the pipelines specialized on
+// demand for the push constant values dispatches use.
+typedef struct iree_hal_vulkan_specialization_t {
+  // Static specialization constants applied to all pipelines.
+  iree_host_size_t static_count;
+  VkSpecializationMapEntry* static_entries;
+  uint32_t* static_values;
+
+  // Ordinals of the push constants mirrored by specialization constants. Zero
+  // if the executable does not support specialized variants.
+  iree_host_size_t push_constant_count;
+  uint32_t
+      push_constant_ordinals[IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANTS];
+
+  // State required to create variants after the executable is created. The
+  // shader module is only retained if |push_constant_count| is non-zero.
+  VkShaderModule shader_module;
+  VkPipelineCache pipeline_cache;
+  VkPipelineCreateFlags pipeline_flags;
+
+  // Variants of each entry point with IREE_HAL_VULKAN_MAX_PIPELINE_VARIANTS
+  // slots per entry point.
+  iree_slim_mutex_t mutex;
+  iree_hal_vulkan_pipeline_variant_t* variants;
+} iree_hal_vulkan_specialization_t;
+
 static iree_status_t iree_hal_vulkan_create_shader_module(
     VkDeviceHandle* logical_device, iree_const_byte_span_t code,
     VkShaderModule* out_shader_module) {
@@ -59,7 +107,9 @@ static iree_status_t iree_hal_vulkan_create_pipelines(
     VkDeviceHandle* logical_device, VkPipelineCache pipeline_cache,
     iree_hal_executable_caching_mode_t caching_mode,
     iree_SpirVExecutableDef_table_t executable_def,
-    VkShaderModule shader_module, iree_host_size_t executable_layout_count,
+    VkShaderModule shader_module,
+    const VkSpecializationInfo* specialization_info,
+    iree_host_size_t executable_layout_count,
     iree_hal_executable_layout_t* const* executable_layouts,
     iree_host_size_t pipeline_count,
     iree_hal_vulkan_entry_point_t* out_entry_points) {
@@ -101,7 +151,7 @@ static iree_status_t iree_hal_vulkan_create_pipelines(
     stage_create_info->module = shader_module;
     stage_create_info->pName =
         flatbuffers_string_vec_at(entry_points_vec, entry_ordinal);
-    stage_create_info->pSpecializationInfo = NULL;
+    stage_create_info->pSpecializationInfo = specialization_info;
   }
 
   VkPipeline* pipelines =
@@ -114,6 +164,7 @@ static iree_status_t iree_hal_vulkan_create_pipelines(
   if (iree_status_is_ok(status)) {
     for (iree_host_size_t i = 0; i < pipeline_count; ++i) {
       out_entry_points[i].pipeline = pipelines[i];
+      out_entry_points[i].layout_handle = create_infos[i].layout;
     }
   }
 
@@ -181,20 +232,181 @@ static iree_status_t iree_hal_spirv_executable_flatbuffer_verify(
                             "executable SPIR-V code is missing/empty");
   }
 
-  // TODO(benvanik): pull PopulateSpecializationInfo from history and update.
-  // For now the compiler isn't generating them, and we don't use them.
-  if (iree_SpirVExecutableDef_specialization_info_is_present(executable_def)) {
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "executable uses SPIR-V specialization constants; "
-                            "they need to be revived");
+  // Specialization constants 0 to the number of specialized push constants are
+  // reserved for them.
+  flatbuffers_uint32_vec_t specialized_vec =
+      iree_SpirVExecutableDef_specialized_push_constants_get(executable_def);
+  size_t specialized_count = flatbuffers_uint32_vec_len(specialized_vec);
+  if (specialized_count > IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANTS) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "executable specializes %zu push constants but at "
+                            "most %d are supported",
+                            specialized_count,
+                            IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANTS);
+  }
+  iree_VkSpecializationInfoDef_table_t specialization_info_def =
+      iree_SpirVExecutableDef_specialization_info_get(executable_def);
+  if (specialized_count > 0 && specialization_info_def) {
+    iree_VkSpecializationMapEntryDef_vec_t entries_vec =
+        iree_VkSpecializationInfoDef_map_entries_get(specialization_info_def);
+    size_t entry_count = iree_VkSpecializationMapEntryDef_vec_len(entries_vec);
+    for (size_t i = 0; i < entry_count; ++i) {
+      uint32_t constant_id = iree_VkSpecializationMapEntryDef_constant_id_get(
+          iree_VkSpecializationMapEntryDef_vec_at(entries_vec, i));
+      if (constant_id <= specialized_count) {
+        return iree_make_status(
+            IREE_STATUS_INVALID_ARGUMENT,
+            "specialization constant %u is reserved for push constants",
+            constant_id);
+      }
+    }
   }
 
   return iree_ok_status();
 }
 
+// Initializes |specialization| from |executable_def|. The shader module and
+// pipeline state are set by the caller if variants may be created.
+static iree_status_t iree_hal_vulkan_specialization_initialize(
+    iree_SpirVExecutableDef_table_t executable_def,
+    iree_host_size_t entry_point_count, iree_allocator_t host_allocator,
+    iree_hal_vulkan_specialization_t* specialization) {
+  memset(specialization, 0, sizeof(*specialization));
+  iree_slim_mutex_initialize(&specialization->mutex);
+
+  iree_VkSpecializationInfoDef_table_t specialization_info_def =
+      iree_SpirVExecutableDef_specialization_info_get(executable_def);
+  if (specialization_info_def) {
+    iree_VkSpecializationMapEntryDef_vec_t entries_vec =
+        iree_VkSpecializationInfoDef_map_entries_get(specialization_info_def);
+    iree_host_size_t count =
+        iree_VkSpecializationMapEntryDef_vec_len(entries_vec);
+    if (count > 0) {
+      IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+          host_allocator,
+          count * (sizeof(VkSpecializationMapEntry) + sizeof(uint32_t)),
+          (void**)&specialization->static_entries));
+      specialization->static_values =
+          (uint32_t*)(specialization->static_entries + count);
+      specialization->static_count = count;
+      for (iree_host_size_t i = 0; i < count; ++i) {
+        iree_VkSpecializationMapEntryDef_table_t entry_def =
+            iree_VkSpecializationMapEntryDef_vec_at(entries_vec, i);
+        specialization->static_entries[i].constantID =
+            iree_VkSpecializationMapEntryDef_constant_id_get(entry_def);
+        specialization->static_entries[i].offset =
+            (uint32_t)(i * sizeof(uint32_t));
+        specialization->static_entries[i].size = sizeof(uint32_t);
+        specialization->static_values[i] =
+            iree_VkSpecializationMapEntryDef_uint32_value_get(entry_def);
+      }
+    }
+  }
+
+  flatbuffers_uint32_vec_t specialized_vec =
+      iree_SpirVExecutableDef_specialized_push_constants_get(executable_def);
+  iree_host_size_t specialized_count =
+      flatbuffers_uint32_vec_len(specialized_vec);
+  if (specialized_count > 0) {
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+        host_allocator,
+        entry_point_count * IREE_HAL_VULKAN_MAX_PIPELINE_VARIANTS *
+            sizeof(*specialization->variants),
+        (void**)&specialization->variants));
+    specialization->push_constant_count = specialized_count;
+    for (iree_host_size_t i = 0; i < specialized_count; ++i) {
+      specialization->push_constant_ordinals[i] =
+          flatbuffers_uint32_vec_at(specialized_vec, i);
+    }
+  }
+  return iree_ok_status();
+}
+
+static void iree_hal_vulkan_specialization_deinitialize(
+    VkDeviceHandle* logical_device, iree_host_size_t entry_point_count,
+    iree_hal_vulkan_entry_point_t* entry_points,
+    iree_hal_vulkan_specialization_t* specialization) {
+  iree_allocator_t host_allocator = logical_device->host_allocator();
+  if (specialization->variants) {
+    for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+      for (iree_host_size_t j = 0; j < entry_points[i].variant_count; ++j) {
+        iree_hal_vulkan_destroy_pipeline(
+            logical_device,
+            specialization
+                ->variants[i * IREE_HAL_VULKAN_MAX_PIPELINE_VARIANTS + j]
+                .pipeline);
+      }
+    }
+    iree_allocator_free(host_allocator, specialization->variants);
+  }
+  for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+    iree_hal_executable_layout_release(entry_points[i].layout);
+  }
+  iree_hal_vulkan_destroy_shader_module(logical_device,
+                                        specialization->shader_module);
+  iree_allocator_free(host_allocator, specialization->static_entries);
+  iree_slim_mutex_deinitialize(&specialization->mutex);
+}
+
+// Creates a pipeline for |entry_point| with the push constants mirrored by
+// specialization constants set to |values|.
+static iree_status_t iree_hal_vulkan_specialization_create_variant(
+    VkDeviceHandle* logical_device,
+    iree_hal_vulkan_specialization_t* specialization,
+    const iree_hal_vulkan_entry_point_t* entry_point, const uint32_t* values,
+    VkPipeline* out_pipeline) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_host_size_t entry_count =
+      specialization->static_count + 1 + specialization->push_constant_count;
+  VkSpecializationMapEntry* entries = (VkSpecializationMapEntry*)iree_alloca(
+      entry_count * sizeof(VkSpecializationMapEntry));
+  uint32_t* data = (uint32_t*)iree_alloca(entry_count * sizeof(uint32_t));
+  for (iree_host_size_t i = 0; i < specialization->static_count; ++i) {
+    entries[i] = specialization->static_entries[i];
+    data[i] = specialization->static_values[i];
+  }
+  iree_host_size_t base = specialization->static_count;
+  for (iree_host_size_t i = 0; i < 1 + specialization->push_constant_count;
+       ++i) {
+    entries[base + i].constantID = (uint32_t)i;
+    entries[base + i].offset = (uint32_t)((base + i) * sizeof(uint32_t));
+    entries[base + i].size = sizeof(uint32_t);
+    data[base + i] = i == 0 ? VK_TRUE : values[i - 1];
+  }
+  VkSpecializationInfo specialization_info;
+  specialization_info.mapEntryCount = (uint32_t)entry_count;
+  specialization_info.pMapEntries = entries;
+  specialization_info.dataSize = entry_count * sizeof(uint32_t);
+  specialization_info.pData = data;
+
+  VkComputePipelineCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  create_info.pNext = NULL;
+  create_info.flags = specialization->pipeline_flags;
+  create_info.layout = entry_point->layout_handle;
+  create_info.basePipelineHandle = VK_NULL_HANDLE;
+  create_info.basePipelineIndex = 0;
+  create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  create_info.stage.pNext = NULL;
+  create_info.stage.flags = 0;
+  create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  create_info.stage.module = specialization->shader_module;
+  // Entry point names are NUL terminated in the flatbuffer.
+  create_info.stage.pName = entry_point->name.data;
+  create_info.stage.pSpecializationInfo = &specialization_info;
+  iree_status_t status = VK_RESULT_TO_STATUS(
+      logical_device->syms()->vkCreateComputePipelines(
+          *logical_device, specialization->pipeline_cache, 1, &create_info,
+          logical_device->allocator(), out_pipeline),
+      "vkCreateComputePipelines");
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 typedef struct iree_hal_vulkan_native_executable_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
+  iree_hal_vulkan_specialization_t specialization;
   iree_host_size_t entry_point_count;
   iree_hal_vulkan_entry_point_t entry_points[];
 } iree_hal_vulkan_native_executable_t;
@@ -229,6 +441,25 @@ iree_status_t iree_hal_vulkan_native_executable_create(
   iree_SpirVExecutableDef_table_t executable_def =
       iree_SpirVExecutableDef_as_root(executable_spec->executable_data.data);
 
+  // Shaders using buffer device addresses read their bindings from push
+  // constants and can only be used with layouts that put them there.
+  bool uses_buffer_device_addresses =
+      iree_SpirVExecutableDef_buffer_device_address_get(executable_def);
+  for (iree_host_size_t i = 0; i < executable_spec->executable_layout_count;
+       ++i) {
+    if (iree_hal_vulkan_native_executable_layout_uses_buffer_device_addresses(
+            executable_spec->executable_layouts[i]) !=
+        uses_buffer_device_addresses) {
+      IREE_TRACE_ZONE_END(z0);
+      return iree_make_status(
+          IREE_STATUS_FAILED_PRECONDITION,
+          "executable buffer device address mode (%d) does not match the "
+          "device; compile with --iree-vulkan-buffer-device-address=%s",
+          (int)uses_buffer_device_addresses,
+          uses_buffer_device_addresses ? "false" : "true");
+    }
+  }
+
   // Create the shader module.
   flatbuffers_uint32_vec_t code_vec =
       iree_SpirVExecutableDef_code_get(executable_def);
@@ -260,15 +491,46 @@ iree_status_t iree_hal_vulkan_native_executable_create(
     executable->entry_point_count = entry_point_count;
     memset(executable->entry_points, 0,
            entry_point_count * sizeof(*executable->entry_points));
+    status = iree_hal_vulkan_specialization_initialize(
+        executable_def, entry_point_count, logical_device->host_allocator(),
+        &executable->specialization);
   }
   if (iree_status_is_ok(status)) {
+    iree_hal_vulkan_specialization_t* specialization =
+        &executable->specialization;
+    VkSpecializationInfo static_info;
+    static_info.mapEntryCount = (uint32_t)specialization->static_count;
+    static_info.pMapEntries = specialization->static_entries;
+    static_info.dataSize = specialization->static_count * sizeof(uint32_t);
+    static_info.pData = specialization->static_values;
     status = iree_hal_vulkan_create_pipelines(
         logical_device, pipeline_cache, executable_spec->caching_mode,
-        executable_def, shader_module, executable_spec->executable_layout_count,
+        executable_def, shader_module,
+        specialization->static_count > 0 ? &static_info : NULL,
+        executable_spec->executable_layout_count,
         executable_spec->executable_layouts, executable->entry_point_count,
         executable->entry_points);
   }
-  iree_hal_vulkan_destroy_shader_module(logical_device, shader_module);
+  if (iree_status_is_ok(status) &&
+      executable->specialization.push_constant_count > 0) {
+    // Retain the shader module and layouts to create specialized variants on
+    // demand.
+    for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+      executable->entry_points[i].layout =
+          executable_spec->executable_layouts[i];
+      iree_hal_executable_layout_retain(executable->entry_points[i].layout);
+    }
+    executable->specialization.shader_module = shader_module;
+    executable->specialization.pipeline_cache = pipeline_cache;
+    if (!iree_all_bits_set(
+            executable_spec->caching_mode,
+            IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION)) {
+      executable->specialization.pipeline_flags |=
+          VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT;
+    }
+  } else {
+    iree_hal_vulkan_destroy_shader_module(logical_device, shader_module);
+  }
 
   if (iree_status_is_ok(status)) {
     flatbuffers_string_vec_t entry_points_vec =
@@ -303,6 +565,9 @@ static void iree_hal_vulkan_native_executable_destroy(
     iree_hal_vulkan_destroy_pipeline(executable->logical_device,
                                      executable->entry_points[i].pipeline);
   }
+  iree_hal_vulkan_specialization_deinitialize(
+      executable->logical_device, executable->entry_point_count,
+      executable->entry_points, &executable->specialization);
   iree_allocator_free(host_allocator, executable);
 
   IREE_TRACE_ZONE_END(z0);
@@ -337,6 +602,65 @@ iree_status_t iree_hal_vulkan_native_executable_pipeline_for_entry_point(
   return iree_ok_status();
 }
 
+iree_status_t iree_hal_vulkan_native_executable_pipeline_for_dispatch(
+    iree_hal_executable_t* base_executable, iree_host_size_t entry_ordinal,
+    iree_host_size_t push_constant_count, const uint32_t* push_constants,
+    uint64_t push_constant_valid_words, VkPipeline* out_pipeline_handle) {
+  iree_hal_vulkan_native_executable_t* executable =
+      iree_hal_vulkan_native_executable_cast(base_executable);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_vulkan_native_executable_pipeline_for_entry_point(
+          base_executable, entry_ordinal, out_pipeline_handle));
+  iree_hal_vulkan_specialization_t* specialization =
+      &executable->specialization;
+  if (specialization->push_constant_count == 0) return iree_ok_status();
+
+  // Gather the values of the specialized push constants. Words that are not
+  // tracked must use the generic pipeline while words that were never pushed
+  // have undefined contents and can be specialized as anything.
+  uint32_t values[IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANTS];
+  for (iree_host_size_t i = 0; i < specialization->push_constant_count; ++i) {
+    uint32_t ordinal = specialization->push_constant_ordinals[i];
+    if (ordinal >= push_constant_count) return iree_ok_status();
+    values[i] = (ordinal < 64 && (push_constant_valid_words >> ordinal) & 1)
+                    ? push_constants[ordinal]
+                    : 0;
+  }
+  iree_host_size_t values_size =
+      specialization->push_constant_count * sizeof(uint32_t);
+
+  iree_hal_vulkan_entry_point_t* entry_point =
+      &executable->entry_points[entry_ordinal];
+  iree_hal_vulkan_pipeline_variant_t* variants =
+      &specialization
+           ->variants[entry_ordinal * IREE_HAL_VULKAN_MAX_PIPELINE_VARIANTS];
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&specialization->mutex);
+  bool found = false;
+  for (iree_host_size_t i = 0; i < entry_point->variant_count; ++i) {
+    if (memcmp(variants[i].values, values, values_size) == 0) {
+      *out_pipeline_handle = variants[i].pipeline;
+      found = true;
+      break;
+    }
+  }
+  if (!found &&
+      entry_point->variant_count < IREE_HAL_VULKAN_MAX_PIPELINE_VARIANTS) {
+    iree_hal_vulkan_pipeline_variant_t* variant =
+        &variants[entry_point->variant_count];
+    status = iree_hal_vulkan_specialization_create_variant(
+        executable->logical_device, specialization, entry_point, values,
+        &variant->pipeline);
+    if (iree_status_is_ok(status)) {
+      memcpy(variant->values, values, values_size);
+      ++entry_point->variant_count;
+      *out_pipeline_handle = variant->pipeline;
+    }
+  }
+  iree_slim_mutex_unlock(&specialization->mutex);
+  return status;
+}
+
 namespace {
 const iree_hal_executable_vtable_t iree_hal_vulkan_native_executable_vtable = {
     /*.destroy=*/iree_hal_vulkan_native_executable_destroy,
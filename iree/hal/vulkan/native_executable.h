@@ -45,6 +45,20 @@ iree_status_t iree_hal_vulkan_native_executable_pipeline_for_entry_point(
     iree_hal_executable_t* executable, iree_host_size_t entry_ordinal,
     VkPipeline* out_pipeline_handle);
 
+// Returns the VkPipeline to use for dispatching |entry_ordinal| with the given
+// push constant values. |push_constants| holds |push_constant_count| words of
+// which those with bits set in |push_constant_valid_words| are known.
+//
+// Executables compiled with specialized push constants create and memoize a
+// pipeline specialized for each distinct tuple of values up to a fixed limit
+// per entry point. Otherwise, or once the limit has been reached, the generic
+// pipeline of the entry point is returned.
+// Thread-safe.
+iree_status_t iree_hal_vulkan_native_executable_pipeline_for_dispatch(
+    iree_hal_executable_t* executable, iree_host_size_t entry_ordinal,
+    iree_host_size_t push_constant_count, const uint32_t* push_constants,
+    uint64_t push_constant_valid_words, VkPipeline* out_pipeline_handle);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
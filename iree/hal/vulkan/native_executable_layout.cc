@@ -23,6 +23,13 @@ typedef struct iree_hal_vulkan_native_executable_layout_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
   VkPipelineLayout handle;
+  // True if bindings are passed as buffer device addresses in push constants.
+  // The addresses follow the push constants (aligned to 8 bytes) starting at
+  // |binding_address_offset| with one 64-bit slot for each binding ordinal of
+  // each set in order: set N starts at slot |binding_address_bases[N]|.
+  bool uses_buffer_device_addresses;
+  uint32_t binding_address_offset;
+  uint32_t* binding_address_bases;
   iree_host_size_t set_layout_count;
   iree_hal_descriptor_set_layout_t* set_layouts[];
 } iree_hal_vulkan_native_executable_layout_t;
@@ -40,11 +47,41 @@ iree_hal_vulkan_native_executable_layout_cast(
   return (iree_hal_vulkan_native_executable_layout_t*)base_value;
 }
 
+// Returns the size in bytes of the push constant block of the layout and the
+// offset of the binding addresses within it, if used.
+static uint32_t iree_hal_vulkan_push_constant_block_size(
+    bool use_buffer_device_addresses, iree_host_size_t push_constant_count,
+    iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    uint32_t* out_binding_address_offset) {
+  uint32_t size = (uint32_t)(push_constant_count * sizeof(uint32_t));
+  *out_binding_address_offset = 0;
+  if (!use_buffer_device_addresses) return size;
+  size = (uint32_t)iree_host_align(size, sizeof(uint64_t));
+  *out_binding_address_offset = size;
+  for (iree_host_size_t i = 0; i < set_layout_count; ++i) {
+    size += iree_hal_vulkan_native_descriptor_set_layout_binding_capacity(
+                set_layouts[i]) *
+            sizeof(uint64_t);
+  }
+  return size;
+}
+
 static iree_status_t iree_hal_vulkan_create_pipeline_layout(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
-    iree_host_size_t push_constant_count, iree_host_size_t set_layout_count,
+    bool use_buffer_device_addresses, iree_host_size_t push_constant_count,
+    iree_host_size_t set_layout_count,
     iree_hal_descriptor_set_layout_t** set_layouts,
     VkPipelineLayout* out_handle) {
+  uint32_t binding_address_offset = 0;
+  uint32_t push_constant_size = iree_hal_vulkan_push_constant_block_size(
+      use_buffer_device_addresses, push_constant_count, set_layout_count,
+      set_layouts, &binding_address_offset);
+  if (use_buffer_device_addresses) {
+    // Shaders compiled for buffer device addresses declare no descriptor sets.
+    set_layout_count = 0;
+  }
+
   VkDescriptorSetLayout* set_layout_handles =
       (VkDescriptorSetLayout*)iree_alloca(set_layout_count *
                                           sizeof(VkDescriptorSetLayout));
@@ -56,8 +93,7 @@ static iree_status_t iree_hal_vulkan_create_pipeline_layout(
   VkPushConstantRange push_constant_ranges[1];
   push_constant_ranges[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
   push_constant_ranges[0].offset = 0;
-  push_constant_ranges[0].size =
-      (uint32_t)(push_constant_count * sizeof(uint32_t));
+  push_constant_ranges[0].size = push_constant_size;
 
   VkPipelineLayoutCreateInfo create_info;
   create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -65,7 +101,7 @@ static iree_status_t iree_hal_vulkan_create_pipeline_layout(
   create_info.flags = 0;
   create_info.setLayoutCount = (uint32_t)set_layout_count;
   create_info.pSetLayouts = set_layout_handles;
-  create_info.pushConstantRangeCount = push_constant_count > 0 ? 1 : 0;
+  create_info.pushConstantRangeCount = push_constant_size > 0 ? 1 : 0;
   create_info.pPushConstantRanges = push_constant_ranges;
 
   return VK_RESULT_TO_STATUS(logical_device->syms()->vkCreatePipelineLayout(
@@ -83,7 +119,8 @@ static void iree_hal_vulkan_destroy_pipeline_layout(
 
 iree_status_t iree_hal_vulkan_native_executable_layout_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
-    iree_host_size_t push_constant_count, iree_host_size_t set_layout_count,
+    bool use_buffer_device_addresses, iree_host_size_t push_constant_count,
+    iree_host_size_t set_layout_count,
     iree_hal_descriptor_set_layout_t** set_layouts,
     iree_hal_executable_layout_t** out_executable_layout) {
   IREE_ASSERT_ARGUMENT(logical_device);
@@ -95,13 +132,15 @@ iree_status_t iree_hal_vulkan_native_executable_layout_create(
   VkPipelineLayout handle = VK_NULL_HANDLE;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_vulkan_create_pipeline_layout(
-              logical_device, push_constant_count, set_layout_count,
-              set_layouts, &handle));
+              logical_device, use_buffer_device_addresses, push_constant_count,
+              set_layout_count, set_layouts, &handle));
 
   iree_hal_vulkan_native_executable_layout_t* executable_layout = NULL;
-  iree_host_size_t total_size =
-      sizeof(*executable_layout) +
+  iree_host_size_t set_layouts_size =
       set_layout_count * sizeof(*executable_layout->set_layouts);
+  iree_host_size_t total_size =
+      sizeof(*executable_layout) + set_layouts_size +
+      set_layout_count * sizeof(*executable_layout->binding_address_bases);
   iree_status_t status = iree_allocator_malloc(
       logical_device->host_allocator(), total_size, (void**)&executable_layout);
   if (iree_status_is_ok(status)) {
@@ -110,10 +149,23 @@ iree_status_t iree_hal_vulkan_native_executable_layout_create(
         &executable_layout->resource);
     executable_layout->logical_device = logical_device;
     executable_layout->handle = handle;
+    executable_layout->uses_buffer_device_addresses =
+        use_buffer_device_addresses;
+    iree_hal_vulkan_push_constant_block_size(
+        use_buffer_device_addresses, push_constant_count, set_layout_count,
+        set_layouts, &executable_layout->binding_address_offset);
+    executable_layout->binding_address_bases =
+        (uint32_t*)((uint8_t*)executable_layout + sizeof(*executable_layout) +
+                    set_layouts_size);
     executable_layout->set_layout_count = set_layout_count;
+    uint32_t binding_address_base = 0;
     for (iree_host_size_t i = 0; i < set_layout_count; ++i) {
       executable_layout->set_layouts[i] = set_layouts[i];
       iree_hal_descriptor_set_layout_retain(set_layouts[i]);
+      executable_layout->binding_address_bases[i] = binding_address_base;
+      binding_address_base +=
+          iree_hal_vulkan_native_descriptor_set_layout_binding_capacity(
+              set_layouts[i]);
     }
     *out_executable_layout = (iree_hal_executable_layout_t*)executable_layout;
   } else {
@@ -167,6 +219,40 @@ iree_hal_descriptor_set_layout_t* iree_hal_vulkan_native_executable_layout_set(
   return executable_layout->set_layouts[set_index];
 }
 
+bool iree_hal_vulkan_native_executable_layout_uses_buffer_device_addresses(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_vulkan_native_executable_layout_t* executable_layout =
+      iree_hal_vulkan_native_executable_layout_cast(base_executable_layout);
+  return executable_layout->uses_buffer_device_addresses;
+}
+
+iree_status_t iree_hal_vulkan_native_executable_layout_binding_address_offset(
+    iree_hal_executable_layout_t* base_executable_layout, uint32_t set,
+    uint32_t binding, uint32_t* out_offset) {
+  iree_hal_vulkan_native_executable_layout_t* executable_layout =
+      iree_hal_vulkan_native_executable_layout_cast(base_executable_layout);
+  *out_offset = 0;
+  if (IREE_UNLIKELY(!executable_layout->uses_buffer_device_addresses)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "executable layout does not use buffer device "
+                            "addresses");
+  }
+  uint32_t binding_capacity =
+      set < executable_layout->set_layout_count
+          ? iree_hal_vulkan_native_descriptor_set_layout_binding_capacity(
+                executable_layout->set_layouts[set])
+          : 0;
+  if (IREE_UNLIKELY(binding >= binding_capacity)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "binding %u of set %u not in the executable layout",
+                            binding, set);
+  }
+  *out_offset = executable_layout->binding_address_offset +
+                (executable_layout->binding_address_bases[set] + binding) *
+                    (uint32_t)sizeof(uint64_t);
+  return iree_ok_status();
+}
+
 namespace {
 const iree_hal_executable_layout_vtable_t
     iree_hal_vulkan_native_executable_layout_vtable = {
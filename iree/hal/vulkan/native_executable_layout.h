@@ -21,9 +21,15 @@ extern "C" {
 
 // Creates a VkPipelineLayout-based executable layout composed of one or more
 // descriptor set layouts.
+//
+// If |use_buffer_device_addresses| is true the pipeline layout has no
+// descriptor sets and the bindings described by |set_layouts| are instead
+// passed as 64-bit buffer device addresses appended to the push constants.
+// Requires VK_KHR_buffer_device_address.
 iree_status_t iree_hal_vulkan_native_executable_layout_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
-    iree_host_size_t push_constant_count, iree_host_size_t set_layout_count,
+    bool use_buffer_device_addresses, iree_host_size_t push_constant_count,
+    iree_host_size_t set_layout_count,
     iree_hal_descriptor_set_layout_t** set_layouts,
     iree_hal_executable_layout_t** out_executable_layout);
 
@@ -40,6 +46,18 @@ iree_hal_descriptor_set_layout_t* iree_hal_vulkan_native_executable_layout_set(
     iree_hal_executable_layout_t* executable_layout,
     iree_host_size_t set_index);
 
+// Returns true if bindings are passed to dispatches using the layout as buffer
+// device addresses in push constants instead of through descriptor sets.
+bool iree_hal_vulkan_native_executable_layout_uses_buffer_device_addresses(
+    iree_hal_executable_layout_t* executable_layout);
+
+// Returns the byte offset in the push constant block of the 64-bit device
+// address of |binding| in |set|. Only valid if the layout uses buffer device
+// addresses.
+iree_status_t iree_hal_vulkan_native_executable_layout_binding_address_offset(
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    uint32_t binding, uint32_t* out_offset);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -0,0 +1,235 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/vulkan/pipeline_executable_cache.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/vulkan/dynamic_symbol_tables.h"
+#include "iree/hal/vulkan/native_executable.h"
+#include "iree/hal/vulkan/status_util.h"
+
+using namespace iree::hal::vulkan;
+
+//===----------------------------------------------------------------------===//
+// VkPipelineCache utilities
+//===----------------------------------------------------------------------===//
+
+// Returns true if |data| begins with a VkPipelineCacheHeaderVersionOne that
+// matches |physical_device|. Drivers are required to reject incompatible data
+// but not all do so gracefully and checking here lets us report why the data
+// was dropped.
+static bool iree_hal_vulkan_pipeline_cache_is_compatible(
+    VkDeviceHandle* logical_device, VkPhysicalDevice physical_device,
+    iree_const_byte_span_t data) {
+  // NOTE: the header fields are tightly packed uint32_ts followed by the UUID
+  // so we read them individually instead of relying on struct layout.
+  const iree_host_size_t header_length = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+  if (data.data_length < header_length) return false;
+  uint32_t fields[4];
+  memcpy(fields, data.data, sizeof(fields));
+  const uint32_t length = fields[0];
+  const uint32_t version = fields[1];
+  const uint32_t vendor_id = fields[2];
+  const uint32_t device_id = fields[3];
+  if (length < header_length || length > data.data_length ||
+      version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+    return false;
+  }
+
+  VkPhysicalDeviceProperties properties;
+  logical_device->syms()->vkGetPhysicalDeviceProperties(physical_device,
+                                                        &properties);
+  return vendor_id == properties.vendorID &&
+         device_id == properties.deviceID &&
+         memcmp(data.data + sizeof(fields), properties.pipelineCacheUUID,
+                VK_UUID_SIZE) == 0;
+}
+
+iree_status_t iree_hal_vulkan_pipeline_cache_create(
+    VkDeviceHandle* logical_device, VkPhysicalDevice physical_device,
+    iree_const_byte_span_t initial_data, VkPipelineCache* out_pipeline_cache) {
+  IREE_ASSERT_ARGUMENT(logical_device);
+  IREE_ASSERT_ARGUMENT(out_pipeline_cache);
+  *out_pipeline_cache = VK_NULL_HANDLE;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  if (initial_data.data_length > 0 &&
+      !iree_hal_vulkan_pipeline_cache_is_compatible(
+          logical_device, physical_device, initial_data)) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "incompatible initial data dropped");
+    initial_data = iree_const_byte_span_empty();
+  }
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)initial_data.data_length);
+
+  VkPipelineCacheCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  create_info.pNext = NULL;
+  create_info.flags = 0;
+  create_info.initialDataSize = initial_data.data_length;
+  create_info.pInitialData = initial_data.data;
+  iree_status_t status = VK_RESULT_TO_STATUS(
+      logical_device->syms()->vkCreatePipelineCache(
+          *logical_device, &create_info, logical_device->allocator(),
+          out_pipeline_cache),
+      "vkCreatePipelineCache");
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_vulkan_pipeline_cache_destroy(VkDeviceHandle* logical_device,
+                                            VkPipelineCache pipeline_cache) {
+  if (pipeline_cache == VK_NULL_HANDLE) return;
+  logical_device->syms()->vkDestroyPipelineCache(
+      *logical_device, pipeline_cache, logical_device->allocator());
+}
+
+iree_status_t iree_hal_vulkan_pipeline_cache_serialize(
+    VkDeviceHandle* logical_device, VkPipelineCache pipeline_cache,
+    iree_allocator_t allocator, iree_byte_span_t* out_data) {
+  IREE_ASSERT_ARGUMENT(logical_device);
+  IREE_ASSERT_ARGUMENT(out_data);
+  *out_data = iree_make_byte_span(NULL, 0);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The cache may grow between the size query and the data query if other
+  // threads are creating pipelines; VK_INCOMPLETE indicates we need to retry
+  // with a larger buffer.
+  iree_status_t status = iree_ok_status();
+  uint8_t* data = NULL;
+  size_t data_size = 0;
+  VkResult result = VK_INCOMPLETE;
+  while (iree_status_is_ok(status) && result == VK_INCOMPLETE) {
+    status = VK_RESULT_TO_STATUS(
+        logical_device->syms()->vkGetPipelineCacheData(
+            *logical_device, pipeline_cache, &data_size, NULL),
+        "vkGetPipelineCacheData");
+    if (iree_status_is_ok(status)) {
+      status = iree_allocator_realloc(allocator, data_size, (void**)&data);
+    }
+    if (iree_status_is_ok(status)) {
+      result = logical_device->syms()->vkGetPipelineCacheData(
+          *logical_device, pipeline_cache, &data_size, data);
+      if (result != VK_INCOMPLETE) {
+        status = VK_RESULT_TO_STATUS(result, "vkGetPipelineCacheData");
+      }
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)data_size);
+    *out_data = iree_make_byte_span(data, data_size);
+  } else {
+    iree_allocator_free(allocator, data);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_vulkan_pipeline_executable_cache_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_vulkan_pipeline_executable_cache_t {
+  iree_hal_resource_t resource;
+  VkDeviceHandle* logical_device;
+  // Unowned; shared by all executable caches on the device.
+  VkPipelineCache pipeline_cache;
+} iree_hal_vulkan_pipeline_executable_cache_t;
+
+namespace {
+extern const iree_hal_executable_cache_vtable_t
+    iree_hal_vulkan_pipeline_executable_cache_vtable;
+}  // namespace
+
+static iree_hal_vulkan_pipeline_executable_cache_t*
+iree_hal_vulkan_pipeline_executable_cache_cast(
+    iree_hal_executable_cache_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value,
+                       &iree_hal_vulkan_pipeline_executable_cache_vtable);
+  return (iree_hal_vulkan_pipeline_executable_cache_t*)base_value;
+}
+
+iree_status_t iree_hal_vulkan_pipeline_executable_cache_create(
+    VkDeviceHandle* logical_device, iree_string_view_t identifier,
+    VkPipelineCache pipeline_cache,
+    iree_hal_executable_cache_t** out_executable_cache) {
+  IREE_ASSERT_ARGUMENT(out_executable_cache);
+  *out_executable_cache = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_vulkan_pipeline_executable_cache_t* executable_cache = NULL;
+  iree_status_t status = iree_allocator_malloc(logical_device->host_allocator(),
+                                               sizeof(*executable_cache),
+                                               (void**)&executable_cache);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(
+        &iree_hal_vulkan_pipeline_executable_cache_vtable,
+        &executable_cache->resource);
+    executable_cache->logical_device = logical_device;
+    executable_cache->pipeline_cache = pipeline_cache;
+
+    *out_executable_cache = (iree_hal_executable_cache_t*)executable_cache;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_vulkan_pipeline_executable_cache_destroy(
+    iree_hal_executable_cache_t* base_executable_cache) {
+  iree_hal_vulkan_pipeline_executable_cache_t* executable_cache =
+      iree_hal_vulkan_pipeline_executable_cache_cast(base_executable_cache);
+  iree_allocator_t host_allocator =
+      executable_cache->logical_device->host_allocator();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocator_free(host_allocator, executable_cache);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static bool iree_hal_vulkan_pipeline_executable_cache_can_prepare_format(
+    iree_hal_executable_cache_t* base_executable_cache,
+    iree_hal_executable_caching_mode_t caching_mode,
+    iree_string_view_t executable_format) {
+  return iree_string_view_equal(executable_format,
+                                iree_make_cstring_view("SPVE"));
+}
+
+static iree_status_t
+iree_hal_vulkan_pipeline_executable_cache_prepare_executable(
+    iree_hal_executable_cache_t* base_executable_cache,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  iree_hal_vulkan_pipeline_executable_cache_t* executable_cache =
+      iree_hal_vulkan_pipeline_executable_cache_cast(base_executable_cache);
+  VkPipelineCache pipeline_cache = executable_cache->pipeline_cache;
+  if (!iree_all_bits_set(
+          executable_spec->caching_mode,
+          IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_PERSISTENT_CACHING)) {
+    // Caller has requested the executable not be persisted.
+    pipeline_cache = VK_NULL_HANDLE;
+  }
+  return iree_hal_vulkan_native_executable_create(
+      executable_cache->logical_device, pipeline_cache, executable_spec,
+      out_executable);
+}
+
+namespace {
+const iree_hal_executable_cache_vtable_t
+    iree_hal_vulkan_pipeline_executable_cache_vtable = {
+        /*.destroy=*/iree_hal_vulkan_pipeline_executable_cache_destroy,
+        /*.can_prepare_format=*/
+        iree_hal_vulkan_pipeline_executable_cache_can_prepare_format,
+        /*.prepare_executable=*/
+        iree_hal_vulkan_pipeline_executable_cache_prepare_executable,
+};
+}  // namespace
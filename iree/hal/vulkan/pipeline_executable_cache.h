@@ -0,0 +1,65 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_VULKAN_PIPELINE_EXECUTABLE_CACHE_H_
+#define IREE_HAL_VULKAN_PIPELINE_EXECUTABLE_CACHE_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/vulkan/handle_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// VkPipelineCache utilities
+//===----------------------------------------------------------------------===//
+
+// Creates a VkPipelineCache seeded with |initial_data|, if provided.
+// The data is only used if its header matches |physical_device| (same vendor,
+// device, and pipelineCacheUUID); stale or foreign data (from a driver update
+// or another device) is ignored and an empty cache is created instead.
+//
+// VkPipelineCache is internally synchronized and the returned cache may be
+// shared by all executable caches on the device.
+iree_status_t iree_hal_vulkan_pipeline_cache_create(
+    iree::hal::vulkan::VkDeviceHandle* logical_device,
+    VkPhysicalDevice physical_device, iree_const_byte_span_t initial_data,
+    VkPipelineCache* out_pipeline_cache);
+
+// Destroys a |pipeline_cache| created with
+// iree_hal_vulkan_pipeline_cache_create.
+void iree_hal_vulkan_pipeline_cache_destroy(
+    iree::hal::vulkan::VkDeviceHandle* logical_device,
+    VkPipelineCache pipeline_cache);
+
+// Serializes the contents of |pipeline_cache| into a new allocation from
+// |allocator| returned in |out_data|. The data may be passed back to
+// iree_hal_vulkan_pipeline_cache_create on a future run to skip pipeline
+// compilation. The caller must free the data with |allocator|.
+iree_status_t iree_hal_vulkan_pipeline_cache_serialize(
+    iree::hal::vulkan::VkDeviceHandle* logical_device,
+    VkPipelineCache pipeline_cache, iree_allocator_t allocator,
+    iree_byte_span_t* out_data);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_vulkan_pipeline_executable_cache_t
+//===----------------------------------------------------------------------===//
+
+// Creates an executable cache that creates pipelines through the given
+// |pipeline_cache|. The pipeline cache is owned by the caller and must remain
+// valid for the lifetime of the executable cache.
+iree_status_t iree_hal_vulkan_pipeline_executable_cache_create(
+    iree::hal::vulkan::VkDeviceHandle* logical_device,
+    iree_string_view_t identifier, VkPipelineCache pipeline_cache,
+    iree_hal_executable_cache_t** out_executable_cache);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_VULKAN_PIPELINE_EXECUTABLE_CACHE_H_
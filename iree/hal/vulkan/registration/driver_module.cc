@@ -30,6 +30,20 @@ IREE_FLAG(bool, vulkan_force_timeline_semaphore_emulation, false,
 IREE_FLAG(bool, vulkan_tracing, true,
           "Enables Vulkan tracing (if IREE tracing is enabled).");
 
+IREE_FLAG(bool, vulkan_pipeline_cache, true,
+          "Creates pipelines through a VkPipelineCache.");
+IREE_FLAG(string, vulkan_pipeline_cache_path, "",
+          "Path of a file used to persist the VkPipelineCache across runs.");
+
+IREE_FLAG(bool, vulkan_buffer_device_addresses, false,
+          "Passes bindings as buffer device addresses; executables must be "
+          "compiled with --iree-vulkan-buffer-device-address.");
+
+IREE_FLAG(string, vulkan_dispatch_profile, "",
+          "Profiles dispatch GPU durations with timestamp queries and writes "
+          "them per entry point to the given path (`-` for stderr) when the "
+          "device is destroyed.");
+
 static iree_status_t iree_hal_vulkan_create_driver_with_flags(
     iree_string_view_t identifier, iree_allocator_t allocator,
     iree_hal_driver_t** out_driver) {
@@ -62,12 +76,30 @@ static iree_status_t iree_hal_vulkan_create_driver_with_flags(
     driver_options.requested_features |= IREE_HAL_VULKAN_FEATURE_ENABLE_TRACING;
   }
 
+  if (FLAG_vulkan_buffer_device_addresses) {
+    driver_options.requested_features |=
+        IREE_HAL_VULKAN_FEATURE_ENABLE_BUFFER_DEVICE_ADDRESSES;
+  }
+
   driver_options.default_device_index = FLAG_vulkan_default_index;
 
   if (FLAG_vulkan_force_timeline_semaphore_emulation) {
     driver_options.device_options.flags |=
         IREE_HAL_VULKAN_DEVICE_FORCE_TIMELINE_SEMAPHORE_EMULATION;
   }
+  if (!FLAG_vulkan_pipeline_cache) {
+    driver_options.device_options.flags |=
+        IREE_HAL_VULKAN_DEVICE_DISABLE_PIPELINE_CACHE;
+  }
+  driver_options.device_options.pipeline_cache_path =
+      iree_make_cstring_view(FLAG_vulkan_pipeline_cache_path);
+  driver_options.device_options.dispatch_profile_path =
+      iree_make_cstring_view(FLAG_vulkan_dispatch_profile);
+  if (!iree_string_view_is_empty(
+          driver_options.device_options.dispatch_profile_path)) {
+    driver_options.device_options.flags |=
+        IREE_HAL_VULKAN_DEVICE_ENABLE_DISPATCH_PROFILING;
+  }
 
   // Load the Vulkan library. This will fail if the library cannot be found or
   // does not have the expected functions.
@@ -6,6 +6,7 @@
 
 #include "iree/hal/vulkan/serializing_command_queue.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <type_traits>
@@ -41,6 +42,9 @@ iree_status_t TryToPrepareSemaphores(
   *out_ready_to_submit = false;
 
   wait_semaphores->clear();
+  // Timelines each entry in |wait_semaphores| was acquired from; batch wait
+  // semaphores that have already been signaled are skipped and do not get one.
+  std::vector<iree_hal_semaphore_t*> wait_timelines;
   for (const auto& timeline_semaphore : batch_wait_semaphores) {
     // Query first to progress this timeline semaphore to the furthest.
     uint64_t signaled_value = 0;
@@ -55,30 +59,31 @@ iree_status_t TryToPrepareSemaphores(
 
     // Otherwise try to get a binary semaphore for this time point so that
     // we can wait on.
-    // TODO(antiagainst): if this fails we need to cancel.
     VkSemaphore wait_semaphore = VK_NULL_HANDLE;
-    IREE_RETURN_IF_ERROR(iree_hal_vulkan_emulated_semaphore_acquire_wait_handle(
-        timeline_semaphore.first, timeline_semaphore.second, batch_fence,
-        &wait_semaphore));
-    wait_semaphores->push_back(wait_semaphore);
+    iree_status_t status =
+        iree_hal_vulkan_emulated_semaphore_acquire_wait_handle(
+            timeline_semaphore.first, timeline_semaphore.second, batch_fence,
+            &wait_semaphore);
 
-    if (wait_semaphore == VK_NULL_HANDLE) {
+    if (!iree_status_is_ok(status) || wait_semaphore == VK_NULL_HANDLE) {
       // We cannot wait on this time point yet: there are no previous semaphores
       // submitted to the GPU that can signal a value greater than what's
       // desired here.
 
-      // Cancel the wait so others may make progress.
-      // TODO(antiagainst): if any of these fail we need to cancel.
-      for (iree_host_size_t i = 0; i < batch_wait_semaphores.size(); ++i) {
-        if (!wait_semaphores->at(i)) break;
-        IREE_RETURN_IF_ERROR(
-            iree_hal_vulkan_emulated_semaphore_cancel_wait_handle(
-                batch_wait_semaphores[i].first, wait_semaphores->at(i)));
+      // Cancel the waits acquired so far so others may make progress.
+      for (size_t i = 0; i < wait_semaphores->size(); ++i) {
+        status = iree_status_join(
+            status, iree_hal_vulkan_emulated_semaphore_cancel_wait_handle(
+                        wait_timelines[i], wait_semaphores->at(i)));
       }
+      wait_semaphores->clear();
 
       // This batch cannot be submitted to GPU yet.
-      return iree_ok_status();
+      return status;
     }
+
+    wait_semaphores->push_back(wait_semaphore);
+    wait_timelines.push_back(timeline_semaphore.first);
   }
 
   // We've collected all necessary binary semaphores for each timeline we need
@@ -153,6 +158,22 @@ void PrepareSubmitInfo(
   submit_info->pSignalSemaphores = signal_semaphores.data();
 }
 
+// Notifies each of the |semaphores| that a submission signaling it has been
+// submitted to the GPU and releases them. Must be called without holding any
+// queue lock as the notification may advance other queues (and this one).
+iree_status_t NotifySignalSubmitted(
+    const std::vector<iree_hal_semaphore_t*>& semaphores) {
+  iree_status_t status = iree_ok_status();
+  for (iree_hal_semaphore_t* semaphore : semaphores) {
+    if (iree_status_is_ok(status)) {
+      status =
+          iree_hal_vulkan_emulated_semaphore_notify_signal_submitted(semaphore);
+    }
+    iree_hal_semaphore_release(semaphore);
+  }
+  return status;
+}
+
 }  // namespace
 
 SerializingCommandQueue::SerializingCommandQueue(
@@ -201,23 +222,30 @@ iree_status_t SerializingCommandQueue::Submit(
     new_submissions.push_back(std::move(submission));
   }
 
+  std::vector<iree_hal_semaphore_t*> signaled_semaphores;
   iree_slim_mutex_lock(&queue_mutex_);
   deferred_submissions_.merge_from(&new_submissions);
-  iree_status_t status = ProcessDeferredSubmissions();
+  iree_status_t status =
+      ProcessDeferredSubmissions(/*out_work_submitted=*/NULL,
+                                 &signaled_semaphores);
   iree_slim_mutex_unlock(&queue_mutex_);
-  return status;
+
+  // Submissions on other queues waiting on what we just submitted can now be
+  // submitted ahead of the signal without a round trip through the host.
+  return iree_status_join(status, NotifySignalSubmitted(signaled_semaphores));
 }
 
 iree_status_t SerializingCommandQueue::ProcessDeferredSubmissions(
-    bool* out_work_submitted) {
+    bool* out_work_submitted,
+    std::vector<iree_hal_semaphore_t*>* out_signaled_semaphores) {
   IREE_TRACE_SCOPE0("SerializingCommandQueue::ProcessDeferredSubmissions");
 
   // Try to process the submissions and if we hit a stopping point during the
   // process where we need to yield we take the remaining submissions and
   // re-enqueue them.
   IntrusiveList<std::unique_ptr<FencedSubmission>> remaining_submissions;
-  iree_status_t status =
-      TryProcessDeferredSubmissions(remaining_submissions, out_work_submitted);
+  iree_status_t status = TryProcessDeferredSubmissions(
+      remaining_submissions, out_work_submitted, out_signaled_semaphores);
   while (!remaining_submissions.empty()) {
     deferred_submissions_.push_back(
         remaining_submissions.take(remaining_submissions.front()));
@@ -228,12 +256,14 @@ iree_status_t SerializingCommandQueue::ProcessDeferredSubmissions(
 
 iree_status_t SerializingCommandQueue::TryProcessDeferredSubmissions(
     IntrusiveList<std::unique_ptr<FencedSubmission>>& remaining_submissions,
-    bool* out_work_submitted) {
+    bool* out_work_submitted,
+    std::vector<iree_hal_semaphore_t*>* out_signaled_semaphores) {
   if (out_work_submitted) *out_work_submitted = false;
 
   Arena arena(4 * 1024);
   std::vector<VkSubmitInfo> submit_infos;
   std::vector<VkFence> submit_fences;
+  std::vector<iree_hal_semaphore_t*> signaled_semaphores;
   while (!deferred_submissions_.empty()) {
     FencedSubmission* submission = deferred_submissions_.front();
     ref_ptr<TimePointFence>& fence = submission->fence;
@@ -251,6 +281,12 @@ iree_status_t SerializingCommandQueue::TryProcessDeferredSubmissions(
 
       submit_fences.push_back(fence->value());
       pending_fences_.emplace_back(std::move(fence));
+      for (const auto& timeline_semaphore : submission->signal_semaphores) {
+        if (std::find(signaled_semaphores.begin(), signaled_semaphores.end(),
+                      timeline_semaphore.first) == signaled_semaphores.end()) {
+          signaled_semaphores.push_back(timeline_semaphore.first);
+        }
+      }
       deferred_submissions_.pop_front();
     } else {
       // We need to defer the submission until later.
@@ -271,6 +307,12 @@ iree_status_t SerializingCommandQueue::TryProcessDeferredSubmissions(
         "vkQueueSubmit");
   }
 
+  if (out_signaled_semaphores) {
+    for (iree_hal_semaphore_t* semaphore : signaled_semaphores) {
+      iree_hal_semaphore_retain(semaphore);
+      out_signaled_semaphores->push_back(semaphore);
+    }
+  }
   if (out_work_submitted) *out_work_submitted = true;
   return iree_ok_status();
 }
@@ -373,10 +415,12 @@ iree_status_t SerializingCommandQueue::AdvanceQueueSubmission() {
   // submissions gotten submitted to the GPU. Other callers might be
   // interested in that information but for this API we just want to advance
   // queue submisison if possible. So we ignore it here.
+  std::vector<iree_hal_semaphore_t*> signaled_semaphores;
   iree_slim_mutex_lock(&queue_mutex_);
-  iree_status_t status = ProcessDeferredSubmissions();
+  iree_status_t status = ProcessDeferredSubmissions(
+      /*out_work_submitted=*/NULL, &signaled_semaphores);
   iree_slim_mutex_unlock(&queue_mutex_);
-  return status;
+  return iree_status_join(status, NotifySignalSubmitted(signaled_semaphores));
 }
 
 void SerializingCommandQueue::AbortQueueSubmission() {
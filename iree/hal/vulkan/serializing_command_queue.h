@@ -82,10 +82,16 @@ class SerializingCommandQueue final : public CommandQueue {
 
   // Processes deferred submissions in this queue and returns whether there are
   // new workload submitted to the GPU if no errors happen.
-  iree_status_t ProcessDeferredSubmissions(bool* out_work_submitted = NULL);
+  // If provided |out_signaled_semaphores| receives a retained reference to
+  // each timeline signaled by the newly submitted work; callers must notify
+  // them once they have released the queue lock.
+  iree_status_t ProcessDeferredSubmissions(
+      bool* out_work_submitted = NULL,
+      std::vector<iree_hal_semaphore_t*>* out_signaled_semaphores = NULL);
   iree_status_t TryProcessDeferredSubmissions(
       IntrusiveList<std::unique_ptr<FencedSubmission>>& remaining_submissions,
-      bool* out_work_submitted);
+      bool* out_work_submitted,
+      std::vector<iree_hal_semaphore_t*>* out_signaled_semaphores);
 
   TimePointFencePool* fence_pool_;
 
@@ -6,10 +6,13 @@
 
 #include "iree/hal/vulkan/vma_allocator.h"
 
+#include <cinttypes>
 #include <cstddef>
 #include <cstring>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/math.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
 #include "iree/hal/vulkan/status_util.h"
@@ -18,12 +21,70 @@
 
 using namespace iree::hal::vulkan;
 
+// Maximum number of staging buffers retained for reuse by uploads.
+#define IREE_HAL_VULKAN_VMA_STAGING_BUFFER_CAPACITY 4
+
+// Minimum size of staging buffers; uploads are rounded up to a power of two
+// no smaller than this so that similarly sized uploads can share buffers.
+#define IREE_HAL_VULKAN_VMA_MIN_STAGING_BUFFER_SIZE (1024 * 1024)
+
+// Size of the device memory blocks backing the transient buffer pools. Smaller
+// than the default heap block size so that short-lived allocations don't pin
+// large blocks on memory-constrained devices.
+#define IREE_HAL_VULKAN_VMA_TRANSIENT_BLOCK_SIZE (16 * 1024 * 1024)
+
+// Largest transient allocation served from the transient pools; larger ones
+// would waste most of a block and are allocated from the default pools.
+#define IREE_HAL_VULKAN_VMA_MAX_TRANSIENT_POOL_ALLOCATION_SIZE \
+  (IREE_HAL_VULKAN_VMA_TRANSIENT_BLOCK_SIZE / 2)
+
+// Maximum number of blocks each transient pool may grow to. Transient
+// allocations that don't fit once a pool has reached this size are allocated
+// from the default pools instead so that bursts don't pin more memory in the
+// pools than steady-state execution needs.
+#if !defined(IREE_HAL_VULKAN_VMA_MAX_TRANSIENT_BLOCK_COUNT)
+#define IREE_HAL_VULKAN_VMA_MAX_TRANSIENT_BLOCK_COUNT 8
+#endif  // !IREE_HAL_VULKAN_VMA_MAX_TRANSIENT_BLOCK_COUNT
+
 typedef struct iree_hal_vulkan_vma_allocator_t {
   iree_hal_resource_t resource;
   iree_hal_device_t* device;  // unretained to avoid cycles
+  VkDeviceHandle* logical_device;
   iree_allocator_t host_allocator;
   VmaAllocator vma;
 
+  // True if all device-local memory is also host-visible (UMA); buffers can
+  // then be filled in place instead of through staging buffers.
+  bool is_unified_memory;
+
+  // Required alignment of host pointers and sizes imported with
+  // VK_EXT_external_memory_host or 0 if host memory cannot be imported.
+  VkDeviceSize host_import_alignment;
+
+  // Host-visible staging buffers retained for uploads into buffers that are
+  // not host-visible. Uploads are synchronous and return their staging buffer
+  // as soon as they complete so the next upload can reuse it.
+  iree_slim_mutex_t staging_mutex;
+  iree_host_size_t staging_buffer_count;
+  iree_hal_buffer_t*
+      staging_buffers[IREE_HAL_VULKAN_VMA_STAGING_BUFFER_CAPACITY];
+
+  // Queue families buffers may be used from. When there is more than one the
+  // buffers are created with VK_SHARING_MODE_CONCURRENT so that they can be
+  // used from any of the device queues without ownership transfers.
+  uint32_t queue_family_count;
+  uint32_t queue_family_indices[2];
+
+  // Custom pools per memory type index serving IREE_HAL_MEMORY_TYPE_TRANSIENT
+  // allocations, created on first use. Transient buffers live for at most a
+  // few submissions and are retained by the command buffers using them until
+  // the submissions retire, so their memory is returned to the pools in queue
+  // order and reused by later submissions without new vkAllocateMemory calls.
+  // Keeping them apart from long-lived buffers also avoids the fragmentation
+  // that would otherwise keep default pool blocks alive.
+  iree_slim_mutex_t transient_pool_mutex;
+  VmaPool transient_pools[VK_MAX_MEMORY_TYPES];
+
   IREE_STATISTICS(VkPhysicalDeviceMemoryProperties memory_props;)
   IREE_STATISTICS(iree_hal_allocator_statistics_t statistics;)
 } iree_hal_vulkan_vma_allocator_t;
@@ -84,6 +145,7 @@ static void VKAPI_PTR iree_hal_vulkan_vma_free_callback(
 iree_status_t iree_hal_vulkan_vma_allocator_create(
     VkInstance instance, VkPhysicalDevice physical_device,
     VkDeviceHandle* logical_device, iree_hal_device_t* device,
+    uint32_t queue_family_count, const uint32_t* queue_family_indices,
     VmaRecordSettings record_settings, iree_hal_allocator_t** out_allocator) {
   IREE_ASSERT_ARGUMENT(instance);
   IREE_ASSERT_ARGUMENT(physical_device);
@@ -101,8 +163,55 @@ iree_status_t iree_hal_vulkan_vma_allocator_create(
                                &allocator->resource);
   allocator->host_allocator = host_allocator;
   allocator->device = device;
+  allocator->logical_device = logical_device;
+  allocator->queue_family_count = 0;
+  for (uint32_t i = 0; i < queue_family_count; ++i) {
+    bool is_duplicate = false;
+    for (uint32_t j = 0; j < allocator->queue_family_count; ++j) {
+      is_duplicate |=
+          allocator->queue_family_indices[j] == queue_family_indices[i];
+    }
+    if (is_duplicate) continue;
+    if (allocator->queue_family_count >=
+        IREE_ARRAYSIZE(allocator->queue_family_indices)) {
+      iree_allocator_free(host_allocator, allocator);
+      IREE_TRACE_ZONE_END(z0);
+      return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "at most %zu distinct queue families supported",
+                              IREE_ARRAYSIZE(allocator->queue_family_indices));
+    }
+    allocator->queue_family_indices[allocator->queue_family_count++] =
+        queue_family_indices[i];
+  }
 
   const auto& syms = logical_device->syms();
+
+  allocator->host_import_alignment = 0;
+  PFN_vkGetPhysicalDeviceProperties2 get_physical_device_properties2 =
+      syms->vkGetPhysicalDeviceProperties2
+          ? syms->vkGetPhysicalDeviceProperties2
+          : syms->vkGetPhysicalDeviceProperties2KHR;
+  if (logical_device->enabled_extensions().external_memory_host &&
+      get_physical_device_properties2) {
+    VkPhysicalDeviceExternalMemoryHostPropertiesEXT host_properties;
+    memset(&host_properties, 0, sizeof(host_properties));
+    host_properties.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+    VkPhysicalDeviceProperties2 properties2;
+    memset(&properties2, 0, sizeof(properties2));
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &host_properties;
+    get_physical_device_properties2(physical_device, &properties2);
+    allocator->host_import_alignment =
+        host_properties.minImportedHostPointerAlignment;
+  }
+
+  iree_slim_mutex_initialize(&allocator->staging_mutex);
+  allocator->staging_buffer_count = 0;
+
+  iree_slim_mutex_initialize(&allocator->transient_pool_mutex);
+  memset(allocator->transient_pools, 0, sizeof(allocator->transient_pools));
+
   VmaVulkanFunctions vulkan_fns;
   memset(&vulkan_fns, 0, sizeof(vulkan_fns));
   vulkan_fns.vkGetPhysicalDeviceProperties =
@@ -138,6 +247,11 @@ iree_status_t iree_hal_vulkan_vma_allocator_create(
   VmaAllocatorCreateInfo create_info;
   memset(&create_info, 0, sizeof(create_info));
   create_info.flags = 0;
+  if (logical_device->enabled_extensions().buffer_device_address) {
+    // Allocates memory with VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT so that the
+    // addresses of buffers bound to it can be queried.
+    create_info.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+  }
   create_info.physicalDevice = physical_device;
   create_info.device = *logical_device;
   create_info.instance = instance;
@@ -155,6 +269,26 @@ iree_status_t iree_hal_vulkan_vma_allocator_create(
   if (iree_status_is_ok(status)) {
     allocator->vma = vma;
 
+    // Mobile GPUs (Mali/Adreno/etc) and integrated GPUs generally only expose
+    // device-local memory types that are host-visible. Discrete GPUs may have a
+    // small host-visible device-local heap but it's not all of device memory.
+    const VkPhysicalDeviceMemoryProperties* vma_memory_props = NULL;
+    vmaGetMemoryProperties(allocator->vma, &vma_memory_props);
+    bool has_device_local = false;
+    bool all_device_local_host_visible = true;
+    for (uint32_t i = 0; i < vma_memory_props->memoryTypeCount; ++i) {
+      VkMemoryPropertyFlags flags =
+          vma_memory_props->memoryTypes[i].propertyFlags;
+      if (!iree_all_bits_set(flags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+        continue;
+      }
+      has_device_local = true;
+      all_device_local_host_visible &=
+          iree_all_bits_set(flags, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    }
+    allocator->is_unified_memory =
+        has_device_local && all_device_local_host_visible;
+
     IREE_STATISTICS({
       const VkPhysicalDeviceMemoryProperties* memory_props = NULL;
       vmaGetMemoryProperties(allocator->vma, &memory_props);
@@ -165,12 +299,40 @@ iree_status_t iree_hal_vulkan_vma_allocator_create(
     *out_allocator = (iree_hal_allocator_t*)allocator;
   } else {
     vmaDestroyAllocator(vma);
+    iree_slim_mutex_deinitialize(&allocator->transient_pool_mutex);
+    iree_slim_mutex_deinitialize(&allocator->staging_mutex);
+    iree_allocator_free(host_allocator, allocator);
   }
 
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
 
+iree_hal_device_t* iree_hal_vulkan_vma_allocator_device(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_vulkan_vma_allocator_t* allocator =
+      iree_hal_vulkan_vma_allocator_cast(base_allocator);
+  return allocator->device;
+}
+
+void iree_hal_vulkan_vma_allocator_query_transient_pool_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_vulkan_vma_transient_pool_statistics_t* out_statistics) {
+  iree_hal_vulkan_vma_allocator_t* allocator =
+      iree_hal_vulkan_vma_allocator_cast(base_allocator);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  iree_slim_mutex_lock(&allocator->transient_pool_mutex);
+  for (uint32_t i = 0; i < IREE_ARRAYSIZE(allocator->transient_pools); ++i) {
+    if (allocator->transient_pools[i] == VK_NULL_HANDLE) continue;
+    VmaPoolStats pool_stats;
+    vmaGetPoolStats(allocator->vma, allocator->transient_pools[i],
+                    &pool_stats);
+    out_statistics->allocation_count += pool_stats.allocationCount;
+    out_statistics->block_count += pool_stats.blockCount;
+  }
+  iree_slim_mutex_unlock(&allocator->transient_pool_mutex);
+}
+
 static void iree_hal_vulkan_vma_allocator_destroy(
     iree_hal_allocator_t* base_allocator) {
   iree_hal_vulkan_vma_allocator_t* allocator =
@@ -178,6 +340,18 @@ static void iree_hal_vulkan_vma_allocator_destroy(
   iree_allocator_t host_allocator = allocator->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Staging buffers must be released before the VMA allocator they came from.
+  iree_status_ignore(iree_hal_allocator_trim(base_allocator));
+  iree_slim_mutex_deinitialize(&allocator->staging_mutex);
+
+  // All buffers allocated from the pools must have been released by now.
+  for (uint32_t i = 0; i < IREE_ARRAYSIZE(allocator->transient_pools); ++i) {
+    if (allocator->transient_pools[i] != VK_NULL_HANDLE) {
+      vmaDestroyPool(allocator->vma, allocator->transient_pools[i]);
+    }
+  }
+  iree_slim_mutex_deinitialize(&allocator->transient_pool_mutex);
+
   vmaDestroyAllocator(allocator->vma);
   iree_allocator_free(host_allocator, allocator);
 
@@ -193,6 +367,23 @@ static iree_allocator_t iree_hal_vulkan_vma_allocator_host_allocator(
 
 static iree_status_t iree_hal_vulkan_vma_allocator_trim(
     iree_hal_allocator_t* base_allocator) {
+  iree_hal_vulkan_vma_allocator_t* allocator =
+      iree_hal_vulkan_vma_allocator_cast(base_allocator);
+
+  // Release all retained staging buffers. We swap them out under the lock and
+  // release them outside of it as releasing calls back into the allocator.
+  iree_hal_buffer_t*
+      staging_buffers[IREE_HAL_VULKAN_VMA_STAGING_BUFFER_CAPACITY];
+  iree_slim_mutex_lock(&allocator->staging_mutex);
+  iree_host_size_t staging_buffer_count = allocator->staging_buffer_count;
+  memcpy(staging_buffers, allocator->staging_buffers,
+         staging_buffer_count * sizeof(staging_buffers[0]));
+  allocator->staging_buffer_count = 0;
+  iree_slim_mutex_unlock(&allocator->staging_mutex);
+  for (iree_host_size_t i = 0; i < staging_buffer_count; ++i) {
+    iree_hal_buffer_release(staging_buffers[i]);
+  }
+
   return iree_ok_status();
 }
 
@@ -245,6 +436,88 @@ static iree_status_t iree_hal_vulkan_vma_allocator_make_compatible(
   return iree_ok_status();
 }
 
+// Populates |out_create_info| for a buffer of |allocation_size| bytes usable as
+// |allowed_usage| from all of the queue families of the allocator.
+static void iree_hal_vulkan_vma_allocator_populate_buffer_create_info(
+    iree_hal_vulkan_vma_allocator_t* allocator,
+    iree_hal_buffer_usage_t allowed_usage, VkDeviceSize allocation_size,
+    VkBufferCreateInfo* out_create_info) {
+  out_create_info->sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  out_create_info->pNext = NULL;
+  out_create_info->flags = 0;
+  out_create_info->size = allocation_size;
+  out_create_info->usage = 0;
+  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
+    out_create_info->usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    out_create_info->usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  }
+  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
+    out_create_info->usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    out_create_info->usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    out_create_info->usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    if (allocator->logical_device->enabled_extensions()
+            .buffer_device_address) {
+      out_create_info->usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
+    }
+  }
+  if (allocator->queue_family_count > 1) {
+    out_create_info->sharingMode = VK_SHARING_MODE_CONCURRENT;
+    out_create_info->queueFamilyIndexCount = allocator->queue_family_count;
+    out_create_info->pQueueFamilyIndices = allocator->queue_family_indices;
+  } else {
+    out_create_info->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    out_create_info->queueFamilyIndexCount = 0;
+    out_create_info->pQueueFamilyIndices = NULL;
+  }
+}
+
+static iree_status_t iree_hal_vulkan_vma_allocator_upload(
+    iree_hal_vulkan_vma_allocator_t* allocator, iree_hal_buffer_t* buffer,
+    iree_const_byte_span_t data);
+
+// Returns the transient pool for the memory type VMA would select for
+// |buffer_create_info| and |allocation_create_info|, creating it if needed.
+static iree_status_t iree_hal_vulkan_vma_allocator_lookup_transient_pool(
+    iree_hal_vulkan_vma_allocator_t* allocator,
+    const VkBufferCreateInfo* buffer_create_info,
+    const VmaAllocationCreateInfo* allocation_create_info, VmaPool* out_pool) {
+  *out_pool = VK_NULL_HANDLE;
+  uint32_t memory_type_index = 0;
+  VK_RETURN_IF_ERROR(vmaFindMemoryTypeIndexForBufferInfo(
+                         allocator->vma, buffer_create_info,
+                         allocation_create_info, &memory_type_index),
+                     "vmaFindMemoryTypeIndexForBufferInfo");
+
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&allocator->transient_pool_mutex);
+  VmaPool pool = allocator->transient_pools[memory_type_index];
+  if (pool == VK_NULL_HANDLE) {
+    IREE_TRACE_ZONE_BEGIN(z0);
+    VmaPoolCreateInfo pool_create_info;
+    memset(&pool_create_info, 0, sizeof(pool_create_info));
+    pool_create_info.memoryTypeIndex = memory_type_index;
+    pool_create_info.flags = 0;
+    pool_create_info.blockSize = IREE_HAL_VULKAN_VMA_TRANSIENT_BLOCK_SIZE;
+    // No blocks are allocated up front; VMA retains one empty block once all
+    // allocations from it are freed so steady-state reuse doesn't reallocate.
+    pool_create_info.minBlockCount = 0;
+    pool_create_info.maxBlockCount =
+        IREE_HAL_VULKAN_VMA_MAX_TRANSIENT_BLOCK_COUNT;
+    pool_create_info.frameInUseCount = 0;
+    status = VK_RESULT_TO_STATUS(
+        vmaCreatePool(allocator->vma, &pool_create_info, &pool),
+        "vmaCreatePool");
+    if (iree_status_is_ok(status)) {
+      allocator->transient_pools[memory_type_index] = pool;
+    }
+    IREE_TRACE_ZONE_END(z0);
+  }
+  iree_slim_mutex_unlock(&allocator->transient_pool_mutex);
+
+  if (iree_status_is_ok(status)) *out_pool = pool;
+  return status;
+}
+
 static iree_status_t iree_hal_vulkan_vma_allocator_allocate_internal(
     iree_hal_vulkan_vma_allocator_t* allocator,
     iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
@@ -259,24 +532,20 @@ static iree_status_t iree_hal_vulkan_vma_allocator_allocate_internal(
   // act safely even on buffer ranges that are not naturally aligned.
   allocation_size = iree_host_align(allocation_size, 4);
 
-  VkBufferCreateInfo buffer_create_info;
-  buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-  buffer_create_info.pNext = NULL;
-  buffer_create_info.flags = 0;
-  buffer_create_info.size = allocation_size;
-  buffer_create_info.usage = 0;
-  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
-    buffer_create_info.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    buffer_create_info.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  // On unified memory systems device-local memory is host-visible and we can
+  // fill the buffer in place instead of staging the initial contents.
+  bool require_device_local = false;
+  if (allocator->is_unified_memory &&
+      !iree_const_byte_span_is_empty(initial_data) &&
+      iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    memory_type |= IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+    allowed_usage |= IREE_HAL_BUFFER_USAGE_MAPPING;
+    require_device_local = true;
   }
-  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
-    buffer_create_info.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    buffer_create_info.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-    buffer_create_info.usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
-  }
-  buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-  buffer_create_info.queueFamilyIndexCount = 0;
-  buffer_create_info.pQueueFamilyIndices = NULL;
+
+  VkBufferCreateInfo buffer_create_info;
+  iree_hal_vulkan_vma_allocator_populate_buffer_create_info(
+      allocator, allowed_usage, allocation_size, &buffer_create_info);
 
   VmaAllocationCreateInfo allocation_create_info;
   allocation_create_info.flags = flags;
@@ -321,17 +590,37 @@ static iree_status_t iree_hal_vulkan_vma_allocator_allocate_internal(
   if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_MAPPING)) {
     allocation_create_info.requiredFlags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
   }
+  if (require_device_local) {
+    allocation_create_info.requiredFlags |=
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  }
 
-  // TODO(benvanik): if on a unified memory system and initial data is present
-  // we could set the mapping bit and ensure a much more efficient upload.
+  // Suballocate transient buffers from the transient pools. Dedicated
+  // allocations and those larger than the pool blocks can't come from a pool.
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_TRANSIENT) &&
+      !iree_all_bits_set(flags, VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) &&
+      allocation_size <=
+          IREE_HAL_VULKAN_VMA_MAX_TRANSIENT_POOL_ALLOCATION_SIZE) {
+    IREE_RETURN_IF_ERROR(iree_hal_vulkan_vma_allocator_lookup_transient_pool(
+        allocator, &buffer_create_info, &allocation_create_info,
+        &allocation_create_info.pool));
+  }
 
   VkBuffer handle = VK_NULL_HANDLE;
   VmaAllocation allocation = VK_NULL_HANDLE;
   VmaAllocationInfo allocation_info;
-  VK_RETURN_IF_ERROR(vmaCreateBuffer(allocator->vma, &buffer_create_info,
-                                     &allocation_create_info, &handle,
-                                     &allocation, &allocation_info),
-                     "vmaCreateBuffer");
+  VkResult result = vmaCreateBuffer(allocator->vma, &buffer_create_info,
+                                    &allocation_create_info, &handle,
+                                    &allocation, &allocation_info);
+  if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY &&
+      allocation_create_info.pool != VK_NULL_HANDLE) {
+    // The transient pool has reached its block limit.
+    allocation_create_info.pool = VK_NULL_HANDLE;
+    result = vmaCreateBuffer(allocator->vma, &buffer_create_info,
+                             &allocation_create_info, &handle, &allocation,
+                             &allocation_info);
+  }
+  VK_RETURN_IF_ERROR(result, "vmaCreateBuffer");
 
   iree_hal_buffer_t* buffer = NULL;
   iree_status_t status = iree_hal_vulkan_vma_buffer_wrap(
@@ -345,9 +634,23 @@ static iree_status_t iree_hal_vulkan_vma_allocator_allocate_internal(
     return status;
   }
 
-  // Copy the initial contents into the buffer. This may require staging.
-  if (iree_status_is_ok(status) &&
-      !iree_const_byte_span_is_empty(initial_data)) {
+  // Copy the initial contents into the buffer. Mappable buffers (including
+  // device-local ones on unified memory systems) are filled in place. Large
+  // uploads into buffers we can't map use our retained staging buffers instead
+  // of allocating new ones each time.
+  bool is_mappable =
+      iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) &&
+      iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_MAPPING);
+  if (iree_status_is_ok(status) && is_mappable) {
+    status = iree_hal_buffer_write_data(buffer, 0, initial_data.data,
+                                        initial_data.data_length);
+  } else if (iree_status_is_ok(status) &&
+             initial_data.data_length >
+                 IREE_HAL_COMMAND_BUFFER_MAX_UPDATE_SIZE) {
+    status = iree_hal_vulkan_vma_allocator_upload(allocator, buffer,
+                                                  initial_data);
+  } else if (iree_status_is_ok(status) &&
+             !iree_const_byte_span_is_empty(initial_data)) {
     status = iree_hal_device_transfer_range(
         allocator->device,
         iree_hal_make_host_transfer_buffer_span((void*)initial_data.data,
@@ -365,6 +668,94 @@ static iree_status_t iree_hal_vulkan_vma_allocator_allocate_internal(
   return status;
 }
 
+// Acquires a host-visible staging buffer of at least |minimum_size| bytes,
+// reusing a retained one if possible. Return it with
+// iree_hal_vulkan_vma_allocator_release_staging_buffer.
+static iree_status_t iree_hal_vulkan_vma_allocator_acquire_staging_buffer(
+    iree_hal_vulkan_vma_allocator_t* allocator, iree_device_size_t minimum_size,
+    iree_hal_buffer_t** out_buffer) {
+  *out_buffer = NULL;
+
+  // Take the smallest retained buffer that fits.
+  iree_slim_mutex_lock(&allocator->staging_mutex);
+  iree_host_size_t best_index = allocator->staging_buffer_count;
+  for (iree_host_size_t i = 0; i < allocator->staging_buffer_count; ++i) {
+    iree_device_size_t size =
+        iree_hal_buffer_allocation_size(allocator->staging_buffers[i]);
+    if (size >= minimum_size &&
+        (best_index == allocator->staging_buffer_count ||
+         size < iree_hal_buffer_allocation_size(
+                    allocator->staging_buffers[best_index]))) {
+      best_index = i;
+    }
+  }
+  if (best_index < allocator->staging_buffer_count) {
+    *out_buffer = allocator->staging_buffers[best_index];
+    allocator->staging_buffers[best_index] =
+        allocator->staging_buffers[--allocator->staging_buffer_count];
+  }
+  iree_slim_mutex_unlock(&allocator->staging_mutex);
+  if (*out_buffer) return iree_ok_status();
+
+  iree_device_size_t allocation_size =
+      iree_max((iree_device_size_t)IREE_HAL_VULKAN_VMA_MIN_STAGING_BUFFER_SIZE,
+               (iree_device_size_t)iree_math_round_up_to_pow2_u64(
+                   (uint64_t)minimum_size));
+  return iree_hal_vulkan_vma_allocator_allocate_internal(
+      allocator,
+      IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING,
+      IREE_HAL_MEMORY_ACCESS_ALL, allocation_size, iree_const_byte_span_empty(),
+      /*flags=*/0, out_buffer);
+}
+
+// Returns |buffer| to the retained set or releases it if the set is full.
+static void iree_hal_vulkan_vma_allocator_release_staging_buffer(
+    iree_hal_vulkan_vma_allocator_t* allocator, iree_hal_buffer_t* buffer) {
+  iree_slim_mutex_lock(&allocator->staging_mutex);
+  if (allocator->staging_buffer_count <
+      IREE_ARRAYSIZE(allocator->staging_buffers)) {
+    allocator->staging_buffers[allocator->staging_buffer_count++] = buffer;
+    buffer = NULL;
+  }
+  iree_slim_mutex_unlock(&allocator->staging_mutex);
+  iree_hal_buffer_release(buffer);
+}
+
+// Uploads |data| to the start of |buffer| through a staging buffer and waits
+// for the upload to complete.
+static iree_status_t iree_hal_vulkan_vma_allocator_upload(
+    iree_hal_vulkan_vma_allocator_t* allocator, iree_hal_buffer_t* buffer,
+    iree_const_byte_span_t data) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)data.data_length);
+
+  iree_hal_buffer_t* staging_buffer = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_vulkan_vma_allocator_acquire_staging_buffer(
+              allocator, data.data_length, &staging_buffer));
+  iree_status_t status = iree_hal_buffer_write_data(
+      staging_buffer, 0, data.data, data.data_length);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_device_transfer_range(
+        allocator->device, iree_hal_make_device_transfer_buffer(staging_buffer),
+        0, iree_hal_make_device_transfer_buffer(buffer), 0, data.data_length,
+        IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, iree_infinite_timeout());
+  }
+
+  // If the transfer failed the device may still be using the staging buffer
+  // and we can't safely reuse it.
+  if (iree_status_is_ok(status)) {
+    iree_hal_vulkan_vma_allocator_release_staging_buffer(allocator,
+                                                         staging_buffer);
+  } else {
+    iree_hal_buffer_release(staging_buffer);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static iree_status_t iree_hal_vulkan_vma_allocator_allocate_buffer(
     iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
     iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
@@ -394,9 +785,156 @@ static iree_status_t iree_hal_vulkan_vma_allocator_wrap_buffer(
     iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
     iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  iree_hal_vulkan_vma_allocator_t* allocator =
+      iree_hal_vulkan_vma_allocator_cast(base_allocator);
+
+  // On unified memory systems read-only data (such as constants) can be cloned
+  // directly into device-local memory for about the cost of a memcpy. We then
+  // no longer need the original data and free it immediately. Writable data
+  // must alias the original memory and isn't supported.
   // TODO(#7242): use VK_EXT_external_memory_host to import memory.
-  return iree_make_status(IREE_STATUS_UNAVAILABLE,
-                          "wrapping of external buffers not supported");
+  if (!allocator->is_unified_memory ||
+      iree_any_bit_set(allowed_access, IREE_HAL_MEMORY_ACCESS_WRITE)) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "wrapping of external buffers not supported");
+  }
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_vma_allocator_allocate_internal(
+      allocator, memory_type, allowed_usage, allowed_access, data.data_length,
+      iree_make_const_byte_span(data.data, data.data_length), /*flags=*/0,
+      out_buffer));
+  iree_allocator_free(data_allocator, data.data);
+  return iree_ok_status();
+}
+
+// Imports |host_ptr| with VK_EXT_external_memory_host. The pointer and
+// |allocation_size| must be aligned to the host_import_alignment.
+static iree_status_t iree_hal_vulkan_vma_allocator_import_host_allocation(
+    iree_hal_vulkan_vma_allocator_t* allocator,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, void* host_ptr,
+    iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer) {
+  VkDeviceHandle* logical_device = allocator->logical_device;
+  const auto& syms = logical_device->syms();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)allocation_size);
+
+  VkMemoryHostPointerPropertiesEXT host_pointer_properties;
+  memset(&host_pointer_properties, 0, sizeof(host_pointer_properties));
+  host_pointer_properties.sType =
+      VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, VK_RESULT_TO_STATUS(
+              syms->vkGetMemoryHostPointerPropertiesEXT(
+                  *logical_device,
+                  VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+                  host_ptr, &host_pointer_properties),
+              "vkGetMemoryHostPointerPropertiesEXT"));
+
+  VkExternalMemoryBufferCreateInfo external_create_info;
+  external_create_info.sType =
+      VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+  external_create_info.pNext = NULL;
+  external_create_info.handleTypes =
+      VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+  VkBufferCreateInfo buffer_create_info;
+  iree_hal_vulkan_vma_allocator_populate_buffer_create_info(
+      allocator, allowed_usage, allocation_size, &buffer_create_info);
+  buffer_create_info.pNext = &external_create_info;
+  VkBuffer handle = VK_NULL_HANDLE;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, VK_RESULT_TO_STATUS(
+              syms->vkCreateBuffer(*logical_device, &buffer_create_info,
+                                   logical_device->allocator(), &handle),
+              "vkCreateBuffer"));
+
+  // Pick a host-coherent memory type that can hold both the buffer and the
+  // host pointer, preferring device-local (integrated GPUs).
+  VkMemoryRequirements requirements;
+  syms->vkGetBufferMemoryRequirements(*logical_device, handle, &requirements);
+  const VkPhysicalDeviceMemoryProperties* memory_props = NULL;
+  vmaGetMemoryProperties(allocator->vma, &memory_props);
+  uint32_t memory_type_bits =
+      requirements.memoryTypeBits & host_pointer_properties.memoryTypeBits;
+  uint32_t memory_type_index = UINT32_MAX;
+  bool is_device_local = false;
+  for (uint32_t i = 0; i < memory_props->memoryTypeCount; ++i) {
+    if (!(memory_type_bits & (1u << i))) continue;
+    VkMemoryPropertyFlags flags = memory_props->memoryTypes[i].propertyFlags;
+    if (!iree_all_bits_set(flags, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+      continue;
+    }
+    bool device_local =
+        iree_all_bits_set(flags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (memory_type_index == UINT32_MAX || (device_local && !is_device_local)) {
+      memory_type_index = i;
+      is_device_local = device_local;
+    }
+  }
+  iree_status_t status = iree_ok_status();
+  if (memory_type_index == UINT32_MAX) {
+    status = iree_make_status(
+        IREE_STATUS_UNAVAILABLE,
+        "no host-coherent memory type can import the host allocation");
+  } else if (requirements.size > allocation_size) {
+    status = iree_make_status(
+        IREE_STATUS_UNAVAILABLE,
+        "buffer requires %" PRIu64 " bytes but the host allocation is %" PRIu64,
+        (uint64_t)requirements.size, (uint64_t)allocation_size);
+  }
+
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  if (iree_status_is_ok(status)) {
+    VkImportMemoryHostPointerInfoEXT import_info;
+    import_info.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+    import_info.pNext = NULL;
+    import_info.handleType =
+        VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+    import_info.pHostPointer = host_ptr;
+    VkMemoryAllocateFlagsInfoKHR allocate_flags_info;
+    if (logical_device->enabled_extensions().buffer_device_address) {
+      allocate_flags_info.sType =
+          VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR;
+      allocate_flags_info.pNext = NULL;
+      allocate_flags_info.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
+      allocate_flags_info.deviceMask = 0;
+      import_info.pNext = &allocate_flags_info;
+    }
+    VkMemoryAllocateInfo allocate_info;
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.pNext = &import_info;
+    allocate_info.allocationSize = allocation_size;
+    allocate_info.memoryTypeIndex = memory_type_index;
+    status = VK_RESULT_TO_STATUS(
+        syms->vkAllocateMemory(*logical_device, &allocate_info,
+                               logical_device->allocator(), &memory),
+        "vkAllocateMemory");
+  }
+  if (iree_status_is_ok(status)) {
+    status = VK_RESULT_TO_STATUS(
+        syms->vkBindBufferMemory(*logical_device, handle, memory, 0),
+        "vkBindBufferMemory");
+  }
+
+  if (iree_status_is_ok(status)) {
+    iree_hal_memory_type_t memory_type =
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+    if (is_device_local) memory_type |= IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL;
+    // NOTE: the buffer takes ownership of |handle| and |memory|.
+    status = iree_hal_vulkan_vma_buffer_wrap_host_allocation(
+        (iree_hal_allocator_t*)allocator, memory_type, allowed_access,
+        allowed_usage, allocation_size, logical_device, handle, memory,
+        host_ptr, out_buffer);
+  } else {
+    syms->vkDestroyBuffer(*logical_device, handle,
+                          logical_device->allocator());
+    if (memory) {
+      syms->vkFreeMemory(*logical_device, memory, logical_device->allocator());
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 static iree_status_t iree_hal_vulkan_vma_allocator_import_buffer(
@@ -405,8 +943,45 @@ static iree_status_t iree_hal_vulkan_vma_allocator_import_buffer(
     iree_hal_buffer_usage_t allowed_usage,
     iree_hal_external_buffer_t* external_buffer,
     iree_hal_buffer_t** out_buffer) {
-  return iree_make_status(IREE_STATUS_UNAVAILABLE,
-                          "importing from external buffers not supported");
+  iree_hal_vulkan_vma_allocator_t* allocator =
+      iree_hal_vulkan_vma_allocator_cast(base_allocator);
+  if (external_buffer->type != IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "external buffer type %d not supported",
+                            (int)external_buffer->type);
+  }
+  void* host_ptr = external_buffer->handle.host_allocation.ptr;
+  iree_device_size_t size = external_buffer->size;
+
+  // Zero-copy import when the device supports it and the allocation is
+  // suitably aligned.
+  VkDeviceSize alignment = allocator->host_import_alignment;
+  bool is_importable = alignment != 0 && size != 0 &&
+                       ((uintptr_t)host_ptr % alignment) == 0 &&
+                       (size % alignment) == 0;
+  iree_status_t status = iree_ok_status();
+  if (is_importable) {
+    status = iree_hal_vulkan_vma_allocator_import_host_allocation(
+        allocator, allowed_access, allowed_usage, host_ptr, size, out_buffer);
+    if (iree_status_is_ok(status)) return status;
+  } else {
+    status = iree_make_status(
+        IREE_STATUS_UNAVAILABLE,
+        "host allocation import requires VK_EXT_external_memory_host and a "
+        "pointer and size aligned to %" PRIu64 " bytes",
+        (uint64_t)alignment);
+  }
+
+  // Without aliasing device writes would not be visible through the host
+  // pointer so we can only copy allocations that will never be written.
+  if (iree_any_bit_set(allowed_access, IREE_HAL_MEMORY_ACCESS_WRITE)) {
+    return status;
+  }
+  iree_status_ignore(status);
+  return iree_hal_vulkan_vma_allocator_allocate_internal(
+      allocator, memory_type, allowed_usage | IREE_HAL_BUFFER_USAGE_TRANSFER,
+      allowed_access, size, iree_make_const_byte_span(host_ptr, size),
+      /*flags=*/0, out_buffer);
 }
 
 static iree_status_t iree_hal_vulkan_vma_allocator_export_buffer(
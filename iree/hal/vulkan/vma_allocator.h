@@ -30,15 +30,42 @@ extern "C" {
 // VMA is internally synchronized and the functionality exposed on the HAL
 // interface is thread-safe.
 //
+// Buffers are shared between all of the |queue_family_indices| the device
+// submits to; if more than one distinct family is provided buffers are created
+// with concurrent sharing so that they need no queue family ownership
+// transfers.
+//
 // More information:
 //   https://github.com/GPUOpen-LibrariesAndSDKs/VulkanMemoryAllocator
 //   https://gpuopen-librariesandsdks.github.io/VulkanMemoryAllocator/html/
 iree_status_t iree_hal_vulkan_vma_allocator_create(
     VkInstance instance, VkPhysicalDevice physical_device,
     iree::hal::vulkan::VkDeviceHandle* logical_device,
-    iree_hal_device_t* device, VmaRecordSettings record_settings,
+    iree_hal_device_t* device, uint32_t queue_family_count,
+    const uint32_t* queue_family_indices, VmaRecordSettings record_settings,
     iree_hal_allocator_t** out_allocator);
 
+// Returns the device |allocator| was created for. Unretained.
+iree_hal_device_t* iree_hal_vulkan_vma_allocator_device(
+    iree_hal_allocator_t* allocator);
+
+// Statistics of the pools serving IREE_HAL_MEMORY_TYPE_TRANSIENT allocations
+// aggregated across all memory types.
+typedef struct iree_hal_vulkan_vma_transient_pool_statistics_t {
+  // Number of live buffers allocated from the transient pools.
+  iree_host_size_t allocation_count;
+  // Number of device memory blocks held by the transient pools.
+  iree_host_size_t block_count;
+} iree_hal_vulkan_vma_transient_pool_statistics_t;
+
+// Queries the current usage of the transient pools of |allocator|.
+// Transient allocations that are dedicated, too large for the pools, or made
+// once the pools have reached their block limit come from the default pools
+// and are not included.
+void iree_hal_vulkan_vma_allocator_query_transient_pool_statistics(
+    iree_hal_allocator_t* allocator,
+    iree_hal_vulkan_vma_transient_pool_statistics_t* out_statistics);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
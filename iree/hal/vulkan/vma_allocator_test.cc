@@ -0,0 +1,175 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/vulkan/vma_allocator.h"
+
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/vulkan/registration/driver_module.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace vulkan {
+namespace {
+
+constexpr iree_device_size_t kSmallSize = 64 * 1024;
+
+// Small enough to be served from the transient pools (at most half a block).
+constexpr iree_device_size_t kPooledSize = 4 * 1024 * 1024;
+
+// Larger than any transient pool block.
+constexpr iree_device_size_t kOversizedSize = 32 * 1024 * 1024;
+
+// Upper bound on the number of allocations made to exhaust the transient pools.
+constexpr int kMaxExhaustionAllocations = 256;
+
+class VmaAllocatorTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    IREE_CHECK_OK(iree_hal_vulkan_driver_module_register(
+        iree_hal_driver_registry_default()));
+  }
+
+  virtual void SetUp() {
+    iree_status_t status = iree_hal_driver_registry_try_create_by_name(
+        iree_hal_driver_registry_default(), iree_make_cstring_view("vulkan"),
+        iree_allocator_system(), &driver_);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_driver_create_default_device(
+          driver_, iree_allocator_system(), &device_);
+    }
+    if (iree_status_is_unavailable(status)) {
+      iree_status_free(status);
+      GTEST_SKIP() << "Vulkan driver or device unavailable";
+    }
+    IREE_ASSERT_OK(status);
+    device_allocator_ = iree_hal_device_allocator(device_);
+  }
+
+  virtual void TearDown() {
+    iree_hal_device_release(device_);
+    iree_hal_driver_release(driver_);
+  }
+
+  iree_status_t Allocate(iree_hal_memory_type_t memory_type,
+                         iree_device_size_t size,
+                         iree_hal_buffer_t** out_buffer) {
+    return iree_hal_allocator_allocate_buffer(
+        device_allocator_, memory_type,
+        IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER, size,
+        iree_const_byte_span_empty(), out_buffer);
+  }
+
+  iree_hal_buffer_t* AllocateTransient(iree_device_size_t size) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(Allocate(
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_TRANSIENT,
+        size, &buffer));
+    return buffer;
+  }
+
+  iree_hal_vulkan_vma_transient_pool_statistics_t QueryStatistics() {
+    iree_hal_vulkan_vma_transient_pool_statistics_t statistics;
+    iree_hal_vulkan_vma_allocator_query_transient_pool_statistics(
+        device_allocator_, &statistics);
+    return statistics;
+  }
+
+  iree_hal_driver_t* driver_ = NULL;
+  iree_hal_device_t* device_ = NULL;
+  iree_hal_allocator_t* device_allocator_ = NULL;
+};
+
+// Tests that transient buffers are allocated from the transient pools and that
+// their memory returns to the pools for reuse when released.
+TEST_F(VmaAllocatorTest, TransientAllocatedFromPool) {
+  iree_hal_buffer_t* buffer = AllocateTransient(kSmallSize);
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(1u, statistics.allocation_count);
+  EXPECT_EQ(1u, statistics.block_count);
+
+  iree_hal_buffer_release(buffer);
+  statistics = QueryStatistics();
+  EXPECT_EQ(0u, statistics.allocation_count);
+  // The empty block is retained for reuse.
+  EXPECT_EQ(1u, statistics.block_count);
+
+  buffer = AllocateTransient(kSmallSize);
+  statistics = QueryStatistics();
+  EXPECT_EQ(1u, statistics.allocation_count);
+  EXPECT_EQ(1u, statistics.block_count);
+  iree_hal_buffer_release(buffer);
+}
+
+// Tests that buffers that are not transient don't use the transient pools.
+TEST_F(VmaAllocatorTest, NonTransientNotPooled) {
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(
+      Allocate(IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL, kSmallSize, &buffer));
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(0u, statistics.allocation_count);
+  EXPECT_EQ(0u, statistics.block_count);
+  iree_hal_buffer_release(buffer);
+}
+
+// Tests that transient buffers too large for the pool blocks are allocated
+// from the default pools.
+TEST_F(VmaAllocatorTest, OversizedTransientFallsBack) {
+  iree_hal_buffer_t* buffer = AllocateTransient(kOversizedSize);
+  EXPECT_EQ(0u, QueryStatistics().allocation_count);
+  iree_hal_buffer_release(buffer);
+}
+
+// Tests that transient allocations fall back to the default pools once the
+// transient pools have reached their block limit and that pooled allocations
+// resume once memory is returned to the pools.
+TEST_F(VmaAllocatorTest, ExhaustedPoolFallsBack) {
+  std::vector<iree_hal_buffer_t*> buffers;
+  bool fell_back = false;
+  iree_host_size_t block_limit = 0;
+  for (int i = 0; i < kMaxExhaustionAllocations && !fell_back; ++i) {
+    auto before = QueryStatistics();
+    iree_hal_buffer_t* buffer = NULL;
+    iree_status_t status = Allocate(
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_TRANSIENT,
+        kPooledSize, &buffer);
+    if (iree_status_is_resource_exhausted(status)) {
+      iree_status_free(status);
+      for (auto* allocated : buffers) iree_hal_buffer_release(allocated);
+      GTEST_SKIP() << "device ran out of memory before the pools were full";
+    }
+    IREE_ASSERT_OK(status);
+    buffers.push_back(buffer);
+    auto after = QueryStatistics();
+    if (after.allocation_count == before.allocation_count) {
+      // The allocation succeeded without the pools growing.
+      EXPECT_EQ(before.block_count, after.block_count);
+      fell_back = true;
+      block_limit = after.block_count;
+    }
+  }
+  EXPECT_TRUE(fell_back);
+
+  // Releasing a pooled buffer makes room for the next transient allocation.
+  iree_hal_buffer_release(buffers.front());
+  buffers.erase(buffers.begin());
+  auto before = QueryStatistics();
+  buffers.push_back(AllocateTransient(kPooledSize));
+  auto after = QueryStatistics();
+  EXPECT_EQ(before.allocation_count + 1, after.allocation_count);
+  EXPECT_EQ(block_limit, after.block_count);
+
+  for (auto* buffer : buffers) iree_hal_buffer_release(buffer);
+}
+
+}  // namespace
+}  // namespace vulkan
+}  // namespace hal
+}  // namespace iree
@@ -12,7 +12,12 @@
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/vulkan/dynamic_symbols.h"
 #include "iree/hal/vulkan/status_util.h"
+#include "iree/hal/vulkan/vma_allocator.h"
+
+using namespace iree::hal::vulkan;
 
 typedef struct iree_hal_vulkan_vma_buffer_t {
   iree_hal_buffer_t base;
@@ -21,6 +26,12 @@ typedef struct iree_hal_vulkan_vma_buffer_t {
   VkBuffer handle;
   VmaAllocation allocation;
   VmaAllocationInfo allocation_info;
+
+  // Set when the buffer is bound to imported host memory instead of a VMA
+  // allocation; |vma| and |allocation| are NULL.
+  VkDeviceHandle* logical_device;
+  VkDeviceMemory imported_memory;
+  uint8_t* imported_host_ptr;
 } iree_hal_vulkan_vma_buffer_t;
 
 namespace {
@@ -61,6 +72,9 @@ iree_status_t iree_hal_vulkan_vma_buffer_wrap(
     buffer->handle = handle;
     buffer->allocation = allocation;
     buffer->allocation_info = allocation_info;
+    buffer->logical_device = NULL;
+    buffer->imported_memory = VK_NULL_HANDLE;
+    buffer->imported_host_ptr = NULL;
 
     // TODO(benvanik): set debug name instead and use the
     //     VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT flag.
@@ -79,6 +93,50 @@ iree_status_t iree_hal_vulkan_vma_buffer_wrap(
   return iree_ok_status();
 }
 
+iree_status_t iree_hal_vulkan_vma_buffer_wrap_host_allocation(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    VkDeviceHandle* logical_device, VkBuffer handle, VkDeviceMemory memory,
+    void* host_ptr, iree_hal_buffer_t** out_buffer) {
+  IREE_ASSERT_ARGUMENT(allocator);
+  IREE_ASSERT_ARGUMENT(logical_device);
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(memory);
+  IREE_ASSERT_ARGUMENT(host_ptr);
+  IREE_ASSERT_ARGUMENT(out_buffer);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocator_t host_allocator =
+      iree_hal_allocator_host_allocator(allocator);
+  iree_hal_vulkan_vma_buffer_t* buffer = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, sizeof(*buffer), (void**)&buffer);
+  if (iree_status_is_ok(status)) {
+    iree_hal_buffer_initialize(
+        host_allocator, allocator, &buffer->base, allocation_size,
+        /*byte_offset=*/0, /*byte_length=*/allocation_size, memory_type,
+        allowed_access, allowed_usage, &iree_hal_vulkan_vma_buffer_vtable,
+        &buffer->base);
+    buffer->vma = VK_NULL_HANDLE;
+    buffer->handle = handle;
+    buffer->allocation = VK_NULL_HANDLE;
+    memset(&buffer->allocation_info, 0, sizeof(buffer->allocation_info));
+    buffer->logical_device = logical_device;
+    buffer->imported_memory = memory;
+    buffer->imported_host_ptr = (uint8_t*)host_ptr;
+    *out_buffer = &buffer->base;
+  } else {
+    logical_device->syms()->vkDestroyBuffer(*logical_device, handle,
+                                            logical_device->allocator());
+    logical_device->syms()->vkFreeMemory(*logical_device, memory,
+                                         logical_device->allocator());
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static void iree_hal_vulkan_vma_buffer_destroy(iree_hal_buffer_t* base_buffer) {
   iree_hal_vulkan_vma_buffer_t* buffer =
       iree_hal_vulkan_vma_buffer_cast(base_buffer);
@@ -87,7 +145,15 @@ static void iree_hal_vulkan_vma_buffer_destroy(iree_hal_buffer_t* base_buffer) {
 
   // IREE_TRACE_FREE_NAMED("VMA", (void*)buffer->handle);
 
-  vmaDestroyBuffer(buffer->vma, buffer->handle, buffer->allocation);
+  if (buffer->imported_memory) {
+    VkDeviceHandle* logical_device = buffer->logical_device;
+    logical_device->syms()->vkDestroyBuffer(*logical_device, buffer->handle,
+                                            logical_device->allocator());
+    logical_device->syms()->vkFreeMemory(
+        *logical_device, buffer->imported_memory, logical_device->allocator());
+  } else {
+    vmaDestroyBuffer(buffer->vma, buffer->handle, buffer->allocation);
+  }
   iree_allocator_free(host_allocator, buffer);
 
   IREE_TRACE_ZONE_END(z0);
@@ -107,18 +173,27 @@ static iree_status_t iree_hal_vulkan_vma_buffer_map_range(
   iree_hal_vulkan_vma_buffer_t* buffer =
       iree_hal_vulkan_vma_buffer_cast(base_buffer);
 
-  // TODO(benvanik): add upload/download for unmapped buffers.
-  IREE_RETURN_IF_ERROR(iree_hal_buffer_validate_memory_type(
-      iree_hal_buffer_memory_type(base_buffer),
-      IREE_HAL_MEMORY_TYPE_HOST_VISIBLE));
+  // Device-only memory is mapped by staging a copy of the range in host memory
+  // that is transferred to and from the device.
+  if (!iree_all_bits_set(iree_hal_buffer_memory_type(base_buffer),
+                         IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    return iree_hal_buffer_emulated_map_range(
+        iree_hal_vulkan_vma_allocator_device(base_buffer->device_allocator),
+        base_buffer, mapping_mode, memory_access, local_byte_offset,
+        local_byte_length, mapping);
+  }
+
   IREE_RETURN_IF_ERROR(
       iree_hal_buffer_validate_usage(iree_hal_buffer_allowed_usage(base_buffer),
                                      IREE_HAL_BUFFER_USAGE_MAPPING));
 
-  uint8_t* data_ptr = nullptr;
-  VK_RETURN_IF_ERROR(
-      vmaMapMemory(buffer->vma, buffer->allocation, (void**)&data_ptr),
-      "vmaMapMemory");
+  // Imported host allocations are always mapped.
+  uint8_t* data_ptr = buffer->imported_host_ptr;
+  if (!data_ptr) {
+    VK_RETURN_IF_ERROR(
+        vmaMapMemory(buffer->vma, buffer->allocation, (void**)&data_ptr),
+        "vmaMapMemory");
+  }
   mapping->contents =
       iree_make_byte_span(data_ptr + local_byte_offset, local_byte_length);
 
@@ -140,7 +215,15 @@ static iree_status_t iree_hal_vulkan_vma_buffer_unmap_range(
     iree_device_size_t local_byte_length, iree_hal_buffer_mapping_t* mapping) {
   iree_hal_vulkan_vma_buffer_t* buffer =
       iree_hal_vulkan_vma_buffer_cast(base_buffer);
-  vmaUnmapMemory(buffer->vma, buffer->allocation);
+  if (!iree_all_bits_set(iree_hal_buffer_memory_type(base_buffer),
+                         IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    return iree_hal_buffer_emulated_unmap_range(
+        iree_hal_vulkan_vma_allocator_device(base_buffer->device_allocator),
+        base_buffer, local_byte_offset, local_byte_length, mapping);
+  }
+  if (!buffer->imported_host_ptr) {
+    vmaUnmapMemory(buffer->vma, buffer->allocation);
+  }
   return iree_ok_status();
 }
 
@@ -149,6 +232,7 @@ static iree_status_t iree_hal_vulkan_vma_buffer_invalidate_range(
     iree_device_size_t local_byte_length) {
   iree_hal_vulkan_vma_buffer_t* buffer =
       iree_hal_vulkan_vma_buffer_cast(base_buffer);
+  if (buffer->imported_memory) return iree_ok_status();  // Host-coherent.
   VK_RETURN_IF_ERROR(
       vmaInvalidateAllocation(buffer->vma, buffer->allocation,
                               local_byte_offset, local_byte_length),
@@ -161,6 +245,7 @@ static iree_status_t iree_hal_vulkan_vma_buffer_flush_range(
     iree_device_size_t local_byte_length) {
   iree_hal_vulkan_vma_buffer_t* buffer =
       iree_hal_vulkan_vma_buffer_cast(base_buffer);
+  if (buffer->imported_memory) return iree_ok_status();  // Host-coherent.
   VK_RETURN_IF_ERROR(vmaFlushAllocation(buffer->vma, buffer->allocation,
                                         local_byte_offset, local_byte_length),
                      "vmaFlushAllocation");
@@ -9,6 +9,7 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/hal/vulkan/handle_util.h"
 #include "iree/hal/vulkan/internal_vk_mem_alloc.h"
 
 #ifdef __cplusplus
@@ -25,6 +26,18 @@ iree_status_t iree_hal_vulkan_vma_buffer_wrap(
     VmaAllocator vma, VkBuffer handle, VmaAllocation allocation,
     VmaAllocationInfo allocation_info, iree_hal_buffer_t** out_buffer);
 
+// Wraps a VkBuffer bound to |memory| imported from the host allocation at
+// |host_ptr| with VK_EXT_external_memory_host in an iree_hal_buffer_t.
+// The buffer and memory will be destroyed when the buffer is released but the
+// host allocation remains owned by the caller and must outlive the buffer.
+// |memory| must be host-coherent.
+iree_status_t iree_hal_vulkan_vma_buffer_wrap_host_allocation(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree::hal::vulkan::VkDeviceHandle* logical_device, VkBuffer handle,
+    VkDeviceMemory memory, void* host_ptr, iree_hal_buffer_t** out_buffer);
+
 // Returns the Vulkan handle backing the given |buffer|.
 // This is the entire allocated_buffer and must be offset by the buffer
 // byte_offset and byte_length when used.
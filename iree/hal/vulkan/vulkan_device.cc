@@ -12,6 +12,8 @@
 #include <vector>
 
 #include "iree/base/internal/arena.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/file_io.h"
 #include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/utils/buffer_transfer.h"
@@ -21,6 +23,7 @@
 #include "iree/hal/vulkan/descriptor_pool_cache.h"
 #include "iree/hal/vulkan/direct_command_buffer.h"
 #include "iree/hal/vulkan/direct_command_queue.h"
+#include "iree/hal/vulkan/dispatch_profiler.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
 #include "iree/hal/vulkan/emulated_semaphore.h"
 #include "iree/hal/vulkan/extensibility_util.h"
@@ -31,6 +34,7 @@
 #include "iree/hal/vulkan/native_executable_layout.h"
 #include "iree/hal/vulkan/native_semaphore.h"
 #include "iree/hal/vulkan/nop_executable_cache.h"
+#include "iree/hal/vulkan/pipeline_executable_cache.h"
 #include "iree/hal/vulkan/serializing_command_queue.h"
 #include "iree/hal/vulkan/status_util.h"
 #include "iree/hal/vulkan/timepoint_util.h"
@@ -99,6 +103,22 @@ IREE_API_EXPORT iree_status_t iree_hal_vulkan_query_extensibility_set(
   ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
           VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
 
+  // VK_EXT_external_memory_host:
+  // Allows host allocations to be imported as device memory without copies.
+  // When unavailable read-only imports are copied through staging buffers.
+  ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
+          VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+
+  // VK_KHR_buffer_device_address:
+  // Only used when requested as it changes the binding model of executables.
+  // Core in Vulkan 1.2 but the extension is still reported by drivers.
+  if (iree_all_bits_set(
+          requested_features,
+          IREE_HAL_VULKAN_FEATURE_ENABLE_BUFFER_DEVICE_ADDRESSES)) {
+    ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_REQUIRED,
+            VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+  }
+
   //===--------------------------------------------------------------------===//
   // Vulkan forward-compatibility shims
   //===--------------------------------------------------------------------===//
@@ -316,10 +336,10 @@ static iree_status_t iree_hal_vulkan_build_queue_sets(
 
   memset(out_transfer_queue_set, 0, sizeof(*out_transfer_queue_set));
   out_transfer_queue_set->queue_family_index = queue_family_info.transfer_index;
-  uint32_t base_queue_index = 0;
+  iree_host_size_t base_queue_index = 0;
   if (queue_family_info.dispatch_index == queue_family_info.transfer_index) {
     // Sharing a family, so transfer queues follow compute queues.
-    base_queue_index = queue_family_info.dispatch_index;
+    base_queue_index = queue_family_info.dispatch_queue_count;
   }
   for (iree_host_size_t i = 0; i < queue_family_info.transfer_queue_count;
        ++i) {
@@ -353,6 +373,10 @@ typedef struct iree_hal_vulkan_device_t {
   iree_allocator_t host_allocator;
   iree_hal_allocator_t* device_allocator;
 
+  // Host-visible staging memory for transfers to and from device-local
+  // buffers.
+  iree_hal_transfer_staging_ring_t staging_ring;
+
   // All queues available on the device; the device owns these.
   iree_host_size_t queue_count;
   CommandQueue** queues;
@@ -365,6 +389,19 @@ typedef struct iree_hal_vulkan_device_t {
   iree_host_size_t transfer_queue_count;
   CommandQueue** transfer_queues;
 
+  // True if command buffers containing only transfer commands are recorded
+  // from |transfer_command_pool| and submitted to |transfer_queues| so that
+  // they can overlap with dispatches. When false all command buffers are
+  // recorded and submitted as if they contained dispatches.
+  bool route_transfer_commands;
+  // True if |transfer_queues| are in a different queue family than
+  // |dispatch_queues| and command buffers recorded for one can't be submitted
+  // to the other.
+  bool has_distinct_transfer_queue_family;
+  // Incremented on each submission that may be placed on any of several
+  // queues and used to spread the submissions across them round-robin.
+  iree_atomic_int32_t queue_ordinal;
+
   // |queue_count| tracing contexts, if tracing is enabled.
   iree_hal_vulkan_tracing_context_t** queue_tracing_contexts;
 
@@ -382,6 +419,18 @@ typedef struct iree_hal_vulkan_device_t {
   TimePointFencePool* fence_pool;
 
   BuiltinExecutables* builtin_executables;
+
+  // Pipeline cache shared by all executable caches created from the device or
+  // VK_NULL_HANDLE if disabled.
+  VkPipelineCache pipeline_cache;
+  // Optional NUL-terminated path the pipeline cache is persisted to.
+  iree_string_view_t pipeline_cache_path;
+
+  // Aggregates dispatch timings of command buffers recorded for the dispatch
+  // queues or NULL if dispatch profiling is disabled.
+  iree_hal_vulkan_dispatch_profiler_t* dispatch_profiler;
+  // Optional NUL-terminated path the dispatch profile is written to.
+  iree_string_view_t dispatch_profile_path;
 } iree_hal_vulkan_device_t;
 
 namespace {
@@ -400,6 +449,82 @@ IREE_API_EXPORT void iree_hal_vulkan_device_options_initialize(
   out_options->flags = 0;
 }
 
+// Creates the device pipeline cache seeded from the file at
+// |pipeline_cache_path| if it exists or otherwise |options| initial data.
+// The cache is only an optimization and failing to load it is not an error.
+static iree_status_t iree_hal_vulkan_device_initialize_pipeline_cache(
+    iree_hal_vulkan_device_t* device,
+    const iree_hal_vulkan_device_options_t* options) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_const_byte_span_t initial_data = options->pipeline_cache_data;
+  iree_byte_span_t file_contents = iree_make_byte_span(NULL, 0);
+  if (!iree_string_view_is_empty(device->pipeline_cache_path)) {
+    iree_status_t read_status = iree_file_read_contents(
+        device->pipeline_cache_path.data, device->host_allocator,
+        &file_contents);
+    if (iree_status_is_ok(read_status)) {
+      initial_data = iree_make_const_byte_span(file_contents.data,
+                                               file_contents.data_length);
+    } else {
+      // Expected on the first run when the file does not yet exist.
+      iree_status_ignore(read_status);
+    }
+  }
+
+  iree_status_t status = iree_hal_vulkan_pipeline_cache_create(
+      device->logical_device, device->physical_device, initial_data,
+      &device->pipeline_cache);
+
+  iree_allocator_free(device->host_allocator, file_contents.data);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Writes the device pipeline cache to its persistent path, if any.
+static void iree_hal_vulkan_device_persist_pipeline_cache(
+    iree_hal_vulkan_device_t* device) {
+  if (device->pipeline_cache == VK_NULL_HANDLE ||
+      iree_string_view_is_empty(device->pipeline_cache_path)) {
+    return;
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_byte_span_t data = iree_make_byte_span(NULL, 0);
+  iree_status_t status = iree_hal_vulkan_pipeline_cache_serialize(
+      device->logical_device, device->pipeline_cache, device->host_allocator,
+      &data);
+  if (iree_status_is_ok(status)) {
+    status = iree_file_write_contents(
+        device->pipeline_cache_path.data,
+        iree_make_const_byte_span(data.data, data.data_length));
+  }
+  iree_allocator_free(device->host_allocator, data.data);
+  // Failing to persist only means the next run compiles from scratch.
+  iree_status_ignore(status);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Writes the dispatch profile to its path, if any.
+static void iree_hal_vulkan_device_dump_dispatch_profile(
+    iree_hal_vulkan_device_t* device) {
+  if (!device->dispatch_profiler ||
+      iree_string_view_is_empty(device->dispatch_profile_path)) {
+    return;
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  bool use_stderr =
+      iree_string_view_equal(device->dispatch_profile_path, IREE_SV("-"));
+  FILE* file = use_stderr ? stderr
+                          : fopen(device->dispatch_profile_path.data, "wb");
+  if (file) {
+    // Failing to dump only loses the profile; nothing depends on it.
+    iree_status_ignore(iree_hal_vulkan_dispatch_profiler_fprint(
+        file, device->dispatch_profiler));
+    if (!use_stderr) fclose(file);
+  }
+  IREE_TRACE_ZONE_END(z0);
+}
+
 // Creates a transient command pool for the given queue family.
 // Command buffers allocated from the pool must only be issued on queues
 // belonging to the specified family.
@@ -429,7 +554,8 @@ static iree_status_t iree_hal_vulkan_create_transient_command_pool(
 static CommandQueue* iree_hal_vulkan_device_create_queue(
     VkDeviceHandle* logical_device,
     iree_hal_command_category_t command_category, uint32_t queue_family_index,
-    uint32_t queue_index, TimePointFencePool* fence_pool) {
+    uint32_t queue_index, TimePointFencePool* fence_pool,
+    iree_arena_block_pool_t* block_pool) {
   VkQueue queue = VK_NULL_HANDLE;
   logical_device->syms()->vkGetDeviceQueue(*logical_device, queue_family_index,
                                            queue_index, &queue);
@@ -441,7 +567,8 @@ static CommandQueue* iree_hal_vulkan_device_create_queue(
                                        fence_pool);
   }
 
-  return new DirectCommandQueue(logical_device, command_category, queue);
+  return new DirectCommandQueue(logical_device, command_category, queue,
+                                block_pool);
 }
 
 // Creates command queues for the given sets of queues and populates the
@@ -460,11 +587,9 @@ static iree_status_t iree_hal_vulkan_device_initialize_command_queues(
   // the tracing subsystem for query and cleanup tasks.
   VkQueue maintenance_dispatch_queue = VK_NULL_HANDLE;
 
-  uint64_t compute_queue_count =
-      iree_math_count_ones_u64(compute_queue_set->queue_indices);
   uint64_t transfer_queue_count =
       iree_math_count_ones_u64(transfer_queue_set->queue_indices);
-  for (iree_host_size_t i = 0; i < compute_queue_count; ++i) {
+  for (iree_host_size_t i = 0; i < 64; ++i) {
     if (!(compute_queue_set->queue_indices & (1ull << i))) continue;
 
     char queue_name_buffer[32];
@@ -476,7 +601,8 @@ static iree_status_t iree_hal_vulkan_device_initialize_command_queues(
 
     CommandQueue* queue = iree_hal_vulkan_device_create_queue(
         device->logical_device, IREE_HAL_COMMAND_CATEGORY_ANY,
-        compute_queue_set->queue_family_index, i, device->fence_pool);
+        compute_queue_set->queue_family_index, i, device->fence_pool,
+        &device->block_pool);
 
     iree_host_size_t queue_index = device->queue_count++;
     device->queues[queue_index] = queue;
@@ -502,7 +628,7 @@ static iree_status_t iree_hal_vulkan_device_initialize_command_queues(
       queue->set_tracing_context(device->queue_tracing_contexts[queue_index]);
     }
   }
-  for (iree_host_size_t i = 0; i < transfer_queue_count; ++i) {
+  for (iree_host_size_t i = 0; i < 64; ++i) {
     if (!(transfer_queue_set->queue_indices & (1ull << i))) continue;
 
     char queue_name_buffer[32];
@@ -514,7 +640,8 @@ static iree_status_t iree_hal_vulkan_device_initialize_command_queues(
 
     CommandQueue* queue = iree_hal_vulkan_device_create_queue(
         device->logical_device, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
-        transfer_queue_set->queue_family_index, i, device->fence_pool);
+        transfer_queue_set->queue_family_index, i, device->fence_pool,
+        &device->block_pool);
 
     iree_host_size_t queue_index = device->queue_count++;
     device->queues[queue_index] = queue;
@@ -558,7 +685,9 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
       total_queue_count * sizeof(device->queues[0]) +
       total_queue_count * sizeof(device->dispatch_queues[0]) +
       total_queue_count * sizeof(device->transfer_queues[0]) +
-      total_queue_count * sizeof(device->queue_tracing_contexts[0]);
+      total_queue_count * sizeof(device->queue_tracing_contexts[0]) +
+      options->pipeline_cache_path.size + /*NUL=*/1 +
+      options->dispatch_profile_path.size + /*NUL=*/1;
   IREE_RETURN_IF_ERROR(
       iree_allocator_malloc(host_allocator, total_size, (void**)&device));
   memset(device, 0, total_size);
@@ -580,6 +709,9 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
 
   iree_arena_block_pool_initialize(32 * 1024, host_allocator,
                                    &device->block_pool);
+  iree_hal_transfer_staging_ring_initialize(
+      (iree_hal_device_t*)device,
+      IREE_HAL_TRANSFER_STAGING_RING_DEFAULT_SLOT_SIZE, &device->staging_ring);
 
   // Point the queue storage into the new device allocation. The queues
   // themselves are populated
@@ -592,17 +724,39 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
   device->queue_tracing_contexts =
       (iree_hal_vulkan_tracing_context_t**)buffer_ptr;
   buffer_ptr += total_queue_count * sizeof(device->queue_tracing_contexts[0]);
+  if (options->pipeline_cache_path.size) {
+    buffer_ptr += iree_string_view_append_to_buffer(
+        options->pipeline_cache_path, &device->pipeline_cache_path,
+        (char*)buffer_ptr);
+    *buffer_ptr++ = 0;  // NUL terminator for file APIs.
+  }
+  if (options->dispatch_profile_path.size) {
+    buffer_ptr += iree_string_view_append_to_buffer(
+        options->dispatch_profile_path, &device->dispatch_profile_path,
+        (char*)buffer_ptr);
+    *buffer_ptr++ = 0;  // NUL terminator for file APIs.
+  }
 
   device->descriptor_pool_cache =
       new DescriptorPoolCache(device->logical_device);
 
   // Create the device memory allocator that will service all buffer
   // allocation requests.
+  // Buffers may be used from both the dispatch and transfer queue families.
   VmaRecordSettings vma_record_settings;
   memset(&vma_record_settings, 0, sizeof(vma_record_settings));
+  uint32_t queue_family_count = 0;
+  uint32_t queue_family_indices[2];
+  queue_family_indices[queue_family_count++] =
+      compute_queue_set->queue_family_index;
+  if (transfer_queue_set->queue_indices != 0) {
+    queue_family_indices[queue_family_count++] =
+        transfer_queue_set->queue_family_index;
+  }
   iree_status_t status = iree_hal_vulkan_vma_allocator_create(
       instance, physical_device, logical_device, (iree_hal_device_t*)device,
-      vma_record_settings, &device->device_allocator);
+      queue_family_count, queue_family_indices, vma_record_settings,
+      &device->device_allocator);
 
   // Create command pools for each queue family. If we don't have a transfer
   // queue then we'll ignore that one and just use the dispatch pool.
@@ -645,6 +799,32 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
         transfer_queue_set);
   }
 
+  // Tracing may insert commands that require a dispatch-capable queue into
+  // command buffers that otherwise only contain transfer commands.
+  device->route_transfer_commands =
+      device->transfer_command_pool != NULL &&
+      !iree_all_bits_set(enabled_features,
+                         IREE_HAL_VULKAN_FEATURE_ENABLE_TRACING);
+  device->has_distinct_transfer_queue_family =
+      device->transfer_command_pool != NULL &&
+      transfer_queue_set->queue_family_index !=
+          compute_queue_set->queue_family_index;
+
+  if (iree_status_is_ok(status) &&
+      !iree_all_bits_set(options->flags,
+                         IREE_HAL_VULKAN_DEVICE_DISABLE_PIPELINE_CACHE)) {
+    status = iree_hal_vulkan_device_initialize_pipeline_cache(device, options);
+  }
+
+  if (iree_status_is_ok(status) &&
+      iree_all_bits_set(options->flags,
+                        IREE_HAL_VULKAN_DEVICE_ENABLE_DISPATCH_PROFILING)) {
+    status = iree_hal_vulkan_dispatch_profiler_create(
+        device->logical_device, physical_device,
+        compute_queue_set->queue_family_index, host_allocator,
+        &device->dispatch_profiler);
+  }
+
   if (iree_status_is_ok(status)) {
     device->builtin_executables =
         new BuiltinExecutables(device->logical_device);
@@ -664,6 +844,9 @@ static void iree_hal_vulkan_device_destroy(iree_hal_device_t* base_device) {
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // The staging ring holds a semaphore and a buffer from the allocator.
+  iree_hal_transfer_staging_ring_deinitialize(&device->staging_ring);
+
   // Drop all command queues. These may wait until idle in their destructor.
   for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
     delete device->queues[i];
@@ -679,8 +862,13 @@ static void iree_hal_vulkan_device_destroy(iree_hal_device_t* base_device) {
   // have been in use.
   delete device->builtin_executables;
   delete device->descriptor_pool_cache;
+  iree_hal_vulkan_device_persist_pipeline_cache(device);
+  iree_hal_vulkan_pipeline_cache_destroy(device->logical_device,
+                                         device->pipeline_cache);
   delete device->semaphore_pool;
   delete device->fence_pool;
+  iree_hal_vulkan_device_dump_dispatch_profile(device);
+  iree_hal_vulkan_dispatch_profiler_destroy(device->dispatch_profiler);
 
   // There should be no more buffers live that use the allocator.
   iree_hal_allocator_release(device->device_allocator);
@@ -830,6 +1018,17 @@ iree_status_t iree_hal_vulkan_device_create(
     host_query_reset_features.hostQueryReset = VK_TRUE;
   }
 
+  VkPhysicalDeviceBufferDeviceAddressFeaturesKHR buffer_device_address_features;
+  if (enabled_device_extensions.buffer_device_address) {
+    memset(&buffer_device_address_features, 0,
+           sizeof(buffer_device_address_features));
+    buffer_device_address_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR;
+    buffer_device_address_features.pNext = features2.pNext;
+    features2.pNext = &buffer_device_address_features;
+    buffer_device_address_features.bufferDeviceAddress = VK_TRUE;
+  }
+
   auto logical_device = new VkDeviceHandle(
       instance_syms, enabled_device_extensions,
       /*owns_device=*/true, host_allocator, /*allocator=*/NULL);
@@ -941,6 +1140,8 @@ static iree_status_t iree_hal_vulkan_device_trim(
     iree_hal_device_t* base_device) {
   iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
   iree_arena_block_pool_trim(&device->block_pool);
+  device->descriptor_pool_cache->Trim();
+  iree_hal_transfer_staging_ring_trim(&device->staging_ring);
   return iree_hal_allocator_trim(device->device_allocator);
 }
 
@@ -966,27 +1167,72 @@ static iree_status_t iree_hal_vulkan_device_query_i32(
       (int)category.size, category.data, (int)key.size, key.data);
 }
 
+// Returns the command categories command buffers are recorded and submitted
+// with given the |command_categories| requested by the user.
+static iree_hal_command_category_t iree_hal_vulkan_device_command_categories(
+    iree_hal_vulkan_device_t* device,
+    iree_hal_command_category_t command_categories) {
+  // The unaligned buffer fill polyfill and tracing timestamp queries may both
+  // need a dispatch-capable queue. When transfer-only command buffers can't be
+  // routed to the transfer queues (no dedicated queues or tracing enabled) we
+  // treat all command buffers as containing dispatches.
+  if (!device->route_transfer_commands) {
+    command_categories |= IREE_HAL_COMMAND_CATEGORY_DISPATCH;
+  }
+  return command_categories;
+}
+
+// Returns a bitmask of the queues in a list of |queue_count| queues that
+// |queue_affinity| allows. Each bit in the affinity selects the queue at that
+// index modulo the queue count so that any affinity selects at least one queue.
+static uint64_t iree_hal_vulkan_device_queue_affinity_mask(
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t queue_count) {
+  uint64_t queue_mask = queue_affinity;
+  if (queue_count < 64) {
+    queue_mask = 0;
+    for (iree_host_size_t i = 0; i < 64; ++i) {
+      if (queue_affinity & (1ull << i)) queue_mask |= 1ull << (i % queue_count);
+    }
+  }
+  if (!queue_mask) {
+    // An empty affinity places no constraints on the queue.
+    queue_mask = queue_count >= 64 ? UINT64_MAX : (1ull << queue_count) - 1;
+  }
+  return queue_mask;
+}
+
 // Returns the queue to submit work to based on the |queue_affinity|.
+// Work that only contains transfer commands goes to the transfer queues (which
+// are dedicated DMA queues if the device has any) and everything else goes to
+// the dispatch queues. If the affinity allows more than one queue we spread
+// submissions across them round-robin; the HAL only orders work across
+// submissions with semaphores so this is safe and lets independent submissions
+// execute concurrently. If |spread| is false the first allowed queue is used.
 static CommandQueue* iree_hal_vulkan_device_select_queue(
     iree_hal_vulkan_device_t* device,
     iree_hal_command_category_t command_categories,
-    iree_hal_queue_affinity_t queue_affinity) {
-  // TODO(scotttodd): revisit queue selection logic and remove this
-  //   * the unaligned buffer fill polyfill and tracing timestamp queries may
-  //     both insert dispatches into command buffers that at compile time are
-  //     expected to only contain transfer commands
-  //   * we could set a bit at recording time if emulation or tracing is used
-  //     and submit to the right queue based on that
-  command_categories |= IREE_HAL_COMMAND_CATEGORY_DISPATCH;
-
-  // TODO(benvanik): meaningful heuristics for affinity. We don't generate
-  // anything from the compiler that uses multiple queues and until we do it's
-  // best not to do anything too clever here.
+    iree_hal_queue_affinity_t queue_affinity, bool spread) {
+  command_categories =
+      iree_hal_vulkan_device_command_categories(device, command_categories);
+  iree_host_size_t queue_count = device->dispatch_queue_count;
+  CommandQueue** queues = device->dispatch_queues;
   if (command_categories == IREE_HAL_COMMAND_CATEGORY_TRANSFER) {
-    return device
-        ->transfer_queues[queue_affinity % device->transfer_queue_count];
+    queue_count = device->transfer_queue_count;
+    queues = device->transfer_queues;
+  }
+
+  uint64_t queue_mask =
+      iree_hal_vulkan_device_queue_affinity_mask(queue_affinity, queue_count);
+  if (!spread || iree_math_count_ones_u64(queue_mask) == 1) {
+    return queues[iree_math_count_trailing_zeros_u64(queue_mask)];
+  }
+  uint32_t ordinal = (uint32_t)iree_atomic_fetch_add_int32(
+      &device->queue_ordinal, 1, iree_memory_order_relaxed);
+  for (iree_host_size_t i = 0; i < queue_count; ++i) {
+    iree_host_size_t queue_index = (ordinal + i) % queue_count;
+    if (queue_mask & (1ull << queue_index)) return queues[queue_index];
   }
-  return device->dispatch_queues[queue_affinity % device->dispatch_queue_count];
+  return queues[0];  // unreachable; the mask always has a bit set
 }
 
 static iree_status_t iree_hal_vulkan_device_create_command_buffer(
@@ -995,14 +1241,8 @@ static iree_status_t iree_hal_vulkan_device_create_command_buffer(
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_command_buffer_t** out_command_buffer) {
   iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
-
-  // TODO(scotttodd): revisit queue selection logic and remove this
-  //   * the unaligned buffer fill polyfill and tracing timestamp queries may
-  //     both insert dispatches into command buffers that at compile time are
-  //     expected to only contain transfer commands
-  //   * we could set a bit at recording time if emulation or tracing is used
-  //     and submit to the right queue based on that
-  command_categories |= IREE_HAL_COMMAND_CATEGORY_DISPATCH;
+  command_categories =
+      iree_hal_vulkan_device_command_categories(device, command_categories);
 
   // Select the command pool to used based on the types of commands used.
   // Note that we may not have a dedicated transfer command pool if there are
@@ -1022,13 +1262,13 @@ static iree_status_t iree_hal_vulkan_device_create_command_buffer(
   // submission it just means the commands will be attributed to the wrong
   // queue.
   CommandQueue* queue = iree_hal_vulkan_device_select_queue(
-      device, command_categories, queue_affinity);
+      device, command_categories, queue_affinity, /*spread=*/false);
 
   return iree_hal_vulkan_direct_command_buffer_allocate(
       base_device, device->logical_device, command_pool, mode,
       command_categories, queue_affinity, queue->tracing_context(),
       device->descriptor_pool_cache, device->builtin_executables,
-      &device->block_pool, out_command_buffer);
+      device->dispatch_profiler, &device->block_pool, out_command_buffer);
 }
 
 static iree_status_t iree_hal_vulkan_device_create_descriptor_set(
@@ -1064,8 +1304,60 @@ static iree_status_t iree_hal_vulkan_device_create_executable_cache(
     iree_hal_device_t* base_device, iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
-  return iree_hal_vulkan_nop_executable_cache_create(
-      device->logical_device, identifier, out_executable_cache);
+  if (device->pipeline_cache == VK_NULL_HANDLE) {
+    return iree_hal_vulkan_nop_executable_cache_create(
+        device->logical_device, identifier, out_executable_cache);
+  }
+  return iree_hal_vulkan_pipeline_executable_cache_create(
+      device->logical_device, identifier, device->pipeline_cache,
+      out_executable_cache);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_vulkan_device_serialize_pipeline_cache(
+    iree_hal_device_t* base_device, iree_allocator_t host_allocator,
+    iree_byte_span_t* out_data) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  IREE_ASSERT_ARGUMENT(out_data);
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  if (device->pipeline_cache == VK_NULL_HANDLE) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "device pipeline cache is disabled");
+  }
+  return iree_hal_vulkan_pipeline_cache_serialize(
+      device->logical_device, device->pipeline_cache, host_allocator, out_data);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_vulkan_device_query_dispatch_profile(
+    iree_hal_device_t* base_device, iree_host_size_t entry_capacity,
+    iree_hal_vulkan_dispatch_profile_entry_t* out_entries,
+    iree_host_size_t* out_entry_count) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  IREE_ASSERT_ARGUMENT(out_entry_count);
+  *out_entry_count = 0;
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  if (!device->dispatch_profiler) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "device dispatch profiling is disabled");
+  }
+  return iree_hal_vulkan_dispatch_profiler_query(
+      device->dispatch_profiler, entry_capacity, out_entries, out_entry_count);
+}
+
+IREE_API_EXPORT void iree_hal_vulkan_device_reset_dispatch_profile(
+    iree_hal_device_t* base_device) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  if (!device->dispatch_profiler) return;
+  iree_hal_vulkan_dispatch_profiler_reset(device->dispatch_profiler);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_vulkan_device_dispatch_profile_fprint(
+    FILE* file, iree_hal_device_t* base_device) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  if (!device->dispatch_profiler) return iree_ok_status();
+  return iree_hal_vulkan_dispatch_profiler_fprint(file,
+                                                  device->dispatch_profiler);
 }
 
 static iree_status_t iree_hal_vulkan_device_create_executable_layout(
@@ -1075,8 +1367,9 @@ static iree_status_t iree_hal_vulkan_device_create_executable_layout(
     iree_hal_executable_layout_t** out_executable_layout) {
   iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
   return iree_hal_vulkan_native_executable_layout_create(
-      device->logical_device, push_constants, set_layout_count, set_layouts,
-      out_executable_layout);
+      device->logical_device,
+      device->logical_device->enabled_extensions().buffer_device_address,
+      push_constants, set_layout_count, set_layouts, out_executable_layout);
 }
 
 static iree_status_t iree_hal_vulkan_device_create_semaphore(
@@ -1092,14 +1385,53 @@ static iree_status_t iree_hal_vulkan_device_create_semaphore(
                                                  initial_value, out_semaphore);
 }
 
+static iree_status_t iree_hal_vulkan_device_transfer_range(
+    iree_hal_device_t* base_device, iree_hal_transfer_buffer_t source,
+    iree_device_size_t source_offset, iree_hal_transfer_buffer_t target,
+    iree_device_size_t target_offset, iree_device_size_t data_length,
+    iree_hal_transfer_buffer_flags_t flags, iree_timeout_t timeout) {
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  return iree_hal_device_transfer_staged_range(
+      base_device, &device->staging_ring, source, source_offset, target,
+      target_offset, data_length, flags, timeout);
+}
+
 static iree_status_t iree_hal_vulkan_device_queue_submit(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
     const iree_hal_submission_batch_t* batches) {
   iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+
+  // Command buffers must be submitted to queues in the family of the pool they
+  // were recorded from and that is decided by the categories they were created
+  // with, not the ones provided here.
+  if (device->route_transfer_commands) {
+    iree_hal_command_category_t recorded_categories = 0;
+    bool has_transfer_only = false;
+    for (iree_host_size_t i = 0; i < batch_count; ++i) {
+      for (iree_host_size_t j = 0; j < batches[i].command_buffer_count; ++j) {
+        iree_hal_command_category_t categories =
+            iree_hal_command_buffer_allowed_categories(
+                batches[i].command_buffers[j]);
+        recorded_categories |= categories;
+        has_transfer_only |= categories == IREE_HAL_COMMAND_CATEGORY_TRANSFER;
+      }
+    }
+    if (recorded_categories) command_categories = recorded_categories;
+    if (has_transfer_only && device->has_distinct_transfer_queue_family &&
+        iree_all_bits_set(command_categories,
+                          IREE_HAL_COMMAND_CATEGORY_DISPATCH)) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "transfer-only command buffers are executed on a dedicated transfer "
+          "queue family and cannot be submitted together with dispatch "
+          "command buffers");
+    }
+  }
+
   CommandQueue* queue = iree_hal_vulkan_device_select_queue(
-      device, command_categories, queue_affinity);
+      device, command_categories, queue_affinity, /*spread=*/true);
   return queue->Submit(batch_count, batches);
 }
 
@@ -1161,7 +1493,7 @@ const iree_hal_device_vtable_t iree_hal_vulkan_device_vtable = {
     /*.create_executable_layout=*/
     iree_hal_vulkan_device_create_executable_layout,
     /*.create_semaphore=*/iree_hal_vulkan_device_create_semaphore,
-    /*.transfer_range=*/iree_hal_device_submit_transfer_range_and_wait,
+    /*.transfer_range=*/iree_hal_vulkan_device_transfer_range,
     /*.queue_submit=*/iree_hal_vulkan_device_queue_submit,
     /*.submit_and_wait=*/
     iree_hal_vulkan_device_submit_and_wait,
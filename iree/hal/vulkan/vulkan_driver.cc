@@ -111,8 +111,15 @@ static iree_status_t iree_hal_vulkan_driver_create_internal(
         &debug_reporter));
   }
 
+  // The device options are retained for creating devices later on and any
+  // referenced pipeline cache path/data is copied into the driver allocation.
+  const iree_hal_vulkan_device_options_t* device_options =
+      &options->device_options;
   iree_hal_vulkan_driver_t* driver = NULL;
-  iree_host_size_t total_size = sizeof(*driver) + identifier.size;
+  iree_host_size_t total_size =
+      sizeof(*driver) + identifier.size +
+      device_options->pipeline_cache_path.size +
+      device_options->pipeline_cache_data.data_length;
   iree_status_t status =
       iree_allocator_malloc(host_allocator, total_size, (void**)&driver);
   if (!iree_status_is_ok(status)) {
@@ -123,11 +130,20 @@ static iree_status_t iree_hal_vulkan_driver_create_internal(
   iree_hal_resource_initialize(&iree_hal_vulkan_driver_vtable,
                                &driver->resource);
   driver->host_allocator = host_allocator;
-  iree_string_view_append_to_buffer(
-      identifier, &driver->identifier,
-      (char*)driver + total_size - identifier.size);
-  memcpy(&driver->device_options, &options->device_options,
+  uint8_t* buffer_ptr = (uint8_t*)driver + sizeof(*driver);
+  buffer_ptr += iree_string_view_append_to_buffer(
+      identifier, &driver->identifier, (char*)buffer_ptr);
+  memcpy(&driver->device_options, device_options,
          sizeof(driver->device_options));
+  buffer_ptr += iree_string_view_append_to_buffer(
+      device_options->pipeline_cache_path,
+      &driver->device_options.pipeline_cache_path, (char*)buffer_ptr);
+  if (device_options->pipeline_cache_data.data_length > 0) {
+    memcpy(buffer_ptr, device_options->pipeline_cache_data.data,
+           device_options->pipeline_cache_data.data_length);
+    driver->device_options.pipeline_cache_data = iree_make_const_byte_span(
+        buffer_ptr, device_options->pipeline_cache_data.data_length);
+  }
   driver->default_device_index = options->default_device_index;
   driver->enabled_features = options->requested_features;
   driver->syms = iree::add_ref(instance_syms);
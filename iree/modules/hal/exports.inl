@@ -50,6 +50,7 @@ EXPORT_FN("command_buffer.bind_descriptor_set", iree_hal_module_command_buffer_b
 EXPORT_FN("command_buffer.copy_buffer", iree_hal_module_command_buffer_copy_buffer, rririi, v)
 EXPORT_FN("command_buffer.create", iree_hal_module_command_buffer_create, rii, r)
 EXPORT_FN("command_buffer.dispatch", iree_hal_module_command_buffer_dispatch, rriiii, v)
+EXPORT_FN("command_buffer.dispatch.batch", iree_hal_module_command_buffer_dispatch_batch, rrCrD, v)
 EXPORT_FN("command_buffer.dispatch.indirect", iree_hal_module_command_buffer_dispatch_indirect, rriri, v)
 EXPORT_FN("command_buffer.end", iree_hal_module_command_buffer_end, r, v)
 EXPORT_FN("command_buffer.end_debug_group", iree_hal_module_command_buffer_end_debug_group, r, v)
@@ -64,9 +65,15 @@ EXPORT_FN("descriptor_set_layout.create", iree_hal_module_descriptor_set_layout_
 
 EXPORT_FN("device.allocator", iree_hal_module_device_allocator, r, r)
 EXPORT_FN("device.query.i32", iree_hal_module_device_query_i32, rrr, ii)
+EXPORT_FN("device.queue.alloca", iree_hal_module_device_queue_alloca, riii, r)
+EXPORT_FN("device.queue.dealloca", iree_hal_module_device_queue_dealloca, rr, v)
 
+EXPORT_FN("ex.device", iree_hal_module_ex_device, i, r)
 EXPORT_FN("ex.shared_device", iree_hal_module_ex_shared_device, v, r)
-EXPORT_FN("ex.submit_and_wait", iree_hal_module_ex_submit_and_wait, rr, v)
+EXPORT_FN("ex.submit", iree_hal_module_ex_submit, rri, i)
+EXPORT_FN("ex.submit_and_wait", iree_hal_module_ex_submit_and_wait, rri, v)
+EXPORT_FN("ex.submit_await", iree_hal_module_ex_submit_await, i, v)
+EXPORT_FN("ex.submit_timeline", iree_hal_module_ex_submit_timeline, i, ri)
 
 EXPORT_FN("executable.create", iree_hal_module_executable_create, rrrCrD, r)
 
@@ -14,14 +14,32 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/profiler.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
+#include "iree/hal/utils/allocation_cache.h"
+#include "iree/hal/utils/lazy_executable.h"
 #include "iree/vm/api.h"
 
 // Limit the number of bindings we pass down through the HAL. This can be tuned
 // in the future but right now guards the stack from blowing up during calls.
 #define IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT ((iree_host_size_t)32)
 
+// Maximum total size of transient buffers returned with device.queue.dealloca
+// that are retained for reuse by device.queue.alloca. Buffers beyond this are
+// released back to the device allocator.
+#if !defined(IREE_HAL_MODULE_TRANSIENT_POOL_LIMIT)
+#define IREE_HAL_MODULE_TRANSIENT_POOL_LIMIT (64 * 1024 * 1024)
+#endif  // !IREE_HAL_MODULE_TRANSIENT_POOL_LIMIT
+
+// Number of buffer views created by buffer_view.create that are retained for
+// reuse once released by their users. Each retained view also retains its
+// buffer until the view is reused or the module state is trimmed.
+#if !defined(IREE_HAL_MODULE_BUFFER_VIEW_CACHE_CAPACITY)
+#define IREE_HAL_MODULE_BUFFER_VIEW_CACHE_CAPACITY 32
+#endif  // !IREE_HAL_MODULE_BUFFER_VIEW_CACHE_CAPACITY
+
 //===----------------------------------------------------------------------===//
 // Type registration
 //===----------------------------------------------------------------------===//
@@ -116,25 +134,89 @@ IREE_VM_DEFINE_TYPE_ADAPTERS(iree_hal_semaphore, iree_hal_semaphore_t);
 
 typedef struct iree_hal_module_t {
   iree_allocator_t host_allocator;
-  iree_hal_device_t* shared_device;
+  iree_hal_module_flags_t flags;
+  // Devices available to programs as hal.ex.device[ordinal]. devices[0] is the
+  // shared device returned by hal.ex.shared_device.
+  iree_host_size_t device_count;
+  iree_hal_device_t* devices[];
   // TODO(benvanik): types.
 } iree_hal_module_t;
 
 #define IREE_HAL_MODULE_CAST(module) \
   (iree_hal_module_t*)((uint8_t*)(module) + iree_vm_native_module_size());
 
+// Per-device state of a module state.
+typedef struct iree_hal_module_device_state_t {
+  iree_hal_executable_cache_t* executable_cache;
+  // Semaphore created on the device and signaled by submissions to it with
+  // their submission timeline value.
+  iree_hal_semaphore_t* submit_semaphore;
+  // Submission timeline value of the last submission to the device or 0 if
+  // nothing has been submitted yet.
+  uint64_t last_submit_value;
+} iree_hal_module_device_state_t;
+
 typedef struct iree_hal_module_state_t {
   iree_allocator_t host_allocator;
+  iree_hal_module_flags_t flags;
   iree_hal_device_t* shared_device;
-  iree_hal_executable_cache_t* executable_cache;
 
-  iree_hal_semaphore_t* submit_semaphore;
+  // Devices from the module; unretained as the module outlives its state.
+  iree_host_size_t device_count;
+  iree_hal_device_t* const* devices;
+
+  // Last value of the submission timeline. Each submission to any device is
+  // assigned the next value and timeline value V is reached once all
+  // submissions with values <= V have completed.
   uint64_t submit_value;
+
+  // Transient buffers returned with device.queue.dealloca available for reuse
+  // by device.queue.alloca on the shared device. Each cached allocation holds
+  // a reference to the buffer in its |host_ptr|.
+  iree_hal_allocation_cache_t transient_pool;
+
+  // Buffer views returned from buffer_view.create. Views that are no longer
+  // referenced by anything but the cache are reused for new views instead of
+  // allocating. |buffer_view_cache_next| is the slot to evict next.
+  iree_hal_buffer_view_t*
+      buffer_view_cache[IREE_HAL_MODULE_BUFFER_VIEW_CACHE_CAPACITY];
+  iree_host_size_t buffer_view_cache_next;
+
+  // Retained lazy executables created by executable.create when the module
+  // has IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES so that they can be prepared
+  // ahead of their first dispatch. Guarded by |lazy_executable_mutex| as
+  // preparation may happen on another thread.
+  iree_slim_mutex_t lazy_executable_mutex;
+  iree_host_size_t lazy_executable_count;
+  iree_host_size_t lazy_executable_capacity;
+  iree_hal_executable_t** lazy_executables;
+
+  // One entry per device in |devices|.
+  iree_hal_module_device_state_t device_states[];
 } iree_hal_module_state_t;
 
+// Releases all buffer views retained for reuse along with their buffers.
+static void iree_hal_module_buffer_view_cache_trim(
+    iree_hal_module_state_t* state) {
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(state->buffer_view_cache);
+       ++i) {
+    iree_hal_buffer_view_release(state->buffer_view_cache[i]);
+    state->buffer_view_cache[i] = NULL;
+  }
+  state->buffer_view_cache_next = 0;
+}
+
+static void IREE_API_PTR iree_hal_module_transient_pool_free(
+    void* user_data, iree_host_size_t heap,
+    iree_hal_cached_allocation_t allocation) {
+  iree_hal_buffer_release((iree_hal_buffer_t*)allocation.host_ptr);
+}
+
 static void IREE_API_PTR iree_hal_module_destroy(void* base_module) {
   iree_hal_module_t* module = IREE_HAL_MODULE_CAST(base_module);
-  iree_hal_device_release(module->shared_device);
+  for (iree_host_size_t i = 0; i < module->device_count; ++i) {
+    iree_hal_device_release(module->devices[i]);
+  }
 }
 
 static iree_status_t IREE_API_PTR
@@ -144,23 +226,39 @@ iree_hal_module_alloc_state(void* self, iree_allocator_t host_allocator,
 
   iree_hal_module_t* module = IREE_HAL_MODULE_CAST(self);
   iree_hal_module_state_t* state = NULL;
+  iree_host_size_t total_size =
+      sizeof(*state) +
+      module->device_count * sizeof(state->device_states[0]);
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0,
-      iree_allocator_malloc(host_allocator, sizeof(*state), (void**)&state));
-  memset(state, 0, sizeof(*state));
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&state));
+  memset(state, 0, total_size);
   state->host_allocator = host_allocator;
-  state->shared_device = module->shared_device;
+  state->flags = module->flags;
+  iree_slim_mutex_initialize(&state->lazy_executable_mutex);
+  state->device_count = module->device_count;
+  state->devices = module->devices;
+  state->shared_device = module->devices[0];
   iree_hal_device_retain(state->shared_device);
 
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_hal_executable_cache_create(state->shared_device,
-                                           iree_string_view_empty(),
-                                           &state->executable_cache));
+  iree_hal_allocation_cache_free_callback_t transient_pool_free = {
+      .fn = iree_hal_module_transient_pool_free,
+      .user_data = NULL,
+  };
+  iree_hal_allocation_cache_initialize(
+      IREE_HAL_MODULE_TRANSIENT_POOL_LIMIT, /*heap_count=*/1,
+      transient_pool_free, host_allocator, &state->transient_pool);
 
   state->submit_value = 0ull;
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_hal_semaphore_create(state->shared_device, state->submit_value,
-                                    &state->submit_semaphore));
+  for (iree_host_size_t i = 0; i < state->device_count; ++i) {
+    iree_hal_module_device_state_t* device_state = &state->device_states[i];
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_executable_cache_create(state->devices[i],
+                                             iree_string_view_empty(),
+                                             &device_state->executable_cache));
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_semaphore_create(state->devices[i], state->submit_value,
+                                      &device_state->submit_semaphore));
+  }
 
   *out_module_state = (iree_vm_module_state_t*)state;
   IREE_TRACE_ZONE_END(z0);
@@ -172,8 +270,17 @@ iree_hal_module_free_state(void* self, iree_vm_module_state_t* module_state) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
-  iree_hal_semaphore_release(state->submit_semaphore);
-  iree_hal_executable_cache_release(state->executable_cache);
+  iree_hal_module_buffer_view_cache_trim(state);
+  iree_hal_allocation_cache_deinitialize(&state->transient_pool);
+  for (iree_host_size_t i = 0; i < state->lazy_executable_count; ++i) {
+    iree_hal_executable_release(state->lazy_executables[i]);
+  }
+  iree_allocator_free(state->host_allocator, state->lazy_executables);
+  iree_slim_mutex_deinitialize(&state->lazy_executable_mutex);
+  for (iree_host_size_t i = 0; i < state->device_count; ++i) {
+    iree_hal_semaphore_release(state->device_states[i].submit_semaphore);
+    iree_hal_executable_cache_release(state->device_states[i].executable_cache);
+  }
   iree_hal_device_release(state->shared_device);
   iree_allocator_free(state->host_allocator, state);
 
@@ -186,7 +293,12 @@ static iree_status_t IREE_API_PTR iree_hal_module_notify(
   switch (signal) {
     case IREE_VM_SIGNAL_SUSPEND:
     case IREE_VM_SIGNAL_LOW_MEMORY:
-      return iree_hal_device_trim(state->shared_device);
+      iree_hal_module_buffer_view_cache_trim(state);
+      iree_hal_allocation_cache_trim(&state->transient_pool);
+      for (iree_host_size_t i = 0; i < state->device_count; ++i) {
+        IREE_RETURN_IF_ERROR(iree_hal_device_trim(state->devices[i]));
+      }
+      return iree_ok_status();
     default:
       return iree_ok_status();
   }
@@ -205,37 +317,177 @@ IREE_VM_ABI_EXPORT(iree_hal_module_ex_shared_device,  //
   return iree_ok_status();
 }
 
+IREE_VM_ABI_EXPORT(iree_hal_module_ex_device,  //
+                   iree_hal_module_state_t,    //
+                   i, r) {
+  iree_host_size_t ordinal = (iree_host_size_t)args->i0;
+  if (IREE_UNLIKELY(args->i0 < 0 || ordinal >= state->device_count)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "device ordinal %d out of range; %zu devices are "
+                            "available to the HAL module",
+                            args->i0, state->device_count);
+  }
+  rets->r0 = iree_hal_device_retain_ref(state->devices[ordinal]);
+  return iree_ok_status();
+}
+
+// Returns the index of |device| in the module devices. Devices not bound to the
+// module are treated as the shared device.
+static iree_host_size_t iree_hal_module_device_index(
+    iree_hal_module_state_t* state, iree_hal_device_t* device) {
+  for (iree_host_size_t i = 1; i < state->device_count; ++i) {
+    if (state->devices[i] == device) return i;
+  }
+  return 0;
+}
+
+// Converts a timepoint passed from a program to a submission timeline value.
+// Negative timepoints refer to all prior submissions.
+static uint64_t iree_hal_module_timepoint_value(int32_t timepoint) {
+  return timepoint < 0 ? UINT64_MAX : (uint64_t)timepoint;
+}
+
+// Blocks the caller until all submissions with values <= |value| have
+// completed on all devices but |except_device_index|.
+static iree_status_t iree_hal_module_await_timeline(
+    iree_hal_module_state_t* state, uint64_t value,
+    iree_host_size_t except_device_index) {
+  for (iree_host_size_t i = 0; i < state->device_count; ++i) {
+    if (i == except_device_index) continue;
+    // Devices signal the values of their own submissions only and waiting on
+    // the last one at or before |value| would need a history; waiting on the
+    // earliest one at or after it may wait a little longer but is sufficient.
+    iree_hal_module_device_state_t* device_state = &state->device_states[i];
+    uint64_t device_value = iree_min(value, device_state->last_submit_value);
+    if (!device_value) continue;
+    IREE_RETURN_IF_ERROR(iree_hal_semaphore_wait(device_state->submit_semaphore,
+                                                 device_value,
+                                                 iree_infinite_timeout()));
+  }
+  return iree_ok_status();
+}
+
+// Prepares a submission batch of |command_buffer| to |device_index| that
+// signals the next value of the module submission timeline and returns that
+// value in |out_value|.
+//
+// Submissions to the same device are ordered by waiting on the value signaled
+// by the previous submission to the device if it has not yet been reached.
+// Submissions must also not begin before all submissions up to |wait_value| on
+// other devices have completed; as semaphores of one device cannot generally
+// be waited on by devices of other drivers those waits block the caller.
+// Programs pass the timepoint their work depends on such that submissions to
+// different devices can overlap and -1 to wait for all prior work.
+//
+// Command buffers that may have executed inline during recording cannot wait
+// on the device and instead block the caller until prior work has completed.
+static iree_status_t iree_hal_module_prepare_submit(
+    iree_hal_module_state_t* state, iree_host_size_t device_index,
+    iree_hal_command_buffer_t** command_buffer, uint64_t wait_value,
+    uint64_t* device_wait_value, uint64_t* signal_value,
+    iree_hal_submission_batch_t* out_batch) {
+  memset(out_batch, 0, sizeof(*out_batch));
+  out_batch->command_buffer_count = 1;
+  out_batch->command_buffers = command_buffer;
+
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_await_timeline(state, wait_value, device_index));
+
+  iree_hal_module_device_state_t* device_state =
+      &state->device_states[device_index];
+  uint64_t current_value = 0ull;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_semaphore_query(device_state->submit_semaphore, &current_value));
+  if (current_value < device_state->last_submit_value) {
+    if (iree_all_bits_set(
+            iree_hal_command_buffer_mode(*command_buffer),
+            IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION)) {
+      IREE_RETURN_IF_ERROR(iree_hal_semaphore_wait(
+          device_state->submit_semaphore, device_state->last_submit_value,
+          iree_infinite_timeout()));
+    } else {
+      *device_wait_value = device_state->last_submit_value;
+      out_batch->wait_semaphores.count = 1;
+      out_batch->wait_semaphores.semaphores = &device_state->submit_semaphore;
+      out_batch->wait_semaphores.payload_values = device_wait_value;
+    }
+  }
+
+  *signal_value = ++state->submit_value;
+  device_state->last_submit_value = *signal_value;
+  out_batch->signal_semaphores.count = 1;
+  out_batch->signal_semaphores.semaphores = &device_state->submit_semaphore;
+  out_batch->signal_semaphores.payload_values = signal_value;
+  return iree_ok_status();
+}
+
+IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit,  //
+                   iree_hal_module_state_t,    //
+                   rri, i) {
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_device_check_deref(args->r0, &device));
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_command_buffer_check_deref(args->r1, &command_buffer));
+  uint64_t wait_value = iree_hal_module_timepoint_value(args->i2);
+
+  iree_hal_submission_batch_t batch;
+  uint64_t device_wait_value = 0ull;
+  uint64_t signal_value = 0ull;
+  IREE_RETURN_IF_ERROR(iree_hal_module_prepare_submit(
+      state, iree_hal_module_device_index(state, device), &command_buffer,
+      wait_value, &device_wait_value, &signal_value, &batch));
+  IREE_RETURN_IF_ERROR(iree_hal_device_queue_submit(
+      device, IREE_HAL_COMMAND_CATEGORY_ANY, 0, 1, &batch));
+
+  rets->i0 = (int32_t)signal_value;
+  return iree_ok_status();
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit_and_wait,  //
                    iree_hal_module_state_t,             //
-                   rr, v) {
+                   rri, v) {
   iree_hal_device_t* device = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_device_check_deref(args->r0, &device));
   iree_hal_command_buffer_t* command_buffer = NULL;
   IREE_RETURN_IF_ERROR(
       iree_hal_command_buffer_check_deref(args->r1, &command_buffer));
+  uint64_t wait_value = iree_hal_module_timepoint_value(args->i2);
 
   // Batch with our single command buffer.
+  iree_host_size_t device_index = iree_hal_module_device_index(state, device);
   iree_hal_submission_batch_t batch;
-  memset(&batch, 0, sizeof(batch));
-
-  iree_hal_command_buffer_t* command_buffer_ptrs[] = {command_buffer};
-  batch.command_buffer_count = IREE_ARRAYSIZE(command_buffer_ptrs);
-  batch.command_buffers = command_buffer_ptrs;
-
-  uint64_t next_semaphore_value = ++state->submit_value;
-  iree_hal_semaphore_t* signal_semaphore_ptrs[] = {state->submit_semaphore};
-  uint64_t signal_semaphore_values[] = {next_semaphore_value};
-  batch.signal_semaphores.count = IREE_ARRAYSIZE(signal_semaphore_ptrs);
-  batch.signal_semaphores.semaphores = signal_semaphore_ptrs;
-  batch.signal_semaphores.payload_values = signal_semaphore_values;
+  uint64_t device_wait_value = 0ull;
+  uint64_t signal_value = 0ull;
+  IREE_RETURN_IF_ERROR(iree_hal_module_prepare_submit(
+      state, device_index, &command_buffer, wait_value, &device_wait_value,
+      &signal_value, &batch));
 
-  iree_status_t status = iree_hal_device_submit_and_wait(
+  return iree_hal_device_submit_and_wait(
       device, IREE_HAL_COMMAND_CATEGORY_ANY, 0, 1, &batch,
-      state->submit_semaphore, next_semaphore_value, iree_infinite_timeout());
-  if (!iree_status_is_ok(status)) {
-    return status;
-  }
+      state->device_states[device_index].submit_semaphore, signal_value,
+      iree_infinite_timeout());
+}
 
+IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit_await,  //
+                   iree_hal_module_state_t,          //
+                   i, v) {
+  return iree_hal_module_await_timeline(
+      state, iree_hal_module_timepoint_value(args->i0),
+      /*except_device_index=*/SIZE_MAX);
+}
+
+IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit_timeline,  //
+                   iree_hal_module_state_t,             //
+                   i, ri) {
+  // Only the shared device semaphore is exported; work on other devices the
+  // timepoint covers is waited on here.
+  uint64_t value = iree_hal_module_timepoint_value(args->i0);
+  IREE_RETURN_IF_ERROR(iree_hal_module_await_timeline(
+      state, value, /*except_device_index=*/0));
+  iree_hal_module_device_state_t* device_state = &state->device_states[0];
+  rets->r0 = iree_hal_semaphore_retain_ref(device_state->submit_semaphore);
+  rets->i1 = (int32_t)iree_min(value, device_state->last_submit_value);
   return iree_ok_status();
 }
 
@@ -243,6 +495,25 @@ IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit_and_wait,  //
 // iree_hal_allocator_t
 //===----------------------------------------------------------------------===//
 
+// Attributes allocations made on behalf of the calling VM function to it when
+// profiling so that memory timelines can be broken down by source. Returns the
+// prior source to restore with iree_hal_module_end_allocation_source.
+static iree_string_view_t iree_hal_module_begin_allocation_source(
+    iree_vm_stack_t* stack) {
+  iree_string_view_t source = iree_string_view_empty();
+  if (iree_profiler_is_enabled(IREE_PROFILER_EVENT_MASK_ALLOCATION)) {
+    // The top frame is this native function; its parent is the caller.
+    iree_vm_stack_frame_t* caller_frame = iree_vm_stack_parent_frame(stack);
+    if (caller_frame) source = iree_vm_function_name(&caller_frame->function);
+  }
+  return iree_profiler_set_thread_source(source);
+}
+
+static void iree_hal_module_end_allocation_source(
+    iree_string_view_t previous_source) {
+  iree_profiler_set_thread_source(previous_source);
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_allocator_allocate,  //
                    iree_hal_module_state_t,             //
                    riii, r) {
@@ -253,9 +524,13 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_allocate,  //
   iree_vm_size_t allocation_size = (iree_vm_size_t)args->i3;
 
   iree_hal_buffer_t* buffer = NULL;
-  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+  iree_string_view_t previous_source =
+      iree_hal_module_begin_allocation_source(stack);
+  iree_status_t status = iree_hal_allocator_allocate_buffer(
       allocator, memory_types, buffer_usage, allocation_size,
-      iree_const_byte_span_empty(), &buffer));
+      iree_const_byte_span_empty(), &buffer);
+  iree_hal_module_end_allocation_source(previous_source);
+  IREE_RETURN_IF_ERROR(status);
   rets->r0 = iree_hal_buffer_move_ref(buffer);
   return iree_ok_status();
 }
@@ -272,6 +547,34 @@ static iree_status_t iree_hal_module_map_data_ctl(
   return iree_ok_status();
 }
 
+// Wraps |length| bytes of |source| starting at |offset| in a HAL buffer
+// without copying.
+//
+// The source buffer is retained for the allocator and will be released by
+// iree_hal_module_map_data_ctl when the mapping is no longer used. Some
+// allocators clone read-only data and free it before returning so the
+// reference must be held before wrapping.
+static iree_status_t iree_hal_module_wrap_vm_buffer(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_types,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t buffer_usage, iree_vm_buffer_t* source,
+    iree_vm_size_t offset, iree_vm_size_t length,
+    iree_hal_buffer_t** out_buffer) {
+  iree_allocator_t buffer_deref_allocator = {
+      .self = source,
+      .ctl = iree_hal_module_map_data_ctl,
+  };
+  iree_vm_buffer_retain(source);
+  iree_status_t status = iree_hal_allocator_wrap_buffer(
+      allocator, memory_types, allowed_access, buffer_usage,
+      iree_make_byte_span(source->data.data + offset, length),
+      buffer_deref_allocator, out_buffer);
+  if (!iree_status_is_ok(status)) {
+    iree_vm_buffer_release(source);
+  }
+  return status;
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_allocator_map_byte_buffer,  //
                    iree_hal_module_state_t,                    //
                    riiirii, r) {
@@ -320,19 +623,11 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_map_byte_buffer,  //
   // Try mapping - note that this may fail if the target device cannot map the
   // memory into the given type (for example, mapping a host buffer into
   // device-local memory is only going to work on unified memory systems).
-  iree_allocator_t buffer_deref_allocator = {
-      .self = source,
-      .ctl = iree_hal_module_map_data_ctl,
-  };
   iree_hal_buffer_t* buffer = NULL;
-  iree_status_t status = iree_hal_allocator_wrap_buffer(
-      allocator, memory_types, allowed_access, buffer_usage,
-      iree_make_byte_span(source->data.data + offset, length),
-      buffer_deref_allocator, &buffer);
+  iree_status_t status = iree_hal_module_wrap_vm_buffer(
+      allocator, memory_types, allowed_access, buffer_usage, source, offset,
+      length, &buffer);
   if (iree_status_is_ok(status)) {
-    // Mapping succeeded - retain the source buffer that'll be released by
-    // iree_hal_module_map_data_ctl when the mapping is no longer used.
-    iree_vm_buffer_retain(source);
     rets->r0 = iree_hal_buffer_move_ref(buffer);
     return iree_ok_status();
   }
@@ -347,6 +642,8 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_map_byte_buffer,  //
   return status;
 }
 
+// Wraps a byte range of a VM buffer in a HAL buffer for staging purposes,
+// avoiding the copy when possible and otherwise allocating and copying.
 // TODO(#7277): drop this method (use map instead) with streams.
 IREE_VM_ABI_EXPORT(iree_hal_module_allocator_wrap_byte_buffer,  //
                    iree_hal_module_state_t,                     //
@@ -372,13 +669,38 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_wrap_byte_buffer,  //
         (offset + length - 1), buffer_length);
   }
 
+  // Immutable source data (such as module rodata, which may be backed by a
+  // file mapping) can be used directly by any device able to import host
+  // memory. This avoids a full copy of every constant on CPU and unified
+  // memory devices and keeps the pages shared with the file cache. The
+  // resulting buffer is read-only; callers are expected to only use it as the
+  // source of transfers.
   iree_hal_buffer_t* buffer = NULL;
-  IREE_RETURN_IF_ERROR(
-      iree_hal_allocator_allocate_buffer(
-          allocator, memory_types, buffer_usage, length,
-          iree_make_const_byte_span(source->data.data + offset, length),
-          &buffer),
-      "failed to allocate buffer of length %d", length);
+  if (!iree_all_bits_set(source->access, IREE_VM_BUFFER_ACCESS_MUTABLE) &&
+      iree_all_bits_set(iree_hal_allocator_query_buffer_compatibility(
+                            allocator, memory_types, buffer_usage,
+                            buffer_usage, (iree_device_size_t)length),
+                        IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE)) {
+    iree_status_t status = iree_hal_module_wrap_vm_buffer(
+        allocator, memory_types, IREE_HAL_MEMORY_ACCESS_READ, buffer_usage,
+        source, offset, length, &buffer);
+    if (iree_status_is_ok(status)) {
+      rets->r0 = iree_hal_buffer_move_ref(buffer);
+      return iree_ok_status();
+    }
+    // Importing may still fail for pointers the device cannot access (such as
+    // misaligned ranges); fall back to copying.
+    iree_status_ignore(status);
+  }
+
+  iree_string_view_t previous_source =
+      iree_hal_module_begin_allocation_source(stack);
+  iree_status_t status = iree_hal_allocator_allocate_buffer(
+      allocator, memory_types, buffer_usage, length,
+      iree_make_const_byte_span(source->data.data + offset, length), &buffer);
+  iree_hal_module_end_allocation_source(previous_source);
+  IREE_RETURN_IF_ERROR(status, "failed to allocate buffer of length %d",
+                       length);
 
   rets->r0 = iree_hal_buffer_move_ref(buffer);
   return iree_ok_status();
@@ -559,6 +881,59 @@ IREE_VM_ABI_EXPORT(iree_hal_module_buffer_store,  //
 // iree_hal_buffer_view_t
 //===----------------------------------------------------------------------===//
 
+// Returns a buffer view of |buffer| with the given shape and types.
+// Views retained in the state cache are returned as-is if equivalent or
+// updated in place if no longer used. The returned view is borrowed from the
+// cache and must be retained by the caller.
+static iree_status_t iree_hal_module_acquire_buffer_view(
+    iree_hal_module_state_t* state, iree_hal_buffer_t* buffer,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type,
+    iree_hal_buffer_view_t** out_buffer_view) {
+  // Prefer views that are already equivalent as it's common for the same
+  // results to be returned on each invocation. Views still referenced by users
+  // are never shared as users may mutate them (such as with a reshape).
+  iree_hal_buffer_view_t** cache = state->buffer_view_cache;
+  for (iree_host_size_t i = 0; i < IREE_HAL_MODULE_BUFFER_VIEW_CACHE_CAPACITY;
+       ++i) {
+    if (cache[i] &&
+        iree_hal_buffer_view_is_equivalent(cache[i], buffer, shape,
+                                           shape_rank, element_type,
+                                           encoding_type) &&
+        iree_hal_buffer_view_try_update(cache[i], buffer, shape, shape_rank,
+                                        element_type, encoding_type)) {
+      *out_buffer_view = cache[i];
+      return iree_ok_status();
+    }
+  }
+
+  // Otherwise update the first view that's no longer in use, if any.
+  for (iree_host_size_t i = 0; i < IREE_HAL_MODULE_BUFFER_VIEW_CACHE_CAPACITY;
+       ++i) {
+    if (cache[i] &&
+        iree_hal_buffer_view_try_update(cache[i], buffer, shape, shape_rank,
+                                        element_type, encoding_type)) {
+      *out_buffer_view = cache[i];
+      return iree_ok_status();
+    }
+  }
+
+  // Allocate a new view and store it in the cache, evicting a prior view if
+  // needed. Evicted views remain valid for any users still referencing them.
+  iree_hal_buffer_view_t* buffer_view = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_create(
+      buffer, shape, shape_rank, element_type, encoding_type,
+      state->host_allocator, &buffer_view));
+  iree_host_size_t slot = state->buffer_view_cache_next;
+  state->buffer_view_cache_next =
+      (slot + 1) % IREE_HAL_MODULE_BUFFER_VIEW_CACHE_CAPACITY;
+  iree_hal_buffer_view_release(cache[slot]);
+  cache[slot] = buffer_view;
+  *out_buffer_view = buffer_view;
+  return iree_ok_status();
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_buffer_view_create,  //
                    iree_hal_module_state_t,             //
                    riiCiD, r) {
@@ -572,10 +947,10 @@ IREE_VM_ABI_EXPORT(iree_hal_module_buffer_view_create,  //
                              &shape_rank, &shape_dims);
 
   iree_hal_buffer_view_t* buffer_view = NULL;
-  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_create(
-      source_buffer, shape_dims, shape_rank, element_type, encoding_type,
-      state->host_allocator, &buffer_view));
-  rets->r0 = iree_hal_buffer_view_move_ref(buffer_view);
+  IREE_RETURN_IF_ERROR(iree_hal_module_acquire_buffer_view(
+      state, source_buffer, shape_dims, shape_rank, element_type,
+      encoding_type, &buffer_view));
+  rets->r0 = iree_hal_buffer_view_retain_ref(buffer_view);
   return iree_ok_status();
 }
 
@@ -1035,6 +1410,15 @@ IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_bind_descriptor_set,  //
       dynamic_offset_count, dynamic_offsets);
 }
 
+// Dereferences |ref| as an executable that can be dispatched, preparing it
+// first if it was deferred by IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES.
+static iree_status_t iree_hal_module_executable_resolve_ref(
+    iree_vm_ref_t ref, iree_hal_executable_t** out_executable) {
+  iree_hal_executable_t* executable = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_executable_check_deref(ref, &executable));
+  return iree_hal_lazy_executable_resolve(executable, out_executable);
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_dispatch,  //
                    iree_hal_module_state_t,                  //
                    rriiii, v) {
@@ -1042,7 +1426,8 @@ IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_dispatch,  //
   IREE_RETURN_IF_ERROR(
       iree_hal_command_buffer_check_deref(args->r0, &command_buffer));
   iree_hal_executable_t* executable = NULL;
-  IREE_RETURN_IF_ERROR(iree_hal_executable_check_deref(args->r1, &executable));
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_executable_resolve_ref(args->r1, &executable));
   uint32_t entry_point = (uint32_t)args->i2;
   uint32_t workgroup_x = (uint32_t)args->i3;
   uint32_t workgroup_y = (uint32_t)args->i4;
@@ -1059,7 +1444,8 @@ IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_dispatch_indirect,  //
   IREE_RETURN_IF_ERROR(
       iree_hal_command_buffer_check_deref(args->r0, &command_buffer));
   iree_hal_executable_t* executable = NULL;
-  IREE_RETURN_IF_ERROR(iree_hal_executable_check_deref(args->r1, &executable));
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_executable_resolve_ref(args->r1, &executable));
   uint32_t entry_point = (uint32_t)args->i2;
   iree_hal_buffer_t* workgroups_buffer = NULL;
   IREE_RETURN_IF_ERROR(
@@ -1070,6 +1456,169 @@ IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_dispatch_indirect,  //
       workgroups_offset);
 }
 
+// Opcodes of the commands encoded in a command_buffer.dispatch.batch command
+// stream. Each command is a sequence of little-endian uint32_t words starting
+// with its opcode. Resources are referenced by their ordinal in the resource
+// list passed alongside the command stream.
+//
+// This must be kept in sync with the compiler BatchDispatchCommands pass.
+typedef enum iree_hal_module_batch_opcode_e {
+  // <source_stage_mask, target_stage_mask, flags>
+  IREE_HAL_MODULE_BATCH_OPCODE_EXECUTION_BARRIER = 0,
+  // <executable_layout, offset, value_count, values...>
+  IREE_HAL_MODULE_BATCH_OPCODE_PUSH_CONSTANTS = 1,
+  // <executable_layout, set, binding_count,
+  //  (binding, buffer, offset, length)...>
+  IREE_HAL_MODULE_BATCH_OPCODE_PUSH_DESCRIPTOR_SET = 2,
+  // <executable, entry_point, workgroup_x, workgroup_y, workgroup_z>
+  IREE_HAL_MODULE_BATCH_OPCODE_DISPATCH = 3,
+} iree_hal_module_batch_opcode_t;
+
+// Takes |count| words from the command stream at |cursor| and advances it.
+static iree_status_t iree_hal_module_batch_take(const uint32_t** cursor,
+                                                const uint32_t* end,
+                                                iree_host_size_t count,
+                                                const uint32_t** out_words) {
+  if (IREE_UNLIKELY((iree_host_size_t)(end - *cursor) < count)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "command stream truncated; expected %zu words",
+                            count);
+  }
+  *out_words = *cursor;
+  *cursor += count;
+  return iree_ok_status();
+}
+
+// Returns the resource at |ordinal| in the batch resource list.
+static iree_status_t iree_hal_module_batch_resource(
+    const iree_vm_abi_rrCrD_t* args, uint32_t ordinal,
+    iree_vm_ref_t* out_ref) {
+  if (IREE_UNLIKELY(ordinal >= (uint32_t)args->a2_count)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "resource ordinal %u out of range (%d resources)",
+                            ordinal, (int)args->a2_count);
+  }
+  *out_ref = args->a2[ordinal].r0;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_module_command_buffer_record_batch_command(
+    iree_hal_command_buffer_t* command_buffer, const iree_vm_abi_rrCrD_t* args,
+    uint32_t opcode, const uint32_t** cursor, const uint32_t* end) {
+  const uint32_t* words = NULL;
+  iree_vm_ref_t ref;
+  switch (opcode) {
+    case IREE_HAL_MODULE_BATCH_OPCODE_EXECUTION_BARRIER: {
+      IREE_RETURN_IF_ERROR(iree_hal_module_batch_take(cursor, end, 3, &words));
+      // TODO(benvanik): decode barriers.
+      iree_hal_memory_barrier_t global_barrier;
+      global_barrier.source_scope = IREE_HAL_ACCESS_SCOPE_DISPATCH_WRITE;
+      global_barrier.target_scope = IREE_HAL_ACCESS_SCOPE_DISPATCH_READ;
+      return iree_hal_command_buffer_execution_barrier(
+          command_buffer, (iree_hal_execution_stage_t)words[0],
+          (iree_hal_execution_stage_t)words[1],
+          (iree_hal_execution_barrier_flags_t)words[2], 1, &global_barrier, 0,
+          NULL);
+    }
+    case IREE_HAL_MODULE_BATCH_OPCODE_PUSH_CONSTANTS: {
+      IREE_RETURN_IF_ERROR(iree_hal_module_batch_take(cursor, end, 3, &words));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_batch_resource(args, words[0], &ref));
+      iree_hal_executable_layout_t* executable_layout = NULL;
+      IREE_RETURN_IF_ERROR(
+          iree_hal_executable_layout_check_deref(ref, &executable_layout));
+      uint32_t offset = words[1];
+      uint32_t value_count = words[2];
+      const uint32_t* values = NULL;
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_batch_take(cursor, end, value_count, &values));
+      return iree_hal_command_buffer_push_constants(
+          command_buffer, executable_layout, offset * sizeof(uint32_t), values,
+          value_count * sizeof(uint32_t));
+    }
+    case IREE_HAL_MODULE_BATCH_OPCODE_PUSH_DESCRIPTOR_SET: {
+      IREE_RETURN_IF_ERROR(iree_hal_module_batch_take(cursor, end, 3, &words));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_batch_resource(args, words[0], &ref));
+      iree_hal_executable_layout_t* executable_layout = NULL;
+      IREE_RETURN_IF_ERROR(
+          iree_hal_executable_layout_check_deref(ref, &executable_layout));
+      uint32_t set = words[1];
+      iree_host_size_t binding_count = words[2];
+      if (IREE_UNLIKELY(binding_count >
+                        IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT)) {
+        return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                "binding count %zu > %zu", binding_count,
+                                IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT);
+      }
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_batch_take(cursor, end, binding_count * 4, &words));
+      iree_hal_descriptor_set_binding_t
+          bindings[IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT];
+      for (iree_host_size_t i = 0; i < binding_count; ++i) {
+        const uint32_t* binding_words = &words[i * 4];
+        IREE_RETURN_IF_ERROR(
+            iree_hal_module_batch_resource(args, binding_words[1], &ref));
+        IREE_RETURN_IF_ERROR(
+            iree_hal_buffer_check_deref(ref, &bindings[i].buffer));
+        bindings[i].binding = binding_words[0];
+        bindings[i].offset = (iree_device_size_t)binding_words[2];
+        bindings[i].length = (iree_device_size_t)binding_words[3];
+      }
+      return iree_hal_command_buffer_push_descriptor_set(
+          command_buffer, executable_layout, set, binding_count, bindings);
+    }
+    case IREE_HAL_MODULE_BATCH_OPCODE_DISPATCH: {
+      IREE_RETURN_IF_ERROR(iree_hal_module_batch_take(cursor, end, 5, &words));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_batch_resource(args, words[0], &ref));
+      iree_hal_executable_t* executable = NULL;
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_executable_resolve_ref(ref, &executable));
+      return iree_hal_command_buffer_dispatch(command_buffer, executable,
+                                              words[1], words[2], words[3],
+                                              words[4]);
+    }
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unknown batch command opcode %u", opcode);
+  }
+}
+
+// Records all commands in the packed command stream. This allows an entire
+// execution region with constant parameters to be recorded with a single
+// import call instead of one per command.
+IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_dispatch_batch,  //
+                   iree_hal_module_state_t,                        //
+                   rrCrD, v) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_command_buffer_check_deref(args->r0, &command_buffer));
+  iree_vm_buffer_t* commands = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(args->r1, &commands));
+
+  iree_byte_span_t command_data = iree_vm_buffer_data(commands);
+  if (IREE_UNLIKELY(
+          ((uintptr_t)command_data.data % sizeof(uint32_t)) != 0 ||
+          (command_data.data_length % sizeof(uint32_t)) != 0)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "command stream must be a 4-byte aligned sequence of 32-bit words");
+  }
+  const uint32_t* cursor = (const uint32_t*)command_data.data;
+  const uint32_t* end = cursor + command_data.data_length / sizeof(uint32_t);
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_ok_status();
+  while (iree_status_is_ok(status) && cursor < end) {
+    uint32_t opcode = *cursor++;
+    status = iree_hal_module_command_buffer_record_batch_command(
+        command_buffer, args, opcode, &cursor, end);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_descriptor_set_t
 //===----------------------------------------------------------------------===//
@@ -1175,10 +1724,144 @@ IREE_VM_ABI_EXPORT(iree_hal_module_device_query_i32,  //
   return iree_ok_status();
 }
 
+// Allocates |allocation_size| bytes for use as a transient buffer, reusing a
+// buffer returned with device.queue.dealloca if one is available.
+// Buffers are allocated with the size of their size class so that they can be
+// pooled once returned and the caller receives a subspan of the requested size.
+static iree_status_t iree_hal_module_transient_buffer_allocate(
+    iree_hal_module_state_t* state, iree_hal_device_t* device,
+    iree_hal_memory_type_t memory_types, iree_hal_buffer_usage_t buffer_usage,
+    iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer) {
+  iree_hal_allocation_cache_class_t size_class;
+  if (device != state->shared_device ||
+      !iree_all_bits_set(memory_types, IREE_HAL_MEMORY_TYPE_TRANSIENT) ||
+      !iree_hal_allocation_cache_lookup_class(&state->transient_pool,
+                                              allocation_size, &size_class)) {
+    return iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device), memory_types, buffer_usage,
+        allocation_size, iree_const_byte_span_empty(), out_buffer);
+  }
+
+  iree_hal_buffer_t* buffer = NULL;
+  iree_hal_cached_allocation_t allocation;
+  if (iree_hal_allocation_cache_acquire(&state->transient_pool, /*heap=*/0,
+                                        &size_class, &allocation)) {
+    buffer = (iree_hal_buffer_t*)allocation.host_ptr;
+    if (!iree_all_bits_set(iree_hal_buffer_memory_type(buffer),
+                           memory_types) ||
+        !iree_all_bits_set(iree_hal_buffer_allowed_usage(buffer),
+                           buffer_usage)) {
+      // Pooled buffer was allocated for a different use; drop it.
+      iree_hal_buffer_release(buffer);
+      buffer = NULL;
+    }
+  }
+  if (!buffer) {
+    IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device), memory_types, buffer_usage,
+        size_class.size, iree_const_byte_span_empty(), &buffer));
+  }
+
+  iree_status_t status =
+      iree_hal_buffer_subspan(buffer, 0, allocation_size, out_buffer);
+  iree_hal_buffer_release(buffer);
+  return status;
+}
+
+IREE_VM_ABI_EXPORT(iree_hal_module_device_queue_alloca,  //
+                   iree_hal_module_state_t,              //
+                   riii, r) {
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_device_check_deref(args->r0, &device));
+  iree_hal_memory_type_t memory_types = (iree_hal_memory_type_t)args->i1;
+  iree_hal_buffer_usage_t buffer_usage = (iree_hal_buffer_usage_t)args->i2;
+  iree_vm_size_t allocation_size = (iree_vm_size_t)args->i3;
+
+  iree_hal_buffer_t* buffer = NULL;
+  iree_string_view_t previous_source =
+      iree_hal_module_begin_allocation_source(stack);
+  iree_status_t status = iree_hal_module_transient_buffer_allocate(
+      state, device, memory_types, buffer_usage, allocation_size, &buffer);
+  iree_hal_module_end_allocation_source(previous_source);
+  IREE_RETURN_IF_ERROR(status);
+  rets->r0 = iree_hal_buffer_move_ref(buffer);
+  return iree_ok_status();
+}
+
+IREE_VM_ABI_EXPORT(iree_hal_module_device_queue_dealloca,  //
+                   iree_hal_module_state_t,                //
+                   rr, v) {
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_device_check_deref(args->r0, &device));
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_check_deref(args->r1, &buffer));
+  if (device != state->shared_device) return iree_ok_status();
+
+  // Submissions are synchronous and all work using the buffer has completed
+  // by the time it is deallocated; the allocation can be reused immediately.
+  // Only buffers with the exact size of their size class (as allocated by
+  // device.queue.alloca) can be pooled; all others are left to be released
+  // when their last reference is dropped.
+  iree_hal_buffer_t* allocated_buffer =
+      iree_hal_buffer_allocated_buffer(buffer);
+  iree_device_size_t allocation_size =
+      iree_hal_buffer_allocation_size(allocated_buffer);
+  iree_hal_allocation_cache_class_t size_class;
+  if (!iree_all_bits_set(iree_hal_buffer_memory_type(allocated_buffer),
+                         IREE_HAL_MEMORY_TYPE_TRANSIENT) ||
+      !iree_hal_allocation_cache_lookup_class(&state->transient_pool,
+                                              allocation_size, &size_class) ||
+      size_class.size != allocation_size) {
+    return iree_ok_status();
+  }
+  iree_hal_cached_allocation_t allocation = {
+      .device_ptr = 0,
+      .host_ptr = allocated_buffer,
+  };
+  iree_hal_buffer_retain(allocated_buffer);
+  if (!iree_hal_allocation_cache_release(&state->transient_pool, /*heap=*/0,
+                                         &size_class, allocation)) {
+    iree_hal_buffer_release(allocated_buffer);
+  }
+  return iree_ok_status();
+}
+
 //===--------------------------------------------------------------------===//
 // iree_hal_executable_t
 //===--------------------------------------------------------------------===//
 
+// Returns the executable cache of |device|. Devices not bound to the module
+// share the cache of the shared device.
+static iree_hal_executable_cache_t* iree_hal_module_executable_cache_for(
+    iree_hal_module_state_t* state, iree_hal_device_t* device) {
+  iree_host_size_t device_index = iree_hal_module_device_index(state, device);
+  return state->device_states[device_index].executable_cache;
+}
+
+// Retains |executable| in the list of lazy executables of |state|.
+static iree_status_t iree_hal_module_track_lazy_executable(
+    iree_hal_module_state_t* state, iree_hal_executable_t* executable) {
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&state->lazy_executable_mutex);
+  if (state->lazy_executable_count == state->lazy_executable_capacity) {
+    iree_host_size_t new_capacity =
+        iree_max(16, state->lazy_executable_capacity * 2);
+    status = iree_allocator_realloc(
+        state->host_allocator,
+        new_capacity * sizeof(state->lazy_executables[0]),
+        (void**)&state->lazy_executables);
+    if (iree_status_is_ok(status)) {
+      state->lazy_executable_capacity = new_capacity;
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    iree_hal_executable_retain(executable);
+    state->lazy_executables[state->lazy_executable_count++] = executable;
+  }
+  iree_slim_mutex_unlock(&state->lazy_executable_mutex);
+  return status;
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
                    iree_hal_module_state_t,            //
                    rrrCrD, r) {
@@ -1217,8 +1900,19 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
         executable_data->data.data, executable_data->data.data_length);
     spec.executable_layout_count = executable_layout_count;
     spec.executable_layouts = executable_layouts;
-    status = iree_hal_executable_cache_prepare_executable(
-        state->executable_cache, &spec, &executable);
+    iree_hal_executable_cache_t* executable_cache =
+        iree_hal_module_executable_cache_for(state, device);
+    if (iree_all_bits_set(state->flags,
+                          IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES)) {
+      status = iree_hal_lazy_executable_create(
+          executable_cache, &spec, state->host_allocator, &executable);
+      if (iree_status_is_ok(status)) {
+        status = iree_hal_module_track_lazy_executable(state, executable);
+      }
+    } else {
+      status = iree_hal_executable_cache_prepare_executable(
+          executable_cache, &spec, &executable);
+    }
   }
 
   iree_allocator_free(state->host_allocator, executable_layouts);
@@ -1373,8 +2067,24 @@ IREE_API_EXPORT iree_status_t
 iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
                        iree_vm_module_t** out_module) {
   IREE_ASSERT_ARGUMENT(device);
+  return iree_hal_module_create_multi(1, &device, IREE_HAL_MODULE_FLAG_NONE,
+                                      allocator, out_module);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_module_create_multi(
+    iree_host_size_t device_count, iree_hal_device_t* const* devices,
+    iree_hal_module_flags_t flags, iree_allocator_t allocator,
+    iree_vm_module_t** out_module) {
+  IREE_ASSERT_ARGUMENT(!device_count || devices);
   IREE_ASSERT_ARGUMENT(out_module);
   *out_module = NULL;
+  if (IREE_UNLIKELY(device_count == 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "at least one device is required");
+  }
+  for (iree_host_size_t i = 0; i < device_count; ++i) {
+    IREE_ASSERT_ARGUMENT(devices[i]);
+  }
 
   // Setup the interface with the functions we implement ourselves. Any function
   // we omit will be handled by the base native module.
@@ -1386,8 +2096,9 @@ iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
   };
 
   // Allocate shared module state.
-  iree_host_size_t total_size =
-      iree_vm_native_module_size() + sizeof(iree_hal_module_t);
+  iree_host_size_t total_size = iree_vm_native_module_size() +
+                                sizeof(iree_hal_module_t) +
+                                device_count * sizeof(iree_hal_device_t*);
   iree_vm_module_t* base_module = NULL;
   IREE_RETURN_IF_ERROR(
       iree_allocator_malloc(allocator, total_size, (void**)&base_module));
@@ -1401,8 +2112,12 @@ iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
 
   iree_hal_module_t* module = IREE_HAL_MODULE_CAST(base_module);
   module->host_allocator = allocator;
-  module->shared_device = device;
-  iree_hal_device_retain(module->shared_device);
+  module->flags = flags;
+  module->device_count = device_count;
+  for (iree_host_size_t i = 0; i < device_count; ++i) {
+    module->devices[i] = devices[i];
+    iree_hal_device_retain(module->devices[i]);
+  }
 
   *out_module = base_module;
   return iree_ok_status();
@@ -1414,6 +2129,94 @@ IREE_API_EXPORT iree_hal_device_t* iree_hal_module_state_device(
   return state->shared_device;
 }
 
+IREE_API_EXPORT iree_status_t iree_hal_module_state_prepare_executables(
+    iree_vm_module_state_t* module_state) {
+  IREE_ASSERT_ARGUMENT(module_state);
+  iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Walk by index and only hold the lock while fetching each entry so that
+  // initializers can keep creating executables while others are prepared.
+  // Entries are never removed until the state is freed.
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; iree_status_is_ok(status); ++i) {
+    iree_hal_executable_t* executable = NULL;
+    iree_slim_mutex_lock(&state->lazy_executable_mutex);
+    if (i < state->lazy_executable_count) {
+      executable = state->lazy_executables[i];
+    }
+    iree_slim_mutex_unlock(&state->lazy_executable_mutex);
+    if (!executable) break;
+    iree_hal_executable_t* prepared_executable = NULL;
+    status =
+        iree_hal_lazy_executable_resolve(executable, &prepared_executable);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Submits an empty command buffer to |device_index| on the module submission
+// timeline and waits for it to complete.
+static iree_status_t iree_hal_module_warmup_device_queue(
+    iree_hal_module_state_t* state, iree_host_size_t device_index) {
+  iree_hal_device_t* device = state->devices[device_index];
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_command_buffer_create(
+      device, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      IREE_HAL_COMMAND_CATEGORY_ANY, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+  iree_status_t status = iree_hal_command_buffer_begin(command_buffer);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_end(command_buffer);
+  }
+  iree_hal_submission_batch_t batch;
+  uint64_t device_wait_value = 0ull;
+  uint64_t signal_value = 0ull;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_module_prepare_submit(state, device_index,
+                                            &command_buffer, /*wait_value=*/0,
+                                            &device_wait_value, &signal_value,
+                                            &batch);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_device_submit_and_wait(
+        device, IREE_HAL_COMMAND_CATEGORY_ANY, 0, 1, &batch,
+        state->device_states[device_index].submit_semaphore, signal_value,
+        iree_infinite_timeout());
+  }
+  iree_hal_command_buffer_release(command_buffer);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_hal_module_state_warmup(iree_vm_module_state_t* module_state) {
+  IREE_ASSERT_ARGUMENT(module_state);
+  iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_module_state_prepare_executables(module_state));
+
+  for (iree_host_size_t i = 0; i < state->device_count; ++i) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_module_warmup_device_queue(state, i));
+
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_allocator_allocate_buffer(
+                iree_hal_device_allocator(state->devices[i]),
+                IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+                IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER,
+                IREE_HAL_MODULE_WARMUP_ALLOCATION_SIZE,
+                iree_const_byte_span_empty(), &buffer));
+    iree_hal_buffer_release(buffer);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 //===--------------------------------------------------------------------===//
 // Utilities
 //===--------------------------------------------------------------------===//
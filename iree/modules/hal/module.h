@@ -39,6 +39,18 @@ extern "C" {
 // WARNING: not thread-safe; call at startup before using.
 IREE_API_EXPORT iree_status_t iree_hal_module_register_types(void);
 
+// Flags controlling HAL module behavior.
+enum iree_hal_module_flag_bits_t {
+  IREE_HAL_MODULE_FLAG_NONE = 0u,
+  // Defers executable preparation until the first dispatch using each
+  // executable instead of preparing them all from module initializers.
+  // This reduces load time for programs that only use some of their
+  // executables at the cost of latency on the first dispatch. Executables can
+  // be prepared ahead of use with iree_hal_module_state_prepare_executables.
+  IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES = 1u << 0,
+};
+typedef uint32_t iree_hal_module_flags_t;
+
 // Creates the HAL module initialized to use a specific |device|.
 // Each context using this module will share the device and have compatible
 // allocations.
@@ -46,11 +58,50 @@ IREE_API_EXPORT iree_status_t
 iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
                        iree_vm_module_t** out_module);
 
+// Creates the HAL module initialized to use a set of |devices|.
+// devices[0] is the shared device used by default and programs may select
+// other devices by ordinal (hal.ex.device) to place work on them. Devices must
+// be created from the same driver so that semaphores and buffers can be shared
+// between them. Each context using this module will share the devices.
+IREE_API_EXPORT iree_status_t iree_hal_module_create_multi(
+    iree_host_size_t device_count, iree_hal_device_t* const* devices,
+    iree_hal_module_flags_t flags, iree_allocator_t allocator,
+    iree_vm_module_t** out_module);
+
 // Returns the device currently in use by the HAL module.
 // Returns NULL if no device has been initialized yet.
 IREE_API_EXPORT iree_hal_device_t* iree_hal_module_state_device(
     iree_vm_module_state_t* module_state);
 
+// Prepares all executables created so far by the HAL module state that were
+// deferred with IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES. A no-op if the module
+// was not created in lazy mode or all executables have already been prepared.
+//
+// Thread-safe: may be called from any thread (such as a background thread
+// prewarming executables) while the context is in use. Dispatches using an
+// executable being prepared will block until it is ready.
+IREE_API_EXPORT iree_status_t iree_hal_module_state_prepare_executables(
+    iree_vm_module_state_t* module_state);
+
+// Size of the buffer allocated from each device allocator during warm-up.
+#define IREE_HAL_MODULE_WARMUP_ALLOCATION_SIZE (64 * 1024)
+
+// Initializes everything the HAL module state would otherwise initialize
+// lazily on first use so that the first call into the program runs at steady
+// state speed:
+//   - executables deferred with IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES are
+//     prepared (including any JIT compilation by the device);
+//   - an empty command buffer is submitted to and awaited on each device,
+//     bringing up its queues and any worker threads;
+//   - a device-local buffer is allocated and released from each device
+//     allocator to reserve its initial pool memory.
+// Should be called after the modules using the HAL module have been loaded and
+// their initializers have created their executables.
+//
+// Thread-compatible: must not be called concurrently with the context.
+IREE_API_EXPORT iree_status_t
+iree_hal_module_state_warmup(iree_vm_module_state_t* module_state);
+
 // TODO(benvanik): generate these list helpers:
 
 IREE_API_EXPORT iree_hal_buffer_view_t* iree_vm_list_get_buffer_view_assign(
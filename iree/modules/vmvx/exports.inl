@@ -23,6 +23,18 @@
 
 // clang-format off
 
-EXPORT_FN("_placeholder", iree_vmvx_module_placeholder, v, v)
+EXPORT_FN("add.2d.f32", iree_vmvx_add_2d_f32, riiiriiiriiiii, v)
+EXPORT_FN("add.2d.i32", iree_vmvx_add_2d_i32, riiiriiiriiiii, v)
+EXPORT_FN("copy.2d.x16", iree_vmvx_copy_2d_x16, riiiriiiii, v)
+EXPORT_FN("copy.2d.x32", iree_vmvx_copy_2d_x32, riiiriiiii, v)
+EXPORT_FN("copy.2d.x64", iree_vmvx_copy_2d_x64, riiiriiiii, v)
+EXPORT_FN("copy.2d.x8", iree_vmvx_copy_2d_x8, riiiriiiii, v)
+EXPORT_FN("exp.2d.f32", iree_vmvx_exp_2d_f32, riiiriiiii, v)
+EXPORT_FN("fill.2d.x16", iree_vmvx_fill_2d_x16, iriiiii, v)
+EXPORT_FN("fill.2d.x32", iree_vmvx_fill_2d_x32, iriiiii, v)
+EXPORT_FN("fill.2d.x8", iree_vmvx_fill_2d_x8, iriiiii, v)
+EXPORT_FN("matmul.f32f32f32", iree_vmvx_matmul_f32f32f32, riiriiriiiii, v)
+EXPORT_FN("mul.2d.f32", iree_vmvx_mul_2d_f32, riiiriiiriiiii, v)
+EXPORT_FN("mul.2d.i32", iree_vmvx_mul_2d_i32, riiiriiiriiiii, v)
 
 // clang-format on
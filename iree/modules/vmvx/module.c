@@ -6,6 +6,7 @@
 
 #include "iree/modules/vmvx/module.h"
 
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -91,13 +92,262 @@ iree_vmvx_module_free_state(void* self, iree_vm_module_state_t* module_state) {
 }
 
 //===----------------------------------------------------------------------===//
-// TODO
+// Strided buffer access
 //===----------------------------------------------------------------------===//
 
-// Placeholder to make the function pointer arrays happy (they can't be empty).
-IREE_VM_ABI_EXPORT(iree_vmvx_module_placeholder,  //
-                   iree_vmvx_module_state_t,      //
-                   v, v) {
+// Returns a pointer to the element at |offset| in |buffer_ref| after verifying
+// that the 2D region of |size0| x |size1| elements with the given element
+// strides is in bounds. Offsets and strides are in elements of
+// |element_size| bytes. The pointer is NULL if the region is empty.
+static iree_status_t iree_vmvx_map_2d(iree_vm_ref_t buffer_ref,
+                                      bool is_mutable, int32_t offset,
+                                      int32_t stride0, int32_t stride1,
+                                      int32_t size0, int32_t size1,
+                                      iree_host_size_t element_size,
+                                      uint8_t** out_data) {
+  *out_data = NULL;
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(buffer_ref, &buffer));
+  if (is_mutable &&
+      !iree_all_bits_set(buffer->access, IREE_VM_BUFFER_ACCESS_MUTABLE)) {
+    return iree_make_status(IREE_STATUS_PERMISSION_DENIED,
+                            "buffer is read-only and cannot be written");
+  }
+  if (offset < 0 || stride0 < 0 || stride1 < 0 || size0 < 0 || size1 < 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "negative offset, stride, or size");
+  }
+  if (size0 == 0 || size1 == 0) return iree_ok_status();
+  uint64_t last_element = (uint64_t)offset +
+                          (uint64_t)(size0 - 1) * (uint64_t)stride0 +
+                          (uint64_t)(size1 - 1) * (uint64_t)stride1;
+  if ((last_element + 1) * element_size > iree_vm_buffer_length(buffer)) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "strided region ending at element %" PRIu64
+        " exceeds the buffer length of %" PRIhsz " bytes",
+        last_element, iree_vm_buffer_length(buffer));
+  }
+  *out_data = buffer->data.data + offset * element_size;
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Copy and fill
+//===----------------------------------------------------------------------===//
+
+#define IREE_VMVX_COPY_2D_STRIDED(type)                                    \
+  for (int32_t i = 0; i < size0; ++i) {                                    \
+    const type* in_row = (const type*)in + i * in_stride0;                 \
+    type* out_row = (type*)out + i * out_stride0;                          \
+    for (int32_t j = 0; j < size1; ++j) {                                  \
+      out_row[j * out_stride1] = in_row[j * in_stride1];                   \
+    }                                                                      \
+  }
+
+// Copies a 2D region of elements. Rows that are contiguous in both buffers
+// (the common case) are copied with memmove; other layouts, such as
+// transposes and broadcasts, are copied one element at a time.
+static void iree_vmvx_copy_2d(const uint8_t* in, int32_t in_stride0,
+                              int32_t in_stride1, uint8_t* out,
+                              int32_t out_stride0, int32_t out_stride1,
+                              int32_t size0, int32_t size1,
+                              iree_host_size_t element_size) {
+  if (in_stride1 == 1 && out_stride1 == 1) {
+    for (int32_t i = 0; i < size0; ++i) {
+      memmove(out + i * out_stride0 * element_size,
+              in + i * in_stride0 * element_size, size1 * element_size);
+    }
+    return;
+  }
+  switch (element_size) {
+    case 1:
+      IREE_VMVX_COPY_2D_STRIDED(uint8_t);
+      break;
+    case 2:
+      IREE_VMVX_COPY_2D_STRIDED(uint16_t);
+      break;
+    case 4:
+      IREE_VMVX_COPY_2D_STRIDED(uint32_t);
+      break;
+    case 8:
+      IREE_VMVX_COPY_2D_STRIDED(uint64_t);
+      break;
+  }
+}
+
+#define IREE_VMVX_DEFINE_COPY_2D(bit_width, type)                            \
+  IREE_VM_ABI_EXPORT(iree_vmvx_copy_2d_x##bit_width,                         \
+                     iree_vmvx_module_state_t, riiiriiiii, v) {              \
+    uint8_t* in = NULL;                                                      \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r0, /*is_mutable=*/false,    \
+                                          args->i1, args->i2, args->i3,      \
+                                          args->i8, args->i9, sizeof(type),  \
+                                          &in));                             \
+    uint8_t* out = NULL;                                                     \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r4, /*is_mutable=*/true,     \
+                                          args->i5, args->i6, args->i7,      \
+                                          args->i8, args->i9, sizeof(type),  \
+                                          &out));                            \
+    if (!in || !out) return iree_ok_status();                                \
+    iree_vmvx_copy_2d(in, args->i2, args->i3, out, args->i6, args->i7,       \
+                      args->i8, args->i9, sizeof(type));                     \
+    return iree_ok_status();                                                 \
+  }
+
+IREE_VMVX_DEFINE_COPY_2D(8, uint8_t);
+IREE_VMVX_DEFINE_COPY_2D(16, uint16_t);
+IREE_VMVX_DEFINE_COPY_2D(32, uint32_t);
+IREE_VMVX_DEFINE_COPY_2D(64, uint64_t);
+
+// Fills a 2D region with the low bits of the i32 operand as the pattern.
+#define IREE_VMVX_DEFINE_FILL_2D(bit_width, type)                            \
+  IREE_VM_ABI_EXPORT(iree_vmvx_fill_2d_x##bit_width,                         \
+                     iree_vmvx_module_state_t, iriiiii, v) {                 \
+    uint8_t* out_data = NULL;                                                \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r1, /*is_mutable=*/true,     \
+                                          args->i2, args->i3, args->i4,      \
+                                          args->i5, args->i6, sizeof(type),  \
+                                          &out_data));                       \
+    if (!out_data) return iree_ok_status();                                  \
+    const type value = (type)args->i0;                                       \
+    for (int32_t i = 0; i < args->i5; ++i) {                                 \
+      type* IREE_RESTRICT out_row = (type*)out_data + i * args->i3;          \
+      if (args->i4 == 1) {                                                   \
+        for (int32_t j = 0; j < args->i6; ++j) out_row[j] = value;           \
+      } else {                                                               \
+        for (int32_t j = 0; j < args->i6; ++j) out_row[j * args->i4] = value; \
+      }                                                                      \
+    }                                                                        \
+    return iree_ok_status();                                                 \
+  }
+
+IREE_VMVX_DEFINE_FILL_2D(8, uint8_t);
+IREE_VMVX_DEFINE_FILL_2D(16, uint16_t);
+IREE_VMVX_DEFINE_FILL_2D(32, uint32_t);
+
+//===----------------------------------------------------------------------===//
+// Elementwise ops
+//===----------------------------------------------------------------------===//
+
+// Integer arithmetic wraps around as in the VM integer ops.
+#define IREE_VMVX_ADD_F32(lhs, rhs) ((lhs) + (rhs))
+#define IREE_VMVX_ADD_I32(lhs, rhs) \
+  ((int32_t)((uint32_t)(lhs) + (uint32_t)(rhs)))
+#define IREE_VMVX_MUL_F32(lhs, rhs) ((lhs) * (rhs))
+#define IREE_VMVX_MUL_I32(lhs, rhs) \
+  ((int32_t)((uint32_t)(lhs) * (uint32_t)(rhs)))
+
+// Binary ops on 2D regions. Rows contiguous in all operands get their own loop
+// so that compilers can vectorize it. The output may alias the inputs at the
+// same elements.
+#define IREE_VMVX_DEFINE_BINARY_2D(name, type, op)                             \
+  IREE_VM_ABI_EXPORT(iree_vmvx_##name, iree_vmvx_module_state_t,               \
+                     riiiriiiriiiii, v) {                                      \
+    int32_t size0 = args->i12, size1 = args->i13;                              \
+    uint8_t* lhs_data = NULL;                                                  \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r0, /*is_mutable=*/false,      \
+                                          args->i1, args->i2, args->i3, size0, \
+                                          size1, sizeof(type), &lhs_data));    \
+    uint8_t* rhs_data = NULL;                                                  \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r4, /*is_mutable=*/false,      \
+                                          args->i5, args->i6, args->i7, size0, \
+                                          size1, sizeof(type), &rhs_data));    \
+    uint8_t* out_data = NULL;                                                  \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(                                     \
+        args->r8, /*is_mutable=*/true, args->i9, args->i10, args->i11, size0, \
+        size1, sizeof(type), &out_data));                                      \
+    if (!out_data) return iree_ok_status();                                    \
+    bool is_contiguous = args->i3 == 1 && args->i7 == 1 && args->i11 == 1;     \
+    for (int32_t i = 0; i < size0; ++i) {                                      \
+      const type* lhs = (const type*)lhs_data + i * args->i2;                  \
+      const type* rhs = (const type*)rhs_data + i * args->i6;                  \
+      type* out = (type*)out_data + i * args->i10;                             \
+      if (is_contiguous) {                                                     \
+        for (int32_t j = 0; j < size1; ++j) out[j] = op(lhs[j], rhs[j]);       \
+      } else {                                                                 \
+        for (int32_t j = 0; j < size1; ++j) {                                  \
+          out[j * args->i11] = op(lhs[j * args->i3], rhs[j * args->i7]);       \
+        }                                                                      \
+      }                                                                        \
+    }                                                                          \
+    return iree_ok_status();                                                   \
+  }
+
+IREE_VMVX_DEFINE_BINARY_2D(add_2d_f32, float, IREE_VMVX_ADD_F32);
+IREE_VMVX_DEFINE_BINARY_2D(add_2d_i32, int32_t, IREE_VMVX_ADD_I32);
+IREE_VMVX_DEFINE_BINARY_2D(mul_2d_f32, float, IREE_VMVX_MUL_F32);
+IREE_VMVX_DEFINE_BINARY_2D(mul_2d_i32, int32_t, IREE_VMVX_MUL_I32);
+
+// Unary ops on 2D regions, following the same layout rules as binary ops.
+#define IREE_VMVX_DEFINE_UNARY_2D(name, type, op)                            \
+  IREE_VM_ABI_EXPORT(iree_vmvx_##name, iree_vmvx_module_state_t,             \
+                     riiiriiiii, v) {                                        \
+    int32_t size0 = args->i8, size1 = args->i9;                              \
+    uint8_t* in_data = NULL;                                                 \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r0, /*is_mutable=*/false,    \
+                                          args->i1, args->i2, args->i3,      \
+                                          size0, size1, sizeof(type),        \
+                                          &in_data));                        \
+    uint8_t* out_data = NULL;                                                \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r4, /*is_mutable=*/true,     \
+                                          args->i5, args->i6, args->i7,      \
+                                          size0, size1, sizeof(type),        \
+                                          &out_data));                       \
+    if (!out_data) return iree_ok_status();                                  \
+    bool is_contiguous = args->i3 == 1 && args->i7 == 1;                     \
+    for (int32_t i = 0; i < size0; ++i) {                                    \
+      const type* in = (const type*)in_data + i * args->i2;                  \
+      type* out = (type*)out_data + i * args->i6;                            \
+      if (is_contiguous) {                                                   \
+        for (int32_t j = 0; j < size1; ++j) out[j] = op(in[j]);              \
+      } else {                                                               \
+        for (int32_t j = 0; j < size1; ++j) {                                \
+          out[j * args->i7] = op(in[j * args->i3]);                          \
+        }                                                                    \
+      }                                                                      \
+    }                                                                        \
+    return iree_ok_status();                                                 \
+  }
+
+IREE_VMVX_DEFINE_UNARY_2D(exp_2d_f32, float, expf);
+
+//===----------------------------------------------------------------------===//
+// Matmul
+//===----------------------------------------------------------------------===//
+
+// Accumulates the product of the row-major M x K lhs and K x N rhs into the
+// M x N output: out += lhs * rhs. The innermost loop runs along contiguous rows
+// of the rhs and output and vectorizes.
+IREE_VM_ABI_EXPORT(iree_vmvx_matmul_f32f32f32,  //
+                   iree_vmvx_module_state_t,    //
+                   riiriiriiiii, v) {
+  int32_t m = args->i9, n = args->i10, k = args->i11;
+  uint8_t* lhs_data = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r0, /*is_mutable=*/false,
+                                        args->i1, args->i2, 1, m, k,
+                                        sizeof(float), &lhs_data));
+  uint8_t* rhs_data = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r3, /*is_mutable=*/false,
+                                        args->i4, args->i5, 1, k, n,
+                                        sizeof(float), &rhs_data));
+  uint8_t* out_data = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r6, /*is_mutable=*/true,
+                                        args->i7, args->i8, 1, m, n,
+                                        sizeof(float), &out_data));
+  if (!lhs_data || !rhs_data || !out_data) return iree_ok_status();
+  for (int32_t i = 0; i < m; ++i) {
+    const float* lhs_row = (const float*)lhs_data + i * args->i2;
+    float* IREE_RESTRICT out_row = (float*)out_data + i * args->i8;
+    for (int32_t r = 0; r < k; ++r) {
+      const float lhs_value = lhs_row[r];
+      const float* IREE_RESTRICT rhs_row =
+          (const float*)rhs_data + r * args->i5;
+      for (int32_t j = 0; j < n; ++j) {
+        out_row[j] += lhs_value * rhs_row[j];
+      }
+    }
+  }
   return iree_ok_status();
 }
 
@@ -0,0 +1,544 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/batcher.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/modules/hal/module.h"
+#include "iree/runtime/session.h"
+
+// Maximum rank of the buffer views that can be batched.
+#define IREE_RUNTIME_BATCHER_MAX_RANK 16
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_options_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT void iree_runtime_batcher_options_initialize(
+    iree_runtime_batcher_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->max_batch_size = 8;
+  out_options->max_delay_ns = 1000000;  // 1ms
+}
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batch_t
+//===----------------------------------------------------------------------===//
+
+// A single call queued within a batch.
+typedef struct iree_runtime_batch_call_t {
+  // Caller-owned input list; valid until the batch completes.
+  iree_vm_list_t* input_list;
+  // Caller-owned output list that receives the rows of each batched result.
+  iree_vm_list_t* output_list;
+  // Number of rows along the batch dimension provided by the call.
+  iree_hal_dim_t row_count;
+  // Result of the call populated when the batch completes.
+  iree_status_t status;
+} iree_runtime_batch_call_t;
+
+enum iree_runtime_batch_state_e {
+  // Calls may still join the batch.
+  IREE_RUNTIME_BATCH_STATE_OPEN = 0,
+  // The batch is full or has been replaced and is waiting to be invoked.
+  IREE_RUNTIME_BATCH_STATE_CLOSED = 1,
+  // The batch has been invoked and the status of each call is available.
+  IREE_RUNTIME_BATCH_STATE_COMPLETE = 2,
+};
+
+// A set of compatible calls that will be invoked together.
+// The first call to join the batch (the leader) performs the invocation.
+typedef struct iree_runtime_batch_t {
+  // One reference per call in the batch; the last call to leave frees it.
+  iree_atomic_ref_count_t ref_count;
+  // iree_runtime_batch_state_e; posted to |notification| on each change.
+  iree_atomic_int32_t state;
+  iree_notification_t notification;
+  // Time at which the leader stops waiting for more calls to join.
+  iree_time_t deadline_ns;
+  // Total number of calls in |calls|; only modified while the batch is open.
+  iree_host_size_t call_count;
+  iree_runtime_batch_call_t calls[];
+} iree_runtime_batch_t;
+
+static bool iree_runtime_batch_is_closed(void* arg) {
+  iree_runtime_batch_t* batch = (iree_runtime_batch_t*)arg;
+  return iree_atomic_load_int32(&batch->state, iree_memory_order_acquire) >=
+         IREE_RUNTIME_BATCH_STATE_CLOSED;
+}
+
+static bool iree_runtime_batch_is_complete(void* arg) {
+  iree_runtime_batch_t* batch = (iree_runtime_batch_t*)arg;
+  return iree_atomic_load_int32(&batch->state, iree_memory_order_acquire) ==
+         IREE_RUNTIME_BATCH_STATE_COMPLETE;
+}
+
+static void iree_runtime_batch_set_state(iree_runtime_batch_t* batch,
+                                         int32_t state) {
+  iree_atomic_store_int32(&batch->state, state, iree_memory_order_release);
+  iree_notification_post(&batch->notification, IREE_ALL_WAITERS);
+}
+
+struct iree_runtime_batcher_t {
+  iree_atomic_ref_count_t ref_count;
+
+  // Allocator used to allocate the batcher and its batches.
+  iree_allocator_t host_allocator;
+
+  // Session the function is invoked within; retained.
+  iree_runtime_session_t* session;
+  iree_vm_function_t function;
+  iree_host_size_t result_count;
+
+  iree_runtime_batcher_options_t options;
+
+  // Guards batch formation.
+  iree_slim_mutex_t mutex;
+  // Batch new calls will join, if any.
+  iree_runtime_batch_t* pending_batch IREE_GUARDED_BY(mutex);
+
+  // Serializes invocations as the session is thread-compatible.
+  iree_slim_mutex_t invoke_mutex;
+};
+
+//===----------------------------------------------------------------------===//
+// Batched I/O
+//===----------------------------------------------------------------------===//
+
+// Returns the size in bytes of a single row along the outermost dimension of
+// a buffer view with the given |shape|.
+static iree_device_size_t iree_runtime_batcher_row_length(
+    const iree_hal_buffer_view_t* buffer_view, const iree_hal_dim_t* shape,
+    iree_host_size_t shape_rank) {
+  iree_device_size_t row_length =
+      iree_hal_buffer_view_element_size(buffer_view);
+  for (iree_host_size_t i = 1; i < shape_rank; ++i) {
+    row_length *= shape[i];
+  }
+  return row_length;
+}
+
+// Verifies that |input_list| contains only buffer views with a matching
+// outermost dimension and returns that dimension in |out_row_count|.
+static iree_status_t iree_runtime_batcher_verify_inputs(
+    const iree_vm_list_t* input_list, iree_hal_dim_t* out_row_count) {
+  *out_row_count = 0;
+  iree_host_size_t input_count = iree_vm_list_size(input_list);
+  for (iree_host_size_t i = 0; i < input_count; ++i) {
+    iree_hal_buffer_view_t* buffer_view =
+        iree_vm_list_get_buffer_view_assign(input_list, i);
+    if (!buffer_view) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "batched input %zu must be a buffer view", i);
+    }
+    iree_host_size_t shape_rank = iree_hal_buffer_view_shape_rank(buffer_view);
+    if (shape_rank == 0 || shape_rank > IREE_RUNTIME_BATCHER_MAX_RANK) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "batched input %zu has rank %zu; expected [1, %d]", i, shape_rank,
+          IREE_RUNTIME_BATCHER_MAX_RANK);
+    }
+    iree_hal_dim_t row_count = iree_hal_buffer_view_shape_dim(buffer_view, 0);
+    if (i > 0 && row_count != *out_row_count) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "batched input %zu has %d rows but input 0 has %d", i, row_count,
+          *out_row_count);
+    }
+    *out_row_count = row_count;
+  }
+  return iree_ok_status();
+}
+
+// Returns true if the inputs in |lhs| and |rhs| differ only in their
+// outermost dimension.
+static bool iree_runtime_batcher_inputs_compatible(const iree_vm_list_t* lhs,
+                                                   const iree_vm_list_t* rhs) {
+  iree_host_size_t input_count = iree_vm_list_size(lhs);
+  if (input_count != iree_vm_list_size(rhs)) return false;
+  for (iree_host_size_t i = 0; i < input_count; ++i) {
+    iree_hal_buffer_view_t* lhs_view =
+        iree_vm_list_get_buffer_view_assign(lhs, i);
+    iree_hal_buffer_view_t* rhs_view =
+        iree_vm_list_get_buffer_view_assign(rhs, i);
+    iree_host_size_t shape_rank = iree_hal_buffer_view_shape_rank(lhs_view);
+    if (shape_rank != iree_hal_buffer_view_shape_rank(rhs_view) ||
+        iree_hal_buffer_view_element_type(lhs_view) !=
+            iree_hal_buffer_view_element_type(rhs_view) ||
+        iree_hal_buffer_view_encoding_type(lhs_view) !=
+            iree_hal_buffer_view_encoding_type(rhs_view)) {
+      return false;
+    }
+    const iree_hal_dim_t* lhs_dims = iree_hal_buffer_view_shape_dims(lhs_view);
+    const iree_hal_dim_t* rhs_dims = iree_hal_buffer_view_shape_dims(rhs_view);
+    for (iree_host_size_t j = 1; j < shape_rank; ++j) {
+      if (lhs_dims[j] != rhs_dims[j]) return false;
+    }
+  }
+  return true;
+}
+
+// Concatenates input |input_index| of every call in |batch| along the
+// outermost dimension into a new buffer view appended to |batch_input_list|.
+static iree_status_t iree_runtime_batcher_concat_input(
+    iree_runtime_batcher_t* batcher, iree_runtime_batch_t* batch,
+    iree_host_size_t input_index, iree_hal_dim_t total_row_count,
+    iree_vm_list_t* batch_input_list) {
+  iree_hal_buffer_view_t* first_view =
+      iree_vm_list_get_buffer_view_assign(batch->calls[0].input_list,
+                                          input_index);
+  iree_hal_dim_t shape[IREE_RUNTIME_BATCHER_MAX_RANK];
+  iree_host_size_t shape_rank = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_shape(
+      first_view, IREE_ARRAYSIZE(shape), shape, &shape_rank));
+  iree_device_size_t row_length =
+      iree_runtime_batcher_row_length(first_view, shape, shape_rank);
+
+  iree_hal_device_t* device = iree_runtime_session_device(batcher->session);
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+      iree_runtime_session_device_allocator(batcher->session),
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER,
+      (iree_host_size_t)(total_row_count * row_length),
+      iree_const_byte_span_empty(), &buffer));
+
+  // TODO(benvanik): batch the copies into a single transfer command buffer.
+  iree_status_t status = iree_ok_status();
+  iree_device_size_t offset = 0;
+  for (iree_host_size_t i = 0; i < batch->call_count; ++i) {
+    iree_device_size_t length = batch->calls[i].row_count * row_length;
+    if (length == 0) continue;
+    iree_hal_buffer_view_t* source_view = iree_vm_list_get_buffer_view_assign(
+        batch->calls[i].input_list, input_index);
+    status = iree_hal_device_transfer_range(
+        device,
+        iree_hal_make_device_transfer_buffer(
+            iree_hal_buffer_view_buffer(source_view)),
+        0, iree_hal_make_device_transfer_buffer(buffer), offset, length,
+        IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, iree_infinite_timeout());
+    if (!iree_status_is_ok(status)) break;
+    offset += length;
+  }
+
+  iree_hal_buffer_view_t* batch_view = NULL;
+  if (iree_status_is_ok(status)) {
+    shape[0] = total_row_count;
+    status = iree_hal_buffer_view_create(
+        buffer, shape, shape_rank,
+        iree_hal_buffer_view_element_type(first_view),
+        iree_hal_buffer_view_encoding_type(first_view),
+        batcher->host_allocator, &batch_view);
+  }
+  iree_hal_buffer_release(buffer);
+  if (iree_status_is_ok(status)) {
+    iree_vm_ref_t batch_view_ref = iree_hal_buffer_view_move_ref(batch_view);
+    status = iree_vm_list_push_ref_move(batch_input_list, &batch_view_ref);
+    if (!iree_status_is_ok(status)) iree_vm_ref_release(&batch_view_ref);
+  }
+  return status;
+}
+
+// Splits result |output_index| in |batch_output_list| along the outermost
+// dimension and appends the rows of each call in |batch| to its output list.
+static iree_status_t iree_runtime_batcher_split_output(
+    iree_runtime_batcher_t* batcher, iree_runtime_batch_t* batch,
+    const iree_vm_list_t* batch_output_list, iree_host_size_t output_index,
+    iree_hal_dim_t total_row_count) {
+  iree_hal_buffer_view_t* batch_view =
+      iree_vm_list_get_buffer_view_assign(batch_output_list, output_index);
+  if (!batch_view) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "batched result %zu must be a buffer view",
+                            output_index);
+  }
+  iree_hal_dim_t shape[IREE_RUNTIME_BATCHER_MAX_RANK];
+  iree_host_size_t shape_rank = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_shape(
+      batch_view, IREE_ARRAYSIZE(shape), shape, &shape_rank));
+  if (shape_rank == 0 || shape[0] != total_row_count) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "batched result %zu must have an outermost dimension of %d",
+        output_index, total_row_count);
+  }
+  iree_device_size_t row_length =
+      iree_runtime_batcher_row_length(batch_view, shape, shape_rank);
+
+  // Each call receives a view of its rows in the batched result; no copies are
+  // performed.
+  iree_hal_buffer_t* batch_buffer = iree_hal_buffer_view_buffer(batch_view);
+  iree_device_size_t offset = 0;
+  for (iree_host_size_t i = 0; i < batch->call_count; ++i) {
+    iree_runtime_batch_call_t* call = &batch->calls[i];
+    iree_device_size_t length = call->row_count * row_length;
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_hal_buffer_subspan(batch_buffer, offset, length, &buffer));
+    shape[0] = call->row_count;
+    iree_hal_buffer_view_t* view = NULL;
+    iree_status_t status = iree_hal_buffer_view_create(
+        buffer, shape, shape_rank,
+        iree_hal_buffer_view_element_type(batch_view),
+        iree_hal_buffer_view_encoding_type(batch_view), batcher->host_allocator,
+        &view);
+    iree_hal_buffer_release(buffer);
+    IREE_RETURN_IF_ERROR(status);
+    iree_vm_ref_t view_ref = iree_hal_buffer_view_move_ref(view);
+    status = iree_vm_list_push_ref_move(call->output_list, &view_ref);
+    if (!iree_status_is_ok(status)) {
+      iree_vm_ref_release(&view_ref);
+      return status;
+    }
+    offset += length;
+  }
+  return iree_ok_status();
+}
+
+// Invokes the batched function once for all calls in |batch|.
+static iree_status_t iree_runtime_batcher_invoke(
+    iree_runtime_batcher_t* batcher, iree_runtime_batch_t* batch) {
+  // Single calls need no concatenation and are passed through as-is.
+  if (batch->call_count == 1) {
+    return iree_runtime_session_call(batcher->session, &batcher->function,
+                                     batch->calls[0].input_list,
+                                     batch->calls[0].output_list);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)batch->call_count);
+
+  iree_hal_dim_t total_row_count = 0;
+  for (iree_host_size_t i = 0; i < batch->call_count; ++i) {
+    total_row_count += batch->calls[i].row_count;
+  }
+
+  iree_host_size_t input_count = iree_vm_list_size(batch->calls[0].input_list);
+  iree_vm_list_t* batch_input_list = NULL;
+  iree_vm_list_t* batch_output_list = NULL;
+  iree_status_t status =
+      iree_vm_list_create(/*element_type=*/NULL, input_count,
+                          batcher->host_allocator, &batch_input_list);
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_list_create(/*element_type=*/NULL, batcher->result_count,
+                                 batcher->host_allocator, &batch_output_list);
+  }
+  for (iree_host_size_t i = 0; i < input_count && iree_status_is_ok(status);
+       ++i) {
+    status = iree_runtime_batcher_concat_input(
+        batcher, batch, i, total_row_count, batch_input_list);
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_session_call(batcher->session, &batcher->function,
+                                       batch_input_list, batch_output_list);
+  }
+
+  iree_host_size_t output_count = iree_vm_list_size(batch_output_list);
+  for (iree_host_size_t i = 0; i < output_count && iree_status_is_ok(status);
+       ++i) {
+    status = iree_runtime_batcher_split_output(
+        batcher, batch, batch_output_list, i, total_row_count);
+  }
+
+  iree_vm_list_release(batch_input_list);
+  iree_vm_list_release(batch_output_list);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_create(
+    iree_runtime_session_t* session, iree_vm_function_t function,
+    const iree_runtime_batcher_options_t* options,
+    iree_allocator_t host_allocator, iree_runtime_batcher_t** out_batcher) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_ASSERT_ARGUMENT(out_batcher);
+  *out_batcher = NULL;
+  if (options->max_batch_size == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "max_batch_size must be at least 1");
+  }
+
+  iree_vm_function_signature_t signature =
+      iree_vm_function_signature(&function);
+  iree_string_view_t arguments;
+  iree_string_view_t results;
+  IREE_RETURN_IF_ERROR(iree_vm_function_call_get_cconv_fragments(
+      &signature, &arguments, &results));
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_runtime_batcher_t* batcher = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*batcher),
+                                (void**)&batcher));
+  memset(batcher, 0, sizeof(*batcher));
+  iree_atomic_ref_count_init(&batcher->ref_count);
+  batcher->host_allocator = host_allocator;
+  batcher->session = session;
+  iree_runtime_session_retain(session);
+  batcher->function = function;
+  batcher->result_count = results.size;
+  batcher->options = *options;
+  iree_slim_mutex_initialize(&batcher->mutex);
+  iree_slim_mutex_initialize(&batcher->invoke_mutex);
+
+  *out_batcher = batcher;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_runtime_batcher_destroy(iree_runtime_batcher_t* batcher) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT(!batcher->pending_batch);
+  iree_slim_mutex_deinitialize(&batcher->invoke_mutex);
+  iree_slim_mutex_deinitialize(&batcher->mutex);
+  iree_runtime_session_release(batcher->session);
+  iree_allocator_free(batcher->host_allocator, batcher);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_runtime_batcher_retain(
+    iree_runtime_batcher_t* batcher) {
+  if (batcher) {
+    iree_atomic_ref_count_inc(&batcher->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_runtime_batcher_release(
+    iree_runtime_batcher_t* batcher) {
+  if (batcher && iree_atomic_ref_count_dec(&batcher->ref_count) == 1) {
+    iree_runtime_batcher_destroy(batcher);
+  }
+}
+
+// Closes |batch| so that no more calls may join it and wakes its leader.
+static void iree_runtime_batcher_close_batch(iree_runtime_batcher_t* batcher,
+                                             iree_runtime_batch_t* batch) {
+  if (batcher->pending_batch == batch) batcher->pending_batch = NULL;
+  iree_runtime_batch_set_state(batch, IREE_RUNTIME_BATCH_STATE_CLOSED);
+}
+
+// Adds a call to the pending batch, starting a new batch as needed.
+// Returns the batch and the index of the call within it. The call with index 0
+// is the leader of the batch.
+static iree_status_t iree_runtime_batcher_join(
+    iree_runtime_batcher_t* batcher, iree_vm_list_t* input_list,
+    iree_vm_list_t* output_list, iree_hal_dim_t row_count,
+    iree_runtime_batch_t** out_batch, iree_host_size_t* out_call_index) {
+  iree_slim_mutex_lock(&batcher->mutex);
+
+  // Incompatible calls close the pending batch early rather than waiting for
+  // it to fill.
+  iree_runtime_batch_t* batch = batcher->pending_batch;
+  if (batch && !iree_runtime_batcher_inputs_compatible(
+                   batch->calls[0].input_list, input_list)) {
+    iree_runtime_batcher_close_batch(batcher, batch);
+    batch = NULL;
+  }
+
+  if (!batch) {
+    iree_status_t status = iree_allocator_malloc(
+        batcher->host_allocator,
+        sizeof(*batch) +
+            batcher->options.max_batch_size * sizeof(batch->calls[0]),
+        (void**)&batch);
+    if (!iree_status_is_ok(status)) {
+      iree_slim_mutex_unlock(&batcher->mutex);
+      return status;
+    }
+    iree_atomic_ref_count_init(&batch->ref_count);
+    iree_atomic_store_int32(&batch->state, IREE_RUNTIME_BATCH_STATE_OPEN,
+                            iree_memory_order_relaxed);
+    iree_notification_initialize(&batch->notification);
+    batch->deadline_ns =
+        iree_relative_timeout_to_deadline_ns(batcher->options.max_delay_ns);
+    batch->call_count = 0;
+    batcher->pending_batch = batch;
+  } else {
+    iree_atomic_ref_count_inc(&batch->ref_count);
+  }
+
+  iree_host_size_t call_index = batch->call_count++;
+  iree_runtime_batch_call_t* call = &batch->calls[call_index];
+  call->input_list = input_list;
+  call->output_list = output_list;
+  call->row_count = row_count;
+  call->status = iree_ok_status();
+  if (batch->call_count == batcher->options.max_batch_size) {
+    iree_runtime_batcher_close_batch(batcher, batch);
+  }
+
+  iree_slim_mutex_unlock(&batcher->mutex);
+  *out_batch = batch;
+  *out_call_index = call_index;
+  return iree_ok_status();
+}
+
+// Waits for |batch| to fill or time out and then invokes it on behalf of all
+// of the calls it contains.
+static void iree_runtime_batcher_lead(iree_runtime_batcher_t* batcher,
+                                      iree_runtime_batch_t* batch) {
+  iree_notification_await(&batch->notification, iree_runtime_batch_is_closed,
+                          batch, iree_make_deadline(batch->deadline_ns));
+  iree_slim_mutex_lock(&batcher->mutex);
+  iree_runtime_batcher_close_batch(batcher, batch);
+  iree_slim_mutex_unlock(&batcher->mutex);
+
+  iree_slim_mutex_lock(&batcher->invoke_mutex);
+  iree_status_t status = iree_runtime_batcher_invoke(batcher, batch);
+  iree_slim_mutex_unlock(&batcher->invoke_mutex);
+
+  // The leader takes the original status and the others receive copies.
+  batch->calls[0].status = status;
+  for (iree_host_size_t i = 1; i < batch->call_count; ++i) {
+    batch->calls[i].status = iree_status_clone(status);
+  }
+  iree_runtime_batch_set_state(batch, IREE_RUNTIME_BATCH_STATE_COMPLETE);
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_call(
+    iree_runtime_batcher_t* batcher, iree_vm_list_t* input_list,
+    iree_vm_list_t* output_list) {
+  IREE_ASSERT_ARGUMENT(batcher);
+  IREE_ASSERT_ARGUMENT(input_list);
+  IREE_ASSERT_ARGUMENT(output_list);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_dim_t row_count = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_runtime_batcher_verify_inputs(input_list, &row_count));
+
+  iree_runtime_batch_t* batch = NULL;
+  iree_host_size_t call_index = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_runtime_batcher_join(batcher, input_list, output_list,
+                                    row_count, &batch, &call_index));
+
+  if (call_index == 0) {
+    iree_runtime_batcher_lead(batcher, batch);
+  } else {
+    iree_notification_await(&batch->notification,
+                            iree_runtime_batch_is_complete, batch,
+                            iree_infinite_timeout());
+  }
+  iree_status_t status = batch->calls[call_index].status;
+
+  if (iree_atomic_ref_count_dec(&batch->ref_count) == 1) {
+    iree_notification_deinitialize(&batch->notification);
+    iree_allocator_free(batcher->host_allocator, batch);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
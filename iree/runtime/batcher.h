@@ -0,0 +1,95 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_RUNTIME_BATCHER_H_
+#define IREE_RUNTIME_BATCHER_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+typedef struct iree_runtime_session_t iree_runtime_session_t;
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_options_t
+//===----------------------------------------------------------------------===//
+
+// Options used to configure batcher creation.
+typedef struct iree_runtime_batcher_options_t {
+  // Maximum number of calls that will be combined into a single invocation.
+  // Must be at least 1; a value of 1 disables batching.
+  iree_host_size_t max_batch_size;
+
+  // Maximum amount of time the first call in a batch will wait for additional
+  // calls to arrive before the batch is invoked. Batches are invoked
+  // immediately once they reach |max_batch_size|.
+  iree_duration_t max_delay_ns;
+} iree_runtime_batcher_options_t;
+
+// Initializes |out_options| to its default values.
+IREE_API_EXPORT void iree_runtime_batcher_options_initialize(
+    iree_runtime_batcher_options_t* out_options);
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_t
+//===----------------------------------------------------------------------===//
+
+// Combines concurrent calls to a single function into batched invocations.
+//
+// The function must take and return only buffer views where the outermost
+// dimension is a dynamic batch dimension. Calls made through the batcher are
+// queued and once either the batch is full or the oldest call has waited
+// |max_delay_ns| the inputs of all queued calls are concatenated along the
+// batch dimension, the function is invoked once, and the outputs are split
+// back into each call's output list as subspans of the batched results. Any
+// number of rows may be provided by each call (usually 1) so long as all of the
+// other dimensions, element types, and encodings match the rest of the batch;
+// calls that are incompatible with the pending batch start a new one.
+//
+// No threads are created: the first call in each batch waits for the batch to
+// fill and then performs the invocation on behalf of all of the calls in it.
+// Invocations are serialized on the session.
+//
+// Thread-safe; calls may be made concurrently from any number of threads so
+// long as the session is not used directly while the batcher is in use.
+typedef struct iree_runtime_batcher_t iree_runtime_batcher_t;
+
+// Creates a new batcher for calls to |function| within |session|.
+// The batcher will retain the session for its lifetime.
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_create(
+    iree_runtime_session_t* session, iree_vm_function_t function,
+    const iree_runtime_batcher_options_t* options,
+    iree_allocator_t host_allocator, iree_runtime_batcher_t** out_batcher);
+
+// Retains the given |batcher| for the caller.
+IREE_API_EXPORT void iree_runtime_batcher_retain(
+    iree_runtime_batcher_t* batcher);
+
+// Releases the given |batcher| from the caller.
+// No calls may be in flight when the last reference is released.
+IREE_API_EXPORT void iree_runtime_batcher_release(
+    iree_runtime_batcher_t* batcher);
+
+// Synchronously calls the batched function with the buffer views in
+// |input_list| and appends the corresponding rows of each result to
+// |output_list|. Blocks until the batch containing the call has been invoked.
+// If the batched invocation fails all calls within the batch receive the
+// failure.
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_call(
+    iree_runtime_batcher_t* batcher, iree_vm_list_t* input_list,
+    iree_vm_list_t* output_list);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_RUNTIME_BATCHER_H_
@@ -10,6 +10,9 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+#include "iree/base/tracing.h"
 #include "iree/modules/hal/module.h"
 #include "iree/runtime/session.h"
 
@@ -97,6 +100,198 @@ IREE_API_EXPORT iree_status_t iree_runtime_call_invoke(
                                    call->outputs);
 }
 
+//===----------------------------------------------------------------------===//
+// iree_runtime_call_queue_t
+//===----------------------------------------------------------------------===//
+
+// A call submitted to a queue awaiting execution.
+typedef struct iree_runtime_call_queue_entry_t {
+  struct iree_runtime_call_queue_entry_t* next;
+  iree_runtime_call_t* call;
+  iree_runtime_call_flags_t flags;
+  iree_runtime_call_completion_callback_t callback;
+  // Semaphore payload signaled when the call completes.
+  uint64_t payload;
+} iree_runtime_call_queue_entry_t;
+
+struct iree_runtime_call_queue_t {
+  iree_allocator_t host_allocator;
+  iree_runtime_session_t* session;
+
+  // Timeline advanced by one as each call completes.
+  iree_hal_semaphore_t* semaphore;
+
+  // Thread executing calls; joined on release.
+  iree_thread_t* thread;
+
+  // Guards the pending call list.
+  iree_slim_mutex_t mutex;
+  // Posted when a call is submitted or the thread is asked to exit.
+  iree_notification_t pending_notification;
+  // FIFO of submitted calls not yet executed.
+  iree_runtime_call_queue_entry_t* pending_head IREE_GUARDED_BY(mutex);
+  iree_runtime_call_queue_entry_t* pending_tail IREE_GUARDED_BY(mutex);
+  // Payload assigned to the most recently submitted call.
+  uint64_t submitted_payload IREE_GUARDED_BY(mutex);
+  // Set when the queue is being released; the thread drains and exits.
+  bool exit_requested IREE_GUARDED_BY(mutex);
+};
+
+static bool iree_runtime_call_queue_has_work(void* arg) {
+  iree_runtime_call_queue_t* queue = (iree_runtime_call_queue_t*)arg;
+  iree_slim_mutex_lock(&queue->mutex);
+  bool has_work = queue->pending_head != NULL || queue->exit_requested;
+  iree_slim_mutex_unlock(&queue->mutex);
+  return has_work;
+}
+
+static int iree_runtime_call_queue_main(void* arg) {
+  iree_runtime_call_queue_t* queue = (iree_runtime_call_queue_t*)arg;
+  for (;;) {
+    iree_slim_mutex_lock(&queue->mutex);
+    iree_runtime_call_queue_entry_t* entry = queue->pending_head;
+    if (entry) {
+      queue->pending_head = entry->next;
+      if (!queue->pending_head) queue->pending_tail = NULL;
+    }
+    bool exit_requested = queue->exit_requested;
+    iree_slim_mutex_unlock(&queue->mutex);
+
+    if (!entry) {
+      // Pending calls are drained before exiting.
+      if (exit_requested) break;
+      iree_notification_await(&queue->pending_notification,
+                              iree_runtime_call_queue_has_work, queue,
+                              iree_infinite_timeout());
+      continue;
+    }
+
+    IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_runtime_call_queue_execute");
+    iree_status_t status = iree_runtime_call_invoke(entry->call, entry->flags);
+    if (entry->callback.fn) {
+      entry->callback.fn(entry->callback.user_data, entry->call, status);
+    } else {
+      iree_status_ignore(status);
+    }
+    iree_status_ignore(
+        iree_hal_semaphore_signal(queue->semaphore, entry->payload));
+    iree_allocator_free(queue->host_allocator, entry);
+    IREE_TRACE_ZONE_END(z0);
+  }
+  return 0;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_call_queue_create(
+    iree_runtime_session_t* session, iree_allocator_t host_allocator,
+    iree_runtime_call_queue_t** out_queue) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(out_queue);
+  *out_queue = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_runtime_call_queue_t* queue = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(host_allocator, sizeof(*queue), (void**)&queue));
+  memset(queue, 0, sizeof(*queue));
+  queue->host_allocator = host_allocator;
+  queue->session = session;
+  iree_runtime_session_retain(session);
+  iree_slim_mutex_initialize(&queue->mutex);
+  iree_notification_initialize(&queue->pending_notification);
+
+  iree_status_t status = iree_hal_semaphore_create(
+      iree_runtime_session_device(session), 0ull, &queue->semaphore);
+  if (iree_status_is_ok(status)) {
+    iree_thread_create_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.name = iree_make_cstring_view("iree-call-queue");
+    status = iree_thread_create(iree_runtime_call_queue_main, queue, params,
+                                host_allocator, &queue->thread);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_queue = queue;
+  } else {
+    iree_runtime_call_queue_release(queue);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT void iree_runtime_call_queue_release(
+    iree_runtime_call_queue_t* queue) {
+  if (!queue) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Ask the thread to exit once it has drained the queue and wait for it.
+  iree_slim_mutex_lock(&queue->mutex);
+  queue->exit_requested = true;
+  iree_slim_mutex_unlock(&queue->mutex);
+  iree_notification_post(&queue->pending_notification, IREE_ALL_WAITERS);
+  iree_thread_release(queue->thread);
+
+  iree_hal_semaphore_release(queue->semaphore);
+  iree_notification_deinitialize(&queue->pending_notification);
+  iree_slim_mutex_deinitialize(&queue->mutex);
+  iree_runtime_session_release(queue->session);
+  iree_allocator_free(queue->host_allocator, queue);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT iree_hal_semaphore_t* iree_runtime_call_queue_semaphore(
+    const iree_runtime_call_queue_t* queue) {
+  IREE_ASSERT_ARGUMENT(queue);
+  return queue->semaphore;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_call_queue_wait_idle(
+    iree_runtime_call_queue_t* queue, iree_timeout_t timeout) {
+  IREE_ASSERT_ARGUMENT(queue);
+  iree_slim_mutex_lock(&queue->mutex);
+  uint64_t payload = queue->submitted_payload;
+  iree_slim_mutex_unlock(&queue->mutex);
+  return iree_hal_semaphore_wait(queue->semaphore, payload, timeout);
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_call_invoke_async(
+    iree_runtime_call_t* call, iree_runtime_call_flags_t flags,
+    iree_runtime_call_queue_t* queue,
+    iree_runtime_call_completion_callback_t callback, uint64_t* out_payload) {
+  IREE_ASSERT_ARGUMENT(call);
+  IREE_ASSERT_ARGUMENT(queue);
+  if (out_payload) *out_payload = 0;
+  if (call->session != queue->session) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "call and queue sessions must match");
+  }
+
+  iree_runtime_call_queue_entry_t* entry = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      queue->host_allocator, sizeof(*entry), (void**)&entry));
+  entry->next = NULL;
+  entry->call = call;
+  entry->flags = flags;
+  entry->callback = callback;
+
+  // The entry may be executed and freed as soon as the lock is released.
+  iree_slim_mutex_lock(&queue->mutex);
+  uint64_t payload = ++queue->submitted_payload;
+  entry->payload = payload;
+  if (queue->pending_tail) {
+    queue->pending_tail->next = entry;
+  } else {
+    queue->pending_head = entry;
+  }
+  queue->pending_tail = entry;
+  iree_slim_mutex_unlock(&queue->mutex);
+  iree_notification_post(&queue->pending_notification, IREE_ALL_WAITERS);
+
+  if (out_payload) *out_payload = payload;
+  return iree_ok_status();
+}
+
 //===----------------------------------------------------------------------===//
 // Helpers for defining call I/O
 //===----------------------------------------------------------------------===//
@@ -111,6 +306,16 @@ IREE_API_EXPORT iree_status_t iree_runtime_call_inputs_push_back_buffer_view(
   return iree_vm_list_push_ref_retain(call->inputs, &value);
 }
 
+IREE_API_EXPORT iree_status_t iree_runtime_call_inputs_push_back_buffer(
+    iree_runtime_call_t* call, iree_hal_buffer_t* buffer) {
+  IREE_ASSERT_ARGUMENT(call);
+  IREE_ASSERT_ARGUMENT(buffer);
+  iree_vm_ref_t value = {0};
+  IREE_RETURN_IF_ERROR(
+      iree_vm_ref_wrap_assign(buffer, iree_hal_buffer_type_id(), &value));
+  return iree_vm_list_push_ref_retain(call->inputs, &value);
+}
+
 // Pops a buffer view from the front of the call outputs list.
 // Ownership of the buffer view transfers to the caller.
 IREE_API_EXPORT iree_status_t iree_runtime_call_outputs_pop_front_buffer_view(
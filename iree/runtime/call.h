@@ -92,6 +92,71 @@ IREE_API_EXPORT iree_vm_list_t* iree_runtime_call_outputs(
 IREE_API_EXPORT iree_status_t iree_runtime_call_invoke(
     iree_runtime_call_t* call, iree_runtime_call_flags_t flags);
 
+//===----------------------------------------------------------------------===//
+// iree_runtime_call_queue_t
+//===----------------------------------------------------------------------===//
+
+// Callback issued when an asynchronous call completes with the final |status|
+// of the invocation. Ownership of |status| transfers to the callback.
+// Callbacks are issued from the queue thread in submission order.
+typedef struct iree_runtime_call_completion_callback_t {
+  void(IREE_API_PTR* fn)(void* user_data, iree_runtime_call_t* call,
+                         iree_status_t status);
+  void* user_data;
+} iree_runtime_call_completion_callback_t;
+
+// Returns a no-op completion callback that ignores the call status.
+static inline iree_runtime_call_completion_callback_t
+iree_runtime_call_completion_callback_null(void) {
+  iree_runtime_call_completion_callback_t callback = {NULL, NULL};
+  return callback;
+}
+
+// A FIFO queue of calls executed asynchronously within a session.
+//
+// Calls submitted to the queue are invoked in order on a dedicated thread
+// while the submitting thread continues on to prepare the next request,
+// allowing a single client thread to pipeline preprocessing, inference, and
+// postprocessing. Each submission is assigned a payload of the queue timeline
+// semaphore which is signaled once the call has completed (after its
+// completion callback, if any, has returned).
+//
+// The session must not be used directly while calls are pending on the queue.
+// Thread-safe; calls may be submitted from any thread.
+typedef struct iree_runtime_call_queue_t iree_runtime_call_queue_t;
+
+// Creates a call queue executing calls within |session|.
+// The queue will retain the session for its lifetime.
+IREE_API_EXPORT iree_status_t iree_runtime_call_queue_create(
+    iree_runtime_session_t* session, iree_allocator_t host_allocator,
+    iree_runtime_call_queue_t** out_queue);
+
+// Releases |queue| after waiting for all pending calls to complete.
+IREE_API_EXPORT void iree_runtime_call_queue_release(
+    iree_runtime_call_queue_t* queue);
+
+// Returns the timeline semaphore signaled as calls on |queue| complete.
+// The semaphore remains valid for the lifetime of the queue.
+IREE_API_EXPORT iree_hal_semaphore_t* iree_runtime_call_queue_semaphore(
+    const iree_runtime_call_queue_t* queue);
+
+// Blocks until all calls submitted to |queue| have completed or |timeout| is
+// reached.
+IREE_API_EXPORT iree_status_t iree_runtime_call_queue_wait_idle(
+    iree_runtime_call_queue_t* queue, iree_timeout_t timeout);
+
+// Asynchronously invokes the call on |queue| and returns immediately.
+// |out_payload| (if provided) receives the payload of the queue semaphore that
+// will be signaled once the call has completed. |callback| receives the status
+// of the invocation; the status is dropped if no callback is provided.
+//
+// The call and its input and output lists must not be modified until the call
+// has completed. The call must have been initialized on the queue session.
+IREE_API_EXPORT iree_status_t iree_runtime_call_invoke_async(
+    iree_runtime_call_t* call, iree_runtime_call_flags_t flags,
+    iree_runtime_call_queue_t* queue,
+    iree_runtime_call_completion_callback_t callback, uint64_t* out_payload);
+
 //===----------------------------------------------------------------------===//
 // Helpers for defining call I/O
 //===----------------------------------------------------------------------===//
@@ -106,6 +171,20 @@ IREE_API_EXPORT iree_status_t iree_runtime_call_invoke(
 IREE_API_EXPORT iree_status_t iree_runtime_call_inputs_push_back_buffer_view(
     iree_runtime_call_t* call, iree_hal_buffer_view_t* buffer_view);
 
+// Pushes |buffer| to the call inputs list.
+// The value will be retained by the list.
+//
+// Functions compiled with output storage arguments (`iree.abi.output` on a
+// !hal.buffer argument or `iree.abi.output_storage` on the function) take the
+// storage for their results as buffer inputs: the results are written into
+// the provided buffers and the output buffer views reference them. Binding
+// the same preallocated buffers on every call avoids allocating result
+// storage in steady state and lets results land directly in caller-owned
+// memory. Callers must not reuse a storage buffer until they are done with
+// the outputs of the call it was bound to.
+IREE_API_EXPORT iree_status_t iree_runtime_call_inputs_push_back_buffer(
+    iree_runtime_call_t* call, iree_hal_buffer_t* buffer);
+
 // Pops a buffer view from the front of the call outputs list.
 // Ownership of the buffer view transfers to the caller.
 IREE_API_EXPORT iree_status_t iree_runtime_call_outputs_pop_front_buffer_view(
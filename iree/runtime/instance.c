@@ -10,10 +10,12 @@
 #include <string.h>
 
 #include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/hal/drivers/init.h"
 #include "iree/modules/hal/module.h"
+#include "iree/runtime/session.h"
 #include "iree/vm/api.h"
 
 //===----------------------------------------------------------------------===//
@@ -53,6 +55,14 @@ struct iree_runtime_instance_t {
   // can find the same devices. This may mean a new HAL type like
   // iree_hal_device_pool_t to prevent too much coupling and make weak
   // references easier.
+
+  // Guards the session list.
+  iree_slim_mutex_t mutex;
+  // Live sessions created within the instance; unretained as sessions
+  // unregister themselves when destroyed.
+  iree_host_size_t session_count IREE_GUARDED_BY(mutex);
+  iree_host_size_t session_capacity IREE_GUARDED_BY(mutex);
+  iree_runtime_session_t** sessions IREE_GUARDED_BY(mutex);
 };
 
 IREE_API_EXPORT iree_status_t iree_runtime_instance_create(
@@ -84,6 +94,7 @@ IREE_API_EXPORT iree_status_t iree_runtime_instance_create(
                                 (void**)&instance));
   instance->host_allocator = host_allocator;
   iree_atomic_ref_count_init(&instance->ref_count);
+  iree_slim_mutex_initialize(&instance->mutex);
 
   instance->driver_registry = options->driver_registry;
   // TODO(benvanik): driver registry ref counting.
@@ -97,6 +108,10 @@ static void iree_runtime_instance_destroy(iree_runtime_instance_t* instance) {
   IREE_ASSERT_ARGUMENT(instance);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Sessions retain the instance and all must have been destroyed by now.
+  IREE_ASSERT_EQ(instance->session_count, 0);
+  iree_allocator_free(instance->host_allocator, instance->sessions);
+  iree_slim_mutex_deinitialize(&instance->mutex);
   iree_allocator_free(instance->host_allocator, instance);
 
   IREE_TRACE_ZONE_END(z0);
@@ -164,3 +179,82 @@ IREE_API_EXPORT iree_status_t iree_runtime_instance_try_create_default_device(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+// Trims |device| based on |level|.
+static iree_status_t iree_runtime_trim_device(iree_hal_device_t* device,
+                                              iree_runtime_trim_level_t level) {
+  if (level == IREE_RUNTIME_TRIM_LEVEL_CRITICAL) {
+    return iree_hal_device_trim(device);
+  }
+  return iree_hal_allocator_trim(iree_hal_device_allocator(device));
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_instance_trim(
+    iree_runtime_instance_t* instance, iree_runtime_trim_level_t level) {
+  IREE_ASSERT_ARGUMENT(instance);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The lock is held while trimming so that sessions (and the devices they
+  // retain) cannot be destroyed out from under us. Every device is trimmed even
+  // if some fail so that as much memory as possible is released.
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&instance->mutex);
+  for (iree_host_size_t i = 0; i < instance->session_count; ++i) {
+    iree_hal_device_t* device =
+        iree_runtime_session_device(instance->sessions[i]);
+
+    // Sessions commonly share devices and each only needs trimming once.
+    bool is_duplicate = false;
+    for (iree_host_size_t j = 0; j < i && !is_duplicate; ++j) {
+      is_duplicate = iree_runtime_session_device(instance->sessions[j]) ==
+                     device;
+    }
+    if (is_duplicate) continue;
+
+    iree_status_t device_status = iree_runtime_trim_device(device, level);
+    if (iree_status_is_ok(status)) {
+      status = device_status;
+    } else {
+      iree_status_ignore(device_status);
+    }
+  }
+  iree_slim_mutex_unlock(&instance->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_instance_register_session(
+    iree_runtime_instance_t* instance, iree_runtime_session_t* session) {
+  IREE_ASSERT_ARGUMENT(instance);
+  IREE_ASSERT_ARGUMENT(session);
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&instance->mutex);
+  if (instance->session_count == instance->session_capacity) {
+    iree_host_size_t new_capacity = iree_max(8, instance->session_capacity * 2);
+    status = iree_allocator_realloc(
+        instance->host_allocator, new_capacity * sizeof(instance->sessions[0]),
+        (void**)&instance->sessions);
+    if (iree_status_is_ok(status)) {
+      instance->session_capacity = new_capacity;
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    instance->sessions[instance->session_count++] = session;
+  }
+  iree_slim_mutex_unlock(&instance->mutex);
+  return status;
+}
+
+IREE_API_EXPORT void iree_runtime_instance_unregister_session(
+    iree_runtime_instance_t* instance, iree_runtime_session_t* session) {
+  IREE_ASSERT_ARGUMENT(instance);
+  iree_slim_mutex_lock(&instance->mutex);
+  for (iree_host_size_t i = 0; i < instance->session_count; ++i) {
+    if (instance->sessions[i] == session) {
+      instance->sessions[i] = instance->sessions[--instance->session_count];
+      break;
+    }
+  }
+  iree_slim_mutex_unlock(&instance->mutex);
+}
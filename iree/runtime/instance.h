@@ -79,6 +79,21 @@ IREE_API_EXPORT void iree_runtime_instance_options_use_all_available_drivers(
 // iree_runtime_instance_t
 //===----------------------------------------------------------------------===//
 
+// Controls how aggressively iree_runtime_instance_trim releases memory.
+typedef enum iree_runtime_trim_level_e {
+  // Releases cached allocations that went unused since the previous trim while
+  // keeping the rest of the working set, such as when the hosting application
+  // moves into the background. Trims the device allocators.
+  IREE_RUNTIME_TRIM_LEVEL_MODERATE = 0,
+  // Releases all possible memory even if expensive to rematerialize, such as
+  // when the OS is about to terminate the process for using too much memory.
+  // Trims the devices including their allocators, task executors, and arena
+  // block pools.
+  IREE_RUNTIME_TRIM_LEVEL_CRITICAL = 1,
+} iree_runtime_trim_level_t;
+
+typedef struct iree_runtime_session_t iree_runtime_session_t;
+
 // Creates a new instance with the given |options|.
 // Instances should be shared with as many sessions in an application as is
 // reasonable to ensure that resources are tracked properly and threads are
@@ -115,6 +130,27 @@ IREE_API_EXPORT iree_status_t iree_runtime_instance_try_create_default_device(
     iree_runtime_instance_t* instance, iree_string_view_t driver_name,
     iree_hal_device_t** out_device);
 
+// Releases cached and pooled memory held by the devices of all live sessions
+// in |instance| based on |level|. Devices shared by multiple sessions are only
+// trimmed once.
+//
+// Intended to be called from OS memory pressure callbacks (such as Android's
+// onTrimMemory) and may be called from any thread concurrently with calls
+// made on sessions.
+IREE_API_EXPORT iree_status_t iree_runtime_instance_trim(
+    iree_runtime_instance_t* instance, iree_runtime_trim_level_t level);
+
+// Registers |session| with |instance| so that it is trimmed by
+// iree_runtime_instance_trim. Called by iree_runtime_session_t; applications
+// should not need to call this directly.
+IREE_API_EXPORT iree_status_t iree_runtime_instance_register_session(
+    iree_runtime_instance_t* instance, iree_runtime_session_t* session);
+
+// Unregisters |session| from |instance|. No-op if the session was never
+// registered.
+IREE_API_EXPORT void iree_runtime_instance_unregister_session(
+    iree_runtime_instance_t* instance, iree_runtime_session_t* session);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
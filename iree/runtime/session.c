@@ -11,10 +11,12 @@
 
 #include "iree/base/internal/atomics.h"
 #include "iree/base/internal/file_io.h"
+#include "iree/base/internal/threading.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/modules/hal/module.h"
 #include "iree/runtime/instance.h"
+#include "iree/runtime/trace_recorder.h"
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode_module.h"
 
@@ -61,15 +63,38 @@ struct iree_runtime_session_t {
   // lookup. An application directly using the API may never need this, or could
   // perform VM calls into HAL module exports to gain more portability.
   iree_vm_module_state_t* hal_module_state;
+
+  // The HAL module within the context; unretained as the context owns it.
+  iree_vm_module_t* hal_module;
+
+  // Optional recorder receiving all module loads and calls; shared with any
+  // sessions forked from this one.
+  iree_runtime_trace_recorder_t* trace_recorder;
+
+  // Thread preparing lazy executables while a prewarm is in progress and the
+  // status it completed with. |prewarm_status| is only valid once the thread
+  // has been joined.
+  iree_thread_t* prewarm_thread;
+  iree_status_t prewarm_status;
 };
 
 IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
     iree_runtime_instance_t* instance,
     const iree_runtime_session_options_t* options, iree_hal_device_t* device,
     iree_allocator_t host_allocator, iree_runtime_session_t** out_session) {
+  IREE_ASSERT_ARGUMENT(device);
+  return iree_runtime_session_create_with_devices(
+      instance, options, 1, &device, host_allocator, out_session);
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_devices(
+    iree_runtime_instance_t* instance,
+    const iree_runtime_session_options_t* options,
+    iree_host_size_t device_count, iree_hal_device_t* const* devices,
+    iree_allocator_t host_allocator, iree_runtime_session_t** out_session) {
   IREE_ASSERT_ARGUMENT(instance);
   IREE_ASSERT_ARGUMENT(options);
-  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(devices);
   IREE_ASSERT_ARGUMENT(out_session);
   *out_session = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -79,6 +104,7 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_allocator_malloc(host_allocator, sizeof(*session),
                                 (void**)&session));
+  memset(session, 0, sizeof(*session));
   session->host_allocator = host_allocator;
   iree_atomic_ref_count_init(&session->ref_count);
 
@@ -90,11 +116,21 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
       /*instance=*/NULL, options->context_flags, host_allocator,
       &session->context);
 
+  if (iree_status_is_ok(status) &&
+      !iree_string_view_is_empty(options->trace_path)) {
+    status = iree_runtime_trace_recorder_create(
+        options->trace_path, options->trace_flags,
+        options->trace_contents_limit, host_allocator,
+        &session->trace_recorder);
+  }
+
   // Add the HAL module; it is always required when using the runtime API.
   // Lower-level usage of the VM can avoid the HAL if it's not required.
   iree_vm_module_t* hal_module = NULL;
   if (iree_status_is_ok(status)) {
-    status = iree_hal_module_create(device, host_allocator, &hal_module);
+    status = iree_hal_module_create_multi(device_count, devices,
+                                          options->hal_module_flags,
+                                          host_allocator, &hal_module);
   }
   if (iree_status_is_ok(status)) {
     status = iree_vm_context_register_modules(session->context, &hal_module, 1);
@@ -103,8 +139,17 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
     status = iree_vm_context_resolve_module_state(session->context, hal_module,
                                                   &session->hal_module_state);
   }
+  if (iree_status_is_ok(status) && session->trace_recorder) {
+    status = iree_runtime_trace_recorder_record_module(
+        session->trace_recorder, hal_module, iree_const_byte_span_empty());
+  }
+  session->hal_module = hal_module;
   iree_vm_module_release(hal_module);
 
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_instance_register_session(instance, session);
+  }
+
   if (iree_status_is_ok(status)) {
     *out_session = session;
   } else {
@@ -114,11 +159,61 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
   return status;
 }
 
+IREE_API_EXPORT iree_status_t iree_runtime_session_fork(
+    const iree_runtime_session_t* session, iree_allocator_t host_allocator,
+    iree_runtime_session_t** out_session) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(out_session);
+  *out_session = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_runtime_session_t* fork = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(host_allocator, sizeof(*fork), (void**)&fork));
+  memset(fork, 0, sizeof(*fork));
+  fork->host_allocator = host_allocator;
+  iree_atomic_ref_count_init(&fork->ref_count);
+
+  fork->instance = session->instance;
+  iree_runtime_instance_retain(fork->instance);
+
+  // Forks record into the same trace as the modules are already loaded.
+  fork->trace_recorder = session->trace_recorder;
+  iree_runtime_trace_recorder_retain(fork->trace_recorder);
+
+  // The forked context shares the modules (and thus the HAL module) with the
+  // parent but has its own HAL module state.
+  fork->hal_module = session->hal_module;
+  iree_status_t status =
+      iree_vm_context_fork(session->context, host_allocator, &fork->context);
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_context_resolve_module_state(
+        fork->context, fork->hal_module, &fork->hal_module_state);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_instance_register_session(fork->instance, fork);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_session = fork;
+  } else {
+    iree_runtime_session_release(fork);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static void iree_runtime_session_destroy(iree_runtime_session_t* session) {
   IREE_ASSERT_ARGUMENT(session);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // The prewarm thread uses the HAL module state owned by the context.
+  iree_status_ignore(iree_runtime_session_end_prewarm(session));
+
+  iree_runtime_instance_unregister_session(session->instance, session);
   iree_vm_context_release(session->context);
+  iree_runtime_trace_recorder_release(session->trace_recorder);
   iree_runtime_instance_release(session->instance);
 
   iree_allocator_free(session->host_allocator, session);
@@ -181,21 +276,97 @@ iree_runtime_session_trim(iree_runtime_session_t* session) {
   return status;
 }
 
-IREE_API_EXPORT iree_status_t iree_runtime_session_append_module(
-    iree_runtime_session_t* session, iree_vm_module_t* module) {
+IREE_API_EXPORT iree_status_t
+iree_runtime_session_freeze(iree_runtime_session_t* session) {
   IREE_ASSERT_ARGUMENT(session);
-  IREE_ASSERT_ARGUMENT(module);
+  return iree_vm_context_freeze(iree_runtime_session_context(session));
+}
+
+// Registers |module| with the session context and records the load if the
+// session is being traced. |flatbuffer_data| is the bytecode of the module, if
+// any, and is written to the trace so that it can be reloaded during replay.
+static iree_status_t iree_runtime_session_register_module(
+    iree_runtime_session_t* session, iree_vm_module_t* module,
+    iree_const_byte_span_t flatbuffer_data) {
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_TEXT(z0, iree_vm_module_name(module).data,
                               iree_vm_module_name(module).size);
 
   iree_status_t status = iree_vm_context_register_modules(
       iree_runtime_session_context(session), &module, 1);
+  if (iree_status_is_ok(status) && session->trace_recorder) {
+    status = iree_runtime_trace_recorder_record_module(
+        session->trace_recorder, module, flatbuffer_data);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static int iree_runtime_session_prewarm_main(void* arg) {
+  iree_runtime_session_t* session = (iree_runtime_session_t*)arg;
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_runtime_session_prewarm");
+  session->prewarm_status =
+      iree_hal_module_state_prepare_executables(session->hal_module_state);
+  IREE_TRACE_ZONE_END(z0);
+  return 0;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_runtime_session_begin_prewarm(iree_runtime_session_t* session) {
+  IREE_ASSERT_ARGUMENT(session);
+  if (session->prewarm_thread) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "session prewarm already in progress");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  session->prewarm_status = iree_ok_status();
+  iree_thread_create_params_t params;
+  memset(&params, 0, sizeof(params));
+  params.name = iree_make_cstring_view("iree-prewarm");
+  iree_status_t status =
+      iree_thread_create(iree_runtime_session_prewarm_main, session, params,
+                         session->host_allocator, &session->prewarm_thread);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
 
+IREE_API_EXPORT iree_status_t
+iree_runtime_session_end_prewarm(iree_runtime_session_t* session) {
+  IREE_ASSERT_ARGUMENT(session);
+  if (!session->prewarm_thread) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  // Releasing the thread joins it.
+  iree_thread_release(session->prewarm_thread);
+  session->prewarm_thread = NULL;
+  iree_status_t status = session->prewarm_status;
+  session->prewarm_status = iree_ok_status();
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
 
+IREE_API_EXPORT iree_status_t
+iree_runtime_session_warmup(iree_runtime_session_t* session) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  // A prewarm in progress is joined first as the warm-up prepares the same
+  // executables and its result would otherwise be reported later.
+  iree_status_t status = iree_runtime_session_end_prewarm(session);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_module_state_warmup(session->hal_module_state);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_session_append_module(
+    iree_runtime_session_t* session, iree_vm_module_t* module) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(module);
+  return iree_runtime_session_register_module(session, module,
+                                              iree_const_byte_span_empty());
+}
+
 IREE_API_EXPORT iree_status_t
 iree_runtime_session_append_bytecode_module_from_memory(
     iree_runtime_session_t* session, iree_const_byte_span_t flatbuffer_data,
@@ -208,7 +379,8 @@ iree_runtime_session_append_bytecode_module_from_memory(
       flatbuffer_data, flatbuffer_allocator,
       iree_runtime_session_host_allocator(session), &module);
   if (iree_status_is_ok(status)) {
-    status = iree_runtime_session_append_module(session, module);
+    status =
+        iree_runtime_session_register_module(session, module, flatbuffer_data);
   }
   iree_vm_module_release(module);
 
@@ -223,24 +395,28 @@ iree_runtime_session_append_bytecode_module_from_file(
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_TEXT(z0, file_path);
 
-  // TODO(#3909): actually map the memory here. For now we just load the
-  // contents.
-  iree_allocator_t flatbuffer_allocator =
-      iree_runtime_session_host_allocator(session);
-  iree_byte_span_t flatbuffer_data;
+  // The file is mapped into memory so that only the pages touched (usually the
+  // bytecode and any rodata actually used) are read. The module takes
+  // ownership of the mapping and unmaps it when destroyed.
+  iree_const_byte_span_t flatbuffer_data = iree_make_const_byte_span(NULL, 0);
+  iree_allocator_t flatbuffer_allocator = iree_allocator_null();
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_file_read_contents(file_path, flatbuffer_allocator,
-                                  &flatbuffer_data));
+      z0, iree_file_map_contents(file_path, IREE_FILE_ACCESS_HINT_DEFAULT,
+                                 iree_runtime_session_host_allocator(session),
+                                 &flatbuffer_data, &flatbuffer_allocator));
 
-  iree_status_t status =
-      iree_runtime_session_append_bytecode_module_from_memory(
-          session,
-          iree_make_const_byte_span(flatbuffer_data.data,
-                                    flatbuffer_data.data_length),
-          flatbuffer_allocator);
-  if (!iree_status_is_ok(status)) {
-    iree_allocator_free(flatbuffer_allocator, flatbuffer_data.data);
+  // NOTE: once created the module owns the mapping even if appending fails.
+  iree_vm_module_t* module = NULL;
+  iree_status_t status = iree_vm_bytecode_module_create(
+      flatbuffer_data, flatbuffer_allocator,
+      iree_runtime_session_host_allocator(session), &module);
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_runtime_session_register_module(session, module, flatbuffer_data);
+  } else {
+    iree_allocator_free(flatbuffer_allocator, (void*)flatbuffer_data.data);
   }
+  iree_vm_module_release(module);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -267,6 +443,12 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call(
   IREE_ASSERT_ARGUMENT(function);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  if (session->trace_recorder) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_runtime_trace_recorder_record_call(session->trace_recorder,
+                                                    *function, input_list));
+  }
+
   iree_status_t status =
       iree_vm_invoke(iree_runtime_session_context(session), *function,
                      IREE_VM_INVOCATION_FLAG_NONE,
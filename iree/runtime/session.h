@@ -11,6 +11,7 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/modules/hal/module.h"
 #include "iree/vm/api.h"
 
 #ifdef __cplusplus
@@ -52,6 +53,20 @@ enum iree_runtime_session_builtins_bits_t {
 };
 typedef uint64_t iree_runtime_session_builtins_t;
 
+// Controls what is recorded when a session trace is enabled.
+enum iree_runtime_session_trace_flag_bits_t {
+  IREE_RUNTIME_SESSION_TRACE_FLAG_NONE = 0u,
+  // Records the contents of buffer view arguments into the trace sidecar file
+  // so that calls replay with the original data. Without this buffer views
+  // are recorded with only their shape and type and replay as zeros.
+  IREE_RUNTIME_SESSION_TRACE_FLAG_RECORD_CONTENTS = 1u << 0,
+  // Records a hash of the contents of each buffer view argument. Hashes are
+  // cheap relative to copying the contents and can be used to identify
+  // repeated inputs when contents are not recorded.
+  IREE_RUNTIME_SESSION_TRACE_FLAG_RECORD_HASHES = 1u << 1,
+};
+typedef uint32_t iree_runtime_session_trace_flags_t;
+
 // Options used to configure session creation.
 typedef struct iree_runtime_session_options_t {
   // Flags controlling the execution environment.
@@ -61,6 +76,25 @@ typedef struct iree_runtime_session_options_t {
   // Session creation will fail if a requested module is not built into the
   // runtime binary.
   iree_runtime_session_builtins_t builtin_modules;
+
+  // Path of a trace file that all modules loaded into and calls made through
+  // iree_runtime_session_call on the session will be recorded into. The trace
+  // can be replayed with iree-run-trace or iree-benchmark-trace. Sessions
+  // forked from the session record into the same trace. Empty to disable.
+  iree_string_view_t trace_path;
+
+  // Flags controlling what is recorded into the trace.
+  iree_runtime_session_trace_flags_t trace_flags;
+
+  // Maximum total number of bytes of buffer view contents that will be
+  // recorded into the trace when contents are being recorded. Calls made after
+  // the limit is reached omit their contents. 0 for unbounded.
+  iree_device_size_t trace_contents_limit;
+
+  // Flags passed to the HAL module. Use IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES
+  // to defer executable preparation until first use and optionally prepare
+  // them in the background with iree_runtime_session_begin_prewarm.
+  iree_hal_module_flags_t hal_module_flags;
 } iree_runtime_session_options_t;
 
 // Initializes |out_options| to its default values.
@@ -88,6 +122,28 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
     const iree_runtime_session_options_t* options, iree_hal_device_t* device,
     iree_allocator_t host_allocator, iree_runtime_session_t** out_session);
 
+// Creates a new session using the given set of |devices|.
+// devices[0] is the default device returned by iree_runtime_session_device
+// and programs compiled with device affinities select the others by ordinal.
+// All devices must be created from the same driver.
+// See iree_runtime_session_create_with_device for details.
+IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_devices(
+    iree_runtime_instance_t* instance,
+    const iree_runtime_session_options_t* options,
+    iree_host_size_t device_count, iree_hal_device_t* const* devices,
+    iree_allocator_t host_allocator, iree_runtime_session_t** out_session);
+
+// Creates a new session that shares the device and modules of |session| and
+// starts from a snapshot of its module state. The parent session must have
+// been frozen with iree_runtime_session_freeze and cannot have more modules
+// appended. See iree_vm_context_fork for details on what state is shared.
+//
+// Forks are independent of each other and may be used concurrently from
+// different threads. |out_session| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_runtime_session_fork(
+    const iree_runtime_session_t* session, iree_allocator_t host_allocator,
+    iree_runtime_session_t** out_session);
+
 // Retains the given |session| for the caller.
 IREE_API_EXPORT void iree_runtime_session_retain(
     iree_runtime_session_t* session);
@@ -135,6 +191,38 @@ IREE_API_EXPORT iree_hal_allocator_t* iree_runtime_session_device_allocator(
 IREE_API_EXPORT iree_status_t
 iree_runtime_session_trim(iree_runtime_session_t* session);
 
+// Begins preparing all executables deferred by the HAL module on a background
+// thread so that they are ready before their first dispatch. Only useful when
+// the session was created with IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES and called
+// after the user modules have been appended (and their initializers have
+// created their executables).
+//
+// Calls may be made on the session while prewarming; dispatches of executables
+// not yet prepared will prepare them inline (or wait for the background thread
+// if it is already preparing them). Returns IREE_STATUS_FAILED_PRECONDITION if
+// a prewarm is already in progress.
+IREE_API_EXPORT iree_status_t
+iree_runtime_session_begin_prewarm(iree_runtime_session_t* session);
+
+// Waits for a prewarm started with iree_runtime_session_begin_prewarm to
+// complete and returns its result. Returns OK if no prewarm was started.
+IREE_API_EXPORT iree_status_t
+iree_runtime_session_end_prewarm(iree_runtime_session_t* session);
+
+// Synchronously initializes everything the session would otherwise initialize
+// lazily during the first call: executables are prepared (waiting on any
+// prewarm in progress), device queues and their worker threads are brought up
+// and the device allocators reserve their initial memory. Call after the user
+// modules have been appended so that servers can become ready without sending
+// warm-up traffic. See iree_hal_module_state_warmup for details.
+IREE_API_EXPORT iree_status_t
+iree_runtime_session_warmup(iree_runtime_session_t* session);
+
+// Freezes the session such that no more modules can be appended.
+// Frozen sessions can be forked with iree_runtime_session_fork.
+IREE_API_EXPORT iree_status_t
+iree_runtime_session_freeze(iree_runtime_session_t* session);
+
 // Appends the given |module| to the context.
 // The module will be retained by the context.
 //
@@ -161,6 +249,10 @@ iree_runtime_session_append_bytecode_module_from_memory(
     iree_allocator_t flatbuffer_allocator);
 
 // Appends a bytecode module to the context loaded from the given |file_path|.
+// The file is memory mapped where supported by the platform: rodata segments
+// are referenced directly from the mapping and paged in from disk on demand
+// instead of being read into memory up front. The file contents must not be
+// modified while the session is live.
 //
 // NOTE: only valid if the context is not yet frozen; see
 // iree_vm_context_freeze for more information.
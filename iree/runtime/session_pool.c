@@ -0,0 +1,128 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/session_pool.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/runtime/session.h"
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_session_pool_t
+//===----------------------------------------------------------------------===//
+
+struct iree_runtime_session_pool_t {
+  iree_atomic_ref_count_t ref_count;
+
+  // Allocator used to allocate the pool and all forked sessions.
+  iree_allocator_t host_allocator;
+
+  // Frozen session that all pooled sessions are forked from.
+  iree_runtime_session_t* template_session;
+
+  // Guards the idle session list.
+  iree_slim_mutex_t mutex;
+  // Sessions returned to the pool that are available for reuse; retained.
+  iree_host_size_t idle_count IREE_GUARDED_BY(mutex);
+  iree_host_size_t idle_capacity;
+  iree_runtime_session_t* idle_sessions[];
+};
+
+IREE_API_EXPORT iree_status_t iree_runtime_session_pool_create(
+    iree_runtime_session_t* template_session, iree_host_size_t max_idle_count,
+    iree_allocator_t host_allocator, iree_runtime_session_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(template_session);
+  IREE_ASSERT_ARGUMENT(out_pool);
+  *out_pool = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_runtime_session_freeze(template_session));
+
+  iree_runtime_session_pool_t* pool = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(
+              host_allocator,
+              sizeof(*pool) + max_idle_count * sizeof(pool->idle_sessions[0]),
+              (void**)&pool));
+  iree_atomic_ref_count_init(&pool->ref_count);
+  pool->host_allocator = host_allocator;
+  pool->template_session = template_session;
+  iree_runtime_session_retain(template_session);
+  iree_slim_mutex_initialize(&pool->mutex);
+  pool->idle_count = 0;
+  pool->idle_capacity = max_idle_count;
+
+  *out_pool = pool;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_runtime_session_pool_destroy(
+    iree_runtime_session_pool_t* pool) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  for (iree_host_size_t i = 0; i < pool->idle_count; ++i) {
+    iree_runtime_session_release(pool->idle_sessions[i]);
+  }
+  iree_slim_mutex_deinitialize(&pool->mutex);
+  iree_runtime_session_release(pool->template_session);
+  iree_allocator_free(pool->host_allocator, pool);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_runtime_session_pool_retain(
+    iree_runtime_session_pool_t* pool) {
+  if (pool) {
+    iree_atomic_ref_count_inc(&pool->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_runtime_session_pool_release(
+    iree_runtime_session_pool_t* pool) {
+  if (pool && iree_atomic_ref_count_dec(&pool->ref_count) == 1) {
+    iree_runtime_session_pool_destroy(pool);
+  }
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_session_pool_acquire(
+    iree_runtime_session_pool_t* pool, iree_runtime_session_t** out_session) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_ASSERT_ARGUMENT(out_session);
+  *out_session = NULL;
+
+  iree_slim_mutex_lock(&pool->mutex);
+  if (pool->idle_count > 0) {
+    *out_session = pool->idle_sessions[--pool->idle_count];
+  }
+  iree_slim_mutex_unlock(&pool->mutex);
+  if (*out_session) return iree_ok_status();
+
+  // Forking happens outside of the lock so that concurrent acquisitions only
+  // contend on the allocator.
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_runtime_session_fork(
+      pool->template_session, pool->host_allocator, out_session);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT void iree_runtime_session_pool_recycle(
+    iree_runtime_session_pool_t* pool, iree_runtime_session_t* session) {
+  IREE_ASSERT_ARGUMENT(pool);
+  if (!session) return;
+  iree_slim_mutex_lock(&pool->mutex);
+  if (pool->idle_count < pool->idle_capacity) {
+    pool->idle_sessions[pool->idle_count++] = session;
+    session = NULL;
+  }
+  iree_slim_mutex_unlock(&pool->mutex);
+  // Pool is full; drop the session.
+  iree_runtime_session_release(session);
+}
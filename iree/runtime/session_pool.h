@@ -0,0 +1,77 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_RUNTIME_SESSION_POOL_H_
+#define IREE_RUNTIME_SESSION_POOL_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+typedef struct iree_runtime_session_t iree_runtime_session_t;
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_session_pool_t
+//===----------------------------------------------------------------------===//
+
+// A pool of sessions forked from a single template session.
+//
+// Sessions are thread-compatible and callers wanting to execute concurrently
+// would otherwise need to either serialize on a single session or load their
+// modules into many. The pool instead hands out forks of a fully loaded and
+// initialized template session: all forks share the template's HAL device,
+// modules, and any resources held in module globals (such as executables and
+// constant buffers) while each has its own VM context with independent mutable
+// state. Calls on different sessions acquired from the pool may proceed
+// concurrently without any synchronization.
+//
+// Sessions are created on demand when no idle session is available and up
+// to |max_idle_count| sessions are kept around after being returned to the
+// pool for reuse by later requests.
+//
+// Thread-safe.
+typedef struct iree_runtime_session_pool_t iree_runtime_session_pool_t;
+
+// Creates a session pool handing out forks of |template_session|.
+// The template session must have all of its modules appended and is frozen as
+// part of creating the pool. The pool will retain the template session for its
+// lifetime.
+IREE_API_EXPORT iree_status_t iree_runtime_session_pool_create(
+    iree_runtime_session_t* template_session, iree_host_size_t max_idle_count,
+    iree_allocator_t host_allocator, iree_runtime_session_pool_t** out_pool);
+
+// Retains the given |pool| for the caller.
+IREE_API_EXPORT void iree_runtime_session_pool_retain(
+    iree_runtime_session_pool_t* pool);
+
+// Releases the given |pool| from the caller.
+// Sessions that have been acquired from the pool remain valid.
+IREE_API_EXPORT void iree_runtime_session_pool_release(
+    iree_runtime_session_pool_t* pool);
+
+// Acquires a session for exclusive use by the caller.
+// The session must be returned to the pool with
+// iree_runtime_session_pool_recycle when no longer needed or may be released
+// directly if it should not be reused.
+IREE_API_EXPORT iree_status_t iree_runtime_session_pool_acquire(
+    iree_runtime_session_pool_t* pool, iree_runtime_session_t** out_session);
+
+// Returns a |session| acquired from |pool| for reuse by later requests.
+// Ownership of the caller's reference transfers to the pool. Any state the
+// calls made on the session left in module globals will be observed by the
+// next user of the session.
+IREE_API_EXPORT void iree_runtime_session_pool_recycle(
+    iree_runtime_session_pool_t* pool, iree_runtime_session_t* session);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_RUNTIME_SESSION_POOL_H_
@@ -0,0 +1,436 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/trace_recorder.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/base/internal/file_path.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/modules/hal/module.h"
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_trace_recorder_t
+//===----------------------------------------------------------------------===//
+
+struct iree_runtime_trace_recorder_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+
+  iree_runtime_session_trace_flags_t flags;
+
+  // Total bytes of contents that may be written to the sidecar or 0 if
+  // unbounded.
+  iree_device_size_t contents_limit;
+
+  // Time the recorder was created; call timestamps are relative to this.
+  iree_time_t start_time_ns;
+
+  // Directory containing the trace and the stem of the trace file name used to
+  // derive the names of the sidecar and module files.
+  iree_string_view_t trace_dirname;
+  iree_string_view_t trace_stem;
+
+  // Guards the trace files and all recording state.
+  iree_slim_mutex_t mutex;
+
+  // Trace file receiving the YAML event stream.
+  FILE* trace_file IREE_GUARDED_BY(mutex);
+
+  // Sidecar file receiving buffer contents or NULL if contents are not being
+  // recorded. Opened on first use.
+  FILE* contents_file IREE_GUARDED_BY(mutex);
+  // Total bytes written to |contents_file|; the offset of the next contents.
+  iree_device_size_t contents_offset IREE_GUARDED_BY(mutex);
+
+  // Storage for |trace_dirname| and |trace_stem|.
+  char trace_path[];
+};
+
+// Formats the name of a file derived from the trace into |buffer| as
+// `<trace stem><suffix>`.
+static iree_string_view_t iree_runtime_trace_recorder_file_name(
+    iree_runtime_trace_recorder_t* recorder, iree_string_view_t suffix,
+    char* buffer, iree_host_size_t buffer_capacity) {
+  int length = snprintf(buffer, buffer_capacity, "%.*s%.*s",
+                        (int)recorder->trace_stem.size,
+                        recorder->trace_stem.data, (int)suffix.size,
+                        suffix.data);
+  if (length < 0 || (iree_host_size_t)length >= buffer_capacity) {
+    return iree_string_view_empty();
+  }
+  return iree_make_string_view(buffer, (iree_host_size_t)length);
+}
+
+// Opens a file derived from the trace in the trace directory.
+static iree_status_t iree_runtime_trace_recorder_open_file(
+    iree_runtime_trace_recorder_t* recorder, iree_string_view_t file_name,
+    FILE** out_file) {
+  char* full_path = NULL;
+  IREE_RETURN_IF_ERROR(iree_file_path_join(recorder->trace_dirname, file_name,
+                                           recorder->host_allocator,
+                                           &full_path));
+  *out_file = fopen(full_path, "wb");
+  iree_status_t status = iree_ok_status();
+  if (!*out_file) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "unable to open trace file '%s'", full_path);
+  }
+  iree_allocator_free(recorder->host_allocator, full_path);
+  return status;
+}
+
+iree_status_t iree_runtime_trace_recorder_create(
+    iree_string_view_t trace_path, iree_runtime_session_trace_flags_t flags,
+    iree_device_size_t contents_limit, iree_allocator_t host_allocator,
+    iree_runtime_trace_recorder_t** out_recorder) {
+  IREE_ASSERT_ARGUMENT(out_recorder);
+  *out_recorder = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, trace_path.data, trace_path.size);
+
+  iree_runtime_trace_recorder_t* recorder = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator,
+                                sizeof(*recorder) + trace_path.size + 1,
+                                (void**)&recorder));
+  memset(recorder, 0, sizeof(*recorder));
+  iree_atomic_ref_count_init(&recorder->ref_count);
+  recorder->host_allocator = host_allocator;
+  recorder->flags = flags;
+  recorder->contents_limit = contents_limit;
+  recorder->start_time_ns = iree_time_now();
+  memcpy(recorder->trace_path, trace_path.data, trace_path.size);
+  recorder->trace_path[trace_path.size] = 0;
+  iree_string_view_t stored_path =
+      iree_make_string_view(recorder->trace_path, trace_path.size);
+  recorder->trace_dirname = iree_file_path_dirname(stored_path);
+  recorder->trace_stem = iree_file_path_stem(stored_path);
+  iree_slim_mutex_initialize(&recorder->mutex);
+
+  iree_status_t status = iree_ok_status();
+  recorder->trace_file = fopen(recorder->trace_path, "wb");
+  if (!recorder->trace_file) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "unable to open trace file '%s'",
+                              recorder->trace_path);
+  }
+
+  if (iree_status_is_ok(status)) {
+    fprintf(recorder->trace_file, "type: context_load\n");
+    *out_recorder = recorder;
+  } else {
+    iree_runtime_trace_recorder_release(recorder);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_runtime_trace_recorder_destroy(
+    iree_runtime_trace_recorder_t* recorder) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  if (recorder->contents_file) fclose(recorder->contents_file);
+  if (recorder->trace_file) fclose(recorder->trace_file);
+  iree_slim_mutex_deinitialize(&recorder->mutex);
+  iree_allocator_free(recorder->host_allocator, recorder);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_runtime_trace_recorder_retain(
+    iree_runtime_trace_recorder_t* recorder) {
+  if (recorder) {
+    iree_atomic_ref_count_inc(&recorder->ref_count);
+  }
+}
+
+void iree_runtime_trace_recorder_release(
+    iree_runtime_trace_recorder_t* recorder) {
+  if (recorder && iree_atomic_ref_count_dec(&recorder->ref_count) == 1) {
+    iree_runtime_trace_recorder_destroy(recorder);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Module loads
+//===----------------------------------------------------------------------===//
+
+iree_status_t iree_runtime_trace_recorder_record_module(
+    iree_runtime_trace_recorder_t* recorder, iree_vm_module_t* module,
+    iree_const_byte_span_t flatbuffer_data) {
+  IREE_ASSERT_ARGUMENT(recorder);
+  IREE_ASSERT_ARGUMENT(module);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_string_view_t module_name = iree_vm_module_name(module);
+
+  // Bytecode modules are written next to the trace so that the trace is
+  // self-contained even if the module was loaded from memory.
+  char file_name_buffer[256];
+  iree_string_view_t file_name = iree_string_view_empty();
+  iree_status_t status = iree_ok_status();
+  if (flatbuffer_data.data_length > 0) {
+    char suffix_buffer[128];
+    int suffix_length =
+        snprintf(suffix_buffer, sizeof(suffix_buffer), ".%.*s.vmfb",
+                 (int)module_name.size, module_name.data);
+    if (suffix_length > 0 &&
+        (iree_host_size_t)suffix_length < sizeof(suffix_buffer)) {
+      file_name = iree_runtime_trace_recorder_file_name(
+          recorder,
+          iree_make_string_view(suffix_buffer, (iree_host_size_t)suffix_length),
+          file_name_buffer, sizeof(file_name_buffer));
+    }
+    if (iree_string_view_is_empty(file_name)) {
+      status = iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                "module name '%.*s' too long for trace file",
+                                (int)module_name.size, module_name.data);
+    }
+    char* full_path = NULL;
+    if (iree_status_is_ok(status)) {
+      status = iree_file_path_join(recorder->trace_dirname, file_name,
+                                   recorder->host_allocator, &full_path);
+    }
+    if (iree_status_is_ok(status)) {
+      status = iree_file_write_contents(full_path, flatbuffer_data);
+    }
+    iree_allocator_free(recorder->host_allocator, full_path);
+  }
+
+  if (iree_status_is_ok(status)) {
+    iree_slim_mutex_lock(&recorder->mutex);
+    FILE* file = recorder->trace_file;
+    fprintf(file, "---\ntype: module_load\nmodule:\n");
+    if (iree_string_view_is_empty(file_name)) {
+      fprintf(file, "  type: builtin\n  name: %.*s\n", (int)module_name.size,
+              module_name.data);
+    } else {
+      fprintf(file, "  type: bytecode\n  name: %.*s\n  path: %.*s\n",
+              (int)module_name.size, module_name.data, (int)file_name.size,
+              file_name.data);
+    }
+    fflush(file);
+    iree_slim_mutex_unlock(&recorder->mutex);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Calls
+//===----------------------------------------------------------------------===//
+
+// 64-bit FNV-1a; not cryptographic but fast and stable across platforms.
+static uint64_t iree_runtime_trace_recorder_hash(iree_const_byte_span_t data) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (iree_host_size_t i = 0; i < data.data_length; ++i) {
+    hash ^= data.data[i];
+    hash *= 0x100000001B3ull;
+  }
+  return hash;
+}
+
+// Appends |contents| to the sidecar file and returns its offset in
+// |out_offset|. |out_recorded| is set to false if the contents were dropped
+// because they would exceed the contents limit.
+static iree_status_t iree_runtime_trace_recorder_append_contents(
+    iree_runtime_trace_recorder_t* recorder, iree_const_byte_span_t contents,
+    iree_string_view_t contents_file_name, bool* out_recorded,
+    iree_device_size_t* out_offset) {
+  *out_recorded = false;
+  *out_offset = 0;
+  if (recorder->contents_limit &&
+      contents.data_length >
+          recorder->contents_limit - recorder->contents_offset) {
+    return iree_ok_status();
+  }
+  if (!recorder->contents_file) {
+    IREE_RETURN_IF_ERROR(iree_runtime_trace_recorder_open_file(
+        recorder, contents_file_name, &recorder->contents_file));
+  }
+  if (fwrite(contents.data, 1, contents.data_length, recorder->contents_file) !=
+      contents.data_length) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS,
+                            "failed to write trace contents");
+  }
+  *out_recorded = true;
+  *out_offset = recorder->contents_offset;
+  recorder->contents_offset += contents.data_length;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_runtime_trace_recorder_write_buffer_view(
+    iree_runtime_trace_recorder_t* recorder,
+    iree_hal_buffer_view_t* buffer_view, int indent) {
+  FILE* file = recorder->trace_file;
+  fprintf(file, "%*s  shape: [", indent, "");
+  iree_host_size_t shape_rank = iree_hal_buffer_view_shape_rank(buffer_view);
+  const iree_hal_dim_t* shape = iree_hal_buffer_view_shape_dims(buffer_view);
+  for (iree_host_size_t i = 0; i < shape_rank; ++i) {
+    fprintf(file, i ? ", %" PRIu64 : "%" PRIu64, (uint64_t)shape[i]);
+  }
+  fprintf(file, "]\n");
+  fprintf(file, "%*s  element_type: %u\n", indent, "",
+          (uint32_t)iree_hal_buffer_view_element_type(buffer_view));
+  fprintf(file, "%*s  encoding_type: %u\n", indent, "",
+          (uint32_t)iree_hal_buffer_view_encoding_type(buffer_view));
+
+  const bool record_contents = iree_all_bits_set(
+      recorder->flags, IREE_RUNTIME_SESSION_TRACE_FLAG_RECORD_CONTENTS);
+  const bool record_hashes = iree_all_bits_set(
+      recorder->flags, IREE_RUNTIME_SESSION_TRACE_FLAG_RECORD_HASHES);
+  if (!record_contents && !record_hashes) return iree_ok_status();
+
+  // Buffers that are not host-visible cannot be mapped without a transfer and
+  // are recorded without contents so that recording never blocks on the
+  // device.
+  iree_hal_buffer_mapping_t mapping;
+  iree_status_t status = iree_hal_buffer_map_range(
+      iree_hal_buffer_view_buffer(buffer_view), IREE_HAL_MAPPING_MODE_SCOPED,
+      IREE_HAL_MEMORY_ACCESS_READ, 0,
+      iree_hal_buffer_view_byte_length(buffer_view), &mapping);
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(status);
+    return iree_ok_status();
+  }
+  iree_const_byte_span_t contents = iree_make_const_byte_span(
+      mapping.contents.data, mapping.contents.data_length);
+
+  if (record_hashes) {
+    fprintf(file, "%*s  contents_hash: \"0x%016" PRIx64 "\"\n", indent, "",
+            iree_runtime_trace_recorder_hash(contents));
+  }
+  if (record_contents) {
+    char file_name_buffer[256];
+    iree_string_view_t file_name = iree_runtime_trace_recorder_file_name(
+        recorder, IREE_SV(".bin"), file_name_buffer, sizeof(file_name_buffer));
+    bool recorded = false;
+    iree_device_size_t offset = 0;
+    status = iree_runtime_trace_recorder_append_contents(
+        recorder, contents, file_name, &recorded, &offset);
+    if (iree_status_is_ok(status) && recorded) {
+      fprintf(file, "%*s  contents_file: %.*s\n", indent, "",
+              (int)file_name.size, file_name.data);
+      fprintf(file, "%*s  contents_offset: %" PRIu64 "\n", indent, "",
+              (uint64_t)offset);
+    }
+  }
+
+  iree_status_ignore(iree_hal_buffer_unmap_range(&mapping));
+  return status;
+}
+
+static iree_status_t iree_runtime_trace_recorder_write_variant(
+    iree_runtime_trace_recorder_t* recorder, iree_vm_variant_t variant,
+    int indent) {
+  FILE* file = recorder->trace_file;
+  if (iree_vm_variant_is_value(variant)) {
+    fprintf(file, "%*s- type: value\n", indent, "");
+    switch (variant.type.value_type) {
+      case IREE_VM_VALUE_TYPE_I8:
+        fprintf(file, "%*s  i8: %" PRIi8 "\n", indent, "", variant.i8);
+        break;
+      case IREE_VM_VALUE_TYPE_I16:
+        fprintf(file, "%*s  i16: %" PRIi16 "\n", indent, "", variant.i16);
+        break;
+      case IREE_VM_VALUE_TYPE_I32:
+        fprintf(file, "%*s  i32: %" PRIi32 "\n", indent, "", variant.i32);
+        break;
+      case IREE_VM_VALUE_TYPE_I64:
+        fprintf(file, "%*s  i64: %" PRIi64 "\n", indent, "", variant.i64);
+        break;
+      case IREE_VM_VALUE_TYPE_F32:
+        fprintf(file, "%*s  f32: %.9g\n", indent, "", variant.f32);
+        break;
+      case IREE_VM_VALUE_TYPE_F64:
+        fprintf(file, "%*s  f64: %.17g\n", indent, "", variant.f64);
+        break;
+      default:
+        return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                                "unsupported value type %d",
+                                (int)variant.type.value_type);
+    }
+    return iree_ok_status();
+  } else if (!iree_vm_variant_is_ref(variant) || !variant.ref.ptr) {
+    fprintf(file, "%*s- type: null\n", indent, "");
+    return iree_ok_status();
+  }
+
+  if (iree_vm_list_isa(variant.ref)) {
+    iree_vm_list_t* list = iree_vm_list_deref(variant.ref);
+    iree_host_size_t item_count = iree_vm_list_size(list);
+    fprintf(file, "%*s- type: vm.list\n", indent, "");
+    fprintf(file, item_count ? "%*s  items:\n" : "%*s  items: []\n", indent,
+            "");
+    for (iree_host_size_t i = 0; i < item_count; ++i) {
+      iree_vm_variant_t item = iree_vm_variant_empty();
+      IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(list, i, &item));
+      IREE_RETURN_IF_ERROR(iree_runtime_trace_recorder_write_variant(
+          recorder, item, indent + 2));
+    }
+    return iree_ok_status();
+  } else if (iree_hal_buffer_view_isa(variant.ref)) {
+    fprintf(file, "%*s- type: hal.buffer_view\n", indent, "");
+    return iree_runtime_trace_recorder_write_buffer_view(
+        recorder, iree_hal_buffer_view_deref(variant.ref), indent);
+  } else if (iree_hal_buffer_isa(variant.ref)) {
+    // Raw buffers are recorded as bytes; replay allocates them uninitialized.
+    iree_hal_buffer_t* buffer = iree_hal_buffer_deref(variant.ref);
+    fprintf(file, "%*s- type: hal.buffer\n", indent, "");
+    fprintf(file, "%*s  shape: [%" PRIu64 "]\n", indent, "",
+            (uint64_t)iree_hal_buffer_byte_length(buffer));
+    fprintf(file, "%*s  element_type: %u\n", indent, "",
+            (uint32_t)IREE_HAL_ELEMENT_TYPE_UINT_8);
+    return iree_ok_status();
+  }
+
+  iree_string_view_t type_name = iree_vm_ref_type_name(variant.type.ref_type);
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "tracing of '%.*s' arguments not supported",
+                          (int)type_name.size, type_name.data);
+}
+
+iree_status_t iree_runtime_trace_recorder_record_call(
+    iree_runtime_trace_recorder_t* recorder, iree_vm_function_t function,
+    iree_vm_list_t* input_list) {
+  IREE_ASSERT_ARGUMENT(recorder);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_time_t timestamp_ns = iree_time_now() - recorder->start_time_ns;
+  iree_string_view_t module_name = iree_vm_module_name(function.module);
+  iree_string_view_t function_name = iree_vm_function_name(&function);
+
+  iree_slim_mutex_lock(&recorder->mutex);
+  FILE* file = recorder->trace_file;
+  fprintf(file, "---\ntype: call\nfunction: %.*s.%.*s\n",
+          (int)module_name.size, module_name.data, (int)function_name.size,
+          function_name.data);
+  fprintf(file, "timestamp_ns: %" PRId64 "\n", (int64_t)timestamp_ns);
+  iree_host_size_t arg_count = input_list ? iree_vm_list_size(input_list) : 0;
+  fprintf(file, arg_count ? "args:\n" : "args: []\n");
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < arg_count && iree_status_is_ok(status);
+       ++i) {
+    iree_vm_variant_t arg = iree_vm_variant_empty();
+    status = iree_vm_list_get_variant(input_list, i, &arg);
+    if (iree_status_is_ok(status)) {
+      status = iree_runtime_trace_recorder_write_variant(recorder, arg,
+                                                         /*indent=*/0);
+    }
+  }
+  // Flushed on each call so that the trace covers everything up to a crash.
+  if (recorder->contents_file) fflush(recorder->contents_file);
+  fflush(file);
+  iree_slim_mutex_unlock(&recorder->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,81 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_RUNTIME_TRACE_RECORDER_H_
+#define IREE_RUNTIME_TRACE_RECORDER_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/runtime/session.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_trace_recorder_t
+//===----------------------------------------------------------------------===//
+
+// Records module loads and calls into a trace file that can be replayed with
+// iree-run-trace and iree-benchmark-trace.
+//
+// The trace is written as a stream of YAML documents matching those produced
+// by the Python tracing utilities: a `context_load` event followed by one
+// `module_load` event per module and one `call` event per call. Bytecode
+// modules are written alongside the trace as `<trace stem>.<module>.vmfb` and
+// buffer view contents (when recorded) are appended to a `<trace stem>.bin`
+// sidecar file that the calls reference by offset.
+//
+// Only call arguments are recorded; results are not checked during replay.
+//
+// Thread-safe; events from any number of sessions sharing the recorder are
+// serialized into the trace in the order they are recorded.
+typedef struct iree_runtime_trace_recorder_t iree_runtime_trace_recorder_t;
+
+// Creates a new trace recorder writing to the file at |trace_path|.
+// Any existing trace, sidecar, or module files are overwritten.
+//
+// |flags| controls which buffer view data is recorded and
+// |contents_limit| bounds the total number of bytes of contents that will be
+// recorded across all calls (0 for unbounded). Once the limit is reached
+// buffer views are recorded with only their shape and type and will be
+// zero-filled during replay.
+iree_status_t iree_runtime_trace_recorder_create(
+    iree_string_view_t trace_path, iree_runtime_session_trace_flags_t flags,
+    iree_device_size_t contents_limit, iree_allocator_t host_allocator,
+    iree_runtime_trace_recorder_t** out_recorder);
+
+// Retains the given |recorder| for the caller.
+void iree_runtime_trace_recorder_retain(
+    iree_runtime_trace_recorder_t* recorder);
+
+// Releases the given |recorder| from the caller.
+// The trace files are flushed and closed when the last reference is released.
+void iree_runtime_trace_recorder_release(
+    iree_runtime_trace_recorder_t* recorder);
+
+// Records that |module| was loaded.
+// Bytecode modules must provide their |flatbuffer_data| so that it can be
+// written alongside the trace; modules without data are recorded as builtins.
+iree_status_t iree_runtime_trace_recorder_record_module(
+    iree_runtime_trace_recorder_t* recorder, iree_vm_module_t* module,
+    iree_const_byte_span_t flatbuffer_data);
+
+// Records a call to |function| with the given |input_list| arguments.
+// Must be called before the function is invoked as the contents of the
+// arguments may be modified by the call.
+iree_status_t iree_runtime_trace_recorder_record_call(
+    iree_runtime_trace_recorder_t* recorder, iree_vm_function_t function,
+    iree_vm_list_t* input_list);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_RUNTIME_TRACE_RECORDER_H_
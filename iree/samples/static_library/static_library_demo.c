@@ -14,7 +14,8 @@
 
 extern const iree_hal_executable_library_header_t**
 simple_mul_dispatch_0_library_query(
-    iree_hal_executable_library_version_t max_version, void* reserved);
+    iree_hal_executable_library_version_t max_version,
+    const iree_hal_executable_environment_v0_t* environment);
 // A function to create the bytecode or C module.
 extern iree_status_t create_module(iree_vm_module_t** module);
 
@@ -34,7 +35,7 @@ iree_status_t create_device_with_static_loader(iree_allocator_t host_allocator,
   // Load the statically embedded library
   const iree_hal_executable_library_header_t** static_library =
       simple_mul_dispatch_0_library_query(
-          IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION, /*reserved=*/NULL);
+          IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION, /*environment=*/NULL);
   const iree_hal_executable_library_header_t** libraries[1] = {static_library};
 
   iree_hal_executable_loader_t* library_loader = NULL;
@@ -7,6 +7,7 @@
 #include "iree/task/api.h"
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "iree/base/internal/flags.h"
@@ -25,15 +26,55 @@ IREE_FLAG(
     "threads for potential latency additions later on as threads take longer\n"
     "to wake on their first use.");
 
-// TODO(benvanik): enable this when we use it - though hopefully we don't!
 IREE_FLAG(
     int32_t, task_worker_local_memory, 0,  // 64 * 1024,
-    "Specifies the bytes of per-worker local memory allocated for use by\n"
-    "dispatched tiles. Tiles may use less than this but will fail to dispatch\n"
-    "if they require more. Conceptually it is like a stack reservation and\n"
+    "Specifies the bytes of per-worker local memory allocated up front for\n"
+    "use by dispatched tiles. Workers grow their local memory on demand when\n"
+    "tiles require more (up to --task_worker_local_memory_max) and this only\n"
+    "avoids the allocation on the first dispatch that needs it.");
+
+IREE_FLAG(
+    int32_t, task_worker_local_memory_max, 0,
+    "Specifies the maximum bytes of per-worker local memory available for\n"
+    "use by dispatched tiles. Tiles may use less than this but will fail to\n"
+    "dispatch if they require more. Conceptually it is like a stack limit and\n"
     "should be treated the same way: the source programs must be built to\n"
     "only use a specific maximum amount of local memory and the runtime must\n"
-    "be configured to make at least that amount of local memory available.");
+    "be configured to make at least that amount of local memory available.\n"
+    "Defaults to IREE_TASK_EXECUTOR_DEFAULT_WORKER_LOCAL_MEMORY_MAX_SIZE.");
+
+IREE_FLAG(
+    int32_t, task_dispatch_tiles_per_reservation, 0,
+    "Number of tiles each dispatch shard reserves from the grid at a time.\n"
+    "Higher values reduce contention on the shared grid while lower values\n"
+    "allow for finer-grained balancing across workers. 0 uses the default\n"
+    "from iree/task/tuning.h.");
+
+IREE_FLAG(
+    bool, task_dispatch_adaptive_reservation, false,
+    "Grows the number of tiles each dispatch shard reserves at a time while\n"
+    "the tiles are cheap to execute, up to\n"
+    "--task_dispatch_max_tiles_per_reservation.");
+
+IREE_FLAG(
+    int32_t, task_dispatch_max_tiles_per_reservation, 0,
+    "Maximum number of tiles an adaptive reservation may grow to when\n"
+    "--task_dispatch_adaptive_reservation is specified. 0 uses the default\n"
+    "from iree/task/tuning.h.");
+
+IREE_FLAG(
+    int64_t, task_donation_worker_mask, -1,
+    "Bitmask of workers that threads donated to the executor while waiting\n"
+    "may steal tasks from. -1 allows all workers and 0 disables theft such\n"
+    "that donated threads only wait. Restricting the mask to workers sharing\n"
+    "caches with the waiting threads avoids thrashing unrelated clusters.");
+
+IREE_FLAG(
+    bool, task_print_statistics, false,
+    "Prints per-worker scheduling statistics (tiles executed, steals, wake\n"
+    "latency, idle time, etc) to stderr when the executor is destroyed.\n"
+    "Useful for tuning worker counts and tile reservation sizes against real\n"
+    "workloads. No-op if statistics are compiled out.");
 
 //===----------------------------------------------------------------------===//
 // Topology configuration
@@ -52,7 +93,12 @@ IREE_FLAG(
     "   cores up to the value specified by --task_topology_max_group_count.\n"
     "   This optimizes for temporal and spatial cache locality but may suffer\n"
     "   from oversubscription if there are other processes trying to use the\n"
-    "   same cores.\n");
+    "   same cores.\n"
+    " 'threadless':\n"
+    "   Creates no worker threads and executes all tasks on threads that wait\n"
+    "   on results (donating themselves to the executor). This avoids the\n"
+    "   cross-thread hops between submission and execution at the cost of\n"
+    "   only having the concurrency of the waiting threads.\n");
 
 IREE_FLAG(
     int32_t, task_topology_group_count, 0,
@@ -67,6 +113,32 @@ IREE_FLAG(
     "detected and used when --task_topology_group_count=0 and is ignored\n"
     "otherwise.\n");
 
+IREE_FLAG(
+    int32_t, task_topology_base_core, -1,
+    "Index of the physical core to begin selecting cores from when\n"
+    "--task_topology_mode= is used; selection walks the cores in order from\n"
+    "here and wraps around. -1 begins after the core of the calling thread.");
+
+IREE_FLAG(
+    int64_t, task_topology_package_mask, 0,
+    "Bitmask of packages (sockets/NUMA nodes) that cores may be selected from\n"
+    "when --task_topology_mode= is used. 0 allows all packages. Running\n"
+    "multiple instances with disjoint masks avoids them contending for\n"
+    "caches and cross-socket bandwidth.");
+
+IREE_FLAG(
+    string, task_topology_distribution, "packed",
+    "Distribution of groups across L3 caches (or packages) when fewer groups\n"
+    "than cores are used:\n"
+    " 'packed': fills each cache before moving on to the next.\n"
+    " 'spread': assigns groups round-robin across caches.");
+
+IREE_FLAG(
+    bool, task_topology_exclude_efficiency_cores, false,
+    "Excludes the slower cores of hybrid systems (ARM big.LITTLE, Intel\n"
+    "P/E-cores, etc) when --task_topology_mode= is used. By default all cores\n"
+    "are used with the slower ones given proportionally less work.");
+
 // TODO(benvanik): add --task_topology_dump to dump out the current machine
 // configuration as seen by the topology utilities.
 
@@ -80,28 +152,69 @@ iree_status_t iree_task_executor_create_from_flags(
   *out_executor = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_task_scheduling_mode_t scheduling_mode = 0;
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
   if (FLAG_task_scheduling_defer_worker_startup) {
-    scheduling_mode |= IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP;
+    options.scheduling_mode |= IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP;
   }
-
-  iree_host_size_t worker_local_memory =
+  if (FLAG_task_dispatch_adaptive_reservation) {
+    options.scheduling_mode |=
+        IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION;
+  }
+  options.worker_local_memory_size =
       (iree_host_size_t)FLAG_task_worker_local_memory;
+  if (FLAG_task_worker_local_memory_max > 0) {
+    options.worker_local_memory_max_size =
+        (iree_host_size_t)FLAG_task_worker_local_memory_max;
+  }
+  if (FLAG_task_dispatch_tiles_per_reservation > 0) {
+    options.dispatch_tiles_per_reservation =
+        (uint32_t)FLAG_task_dispatch_tiles_per_reservation;
+    options.dispatch_max_tiles_per_reservation =
+        iree_max(options.dispatch_max_tiles_per_reservation,
+                 options.dispatch_tiles_per_reservation);
+  }
+  if (FLAG_task_dispatch_max_tiles_per_reservation > 0) {
+    options.dispatch_max_tiles_per_reservation =
+        (uint32_t)FLAG_task_dispatch_max_tiles_per_reservation;
+  }
 
   iree_status_t status = iree_ok_status();
 
+  iree_task_topology_cpuinfo_options_t topology_options;
+  iree_task_topology_cpuinfo_options_initialize(&topology_options);
+  topology_options.base_core_index = FLAG_task_topology_base_core;
+  topology_options.package_mask = (uint64_t)FLAG_task_topology_package_mask;
+  topology_options.exclude_efficiency_cores =
+      FLAG_task_topology_exclude_efficiency_cores;
+  if (strcmp(FLAG_task_topology_distribution, "packed") == 0) {
+    topology_options.distribution = IREE_TASK_TOPOLOGY_DISTRIBUTION_PACKED;
+  } else if (strcmp(FLAG_task_topology_distribution, "spread") == 0) {
+    topology_options.distribution = IREE_TASK_TOPOLOGY_DISTRIBUTION_SPREAD;
+  } else {
+    status = iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "--task_topology_distribution must be one of 'packed' or 'spread'; "
+        "have '%s'",
+        FLAG_task_topology_distribution);
+  }
+
   iree_task_topology_t topology;
   iree_task_topology_initialize(&topology);
 
-  if (FLAG_task_topology_group_count != 0) {
+  if (!iree_status_is_ok(status)) {
+    // Invalid options; skip topology initialization.
+  } else if (FLAG_task_topology_group_count != 0) {
     iree_task_topology_initialize_from_group_count(
         FLAG_task_topology_group_count, &topology);
   } else if (strcmp(FLAG_task_topology_mode, "physical_cores") == 0) {
-    iree_task_topology_initialize_from_physical_cores(
-        FLAG_task_topology_max_group_count, &topology);
+    iree_task_topology_initialize_from_physical_cores_with_options(
+        &topology_options, FLAG_task_topology_max_group_count, &topology);
   } else if (strcmp(FLAG_task_topology_mode, "unique_l2_cache_groups") == 0) {
-    iree_task_topology_initialize_from_unique_l2_cache_groups(
-        FLAG_task_topology_max_group_count, &topology);
+    iree_task_topology_initialize_from_unique_l2_cache_groups_with_options(
+        &topology_options, FLAG_task_topology_max_group_count, &topology);
+  } else if (strcmp(FLAG_task_topology_mode, "threadless") == 0) {
+    // Empty topology; the executor will be created without workers.
   } else {
     status = iree_make_status(
         IREE_STATUS_INVALID_ARGUMENT,
@@ -111,10 +224,17 @@ iree_status_t iree_task_executor_create_from_flags(
   }
 
   if (iree_status_is_ok(status)) {
-    status = iree_task_executor_create(scheduling_mode, &topology,
-                                       worker_local_memory, host_allocator,
+    status = iree_task_executor_create(&options, &topology, host_allocator,
                                        out_executor);
   }
+  if (iree_status_is_ok(status)) {
+    iree_task_executor_set_donation_affinity(
+        *out_executor,
+        (iree_task_affinity_set_t)FLAG_task_donation_worker_mask);
+    if (FLAG_task_print_statistics) {
+      iree_task_executor_set_exit_statistics_file(*out_executor, stderr);
+    }
+  }
 
   iree_task_topology_deinitialize(&topology);
 
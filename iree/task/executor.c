@@ -8,8 +8,10 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 
+#include "iree/base/internal/fpu_state.h"
 #include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/task/affinity_set.h"
@@ -24,11 +26,68 @@
 
 static void iree_task_executor_destroy(iree_task_executor_t* executor);
 
+void iree_task_executor_options_initialize(
+    iree_task_executor_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->scheduling_mode = IREE_TASK_SCHEDULING_MODE_RESERVED;
+  out_options->worker_local_memory_size = 0;
+  out_options->worker_local_memory_max_size =
+      IREE_TASK_EXECUTOR_DEFAULT_WORKER_LOCAL_MEMORY_MAX_SIZE;
+  out_options->worker_max_theft_task_count =
+      IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT;
+  out_options->worker_max_theft_attempts_divisor =
+      IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR;
+  out_options->delay_slop_ns = IREE_TASK_EXECUTOR_DELAY_SLOP_NS;
+  out_options->donation_wait_slice_ns =
+      IREE_TASK_EXECUTOR_DONATION_WAIT_SLICE_NS;
+  out_options->dispatch_tiles_per_reservation =
+      IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION;
+  out_options->dispatch_max_tiles_per_reservation =
+      IREE_TASK_DISPATCH_MAX_ADAPTIVE_TILES_PER_SHARD_RESERVATION;
+  out_options->dispatch_reservation_target_ns =
+      IREE_TASK_DISPATCH_ADAPTIVE_RESERVATION_TARGET_NS;
+}
+
+static iree_status_t iree_task_executor_check_options(
+    const iree_task_executor_options_t* options) {
+  if (options->worker_max_theft_task_count == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "worker max theft task count must be >= 1");
+  }
+  if (options->worker_max_theft_attempts_divisor == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "worker max theft attempts divisor must be >= 1");
+  }
+  if (options->delay_slop_ns < 0 || options->donation_wait_slice_ns <= 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "delay slop must be >= 0 and donation wait slice "
+                            "must be > 0");
+  }
+  if (options->dispatch_tiles_per_reservation == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "dispatch tiles per reservation must be >= 1");
+  }
+  if ((options->scheduling_mode &
+       IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION) &&
+      (options->dispatch_max_tiles_per_reservation <
+           options->dispatch_tiles_per_reservation ||
+       options->dispatch_reservation_target_ns <= 0)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "adaptive tile reservation requires a maximum of at least %u tiles per "
+        "reservation (have %u) and a positive target duration",
+        options->dispatch_tiles_per_reservation,
+        options->dispatch_max_tiles_per_reservation);
+  }
+  return iree_ok_status();
+}
+
 iree_status_t iree_task_executor_create(
-    iree_task_scheduling_mode_t scheduling_mode,
-    const iree_task_topology_t* topology,
-    iree_host_size_t worker_local_memory_size, iree_allocator_t allocator,
+    const iree_task_executor_options_t* options,
+    const iree_task_topology_t* topology, iree_allocator_t allocator,
     iree_task_executor_t** out_executor) {
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_RETURN_IF_ERROR(iree_task_executor_check_options(options));
   iree_host_size_t worker_count = iree_task_topology_group_count(topology);
   if (worker_count > IREE_TASK_EXECUTOR_MAX_WORKER_COUNT) {
     return iree_make_status(
@@ -37,23 +96,22 @@ iree_status_t iree_task_executor_create(
         IREE_TASK_EXECUTOR_MAX_WORKER_COUNT);
   }
 
-  // TODO(benvanik): support a threadless mode where we have one dummy worker
-  // that just holds the lists but is pumped from donate_caller.
-  if (worker_count == 0) {
-    return iree_make_status(
-        IREE_STATUS_UNIMPLEMENTED,
-        "threadless donate-only executor mode not yet implemented");
-  }
+  // Threadless mode has a single worker that holds the lists but has no thread
+  // of its own; it is pumped by callers from donate_caller.
+  const bool threadless = worker_count == 0;
+  if (threadless) worker_count = 1;
 
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_ASSERT_ARGUMENT(out_executor);
   *out_executor = NULL;
 
-  // The executor is followed in memory by worker[] + worker_local_memory[].
-  // The whole point is that we don't want destructive sharing between workers
-  // so ensure we are aligned to at least the destructive interference size.
-  worker_local_memory_size = iree_host_align(
-      worker_local_memory_size, iree_hardware_destructive_interference_size);
+  // The executor is followed in memory by worker[]. Each worker allocates its
+  // own local memory so that it can be placed near the worker. The whole point
+  // is that we don't want destructive sharing between workers so ensure we are
+  // aligned to at least the destructive interference size.
+  const iree_host_size_t worker_local_memory_size =
+      iree_host_align(options->worker_local_memory_size,
+                      iree_hardware_destructive_interference_size);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)worker_local_memory_size);
   iree_host_size_t executor_base_size =
       iree_host_align(sizeof(iree_task_executor_t),
@@ -61,8 +119,7 @@ iree_status_t iree_task_executor_create(
   iree_host_size_t worker_list_size =
       iree_host_align(worker_count * sizeof(iree_task_worker_t),
                       iree_hardware_destructive_interference_size);
-  iree_host_size_t executor_size = executor_base_size + worker_list_size +
-                                   worker_count * worker_local_memory_size;
+  iree_host_size_t executor_size = executor_base_size + worker_list_size;
 
   iree_task_executor_t* executor = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -70,9 +127,23 @@ iree_status_t iree_task_executor_create(
   memset(executor, 0, executor_size);
   iree_atomic_ref_count_init(&executor->ref_count);
   executor->allocator = allocator;
-  executor->scheduling_mode = scheduling_mode;
+  memcpy(&executor->options, options, sizeof(executor->options));
+  executor->options.worker_local_memory_size = worker_local_memory_size;
+  executor->options.worker_local_memory_max_size =
+      iree_max(options->worker_local_memory_max_size, worker_local_memory_size);
+  if (!(options->scheduling_mode &
+        IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION)) {
+    executor->options.dispatch_max_tiles_per_reservation =
+        options->dispatch_tiles_per_reservation;
+  }
+  executor->threadless = threadless;
+  iree_atomic_task_affinity_set_store(&executor->donation_affinity_mask,
+                                      iree_task_affinity_for_any_worker(),
+                                      iree_memory_order_relaxed);
   iree_atomic_task_slist_initialize(&executor->incoming_ready_slist);
   iree_slim_mutex_initialize(&executor->coordinator_mutex);
+  iree_slim_mutex_initialize(&executor->threadless_donor_mutex);
+  iree_notification_set_initialize(&executor->worker_wake_set);
 
   // Simple PRNG used to generate seeds for the per-worker PRNGs used to
   // distribute work. This isn't strong (and doesn't need to be); it's just
@@ -107,6 +178,14 @@ iree_status_t iree_task_executor_create(
         &executor->transient_task_pool);
   }
 
+  // Lock-free queue used to hand off submissions from any thread to whichever
+  // thread is acting as the coordinator.
+  if (iree_status_is_ok(status)) {
+    status = iree_atomic_mpmc_queue_initialize(
+        IREE_TASK_EXECUTOR_INCOMING_QUEUE_CAPACITY, allocator,
+        &executor->incoming_ready_queue);
+  }
+
   // Wait handling polling and waiting use a dedicated thread to ensure that
   // blocking syscalls stay off the workers.
   if (iree_status_is_ok(status)) {
@@ -124,8 +203,11 @@ iree_status_t iree_task_executor_create(
     executor->worker_count = worker_count;
     executor->workers =
         (iree_task_worker_t*)((uint8_t*)executor + executor_base_size);
-    uint8_t* worker_local_memory =
-        (uint8_t*)executor->workers + worker_list_size;
+    // Threadless executors have no topology groups to pull from so the caller
+    // worker gets a default group that allows any affinity (it'll be running
+    // on whatever thread donates itself anyway).
+    iree_task_topology_group_t caller_group;
+    iree_task_topology_group_initialize(0, &caller_group);
 
     iree_task_affinity_set_t worker_idle_mask = 0;
     iree_task_affinity_set_t worker_live_mask = 0;
@@ -134,17 +216,17 @@ iree_status_t iree_task_executor_create(
       iree_task_affinity_set_t worker_bit = iree_task_affinity_for_worker(i);
       worker_idle_mask |= worker_bit;
       worker_live_mask |= worker_bit;
-      if (executor->scheduling_mode &
-          IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP) {
+      if (!threadless && (executor->options.scheduling_mode &
+                          IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP)) {
         worker_suspend_mask |= worker_bit;
       }
 
       iree_task_worker_t* worker = &executor->workers[i];
       status = iree_task_worker_initialize(
-          executor, i, iree_task_topology_get_group(topology, i),
-          iree_make_byte_span(worker_local_memory, worker_local_memory_size),
-          &seed_prng, worker);
-      worker_local_memory += worker_local_memory_size;
+          executor, i,
+          threadless ? &caller_group
+                     : iree_task_topology_get_group(topology, i),
+          worker_local_memory_size, &seed_prng, worker);
       if (!iree_status_is_ok(status)) break;
     }
     iree_atomic_task_affinity_set_store(&executor->worker_live_mask,
@@ -197,9 +279,18 @@ static void iree_task_executor_destroy(iree_task_executor_t* executor) {
   // Once no more workers can possibly put work on the poller we can kill it.
   iree_task_poller_deinitialize(&executor->poller);
 
+  // All workers have exited and the statistics are final.
+  if (executor->exit_statistics_file) {
+    IREE_IGNORE_ERROR(iree_task_executor_statistics_fprint(
+        executor->exit_statistics_file, executor));
+  }
+
   iree_event_pool_free(executor->event_pool);
+  iree_notification_set_deinitialize(&executor->worker_wake_set);
   iree_slim_mutex_deinitialize(&executor->coordinator_mutex);
+  iree_slim_mutex_deinitialize(&executor->threadless_donor_mutex);
   iree_atomic_task_slist_deinitialize(&executor->incoming_ready_slist);
+  iree_atomic_mpmc_queue_deinitialize(&executor->incoming_ready_queue);
   iree_task_pool_deinitialize(&executor->transient_task_pool);
   iree_allocator_free(executor->allocator, executor);
 
@@ -218,6 +309,16 @@ void iree_task_executor_release(iree_task_executor_t* executor) {
   }
 }
 
+bool iree_task_executor_is_threadless(iree_task_executor_t* executor) {
+  return executor->threadless;
+}
+
+void iree_task_executor_set_donation_affinity(
+    iree_task_executor_t* executor, iree_task_affinity_set_t affinity_mask) {
+  iree_atomic_task_affinity_set_store(&executor->donation_affinity_mask,
+                                      affinity_mask, iree_memory_order_relaxed);
+}
+
 void iree_task_executor_trim(iree_task_executor_t* executor) {
   // TODO(benvanik): figure out a good way to do this; the pools require that
   // no tasks are in-flight to trim but our caller can't reliably make that
@@ -227,6 +328,129 @@ void iree_task_executor_trim(iree_task_executor_t* executor) {
   // iree_task_pool_trim(&executor->transient_task_pool);
 }
 
+void iree_task_executor_query_statistics(
+    iree_task_executor_t* executor,
+    iree_task_executor_statistics_t* out_statistics) {
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  out_statistics->worker_count =
+      executor->threadless ? 0 : executor->worker_count;
+  IREE_STATISTICS({
+    // The worker of a threadless executor is only ever pumped by donors.
+    iree_task_worker_statistics_t* worker_statistics =
+        executor->threadless ? &out_statistics->donors
+                             : &out_statistics->workers;
+    for (iree_host_size_t i = 0; i < executor->worker_count; ++i) {
+      iree_task_worker_counters_accumulate(&executor->workers[i].counters,
+                                           worker_statistics);
+    }
+    iree_task_worker_counters_accumulate(&executor->donor_counters,
+                                         &out_statistics->donors);
+  });
+}
+
+iree_status_t iree_task_executor_query_worker_statistics(
+    iree_task_executor_t* executor, iree_host_size_t worker_index,
+    iree_task_worker_statistics_t* out_statistics) {
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  if (executor->threadless || worker_index >= executor->worker_count) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "worker index %zu out of range (%zu workers)",
+                            worker_index,
+                            executor->threadless ? 0 : executor->worker_count);
+  }
+  iree_task_worker_counters_accumulate(
+      &executor->workers[worker_index].counters, out_statistics);
+  return iree_ok_status();
+}
+
+#if IREE_STATISTICS_ENABLE
+// Formats a single line of |statistics| labeled with |label|.
+static iree_status_t iree_task_worker_statistics_format(
+    const char* label, const iree_task_worker_statistics_t* statistics,
+    iree_string_builder_t* builder) {
+  double tiles_per_reservation =
+      statistics->reservation_count
+          ? (double)statistics->tile_count / statistics->reservation_count
+          : 0.0;
+  double wake_latency_us = statistics->wake_count
+                               ? (double)statistics->wake_latency_ns /
+                                     statistics->wake_count / 1000.0
+                               : 0.0;
+  return iree_string_builder_append_format(
+      builder,
+      "%8s: %10" PRId64 " tasks / %10" PRId64 " tiles / %8" PRId64
+      " shards / %8" PRId64 " reservations (%.1f tiles/res) / %8" PRId64
+      " steals of %8" PRId64 " attempts / %8" PRId64 " yields / %8" PRId64
+      " tile steals / %8" PRId64
+      " wakes (%.1fus avg latency) / %10.3fms idle\n",
+      label, statistics->task_count, statistics->tile_count,
+      statistics->shard_count, statistics->reservation_count,
+      tiles_per_reservation,
+      statistics->steal_attempt_count - statistics->steal_failure_count,
+      statistics->steal_attempt_count, statistics->yield_count,
+      statistics->tile_steal_count, statistics->wake_count, wake_latency_us,
+      statistics->idle_duration_ns / 1000000.0);
+}
+#endif  // IREE_STATISTICS_ENABLE
+
+iree_status_t iree_task_executor_statistics_format(
+    iree_task_executor_t* executor, iree_string_builder_t* builder) {
+#if IREE_STATISTICS_ENABLE
+  // This could be prettier/have nice number formatting/etc.
+  const iree_host_size_t worker_count =
+      executor->threadless ? 0 : executor->worker_count;
+  for (iree_host_size_t i = 0; i < worker_count; ++i) {
+    iree_task_worker_statistics_t worker_statistics;
+    IREE_RETURN_IF_ERROR(iree_task_executor_query_worker_statistics(
+        executor, i, &worker_statistics));
+    char label[16];
+    snprintf(label, sizeof(label), "worker%zu", i);
+    IREE_RETURN_IF_ERROR(
+        iree_task_worker_statistics_format(label, &worker_statistics, builder));
+  }
+  iree_task_executor_statistics_t statistics;
+  iree_task_executor_query_statistics(executor, &statistics);
+  IREE_RETURN_IF_ERROR(iree_task_worker_statistics_format(
+      "donors", &statistics.donors, builder));
+  IREE_RETURN_IF_ERROR(iree_task_worker_statistics_format(
+      "workers", &statistics.workers, builder));
+#else
+  // No-op when disabled.
+#endif  // IREE_STATISTICS_ENABLE
+  return iree_ok_status();
+}
+
+iree_status_t iree_task_executor_statistics_fprint(
+    FILE* file, iree_task_executor_t* executor) {
+#if IREE_STATISTICS_ENABLE
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(executor->allocator, &builder);
+
+  iree_status_t status = iree_string_builder_append_cstring(
+      &builder, "[[ iree_task_executor_t statistics ]]\n");
+
+  if (iree_status_is_ok(status)) {
+    status = iree_task_executor_statistics_format(executor, &builder);
+  }
+
+  if (iree_status_is_ok(status)) {
+    fprintf(file, "%.*s", (int)iree_string_builder_size(&builder),
+            iree_string_builder_buffer(&builder));
+  }
+
+  iree_string_builder_deinitialize(&builder);
+  return status;
+#else
+  // No-op.
+  return iree_ok_status();
+#endif  // IREE_STATISTICS_ENABLE
+}
+
+void iree_task_executor_set_exit_statistics_file(iree_task_executor_t* executor,
+                                                 FILE* file) {
+  executor->exit_statistics_file = file;
+}
+
 iree_event_pool_t* iree_task_executor_event_pool(
     iree_task_executor_t* executor) {
   return executor->event_pool;
@@ -343,13 +567,19 @@ void iree_task_executor_schedule_ready_tasks(
 
 void iree_task_executor_merge_submission(iree_task_executor_t* executor,
                                          iree_task_submission_t* submission) {
-  // Concatenate all of the incoming tasks into the submission list.
+  // Hand off the ready tasks as a single chain through the FIFO queue. If the
+  // queue is full (the coordinator is falling behind) we fall back to
+  // concatenating into the overflow slist.
   // Note that the submission stores tasks in LIFO order such that when they are
   // put into the LIFO atomic slist they match the order across all concats
   // (earlier concats are later in the LIFO list).
-  iree_atomic_task_slist_concat(&executor->incoming_ready_slist,
-                                submission->ready_list.head,
-                                submission->ready_list.tail);
+  if (!iree_task_list_is_empty(&submission->ready_list) &&
+      !iree_atomic_mpmc_queue_try_enqueue(&executor->incoming_ready_queue,
+                                          submission->ready_list.head)) {
+    iree_atomic_task_slist_concat(&executor->incoming_ready_slist,
+                                  submission->ready_list.head,
+                                  submission->ready_list.tail);
+  }
 
   // Enqueue waiting tasks with the poller immediately: this may issue a
   // syscall to kick the poller. If we see bad context switches here then we
@@ -366,7 +596,7 @@ void iree_task_executor_submit(iree_task_executor_t* executor,
                                iree_task_submission_t* submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Concatenate the submitted tasks onto our primary LIFO incoming lists.
+  // Enqueue the submitted tasks onto our primary incoming queue.
   iree_task_executor_merge_submission(executor, submission);
 
   IREE_TRACE_ZONE_END(z0);
@@ -383,6 +613,35 @@ void iree_task_executor_flush(iree_task_executor_t* executor) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Flushes incoming submissions into |out_submission| in the order they were
+// submitted. At most one queue capacity worth of submissions is taken so that
+// we don't spin here forever if submitters outpace us; anything remaining will
+// be picked up by the next coordination pass. Tasks that spilled to the
+// overflow slist are appended last.
+static void iree_task_executor_flush_incoming(
+    iree_task_executor_t* executor, iree_task_submission_t* out_submission) {
+  iree_task_submission_initialize(out_submission);
+  iree_host_size_t capacity =
+      iree_atomic_mpmc_queue_capacity(&executor->incoming_ready_queue);
+  void* value = NULL;
+  for (iree_host_size_t i = 0;
+       i < capacity && iree_atomic_mpmc_queue_try_dequeue(
+                           &executor->incoming_ready_queue, &value);
+       ++i) {
+    iree_task_list_t chain;
+    chain.head = (iree_task_t*)value;
+    chain.tail = chain.head;
+    while (chain.tail->next_task) chain.tail = chain.tail->next_task;
+    iree_task_list_append(&out_submission->ready_list, &chain);
+  }
+
+  iree_task_submission_t overflow_submission;
+  iree_task_submission_initialize_from_lifo_slist(
+      &executor->incoming_ready_slist, &overflow_submission);
+  iree_task_list_append(&out_submission->ready_list,
+                        &overflow_submission.ready_list);
+}
+
 // Dispatches tasks in the global submission queue to workers.
 // This is called by users upon submission of new tasks or by workers when they
 // run out of tasks to process. If |current_worker| is provided then tasks will
@@ -418,8 +677,7 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     // various places and have no relation - hopefully leading to better average
     // latency.
     iree_task_submission_t pending_submission;
-    iree_task_submission_initialize_from_lifo_slist(
-        &executor->incoming_ready_slist, &pending_submission);
+    iree_task_executor_flush_incoming(executor, &pending_submission);
     if (iree_task_list_is_empty(&pending_submission.ready_list)) break;
 
     // Scratch coordinator submission batch used during scheduling to batch up
@@ -452,9 +710,9 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 }
 
 static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
-    iree_task_executor_t* executor, iree_task_affinity_set_t victim_mask,
-    uint32_t max_theft_attempts, int rotation_offset,
-    iree_task_queue_t* local_task_queue) {
+    iree_task_executor_t* executor, iree_task_affinity_set_t thief_affinity_set,
+    iree_task_affinity_set_t victim_mask, uint32_t max_theft_attempts,
+    int rotation_offset, iree_task_queue_t* local_task_queue) {
   if (!victim_mask) return NULL;
   max_theft_attempts = iree_min(max_theft_attempts,
                                 iree_task_affinity_set_count_ones(victim_mask));
@@ -488,8 +746,8 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
     // thievery taking ~half of the tasks each time (across all queues) will
     // lead to a relatively even distribution.
     iree_task_t* task = iree_task_worker_try_steal_task(
-        victim_worker, local_task_queue,
-        /*max_tasks=*/IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT);
+        victim_worker, local_task_queue, thief_affinity_set,
+        /*max_tasks=*/executor->options.worker_max_theft_task_count);
     if (task) return task;
   }
 
@@ -512,7 +770,7 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 // instead of bouncing around at random we just select the starting point in
 // our search and then go in-order.
 iree_task_t* iree_task_executor_try_steal_task(
-    iree_task_executor_t* executor,
+    iree_task_executor_t* executor, iree_task_affinity_set_t thief_affinity_set,
     iree_task_affinity_set_t constructive_sharing_mask,
     uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
     iree_task_queue_t* local_task_queue) {
@@ -539,14 +797,14 @@ iree_task_t* iree_task_executor_try_steal_task(
   // that we won't need to go back to main memory (or higher cache tiers) in the
   // event that the thief and victim are running close to each other in time.
   iree_task_t* task = iree_task_executor_try_steal_task_from_affinity_set(
-      executor, victim_mask & constructive_sharing_mask, max_theft_attempts,
-      rotation_offset, local_task_queue);
+      executor, thief_affinity_set, victim_mask & constructive_sharing_mask,
+      max_theft_attempts, rotation_offset, local_task_queue);
   if (task) {
     IREE_TRACE_ZONE_APPEND_TEXT(z0, "local");
   } else {
     task = iree_task_executor_try_steal_task_from_affinity_set(
-        executor, victim_mask & ~constructive_sharing_mask, max_theft_attempts,
-        rotation_offset, local_task_queue);
+        executor, thief_affinity_set, victim_mask & ~constructive_sharing_mask,
+        max_theft_attempts, rotation_offset, local_task_queue);
     if (task) {
       IREE_TRACE_ZONE_APPEND_TEXT(z0, "non-local");
     }
@@ -556,20 +814,224 @@ iree_task_t* iree_task_executor_try_steal_task(
   return task;
 }
 
+// Executes a |task| stolen from a worker on a donated caller thread.
+// Only task types that are scheduled to workers can be stolen.
+static void iree_task_executor_execute_donated_task(
+    iree_task_executor_t* executor, iree_task_t* task,
+    iree_task_worker_local_memory_t* local_memory,
+    iree_task_submission_t* pending_submission) {
+  switch (task->type) {
+    case IREE_TASK_TYPE_CALL: {
+      iree_task_call_execute((iree_task_call_t*)task, pending_submission);
+      break;
+    }
+    case IREE_TASK_TYPE_DISPATCH_SHARD: {
+      // Grow our local memory if the dispatch requires more. Failures are
+      // reported to the dispatch by the shard when it finds too little memory.
+      iree_task_dispatch_t* dispatch_task =
+          (iree_task_dispatch_t*)task->completion_task;
+      iree_status_ignore(iree_task_worker_local_memory_reserve(
+          local_memory, dispatch_task->local_memory_size,
+          executor->options.worker_local_memory_max_size,
+          executor->allocator));
+      iree_task_dispatch_statistics_t shard_statistics;
+      // Donated threads have no mailbox higher priority work could be posted
+      // to so shards always run to completion. Idle workers only look for
+      // tile ranges to steal in other workers so none are published.
+      iree_task_dispatch_shard_execute(
+          (iree_task_dispatch_shard_t*)task, local_memory->span,
+          /*yield_check=*/NULL, /*reservation=*/NULL, &shard_statistics,
+          pending_submission);
+      iree_task_worker_counters_record_shard(&executor->donor_counters,
+                                             &shard_statistics);
+      break;
+    }
+    default:
+      IREE_ASSERT_UNREACHABLE("incorrect task type for donated execution");
+      break;
+  }
+  iree_task_worker_counters_add(&executor->donor_counters, task_count, 1);
+}
+
+// Tries to steal a task for a donated caller thread from a worker in the
+// donation affinity mask. Returns NULL if no tasks are available.
+// May steal multiple tasks and add them to the |local_task_queue|.
+static iree_task_t* iree_task_executor_try_steal_donated_task(
+    iree_task_executor_t* executor, iree_task_queue_t* local_task_queue) {
+  // Unlike workers we never fall back to stealing from outside of the mask as
+  // the user has explicitly told us to keep donors away from them.
+  iree_task_affinity_set_t victim_mask =
+      iree_atomic_task_affinity_set_load(&executor->donation_affinity_mask,
+                                         iree_memory_order_relaxed) &
+      iree_atomic_task_affinity_set_load(&executor->worker_live_mask,
+                                         iree_memory_order_relaxed) &
+      ~iree_atomic_task_affinity_set_load(&executor->worker_idle_mask,
+                                          iree_memory_order_relaxed);
+  if (!victim_mask) return NULL;
+  int rotation_offset =
+      iree_prng_minilcg128_next_uint8(&executor->donation_theft_prng) &
+      (8 * sizeof(iree_task_affinity_set_t) - 1);
+  // Donors run tasks of any scope so they steal as if they were any worker.
+  iree_task_t* task = iree_task_executor_try_steal_task_from_affinity_set(
+      executor, iree_task_affinity_for_any_worker(), victim_mask,
+      executor->worker_count /
+          executor->options.worker_max_theft_attempts_divisor,
+      rotation_offset, local_task_queue);
+  iree_task_worker_counters_add(&executor->donor_counters, steal_attempt_count,
+                                1);
+  if (!task) {
+    iree_task_worker_counters_add(&executor->donor_counters,
+                                  steal_failure_count, 1);
+  }
+  return task;
+}
+
+// Runs the calling thread as a temporary worker until |wait_source| resolves
+// or |deadline_ns| elapses. Tasks are stolen from workers in the donation
+// affinity mask into |local_task_queue| and executed inline.
+static iree_status_t iree_task_executor_donate_until_resolved(
+    iree_task_executor_t* executor, iree_wait_source_t wait_source,
+    iree_time_t deadline_ns, iree_task_worker_local_memory_t* local_memory,
+    iree_task_queue_t* local_task_queue) {
+  while (true) {
+    // Drain everything we've stolen before checking the wait source; nothing
+    // else can run the tasks in our local queue once we've taken them.
+    iree_task_submission_t pending_submission;
+    iree_task_submission_initialize(&pending_submission);
+    iree_task_t* task = NULL;
+    bool did_work = false;
+    while ((task = iree_task_queue_pop_front(local_task_queue)) ||
+           (task = iree_task_executor_try_steal_donated_task(
+                executor, local_task_queue))) {
+      iree_task_executor_execute_donated_task(executor, task, local_memory,
+                                              &pending_submission);
+      did_work = true;
+      if (!iree_task_submission_is_empty(&pending_submission)) break;
+    }
+
+    // Route any tasks readied by the work we did to the workers (and maybe
+    // back to us on the next pass).
+    if (!iree_task_submission_is_empty(&pending_submission)) {
+      iree_task_executor_submit(executor, &pending_submission);
+      iree_task_executor_flush(executor);
+    }
+
+    iree_status_code_t wait_status_code = IREE_STATUS_OK;
+    IREE_RETURN_IF_ERROR(
+        iree_wait_source_query(wait_source, &wait_status_code));
+    if (wait_status_code != IREE_STATUS_DEFERRED) {
+      return iree_status_from_code(wait_status_code);
+    }
+    if (did_work) continue;
+
+    // Nothing to steal; block on the wait source for a bit before looking for
+    // more work. We aren't a worker and won't be notified when work arrives.
+    iree_time_t now_ns = iree_time_now();
+    if (now_ns >= deadline_ns) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    iree_time_t slice_deadline_ns = iree_min(
+        deadline_ns, now_ns + executor->options.donation_wait_slice_ns);
+    iree_status_t status = iree_wait_source_wait_one(
+        wait_source, iree_make_deadline(slice_deadline_ns));
+    if (!iree_status_is_deadline_exceeded(status)) return status;
+    iree_status_ignore(status);
+  }
+}
+
+// Pumps the worker of a threadless |executor| until |wait_source| resolves or
+// |deadline_ns| elapses. Only one caller may pump the worker at a time; others
+// wait on their wait sources in slices and take over pumping if the current
+// pumping caller returns before their wait sources have resolved.
+static iree_status_t iree_task_executor_pump_threadless(
+    iree_task_executor_t* executor, iree_wait_source_t wait_source,
+    iree_time_t deadline_ns) {
+  while (true) {
+    if (iree_slim_mutex_try_lock(&executor->threadless_donor_mutex)) {
+      iree_status_t status = iree_task_worker_pump_until_resolved(
+          &executor->workers[0], wait_source, iree_make_deadline(deadline_ns));
+      iree_slim_mutex_unlock(&executor->threadless_donor_mutex);
+      return status;
+    }
+
+    iree_status_code_t wait_status_code = IREE_STATUS_OK;
+    IREE_RETURN_IF_ERROR(
+        iree_wait_source_query(wait_source, &wait_status_code));
+    if (wait_status_code != IREE_STATUS_DEFERRED) {
+      return iree_status_from_code(wait_status_code);
+    }
+    iree_time_t now_ns = iree_time_now();
+    if (now_ns >= deadline_ns) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    iree_time_t slice_deadline_ns = iree_min(
+        deadline_ns, now_ns + executor->options.donation_wait_slice_ns);
+    iree_status_t status = iree_wait_source_wait_one(
+        wait_source, iree_make_deadline(slice_deadline_ns));
+    if (!iree_status_is_deadline_exceeded(status)) return status;
+    iree_status_ignore(status);
+  }
+}
+
 iree_status_t iree_task_executor_donate_caller(iree_task_executor_t* executor,
                                                iree_wait_source_t wait_source,
                                                iree_timeout_t timeout) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Perform an immediate flush/coordination (in case the caller queued).
+  // Threadless executors only make progress when a caller is donated so we
+  // have the caller play the role of the worker until the wait resolves.
+  if (executor->threadless) {
+    iree_status_t status = iree_task_executor_pump_threadless(
+        executor, wait_source, iree_timeout_as_deadline_ns(timeout));
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+
+  // If theft is disabled then all we can do is flush and wait.
+  if (!iree_atomic_task_affinity_set_load(&executor->donation_affinity_mask,
+                                          iree_memory_order_relaxed)) {
+    iree_task_executor_flush(executor);
+    iree_status_t status = iree_wait_source_wait_one(
+        wait_source, iree_make_deadline(deadline_ns));
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  // Donated threads need their own local memory to run dispatch shards as the
+  // worker local memory is exclusively owned by each worker.
+  iree_task_worker_local_memory_t local_memory;
+  memset(&local_memory, 0, sizeof(local_memory));
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_task_worker_local_memory_reserve(
+              &local_memory, executor->options.worker_local_memory_size,
+              executor->options.worker_local_memory_max_size,
+              executor->allocator));
+
+  // We don't know what FPU state the calling thread has been configured with
+  // so we match what the workers use while executing tasks on their behalf.
+  iree_fpu_state_t fpu_state =
+      iree_fpu_state_push(IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
+
+  // Register as a donor prior to flushing so that any dispatches issued now
+  // will have shards available for us to steal.
+  iree_atomic_fetch_add_int32(&executor->donor_count, 1,
+                              iree_memory_order_relaxed);
   iree_task_executor_flush(executor);
 
-  // Wait until completed.
-  // TODO(benvanik): make this steal tasks until wait_handle resolves?
-  // Somewhat dangerous as we don't know what kind of thread we are running on;
-  // it may have a smaller stack than we are expecting or have some weird thread
-  // local state (FPU rounding modes/etc).
-  iree_status_t status = iree_wait_source_wait_one(wait_source, timeout);
+  iree_task_queue_t local_task_queue;
+  iree_task_queue_initialize(&local_task_queue);
+  iree_status_t status = iree_task_executor_donate_until_resolved(
+      executor, wait_source, deadline_ns, &local_memory, &local_task_queue);
+  IREE_ASSERT(iree_task_queue_is_empty(&local_task_queue));
+  iree_task_queue_deinitialize(&local_task_queue);
+
+  iree_atomic_fetch_sub_int32(&executor->donor_count, 1,
+                              iree_memory_order_relaxed);
+
+  iree_fpu_state_pop(fpu_state);
+  iree_task_worker_local_memory_release(&local_memory, executor->allocator);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
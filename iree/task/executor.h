@@ -8,6 +8,7 @@
 #define IREE_TASK_EXECUTOR_H_
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include "iree/base/api.h"
 #include "iree/base/internal/atomics.h"
@@ -112,15 +113,16 @@ extern "C" {
 //      the ready_list. If it is initially waiting on an external resource such
 //      as iree_wait_handle_t then it is placed into the waiting_list.
 //
-// 2. iree_task_executor_submit (LIFO, atomic slist)
-//    Submissions have their task thread-local lists concatenated into a LIFO
-//    incoming_ready_slist or the wait poller shared by the executor.
+// 2. iree_task_executor_submit (FIFO, lock-free MPMC queue)
+//    Submissions have their task thread-local lists enqueued as a single chain
+//    into the incoming_ready_queue (spilling to a LIFO incoming_ready_slist if
+//    the queue is full) or the wait poller shared by the executor.
 //
 // 3. iree_task_executor_flush (or a worker puts on its coordinator hat 🎩)
 //
-//   a. Tasks are flushed from the incoming_ready_slist into a coordinator-local
-//      FIFO task queue. This centralizes enqueuing from all threads into a
-//      single ordered list.
+//   a. Tasks are flushed from the incoming_ready_queue and slist into a
+//      coordinator-local FIFO task queue. This centralizes enqueuing from all
+//      threads into a single ordered list.
 //
 //   b. iree_task_executor_schedule_ready_tasks: walks the FIFO task queue and
 //      builds a iree_task_post_batch_t containing the per-worker tasks
@@ -282,26 +284,145 @@ enum iree_task_scheduling_mode_bits_t {
   // much faster schedule all worker quantums and in many cases all workers will
   // begin processing simultaneously immediately after the submission is made.
   IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP = 1u << 0,
+
+  // Adapts the number of tiles each dispatch shard reserves from the grid at a
+  // time based on the observed cost of the tiles. Shards start reserving
+  // dispatch_tiles_per_reservation tiles and double the amount while the
+  // reservations complete faster than dispatch_reservation_target_ns up to
+  // dispatch_max_tiles_per_reservation.
+  //
+  // Prefer this setting when dispatches are dominated by many tiny tiles (such
+  // as elementwise operations over large tensors) where the per-reservation
+  // atomics shared by all shards start to dominate. Dispatches with expensive
+  // tiles are unaffected as their reservations will never grow.
+  IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION = 1u << 1,
 };
 typedef uint32_t iree_task_scheduling_mode_t;
 
+// Options controlling the behavior of an executor.
+// The defaults are defined in iree/task/tuning.h and are a reasonable starting
+// point for most systems; workloads and machines that differ from those
+// assumptions (small/large core counts, tiny/huge dispatches, etc) can tune
+// them here instead of needing to rebuild.
+//
+// Must be initialized with iree_task_executor_options_initialize prior to use.
+typedef struct iree_task_executor_options_t {
+  // Defines how work is selected across queues.
+  iree_task_scheduling_mode_t scheduling_mode;
+
+  // Bytes to be allocated and reserved up front for each worker to use for
+  // local memory operations. May be 0 to allocate the memory lazily when the
+  // first dispatch requiring it executes on the worker.
+  iree_host_size_t worker_local_memory_size;
+
+  // Maximum bytes of local memory each worker may grow to in order to satisfy
+  // the requirements of the dispatches it executes. Dispatches performed will
+  // be able to request up to this amount of memory for their invocations and
+  // no more. See IREE_TASK_EXECUTOR_DEFAULT_WORKER_LOCAL_MEMORY_MAX_SIZE.
+  iree_host_size_t worker_local_memory_max_size;
+
+  // Maximum number of tasks that will be stolen in one go from another worker.
+  // See IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT.
+  iree_host_size_t worker_max_theft_task_count;
+
+  // Divides the total number of workers a worker will attempt to steal from.
+  // See IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR.
+  uint32_t worker_max_theft_attempts_divisor;
+
+  // Amount of time that can remain in a delay task while still retiring.
+  // See IREE_TASK_EXECUTOR_DELAY_SLOP_NS.
+  iree_duration_t delay_slop_ns;
+
+  // Maximum amount of time a donated caller thread will block on its wait
+  // source before checking again for tasks it can steal.
+  // See IREE_TASK_EXECUTOR_DONATION_WAIT_SLICE_NS.
+  iree_duration_t donation_wait_slice_ns;
+
+  // Number of tiles that will be batched into a single reservation from the
+  // dispatch grid. When IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION is
+  // set this is the initial amount reserved by each shard.
+  // See IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION.
+  uint32_t dispatch_tiles_per_reservation;
+
+  // Maximum number of tiles an adaptive reservation may grow to.
+  // Only used with IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION.
+  uint32_t dispatch_max_tiles_per_reservation;
+
+  // Target duration of each adaptive reservation. Reservations that complete
+  // faster than this will double in size for the next reservation.
+  // Only used with IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION.
+  iree_duration_t dispatch_reservation_target_ns;
+} iree_task_executor_options_t;
+
+// Initializes |out_options| to the default values from iree/task/tuning.h.
+void iree_task_executor_options_initialize(
+    iree_task_executor_options_t* out_options);
+
 // Base task system executor interface.
 typedef struct iree_task_executor_t iree_task_executor_t;
 
-// Creates a task executor using the specified topology.
+// Aggregate scheduling statistics for a worker or set of workers.
+// Counters accumulate from executor creation and are never reset.
+typedef struct iree_task_worker_statistics_t {
+#if IREE_STATISTICS_ENABLE
+  // Total number of tasks executed (calls, dispatch shards, etc).
+  int64_t task_count;
+  // Total number of dispatch tiles executed.
+  int64_t tile_count;
+  // Total number of tile ranges reserved from dispatch grids. Each reservation
+  // is an atomic operation on the dispatch shared by all shards; the ratio of
+  // tiles to reservations indicates how much contention is being amortized by
+  // IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION.
+  int64_t reservation_count;
+  // Total number of dispatch shards that executed at least one tile.
+  int64_t shard_count;
+  // Total number of times other workers were searched for tasks to steal.
+  int64_t steal_attempt_count;
+  // Total number of steal attempts that did not find any task to steal.
+  int64_t steal_failure_count;
+  // Total number of times dispatch shards yielded to higher priority tasks.
+  int64_t yield_count;
+  // Total number of tile ranges stolen from dispatch shards executing on other
+  // workers.
+  int64_t tile_steal_count;
+  // Total number of times the worker woke from an idle wait.
+  int64_t wake_count;
+  // Total time spent from when work was posted to an idle worker until the
+  // worker woke to process it. Divide by wake_count for the average latency.
+  iree_duration_t wake_latency_ns;
+  // Total time spent idle waiting for work to be posted.
+  iree_duration_t idle_duration_ns;
+#else
+  int reserved;
+#endif  // IREE_STATISTICS_ENABLE
+} iree_task_worker_statistics_t;
+
+// Executor statistics covering all workers and donated threads.
+typedef struct iree_task_executor_statistics_t {
+  // Total number of workers in the executor. Threadless executors have no
+  // workers and only make progress with donated threads.
+  iree_host_size_t worker_count;
+  // Statistics aggregated across all workers.
+  iree_task_worker_statistics_t workers;
+  // Statistics aggregated across all threads that have been donated via
+  // iree_task_executor_donate_caller. Threadless executors attribute all work
+  // performed on donated threads here.
+  iree_task_worker_statistics_t donors;
+} iree_task_executor_statistics_t;
+
+// Creates a task executor using the specified |options| and |topology|.
 //
-// |worker_local_memory_size| defines the bytes to be allocated and reserved for
-// each worker to use for local memory operations. Will be rounded up to the
-// next power of two. Dispatches performed will be able to request up to this
-// amount of memory for their invocations and no more. May be 0 if no worker
-// local memory is required.
+// If |topology| has no groups then the executor is created in threadless mode:
+// no worker threads are spawned and all tasks are executed on threads donated
+// via iree_task_executor_donate_caller. This trades away concurrency for
+// latency as there are no cross-thread hops between the submitter and the
+// thread executing the work.
 //
-// |topology| is only used during creation and need not live beyond this call.
-// |out_executor| must be released by the caller.
+// |options| and |topology| are only used during creation and need not live
+// beyond this call. |out_executor| must be released by the caller.
 iree_status_t iree_task_executor_create(
-    iree_task_scheduling_mode_t scheduling_mode,
-    const iree_task_topology_t* topology,
-    iree_host_size_t worker_local_memory_size, iree_allocator_t allocator,
+    const iree_task_executor_options_t* options,
+    const iree_task_topology_t* topology, iree_allocator_t allocator,
     iree_task_executor_t** out_executor);
 
 // Retains the given |executor| for the caller.
@@ -310,9 +431,58 @@ void iree_task_executor_retain(iree_task_executor_t* executor);
 // Releases the given |executor| from the caller.
 void iree_task_executor_release(iree_task_executor_t* executor);
 
+// Returns true if the executor has no worker threads of its own and only makes
+// progress when callers donate their threads with
+// iree_task_executor_donate_caller.
+bool iree_task_executor_is_threadless(iree_task_executor_t* executor);
+
+// Sets the mask of workers that threads donated with
+// iree_task_executor_donate_caller may steal tasks from. By default all
+// workers are eligible. Restricting the mask to workers that share caches with
+// the donating threads avoids having the donors thrash the caches of unrelated
+// clusters and a mask of 0 disables theft such that donors only wait.
+//
+// Safe to call from any thread; donors already stealing may observe the
+// change on their next theft attempt.
+void iree_task_executor_set_donation_affinity(
+    iree_task_executor_t* executor, iree_task_affinity_set_t affinity_mask);
+
 // Trims pools and caches used by the executor and its workers.
 void iree_task_executor_trim(iree_task_executor_t* executor);
 
+// Queries the aggregate statistics of the executor since creation.
+// Thread-safe; counters are captured at the time the call is made though
+// individual counters may be updated concurrently and tear.
+//
+// NOTE: statistics may be compiled out in some configurations and this call
+// will only populate the worker count.
+void iree_task_executor_query_statistics(
+    iree_task_executor_t* executor,
+    iree_task_executor_statistics_t* out_statistics);
+
+// Queries the statistics of the worker at |worker_index| since creation.
+// Thread-safe with the same caveats as iree_task_executor_query_statistics.
+iree_status_t iree_task_executor_query_worker_statistics(
+    iree_task_executor_t* executor, iree_host_size_t worker_index,
+    iree_task_worker_statistics_t* out_statistics);
+
+// Formats the per-worker and aggregate executor statistics as a pretty-printed
+// multi-line string.
+iree_status_t iree_task_executor_statistics_format(
+    iree_task_executor_t* executor, iree_string_builder_t* builder);
+
+// Prints the per-worker and aggregate statistics of |executor| to |file|.
+// No-op if statistics are not enabled (IREE_STATISTICS_ENABLE).
+iree_status_t iree_task_executor_statistics_fprint(
+    FILE* file, iree_task_executor_t* executor);
+
+// Sets a |file| the executor statistics will be printed to when the executor
+// is destroyed or NULL to disable. Useful for reporting the scheduling behavior
+// over the lifetime of an executor whose ownership is shared with systems
+// (such as HAL drivers) that release it at some indeterminate time.
+void iree_task_executor_set_exit_statistics_file(iree_task_executor_t* executor,
+                                                 FILE* file);
+
 // Returns an iree_event_t pool managed by the executor.
 // Users of the task system should acquire their transient events from this.
 // Long-lived events should be allocated on their own in order to avoid
@@ -356,10 +526,13 @@ void iree_task_executor_flush(iree_task_executor_t* executor);
 // resolves or |timeout| is exceeded. Flushes any pending task batches prior
 // to doing any work or waiting.
 //
+// While waiting the caller acts as a temporary worker: incoming submissions are
+// coordinated and tasks are stolen from the workers allowed by
+// iree_task_executor_set_donation_affinity and executed on the calling thread.
 // If there are no tasks available then the calling thread will block as if
-// iree_wait_source_wait_one had been used on |wait_source|. If tasks are ready
-// then the caller will not block prior to starting to perform work on behalf of
-// the executor.
+// iree_wait_source_wait_one had been used on |wait_source|, periodically
+// waking to look for more work. If tasks are ready then the caller will not
+// block prior to starting to perform work on behalf of the executor.
 //
 // Donation is intended as an optimization to elide context switches when the
 // caller would have waited anyway; now instead of performing a kernel wait and
@@ -379,6 +552,12 @@ void iree_task_executor_flush(iree_task_executor_t* executor);
 // Especially in large applications it's almost certainly better to do something
 // useful with the calling thread (even if that's go to sleep).
 //
+// Threadless executors (created with an empty topology) only make progress
+// while a caller is donated and the calling thread will execute tasks until
+// |wait_source| resolves. Wait sources that are resolved by tasks running on
+// the executor will be observed as soon as the task completes; wait sources
+// resolved externally are observed within the executor delay_slop_ns.
+//
 // Safe to call from any thread (though bad to reentrantly call from workers).
 iree_status_t iree_task_executor_donate_caller(iree_task_executor_t* executor,
                                                iree_wait_source_t wait_source,
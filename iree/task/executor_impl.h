@@ -7,6 +7,7 @@
 #ifndef IREE_TASK_EXECUTOR_IMPL_H_
 #define IREE_TASK_EXECUTOR_IMPL_H_
 
+#include "iree/base/internal/atomic_mpmc_queue.h"
 #include "iree/base/internal/math.h"
 #include "iree/base/internal/prng.h"
 #include "iree/base/internal/synchronization.h"
@@ -30,9 +31,21 @@ struct iree_task_executor_t {
   iree_atomic_ref_count_t ref_count;
   iree_allocator_t allocator;
 
-  // Defines how work is selected across queues.
-  // TODO(benvanik): make mutable; currently always the same reserved value.
-  iree_task_scheduling_mode_t scheduling_mode;
+  // Options the executor was created with. The worker local memory size is
+  // rounded up to the size actually reserved for each worker.
+  // TODO(benvanik): make the scheduling mode mutable.
+  iree_task_executor_options_t options;
+
+  // True if the executor has no worker threads and is only pumped by callers
+  // donating their threads. In this mode there is a single worker in |workers|
+  // that holds the task lists but has no thread of its own.
+  bool threadless;
+
+  // Held by the caller currently pumping the worker of a threadless executor.
+  // The worker local memory and its wake set member may only be used by one
+  // thread at a time so concurrent donors wait on their own wait sources until
+  // they can take over.
+  iree_slim_mutex_t threadless_donor_mutex;
 
   // State used by the work-stealing operations performed by donated threads.
   // This is **NOT SYNCHRONIZED** and relies on the fact that we actually don't
@@ -42,6 +55,22 @@ struct iree_task_executor_t {
   // extra layer of PRNG anyway ;)
   iree_prng_minilcg128_state_t donation_theft_prng;
 
+  // A bitset indicating which workers donated caller threads may steal tasks
+  // from. Callers can restrict this to workers that share caches with the
+  // threads they expect to donate or set it to 0 to disable theft entirely.
+  iree_atomic_task_affinity_set_t donation_affinity_mask;
+
+  // Number of caller threads currently donated to the executor and stealing
+  // work. Dispatches issued while donors are active will create additional
+  // shards so that the donors have something to steal.
+  iree_atomic_int32_t donor_count;
+
+  // Statistics counters shared by all donated caller threads.
+  iree_task_worker_counters_t donor_counters;
+
+  // Optional file the executor statistics are printed to upon destruction.
+  FILE* exit_statistics_file;
+
   // Pools of transient dispatch tasks shared across all workers.
   // Depending on configuration the task pool may allocate after creation using
   // the allocator provided upon executor creation.
@@ -52,7 +81,15 @@ struct iree_task_executor_t {
   // Increasing the size larger than these will waste memory.
   iree_task_pool_t transient_task_pool;
 
-  // A list of incoming tasks that are ready to execute immediately.
+  // A bounded FIFO queue of incoming submissions from any thread. Each entry is
+  // the head of a NULL-terminated chain of ready tasks (linked by next_task) in
+  // the LIFO order they were recorded in the submission. Submissions are
+  // drained in the order they were enqueued so that work submitted earlier is
+  // scheduled earlier; when the queue is full the submission spills to the
+  // incoming_ready_slist below.
+  iree_atomic_mpmc_queue_t incoming_ready_queue;
+
+  // Overflow list of incoming tasks that are ready to execute immediately.
   // The list is LIFO and we require that task lists are reversed by the
   // submitter so we can use iree_atomic_slist_concat to quickly prepend the
   // LIFO list to the atomic slist. By doing this we can construct the task
@@ -102,6 +139,17 @@ struct iree_task_executor_t {
   // on already woken workers.
   iree_atomic_task_affinity_set_t worker_idle_mask;
 
+  // Notifications used to wake idle workers when work is posted to them.
+  // Each worker waits on the member matching its worker index such that
+  // coordinators can wake all workers they have posted work to at once.
+  iree_notification_set_t worker_wake_set;
+
+  // Rotation offset used when selecting workers for tasks with a wide affinity
+  // set so that we distribute across all of them instead of always favoring
+  // the lowest index. Only touched by the coordinator while it holds the
+  // |coordinator_mutex|.
+  iree_host_size_t worker_rotation_offset;
+
   // Specifies how many workers threads there are.
   // For now this number is fixed per executor however if we wanted to enable
   // live join/leave behavior we could change this to a registration mechanism.
@@ -137,9 +185,10 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
-// May steal multiple tasks and add them to the |local_task_queue|.
+// May steal multiple tasks and add them to the |local_task_queue|. Only tasks
+// with affinity for a worker in |thief_affinity_set| will be stolen.
 iree_task_t* iree_task_executor_try_steal_task(
-    iree_task_executor_t* executor,
+    iree_task_executor_t* executor, iree_task_affinity_set_t thief_affinity_set,
     iree_task_affinity_set_t constructive_sharing_mask,
     uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
     iree_task_queue_t* local_task_queue);
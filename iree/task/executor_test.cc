@@ -7,6 +7,9 @@
 #include "iree/task/executor.h"
 
 #include <cstddef>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 #include "iree/base/internal/prng.h"
 #include "iree/base/tracing.h"
@@ -55,12 +58,11 @@ TEST(ExecutorTest, Any) {
 #endif
 
   iree_task_executor_t* executor = NULL;
-  iree_task_scheduling_mode_t scheduling_mode =
-      IREE_TASK_SCHEDULING_MODE_RESERVED;
-  iree_host_size_t worker_local_memory_size = 0;  // 64 * 1024;
-  IREE_CHECK_OK(iree_task_executor_create(scheduling_mode, &topology,
-                                          worker_local_memory_size, allocator,
-                                          &executor));
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_local_memory_size = 0;  // 64 * 1024;
+  IREE_CHECK_OK(
+      iree_task_executor_create(&options, &topology, allocator, &executor));
   iree_task_topology_deinitialize(&topology);
 
   //
@@ -91,8 +93,6 @@ TEST(ExecutorTest, Any) {
             IREE_TRACE_SCOPE0("tile0");
             EXPECT_EQ(0, user_context);
             simulate_work(tile_context);
-            iree_atomic_fetch_add_int32(&tile_context->statistics->reserved, 1,
-                                        iree_memory_order_relaxed);
             return iree_ok_status();
           },
           0),
@@ -109,8 +109,6 @@ TEST(ExecutorTest, Any) {
             IREE_TRACE_SCOPE0("tile1");
             EXPECT_EQ(0, user_context);
             simulate_work(tile_context);
-            iree_atomic_fetch_add_int32(&tile_context->statistics->reserved, 1,
-                                        iree_memory_order_relaxed);
             return iree_ok_status();
           },
           0),
@@ -165,6 +163,299 @@ TEST(ExecutorTest, Any) {
 
   IREE_CHECK_OK(iree_task_scope_wait_idle(&scope_a, IREE_TIME_INFINITE_FUTURE));
 
+#if IREE_STATISTICS_ENABLE
+  // Every tile of both dispatches should have been accounted for.
+  iree_task_dispatch_statistics_t dispatch_statistics =
+      iree_task_scope_consume_statistics(&scope_a);
+  EXPECT_EQ(32 * 4 * 2 + 16 * 2 * 1,
+            iree_atomic_load_int32(&dispatch_statistics.tile_count,
+                                   iree_memory_order_relaxed));
+  EXPECT_GE(iree_atomic_load_int32(&dispatch_statistics.tile_count,
+                                   iree_memory_order_relaxed),
+            iree_atomic_load_int32(&dispatch_statistics.reservation_count,
+                                   iree_memory_order_relaxed));
+#endif  // IREE_STATISTICS_ENABLE
+
+  iree_task_scope_deinitialize(&scope_a);
+  iree_task_executor_release(executor);
+}
+
+// Tests that an executor with no workers executes tasks on the donating
+// caller thread.
+TEST(ExecutorTest, Threadless) {
+  IREE_TRACE_SCOPE0("ExecutorTest::Threadless");
+
+  iree_allocator_t allocator = iree_allocator_system();
+
+  // An empty topology creates the executor in threadless mode.
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(
+      iree_task_executor_create(&options, &topology, allocator, &executor));
+  iree_task_topology_deinitialize(&topology);
+  EXPECT_TRUE(iree_task_executor_is_threadless(executor));
+
+  iree_task_scope_t scope_a;
+  iree_task_scope_initialize(iree_make_cstring_view("a"), &scope_a);
+
+  iree_atomic_int32_t tile_count = IREE_ATOMIC_VAR_INIT(0);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {8, 4, 2};
+  iree_task_dispatch_t dispatch0;
+  iree_task_dispatch_initialize(
+      &scope_a,
+      iree_task_make_dispatch_closure(
+          [](void* user_context, const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            iree_atomic_fetch_add_int32((iree_atomic_int32_t*)user_context, 1,
+                                        iree_memory_order_relaxed);
+            return iree_ok_status();
+          },
+          (void*)&tile_count),
+      workgroup_size, workgroup_count, &dispatch0);
+
+  // The fence keeps the scope active until the dispatch has completed.
+  iree_task_fence_t* fence0 = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope_a, &fence0));
+  iree_task_set_completion_task(&dispatch0.header, &fence0->header);
+
+  // Nothing can make progress until we donate.
+  iree_task_submission_t sub0;
+  iree_task_submission_initialize(&sub0);
+  iree_task_submission_enqueue(&sub0, &dispatch0.header);
+  iree_task_executor_submit(executor, &sub0);
+  iree_task_executor_flush(executor);
+
+  IREE_CHECK_OK(iree_task_executor_donate_caller(
+      executor, iree_task_scope_await_idle(&scope_a), iree_infinite_timeout()));
+  EXPECT_EQ(8 * 4 * 2, iree_atomic_load_int32(&tile_count,
+                                              iree_memory_order_relaxed));
+
+  // All of the work happened on the donated thread.
+  iree_task_executor_statistics_t statistics;
+  iree_task_executor_query_statistics(executor, &statistics);
+  EXPECT_EQ(0, statistics.worker_count);
+#if IREE_STATISTICS_ENABLE
+  EXPECT_EQ(8 * 4 * 2, statistics.donors.tile_count);
+  EXPECT_EQ(0, statistics.workers.tile_count);
+#endif  // IREE_STATISTICS_ENABLE
+  iree_task_worker_statistics_t worker_statistics;
+  iree_status_t status = iree_task_executor_query_worker_statistics(
+      executor, 0, &worker_statistics);
+  EXPECT_TRUE(iree_status_is_out_of_range(status));
+  iree_status_ignore(status);
+
+  iree_task_scope_deinitialize(&scope_a);
+  iree_task_executor_release(executor);
+}
+
+// Tests that several threads donating to the same threadless executor at once
+// each have their wait resolved and never share local memory while executing
+// tiles.
+TEST(ExecutorTest, ThreadlessConcurrentDonors) {
+  IREE_TRACE_SCOPE0("ExecutorTest::ThreadlessConcurrentDonors");
+
+  iree_allocator_t allocator = iree_allocator_system();
+
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(
+      iree_task_executor_create(&options, &topology, allocator, &executor));
+  iree_task_topology_deinitialize(&topology);
+  ASSERT_TRUE(iree_task_executor_is_threadless(executor));
+
+  static constexpr int kDonorCount = 4;
+  static constexpr uint32_t kLocalMemorySize = 4096;
+  struct donor_state_t {
+    iree_task_scope_t scope;
+    iree_task_dispatch_t dispatch;
+    iree_atomic_int32_t tile_count;
+    iree_atomic_int32_t corrupt_tile_count;
+  } donors[kDonorCount];
+
+  // Each tile fills the local memory with a pattern unique to the tile and
+  // checks that it survives some work; any other thread using the same memory
+  // concurrently will clobber it.
+  auto tile_fn = +[](void* user_context,
+                     const iree_task_tile_context_t* tile_context,
+                     iree_task_submission_t* pending_submission) {
+    donor_state_t* donor = (donor_state_t*)user_context;
+    uint8_t pattern =
+        (uint8_t)(((uintptr_t)donor >> 4) + tile_context->workgroup_xyz[0]);
+    uint8_t* data = tile_context->local_memory.data;
+    memset(data, pattern, tile_context->local_memory.data_length);
+    simulate_work(tile_context);
+    for (iree_host_size_t i = 0; i < tile_context->local_memory.data_length;
+         ++i) {
+      if (data[i] != pattern) {
+        iree_atomic_fetch_add_int32(&donor->corrupt_tile_count, 1,
+                                    iree_memory_order_relaxed);
+        break;
+      }
+    }
+    iree_atomic_fetch_add_int32(&donor->tile_count, 1,
+                                iree_memory_order_relaxed);
+    return iree_ok_status();
+  };
+
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {16, 1, 1};
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  for (int i = 0; i < kDonorCount; ++i) {
+    donor_state_t* donor = &donors[i];
+    iree_task_scope_initialize(iree_make_cstring_view("donor"), &donor->scope);
+    iree_atomic_store_int32(&donor->tile_count, 0, iree_memory_order_relaxed);
+    iree_atomic_store_int32(&donor->corrupt_tile_count, 0,
+                            iree_memory_order_relaxed);
+    iree_task_dispatch_initialize(
+        &donor->scope, iree_task_make_dispatch_closure(tile_fn, donor),
+        workgroup_size, workgroup_count, &donor->dispatch);
+    donor->dispatch.local_memory_size = kLocalMemorySize;
+    iree_task_fence_t* fence = NULL;
+    IREE_CHECK_OK(
+        iree_task_executor_acquire_fence(executor, &donor->scope, &fence));
+    iree_task_set_completion_task(&donor->dispatch.header, &fence->header);
+    iree_task_submission_enqueue(&submission, &donor->dispatch.header);
+  }
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kDonorCount; ++i) {
+    threads.emplace_back([executor, donor = &donors[i]]() {
+      IREE_CHECK_OK(iree_task_executor_donate_caller(
+          executor, iree_task_scope_await_idle(&donor->scope),
+          iree_infinite_timeout()));
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (int i = 0; i < kDonorCount; ++i) {
+    EXPECT_EQ(16, iree_atomic_load_int32(&donors[i].tile_count,
+                                         iree_memory_order_relaxed));
+    EXPECT_EQ(0, iree_atomic_load_int32(&donors[i].corrupt_tile_count,
+                                        iree_memory_order_relaxed));
+    iree_task_scope_deinitialize(&donors[i].scope);
+  }
+  iree_task_executor_release(executor);
+}
+
+// Tests that invalid tuning options are rejected.
+TEST(ExecutorTest, InvalidOptions) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.dispatch_tiles_per_reservation = 0;
+  iree_task_executor_t* executor = NULL;
+  iree_status_t status = iree_task_executor_create(
+      &options, &topology, iree_allocator_system(), &executor);
+  EXPECT_TRUE(iree_status_is_invalid_argument(status));
+  iree_status_ignore(status);
+  EXPECT_EQ(NULL, executor);
+
+  iree_task_executor_options_initialize(&options);
+  options.scheduling_mode |=
+      IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION;
+  options.dispatch_tiles_per_reservation = 16;
+  options.dispatch_max_tiles_per_reservation = 8;
+  status = iree_task_executor_create(&options, &topology,
+                                     iree_allocator_system(), &executor);
+  EXPECT_TRUE(iree_status_is_invalid_argument(status));
+  iree_status_ignore(status);
+  EXPECT_EQ(NULL, executor);
+
+  iree_task_topology_deinitialize(&topology);
+}
+
+// Tests that adaptive tile reservations execute every tile exactly once and
+// grow the reservation size for cheap tiles.
+TEST(ExecutorTest, AdaptiveTileReservation) {
+  IREE_TRACE_SCOPE0("ExecutorTest::AdaptiveTileReservation");
+
+  iree_allocator_t allocator = iree_allocator_system();
+
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.scheduling_mode |=
+      IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION;
+  options.dispatch_tiles_per_reservation = 1;
+  options.dispatch_max_tiles_per_reservation = 1024;
+  // Generous target such that the empty tiles below always grow.
+  options.dispatch_reservation_target_ns = 10 * 1000000;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(
+      iree_task_executor_create(&options, &topology, allocator, &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope_a;
+  iree_task_scope_initialize(iree_make_cstring_view("a"), &scope_a);
+
+  static const uint32_t kTileCount = 64 * 1024;
+  std::vector<iree_atomic_int32_t> tile_hits(kTileCount);
+  for (auto& tile_hit : tile_hits) {
+    iree_atomic_store_int32(&tile_hit, 0, iree_memory_order_relaxed);
+  }
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {kTileCount / 64, 8, 8};
+  iree_task_dispatch_t dispatch0;
+  iree_task_dispatch_initialize(
+      &scope_a,
+      iree_task_make_dispatch_closure(
+          [](void* user_context, const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            auto* tile_hits = (iree_atomic_int32_t*)user_context;
+            uint32_t tile_index =
+                tile_context->workgroup_xyz[0] +
+                tile_context->workgroup_count[0] *
+                    (tile_context->workgroup_xyz[1] +
+                     tile_context->workgroup_count[1] *
+                         tile_context->workgroup_xyz[2]);
+            iree_atomic_fetch_add_int32(&tile_hits[tile_index], 1,
+                                        iree_memory_order_relaxed);
+            return iree_ok_status();
+          },
+          (void*)tile_hits.data()),
+      workgroup_size, workgroup_count, &dispatch0);
+
+  iree_task_fence_t* fence0 = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope_a, &fence0));
+  iree_task_set_completion_task(&dispatch0.header, &fence0->header);
+
+  iree_task_submission_t sub0;
+  iree_task_submission_initialize(&sub0);
+  iree_task_submission_enqueue(&sub0, &dispatch0.header);
+  iree_task_executor_submit(executor, &sub0);
+  IREE_CHECK_OK(iree_task_executor_donate_caller(
+      executor, iree_task_scope_await_idle(&scope_a), iree_infinite_timeout()));
+
+  for (uint32_t i = 0; i < kTileCount; ++i) {
+    ASSERT_EQ(1, iree_atomic_load_int32(&tile_hits[i],
+                                        iree_memory_order_relaxed))
+        << "tile " << i;
+  }
+
+#if IREE_STATISTICS_ENABLE
+  // Reservations should have grown well beyond a single tile.
+  iree_task_dispatch_statistics_t dispatch_statistics =
+      iree_task_scope_consume_statistics(&scope_a);
+  EXPECT_EQ(kTileCount, iree_atomic_load_int32(&dispatch_statistics.tile_count,
+                                               iree_memory_order_relaxed));
+  EXPECT_LT(iree_atomic_load_int32(&dispatch_statistics.reservation_count,
+                                   iree_memory_order_relaxed),
+            kTileCount / 8);
+#endif  // IREE_STATISTICS_ENABLE
+
   iree_task_scope_deinitialize(&scope_a);
   iree_task_executor_release(executor);
 }
@@ -6,6 +6,7 @@
 
 #include "iree/task/poller.h"
 
+#include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/task/executor.h"
 #include "iree/task/executor_impl.h"
@@ -25,7 +26,9 @@ iree_status_t iree_task_poller_initialize(
   out_poller->ideal_thread_affinity = ideal_thread_affinity;
   iree_notification_initialize(&out_poller->state_notification);
   iree_atomic_task_slist_initialize(&out_poller->mailbox_slist);
-  iree_task_list_initialize(&out_poller->wait_list);
+  iree_task_list_initialize(&out_poller->delay_list);
+  out_poller->earliest_deadline_ns = IREE_TIME_INFINITE_FUTURE;
+  out_poller->sweep_required = false;
 
   iree_task_poller_state_t initial_state = IREE_TASK_POLLER_STATE_RUNNING;
   // TODO(benvanik): support initially suspended wait threads. This can reduce
@@ -42,18 +45,37 @@ iree_status_t iree_task_poller_initialize(
       &out_poller->wake_event);
 
   // Wait set used to batch syscalls for polling/waiting on wait handles.
-  // This is currently limited to a relatively small max to make bad behavior
+  // This is limited to a relatively small max when the wait set scans all
+  // handles on each wait (or the platform caps it at 64) to make bad behavior
   // clearer with nice RESOURCE_EXHAUSTED errors. If we start to hit that limit
   // (~63+ simultaneous system waits) we'll need to shard out the wait sets -
-  // possibly with multiple wait threads (one per set).
+  // possibly with multiple wait threads (one per set). When the wait set keeps
+  // handles registered with the kernel (epoll) we can afford many more.
+  // The additional slot is for our wake_event.
+  iree_host_size_t max_outstanding_waits =
+      iree_wait_set_is_scalable()
+          ? IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS_SCALABLE
+          : IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS;
   if (iree_status_is_ok(status)) {
-    status = iree_wait_set_allocate(IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS,
+    status = iree_wait_set_allocate(max_outstanding_waits + 1,
                                     executor->allocator, &out_poller->wait_set);
   }
   if (iree_status_is_ok(status)) {
     status = iree_wait_set_insert(out_poller->wait_set, out_poller->wake_event);
   }
 
+  // Table mapping wait handles to the tasks waiting on them. We keep the load
+  // factor <= 0.5 so that probe sequences stay short; the wait set capacity
+  // bounds the number of unique handles and thus the table can never fill.
+  if (iree_status_is_ok(status)) {
+    out_poller->wait_slot_capacity =
+        iree_math_round_up_to_pow2_u32((uint32_t)max_outstanding_waits) * 2;
+    status = iree_allocator_malloc(
+        executor->allocator,
+        out_poller->wait_slot_capacity * sizeof(*out_poller->wait_slots),
+        (void**)&out_poller->wait_slots);
+  }
+
   iree_thread_create_params_t thread_params;
   memset(&thread_params, 0, sizeof(thread_params));
   thread_params.name = iree_make_cstring_view("iree-poller");
@@ -137,7 +159,14 @@ void iree_task_poller_deinitialize(iree_task_poller_t* poller) {
                             &poller->wake_event);
   }
 
-  iree_task_list_discard(&poller->wait_list);
+  iree_task_list_discard(&poller->delay_list);
+  if (poller->wait_slots) {
+    for (iree_host_size_t i = 0; i < poller->wait_slot_capacity; ++i) {
+      iree_task_list_discard(&poller->wait_slots[i].task_list);
+    }
+    iree_allocator_free(poller->executor->allocator, poller->wait_slots);
+    poller->wait_slots = NULL;
+  }
   iree_atomic_task_slist_discard(&poller->mailbox_slist);
   iree_atomic_task_slist_deinitialize(&poller->mailbox_slist);
   iree_notification_deinitialize(&poller->state_notification);
@@ -164,53 +193,178 @@ void iree_task_poller_enqueue(iree_task_poller_t* poller,
   IREE_TRACE_ZONE_END(z0);
 }
 
-// Acquires a wait handle for |task| and inserts it into |wait_set|.
-static iree_status_t iree_task_poller_insert_wait_handle(
-    iree_wait_set_t* wait_set, iree_task_wait_t* task) {
-  IREE_TRACE_ZONE_BEGIN(z0);
+//===----------------------------------------------------------------------===//
+// Wait slots
+//===----------------------------------------------------------------------===//
+
+// Returns a hash of the wait primitive referenced by |handle|.
+static iree_host_size_t iree_task_poller_hash_wait_handle(
+    const iree_wait_handle_t* handle) {
+  // Primitives are fds/HANDLEs/pointers and are unique in their low bytes.
+  uint64_t key = 0;
+  memcpy(&key, &handle->value, iree_min(sizeof(key), sizeof(handle->value)));
+  key = (key ^ handle->type) * 0x9E3779B97F4A7C15ull;  // Fibonacci hashing
+  return (iree_host_size_t)(key >> 32);
+}
 
-  iree_status_t status = iree_ok_status();
+// Returns the wait slot in |poller| for |handle| or the empty slot it should be
+// inserted into if it is not yet present.
+static iree_task_poller_wait_slot_t* iree_task_poller_find_wait_slot(
+    iree_task_poller_t* poller, const iree_wait_handle_t* handle) {
+  const iree_host_size_t mask = poller->wait_slot_capacity - 1;
+  iree_host_size_t i = iree_task_poller_hash_wait_handle(handle) & mask;
+  while (true) {
+    iree_task_poller_wait_slot_t* slot = &poller->wait_slots[i];
+    if (iree_task_list_is_empty(&slot->task_list) ||
+        (slot->handle.type == handle->type &&
+         memcmp(&slot->handle.value, &handle->value, sizeof(handle->value)) ==
+             0)) {
+      return slot;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+// Removes |slot| from the |poller| wait slot table.
+// Subsequent slots in the probe sequence are shifted back to fill the hole so
+// that lookups never need tombstones. This may move a slot into the position
+// of |slot|.
+static void iree_task_poller_remove_wait_slot(
+    iree_task_poller_t* poller, iree_task_poller_wait_slot_t* slot) {
+  const iree_host_size_t mask = poller->wait_slot_capacity - 1;
+  iree_host_size_t i = (iree_host_size_t)(slot - poller->wait_slots);
+  iree_host_size_t j = i;
+  while (true) {
+    j = (j + 1) & mask;
+    iree_task_poller_wait_slot_t* next_slot = &poller->wait_slots[j];
+    if (iree_task_list_is_empty(&next_slot->task_list)) break;
+    // Slots whose home position lies cyclically within (i, j] must stay put.
+    iree_host_size_t k =
+        iree_task_poller_hash_wait_handle(&next_slot->handle) & mask;
+    if (((j - k) & mask) < ((j - i) & mask)) continue;
+    poller->wait_slots[i] = *next_slot;
+    i = j;
+  }
+  memset(&poller->wait_slots[i], 0, sizeof(poller->wait_slots[i]));
+}
+
+//===----------------------------------------------------------------------===//
+// Wait task management
+//===----------------------------------------------------------------------===//
+
+// Returns the current time, querying it only on first use in a pump.
+// |inout_now_ns| must be initialized to IREE_TIME_INFINITE_PAST.
+static iree_time_t iree_task_poller_now(iree_time_t* inout_now_ns) {
+  if (*inout_now_ns == IREE_TIME_INFINITE_PAST) {
+    *inout_now_ns = iree_time_now();
+  }
+  return *inout_now_ns;
+}
+
+// Returns true if |task| was cancelled by the user (or a wait-any).
+static bool iree_task_poller_is_cancelled(iree_task_wait_t* task) {
+  return task->cancellation_flag != NULL &&
+         iree_atomic_load_int32(task->cancellation_flag,
+                                iree_memory_order_acquire) != 0;
+}
+
+// Retires |task| and enqueues any available completion task.
+// |wait_status_code| indicates how the wait resolved: cancellation is ok and
+// any non-OK code will be propagated to the task scope. Failures in |status|
+// (such as from queries) take precedence.
+static void iree_task_poller_retire_task(
+    iree_task_poller_t* poller, iree_task_wait_t* task,
+    iree_status_code_t wait_status_code, iree_status_t status,
+    iree_task_submission_t* pending_submission) {
+  // If this was part of a wait-any operation then set the cancellation flag
+  // such that other waits are cancelled.
+  if (iree_any_bit_set(task->header.flags, IREE_TASK_FLAG_WAIT_ANY)) {
+    if (iree_atomic_fetch_add_int32(task->cancellation_flag, 1,
+                                    iree_memory_order_release) == 0) {
+      // Ensure we sweep to clean up any potentially cancelled tasks.
+      // If this was task 4 in a wait-any list then tasks 0-3 need to be
+      // retired.
+      poller->sweep_required = true;
+    }
+  }
+
+  task->header.flags &= ~IREE_TASK_FLAG_WAIT_EXPORTED;
+
+  // Note that we pass in the status of the wait query: that propagates any
+  // query failure into the task/task scope.
+  if (iree_status_is_ok(status) && wait_status_code != IREE_STATUS_OK &&
+      wait_status_code != IREE_STATUS_CANCELLED) {
+    status = iree_status_from_code(wait_status_code);
+  }
+  iree_task_wait_retire(task, pending_submission, status);
+}
+
+// Registers |task| with the wait slot for its wait handle, inserting the handle
+// into the wait set if this is the first task waiting on it.
+// Sets |out_wait_status_code| to IREE_STATUS_DEFERRED if the task is now
+// waiting and otherwise to how the wait source resolved.
+static iree_status_t iree_task_poller_register_wait(
+    iree_task_poller_t* poller, iree_task_wait_t* task,
+    iree_status_code_t* out_wait_status_code) {
+  *out_wait_status_code = IREE_STATUS_OK;
 
   iree_wait_handle_t wait_handle = iree_wait_handle_immediate();
   iree_wait_handle_t* wait_handle_ptr =
       iree_wait_handle_from_source(&task->wait_source);
   if (wait_handle_ptr) {
-    // Already a wait handle - can directly insert it.
+    // Already a wait handle - we can directly insert it. We don't query it as
+    // that would be a syscall per handle and the system wait will tell us if
+    // it has already resolved.
     wait_handle = *wait_handle_ptr;
   } else {
+    // Query the status of the wait source to see if it has already been
+    // resolved. Under load we can get lucky and end up with resolved waits
+    // before ever needing to export them for a full system wait. This query
+    // can also avoid making a syscall to check the state of the source such
+    // as when the source is a process-local type.
+    iree_status_code_t wait_status_code = IREE_STATUS_OK;
+    IREE_RETURN_IF_ERROR(
+        iree_wait_source_query(task->wait_source, &wait_status_code));
+    if (wait_status_code != IREE_STATUS_DEFERRED) {
+      *out_wait_status_code = wait_status_code;
+      return iree_ok_status();
+    }
     iree_wait_primitive_t wait_primitive = iree_wait_primitive_immediate();
-    status =
+    IREE_RETURN_IF_ERROR(
         iree_wait_source_export(task->wait_source, IREE_WAIT_PRIMITIVE_TYPE_ANY,
-                                iree_immediate_timeout(), &wait_primitive);
-    if (iree_status_is_ok(status)) {
-      status = iree_wait_handle_wrap_primitive(
-          wait_primitive.type, wait_primitive.value, &wait_handle);
-    }
+                                iree_immediate_timeout(), &wait_primitive));
+    IREE_RETURN_IF_ERROR(iree_wait_handle_wrap_primitive(
+        wait_primitive.type, wait_primitive.value, &wait_handle));
   }
 
-  if (iree_status_is_ok(status)) {
-    status = iree_wait_set_insert(wait_set, wait_handle);
+  // Immediate handles will never be signaled by the system as they are
+  // already resolved.
+  if (iree_wait_handle_is_immediate(wait_handle)) {
+    return iree_ok_status();
   }
 
-  IREE_TRACE_ZONE_END(z0);
-  return status;
-}
+  iree_task_poller_wait_slot_t* slot =
+      iree_task_poller_find_wait_slot(poller, &wait_handle);
+  if (iree_task_list_is_empty(&slot->task_list)) {
+    IREE_RETURN_IF_ERROR(iree_wait_set_insert(poller->wait_set, wait_handle));
+    slot->handle = wait_handle;
+  }
+  task->header.flags |= IREE_TASK_FLAG_WAIT_EXPORTED;
+  iree_task_list_push_back(&slot->task_list, &task->header);
+  poller->earliest_deadline_ns =
+      iree_min(poller->earliest_deadline_ns, task->deadline_ns);
 
-enum iree_task_poller_prepare_result_bits_e {
-  IREE_TASK_POLLER_PREPARE_OK = 0,
-  IREE_TASK_POLLER_PREPARE_RETIRED = 1u << 0,
-  IREE_TASK_POLLER_PREPARE_CANCELLED = 1u << 1,
-};
-typedef uint32_t iree_task_poller_prepare_result_t;
+  *out_wait_status_code = IREE_STATUS_DEFERRED;
+  return iree_ok_status();
+}
 
-// Prepares a wait |task| for waiting.
+// Prepares a newly enqueued wait |task| for waiting.
 // The task will be checked for completion or failure such as deadline exceeded
-// and removed from the wait list if resolved. If unresolved the wait will be
-// prepared for the system wait by ensuring a wait handle is available.
-static iree_task_poller_prepare_result_t iree_task_poller_prepare_task(
+// and retired if resolved. If unresolved the task will be added to the delay
+// list or registered with the wait slot of its wait handle.
+static void iree_task_poller_prepare_task(
     iree_task_poller_t* poller, iree_task_wait_t* task,
-    iree_task_submission_t* pending_submission, iree_time_t now_ns,
-    iree_time_t* earliest_deadline_ns) {
+    iree_task_submission_t* pending_submission, iree_time_t* now_ns) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // Status of the preparation - failures propagate to the task scope.
@@ -221,14 +375,7 @@ static iree_task_poller_prepare_result_t iree_task_poller_prepare_task(
   //   DEADLINE_EXCEEDED: deadline was hit before the wait resolved
   //   CANCELLED: wait was cancelled via the cancellation flag
   iree_status_code_t wait_status_code = IREE_STATUS_DEFERRED;
-  if (iree_all_bits_set(task->header.flags, IREE_TASK_FLAG_WAIT_COMPLETED)) {
-    // Wait was marked as resolved and we just pass that through here.
-    // This allows us to bypass more expensive queries when doing a post-wake
-    // scan of tasks.
-    wait_status_code = IREE_STATUS_OK;
-  } else if (task->cancellation_flag != NULL &&
-             iree_atomic_load_int32(task->cancellation_flag,
-                                    iree_memory_order_acquire) != 0) {
+  if (iree_task_poller_is_cancelled(task)) {
     // Task was cancelled by the user (or a wait-any). These retire without
     // failure and it's up to the user to handle what happens to them.
     wait_status_code = IREE_STATUS_CANCELLED;
@@ -241,173 +388,186 @@ static iree_task_poller_prepare_result_t iree_task_poller_prepare_task(
     // earlier because another wait resolved it's still possible for the delay
     // to have been reached before we get back to this check.
     iree_time_t delay_deadline_ns = (iree_time_t)task->wait_source.data;
-    if (delay_deadline_ns <= now_ns + IREE_TASK_EXECUTOR_DELAY_SLOP_NS) {
+    iree_duration_t delay_slop_ns = poller->executor->options.delay_slop_ns;
+    if (delay_deadline_ns <= iree_task_poller_now(now_ns) + delay_slop_ns) {
       // Wait deadline reached.
       wait_status_code = IREE_STATUS_OK;
     } else {
       // Still waiting.
-      *earliest_deadline_ns =
-          iree_min(*earliest_deadline_ns, delay_deadline_ns);
-      wait_status_code = IREE_STATUS_DEFERRED;
+      iree_task_list_push_back(&poller->delay_list, &task->header);
+      poller->earliest_deadline_ns =
+          iree_min(poller->earliest_deadline_ns, delay_deadline_ns);
     }
+  } else if (task->deadline_ns != IREE_TIME_INFINITE_FUTURE &&
+             task->deadline_ns <= iree_task_poller_now(now_ns)) {
+    // An actual wait that has already exceeded its deadline.
+    wait_status_code = IREE_STATUS_DEADLINE_EXCEEDED;
   } else {
-    // An actual wait. Ensure that the deadline has not been exceeded yet.
-    // If it hasn't yet been hit we'll propagate the deadline to the system wait
-    // API - then on the next pump we'll hit this case and retire the task.
+    // An actual wait. If the deadline is hit before it resolves we'll retire
+    // the task with a failure on the sweep following the system wait timeout.
     IREE_TRACE_ZONE_APPEND_VALUE(z0, task->deadline_ns);
-    IREE_TRACE_ZONE_APPEND_VALUE(z0, now_ns);
-    if (task->deadline_ns <= now_ns) {
-      wait_status_code = IREE_STATUS_DEADLINE_EXCEEDED;
-    } else {
-      // Query the status of the wait source to see if it has already been
-      // resolved. Under load we can get lucky and end up with resolved waits
-      // before ever needing to export them for a full system wait. This query
-      // can also avoid making a syscall to check the state of the source such
-      // as when the source is a process-local type.
-      wait_status_code = IREE_STATUS_OK;
-      status = iree_wait_source_query(task->wait_source, &wait_status_code);
-
-      // TODO(benvanik): avoid this query for wait handles: we don't want to
-      // make one syscall per handle and could rely on the completed bit being
-      // set to retire these.
-    }
-
-    // If the wait has not been resolved then we need to ensure there's an
-    // exported wait handle in the wait set. We only do this on the first time
-    // we prepare the task.
-    if (wait_status_code == IREE_STATUS_DEFERRED) {
-      if (!iree_all_bits_set(task->header.flags,
-                             IREE_TASK_FLAG_WAIT_EXPORTED)) {
-        task->header.flags |= IREE_TASK_FLAG_WAIT_EXPORTED;
-        status = iree_task_poller_insert_wait_handle(poller->wait_set, task);
-      }
-      *earliest_deadline_ns =
-          iree_min(*earliest_deadline_ns, task->deadline_ns);
-    }
+    status = iree_task_poller_register_wait(poller, task, &wait_status_code);
   }
 
-  if (iree_status_is_ok(status) && wait_status_code == IREE_STATUS_DEFERRED) {
-    // Wait is prepared for use and can be waited on.
-    IREE_TRACE_ZONE_END(z0);
-    return IREE_TASK_POLLER_PREPARE_OK;
+  if (!iree_status_is_ok(status) || wait_status_code != IREE_STATUS_DEFERRED) {
+    // If the task was able to be retired (deadline elapsed, completed, etc)
+    // then we send it back to the workers for completion.
+    iree_task_poller_retire_task(poller, task, wait_status_code, status,
+                                 pending_submission);
   }
 
-  // If the task was able to be retired (deadline elapsed, completed, etc)
-  // then we need to unregister it from the poller and send it back to the
-  // workers for completion.
-  iree_task_poller_prepare_result_t result = IREE_TASK_POLLER_PREPARE_RETIRED;
+  IREE_TRACE_ZONE_END(z0);
+}
 
-  // If this was part of a wait-any operation then set the cancellation flag
-  // such that other waits are cancelled.
-  if (iree_any_bit_set(task->header.flags, IREE_TASK_FLAG_WAIT_ANY)) {
-    if (iree_atomic_fetch_add_int32(task->cancellation_flag, 1,
-                                    iree_memory_order_release) == 0) {
-      // Ensure we scan again to clean up any potentially cancelled tasks.
-      // If this was task 4 in a wait-any list then tasks 0-3 need to be
-      // retired.
-      result |= IREE_TASK_POLLER_PREPARE_CANCELLED;
-    }
-  }
+// Merges all wait tasks posted to the |poller| mailbox and prepares them.
+// Resolved/failed waits are enqueued on |pending_submission|.
+static void iree_task_poller_merge_mailbox(
+    iree_task_poller_t* poller, iree_task_submission_t* pending_submission,
+    iree_time_t* now_ns) {
+  iree_task_list_t incoming_list;
+  iree_task_list_initialize(&incoming_list);
+  iree_task_list_append_from_fifo_slist(&incoming_list, &poller->mailbox_slist);
+  if (iree_task_list_is_empty(&incoming_list)) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Remove the system wait handle from the wait set, if assigned.
-  if (iree_all_bits_set(task->header.flags, IREE_TASK_FLAG_WAIT_EXPORTED)) {
-    iree_wait_handle_t* wait_handle =
-        iree_wait_handle_from_source(&task->wait_source);
-    if (wait_handle) {
-      iree_wait_set_erase(poller->wait_set, *wait_handle);
-    }
-    task->header.flags &= ~IREE_TASK_FLAG_WAIT_EXPORTED;
+  int prepared_tasks = 0;
+  while (!iree_task_list_is_empty(&incoming_list)) {
+    iree_task_wait_t* task =
+        (iree_task_wait_t*)iree_task_list_pop_front(&incoming_list);
+    iree_task_poller_prepare_task(poller, task, pending_submission, now_ns);
+    ++prepared_tasks;
   }
 
-  // Retire the task and enqueue any available completion task.
-  // Note that we pass in the status of the wait query above: that propagates
-  // any query failure into the task/task scope.
-  if (iree_status_is_ok(status) && wait_status_code != IREE_STATUS_OK) {
-    // Cancellation is ok - we just ignore those.
-    if (wait_status_code != IREE_STATUS_CANCELLED) {
-      status = iree_status_from_code(wait_status_code);
-    }
-  }
-  iree_task_wait_retire(task, pending_submission, status);
-
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, prepared_tasks);
   IREE_TRACE_ZONE_END(z0);
-  return result;
 }
 
-// Scans all wait tasks in |poller| to see if they have resolved.
-// Resolved/failed waits are enqueued on |pending_submission|.
-// If there are any unresolved delay tasks the earliest deadline will be stored
-// in |out_earliest_deadline_ns| and otherwise it'll be set to
-// IREE_TIME_INFINITE_FUTURE.
-static void iree_task_poller_prepare_wait(
-    iree_task_poller_t* poller, iree_task_submission_t* pending_submission,
-    iree_time_t* out_earliest_deadline_ns) {
+// Sweeps all wait tasks in |poller| to retire those that have been cancelled,
+// have exceeded their deadline, or whose delay has been reached.
+// Resolved/failed waits are enqueued on |pending_submission|. The earliest
+// deadline of all remaining waits is recomputed.
+//
+// This is only needed when a deadline is reached or a wait-any has latched its
+// cancellation flag: waits on handles are otherwise retired directly when the
+// wait set reports them as woken.
+static void iree_task_poller_sweep(iree_task_poller_t* poller,
+                                   iree_task_submission_t* pending_submission,
+                                   iree_time_t now_ns) {
   IREE_TRACE_ZONE_BEGIN(z0);
-  *out_earliest_deadline_ns = IREE_TIME_INFINITE_FUTURE;
-
-  // TODO(benvanik): only query if there are pending delays; this is (likely) a
-  // syscall that we only need to perform if we're going to delay.
-  iree_time_t now_ns = iree_time_now();
+  const iree_duration_t delay_slop_ns = poller->executor->options.delay_slop_ns;
 
-  // Perform the scan over the task list; we may need to retry the scan if we
-  // encounter a situation that would invalidate other waits - such as
-  // cancellation or scope errors.
-  bool retry_scan = false;
+  // We may need to retry the sweep if we encounter a situation that would
+  // invalidate other waits - such as wait-any cancellation.
   do {
-    retry_scan = false;
+    poller->sweep_required = false;
+    poller->earliest_deadline_ns = IREE_TIME_INFINITE_FUTURE;
 
-    // Note that we walk the singly-linked list inline and need to keep track of
-    // the previous task in case we need to unlink one.
+    // Note that we walk the singly-linked lists inline and need to keep track
+    // of the previous task in case we need to unlink one.
     iree_task_t* prev_task = NULL;
-    iree_task_t* task = iree_task_list_front(&poller->wait_list);
+    iree_task_t* task = iree_task_list_front(&poller->delay_list);
     while (task != NULL) {
       iree_task_t* next_task = task->next_task;
-
-      iree_task_poller_prepare_result_t result = iree_task_poller_prepare_task(
-          poller, (iree_task_wait_t*)task, pending_submission, now_ns,
-          out_earliest_deadline_ns);
-      if (iree_all_bits_set(result, IREE_TASK_POLLER_PREPARE_CANCELLED)) {
-        // A task was cancelled; we'll need to retry the scan to clean up any
-        // waits we may have already checked.
-        retry_scan = true;
+      iree_task_wait_t* wait_task = (iree_task_wait_t*)task;
+      iree_time_t delay_deadline_ns = (iree_time_t)wait_task->wait_source.data;
+      iree_status_code_t wait_status_code = IREE_STATUS_DEFERRED;
+      if (iree_task_poller_is_cancelled(wait_task)) {
+        wait_status_code = IREE_STATUS_CANCELLED;
+      } else if (delay_deadline_ns <= now_ns + delay_slop_ns) {
+        wait_status_code = IREE_STATUS_OK;
       }
-
-      if (iree_all_bits_set(result, IREE_TASK_POLLER_PREPARE_RETIRED)) {
-        // Erase the retired task from the wait list.
-        iree_task_list_erase(&poller->wait_list, prev_task, task);
-      } else {
+      if (wait_status_code == IREE_STATUS_DEFERRED) {
+        poller->earliest_deadline_ns =
+            iree_min(poller->earliest_deadline_ns, delay_deadline_ns);
         prev_task = task;
+      } else {
+        iree_task_list_erase(&poller->delay_list, prev_task, task);
+        iree_task_poller_retire_task(poller, wait_task, wait_status_code,
+                                     iree_ok_status(), pending_submission);
       }
       task = next_task;
     }
-  } while (retry_scan);
+
+    for (iree_host_size_t i = 0; i < poller->wait_slot_capacity;) {
+      iree_task_poller_wait_slot_t* slot = &poller->wait_slots[i];
+      if (iree_task_list_is_empty(&slot->task_list)) {
+        ++i;
+        continue;
+      }
+      prev_task = NULL;
+      task = iree_task_list_front(&slot->task_list);
+      while (task != NULL) {
+        iree_task_t* next_task = task->next_task;
+        iree_task_wait_t* wait_task = (iree_task_wait_t*)task;
+        iree_status_code_t wait_status_code = IREE_STATUS_DEFERRED;
+        if (iree_task_poller_is_cancelled(wait_task)) {
+          wait_status_code = IREE_STATUS_CANCELLED;
+        } else if (wait_task->deadline_ns <= now_ns) {
+          wait_status_code = IREE_STATUS_DEADLINE_EXCEEDED;
+        }
+        if (wait_status_code == IREE_STATUS_DEFERRED) {
+          poller->earliest_deadline_ns =
+              iree_min(poller->earliest_deadline_ns, wait_task->deadline_ns);
+          prev_task = task;
+        } else {
+          iree_task_list_erase(&slot->task_list, prev_task, task);
+          iree_task_poller_retire_task(poller, wait_task, wait_status_code,
+                                       iree_ok_status(), pending_submission);
+        }
+        task = next_task;
+      }
+      if (iree_task_list_is_empty(&slot->task_list)) {
+        // Last task waiting on the handle retired; drop it from the wait set.
+        // Another slot may be shifted into this position so we check it again.
+        iree_wait_set_erase(poller->wait_set, slot->handle);
+        iree_task_poller_remove_wait_slot(poller, slot);
+      } else {
+        ++i;
+      }
+    }
+  } while (poller->sweep_required);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
-// Finds tasks in |poller| using the given wait handle and marks them as
-// completed.
-static void iree_task_poller_wake_task(iree_task_poller_t* poller,
-                                       iree_wait_handle_t wake_handle) {
+// Retires all tasks in |poller| waiting on the given wait handle as completed.
+// The handle is removed from the wait set.
+static void iree_task_poller_wake_task(
+    iree_task_poller_t* poller, iree_wait_handle_t wake_handle,
+    iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // TODO(benvanik): scan the list. We need a way to map wake_handle back to
-  // the zero or more tasks that match it but don't currently store the
-  // handle. Ideally we'd have the wait set tell us precisely which things
-  // woke - possibly by having a bitmap of original insertions that match the
-  // handle - but for now we just eat the extra query syscall.
+  iree_task_poller_wait_slot_t* slot =
+      iree_task_poller_find_wait_slot(poller, &wake_handle);
+  iree_task_list_t woken_list;
+  iree_task_list_move(&slot->task_list, &woken_list);
+  if (!iree_task_list_is_empty(&woken_list)) {
+    // NOTE: we pass the wake_handle from the wait set so that it can use the
+    // index it stashed to avoid a scan.
+    iree_wait_set_erase(poller->wait_set, wake_handle);
+    iree_task_poller_remove_wait_slot(poller, slot);
+  }
+
   int woken_tasks = 0;
+  while (!iree_task_list_is_empty(&woken_list)) {
+    iree_task_wait_t* task =
+        (iree_task_wait_t*)iree_task_list_pop_front(&woken_list);
+    iree_task_poller_retire_task(poller, task, IREE_STATUS_OK,
+                                 iree_ok_status(), pending_submission);
+    ++woken_tasks;
+  }
 
-  (void)woken_tasks;
   IREE_TRACE_ZONE_APPEND_VALUE(z0, woken_tasks);
   IREE_TRACE_ZONE_END(z0);
 }
 
 // Commits a system wait on the current wait set in |poller|.
 // The wait will time out after |deadline_ns| is reached and return even if no
-// wait handles were resolved.
-static void iree_task_poller_commit_wait(iree_task_poller_t* poller,
-                                         iree_time_t deadline_ns) {
+// wait handles were resolved. Tasks using a woken wait handle are retired and
+// enqueued on |pending_submission|.
+static void iree_task_poller_commit_wait(
+    iree_task_poller_t* poller, iree_time_t deadline_ns,
+    iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // Enter the system wait API.
@@ -416,12 +576,8 @@ static void iree_task_poller_commit_wait(iree_task_poller_t* poller,
       iree_wait_any(poller->wait_set, deadline_ns, &wake_handle);
   if (iree_status_is_ok(status)) {
     // One or more waiters is ready. We don't support multi-wake right now so
-    // we'll just take the one we got back and try again.
-    //
-    // To avoid extra syscalls we scan the list and mark whatever tasks were
-    // using the handle the wait set reported waking as completed. On the next
-    // scan they'll be retired immediately. Ideally we'd have the wait set be
-    // able to tell us this precise list.
+    // we'll just take the one we got back and try again: any others remain
+    // signaled and the next wait will return immediately.
     if (iree_wait_handle_is_immediate(wake_handle)) {
       // No-op wait - ignore.
       IREE_TRACE_ZONE_APPEND_TEXT(z0, "nop");
@@ -433,11 +589,11 @@ static void iree_task_poller_commit_wait(iree_task_poller_t* poller,
     } else {
       // Route to zero or more tasks using this handle.
       IREE_TRACE_ZONE_APPEND_TEXT(z0, "task(s)");
-      iree_task_poller_wake_task(poller, wake_handle);
+      iree_task_poller_wake_task(poller, wake_handle, pending_submission);
     }
   } else if (iree_status_is_deadline_exceeded(status)) {
     // Indicates nothing was woken within the deadline. We gracefully bail here
-    // and let the scan check for per-task deadline exceeded events or delay
+    // and let the sweep check for per-task deadline exceeded events or delay
     // completion.
     IREE_TRACE_ZONE_APPEND_TEXT(z0, "deadline exceeded");
   } else {
@@ -455,6 +611,14 @@ static void iree_task_poller_commit_wait(iree_task_poller_t* poller,
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Submits all retired wait tasks in |pending_submission| to the executor.
+static void iree_task_poller_flush(iree_task_poller_t* poller,
+                                   iree_task_submission_t* pending_submission) {
+  if (iree_task_submission_is_empty(pending_submission)) return;
+  iree_task_executor_submit(poller->executor, pending_submission);
+  iree_task_executor_flush(poller->executor);
+}
+
 // Pumps the |poller| until it is requested to exit.
 static void iree_task_poller_pump_until_exit(iree_task_poller_t* poller) {
   while (true) {
@@ -467,31 +631,39 @@ static void iree_task_poller_pump_until_exit(iree_task_poller_t* poller) {
 
     IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_task_poller_pump");
 
-    // Reset the wake event and merge any incoming tasks to the wait list.
+    // The current time is only queried if there are delays or deadlines that
+    // need it; waits on handles alone never need to know the time.
+    iree_time_t now_ns = IREE_TIME_INFINITE_PAST;
+
+    // Reset the wake event and merge any incoming tasks.
     // To avoid races we reset and then merge: this allows another thread
     // coming in and enqueuing tasks to set the event and ensure that we'll
     // get the tasks as we'll fall through on the wait below and loop again.
+    // Incoming tasks that have already resolved will be retired immediately.
     iree_event_reset(&poller->wake_event);
-    iree_task_list_append_from_fifo_slist(&poller->wait_list,
-                                          &poller->mailbox_slist);
-
-    // Scan all wait tasks to see if any have resolved and if so we'll enqueue
-    // their retirement on the executor and drop them from the list.
     iree_task_submission_t pending_submission;
     iree_task_submission_initialize(&pending_submission);
-    iree_time_t earliest_deadline_ns = IREE_TIME_INFINITE_FUTURE;
-    iree_task_poller_prepare_wait(poller, &pending_submission,
-                                  &earliest_deadline_ns);
-    if (!iree_task_submission_is_empty(&pending_submission)) {
-      iree_task_executor_submit(poller->executor, &pending_submission);
-      iree_task_executor_flush(poller->executor);
+    iree_task_poller_merge_mailbox(poller, &pending_submission, &now_ns);
+
+    // Sweep all waits for deadlines/delays/cancellation only if required.
+    if (poller->sweep_required ||
+        (poller->earliest_deadline_ns != IREE_TIME_INFINITE_FUTURE &&
+         poller->earliest_deadline_ns <=
+             iree_task_poller_now(&now_ns) +
+                 poller->executor->options.delay_slop_ns)) {
+      iree_task_poller_sweep(poller, &pending_submission,
+                             iree_task_poller_now(&now_ns));
     }
+    iree_task_poller_flush(poller, &pending_submission);
 
     // Enter the system multi-wait API.
     // We unconditionally do this: if we have nothing to wait on we'll still
     // wait on the wake_event for new waits to be enqueued - or the first delay
-    // to be reached.
-    iree_task_poller_commit_wait(poller, earliest_deadline_ns);
+    // to be reached. Woken tasks are submitted as soon as we return.
+    iree_task_submission_initialize(&pending_submission);
+    iree_task_poller_commit_wait(poller, poller->earliest_deadline_ns,
+                                 &pending_submission);
+    iree_task_poller_flush(poller, &pending_submission);
 
     IREE_TRACE_ZONE_END(z0);
   }
@@ -47,6 +47,15 @@ typedef enum iree_task_poller_state_e {
   IREE_TASK_POLLER_STATE_ZOMBIE = 3,
 } iree_task_poller_state_t;
 
+// A slot in the poller wait handle table.
+// Slots are empty when their task_list is empty.
+typedef struct iree_task_poller_wait_slot_t {
+  // Wait handle inserted into the poller wait set.
+  iree_wait_handle_t handle;
+  // Wait tasks waiting on the handle linked through their next_task pointer.
+  iree_task_list_t task_list;
+} iree_task_poller_wait_slot_t;
+
 // Wait task poller with a dedicated thread for performing syscalls.
 // This keeps potentially-blocking syscalls off the worker threads and ensures
 // the lowest possible latency for wakes as the poller will always be kept in
@@ -92,16 +101,31 @@ typedef struct {
   // the full wait set by the wait thread the next time it wakes.
   iree_atomic_task_slist_t mailbox_slist;
 
-  // A list of wait tasks with external handles that need to be waited on.
+  // A list of delay tasks that are waiting for some future time.
   // Managed by the wait thread and must not be accessed from any other thread.
-  // This is the full set of waits actively being managed by the poller.
-  iree_task_list_t wait_list;
+  iree_task_list_t delay_list;
 
-  // Wait set containing wait handles from wait_list.
+  // Wait set containing the wait handles of all wait_slots and wake_event.
   // Managed by the wait thread and must not be accessed from any other thread.
-  // This may only contain a subset of the wait_list in cases where some of
-  // the wait tasks do not have full system handles.
   iree_wait_set_t* wait_set;
+
+  // Open-addressed hash table mapping each wait handle in the wait_set to the
+  // wait tasks waiting on it. This lets the wait thread route a wake from the
+  // wait set directly to the tasks that can be retired without scanning or
+  // querying any other waits.
+  // Managed by the wait thread and must not be accessed from any other thread.
+  iree_host_size_t wait_slot_capacity;  // power of two
+  iree_task_poller_wait_slot_t* wait_slots;
+
+  // Earliest deadline of any delay or wait task managed by the poller.
+  // Waits are only swept for deadlines and delays once this is reached.
+  // Managed by the wait thread and must not be accessed from any other thread.
+  iree_time_t earliest_deadline_ns;
+
+  // True if the waits need to be swept for cancellation, such as when a task
+  // in a wait-any operation has resolved and latched its cancellation flag.
+  // Managed by the wait thread and must not be accessed from any other thread.
+  bool sweep_required;
 } iree_task_poller_t;
 
 // Initializes |out_poller| with a new poller.
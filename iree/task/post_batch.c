@@ -27,26 +27,55 @@ void iree_task_post_batch_initialize(iree_task_executor_t* executor,
          executor->worker_count * sizeof(iree_task_list_t));
 }
 
+const iree_task_executor_options_t* iree_task_post_batch_executor_options(
+    const iree_task_post_batch_t* post_batch) {
+  return &post_batch->executor->options;
+}
+
 iree_host_size_t iree_task_post_batch_worker_count(
     const iree_task_post_batch_t* post_batch) {
   return post_batch->executor->worker_count;
 }
 
-static iree_host_size_t iree_task_post_batch_select_random_worker(
+iree_task_affinity_set_t iree_task_post_batch_live_worker_mask(
+    const iree_task_post_batch_t* post_batch) {
+  return iree_atomic_task_affinity_set_load(
+      &post_batch->executor->worker_live_mask, iree_memory_order_relaxed);
+}
+
+iree_host_size_t iree_task_post_batch_donor_count(
+    const iree_task_post_batch_t* post_batch) {
+  return (iree_host_size_t)iree_atomic_load_int32(
+      &post_batch->executor->donor_count, iree_memory_order_relaxed);
+}
+
+// Selects the next live worker in |affinity_set| in round-robin order.
+// Rotating ensures that tasks with wide affinity sets are distributed across
+// all of the workers they may run on instead of piling up on the lowest index.
+static iree_host_size_t iree_task_post_batch_select_next_worker(
     iree_task_post_batch_t* post_batch, iree_task_affinity_set_t affinity_set) {
+  iree_task_executor_t* executor = post_batch->executor;
   iree_task_affinity_set_t worker_live_mask =
-      iree_atomic_task_affinity_set_load(
-          &post_batch->executor->worker_live_mask, iree_memory_order_relaxed);
+      iree_atomic_task_affinity_set_load(&executor->worker_live_mask,
+                                         iree_memory_order_relaxed);
   iree_task_affinity_set_t valid_worker_mask = affinity_set & worker_live_mask;
   if (!valid_worker_mask) {
     // No valid workers as desired; for now just bail to worker 0.
     return 0;
   }
 
-  // TODO(benvanik): rotate through workers here. Instead, if the affinity set
-  // has the current_worker allowed we just use that to avoid needing a
-  // cross-thread hop.
-  return iree_task_affinity_set_count_trailing_zeros(valid_worker_mask);
+  // Find the first valid worker at or after the rotation offset (wrapping).
+  // Only the coordinator selects workers so we don't need to synchronize.
+  int rotation_offset = (int)(executor->worker_rotation_offset &
+                              (8 * sizeof(iree_task_affinity_set_t) - 1));
+  iree_task_affinity_set_t rotated_mask =
+      iree_task_affinity_set_rotr(valid_worker_mask, rotation_offset);
+  iree_host_size_t worker_index =
+      (rotation_offset +
+       iree_task_affinity_set_count_trailing_zeros(rotated_mask)) &
+      (8 * sizeof(iree_task_affinity_set_t) - 1);
+  executor->worker_rotation_offset = worker_index + 1;
+  return worker_index;
 }
 
 iree_host_size_t iree_task_post_batch_select_worker(
@@ -74,13 +103,13 @@ iree_host_size_t iree_task_post_batch_select_worker(
   worker_idle_mask &= ~post_batch->worker_pending_mask;
   iree_task_affinity_set_t idle_affinity_set = affinity_set & worker_idle_mask;
   if (idle_affinity_set) {
-    return iree_task_post_batch_select_random_worker(post_batch,
-                                                     idle_affinity_set);
+    return iree_task_post_batch_select_next_worker(post_batch,
+                                                   idle_affinity_set);
   }
 
-  // No more workers are idle; farm out at random. In the worst case work
+  // No more workers are idle; farm out round-robin. In the worst case work
   // stealing will help balance things out on the backend.
-  return iree_task_post_batch_select_random_worker(post_batch, affinity_set);
+  return iree_task_post_batch_select_next_worker(post_batch, affinity_set);
 }
 
 void iree_task_post_batch_enqueue(iree_task_post_batch_t* post_batch,
@@ -108,41 +137,33 @@ static void iree_task_post_batch_wake_workers(
                                               ~wake_mask,
                                               iree_memory_order_acquire);
   resume_mask &= wake_mask;
-  if (IREE_UNLIKELY(resume_mask)) {
-    int resume_count = iree_task_affinity_set_count_ones(resume_mask);
-    int worker_index = 0;
-    for (int i = 0; i < resume_count; ++i) {
-      int offset = iree_task_affinity_set_count_trailing_zeros(resume_mask) + 1;
-      int resume_index = worker_index + offset;
-      worker_index += offset + 1;
-      resume_mask = iree_shr(resume_mask, offset + 1);
-      iree_thread_resume(executor->workers[resume_index].thread);
-    }
+  while (IREE_UNLIKELY(resume_mask)) {
+    int resume_index = iree_task_affinity_set_count_trailing_zeros(resume_mask);
+    resume_mask &= resume_mask - 1;
+    iree_thread_resume(executor->workers[resume_index].thread);
   }
 
-  // TODO(#4016): use a FUTEX_WAKE_BITSET here to wake all of the workers that
-  // have pending work in a single syscall (vs. popcnt(worker_pending_mask)
-  // syscalls). This will reduce wake latency for workers later in the set;
-  // for example today worker[31] will wait until workers[0-30] have had their
-  // syscalls performed before it's even requested to wake. This also loses
-  // information the kernel could use to avoid core migration as it knows when N
-  // threads will be needed simultaneously and can hopefully perform any needed
-  // migrations prior to beginning execution.
-  int wake_count = iree_task_affinity_set_count_ones(wake_mask);
-  int worker_index = 0;
-  for (int i = 0; i < wake_count; ++i) {
-    int offset = iree_task_affinity_set_count_trailing_zeros(wake_mask);
-    int wake_index = worker_index + offset;
-    worker_index += offset + 1;
-    wake_mask = iree_shr(wake_mask, offset + 1);
-
-    // Wake workers if they are waiting - workers are the only thing that can
-    // wait on this notification so this should almost always be either free (an
-    // atomic load) if a particular worker isn't waiting or it's required to
-    // actually wake it and we can't avoid it.
-    iree_task_worker_t* worker = &executor->workers[wake_index];
-    iree_notification_post(&worker->wake_notification, 1);
+#if IREE_STATISTICS_ENABLE
+  // Stamp the time work was first posted to each worker so that they can
+  // measure how long it took them to wake up and notice it.
+  iree_time_t post_time_ns = iree_time_now();
+  iree_task_affinity_set_t post_mask = wake_mask;
+  while (post_mask) {
+    int post_index = iree_task_affinity_set_count_trailing_zeros(post_mask);
+    post_mask &= post_mask - 1;
+    int64_t expected_time_ns = 0;
+    iree_atomic_compare_exchange_strong_int64(
+        &executor->workers[post_index].wake_post_time_ns, &expected_time_ns,
+        post_time_ns, iree_memory_order_relaxed, iree_memory_order_relaxed);
   }
+#endif  // IREE_STATISTICS_ENABLE
+
+  // Wake all of the workers that have pending work in a single operation. On
+  // platforms with FUTEX_WAKE_BITSET this is a single syscall (vs.
+  // popcnt(wake_mask) syscalls) such that workers later in the set don't have
+  // to wait for the earlier ones to be woken before they are even requested to
+  // wake. Workers that aren't waiting are skipped without a syscall.
+  iree_notification_set_post(&executor->worker_wake_set, wake_mask);
 
   IREE_TRACE_ZONE_END(z0);
 }
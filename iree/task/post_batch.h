@@ -47,10 +47,23 @@ void iree_task_post_batch_initialize(iree_task_executor_t* executor,
                                      iree_task_worker_t* current_worker,
                                      iree_task_post_batch_t* out_post_batch);
 
+// Returns the options of the executor the post batch is targeting.
+const iree_task_executor_options_t* iree_task_post_batch_executor_options(
+    const iree_task_post_batch_t* post_batch);
+
 // Returns the total number of workers that the post batch is targeting.
 iree_host_size_t iree_task_post_batch_worker_count(
     const iree_task_post_batch_t* post_batch);
 
+// Returns the set of live workers that tasks may be posted to.
+iree_task_affinity_set_t iree_task_post_batch_live_worker_mask(
+    const iree_task_post_batch_t* post_batch);
+
+// Returns the number of caller threads currently donated to the executor that
+// may steal work posted by the batch.
+iree_host_size_t iree_task_post_batch_donor_count(
+    const iree_task_post_batch_t* post_batch);
+
 // Selects a random worker from the given affinity set.
 iree_host_size_t iree_task_post_batch_select_worker(
     iree_task_post_batch_t* post_batch, iree_task_affinity_set_t affinity_set);
@@ -9,53 +9,132 @@
 #include <stddef.h>
 #include <string.h>
 
+// Per-priority FIFO lists used to sort tasks before they enter a queue.
+typedef struct iree_task_queue_sorted_lists_t {
+  iree_task_list_t lists[IREE_TASK_PRIORITY_COUNT];
+} iree_task_queue_sorted_lists_t;
+
+// Moves all tasks from the FIFO |list| into |out_sorted_lists| by priority
+// preserving their relative order.
+static void iree_task_queue_sort_list(
+    iree_task_list_t* list, iree_task_queue_sorted_lists_t* out_sorted_lists) {
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_list_initialize(&out_sorted_lists->lists[i]);
+  }
+  iree_task_t* task = NULL;
+  while ((task = iree_task_list_pop_front(list))) {
+    iree_task_list_push_back(&out_sorted_lists->lists[task->priority], task);
+  }
+}
+
+// Appends all |sorted_lists| to the matching lists in |queue|.
+static void iree_task_queue_append_sorted_lists_locked(
+    iree_task_queue_t* queue, iree_task_queue_sorted_lists_t* sorted_lists) {
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_list_append(&queue->lists[i], &sorted_lists->lists[i]);
+  }
+}
+
+// Pops the first task of the highest priority, if any.
+static iree_task_t* iree_task_queue_pop_front_locked(
+    iree_task_queue_t* queue) {
+  for (int i = IREE_TASK_PRIORITY_COUNT - 1; i >= 0; --i) {
+    iree_task_t* task = iree_task_list_pop_front(&queue->lists[i]);
+    if (task) return task;
+  }
+  return NULL;
+}
+
 void iree_task_queue_initialize(iree_task_queue_t* out_queue) {
   memset(out_queue, 0, sizeof(*out_queue));
   iree_slim_mutex_initialize(&out_queue->mutex);
-  iree_task_list_initialize(&out_queue->list);
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_list_initialize(&out_queue->lists[i]);
+  }
 }
 
 void iree_task_queue_deinitialize(iree_task_queue_t* queue) {
-  iree_task_list_discard(&queue->list);
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_list_discard(&queue->lists[i]);
+  }
   iree_slim_mutex_deinitialize(&queue->mutex);
 }
 
 bool iree_task_queue_is_empty(iree_task_queue_t* queue) {
   iree_slim_mutex_lock(&queue->mutex);
-  bool is_empty = iree_task_list_is_empty(&queue->list);
+  bool is_empty = true;
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    is_empty = is_empty && iree_task_list_is_empty(&queue->lists[i]);
+  }
   iree_slim_mutex_unlock(&queue->mutex);
   return is_empty;
 }
 
+bool iree_task_queue_has_priority_above(iree_task_queue_t* queue,
+                                        iree_task_priority_t priority) {
+  iree_slim_mutex_lock(&queue->mutex);
+  bool has_tasks = false;
+  for (int i = IREE_TASK_PRIORITY_COUNT - 1; i > (int)priority; --i) {
+    has_tasks = has_tasks || !iree_task_list_is_empty(&queue->lists[i]);
+  }
+  iree_slim_mutex_unlock(&queue->mutex);
+  return has_tasks;
+}
+
 void iree_task_queue_push_front(iree_task_queue_t* queue, iree_task_t* task) {
   iree_slim_mutex_lock(&queue->mutex);
-  iree_task_list_push_front(&queue->list, task);
+  iree_task_list_push_front(&queue->lists[task->priority], task);
   iree_slim_mutex_unlock(&queue->mutex);
 }
 
 void iree_task_queue_append_from_lifo_list_unsafe(iree_task_queue_t* queue,
                                                   iree_task_list_t* list) {
-  // NOTE: reversing the list outside of the lock.
+  // NOTE: reversing and sorting the list outside of the lock.
   iree_task_list_reverse(list);
+  iree_task_queue_sorted_lists_t sorted_lists;
+  iree_task_queue_sort_list(list, &sorted_lists);
   iree_slim_mutex_lock(&queue->mutex);
-  iree_task_list_append(&queue->list, list);
+  iree_task_queue_append_sorted_lists_locked(queue, &sorted_lists);
   iree_slim_mutex_unlock(&queue->mutex);
 }
 
-iree_task_t* iree_task_queue_flush_from_lifo_slist(
-    iree_task_queue_t* queue, iree_atomic_task_slist_t* source_slist) {
-  // Perform the flush and swap outside of the lock; acquiring the list is
+// Flushes |source_slist| and sorts the tasks in FIFO order into
+// |out_sorted_lists|. Returns false if there were no tasks to flush.
+static bool iree_task_queue_flush_slist(
+    iree_atomic_task_slist_t* source_slist,
+    iree_task_queue_sorted_lists_t* out_sorted_lists) {
+  // Perform the flush and sort outside of the lock; acquiring the list is
   // atomic and then we own it exclusively.
   iree_task_list_t suffix;
   iree_task_list_initialize(&suffix);
   const bool did_flush = iree_atomic_task_slist_flush(
       source_slist, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_FIFO,
       &suffix.head, &suffix.tail);
+  iree_task_queue_sort_list(&suffix, out_sorted_lists);
+  return did_flush;
+}
+
+void iree_task_queue_append_from_lifo_slist(
+    iree_task_queue_t* queue, iree_atomic_task_slist_t* source_slist) {
+  iree_task_queue_sorted_lists_t sorted_lists;
+  if (!iree_task_queue_flush_slist(source_slist, &sorted_lists)) return;
+  iree_slim_mutex_lock(&queue->mutex);
+  iree_task_queue_append_sorted_lists_locked(queue, &sorted_lists);
+  iree_slim_mutex_unlock(&queue->mutex);
+}
+
+iree_task_t* iree_task_queue_flush_from_lifo_slist(
+    iree_task_queue_t* queue, iree_atomic_task_slist_t* source_slist) {
+  iree_task_queue_sorted_lists_t sorted_lists;
+  const bool did_flush =
+      iree_task_queue_flush_slist(source_slist, &sorted_lists);
 
   // Append the tasks and pop off the front for return.
   iree_slim_mutex_lock(&queue->mutex);
-  if (did_flush) iree_task_list_append(&queue->list, &suffix);
-  iree_task_t* next_task = iree_task_list_pop_front(&queue->list);
+  if (did_flush) {
+    iree_task_queue_append_sorted_lists_locked(queue, &sorted_lists);
+  }
+  iree_task_t* next_task = iree_task_queue_pop_front_locked(queue);
   iree_slim_mutex_unlock(&queue->mutex);
 
   return next_task;
@@ -63,27 +142,61 @@ iree_task_t* iree_task_queue_flush_from_lifo_slist(
 
 iree_task_t* iree_task_queue_pop_front(iree_task_queue_t* queue) {
   iree_slim_mutex_lock(&queue->mutex);
-  iree_task_t* next_task = iree_task_list_pop_front(&queue->list);
+  iree_task_t* next_task = iree_task_queue_pop_front_locked(queue);
   iree_slim_mutex_unlock(&queue->mutex);
   return next_task;
 }
 
-iree_task_t* iree_task_queue_try_steal(iree_task_queue_t* source_queue,
-                                       iree_task_queue_t* target_queue,
-                                       iree_host_size_t max_tasks) {
-  // First attempt to steal up to max_tasks from the source queue.
+// Moves tasks in |stolen_tasks| that have no affinity for any worker in
+// |thief_affinity_set| back to the end of |source_list|.
+static void iree_task_queue_return_unstealable_tasks(
+    iree_task_list_t* stolen_tasks, iree_task_affinity_set_t thief_affinity_set,
+    iree_task_list_t* source_list) {
+  iree_task_list_t unstealable_tasks;
+  iree_task_list_initialize(&unstealable_tasks);
+  iree_task_t* prev_task = NULL;
+  iree_task_t* task = iree_task_list_front(stolen_tasks);
+  while (task) {
+    iree_task_t* next_task = task->next_task;
+    if (task->affinity_set & thief_affinity_set) {
+      prev_task = task;
+    } else {
+      iree_task_list_erase(stolen_tasks, prev_task, task);
+      iree_task_list_push_back(&unstealable_tasks, task);
+    }
+    task = next_task;
+  }
+  iree_task_list_append(source_list, &unstealable_tasks);
+}
+
+iree_task_t* iree_task_queue_try_steal(
+    iree_task_queue_t* source_queue, iree_task_queue_t* target_queue,
+    iree_task_affinity_set_t thief_affinity_set, iree_host_size_t max_tasks) {
+  // First attempt to steal up to max_tasks of the highest priority available
+  // from the source queue. Tasks confined to workers other than the thief are
+  // left in place.
   iree_task_list_t stolen_tasks;
   iree_task_list_initialize(&stolen_tasks);
+  int stolen_priority = IREE_TASK_PRIORITY_COUNT - 1;
   iree_slim_mutex_lock(&source_queue->mutex);
-  iree_task_list_split(&source_queue->list, max_tasks, &stolen_tasks);
+  for (; stolen_priority >= 0; --stolen_priority) {
+    iree_task_list_t* source_list = &source_queue->lists[stolen_priority];
+    if (iree_task_list_is_empty(source_list)) continue;
+    iree_task_list_split(source_list, max_tasks, &stolen_tasks);
+    if (thief_affinity_set != iree_task_affinity_for_any_worker()) {
+      iree_task_queue_return_unstealable_tasks(
+          &stolen_tasks, thief_affinity_set, source_list);
+    }
+    break;
+  }
   iree_slim_mutex_unlock(&source_queue->mutex);
 
   // Add any stolen tasks to the target queue and pop off the head for return.
   iree_task_t* next_task = NULL;
   if (!iree_task_list_is_empty(&stolen_tasks)) {
     iree_slim_mutex_lock(&target_queue->mutex);
-    iree_task_list_append(&target_queue->list, &stolen_tasks);
-    next_task = iree_task_list_pop_front(&target_queue->list);
+    iree_task_list_append(&target_queue->lists[stolen_priority], &stolen_tasks);
+    next_task = iree_task_queue_pop_front_locked(target_queue);
     iree_slim_mutex_unlock(&target_queue->mutex);
   }
   return next_task;
@@ -102,12 +102,16 @@ extern "C" {
 // list we can't easily just walk backward and we don't want to be introducing
 // cache line contention as thieves start touching the same tasks as the worker
 // is while processing.
+//
+// Tasks are kept in one FIFO list per iree_task_priority_t level. Pops and
+// thefts always take from the highest priority list that has tasks such that
+// higher priority work cuts in front of anything already queued.
 typedef struct iree_task_queue_t {
   // Must be held when manipulating the queue. >90% accesses are by the owner.
   iree_slim_mutex_t mutex;
 
-  // FIFO task list.
-  iree_task_list_t list IREE_GUARDED_BY(mutex);
+  // FIFO task lists indexed by task priority.
+  iree_task_list_t lists[IREE_TASK_PRIORITY_COUNT] IREE_GUARDED_BY(mutex);
 } iree_task_queue_t;
 
 // Initializes a work-stealing task queue in-place.
@@ -121,6 +125,12 @@ void iree_task_queue_deinitialize(iree_task_queue_t* queue);
 // Note that due to races this may return both false-positives and -negatives.
 bool iree_task_queue_is_empty(iree_task_queue_t* queue);
 
+// Returns true if the queue contains any task with a priority higher than
+// |priority|. Note that due to races this may return both false-positives and
+// -negatives.
+bool iree_task_queue_has_priority_above(iree_task_queue_t* queue,
+                                        iree_task_priority_t priority);
+
 // Pushes a task to the front of the queue.
 // Always prefer the multi-push variants (prepend/append) when adding more than
 // one task to the queue. This is mostly useful for exceptional cases such as
@@ -135,6 +145,12 @@ void iree_task_queue_push_front(iree_task_queue_t* queue, iree_task_t* task);
 void iree_task_queue_append_from_lifo_list_unsafe(iree_task_queue_t* queue,
                                                   iree_task_list_t* list);
 
+// Flushes the |source_slist| LIFO mailbox into the task queue in FIFO order.
+//
+// Must only be called from the owning worker's thread.
+void iree_task_queue_append_from_lifo_slist(
+    iree_task_queue_t* queue, iree_atomic_task_slist_t* source_slist);
+
 // Flushes the |source_slist| LIFO mailbox into the task queue in FIFO order.
 // Returns the first task in the queue upon success; the task may be
 // pre-existing or from the newly flushed tasks.
@@ -151,13 +167,15 @@ iree_task_t* iree_task_queue_pop_front(iree_task_queue_t* queue);
 // Tries to steal up to |max_tasks| from the back of the queue.
 // Returns NULL if no tasks are available and otherwise up to |max_tasks| tasks
 // that were at the tail of the |source_queue| will be moved to the
-// |target_queue| and the first of the stolen tasks is returned.
+// |target_queue| and the first of the stolen tasks is returned. Only tasks of
+// the highest priority available are stolen and of those only the ones with
+// affinity for a worker in |thief_affinity_set|.
 //
 // It's expected this is not called from the queue's owning worker, though it's
 // valid to do so.
-iree_task_t* iree_task_queue_try_steal(iree_task_queue_t* source_queue,
-                                       iree_task_queue_t* target_queue,
-                                       iree_host_size_t max_tasks);
+iree_task_t* iree_task_queue_try_steal(
+    iree_task_queue_t* source_queue, iree_task_queue_t* target_queue,
+    iree_task_affinity_set_t thief_affinity_set, iree_host_size_t max_tasks);
 
 #ifdef __cplusplus
 }  // extern "C"
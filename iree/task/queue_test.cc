@@ -173,6 +173,72 @@ TEST(QueueTest, FlushSlistOrdered) {
   iree_task_queue_deinitialize(&queue);
 }
 
+TEST(QueueTest, PopHighestPriorityFirst) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+
+  // Make a lifo list: d<-c<-b<-a with mixed priorities.
+  iree_task_list_t list = {0};
+  iree_task_t task_a = {0};
+  task_a.priority = IREE_TASK_PRIORITY_LOW;
+  iree_task_list_push_front(&list, &task_a);
+  iree_task_t task_b = {0};
+  task_b.priority = IREE_TASK_PRIORITY_HIGH;
+  iree_task_list_push_front(&list, &task_b);
+  iree_task_t task_c = {0};
+  task_c.priority = IREE_TASK_PRIORITY_NORMAL;
+  iree_task_list_push_front(&list, &task_c);
+  iree_task_t task_d = {0};
+  task_d.priority = IREE_TASK_PRIORITY_HIGH;
+  iree_task_list_push_front(&list, &task_d);
+  iree_task_queue_append_from_lifo_list_unsafe(&queue, &list);
+
+  // Pop list and ensure priority order with FIFO order within a priority.
+  EXPECT_TRUE(
+      iree_task_queue_has_priority_above(&queue, IREE_TASK_PRIORITY_NORMAL));
+  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&queue));
+  EXPECT_EQ(&task_d, iree_task_queue_pop_front(&queue));
+  EXPECT_FALSE(
+      iree_task_queue_has_priority_above(&queue, IREE_TASK_PRIORITY_NORMAL));
+  EXPECT_TRUE(
+      iree_task_queue_has_priority_above(&queue, IREE_TASK_PRIORITY_LOW));
+  EXPECT_EQ(&task_c, iree_task_queue_pop_front(&queue));
+  EXPECT_EQ(&task_a, iree_task_queue_pop_front(&queue));
+  EXPECT_TRUE(iree_task_queue_is_empty(&queue));
+
+  iree_task_queue_deinitialize(&queue);
+}
+
+TEST(QueueTest, FlushSlistPreemptsQueued) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+
+  iree_task_t task_a = {0};
+  task_a.priority = IREE_TASK_PRIORITY_NORMAL;
+  iree_task_queue_push_front(&queue, &task_a);
+
+  iree_atomic_task_slist_t slist;
+  iree_atomic_task_slist_initialize(&slist);
+  iree_task_t task_b = {0};
+  task_b.priority = IREE_TASK_PRIORITY_NORMAL;
+  iree_atomic_task_slist_push(&slist, &task_b);
+  iree_task_t task_c = {0};
+  task_c.priority = IREE_TASK_PRIORITY_HIGH;
+  iree_atomic_task_slist_push(&slist, &task_c);
+
+  // The high priority task cuts in front of the one already queued while the
+  // normal priority task queues up behind it.
+  iree_task_queue_append_from_lifo_slist(&queue, &slist);
+  EXPECT_EQ(&task_c, iree_task_queue_pop_front(&queue));
+  EXPECT_EQ(&task_a, iree_task_queue_pop_front(&queue));
+  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&queue));
+  EXPECT_TRUE(iree_task_queue_is_empty(&queue));
+
+  iree_atomic_task_slist_deinitialize(&slist);
+
+  iree_task_queue_deinitialize(&queue);
+}
+
 TEST(QueueTest, TryStealEmpty) {
   iree_task_queue_t source_queue;
   iree_task_queue_initialize(&source_queue);
@@ -187,7 +253,8 @@ TEST(QueueTest, TryStealEmpty) {
   iree_task_queue_push_front(&source_queue, &task_c);
 
   EXPECT_EQ(&task_a,
-            iree_task_queue_try_steal(&source_queue, &target_queue, 1));
+            iree_task_queue_try_steal(&source_queue, &target_queue,
+                                      iree_task_affinity_for_any_worker(), 1));
 
   iree_task_queue_deinitialize(&source_queue);
   iree_task_queue_deinitialize(&target_queue);
@@ -203,7 +270,9 @@ TEST(QueueTest, TryStealLast) {
   iree_task_queue_push_front(&source_queue, &task_a);
 
   EXPECT_EQ(&task_a,
-            iree_task_queue_try_steal(&source_queue, &target_queue, 100));
+            iree_task_queue_try_steal(&source_queue, &target_queue,
+                                      iree_task_affinity_for_any_worker(),
+                                      /*max_tasks=*/100));
   EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
   EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
 
@@ -225,7 +294,8 @@ TEST(QueueTest, TrySteal1) {
   iree_task_queue_push_front(&source_queue, &task_a);
 
   EXPECT_EQ(&task_c,
-            iree_task_queue_try_steal(&source_queue, &target_queue, 1));
+            iree_task_queue_try_steal(&source_queue, &target_queue,
+                                      iree_task_affinity_for_any_worker(), 1));
   EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
 
   EXPECT_EQ(&task_a, iree_task_queue_pop_front(&source_queue));
@@ -251,7 +321,8 @@ TEST(QueueTest, TryStealIntoExisting) {
   iree_task_queue_push_front(&target_queue, &task_existing);
 
   EXPECT_EQ(&task_existing,
-            iree_task_queue_try_steal(&source_queue, &target_queue, 1));
+            iree_task_queue_try_steal(&source_queue, &target_queue,
+                                      iree_task_affinity_for_any_worker(), 1));
 
   EXPECT_EQ(&task_a, iree_task_queue_pop_front(&source_queue));
   EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
@@ -279,7 +350,8 @@ TEST(QueueTest, TryStealMany) {
   iree_task_queue_push_front(&source_queue, &task_a);
 
   EXPECT_EQ(&task_c,
-            iree_task_queue_try_steal(&source_queue, &target_queue, 2));
+            iree_task_queue_try_steal(&source_queue, &target_queue,
+                                      iree_task_affinity_for_any_worker(), 2));
   EXPECT_EQ(&task_d, iree_task_queue_pop_front(&target_queue));
   EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
 
@@ -307,7 +379,9 @@ TEST(QueueTest, TryStealAll) {
   iree_task_queue_push_front(&source_queue, &task_a);
 
   EXPECT_EQ(&task_c,
-            iree_task_queue_try_steal(&source_queue, &target_queue, 1000));
+            iree_task_queue_try_steal(&source_queue, &target_queue,
+                                      iree_task_affinity_for_any_worker(),
+                                      /*max_tasks=*/1000));
   EXPECT_EQ(&task_d, iree_task_queue_pop_front(&target_queue));
   EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
 
@@ -319,4 +393,70 @@ TEST(QueueTest, TryStealAll) {
   iree_task_queue_deinitialize(&target_queue);
 }
 
+TEST(QueueTest, TryStealHighestPriority) {
+  iree_task_queue_t source_queue;
+  iree_task_queue_initialize(&source_queue);
+  iree_task_queue_t target_queue;
+  iree_task_queue_initialize(&target_queue);
+
+  iree_task_t task_a = {0};
+  task_a.priority = IREE_TASK_PRIORITY_HIGH;
+  iree_task_queue_push_front(&source_queue, &task_a);
+  iree_task_t task_b = {0};
+  task_b.priority = IREE_TASK_PRIORITY_NORMAL;
+  iree_task_queue_push_front(&source_queue, &task_b);
+
+  EXPECT_EQ(&task_a,
+            iree_task_queue_try_steal(&source_queue, &target_queue,
+                                      iree_task_affinity_for_any_worker(), 2));
+  EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
+  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&source_queue));
+  EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
+
+  iree_task_queue_deinitialize(&source_queue);
+  iree_task_queue_deinitialize(&target_queue);
+}
+
+TEST(QueueTest, TryStealAffinity) {
+  iree_task_queue_t source_queue;
+  iree_task_queue_initialize(&source_queue);
+  iree_task_queue_t target_queue;
+  iree_task_queue_initialize(&target_queue);
+
+  iree_task_t task_a = {0};
+  task_a.affinity_set = 0b01;
+  iree_task_t task_b = {0};
+  task_b.affinity_set = 0b10;
+  iree_task_t task_c = {0};
+  task_c.affinity_set = 0b01;
+  iree_task_t task_d = {0};
+  task_d.affinity_set = 0b10;
+  iree_task_queue_push_front(&source_queue, &task_d);
+  iree_task_queue_push_front(&source_queue, &task_c);
+  iree_task_queue_push_front(&source_queue, &task_b);
+  iree_task_queue_push_front(&source_queue, &task_a);
+
+  // task_d is confined to another worker and must remain with the source.
+  EXPECT_EQ(&task_c,
+            iree_task_queue_try_steal(&source_queue, &target_queue,
+                                      /*thief_affinity_set=*/0b01,
+                                      /*max_tasks=*/1000));
+  EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
+
+  EXPECT_EQ(&task_a, iree_task_queue_pop_front(&source_queue));
+  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&source_queue));
+  EXPECT_EQ(&task_d, iree_task_queue_pop_front(&source_queue));
+  EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
+
+  // Nothing remaining is stealable by a thief confined to worker 0.
+  iree_task_queue_push_front(&source_queue, &task_d);
+  EXPECT_EQ(NULL, iree_task_queue_try_steal(&source_queue, &target_queue,
+                                            /*thief_affinity_set=*/0b01,
+                                            /*max_tasks=*/1000));
+  EXPECT_EQ(&task_d, iree_task_queue_pop_front(&source_queue));
+
+  iree_task_queue_deinitialize(&source_queue);
+  iree_task_queue_deinitialize(&target_queue);
+}
+
 }  // namespace
@@ -25,6 +25,10 @@ void iree_task_scope_initialize(iree_string_view_t name,
   // TODO(benvanik): pick trace colors based on name hash.
   IREE_TRACE(out_scope->task_trace_color = 0xFFFF0000u);
 
+  out_scope->priority = IREE_TASK_PRIORITY_NORMAL;
+  out_scope->worker_mask = iree_task_affinity_for_any_worker();
+  out_scope->max_concurrency = 0;
+
   iree_slim_mutex_initialize(&out_scope->mutex);
   iree_notification_initialize(&out_scope->idle_notification);
 
@@ -59,6 +63,22 @@ iree_string_view_t iree_task_scope_name(iree_task_scope_t* scope) {
   return iree_make_cstring_view(scope->name);
 }
 
+iree_task_priority_t iree_task_scope_priority(iree_task_scope_t* scope) {
+  return scope->priority;
+}
+
+void iree_task_scope_set_priority(iree_task_scope_t* scope,
+                                  iree_task_priority_t priority) {
+  scope->priority = priority;
+}
+
+void iree_task_scope_set_worker_affinity(iree_task_scope_t* scope,
+                                         iree_task_affinity_set_t worker_mask,
+                                         iree_host_size_t max_concurrency) {
+  scope->worker_mask = worker_mask;
+  scope->max_concurrency = max_concurrency;
+}
+
 iree_task_dispatch_statistics_t iree_task_scope_consume_statistics(
     iree_task_scope_t* scope) {
   iree_task_dispatch_statistics_t result = scope->dispatch_statistics;
@@ -161,3 +181,36 @@ iree_status_t iree_task_scope_wait_idle(iree_task_scope_t* scope,
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+// Wait source control function for iree_task_scope_await_idle.
+// |self| is the iree_task_scope_t being waited on.
+static iree_status_t iree_task_scope_await_idle_ctl(
+    iree_wait_source_t wait_source, iree_wait_source_command_t command,
+    const void* params, void** inout_ptr) {
+  iree_task_scope_t* scope = (iree_task_scope_t*)wait_source.self;
+  switch (command) {
+    case IREE_WAIT_SOURCE_COMMAND_QUERY: {
+      iree_status_code_t* out_wait_status_code = (iree_status_code_t*)inout_ptr;
+      *out_wait_status_code = iree_task_scope_is_idle(scope)
+                                  ? IREE_STATUS_OK
+                                  : IREE_STATUS_DEFERRED;
+      return iree_ok_status();
+    }
+    case IREE_WAIT_SOURCE_COMMAND_WAIT_ONE: {
+      return iree_task_scope_wait_idle(
+          scope, iree_timeout_as_deadline_ns(
+                     ((const iree_wait_source_wait_params_t*)params)->timeout));
+    }
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "scope idle wait sources cannot be exported");
+  }
+}
+
+iree_wait_source_t iree_task_scope_await_idle(iree_task_scope_t* scope) {
+  iree_wait_source_t wait_source = {
+      {{scope, 0ull}},
+      iree_task_scope_await_idle_ctl,
+  };
+  return wait_source;
+}
@@ -50,6 +50,16 @@ typedef struct iree_task_scope_t {
   // The color will be modulated based on task type.
   IREE_TRACE(uint32_t task_trace_color;)
 
+  // Scheduling priority assigned to tasks initialized within the scope.
+  iree_task_priority_t priority;
+
+  // Set of workers tasks initialized within the scope are confined to.
+  iree_task_affinity_set_t worker_mask;
+
+  // Maximum number of shards each dispatch in the scope is split into or 0 to
+  // fan out to all workers in worker_mask.
+  iree_host_size_t max_concurrency;
+
   // A permanent status code set when a task within the scope fails. All pending
   // tasks will be aborted, though any in-flight tasks may continue executing
   // to completion.
@@ -98,6 +108,29 @@ void iree_task_scope_deinitialize(iree_task_scope_t* scope);
 // string.
 iree_string_view_t iree_task_scope_name(iree_task_scope_t* scope);
 
+// Returns the scheduling priority of tasks in the scope.
+iree_task_priority_t iree_task_scope_priority(iree_task_scope_t* scope);
+
+// Sets the scheduling priority of tasks in the scope. Scopes default to
+// IREE_TASK_PRIORITY_NORMAL. Only tasks initialized after the change are
+// affected; callers should set the priority prior to recording any tasks.
+void iree_task_scope_set_priority(iree_task_scope_t* scope,
+                                  iree_task_priority_t priority);
+
+// Confines tasks in the scope to the workers in |worker_mask| and limits each
+// dispatch to at most |max_concurrency| concurrently executing shards (or 0
+// for no limit beyond the worker mask). Scopes default to any worker with no
+// limit. Co-locating tenants on an executor with disjoint worker masks keeps
+// them from thrashing each other's caches and makes their latency independent
+// of each other's load. Caller threads donated to the executor are not workers
+// and may still execute tasks of any scope.
+//
+// Only tasks initialized after the change are affected; callers should set the
+// affinity prior to recording any tasks.
+void iree_task_scope_set_worker_affinity(iree_task_scope_t* scope,
+                                         iree_task_affinity_set_t worker_mask,
+                                         iree_host_size_t max_concurrency);
+
 // Returns and resets the statistics for the scope.
 // Statistics may experience tearing (non-atomic update across fields) if this
 // is performed while tasks are in-flight.
@@ -153,6 +186,12 @@ bool iree_task_scope_is_idle(iree_task_scope_t* scope);
 iree_status_t iree_task_scope_wait_idle(iree_task_scope_t* scope,
                                         iree_time_t deadline_ns);
 
+// Returns a wait source that resolves when the scope becomes idle.
+// This can be passed to iree_task_executor_donate_caller to have the caller
+// perform work on behalf of the scope while it waits. The scope must remain
+// valid for as long as the wait source is in use.
+iree_wait_source_t iree_task_scope_await_idle(iree_task_scope_t* scope);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
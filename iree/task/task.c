@@ -9,6 +9,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "iree/base/internal/fpu_state.h"
+#include "iree/base/profiler.h"
 #include "iree/base/tracing.h"
 #include "iree/task/list.h"
 #include "iree/task/pool.h"
@@ -27,8 +29,11 @@ void iree_task_initialize(iree_task_type_t type, iree_task_scope_t* scope,
   // NOTE: only clears the header, not the task body.
   memset(out_task, 0, sizeof(*out_task));
   out_task->scope = scope;
-  out_task->affinity_set = iree_task_affinity_for_any_worker();
+  out_task->affinity_set =
+      scope ? scope->worker_mask : iree_task_affinity_for_any_worker();
   out_task->type = type;
+  out_task->priority = scope ? (uint8_t)iree_task_scope_priority(scope)
+                             : IREE_TASK_PRIORITY_NORMAL;
 }
 
 void iree_task_set_cleanup_fn(iree_task_t* task,
@@ -512,9 +517,22 @@ static uint32_t iree_task_tile_to_color(
 #endif  // IREE_TASK_TRACING_PER_TILE_COLORS
 
 void iree_task_dispatch_statistics_merge(
-    const iree_task_dispatch_statistics_t* source,
+    iree_task_dispatch_statistics_t* source,
     iree_task_dispatch_statistics_t* target) {
-  // TODO(benvanik): statistics.
+#if IREE_STATISTICS_ENABLE
+  iree_atomic_fetch_add_int32(
+      &target->tile_count,
+      iree_atomic_load_int32(&source->tile_count, iree_memory_order_relaxed),
+      iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int32(&target->reservation_count,
+                              iree_atomic_load_int32(&source->reservation_count,
+                                                     iree_memory_order_relaxed),
+                              iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int32(
+      &target->shard_count,
+      iree_atomic_load_int32(&source->shard_count, iree_memory_order_relaxed),
+      iree_memory_order_relaxed);
+#endif  // IREE_STATISTICS_ENABLE
 }
 
 //==============================================================================
@@ -529,6 +547,8 @@ static void iree_task_dispatch_initialize_base(
   memcpy(out_task->workgroup_size, workgroup_size,
          sizeof(out_task->workgroup_size));
   out_task->local_memory_size = 0;
+  out_task->tile_cost = 0;
+  out_task->preferred_tiles_per_reservation = 0;
   iree_atomic_store_intptr(&out_task->status, 0, iree_memory_order_release);
   memset(&out_task->statistics, 0, sizeof(out_task->statistics));
 
@@ -597,28 +617,88 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
                           iree_memory_order_relaxed);
   dispatch_task->tile_count =
       workgroup_count[0] * workgroup_count[1] * workgroup_count[2];
+  if (dispatch_task->tile_count > 0) {
+    dispatch_task->workgroup_count_x_divisor =
+        iree_math_fast_divisor_u32(workgroup_count[0]);
+    dispatch_task->workgroup_count_y_divisor =
+        iree_math_fast_divisor_u32(workgroup_count[1]);
+  }
+  iree_profiler_record(IREE_PROFILER_EVENT_TYPE_DISPATCH_BEGIN,
+                       (uint64_t)(uintptr_t)dispatch_task,
+                       iree_string_view_empty(), dispatch_task->tile_count);
 
   // Compute shard count - almost always worker_count unless we are a very small
-  // dispatch (1x1x1, etc).
+  // dispatch (1x1x1, etc). Any threads donated to the executor get a shard of
+  // their own to steal as otherwise each worker would be busy with its own
+  // shard until the grid is exhausted.
   iree_host_size_t worker_count = iree_task_post_batch_worker_count(post_batch);
   iree_host_size_t shard_count =
-      iree_min(dispatch_task->tile_count, worker_count);
+      iree_min(dispatch_task->tile_count,
+               worker_count + iree_task_post_batch_donor_count(post_batch));
+
+  // Dispatches confined to a subset of workers get one shard per worker in the
+  // subset; donated threads may still help by stealing those shards. The scope
+  // may further limit how many workers a single dispatch occupies.
+  const iree_task_affinity_set_t affinity_set =
+      dispatch_task->header.affinity_set;
+  const bool is_confined = affinity_set != iree_task_affinity_for_any_worker();
+  if (is_confined) {
+    iree_task_affinity_set_t worker_mask =
+        affinity_set & iree_task_post_batch_live_worker_mask(post_batch);
+    shard_count = iree_min(
+        shard_count,
+        iree_max(1, iree_task_affinity_set_count_ones(worker_mask)));
+  }
+  const iree_host_size_t max_concurrency =
+      dispatch_task->header.scope->max_concurrency;
+  if (max_concurrency > 0) {
+    shard_count = iree_min(shard_count, max_concurrency);
+  }
+
+  // When the cost of each tile is known we avoid waking workers that would
+  // spend more time being scheduled than executing: small or cheap grids get
+  // only as many shards as can each do a meaningful amount of work.
+  if (dispatch_task->tile_cost > 0 && shard_count > 1) {
+    uint64_t total_cost =
+        (uint64_t)dispatch_task->tile_count * dispatch_task->tile_cost;
+    uint64_t useful_shard_count =
+        iree_max(1, total_cost / IREE_TASK_DISPATCH_MIN_SHARD_COST);
+    shard_count = (iree_host_size_t)iree_min(shard_count, useful_shard_count);
+  }
 
   // Compute how many tiles we want each shard to reserve at a time from the
   // larger grid. A higher number reduces overhead and improves locality while
   // a lower number reduces maximum worst-case latency (coarser work stealing).
-  if (dispatch_task->tile_count <
-      worker_count * IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION) {
+  const iree_task_executor_options_t* options =
+      iree_task_post_batch_executor_options(post_batch);
+  const uint32_t tiles_per_reservation =
+      dispatch_task->preferred_tiles_per_reservation
+          ? dispatch_task->preferred_tiles_per_reservation
+          : options->dispatch_tiles_per_reservation;
+  const iree_host_size_t reserving_count =
+      iree_max(1, iree_min(worker_count, shard_count));
+  if (dispatch_task->tile_count < reserving_count * tiles_per_reservation) {
     // Grid is small - allow it to be eagerly sliced up.
     dispatch_task->tiles_per_reservation = 1;
+    dispatch_task->max_tiles_per_reservation = 1;
   } else {
-    dispatch_task->tiles_per_reservation =
-        IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION;
+    dispatch_task->tiles_per_reservation = tiles_per_reservation;
+    // Adaptive reservations may grow but are capped such that each shard still
+    // makes several reservations; otherwise a shard could take a large part of
+    // the grid in one shot and leave the others with nothing to balance with.
+    dispatch_task->max_tiles_per_reservation = iree_max(
+        dispatch_task->tiles_per_reservation,
+        iree_min(options->dispatch_max_tiles_per_reservation,
+                 dispatch_task->tile_count /
+                     (shard_count *
+                      IREE_TASK_DISPATCH_MIN_ADAPTIVE_RESERVATIONS_PER_SHARD)));
   }
+  dispatch_task->reservation_target_ns =
+      options->dispatch_reservation_target_ns;
 
   // Randomize starting worker.
-  iree_host_size_t worker_offset = iree_task_post_batch_select_worker(
-      post_batch, dispatch_task->header.affinity_set);
+  iree_host_size_t worker_offset =
+      iree_task_post_batch_select_worker(post_batch, affinity_set);
   iree_host_size_t worker_index = worker_offset;
 
   for (iree_host_size_t i = 0; i < shard_count; ++i) {
@@ -626,7 +706,13 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
     iree_task_dispatch_shard_t* shard_task =
         iree_task_dispatch_shard_allocate(dispatch_task, shard_task_pool);
 
-    // Enqueue on the worker selected for the task.
+    // Enqueue on the worker selected for the task. Confined dispatches select
+    // each worker from their affinity set (preferring idle ones) as the set
+    // may be sparse.
+    if (is_confined && i > 0) {
+      worker_index =
+          iree_task_post_batch_select_worker(post_batch, affinity_set);
+    }
     iree_task_post_batch_enqueue(post_batch, worker_index % worker_count,
                                  &shard_task->header);
     ++worker_index;
@@ -651,7 +737,11 @@ void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, dispatch_task->dispatch_id);
 
-  // TODO(benvanik): attach statistics to the tracy zone.
+#if IREE_STATISTICS_ENABLE
+  IREE_TRACE_ZONE_APPEND_VALUE(
+      z0, iree_atomic_load_int32(&dispatch_task->statistics.tile_count,
+                                 iree_memory_order_relaxed));
+#endif  // IREE_STATISTICS_ENABLE
 
   // Merge the statistics from the dispatch into the scope so we can track all
   // of the work without tracking all the dispatches at a global level.
@@ -671,6 +761,11 @@ void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
   iree_status_t status = (iree_status_t)iree_atomic_exchange_intptr(
       &dispatch_task->status, 0, iree_memory_order_seq_cst);
 
+  iree_profiler_record(
+      IREE_PROFILER_EVENT_TYPE_DISPATCH_END, (uint64_t)(uintptr_t)dispatch_task,
+      iree_string_view_empty(),
+      iree_status_is_ok(status) ? dispatch_task->tile_count : 0);
+
   iree_task_retire(&dispatch_task->header, pending_submission, status);
   IREE_TRACE_ZONE_END(z0);
 }
@@ -688,7 +783,10 @@ void iree_task_dispatch_shard_initialize(iree_task_dispatch_t* dispatch_task,
                                          iree_task_dispatch_shard_t* out_task) {
   iree_task_initialize(IREE_TASK_TYPE_DISPATCH_SHARD,
                        dispatch_task->header.scope, &out_task->header);
+  out_task->header.affinity_set = dispatch_task->header.affinity_set;
   iree_task_set_completion_task(&out_task->header, &dispatch_task->header);
+  iree_atomic_store_int32(&out_task->tile_executor_count, 1,
+                          iree_memory_order_relaxed);
 }
 
 iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
@@ -705,16 +803,74 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
   return shard_task;
 }
 
-void iree_task_dispatch_shard_execute(
-    iree_task_dispatch_shard_t* task, iree_byte_span_t worker_local_memory,
-    iree_task_submission_t* pending_submission) {
-  IREE_TRACE_ZONE_BEGIN(z0);
+static inline int64_t iree_task_tile_range_pack(uint32_t begin, uint32_t end) {
+  return (int64_t)(((uint64_t)begin << 32) | end);
+}
 
-  iree_task_dispatch_t* dispatch_task = iree_task_dispatch_shard_parent(task);
-  IREE_TRACE_ZONE_APPEND_VALUE(z0, dispatch_task->dispatch_id);
-  IREE_TRACE_ZONE_SET_COLOR(
-      z0, iree_math_ptr_to_xrgb(dispatch_task->closure.user_context));
+static inline uint32_t iree_task_tile_range_begin(int64_t range) {
+  return (uint32_t)((uint64_t)range >> 32);
+}
+
+static inline uint32_t iree_task_tile_range_end(int64_t range) {
+  return (uint32_t)range;
+}
+
+void iree_task_dispatch_reservation_initialize(
+    uint32_t relative_performance,
+    iree_task_dispatch_reservation_t* out_reservation) {
+  iree_atomic_store_int64(&out_reservation->tile_range, 0,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_intptr(&out_reservation->shard, 0,
+                           iree_memory_order_relaxed);
+  iree_atomic_store_int32(&out_reservation->thief_count, 0,
+                          iree_memory_order_relaxed);
+  out_reservation->relative_performance = relative_performance;
+}
+
+// Publishes |shard_task| in |reservation| so its tile ranges can be stolen.
+static void iree_task_dispatch_reservation_publish(
+    iree_task_dispatch_reservation_t* reservation,
+    iree_task_dispatch_shard_t* shard_task) {
+  iree_atomic_store_intptr(&reservation->shard, (intptr_t)shard_task,
+                           iree_memory_order_seq_cst);
+}
+
+// Unpublishes the shard in |reservation| and waits for any thieves that may
+// have observed it to leave. Upon return all thieves that stole tiles hold a
+// reference to the shard and no more can be acquired.
+static void iree_task_dispatch_reservation_unpublish(
+    iree_task_dispatch_reservation_t* reservation) {
+  iree_atomic_store_int64(&reservation->tile_range, 0,
+                          iree_memory_order_seq_cst);
+  iree_atomic_store_intptr(&reservation->shard, 0, iree_memory_order_seq_cst);
+  // Thieves only hold the count while splitting the range so this is short.
+  while (iree_atomic_load_int32(&reservation->thief_count,
+                                iree_memory_order_seq_cst) != 0) {
+  }
+}
+
+// Drops a reference to |shard_task| held by a thread executing its tiles and
+// retires the shard if it was the last.
+static void iree_task_dispatch_shard_release(
+    iree_task_dispatch_shard_t* shard_task,
+    iree_task_submission_t* pending_submission) {
+  if (iree_atomic_fetch_sub_int32(&shard_task->tile_executor_count, 1,
+                                  iree_memory_order_acq_rel) == 1) {
+    // NOTE: even if an error was hit we retire OK - the error has already been
+    // propagated to the dispatch and it'll clean up after all shards are
+    // joined.
+    iree_task_retire(&shard_task->header, pending_submission,
+                     iree_ok_status());
+  }
+}
 
+// Prepares a |out_tile_context| for executing tiles of |dispatch_task| using
+// |worker_local_memory| and recording into |statistics|. Returns false and
+// fails the dispatch if the local memory is insufficient.
+static bool iree_task_dispatch_prepare_tile_context(
+    iree_task_dispatch_t* dispatch_task, iree_byte_span_t worker_local_memory,
+    iree_task_dispatch_statistics_t* statistics,
+    iree_task_tile_context_t* out_tile_context) {
   // Map only the requested amount of worker local memory into the tile context.
   // This ensures that how much memory is used by some executions does not
   // inadvertently leak over into other executions.
@@ -727,78 +883,227 @@ void iree_task_dispatch_shard_execute(
                          "%zub is available per-worker",
                          dispatch_task->local_memory_size,
                          worker_local_memory.data_length));
-    iree_task_retire(&task->header, pending_submission, iree_ok_status());
-    IREE_TRACE_ZONE_END(z0);
-    return;
+    return false;
   }
-  iree_byte_span_t local_memory = iree_make_byte_span(
+  memcpy(&out_tile_context->workgroup_size, dispatch_task->workgroup_size,
+         sizeof(out_tile_context->workgroup_size));
+  memcpy(&out_tile_context->workgroup_count,
+         dispatch_task->workgroup_count.value,
+         sizeof(out_tile_context->workgroup_count));
+  out_tile_context->local_memory = iree_make_byte_span(
       worker_local_memory.data, dispatch_task->local_memory_size);
+  out_tile_context->statistics = statistics;
+  return true;
+}
 
-  // Prepare context shared for all tiles in the shard.
-  iree_task_tile_context_t tile_context;
-  memcpy(&tile_context.workgroup_size, dispatch_task->workgroup_size,
-         sizeof(tile_context.workgroup_size));
-  memcpy(&tile_context.workgroup_count, dispatch_task->workgroup_count.value,
-         sizeof(tile_context.workgroup_count));
-  uint32_t workgroup_count_x = tile_context.workgroup_count[0];
-  uint32_t workgroup_count_y = tile_context.workgroup_count[1];
-  tile_context.local_memory = local_memory;
+// Returns the FPU state the tiles of |dispatch_task| must execute with.
+// Workers run with denormals flushed to zero and only dispatches that need
+// them preserved change the state.
+static iree_fpu_state_flags_t iree_task_dispatch_fpu_state_flags(
+    const iree_task_dispatch_t* dispatch_task) {
+  return iree_all_bits_set(dispatch_task->header.flags,
+                           IREE_TASK_FLAG_DISPATCH_PRESERVE_DENORMALS)
+             ? IREE_FPU_STATE_DEFAULT
+             : IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO;
+}
+
+// Executes the tiles in [|tile_base|, |tile_end|) of |dispatch_task| in order.
+// If |reservation| is provided the range is published in it and each tile is
+// claimed before executing it so that thieves may take the tail of the range.
+// Returns false if a tile failed; the failure has been propagated to the
+// dispatch.
+static bool iree_task_dispatch_execute_tile_range(
+    iree_task_dispatch_t* dispatch_task, iree_task_tile_context_t* tile_context,
+    uint32_t tile_base, uint32_t tile_end,
+    iree_task_dispatch_reservation_t* reservation, uint32_t* tile_count,
+    iree_task_submission_t* pending_submission) {
+  const uint32_t workgroup_count_x = tile_context->workgroup_count[0];
+  const uint32_t workgroup_count_y = tile_context->workgroup_count[1];
+
+  // Decompose the first tile of the range into its grid location; the tiles in
+  // the range are sequential so the remaining locations are derived by stepping
+  // x and carrying into y and z.
+  uint32_t tile_yz = iree_math_fast_divide_u32(
+      tile_base, dispatch_task->workgroup_count_x_divisor);
+  uint32_t tile_z = iree_math_fast_divide_u32(
+      tile_yz, dispatch_task->workgroup_count_y_divisor);
+  tile_context->workgroup_xyz[0] = tile_base - tile_yz * workgroup_count_x;
+  tile_context->workgroup_xyz[1] = tile_yz - tile_z * workgroup_count_y;
+  tile_context->workgroup_xyz[2] = tile_z;
+
+  if (reservation) {
+    iree_atomic_store_int64(&reservation->tile_range,
+                            iree_task_tile_range_pack(tile_base, tile_end),
+                            iree_memory_order_seq_cst);
+  }
+
+  bool did_succeed = true;
+  for (uint32_t tile_index = tile_base; tile_index < tile_end; ++tile_index) {
+    // Claim the tile; thieves may have split off the remainder of the range.
+    if (reservation) {
+      int64_t tile_range = iree_atomic_fetch_add_int64(
+          &reservation->tile_range, iree_task_tile_range_pack(1, 0),
+          iree_memory_order_acq_rel);
+      if (tile_index >= iree_task_tile_range_end(tile_range)) break;
+    }
+
+    IREE_TRACE_ZONE_BEGIN_NAMED(z_tile,
+                                "iree_task_dispatch_shard_execute_tile");
+    IREE_TRACE_ZONE_SET_COLOR(z_tile, iree_task_tile_to_color(tile_context));
+
+    // NOTE: these are useful for debugging but dramatically increase our
+    // cost here; only enable if needed for tracking work distribution:
+    IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context->workgroup_xyz[0]);
+    IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context->workgroup_xyz[1]);
+    IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context->workgroup_xyz[2]);
+    // IREE_TRACE_ZONE_APPEND_VALUE(z_tile, (uint64_t)task->closure.fn);
+
+    iree_status_t status =
+        dispatch_task->closure.fn(dispatch_task->closure.user_context,
+                                  tile_context, pending_submission);
+
+    IREE_TRACE_ZONE_END(z_tile);
+    ++*tile_count;
+
+    // If any tile fails we bail early from the loop. This doesn't match
+    // what an accelerator would do but saves some unneeded work.
+    // Note that other shards may have completed execution, be executing
+    // concurrently with this one, or still be pending - this does not
+    // have any influence on them and they may continue to execute even
+    // after we bail from here.
+    if (!iree_status_is_ok(status)) {
+      // Propagate failures to the dispatch task.
+      iree_task_try_set_status(&dispatch_task->status, status);
+      did_succeed = false;
+      break;
+    }
+
+    // Step to the next tile in the range.
+    if (++tile_context->workgroup_xyz[0] == workgroup_count_x) {
+      tile_context->workgroup_xyz[0] = 0;
+      if (++tile_context->workgroup_xyz[1] == workgroup_count_y) {
+        tile_context->workgroup_xyz[1] = 0;
+        ++tile_context->workgroup_xyz[2];
+      }
+    }
+  }
+
+  // Close the range so that no thief takes tiles we skipped after a failure.
+  if (reservation) {
+    iree_atomic_store_int64(&reservation->tile_range, 0,
+                            iree_memory_order_seq_cst);
+  }
+  return did_succeed;
+}
+
+bool iree_task_dispatch_shard_execute(
+    iree_task_dispatch_shard_t* task, iree_byte_span_t worker_local_memory,
+    const iree_task_yield_check_t* yield_check,
+    iree_task_dispatch_reservation_t* reservation,
+    iree_task_dispatch_statistics_t* out_shard_statistics,
+    iree_task_submission_t* pending_submission) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  if (out_shard_statistics) {
+    memset(out_shard_statistics, 0, sizeof(*out_shard_statistics));
+  }
+
+  iree_task_dispatch_t* dispatch_task = iree_task_dispatch_shard_parent(task);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, dispatch_task->dispatch_id);
+  IREE_TRACE_ZONE_SET_COLOR(
+      z0, iree_math_ptr_to_xrgb(dispatch_task->closure.user_context));
 
   // We perform all our shard statistics work locally here and only push back to
   // the dispatch at the end; this avoids contention from each shard trying to
   // update the statistics together.
   iree_task_dispatch_statistics_t shard_statistics;
   memset(&shard_statistics, 0, sizeof(shard_statistics));
-  tile_context.statistics = &shard_statistics;
+
+  // Prepare context shared for all tiles in the shard.
+  iree_task_tile_context_t tile_context;
+  if (!iree_task_dispatch_prepare_tile_context(
+          dispatch_task, worker_local_memory, &shard_statistics,
+          &tile_context)) {
+    iree_task_dispatch_shard_release(task, pending_submission);
+    IREE_TRACE_ZONE_END(z0);
+    return true;
+  }
 
   // Loop over all tiles until they are all processed.
   const uint32_t tile_count = dispatch_task->tile_count;
-  const uint32_t tiles_per_reservation = dispatch_task->tiles_per_reservation;
+  uint32_t tiles_per_reservation = dispatch_task->tiles_per_reservation;
+
+  // When adapting we double the reservation size each time a reservation
+  // completes faster than the target duration. Cheap tiles quickly ramp up to
+  // the maximum while expensive tiles stay at the initial size.
+  uint32_t max_tiles_per_reservation =
+      dispatch_task->max_tiles_per_reservation;
+
+  // Slower cores (such as the efficiency cores of hybrid systems) reserve
+  // proportionally fewer tiles so that the end of the dispatch isn't left
+  // waiting on a large reservation of theirs.
+  if (reservation && reservation->relative_performance <
+                         IREE_TASK_TOPOLOGY_PERFORMANCE_SCALE) {
+    tiles_per_reservation = iree_max(
+        1, (uint32_t)((uint64_t)tiles_per_reservation *
+                      reservation->relative_performance /
+                      IREE_TASK_TOPOLOGY_PERFORMANCE_SCALE));
+    max_tiles_per_reservation = iree_max(
+        tiles_per_reservation,
+        (uint32_t)((uint64_t)max_tiles_per_reservation *
+                   reservation->relative_performance /
+                   IREE_TASK_TOPOLOGY_PERFORMANCE_SCALE));
+  }
+  const iree_duration_t reservation_target_ns =
+      dispatch_task->reservation_target_ns;
+  iree_time_t reservation_start_ns =
+      tiles_per_reservation < max_tiles_per_reservation ? iree_time_now() : 0;
+  uint32_t shard_tile_count = 0;
+  IREE_STATISTICS(uint32_t shard_reservation_count = 0);
+
+  // The highest priority never yields as nothing can preempt it.
+  const iree_task_priority_t priority =
+      (iree_task_priority_t)task->header.priority;
+  if (priority == IREE_TASK_PRIORITY_HIGH) yield_check = NULL;
+  bool did_yield = false;
+
+  if (reservation) iree_task_dispatch_reservation_publish(reservation, task);
+
+  // Switch the FPU state once for all tiles the shard executes; this is a no-op
+  // when it already matches the worker state.
+  iree_fpu_state_t fpu_state =
+      iree_fpu_state_push(iree_task_dispatch_fpu_state_flags(dispatch_task));
+
   uint32_t tile_base = iree_atomic_fetch_add_int32(&dispatch_task->tile_index,
                                                    tiles_per_reservation,
                                                    iree_memory_order_relaxed);
   while (tile_base < tile_count) {
     const uint32_t tile_range =
         iree_min(tile_base + tiles_per_reservation, tile_count);
-    for (uint32_t tile_index = tile_base; tile_index < tile_range;
-         ++tile_index) {
-      // TODO(benvanik): faster math here, especially knowing we pull off N
-      // sequential indices per reservation.
-      uint32_t tile_i = tile_index;
-      tile_context.workgroup_xyz[0] = tile_i % workgroup_count_x;
-      tile_i /= workgroup_count_x;
-      tile_context.workgroup_xyz[1] = tile_i % workgroup_count_y;
-      tile_i /= workgroup_count_y;
-      tile_context.workgroup_xyz[2] = tile_i;
-
-      IREE_TRACE_ZONE_BEGIN_NAMED(z_tile,
-                                  "iree_task_dispatch_shard_execute_tile");
-      IREE_TRACE_ZONE_SET_COLOR(z_tile, iree_task_tile_to_color(&tile_context));
-
-      // NOTE: these are useful for debugging but dramatically increase our
-      // cost here; only enable if needed for tracking work distribution:
-      IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context.workgroup_xyz[0]);
-      IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context.workgroup_xyz[1]);
-      IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context.workgroup_xyz[2]);
-      // IREE_TRACE_ZONE_APPEND_VALUE(z_tile, (uint64_t)task->closure.fn);
-
-      iree_status_t status =
-          dispatch_task->closure.fn(dispatch_task->closure.user_context,
-                                    &tile_context, pending_submission);
-
-      IREE_TRACE_ZONE_END(z_tile);
-
-      // If any tile fails we bail early from the loop. This doesn't match
-      // what an accelerator would do but saves some unneeded work.
-      // Note that other shards may have completed execution, be executing
-      // concurrently with this one, or still be pending - this does not
-      // have any influence on them and they may continue to execute even
-      // after we bail from here.
-      if (!iree_status_is_ok(status)) {
-        // Propagate failures to the dispatch task.
-        iree_task_try_set_status(&dispatch_task->status, status);
-        goto abort_shard;  // out of the while-for nest
+    IREE_STATISTICS(++shard_reservation_count);
+    if (!iree_task_dispatch_execute_tile_range(
+            dispatch_task, &tile_context, tile_base, tile_range, reservation,
+            &shard_tile_count, pending_submission)) {
+      break;
+    }
+
+    if (tiles_per_reservation < max_tiles_per_reservation) {
+      iree_time_t reservation_end_ns = iree_time_now();
+      if (reservation_end_ns - reservation_start_ns < reservation_target_ns) {
+        tiles_per_reservation =
+            iree_min(tiles_per_reservation * 2, max_tiles_per_reservation);
       }
+      reservation_start_ns = reservation_end_ns;
+    }
+
+    // Yield to higher priority work before reserving more tiles. Only worth
+    // it when tiles remain as otherwise the shard would just retire.
+    if (yield_check &&
+        (uint32_t)iree_atomic_load_int32(&dispatch_task->tile_index,
+                                         iree_memory_order_relaxed) <
+            tile_count &&
+        yield_check->fn(yield_check->user_data, priority)) {
+      did_yield = true;
+      break;
     }
 
     // Try to grab the next slice of tiles.
@@ -806,16 +1111,136 @@ void iree_task_dispatch_shard_execute(
                                             tiles_per_reservation,
                                             iree_memory_order_relaxed);
   }
-abort_shard:
+
+  iree_fpu_state_pop(fpu_state);
+
+  if (reservation) iree_task_dispatch_reservation_unpublish(reservation);
+
+#if IREE_STATISTICS_ENABLE
+  iree_atomic_store_int32(&shard_statistics.tile_count, shard_tile_count,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int32(&shard_statistics.reservation_count,
+                          shard_reservation_count, iree_memory_order_relaxed);
+  iree_atomic_store_int32(&shard_statistics.shard_count,
+                          shard_tile_count > 0 ? 1 : 0,
+                          iree_memory_order_relaxed);
+#endif  // IREE_STATISTICS_ENABLE
 
   // Push aggregate statistics up to the dispatch.
   // Note that we may have partial information here if we errored out of the
   // loop but that's still useful to know.
   iree_task_dispatch_statistics_merge(&shard_statistics,
                                       &dispatch_task->statistics);
+  if (out_shard_statistics) {
+    memcpy(out_shard_statistics, &shard_statistics,
+           sizeof(*out_shard_statistics));
+  }
 
-  // NOTE: even if an error was hit we retire OK - the error has already been
-  // propagated to the dispatch and it'll clean up after all shards are joined.
-  iree_task_retire(&task->header, pending_submission, iree_ok_status());
+  // Yielded shards are requeued by the caller and resume reserving tiles
+  // (if any remain) when next executed.
+  if (did_yield) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "yielded");
+    IREE_TRACE_ZONE_END(z0);
+    return false;
+  }
+
+  // Retire the shard unless thieves are still executing tiles they stole from
+  // it; the last of them will retire it instead.
+  iree_task_dispatch_shard_release(task, pending_submission);
+  IREE_TRACE_ZONE_END(z0);
+  return true;
+}
+
+bool iree_task_dispatch_reservation_try_steal(
+    iree_task_dispatch_reservation_t* victim_reservation,
+    iree_task_affinity_set_t thief_affinity_set,
+    iree_task_dispatch_reservation_t* thief_reservation,
+    iree_byte_span_t worker_local_memory,
+    iree_task_dispatch_statistics_t* out_statistics,
+    iree_task_submission_t* pending_submission) {
+  memset(out_statistics, 0, sizeof(*out_statistics));
+
+  // Avoid dirtying the victim's cache lines unless there's something to take.
+  int64_t tile_range = iree_atomic_load_int64(&victim_reservation->tile_range,
+                                              iree_memory_order_relaxed);
+  if (iree_task_tile_range_begin(tile_range) >=
+      iree_task_tile_range_end(tile_range)) {
+    return false;
+  }
+
+  // Announce ourselves before looking at the shard so that the victim cannot
+  // retire it while we acquire a reference.
+  iree_atomic_fetch_add_int32(&victim_reservation->thief_count, 1,
+                              iree_memory_order_seq_cst);
+  iree_task_dispatch_shard_t* shard_task =
+      (iree_task_dispatch_shard_t*)iree_atomic_load_intptr(
+          &victim_reservation->shard, iree_memory_order_seq_cst);
+  uint32_t stolen_base = 0;
+  uint32_t stolen_end = 0;
+  if (shard_task && (shard_task->header.affinity_set & thief_affinity_set) &&
+      iree_task_dispatch_shard_parent(shard_task)->local_memory_size <=
+          worker_local_memory.data_length) {
+    // Split off the back half of the remaining tiles. When a single tile
+    // remains we take it as the victim is still busy with its current one.
+    tile_range = iree_atomic_load_int64(&victim_reservation->tile_range,
+                                        iree_memory_order_seq_cst);
+    while (iree_task_tile_range_begin(tile_range) <
+           iree_task_tile_range_end(tile_range)) {
+      uint32_t begin = iree_task_tile_range_begin(tile_range);
+      uint32_t end = iree_task_tile_range_end(tile_range);
+      uint32_t split = begin + (end - begin) / 2;
+      if (iree_atomic_compare_exchange_weak_int64(
+              &victim_reservation->tile_range, &tile_range,
+              iree_task_tile_range_pack(begin, split),
+              iree_memory_order_seq_cst, iree_memory_order_seq_cst)) {
+        stolen_base = split;
+        stolen_end = end;
+        break;
+      }
+    }
+    if (stolen_base < stolen_end) {
+      iree_atomic_fetch_add_int32(&shard_task->tile_executor_count, 1,
+                                  iree_memory_order_relaxed);
+    }
+  }
+  iree_atomic_fetch_sub_int32(&victim_reservation->thief_count, 1,
+                              iree_memory_order_seq_cst);
+  if (stolen_base >= stolen_end) return false;
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_task_dispatch_t* dispatch_task =
+      iree_task_dispatch_shard_parent(shard_task);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, dispatch_task->dispatch_id);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, stolen_end - stolen_base);
+
+  // The stolen tiles are published in turn so that they may be further split
+  // if we end up being the straggler.
+  iree_task_dispatch_statistics_t statistics;
+  memset(&statistics, 0, sizeof(statistics));
+  iree_task_tile_context_t tile_context;
+  uint32_t tile_count = 0;
+  if (iree_task_dispatch_prepare_tile_context(
+          dispatch_task, worker_local_memory, &statistics, &tile_context)) {
+    iree_task_dispatch_reservation_publish(thief_reservation, shard_task);
+    iree_fpu_state_t fpu_state =
+        iree_fpu_state_push(iree_task_dispatch_fpu_state_flags(dispatch_task));
+    iree_task_dispatch_execute_tile_range(
+        dispatch_task, &tile_context, stolen_base, stolen_end,
+        thief_reservation, &tile_count, pending_submission);
+    iree_fpu_state_pop(fpu_state);
+    iree_task_dispatch_reservation_unpublish(thief_reservation);
+  }
+
+#if IREE_STATISTICS_ENABLE
+  iree_atomic_store_int32(&statistics.tile_count, tile_count,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int32(&statistics.reservation_count, 1,
+                          iree_memory_order_relaxed);
+#endif  // IREE_STATISTICS_ENABLE
+  iree_task_dispatch_statistics_merge(&statistics, &dispatch_task->statistics);
+  memcpy(out_statistics, &statistics, sizeof(*out_statistics));
+
+  iree_task_dispatch_shard_release(shard_task, pending_submission);
   IREE_TRACE_ZONE_END(z0);
+  return true;
 }
@@ -14,6 +14,7 @@
 #include "iree/base/api.h"
 #include "iree/base/internal/atomic_slist.h"
 #include "iree/base/internal/atomics.h"
+#include "iree/base/internal/math.h"
 #include "iree/base/internal/synchronization.h"
 #include "iree/task/affinity_set.h"
 
@@ -116,9 +117,33 @@ enum iree_task_flag_bits_t {
   // happens and may be available for querying before all tasks have been
   // cleaned up.
   IREE_TASK_FLAG_ABORTED = 1u << 5,
+
+  // Tiles of the dispatch must execute with denormal floating-point values
+  // preserved. Workers otherwise flush denormals to zero. The FPU state is
+  // switched once per shard (or stolen tile range) and not per tile.
+  IREE_TASK_FLAG_DISPATCH_PRESERVE_DENORMALS = 1u << 6,
 };
 typedef uint16_t iree_task_flags_t;
 
+// Relative scheduling priority of tasks sharing an executor.
+// Priorities are assigned per scope (see iree_task_scope_set_priority) and
+// workers always pick the highest priority task they have available. Dispatch
+// shards of lower priority yield between tile reservations when higher
+// priority tasks are posted to the worker executing them. Tasks already
+// executing tiles are never interrupted and there is no aging: sustained high
+// priority work will starve lower priority work.
+typedef enum iree_task_priority_e {
+  // Batch work that should only use otherwise idle workers.
+  IREE_TASK_PRIORITY_LOW = 0,
+  // Default priority of all scopes.
+  IREE_TASK_PRIORITY_NORMAL = 1,
+  // Latency-sensitive work that preempts lower priority dispatches.
+  IREE_TASK_PRIORITY_HIGH = 2,
+} iree_task_priority_t;
+
+// Total number of iree_task_priority_t levels.
+#define IREE_TASK_PRIORITY_COUNT 3
+
 typedef struct iree_task_t iree_task_t;
 
 // A function called to cleanup tasks.
@@ -177,6 +202,10 @@ struct iree_alignas(iree_max_align_t) iree_task_t {
   // Specifies the type of the task and how the executor handles it.
   iree_task_type_t type;
 
+  // Scheduling priority (iree_task_priority_t) inherited from the scope when
+  // the task was initialized.
+  uint8_t priority;
+
   // Task-specific flag bits.
   iree_task_flags_t flags;
 };
@@ -190,7 +219,7 @@ static_assert(sizeof(iree_task_t) <= 64,
 // Must be called on all tasks to ensure proper dependency tracking and list
 // state prior to enqueuing. Only the task header structure is initialized and
 // any additional data as part of the wrapping task type must be initialized by
-// the caller.
+// the caller. The task takes the current priority of |scope|.
 void iree_task_initialize(iree_task_type_t type, iree_task_scope_t* scope,
                           iree_task_t* out_task);
 
@@ -491,17 +520,27 @@ void iree_task_wait_set_wait_any(iree_task_wait_t* task,
 // generic ones like 'l2 cache misses' or 'ipc') then we can sprinkle in some
 // #ifdefs.
 typedef struct iree_task_dispatch_statistics_t {
-  // TODO(benvanik): statistics counters.
   // NOTE: each of these increases the command buffer storage requirements; we
   // should always guard these with IREE_STATISTICS_ENABLE.
+#if IREE_STATISTICS_ENABLE
+  // Total number of tiles executed.
+  iree_atomic_int32_t tile_count;
+  // Total number of tile ranges reserved from the dispatch grid. Compared to
+  // tile_count this indicates how effective batching tiles per reservation is.
+  iree_atomic_int32_t reservation_count;
+  // Total number of shards that executed at least one tile. Shards that find
+  // the grid fully reserved by the time they run are not counted.
+  iree_atomic_int32_t shard_count;
+#else
   iree_atomic_int32_t reserved;
+#endif  // IREE_STATISTICS_ENABLE
 } iree_task_dispatch_statistics_t;
 
 // Merges statistics from |source| to |target| atomically per-field.
 // As each field is updated independently and in a relaxed memory order it's
 // possible for statistics consumers to see a tear.
 void iree_task_dispatch_statistics_merge(
-    const iree_task_dispatch_statistics_t* source,
+    iree_task_dispatch_statistics_t* source,
     iree_task_dispatch_statistics_t* target);
 
 typedef struct iree_task_tile_storage_t {
@@ -623,6 +662,15 @@ typedef iree_alignas(iree_max_align_t) struct iree_task_dispatch_t {
   // dispatch closure.
   uint32_t local_memory_size;
 
+  // Optional estimated cost of each tile in abstract operations or 0 if
+  // unknown. When known the dispatch is only split across as many shards as
+  // can each perform at least IREE_TASK_DISPATCH_MIN_SHARD_COST operations.
+  uint32_t tile_cost;
+
+  // Optional preferred number of tiles to fetch per reservation or 0 to use
+  // the executor dispatch_tiles_per_reservation option.
+  uint32_t preferred_tiles_per_reservation;
+
   // Resulting status from the dispatch available once all workgroups have
   // completed (or would have completed). If multiple shards processing the
   // workgroups hit an error the first will be taken and the result ignored. A
@@ -636,11 +684,24 @@ typedef iree_alignas(iree_max_align_t) struct iree_task_dispatch_t {
   // The total number of tiles in the dispatch bounding tile_index.
   uint32_t tile_count;
 
-  // Maximum number of tiles to fetch per tile reservation from the grid.
-  // Bounded by IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION and a
+  // Precomputed divisors for workgroup_count[0] and workgroup_count[1] used to
+  // decompose the first tile index of each reservation into its xyz location.
+  iree_math_fast_divisor_u32_t workgroup_count_x_divisor;
+  iree_math_fast_divisor_u32_t workgroup_count_y_divisor;
+
+  // Number of tiles to fetch per tile reservation from the grid.
+  // Bounded by the executor dispatch_tiles_per_reservation option and a
   // reasonable number chosen based on the tile and shard counts.
   uint32_t tiles_per_reservation;
 
+  // Maximum number of tiles an adaptive reservation may grow to. Equal to
+  // tiles_per_reservation when the reservation size is not adapted.
+  uint32_t max_tiles_per_reservation;
+
+  // Target duration of each reservation used when adapting the reservation
+  // size. Ignored if max_tiles_per_reservation == tiles_per_reservation.
+  iree_duration_t reservation_target_ns;
+
   // The tail tile index; the next reservation will start from here.
   // This is used by shards to slice off the work to perform in their inner
   // loop. Ideally we'd have no destructive interference with other shared data
@@ -673,6 +734,12 @@ typedef iree_alignas(iree_max_align_t) struct {
 
   // NOTE: the parent dispatch task this shard is applied to is in the
   // header.completion_task field.
+
+  // Number of threads executing tiles on behalf of the shard: one for the
+  // shard task itself until it completes plus one for each thread that stole
+  // the tail of a tile range the shard reserved and has yet to finish it.
+  // Whichever drops this to zero retires the shard.
+  iree_atomic_int32_t tile_executor_count;
 } iree_task_dispatch_shard_t;
 
 void iree_task_dispatch_shard_initialize(iree_task_dispatch_t* dispatch_task,
@@ -12,6 +12,7 @@
 #include "iree/task/post_batch.h"
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
+#include "iree/task/topology.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -107,6 +108,62 @@ void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
 iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
     iree_task_dispatch_t* dispatch_task, iree_task_pool_t* shard_task_pool);
 
+// Returns true if a dispatch shard of |priority| executing on the calling
+// thread should yield to pending tasks of a higher priority.
+typedef bool(IREE_API_PTR* iree_task_yield_check_fn_t)(
+    void* user_data, iree_task_priority_t priority);
+
+// Callback used by dispatch shards to check whether they should yield.
+typedef struct iree_task_yield_check_t {
+  iree_task_yield_check_fn_t fn;
+  void* user_data;
+} iree_task_yield_check_t;
+
+// A tile range reserved by a dispatch shard executing on a worker published
+// so that idle workers can steal its unexecuted tail. Without this a worker
+// that reserved a large range of expensive tiles at the end of a dispatch
+// leaves the others idle until it finishes.
+//
+// The executing thread claims tiles one at a time from the front of the range
+// while thieves atomically split off the back half of what remains.
+typedef struct iree_task_dispatch_reservation_t {
+  // Packed [begin, end) range of tiles with begin in the upper 32 bits. There
+  // is nothing to steal when begin >= end.
+  iree_atomic_int64_t tile_range;
+  // The iree_task_dispatch_shard_t the tiles are executed for, if any.
+  iree_atomic_intptr_t shard;
+  // Number of thieves currently inspecting the reservation. The shard is not
+  // unpublished until all have either acquired a reference to it or left.
+  iree_atomic_int32_t thief_count;
+  // Performance of the thread reserving tiles relative to the fastest in the
+  // executor in [1, IREE_TASK_TOPOLOGY_PERFORMANCE_SCALE]. Slower threads
+  // reserve proportionally fewer tiles at a time.
+  uint32_t relative_performance;
+} iree_task_dispatch_reservation_t;
+
+// Initializes an empty |out_reservation| for a thread with the given
+// |relative_performance|.
+void iree_task_dispatch_reservation_initialize(
+    uint32_t relative_performance,
+    iree_task_dispatch_reservation_t* out_reservation);
+
+// Tries to steal the unexecuted tail of the tile range published in
+// |victim_reservation| and execute it on the calling thread. Only ranges of
+// shards with affinity for a worker in |thief_affinity_set| that require no
+// more than |worker_local_memory| are stolen. While executing the stolen tiles
+// are published in |thief_reservation| so that they can be stolen in turn.
+//
+// Returns true if tiles were stolen and executed. |out_statistics| receives
+// the statistics of their execution. If the calling thread was the last to
+// execute tiles of the shard the shard is retired into |pending_submission|.
+bool iree_task_dispatch_reservation_try_steal(
+    iree_task_dispatch_reservation_t* victim_reservation,
+    iree_task_affinity_set_t thief_affinity_set,
+    iree_task_dispatch_reservation_t* thief_reservation,
+    iree_byte_span_t worker_local_memory,
+    iree_task_dispatch_statistics_t* out_statistics,
+    iree_task_submission_t* pending_submission);
+
 // Executes and retires a dispatch shard task.
 // May block the caller for an indeterminate amount of time and should only be
 // called from threads owned by or donated to the executor.
@@ -114,10 +171,26 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
 // |worker_local_memory| is a block of memory exclusively available to the shard
 // during execution. Contents are undefined both before and after execution.
 //
+// |yield_check| is optional and if provided is queried between tile
+// reservations. When it requests a yield the shard returns false without
+// retiring and the caller must requeue it; the remaining tiles stay available
+// to other shards of the dispatch in the meantime.
+//
+// |reservation| is optional and if provided receives each tile range the
+// shard reserves so that idle workers may steal from it. The shard may then be
+// retired by a thief after this returns.
+//
+// |out_shard_statistics| is optional and if provided will receive the
+// statistics of this shard's execution so that the executing thread can
+// accumulate them.
+//
 // Errors are propagated to the parent scope and the dispatch will fail once
 // all shards have completed.
-void iree_task_dispatch_shard_execute(
+bool iree_task_dispatch_shard_execute(
     iree_task_dispatch_shard_t* task, iree_byte_span_t worker_local_memory,
+    const iree_task_yield_check_t* yield_check,
+    iree_task_dispatch_reservation_t* reservation,
+    iree_task_dispatch_statistics_t* out_shard_statistics,
     iree_task_submission_t* pending_submission);
 
 #ifdef __cplusplus
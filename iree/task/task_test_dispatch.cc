@@ -4,14 +4,18 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <memory>
+#include <thread>
 
 #include "iree/base/api.h"
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
 #include "iree/task/testing/task_test.h"
+#include "iree/task/tuning.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
@@ -149,6 +153,158 @@ TEST_F(TaskDispatchTest, IssueIndirect) {
   EXPECT_TRUE(coverage.Verify());
 }
 
+// Tests that tiles get aligned worker-local memory of the requested size.
+TEST_F(TaskDispatchTest, IssueTileCost) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {64, 4, 1};
+  GridCoverage coverage(kWorkgroupCount);
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(GridCoverage::Tile, (void*)&coverage),
+      kWorkgroupSize, kWorkgroupCount, &task);
+  // Cheap enough that the whole grid should land on a single shard.
+  task.tile_cost = 1;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_TRUE(coverage.Verify());
+}
+
+TEST_F(TaskDispatchTest, IssuePreferredTilesPerReservation) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {127, 3, 5};
+  GridCoverage coverage(kWorkgroupCount);
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(GridCoverage::Tile, (void*)&coverage),
+      kWorkgroupSize, kWorkgroupCount, &task);
+  // Odd sized reservations so that the tail of the grid is partial.
+  task.preferred_tiles_per_reservation = 7;
+  task.tile_cost = IREE_TASK_DISPATCH_MIN_SHARD_COST;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_TRUE(coverage.Verify());
+}
+
+// Tests that the tiles of a shard stuck with a large reservation of expensive
+// tiles are executed exactly once when idle workers steal the tail of it.
+TEST_F(TaskDispatchTest, IssueImbalancedReservation) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {64, 8, 1};
+  GridCoverage coverage(kWorkgroupCount);
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(
+          [](void* user_context, const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            // The first reservation is much more expensive than the rest.
+            if (tile_context->workgroup_xyz[1] == 0) {
+              std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            return GridCoverage::Tile(user_context, tile_context,
+                                      pending_submission);
+          },
+          (void*)&coverage),
+      kWorkgroupSize, kWorkgroupCount, &task);
+  task.preferred_tiles_per_reservation = 64;
+  task.tile_cost = IREE_TASK_DISPATCH_MIN_SHARD_COST;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_TRUE(coverage.Verify());
+}
+
+TEST_F(TaskDispatchTest, IssueLocalMemory) {
+  IREE_TRACE_SCOPE();
+
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {64, 4, 1};
+  static const uint32_t kLocalMemorySize = 4096;
+
+  auto tile = [](void* user_context,
+                 const iree_task_tile_context_t* tile_context,
+                 iree_task_submission_t* pending_submission) -> iree_status_t {
+    IREE_TRACE_SCOPE();
+    if (tile_context->local_memory.data_length != kLocalMemorySize ||
+        ((uintptr_t)tile_context->local_memory.data %
+         iree_hardware_destructive_interference_size) != 0) {
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "local memory not sized/aligned as expected");
+    }
+    memset(tile_context->local_memory.data, tile_context->workgroup_xyz[0],
+           tile_context->local_memory.data_length);
+    return iree_ok_status();
+  };
+
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(tile, NULL),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  task.local_memory_size = kLocalMemorySize;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  IREE_EXPECT_OK(iree_task_scope_consume_status(&scope_));
+}
+
+// Tests that workers grow their local memory when a dispatch requires more
+// than was reserved up front and that large spans are huge page aligned.
+TEST_F(TaskDispatchTest, IssueLocalMemoryGrowth) {
+  IREE_TRACE_SCOPE();
+
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {64, 1, 1};
+  static const uint32_t kLocalMemorySize =
+      IREE_TASK_WORKER_LOCAL_MEMORY_HUGE_PAGE_SIZE + 4096;
+
+  auto tile = [](void* user_context,
+                 const iree_task_tile_context_t* tile_context,
+                 iree_task_submission_t* pending_submission) -> iree_status_t {
+    IREE_TRACE_SCOPE();
+    if (tile_context->local_memory.data_length != kLocalMemorySize ||
+        ((uintptr_t)tile_context->local_memory.data %
+         IREE_TASK_WORKER_LOCAL_MEMORY_HUGE_PAGE_SIZE) != 0) {
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "local memory not sized/aligned as expected");
+    }
+    memset(tile_context->local_memory.data, tile_context->workgroup_xyz[0],
+           tile_context->local_memory.data_length);
+    return iree_ok_status();
+  };
+
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(tile, NULL),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  task.local_memory_size = kLocalMemorySize;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  IREE_EXPECT_OK(iree_task_scope_consume_status(&scope_));
+}
+
+// Tests that dispatches requiring more local memory than workers are allowed
+// to grow to fail.
+TEST_F(TaskDispatchTest, IssueLocalMemoryExhausted) {
+  IREE_TRACE_SCOPE();
+
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {4, 1, 1};
+
+  auto tile = [](void* user_context,
+                 const iree_task_tile_context_t* tile_context,
+                 iree_task_submission_t* pending_submission) -> iree_status_t {
+    return iree_make_status(IREE_STATUS_INTERNAL, "tile should not run");
+  };
+
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(tile, NULL),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  task.local_memory_size =
+      IREE_TASK_EXECUTOR_DEFAULT_WORKER_LOCAL_MEMORY_MAX_SIZE + 4096;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_THAT(Status(iree_task_scope_consume_status(&scope_)),
+              StatusIs(StatusCode::kResourceExhausted));
+}
+
 TEST_F(TaskDispatchTest, IssueFailure) {
   IREE_TRACE_SCOPE();
 
@@ -214,4 +370,52 @@ TEST_F(TaskDispatchTest, IssueFailureChained) {
               StatusIs(StatusCode::kDataLoss));
 }
 
+// Counts the tiles that observed denormals being flushed to zero.
+static iree_status_t CountFlushedDenormalsTile(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  volatile float f = 1.0f;
+  f = f * 1e-39f;
+  if (f == 0.0f) {
+    iree_atomic_fetch_add_int32((iree_atomic_int32_t*)user_context, 1,
+                                iree_memory_order_relaxed);
+  }
+  return iree_ok_status();
+}
+
+// NOTE: like fpu_state_test this assumes the FPU state of the host can be
+// controlled.
+TEST_F(TaskDispatchTest, FlushesDenormalsByDefault) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {16, 1, 1};
+  iree_atomic_int32_t flushed_count = IREE_ATOMIC_VAR_INIT(0);
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(CountFlushedDenormalsTile,
+                                      (void*)&flushed_count),
+      kWorkgroupSize, kWorkgroupCount, &task);
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_EQ(16, iree_atomic_load_int32(&flushed_count,
+                                       iree_memory_order_relaxed));
+}
+
+TEST_F(TaskDispatchTest, PreservesDenormals) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {16, 1, 1};
+  iree_atomic_int32_t flushed_count = IREE_ATOMIC_VAR_INIT(0);
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(CountFlushedDenormalsTile,
+                                      (void*)&flushed_count),
+      kWorkgroupSize, kWorkgroupCount, &task);
+  task.header.flags |= IREE_TASK_FLAG_DISPATCH_PRESERVE_DENORMALS;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_EQ(0, iree_atomic_load_int32(&flushed_count,
+                                      iree_memory_order_relaxed));
+}
+
 }  // namespace
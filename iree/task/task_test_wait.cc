@@ -7,6 +7,7 @@
 #include <atomic>
 #include <chrono>
 #include <thread>
+#include <vector>
 
 #include "iree/task/task.h"
 #include "iree/task/testing/task_test.h"
@@ -26,8 +27,8 @@ using iree::testing::status::StatusIs;
 class TaskWaitTest : public TaskTest {};
 
 // Issues a wait task on a handle that has already been signaled.
-// The poller will query the status of the handle and immediately retire the
-// task.
+// The poller will find the handle signaled on its first system wait and
+// immediately retire the task.
 TEST_F(TaskWaitTest, IssueSignaled) {
   IREE_TRACE_SCOPE();
 
@@ -149,8 +150,8 @@ TEST_F(TaskWaitTest, WaitAll) {
     EXPECT_FALSE(has_signaled);
     iree_event_set(&event_a);
     std::this_thread::sleep_for(std::chrono::milliseconds(50));
-    iree_event_set(&event_b);
     has_signaled = true;
+    iree_event_set(&event_b);
   });
 
   EXPECT_FALSE(has_signaled);
@@ -163,6 +164,63 @@ TEST_F(TaskWaitTest, WaitAll) {
   iree_event_deinitialize(&event_b);
 }
 
+// Issues many waits that join on a single task with pairs of waits sharing the
+// same handle. Each wake must retire exactly the tasks waiting on the woken
+// handle.
+TEST_F(TaskWaitTest, WaitAllMany) {
+  IREE_TRACE_SCOPE();
+
+  static const int kEventCount = 24;
+  static const int kTasksPerEvent = 2;
+  std::vector<iree_event_t> events(kEventCount);
+  std::vector<iree_task_wait_t> tasks(kEventCount * kTasksPerEvent);
+  std::vector<iree_task_t*> wait_tasks(tasks.size());
+  for (int i = 0; i < kEventCount; ++i) {
+    iree_event_initialize(/*initial_state=*/false, &events[i]);
+    for (int j = 0; j < kTasksPerEvent; ++j) {
+      iree_task_wait_t* task = &tasks[i * kTasksPerEvent + j];
+      iree_task_wait_initialize(&scope_, iree_event_await(&events[i]),
+                                IREE_TIME_INFINITE_FUTURE, task);
+      wait_tasks[i * kTasksPerEvent + j] = &task->header;
+    }
+  }
+
+  iree_task_barrier_t barrier;
+  iree_task_barrier_initialize(&scope_, wait_tasks.size(), wait_tasks.data(),
+                               &barrier);
+
+  iree_task_fence_t fence;
+  iree_task_fence_initialize(&scope_, iree_wait_primitive_immediate(), &fence);
+  for (auto& task : tasks) {
+    iree_task_set_completion_task(&task.header, &fence.header);
+  }
+
+  // Spin up a thread that will signal the events in reverse order after we
+  // start waiting on them.
+  std::atomic<bool> has_signaled = {false};
+  std::thread signal_thread([&]() {
+    IREE_TRACE_SCOPE();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    for (int i = kEventCount - 1; i > 0; --i) {
+      iree_event_set(&events[i]);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_FALSE(has_signaled);
+    has_signaled = true;
+    iree_event_set(&events[0]);
+  });
+
+  EXPECT_FALSE(has_signaled);
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&barrier.header, &fence.header));
+  EXPECT_TRUE(has_signaled);
+  IREE_EXPECT_OK(iree_task_scope_consume_status(&scope_));
+
+  signal_thread.join();
+  for (auto& event : events) {
+    iree_event_deinitialize(&event);
+  }
+}
+
 // Issues multiple waits that join on a single task but where one times out.
 TEST_F(TaskWaitTest, WaitAllTimeout) {
   IREE_TRACE_SCOPE();
@@ -239,8 +297,8 @@ TEST_F(TaskWaitTest, WaitAny) {
     // NOTE: we only signal event_a - event_b remains unsignaled.
     std::this_thread::sleep_for(std::chrono::milliseconds(50));
     EXPECT_FALSE(has_signaled);
-    iree_event_set(&event_a);
     has_signaled = true;
+    iree_event_set(&event_a);
   });
 
   EXPECT_FALSE(has_signaled);
@@ -27,6 +27,10 @@ typedef uint64_t iree_task_topology_group_mask_t;
 #define IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT \
   (sizeof(iree_task_topology_group_mask_t) * 8)
 
+// Relative performance of groups placed on the fastest cores in the machine.
+// Groups on slower cores have proportionally lower values.
+#define IREE_TASK_TOPOLOGY_PERFORMANCE_SCALE 1024
+
 // Information about a particular group within the topology.
 // Groups may be of varying levels of granularity even within the same topology
 // based on how the topology is defined.
@@ -41,6 +45,17 @@ typedef struct iree_task_topology_group_t {
   // Processor index in the cpuinfo set.
   uint32_t processor_index;
 
+  // Performance class of the core the group is placed on. 0 is the fastest
+  // class in the machine and each higher class is slower; only hybrid systems
+  // (ARM big.LITTLE/DynamIQ, Intel P/E-cores, etc) have more than one.
+  uint8_t performance_class;
+
+  // Performance of the core relative to the fastest in the machine in
+  // [1, IREE_TASK_TOPOLOGY_PERFORMANCE_SCALE]. Workers of slower groups reserve
+  // proportionally fewer dispatch tiles at a time so that they are less likely
+  // to be the ones the rest of the dispatch waits on.
+  uint16_t relative_performance;
+
   // Ideal thread affinity for threads within this group.
   // All threads within the group share the same affinity and this is what
   // allows us to model Simultaneous Multi-Threading (SMT) (aka hyperthreading).
@@ -8,6 +8,7 @@
 
 #include <cpuinfo.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "iree/base/api.h"
 #include "iree/base/internal/math.h"
@@ -46,18 +47,26 @@ static const struct cpuinfo_core* iree_task_topology_get_current_core() {
   return current_core;
 }
 
-// Returns |core_id| rotated by the calling base core ID.
+// Returns the cpuinfo index of |core|.
+static uint32_t iree_task_topology_core_index(const struct cpuinfo_core* core) {
+  return (uint32_t)(core - cpuinfo_get_core(0));
+}
+
+// Returns the index of the core to begin selection with based on |options|.
 // On many systems the kernel will have already assigned a randomized starting
 // core for thread distribution and we can just reuse that.
-static uint32_t iree_task_topology_rotate_from_base_core(uint32_t core_id) {
+static uint32_t iree_task_topology_select_base_core(
+    const iree_task_topology_cpuinfo_options_t* options) {
+  const uint32_t core_count = cpuinfo_get_cores_count();
+  if (options->base_core_index >= 0) {
+    return (uint32_t)options->base_core_index % core_count;
+  }
   const struct cpuinfo_core* current_core =
       iree_task_topology_get_current_core();
   if (!current_core) {
-    return core_id;  // don't modify if we don't know
+    return 0;  // don't rotate if we don't know
   }
-  uint32_t next_core_id =
-      (current_core->core_id + 1) % cpuinfo_get_cores_count();
-  return (next_core_id + core_id) % cpuinfo_get_cores_count();
+  return (iree_task_topology_core_index(current_core) + 1) % core_count;
 }
 
 // Sets a platform-specific iree_thread_affinity_t based on the cpuinfo
@@ -95,35 +104,168 @@ static void iree_task_topology_set_affinity_from_processor(
 #endif  // cpuinfo-like platform field
 }
 
-// Returns a bitset with all *processors* that share the same |cache|.
-static uint64_t iree_task_topology_calculate_cache_bits(
-    const struct cpuinfo_cache* cache) {
-  if (!cache) return 0;
-  uint64_t mask = 0;
-  for (uint32_t processor_i = 0; processor_i < cache->processor_count;
-       ++processor_i) {
-    uint32_t i = cache->processor_start + processor_i;
-    if (i < IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT) {
-      mask |= 1ull << i;
+// Returns true if |processor_a| and |processor_b| share some level of the
+// cache hierarchy. L3 is included as on multi-package systems it is what
+// distinguishes stealing from a neighbor from stealing across the socket
+// interconnect.
+static bool iree_task_topology_processors_share_cache(
+    const struct cpuinfo_processor* processor_a,
+    const struct cpuinfo_processor* processor_b) {
+#define IREE_TASK_TOPOLOGY_SHARES_CACHE(level) \
+  (processor_a->cache.level &&                 \
+   processor_a->cache.level == processor_b->cache.level)
+  return IREE_TASK_TOPOLOGY_SHARES_CACHE(l1i) ||
+         IREE_TASK_TOPOLOGY_SHARES_CACHE(l1d) ||
+         IREE_TASK_TOPOLOGY_SHARES_CACHE(l2) ||
+         IREE_TASK_TOPOLOGY_SHARES_CACHE(l3);
+#undef IREE_TASK_TOPOLOGY_SHARES_CACHE
+}
+
+//===----------------------------------------------------------------------===//
+// Performance classes
+//===----------------------------------------------------------------------===//
+
+// Maximum number of distinct performance classes tracked. Slower cores beyond
+// this are folded into the slowest class.
+#define IREE_TASK_TOPOLOGY_MAX_PERFORMANCE_CLASS_COUNT 8
+
+// Cores with capacities within this percentage of the fastest core in a class
+// are considered part of the class. This keeps cores that differ only by
+// their boost clocks (such as Intel's favored cores) together.
+#define IREE_TASK_TOPOLOGY_PERFORMANCE_CLASS_TOLERANCE_PERCENT 15
+
+// Performance classes of the cores in the machine ordered fastest first.
+typedef struct iree_task_topology_performance_classes_t {
+  uint32_t count;
+  // Capacity of the fastest core in each class.
+  uint64_t capacities[IREE_TASK_TOPOLOGY_MAX_PERFORMANCE_CLASS_COUNT];
+} iree_task_topology_performance_classes_t;
+
+#if defined(IREE_PLATFORM_LINUX)
+// Reads a single unsigned integer from the sysfs file at |path|.
+// Returns 0 if the file does not exist or could not be parsed.
+static uint64_t iree_task_topology_read_sysfs_uint(const char* path) {
+  FILE* file = fopen(path, "r");
+  if (!file) return 0;
+  unsigned long long value = 0;
+  if (fscanf(file, "%llu", &value) != 1) value = 0;
+  fclose(file);
+  return (uint64_t)value;
+}
+#endif  // IREE_PLATFORM_LINUX
+
+// Returns the relative compute capacity of |core| or 0 if unknown.
+// Values are only comparable between cores of the same machine.
+static uint64_t iree_task_topology_core_capacity(
+    const struct cpuinfo_core* core) {
+#if defined(IREE_PLATFORM_LINUX)
+  // The kernel exposes the capacity it uses for its own energy-aware
+  // scheduling on ARM systems (scaled such that the fastest core is 1024).
+  // Elsewhere the maximum frequency is the best indicator we have; hybrid x86
+  // efficiency cores run at lower clocks than the performance cores.
+  uint32_t linux_id = cpuinfo_get_processor(core->processor_start)->linux_id;
+  char path[128];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpu_capacity",
+           linux_id);
+  uint64_t capacity = iree_task_topology_read_sysfs_uint(path);
+  if (capacity) return capacity;
+  snprintf(path, sizeof(path),
+           "/sys/devices/system/cpu/cpu%u/cpufreq/cpuinfo_max_freq", linux_id);
+  capacity = iree_task_topology_read_sysfs_uint(path);
+  if (capacity) return capacity;
+#endif  // IREE_PLATFORM_LINUX
+  return core->frequency;
+}
+
+// Returns true if a core with |capacity| belongs to the class whose fastest
+// core has |leader_capacity|.
+static bool iree_task_topology_capacity_in_class(uint64_t capacity,
+                                                 uint64_t leader_capacity) {
+  return capacity * 100 >=
+         leader_capacity *
+             (100 - IREE_TASK_TOPOLOGY_PERFORMANCE_CLASS_TOLERANCE_PERCENT);
+}
+
+// Returns the performance class of a core with |capacity| in |classes|.
+static uint32_t iree_task_topology_capacity_class(
+    const iree_task_topology_performance_classes_t* classes,
+    uint64_t capacity) {
+  for (uint32_t i = 0; i + 1 < classes->count; ++i) {
+    if (iree_task_topology_capacity_in_class(capacity,
+                                             classes->capacities[i])) {
+      return i;
     }
   }
-  return mask;
+  return classes->count - 1;
 }
 
-// Constructs a constructive sharing mask for all *processors* that share the
-// same cache as the specified |processor|.
-static uint64_t iree_task_topology_calculate_constructive_sharing_mask(
-    const struct cpuinfo_processor* processor) {
-  uint64_t mask = 0;
-  mask |= iree_task_topology_calculate_cache_bits(processor->cache.l1i);
-  mask |= iree_task_topology_calculate_cache_bits(processor->cache.l1d);
-  mask |= iree_task_topology_calculate_cache_bits(processor->cache.l2);
-  // TODO(benvanik): include L3 here too (for systems that have it)? Or use L3
-  // info purely for distribution and focus the group mask on lower-latency
-  // caches?
-  return mask;
+// Clusters all cores in the machine into performance classes by capacity.
+// Machines where capacities are unknown have a single class.
+static void iree_task_topology_query_performance_classes(
+    iree_task_topology_performance_classes_t* out_classes) {
+  memset(out_classes, 0, sizeof(*out_classes));
+  out_classes->count = 1;
+
+  // Gather the distinct capacities sorted fastest first.
+  uint64_t capacities[IREE_TASK_TOPOLOGY_MAX_PERFORMANCE_CLASS_COUNT] = {0};
+  uint32_t capacity_count = 0;
+  for (uint32_t i = 0; i < cpuinfo_get_cores_count(); ++i) {
+    uint64_t capacity = iree_task_topology_core_capacity(cpuinfo_get_core(i));
+    if (!capacity) return;  // unknown; treat all cores equally
+    uint32_t j = 0;
+    while (j < capacity_count && capacities[j] > capacity) ++j;
+    if (j < capacity_count && capacities[j] == capacity) continue;
+    if (capacity_count < IREE_ARRAYSIZE(capacities)) ++capacity_count;
+    for (uint32_t k = capacity_count - 1; k > j; --k) {
+      capacities[k] = capacities[k - 1];
+    }
+    if (j < capacity_count) capacities[j] = capacity;
+  }
+
+  // Each class is led by the fastest capacity not within the tolerance of the
+  // previous class.
+  out_classes->capacities[0] = capacities[0];
+  for (uint32_t i = 1; i < capacity_count; ++i) {
+    if (!iree_task_topology_capacity_in_class(
+            capacities[i], out_classes->capacities[out_classes->count - 1])) {
+      out_classes->capacities[out_classes->count++] = capacities[i];
+    }
+  }
+}
+
+// Returns the performance class of |core| in |classes|.
+static uint32_t iree_task_topology_core_performance_class(
+    const iree_task_topology_performance_classes_t* classes,
+    const struct cpuinfo_core* core) {
+  if (classes->count <= 1) return 0;
+  return iree_task_topology_capacity_class(
+      classes, iree_task_topology_core_capacity(core));
+}
+
+// Assigns the performance class and relative performance of the core each
+// group in |topology| is placed on.
+static void iree_task_topology_assign_performance(
+    const iree_task_topology_performance_classes_t* classes,
+    iree_task_topology_t* topology) {
+  if (classes->count <= 1) return;  // all equal (or unknown)
+  for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
+    iree_task_topology_group_t* group = &topology->groups[i];
+    const struct cpuinfo_core* core =
+        cpuinfo_get_processor(group->processor_index)->core;
+    uint64_t capacity = iree_task_topology_core_capacity(core);
+    group->performance_class =
+        (uint8_t)iree_task_topology_capacity_class(classes, capacity);
+    group->relative_performance = (uint16_t)iree_max(
+        1, iree_min(IREE_TASK_TOPOLOGY_PERFORMANCE_SCALE,
+                    capacity * IREE_TASK_TOPOLOGY_PERFORMANCE_SCALE /
+                        classes->capacities[0]));
+  }
 }
 
+//===----------------------------------------------------------------------===//
+// Core selection
+//===----------------------------------------------------------------------===//
+
 // Populates |our_group| with the information from |core|.
 static void iree_task_topology_group_initialize_from_core(
     uint32_t group_index, const struct cpuinfo_core* core,
@@ -149,21 +291,20 @@ static void iree_task_topology_group_initialize_from_core(
 static void iree_task_topology_fixup_constructive_sharing_masks(
     iree_task_topology_t* topology) {
   // O(n^2), but n is always <= 64 (and often <= 8).
+  // We compare the caches directly instead of building masks of processor
+  // indices as machines with multiple packages often have more than 64.
   for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
     iree_task_topology_group_t* group = &topology->groups[i];
-
-    // Compute the processors that we can constructively share with.
-    uint64_t constructive_sharing_mask =
-        iree_task_topology_calculate_constructive_sharing_mask(
-            cpuinfo_get_processor(group->processor_index));
+    const struct cpuinfo_processor* processor =
+        cpuinfo_get_processor(group->processor_index);
 
     iree_task_topology_group_mask_t group_mask = 0;
     for (iree_host_size_t j = 0; j < topology->group_count; ++j) {
       if (i == j) continue;
       const iree_task_topology_group_t* other_group = &topology->groups[j];
-      uint64_t group_processor_bits =
-          iree_math_rotl_u64(1ull, other_group->processor_index);
-      if (constructive_sharing_mask & group_processor_bits) {
+      if (iree_task_topology_processors_share_cache(
+              processor,
+              cpuinfo_get_processor(other_group->processor_index))) {
         group_mask |= iree_math_rotl_u64(1ull, other_group->group_index);
       }
     }
@@ -187,16 +328,188 @@ static void iree_task_topology_initialize_fallback(
   IREE_TRACE_ZONE_END(z0);
 }
 
-// Matches all cores.
-static bool iree_task_topology_core_filter_all(const struct cpuinfo_core* core,
-                                               uintptr_t user_data) {
+void iree_task_topology_cpuinfo_options_initialize(
+    iree_task_topology_cpuinfo_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->base_core_index = IREE_TASK_TOPOLOGY_BASE_CORE_CALLER;
+  out_options->distribution = IREE_TASK_TOPOLOGY_DISTRIBUTION_PACKED;
+}
+
+// Matches cores of any performance class.
+#define IREE_TASK_TOPOLOGY_ANY_PERFORMANCE_CLASS UINT32_MAX
+
+// Returns true if |core| may be used for a group based on |options|.
+// If |unique_l2_cache| is true then only the first core of each L2 cache is
+// accepted. Only cores in |performance_class| of |classes| are accepted unless
+// it is IREE_TASK_TOPOLOGY_ANY_PERFORMANCE_CLASS.
+static bool iree_task_topology_is_core_selectable(
+    const iree_task_topology_cpuinfo_options_t* options, bool unique_l2_cache,
+    const iree_task_topology_performance_classes_t* classes,
+    uint32_t performance_class, const struct cpuinfo_core* core) {
+  if (options->package_mask) {
+    uint32_t package_index = (uint32_t)(core->package - cpuinfo_get_package(0));
+    if (package_index >= 64 ||
+        !(options->package_mask & (1ull << package_index))) {
+      return false;
+    }
+  }
+  if (unique_l2_cache) {
+    const struct cpuinfo_cache* l2_cache =
+        cpuinfo_get_processor(core->processor_start)->cache.l2;
+    if (l2_cache && cpuinfo_get_processor(l2_cache->processor_start)->core !=
+                        core) {
+      return false;
+    }
+  }
+  if (options->exclude_efficiency_cores ||
+      performance_class != IREE_TASK_TOPOLOGY_ANY_PERFORMANCE_CLASS) {
+    uint32_t core_class =
+        iree_task_topology_core_performance_class(classes, core);
+    if (options->exclude_efficiency_cores && core_class != 0) return false;
+    if (performance_class != IREE_TASK_TOPOLOGY_ANY_PERFORMANCE_CLASS &&
+        core_class != performance_class) {
+      return false;
+    }
+  }
+  if (options->filter_fn &&
+      !options->filter_fn(core, options->filter_fn_data)) {
+    return false;
+  }
   return true;
 }
 
+// Returns the number of distribution domains (L3 caches or packages).
+static uint32_t iree_task_topology_domain_count() {
+  uint32_t l3_cache_count = cpuinfo_get_l3_caches_count();
+  return l3_cache_count ? l3_cache_count : cpuinfo_get_packages_count();
+}
+
+// Returns the distribution domain of |core|: the L3 cache it uses if the
+// system has L3 caches and otherwise the package it is in.
+static uint32_t iree_task_topology_core_domain(
+    const struct cpuinfo_core* core) {
+  if (cpuinfo_get_l3_caches_count()) {
+    const struct cpuinfo_cache* l3_cache =
+        cpuinfo_get_processor(core->processor_start)->cache.l3;
+    return l3_cache ? (uint32_t)(l3_cache - cpuinfo_get_l3_cache(0)) : 0;
+  }
+  return (uint32_t)(core->package - cpuinfo_get_package(0));
+}
+
+// Returns the |n|th selectable core of |performance_class| in |domain| walking
+// cores in order starting from |base_core_index| and wrapping. UINT32_MAX
+// matches any domain. Returns NULL if there are not enough selectable cores.
+static const struct cpuinfo_core* iree_task_topology_find_selectable_core(
+    const iree_task_topology_cpuinfo_options_t* options, bool unique_l2_cache,
+    const iree_task_topology_performance_classes_t* classes,
+    uint32_t performance_class, uint32_t base_core_index, uint32_t domain,
+    uint32_t n) {
+  const uint32_t core_count = cpuinfo_get_cores_count();
+  for (uint32_t i = 0; i < core_count; ++i) {
+    const struct cpuinfo_core* core =
+        cpuinfo_get_core((base_core_index + i) % core_count);
+    if (domain != UINT32_MAX &&
+        iree_task_topology_core_domain(core) != domain) {
+      continue;
+    }
+    if (!iree_task_topology_is_core_selectable(options, unique_l2_cache,
+                                               classes, performance_class,
+                                               core)) {
+      continue;
+    }
+    if (n-- == 0) return core;
+  }
+  return NULL;
+}
+
+// Initializes |out_topology| with one group per core selected by |options|.
+// Groups are assigned to the fastest performance class first such that when
+// there are fewer groups than cores the slower cores are the ones left unused.
+static void iree_task_topology_initialize_from_selected_cores(
+    const iree_task_topology_cpuinfo_options_t* options, bool unique_l2_cache,
+    iree_host_size_t max_group_count, iree_task_topology_t* out_topology) {
+  max_group_count =
+      iree_min(max_group_count, IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT);
+  max_group_count =
+      iree_min(max_group_count, IREE_ARRAYSIZE(out_topology->groups));
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, max_group_count);
+
+  iree_task_topology_performance_classes_t classes;
+  iree_task_topology_query_performance_classes(&classes);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, classes.count);
+
+  iree_task_topology_initialize(out_topology);
+
+  const uint32_t base_core_index = iree_task_topology_select_base_core(options);
+  const uint32_t domain_count = iree_task_topology_domain_count();
+  uint32_t group_i = 0;
+  for (uint32_t class_i = 0;
+       class_i < classes.count && group_i < max_group_count; ++class_i) {
+    // Count cores of the class that can be selected.
+    iree_host_size_t selectable_count = 0;
+    for (uint32_t i = 0; i < cpuinfo_get_cores_count(); i++) {
+      if (iree_task_topology_is_core_selectable(options, unique_l2_cache,
+                                                &classes, class_i,
+                                                cpuinfo_get_core(i))) {
+        ++selectable_count;
+      }
+    }
+    const iree_host_size_t group_count =
+        group_i + iree_min(selectable_count, max_group_count - group_i);
+
+    if (options->distribution == IREE_TASK_TOPOLOGY_DISTRIBUTION_SPREAD &&
+        domain_count > 1) {
+      // Round-robin across domains starting with the one containing the base
+      // core: each pass takes the next selectable core from each domain.
+      // Domains that run out of cores are skipped. Each pass selects at least
+      // one core as we never request more groups than there are selectable
+      // cores.
+      const uint32_t base_domain =
+          iree_task_topology_core_domain(cpuinfo_get_core(base_core_index));
+      for (uint32_t pass = 0; group_i < group_count; ++pass) {
+        for (uint32_t domain_i = 0;
+             domain_i < domain_count && group_i < group_count; ++domain_i) {
+          const struct cpuinfo_core* core =
+              iree_task_topology_find_selectable_core(
+                  options, unique_l2_cache, &classes, class_i,
+                  base_core_index, (base_domain + domain_i) % domain_count,
+                  pass);
+          if (!core) continue;
+          iree_task_topology_group_initialize_from_core(
+              group_i, core, &out_topology->groups[group_i]);
+          ++group_i;
+        }
+      }
+    } else {
+      // Straight-line through the cores from the base; cpuinfo orders cores by
+      // package and cache so this fills each domain before moving to the next.
+      for (uint32_t core_i = 0; group_i < group_count; ++core_i) {
+        const struct cpuinfo_core* core = cpuinfo_get_core(
+            (base_core_index + core_i) % cpuinfo_get_cores_count());
+        if (!iree_task_topology_is_core_selectable(options, unique_l2_cache,
+                                                   &classes, class_i, core)) {
+          continue;
+        }
+        iree_task_topology_group_initialize_from_core(
+            group_i, core, &out_topology->groups[group_i]);
+        ++group_i;
+      }
+    }
+  }
+  out_topology->group_count = group_i;
+
+  iree_task_topology_fixup_constructive_sharing_masks(out_topology);
+  iree_task_topology_assign_performance(&classes, out_topology);
+  IREE_TRACE_ZONE_END(z0);
+}
+
 void iree_task_topology_initialize_from_physical_cores(
     iree_host_size_t max_core_count, iree_task_topology_t* out_topology) {
-  iree_task_topology_initialize_from_physical_cores_with_filter(
-      iree_task_topology_core_filter_all, 0, max_core_count, out_topology);
+  iree_task_topology_cpuinfo_options_t options;
+  iree_task_topology_cpuinfo_options_initialize(&options);
+  iree_task_topology_initialize_from_physical_cores_with_options(
+      &options, max_core_count, out_topology);
 }
 
 // Matches only cores with the uarch as specified in |user_data|.
@@ -216,85 +529,54 @@ void iree_task_topology_initialize_from_physical_cores_with_uarch(
 void iree_task_topology_initialize_from_physical_cores_with_filter(
     iree_task_topology_core_filter_t filter_fn, uintptr_t filter_fn_data,
     iree_host_size_t max_core_count, iree_task_topology_t* out_topology) {
-  max_core_count = iree_min(max_core_count, IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT);
+  iree_task_topology_cpuinfo_options_t options;
+  iree_task_topology_cpuinfo_options_initialize(&options);
+  options.filter_fn = filter_fn;
+  options.filter_fn_data = filter_fn_data;
+  iree_task_topology_initialize_from_physical_cores_with_options(
+      &options, max_core_count, out_topology);
+}
+
+void iree_task_topology_initialize_from_physical_cores_with_options(
+    const iree_task_topology_cpuinfo_options_t* options,
+    iree_host_size_t max_core_count, iree_task_topology_t* out_topology) {
   if (!iree_task_topology_is_cpuinfo_available()) {
     iree_task_topology_initialize_fallback(max_core_count, out_topology);
     return;
   }
-
-  IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_TRACE_ZONE_APPEND_VALUE(z0, max_core_count);
-
-  // Count cores that match the filter.
-  iree_host_size_t core_count = 0;
-  for (uint32_t i = 0; i < cpuinfo_get_cores_count(); i++) {
-    const struct cpuinfo_core* core = cpuinfo_get_core(i);
-    if (filter_fn(core, filter_fn_data)) ++core_count;
-  }
-  core_count = iree_min(core_count, max_core_count);
-
-  iree_task_topology_initialize(out_topology);
-
-  // Build each core up to the max allowed.
-  // TODO(benvanik): if our group_count <= core_count/2 then distribute better;
-  // for now we just do a straight-line through (cores 0-N) when instead we may
-  // want to take advantage of L3 cache info (half of groups on one L3 cache,
-  // half of groups on another, etc).
-  out_topology->group_count = core_count;
-  for (uint32_t core_i = 0, group_i = 0; group_i < out_topology->group_count;
-       ++core_i) {
-    // Rotate the core ID so that we avoid setting the affinity to the calling
-    // thread which we assume is something the user has plans for and doesn't
-    // want to have our workers stealing their time.
-    const struct cpuinfo_core* core =
-        cpuinfo_get_core(iree_task_topology_rotate_from_base_core(core_i));
-    if (filter_fn(core, filter_fn_data)) {
-      iree_task_topology_group_initialize_from_core(
-          group_i, core, &out_topology->groups[group_i]);
-      ++group_i;
-    }
-  }
-
-  iree_task_topology_fixup_constructive_sharing_masks(out_topology);
-  IREE_TRACE_ZONE_END(z0);
+  iree_task_topology_initialize_from_selected_cores(
+      options, /*unique_l2_cache=*/false, max_core_count, out_topology);
 }
 
 void iree_task_topology_initialize_from_unique_l2_cache_groups(
     iree_host_size_t max_group_count, iree_task_topology_t* out_topology) {
+  iree_task_topology_cpuinfo_options_t options;
+  iree_task_topology_cpuinfo_options_initialize(&options);
+  iree_task_topology_initialize_from_unique_l2_cache_groups_with_options(
+      &options, max_group_count, out_topology);
+}
+
+void iree_task_topology_initialize_from_unique_l2_cache_groups_with_options(
+    const iree_task_topology_cpuinfo_options_t* options,
+    iree_host_size_t max_group_count, iree_task_topology_t* out_topology) {
   if (!iree_task_topology_is_cpuinfo_available() ||
       !cpuinfo_get_l2_caches_count()) {
-    iree_task_topology_initialize_from_physical_cores(max_group_count,
-                                                      out_topology);
+    iree_task_topology_initialize_from_physical_cores_with_options(
+        options, max_group_count, out_topology);
     return;
   }
+  iree_task_topology_initialize_from_selected_cores(
+      options, /*unique_l2_cache=*/true, max_group_count, out_topology);
+}
 
-  IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_TRACE_ZONE_APPEND_VALUE(z0, max_group_count);
-
-  iree_host_size_t cache_count = cpuinfo_get_l2_caches_count();
-  cache_count = iree_min(cache_count, max_group_count);
-
-  iree_task_topology_initialize(out_topology);
-
-  // TODO(benvanik): iree_task_topology_rotate_from_base_core to offset all of
-  // the selection here (while still preserving the cache groups). May need to
-  // rework this to instead walk the core list and skip until a new cache is
-  // found instead of starting with the cache list.
-
-  // TODO(benvanik): if our group_count <= cache_count/2 then distribute better;
-  // we could use l3 cache in addition to ensure we are selecting cores that do
-  // (or do not) share.
-  out_topology->group_count = cache_count;
-  for (uint32_t cache_i = 0, group_i = 0; group_i < out_topology->group_count;
-       ++cache_i) {
-    const struct cpuinfo_cache* cache = cpuinfo_get_l2_cache(cache_i);
-    const struct cpuinfo_core* core =
-        cpuinfo_get_processor(cache->processor_start)->core;
-    iree_task_topology_group_initialize_from_core(
-        group_i, core, &out_topology->groups[group_i]);
-    ++group_i;
-  }
-
-  iree_task_topology_fixup_constructive_sharing_masks(out_topology);
-  IREE_TRACE_ZONE_END(z0);
+void iree_task_topology_query_cache_sizes(iree_task_cache_sizes_t* out_sizes) {
+  memset(out_sizes, 0, sizeof(*out_sizes));
+  if (!iree_task_topology_is_cpuinfo_available()) return;
+  const struct cpuinfo_core* core = iree_task_topology_get_current_core();
+  if (!core) core = cpuinfo_get_core(0);
+  const struct cpuinfo_processor* processor =
+      cpuinfo_get_processor(core->processor_start);
+  if (processor->cache.l1d) out_sizes->l1_data = processor->cache.l1d->size;
+  if (processor->cache.l2) out_sizes->l2 = processor->cache.l2->size;
+  if (processor->cache.l3) out_sizes->l3 = processor->cache.l3->size;
 }
@@ -19,6 +19,67 @@ extern "C" {
 
 struct cpuinfo_core;
 
+// Returns true if the given |core| passes the filter and should be included.
+// |user_data| is the value passed alongside the filter function.
+typedef bool (*iree_task_topology_core_filter_t)(
+    const struct cpuinfo_core* core, uintptr_t user_data);
+
+// Controls how groups are distributed across the available cores when there
+// are fewer groups than cores.
+typedef enum iree_task_topology_distribution_e {
+  // Groups are assigned to sequential cores such that they fill up an L3 cache
+  // (or package if there is no L3) before spilling over to the next. Workers
+  // stealing from their constructive sharing peers stay within the same cache
+  // and it leaves entire caches free for other processes.
+  IREE_TASK_TOPOLOGY_DISTRIBUTION_PACKED = 0,
+  // Groups are assigned round-robin across L3 caches (or packages if there is
+  // no L3) such that each cache has roughly the same number of groups. This
+  // maximizes the aggregate cache capacity and memory bandwidth available at
+  // the cost of more theft crossing between caches.
+  IREE_TASK_TOPOLOGY_DISTRIBUTION_SPREAD = 1,
+} iree_task_topology_distribution_t;
+
+// Indicates that core selection should start with the core after the one the
+// calling thread is running on (if known). This avoids setting the affinity of
+// a worker to the calling thread which we assume is something the user has
+// plans for and doesn't want to have our workers stealing its time.
+#define IREE_TASK_TOPOLOGY_BASE_CORE_CALLER (-1)
+
+// Options controlling how cores are selected when initializing a topology from
+// the cpuinfo-reported machine configuration.
+typedef struct iree_task_topology_cpuinfo_options_t {
+  // Optional filter used to exclude cores from selection. NULL includes all.
+  iree_task_topology_core_filter_t filter_fn;
+  uintptr_t filter_fn_data;
+
+  // Bitmask of packages (sockets) cores may be selected from, indexed by the
+  // cpuinfo package index. 0 allows all packages. cpuinfo does not expose NUMA
+  // nodes directly but each package is its own NUMA node (or set of nodes) on
+  // the systems we target. Multiple instances can be run side by side without
+  // contending for caches or cross-socket bandwidth by giving them disjoint
+  // package masks.
+  uint64_t package_mask;
+
+  // Index of the cpuinfo core to begin selection with; selection walks the
+  // cores in order from here and wraps around. Cores rejected by the filter or
+  // package mask are skipped. IREE_TASK_TOPOLOGY_BASE_CORE_CALLER begins after
+  // the core of the calling thread.
+  int32_t base_core_index;
+
+  // Distribution of groups across caches when not all cores are used.
+  iree_task_topology_distribution_t distribution;
+
+  // Excludes all cores slower than the fastest performance class on hybrid
+  // systems. By default all classes are used with groups placed on the faster
+  // classes first such that limiting the group count prefers them.
+  bool exclude_efficiency_cores;
+} iree_task_topology_cpuinfo_options_t;
+
+// Initializes |out_options| to the defaults: all cores in all packages packed
+// starting after the core of the calling thread.
+void iree_task_topology_cpuinfo_options_initialize(
+    iree_task_topology_cpuinfo_options_t* out_options);
+
 // Initializes a topology with one group for each physical core in the machine.
 //
 // If detailed cache information is not available this is a decent
@@ -35,11 +96,6 @@ void iree_task_topology_initialize_from_physical_cores_with_uarch(
     uint32_t cpuinfo_uarch, iree_host_size_t max_core_count,
     iree_task_topology_t* out_topology);
 
-// Returns true if the given |core| passes the filter and should be included.
-// |user_data| is the value passed alongside the filter function.
-typedef bool (*iree_task_topology_core_filter_t)(
-    const struct cpuinfo_core* core, uintptr_t user_data);
-
 // Initializes a topology with one group for each core that matches |filter_fn|.
 //
 // If cpuinfo is not available this falls back to the same behavior as
@@ -48,6 +104,14 @@ void iree_task_topology_initialize_from_physical_cores_with_filter(
     iree_task_topology_core_filter_t filter_fn, uintptr_t filter_fn_data,
     iree_host_size_t max_core_count, iree_task_topology_t* out_topology);
 
+// Initializes a topology with one group for each core selected by |options|.
+//
+// If cpuinfo is not available this falls back to the same behavior as
+// iree_task_topology_initialize_from_physical_cores.
+void iree_task_topology_initialize_from_physical_cores_with_options(
+    const iree_task_topology_cpuinfo_options_t* options,
+    iree_host_size_t max_core_count, iree_task_topology_t* out_topology);
+
 // Initializes a topology with one group for each unique L2 cache group across
 // all available cores. This optimizes for temporal and spatial cache locality
 // but may suffer from oversubscription if there are other processes trying to
@@ -58,11 +122,33 @@ void iree_task_topology_initialize_from_physical_cores_with_filter(
 void iree_task_topology_initialize_from_unique_l2_cache_groups(
     iree_host_size_t max_group_count, iree_task_topology_t* out_topology);
 
+// Initializes a topology with one group for each unique L2 cache group across
+// the cores selected by |options|. The first core sharing each L2 cache is the
+// one used for the group and must pass the filter for the cache to be used.
+//
+// If detailed cache information is not available this falls back to the same
+// behavior as iree_task_topology_initialize_from_physical_cores_with_options.
+void iree_task_topology_initialize_from_unique_l2_cache_groups_with_options(
+    const iree_task_topology_cpuinfo_options_t* options,
+    iree_host_size_t max_group_count, iree_task_topology_t* out_topology);
+
+// Sizes in bytes of the caches used by a single core. Levels that are not
+// present or could not be queried are 0. Caches shared across cores (usually
+// the L3) report their total size.
+typedef struct iree_task_cache_sizes_t {
+  iree_host_size_t l1_data;
+  iree_host_size_t l2;
+  iree_host_size_t l3;
+} iree_task_cache_sizes_t;
+
+// Queries the cache sizes of the core the calling thread is running on (or the
+// first core if unknown). All sizes are 0 if cpuinfo is not available.
+void iree_task_topology_query_cache_sizes(iree_task_cache_sizes_t* out_sizes);
+
 // TODO(#4654): more helpers and better defaults for the platforms we support.
 // Users can always make their own but just using these is the common path.
 // Ideas:
 // - _from_unique_l2_cache_groups but with a min/max count (N% utilization)
-// - cluster filtering (big/little cores on ARM)
 
 #ifdef __cplusplus
 }  // extern "C"
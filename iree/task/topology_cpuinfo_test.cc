@@ -29,6 +29,24 @@ static void EnsureTopologyValid(iree_host_size_t max_group_count,
     const iree_task_topology_group_t* group =
         iree_task_topology_get_group(topology, i);
     EXPECT_EQ(i, group->group_index);
+    // Groups only share with other groups in the topology and not themselves.
+    iree_task_topology_group_mask_t valid_mask =
+        iree_task_topology_group_count(topology) >= 64
+            ? IREE_TASK_TOPOLOGY_GROUP_MASK_ALL
+            : (1ull << iree_task_topology_group_count(topology)) - 1;
+    if (group->constructive_sharing_mask != IREE_TASK_TOPOLOGY_GROUP_MASK_ALL) {
+      EXPECT_EQ(0, group->constructive_sharing_mask & ~valid_mask);
+      EXPECT_EQ(0, group->constructive_sharing_mask & (1ull << i));
+    }
+    // Groups are ordered fastest performance class first.
+    EXPECT_GE(group->relative_performance, 1);
+    EXPECT_LE(group->relative_performance,
+              IREE_TASK_TOPOLOGY_PERFORMANCE_SCALE);
+    if (i > 0) {
+      EXPECT_GE(group->performance_class,
+                iree_task_topology_get_group(topology, i - 1)
+                    ->performance_class);
+    }
   }
 }
 
@@ -41,4 +59,84 @@ TEST(TopologyTest, FromPhysicalCores) {
   iree_task_topology_deinitialize(&topology);
 }
 
+TEST(TopologyTest, FromPhysicalCoresWithOptions) {
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_cpuinfo_options_t options;
+  iree_task_topology_cpuinfo_options_initialize(&options);
+  options.base_core_index = 0;
+  for (auto distribution : {IREE_TASK_TOPOLOGY_DISTRIBUTION_PACKED,
+                            IREE_TASK_TOPOLOGY_DISTRIBUTION_SPREAD}) {
+    options.distribution = distribution;
+    iree_task_topology_t topology;
+    iree_task_topology_initialize(&topology);
+    iree_task_topology_initialize_from_physical_cores_with_options(
+        &options, kMaxGroupCount, &topology);
+    EnsureTopologyValid(kMaxGroupCount, &topology);
+    iree_task_topology_deinitialize(&topology);
+  }
+}
+
+TEST(TopologyTest, FromPhysicalCoresInFirstPackage) {
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_cpuinfo_options_t options;
+  iree_task_topology_cpuinfo_options_initialize(&options);
+  options.package_mask = 1ull << 0;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_topology_initialize_from_physical_cores_with_options(
+      &options, kMaxGroupCount, &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+  iree_task_topology_deinitialize(&topology);
+}
+
+TEST(TopologyTest, FromPhysicalCoresExcludingEfficiencyCores) {
+  static constexpr iree_host_size_t kMaxGroupCount = 64;
+  iree_task_topology_cpuinfo_options_t options;
+  iree_task_topology_cpuinfo_options_initialize(&options);
+  options.exclude_efficiency_cores = true;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_topology_initialize_from_physical_cores_with_options(
+      &options, kMaxGroupCount, &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+  for (iree_host_size_t i = 0; i < iree_task_topology_group_count(&topology);
+       ++i) {
+    EXPECT_EQ(0, iree_task_topology_get_group(&topology, i)->performance_class);
+  }
+  iree_task_topology_deinitialize(&topology);
+}
+
+TEST(TopologyTest, FromUniqueL2CacheGroups) {
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_topology_initialize_from_unique_l2_cache_groups(kMaxGroupCount,
+                                                            &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+  iree_task_topology_deinitialize(&topology);
+}
+
+TEST(TopologyTest, FromUniqueL2CacheGroupsWithOptions) {
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_cpuinfo_options_t options;
+  iree_task_topology_cpuinfo_options_initialize(&options);
+  options.base_core_index = 1;
+  options.distribution = IREE_TASK_TOPOLOGY_DISTRIBUTION_SPREAD;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_topology_initialize_from_unique_l2_cache_groups_with_options(
+      &options, kMaxGroupCount, &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+  iree_task_topology_deinitialize(&topology);
+}
+
+TEST(TopologyTest, QueryCacheSizes) {
+  // Sizes are machine-dependent (and 0 if unavailable) so only check that
+  // outer levels are not smaller than inner ones when present.
+  iree_task_cache_sizes_t sizes;
+  iree_task_topology_query_cache_sizes(&sizes);
+  if (sizes.l1_data && sizes.l2) EXPECT_GE(sizes.l2, sizes.l1_data);
+  if (sizes.l2 && sizes.l3) EXPECT_GE(sizes.l3, sizes.l2);
+}
+
 }  // namespace
@@ -112,6 +112,10 @@ TEST(TopologyTest, FromGroupCount) {
     const iree_task_topology_group_t* group =
         iree_task_topology_get_group(&topology, i);
     EXPECT_EQ(i, group->group_index);
+    // Without machine information all groups are assumed equally fast.
+    EXPECT_EQ(0, group->performance_class);
+    EXPECT_EQ(IREE_TASK_TOPOLOGY_PERFORMANCE_SCALE,
+              group->relative_performance);
   }
 
   iree_task_topology_deinitialize(&topology);
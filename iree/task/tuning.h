@@ -11,6 +11,9 @@
 extern "C" {
 #endif  // __cplusplus
 
+// NOTE: values marked as defaults below are only used when initializing
+// iree_task_executor_options_t and can be overridden per-executor at runtime.
+
 // Maximum number of workers that an executor can manage.
 // A 64 worker hard limit is based on us using uint64_t as a bitmask to select
 // workers. It's easy to go smaller (just use fewer bits) if it's known that
@@ -26,6 +29,12 @@ extern "C" {
 // Maximum number of events retained by the executor event pool.
 #define IREE_TASK_EXECUTOR_EVENT_POOL_CAPACITY 64
 
+// Capacity of the lock-free incoming submission queue of the executor.
+// Each slot holds one submission (a chain of ready tasks) and submissions that
+// arrive while the queue is full spill to a slower atomic slist. Must be a
+// power of two.
+#define IREE_TASK_EXECUTOR_INCOMING_QUEUE_CAPACITY 256
+
 // Maximum number of simultaneous waits an executor may perform as part of a
 // wait-any operation. A larger value may enable better wake coalescing by the
 // kernel. This is only a count limiting wait tasks that have been scheduled and
@@ -46,20 +55,52 @@ extern "C" {
 // sources.
 #define IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS (64 - 1)
 
-// Amount of time that can remain in a delay task while still retiring.
+// Maximum number of simultaneous waits an executor may perform when the wait
+// set implementation registers handles with the kernel (epoll). Waits then
+// cost O(signaled) instead of O(outstanding) and the limit is only there to
+// bound the wait set storage (~16B per handle).
+//
+// NOTE: as above we reserve 1 wait handle for our own internal use.
+#define IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS_SCALABLE (1024 - 1)
+
+// Default maximum amount of worker local memory a dispatch may require.
+// Workers grow their local memory on demand up to this size; dispatches that
+// require more will fail with IREE_STATUS_RESOURCE_EXHAUSTED.
+#define IREE_TASK_EXECUTOR_DEFAULT_WORKER_LOCAL_MEMORY_MAX_SIZE \
+  (16 * 1024 * 1024)
+
+// Granularity of worker local memory allocations. Spans are aligned to and
+// allocated in multiples of this size.
+#define IREE_TASK_WORKER_LOCAL_MEMORY_PAGE_SIZE 4096
+
+// Size of huge pages used to back large worker local memory spans. Spans of
+// at least this size are aligned to it and advised to be huge page backed on
+// platforms that support transparent huge pages.
+#define IREE_TASK_WORKER_LOCAL_MEMORY_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Default amount of time that can remain in a delay task while still retiring.
 // This prevents additional system sleeps when the remaining time before the
 // deadline is less than the granularity the system is likely able to sleep for.
 // Some platforms may have as much as 10-15ms of potential slop and sleeping for
 // 1ms may result in 10-15ms.
 #define IREE_TASK_EXECUTOR_DELAY_SLOP_NS (1 /*ms*/ * 1000000)
 
-// Allows for dividing the total number of attempts that a worker will make to
+// Default divisor for the total number of attempts that a worker will make to
 // steal tasks from other workers. By default all other workers will be
 // attempted while setting this to 2, for example, will try for only half of
 // the available workers.
 #define IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR (1)
 
-// Maximum number of tasks that will be stolen in one go from another worker.
+// Default maximum amount of time a donated caller thread will block on its
+// wait source before checking again for tasks it can steal from workers.
+// Donated threads are not notified when new work arrives (they aren't workers)
+// and instead poll at this interval. Lower values let the caller pick up work
+// sooner after it becomes available (such as after a barrier resolves) at the
+// cost of more frequent wakes while waiting on long-running work.
+#define IREE_TASK_EXECUTOR_DONATION_WAIT_SLICE_NS (250 /*us*/ * 1000)
+
+// Default maximum number of tasks that will be stolen in one go from another
+// worker.
 //
 // Too few tasks will cause additional overhead as the worker repeatedly sips
 // away tasks and when it does get tasks it may suffer spatial locality cache
@@ -79,9 +120,9 @@ extern "C" {
 #define IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT \
   IREE_TASK_EXECUTOR_MAX_WORKER_COUNT
 
-// Number of tiles that will be batched into a single reservation from the grid.
-// This is a maximum; if there are fewer tiles that would otherwise allow for
-// maximum parallelism then this may be ignored.
+// Default number of tiles that will be batched into a single reservation from
+// the grid. This is a maximum; if there are fewer tiles that would otherwise
+// allow for maximum parallelism then this may be ignored.
 //
 // The more tiles reserved at a time the higher the chance for latency to
 // increase as many reserved tiles are held up on one worker while another may
@@ -93,6 +134,28 @@ extern "C" {
 // memory).
 #define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (8)
 
+// Default maximum number of tiles a reservation may grow to when using
+// IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION.
+#define IREE_TASK_DISPATCH_MAX_ADAPTIVE_TILES_PER_SHARD_RESERVATION (256)
+
+// Default target duration of each reservation when using
+// IREE_TASK_SCHEDULING_MODE_ADAPTIVE_TILE_RESERVATION. Reservations that
+// complete faster than this double in size. This should be large enough to
+// amortize the reservation atomics and small enough that the tail of the
+// dispatch (when shards run out of tiles to reserve) stays short.
+#define IREE_TASK_DISPATCH_ADAPTIVE_RESERVATION_TARGET_NS (20 /*us*/ * 1000)
+
+// Minimum number of reservations each shard should be able to make when
+// adapting the reservation size. Caps the reservation size of small grids so
+// that shards can still balance work amongst themselves.
+#define IREE_TASK_DISPATCH_MIN_ADAPTIVE_RESERVATIONS_PER_SHARD (4)
+
+// Minimum estimated number of operations a dispatch shard should perform when
+// the dispatch provides a per-tile cost. Waking a worker and having it reserve
+// and retire a shard costs on the order of a few microseconds; shards doing
+// less work than that are better left to the workers already running.
+#define IREE_TASK_DISPATCH_MIN_SHARD_COST (64 * 1024)
+
 // Whether to enable per-tile colors for each tile tracing zone based on the
 // tile grid xyz. Not cheap and can be disabled to reduce tracing overhead.
 // TODO(#4017): make per-tile color tracing fast enough to always have on.
@@ -11,6 +11,7 @@
 
 #include "iree/base/internal/fpu_state.h"
 #include "iree/base/internal/math.h"
+#include "iree/base/profiler.h"
 #include "iree/base/tracing.h"
 #include "iree/task/executor_impl.h"
 #include "iree/task/post_batch.h"
@@ -18,12 +19,156 @@
 #include "iree/task/task_impl.h"
 #include "iree/task/tuning.h"
 
+#if defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID)
+#include <sys/mman.h>
+#endif  // IREE_PLATFORM_LINUX || IREE_PLATFORM_ANDROID
+
 static int iree_task_worker_main(iree_task_worker_t* worker);
 
+iree_status_t iree_task_worker_local_memory_reserve(
+    iree_task_worker_local_memory_t* local_memory,
+    iree_host_size_t minimum_size, iree_host_size_t maximum_size,
+    iree_allocator_t allocator) {
+  if (IREE_LIKELY(minimum_size <= local_memory->span.data_length)) {
+    return iree_ok_status();
+  } else if (IREE_UNLIKELY(minimum_size > maximum_size)) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "local memory of %zub requested but workers are "
+                            "limited to %zub",
+                            minimum_size, maximum_size);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)minimum_size);
+
+  // The contents are transient per-dispatch and don't need to be preserved so
+  // we drop the old allocation instead of reallocating (and copying) it.
+  iree_task_worker_local_memory_release(local_memory, allocator);
+
+  // Large spans are aligned to huge pages so that the kernel can back the
+  // whole span with them. The alignment padding is never touched and as large
+  // allocations are lazily committed by the system it costs only address
+  // space.
+  iree_host_size_t alignment = IREE_TASK_WORKER_LOCAL_MEMORY_PAGE_SIZE;
+  if (minimum_size >= IREE_TASK_WORKER_LOCAL_MEMORY_HUGE_PAGE_SIZE) {
+    alignment = IREE_TASK_WORKER_LOCAL_MEMORY_HUGE_PAGE_SIZE;
+  }
+  iree_host_size_t size = iree_host_align(minimum_size, alignment);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc_uninitialized(allocator, size + alignment,
+                                              &local_memory->allocation));
+  local_memory->span = iree_make_byte_span(
+      (void*)iree_host_align((uintptr_t)local_memory->allocation, alignment),
+      size);
+
+#if defined(MADV_HUGEPAGE)
+  // Best-effort: the memory works either way, just with more TLB misses.
+  if (alignment == IREE_TASK_WORKER_LOCAL_MEMORY_HUGE_PAGE_SIZE) {
+    madvise(local_memory->span.data, local_memory->span.data_length,
+            MADV_HUGEPAGE);
+  }
+#endif  // MADV_HUGEPAGE
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_task_worker_local_memory_release(
+    iree_task_worker_local_memory_t* local_memory, iree_allocator_t allocator) {
+  if (local_memory->allocation) {
+    iree_allocator_free(allocator, local_memory->allocation);
+  }
+  memset(local_memory, 0, sizeof(*local_memory));
+}
+
+// Returns the index of the worker within the executor; used as its member
+// index in the executor worker_wake_set.
+static inline iree_host_size_t iree_task_worker_index(
+    const iree_task_worker_t* worker) {
+  return iree_task_affinity_set_count_trailing_zeros(worker->worker_bit);
+}
+
+// Returns the tiles executed as reported to the profiler; 0 when statistics
+// are disabled and tiles are not counted.
+static uint64_t iree_task_worker_profiled_tile_count(
+    iree_task_dispatch_statistics_t* statistics) {
+#if IREE_STATISTICS_ENABLE
+  return (uint64_t)iree_atomic_load_int32(&statistics->tile_count,
+                                          iree_memory_order_relaxed);
+#else
+  return 0;
+#endif  // IREE_STATISTICS_ENABLE
+}
+
+#if IREE_STATISTICS_ENABLE
+
+void iree_task_worker_counters_record_shard(
+    iree_task_worker_counters_t* counters,
+    iree_task_dispatch_statistics_t* shard_statistics) {
+  iree_task_worker_counters_add(
+      counters, tile_count,
+      iree_atomic_load_int32(&shard_statistics->tile_count,
+                             iree_memory_order_relaxed));
+  iree_task_worker_counters_add(
+      counters, reservation_count,
+      iree_atomic_load_int32(&shard_statistics->reservation_count,
+                             iree_memory_order_relaxed));
+  iree_task_worker_counters_add(
+      counters, shard_count,
+      iree_atomic_load_int32(&shard_statistics->shard_count,
+                             iree_memory_order_relaxed));
+}
+
+void iree_task_worker_counters_accumulate(
+    iree_task_worker_counters_t* counters,
+    iree_task_worker_statistics_t* statistics) {
+#define IREE_TASK_WORKER_COUNTER_ACCUMULATE(counter) \
+  statistics->counter +=                              \
+      iree_atomic_load_int64(&counters->counter, iree_memory_order_relaxed)
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(task_count);
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(tile_count);
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(reservation_count);
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(shard_count);
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(steal_attempt_count);
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(steal_failure_count);
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(yield_count);
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(tile_steal_count);
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(wake_count);
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(wake_latency_ns);
+  IREE_TASK_WORKER_COUNTER_ACCUMULATE(idle_duration_ns);
+#undef IREE_TASK_WORKER_COUNTER_ACCUMULATE
+}
+
+// Resets the wake post time of the worker prior to checking for work. Any work
+// posted before now will be observed without waiting.
+static void iree_task_worker_reset_wake_post_time(iree_task_worker_t* worker) {
+  iree_atomic_store_int64(&worker->wake_post_time_ns, 0,
+                          iree_memory_order_relaxed);
+}
+
+// Records a wake of the worker from an idle wait that began at |wait_start_ns|.
+static void iree_task_worker_record_wake(iree_task_worker_t* worker,
+                                         iree_time_t wait_start_ns) {
+  iree_time_t now_ns = iree_time_now();
+  iree_task_worker_counters_add(&worker->counters, wake_count, 1);
+  iree_task_worker_counters_add(&worker->counters, idle_duration_ns,
+                                now_ns - wait_start_ns);
+  iree_time_t post_time_ns = iree_atomic_exchange_int64(
+      &worker->wake_post_time_ns, 0, iree_memory_order_relaxed);
+  if (post_time_ns != 0 && post_time_ns <= now_ns) {
+    iree_task_worker_counters_add(&worker->counters, wake_latency_ns,
+                                  now_ns - post_time_ns);
+  }
+}
+
+#else
+#define iree_task_worker_reset_wake_post_time(...)
+#define iree_task_worker_record_wake(...)
+#endif  // IREE_STATISTICS_ENABLE
+
 iree_status_t iree_task_worker_initialize(
     iree_task_executor_t* executor, iree_host_size_t worker_index,
     const iree_task_topology_group_t* topology_group,
-    iree_byte_span_t local_memory, iree_prng_splitmix64_state_t* seed_prng,
+    iree_host_size_t local_memory_size, iree_prng_splitmix64_state_t* seed_prng,
     iree_task_worker_t* out_worker) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -33,14 +178,15 @@ iree_status_t iree_task_worker_initialize(
   out_worker->constructive_sharing_mask =
       topology_group->constructive_sharing_mask;
   out_worker->max_theft_attempts =
-      executor->worker_count / IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR;
+      executor->worker_count /
+      executor->options.worker_max_theft_attempts_divisor;
   iree_prng_minilcg128_initialize(iree_prng_splitmix64_next(seed_prng),
                                   &out_worker->theft_prng);
-  out_worker->local_memory = local_memory;
 
   iree_task_worker_state_t initial_state = IREE_TASK_WORKER_STATE_RUNNING;
-  if (executor->scheduling_mode &
-      IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP) {
+  if (!executor->threadless &&
+      (executor->options.scheduling_mode &
+       IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP)) {
     // User is favoring startup latency vs. initial scheduling latency. Our
     // thread will be created suspended and not first scheduled until work
     // arrives for it, (almost) ensuring no context switches and 10x+ lower
@@ -50,10 +196,27 @@ iree_status_t iree_task_worker_initialize(
   iree_atomic_store_int32(&out_worker->state, initial_state,
                           iree_memory_order_seq_cst);
 
-  iree_notification_initialize(&out_worker->wake_notification);
   iree_notification_initialize(&out_worker->state_notification);
   iree_atomic_task_slist_initialize(&out_worker->mailbox_slist);
   iree_task_queue_initialize(&out_worker->local_task_queue);
+  iree_task_dispatch_reservation_initialize(
+      topology_group->relative_performance, &out_worker->tile_reservation);
+
+  // Allocate the local memory uninitialized; the worker thread touches it
+  // first once pinned so that the pages are placed local to it. Threadless
+  // workers need it as well as the donated callers pumping them use it.
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_task_worker_local_memory_reserve(
+              &out_worker->local_memory, local_memory_size,
+              executor->options.worker_local_memory_max_size,
+              executor->allocator));
+
+  // Threadless workers are pumped by donated caller threads and never get a
+  // thread of their own.
+  if (executor->threadless) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
 
   iree_thread_create_params_t thread_params;
   memset(&thread_params, 0, sizeof(thread_params));
@@ -100,7 +263,8 @@ void iree_task_worker_request_exit(iree_task_worker_t* worker) {
   }
 
   // Kick the worker in case it is waiting for work.
-  iree_notification_post(&worker->wake_notification, 1);
+  iree_notification_set_post(&worker->executor->worker_wake_set,
+                             worker->worker_bit);
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -131,39 +295,82 @@ void iree_task_worker_deinitialize(iree_task_worker_t* worker) {
   // get anything more posted to it) and then discarding everything we still
   // have a reference to.
   iree_atomic_task_slist_discard(&worker->mailbox_slist);
-  iree_task_list_discard(&worker->local_task_queue.list);
 
-  iree_notification_deinitialize(&worker->wake_notification);
   iree_notification_deinitialize(&worker->state_notification);
   iree_atomic_task_slist_deinitialize(&worker->mailbox_slist);
   iree_task_queue_deinitialize(&worker->local_task_queue);
 
+  // NOTE: workers that failed to initialize may not have an executor set.
+  if (worker->local_memory.allocation) {
+    iree_task_worker_local_memory_release(&worker->local_memory,
+                                          worker->executor->allocator);
+  }
+
   IREE_TRACE_ZONE_END(z0);
 }
 
 void iree_task_worker_post_tasks(iree_task_worker_t* worker,
                                  iree_task_list_t* list) {
+  // Gather the priorities of the posted tasks before we lose ownership of them.
+  int32_t priority_mask = 0;
+  for (iree_task_t* task = list->head; task; task = task->next_task) {
+    priority_mask |= 1 << task->priority;
+  }
+
   // Move the list into the mailbox. Note that the mailbox is LIFO and this list
   // is concatenated with its current order preserved (which should be LIFO).
   iree_atomic_task_slist_concat(&worker->mailbox_slist, list->head, list->tail);
   memset(list, 0, sizeof(*list));
+
+  // Publish the priorities after the tasks are in the mailbox so that anyone
+  // observing the mask and flushing will find them.
+  iree_atomic_fetch_or_int32(&worker->mailbox_priority_mask, priority_mask,
+                             iree_memory_order_release);
 }
 
-iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
-                                             iree_task_queue_t* target_queue,
-                                             iree_host_size_t max_tasks) {
+// Moves all tasks posted to the worker mailbox into its local task queue.
+static void iree_task_worker_flush_mailbox(iree_task_worker_t* worker) {
+  iree_atomic_store_int32(&worker->mailbox_priority_mask, 0,
+                          iree_memory_order_relaxed);
+  iree_task_queue_append_from_lifo_slist(&worker->local_task_queue,
+                                         &worker->mailbox_slist);
+}
+
+// iree_task_yield_check_fn_t for shards executing on |user_data| worker.
+// Yields when tasks of a priority higher than |priority| have been posted.
+static bool iree_task_worker_should_yield(void* user_data,
+                                          iree_task_priority_t priority) {
+  iree_task_worker_t* worker = (iree_task_worker_t*)user_data;
+  const int32_t higher_priority_mask = ~((1 << (priority + 1)) - 1);
+  if (!(iree_atomic_load_int32(&worker->mailbox_priority_mask,
+                               iree_memory_order_acquire) &
+        higher_priority_mask)) {
+    return false;
+  }
+  iree_task_worker_flush_mailbox(worker);
+  return iree_task_queue_has_priority_above(&worker->local_task_queue,
+                                            priority);
+}
+
+iree_task_t* iree_task_worker_try_steal_task(
+    iree_task_worker_t* worker, iree_task_queue_t* target_queue,
+    iree_task_affinity_set_t thief_affinity_set, iree_host_size_t max_tasks) {
   // Try to grab tasks from the worker; if more than one task is stolen then the
   // first will be returned and the remaining will be added to the target queue.
   iree_task_t* task = iree_task_queue_try_steal(
-      &worker->local_task_queue, target_queue,
-      /*max_tasks=*/IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT);
+      &worker->local_task_queue, target_queue, thief_affinity_set,
+      /*max_tasks=*/max_tasks);
   if (task) return task;
 
   // If we still didn't steal any tasks then let's try the slist instead.
   task = iree_atomic_task_slist_pop(&worker->mailbox_slist);
-  if (task) return task;
-
-  return NULL;
+  if (task && !(task->affinity_set & thief_affinity_set)) {
+    // Confined to workers other than the thief; hand it back to the victim.
+    // The mailbox is unordered with respect to the victim's queue anyway.
+    iree_atomic_task_slist_push(&worker->mailbox_slist, task);
+    task = NULL;
+  }
+  return task;
 }
 
 // Executes a task on a worker.
@@ -179,27 +386,119 @@ static void iree_task_worker_execute(
   // TODO(benvanik): think a bit more about this timing; this ensures we have
   // BFS behavior at the cost of the additional merge overhead - it's probably
   // worth it?
-  // TODO(benvanik): handle partial tasks and re-queuing.
   switch (task->type) {
     case IREE_TASK_TYPE_CALL: {
       iree_task_call_execute((iree_task_call_t*)task, pending_submission);
       break;
     }
     case IREE_TASK_TYPE_DISPATCH_SHARD: {
-      iree_task_dispatch_shard_execute((iree_task_dispatch_shard_t*)task,
-                                       worker->local_memory,
-                                       pending_submission);
+      // Grow our local memory if the dispatch requires more. This happens on
+      // the worker thread so the new pages are first touched (and placed) by
+      // us. Failures are reported to the dispatch by the shard when it finds
+      // too little memory.
+      iree_task_executor_t* executor = worker->executor;
+      iree_task_dispatch_t* dispatch_task =
+          (iree_task_dispatch_t*)task->completion_task;
+      iree_status_ignore(iree_task_worker_local_memory_reserve(
+          &worker->local_memory, dispatch_task->local_memory_size,
+          executor->options.worker_local_memory_max_size,
+          executor->allocator));
+      iree_task_dispatch_statistics_t shard_statistics;
+      const iree_task_yield_check_t yield_check = {
+          iree_task_worker_should_yield,
+          worker,
+      };
+      iree_profiler_record(IREE_PROFILER_EVENT_TYPE_TILES_BEGIN,
+                           iree_task_worker_index(worker),
+                           iree_string_view_empty(), 0);
+      bool did_retire = iree_task_dispatch_shard_execute(
+          (iree_task_dispatch_shard_t*)task, worker->local_memory.span,
+          &yield_check, &worker->tile_reservation, &shard_statistics,
+          pending_submission);
+      iree_profiler_record(
+          IREE_PROFILER_EVENT_TYPE_TILES_END, iree_task_worker_index(worker),
+          iree_string_view_empty(),
+          iree_task_worker_profiled_tile_count(&shard_statistics));
+      iree_task_worker_counters_record_shard(&worker->counters,
+                                             &shard_statistics);
+      if (!did_retire) {
+        // The shard yielded to higher priority work now in our queue; it'll be
+        // resumed after that work (or stolen by an idle worker).
+        iree_task_queue_push_front(&worker->local_task_queue, task);
+        iree_task_worker_counters_add(&worker->counters, yield_count, 1);
+      }
       break;
     }
     default:
       IREE_ASSERT_UNREACHABLE("incorrect task type for worker execution");
       break;
   }
+  iree_task_worker_counters_add(&worker->counters, task_count, 1);
 
   // NOTE: task is invalidated above and must not be used!
   task = NULL;
 }
 
+// Tries to steal the tail of a tile range from a worker that is executing a
+// dispatch shard and execute it. Returns true if any tiles were executed.
+static bool iree_task_worker_try_steal_tiles(
+    iree_task_worker_t* worker, iree_task_submission_t* pending_submission) {
+  iree_task_executor_t* executor = worker->executor;
+  iree_task_affinity_set_t victim_mask =
+      iree_atomic_task_affinity_set_load(&executor->worker_live_mask,
+                                         iree_memory_order_relaxed) &
+      ~iree_atomic_task_affinity_set_load(&executor->worker_idle_mask,
+                                          iree_memory_order_relaxed) &
+      ~worker->worker_bit;
+  if (!victim_mask) return false;
+
+  // Whether any tiles will be stolen is only known after the fact so the
+  // profiler slice (if any) starts from here.
+  const iree_time_t steal_begin_ns =
+      iree_profiler_is_enabled(IREE_PROFILER_EVENT_MASK_TILES) ? iree_time_now()
+                                                               : 0;
+
+  // Start the scan at a random victim so that thieves spread out.
+  const int bit_count = 8 * sizeof(iree_task_affinity_set_t);
+  int rotation_offset =
+      iree_prng_minilcg128_next_uint8(&worker->theft_prng) & (bit_count - 1);
+  victim_mask = iree_task_affinity_set_rotr(victim_mask, rotation_offset);
+  int victim_offset = 0;
+  for (uint32_t i = 0; victim_mask && i < worker->max_theft_attempts; ++i) {
+    int offset = iree_task_affinity_set_count_trailing_zeros(victim_mask);
+    victim_offset += offset;
+    victim_mask = iree_shr(victim_mask, offset + 1);
+    iree_task_worker_t* victim_worker =
+        &executor->workers[(rotation_offset + victim_offset++) &
+                           (bit_count - 1)];
+    // Leave the tiles of faster workers to them; on hybrid systems a slower
+    // worker taking them would only make the dispatch take longer.
+    if (victim_worker->tile_reservation.relative_performance >
+        worker->tile_reservation.relative_performance) {
+      continue;
+    }
+    iree_task_dispatch_statistics_t statistics;
+    if (iree_task_dispatch_reservation_try_steal(
+            &victim_worker->tile_reservation, worker->worker_bit,
+            &worker->tile_reservation, worker->local_memory.span, &statistics,
+            pending_submission)) {
+      if (steal_begin_ns) {
+        iree_profiler_record_at(IREE_PROFILER_EVENT_TYPE_TILES_BEGIN,
+                                steal_begin_ns, iree_task_worker_index(worker),
+                                IREE_SV("stolen tiles"), 0);
+        iree_profiler_record(
+            IREE_PROFILER_EVENT_TYPE_TILES_END, iree_task_worker_index(worker),
+            IREE_SV("stolen tiles"),
+            iree_task_worker_profiled_tile_count(&statistics));
+      }
+      iree_task_worker_counters_record_shard(&worker->counters, &statistics);
+      iree_task_worker_counters_add(&worker->counters, tile_steal_count, 1);
+      return true;
+    }
+  }
+  return false;
+}
+
 // Pumps the worker thread once, processing a single task.
 // Returns true if pumping should continue as there are more tasks remaining or
 // false if the caller should wait for more tasks to be posted.
@@ -207,6 +506,13 @@ static bool iree_task_worker_pump_once(
     iree_task_worker_t* worker, iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Move any newly posted tasks into the local work queue so that higher
+  // priority tasks among them are picked ahead of those already queued.
+  if (iree_atomic_load_int32(&worker->mailbox_priority_mask,
+                             iree_memory_order_acquire)) {
+    iree_task_worker_flush_mailbox(worker);
+  }
+
   // Check the local work queue for any work we know we should start
   // processing immediately. Other workers may try to steal some of this work
   // if we take too long.
@@ -232,15 +538,22 @@ static bool iree_task_worker_pump_once(
   // the first task in the queue is popped off and returned.
   if (!task) {
     task = iree_task_executor_try_steal_task(
-        worker->executor, worker->constructive_sharing_mask,
+        worker->executor, worker->worker_bit, worker->constructive_sharing_mask,
         worker->max_theft_attempts, &worker->theft_prng,
         &worker->local_task_queue);
+    iree_task_worker_counters_add(&worker->counters, steal_attempt_count, 1);
+    if (!task) {
+      iree_task_worker_counters_add(&worker->counters, steal_failure_count, 1);
+    }
   }
 
-  // No tasks to run; let the caller know we want to wait for more.
+  // No tasks to run; before waiting for more help out any worker still
+  // executing a large tile range of a dispatch.
   if (!task) {
+    bool did_steal_tiles =
+        iree_task_worker_try_steal_tiles(worker, pending_submission);
     IREE_TRACE_ZONE_END(z0);
-    return false;
+    return did_steal_tiles;
   }
 
   // Execute the task (may call out to arbitrary user code and may submit more
@@ -262,8 +575,9 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
     // checked a particular source we use an interruptable wait token that
     // will prevent the wait from happening if anyone touches the data
     // structures we use.
-    iree_wait_token_t wait_token =
-        iree_notification_prepare_wait(&worker->wake_notification);
+    iree_wait_token_t wait_token = iree_notification_set_prepare_wait(
+        &worker->executor->worker_wake_set, iree_task_worker_index(worker));
+    iree_task_worker_reset_wake_post_time(worker);
     iree_atomic_task_affinity_set_fetch_and(&worker->executor->worker_idle_mask,
                                             ~worker->worker_bit,
                                             iree_memory_order_seq_cst);
@@ -272,7 +586,8 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
     if (iree_atomic_load_int32(&worker->state, iree_memory_order_seq_cst) ==
         IREE_TASK_WORKER_STATE_EXITING) {
       // Thread exit requested - cancel pumping.
-      iree_notification_cancel_wait(&worker->wake_notification);
+      iree_notification_set_cancel_wait(&worker->executor->worker_wake_set,
+                                        iree_task_worker_index(worker));
       // TODO(benvanik): complete tasks before exiting?
       break;
     }
@@ -314,12 +629,16 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
     if (schedule_dirty ||
         !iree_task_queue_is_empty(&worker->local_task_queue)) {
       // Have more work to do; loop around to try another pump.
-      iree_notification_cancel_wait(&worker->wake_notification);
+      iree_notification_set_cancel_wait(&worker->executor->worker_wake_set,
+                                        iree_task_worker_index(worker));
     } else {
       IREE_TRACE_ZONE_BEGIN_NAMED(z_wait,
                                   "iree_task_worker_main_pump_wake_wait");
-      iree_notification_commit_wait(&worker->wake_notification, wait_token,
-                                    IREE_TIME_INFINITE_FUTURE);
+      IREE_STATISTICS(iree_time_t wait_start_ns = iree_time_now());
+      iree_notification_set_commit_wait(&worker->executor->worker_wake_set,
+                                        iree_task_worker_index(worker),
+                                        wait_token, IREE_TIME_INFINITE_FUTURE);
+      iree_task_worker_record_wake(worker, wait_start_ns);
       IREE_TRACE_ZONE_END(z_wait);
     }
 
@@ -329,6 +648,92 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
   }
 }
 
+iree_status_t iree_task_worker_pump_until_resolved(
+    iree_task_worker_t* worker, iree_wait_source_t wait_source,
+    iree_timeout_t timeout) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+
+  // The donating thread may have any FPU state; match what worker threads use
+  // for the duration of the donation and restore it before returning.
+  iree_fpu_state_t fpu_state =
+      iree_fpu_state_push(IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
+
+  iree_status_t status = iree_ok_status();
+  while (true) {
+    // Check the wait source first so that we return immediately if it was
+    // resolved by the tasks we processed (or before we were even called).
+    iree_status_code_t wait_status_code = IREE_STATUS_OK;
+    status = iree_wait_source_query(wait_source, &wait_status_code);
+    if (!iree_status_is_ok(status)) break;
+    if (wait_status_code != IREE_STATUS_DEFERRED) {
+      status = iree_status_from_code(wait_status_code);
+      break;
+    }
+
+    // As with pump_until_exit we prepare the wait before checking the data
+    // structures so that any tasks posted to us from another thread after we
+    // check will interrupt the wait below.
+    iree_wait_token_t wait_token = iree_notification_set_prepare_wait(
+        &worker->executor->worker_wake_set, iree_task_worker_index(worker));
+    iree_task_worker_reset_wake_post_time(worker);
+    iree_atomic_task_affinity_set_fetch_and(&worker->executor->worker_idle_mask,
+                                            ~worker->worker_bit,
+                                            iree_memory_order_seq_cst);
+
+    // Move any incoming submissions into our local queue. We are the only
+    // worker so everything coordinated will be posted to us.
+    iree_task_executor_coordinate(worker->executor, worker);
+
+    iree_task_submission_t pending_submission;
+    iree_task_submission_initialize(&pending_submission);
+    bool did_work = false;
+    while (iree_task_worker_pump_once(worker, &pending_submission)) {
+      did_work = true;
+    }
+    if (!iree_task_submission_is_empty(&pending_submission)) {
+      iree_task_executor_merge_submission(worker->executor,
+                                          &pending_submission);
+      did_work = true;
+    }
+
+    iree_atomic_task_affinity_set_fetch_or(&worker->executor->worker_idle_mask,
+                                           worker->worker_bit,
+                                           iree_memory_order_seq_cst);
+
+    if (did_work || !iree_task_queue_is_empty(&worker->local_task_queue)) {
+      // Have more work to do (or need to recheck the wait source).
+      iree_notification_set_cancel_wait(&worker->executor->worker_wake_set,
+                                        iree_task_worker_index(worker));
+      continue;
+    }
+
+    iree_time_t now_ns = iree_time_now();
+    if (now_ns >= deadline_ns) {
+      iree_notification_set_cancel_wait(&worker->executor->worker_wake_set,
+                                        iree_task_worker_index(worker));
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      break;
+    }
+
+    // Nothing to do until either the poller or another thread posts work to us
+    // or the wait source resolves externally. We can't wait on both at once so
+    // we bound the wait and recheck the wait source periodically.
+    IREE_TRACE_ZONE_BEGIN_NAMED(z_wait, "iree_task_worker_donate_wake_wait");
+    iree_notification_set_commit_wait(
+        &worker->executor->worker_wake_set, iree_task_worker_index(worker),
+        wait_token,
+        iree_min(deadline_ns,
+                 now_ns + worker->executor->options.delay_slop_ns));
+    iree_task_worker_record_wake(worker, now_ns);
+    IREE_TRACE_ZONE_END(z_wait);
+  }
+
+  iree_fpu_state_pop(fpu_state);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 // Thread entry point for each worker.
 static int iree_task_worker_main(iree_task_worker_t* worker) {
   IREE_TRACE_ZONE_BEGIN(thread_zone);
@@ -341,6 +746,16 @@ static int iree_task_worker_main(iree_task_worker_t* worker) {
   // TODO(benvanik): call this after waking in case CPU hotplugging happens.
   iree_thread_request_affinity(worker->thread, worker->ideal_thread_affinity);
 
+  // Fault in the local memory from the pinned thread so that first-touch page
+  // placement puts it on our NUMA node instead of the node of the thread that
+  // created the executor.
+  if (worker->local_memory.span.data_length > 0) {
+    IREE_TRACE_ZONE_BEGIN_NAMED(z_touch, "iree_task_worker_touch_local_memory");
+    memset(worker->local_memory.span.data, 0,
+           worker->local_memory.span.data_length);
+    IREE_TRACE_ZONE_END(z_touch);
+  }
+
   // Enter the running state immediately. Note that we could have been requested
   // to exit while suspended/still starting up, so check that here before we
   // mess with any data structures.
@@ -20,6 +20,7 @@
 #include "iree/task/list.h"
 #include "iree/task/queue.h"
 #include "iree/task/task.h"
+#include "iree/task/task_impl.h"
 #include "iree/task/topology.h"
 #include "iree/task/tuning.h"
 
@@ -27,6 +28,34 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Scratch memory exclusively owned by a worker (or a donated caller thread)
+// and made available to the dispatch tiles it executes.
+//
+// The memory is right-sized on demand: it starts at the executor-configured
+// worker_local_memory_size and grows to the largest requirement of any
+// dispatch executed up to worker_local_memory_max_size. Spans are page aligned
+// and those of at least IREE_TASK_WORKER_LOCAL_MEMORY_HUGE_PAGE_SIZE are
+// aligned to and (where supported) backed by huge pages to reduce TLB misses.
+typedef struct iree_task_worker_local_memory_t {
+  // Memory available for use; contents are undefined.
+  iree_byte_span_t span;
+  // Base of the allocation containing |span|, if any.
+  void* allocation;
+} iree_task_worker_local_memory_t;
+
+// Ensures that |local_memory| has at least |minimum_size| bytes available.
+// Existing contents are not preserved when the memory is grown.
+// Fails with IREE_STATUS_RESOURCE_EXHAUSTED if |minimum_size| exceeds
+// |maximum_size|.
+iree_status_t iree_task_worker_local_memory_reserve(
+    iree_task_worker_local_memory_t* local_memory,
+    iree_host_size_t minimum_size, iree_host_size_t maximum_size,
+    iree_allocator_t allocator);
+
+// Releases the memory held by |local_memory| back to |allocator|.
+void iree_task_worker_local_memory_release(
+    iree_task_worker_local_memory_t* local_memory, iree_allocator_t allocator);
+
 // Indicates the current state of a worker or, in the case of EXITING, the state
 // the worker should transition to.
 //
@@ -50,6 +79,50 @@ typedef enum iree_task_worker_state_e {
   IREE_TASK_WORKER_STATE_ZOMBIE = 3,
 } iree_task_worker_state_t;
 
+// Statistics counters updated as tasks are executed on a worker or donated
+// thread. Counters are accumulated with relaxed atomics so that they may be
+// captured from any thread while the worker is running.
+typedef struct iree_task_worker_counters_t {
+#if IREE_STATISTICS_ENABLE
+  iree_atomic_int64_t task_count;
+  iree_atomic_int64_t tile_count;
+  iree_atomic_int64_t reservation_count;
+  iree_atomic_int64_t shard_count;
+  iree_atomic_int64_t steal_attempt_count;
+  iree_atomic_int64_t steal_failure_count;
+  iree_atomic_int64_t yield_count;
+  iree_atomic_int64_t tile_steal_count;
+  iree_atomic_int64_t wake_count;
+  iree_atomic_int64_t wake_latency_ns;
+  iree_atomic_int64_t idle_duration_ns;
+#else
+  int reserved;
+#endif  // IREE_STATISTICS_ENABLE
+} iree_task_worker_counters_t;
+
+#if IREE_STATISTICS_ENABLE
+
+// Adds |delta| to the |counter| in |counters|.
+#define iree_task_worker_counters_add(counters, counter, delta)      \
+  iree_atomic_fetch_add_int64(&(counters)->counter, (int64_t)(delta), \
+                              iree_memory_order_relaxed)
+
+// Records the execution of a dispatch shard in |counters|.
+void iree_task_worker_counters_record_shard(
+    iree_task_worker_counters_t* counters,
+    iree_task_dispatch_statistics_t* shard_statistics);
+
+// Accumulates the current values of |counters| into |statistics|.
+void iree_task_worker_counters_accumulate(
+    iree_task_worker_counters_t* counters,
+    iree_task_worker_statistics_t* statistics);
+
+#else
+#define iree_task_worker_counters_add(...)
+#define iree_task_worker_counters_record_shard(...)
+#define iree_task_worker_counters_accumulate(...)
+#endif  // IREE_STATISTICS_ENABLE
+
 // A worker within the executor pool.
 //
 // NOTE: fields in here are touched from multiple threads with lock-free
@@ -67,15 +140,18 @@ typedef struct iree_task_worker_t {
   iree_atomic_task_slist_t mailbox_slist;
 
   // Current state of the worker (iree_task_worker_state_t).
-  // LAYOUT: frequent access; next to wake_notification as they are always
-  //         accessed together.
+  // LAYOUT: frequent access; next to mailbox_slist as when posting other
+  //         threads will touch mailbox_slist and then check the state.
+  //
+  // NOTE: workers wait for new work on the executor worker_wake_set using
+  // their worker index so that coordinators can wake many workers at once.
   iree_atomic_int32_t state;
 
-  // Notification signaled when the worker should wake (if it is idle).
-  // LAYOUT: next to state for similar access patterns; when posting other
-  //         threads will touch mailbox_slist and then send a wake
-  //         notification.
-  iree_notification_t wake_notification;
+  // Bitmask of the priorities (1 << iree_task_priority_t) of tasks posted to
+  // mailbox_slist since the worker last flushed it. Lets dispatch shards
+  // cheaply check whether they should yield to higher priority work.
+  // LAYOUT: next to mailbox_slist as posters touch both.
+  iree_atomic_int32_t mailbox_priority_mask;
 
   // Notification signaled when the worker changes any state.
   iree_notification_t state_notification;
@@ -122,16 +198,34 @@ typedef struct iree_task_worker_t {
   // interference) this is the only place padding should be added.
   // uint8_t _padding[8];
 
-  // Pointer to local memory available for use exclusively by the worker.
-  // The base address should be aligned to avoid false sharing with other
-  // workers.
-  iree_byte_span_t local_memory;
+  // Local memory available for use exclusively by the worker.
+  // The memory is allocated per-worker and first touched by the worker thread
+  // after its affinity has been set such that on NUMA systems using first-touch
+  // page placement (the Linux default) it is local to the node the worker is
+  // pinned to. Grown on the worker thread when a dispatch requires more.
+  iree_task_worker_local_memory_t local_memory;
 
   // Worker-local FIFO queue containing the tasks that will be processed by the
   // worker. This queue supports work-stealing by other workers if they run out
   // of work of their own.
   // LAYOUT: must be 64b away from mailbox_slist.
   iree_task_queue_t local_task_queue;
+
+#if IREE_STATISTICS_ENABLE
+  // Time at which work was first posted to the worker since it last prepared
+  // to wait or 0 if nothing has been posted. Used to measure wake latency.
+  iree_atomic_int64_t wake_post_time_ns;
+#endif  // IREE_STATISTICS_ENABLE
+
+  // Tile range of the dispatch shard the worker is executing, if any, that
+  // idle workers may steal the tail of.
+  // LAYOUT: after local_task_queue as it is touched by thieves once they have
+  //         failed to steal any tasks.
+  iree_task_dispatch_reservation_t tile_reservation;
+
+  // Statistics counters updated by the worker as it executes tasks.
+  // LAYOUT: after local_task_queue as only the worker writes these.
+  iree_task_worker_counters_t counters;
 } iree_task_worker_t;
 static_assert(offsetof(iree_task_worker_t, mailbox_slist) +
                       sizeof(iree_atomic_task_slist_t) <
@@ -146,10 +240,15 @@ static_assert(offsetof(iree_task_worker_t, local_task_queue) >=
 // tasks. Where supported the worker will be created in a suspended state so
 // that we aren't creating a thundering herd on startup:
 // https://en.wikipedia.org/wiki/Thundering_herd_problem
+//
+// |local_memory_size| bytes of worker-local memory will be allocated for use
+// by the tiles the worker executes. Threadless workers allocate it as well and
+// the donated caller threads pumping them execute tiles with it; it is touched
+// first by whichever thread executes the first tile.
 iree_status_t iree_task_worker_initialize(
     iree_task_executor_t* executor, iree_host_size_t worker_index,
     const iree_task_topology_group_t* topology_group,
-    iree_byte_span_t local_memory, iree_prng_splitmix64_state_t* seed_prng,
+    iree_host_size_t local_memory_size, iree_prng_splitmix64_state_t* seed_prng,
     iree_task_worker_t* out_worker);
 
 // Deinitializes a worker that has successfully exited. The worker must be in
@@ -174,10 +273,21 @@ void iree_task_worker_post_tasks(iree_task_worker_t* worker,
 // Returns NULL if no tasks are available and otherwise up to |max_tasks| tasks
 // that were at the tail of the worker FIFO will be moved to the |target_queue|
 // and the first of the stolen tasks is returned. While tasks from the FIFO
-// are preferred this may also steal tasks from the mailbox.
-iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
-                                             iree_task_queue_t* target_queue,
-                                             iree_host_size_t max_tasks);
+// are preferred this may also steal tasks from the mailbox. Only tasks with
+// affinity for a worker in |thief_affinity_set| will be stolen.
+iree_task_t* iree_task_worker_try_steal_task(
+    iree_task_worker_t* worker, iree_task_queue_t* target_queue,
+    iree_task_affinity_set_t thief_affinity_set, iree_host_size_t max_tasks);
+
+// Pumps the |worker| on the calling thread until |wait_source| resolves or
+// |timeout| elapses. Only valid for workers of threadless executors as they
+// have no thread of their own to process their queues.
+//
+// May be called from any non-worker thread but only one thread may pump the
+// worker at a time as it uses the worker local memory and wake set member.
+iree_status_t iree_task_worker_pump_until_resolved(
+    iree_task_worker_t* worker, iree_wait_source_t wait_source,
+    iree_timeout_t timeout);
 
 #ifdef __cplusplus
 }  // extern "C"
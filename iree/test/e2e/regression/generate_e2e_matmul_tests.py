@@ -32,6 +32,9 @@ class MatrixElemTypeId(enum.Enum):
 class ShapesId(enum.Enum):
   SMALL = "small"
   LARGE = "large"
+  # Sweep of sizes meant to be run with iree-e2e-matmul-test
+  # --benchmark_repetitions to compare performance across backends.
+  BENCHMARK = "benchmark"
 
 
 # Enumerates ways to construct MLIR tensor types.
@@ -144,6 +147,14 @@ def get_test_shapes(shapes_id: ShapesId):
         # running on fewer backends/drivers or with fewer generators
         # (see get_test_generators).
     ]
+  if shapes_id == ShapesId.BENCHMARK:
+    # Square powers of two, then rectangular shapes typical of inference:
+    # skinny LHS (small batch) and skinny RHS (matrix-vector like).
+    return [TestShape(m=x, k=x, n=x) for x in [64, 128, 256, 512, 1024]] + [
+        TestShape(m=m, k=k, n=n)
+        for (m, k, n) in [(1, 1024, 1024), (16, 1024, 1024), (1024, 1024, 1),
+                          (1024, 1024, 16), (384, 768, 3072)]
+    ]
   raise ValueError(shapes_id)
 
 
@@ -200,6 +211,15 @@ def get_test_generators(shapes_id: ShapesId):
                       acc=MatrixGenerator.RANDOM,
                       dynamicity=Dynamicity.STATIC),
     ]
+  if shapes_id == ShapesId.BENCHMARK:
+    # Only static shapes: dynamic shapes benchmark the dynamic shape support
+    # rather than the matmul codegen.
+    return [
+        TestGenerator(lhs=MatrixGenerator.RANDOM,
+                      rhs=MatrixGenerator.RANDOM,
+                      acc=MatrixGenerator.RANDOM,
+                      dynamicity=Dynamicity.STATIC),
+    ]
   raise ValueError(shapes_id)
 
 
@@ -4,11 +4,16 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -17,6 +22,8 @@
 #include "iree/base/api.h"
 #include "iree/base/internal/file_io.h"
 #include "iree/base/internal/flags.h"
+#include "iree/base/internal/profiler_sink.h"
+#include "iree/base/profiler.h"
 #include "iree/base/status_cc.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
@@ -31,12 +38,12 @@ IREE_FLAG(string, module_file, "-",
           "File containing the module to load that contains the entry "
           "function. Defaults to stdin.");
 
-// TODO(hanchung): Extract the batch size using
-// iree_vm_function_reflection_attr.
 IREE_FLAG(
-    int32_t, batch_size, 1,
+    int32_t, batch_size, 0,
     "The number of batch size, which is expected to match "
-    "iree-hal-benchmark-dispatch-repeat-count when translating the module");
+    "iree-hal-benchmark-dispatch-repeat-count when translating the module. "
+    "When 0 the batch size is read from the `batch_size` reflection attribute "
+    "of each function and defaults to 1 if not present.");
 
 IREE_FLAG(string, entry_function, "",
           "Name of a function contained in the module specified by module_file "
@@ -45,9 +52,45 @@ IREE_FLAG(string, entry_function, "",
 
 IREE_FLAG(string, driver, "vmvx", "Backend driver to use.");
 
+IREE_FLAG(string, trace_output, "",
+          "Records VM invocations, HAL submissions and waits, dispatches, "
+          "task executor tile ranges, and buffer allocations to the given "
+          "file. Paths ending in `.json` produce a Chrome trace viewable in "
+          "chrome://tracing or ui.perfetto.dev; others produce CSV.");
+
+IREE_FLAG(int32_t, warmup_iterations, 0,
+          "Number of untimed calls made to each function before it is "
+          "benchmarked to populate caches and finish any lazy initialization "
+          "(such as executable loading) that would otherwise skew the first "
+          "repetition.");
+
+IREE_FLAG(int32_t, load_threads, 0,
+          "When > 0 generates load instead of running benchmarks: the function "
+          "specified by --entry_function is called concurrently from this many "
+          "client threads, each with its own context sharing the device, and "
+          "latency percentiles and the achieved throughput are reported.");
+
+IREE_FLAG(double, load_qps, 0.0,
+          "Target aggregate request rate when generating load. Requests are "
+          "issued open-loop on a fixed schedule independent of when prior "
+          "requests complete and latency is measured from the scheduled time "
+          "so that any queuing delay is included. When 0 each client thread "
+          "issues requests back-to-back (closed-loop).");
+
+IREE_FLAG(int32_t, load_duration_ms, 10000,
+          "Duration in milliseconds over which load is generated.");
+
 IREE_FLAG(bool, print_statistics, false,
           "Prints runtime statistics to stderr on exit.");
 
+IREE_FLAG(bool, warmup, false,
+          "Prepares executables, devices and allocators before invoking the "
+          "function so that it runs without first-call initialization costs.");
+
+IREE_FLAG(bool, print_vm_profile, false,
+          "Profiles VM execution and prints per-function instruction counts "
+          "and self times to stderr on exit.");
+
 static iree_status_t parse_function_input(iree_string_view_t flag_name,
                                           void* storage,
                                           iree_string_view_t value) {
@@ -82,15 +125,55 @@ IREE_FLAG_CALLBACK(
 namespace iree {
 namespace {
 
-static void BenchmarkFunction(const std::string& benchmark_name, int batch_size,
+// Per-invocation work reported by the compiler in the reflection metadata of
+// exported benchmark functions. Zero values are not reported.
+struct BenchmarkWork {
+  int batch_size = 1;
+  uint64_t bytes = 0;
+  double flops = 0.0;
+};
+
+// Returns the work performed by |function| based on its reflection attributes
+// and the --batch_size flag.
+static BenchmarkWork QueryBenchmarkWork(iree_vm_function_t function) {
+  BenchmarkWork work;
+  int32_t batch_size = FLAG_batch_size;
+  if (batch_size <= 0) {
+    if (!iree_string_view_atoi_int32(
+            iree_vm_function_reflection_attr(&function, IREE_SV("batch_size")),
+            &batch_size) ||
+        batch_size <= 0) {
+      batch_size = 1;
+    }
+  }
+  work.batch_size = batch_size;
+  uint64_t bytes = 0;
+  if (iree_string_view_atoi_uint64(
+          iree_vm_function_reflection_attr(&function, IREE_SV("bytes")),
+          &bytes)) {
+    work.bytes = bytes;
+  }
+  double flops = 0.0;
+  if (iree_string_view_atod(
+          iree_vm_function_reflection_attr(&function, IREE_SV("flops")),
+          &flops)) {
+    work.flops = flops;
+  }
+  return work;
+}
+
+static void BenchmarkFunction(const std::string& benchmark_name,
+                              const BenchmarkWork& work,
                               iree_vm_context_t* context,
                               iree_vm_function_t function,
-                              iree_vm_list_t* inputs, benchmark::State& state) {
+                              iree_vm_list_t* inputs,
+                              iree_hal_allocator_t* device_allocator,
+                              benchmark::State& state) {
   IREE_TRACE_SCOPE_DYNAMIC(benchmark_name.c_str());
   IREE_TRACE_FRAME_MARK();
 
   // Benchmarking loop.
-  while (state.KeepRunningBatch(batch_size)) {
+  while (state.KeepRunningBatch(work.batch_size)) {
     IREE_TRACE_SCOPE0("BenchmarkIteration");
     IREE_TRACE_FRAME_MARK_NAMED("Iteration");
     vm::ref<iree_vm_list_t> outputs;
@@ -100,21 +183,59 @@ static void BenchmarkFunction(const std::string& benchmark_name, int batch_size,
         context, function, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr,
         inputs, outputs.get(), iree_allocator_system()));
   }
+
+  // Iterations count each batched repetition so the rates are per-dispatch
+  // (or per-call) and not per-invocation.
+  if (work.bytes) {
+    state.SetBytesProcessed(state.iterations() * work.bytes);
+  }
+  if (work.flops > 0.0) {
+    state.counters["FLOP/s"] = benchmark::Counter(
+        work.flops, benchmark::Counter::kIsIterationInvariantRate,
+        benchmark::Counter::kIs1000);
+  }
+
+#if IREE_STATISTICS_ENABLE
+  // Peak memory use includes the warmup and all prior benchmarks run on the
+  // same device.
+  if (device_allocator) {
+    iree_hal_allocator_statistics_t statistics;
+    iree_hal_allocator_query_statistics(device_allocator, &statistics);
+    state.counters["host_bytes_peak"] = benchmark::Counter(
+        (double)statistics.host_bytes_peak, benchmark::Counter::kDefaults,
+        benchmark::Counter::kIs1024);
+    state.counters["device_bytes_peak"] = benchmark::Counter(
+        (double)statistics.device_bytes_peak, benchmark::Counter::kDefaults,
+        benchmark::Counter::kIs1024);
+  }
+#endif  // IREE_STATISTICS_ENABLE
 }
 
 void RegisterModuleBenchmarks(const std::string& function_name,
                               iree_vm_context_t* context,
                               iree_vm_function_t function,
-                              iree_vm_list_t* inputs) {
+                              iree_vm_list_t* inputs,
+                              iree_hal_allocator_t* device_allocator) {
   auto benchmark_name = "BM_" + function_name;
-  int batch_size = FLAG_batch_size;
-  benchmark::RegisterBenchmark(benchmark_name.c_str(),
-                               [benchmark_name, batch_size, context, function,
-                                inputs](benchmark::State& state) -> void {
-                                 BenchmarkFunction(benchmark_name, batch_size,
-                                                   context, function, inputs,
-                                                   state);
-                               })
+  BenchmarkWork work = QueryBenchmarkWork(function);
+
+  for (int32_t i = 0; i < FLAG_warmup_iterations; ++i) {
+    IREE_TRACE_SCOPE0("WarmupIteration");
+    vm::ref<iree_vm_list_t> outputs;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/nullptr, 16,
+                                      iree_allocator_system(), &outputs));
+    IREE_CHECK_OK(iree_vm_invoke(
+        context, function, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr,
+        inputs, outputs.get(), iree_allocator_system()));
+  }
+
+  benchmark::RegisterBenchmark(
+      benchmark_name.c_str(),
+      [benchmark_name, work, context, function, inputs,
+       device_allocator](benchmark::State& state) -> void {
+        BenchmarkFunction(benchmark_name, work, context, function, inputs,
+                          device_allocator, state);
+      })
       // By default only the main thread is included in CPU time. Include all
       // the threads instead.
       ->MeasureProcessCPUTime()
@@ -130,16 +251,44 @@ void RegisterModuleBenchmarks(const std::string& function_name,
       ->Unit(benchmark::kMillisecond);
 }
 
-iree_status_t GetModuleContentsFromFlags(std::string* out_contents) {
-  IREE_TRACE_SCOPE0("GetModuleContentsFromFlags");
+// Returns the |percentile| (0-1) of |sorted_values| using the nearest-rank
+// method.
+static int64_t Percentile(const std::vector<int64_t>& sorted_values,
+                          double percentile) {
+  if (sorted_values.empty()) return 0;
+  size_t rank = static_cast<size_t>(
+      std::ceil(percentile * static_cast<double>(sorted_values.size())));
+  rank = std::min(sorted_values.size(), std::max<size_t>(rank, 1));
+  return sorted_values[rank - 1];
+}
+
+// Creates the input module from the file specified by the flags.
+// Files are memory mapped so that large rodata is only paged in as used; stdin
+// contents are read into |out_stdin_contents| which must outlive the module.
+iree_status_t CreateModuleFromFlags(std::string* out_stdin_contents,
+                                    iree_vm_module_t** out_module) {
+  IREE_TRACE_SCOPE0("CreateModuleFromFlags");
   auto module_file = std::string(FLAG_module_file);
   if (module_file == "-") {
-    *out_contents = std::string{std::istreambuf_iterator<char>(std::cin),
-                                std::istreambuf_iterator<char>()};
-  } else {
-    IREE_RETURN_IF_ERROR(GetFileContents(module_file.c_str(), out_contents));
+    *out_stdin_contents = std::string{std::istreambuf_iterator<char>(std::cin),
+                                      std::istreambuf_iterator<char>()};
+    return iree_vm_bytecode_module_create(
+        iree_make_const_byte_span((void*)out_stdin_contents->data(),
+                                  out_stdin_contents->size()),
+        iree_allocator_null(), iree_allocator_system(), out_module);
   }
-  return iree_ok_status();
+  iree_const_byte_span_t module_data = iree_make_const_byte_span(NULL, 0);
+  iree_allocator_t module_data_allocator = iree_allocator_null();
+  IREE_RETURN_IF_ERROR(iree_file_map_contents(
+      module_file.c_str(), IREE_FILE_ACCESS_HINT_DEFAULT,
+      iree_allocator_system(), &module_data, &module_data_allocator));
+  iree_status_t status =
+      iree_vm_bytecode_module_create(module_data, module_data_allocator,
+                                     iree_allocator_system(), out_module);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(module_data_allocator, (void*)module_data.data);
+  }
+  return status;
 }
 
 // TODO(hanchung): Consider to refactor this out and reuse in iree-run-module.
@@ -157,6 +306,14 @@ class IREEBenchmark {
 
     // Order matters.
     inputs_.reset();
+    if (FLAG_print_vm_profile && context_) {
+      iree_string_builder_t builder;
+      iree_string_builder_initialize(iree_allocator_system(), &builder);
+      IREE_IGNORE_ERROR(iree_vm_context_append_profile(context_, &builder));
+      fprintf(stderr, "%.*s", (int)iree_string_builder_size(&builder),
+              iree_string_builder_buffer(&builder));
+      iree_string_builder_deinitialize(&builder);
+    }
     iree_vm_context_release(context_);
     iree_vm_module_release(hal_module_);
     iree_vm_module_release(input_module_);
@@ -184,13 +341,139 @@ class IREEBenchmark {
     return iree_ok_status();
   }
 
+  // Calls the function specified by --entry_function from --load_threads
+  // client threads for --load_duration_ms and prints the latency distribution
+  // and achieved throughput to stdout.
+  iree_status_t GenerateLoad() {
+    IREE_TRACE_SCOPE0("IREEBenchmark::GenerateLoad");
+
+    if (!instance_ || !device_ || !hal_module_ || !context_ || !input_module_) {
+      IREE_RETURN_IF_ERROR(Init());
+    }
+
+    auto function_name = std::string(FLAG_entry_function);
+    if (function_name.empty()) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "--entry_function must be specified when "
+                              "generating load");
+    }
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(input_module_->lookup_function(
+        input_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_string_view_t{function_name.data(), function_name.size()},
+        &function));
+
+    // Each client gets its own context (and with it HAL module state) so that
+    // clients only share the modules and the device.
+    struct LoadClient {
+      ~LoadClient() { iree_vm_context_release(context); }
+      iree_vm_context_t* context = nullptr;
+      vm::ref<iree_vm_list_t> inputs;
+      std::vector<int64_t> latencies_ns;
+      iree_status_t status = iree_ok_status();
+    };
+    std::vector<LoadClient> clients(FLAG_load_threads);
+    std::array<iree_vm_module_t*, 2> modules = {hal_module_, input_module_};
+    for (auto& client : clients) {
+      IREE_RETURN_IF_ERROR(iree_vm_context_create_with_modules(
+          instance_, IREE_VM_CONTEXT_FLAG_NONE, modules.data(), modules.size(),
+          iree_allocator_system(), &client.context));
+      IREE_RETURN_IF_ERROR(ParseToVariantList(
+          iree_hal_device_allocator(device_),
+          iree::span<const std::string>{FLAG_function_inputs.data(),
+                                        FLAG_function_inputs.size()},
+          &client.inputs));
+    }
+
+    // Requests are scheduled every |interval_ns| starting at |start_ns|.
+    // Clients claim the next scheduled request and wait for its time to come;
+    // when all clients are busy requests fall behind schedule and their
+    // latency includes the time spent waiting to be issued.
+    const iree_time_t interval_ns =
+        FLAG_load_qps > 0.0
+            ? static_cast<iree_time_t>(1000000000.0 / FLAG_load_qps)
+            : 0;
+    const iree_time_t start_ns = iree_time_now();
+    const iree_time_t end_ns =
+        start_ns + static_cast<iree_time_t>(FLAG_load_duration_ms) * 1000000;
+    std::atomic<int64_t> next_request{0};
+    auto run_client = [&](LoadClient* client) {
+      IREE_TRACE_SCOPE0("LoadClient");
+      for (;;) {
+        iree_time_t scheduled_ns = 0;
+        if (interval_ns > 0) {
+          scheduled_ns = start_ns + next_request.fetch_add(1) * interval_ns;
+          if (scheduled_ns >= end_ns) break;
+          iree_wait_until(scheduled_ns);
+        } else {
+          scheduled_ns = iree_time_now();
+          if (scheduled_ns >= end_ns) break;
+        }
+        vm::ref<iree_vm_list_t> outputs;
+        client->status = iree_vm_list_create(/*element_type=*/nullptr, 16,
+                                             iree_allocator_system(), &outputs);
+        if (iree_status_is_ok(client->status)) {
+          client->status = iree_vm_invoke(
+              client->context, function, IREE_VM_INVOCATION_FLAG_NONE,
+              /*policy=*/nullptr, client->inputs.get(), outputs.get(),
+              iree_allocator_system());
+        }
+        if (!iree_status_is_ok(client->status)) break;
+        client->latencies_ns.push_back(iree_time_now() - scheduled_ns);
+      }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(clients.size());
+    for (auto& client : clients) {
+      threads.emplace_back(run_client, &client);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    const iree_time_t elapsed_ns = iree_time_now() - start_ns;
+
+    std::vector<int64_t> latencies_ns;
+    iree_status_t status = iree_ok_status();
+    for (auto& client : clients) {
+      latencies_ns.insert(latencies_ns.end(), client.latencies_ns.begin(),
+                          client.latencies_ns.end());
+      if (iree_status_is_ok(status)) {
+        status = client.status;
+      } else {
+        iree_status_ignore(client.status);
+      }
+    }
+    IREE_RETURN_IF_ERROR(status);
+    std::sort(latencies_ns.begin(), latencies_ns.end());
+
+    auto to_ms = [](int64_t ns) { return static_cast<double>(ns) / 1e6; };
+    if (interval_ns > 0) {
+      fprintf(stdout, "%s: %d threads, open-loop at %.2f qps target\n",
+              function_name.c_str(), FLAG_load_threads, FLAG_load_qps);
+    } else {
+      fprintf(stdout, "%s: %d threads, closed-loop\n", function_name.c_str(),
+              FLAG_load_threads);
+    }
+    fprintf(stdout, "  requests: %zu in %.3fs (%.2f qps achieved)\n",
+            latencies_ns.size(), to_ms(elapsed_ns) / 1e3,
+            static_cast<double>(latencies_ns.size()) * 1e9 /
+                static_cast<double>(elapsed_ns));
+    fprintf(stdout,
+            "  latency (ms): p50 %.3f / p90 %.3f / p99 %.3f / p99.9 %.3f / "
+            "max %.3f\n",
+            to_ms(Percentile(latencies_ns, 0.5)),
+            to_ms(Percentile(latencies_ns, 0.9)),
+            to_ms(Percentile(latencies_ns, 0.99)),
+            to_ms(Percentile(latencies_ns, 0.999)),
+            to_ms(latencies_ns.empty() ? 0 : latencies_ns.back()));
+    return iree_ok_status();
+  }
+
  private:
   iree_status_t Init() {
     IREE_TRACE_SCOPE0("IREEBenchmark::Init");
     IREE_TRACE_FRAME_MARK_BEGIN_NAMED("init");
 
-    IREE_RETURN_IF_ERROR(GetModuleContentsFromFlags(&module_data_));
-
     IREE_RETURN_IF_ERROR(iree_hal_module_register_types());
     IREE_RETURN_IF_ERROR(
         iree_vm_instance_create(iree_allocator_system(), &instance_));
@@ -199,18 +482,27 @@ class IREEBenchmark {
     IREE_RETURN_IF_ERROR(iree::CreateDevice(FLAG_driver, &device_));
     IREE_RETURN_IF_ERROR(
         iree_hal_module_create(device_, iree_allocator_system(), &hal_module_));
-    IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_create(
-        iree_make_const_byte_span((void*)module_data_.data(),
-                                  module_data_.size()),
-        iree_allocator_null(), iree_allocator_system(), &input_module_));
+    IREE_RETURN_IF_ERROR(
+        CreateModuleFromFlags(&stdin_contents_, &input_module_));
 
     // Order matters. The input module will likely be dependent on the hal
     // module.
     std::array<iree_vm_module_t*, 2> modules = {hal_module_, input_module_};
+    iree_vm_context_flags_t context_flags = IREE_VM_CONTEXT_FLAG_NONE;
+    if (FLAG_print_vm_profile) {
+      context_flags |= IREE_VM_CONTEXT_FLAG_PROFILE_EXECUTION;
+    }
     IREE_RETURN_IF_ERROR(iree_vm_context_create_with_modules(
-        instance_, IREE_VM_CONTEXT_FLAG_NONE, modules.data(), modules.size(),
+        instance_, context_flags, modules.data(), modules.size(),
         iree_allocator_system(), &context_));
 
+    if (FLAG_warmup) {
+      iree_vm_module_state_t* hal_module_state = nullptr;
+      IREE_RETURN_IF_ERROR(iree_vm_context_resolve_module_state(
+          context_, hal_module_, &hal_module_state));
+      IREE_RETURN_IF_ERROR(iree_hal_module_state_warmup(hal_module_state));
+    }
+
     IREE_TRACE_FRAME_MARK_END_NAMED("init");
     return iree_ok_status();
   }
@@ -229,7 +521,8 @@ class IREEBenchmark {
         iree::span<const std::string>{FLAG_function_inputs.data(),
                                       FLAG_function_inputs.size()},
         &inputs_));
-    RegisterModuleBenchmarks(function_name, context_, function, inputs_.get());
+    RegisterModuleBenchmarks(function_name, context_, function, inputs_.get(),
+                             iree_hal_device_allocator(device_));
     return iree_ok_status();
   }
 
@@ -272,12 +565,13 @@ class IREEBenchmark {
       iree::RegisterModuleBenchmarks(
           std::string(function_name.data, function_name.size), context_,
           function,
-          /*inputs=*/nullptr);
+          /*inputs=*/nullptr, iree_hal_device_allocator(device_));
     }
     return iree_ok_status();
   }
 
-  std::string module_data_;
+  // Module contents when read from stdin; mapped files are owned by the module.
+  std::string stdin_contents_;
   iree_vm_instance_t* instance_ = nullptr;
   iree_hal_device_t* device_ = nullptr;
   iree_vm_module_t* hal_module_ = nullptr;
@@ -300,13 +594,33 @@ int main(int argc, char** argv) {
   IREE_CHECK_OK(iree_hal_register_all_available_drivers(
       iree_hal_driver_registry_default()));
 
-  iree::IREEBenchmark iree_benchmark;
-  iree_status_t status = iree_benchmark.Register();
+  iree_profiler_file_sink_t* trace_sink = NULL;
+  if (strlen(FLAG_trace_output) > 0) {
+    IREE_CHECK_OK(iree_profiler_file_sink_open(
+        FLAG_trace_output,
+        iree_profiler_file_format_from_path(
+            iree_make_cstring_view(FLAG_trace_output)),
+        IREE_PROFILER_EVENT_MASK_ALL, iree_allocator_system(), &trace_sink));
+    iree_profiler_set(iree_profiler_file_sink_profiler(trace_sink));
+  }
+
+  // Scoped such that the device is released (and all work on it completed)
+  // before the trace is closed.
+  iree_status_t status = iree_ok_status();
+  {
+    iree::IREEBenchmark iree_benchmark;
+    status = FLAG_load_threads > 0 ? iree_benchmark.GenerateLoad()
+                                   : iree_benchmark.Register();
+    if (iree_status_is_ok(status) && FLAG_load_threads == 0) {
+      ::benchmark::RunSpecifiedBenchmarks();
+    }
+  }
+  iree_profiler_file_sink_close(trace_sink);
+
   if (!iree_status_is_ok(status)) {
     int ret = static_cast<int>(iree_status_code(status));
     std::cout << iree::Status(std::move(status)) << std::endl;
     return ret;
   }
-  ::benchmark::RunSpecifiedBenchmarks();
   return 0;
 }
@@ -30,6 +30,14 @@ IREE_FLAG(int32_t, call_iterations, 1,
           "Number of times to invoke each call in the trace. May break usage "
           "with stateful models.");
 
+IREE_FLAG(double, arrival_time_scale, 0.0,
+          "When > 0 calls are issued at the times recorded in the trace "
+          "`timestamp_ns` fields with the gaps between them multiplied by this "
+          "scale (1.0 reproduces the recorded timing, 0.5 replays twice as "
+          "fast). Call latency is measured from the scheduled arrival time and "
+          "includes any queuing behind prior calls. When 0 calls are issued "
+          "back-to-back.");
+
 // A benchmark registration for each file to run.
 typedef struct iree_replay_benchmark_registration_t {
   iree_benchmark_def_t benchmark_def;  // Must be first.
@@ -44,6 +52,9 @@ typedef struct iree_replay_benchmark_registration_t {
 
 // A parsed call event from the trace file.
 typedef struct iree_replay_benchmark_call_t {
+  // Time the call was made relative to the start of the trace or
+  // IREE_TIME_INFINITE_PAST if the trace has no timing information.
+  iree_time_t timestamp_ns;
   iree_vm_function_t function;
   iree_vm_list_t* input_list;
   iree_vm_list_t* output_list;
@@ -90,6 +101,57 @@ iree_replay_benchmark_call_list_acquire_back(
   return &list->items[list->count++];
 }
 
+// A growable list of call latencies in nanoseconds.
+typedef struct iree_replay_benchmark_latency_list_t {
+  size_t count;
+  size_t capacity;
+  iree_duration_t* items;
+} iree_replay_benchmark_latency_list_t;
+
+static void iree_replay_benchmark_latency_list_append(
+    iree_replay_benchmark_latency_list_t* list, iree_duration_t latency_ns) {
+  if (list->count >= list->capacity) {
+    list->capacity = list->capacity ? list->capacity * 2 : 1024;
+    list->items = (iree_duration_t*)realloc(
+        list->items, list->capacity * sizeof(*list->items));
+  }
+  list->items[list->count++] = latency_ns;
+}
+
+static int iree_replay_benchmark_compare_latency(const void* a,
+                                                 const void* b) {
+  iree_duration_t lhs = *(const iree_duration_t*)a;
+  iree_duration_t rhs = *(const iree_duration_t*)b;
+  return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+// Reports the latency distribution of all calls in |list| in milliseconds.
+// The nearest-rank method is used for percentiles.
+static void iree_replay_benchmark_report_latencies(
+    iree_replay_benchmark_latency_list_t* list,
+    iree_benchmark_state_t* benchmark_state) {
+  if (!list->count) return;
+  qsort(list->items, list->count, sizeof(*list->items),
+        iree_replay_benchmark_compare_latency);
+  static const struct {
+    const char* name;
+    double percentile;
+  } kPercentiles[] = {
+      {"p50_ms", 0.50},
+      {"p90_ms", 0.90},
+      {"p99_ms", 0.99},
+      {"p99.9_ms", 0.999},
+      {"max_ms", 1.0},
+  };
+  for (size_t i = 0; i < IREE_ARRAYSIZE(kPercentiles); ++i) {
+    size_t rank = (size_t)(kPercentiles[i].percentile * list->count + 0.5);
+    size_t index = rank ? iree_min(rank, list->count) - 1 : 0;
+    iree_benchmark_set_counter(benchmark_state, kPercentiles[i].name,
+                               list->items[index] / 1e6,
+                               IREE_BENCHMARK_COUNTER_FLAG_NONE);
+  }
+}
+
 // Processes a call trace event by preparing the inputs and appending it to the
 // provided |call_list|.
 static iree_status_t iree_replay_benchmark_prepare_call(
@@ -101,6 +163,8 @@ static iree_status_t iree_replay_benchmark_prepare_call(
   memset(call, 0, sizeof(*call));
 
   // Prepare the call event state.
+  IREE_RETURN_IF_ERROR(iree_trace_replay_event_call_timestamp(
+      document, event_node, &call->timestamp_ns));
   IREE_RETURN_IF_ERROR(iree_trace_replay_event_call_prepare(
       replay, document, event_node, &call->function, &call->input_list));
 
@@ -211,20 +275,55 @@ static iree_status_t iree_replay_benchmark_run_file(
   IREE_RETURN_IF_ERROR(iree_replay_benchmark_load_trace(registration->file_path,
                                                         &replay, &call_list));
 
-  // Call the functions within the trace in order.
+  // Inter-arrival timing is only reproduced when all calls were recorded with
+  // timestamps.
+  bool timed = FLAG_arrival_time_scale > 0.0 && call_list.count > 0;
+  for (size_t i = 0; timed && i < call_list.count; ++i) {
+    if (call_list.items[i].timestamp_ns == IREE_TIME_INFINITE_PAST) {
+      iree_replay_benchmark_call_list_deinitialize(&call_list);
+      iree_trace_replay_deinitialize(&replay, IREE_TRACE_REPLAY_SHUTDOWN_QUIET);
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "--arrival_time_scale requires all calls in the "
+                              "trace to have a `timestamp_ns`");
+    }
+  }
+
+  // Call the functions within the trace in order. Latencies are measured from
+  // when each call is issued: the scheduled arrival time when timed or when the
+  // prior call completed otherwise.
+  iree_replay_benchmark_latency_list_t latency_list = {0};
   while (iree_benchmark_keep_running(benchmark_state,
                                      /*batch_count=*/FLAG_call_iterations)) {
+    iree_time_t base_time_ns = iree_time_now();
     for (size_t i = 0; i < call_list.count; ++i) {
       iree_replay_benchmark_call_t* call = &call_list.items[i];
+      iree_time_t issue_time_ns = iree_time_now();
+      if (timed) {
+        iree_time_t scheduled_time_ns =
+            base_time_ns +
+            (iree_time_t)((call->timestamp_ns -
+                           call_list.items[0].timestamp_ns) *
+                          FLAG_arrival_time_scale);
+        if (scheduled_time_ns > issue_time_ns) {
+          iree_wait_until(scheduled_time_ns);
+        }
+        issue_time_ns = scheduled_time_ns;
+      }
       for (int32_t j = 0; j < FLAG_call_iterations; ++j) {
         IREE_RETURN_IF_ERROR(iree_vm_invoke(
             replay.context, call->function, IREE_VM_INVOCATION_FLAG_NONE,
             /*policy=*/NULL, call->input_list, call->output_list,
             replay.host_allocator));
         IREE_RETURN_IF_ERROR(iree_vm_list_resize(call->output_list, 0));
+        iree_time_t end_time_ns = iree_time_now();
+        iree_replay_benchmark_latency_list_append(&latency_list,
+                                                  end_time_ns - issue_time_ns);
+        issue_time_ns = end_time_ns;
       }
     }
   }
+  iree_replay_benchmark_report_latencies(&latency_list, benchmark_state);
+  free(latency_list.items);
 
   iree_replay_benchmark_call_list_deinitialize(&call_list);
   iree_trace_replay_deinitialize(
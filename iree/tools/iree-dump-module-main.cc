@@ -4,37 +4,358 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "iree/base/api.h"
 #include "iree/base/internal/file_io.h"
-#include "iree/schemas/bytecode_module_def_json_printer.h"
+#include "iree/base/internal/flags.h"
+#include "iree/base/internal/lz4.h"
 #include "iree/tools/utils/vm_util.h"
 
-// Today we just print to JSON. We could do something more useful (size
-// analysis, etc), but JSON should be enough.
-//
+// NOTE: include order matters:
+#include "iree/base/internal/flatcc/debugging.h"
+#include "iree/schemas/bytecode_module_def_json_printer.h"
+#include "iree/schemas/bytecode_module_def_reader.h"
+#include "iree/schemas/bytecode_module_def_verifier.h"
+
+IREE_FLAG(string, output, "json",
+          "Output mode:\n"
+          "  'json': prints the full module flatbuffer as JSON.\n"
+          "  'size': prints a table of where the module bytes go.\n"
+          "  'size_json': prints the size breakdown as JSON.");
+
 // We could also move all of this into iree-translate (mlir -> vmfb -> json),
 // though having a tiny little tool not reliant on LLVM is nice (can run this
 // on a device).
+
+namespace {
+
+// Size of a single rodata segment as stored in the file and once loaded.
+struct RodataSegmentSize {
+  std::string kind;
+  uint64_t stored_bytes = 0;
+  uint64_t loaded_bytes = 0;
+};
+
+// Size of a single internal function's bytecode.
+struct FunctionSize {
+  std::string name;
+  uint64_t bytecode_bytes = 0;
+};
+
+struct ModuleSizes {
+  std::string name;
+  uint64_t file_bytes = 0;
+  uint64_t bytecode_bytes = 0;
+  std::vector<RodataSegmentSize> rodata_segments;
+  std::vector<FunctionSize> functions;
+  // Embedded executable count and stored bytes keyed by format.
+  std::map<std::string, std::pair<uint64_t, uint64_t>> executable_formats;
+  uint64_t rwdata_bytes = 0;
+  uint64_t global_bytes = 0;
+  uint64_t global_ref_count = 0;
+};
+
+// Classifies the contents of a rodata segment by its magic bytes.
+// Executables are embedded as FlatBuffers with the file identifier of their
+// schema (iree/schemas/*_executable_def.fbs) or as native shared libraries.
+// Everything else (constants, strings, etc) is reported as 'data'.
+std::string ClassifyRodata(iree_const_byte_span_t data) {
+  if (data.data_length >= 4) {
+    if (memcmp(data.data, "\x7F" "ELF", 4) == 0) return "executable:elf";
+    if (memcmp(data.data, "\xCF\xFA\xED\xFE", 4) == 0) {
+      return "executable:macho";
+    }
+    if (memcmp(data.data, "MZ", 2) == 0) return "executable:pe";
+  }
+  if (data.data_length >= 8) {
+    static const char* kExecutableIdentifiers[][2] = {
+        {"CUDA", "executable:cuda"}, {"MTLE", "executable:metal"},
+        {"ROCM", "executable:rocm"}, {"SPVE", "executable:spirv"},
+        {"WGSL", "executable:wgsl"},
+    };
+    for (const auto& identifier : kExecutableIdentifiers) {
+      if (memcmp(data.data + 4, identifier[0], 4) == 0) return identifier[1];
+    }
+  }
+  return "data";
+}
+
+iree_status_t CalculateModuleSizes(iree_const_byte_span_t file_data,
+                                   ModuleSizes* out_sizes) {
+  out_sizes->file_bytes = file_data.data_length;
+  int verify_ret = iree_vm_BytecodeModuleDef_verify_as_root(
+      file_data.data, file_data.data_length);
+  if (verify_ret != flatcc_verify_ok) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "flatbuffer verification failed: %s",
+                            flatcc_verify_error_string(verify_ret));
+  }
+  iree_vm_BytecodeModuleDef_table_t module_def =
+      iree_vm_BytecodeModuleDef_as_root(file_data.data);
+  out_sizes->name = iree_vm_BytecodeModuleDef_name(module_def);
+
+  flatbuffers_uint8_vec_t bytecode_data =
+      iree_vm_BytecodeModuleDef_bytecode_data(module_def);
+  out_sizes->bytecode_bytes = flatbuffers_uint8_vec_len(bytecode_data);
+
+  iree_vm_RodataSegmentDef_vec_t rodata_segments =
+      iree_vm_BytecodeModuleDef_rodata_segments(module_def);
+  for (size_t i = 0; i < iree_vm_RodataSegmentDef_vec_len(rodata_segments);
+       ++i) {
+    iree_vm_RodataSegmentDef_table_t segment_def =
+        iree_vm_RodataSegmentDef_vec_at(rodata_segments, i);
+    flatbuffers_uint8_vec_t data = iree_vm_RodataSegmentDef_data(segment_def);
+    RodataSegmentSize segment;
+    segment.stored_bytes = flatbuffers_uint8_vec_len(data);
+    segment.loaded_bytes = segment.stored_bytes;
+    iree_const_byte_span_t contents =
+        iree_make_const_byte_span(data, segment.stored_bytes);
+    std::vector<uint8_t> decompressed;
+    if (iree_vm_RodataSegmentDef_compression_type_type(segment_def) ==
+        iree_vm_CompressionTypeDef_LZ4BlockDataDef) {
+      iree_vm_LZ4BlockDataDef_table_t lz4_def =
+          (iree_vm_LZ4BlockDataDef_table_t)
+              iree_vm_RodataSegmentDef_compression_type(segment_def);
+      segment.loaded_bytes =
+          iree_vm_LZ4BlockDataDef_uncompressed_size(lz4_def);
+      // Only the header is needed to classify the contents but LZ4 blocks
+      // can only be decoded in full.
+      decompressed.resize(segment.loaded_bytes);
+      IREE_RETURN_IF_ERROR(iree_lz4_decompress(
+          contents,
+          iree_make_byte_span(decompressed.data(), decompressed.size())));
+      contents =
+          iree_make_const_byte_span(decompressed.data(), decompressed.size());
+    }
+    segment.kind = ClassifyRodata(contents);
+    if (segment.kind != "data") {
+      auto& format = out_sizes->executable_formats[segment.kind.substr(
+          strlen("executable:"))];
+      format.first += 1;
+      format.second += segment.stored_bytes;
+    }
+    out_sizes->rodata_segments.push_back(std::move(segment));
+  }
+
+  iree_vm_RwdataSegmentDef_vec_t rwdata_segments =
+      iree_vm_BytecodeModuleDef_rwdata_segments(module_def);
+  for (size_t i = 0; i < iree_vm_RwdataSegmentDef_vec_len(rwdata_segments);
+       ++i) {
+    out_sizes->rwdata_bytes += iree_vm_RwdataSegmentDef_byte_size(
+        iree_vm_RwdataSegmentDef_vec_at(rwdata_segments, i));
+  }
+
+  iree_vm_ModuleStateDef_table_t module_state_def =
+      iree_vm_BytecodeModuleDef_module_state(module_def);
+  if (module_state_def) {
+    out_sizes->global_bytes =
+        iree_vm_ModuleStateDef_global_bytes_capacity(module_state_def);
+    out_sizes->global_ref_count =
+        iree_vm_ModuleStateDef_global_ref_count(module_state_def);
+  }
+
+  // Internal functions only have names when exported; others are reported by
+  // ordinal.
+  iree_vm_FunctionDescriptor_vec_t function_descriptors =
+      iree_vm_BytecodeModuleDef_function_descriptors(module_def);
+  size_t function_count =
+      iree_vm_FunctionDescriptor_vec_len(function_descriptors);
+  out_sizes->functions.resize(function_count);
+  for (size_t i = 0; i < function_count; ++i) {
+    iree_vm_FunctionDescriptor_struct_t descriptor =
+        iree_vm_FunctionDescriptor_vec_at(function_descriptors, i);
+    out_sizes->functions[i].name = "internal[" + std::to_string(i) + "]";
+    out_sizes->functions[i].bytecode_bytes =
+        iree_vm_FunctionDescriptor_bytecode_length(descriptor);
+  }
+  iree_vm_ExportFunctionDef_vec_t exported_functions =
+      iree_vm_BytecodeModuleDef_exported_functions(module_def);
+  for (size_t i = 0; i < iree_vm_ExportFunctionDef_vec_len(exported_functions);
+       ++i) {
+    iree_vm_ExportFunctionDef_table_t export_def =
+        iree_vm_ExportFunctionDef_vec_at(exported_functions, i);
+    int32_t ordinal = iree_vm_ExportFunctionDef_internal_ordinal(export_def);
+    flatbuffers_string_t local_name =
+        iree_vm_ExportFunctionDef_local_name(export_def);
+    if (ordinal >= 0 && (size_t)ordinal < function_count &&
+        flatbuffers_string_len(local_name)) {
+      out_sizes->functions[ordinal].name = local_name;
+    }
+  }
+  return iree_ok_status();
+}
+
+uint64_t LoadedRodataBytes(const ModuleSizes& sizes) {
+  uint64_t total = 0;
+  for (const auto& segment : sizes.rodata_segments) {
+    total += segment.loaded_bytes;
+  }
+  return total;
+}
+
+void PrintSizeTable(const ModuleSizes& sizes) {
+  uint64_t stored_rodata_bytes = 0;
+  for (const auto& segment : sizes.rodata_segments) {
+    stored_rodata_bytes += segment.stored_bytes;
+  }
+  uint64_t loaded_rodata_bytes = LoadedRodataBytes(sizes);
+
+  fprintf(stdout, "Module: %s\n", sizes.name.c_str());
+  fprintf(stdout, "  file:           %12" PRIu64 " bytes\n", sizes.file_bytes);
+  fprintf(stdout, "  rodata:         %12" PRIu64 " bytes (%zu segments)\n",
+          stored_rodata_bytes, sizes.rodata_segments.size());
+  fprintf(stdout, "  bytecode:       %12" PRIu64 " bytes (%zu functions)\n",
+          sizes.bytecode_bytes, sizes.functions.size());
+  fprintf(stdout, "\n");
+
+  fprintf(stdout, "Rodata segments:\n");
+  fprintf(stdout, "  %8s %-20s %12s %12s\n", "ordinal", "kind", "stored",
+          "loaded");
+  for (size_t i = 0; i < sizes.rodata_segments.size(); ++i) {
+    const auto& segment = sizes.rodata_segments[i];
+    fprintf(stdout, "  %8zu %-20s %12" PRIu64 " %12" PRIu64 "\n", i,
+            segment.kind.c_str(), segment.stored_bytes, segment.loaded_bytes);
+  }
+  fprintf(stdout, "\n");
+
+  fprintf(stdout, "Executables:\n");
+  fprintf(stdout, "  %-12s %8s %12s\n", "format", "count", "stored");
+  for (const auto& format : sizes.executable_formats) {
+    fprintf(stdout, "  %-12s %8" PRIu64 " %12" PRIu64 "\n",
+            format.first.c_str(), format.second.first, format.second.second);
+  }
+  fprintf(stdout, "\n");
+
+  fprintf(stdout, "Functions:\n");
+  fprintf(stdout, "  %8s %-40s %12s\n", "ordinal", "name", "bytecode");
+  for (size_t i = 0; i < sizes.functions.size(); ++i) {
+    const auto& function = sizes.functions[i];
+    fprintf(stdout, "  %8zu %-40s %12" PRIu64 "\n", i, function.name.c_str(),
+            function.bytecode_bytes);
+  }
+  fprintf(stdout, "\n");
+
+  // Transient memory is allocated by the program at runtime and its peak is
+  // not recorded in the module; use --print_statistics on iree-run-module to
+  // measure it.
+  fprintf(stdout, "Projected resident memory (excluding transients):\n");
+  fprintf(stdout, "  rodata:         %12" PRIu64 " bytes\n",
+          loaded_rodata_bytes);
+  fprintf(stdout, "  rwdata:         %12" PRIu64 " bytes per context\n",
+          sizes.rwdata_bytes);
+  fprintf(stdout,
+          "  globals:        %12" PRIu64 " bytes + %" PRIu64
+          " refs per context\n",
+          sizes.global_bytes, sizes.global_ref_count);
+}
+
+void PrintJsonString(const std::string& value) {
+  fputc('"', stdout);
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      fputc('\\', stdout);
+      fputc(c, stdout);
+    } else if ((unsigned char)c < 0x20) {
+      fprintf(stdout, "\\u%04x", (unsigned char)c);
+    } else {
+      fputc(c, stdout);
+    }
+  }
+  fputc('"', stdout);
+}
+
+void PrintSizeJson(const ModuleSizes& sizes) {
+  fprintf(stdout, "{\n  \"name\": ");
+  PrintJsonString(sizes.name);
+  fprintf(stdout, ",\n  \"file_bytes\": %" PRIu64 ",\n", sizes.file_bytes);
+  fprintf(stdout, "  \"bytecode_bytes\": %" PRIu64 ",\n", sizes.bytecode_bytes);
+
+  fprintf(stdout, "  \"rodata_segments\": [");
+  for (size_t i = 0; i < sizes.rodata_segments.size(); ++i) {
+    const auto& segment = sizes.rodata_segments[i];
+    fprintf(stdout, "%s\n    {\"ordinal\": %zu, \"kind\": ", i ? "," : "", i);
+    PrintJsonString(segment.kind);
+    fprintf(stdout,
+            ", \"stored_bytes\": %" PRIu64 ", \"loaded_bytes\": %" PRIu64 "}",
+            segment.stored_bytes, segment.loaded_bytes);
+  }
+  fprintf(stdout, "\n  ],\n");
+
+  fprintf(stdout, "  \"executables\": [");
+  bool first = true;
+  for (const auto& format : sizes.executable_formats) {
+    fprintf(stdout, "%s\n    {\"format\": ", first ? "" : ",");
+    PrintJsonString(format.first);
+    fprintf(stdout, ", \"count\": %" PRIu64 ", \"stored_bytes\": %" PRIu64 "}",
+            format.second.first, format.second.second);
+    first = false;
+  }
+  fprintf(stdout, "\n  ],\n");
+
+  fprintf(stdout, "  \"functions\": [");
+  for (size_t i = 0; i < sizes.functions.size(); ++i) {
+    const auto& function = sizes.functions[i];
+    fprintf(stdout, "%s\n    {\"ordinal\": %zu, \"name\": ", i ? "," : "", i);
+    PrintJsonString(function.name);
+    fprintf(stdout, ", \"bytecode_bytes\": %" PRIu64 "}",
+            function.bytecode_bytes);
+  }
+  fprintf(stdout, "\n  ],\n");
+
+  fprintf(stdout, "  \"resident_memory\": {\n");
+  fprintf(stdout, "    \"rodata_bytes\": %" PRIu64 ",\n",
+          LoadedRodataBytes(sizes));
+  fprintf(stdout, "    \"rwdata_bytes\": %" PRIu64 ",\n", sizes.rwdata_bytes);
+  fprintf(stdout, "    \"global_bytes\": %" PRIu64 ",\n", sizes.global_bytes);
+  fprintf(stdout, "    \"global_ref_count\": %" PRIu64 "\n",
+          sizes.global_ref_count);
+  fprintf(stdout, "  }\n}\n");
+}
+
+}  // namespace
+
 extern "C" int main(int argc, char** argv) {
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_DEFAULT, &argc, &argv);
   if (argc < 2) {
-    std::cerr << "Syntax: iree-dump-module module.vmfb > module.json\n";
+    std::cerr << "Syntax: iree-dump-module [--output=json|size|size_json] "
+                 "module.vmfb > module.json\n";
     return 1;
   }
   std::string module_contents;
   IREE_CHECK_OK(iree::GetFileContents(argv[1], &module_contents));
 
-  // Print direct to stdout.
-  flatcc_json_printer_t printer;
-  flatcc_json_printer_init(&printer, /*fp=*/nullptr);
-  flatcc_json_printer_set_skip_default(&printer, true);
-  bytecode_module_def_print_json(
-      &printer, reinterpret_cast<const char*>(module_contents.data()),
-      module_contents.size());
-  flatcc_json_printer_clear(&printer);
+  if (strcmp(FLAG_output, "json") == 0) {
+    // Print direct to stdout.
+    flatcc_json_printer_t printer;
+    flatcc_json_printer_init(&printer, /*fp=*/nullptr);
+    flatcc_json_printer_set_skip_default(&printer, true);
+    bytecode_module_def_print_json(
+        &printer, reinterpret_cast<const char*>(module_contents.data()),
+        module_contents.size());
+    flatcc_json_printer_clear(&printer);
+    return 0;
+  }
 
+  ModuleSizes sizes;
+  IREE_CHECK_OK(CalculateModuleSizes(
+      iree_make_const_byte_span(module_contents.data(),
+                                module_contents.size()),
+      &sizes));
+  if (strcmp(FLAG_output, "size") == 0) {
+    PrintSizeTable(sizes);
+  } else if (strcmp(FLAG_output, "size_json") == 0) {
+    PrintSizeJson(sizes);
+  } else {
+    std::cerr << "Unknown --output mode '" << FLAG_output << "'\n";
+    return 1;
+  }
   return 0;
 }
@@ -15,6 +15,7 @@
 #include "iree/base/target_platform.h"
 #include "iree/hal/api.h"
 #include "iree/hal/drivers/init.h"
+#include "iree/hal/string_util.h"
 #include "iree/modules/hal/module.h"
 #include "iree/tools/utils/trace_replay.h"
 #include "iree/tools/utils/yaml_util.h"
@@ -24,6 +25,12 @@ IREE_FLAG(bool, trace_execution, false, "Traces VM execution to stderr.");
 
 IREE_FLAG(string, driver, "vmvx", "Backend driver to use.");
 
+IREE_FLAG(
+    int32_t, benchmark_repetitions, 0,
+    "When > 0, times each matmul over this many calls after checking its\n"
+    "result and reports its GFLOP/s next to the reference implementation's.\n"
+    "Traces generated with --shapes=benchmark sweep sizes meant for this.");
+
 // Helper to get a list item as a buffer_view.
 static iree_status_t iree_get_buffer_view_list_item(
     iree_vm_list_t* list, iree_host_size_t i,
@@ -526,6 +533,87 @@ static iree_status_t copy_list_of_buffer_views(
   return iree_ok_status();
 }
 
+// Returns the GFLOP/s of a |m_size|x|k_size|x|n_size| matmul taking
+// |duration_ns|.
+static double matmul_gflops(iree_hal_dim_t m_size, iree_hal_dim_t k_size,
+                            iree_hal_dim_t n_size,
+                            iree_duration_t duration_ns) {
+  if (duration_ns <= 0) return 0.0;
+  double flops = 2.0 * (double)m_size * (double)k_size * (double)n_size;
+  return flops / (double)duration_ns;
+}
+
+// Times |function| over FLAG_benchmark_repetitions calls on fresh copies of
+// |input_list| and the reference matmul over one call, and prints both.
+// The copies are made outside of the timed region as the function may update
+// its accumulator input in place.
+static iree_status_t benchmark_matmul(iree_trace_replay_t* replay,
+                                      iree_vm_function_t function,
+                                      iree_string_view_t function_name,
+                                      iree_vm_list_t* input_list,
+                                      iree_hal_buffer_view_t* expected_result) {
+  iree_hal_allocator_t* device_allocator =
+      iree_hal_device_allocator(replay->device);
+  iree_hal_buffer_view_t* lhs;
+  iree_hal_buffer_view_t* rhs;
+  iree_hal_buffer_view_t* acc;
+  IREE_RETURN_IF_ERROR(iree_get_buffer_view_list_item(input_list, 0, &lhs));
+  IREE_RETURN_IF_ERROR(iree_get_buffer_view_list_item(input_list, 1, &rhs));
+  IREE_RETURN_IF_ERROR(iree_get_buffer_view_list_item(input_list, 2, &acc));
+  iree_hal_dim_t m_size, k_size, n_size;
+  IREE_RETURN_IF_ERROR(get_matmul_sizes(lhs, rhs, acc, expected_result,
+                                        &m_size, &k_size, &n_size));
+
+  iree_duration_t total_ns = 0;
+  iree_status_t status = iree_ok_status();
+  for (int32_t i = 0; i < FLAG_benchmark_repetitions; ++i) {
+    iree_vm_list_t* call_inputs = NULL;
+    iree_vm_list_t* call_outputs = NULL;
+    status = copy_list_of_buffer_views(device_allocator, input_list,
+                                       &call_inputs);
+    if (iree_status_is_ok(status)) {
+      status = iree_vm_list_create(/*element_type=*/NULL,
+                                   /*initial_capacity=*/8,
+                                   replay->host_allocator, &call_outputs);
+    }
+    if (iree_status_is_ok(status)) {
+      iree_time_t start_ns = iree_time_now();
+      status = iree_vm_invoke(replay->context, function,
+                              IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/NULL,
+                              call_inputs, call_outputs,
+                              replay->host_allocator);
+      total_ns += iree_time_now() - start_ns;
+    }
+    iree_vm_list_release(call_inputs);
+    iree_vm_list_release(call_outputs);
+    if (!iree_status_is_ok(status)) return status;
+  }
+  iree_duration_t iree_ns = total_ns / FLAG_benchmark_repetitions;
+
+  iree_time_t reference_start_ns = iree_time_now();
+  IREE_RETURN_IF_ERROR(reference_matmul(input_list, expected_result));
+  iree_duration_t reference_ns = iree_time_now() - reference_start_ns;
+
+  char lhs_type[16] = {0};
+  char acc_type[16] = {0};
+  IREE_RETURN_IF_ERROR(iree_hal_format_element_type(
+      iree_hal_buffer_view_element_type(lhs), sizeof(lhs_type), lhs_type,
+      NULL));
+  IREE_RETURN_IF_ERROR(iree_hal_format_element_type(
+      iree_hal_buffer_view_element_type(acc), sizeof(acc_type), acc_type,
+      NULL));
+  double iree_gflops = matmul_gflops(m_size, k_size, n_size, iree_ns);
+  double reference_gflops = matmul_gflops(m_size, k_size, n_size, reference_ns);
+  fprintf(stdout,
+          "BENCHMARK %.*s %s %dx%dx%d %s->%s: %.3f ms %.2f GFLOP/s "
+          "(reference %.3f ms %.2f GFLOP/s, %.2fx)\n",
+          (int)function_name.size, function_name.data, FLAG_driver,
+          (int)m_size, (int)k_size, (int)n_size, lhs_type, acc_type,
+          iree_ns / 1e6, iree_gflops, reference_ns / 1e6, reference_gflops,
+          reference_gflops > 0.0 ? iree_gflops / reference_gflops : 0.0);
+  return iree_ok_status();
+}
+
 // Special handler for function calls in a e2e matmul test trace.
 // Assumes that all calls are to functions that take 3 inputs (lhs, rhs, acc)
 // and return the result of a matmul (lhs*rhs+acc).
@@ -582,6 +670,11 @@ static iree_status_t replay_event_call(iree_trace_replay_t* replay,
   // Check that actual_result and expected_result agree.
   IREE_CHECK_OK(iree_check_matmul(input_list, actual_result, expected_result));
 
+  if (FLAG_benchmark_repetitions > 0) {
+    IREE_CHECK_OK(benchmark_matmul(replay, function, function_name, input_list,
+                                   expected_result));
+  }
+
   // Clean up.
   iree_vm_list_release(input_list);
   iree_vm_list_release(copy_of_input_list);
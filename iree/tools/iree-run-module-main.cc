@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <string>
@@ -15,10 +16,13 @@
 #include "iree/base/api.h"
 #include "iree/base/internal/file_io.h"
 #include "iree/base/internal/flags.h"
+#include "iree/base/internal/profiler_sink.h"
+#include "iree/base/profiler.h"
 #include "iree/base/status_cc.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/hal/drivers/init.h"
+#include "iree/hal/utils/memory_timeline.h"
 #include "iree/modules/hal/module.h"
 #include "iree/tools/utils/vm_util.h"
 #include "iree/vm/api.h"
@@ -37,6 +41,12 @@ IREE_FLAG(bool, trace_execution, false, "Traces VM execution to stderr.");
 
 IREE_FLAG(string, driver, "vmvx", "Backend driver to use.");
 
+IREE_FLAG(string, trace_output, "",
+          "Records VM invocations, HAL submissions and waits, dispatches, "
+          "task executor tile ranges, and buffer allocations to the given "
+          "file. Paths ending in `.json` produce a Chrome trace viewable in "
+          "chrome://tracing or ui.perfetto.dev; others produce CSV.");
+
 IREE_FLAG(int32_t, print_max_element_count, 1024,
           "Prints up to the maximum number of elements of output tensors, "
           "eliding the remainder.");
@@ -44,6 +54,15 @@ IREE_FLAG(int32_t, print_max_element_count, 1024,
 IREE_FLAG(bool, print_statistics, false,
           "Prints runtime statistics to stderr on exit.");
 
+IREE_FLAG(bool, warmup, false,
+          "Prepares executables, devices and allocators before invoking the "
+          "function so that it runs without first-call initialization costs.");
+
+IREE_FLAG(bool, print_memory_timeline, false,
+          "Tracks buffer allocations over the run and prints the peak live "
+          "memory and the functions allocating the most memory to stderr on "
+          "exit.");
+
 static iree_status_t parse_function_input(iree_string_view_t flag_name,
                                           void* storage,
                                           iree_string_view_t value) {
@@ -72,22 +91,51 @@ IREE_FLAG_CALLBACK(
     "  2x2xi32=1 2 3 4\n"
     "Optionally, brackets may be used to separate the element values:\n"
     "  2x2xi32=[[1 2][3 4]]\n"
+    "Buffers may also be loaded from binary NumPy files:\n"
+    "  @input.npy\n"
     "Each occurrence of the flag indicates an input in the order they were\n"
     "specified on the command line.");
 
+static std::vector<std::string> FLAG_function_outputs;
+IREE_FLAG_CALLBACK(
+    parse_function_input, print_function_input, &FLAG_function_outputs,
+    function_output,
+    "A binary NumPy file to write an output buffer to of the format:\n"
+    "  @output.npy\n"
+    "Each occurrence of the flag indicates an output in the order they are\n"
+    "returned from the function; empty values skip the respective output.\n"
+    "Outputs are still printed to stdout.");
+
 namespace iree {
 namespace {
 
-iree_status_t GetModuleContentsFromFlags(std::string* out_contents) {
-  IREE_TRACE_SCOPE0("GetModuleContentsFromFlags");
+// Creates the input module from the file specified by the flags.
+// Files are memory mapped so that large rodata is only paged in as used; stdin
+// contents are read into |out_stdin_contents| which must outlive the module.
+iree_status_t CreateModuleFromFlags(std::string* out_stdin_contents,
+                                    iree_vm_module_t** out_module) {
+  IREE_TRACE_SCOPE0("CreateModuleFromFlags");
   auto module_file = std::string(FLAG_module_file);
   if (module_file == "-") {
-    *out_contents = std::string{std::istreambuf_iterator<char>(std::cin),
-                                std::istreambuf_iterator<char>()};
-  } else {
-    IREE_RETURN_IF_ERROR(GetFileContents(module_file.c_str(), out_contents));
+    *out_stdin_contents = std::string{std::istreambuf_iterator<char>(std::cin),
+                                      std::istreambuf_iterator<char>()};
+    return iree_vm_bytecode_module_create(
+        iree_make_const_byte_span((void*)out_stdin_contents->data(),
+                                  out_stdin_contents->size()),
+        iree_allocator_null(), iree_allocator_system(), out_module);
   }
-  return iree_ok_status();
+  iree_const_byte_span_t module_data = iree_make_const_byte_span(NULL, 0);
+  iree_allocator_t module_data_allocator = iree_allocator_null();
+  IREE_RETURN_IF_ERROR(iree_file_map_contents(
+      module_file.c_str(), IREE_FILE_ACCESS_HINT_DEFAULT,
+      iree_allocator_system(), &module_data, &module_data_allocator));
+  iree_status_t status =
+      iree_vm_bytecode_module_create(module_data, module_data_allocator,
+                                     iree_allocator_system(), out_module);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(module_data_allocator, (void*)module_data.data);
+  }
+  return status;
 }
 
 iree_status_t Run() {
@@ -100,12 +148,9 @@ iree_status_t Run() {
       iree_vm_instance_create(iree_allocator_system(), &instance),
       "creating instance");
 
-  std::string module_data;
-  IREE_RETURN_IF_ERROR(GetModuleContentsFromFlags(&module_data));
+  std::string stdin_contents;
   iree_vm_module_t* input_module = nullptr;
-  IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_create(
-      iree_make_const_byte_span((void*)module_data.data(), module_data.size()),
-      iree_allocator_null(), iree_allocator_system(), &input_module));
+  IREE_RETURN_IF_ERROR(CreateModuleFromFlags(&stdin_contents, &input_module));
 
   iree_hal_device_t* device = nullptr;
   IREE_RETURN_IF_ERROR(CreateDevice(FLAG_driver, &device));
@@ -124,6 +169,14 @@ iree_status_t Run() {
           modules.data(), modules.size(), iree_allocator_system(), &context),
       "creating context");
 
+  if (FLAG_warmup) {
+    iree_vm_module_state_t* hal_module_state = nullptr;
+    IREE_RETURN_IF_ERROR(iree_vm_context_resolve_module_state(
+        context, hal_module, &hal_module_state));
+    IREE_RETURN_IF_ERROR(iree_hal_module_state_warmup(hal_module_state),
+                         "warming up");
+  }
+
   std::string function_name = std::string(FLAG_entry_function);
   iree_vm_function_t function;
   if (function_name.empty()) {
@@ -159,6 +212,12 @@ iree_status_t Run() {
   IREE_RETURN_IF_ERROR(
       PrintVariantList(outputs.get(), (size_t)FLAG_print_max_element_count),
       "printing results");
+  IREE_RETURN_IF_ERROR(
+      WriteVariantList(outputs.get(),
+                       iree::span<const std::string>{
+                           FLAG_function_outputs.data(),
+                           FLAG_function_outputs.size()}),
+      "writing results");
 
   inputs.reset();
   outputs.reset();
@@ -190,7 +249,33 @@ extern "C" int main(int argc, char** argv) {
   }
   IREE_CHECK_OK(iree_hal_register_all_available_drivers(
       iree_hal_driver_registry_default()));
+
+  iree_profiler_file_sink_t* trace_sink = NULL;
+  if (strlen(FLAG_trace_output) > 0) {
+    IREE_CHECK_OK(iree_profiler_file_sink_open(
+        FLAG_trace_output,
+        iree_profiler_file_format_from_path(
+            iree_make_cstring_view(FLAG_trace_output)),
+        IREE_PROFILER_EVENT_MASK_ALL, iree_allocator_system(), &trace_sink));
+    iree_profiler_set(iree_profiler_file_sink_profiler(trace_sink));
+  }
+  iree_hal_memory_timeline_t* memory_timeline = NULL;
+  if (FLAG_print_memory_timeline) {
+    // Forwards to the trace sink (if any) as only one profiler can be set.
+    IREE_CHECK_OK(iree_hal_memory_timeline_create(
+        iree_profiler_get(), iree_allocator_system(), &memory_timeline));
+    iree_profiler_set(iree_hal_memory_timeline_profiler(memory_timeline));
+  }
+
   IREE_CHECK_OK(Run());
+
+  // All devices have been released by Run so nothing is recording events.
+  if (memory_timeline) {
+    IREE_CHECK_OK(iree_hal_memory_timeline_fprint(stderr, memory_timeline,
+                                                  /*max_source_count=*/10));
+    iree_hal_memory_timeline_free(memory_timeline);
+  }
+  iree_profiler_file_sink_close(trace_sink);
   return 0;
 }
 
@@ -6,12 +6,14 @@
 
 #include "iree/tools/iree_translate_lib.h"
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
 
 #include "iree/compiler/Dialect/VM/Target/init_targets.h"
+#include "iree/compiler/Utils/CompileTimeReport.h"
 #include "iree/tools/init_compiler_modules.h"
 #include "iree/tools/init_iree_dialects.h"
 #include "iree/tools/init_mlir_dialects.h"
@@ -83,6 +85,18 @@ int mlir::iree_compiler::runIreeTranslateMain(int argc, char **argv) {
                      "process each chunk independently"),
       llvm::cl::init(false));
 
+  llvm::cl::opt<std::string> compileTimeReportFilename(
+      "iree-compile-time-report",
+      llvm::cl::desc("Writes a JSON report of the time spent in each pass and "
+                     "on each executable to the given file"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+
+  llvm::cl::opt<unsigned> compileTimeReportMaxExecutables(
+      "iree-compile-time-report-max-executables",
+      llvm::cl::desc("Maximum number of the slowest executables to list in "
+                     "the compile time report (0 for all)"),
+      llvm::cl::init(20));
+
   // Add flags for all the registered translations.
   llvm::cl::opt<const mlir::TranslateFunction *, false, mlir::TranslationParser>
       translationRequested("", llvm::cl::desc("Translation to perform"),
@@ -112,6 +126,16 @@ int mlir::iree_compiler::runIreeTranslateMain(int argc, char **argv) {
     return 1;
   }
 
+  // Executables are where codegen happens and are reported individually.
+  std::unique_ptr<mlir::iree_compiler::CompileTimeReport> compileTimeReport;
+  if (!compileTimeReportFilename.empty()) {
+    compileTimeReport =
+        std::make_unique<mlir::iree_compiler::CompileTimeReport>(
+            "hal.executable");
+    mlir::iree_compiler::CompileTimeReport::setGlobal(compileTimeReport.get());
+  }
+  auto startTime = std::chrono::steady_clock::now();
+
   /// Processes the memory buffer with a new MLIRContext.
   auto processBuffer = [&](std::unique_ptr<llvm::MemoryBuffer> ownedBuffer,
                            llvm::raw_ostream &os) {
@@ -124,14 +148,33 @@ int mlir::iree_compiler::runIreeTranslateMain(int argc, char **argv) {
     return (*translationRequested)(sourceMgr, os, &context);
   };
 
+  mlir::LogicalResult result = mlir::success();
   if (splitInputFile) {
-    if (failed(mlir::splitAndProcessBuffer(std::move(input), processBuffer,
-                                           output->os())))
-      return 1;
+    result = mlir::splitAndProcessBuffer(std::move(input), processBuffer,
+                                         output->os());
   } else {
-    if (failed(processBuffer(std::move(input), output->os()))) return 1;
+    result = processBuffer(std::move(input), output->os());
+  }
+
+  // The report is written even if translation failed so that slow failing
+  // compilations can be investigated.
+  if (compileTimeReport) {
+    mlir::iree_compiler::CompileTimeReport::setGlobal(nullptr);
+    double totalMs = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - startTime)
+                         .count();
+    auto reportOutput =
+        mlir::openOutputFile(compileTimeReportFilename, &errorMessage);
+    if (!reportOutput) {
+      llvm::errs() << errorMessage << "\n";
+      return 1;
+    }
+    compileTimeReport->writeJSON(reportOutput->os(), totalMs,
+                                 compileTimeReportMaxExecutables);
+    reportOutput->keep();
   }
 
+  if (failed(result)) return 1;
   output->keep();
   return 0;
 }
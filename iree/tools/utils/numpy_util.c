@@ -0,0 +1,419 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/tools/utils/numpy_util.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/internal/file_io.h"
+#include "iree/base/target_platform.h"
+#include "iree/base/tracing.h"
+
+// NumPy .npy format reference:
+// https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+//
+//   "\x93NUMPY" <major:u8> <minor:u8> <header_len:u16 (v1) or u32 (v2/v3)>
+//   <header: python dict literal padded with spaces and terminated by '\n'>
+//   <raw element data>
+//
+// The header dict has the keys 'descr' (dtype string such as '<f4'),
+// 'fortran_order' (True/False), and 'shape' (tuple of dimensions).
+
+#define IREE_NPY_MAGIC "\x93NUMPY"
+#define IREE_NPY_MAGIC_LENGTH 6
+// Total size of the magic, version, and header length and header contents is
+// padded to a multiple of this value.
+#define IREE_NPY_HEADER_ALIGNMENT 64
+// Matches the rank limit of iree_hal_buffer_view_parse.
+#define IREE_NPY_MAX_RANK 128
+
+#if !defined(IREE_ENDIANNESS_LITTLE) || !IREE_ENDIANNESS_LITTLE
+#error "npy support is only implemented for little-endian hosts"
+#endif  // IREE_ENDIANNESS_LITTLE
+
+//===----------------------------------------------------------------------===//
+// Header parsing
+//===----------------------------------------------------------------------===//
+
+// Returns the contents of the header dict following the |key| and its ':'
+// separator or an empty string view if the key is not present.
+static iree_string_view_t iree_npy_find_key_value(iree_string_view_t header,
+                                                  const char* key) {
+  iree_host_size_t key_length = strlen(key);
+  for (iree_host_size_t i = 0; i + key_length + 2 <= header.size; ++i) {
+    char quote = header.data[i];
+    if ((quote != '\'' && quote != '"') ||
+        header.data[i + key_length + 1] != quote ||
+        memcmp(header.data + i + 1, key, key_length) != 0) {
+      continue;
+    }
+    iree_string_view_t value = iree_string_view_trim(
+        iree_string_view_remove_prefix(header, i + key_length + 2));
+    if (!iree_string_view_consume_prefix(&value, iree_make_cstring_view(":"))) {
+      continue;  // matched a value and not a key
+    }
+    return iree_string_view_trim(value);
+  }
+  return iree_string_view_empty();
+}
+
+// Parses a dtype descriptor such as '<f4' into an element type.
+static iree_status_t iree_npy_parse_descr(
+    iree_string_view_t value, iree_hal_element_type_t* out_element_type) {
+  *out_element_type = IREE_HAL_ELEMENT_TYPE_NONE;
+  char quote = value.size ? value.data[0] : 0;
+  iree_host_size_t end = iree_string_view_find_char(value, quote, 1);
+  if ((quote != '\'' && quote != '"') || end == IREE_STRING_VIEW_NPOS) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "npy header missing a valid 'descr'");
+  }
+  iree_string_view_t descr = iree_string_view_substr(value, 1, end - 1);
+  uint32_t byte_count = 0;
+  if (descr.size < 3 ||
+      !iree_string_view_atoi_uint32(iree_string_view_remove_prefix(descr, 2),
+                                    &byte_count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "unsupported npy dtype '%.*s'", (int)descr.size,
+                            descr.data);
+  }
+  char byte_order = descr.data[0];
+  if (byte_order != '<' && byte_order != '|' && byte_order != '=' &&
+      !(byte_order == '>' && byte_count == 1)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "only little-endian npy dtypes are supported; got "
+                            "'%.*s'",
+                            (int)descr.size, descr.data);
+  }
+  iree_hal_numerical_type_t numerical_type = IREE_HAL_NUMERICAL_TYPE_UNKNOWN;
+  switch (descr.data[1]) {
+    case 'i':
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED;
+      break;
+    case 'u':
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED;
+      break;
+    case 'f':
+      if (byte_count == 2 || byte_count == 4 || byte_count == 8) {
+        numerical_type = IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE;
+      }
+      break;
+    case 'b':
+      // Booleans are stored as one byte per element.
+      if (byte_count == 1) numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER;
+      break;
+    default:
+      break;
+  }
+  if (numerical_type == IREE_HAL_NUMERICAL_TYPE_UNKNOWN ||
+      (byte_count != 1 && byte_count != 2 && byte_count != 4 &&
+       byte_count != 8)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported npy dtype '%.*s'", (int)descr.size,
+                            descr.data);
+  }
+  *out_element_type =
+      iree_hal_make_element_type(numerical_type, byte_count * 8);
+  return iree_ok_status();
+}
+
+// Parses a shape tuple such as '(2, 3)', '(4,)', or '()'.
+static iree_status_t iree_npy_parse_shape(iree_string_view_t value,
+                                          iree_host_size_t shape_capacity,
+                                          iree_hal_dim_t* out_shape,
+                                          iree_host_size_t* out_shape_rank) {
+  *out_shape_rank = 0;
+  iree_host_size_t end = iree_string_view_find_char(value, ')', 0);
+  if (!iree_string_view_consume_prefix(&value, iree_make_cstring_view("(")) ||
+      end == IREE_STRING_VIEW_NPOS) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "npy header missing a valid 'shape'");
+  }
+  iree_string_view_t dims = iree_string_view_substr(value, 0, end - 1);
+  iree_host_size_t shape_rank = 0;
+  while (!iree_string_view_is_empty(dims)) {
+    iree_string_view_t dim_str = iree_string_view_empty();
+    iree_string_view_split(dims, ',', &dim_str, &dims);
+    dim_str = iree_string_view_trim(dim_str);
+    if (iree_string_view_is_empty(dim_str)) continue;  // trailing ','
+    int32_t dim = 0;
+    if (shape_rank >= shape_capacity) {
+      return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "npy shape rank exceeds the maximum of %zu",
+                              shape_capacity);
+    } else if (!iree_string_view_atoi_int32(dim_str, &dim) || dim < 0) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "invalid npy shape dimension '%.*s'",
+                              (int)dim_str.size, dim_str.data);
+    }
+    out_shape[shape_rank++] = (iree_hal_dim_t)dim;
+  }
+  *out_shape_rank = shape_rank;
+  return iree_ok_status();
+}
+
+// Parses the npy file prefix and header in |contents|.
+// Returns the offset of the element data in |out_data_offset|.
+static iree_status_t iree_npy_parse_header(
+    iree_const_byte_span_t contents, iree_host_size_t shape_capacity,
+    iree_hal_dim_t* out_shape, iree_host_size_t* out_shape_rank,
+    iree_hal_element_type_t* out_element_type,
+    iree_host_size_t* out_data_offset) {
+  const uint8_t* data = contents.data;
+  if (contents.data_length < IREE_NPY_MAGIC_LENGTH + 4 ||
+      memcmp(data, IREE_NPY_MAGIC, IREE_NPY_MAGIC_LENGTH) != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "file is not in the npy format (magic mismatch)");
+  }
+  uint8_t major_version = data[IREE_NPY_MAGIC_LENGTH];
+  iree_host_size_t prefix_length = 0;
+  iree_host_size_t header_length = 0;
+  if (major_version == 1) {
+    prefix_length = IREE_NPY_MAGIC_LENGTH + 2 + 2;
+    header_length =
+        (iree_host_size_t)data[8] | ((iree_host_size_t)data[9] << 8);
+  } else if (major_version == 2 || major_version == 3) {
+    prefix_length = IREE_NPY_MAGIC_LENGTH + 2 + 4;
+    if (contents.data_length < prefix_length) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "npy file truncated in header");
+    }
+    header_length = (iree_host_size_t)data[8] |
+                    ((iree_host_size_t)data[9] << 8) |
+                    ((iree_host_size_t)data[10] << 16) |
+                    ((iree_host_size_t)data[11] << 24);
+  } else {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported npy format version %u",
+                            major_version);
+  }
+  if (contents.data_length - prefix_length < header_length) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "npy file truncated in header");
+  }
+  iree_string_view_t header = iree_make_string_view(
+      (const char*)data + prefix_length, header_length);
+
+  IREE_RETURN_IF_ERROR(iree_npy_parse_descr(
+      iree_npy_find_key_value(header, "descr"), out_element_type));
+  if (!iree_string_view_starts_with(
+          iree_npy_find_key_value(header, "fortran_order"),
+          iree_make_cstring_view("False"))) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "only C-ordered npy arrays are supported");
+  }
+  IREE_RETURN_IF_ERROR(
+      iree_npy_parse_shape(iree_npy_find_key_value(header, "shape"),
+                           shape_capacity, out_shape, out_shape_rank));
+
+  *out_data_offset = prefix_length + header_length;
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Loading
+//===----------------------------------------------------------------------===//
+
+iree_status_t iree_tools_utils_buffer_view_from_npy(
+    const char* path, iree_hal_allocator_t* allocator,
+    iree_hal_buffer_view_t** out_buffer_view) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(allocator);
+  IREE_ASSERT_ARGUMENT(out_buffer_view);
+  *out_buffer_view = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Mapping lets the element data be copied straight from the page cache into
+  // the device buffer without an intermediate heap copy.
+  iree_const_byte_span_t contents = iree_const_byte_span_empty();
+  iree_allocator_t contents_deallocator = iree_allocator_null();
+  iree_status_t status = iree_file_map_contents(
+      path, IREE_FILE_ACCESS_HINT_SEQUENTIAL,
+      iree_hal_allocator_host_allocator(allocator), &contents,
+      &contents_deallocator);
+
+  iree_hal_dim_t shape[IREE_NPY_MAX_RANK];
+  iree_host_size_t shape_rank = 0;
+  iree_hal_element_type_t element_type = IREE_HAL_ELEMENT_TYPE_NONE;
+  iree_host_size_t data_offset = 0;
+  if (iree_status_is_ok(status)) {
+    status = iree_npy_parse_header(contents, IREE_ARRAYSIZE(shape), shape,
+                                   &shape_rank, &element_type, &data_offset);
+  }
+
+  iree_device_size_t data_length = 0;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_buffer_compute_view_size(
+        shape, shape_rank, element_type,
+        IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &data_length);
+  }
+  if (iree_status_is_ok(status) &&
+      contents.data_length - data_offset < data_length) {
+    status = iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "npy file data truncated: expected %" PRIdsz " bytes but only %" PRIhsz
+        " are present",
+        data_length, contents.data_length - data_offset);
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_buffer_view_allocate_buffer(
+        allocator, shape, shape_rank, element_type,
+        IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER |
+            IREE_HAL_BUFFER_USAGE_MAPPING,
+        iree_make_const_byte_span(contents.data + data_offset,
+                                  (iree_host_size_t)data_length),
+        out_buffer_view);
+  }
+
+  iree_allocator_free(contents_deallocator, (void*)contents.data);
+  if (!iree_status_is_ok(status)) {
+    status = iree_status_annotate_f(status, "loading npy file '%s'", path);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Writing
+//===----------------------------------------------------------------------===//
+
+// Formats the npy dtype descriptor for |element_type| into |out_descr|.
+static iree_status_t iree_npy_format_descr(iree_hal_element_type_t element_type,
+                                           char out_descr[8]) {
+  iree_host_size_t byte_count = iree_hal_element_dense_byte_count(element_type);
+  char kind = 0;
+  switch (iree_hal_element_numerical_type(element_type)) {
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER:
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED:
+      kind = 'i';
+      break;
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED:
+      kind = 'u';
+      break;
+    case IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE:
+      kind = 'f';
+      break;
+    default:
+      break;
+  }
+  if (!kind || !iree_hal_element_is_byte_aligned(element_type) ||
+      (byte_count != 1 && byte_count != 2 && byte_count != 4 &&
+       byte_count != 8) ||
+      (kind == 'f' && byte_count == 1)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "element type %08X has no npy equivalent",
+                            element_type);
+  }
+  snprintf(out_descr, 8, "%c%c%zu", byte_count == 1 ? '|' : '<', kind,
+           byte_count);
+  return iree_ok_status();
+}
+
+// Formats the npy prefix and padded header for |buffer_view| into |buffer|.
+static iree_status_t iree_npy_format_header(
+    iree_hal_buffer_view_t* buffer_view, iree_host_size_t buffer_capacity,
+    char* buffer, iree_host_size_t* out_buffer_length) {
+  char descr[8];
+  IREE_RETURN_IF_ERROR(iree_npy_format_descr(
+      iree_hal_buffer_view_element_type(buffer_view), descr));
+
+  // Leave room for the prefix; the header length is filled in below.
+  const iree_host_size_t prefix_length = IREE_NPY_MAGIC_LENGTH + 2 + 2;
+  iree_host_size_t length = prefix_length;
+  int n = snprintf(buffer + length, buffer_capacity - length,
+                   "{'descr': '%s', 'fortran_order': False, 'shape': (", descr);
+  length += n > 0 ? n : 0;
+  const iree_hal_dim_t* shape = iree_hal_buffer_view_shape_dims(buffer_view);
+  iree_host_size_t shape_rank = iree_hal_buffer_view_shape_rank(buffer_view);
+  for (iree_host_size_t i = 0; i < shape_rank && length < buffer_capacity;
+       ++i) {
+    // Single element tuples require a trailing ',' in python syntax.
+    n = snprintf(buffer + length, buffer_capacity - length,
+                 shape_rank == 1 ? "%d," : (i > 0 ? ", %d" : "%d"), shape[i]);
+    length += n > 0 ? n : 0;
+  }
+  if (length < buffer_capacity) {
+    n = snprintf(buffer + length, buffer_capacity - length, "), }");
+    length += n > 0 ? n : 0;
+  }
+
+  // Pad with spaces to the alignment and terminate with a newline.
+  iree_host_size_t total_length =
+      iree_host_align(length + 1, IREE_NPY_HEADER_ALIGNMENT);
+  iree_host_size_t header_length = total_length - prefix_length;
+  if (total_length > buffer_capacity || header_length > UINT16_MAX) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "npy header for rank %zu shape too large",
+                            shape_rank);
+  }
+  memset(buffer + length, ' ', total_length - length - 1);
+  buffer[total_length - 1] = '\n';
+
+  memcpy(buffer, IREE_NPY_MAGIC, IREE_NPY_MAGIC_LENGTH);
+  buffer[IREE_NPY_MAGIC_LENGTH + 0] = 1;  // major version
+  buffer[IREE_NPY_MAGIC_LENGTH + 1] = 0;  // minor version
+  buffer[IREE_NPY_MAGIC_LENGTH + 2] = (char)(header_length & 0xFF);
+  buffer[IREE_NPY_MAGIC_LENGTH + 3] = (char)((header_length >> 8) & 0xFF);
+
+  *out_buffer_length = total_length;
+  return iree_ok_status();
+}
+
+iree_status_t iree_tools_utils_buffer_view_write_npy(
+    const char* path, iree_hal_buffer_view_t* buffer_view) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(buffer_view);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  if (iree_hal_buffer_view_encoding_type(buffer_view) !=
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "only dense row-major buffer views can be written "
+                            "as npy files");
+  }
+
+  // Large enough for any shape up to the maximum rank.
+  char header[IREE_NPY_MAX_RANK * 16 + 128];
+  iree_host_size_t header_length = 0;
+  iree_status_t status = iree_npy_format_header(buffer_view, sizeof(header),
+                                                header, &header_length);
+
+  iree_hal_buffer_mapping_t mapping = {{0}};
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_buffer_map_range(
+        iree_hal_buffer_view_buffer(buffer_view), IREE_HAL_MAPPING_MODE_SCOPED,
+        IREE_HAL_MEMORY_ACCESS_READ, 0,
+        iree_hal_buffer_view_byte_length(buffer_view), &mapping);
+  }
+
+  FILE* file = NULL;
+  if (iree_status_is_ok(status)) {
+    file = fopen(path, "wb");
+    if (!file) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "failed to open file '%s'", path);
+    }
+  }
+  if (iree_status_is_ok(status) &&
+      (fwrite(header, 1, header_length, file) != header_length ||
+       fwrite(mapping.contents.data, 1, mapping.contents.data_length, file) !=
+           mapping.contents.data_length)) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to write npy file '%s'", path);
+  }
+  if (file) fclose(file);
+  if (mapping.contents.data) {
+    status = iree_status_join(status, iree_hal_buffer_unmap_range(&mapping));
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,41 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_TOOLS_UTILS_NUMPY_UTIL_H_
+#define IREE_TOOLS_UTILS_NUMPY_UTIL_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#if __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Loads the NumPy .npy file at |path| into a HAL buffer view allocated from
+// |allocator|. The element type and shape are taken from the file header.
+//
+// Only little-endian, C-ordered (non-fortran_order) numeric and bool arrays
+// are supported; bool arrays are loaded as i8. Versions 1.0 through 3.0 of the
+// format are accepted.
+//
+// The returned |out_buffer_view| must be released by the caller.
+iree_status_t iree_tools_utils_buffer_view_from_npy(
+    const char* path, iree_hal_allocator_t* allocator,
+    iree_hal_buffer_view_t** out_buffer_view);
+
+// Writes the contents of |buffer_view| to |path| as a NumPy .npy file.
+// Existing contents are overwritten.
+//
+// The buffer view must have a dense row-major encoding and an element type
+// with a NumPy equivalent. The resulting file can be loaded with numpy.load.
+iree_status_t iree_tools_utils_buffer_view_write_npy(
+    const char* path, iree_hal_buffer_view_t* buffer_view);
+
+#if __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // IREE_TOOLS_UTILS_NUMPY_UTIL_H_
@@ -18,6 +18,15 @@
 #include "iree/modules/hal/module.h"
 #include "iree/vm/bytecode_module.h"
 
+// A file backing buffer contents mapped into memory.
+struct iree_trace_replay_mapped_file_t {
+  iree_trace_replay_mapped_file_t* next;
+  iree_const_byte_span_t contents;
+  iree_allocator_t deallocator;
+  // NUL-terminated fully-qualified path of the file.
+  char path[];
+};
+
 iree_status_t iree_trace_replay_initialize(
     iree_string_view_t root_path, iree_vm_instance_t* instance,
     iree_vm_context_flags_t context_flags, iree_allocator_t host_allocator,
@@ -45,6 +54,15 @@ void iree_trace_replay_deinitialize(iree_trace_replay_t* replay,
   }
   iree_hal_device_release(replay->device);
 
+  iree_trace_replay_mapped_file_t* mapped_file = replay->mapped_files;
+  while (mapped_file) {
+    iree_trace_replay_mapped_file_t* next_file = mapped_file->next;
+    iree_allocator_free(mapped_file->deallocator,
+                        (void*)mapped_file->contents.data);
+    iree_allocator_free(replay->host_allocator, mapped_file);
+    mapped_file = next_file;
+  }
+
   memset(replay, 0, sizeof(*replay));
 }
 
@@ -720,6 +738,87 @@ static iree_status_t iree_trace_replay_parse_hal_buffer(
   return status;
 }
 
+// Returns the contents of the file at |path| (relative to the replay root),
+// mapping it into memory if it has not yet been referenced.
+static iree_status_t iree_trace_replay_map_file(
+    iree_trace_replay_t* replay, iree_string_view_t path,
+    iree_const_byte_span_t* out_contents) {
+  char* full_path = NULL;
+  IREE_RETURN_IF_ERROR(iree_file_path_join(replay->root_path, path,
+                                           replay->host_allocator, &full_path));
+  for (iree_trace_replay_mapped_file_t* mapped_file = replay->mapped_files;
+       mapped_file; mapped_file = mapped_file->next) {
+    if (strcmp(mapped_file->path, full_path) == 0) {
+      iree_allocator_free(replay->host_allocator, full_path);
+      *out_contents = mapped_file->contents;
+      return iree_ok_status();
+    }
+  }
+
+  iree_host_size_t path_length = strlen(full_path);
+  iree_trace_replay_mapped_file_t* mapped_file = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      replay->host_allocator, sizeof(*mapped_file) + path_length + 1,
+      (void**)&mapped_file);
+  if (iree_status_is_ok(status)) {
+    memcpy(mapped_file->path, full_path, path_length + 1);
+    status = iree_file_map_contents(
+        full_path, IREE_FILE_ACCESS_HINT_DEFAULT, replay->host_allocator,
+        &mapped_file->contents, &mapped_file->deallocator);
+  }
+  iree_allocator_free(replay->host_allocator, full_path);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(replay->host_allocator, mapped_file);
+    return status;
+  }
+  mapped_file->next = replay->mapped_files;
+  replay->mapped_files = mapped_file;
+  *out_contents = mapped_file->contents;
+  return iree_ok_status();
+}
+
+// Resolves the |byte_length| bytes of buffer contents stored in an external
+// file referenced by |contents_file_node| starting at the optional
+// `contents_offset` of |value_node|. The returned span references the mapped
+// file and is valid for the lifetime of the replay.
+//
+// ```yaml
+// contents_file: calls.bin
+// contents_offset: 1024
+// ```
+static iree_status_t iree_trace_replay_resolve_contents_file(
+    iree_trace_replay_t* replay, yaml_document_t* document,
+    yaml_node_t* value_node, yaml_node_t* contents_file_node,
+    iree_device_size_t byte_length, iree_const_byte_span_t* out_contents) {
+  yaml_node_t* offset_node = NULL;
+  IREE_RETURN_IF_ERROR(iree_yaml_mapping_try_find(
+      document, value_node, iree_make_cstring_view("contents_offset"),
+      &offset_node));
+  uint64_t offset = 0;
+  if (offset_node && !iree_string_view_atoi_uint64(
+                         iree_yaml_node_as_string(offset_node), &offset)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "(%zu): invalid contents_offset",
+                            offset_node->start_mark.line);
+  }
+
+  iree_const_byte_span_t file_contents = iree_const_byte_span_empty();
+  IREE_RETURN_IF_ERROR(iree_trace_replay_map_file(
+      replay, iree_yaml_node_as_string(contents_file_node), &file_contents));
+  if (offset > file_contents.data_length ||
+      byte_length > file_contents.data_length - offset) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "(%zu): contents range [%" PRIu64 ", %" PRIu64
+        ") exceeds the file length of %zu bytes",
+        contents_file_node->start_mark.line, offset,
+        offset + (uint64_t)byte_length, file_contents.data_length);
+  }
+  *out_contents = iree_make_const_byte_span(file_contents.data + offset,
+                                            (iree_host_size_t)byte_length);
+  return iree_ok_status();
+}
+
 // Parses a !hal.buffer_view and appends it to |target_list|.
 //
 // ```yaml
@@ -729,6 +828,10 @@ static iree_status_t iree_trace_replay_parse_hal_buffer(
 // contents: !!binary |
 //   AACAPwAAAEAAAEBAAACAQA==
 // ```
+//
+// Large contents may instead be stored in a raw binary sidecar file with
+// `contents_file` (see iree_trace_replay_resolve_contents_file) so that they
+// are copied directly from the mapped file without any parsing.
 static iree_status_t iree_trace_replay_parse_hal_buffer_view(
     iree_trace_replay_t* replay, yaml_document_t* document,
     yaml_node_t* value_node, iree_vm_list_t* target_list) {
@@ -767,12 +870,36 @@ static iree_status_t iree_trace_replay_parse_hal_buffer_view(
       document, value_node, iree_make_cstring_view("contents_generator"),
       &generator_node));
 
+  yaml_node_t* contents_file_node = NULL;
+  IREE_RETURN_IF_ERROR(iree_yaml_mapping_try_find(
+      document, value_node, iree_make_cstring_view("contents_file"),
+      &contents_file_node));
+
+  int contents_source_count = (contents_node ? 1 : 0) +
+                              (generator_node ? 1 : 0) +
+                              (contents_file_node ? 1 : 0);
   iree_hal_buffer_view_t* buffer_view = NULL;
-  if (contents_node && generator_node) {
+  if (contents_source_count > 1) {
     return iree_make_status(
         IREE_STATUS_INVALID_ARGUMENT,
-        "(%zu): cannot have both contents and contents_generator",
-        generator_node->start_mark.line);
+        "(%zu): only one of contents, contents_generator, and contents_file "
+        "may be specified",
+        value_node->start_mark.line);
+  } else if (contents_file_node) {
+    iree_device_size_t byte_length = 0;
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_compute_view_size(
+        shape, shape_rank, element_type, encoding_type, &byte_length));
+    iree_const_byte_span_t contents = iree_const_byte_span_empty();
+    IREE_RETURN_IF_ERROR(iree_trace_replay_resolve_contents_file(
+        replay, document, value_node, contents_file_node, byte_length,
+        &contents));
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_view_allocate_buffer(
+        iree_hal_device_allocator(replay->device), shape, shape_rank,
+        element_type, encoding_type,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER |
+            IREE_HAL_BUFFER_USAGE_MAPPING,
+        contents, &buffer_view));
   } else if (contents_node || generator_node) {
     iree_trace_replay_generation_params_t params = {
         .replay = replay,
@@ -1018,6 +1145,26 @@ iree_status_t iree_trace_replay_event_call_prepare(
   return status;
 }
 
+iree_status_t iree_trace_replay_event_call_timestamp(
+    yaml_document_t* document, yaml_node_t* event_node,
+    iree_time_t* out_timestamp_ns) {
+  *out_timestamp_ns = IREE_TIME_INFINITE_PAST;
+  yaml_node_t* timestamp_node = NULL;
+  IREE_RETURN_IF_ERROR(iree_yaml_mapping_try_find(
+      document, event_node, iree_make_cstring_view("timestamp_ns"),
+      &timestamp_node));
+  if (!timestamp_node) return iree_ok_status();
+  int64_t timestamp_ns = 0;
+  if (!iree_string_view_atoi_int64(iree_yaml_node_as_string(timestamp_node),
+                                   &timestamp_ns)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "(%zu): invalid timestamp_ns",
+                            timestamp_node->start_mark.line);
+  }
+  *out_timestamp_ns = timestamp_ns;
+  return iree_ok_status();
+}
+
 iree_status_t iree_trace_replay_event_call(iree_trace_replay_t* replay,
                                            yaml_document_t* document,
                                            yaml_node_t* event_node,
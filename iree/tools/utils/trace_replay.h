@@ -22,6 +22,8 @@ enum iree_trace_replay_shutdown_flag_bits_e {
 };
 typedef uint32_t iree_trace_replay_shutdown_flags_t;
 
+typedef struct iree_trace_replay_mapped_file_t iree_trace_replay_mapped_file_t;
+
 typedef struct iree_trace_replay_t {
   iree_allocator_t host_allocator;
   iree_string_view_t root_path;
@@ -31,6 +33,11 @@ typedef struct iree_trace_replay_t {
 
   iree_vm_context_t* context;
   iree_hal_device_t* device;
+
+  // Files referenced by `contents_file` buffer contents that have been mapped.
+  // Files stay mapped for the lifetime of the replay so that many buffers can
+  // reference a single file.
+  iree_trace_replay_mapped_file_t* mapped_files;
 } iree_trace_replay_t;
 
 // Initializes a trace replay context.
@@ -73,6 +80,14 @@ iree_status_t iree_trace_replay_event_call_prepare(
     yaml_node_t* event_node, iree_vm_function_t* out_function,
     iree_vm_list_t** out_input_list);
 
+// Queries the optional `timestamp_ns` of a `call` event recording when the
+// call was made relative to the start of the trace.
+// |out_timestamp_ns| will be IREE_TIME_INFINITE_PAST if the event has no
+// timestamp.
+iree_status_t iree_trace_replay_event_call_timestamp(
+    yaml_document_t* document, yaml_node_t* event_node,
+    iree_time_t* out_timestamp_ns);
+
 // Replays a `call` event against the replay context.
 // Optionally |out_output_list| can be populated with a caller-owned set of
 // outputs from the call.
@@ -7,6 +7,7 @@
 #include "iree/tools/utils/vm_util.h"
 
 #include <cerrno>
+#include <cinttypes>
 #include <cstdint>
 #include <cstdio>
 #include <ostream>
@@ -20,6 +21,7 @@
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/modules/hal/module.h"
+#include "iree/tools/utils/numpy_util.h"
 #include "iree/vm/ref_cc.h"
 
 namespace iree {
@@ -79,6 +81,18 @@ Status ParseToVariantList(iree_hal_allocator_t* allocator,
   for (size_t i = 0; i < input_strings.size(); ++i) {
     iree_string_view_t input_view = iree_string_view_trim(iree_make_string_view(
         input_strings[i].data(), input_strings[i].size()));
+    if (iree_string_view_consume_prefix(&input_view,
+                                        iree_make_cstring_view("@"))) {
+      // Buffer view loaded from a numpy file.
+      std::string path(input_view.data, input_view.size);
+      iree_hal_buffer_view_t* buffer_view = nullptr;
+      IREE_RETURN_IF_ERROR(iree_tools_utils_buffer_view_from_npy(
+          path.c_str(), allocator, &buffer_view));
+      auto buffer_view_ref = iree_hal_buffer_view_move_ref(buffer_view);
+      IREE_RETURN_IF_ERROR(
+          iree_vm_list_push_ref_move(variant_list.get(), &buffer_view_ref));
+      continue;
+    }
     bool has_equal =
         iree_string_view_find_char(input_view, '=', 0) != IREE_STRING_VIEW_NPOS;
     bool has_x =
@@ -195,6 +209,94 @@ Status PrintVariantList(iree_vm_list_t* variant_list, size_t max_element_count,
   return OkStatus();
 }
 
+Status PrintVariantList(iree_vm_list_t* variant_list, size_t max_element_count,
+                        FILE* file) {
+  for (iree_host_size_t i = 0; i < iree_vm_list_size(variant_list); ++i) {
+    iree_vm_variant_t variant = iree_vm_variant_empty();
+    IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(variant_list, i, &variant),
+                         "variant %zu not present", i);
+
+    fprintf(file, "result[%zu]: ", i);
+    if (iree_vm_variant_is_value(variant)) {
+      switch (variant.type.value_type) {
+        case IREE_VM_VALUE_TYPE_I8:
+          fprintf(file, "i8=%" PRIi8 "\n", variant.i8);
+          break;
+        case IREE_VM_VALUE_TYPE_I16:
+          fprintf(file, "i16=%" PRIi16 "\n", variant.i16);
+          break;
+        case IREE_VM_VALUE_TYPE_I32:
+          fprintf(file, "i32=%" PRIi32 "\n", variant.i32);
+          break;
+        case IREE_VM_VALUE_TYPE_I64:
+          fprintf(file, "i64=%" PRIi64 "\n", variant.i64);
+          break;
+        case IREE_VM_VALUE_TYPE_F32:
+          fprintf(file, "f32=%g\n", variant.f32);
+          break;
+        case IREE_VM_VALUE_TYPE_F64:
+          fprintf(file, "f64=%g\n", variant.f64);
+          break;
+        default:
+          fprintf(file, "?\n");
+          break;
+      }
+    } else if (iree_vm_variant_is_ref(variant)) {
+      iree_string_view_t type_name =
+          iree_vm_ref_type_name(variant.type.ref_type);
+      fprintf(file, "%.*s\n", (int)type_name.size, type_name.data);
+      if (iree_hal_buffer_view_isa(variant.ref)) {
+        auto* buffer_view = iree_hal_buffer_view_deref(variant.ref);
+        IREE_RETURN_IF_ERROR(iree_hal_buffer_view_fprint(
+            file, buffer_view, max_element_count, iree_allocator_system()));
+        fprintf(file, "\n");
+      } else {
+        // TODO(benvanik): a way for ref types to describe themselves.
+        fprintf(file, "(no printer)\n");
+      }
+    } else {
+      fprintf(file, "(null)\n");
+    }
+  }
+  return OkStatus();
+}
+
+Status WriteVariantList(iree_vm_list_t* variant_list,
+                        iree::span<const std::string> output_strings) {
+  if (output_strings.size() > iree_vm_list_size(variant_list)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "%zu outputs specified but only %zu results",
+                            output_strings.size(),
+                            iree_vm_list_size(variant_list));
+  }
+  for (size_t i = 0; i < output_strings.size(); ++i) {
+    iree_string_view_t output_view = iree_string_view_trim(
+        iree_make_string_view(output_strings[i].data(),
+                              output_strings[i].size()));
+    if (iree_string_view_is_empty(output_view)) continue;
+    if (!iree_string_view_consume_prefix(&output_view,
+                                         iree_make_cstring_view("@"))) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "output %zu '%.*s' must be an @path.npy file", i,
+                              (int)output_view.size, output_view.data);
+    }
+    iree_vm_variant_t variant = iree_vm_variant_empty();
+    IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(variant_list, i, &variant),
+                         "variant %zu not present", i);
+    if (!iree_vm_variant_is_ref(variant) ||
+        !iree_hal_buffer_view_isa(variant.ref)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "result %zu is not a buffer view and cannot be "
+                              "written to a file",
+                              i);
+    }
+    std::string path(output_view.data, output_view.size);
+    IREE_RETURN_IF_ERROR(iree_tools_utils_buffer_view_write_npy(
+        path.c_str(), iree_hal_buffer_view_deref(variant.ref)));
+  }
+  return OkStatus();
+}
+
 Status CreateDevice(const char* driver_name, iree_hal_device_t** out_device) {
   IREE_LOG(INFO) << "Creating driver and device for '" << driver_name << "'...";
   iree_hal_driver_t* driver = nullptr;
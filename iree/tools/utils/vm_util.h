@@ -7,6 +7,7 @@
 #ifndef IREE_TOOLS_UTILS_VM_UTIL_H_
 #define IREE_TOOLS_UTILS_VM_UTIL_H_
 
+#include <cstdio>
 #include <iostream>
 #include <ostream>
 #include <string>
@@ -31,6 +32,8 @@ Status GetFileContents(const char* path, std::string* out_contents);
 // Buffers should be in the IREE standard shaped buffer format:
 //   [shape]xtype=[value]
 // described in iree/hal/api.h
+// Buffers may also be loaded from NumPy .npy files by prefixing a path with @:
+//   @path/to/input.npy
 // Uses |allocator| to allocate the buffers.
 // Uses descriptors in |descs| for type information and validation.
 // The returned variant list must be freed by the caller.
@@ -51,11 +54,25 @@ Status PrintVariantList(iree_vm_list_t* variant_list, size_t max_element_count,
 inline Status PrintVariantList(iree_vm_list_t* variant_list, std::ostream* os) {
   return PrintVariantList(variant_list, 1024, os);
 }
+
+// Prints a variant list to |file| in the same format as above.
+// Buffer contents are streamed to the file as they are formatted instead of
+// first being formatted into an intermediate string.
+Status PrintVariantList(iree_vm_list_t* variant_list, size_t max_element_count,
+                        FILE* file);
 inline Status PrintVariantList(iree_vm_list_t* variant_list,
                                size_t max_element_count = 1024) {
-  return PrintVariantList(variant_list, max_element_count, &std::cout);
+  return PrintVariantList(variant_list, max_element_count, stdout);
 }
 
+// Writes the buffer views in |variant_list| to the files named in
+// |output_strings|. Each output string corresponds to the list element at the
+// same ordinal and must either be empty (to skip the element) or a path to a
+// NumPy .npy file prefixed with @:
+//   @path/to/output.npy
+Status WriteVariantList(iree_vm_list_t* variant_list,
+                        iree::span<const std::string> output_strings);
+
 // Creates the default device for |driver| in |out_device|.
 // The returned |out_device| must be released by the caller.
 Status CreateDevice(const char* driver_name, iree_hal_device_t** out_device);
@@ -6,6 +6,10 @@
 
 #include "iree/tools/utils/vm_util.h"
 
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/vmvx/registration/driver_module.h"
@@ -95,5 +99,53 @@ TEST_F(VmUtilTest, ParsePrintMultipleBufferViews) {
                           buf_string2 + "\n");
 }
 
+TEST_F(VmUtilTest, PrintBufferViewToFile) {
+  std::string buf_string = "2x3xf32=[1 2 3][4 5 6]";
+  vm::ref<iree_vm_list_t> variant_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{buf_string, "7"}, &variant_list));
+  FILE* file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  IREE_ASSERT_OK(PrintVariantList(variant_list.get(), 1024, file));
+  std::string contents(ftell(file), '\0');
+  rewind(file);
+  ASSERT_EQ(fread(&contents[0], 1, contents.size(), file), contents.size());
+  fclose(file);
+  EXPECT_EQ(contents, std::string("result[0]: hal.buffer_view\n") +
+                          buf_string + "\nresult[1]: i32=7\n");
+}
+
+TEST_F(VmUtilTest, WriteParseNpyBufferView) {
+  const char* tmpdir = getenv("TEST_TMPDIR");
+  if (!tmpdir) tmpdir = getenv("TMPDIR");
+  if (!tmpdir) tmpdir = ".";
+  std::string path = std::string(tmpdir) + "/iree_vm_util_test.npy";
+
+  std::string buf_string = "2x3xi16=[1 -2 3][4 5 -6]";
+  vm::ref<iree_vm_list_t> output_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{"1", buf_string}, &output_list));
+  IREE_ASSERT_OK(WriteVariantList(output_list.get(),
+                                  std::vector<std::string>{"", "@" + path}));
+
+  vm::ref<iree_vm_list_t> input_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{"@" + path}, &input_list));
+  std::stringstream os;
+  IREE_ASSERT_OK(PrintVariantList(input_list.get(), &os));
+  EXPECT_EQ(os.str(),
+            std::string("result[0]: hal.buffer_view\n") + buf_string + "\n");
+  remove(path.c_str());
+}
+
+TEST_F(VmUtilTest, WriteNpyNonBufferView) {
+  vm::ref<iree_vm_list_t> output_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{"1"}, &output_list));
+  Status status = WriteVariantList(output_list.get(),
+                                   std::vector<std::string>{"@unused.npy"});
+  EXPECT_EQ(status.code(), StatusCode::kInvalidArgument);
+}
+
 }  // namespace
 }  // namespace iree
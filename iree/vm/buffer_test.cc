@@ -7,13 +7,19 @@
 #include "iree/vm/buffer.h"
 
 #include <cstddef>
+#include <cstring>
 
 #include "iree/base/api.h"
 #include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
 #include "iree/vm/builtin_types.h"
 
 namespace {
 
+using ::iree::Status;
+using ::iree::StatusCode;
+using ::iree::testing::status::StatusIs;
+
 class VMBufferTest : public ::testing::Test {
  protected:
   static void SetUpTestSuite() {
@@ -48,4 +54,55 @@ TEST_F(VMBufferTest, Initialize) {
   ASSERT_TRUE(did_free);
 }
 
+// Tests filling with patterns of each supported element length, including
+// element counts that are not a power of two.
+TEST_F(VMBufferTest, FillElements) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_vm_buffer_create(IREE_VM_BUFFER_ACCESS_MUTABLE, 64,
+                                       iree_allocator_system(), &buffer));
+  uint8_t* data = buffer->data.data;
+
+  const uint8_t value_i8 = 0xAB;
+  IREE_ASSERT_OK(iree_vm_buffer_fill_elements(buffer, 0, 64, 1, &value_i8));
+  for (int i = 0; i < 64; ++i) EXPECT_EQ(data[i], 0xAB);
+
+  const uint16_t value_i16 = 0x1234;
+  IREE_ASSERT_OK(iree_vm_buffer_fill_elements(buffer, 2, 5, 2, &value_i16));
+  EXPECT_EQ(data[0], 0xAB);
+  EXPECT_EQ(data[1], 0xAB);
+  for (int i = 0; i < 5; ++i) {
+    uint16_t element = 0;
+    memcpy(&element, data + 2 + i * 2, sizeof(element));
+    EXPECT_EQ(element, value_i16);
+  }
+  EXPECT_EQ(data[12], 0xAB);
+
+  const uint32_t value_i32 = 0xDEADBEEFu;
+  IREE_ASSERT_OK(iree_vm_buffer_fill_elements(buffer, 4, 11, 4, &value_i32));
+  for (int i = 0; i < 11; ++i) {
+    uint32_t element = 0;
+    memcpy(&element, data + 4 + i * 4, sizeof(element));
+    EXPECT_EQ(element, value_i32);
+  }
+  EXPECT_EQ(data[48], 0xAB);
+
+  const uint64_t value_i64 = 0;
+  IREE_ASSERT_OK(iree_vm_buffer_fill_elements(buffer, 0, 8, 8, &value_i64));
+  for (int i = 0; i < 64; ++i) EXPECT_EQ(data[i], 0);
+
+  iree_vm_buffer_release(buffer);
+}
+
+TEST_F(VMBufferTest, FillElementsOutOfRange) {
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_vm_buffer_create(IREE_VM_BUFFER_ACCESS_MUTABLE, 16,
+                                       iree_allocator_system(), &buffer));
+  const uint32_t value = 1;
+  EXPECT_THAT(Status(iree_vm_buffer_fill_elements(buffer, 8, 4, 4, &value)),
+              StatusIs(StatusCode::kOutOfRange));
+  EXPECT_THAT(Status(iree_vm_buffer_fill_elements(buffer, 0, 4, 3, &value)),
+              StatusIs(StatusCode::kInvalidArgument));
+  iree_vm_buffer_release(buffer);
+}
+
 }  // namespace
@@ -310,6 +310,33 @@ static iree_status_t iree_vm_bytecode_disasm_emit_remap_list(
     break;                                                             \
   }
 
+#define DISASM_OP_CORE_COND_BRANCH_CMP_I32(op_name, op_mnemonic)            \
+  DISASM_OP(CORE, op_name) {                                                \
+    uint16_t lhs_reg = VM_ParseOperandRegI32("lhs");                        \
+    uint16_t rhs_reg = VM_ParseOperandRegI32("rhs");                        \
+    int32_t true_block_pc = VM_ParseBranchTarget("true_dest");              \
+    const iree_vm_register_remap_list_t* true_remap_list =                  \
+        VM_ParseBranchOperands("true_operands");                            \
+    int32_t false_block_pc = VM_ParseBranchTarget("false_dest");            \
+    const iree_vm_register_remap_list_t* false_remap_list =                 \
+        VM_ParseBranchOperands("false_operands");                           \
+    IREE_RETURN_IF_ERROR(                                                   \
+        iree_string_builder_append_format(b, "%s ", op_mnemonic));          \
+    EMIT_I32_REG_NAME(lhs_reg);                                             \
+    EMIT_OPTIONAL_VALUE_I32(regs->i32[lhs_reg]);                            \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", "));      \
+    EMIT_I32_REG_NAME(rhs_reg);                                             \
+    EMIT_OPTIONAL_VALUE_I32(regs->i32[rhs_reg]);                            \
+    IREE_RETURN_IF_ERROR(                                                   \
+        iree_string_builder_append_format(b, ", ^%08X(", true_block_pc));   \
+    EMIT_REMAP_LIST(true_remap_list);                                       \
+    IREE_RETURN_IF_ERROR(                                                   \
+        iree_string_builder_append_format(b, "), ^%08X(", false_block_pc)); \
+    EMIT_REMAP_LIST(false_remap_list);                                      \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ")"));       \
+    break;                                                                  \
+  }
+
 #define DISASM_OP_EXT_I64_UNARY_I64(op_name, op_mnemonic)             \
   DISASM_OP(EXT_I64, op_name) {                                       \
     uint16_t operand_reg = VM_ParseOperandRegI64("operand");          \
@@ -1256,6 +1283,15 @@ iree_status_t iree_vm_bytecode_disasm_op(
       break;
     }
 
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpEQI32,
+                                       "vm.cond_br.cmp.eq.i32");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpNEI32,
+                                       "vm.cond_br.cmp.ne.i32");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32S,
+                                       "vm.cond_br.cmp.lt.i32.s");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32U,
+                                       "vm.cond_br.cmp.lt.i32.u");
+
     DISASM_OP(CORE, Call) {
       int32_t function_ordinal = VM_ParseFuncAttr("callee");
       const iree_vm_register_list_t* src_reg_list =
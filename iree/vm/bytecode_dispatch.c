@@ -27,21 +27,24 @@
 // This assumes that the remapping list is properly ordered such that there are
 // no swapping hazards (such as 0->1,1->0). The register allocator in the
 // compiler should ensure this is the case when it can occur.
+//
+// The list is partitioned with all i32 pairs preceding all ref pairs so that
+// each bank can be remapped in a loop without per-pair type checks.
 static void iree_vm_bytecode_dispatch_remap_branch_registers(
     const iree_vm_registers_t regs,
     const iree_vm_register_remap_list_t* IREE_RESTRICT remap_list) {
-  for (int i = 0; i < remap_list->size; ++i) {
-    // TODO(benvanik): change encoding to avoid this branching.
-    // Could write two arrays: one for prims and one for refs.
+  const uint16_t i32_size = remap_list->i32_size;
+  for (uint16_t i = 0; i < i32_size; ++i) {
     uint16_t src_reg = remap_list->pairs[i].src_reg;
     uint16_t dst_reg = remap_list->pairs[i].dst_reg;
-    if (src_reg & IREE_REF_REGISTER_TYPE_BIT) {
-      iree_vm_ref_retain_or_move(src_reg & IREE_REF_REGISTER_MOVE_BIT,
-                                 &regs.ref[src_reg & regs.ref_mask],
-                                 &regs.ref[dst_reg & regs.ref_mask]);
-    } else {
-      regs.i32[dst_reg & regs.i32_mask] = regs.i32[src_reg & regs.i32_mask];
-    }
+    regs.i32[dst_reg & regs.i32_mask] = regs.i32[src_reg & regs.i32_mask];
+  }
+  for (uint16_t i = i32_size; i < remap_list->size; ++i) {
+    uint16_t src_reg = remap_list->pairs[i].src_reg;
+    uint16_t dst_reg = remap_list->pairs[i].dst_reg;
+    iree_vm_ref_retain_or_move_inline(src_reg & IREE_REF_REGISTER_MOVE_BIT,
+                                      &regs.ref[src_reg & regs.ref_mask],
+                                      &regs.ref[dst_reg & regs.ref_mask]);
   }
 }
 
@@ -56,11 +59,112 @@ static void iree_vm_bytecode_dispatch_discard_registers(
     uint16_t reg = reg_list->registers[i];
     if ((reg & (IREE_REF_REGISTER_TYPE_BIT | IREE_REF_REGISTER_MOVE_BIT)) ==
         (IREE_REF_REGISTER_TYPE_BIT | IREE_REF_REGISTER_MOVE_BIT)) {
-      iree_vm_ref_release(&regs.ref[reg & regs.ref_mask]);
+      iree_vm_ref_release_inline(&regs.ref[reg & regs.ref_mask]);
     }
   }
 }
 
+//===----------------------------------------------------------------------===//
+// Buffer element access
+//===----------------------------------------------------------------------===//
+// The vm.buffer.load/store/fill ops encode the element length (and for loads
+// the extension mode) in the low bits of their opcodes so that all widths can
+// share a single handler. Single element loads and stores are hot in buffer
+// heavy code and are performed inline with one combined bounds check instead
+// of going through the generic iree_vm_buffer_*_elements routines.
+// See VMOpcodesCore.td for more information on the encoding.
+
+// Returns the byte length of the element accessed by a buffer opcode.
+#define IREE_VM_BUFFER_OPCODE_ELEMENT_LENGTH(opcode) \
+  ((iree_host_size_t)((opcode)&0x3) + 1)
+// Returns true if a buffer load opcode sign-extends the loaded element.
+#define IREE_VM_BUFFER_OPCODE_IS_SIGNED(opcode) (((opcode)&0x4) != 0)
+
+// Returns a pointer to the low |element_length| bytes of the i32 |value| in
+// host byte order.
+static inline const void* iree_vm_bytecode_buffer_value_ptr(
+    const uint32_t* value, iree_host_size_t element_length) {
+#if defined(IREE_ENDIANNESS_BIG)
+  return (const uint8_t*)value + (sizeof(*value) - element_length);
+#else
+  (void)element_length;
+  return value;
+#endif  // IREE_ENDIANNESS_BIG
+}
+
+// Maps the element accessed by a buffer |opcode| at |offset| in |buffer|.
+// Matches the iree_vm_buffer_t mapping behavior by rounding |offset| down to
+// the natural alignment of the element.
+static inline iree_status_t iree_vm_bytecode_buffer_map_element(
+    const iree_vm_buffer_t* buffer, uint32_t offset,
+    iree_host_size_t element_length, uint8_t** out_ptr) {
+  const iree_host_size_t aligned_offset =
+      (iree_host_size_t)offset & ~(element_length - 1);
+  if (IREE_UNLIKELY(aligned_offset + element_length >
+                    buffer->data.data_length)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "out-of-bounds access detected (offset=%zu, "
+                            "length=%zu, buffer length=%zu)",
+                            aligned_offset, element_length,
+                            buffer->data.data_length);
+  }
+  *out_ptr = buffer->data.data + aligned_offset;
+  return iree_ok_status();
+}
+
+// Loads the element described by the buffer load |opcode| and zero or sign
+// extends it to i32.
+static inline iree_status_t iree_vm_bytecode_buffer_load(
+    const iree_vm_buffer_t* buffer, uint32_t offset, uint8_t opcode,
+    uint32_t* out_value) {
+  uint8_t* ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_buffer_map_element(
+      buffer, offset, IREE_VM_BUFFER_OPCODE_ELEMENT_LENGTH(opcode), &ptr));
+  const bool is_signed = IREE_VM_BUFFER_OPCODE_IS_SIGNED(opcode);
+  switch (IREE_VM_BUFFER_OPCODE_ELEMENT_LENGTH(opcode)) {
+    case 1:
+      *out_value = is_signed ? vm_ext_i8i32s(*(const int8_t*)ptr)
+                             : vm_ext_i8i32u(*(const uint8_t*)ptr);
+      break;
+    case 2:
+      *out_value = is_signed ? vm_ext_i16i32s(*(const int16_t*)ptr)
+                             : vm_ext_i16i32u(*(const uint16_t*)ptr);
+      break;
+    default:
+      *out_value = *(const uint32_t*)ptr;
+      break;
+  }
+  return iree_ok_status();
+}
+
+// Stores the low bytes of |value| as the element described by the buffer
+// store |opcode|.
+static inline iree_status_t iree_vm_bytecode_buffer_store(
+    const iree_vm_buffer_t* buffer, uint32_t offset, uint8_t opcode,
+    uint32_t value) {
+  if (IREE_UNLIKELY(
+          !iree_all_bits_set(buffer->access, IREE_VM_BUFFER_ACCESS_MUTABLE))) {
+    return iree_make_status(
+        IREE_STATUS_PERMISSION_DENIED,
+        "buffer is read-only and cannot be mapped for mutation");
+  }
+  uint8_t* ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_buffer_map_element(
+      buffer, offset, IREE_VM_BUFFER_OPCODE_ELEMENT_LENGTH(opcode), &ptr));
+  switch (IREE_VM_BUFFER_OPCODE_ELEMENT_LENGTH(opcode)) {
+    case 1:
+      *(uint8_t*)ptr = (uint8_t)value;
+      break;
+    case 2:
+      *(uint16_t*)ptr = (uint16_t)value;
+      break;
+    default:
+      *(uint32_t*)ptr = value;
+      break;
+  }
+  return iree_ok_status();
+}
+
 //===----------------------------------------------------------------------===//
 // Stack management
 //===----------------------------------------------------------------------===//
@@ -97,7 +201,7 @@ static void iree_vm_bytecode_stack_frame_cleanup(iree_vm_stack_frame_t* frame) {
   // no more live registers.
   for (uint16_t i = 0; i <= regs.ref_mask; ++i) {
     iree_vm_ref_t* ref = &regs.ref[i];
-    if (ref->ptr) iree_vm_ref_release(ref);
+    if (ref->ptr) iree_vm_ref_release_inline(ref);
   }
 }
 
@@ -164,6 +268,7 @@ static iree_status_t iree_vm_bytecode_function_enter(
   stack_storage->ref_register_count = ref_register_count;
   stack_storage->i32_register_offset = header_size;
   stack_storage->ref_register_offset = header_size + i32_register_size;
+  stack_storage->returns_to_external = false;
   *out_callee_registers =
       iree_vm_bytecode_get_register_storage(*out_callee_frame);
 
@@ -173,19 +278,28 @@ static iree_status_t iree_vm_bytecode_function_enter(
 // Enters an internal bytecode stack frame from an external caller.
 // A new |out_callee_frame| will be pushed to the stack with storage space for
 // the registers used by the function and |arguments| will be marshaled into the
-// ABI-defined registers.
+// ABI-defined registers. |results| will be populated when the frame returns.
 //
 // Note that callers are expected to have matched our expectations for
 // |arguments| and we don't validate that here.
 static iree_status_t iree_vm_bytecode_external_enter(
     iree_vm_stack_t* stack, const iree_vm_function_t function,
     iree_string_view_t cconv_arguments, iree_byte_span_t arguments,
+    iree_string_view_t cconv_results, iree_byte_span_t results,
     iree_vm_stack_frame_t** out_callee_frame,
     iree_vm_registers_t* out_callee_registers) {
   // Enter the bytecode function and allocate registers.
   IREE_RETURN_IF_ERROR(iree_vm_bytecode_function_enter(
       stack, function, out_callee_frame, out_callee_registers));
 
+  // Stash where results go when the function returns (possibly after yields).
+  iree_vm_bytecode_frame_storage_t* stack_storage =
+      (iree_vm_bytecode_frame_storage_t*)iree_vm_stack_frame_storage(
+          *out_callee_frame);
+  stack_storage->returns_to_external = true;
+  stack_storage->external_cconv_results = cconv_results;
+  stack_storage->external_results = results;
+
   // Marshal arguments from the ABI format to the VM registers.
   iree_vm_registers_t callee_registers = *out_callee_registers;
   uint16_t i32_reg = 0;
@@ -212,7 +326,7 @@ static iree_status_t iree_vm_bytecode_external_enter(
       } break;
       case IREE_VM_CCONV_TYPE_REF: {
         uint16_t dst_reg = ref_reg++;
-        iree_vm_ref_move(
+        iree_vm_ref_move_inline(
             (iree_vm_ref_t*)p,
             &callee_registers.ref[dst_reg & callee_registers.ref_mask]);
         p += sizeof(iree_vm_ref_t);
@@ -224,15 +338,21 @@ static iree_status_t iree_vm_bytecode_external_enter(
 }
 
 // Leaves an internal bytecode stack frame and returns to an external caller.
-// Registers will be marshaled from the |src_reg_list| to the |results| buffer.
+// Registers will be marshaled from the |src_reg_list| to the results buffer
+// provided when the frame was entered.
 //
 // Note that callers are expected to have matched our expectations for
 // |results| and we don't validate that here.
 static iree_status_t iree_vm_bytecode_external_leave(
     iree_vm_stack_t* stack, iree_vm_stack_frame_t* callee_frame,
     const iree_vm_registers_t* IREE_RESTRICT callee_registers,
-    const iree_vm_register_list_t* IREE_RESTRICT src_reg_list,
-    iree_string_view_t cconv_results, iree_byte_span_t results) {
+    const iree_vm_register_list_t* IREE_RESTRICT src_reg_list) {
+  iree_vm_bytecode_frame_storage_t* stack_storage =
+      (iree_vm_bytecode_frame_storage_t*)iree_vm_stack_frame_storage(
+          callee_frame);
+  iree_string_view_t cconv_results = stack_storage->external_cconv_results;
+  iree_byte_span_t results = stack_storage->external_results;
+
   // Marshal results from registers to the ABI results buffer.
   uint8_t* p = results.data;
   for (iree_host_size_t i = 0; i < cconv_results.size; ++i) {
@@ -255,7 +375,7 @@ static iree_status_t iree_vm_bytecode_external_leave(
         p += sizeof(int64_t);
       } break;
       case IREE_VM_CCONV_TYPE_REF: {
-        iree_vm_ref_retain_or_move(
+        iree_vm_ref_retain_or_move_inline(
             src_reg & IREE_REF_REGISTER_MOVE_BIT,
             &callee_registers->ref[src_reg & callee_registers->ref_mask],
             (iree_vm_ref_t*)p);
@@ -310,9 +430,10 @@ static iree_status_t iree_vm_bytecode_internal_enter(
       uint16_t dst_reg = ref_reg_offset++;
       memset(&dst_regs->ref[dst_reg & dst_regs->ref_mask], 0,
              sizeof(iree_vm_ref_t));
-      iree_vm_ref_retain_or_move(src_reg & IREE_REF_REGISTER_MOVE_BIT,
-                                 &src_regs.ref[src_reg & src_regs.ref_mask],
-                                 &dst_regs->ref[dst_reg & dst_regs->ref_mask]);
+      iree_vm_ref_retain_or_move_inline(
+          src_reg & IREE_REF_REGISTER_MOVE_BIT,
+          &src_regs.ref[src_reg & src_regs.ref_mask],
+          &dst_regs->ref[dst_reg & dst_regs->ref_mask]);
     } else {
       uint16_t dst_reg = i32_reg_offset++;
       dst_regs->i32[dst_reg & dst_regs->i32_mask] =
@@ -356,7 +477,7 @@ static iree_status_t iree_vm_bytecode_internal_leave(
     uint16_t src_reg = src_reg_list->registers[i];
     uint16_t dst_reg = dst_reg_list->registers[i];
     if (src_reg & IREE_REF_REGISTER_TYPE_BIT) {
-      iree_vm_ref_retain_or_move(
+      iree_vm_ref_retain_or_move_inline(
           src_reg & IREE_REF_REGISTER_MOVE_BIT,
           &callee_registers.ref[src_reg & callee_registers.ref_mask],
           &caller_registers.ref[dst_reg & caller_registers.ref_mask]);
@@ -402,7 +523,7 @@ static void iree_vm_bytecode_populate_import_cconv_arguments(
       } break;
       case IREE_VM_CCONV_TYPE_REF: {
         uint16_t src_reg = src_reg_list->registers[reg_i++];
-        iree_vm_ref_assign(
+        iree_vm_ref_assign_inline(
             &caller_registers.ref[src_reg & caller_registers.ref_mask],
             (iree_vm_ref_t*)p);
         p += sizeof(iree_vm_ref_t);
@@ -448,7 +569,7 @@ static void iree_vm_bytecode_populate_import_cconv_arguments(
               } break;
               case IREE_VM_CCONV_TYPE_REF: {
                 uint16_t src_reg = src_reg_list->registers[reg_i++];
-                iree_vm_ref_assign(
+                iree_vm_ref_assign_inline(
                     &caller_registers.ref[src_reg & caller_registers.ref_mask],
                     (iree_vm_ref_t*)p);
                 p += sizeof(iree_vm_ref_t);
@@ -508,7 +629,7 @@ static iree_status_t iree_vm_bytecode_issue_import_call(
         p += sizeof(int64_t);
         break;
       case IREE_VM_CCONV_TYPE_REF:
-        iree_vm_ref_move(
+        iree_vm_ref_move_inline(
             (iree_vm_ref_t*)p,
             &caller_registers.ref[dst_reg & caller_registers.ref_mask]);
         p += sizeof(iree_vm_ref_t);
@@ -519,6 +640,65 @@ static iree_status_t iree_vm_bytecode_issue_import_call(
   return iree_ok_status();
 }
 
+// Calls an imported function through its direct entry point.
+// Registers in |src_reg_list| are copied into argument slots and the result
+// slots into |dst_reg_list| without a callee stack frame. Because the caller
+// frame is unchanged the caller registers remain valid across the call. The
+// callee module state was resolved when the import was linked.
+static iree_status_t iree_vm_bytecode_call_import_direct(
+    const iree_vm_bytecode_import_t* import,
+    const iree_vm_registers_t caller_registers,
+    const iree_vm_register_list_t* IREE_RESTRICT src_reg_list,
+    const iree_vm_register_list_t* IREE_RESTRICT dst_reg_list) {
+  // Import cconv fragments were verified to be primitive-only and within
+  // IREE_VM_DIRECT_CALL_MAX_VALUES when the direct entry point was resolved.
+  uint64_t arguments[IREE_VM_DIRECT_CALL_MAX_VALUES];
+  uint64_t results[IREE_VM_DIRECT_CALL_MAX_VALUES];
+  for (iree_host_size_t i = 0;
+       i < import->arguments.size && i < src_reg_list->size; ++i) {
+    uint16_t src_reg = src_reg_list->registers[i];
+    switch (import->arguments.data[i]) {
+      case IREE_VM_CCONV_TYPE_I32:
+      case IREE_VM_CCONV_TYPE_F32:
+        memcpy(&arguments[i],
+               &caller_registers.i32[src_reg & caller_registers.i32_mask],
+               sizeof(int32_t));
+        break;
+      default:
+        memcpy(
+            &arguments[i],
+            &caller_registers.i32[src_reg & (caller_registers.i32_mask & ~1)],
+            sizeof(int64_t));
+        break;
+    }
+  }
+
+  iree_status_t call_status = import->direct.call(
+      import->direct.function_data, import->module_state, arguments, results);
+  if (IREE_UNLIKELY(!iree_status_is_ok(call_status))) {
+    return iree_status_annotate(call_status,
+                                iree_make_cstring_view("while calling import"));
+  }
+
+  for (iree_host_size_t i = 0;
+       i < import->results.size && i < dst_reg_list->size; ++i) {
+    uint16_t dst_reg = dst_reg_list->registers[i];
+    switch (import->results.data[i]) {
+      case IREE_VM_CCONV_TYPE_I32:
+      case IREE_VM_CCONV_TYPE_F32:
+        memcpy(&caller_registers.i32[dst_reg & caller_registers.i32_mask],
+               &results[i], sizeof(int32_t));
+        break;
+      default:
+        memcpy(
+            &caller_registers.i32[dst_reg & (caller_registers.i32_mask & ~1)],
+            &results[i], sizeof(int64_t));
+        break;
+    }
+  }
+  return iree_ok_status();
+}
+
 // Calls an imported function from another module.
 // Marshals the |src_reg_list| registers into ABI storage and results into
 // |dst_reg_list|.
@@ -538,6 +718,10 @@ static iree_status_t iree_vm_bytecode_call_import(
   }
   const iree_vm_bytecode_import_t* import =
       &module_state->import_table[import_ordinal];
+  if (import->direct.call) {
+    return iree_vm_bytecode_call_import_direct(import, caller_registers,
+                                               src_reg_list, dst_reg_list);
+  }
   iree_vm_function_call_t call;
   memset(&call, 0, sizeof(call));
   call.function = import->function;
@@ -604,29 +788,63 @@ static iree_status_t iree_vm_bytecode_call_import_variadic(
                                             out_caller_registers, out_result);
 }
 
+//===----------------------------------------------------------------------===//
+// Execution profiling
+//===----------------------------------------------------------------------===//
+
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+
+// Returns the profile of the bytecode function executing in |frame|.
+static inline iree_vm_bytecode_function_profile_t*
+iree_vm_bytecode_frame_profile(const iree_vm_stack_frame_t* frame) {
+  iree_vm_bytecode_module_state_t* module_state =
+      (iree_vm_bytecode_module_state_t*)frame->module_state;
+  return &module_state->function_profiles[frame->function.ordinal];
+}
+
+// Charges the instructions executed and host time elapsed since the last
+// profiling point to the function executing in |frame|.
+static void iree_vm_bytecode_profile_charge(
+    const iree_vm_stack_frame_t* frame, uint64_t* inout_instruction_count,
+    iree_time_t* inout_timestamp) {
+  iree_time_t now = iree_time_now();
+  iree_vm_bytecode_function_profile_t* profile =
+      iree_vm_bytecode_frame_profile(frame);
+  profile->instruction_count += *inout_instruction_count;
+  profile->self_time_ns += now - *inout_timestamp;
+  *inout_instruction_count = 0;
+  *inout_timestamp = now;
+}
+
+#define IREE_DISPATCH_PROFILE_CHARGE()                                  \
+  if (IREE_UNLIKELY(is_profiling)) {                                    \
+    iree_vm_bytecode_profile_charge(                                    \
+        current_frame, &profile_instruction_count, &profile_timestamp); \
+  }
+#define IREE_DISPATCH_PROFILE_ENTER()                            \
+  if (IREE_UNLIKELY(is_profiling)) {                             \
+    ++iree_vm_bytecode_frame_profile(current_frame)->call_count; \
+  }
+
+#else
+#define IREE_DISPATCH_PROFILE_CHARGE()
+#define IREE_DISPATCH_PROFILE_ENTER()
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+
 //===----------------------------------------------------------------------===//
 // Main interpreter dispatch routine
 //===----------------------------------------------------------------------===//
 
-iree_status_t iree_vm_bytecode_dispatch(
+// Executes bytecode starting at the current pc of |current_frame| until the
+// outermost frame entered by an external caller returns or execution yields.
+static iree_status_t iree_vm_bytecode_execute(
     iree_vm_stack_t* stack, iree_vm_bytecode_module_t* module,
-    const iree_vm_function_call_t* call, iree_string_view_t cconv_arguments,
-    iree_string_view_t cconv_results, iree_vm_execution_result_t* out_result) {
-  memset(out_result, 0, sizeof(*out_result));
-
+    iree_vm_stack_frame_t* current_frame, iree_vm_registers_t regs,
+    iree_vm_execution_result_t* out_result) {
   // When required emit the dispatch tables here referencing the labels we are
   // defining below.
   DEFINE_DISPATCH_TABLES();
 
-  // Enter function (as this is the initial call).
-  // The callee's return will take care of storing the output registers when it
-  // actually does return, either immediately or in the future via a resume.
-  iree_vm_stack_frame_t* current_frame = NULL;
-  iree_vm_registers_t regs;
-  IREE_RETURN_IF_ERROR(
-      iree_vm_bytecode_external_enter(stack, call->function, cconv_arguments,
-                                      call->arguments, &current_frame, &regs));
-
   // Primary dispatch state. This is our 'native stack frame' and really
   // just enough to make dereferencing common addresses (like the current
   // offset) faster. You can think of this like CPU state (like PC).
@@ -641,7 +859,15 @@ iree_status_t iree_vm_bytecode_dispatch(
       module->function_descriptor_table[current_frame->function.ordinal]
           .bytecode_offset;
   iree_vm_source_offset_t pc = current_frame->pc;
-  const int32_t entry_frame_depth = current_frame->depth;
+
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  // Instructions and time not yet charged to the current function. Nothing is
+  // recorded on failure as the invocation is aborted anyway.
+  const bool is_profiling = (iree_vm_stack_invocation_flags(stack) &
+                             IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION) != 0;
+  uint64_t profile_instruction_count = 0;
+  iree_time_t profile_timestamp = is_profiling ? iree_time_now() : 0;
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
 
   BEGIN_DISPATCH_CORE() {
     //===------------------------------------------------------------------===//
@@ -650,8 +876,8 @@ iree_status_t iree_vm_bytecode_dispatch(
 
     DISPATCH_OP(CORE, GlobalLoadI32, {
       uint32_t byte_offset = VM_DecGlobalAttr("global");
-      if (IREE_UNLIKELY(byte_offset >=
-                        module_state->rwdata_storage.data_length)) {
+      if (IREE_UNLIKELY(VM_UNVERIFIED(
+              byte_offset >= module_state->rwdata_storage.data_length))) {
         return iree_make_status(
             IREE_STATUS_OUT_OF_RANGE,
             "global byte_offset out of range: %d (rwdata=%zu)", byte_offset,
@@ -665,8 +891,8 @@ iree_status_t iree_vm_bytecode_dispatch(
 
     DISPATCH_OP(CORE, GlobalStoreI32, {
       uint32_t byte_offset = VM_DecGlobalAttr("global");
-      if (IREE_UNLIKELY(byte_offset >=
-                        module_state->rwdata_storage.data_length)) {
+      if (IREE_UNLIKELY(VM_UNVERIFIED(
+              byte_offset >= module_state->rwdata_storage.data_length))) {
         return iree_make_status(
             IREE_STATUS_OUT_OF_RANGE,
             "global byte_offset out of range: %d (rwdata=%zu)", byte_offset,
@@ -708,7 +934,8 @@ iree_status_t iree_vm_bytecode_dispatch(
 
     DISPATCH_OP(CORE, GlobalLoadRef, {
       uint32_t global = VM_DecGlobalAttr("global");
-      if (IREE_UNLIKELY(global >= module_state->global_ref_count)) {
+      if (IREE_UNLIKELY(VM_UNVERIFIED(
+              global >= module_state->global_ref_count))) {
         return iree_make_status(
             IREE_STATUS_OUT_OF_RANGE,
             "global ref ordinal out of range: %d (table=%zu)", global,
@@ -724,7 +951,8 @@ iree_status_t iree_vm_bytecode_dispatch(
 
     DISPATCH_OP(CORE, GlobalStoreRef, {
       uint32_t global = VM_DecGlobalAttr("global");
-      if (IREE_UNLIKELY(global >= module_state->global_ref_count)) {
+      if (IREE_UNLIKELY(VM_UNVERIFIED(
+              global >= module_state->global_ref_count))) {
         return iree_make_status(
             IREE_STATUS_OUT_OF_RANGE,
             "global ref ordinal out of range: %d (table=%zu)", global,
@@ -788,12 +1016,13 @@ iree_status_t iree_vm_bytecode_dispatch(
     DISPATCH_OP(CORE, ConstRefZero, {
       bool result_is_move;
       iree_vm_ref_t* result = VM_DecResultRegRef("result", &result_is_move);
-      iree_vm_ref_release(result);
+      iree_vm_ref_release_inline(result);
     });
 
     DISPATCH_OP(CORE, ConstRefRodata, {
       uint32_t rodata_ordinal = VM_DecRodataAttr("rodata");
-      if (IREE_UNLIKELY(rodata_ordinal >= module_state->rodata_ref_count)) {
+      if (IREE_UNLIKELY(VM_UNVERIFIED(
+              rodata_ordinal >= module_state->rodata_ref_count))) {
         return iree_make_status(
             IREE_STATUS_OUT_OF_RANGE,
             "rodata ref ordinal out of range: %d (table=%zu)", rodata_ordinal,
@@ -907,39 +1136,15 @@ iree_status_t iree_vm_bytecode_dispatch(
       *result_ptr = result ? 1 : 0;
     });
 
-    // TODO(benvanik): rework dispatch so that the FillI* ops can share the same
-    // body - they all only vary by the length passed to fill_elements. The
-    // gotcha is that on big-endian machines we'd have to flip around the bytes.
+    // All BufferFillI* ops share the same body and only vary by the element
+    // length encoded in the low bits of the opcode.
     // See VMOpcodesCore.td for more information on the encoding.
-    DISPATCH_OP(CORE, BufferFillI8, {
-      bool buffer_is_move;
-      iree_vm_ref_t* buffer_ref =
-          VM_DecOperandRegRef("target_buffer", &buffer_is_move);
-      iree_vm_buffer_t* buffer = iree_vm_buffer_deref(*buffer_ref);
-      if (IREE_UNLIKELY(!buffer)) {
-        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "buffer is null");
-      }
-      uint32_t offset = VM_DecOperandRegI32("target_offset");
-      uint32_t length = VM_DecOperandRegI32("length");
-      uint8_t value = (uint8_t)VM_DecOperandRegI32("value");
-      IREE_RETURN_IF_ERROR(iree_vm_buffer_fill_elements(
-          buffer, offset, length / sizeof(uint8_t), sizeof(uint8_t), &value));
-    });
-    DISPATCH_OP(CORE, BufferFillI16, {
-      bool buffer_is_move;
-      iree_vm_ref_t* buffer_ref =
-          VM_DecOperandRegRef("target_buffer", &buffer_is_move);
-      iree_vm_buffer_t* buffer = iree_vm_buffer_deref(*buffer_ref);
-      if (IREE_UNLIKELY(!buffer)) {
-        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "buffer is null");
-      }
-      uint32_t offset = VM_DecOperandRegI32("target_offset");
-      uint32_t length = VM_DecOperandRegI32("length");
-      uint16_t value = (uint16_t)VM_DecOperandRegI32("value");
-      IREE_RETURN_IF_ERROR(iree_vm_buffer_fill_elements(
-          buffer, offset, length / sizeof(uint16_t), sizeof(uint16_t), &value));
-    });
+    DISPATCH_OP_SHARED(CORE, BufferFillI8)
+    DISPATCH_OP_SHARED(CORE, BufferFillI16)
     DISPATCH_OP(CORE, BufferFillI32, {
+      const iree_host_size_t element_length =
+          IREE_VM_BUFFER_OPCODE_ELEMENT_LENGTH(
+              bytecode_data[pc - VM_PC_OFFSET_CORE]);
       bool buffer_is_move;
       iree_vm_ref_t* buffer_ref =
           VM_DecOperandRegRef("target_buffer", &buffer_is_move);
@@ -951,78 +1156,19 @@ iree_status_t iree_vm_bytecode_dispatch(
       uint32_t length = VM_DecOperandRegI32("length");
       uint32_t value = VM_DecOperandRegI32("value");
       IREE_RETURN_IF_ERROR(iree_vm_buffer_fill_elements(
-          buffer, offset, length / sizeof(uint32_t), sizeof(uint32_t), &value));
+          buffer, offset, length / element_length, element_length,
+          iree_vm_bytecode_buffer_value_ptr(&value, element_length)));
     });
 
-    // TODO(benvanik): rework dispatch so that the LoadI* ops can share the same
-    // body - they only vary on the length and sign/zero extension mode but
-    // can be packed into a single handler to reduce code-size.
-    // See VMOpcodesCore.td for more information on the encoding.
-    DISPATCH_OP(CORE, BufferLoadI8U, {
-      bool buffer_is_move;
-      iree_vm_ref_t* buffer_ref =
-          VM_DecOperandRegRef("source_buffer", &buffer_is_move);
-      iree_vm_buffer_t* buffer = iree_vm_buffer_deref(*buffer_ref);
-      if (IREE_UNLIKELY(!buffer)) {
-        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
-                                "source_buffer is null");
-      }
-      uint32_t offset = VM_DecOperandRegI32("source_offset");
-      uint32_t* result_ptr = VM_DecResultRegI32("result");
-      uint8_t result_x8 = 0;
-      IREE_RETURN_IF_ERROR(iree_vm_buffer_read_elements(
-          buffer, offset, &result_x8, 1, sizeof(result_x8)));
-      *result_ptr = vm_ext_i8i32u(result_x8);
-    });
-    DISPATCH_OP(CORE, BufferLoadI8S, {
-      bool buffer_is_move;
-      iree_vm_ref_t* buffer_ref =
-          VM_DecOperandRegRef("source_buffer", &buffer_is_move);
-      iree_vm_buffer_t* buffer = iree_vm_buffer_deref(*buffer_ref);
-      if (IREE_UNLIKELY(!buffer)) {
-        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
-                                "source_buffer is null");
-      }
-      uint32_t offset = VM_DecOperandRegI32("source_offset");
-      uint32_t* result_ptr = VM_DecResultRegI32("result");
-      int8_t result_x8 = 0;
-      IREE_RETURN_IF_ERROR(iree_vm_buffer_read_elements(
-          buffer, offset, &result_x8, 1, sizeof(result_x8)));
-      *result_ptr = vm_ext_i8i32s(result_x8);
-    });
-    DISPATCH_OP(CORE, BufferLoadI16U, {
-      bool buffer_is_move;
-      iree_vm_ref_t* buffer_ref =
-          VM_DecOperandRegRef("source_buffer", &buffer_is_move);
-      iree_vm_buffer_t* buffer = iree_vm_buffer_deref(*buffer_ref);
-      if (IREE_UNLIKELY(!buffer)) {
-        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
-                                "source_buffer is null");
-      }
-      uint32_t offset = VM_DecOperandRegI32("source_offset");
-      uint32_t* result_ptr = VM_DecResultRegI32("result");
-      uint16_t result_x16 = 0;
-      IREE_RETURN_IF_ERROR(iree_vm_buffer_read_elements(
-          buffer, offset, &result_x16, 1, sizeof(result_x16)));
-      *result_ptr = vm_ext_i16i32u(result_x16);
-    });
-    DISPATCH_OP(CORE, BufferLoadI16S, {
-      bool buffer_is_move;
-      iree_vm_ref_t* buffer_ref =
-          VM_DecOperandRegRef("source_buffer", &buffer_is_move);
-      iree_vm_buffer_t* buffer = iree_vm_buffer_deref(*buffer_ref);
-      if (IREE_UNLIKELY(!buffer)) {
-        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
-                                "source_buffer is null");
-      }
-      uint32_t offset = VM_DecOperandRegI32("source_offset");
-      uint32_t* result_ptr = VM_DecResultRegI32("result");
-      int16_t result_x16 = 0;
-      IREE_RETURN_IF_ERROR(iree_vm_buffer_read_elements(
-          buffer, offset, &result_x16, 1, sizeof(result_x16)));
-      *result_ptr = vm_ext_i16i32s(result_x16);
-    });
+    // All BufferLoadI* ops share the same body and only vary on the element
+    // length and sign/zero extension mode encoded in the low bits of the
+    // opcode. See VMOpcodesCore.td for more information on the encoding.
+    DISPATCH_OP_SHARED(CORE, BufferLoadI8U)
+    DISPATCH_OP_SHARED(CORE, BufferLoadI8S)
+    DISPATCH_OP_SHARED(CORE, BufferLoadI16U)
+    DISPATCH_OP_SHARED(CORE, BufferLoadI16S)
     DISPATCH_OP(CORE, BufferLoadI32, {
+      const uint8_t opcode = bytecode_data[pc - VM_PC_OFFSET_CORE];
       bool buffer_is_move;
       iree_vm_ref_t* buffer_ref =
           VM_DecOperandRegRef("source_buffer", &buffer_is_move);
@@ -1033,42 +1179,17 @@ iree_status_t iree_vm_bytecode_dispatch(
       }
       uint32_t offset = VM_DecOperandRegI32("source_offset");
       uint32_t* result = VM_DecResultRegI32("result");
-      IREE_RETURN_IF_ERROR(iree_vm_buffer_read_elements(buffer, offset, result,
-                                                        1, sizeof(*result)));
+      IREE_RETURN_IF_ERROR(
+          iree_vm_bytecode_buffer_load(buffer, offset, opcode, result));
     });
 
-    // TODO(benvanik): rework dispatch so that the StoreI* ops can share the
-    // same body - they only vary on the length.
+    // All BufferStoreI* ops share the same body and only vary on the element
+    // length encoded in the low bits of the opcode.
     // See VMOpcodesCore.td for more information on the encoding.
-    DISPATCH_OP(CORE, BufferStoreI8, {
-      bool buffer_is_move;
-      iree_vm_ref_t* buffer_ref =
-          VM_DecOperandRegRef("target_buffer", &buffer_is_move);
-      iree_vm_buffer_t* buffer = iree_vm_buffer_deref(*buffer_ref);
-      if (IREE_UNLIKELY(!buffer)) {
-        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
-                                "target_buffer is null");
-      }
-      uint32_t offset = VM_DecOperandRegI32("target_offset");
-      uint8_t value = (uint8_t)VM_DecOperandRegI32("value");
-      IREE_RETURN_IF_ERROR(iree_vm_buffer_write_elements(&value, buffer, offset,
-                                                         1, sizeof(uint8_t)));
-    });
-    DISPATCH_OP(CORE, BufferStoreI16, {
-      bool buffer_is_move;
-      iree_vm_ref_t* buffer_ref =
-          VM_DecOperandRegRef("target_buffer", &buffer_is_move);
-      iree_vm_buffer_t* buffer = iree_vm_buffer_deref(*buffer_ref);
-      if (IREE_UNLIKELY(!buffer)) {
-        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
-                                "target_buffer is null");
-      }
-      uint32_t offset = VM_DecOperandRegI32("target_offset");
-      uint16_t value = (uint16_t)VM_DecOperandRegI32("value");
-      IREE_RETURN_IF_ERROR(iree_vm_buffer_write_elements(&value, buffer, offset,
-                                                         1, sizeof(uint16_t)));
-    });
+    DISPATCH_OP_SHARED(CORE, BufferStoreI8)
+    DISPATCH_OP_SHARED(CORE, BufferStoreI16)
     DISPATCH_OP(CORE, BufferStoreI32, {
+      const uint8_t opcode = bytecode_data[pc - VM_PC_OFFSET_CORE];
       bool buffer_is_move;
       iree_vm_ref_t* buffer_ref =
           VM_DecOperandRegRef("target_buffer", &buffer_is_move);
@@ -1079,8 +1200,8 @@ iree_status_t iree_vm_bytecode_dispatch(
       }
       uint32_t offset = VM_DecOperandRegI32("target_offset");
       uint32_t value = VM_DecOperandRegI32("value");
-      IREE_RETURN_IF_ERROR(iree_vm_buffer_write_elements(&value, buffer, offset,
-                                                         1, sizeof(uint32_t)));
+      IREE_RETURN_IF_ERROR(
+          iree_vm_bytecode_buffer_store(buffer, offset, opcode, value));
     });
 
     //===------------------------------------------------------------------===//
@@ -1178,7 +1299,7 @@ iree_status_t iree_vm_bytecode_dispatch(
            result->type != type_def->ref_type)) {
         // Type mismatch; put null in the register instead.
         // TODO(benvanik): return an error here and make a query type method?
-        iree_vm_ref_release(result);
+        iree_vm_ref_release_inline(result);
       }
     });
 
@@ -1229,14 +1350,14 @@ iree_status_t iree_vm_bytecode_dispatch(
         IREE_RETURN_IF_ERROR(iree_vm_ref_retain_or_move_checked(
             true_value_is_move, true_value, type_def->ref_type, result));
         if (false_value_is_move && false_value != result) {
-          iree_vm_ref_release(false_value);
+          iree_vm_ref_release_inline(false_value);
         }
       } else {
         // Select RHS.
         IREE_RETURN_IF_ERROR(iree_vm_ref_retain_or_move_checked(
             false_value_is_move, false_value, type_def->ref_type, result));
         if (true_value_is_move && true_value != result) {
-          iree_vm_ref_release(true_value);
+          iree_vm_ref_release_inline(true_value);
         }
       }
     });
@@ -1338,8 +1459,8 @@ iree_status_t iree_vm_bytecode_dispatch(
       iree_vm_ref_t* rhs = VM_DecOperandRegRef("rhs", &rhs_is_move);
       int32_t* result = VM_DecResultRegI32("result");
       *result = vm_cmp_eq_ref(lhs, rhs);
-      if (lhs_is_move) iree_vm_ref_release(lhs);
-      if (rhs_is_move) iree_vm_ref_release(rhs);
+      if (lhs_is_move) iree_vm_ref_release_inline(lhs);
+      if (rhs_is_move) iree_vm_ref_release_inline(rhs);
     });
     DISPATCH_OP(CORE, CmpNERef, {
       bool lhs_is_move;
@@ -1348,15 +1469,15 @@ iree_status_t iree_vm_bytecode_dispatch(
       iree_vm_ref_t* rhs = VM_DecOperandRegRef("rhs", &rhs_is_move);
       int32_t* result = VM_DecResultRegI32("result");
       *result = vm_cmp_ne_ref(lhs, rhs);
-      if (lhs_is_move) iree_vm_ref_release(lhs);
-      if (rhs_is_move) iree_vm_ref_release(rhs);
+      if (lhs_is_move) iree_vm_ref_release_inline(lhs);
+      if (rhs_is_move) iree_vm_ref_release_inline(rhs);
     });
     DISPATCH_OP(CORE, CmpNZRef, {
       bool operand_is_move;
       iree_vm_ref_t* operand = VM_DecOperandRegRef("operand", &operand_is_move);
       int32_t* result = VM_DecResultRegI32("result");
       *result = vm_cmp_nz_ref(operand);
-      if (operand_is_move) iree_vm_ref_release(operand);
+      if (operand_is_move) iree_vm_ref_release_inline(operand);
     });
 
     //===------------------------------------------------------------------===//
@@ -1389,6 +1510,11 @@ iree_status_t iree_vm_bytecode_dispatch(
       }
     });
 
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpEQI32, vm_cmp_eq_i32);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpNEI32, vm_cmp_ne_i32);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32S, vm_cmp_lt_i32s);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32U, vm_cmp_lt_i32u);
+
     DISPATCH_OP(CORE, Call, {
       int32_t function_ordinal = VM_DecFuncAttr("callee");
       const iree_vm_register_list_t* src_reg_list =
@@ -1408,9 +1534,11 @@ iree_status_t iree_vm_bytecode_dispatch(
       } else {
         // Switch execution to the target function and continue running in the
         // bytecode dispatcher.
+        IREE_DISPATCH_PROFILE_CHARGE();
         IREE_RETURN_IF_ERROR(iree_vm_bytecode_internal_enter(
             stack, current_frame->function.module, function_ordinal,
             src_reg_list, dst_reg_list, &current_frame, &regs));
+        IREE_DISPATCH_PROFILE_ENTER();
         bytecode_data =
             module->bytecode_data.data +
             module->function_descriptor_table[function_ordinal].bytecode_offset;
@@ -1450,12 +1578,15 @@ iree_status_t iree_vm_bytecode_dispatch(
       const iree_vm_register_list_t* src_reg_list =
           VM_DecVariadicOperands("operands");
       current_frame->pc = pc;
+      IREE_DISPATCH_PROFILE_CHARGE();
 
-      if (current_frame->depth <= entry_frame_depth) {
+      const iree_vm_bytecode_frame_storage_t* current_storage =
+          (const iree_vm_bytecode_frame_storage_t*)iree_vm_stack_frame_storage(
+              current_frame);
+      if (current_storage->returns_to_external) {
         // Return from the top-level entry frame - return back to call().
         return iree_vm_bytecode_external_leave(stack, current_frame, &regs,
-                                               src_reg_list, cconv_results,
-                                               call->results);
+                                               src_reg_list);
       }
 
       // Store results into the caller frame and pop back to the parent.
@@ -1493,6 +1624,8 @@ iree_status_t iree_vm_bytecode_dispatch(
           VM_DecBranchOperands("operands");
       iree_vm_bytecode_dispatch_remap_branch_registers(regs, remap_list);
       pc = block_pc;
+      current_frame->pc = pc;
+      IREE_DISPATCH_PROFILE_CHARGE();
 
       // Return magic status code indicating a yield.
       // This isn't an error, though callers not supporting coroutines will
@@ -1555,8 +1688,8 @@ iree_status_t iree_vm_bytecode_dispatch(
 
       DISPATCH_OP(EXT_I64, GlobalLoadI64, {
         uint32_t byte_offset = VM_DecGlobalAttr("global");
-        if (IREE_UNLIKELY(byte_offset >=
-                          module_state->rwdata_storage.data_length)) {
+        if (IREE_UNLIKELY(VM_UNVERIFIED(
+                byte_offset >= module_state->rwdata_storage.data_length))) {
           return iree_make_status(
               IREE_STATUS_OUT_OF_RANGE,
               "global byte_offset out of range: %d (rwdata=%zu)", byte_offset,
@@ -1570,8 +1703,8 @@ iree_status_t iree_vm_bytecode_dispatch(
 
       DISPATCH_OP(EXT_I64, GlobalStoreI64, {
         uint32_t byte_offset = VM_DecGlobalAttr("global");
-        if (IREE_UNLIKELY(byte_offset >=
-                          module_state->rwdata_storage.data_length)) {
+        if (IREE_UNLIKELY(VM_UNVERIFIED(
+                byte_offset >= module_state->rwdata_storage.data_length))) {
           return iree_make_status(
               IREE_STATUS_OUT_OF_RANGE,
               "global byte_offset out of range: %d (rwdata=%zu)", byte_offset,
@@ -1823,8 +1956,8 @@ iree_status_t iree_vm_bytecode_dispatch(
 
       DISPATCH_OP(EXT_F32, GlobalLoadF32, {
         uint32_t byte_offset = VM_DecGlobalAttr("global");
-        if (IREE_UNLIKELY(byte_offset >=
-                          module_state->rwdata_storage.data_length)) {
+        if (IREE_UNLIKELY(VM_UNVERIFIED(
+                byte_offset >= module_state->rwdata_storage.data_length))) {
           return iree_make_status(
               IREE_STATUS_OUT_OF_RANGE,
               "global byte_offset out of range: %d (rwdata=%zu)", byte_offset,
@@ -1838,8 +1971,8 @@ iree_status_t iree_vm_bytecode_dispatch(
 
       DISPATCH_OP(EXT_F32, GlobalStoreF32, {
         uint32_t byte_offset = VM_DecGlobalAttr("global");
-        if (IREE_UNLIKELY(byte_offset >=
-                          module_state->rwdata_storage.data_length)) {
+        if (IREE_UNLIKELY(VM_UNVERIFIED(
+                byte_offset >= module_state->rwdata_storage.data_length))) {
           return iree_make_status(
               IREE_STATUS_OUT_OF_RANGE,
               "global byte_offset out of range: %d (rwdata=%zu)", byte_offset,
@@ -2108,3 +2241,48 @@ iree_status_t iree_vm_bytecode_dispatch(
   }
   END_DISPATCH_CORE();
 }
+
+iree_status_t iree_vm_bytecode_dispatch(
+    iree_vm_stack_t* stack, iree_vm_bytecode_module_t* module,
+    const iree_vm_function_call_t* call, iree_string_view_t cconv_arguments,
+    iree_string_view_t cconv_results, iree_vm_execution_result_t* out_result) {
+  memset(out_result, 0, sizeof(*out_result));
+
+  // Enter function (as this is the initial call).
+  // The callee's return will take care of storing the output registers when it
+  // actually does return, either immediately or in the future via a resume.
+  iree_vm_stack_frame_t* current_frame = NULL;
+  iree_vm_registers_t regs;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_external_enter(
+      stack, call->function, cconv_arguments, call->arguments, cconv_results,
+      call->results, &current_frame, &regs));
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  if (iree_vm_stack_invocation_flags(stack) &
+      IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION) {
+    ++iree_vm_bytecode_frame_profile(current_frame)->call_count;
+  }
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+
+  return iree_vm_bytecode_execute(stack, module, current_frame, regs,
+                                  out_result);
+}
+
+iree_status_t iree_vm_bytecode_resume(iree_vm_stack_t* stack,
+                                      iree_vm_bytecode_module_t* module,
+                                      iree_vm_execution_result_t* out_result) {
+  memset(out_result, 0, sizeof(*out_result));
+
+  // Yields only happen in bytecode frames so the top of the stack is the frame
+  // that yielded and its pc is the branch target to resume at.
+  iree_vm_stack_frame_t* current_frame = iree_vm_stack_current_frame(stack);
+  if (IREE_UNLIKELY(!current_frame ||
+                    current_frame->function.module != &module->interface)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "no yielded bytecode frame to resume");
+  }
+  iree_vm_registers_t regs =
+      iree_vm_bytecode_get_register_storage(current_frame);
+
+  return iree_vm_bytecode_execute(stack, module, current_frame, regs,
+                                  out_result);
+}
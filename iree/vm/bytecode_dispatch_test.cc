@@ -13,6 +13,7 @@
 #include "iree/base/logging.h"
 #include "iree/base/status_cc.h"
 #include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode_module.h"
 
@@ -92,13 +93,15 @@ class VMBytecodeDispatchTest
     iree_vm_instance_release(instance_);
   }
 
-  iree_status_t RunFunction(const char* function_name) {
+  iree_status_t RunFunction(
+      const char* function_name,
+      iree_vm_invocation_flags_t flags = IREE_VM_INVOCATION_FLAG_NONE) {
     iree_vm_function_t function;
     IREE_CHECK_OK(bytecode_module_->lookup_function(
         bytecode_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
         iree_make_cstring_view(function_name), &function));
 
-    return iree_vm_invoke(context_, function, IREE_VM_INVOCATION_FLAG_NONE,
+    return iree_vm_invoke(context_, function, flags,
                           /*policy=*/nullptr, /*inputs=*/nullptr,
                           /*outputs=*/nullptr, iree_allocator_system());
   }
@@ -130,6 +133,42 @@ TEST_P(VMBytecodeDispatchTest, Check) {
   }
 }
 
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+TEST_P(VMBytecodeDispatchTest, Profile) {
+  const auto& test_params = GetParam();
+  if (test_params.function_name.find("fail_") == 0) {
+    GTEST_SKIP() << "Profiles are not recorded for failing invocations";
+  }
+
+  IREE_ASSERT_OK(RunFunction(test_params.function_name.c_str(),
+                             IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION));
+
+  // The exported function must have been entered and executed at least its
+  // return instruction.
+  struct ProfileQuery {
+    iree_string_view_t name;
+    bool found;
+  } query = {
+      iree_make_string_view(test_params.function_name.data(),
+                            test_params.function_name.size()),
+      false,
+  };
+  auto callback = +[](void* user_data,
+                      const iree_vm_function_profile_t* profile) {
+    auto* query = (ProfileQuery*)user_data;
+    if (iree_string_view_equal(profile->name, query->name)) {
+      query->found = true;
+      EXPECT_GE(profile->call_count, 1u);
+      EXPECT_GE(profile->instruction_count, 1u);
+    }
+    return iree_ok_status();
+  };
+  IREE_ASSERT_OK(iree_vm_context_enumerate_function_profiles(
+      context_, {callback, &query}));
+  EXPECT_TRUE(query.found);
+}
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+
 INSTANTIATE_TEST_SUITE_P(VMIRFunctions, VMBytecodeDispatchTest,
                          ::testing::ValuesIn(GetModuleTestParams()),
                          ::testing::PrintToStringParamName());
@@ -33,6 +33,11 @@
 // sneak in. The iree_vm_registers_t struct is often kept in cache and the
 // masking is cheap relative to any other validation we could be performing.
 //
+// When IREE_VM_BYTECODE_VERIFICATION_ENABLE is set the bytecode verifier checks
+// all register operands against the register banks of their function at load
+// time and the instruction operand masking is skipped (see VM_RegI32).
+// Register lists and values produced at runtime are still always masked.
+//
 // Alternative register widths
 // ---------------------------
 // Registers in the VM are just a blob of memory and not physical device
@@ -90,13 +95,30 @@ typedef struct iree_vm_bytecode_frame_storage_t {
   // Relative byte offsets from the head of this struct.
   iree_host_size_t i32_register_offset;
   iree_host_size_t ref_register_offset;
+
+  // True if the frame was entered by an external caller and returns into
+  // |external_results| instead of a parent bytecode frame. The results are
+  // kept with the frame so that yielded executions can be resumed without the
+  // original call. The buffer must remain valid until the frame returns.
+  bool returns_to_external;
+  iree_string_view_t external_cconv_results;
+  iree_byte_span_t external_results;
 } iree_vm_bytecode_frame_storage_t;
 
 // Interleaved src-dst register sets for branch register remapping.
 // This structure is an overlay for the bytecode that is serialized in a
 // matching format.
+//
+// The compiler partitions the pairs by register bank: all i32 pairs come first
+// followed by all ref pairs. This allows the remapping to be performed without
+// checking the register type of each pair. Relative order within each bank is
+// preserved and the banks never alias so no new swapping hazards are
+// introduced by the partitioning.
 typedef struct iree_vm_register_remap_list_t {
+  // Total number of pairs in the list.
   uint16_t size;
+  // Number of leading i32 pairs; pairs [i32_size, size) are refs.
+  uint16_t i32_size;
   struct pair {
     uint16_t src_reg;
     uint16_t dst_reg;
@@ -104,7 +126,7 @@ typedef struct iree_vm_register_remap_list_t {
 } iree_vm_register_remap_list_t;
 static_assert(iree_alignof(iree_vm_register_remap_list_t) == 2,
               "Expecting byte alignment (to avoid padding)");
-static_assert(offsetof(iree_vm_register_remap_list_t, pairs) == 2,
+static_assert(offsetof(iree_vm_register_remap_list_t, pairs) == 4,
               "Expect no padding in the struct");
 
 // Maps a type ID to a type def with clamping for out of bounds values.
@@ -137,6 +159,15 @@ static inline const iree_vm_type_def_t* iree_vm_map_type(
 #define IREE_DISPATCH_TRACE_INSTRUCTION(...)
 #endif  // IREE_VM_EXECUTION_TRACING_ENABLE
 
+// Counts every dispatched instruction in a local of the dispatch loop. The
+// count is only charged to a function (and reset) at call boundaries when the
+// invocation is being profiled.
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+#define IREE_DISPATCH_PROFILE_INSTRUCTION() ++profile_instruction_count;
+#else
+#define IREE_DISPATCH_PROFILE_INSTRUCTION()
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+
 #if defined(IREE_COMPILER_MSVC) && !defined(IREE_COMPILER_CLANG)
 #define IREE_DISPATCH_MODE_SWITCH 1
 #else
@@ -149,6 +180,14 @@ static inline const iree_vm_type_def_t* iree_vm_map_type(
 #define VMCHECK(expr)
 #endif  // NDEBUG
 
+// Evaluates a runtime check of |expr| only if the bytecode has not been
+// verified at load time. Verified bytecode is guaranteed to pass the check.
+#if IREE_VM_BYTECODE_VERIFICATION_ENABLE
+#define VM_UNVERIFIED(expr) 0
+#else
+#define VM_UNVERIFIED(expr) (expr)
+#endif  // IREE_VM_BYTECODE_VERIFICATION_ENABLE
+
 //===----------------------------------------------------------------------===//
 // Bytecode data reading with little-/big-endian support
 //===----------------------------------------------------------------------===//
@@ -173,6 +212,19 @@ static const int kRegSize = sizeof(uint16_t);
 // Each macro will increment the pc by the number of bytes read and as such must
 // be called in the same order the values are encoded.
 
+// Register ordinals are masked to the frame register banks unless the bytecode
+// has been verified at load time to only reference registers within them. The
+// ref ordinals always have their type and move bits stripped.
+#if IREE_VM_BYTECODE_VERIFICATION_ENABLE
+#define VM_RegI32(ordinal) (ordinal)
+#define VM_RegI64(ordinal) ((ordinal) & ~1)
+#define VM_RegRef(ordinal) ((ordinal)&IREE_REF_REGISTER_MASK)
+#else
+#define VM_RegI32(ordinal) ((ordinal)&regs.i32_mask)
+#define VM_RegI64(ordinal) ((ordinal) & (regs.i32_mask & ~1))
+#define VM_RegRef(ordinal) ((ordinal)&regs.ref_mask)
+#endif  // IREE_VM_BYTECODE_VERIFICATION_ENABLE
+
 #define VM_AlignPC(pc, alignment) \
   (pc) = ((pc) + ((alignment)-1)) & ~((alignment)-1)
 
@@ -215,23 +267,23 @@ static inline const iree_vm_register_remap_list_t* VM_DecBranchOperandsImpl(
   VM_AlignPC(*pc, kRegSize);
   const iree_vm_register_remap_list_t* list =
       (const iree_vm_register_remap_list_t*)&bytecode_data[*pc];
-  *pc = *pc + kRegSize + list->size * 2 * kRegSize;
+  *pc = *pc + 2 * kRegSize + list->size * 2 * kRegSize;
   return list;
 }
-#define VM_DecOperandRegI32(name)      \
-  regs.i32[OP_I16(0) & regs.i32_mask]; \
+#define VM_DecOperandRegI32(name) \
+  regs.i32[VM_RegI32(OP_I16(0))]; \
   pc += kRegSize;
-#define VM_DecOperandRegI64(name)                           \
-  *((int64_t*)&regs.i32[OP_I16(0) & (regs.i32_mask & ~1)]); \
+#define VM_DecOperandRegI64(name)               \
+  *((int64_t*)&regs.i32[VM_RegI64(OP_I16(0))]); \
   pc += kRegSize;
-#define VM_DecOperandRegF32(name)                  \
-  *((float*)&regs.i32[OP_I16(0) & regs.i32_mask]); \
+#define VM_DecOperandRegF32(name)             \
+  *((float*)&regs.i32[VM_RegI32(OP_I16(0))]); \
   pc += kRegSize;
-#define VM_DecOperandRegF64(name)                          \
-  *((double*)&regs.i32[OP_I16(0) & (regs.i32_mask & ~1)]); \
+#define VM_DecOperandRegF64(name)              \
+  *((double*)&regs.i32[VM_RegI64(OP_I16(0))]); \
   pc += kRegSize;
 #define VM_DecOperandRegRef(name, out_is_move)                      \
-  &regs.ref[OP_I16(0) & regs.ref_mask];                             \
+  &regs.ref[VM_RegRef(OP_I16(0))];                                  \
   *(out_is_move) = 0; /*= OP_I16(0) & IREE_REF_REGISTER_MOVE_BIT;*/ \
   pc += kRegSize;
 #define VM_DecVariadicOperands(name) \
@@ -244,20 +296,20 @@ static inline const iree_vm_register_list_t* VM_DecVariadicOperandsImpl(
   *pc = *pc + kRegSize + list->size * kRegSize;
   return list;
 }
-#define VM_DecResultRegI32(name)        \
-  &regs.i32[OP_I16(0) & regs.i32_mask]; \
+#define VM_DecResultRegI32(name)   \
+  &regs.i32[VM_RegI32(OP_I16(0))]; \
   pc += kRegSize;
-#define VM_DecResultRegI64(name)                           \
-  ((int64_t*)&regs.i32[OP_I16(0) & (regs.i32_mask & ~1)]); \
+#define VM_DecResultRegI64(name)               \
+  ((int64_t*)&regs.i32[VM_RegI64(OP_I16(0))]); \
   pc += kRegSize;
-#define VM_DecResultRegF32(name)                  \
-  ((float*)&regs.i32[OP_I16(0) & regs.i32_mask]); \
+#define VM_DecResultRegF32(name)             \
+  ((float*)&regs.i32[VM_RegI32(OP_I16(0))]); \
   pc += kRegSize;
-#define VM_DecResultRegF64(name)                          \
-  ((double*)&regs.i32[OP_I16(0) & (regs.i32_mask & ~1)]); \
+#define VM_DecResultRegF64(name)              \
+  ((double*)&regs.i32[VM_RegI64(OP_I16(0))]); \
   pc += kRegSize;
 #define VM_DecResultRegRef(name, out_is_move)                       \
-  &regs.ref[OP_I16(0) & regs.ref_mask];                             \
+  &regs.ref[VM_RegRef(OP_I16(0))];                                  \
   *(out_is_move) = 0; /*= OP_I16(0) & IREE_REF_REGISTER_MOVE_BIT;*/ \
   pc += kRegSize;
 #define VM_DecVariadicResults(name) VM_DecVariadicOperands(name)
@@ -351,9 +403,15 @@ static inline const iree_vm_register_list_t* VM_DecVariadicOperandsImpl(
 #define DISPATCH_OP(ext, op_name, body)                          \
   _dispatch_##ext##_##op_name:;                                  \
   IREE_DISPATCH_TRACE_INSTRUCTION(VM_PC_OFFSET_##ext, #op_name); \
+  IREE_DISPATCH_PROFILE_INSTRUCTION();                           \
   body;                                                          \
   goto* kDispatchTable_CORE[bytecode_data[pc++]];
 
+// Declares |op_name| as sharing the handler of the DISPATCH_OP that follows.
+// The handler can recover the dispatched opcode from the bytecode, such as
+// with `bytecode_data[pc - VM_PC_OFFSET_CORE]`.
+#define DISPATCH_OP_SHARED(ext, op_name) _dispatch_##ext##_##op_name:
+
 #define BEGIN_DISPATCH_PREFIX(op_name, ext)                                   \
   _dispatch_CORE_##op_name : goto* kDispatchTable_##ext[bytecode_data[pc++]]; \
   while (1)
@@ -387,9 +445,12 @@ static inline const iree_vm_register_list_t* VM_DecVariadicOperandsImpl(
 #define DISPATCH_OP(ext, op_name, body)                            \
   case IREE_VM_OP_##ext##_##op_name: {                             \
     IREE_DISPATCH_TRACE_INSTRUCTION(VM_PC_OFFSET_##ext, #op_name); \
+    IREE_DISPATCH_PROFILE_INSTRUCTION();                           \
     body;                                                          \
   } break;
 
+#define DISPATCH_OP_SHARED(ext, op_name) case IREE_VM_OP_##ext##_##op_name:
+
 #define BEGIN_DISPATCH_PREFIX(op_name, ext) \
   case IREE_VM_OP_CORE_##op_name: {         \
     switch (bytecode_data[pc++])
@@ -425,6 +486,29 @@ static inline const iree_vm_register_list_t* VM_DecVariadicOperandsImpl(
     *result = op_func(a, b, c);                        \
   });
 
+// Compare-and-branch superinstruction fusing a vm.cmp.*.i32 with the
+// vm.cond_br consuming its result. The comparison result is not stored.
+#define DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(op_name, op_func)            \
+  DISPATCH_OP(CORE, op_name, {                                            \
+    int32_t lhs = VM_DecOperandRegI32("lhs");                             \
+    int32_t rhs = VM_DecOperandRegI32("rhs");                             \
+    int32_t true_block_pc = VM_DecBranchTarget("true_dest");              \
+    const iree_vm_register_remap_list_t* true_remap_list =                \
+        VM_DecBranchOperands("true_operands");                            \
+    int32_t false_block_pc = VM_DecBranchTarget("false_dest");            \
+    const iree_vm_register_remap_list_t* false_remap_list =               \
+        VM_DecBranchOperands("false_operands");                           \
+    if (op_func(lhs, rhs)) {                                              \
+      pc = true_block_pc;                                                 \
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs,              \
+                                                       true_remap_list);  \
+    } else {                                                              \
+      pc = false_block_pc;                                                \
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs,              \
+                                                       false_remap_list); \
+    }                                                                     \
+  });
+
 #define DISPATCH_OP_EXT_I64_UNARY_I64(op_name, op_func) \
   DISPATCH_OP(EXT_I64, op_name, {                       \
     int64_t operand = VM_DecOperandRegI64("operand");   \
@@ -11,9 +11,11 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/lz4.h"
 #include "iree/base/tracing.h"
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode_module_impl.h"
+#include "iree/vm/bytecode_verifier.h"
 
 // Perform an strcmp between a flatbuffers string and an IREE string view.
 static bool iree_vm_flatbuffer_strcmp(flatbuffers_string_t lhs,
@@ -100,6 +102,119 @@ static iree_status_t iree_vm_bytecode_module_resolve_types(
   return status;
 }
 
+// Returns the size in bytes of |segment| once decompressed or 0 if the segment
+// is stored uncompressed.
+static iree_status_t iree_vm_bytecode_module_rodata_decompressed_size(
+    iree_host_size_t ordinal, iree_vm_RodataSegmentDef_table_t segment,
+    iree_host_size_t* out_size) {
+  *out_size = 0;
+  switch (iree_vm_RodataSegmentDef_compression_type_type(segment)) {
+    case iree_vm_CompressionTypeDef_NONE:
+    case iree_vm_CompressionTypeDef_UncompressedDataDef:
+      return iree_ok_status();
+#if IREE_VM_BYTECODE_COMPRESSION_ENABLE
+    case iree_vm_CompressionTypeDef_LZ4BlockDataDef: {
+      iree_vm_LZ4BlockDataDef_table_t lz4_def =
+          (iree_vm_LZ4BlockDataDef_table_t)
+              iree_vm_RodataSegmentDef_compression_type(segment);
+      uint64_t size = iree_vm_LZ4BlockDataDef_uncompressed_size(lz4_def);
+      if (size > (uint64_t)(SIZE_MAX / 2)) {
+        return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                                "rodata segment %" PRIhsz
+                                " decompressed size %" PRIu64
+                                " exceeds the addressable range",
+                                ordinal, size);
+      }
+      *out_size = (iree_host_size_t)size;
+      return iree_ok_status();
+    }
+#endif  // IREE_VM_BYTECODE_COMPRESSION_ENABLE
+    default:
+      return iree_make_status(
+          IREE_STATUS_UNIMPLEMENTED,
+          "rodata segment %" PRIhsz
+          " compression type %u is not supported by this runtime",
+          ordinal,
+          (uint32_t)iree_vm_RodataSegmentDef_compression_type_type(segment));
+  }
+}
+
+// Builds the rodata segment table of |module|, decompressing any compressed
+// segments into storage owned by the module. All compressed segments are
+// decompressed up front so that states (and forks of them) can share them and
+// so that corrupt data is reported at load time instead of at first use.
+static iree_status_t iree_vm_bytecode_module_load_rodata(
+    iree_vm_bytecode_module_t* module) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_vm_RodataSegmentDef_vec_t segments =
+      iree_vm_BytecodeModuleDef_rodata_segments(module->def);
+  iree_host_size_t segment_count = iree_vm_RodataSegmentDef_vec_len(segments);
+
+  // Size the segment table and the storage for decompressed segments, which
+  // is aligned to 16 bytes (128-bits) as with the FlatBuffer rodata.
+  iree_host_size_t total_size =
+      iree_host_align(segment_count * sizeof(iree_byte_span_t), 16);
+  for (iree_host_size_t i = 0; i < segment_count; ++i) {
+    iree_host_size_t decompressed_size = 0;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_vm_bytecode_module_rodata_decompressed_size(
+                i, iree_vm_RodataSegmentDef_vec_at(segments, i),
+                &decompressed_size));
+    if (decompressed_size > SIZE_MAX / 2 - total_size) {
+      IREE_TRACE_ZONE_END(z0);
+      return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "decompressed rodata exceeds the addressable "
+                              "range");
+    }
+    total_size += iree_host_align(decompressed_size, 16);
+  }
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(module->allocator, total_size,
+                                (void**)&module->rodata_segments));
+  module->rodata_segment_count = segment_count;
+
+#if IREE_VM_BYTECODE_COMPRESSION_ENABLE
+  uint8_t* storage_ptr =
+      (uint8_t*)module->rodata_segments +
+      iree_host_align(segment_count * sizeof(iree_byte_span_t), 16);
+#endif  // IREE_VM_BYTECODE_COMPRESSION_ENABLE
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < segment_count; ++i) {
+    iree_vm_RodataSegmentDef_table_t segment =
+        iree_vm_RodataSegmentDef_vec_at(segments, i);
+    flatbuffers_uint8_vec_t data = iree_vm_RodataSegmentDef_data(segment);
+    iree_byte_span_t data_span =
+        iree_make_byte_span((uint8_t*)data, flatbuffers_uint8_vec_len(data));
+    iree_host_size_t decompressed_size = 0;
+    status = iree_vm_bytecode_module_rodata_decompressed_size(
+        i, segment, &decompressed_size);
+    if (!iree_status_is_ok(status)) break;
+    if (!decompressed_size) {
+      module->rodata_segments[i] = data_span;
+      continue;
+    }
+#if IREE_VM_BYTECODE_COMPRESSION_ENABLE
+    IREE_TRACE_ZONE_BEGIN_NAMED(z1, "iree_vm_bytecode_module_decompress");
+    IREE_TRACE_ZONE_APPEND_VALUE(z1, decompressed_size);
+    module->rodata_segments[i] =
+        iree_make_byte_span(storage_ptr, decompressed_size);
+    status = iree_lz4_decompress(
+        iree_make_const_byte_span(data_span.data, data_span.data_length),
+        module->rodata_segments[i]);
+    storage_ptr += iree_host_align(decompressed_size, 16);
+    IREE_TRACE_ZONE_END(z1);
+    if (!iree_status_is_ok(status)) {
+      status = iree_status_annotate_f(status,
+                                      "decompressing rodata segment %" PRIhsz,
+                                      i);
+      break;
+    }
+#endif  // IREE_VM_BYTECODE_COMPRESSION_ENABLE
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 // Verifies the structure of the flatbuffer so that we can avoid doing so during
 // runtime. There are still some conditions we must be aware of (such as omitted
 // names on functions with internal linkage), however we shouldn't need to
@@ -219,7 +334,8 @@ static iree_status_t iree_vm_bytecode_module_flatbuffer_verify(
           "functions[%zu] descriptor register count out of range", i);
     }
 
-    // TODO(benvanik): run bytecode verifier on contents.
+    // NOTE: the bytecode contents are verified after the module tables have
+    // been resolved (see iree_vm_bytecode_verify_module).
   }
 
   return iree_ok_status();
@@ -270,6 +386,7 @@ static void iree_vm_bytecode_module_destroy(void* self) {
   iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_allocator_free(module->allocator, module->rodata_segments);
   iree_allocator_free(module->flatbuffer_allocator,
                       (void*)module->flatbuffer_data.data);
   module->flatbuffer_data = iree_make_const_byte_span(NULL, 0);
@@ -643,6 +760,12 @@ static iree_host_size_t iree_vm_bytecode_module_layout_state(
       iree_vm_BytecodeModuleDef_rodata_segments(module_def));
   iree_host_size_t import_function_count = iree_vm_ImportFunctionDef_vec_len(
       iree_vm_BytecodeModuleDef_imported_functions(module_def));
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  iree_host_size_t function_profile_count = iree_vm_FunctionDescriptor_vec_len(
+      iree_vm_BytecodeModuleDef_function_descriptors(module_def));
+#else
+  iree_host_size_t function_profile_count = 0;
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
 
   uint8_t* base_ptr = (uint8_t*)state;
   iree_host_size_t offset =
@@ -673,6 +796,14 @@ static iree_host_size_t iree_vm_bytecode_module_layout_state(
   offset +=
       iree_host_align(import_function_count * sizeof(*state->import_table), 16);
 
+  if (state) {
+    state->function_profile_count = function_profile_count;
+    state->function_profiles =
+        (iree_vm_bytecode_function_profile_t*)(base_ptr + offset);
+  }
+  offset += iree_host_align(
+      function_profile_count * sizeof(*state->function_profiles), 16);
+
   return offset;
 }
 
@@ -700,19 +831,13 @@ static iree_status_t iree_vm_bytecode_module_alloc_state(
   // Perform layout to get the pointers into the storage for each nested table.
   iree_vm_bytecode_module_layout_state(module_def, state);
 
-  // Setup rodata segments to point directly at the flatbuffer memory.
-  iree_vm_RodataSegmentDef_vec_t rodata_segments =
-      iree_vm_BytecodeModuleDef_rodata_segments(module_def);
+  // Setup rodata segments to point directly at the flatbuffer memory or the
+  // decompressed copies owned by the module.
   for (int i = 0; i < state->rodata_ref_count; ++i) {
-    iree_vm_RodataSegmentDef_table_t segment =
-        iree_vm_RodataSegmentDef_vec_at(rodata_segments, i);
     iree_vm_buffer_t* ref = &state->rodata_ref_table[i];
-    iree_vm_buffer_initialize(
-        IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE,
-        iree_make_byte_span(
-            (uint8_t*)iree_vm_RodataSegmentDef_data(segment),
-            flatbuffers_uint8_vec_len(iree_vm_RodataSegmentDef_data(segment))),
-        iree_allocator_null(), ref);
+    iree_vm_buffer_initialize(IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE,
+                              module->rodata_segments[i], iree_allocator_null(),
+                              ref);
   }
 
   *out_module_state = (iree_vm_module_state_t*)state;
@@ -720,6 +845,33 @@ static iree_status_t iree_vm_bytecode_module_alloc_state(
   return iree_ok_status();
 }
 
+static iree_status_t iree_vm_bytecode_module_fork_state(
+    void* self, iree_vm_module_state_t* parent_state,
+    iree_allocator_t allocator, iree_vm_module_state_t** out_module_state) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_vm_bytecode_module_alloc_state(self, allocator, out_module_state));
+  iree_vm_bytecode_module_state_t* parent =
+      (iree_vm_bytecode_module_state_t*)parent_state;
+  iree_vm_bytecode_module_state_t* state =
+      (iree_vm_bytecode_module_state_t*)*out_module_state;
+
+  // Primitive globals are copied so that the child can mutate them freely.
+  memcpy(state->rwdata_storage.data, parent->rwdata_storage.data,
+         state->rwdata_storage.data_length);
+
+  // Ref globals are retained so that the objects they reference (such as
+  // uploaded constants) are shared with the parent and all other forks.
+  for (iree_host_size_t i = 0; i < state->global_ref_count; ++i) {
+    iree_vm_ref_retain(&parent->global_ref_table[i],
+                       &state->global_ref_table[i]);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 static void iree_vm_bytecode_module_free_state(
     void* self, iree_vm_module_state_t* module_state) {
   if (!module_state) return;
@@ -744,9 +896,28 @@ static void iree_vm_bytecode_module_free_state(
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Returns true if |cconv_fragment| only contains primitive values that can be
+// passed through an iree_vm_direct_call_fn_t.
+static bool iree_vm_bytecode_is_direct_cconv(
+    iree_string_view_t cconv_fragment) {
+  if (cconv_fragment.size > IREE_VM_DIRECT_CALL_MAX_VALUES) return false;
+  for (iree_host_size_t i = 0; i < cconv_fragment.size; ++i) {
+    switch (cconv_fragment.data[i]) {
+      case IREE_VM_CCONV_TYPE_I32:
+      case IREE_VM_CCONV_TYPE_I64:
+      case IREE_VM_CCONV_TYPE_F32:
+      case IREE_VM_CCONV_TYPE_F64:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
 static iree_status_t iree_vm_bytecode_module_resolve_import(
     void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
-    const iree_vm_function_t* function,
+    const iree_vm_function_t* function, iree_vm_module_state_t* function_state,
     const iree_vm_function_signature_t* signature) {
   IREE_ASSERT_ARGUMENT(module_state);
   iree_vm_bytecode_module_state_t* state =
@@ -759,6 +930,7 @@ static iree_status_t iree_vm_bytecode_module_resolve_import(
 
   iree_vm_bytecode_import_t* import = &state->import_table[ordinal];
   import->function = *function;
+  import->module_state = function_state;
 
   // Split up arguments/results into fragments so that we can avoid scanning
   // during calling.
@@ -785,6 +957,23 @@ static iree_status_t iree_vm_bytecode_module_resolve_import(
   import->argument_buffer_size = (uint16_t)argument_buffer_size;
   import->result_buffer_size = (uint16_t)result_buffer_size;
 
+  // Query a direct entry point for primitive-only imports so that calls can
+  // skip the callee stack frame and ABI marshaling. Callees that don't support
+  // it (or the particular function) use begin_call as usual.
+  memset(&import->direct, 0, sizeof(import->direct));
+  iree_vm_module_t* callee_module = function->module;
+  if (callee_module->get_direct_function &&
+      function->linkage == IREE_VM_FUNCTION_LINKAGE_EXPORT &&
+      iree_vm_bytecode_is_direct_cconv(import->arguments) &&
+      iree_vm_bytecode_is_direct_cconv(import->results)) {
+    iree_status_t direct_status = callee_module->get_direct_function(
+        callee_module->self, function->ordinal, &import->direct);
+    if (!iree_status_is_ok(direct_status)) {
+      iree_status_ignore(direct_status);
+      memset(&import->direct, 0, sizeof(import->direct));
+    }
+  }
+
   return iree_ok_status();
 }
 
@@ -844,6 +1033,63 @@ static iree_status_t iree_vm_bytecode_module_begin_call(
   return status;
 }
 
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+static iree_status_t iree_vm_bytecode_module_get_function_profile(
+    void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
+    iree_vm_function_profile_t* out_profile) {
+  IREE_ASSERT_ARGUMENT(module_state);
+  IREE_ASSERT_ARGUMENT(out_profile);
+  memset(out_profile, 0, sizeof(*out_profile));
+  iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
+  iree_vm_bytecode_module_state_t* state =
+      (iree_vm_bytecode_module_state_t*)module_state;
+  if (ordinal >= state->function_profile_count) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "function ordinal out of range (0 < %zu < %zu)",
+                            ordinal, state->function_profile_count);
+  }
+
+  // Internal functions only have names when exported; use the first export
+  // referencing this function.
+  iree_vm_ExportFunctionDef_vec_t exported_functions =
+      iree_vm_BytecodeModuleDef_exported_functions(module->def);
+  for (iree_host_size_t i = 0;
+       i < iree_vm_ExportFunctionDef_vec_len(exported_functions); ++i) {
+    iree_vm_ExportFunctionDef_table_t export_def =
+        iree_vm_ExportFunctionDef_vec_at(exported_functions, i);
+    if (iree_vm_ExportFunctionDef_internal_ordinal(export_def) == ordinal) {
+      flatbuffers_string_t name =
+          iree_vm_ExportFunctionDef_local_name(export_def);
+      out_profile->name =
+          iree_make_string_view(name, flatbuffers_string_len(name));
+      break;
+    }
+  }
+
+  const iree_vm_bytecode_function_profile_t* profile =
+      &state->function_profiles[ordinal];
+  out_profile->module = &module->interface;
+  out_profile->call_count = profile->call_count;
+  out_profile->instruction_count = profile->instruction_count;
+  out_profile->self_time_ns = profile->self_time_ns;
+  return iree_ok_status();
+}
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+
+static iree_status_t iree_vm_bytecode_module_resume_call(
+    void* self, iree_vm_stack_t* stack,
+    iree_vm_execution_result_t* out_result) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(out_result);
+  iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
+
+  // Continue executing the yielded frame from where it left off; the results
+  // are stored by the return of the frame that began the call.
+  iree_status_t status = iree_vm_bytecode_resume(stack, module, out_result);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     iree_const_byte_span_t flatbuffer_data,
     iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
@@ -881,6 +1127,8 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
       z0, iree_allocator_malloc(allocator, sizeof(*module) + type_table_size,
                                 (void**)&module));
   module->allocator = allocator;
+  module->rodata_segment_count = 0;
+  module->rodata_segments = NULL;
 
   iree_vm_FunctionDescriptor_vec_t function_descriptors =
       iree_vm_BytecodeModuleDef_function_descriptors(module_def);
@@ -906,6 +1154,23 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     return resolve_status;
   }
 
+#if IREE_VM_BYTECODE_VERIFICATION_ENABLE
+  iree_status_t verify_status = iree_vm_bytecode_verify_module(module);
+  if (!iree_status_is_ok(verify_status)) {
+    iree_allocator_free(allocator, module);
+    IREE_TRACE_ZONE_END(z0);
+    return verify_status;
+  }
+#endif  // IREE_VM_BYTECODE_VERIFICATION_ENABLE
+
+  iree_status_t rodata_status = iree_vm_bytecode_module_load_rodata(module);
+  if (!iree_status_is_ok(rodata_status)) {
+    iree_allocator_free(allocator, module->rodata_segments);
+    iree_allocator_free(allocator, module);
+    IREE_TRACE_ZONE_END(z0);
+    return rodata_status;
+  }
+
   iree_vm_module_initialize(&module->interface, module);
   module->interface.destroy = iree_vm_bytecode_module_destroy;
   module->interface.name = iree_vm_bytecode_module_name;
@@ -918,9 +1183,15 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
 #endif  // IREE_VM_BACKTRACE_ENABLE
   module->interface.alloc_state = iree_vm_bytecode_module_alloc_state;
   module->interface.free_state = iree_vm_bytecode_module_free_state;
+  module->interface.fork_state = iree_vm_bytecode_module_fork_state;
   module->interface.resolve_import = iree_vm_bytecode_module_resolve_import;
   module->interface.notify = iree_vm_bytecode_module_notify;
   module->interface.begin_call = iree_vm_bytecode_module_begin_call;
+  module->interface.resume_call = iree_vm_bytecode_module_resume_call;
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  module->interface.get_function_profile =
+      iree_vm_bytecode_module_get_function_profile;
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
   module->interface.get_function_reflection_attr =
       iree_vm_bytecode_module_get_function_reflection_attr;
 
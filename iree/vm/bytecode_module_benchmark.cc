@@ -14,6 +14,12 @@
 #include "iree/vm/bytecode_module.h"
 #include "iree/vm/bytecode_module_benchmark_module_c.h"
 
+// When built with EmitC the same module is also compiled ahead-of-time to C
+// and each benchmark has a native variant running without the interpreter.
+#if defined(IREE_VM_BENCHMARK_EMITC)
+#include "iree/vm/bytecode_module_benchmark_module_emitc.h"
+#endif  // IREE_VM_BENCHMARK_EMITC
+
 namespace {
 
 struct native_import_module_s;
@@ -65,8 +71,34 @@ static iree_status_t native_import_module_create(
       &interface, &native_import_module_descriptor_, allocator, out_module);
 }
 
-// Benchmarks the given exported function, optionally passing in arguments.
+// Creates the benchmark module in one of its compiled forms.
+typedef iree_status_t (*module_create_fn_t)(iree_allocator_t allocator,
+                                            iree_vm_module_t** out_module);
+
+// Creates the benchmark module from its embedded bytecode.
+static iree_status_t bytecode_benchmark_module_create(
+    iree_allocator_t allocator, iree_vm_module_t** out_module) {
+  const auto* module_file_toc =
+      iree_vm_bytecode_module_benchmark_module_create();
+  return iree_vm_bytecode_module_create(
+      iree_const_byte_span_t{
+          reinterpret_cast<const uint8_t*>(module_file_toc->data),
+          module_file_toc->size},
+      iree_allocator_null(), allocator, out_module);
+}
+
+#if defined(IREE_VM_BENCHMARK_EMITC)
+// Creates the benchmark module from its ahead-of-time compiled C.
+static iree_status_t emitc_benchmark_module_create(
+    iree_allocator_t allocator, iree_vm_module_t** out_module) {
+  return bytecode_module_benchmark_create(allocator, out_module);
+}
+#endif  // IREE_VM_BENCHMARK_EMITC
+
+// Benchmarks the given exported function of the module created by
+// |module_create|, optionally passing in arguments.
 static iree_status_t RunFunction(benchmark::State& state,
+                                 module_create_fn_t module_create,
                                  iree_string_view_t function_name,
                                  std::vector<int32_t> i32_args,
                                  int result_count, int64_t batch_size = 1) {
@@ -77,14 +109,8 @@ static iree_status_t RunFunction(benchmark::State& state,
   IREE_CHECK_OK(
       native_import_module_create(iree_allocator_system(), &import_module));
 
-  const auto* module_file_toc =
-      iree_vm_bytecode_module_benchmark_module_create();
   iree_vm_module_t* bytecode_module = nullptr;
-  IREE_CHECK_OK(iree_vm_bytecode_module_create(
-      iree_const_byte_span_t{
-          reinterpret_cast<const uint8_t*>(module_file_toc->data),
-          module_file_toc->size},
-      iree_allocator_null(), iree_allocator_system(), &bytecode_module));
+  IREE_CHECK_OK(module_create(iree_allocator_system(), &bytecode_module));
 
   std::array<iree_vm_module_t*, 2> modules = {import_module, bytecode_module};
   iree_vm_context_t* context = NULL;
@@ -211,7 +237,8 @@ BENCHMARK(BM_EmptyFuncReference);
 
 static void BM_EmptyFuncBytecode(benchmark::State& state) {
   IREE_CHECK_OK(RunFunction(
-      state, iree_make_cstring_view("bytecode_module_benchmark.empty_func"), {},
+      state, bytecode_benchmark_module_create,
+      iree_make_cstring_view("bytecode_module_benchmark.empty_func"), {},
       /*result_count=*/0));
 }
 BENCHMARK(BM_EmptyFuncBytecode);
@@ -251,7 +278,7 @@ BENCHMARK(BM_CallInternalFuncReference);
 
 static void BM_CallInternalFuncBytecode(benchmark::State& state) {
   IREE_CHECK_OK(RunFunction(
-      state,
+      state, bytecode_benchmark_module_create,
       iree_make_cstring_view("bytecode_module_benchmark.call_internal_func"),
       {100},
       /*result_count=*/1,
@@ -261,7 +288,7 @@ BENCHMARK(BM_CallInternalFuncBytecode);
 
 static void BM_CallImportedFuncBytecode(benchmark::State& state) {
   IREE_CHECK_OK(RunFunction(
-      state,
+      state, bytecode_benchmark_module_create,
       iree_make_cstring_view("bytecode_module_benchmark.call_imported_func"),
       {100},
       /*result_count=*/1,
@@ -291,7 +318,8 @@ BENCHMARK(BM_LoopSumReference)->Arg(100000);
 
 static void BM_LoopSumBytecode(benchmark::State& state) {
   IREE_CHECK_OK(RunFunction(
-      state, iree_make_cstring_view("bytecode_module_benchmark.loop_sum"),
+      state, bytecode_benchmark_module_create,
+      iree_make_cstring_view("bytecode_module_benchmark.loop_sum"),
       {static_cast<int32_t>(state.range(0))},
       /*result_count=*/1,
       /*batch_size=*/state.range(0)));
@@ -326,7 +354,8 @@ BENCHMARK(BM_BufferReduceReference)->Arg(100000);
 
 static void BM_BufferReduceBytecode(benchmark::State& state) {
   IREE_CHECK_OK(RunFunction(
-      state, iree_make_cstring_view("bytecode_module_benchmark.buffer_reduce"),
+      state, bytecode_benchmark_module_create,
+      iree_make_cstring_view("bytecode_module_benchmark.buffer_reduce"),
       {static_cast<int32_t>(state.range(0))},
       /*result_count=*/1,
       /*batch_size=*/state.range(0)));
@@ -336,7 +365,7 @@ BENCHMARK(BM_BufferReduceBytecode)->Arg(100000);
 // NOTE: unrolled 8x, requires %count to be % 8 = 0.
 static void BM_BufferReduceBytecodeUnrolled(benchmark::State& state) {
   IREE_CHECK_OK(
-      RunFunction(state,
+      RunFunction(state, bytecode_benchmark_module_create,
                   iree_make_cstring_view(
                       "bytecode_module_benchmark.buffer_reduce_unrolled"),
                   {static_cast<int32_t>(state.range(0))},
@@ -345,4 +374,83 @@ static void BM_BufferReduceBytecodeUnrolled(benchmark::State& state) {
 }
 BENCHMARK(BM_BufferReduceBytecodeUnrolled)->Arg(100000);
 
+#if defined(IREE_VM_BENCHMARK_EMITC)
+
+// The same functions as above compiled ahead-of-time to C. The difference from
+// the bytecode variants is the interpreter overhead while the difference from
+// the references is the cost of the VM calling convention.
+
+static void BM_ModuleCreateEmitC(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    iree_vm_module_t* module = nullptr;
+    IREE_CHECK_OK(
+        emitc_benchmark_module_create(iree_allocator_system(), &module));
+    benchmark::DoNotOptimize(module);
+    iree_vm_module_release(module);
+  }
+}
+BENCHMARK(BM_ModuleCreateEmitC);
+
+static void BM_EmptyFuncEmitC(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(
+      state, emitc_benchmark_module_create,
+      iree_make_cstring_view("bytecode_module_benchmark.empty_func"), {},
+      /*result_count=*/0));
+}
+BENCHMARK(BM_EmptyFuncEmitC);
+
+static void BM_CallInternalFuncEmitC(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(
+      state, emitc_benchmark_module_create,
+      iree_make_cstring_view("bytecode_module_benchmark.call_internal_func"),
+      {100},
+      /*result_count=*/1,
+      /*batch_size=*/20));
+}
+BENCHMARK(BM_CallInternalFuncEmitC);
+
+static void BM_CallImportedFuncEmitC(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(
+      state, emitc_benchmark_module_create,
+      iree_make_cstring_view("bytecode_module_benchmark.call_imported_func"),
+      {100},
+      /*result_count=*/1,
+      /*batch_size=*/20));
+}
+BENCHMARK(BM_CallImportedFuncEmitC);
+
+static void BM_LoopSumEmitC(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(
+      state, emitc_benchmark_module_create,
+      iree_make_cstring_view("bytecode_module_benchmark.loop_sum"),
+      {static_cast<int32_t>(state.range(0))},
+      /*result_count=*/1,
+      /*batch_size=*/state.range(0)));
+}
+BENCHMARK(BM_LoopSumEmitC)->Arg(100000);
+
+static void BM_BufferReduceEmitC(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(
+      state, emitc_benchmark_module_create,
+      iree_make_cstring_view("bytecode_module_benchmark.buffer_reduce"),
+      {static_cast<int32_t>(state.range(0))},
+      /*result_count=*/1,
+      /*batch_size=*/state.range(0)));
+}
+BENCHMARK(BM_BufferReduceEmitC)->Arg(100000);
+
+// NOTE: unrolled 8x, requires %count to be % 8 = 0.
+static void BM_BufferReduceEmitCUnrolled(benchmark::State& state) {
+  IREE_CHECK_OK(
+      RunFunction(state, emitc_benchmark_module_create,
+                  iree_make_cstring_view(
+                      "bytecode_module_benchmark.buffer_reduce_unrolled"),
+                  {static_cast<int32_t>(state.range(0))},
+                  /*result_count=*/1,
+                  /*batch_size=*/state.range(0)));
+}
+BENCHMARK(BM_BufferReduceEmitCUnrolled)->Arg(100000);
+
+#endif  // IREE_VM_BENCHMARK_EMITC
+
 }  // namespace
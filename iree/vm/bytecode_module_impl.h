@@ -65,6 +65,13 @@ typedef struct iree_vm_bytecode_module_t {
   iree_allocator_t flatbuffer_allocator;
   iree_vm_BytecodeModuleDef_table_t def;
 
+  // Contents of each rodata segment indexed by rodata ordinal. Uncompressed
+  // segments reference the FlatBuffer directly and compressed segments were
+  // decompressed into this allocation when the module was loaded, allowing
+  // all states to share them.
+  iree_host_size_t rodata_segment_count;
+  iree_byte_span_t* rodata_segments;
+
   // Type table mapping module type IDs to registered VM types.
   iree_host_size_t type_count;
   iree_vm_type_def_t type_table[];
@@ -80,6 +87,9 @@ typedef struct iree_vm_bytecode_import_t {
   // Import function in the source module.
   iree_vm_function_t function;
 
+  // State of the source module within the context, resolved at link time.
+  iree_vm_module_state_t* module_state;
+
   // Pre-parsed argument/result calling convention string fragments.
   // For example, 0ii.r will be split to arguments=ii and results=r.
   iree_string_view_t arguments;
@@ -90,8 +100,21 @@ typedef struct iree_vm_bytecode_import_t {
   // don't support variadic values (yet).
   uint16_t argument_buffer_size;
   uint16_t result_buffer_size;
+
+  // Direct entry point of the import if the callee provides one for its
+  // primitive-only signature. When set calls bypass the callee stack frame and
+  // ABI buffers entirely.
+  iree_vm_direct_function_t direct;
 } iree_vm_bytecode_import_t;
 
+// Execution statistics of an internal function collected by the dispatcher for
+// invocations with IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION.
+typedef struct iree_vm_bytecode_function_profile_t {
+  uint64_t call_count;
+  uint64_t instruction_count;
+  iree_duration_t self_time_ns;
+} iree_vm_bytecode_function_profile_t;
+
 // Per-instance module state.
 // This is allocated with a provided allocator as a single flat allocation.
 // This struct is a prefix to the allocation pointing into the dynamic offsets
@@ -116,13 +139,19 @@ typedef struct iree_vm_bytecode_module_state_t {
   iree_host_size_t import_count;
   iree_vm_bytecode_import_t* import_table;
 
+  // Execution profiles indexed by internal function ordinal. Empty if
+  // IREE_VM_EXECUTION_PROFILING_ENABLE is not set.
+  iree_host_size_t function_profile_count;
+  iree_vm_bytecode_function_profile_t* function_profiles;
+
   // Allocator used for the state itself and any runtime allocations needed.
   iree_allocator_t allocator;
 } iree_vm_bytecode_module_state_t;
 
-// Begins (or resumes) execution of the current frame and continues until
-// either a yield or return. |out_result| will contain the result status for
-// continuation, if needed.
+// Begins execution of |call| and continues until either a yield or return.
+// |out_result| will contain the result status for continuation, if needed.
+// Returns IREE_STATUS_DEFERRED if execution yielded; the frames remain on
+// |stack| and the results are only written once a later resume returns.
 iree_status_t iree_vm_bytecode_dispatch(iree_vm_stack_t* stack,
                                         iree_vm_bytecode_module_t* module,
                                         const iree_vm_function_call_t* call,
@@ -130,6 +159,13 @@ iree_status_t iree_vm_bytecode_dispatch(iree_vm_stack_t* stack,
                                         iree_string_view_t cconv_results,
                                         iree_vm_execution_result_t* out_result);
 
+// Resumes execution of the bytecode frame on the top of |stack| that
+// previously yielded and continues until either another yield or the return
+// of the frame that began the call.
+iree_status_t iree_vm_bytecode_resume(iree_vm_stack_t* stack,
+                                      iree_vm_bytecode_module_t* module,
+                                      iree_vm_execution_result_t* out_result);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -10,10 +10,192 @@
 
 #include "iree/vm/bytecode_module.h"
 
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/base/status_cc.h"
 #include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+// NOTE: include order matters:
+#include "iree/base/internal/flatcc/parsing.h"
+#include "iree/schemas/bytecode_module_def_reader.h"
+
+// Compiled module embedded here to avoid file IO:
+#include "iree/vm/test/all_bytecode_modules.h"
 
 namespace {
 
-// TODO(benvanik): bytecode_module_test.cc for flatbuffer/module implementation.
+// Opcodes from iree/vm/generated/bytecode_op_table.h used to hand-assemble
+// function bodies below.
+constexpr uint8_t kOpConstI32Zero = 0x08;
+constexpr uint8_t kOpConstI32 = 0x09;
+constexpr uint8_t kOpBranch = 0x50;
+constexpr uint8_t kOpCall = 0x52;
+constexpr uint8_t kOpReturn = 0x54;
+
+// Number of i32 registers given to the hand-assembled functions.
+constexpr int16_t kI32RegisterCount = 4;
+
+// Tests that malformed bytecode is rejected when the module is loaded instead
+// of faulting when it is executed. Each test takes a compiled test module and
+// replaces the body of one of its functions with hand-assembled bytecode so
+// that the rest of the module remains valid.
+class BytecodeVerifierTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    IREE_CHECK_OK(iree_vm_register_builtin_types());
+  }
+
+  // Returns a copy of control_flow_ops.vmfb with the body of its longest
+  // function replaced by |bytecode|.
+  std::vector<uint8_t> MakeModuleData(const std::vector<uint8_t>& bytecode) {
+    const struct iree_file_toc_t* module_file = nullptr;
+    const struct iree_file_toc_t* module_file_toc =
+        all_bytecode_modules_c_create();
+    for (size_t i = 0; i < all_bytecode_modules_c_size(); ++i) {
+      if (strcmp(module_file_toc[i].name, "control_flow_ops.vmfb") == 0) {
+        module_file = &module_file_toc[i];
+      }
+    }
+    IREE_CHECK(module_file);
+    std::vector<uint8_t> data(
+        reinterpret_cast<const uint8_t*>(module_file->data),
+        reinterpret_cast<const uint8_t*>(module_file->data) +
+            module_file->size);
+
+    // The accessors return pointers into |data| which we own and can modify.
+    iree_vm_BytecodeModuleDef_table_t module_def =
+        iree_vm_BytecodeModuleDef_as_root(data.data());
+    iree_vm_FunctionDescriptor_vec_t function_descriptors =
+        iree_vm_BytecodeModuleDef_function_descriptors(module_def);
+    iree_vm_FunctionDescriptor_t* descriptor = nullptr;
+    for (size_t i = 0;
+         i < iree_vm_FunctionDescriptor_vec_len(function_descriptors); ++i) {
+      auto* candidate = const_cast<iree_vm_FunctionDescriptor_t*>(
+          iree_vm_FunctionDescriptor_vec_at(function_descriptors, i));
+      if (!descriptor ||
+          candidate->bytecode_length > descriptor->bytecode_length) {
+        descriptor = candidate;
+      }
+    }
+    IREE_CHECK(descriptor);
+    IREE_CHECK_GE(static_cast<size_t>(descriptor->bytecode_length),
+                  bytecode.size());
+
+    uint8_t* bytecode_data = const_cast<uint8_t*>(
+        iree_vm_BytecodeModuleDef_bytecode_data(module_def));
+    memcpy(bytecode_data + descriptor->bytecode_offset, bytecode.data(),
+           bytecode.size());
+    descriptor->bytecode_length = static_cast<int32_t>(bytecode.size());
+    descriptor->i32_register_count = kI32RegisterCount;
+    descriptor->ref_register_count = 0;
+    return data;
+  }
+
+  // Loads a module with the given function |bytecode| and returns the status.
+  iree_status_t LoadModule(const std::vector<uint8_t>& bytecode) {
+    std::vector<uint8_t> data = MakeModuleData(bytecode);
+    iree_vm_module_t* module = nullptr;
+    iree_status_t status = iree_vm_bytecode_module_create(
+        iree_make_const_byte_span(data.data(), data.size()),
+        iree_allocator_null(), iree_allocator_system(), &module);
+    iree_vm_module_release(module);
+    return status;
+  }
+};
+
+// Ensures the test harness itself produces loadable modules.
+TEST_F(BytecodeVerifierTest, ValidFunction) {
+  IREE_EXPECT_OK(LoadModule({
+      kOpConstI32Zero, 0x03, 0x00,  // %i3 = vm.const.i32.zero
+      kOpReturn, 0x00, 0x00,        // vm.return
+  }));
+}
+
+TEST_F(BytecodeVerifierTest, TruncatedOperand) {
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        LoadModule({
+                            kOpConstI32, 0x01, 0x00,  // value cut short
+                        }));
+}
+
+TEST_F(BytecodeVerifierTest, TruncatedRegisterList) {
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        LoadModule({
+                            kOpConstI32Zero, 0x00, 0x00,  //
+                            kOpReturn, 0x02, 0x00,        // 2 registers
+                            0x00, 0x00,                   // only 1 present
+                        }));
+}
+
+TEST_F(BytecodeVerifierTest, MissingTerminator) {
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        LoadModule({
+                            kOpConstI32Zero, 0x00, 0x00,  //
+                            kOpConstI32Zero, 0x01, 0x00,  //
+                        }));
+}
+
+TEST_F(BytecodeVerifierTest, RegisterOutOfRange) {
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        LoadModule({
+                            kOpConstI32Zero, 0x64, 0x00,  // %i100
+                            kOpReturn, 0x00, 0x00,        //
+                        }));
+}
+
+TEST_F(BytecodeVerifierTest, RegisterListOutOfRange) {
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        LoadModule({
+                            kOpConstI32Zero, 0x00, 0x00,  //
+                            kOpReturn, 0x01, 0x00,        //
+                            0x64, 0x00,                   // %i100
+                        }));
+}
+
+TEST_F(BytecodeVerifierTest, BranchTargetOutOfRange) {
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        LoadModule({
+                            kOpBranch, 0x00, 0x10, 0x00, 0x00,  // ^0x1000
+                            0x00,                               // align
+                            0x00, 0x00, 0x00, 0x00,             // no operands
+                        }));
+}
+
+TEST_F(BytecodeVerifierTest, BranchTargetMidInstruction) {
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        LoadModule({
+                            kOpBranch, 0x01, 0x00, 0x00, 0x00,  // ^0x0001
+                            0x00,                               // align
+                            0x00, 0x00, 0x00, 0x00,             // no operands
+                        }));
+}
+
+TEST_F(BytecodeVerifierTest, FunctionOrdinalOutOfRange) {
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        LoadModule({
+                            kOpCall, 0xFF, 0x7F, 0x00, 0x00,  // @0x7FFF
+                            0x00,                             // align
+                            0x00, 0x00,                       // no operands
+                            0x00, 0x00,                       // no results
+                            kOpReturn, 0x00, 0x00, 0x00,      //
+                        }));
+}
+
+TEST_F(BytecodeVerifierTest, ImportOrdinalOutOfRange) {
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        LoadModule({
+                            kOpCall, 0xFF, 0x7F, 0x00, 0x80,  // import 0x7FFF
+                            0x00,                             // align
+                            0x00, 0x00,                       // no operands
+                            0x00, 0x00,                       // no results
+                            kOpReturn, 0x00, 0x00, 0x00,      //
+                        }));
+}
 
 }  // namespace
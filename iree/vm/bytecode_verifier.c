@@ -0,0 +1,1116 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/vm/bytecode_verifier.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "iree/base/internal/math.h"
+#include "iree/base/tracing.h"
+#include "iree/vm/bytecode_dispatch_util.h"
+
+//===----------------------------------------------------------------------===//
+// Verifier state
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_vm_bytecode_verifier_t {
+  iree_vm_bytecode_module_t* module;
+
+  // Sizes of the module tables referenced by ordinal from the bytecode.
+  iree_host_size_t rwdata_storage_capacity;
+  iree_host_size_t global_ref_count;
+  iree_host_size_t rodata_ref_count;
+  iree_host_size_t import_function_count;
+
+  // Function currently being verified.
+  uint16_t function_ordinal;
+  const uint8_t* bytecode_data;
+  iree_vm_source_offset_t bytecode_length;
+  // Register counts as allocated by the interpreter (rounded up to the next
+  // power of two); see iree_vm_bytecode_function_enter.
+  uint32_t i32_register_count;
+  uint32_t ref_register_count;
+
+  // Bitmaps with one bit per byte of the function bytecode marking the
+  // offsets that instructions start at and the offsets that are branched to.
+  uint64_t* instruction_starts;
+  uint64_t* branch_targets;
+} iree_vm_bytecode_verifier_t;
+
+static inline void iree_vm_bytecode_bitmap_set(uint64_t* bitmap,
+                                               iree_vm_source_offset_t i) {
+  bitmap[i / 64] |= 1ull << (i % 64);
+}
+
+//===----------------------------------------------------------------------===//
+// Operand verification
+//===----------------------------------------------------------------------===//
+// These utilities match the VM_Dec* macros in bytecode_dispatch_util.h 1:1 and
+// must be called in the same order the values are decoded by the interpreter.
+// Each macro advances the pc by the number of bytes decoded and returns from
+// the enclosing function if the operand is invalid.
+
+static iree_status_t iree_vm_bytecode_verify_require(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t pc,
+    iree_vm_source_offset_t length, const char* name) {
+  if (IREE_UNLIKELY(pc + length > verifier->bytecode_length)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "functions[%u]+%08" PRIX64
+                            ": %s extends past the end of the function "
+                            "bytecode (length=%" PRId64 ")",
+                            verifier->function_ordinal, pc, name,
+                            verifier->bytecode_length);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_const(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    iree_vm_source_offset_t length, const char* name) {
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_require(verifier, *pc, length, name));
+  *pc += length;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_i32_ordinal(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    const char* name, uint32_t* out_value) {
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_require(verifier, *pc,
+                                                       sizeof(*out_value),
+                                                       name));
+  *out_value = iree_unaligned_load_le((uint32_t*)&verifier->bytecode_data[*pc]);
+  *pc += sizeof(*out_value);
+  return iree_ok_status();
+}
+
+// Verifies a register that is accessed as |width| consecutive i32 registers.
+// Wide registers are aligned to their natural size by the interpreter.
+static iree_status_t iree_vm_bytecode_verify_reg_i32(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    uint16_t width, const char* name) {
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_require(verifier, *pc, kRegSize, name));
+  uint16_t reg =
+      iree_unaligned_load_le((uint16_t*)&verifier->bytecode_data[*pc]);
+  uint32_t end = (uint32_t)(reg & ~(width - 1)) + width;
+  if (IREE_UNLIKELY(end > verifier->i32_register_count)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%u]+%08" PRIX64 ": %s register %u out of range (i32=%u)",
+        verifier->function_ordinal, *pc, name, reg,
+        verifier->i32_register_count);
+  }
+  *pc += kRegSize;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_reg_ref(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    const char* name) {
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_require(verifier, *pc, kRegSize, name));
+  uint16_t reg =
+      iree_unaligned_load_le((uint16_t*)&verifier->bytecode_data[*pc]);
+  if (IREE_UNLIKELY((reg & IREE_REF_REGISTER_MASK) >=
+                    verifier->ref_register_count)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%u]+%08" PRIX64 ": %s register %u out of range (ref=%u)",
+        verifier->function_ordinal, *pc, name, reg & IREE_REF_REGISTER_MASK,
+        verifier->ref_register_count);
+  }
+  *pc += kRegSize;
+  return iree_ok_status();
+}
+
+// Verifies a register of either bank as encoded in register lists.
+static iree_status_t iree_vm_bytecode_verify_list_reg(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t pc,
+    uint16_t reg, const char* name) {
+  if (reg & IREE_REF_REGISTER_TYPE_BIT) {
+    if (IREE_UNLIKELY((reg & IREE_REF_REGISTER_MASK) >=
+                      verifier->ref_register_count)) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "functions[%u]+%08" PRIX64 ": %s register %u out of range (ref=%u)",
+          verifier->function_ordinal, pc, name, reg & IREE_REF_REGISTER_MASK,
+          verifier->ref_register_count);
+    }
+  } else if (IREE_UNLIKELY(reg >= verifier->i32_register_count)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%u]+%08" PRIX64 ": %s register %u out of range (i32=%u)",
+        verifier->function_ordinal, pc, name, reg,
+        verifier->i32_register_count);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_reg_list(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    const char* name) {
+  VM_AlignPC(*pc, kRegSize);
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_require(verifier, *pc, kRegSize, name));
+  const iree_vm_register_list_t* list =
+      (const iree_vm_register_list_t*)&verifier->bytecode_data[*pc];
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_require(
+      verifier, *pc, kRegSize + list->size * kRegSize, name));
+  for (uint16_t i = 0; i < list->size; ++i) {
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_list_reg(
+        verifier, *pc, list->registers[i], name));
+  }
+  *pc += kRegSize + list->size * kRegSize;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_remap_list(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    const char* name) {
+  VM_AlignPC(*pc, kRegSize);
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_require(verifier, *pc, 2 * kRegSize, name));
+  const iree_vm_register_remap_list_t* list =
+      (const iree_vm_register_remap_list_t*)&verifier->bytecode_data[*pc];
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_require(
+      verifier, *pc, 2 * kRegSize + list->size * 2 * kRegSize, name));
+  if (IREE_UNLIKELY(list->i32_size > list->size)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%u]+%08" PRIX64 ": %s i32 pair count %u exceeds size %u",
+        verifier->function_ordinal, *pc, name, list->i32_size, list->size);
+  }
+  for (uint16_t i = 0; i < list->size; ++i) {
+    // The interpreter remaps pairs by bank and ignores the type bit.
+    uint16_t type_bit = i < list->i32_size ? 0 : IREE_REF_REGISTER_TYPE_BIT;
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_list_reg(
+        verifier, *pc, list->pairs[i].src_reg | type_bit, name));
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_list_reg(
+        verifier, *pc, list->pairs[i].dst_reg | type_bit, name));
+  }
+  *pc += 2 * kRegSize + list->size * 2 * kRegSize;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_branch_target(
+    iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    const char* name) {
+  uint32_t target = 0;
+  iree_vm_source_offset_t operand_pc = *pc;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_i32_ordinal(verifier, pc, name, &target));
+  if (IREE_UNLIKELY(target >= verifier->bytecode_length)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "functions[%u]+%08" PRIX64
+                            ": %s branch target %08X out of range",
+                            verifier->function_ordinal, operand_pc, name,
+                            target);
+  }
+  // Checked against instruction starts once the whole function is decoded.
+  iree_vm_bytecode_bitmap_set(verifier->branch_targets, target);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_global_attr(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    iree_host_size_t value_size, const char* name) {
+  uint32_t byte_offset = 0;
+  iree_vm_source_offset_t operand_pc = *pc;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_i32_ordinal(verifier, pc, name, &byte_offset));
+  if (IREE_UNLIKELY(byte_offset + value_size >
+                    verifier->rwdata_storage_capacity)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%u]+%08" PRIX64
+        ": %s byte_offset out of range: %u+%zu (rwdata=%zu)",
+        verifier->function_ordinal, operand_pc, name, byte_offset, value_size,
+        verifier->rwdata_storage_capacity);
+  }
+  return iree_ok_status();
+}
+
+// Verifies that an ordinal decoded from the bytecode is less than |count|.
+static iree_status_t iree_vm_bytecode_verify_table_ordinal(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    iree_host_size_t count, const char* table_name, const char* name) {
+  uint32_t ordinal = 0;
+  iree_vm_source_offset_t operand_pc = *pc;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_i32_ordinal(verifier, pc, name, &ordinal));
+  if (IREE_UNLIKELY(ordinal >= count)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%u]+%08" PRIX64 ": %s %s ordinal out of range: %u (%zu)",
+        verifier->function_ordinal, operand_pc, name, table_name, ordinal,
+        count);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_func_attr(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    bool require_import, const char* name) {
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_require(verifier, *pc, sizeof(uint32_t), name));
+  uint32_t function_ordinal =
+      iree_unaligned_load_le((uint32_t*)&verifier->bytecode_data[*pc]);
+  bool is_import = (function_ordinal & 0x80000000u) != 0;
+  if (is_import) {
+    function_ordinal &= 0x7FFFFFFFu;
+    if (IREE_UNLIKELY(function_ordinal >= verifier->import_function_count)) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "functions[%u]+%08" PRIX64 ": %s import ordinal out of range: %u "
+          "(%zu)",
+          verifier->function_ordinal, *pc, name, function_ordinal,
+          verifier->import_function_count);
+    }
+  } else if (IREE_UNLIKELY(require_import)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "functions[%u]+%08" PRIX64
+                            ": %s variadic calls are only supported for "
+                            "imported callees",
+                            verifier->function_ordinal, *pc, name);
+  } else if (IREE_UNLIKELY(function_ordinal >=
+                           verifier->module->function_descriptor_count)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%u]+%08" PRIX64 ": %s function ordinal out of range: %u "
+        "(%zu)",
+        verifier->function_ordinal, *pc, name, function_ordinal,
+        verifier->module->function_descriptor_count);
+  }
+  *pc += sizeof(uint32_t);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_str_attr(
+    const iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* pc,
+    const char* name) {
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_require(verifier, *pc, sizeof(uint16_t), name));
+  uint16_t length =
+      iree_unaligned_load_le((uint16_t*)&verifier->bytecode_data[*pc]);
+  return iree_vm_bytecode_verify_const(verifier, pc, sizeof(uint16_t) + length,
+                                       name);
+}
+
+#define VM_VerifyConstI8(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_const(verifier, &pc, 1, name))
+#define VM_VerifyConstI32(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_const(verifier, &pc, 4, name))
+#define VM_VerifyConstI64(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_const(verifier, &pc, 8, name))
+#define VM_VerifyFuncAttr(name)                           \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_func_attr( \
+      verifier, &pc, /*require_import=*/false, name))
+#define VM_VerifyImportAttr(name)                         \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_func_attr( \
+      verifier, &pc, /*require_import=*/true, name))
+#define VM_VerifyGlobalAttr(name, value_size)                             \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_global_attr(verifier, &pc, \
+                                                           value_size, name))
+#define VM_VerifyGlobalRefAttr(name)                          \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_table_ordinal( \
+      verifier, &pc, verifier->global_ref_count, "global ref", name))
+#define VM_VerifyRodataAttr(name)                             \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_table_ordinal( \
+      verifier, &pc, verifier->rodata_ref_count, "rodata", name))
+#define VM_VerifyTypeOf(name)                                 \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_table_ordinal( \
+      verifier, &pc, verifier->module->type_count, "type", name))
+#define VM_VerifyIntAttr32(name) VM_VerifyConstI32(name)
+#define VM_VerifyIntAttr64(name) VM_VerifyConstI64(name)
+#define VM_VerifyFloatAttr32(name) VM_VerifyConstI32(name)
+#define VM_VerifyFloatAttr64(name) VM_VerifyConstI64(name)
+#define VM_VerifyStrAttr(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_str_attr(verifier, &pc, name))
+#define VM_VerifyBranchTarget(name) \
+  IREE_RETURN_IF_ERROR(             \
+      iree_vm_bytecode_verify_branch_target(verifier, &pc, name))
+#define VM_VerifyBranchOperands(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_remap_list(verifier, &pc, name))
+#define VM_VerifyOperandRegI32(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_reg_i32(verifier, &pc, 1, name))
+#define VM_VerifyOperandRegI64(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_reg_i32(verifier, &pc, 2, name))
+#define VM_VerifyOperandRegF32(name) VM_VerifyOperandRegI32(name)
+#define VM_VerifyOperandRegF64(name) VM_VerifyOperandRegI64(name)
+#define VM_VerifyOperandRegRef(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_reg_ref(verifier, &pc, name))
+#define VM_VerifyVariadicOperands(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_reg_list(verifier, &pc, name))
+#define VM_VerifyResultRegI32(name) VM_VerifyOperandRegI32(name)
+#define VM_VerifyResultRegI64(name) VM_VerifyOperandRegI64(name)
+#define VM_VerifyResultRegF32(name) VM_VerifyOperandRegF32(name)
+#define VM_VerifyResultRegF64(name) VM_VerifyOperandRegF64(name)
+#define VM_VerifyResultRegRef(name) VM_VerifyOperandRegRef(name)
+#define VM_VerifyVariadicResults(name) VM_VerifyVariadicOperands(name)
+
+//===----------------------------------------------------------------------===//
+// Instruction verification
+//===----------------------------------------------------------------------===//
+
+#define VERIFY_OP(ext, op_name) case IREE_VM_OP_##ext##_##op_name:
+
+#define BEGIN_VERIFY_PREFIX(op_name, ext) \
+  case IREE_VM_OP_CORE_##op_name: {       \
+    VM_VerifyConstI8("opcode");           \
+    switch (verifier->bytecode_data[pc - 1]) {
+#define END_VERIFY_PREFIX()                                      \
+  default:                                                       \
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,        \
+                            "functions[%u]+%08" PRIX64           \
+                            ": unhandled ext opcode",            \
+                            verifier->function_ordinal, pc - 1); \
+    }                                                            \
+    break;                                                       \
+    }
+#define UNHANDLED_VERIFY_PREFIX(op_name, ext)                       \
+  case IREE_VM_OP_CORE_##op_name: {                                 \
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,              \
+                            "functions[%u]+%08" PRIX64              \
+                            ": unhandled dispatch extension " #ext, \
+                            verifier->function_ordinal, pc - 1);    \
+  }
+
+// Verifies the instruction at |*inout_pc| and advances it to the next one.
+// |out_is_terminator| is set if the instruction never falls through.
+static iree_status_t iree_vm_bytecode_verify_op(
+    iree_vm_bytecode_verifier_t* verifier, iree_vm_source_offset_t* inout_pc,
+    bool* out_is_terminator) {
+  iree_vm_source_offset_t pc = *inout_pc;
+  bool is_terminator = false;
+  VM_VerifyConstI8("opcode");
+  switch (verifier->bytecode_data[pc - 1]) {
+    VERIFY_OP(CORE, GlobalLoadI32) {
+      VM_VerifyGlobalAttr("global", sizeof(int32_t));
+      VM_VerifyResultRegI32("value");
+      break;
+    }
+    VERIFY_OP(CORE, GlobalStoreI32) {
+      VM_VerifyGlobalAttr("global", sizeof(int32_t));
+      VM_VerifyOperandRegI32("value");
+      break;
+    }
+    VERIFY_OP(CORE, GlobalLoadIndirectI32) {
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyResultRegI32("value");
+      break;
+    }
+    VERIFY_OP(CORE, GlobalStoreIndirectI32) {
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyOperandRegI32("value");
+      break;
+    }
+    VERIFY_OP(CORE, GlobalLoadRef) {
+      VM_VerifyGlobalRefAttr("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyResultRegRef("value");
+      break;
+    }
+    VERIFY_OP(CORE, GlobalStoreRef) {
+      VM_VerifyGlobalRefAttr("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyOperandRegRef("value");
+      break;
+    }
+    VERIFY_OP(CORE, GlobalLoadIndirectRef) {
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyResultRegRef("value");
+      break;
+    }
+    VERIFY_OP(CORE, GlobalStoreIndirectRef) {
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyOperandRegRef("value");
+      break;
+    }
+    VERIFY_OP(CORE, ConstI32) {
+      VM_VerifyIntAttr32("value");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, ConstI32Zero) {
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, ConstRefZero) {
+      VM_VerifyResultRegRef("result");
+      break;
+    }
+    VERIFY_OP(CORE, ConstRefRodata) {
+      VM_VerifyRodataAttr("rodata");
+      VM_VerifyResultRegRef("value");
+      break;
+    }
+    VERIFY_OP(CORE, BufferAlloc) {
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyResultRegRef("result");
+      break;
+    }
+    VERIFY_OP(CORE, BufferClone) {
+      VM_VerifyOperandRegRef("source");
+      VM_VerifyOperandRegI32("offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyResultRegRef("result");
+      break;
+    }
+    VERIFY_OP(CORE, BufferLength) {
+      VM_VerifyOperandRegRef("buffer");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, BufferCopy) {
+      VM_VerifyOperandRegRef("source_buffer");
+      VM_VerifyOperandRegI32("source_offset");
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("length");
+      break;
+    }
+    VERIFY_OP(CORE, BufferCompare) {
+      VM_VerifyOperandRegRef("lhs_buffer");
+      VM_VerifyOperandRegI32("lhs_offset");
+      VM_VerifyOperandRegRef("rhs_buffer");
+      VM_VerifyOperandRegI32("rhs_offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, BufferFillI8)
+    VERIFY_OP(CORE, BufferFillI16)
+    VERIFY_OP(CORE, BufferFillI32) {
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyOperandRegI32("value");
+      break;
+    }
+    VERIFY_OP(CORE, BufferLoadI8U)
+    VERIFY_OP(CORE, BufferLoadI8S)
+    VERIFY_OP(CORE, BufferLoadI16U)
+    VERIFY_OP(CORE, BufferLoadI16S)
+    VERIFY_OP(CORE, BufferLoadI32) {
+      VM_VerifyOperandRegRef("source_buffer");
+      VM_VerifyOperandRegI32("source_offset");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, BufferStoreI8)
+    VERIFY_OP(CORE, BufferStoreI16)
+    VERIFY_OP(CORE, BufferStoreI32) {
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("value");
+      break;
+    }
+    VERIFY_OP(CORE, ListAlloc) {
+      VM_VerifyTypeOf("element_type");
+      VM_VerifyOperandRegI32("initial_capacity");
+      VM_VerifyResultRegRef("result");
+      break;
+    }
+    VERIFY_OP(CORE, ListReserve) {
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("minimum_capacity");
+      break;
+    }
+    VERIFY_OP(CORE, ListSize) {
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, ListResize) {
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("new_size");
+      break;
+    }
+    VERIFY_OP(CORE, ListGetI32) {
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, ListSetI32) {
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyOperandRegI32("raw_value");
+      break;
+    }
+    VERIFY_OP(CORE, ListGetRef) {
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyTypeOf("result");
+      VM_VerifyResultRegRef("result");
+      break;
+    }
+    VERIFY_OP(CORE, ListSetRef) {
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyOperandRegRef("value");
+      break;
+    }
+    VERIFY_OP(CORE, SelectI32) {
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyOperandRegI32("true_value");
+      VM_VerifyOperandRegI32("false_value");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, SelectRef) {
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyTypeOf("true_value");
+      VM_VerifyOperandRegRef("true_value");
+      VM_VerifyOperandRegRef("false_value");
+      VM_VerifyResultRegRef("result");
+      break;
+    }
+    VERIFY_OP(CORE, SwitchI32) {
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyIntAttr32("default_value");
+      VM_VerifyVariadicOperands("values");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, SwitchRef) {
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyTypeOf("result");
+      VM_VerifyOperandRegRef("default_value");
+      VM_VerifyVariadicOperands("values");
+      VM_VerifyResultRegRef("result");
+      break;
+    }
+    VERIFY_OP(CORE, AddI32)
+    VERIFY_OP(CORE, SubI32)
+    VERIFY_OP(CORE, MulI32)
+    VERIFY_OP(CORE, DivI32S)
+    VERIFY_OP(CORE, DivI32U)
+    VERIFY_OP(CORE, RemI32S)
+    VERIFY_OP(CORE, RemI32U)
+    VERIFY_OP(CORE, AndI32)
+    VERIFY_OP(CORE, OrI32)
+    VERIFY_OP(CORE, XorI32)
+    VERIFY_OP(CORE, CmpEQI32)
+    VERIFY_OP(CORE, CmpNEI32)
+    VERIFY_OP(CORE, CmpLTI32S)
+    VERIFY_OP(CORE, CmpLTI32U) {
+      VM_VerifyOperandRegI32("lhs");
+      VM_VerifyOperandRegI32("rhs");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, FMAI32) {
+      VM_VerifyOperandRegI32("a");
+      VM_VerifyOperandRegI32("b");
+      VM_VerifyOperandRegI32("c");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, NotI32)
+    VERIFY_OP(CORE, TruncI32I8)
+    VERIFY_OP(CORE, TruncI32I16)
+    VERIFY_OP(CORE, ExtI8I32S)
+    VERIFY_OP(CORE, ExtI8I32U)
+    VERIFY_OP(CORE, ExtI16I32S)
+    VERIFY_OP(CORE, ExtI16I32U)
+    VERIFY_OP(CORE, CmpNZI32) {
+      VM_VerifyOperandRegI32("operand");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, ShlI32)
+    VERIFY_OP(CORE, ShrI32S)
+    VERIFY_OP(CORE, ShrI32U) {
+      VM_VerifyOperandRegI32("operand");
+      VM_VerifyOperandRegI32("amount");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, CmpEQRef)
+    VERIFY_OP(CORE, CmpNERef) {
+      VM_VerifyOperandRegRef("lhs");
+      VM_VerifyOperandRegRef("rhs");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, CmpNZRef) {
+      VM_VerifyOperandRegRef("operand");
+      VM_VerifyResultRegI32("result");
+      break;
+    }
+    VERIFY_OP(CORE, Branch)
+    VERIFY_OP(CORE, Yield)
+    VERIFY_OP(CORE, Break) {
+      VM_VerifyBranchTarget("dest");
+      VM_VerifyBranchOperands("operands");
+      is_terminator = true;
+      break;
+    }
+    VERIFY_OP(CORE, CondBranch) {
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyBranchTarget("true_dest");
+      VM_VerifyBranchOperands("true_operands");
+      VM_VerifyBranchTarget("false_dest");
+      VM_VerifyBranchOperands("false_operands");
+      is_terminator = true;
+      break;
+    }
+    VERIFY_OP(CORE, CondBranchCmpEQI32)
+    VERIFY_OP(CORE, CondBranchCmpNEI32)
+    VERIFY_OP(CORE, CondBranchCmpLTI32S)
+    VERIFY_OP(CORE, CondBranchCmpLTI32U) {
+      VM_VerifyOperandRegI32("lhs");
+      VM_VerifyOperandRegI32("rhs");
+      VM_VerifyBranchTarget("true_dest");
+      VM_VerifyBranchOperands("true_operands");
+      VM_VerifyBranchTarget("false_dest");
+      VM_VerifyBranchOperands("false_operands");
+      is_terminator = true;
+      break;
+    }
+    VERIFY_OP(CORE, Call) {
+      VM_VerifyFuncAttr("callee");
+      VM_VerifyVariadicOperands("operands");
+      VM_VerifyVariadicResults("results");
+      break;
+    }
+    VERIFY_OP(CORE, CallVariadic) {
+      VM_VerifyImportAttr("callee");
+      VM_VerifyVariadicOperands("segment_sizes");
+      VM_VerifyVariadicOperands("operands");
+      VM_VerifyVariadicResults("results");
+      break;
+    }
+    VERIFY_OP(CORE, Return) {
+      VM_VerifyVariadicOperands("operands");
+      is_terminator = true;
+      break;
+    }
+    VERIFY_OP(CORE, Fail) {
+      VM_VerifyOperandRegI32("status");
+      VM_VerifyStrAttr("message");
+      is_terminator = true;
+      break;
+    }
+    VERIFY_OP(CORE, Trace)
+    VERIFY_OP(CORE, Print) {
+      VM_VerifyStrAttr("event_name");
+      VM_VerifyVariadicOperands("operands");
+      break;
+    }
+    VERIFY_OP(CORE, CondBreak) {
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyBranchTarget("dest");
+      VM_VerifyBranchOperands("operands");
+      is_terminator = true;
+      break;
+    }
+
+    //===------------------------------------------------------------------===//
+    // Extension trampolines
+    //===------------------------------------------------------------------===//
+
+#if IREE_VM_EXT_I64_ENABLE
+    BEGIN_VERIFY_PREFIX(PrefixExtI64, EXT_I64)
+        VERIFY_OP(EXT_I64, GlobalLoadI64) {
+          VM_VerifyGlobalAttr("global", sizeof(int64_t));
+          VM_VerifyResultRegI64("value");
+          break;
+        }
+        VERIFY_OP(EXT_I64, GlobalStoreI64) {
+          VM_VerifyGlobalAttr("global", sizeof(int64_t));
+          VM_VerifyOperandRegI64("value");
+          break;
+        }
+        VERIFY_OP(EXT_I64, GlobalLoadIndirectI64) {
+          VM_VerifyOperandRegI32("global");
+          VM_VerifyResultRegI64("value");
+          break;
+        }
+        VERIFY_OP(EXT_I64, GlobalStoreIndirectI64) {
+          VM_VerifyOperandRegI32("global");
+          VM_VerifyOperandRegI64("value");
+          break;
+        }
+        VERIFY_OP(EXT_I64, ConstI64) {
+          VM_VerifyIntAttr64("value");
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, ConstI64Zero) {
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, ListGetI64) {
+          VM_VerifyOperandRegRef("list");
+          VM_VerifyOperandRegI32("index");
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, ListSetI64) {
+          VM_VerifyOperandRegRef("list");
+          VM_VerifyOperandRegI32("index");
+          VM_VerifyOperandRegI64("value");
+          break;
+        }
+        VERIFY_OP(EXT_I64, SelectI64) {
+          VM_VerifyOperandRegI32("condition");
+          VM_VerifyOperandRegI64("true_value");
+          VM_VerifyOperandRegI64("false_value");
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, SwitchI64) {
+          VM_VerifyOperandRegI32("index");
+          VM_VerifyIntAttr64("default_value");
+          VM_VerifyVariadicOperands("values");
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, AddI64)
+        VERIFY_OP(EXT_I64, SubI64)
+        VERIFY_OP(EXT_I64, MulI64)
+        VERIFY_OP(EXT_I64, DivI64S)
+        VERIFY_OP(EXT_I64, DivI64U)
+        VERIFY_OP(EXT_I64, RemI64S)
+        VERIFY_OP(EXT_I64, RemI64U)
+        VERIFY_OP(EXT_I64, AndI64)
+        VERIFY_OP(EXT_I64, OrI64)
+        VERIFY_OP(EXT_I64, XorI64) {
+          VM_VerifyOperandRegI64("lhs");
+          VM_VerifyOperandRegI64("rhs");
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, FMAI64) {
+          VM_VerifyOperandRegI64("a");
+          VM_VerifyOperandRegI64("b");
+          VM_VerifyOperandRegI64("c");
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, NotI64) {
+          VM_VerifyOperandRegI64("operand");
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, TruncI64I32)
+        VERIFY_OP(EXT_I64, CmpNZI64) {
+          VM_VerifyOperandRegI64("operand");
+          VM_VerifyResultRegI32("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, ExtI32I64S)
+        VERIFY_OP(EXT_I64, ExtI32I64U) {
+          VM_VerifyOperandRegI32("operand");
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, ShlI64)
+        VERIFY_OP(EXT_I64, ShrI64S)
+        VERIFY_OP(EXT_I64, ShrI64U) {
+          VM_VerifyOperandRegI64("operand");
+          VM_VerifyOperandRegI32("amount");
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, CmpEQI64)
+        VERIFY_OP(EXT_I64, CmpNEI64)
+        VERIFY_OP(EXT_I64, CmpLTI64S)
+        VERIFY_OP(EXT_I64, CmpLTI64U) {
+          VM_VerifyOperandRegI64("lhs");
+          VM_VerifyOperandRegI64("rhs");
+          VM_VerifyResultRegI32("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, BufferFillI64) {
+          VM_VerifyOperandRegRef("target_buffer");
+          VM_VerifyOperandRegI32("target_offset");
+          VM_VerifyOperandRegI32("length");
+          VM_VerifyOperandRegI64("value");
+          break;
+        }
+        VERIFY_OP(EXT_I64, BufferLoadI64) {
+          VM_VerifyOperandRegRef("source_buffer");
+          VM_VerifyOperandRegI32("source_offset");
+          VM_VerifyResultRegI64("result");
+          break;
+        }
+        VERIFY_OP(EXT_I64, BufferStoreI64) {
+          VM_VerifyOperandRegRef("target_buffer");
+          VM_VerifyOperandRegI32("target_offset");
+          VM_VerifyOperandRegI64("value");
+          break;
+        }
+    END_VERIFY_PREFIX()
+#else
+    UNHANDLED_VERIFY_PREFIX(PrefixExtI64, EXT_I64)
+#endif  // IREE_VM_EXT_I64_ENABLE
+
+#if IREE_VM_EXT_F32_ENABLE
+    BEGIN_VERIFY_PREFIX(PrefixExtF32, EXT_F32)
+        VERIFY_OP(EXT_F32, GlobalLoadF32) {
+          VM_VerifyGlobalAttr("global", sizeof(float));
+          VM_VerifyResultRegF32("value");
+          break;
+        }
+        VERIFY_OP(EXT_F32, GlobalStoreF32) {
+          VM_VerifyGlobalAttr("global", sizeof(float));
+          VM_VerifyOperandRegF32("value");
+          break;
+        }
+        VERIFY_OP(EXT_F32, GlobalLoadIndirectF32) {
+          VM_VerifyOperandRegI32("global");
+          VM_VerifyResultRegF32("value");
+          break;
+        }
+        VERIFY_OP(EXT_F32, GlobalStoreIndirectF32) {
+          VM_VerifyOperandRegI32("global");
+          VM_VerifyOperandRegF32("value");
+          break;
+        }
+        VERIFY_OP(EXT_F32, ConstF32) {
+          VM_VerifyFloatAttr32("value");
+          VM_VerifyResultRegF32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, ConstF32Zero) {
+          VM_VerifyResultRegF32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, ListGetF32) {
+          VM_VerifyOperandRegRef("list");
+          VM_VerifyOperandRegI32("index");
+          VM_VerifyResultRegF32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, ListSetF32) {
+          VM_VerifyOperandRegRef("list");
+          VM_VerifyOperandRegI32("index");
+          VM_VerifyOperandRegF32("value");
+          break;
+        }
+        VERIFY_OP(EXT_F32, SelectF32) {
+          VM_VerifyOperandRegI32("condition");
+          VM_VerifyOperandRegF32("true_value");
+          VM_VerifyOperandRegF32("false_value");
+          VM_VerifyResultRegF32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, SwitchF32) {
+          VM_VerifyOperandRegI32("index");
+          VM_VerifyFloatAttr32("default_value");
+          VM_VerifyVariadicOperands("values");
+          VM_VerifyResultRegF32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, AddF32)
+        VERIFY_OP(EXT_F32, SubF32)
+        VERIFY_OP(EXT_F32, MulF32)
+        VERIFY_OP(EXT_F32, DivF32)
+        VERIFY_OP(EXT_F32, RemF32)
+        VERIFY_OP(EXT_F32, Atan2F32)
+        VERIFY_OP(EXT_F32, PowF32) {
+          VM_VerifyOperandRegF32("lhs");
+          VM_VerifyOperandRegF32("rhs");
+          VM_VerifyResultRegF32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, FMAF32) {
+          VM_VerifyOperandRegF32("a");
+          VM_VerifyOperandRegF32("b");
+          VM_VerifyOperandRegF32("c");
+          VM_VerifyResultRegF32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, AbsF32)
+        VERIFY_OP(EXT_F32, NegF32)
+        VERIFY_OP(EXT_F32, CeilF32)
+        VERIFY_OP(EXT_F32, FloorF32)
+        VERIFY_OP(EXT_F32, AtanF32)
+        VERIFY_OP(EXT_F32, CosF32)
+        VERIFY_OP(EXT_F32, SinF32)
+        VERIFY_OP(EXT_F32, ExpF32)
+        VERIFY_OP(EXT_F32, Exp2F32)
+        VERIFY_OP(EXT_F32, ExpM1F32)
+        VERIFY_OP(EXT_F32, LogF32)
+        VERIFY_OP(EXT_F32, Log10F32)
+        VERIFY_OP(EXT_F32, Log1pF32)
+        VERIFY_OP(EXT_F32, Log2F32)
+        VERIFY_OP(EXT_F32, RsqrtF32)
+        VERIFY_OP(EXT_F32, SqrtF32)
+        VERIFY_OP(EXT_F32, TanhF32)
+        VERIFY_OP(EXT_F32, ErfF32) {
+          VM_VerifyOperandRegF32("operand");
+          VM_VerifyResultRegF32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, CastSI32F32)
+        VERIFY_OP(EXT_F32, CastUI32F32)
+        VERIFY_OP(EXT_F32, BitcastI32F32) {
+          VM_VerifyOperandRegI32("operand");
+          VM_VerifyResultRegF32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, CastF32SI32)
+        VERIFY_OP(EXT_F32, CastF32UI32)
+        VERIFY_OP(EXT_F32, BitcastF32I32)
+        VERIFY_OP(EXT_F32, CmpNaNF32) {
+          VM_VerifyOperandRegF32("operand");
+          VM_VerifyResultRegI32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, CmpEQF32O)
+        VERIFY_OP(EXT_F32, CmpEQF32U)
+        VERIFY_OP(EXT_F32, CmpNEF32O)
+        VERIFY_OP(EXT_F32, CmpNEF32U)
+        VERIFY_OP(EXT_F32, CmpLTF32O)
+        VERIFY_OP(EXT_F32, CmpLTF32U)
+        VERIFY_OP(EXT_F32, CmpLTEF32O)
+        VERIFY_OP(EXT_F32, CmpLTEF32U) {
+          VM_VerifyOperandRegF32("lhs");
+          VM_VerifyOperandRegF32("rhs");
+          VM_VerifyResultRegI32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, BufferFillF32) {
+          VM_VerifyOperandRegRef("target_buffer");
+          VM_VerifyOperandRegI32("target_offset");
+          VM_VerifyOperandRegI32("length");
+          VM_VerifyOperandRegF32("value");
+          break;
+        }
+        VERIFY_OP(EXT_F32, BufferLoadF32) {
+          VM_VerifyOperandRegRef("source_buffer");
+          VM_VerifyOperandRegI32("source_offset");
+          VM_VerifyResultRegF32("result");
+          break;
+        }
+        VERIFY_OP(EXT_F32, BufferStoreF32) {
+          VM_VerifyOperandRegRef("target_buffer");
+          VM_VerifyOperandRegI32("target_offset");
+          VM_VerifyOperandRegF32("value");
+          break;
+        }
+    END_VERIFY_PREFIX()
+#else
+    UNHANDLED_VERIFY_PREFIX(PrefixExtF32, EXT_F32)
+#endif  // IREE_VM_EXT_F32_ENABLE
+
+    UNHANDLED_VERIFY_PREFIX(PrefixExtF64, EXT_F64)
+
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "functions[%u]+%08" PRIX64
+                              ": unhandled core opcode",
+                              verifier->function_ordinal, pc - 1);
+  }
+  *inout_pc = pc;
+  *out_is_terminator = is_terminator;
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Function and module verification
+//===----------------------------------------------------------------------===//
+
+static iree_status_t iree_vm_bytecode_verify_function(
+    iree_vm_bytecode_verifier_t* verifier, uint16_t function_ordinal) {
+  const iree_vm_FunctionDescriptor_t* descriptor =
+      &verifier->module->function_descriptor_table[function_ordinal];
+  verifier->function_ordinal = function_ordinal;
+  verifier->bytecode_data =
+      verifier->module->bytecode_data.data + descriptor->bytecode_offset;
+  verifier->bytecode_length = descriptor->bytecode_length;
+  verifier->i32_register_count = iree_math_round_up_to_pow2_u32(
+      VMMAX(1, descriptor->i32_register_count));
+  verifier->ref_register_count = iree_math_round_up_to_pow2_u32(
+      VMMAX(1, descriptor->ref_register_count));
+  iree_host_size_t bitmap_length = (verifier->bytecode_length + 63) / 64;
+  memset(verifier->instruction_starts, 0, bitmap_length * sizeof(uint64_t));
+  memset(verifier->branch_targets, 0, bitmap_length * sizeof(uint64_t));
+
+  iree_vm_source_offset_t pc = 0;
+  bool is_terminator = false;
+  while (pc < verifier->bytecode_length) {
+    iree_vm_bytecode_bitmap_set(verifier->instruction_starts, pc);
+    IREE_RETURN_IF_ERROR(
+        iree_vm_bytecode_verify_op(verifier, &pc, &is_terminator));
+  }
+  if (IREE_UNLIKELY(!is_terminator)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "functions[%u] bytecode does not end with a "
+                            "terminator",
+                            function_ordinal);
+  }
+
+  for (iree_host_size_t i = 0; i < bitmap_length; ++i) {
+    uint64_t invalid_targets =
+        verifier->branch_targets[i] & ~verifier->instruction_starts[i];
+    if (IREE_UNLIKELY(invalid_targets)) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "functions[%u] branch target %08" PRIX64
+          " is not the start of an instruction",
+          function_ordinal,
+          (uint64_t)(i * 64 +
+                     iree_math_count_trailing_zeros_u64(invalid_targets)));
+    }
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_vm_bytecode_verify_module(
+    iree_vm_bytecode_module_t* module) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_bytecode_verifier_t verifier;
+  memset(&verifier, 0, sizeof(verifier));
+  verifier.module = module;
+  iree_vm_ModuleStateDef_table_t module_state_def =
+      iree_vm_BytecodeModuleDef_module_state(module->def);
+  if (module_state_def) {
+    verifier.rwdata_storage_capacity =
+        iree_vm_ModuleStateDef_global_bytes_capacity(module_state_def);
+    verifier.global_ref_count =
+        iree_vm_ModuleStateDef_global_ref_count(module_state_def);
+  }
+  verifier.rodata_ref_count = iree_vm_RodataSegmentDef_vec_len(
+      iree_vm_BytecodeModuleDef_rodata_segments(module->def));
+  verifier.import_function_count = iree_vm_ImportFunctionDef_vec_len(
+      iree_vm_BytecodeModuleDef_imported_functions(module->def));
+
+  // Bitmaps are sized for the largest function and reused for all of them.
+  iree_host_size_t max_bitmap_length = 0;
+  for (iree_host_size_t i = 0; i < module->function_descriptor_count; ++i) {
+    iree_host_size_t bitmap_length =
+        (module->function_descriptor_table[i].bytecode_length + 63) / 64;
+    max_bitmap_length = iree_max(max_bitmap_length, bitmap_length);
+  }
+  uint64_t* bitmaps = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(module->allocator,
+                                VMMAX(1, 2 * max_bitmap_length) *
+                                    sizeof(uint64_t),
+                                (void**)&bitmaps));
+  verifier.instruction_starts = bitmaps;
+  verifier.branch_targets = bitmaps + max_bitmap_length;
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < module->function_descriptor_count; ++i) {
+    status = iree_vm_bytecode_verify_function(&verifier, (uint16_t)i);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  iree_allocator_free(module->allocator, bitmaps);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,35 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_VM_BYTECODE_VERIFIER_H_
+#define IREE_VM_BYTECODE_VERIFIER_H_
+
+#include "iree/base/api.h"
+#include "iree/vm/bytecode_module_impl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Verifies the bytecode of all internal functions in |module|.
+// Each instruction is decoded once and checked to ensure that:
+//  - all instructions and their operands lie within the function bytecode;
+//  - register ordinals are within the register banks of the function;
+//  - branch targets are the start of an instruction within the function;
+//  - global, rodata, type, and function ordinals are within the module tables;
+//  - the bytecode ends with a terminator so execution never runs off the end.
+//
+// The interpreter relies on these properties when
+// IREE_VM_BYTECODE_VERIFICATION_ENABLE is set and skips the matching checks
+// during dispatch. Only dynamic values (such as indirect global offsets and
+// refs) are checked at runtime.
+iree_status_t iree_vm_bytecode_verify_module(iree_vm_bytecode_module_t* module);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_VM_BYTECODE_VERIFIER_H_
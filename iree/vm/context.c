@@ -7,7 +7,9 @@
 #include "iree/vm/context.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "iree/base/internal/atomics.h"
@@ -27,6 +29,9 @@ struct iree_vm_context_t {
   // Configuration flags.
   iree_vm_context_flags_t flags;
 
+  // Stacks reused across invocations within the context.
+  iree_vm_stack_pool_t* stack_pool;
+
   struct {
     iree_host_size_t count;
     iree_host_size_t capacity;
@@ -69,6 +74,19 @@ static iree_status_t iree_vm_context_run_function(
   return status;
 }
 
+// Returns the invocation flags implied by the |context| flags.
+static iree_vm_invocation_flags_t iree_vm_context_invocation_flags(
+    const iree_vm_context_t* context) {
+  iree_vm_invocation_flags_t flags = IREE_VM_INVOCATION_FLAG_NONE;
+  if (context->flags & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION) {
+    flags |= IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION;
+  }
+  if (context->flags & IREE_VM_CONTEXT_FLAG_PROFILE_EXECUTION) {
+    flags |= IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION;
+  }
+  return flags;
+}
+
 static iree_status_t iree_vm_context_query_module_state(
     void* state_resolver, iree_vm_module_t* module,
     iree_vm_module_state_t** out_module_state) {
@@ -148,9 +166,18 @@ static iree_status_t iree_vm_context_resolve_module_imports(
           import_signature.calling_convention.data);
     }
 
+    // Resolve the state of the module providing the import once here so that
+    // calls need not query it again. The providing module was registered
+    // earlier and its state lives as long as the importing module state.
+    iree_vm_module_state_t* import_module_state = NULL;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_vm_context_query_module_state(context, import_function.module,
+                                               &import_module_state));
+
     IREE_RETURN_AND_END_ZONE_IF_ERROR(
         z0, module->resolve_import(module->self, module_state, i,
-                                   &import_function, &import_signature));
+                                   &import_function, import_module_state,
+                                   &import_signature));
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -164,10 +191,7 @@ static void iree_vm_context_release_modules(iree_vm_context_t* context,
 
   // Run module __deinit functions, if present (in reverse init order).
   IREE_VM_INLINE_STACK_INITIALIZE(
-      stack,
-      context->flags & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION
-          ? IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION
-          : IREE_VM_INVOCATION_FLAG_NONE,
+      stack, iree_vm_context_invocation_flags(context),
       iree_vm_context_state_resolver(context), context->allocator);
   for (int i = (int)end; i >= (int)start; --i) {
     iree_vm_module_t* module = context->list.modules[i];
@@ -209,20 +233,19 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create(
                                              allocator, out_context);
 }
 
-IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
+// Allocates a context with storage for |module_count| modules.
+// Contexts with a non-zero |module_count| are static and frozen from creation.
+static iree_status_t iree_vm_context_allocate(
     iree_vm_instance_t* instance, iree_vm_context_flags_t flags,
-    iree_vm_module_t** modules, iree_host_size_t module_count,
-    iree_allocator_t allocator, iree_vm_context_t** out_context) {
-  IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_ASSERT_ARGUMENT(out_context);
-  *out_context = NULL;
-
+    iree_host_size_t module_count, iree_allocator_t allocator,
+    iree_vm_context_t** out_context) {
   iree_host_size_t context_size =
       sizeof(iree_vm_context_t) + sizeof(iree_vm_module_t*) * module_count +
       sizeof(iree_vm_module_state_t*) * module_count;
 
   iree_vm_context_t* context = NULL;
-  iree_allocator_malloc(allocator, context_size, (void**)&context);
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(allocator, context_size, (void**)&context));
   iree_atomic_ref_count_init(&context->ref_count);
   context->instance = instance;
   iree_vm_instance_retain(context->instance);
@@ -245,12 +268,140 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
   context->list.count = 0;
   context->list.capacity = module_count;
 
-  iree_status_t register_status =
+  iree_status_t status = iree_vm_stack_pool_create(
+      iree_vm_context_state_resolver(context), allocator, &context->stack_pool);
+  if (!iree_status_is_ok(status)) {
+    iree_vm_context_destroy(context);
+    return status;
+  }
+
+  *out_context = context;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
+    iree_vm_instance_t* instance, iree_vm_context_flags_t flags,
+    iree_vm_module_t** modules, iree_host_size_t module_count,
+    iree_allocator_t allocator, iree_vm_context_t** out_context) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(out_context);
+  *out_context = NULL;
+
+  iree_vm_context_t* context = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_context_allocate(instance, flags, module_count, allocator,
+                                   &context));
+
+  iree_status_t status =
       iree_vm_context_register_modules(context, modules, module_count);
-  if (!iree_status_is_ok(register_status)) {
+  if (!iree_status_is_ok(status)) {
     iree_vm_context_destroy(context);
     IREE_TRACE_ZONE_END(z0);
-    return register_status;
+    return status;
+  }
+
+  *out_context = context;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+// Populates the empty static |context| with the modules of |parent_context|
+// using state forked from the parent where supported by the module.
+static iree_status_t iree_vm_context_fork_modules(
+    iree_vm_context_t* context, const iree_vm_context_t* parent_context) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // VM stack used to call into module __init methods.
+  IREE_VM_INLINE_STACK_INITIALIZE(
+      stack, iree_vm_context_invocation_flags(context),
+      iree_vm_context_state_resolver(context), context->allocator);
+
+  assert(context->list.capacity >= parent_context->list.count);
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t i = 0;
+  for (i = 0; i < parent_context->list.count; ++i) {
+    iree_vm_module_t* module = parent_context->list.modules[i];
+    context->list.modules[i] = module;
+    context->list.module_states[i] = NULL;
+
+    iree_vm_module_retain(module);
+
+    // Fork the module state from the parent, if supported, and otherwise
+    // allocate fresh state that will need initialization.
+    const bool is_forked = module->fork_state != NULL;
+    iree_vm_module_state_t* module_state = NULL;
+    if (is_forked) {
+      status = module->fork_state(module->self,
+                                  parent_context->list.module_states[i],
+                                  context->allocator, &module_state);
+    } else {
+      status =
+          module->alloc_state(module->self, context->allocator, &module_state);
+    }
+    if (!iree_status_is_ok(status)) {
+      // Cleanup handled below.
+      break;
+    }
+    context->list.module_states[i] = module_state;
+
+    // Imports must resolve to the module states within the new context.
+    status =
+        iree_vm_context_resolve_module_imports(context, module, module_state);
+    if (!iree_status_is_ok(status)) {
+      // Cleanup handled below.
+      break;
+    }
+
+    ++context->list.count;
+
+    // Forked state was initialized in the parent context.
+    if (!is_forked) {
+      status = iree_vm_context_run_function(stack, module,
+                                            iree_make_cstring_view("__init"));
+      if (!iree_status_is_ok(status)) {
+        // Cleanup handled below.
+        break;
+      }
+    }
+  }
+
+  iree_vm_stack_deinitialize(stack);
+
+  if (!iree_status_is_ok(status)) {
+    iree_vm_context_release_modules(context, 0, i);
+    context->list.count = 0;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_fork(
+    const iree_vm_context_t* parent_context, iree_allocator_t allocator,
+    iree_vm_context_t** out_context) {
+  IREE_ASSERT_ARGUMENT(parent_context);
+  IREE_ASSERT_ARGUMENT(out_context);
+  *out_context = NULL;
+  if (!parent_context->is_frozen) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "only frozen contexts can be forked");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_context_t* context = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_context_allocate(parent_context->instance,
+                                   parent_context->flags,
+                                   parent_context->list.count, allocator,
+                                   &context));
+  // Forks of empty contexts are still frozen like their parent.
+  context->is_frozen = 1;
+
+  iree_status_t status = iree_vm_context_fork_modules(context, parent_context);
+  if (!iree_status_is_ok(status)) {
+    iree_vm_context_destroy(context);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
   }
 
   *out_context = context;
@@ -263,6 +414,10 @@ static void iree_vm_context_destroy(iree_vm_context_t* context) {
 
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Stacks reference module state and must go before the modules do.
+  iree_vm_stack_pool_free(context->stack_pool);
+  context->stack_pool = NULL;
+
   if (context->list.count > 0) {
     iree_vm_context_release_modules(context, 0, context->list.count - 1);
   }
@@ -367,10 +522,7 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
 
   // VM stack used to call into module __init methods.
   IREE_VM_INLINE_STACK_INITIALIZE(
-      stack,
-      context->flags & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION
-          ? IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION
-          : IREE_VM_INVOCATION_FLAG_NONE,
+      stack, iree_vm_context_invocation_flags(context),
       iree_vm_context_state_resolver(context), context->allocator);
 
   // Retain all modules and allocate their state.
@@ -445,6 +597,12 @@ iree_vm_context_state_resolver(const iree_vm_context_t* context) {
   return state_resolver;
 }
 
+IREE_API_EXPORT iree_vm_stack_pool_t* iree_vm_context_stack_pool(
+    const iree_vm_context_t* context) {
+  IREE_ASSERT_ARGUMENT(context);
+  return context->stack_pool;
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_context_resolve_module_state(
     const iree_vm_context_t* context, iree_vm_module_t* module,
     iree_vm_module_state_t** out_module_state) {
@@ -488,6 +646,105 @@ IREE_API_EXPORT iree_status_t iree_vm_context_resolve_function(
                           (int)full_name.size, full_name.data);
 }
 
+IREE_API_EXPORT iree_status_t iree_vm_context_enumerate_function_profiles(
+    const iree_vm_context_t* context,
+    iree_vm_function_profile_callback_t callback) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(callback.fn);
+  for (iree_host_size_t i = 0; i < context->list.count; ++i) {
+    iree_vm_module_t* module = context->list.modules[i];
+    if (!module->get_function_profile) continue;
+    iree_vm_module_signature_t signature = iree_vm_module_signature(module);
+    for (iree_host_size_t j = 0; j < signature.internal_function_count; ++j) {
+      iree_vm_function_profile_t profile;
+      memset(&profile, 0, sizeof(profile));
+      IREE_RETURN_IF_ERROR(module->get_function_profile(
+          module->self, context->list.module_states[i], j, &profile));
+      if (profile.call_count == 0) continue;
+      IREE_RETURN_IF_ERROR(callback.fn(callback.user_data, &profile));
+    }
+  }
+  return iree_ok_status();
+}
+
+typedef struct iree_vm_context_profile_list_t {
+  iree_allocator_t allocator;
+  iree_host_size_t count;
+  iree_host_size_t capacity;
+  iree_vm_function_profile_t* profiles;
+} iree_vm_context_profile_list_t;
+
+static iree_status_t iree_vm_context_profile_list_append(
+    void* user_data, const iree_vm_function_profile_t* profile) {
+  iree_vm_context_profile_list_t* list =
+      (iree_vm_context_profile_list_t*)user_data;
+  if (list->count == list->capacity) {
+    iree_host_size_t new_capacity = iree_max(16, list->capacity * 2);
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        list->allocator, new_capacity * sizeof(*list->profiles),
+        (void**)&list->profiles));
+    list->capacity = new_capacity;
+  }
+  list->profiles[list->count++] = *profile;
+  return iree_ok_status();
+}
+
+// Orders profiles by descending self time.
+static int iree_vm_context_profile_compare(const void* a, const void* b) {
+  iree_duration_t time_a = ((const iree_vm_function_profile_t*)a)->self_time_ns;
+  iree_duration_t time_b = ((const iree_vm_function_profile_t*)b)->self_time_ns;
+  return time_a < time_b ? 1 : (time_a > time_b ? -1 : 0);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_append_profile(
+    const iree_vm_context_t* context, iree_string_builder_t* builder) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(builder);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_context_profile_list_t list;
+  memset(&list, 0, sizeof(list));
+  list.allocator = context->allocator;
+  iree_vm_function_profile_callback_t callback = {
+      .fn = iree_vm_context_profile_list_append,
+      .user_data = &list,
+  };
+  iree_status_t status =
+      iree_vm_context_enumerate_function_profiles(context, callback);
+
+  iree_duration_t total_time_ns = 0;
+  for (iree_host_size_t i = 0; i < list.count; ++i) {
+    total_time_ns += list.profiles[i].self_time_ns;
+  }
+  if (iree_status_is_ok(status) && list.count > 1) {
+    qsort(list.profiles, list.count, sizeof(*list.profiles),
+          iree_vm_context_profile_compare);
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_string_builder_append_format(
+        builder, "%8s %12s %16s %14s  %s\n", "self%", "calls",
+        "instructions", "self_us", "function");
+  }
+  for (iree_host_size_t i = 0; i < list.count && iree_status_is_ok(status);
+       ++i) {
+    const iree_vm_function_profile_t* profile = &list.profiles[i];
+    iree_string_view_t module_name = iree_vm_module_name(profile->module);
+    double percent = total_time_ns > 0 ? 100.0 * profile->self_time_ns /
+                                             (double)total_time_ns
+                                       : 0.0;
+    status = iree_string_builder_append_format(
+        builder, "%7.2f%% %12" PRIu64 " %16" PRIu64 " %14.3f  %.*s.%.*s\n",
+        percent, profile->call_count, profile->instruction_count,
+        profile->self_time_ns / 1000.0, (int)module_name.size, module_name.data,
+        (int)profile->name.size, profile->name.data);
+  }
+
+  iree_allocator_free(context->allocator, list.profiles);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 // Calls the '__notify(i32)' function in |module|, if present.
 static iree_status_t iree_vm_context_call_module_notify(
     iree_vm_stack_t* stack, iree_vm_module_t* module,
@@ -585,10 +842,7 @@ IREE_API_EXPORT iree_status_t iree_vm_context_notify(iree_vm_context_t* context,
 
   // VM stack used to call into module __init methods.
   IREE_VM_INLINE_STACK_INITIALIZE(
-      stack,
-      context->flags & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION
-          ? IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION
-          : IREE_VM_INVOCATION_FLAG_NONE,
+      stack, iree_vm_context_invocation_flags(context),
       iree_vm_context_state_resolver(context), context->allocator);
 
   // Resumes are walked forward while suspends are walked backward.
@@ -41,6 +41,14 @@ enum iree_vm_context_flag_bits_t {
   // All invocations made to this context - including initializers - will be
   // traced. For fine-grained control use `iree_vm_invocation_flags_t`.
   IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION = 1u << 0,
+
+  // Enables collection of per-function execution profiles (when available).
+  // See iree/base/config.h for the flags that control whether this
+  // functionality is available; specifically:
+  //   -DIREE_VM_EXECUTION_PROFILING_ENABLE=1
+  // All invocations made to this context will be profiled. For fine-grained
+  // control use `iree_vm_invocation_flags_t`.
+  IREE_VM_CONTEXT_FLAG_PROFILE_EXECUTION = 1u << 1,
 };
 typedef uint32_t iree_vm_context_flags_t;
 
@@ -60,6 +68,25 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
     iree_vm_module_t** modules, iree_host_size_t module_count,
     iree_allocator_t allocator, iree_vm_context_t** out_context);
 
+// Creates a new context that shares the modules of the frozen |parent_context|
+// and starts from a snapshot of its module state.
+//
+// Modules that implement fork_state (such as bytecode modules) have their state
+// copied from the parent without rerunning their initializers: primitive
+// globals are copied and ref globals (such as uploaded constant buffers) are
+// shared with the parent and all other forks. Other modules have fresh state
+// allocated and initialized as if registered with a new context. This allows a
+// template context to be initialized once and cheaply forked for each
+// concurrent user with only the mutable state duplicated.
+//
+// Forks do not reference the parent context and it may be released first.
+// Objects shared through ref globals must not be mutated in-place by any
+// context unless that is the intent. The forked context is frozen.
+// |out_context| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_vm_context_fork(
+    const iree_vm_context_t* parent_context, iree_allocator_t allocator,
+    iree_vm_context_t** out_context);
+
 // Retains the given |context| for the caller.
 IREE_API_EXPORT void iree_vm_context_retain(iree_vm_context_t* context);
 
@@ -92,6 +119,11 @@ iree_vm_context_freeze(iree_vm_context_t* context);
 IREE_API_EXPORT iree_vm_state_resolver_t
 iree_vm_context_state_resolver(const iree_vm_context_t* context);
 
+// Returns the pool of stacks used for invocations within |context|.
+// The pool is owned by the context and valid for as long as the context is.
+IREE_API_EXPORT iree_vm_stack_pool_t* iree_vm_context_stack_pool(
+    const iree_vm_context_t* context);
+
 // Sets |out_module_state| to the context-specific state for the given |module|.
 // The state is owned by the context and will only be live for as long as the
 // context is.
@@ -106,6 +138,27 @@ IREE_API_EXPORT iree_status_t iree_vm_context_resolve_function(
     const iree_vm_context_t* context, iree_string_view_t full_name,
     iree_vm_function_t* out_function);
 
+// Callback receiving the profile of a single function.
+typedef struct iree_vm_function_profile_callback_t {
+  iree_status_t(IREE_API_PTR* fn)(void* user_data,
+                                  const iree_vm_function_profile_t* profile);
+  void* user_data;
+} iree_vm_function_profile_callback_t;
+
+// Enumerates the execution profiles of all functions in the context that have
+// been called at least once. Profiles are only gathered for invocations made
+// with IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION (or within contexts created
+// with IREE_VM_CONTEXT_FLAG_PROFILE_EXECUTION) and only by modules that
+// support it.
+IREE_API_EXPORT iree_status_t iree_vm_context_enumerate_function_profiles(
+    const iree_vm_context_t* context,
+    iree_vm_function_profile_callback_t callback);
+
+// Appends a human-readable table of the function execution profiles in
+// |context| to |builder| sorted by descending self time.
+IREE_API_EXPORT iree_status_t iree_vm_context_append_profile(
+    const iree_vm_context_t* context, iree_string_builder_t* builder);
+
 // Notifies all modules in the context of a system signal.
 IREE_API_EXPORT iree_status_t iree_vm_context_notify(iree_vm_context_t* context,
                                                      iree_vm_signal_t signal);
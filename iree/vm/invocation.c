@@ -11,11 +11,48 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/profiler.h"
 #include "iree/base/tracing.h"
 #include "iree/vm/ref.h"
 #include "iree/vm/stack.h"
 #include "iree/vm/value.h"
 
+// Returns the size of a primitive |cconv_type| and its |out_value_type| or 0
+// if the type is not a primitive value.
+static iree_host_size_t iree_vm_invoke_cconv_value_type(
+    char cconv_type, iree_vm_value_type_t* out_value_type) {
+  switch (cconv_type) {
+    case IREE_VM_CCONV_TYPE_I32:
+      *out_value_type = IREE_VM_VALUE_TYPE_I32;
+      return sizeof(int32_t);
+    case IREE_VM_CCONV_TYPE_I64:
+      *out_value_type = IREE_VM_VALUE_TYPE_I64;
+      return sizeof(int64_t);
+    case IREE_VM_CCONV_TYPE_F32:
+      *out_value_type = IREE_VM_VALUE_TYPE_F32;
+      return sizeof(float);
+    case IREE_VM_CCONV_TYPE_F64:
+      *out_value_type = IREE_VM_VALUE_TYPE_F64;
+      return sizeof(double);
+    default:
+      *out_value_type = IREE_VM_VALUE_TYPE_NONE;
+      return 0;
+  }
+}
+
+// Returns the number of consecutive |cconv_types| starting at |cconv_i| that
+// are the same as the one at |cconv_i|. Runs of primitive values are densely
+// packed in the ABI buffers and can be transferred with a single list access.
+static iree_host_size_t iree_vm_invoke_cconv_run_length(
+    iree_string_view_t cconv_types, iree_host_size_t cconv_i) {
+  iree_host_size_t run_length = 1;
+  while (cconv_i + run_length < cconv_types.size &&
+         cconv_types.data[cconv_i + run_length] == cconv_types.data[cconv_i]) {
+    ++run_length;
+  }
+  return run_length;
+}
+
 // Marshals caller arguments from the variant list to the ABI convention.
 static iree_status_t iree_vm_invoke_marshal_inputs(
     iree_string_view_t cconv_arguments, iree_vm_list_t* inputs,
@@ -41,47 +78,31 @@ static iree_status_t iree_vm_invoke_marshal_inputs(
   }
 
   uint8_t* p = arguments.data;
-  for (iree_host_size_t cconv_i = 0, arg_i = 0; cconv_i < cconv_arguments.size;
-       ++cconv_i, ++arg_i) {
-    switch (cconv_arguments.data[cconv_i]) {
-      case IREE_VM_CCONV_TYPE_VOID:
-        break;
-      case IREE_VM_CCONV_TYPE_I32: {
-        iree_vm_value_t value;
-        IREE_RETURN_IF_ERROR(iree_vm_list_get_value_as(
-            inputs, arg_i, IREE_VM_VALUE_TYPE_I32, &value));
-        memcpy(p, &value.i32, sizeof(int32_t));
-        p += sizeof(int32_t);
-      } break;
-      case IREE_VM_CCONV_TYPE_I64: {
-        iree_vm_value_t value;
-        IREE_RETURN_IF_ERROR(iree_vm_list_get_value_as(
-            inputs, arg_i, IREE_VM_VALUE_TYPE_I64, &value));
-        memcpy(p, &value.i64, sizeof(int64_t));
-        p += sizeof(int64_t);
-      } break;
-      case IREE_VM_CCONV_TYPE_F32: {
-        iree_vm_value_t value;
-        IREE_RETURN_IF_ERROR(iree_vm_list_get_value_as(
-            inputs, arg_i, IREE_VM_VALUE_TYPE_F32, &value));
-        memcpy(p, &value.f32, sizeof(float));
-        p += sizeof(float);
-      } break;
-      case IREE_VM_CCONV_TYPE_F64: {
-        iree_vm_value_t value;
-        IREE_RETURN_IF_ERROR(iree_vm_list_get_value_as(
-            inputs, arg_i, IREE_VM_VALUE_TYPE_F64, &value));
-        memcpy(p, &value.f64, sizeof(double));
-        p += sizeof(double);
-      } break;
-      case IREE_VM_CCONV_TYPE_REF: {
-        // TODO(benvanik): see if we can't remove this retain by instead relying
-        // on the caller still owning the list.
-        IREE_RETURN_IF_ERROR(
-            iree_vm_list_get_ref_retain(inputs, arg_i, (iree_vm_ref_t*)p));
-        p += sizeof(iree_vm_ref_t);
-      } break;
+  for (iree_host_size_t cconv_i = 0, arg_i = 0;
+       cconv_i < cconv_arguments.size;) {
+    char cconv_type = cconv_arguments.data[cconv_i];
+    iree_vm_value_type_t value_type = IREE_VM_VALUE_TYPE_NONE;
+    iree_host_size_t value_size =
+        iree_vm_invoke_cconv_value_type(cconv_type, &value_type);
+    if (value_size > 0) {
+      iree_host_size_t run_length =
+          iree_vm_invoke_cconv_run_length(cconv_arguments, cconv_i);
+      IREE_RETURN_IF_ERROR(
+          iree_vm_list_get_values(inputs, arg_i, run_length, value_type, p));
+      p += run_length * value_size;
+      cconv_i += run_length;
+      arg_i += run_length;
+      continue;
     }
+    if (cconv_type == IREE_VM_CCONV_TYPE_REF) {
+      // TODO(benvanik): see if we can't remove this retain by instead relying
+      // on the caller still owning the list.
+      IREE_RETURN_IF_ERROR(
+          iree_vm_list_get_ref_retain(inputs, arg_i, (iree_vm_ref_t*)p));
+      p += sizeof(iree_vm_ref_t);
+    }
+    ++cconv_i;
+    ++arg_i;
   }
   return iree_ok_status();
 }
@@ -103,48 +124,68 @@ static iree_status_t iree_vm_invoke_marshal_outputs(
     return iree_ok_status();
   }
 
-  // Resize the output list to hold all results (and kill anything that may
-  // have been in there).
-  IREE_RETURN_IF_ERROR(iree_vm_list_resize(outputs, 0));
+  // Resize the output list to hold all results. Any elements that were in
+  // there are released as they are overwritten below.
   IREE_RETURN_IF_ERROR(iree_vm_list_resize(outputs, expected_output_count));
 
   uint8_t* p = results.data;
-  for (iree_host_size_t cconv_i = 0, arg_i = 0; cconv_i < cconv_results.size;
-       ++cconv_i, ++arg_i) {
-    switch (cconv_results.data[cconv_i]) {
-      case IREE_VM_CCONV_TYPE_VOID:
-        break;
-      case IREE_VM_CCONV_TYPE_I32: {
-        iree_vm_value_t value = iree_vm_value_make_i32(*(int32_t*)p);
-        IREE_RETURN_IF_ERROR(iree_vm_list_set_value(outputs, arg_i, &value));
-        p += sizeof(int32_t);
-      } break;
-      case IREE_VM_CCONV_TYPE_I64: {
-        iree_vm_value_t value = iree_vm_value_make_i64(*(int64_t*)p);
-        IREE_RETURN_IF_ERROR(iree_vm_list_set_value(outputs, arg_i, &value));
-        p += sizeof(int64_t);
-      } break;
-      case IREE_VM_CCONV_TYPE_F32: {
-        iree_vm_value_t value = iree_vm_value_make_f32(*(float*)p);
-        IREE_RETURN_IF_ERROR(iree_vm_list_set_value(outputs, arg_i, &value));
-        p += sizeof(float);
-      } break;
-      case IREE_VM_CCONV_TYPE_F64: {
-        iree_vm_value_t value = iree_vm_value_make_f64(*(double*)p);
-        IREE_RETURN_IF_ERROR(iree_vm_list_set_value(outputs, arg_i, &value));
-        p += sizeof(double);
-      } break;
-      case IREE_VM_CCONV_TYPE_REF: {
-        IREE_RETURN_IF_ERROR(
-            iree_vm_list_set_ref_move(outputs, arg_i, (iree_vm_ref_t*)p));
-        p += sizeof(iree_vm_ref_t);
-      } break;
+  for (iree_host_size_t cconv_i = 0, arg_i = 0; cconv_i < cconv_results.size;) {
+    char cconv_type = cconv_results.data[cconv_i];
+    iree_vm_value_type_t value_type = IREE_VM_VALUE_TYPE_NONE;
+    iree_host_size_t value_size =
+        iree_vm_invoke_cconv_value_type(cconv_type, &value_type);
+    if (value_size > 0) {
+      iree_host_size_t run_length =
+          iree_vm_invoke_cconv_run_length(cconv_results, cconv_i);
+      IREE_RETURN_IF_ERROR(
+          iree_vm_list_set_values(outputs, arg_i, run_length, value_type, p));
+      p += run_length * value_size;
+      cconv_i += run_length;
+      arg_i += run_length;
+      continue;
     }
+    if (cconv_type == IREE_VM_CCONV_TYPE_REF) {
+      IREE_RETURN_IF_ERROR(
+          iree_vm_list_set_ref_move(outputs, arg_i, (iree_vm_ref_t*)p));
+      p += sizeof(iree_vm_ref_t);
+    }
+    ++cconv_i;
+    ++arg_i;
   }
   return iree_ok_status();
 }
 
+// Resumes the yielded call on the top of |stack| until it stops yielding.
+// |status| is the status of the original begin_call and is returned as-is if
+// execution did not yield.
+static iree_status_t iree_vm_invoke_resume_yielded(iree_vm_stack_t* stack,
+                                                   iree_status_t status) {
+  while (iree_status_is_deferred(status)) {
+    // The yielding frame is the only one that knows how to continue; frames
+    // below it are resumed transparently when it returns.
+    iree_vm_stack_frame_t* frame = iree_vm_stack_current_frame(stack);
+    iree_vm_module_t* module = frame ? frame->function.module : NULL;
+    if (IREE_UNLIKELY(!module || !module->resume_call)) {
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "yielding function cannot be resumed");
+    }
+    iree_vm_execution_result_t result;
+    status = module->resume_call(module->self, stack, &result);
+  }
+  return status;
+}
+
 // TODO(benvanik): implement this as an iree_vm_invocation_t sequence.
+// Reports |type| for invocation |id| of |function| to the profiler, if any.
+// The function name is only looked up when the event is recorded.
+static inline void iree_vm_invoke_profile(iree_profiler_event_type_t type,
+                                          const void* id,
+                                          const iree_vm_function_t* function) {
+  if (!iree_profiler_is_enabled(1u << type)) return;
+  iree_profiler_record_slow(type, (uint64_t)(uintptr_t)id,
+                            iree_vm_function_name(function), 0);
+}
+
 static iree_status_t iree_vm_invoke_within(
     iree_vm_context_t* context, iree_vm_stack_t* stack,
     iree_vm_function_t function, const iree_vm_invocation_policy_t* policy,
@@ -177,8 +218,8 @@ static iree_status_t iree_vm_invoke_within(
   results.data = iree_alloca(results.data_length);
   memset(results.data, 0, results.data_length);
 
-  // Perform execution. Note that for synchronous execution we expect this to
-  // complete without yielding.
+  // Perform execution. Synchronous execution resumes any yields immediately
+  // until the function returns.
   iree_vm_function_call_t call;
   memset(&call, 0, sizeof(call));
   call.function = function;
@@ -187,6 +228,7 @@ static iree_status_t iree_vm_invoke_within(
   iree_vm_execution_result_t result;
   iree_status_t status =
       function.module->begin_call(function.module->self, stack, &call, &result);
+  status = iree_vm_invoke_resume_yielded(stack, status);
   if (!iree_status_is_ok(status)) {
     iree_vm_function_call_release(&call, &signature);
     return status;
@@ -206,21 +248,271 @@ IREE_API_EXPORT iree_status_t iree_vm_invoke(
     iree_allocator_t allocator) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Force tracing if specified on the context.
+  // Force tracing and profiling if specified on the context.
   if (iree_vm_context_flags(context) & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION) {
     flags |= IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION;
   }
+  if (iree_vm_context_flags(context) & IREE_VM_CONTEXT_FLAG_PROFILE_EXECUTION) {
+    flags |= IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION;
+  }
 
-  // Allocate a VM stack on the host stack and initialize it.
-  IREE_VM_INLINE_STACK_INITIALIZE(
-      stack, flags, iree_vm_context_state_resolver(context), allocator);
+  // Acquire a VM stack from the context pool; it retains any storage grown by
+  // prior invocations so steady-state invocations do not allocate.
+  iree_vm_stack_pool_t* stack_pool = iree_vm_context_stack_pool(context);
+  iree_vm_stack_t* stack = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_stack_pool_acquire(stack_pool, flags, &stack));
+  iree_vm_invoke_profile(IREE_PROFILER_EVENT_TYPE_INVOKE_BEGIN, stack,
+                         &function);
   iree_status_t status =
       iree_vm_invoke_within(context, stack, function, policy, inputs, outputs);
+  iree_vm_invoke_profile(IREE_PROFILER_EVENT_TYPE_INVOKE_END, stack, &function);
   if (!iree_status_is_ok(status)) {
     status = IREE_VM_STACK_ANNOTATE_BACKTRACE_IF_ENABLED(stack, status);
   }
-  iree_vm_stack_deinitialize(stack);
+  iree_vm_stack_pool_release(stack_pool, stack);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+struct iree_vm_prepared_call_t {
+  iree_allocator_t allocator;
+  iree_vm_context_t* context;
+  iree_vm_function_t function;
+
+  // Calling convention fragments referencing the module-owned signature.
+  iree_string_view_t cconv_arguments;
+  iree_string_view_t cconv_results;
+
+  // ABI buffers stored inline after the struct.
+  iree_byte_span_t arguments;
+  iree_byte_span_t results;
+
+  // Stack reused across invocations; empty between them unless suspended.
+  iree_vm_stack_t* stack;
+
+  // True if the current invocation yielded and must be resumed.
+  bool is_suspended;
+};
+
+// Releases all refs in |buffer| laid out per |cconv_fragment| and resets them
+// to null. Non-ref values are left as-is.
+static void iree_vm_prepared_call_release_refs(
+    iree_string_view_t cconv_fragment, iree_byte_span_t buffer) {
+  uint8_t* p = buffer.data;
+  for (iree_host_size_t i = 0; i < cconv_fragment.size; ++i) {
+    switch (cconv_fragment.data[i]) {
+      case IREE_VM_CCONV_TYPE_I32:
+      case IREE_VM_CCONV_TYPE_F32:
+        p += sizeof(int32_t);
+        break;
+      case IREE_VM_CCONV_TYPE_I64:
+      case IREE_VM_CCONV_TYPE_F64:
+        p += sizeof(int64_t);
+        break;
+      case IREE_VM_CCONV_TYPE_REF:
+        iree_vm_ref_release((iree_vm_ref_t*)p);
+        p += sizeof(iree_vm_ref_t);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_prepared_call_create(
+    iree_vm_context_t* context, iree_vm_function_t function,
+    iree_vm_invocation_flags_t flags, iree_allocator_t allocator,
+    iree_vm_prepared_call_t** out_call) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_call);
+  *out_call = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_function_signature_t signature =
+      iree_vm_function_signature(&function);
+  iree_string_view_t cconv_arguments = iree_string_view_empty();
+  iree_string_view_t cconv_results = iree_string_view_empty();
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_get_cconv_fragments(
+              &signature, &cconv_arguments, &cconv_results));
+  if (iree_vm_function_call_is_variadic_cconv(cconv_arguments) ||
+      iree_vm_function_call_is_variadic_cconv(cconv_results)) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "prepared calls of variadic functions are not "
+                            "supported");
+  }
+  iree_host_size_t argument_size = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_compute_cconv_fragment_size(
+              cconv_arguments, /*segment_size_list=*/NULL, &argument_size));
+  iree_host_size_t result_size = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_function_call_compute_cconv_fragment_size(
+              cconv_results, /*segment_size_list=*/NULL, &result_size));
+
+  // Force tracing and profiling if specified on the context.
+  if (iree_vm_context_flags(context) & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION) {
+    flags |= IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION;
+  }
+  if (iree_vm_context_flags(context) & IREE_VM_CONTEXT_FLAG_PROFILE_EXECUTION) {
+    flags |= IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION;
+  }
+
+  iree_vm_prepared_call_t* call = NULL;
+  const iree_host_size_t argument_offset = iree_sizeof_struct(*call);
+  const iree_host_size_t result_offset =
+      argument_offset + iree_host_align(argument_size, iree_max_align_t);
+  const iree_host_size_t total_size = result_offset + result_size;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, total_size, (void**)&call));
+  memset(call, 0, total_size);
+  call->allocator = allocator;
+  call->context = context;
+  iree_vm_context_retain(context);
+  call->function = function;
+  call->cconv_arguments = cconv_arguments;
+  call->cconv_results = cconv_results;
+  call->arguments =
+      iree_make_byte_span((uint8_t*)call + argument_offset, argument_size);
+  call->results =
+      iree_make_byte_span((uint8_t*)call + result_offset, result_size);
+
+  iree_status_t status =
+      iree_vm_stack_allocate(flags, iree_vm_context_state_resolver(context),
+                             allocator, &call->stack);
+
+  if (iree_status_is_ok(status)) {
+    *out_call = call;
+  } else {
+    iree_vm_prepared_call_destroy(call);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT void iree_vm_prepared_call_destroy(
+    iree_vm_prepared_call_t* call) {
+  if (!call) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_prepared_call_release_refs(call->cconv_arguments, call->arguments);
+  iree_vm_prepared_call_release_refs(call->cconv_results, call->results);
+  if (call->stack) iree_vm_stack_free(call->stack);
+  iree_vm_context_release(call->context);
+  iree_allocator_free(call->allocator, call);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT iree_byte_span_t
+iree_vm_prepared_call_arguments(iree_vm_prepared_call_t* call) {
+  IREE_ASSERT_ARGUMENT(call);
+  return call->arguments;
+}
+
+IREE_API_EXPORT iree_byte_span_t
+iree_vm_prepared_call_results(iree_vm_prepared_call_t* call) {
+  IREE_ASSERT_ARGUMENT(call);
+  return call->results;
+}
+
+// Handles the |status| of an invocation of |call| that began or resumed.
+static iree_status_t iree_vm_prepared_call_complete(
+    iree_vm_prepared_call_t* call, iree_status_t status) {
+  // Yielded execution keeps its frames on the stack until resumed.
+  call->is_suspended = iree_status_is_deferred(status);
+  if (iree_status_is_ok(status) || call->is_suspended) return status;
+
+  status = IREE_VM_STACK_ANNOTATE_BACKTRACE_IF_ENABLED(call->stack, status);
+  // Unwind any frames left behind by the failure so that the stack can be
+  // reused by the next invocation.
+  while (iree_vm_stack_current_frame(call->stack)) {
+    iree_status_ignore(iree_vm_stack_function_leave(call->stack));
+  }
+  iree_vm_prepared_call_release_refs(call->cconv_arguments, call->arguments);
+  iree_vm_prepared_call_release_refs(call->cconv_results, call->results);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_prepared_call_invoke(iree_vm_prepared_call_t* call) {
+  IREE_ASSERT_ARGUMENT(call);
+  if (IREE_UNLIKELY(call->is_suspended)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "prepared call is suspended and must be resumed "
+                            "before it can be invoked again");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Drop any results of the prior invocation the caller did not take.
+  iree_vm_prepared_call_release_refs(call->cconv_results, call->results);
+
+  iree_vm_function_call_t function_call;
+  function_call.function = call->function;
+  function_call.arguments = call->arguments;
+  function_call.results = call->results;
+  iree_vm_execution_result_t result;
+  iree_vm_invoke_profile(IREE_PROFILER_EVENT_TYPE_INVOKE_BEGIN, call,
+                         &call->function);
+  iree_status_t status = call->function.module->begin_call(
+      call->function.module->self, call->stack, &function_call, &result);
+  iree_vm_invoke_profile(IREE_PROFILER_EVENT_TYPE_INVOKE_END, call,
+                         &call->function);
+  status = iree_vm_prepared_call_complete(call, status);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_prepared_call_resume(iree_vm_prepared_call_t* call) {
+  IREE_ASSERT_ARGUMENT(call);
+  if (IREE_UNLIKELY(!call->is_suspended)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "prepared call is not suspended");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Resume exactly once so that callers can interleave other work with each
+  // yield.
+  iree_vm_stack_frame_t* frame = iree_vm_stack_current_frame(call->stack);
+  iree_vm_module_t* module = frame ? frame->function.module : NULL;
+  iree_status_t status = iree_ok_status();
+  if (IREE_UNLIKELY(!module || !module->resume_call)) {
+    status = iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "yielding function cannot be resumed");
+  } else {
+    iree_vm_execution_result_t result;
+    iree_vm_invoke_profile(IREE_PROFILER_EVENT_TYPE_INVOKE_BEGIN, call,
+                           &call->function);
+    status = module->resume_call(module->self, call->stack, &result);
+    iree_vm_invoke_profile(IREE_PROFILER_EVENT_TYPE_INVOKE_END, call,
+                           &call->function);
+  }
+  status = iree_vm_prepared_call_complete(call, status);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+IREE_API_EXPORT iree_status_t iree_vm_prepared_call_invoke_lists(
+    iree_vm_prepared_call_t* call, iree_vm_list_t* inputs,
+    iree_vm_list_t* outputs) {
+  IREE_ASSERT_ARGUMENT(call);
+  iree_status_t status = iree_vm_invoke_marshal_inputs(
+      call->cconv_arguments, inputs, call->arguments);
+  if (!iree_status_is_ok(status)) {
+    iree_vm_prepared_call_release_refs(call->cconv_arguments, call->arguments);
+    return status;
+  }
+  status = iree_vm_prepared_call_invoke(call);
+  while (iree_status_is_deferred(status)) {
+    status = iree_vm_prepared_call_resume(call);
+  }
+  IREE_RETURN_IF_ERROR(status);
+  return iree_vm_invoke_marshal_outputs(call->cconv_results, call->results,
+                                        outputs);
+}
@@ -34,12 +34,77 @@ typedef struct iree_vm_invocation_policy_t iree_vm_invocation_policy_t;
 // |outputs| is populated after the function completes execution with the
 // output values and objects of the function. List ownership remains with the
 // caller.
+//
+// The VM stack used for execution is reused from the pool owned by |context|.
 IREE_API_EXPORT iree_status_t iree_vm_invoke(
     iree_vm_context_t* context, iree_vm_function_t function,
     iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
     iree_vm_list_t* inputs, iree_vm_list_t* outputs,
     iree_allocator_t allocator);
 
+// A synchronous call of a single function prepared ahead of time for repeated
+// invocation. The function signature is parsed and the VM stack and the ABI
+// argument and result buffers are allocated once on creation such that each
+// invocation performs no parsing and no allocation (so long as the stack does
+// not need to grow).
+//
+// Arguments may either be written directly into the ABI buffer returned by
+// iree_vm_prepared_call_arguments or marshaled from a list with
+// iree_vm_prepared_call_invoke_lists.
+//
+// Prepared calls are not thread-safe and only one invocation may be in-flight
+// at a time. The context is retained for the lifetime of the prepared call.
+typedef struct iree_vm_prepared_call_t iree_vm_prepared_call_t;
+
+// Prepares |function| in |context| for repeated invocation.
+// Variadic functions are not supported.
+IREE_API_EXPORT iree_status_t iree_vm_prepared_call_create(
+    iree_vm_context_t* context, iree_vm_function_t function,
+    iree_vm_invocation_flags_t flags, iree_allocator_t allocator,
+    iree_vm_prepared_call_t** out_call);
+
+// Destroys |call|, releasing any refs that remain in its buffers.
+IREE_API_EXPORT void iree_vm_prepared_call_destroy(
+    iree_vm_prepared_call_t* call);
+
+// Returns the ABI argument buffer of |call| laid out per the calling
+// convention of the function. Refs written to the buffer are moved into the
+// callee by iree_vm_prepared_call_invoke.
+IREE_API_EXPORT iree_byte_span_t
+iree_vm_prepared_call_arguments(iree_vm_prepared_call_t* call);
+
+// Returns the ABI result buffer of |call| populated by the most recent
+// invocation. Refs in the buffer remain owned by the call until the next
+// invocation or destruction; callers may move them out to take ownership.
+IREE_API_EXPORT iree_byte_span_t
+iree_vm_prepared_call_results(iree_vm_prepared_call_t* call);
+
+// Invokes the function with the arguments currently in the ABI argument
+// buffer. Callers must fully populate the arguments before each invocation as
+// they are consumed by the callee.
+//
+// Returns IREE_STATUS_DEFERRED if execution yielded (such as while waiting on
+// a device fence); the call remains suspended with its frames on the stack
+// and iree_vm_prepared_call_resume must be called until it completes. The
+// results are only valid once the invocation returns OK.
+IREE_API_EXPORT iree_status_t
+iree_vm_prepared_call_invoke(iree_vm_prepared_call_t* call);
+
+// Resumes a suspended invocation of |call| from where it last yielded.
+// Returns IREE_STATUS_DEFERRED if execution yielded again and otherwise the
+// final status of the invocation. Returns IREE_STATUS_FAILED_PRECONDITION if
+// the call is not suspended.
+IREE_API_EXPORT iree_status_t
+iree_vm_prepared_call_resume(iree_vm_prepared_call_t* call);
+
+// Synchronously invokes the function with arguments marshaled from |inputs|
+// and results marshaled into |outputs| as with iree_vm_invoke. Yielded
+// execution is resumed until the invocation completes.
+// List ownership remains with the caller.
+IREE_API_EXPORT iree_status_t iree_vm_prepared_call_invoke_lists(
+    iree_vm_prepared_call_t* call, iree_vm_list_t* inputs,
+    iree_vm_list_t* outputs);
+
 // TODO(benvanik): document and implement.
 IREE_API_EXPORT iree_status_t iree_vm_invocation_create(
     iree_vm_context_t* context, iree_vm_function_t function,
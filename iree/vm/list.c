@@ -58,6 +58,9 @@ struct iree_vm_list_t {
   // A flat dense array of elements in the type defined by storage_mode.
   // For certain storage modes, such as IREE_VM_STORAGE_MODE_REF, special
   // lifetime management and cleanup logic is required.
+  // Values are stored in host byte order and all members of the
+  // iree_vm_value_t union begin at the same address so elements can be copied
+  // to and from value storage with memcpy regardless of host endianness.
   void* storage;
 };
 
@@ -357,21 +360,8 @@ iree_vm_list_get_value(const iree_vm_list_t* list, iree_host_size_t i,
   switch (list->storage_mode) {
     case IREE_VM_LIST_STORAGE_MODE_VALUE: {
       out_value->type = list->element_type.value_type;
-      // TODO(benvanik): #ifdef on LITTLE/BIG_ENDIAN and just memcpy.
-      switch (list->element_size) {
-        case 1:
-          out_value->i8 = *(int8_t*)element_ptr;
-          break;
-        case 2:
-          out_value->i16 = *(int16_t*)element_ptr;
-          break;
-        case 4:
-          out_value->i32 = *(int32_t*)element_ptr;
-          break;
-        case 8:
-          out_value->i64 = *(int64_t*)element_ptr;
-          break;
-      }
+      memcpy(out_value->value_storage, (const void*)element_ptr,
+             list->element_size);
       break;
     }
     case IREE_VM_LIST_STORAGE_MODE_VARIANT: {
@@ -404,21 +394,8 @@ IREE_API_EXPORT iree_status_t iree_vm_list_get_value_as(
   switch (list->storage_mode) {
     case IREE_VM_LIST_STORAGE_MODE_VALUE: {
       value.type = list->element_type.value_type;
-      // TODO(benvanik): #ifdef on LITTLE/BIG_ENDIAN and just memcpy.
-      switch (list->element_size) {
-        case 1:
-          value.i8 = *(int8_t*)element_ptr;
-          break;
-        case 2:
-          value.i16 = *(int16_t*)element_ptr;
-          break;
-        case 4:
-          value.i32 = *(int32_t*)element_ptr;
-          break;
-        case 8:
-          value.i64 = *(int64_t*)element_ptr;
-          break;
-      }
+      memcpy(value.value_storage, (const void*)element_ptr,
+             list->element_size);
       break;
     }
     case IREE_VM_LIST_STORAGE_MODE_VARIANT: {
@@ -465,21 +442,8 @@ IREE_API_EXPORT iree_status_t iree_vm_list_set_value(
   uintptr_t element_ptr = (uintptr_t)list->storage + i * list->element_size;
   switch (list->storage_mode) {
     case IREE_VM_LIST_STORAGE_MODE_VALUE: {
-      // TODO(benvanik): #ifdef on LITTLE/BIG_ENDIAN and just memcpy.
-      switch (list->element_size) {
-        case 1:
-          *(int8_t*)element_ptr = converted_value.i8;
-          break;
-        case 2:
-          *(int16_t*)element_ptr = converted_value.i16;
-          break;
-        case 4:
-          *(int32_t*)element_ptr = converted_value.i32;
-          break;
-        case 8:
-          *(int64_t*)element_ptr = converted_value.i64;
-          break;
-      }
+      memcpy((void*)element_ptr, converted_value.value_storage,
+             list->element_size);
       break;
     }
     case IREE_VM_LIST_STORAGE_MODE_VARIANT: {
@@ -500,6 +464,75 @@ IREE_API_EXPORT iree_status_t iree_vm_list_set_value(
   return iree_ok_status();
 }
 
+// Verifies that [i, i + count) is in range of |list| and returns the size of
+// each |value_type| element.
+static iree_status_t iree_vm_list_verify_value_range(
+    const iree_vm_list_t* list, iree_host_size_t i, iree_host_size_t count,
+    iree_vm_value_type_t value_type, iree_host_size_t* out_value_size) {
+  if (IREE_UNLIKELY(value_type <= IREE_VM_VALUE_TYPE_NONE ||
+                    value_type >= IREE_VM_VALUE_TYPE_COUNT)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid value type %d", (int)value_type);
+  }
+  if (IREE_UNLIKELY(i > list->count || count > list->count - i)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "range [%zu, %zu) out of bounds (%zu)", i,
+                            i + count, list->count);
+  }
+  *out_value_size = kValueTypeSizes[value_type];
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values(
+    const iree_vm_list_t* list, iree_host_size_t i, iree_host_size_t count,
+    iree_vm_value_type_t value_type, void* out_values) {
+  iree_host_size_t value_size = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_list_verify_value_range(
+      list, i, count, value_type, &value_size));
+  if (list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VALUE &&
+      list->element_type.value_type == value_type) {
+    // Storage matches the requested layout exactly.
+    memcpy(out_values,
+           (const void*)((uintptr_t)list->storage + i * list->element_size),
+           count * value_size);
+    return iree_ok_status();
+  }
+  uint8_t* value_ptr = (uint8_t*)out_values;
+  for (iree_host_size_t j = 0; j < count; ++j) {
+    iree_vm_value_t value;
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_get_value_as(list, i + j, value_type, &value));
+    memcpy(value_ptr, value.value_storage, value_size);
+    value_ptr += value_size;
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t i, iree_host_size_t count,
+    iree_vm_value_type_t value_type, const void* values) {
+  iree_host_size_t value_size = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_list_verify_value_range(
+      list, i, count, value_type, &value_size));
+  if (list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VALUE &&
+      list->element_type.value_type == value_type) {
+    // Storage matches the provided layout exactly.
+    memcpy((void*)((uintptr_t)list->storage + i * list->element_size), values,
+           count * value_size);
+    return iree_ok_status();
+  }
+  const uint8_t* value_ptr = (const uint8_t*)values;
+  for (iree_host_size_t j = 0; j < count; ++j) {
+    iree_vm_value_t value;
+    value.type = value_type;
+    value.i64 = 0;
+    memcpy(value.value_storage, value_ptr, value_size);
+    IREE_RETURN_IF_ERROR(iree_vm_list_set_value(list, i + j, &value));
+    value_ptr += value_size;
+  }
+  return iree_ok_status();
+}
+
 IREE_API_EXPORT iree_status_t
 iree_vm_list_push_value(iree_vm_list_t* list, const iree_vm_value_t* value) {
   iree_host_size_t i = iree_vm_list_size(list);
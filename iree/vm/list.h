@@ -114,6 +114,21 @@ IREE_API_EXPORT iree_status_t iree_vm_list_get_value_as(
 IREE_API_EXPORT iree_status_t iree_vm_list_set_value(
     iree_vm_list_t* list, iree_host_size_t i, const iree_vm_value_t* value);
 
+// Copies |count| elements starting at index |i| into |out_values| as a dense
+// array of |value_type|. Elements are converted as with
+// iree_vm_list_get_value_as; lists storing |value_type| directly are copied
+// with a single memcpy.
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values(
+    const iree_vm_list_t* list, iree_host_size_t i, iree_host_size_t count,
+    iree_vm_value_type_t value_type, void* out_values);
+
+// Sets |count| elements starting at index |i| from |values|, a dense array of
+// |value_type|. Elements are converted as with iree_vm_list_set_value; lists
+// storing |value_type| directly are copied with a single memcpy.
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t i, iree_host_size_t count,
+    iree_vm_value_type_t value_type, const void* values);
+
 // Pushes the value of the element to the end of the list.
 // If the specified |value| type differs from the list storage type the value
 // will be converted using the value type semantics (such as sign/zero extend,
@@ -177,6 +192,21 @@ iree_vm_list_get_variant(const iree_vm_list_t* list, iree_host_size_t i,
 IREE_API_EXPORT iree_status_t iree_vm_list_set_variant(
     iree_vm_list_t* list, iree_host_size_t i, const iree_vm_variant_t* value);
 
+// Copies |count| elements starting at index |i| into |out_values| as a dense
+// array of |value_type|. Elements are converted as with
+// iree_vm_list_get_value_as; lists storing |value_type| directly are copied
+// with a single memcpy.
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values(
+    const iree_vm_list_t* list, iree_host_size_t i, iree_host_size_t count,
+    iree_vm_value_type_t value_type, void* out_values);
+
+// Sets |count| elements starting at index |i| from |values|, a dense array of
+// |value_type|. Elements are converted as with iree_vm_list_set_value; lists
+// storing |value_type| directly are copied with a single memcpy.
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t i, iree_host_size_t count,
+    iree_vm_value_type_t value_type, const void* values);
+
 // Pushes the value of the element to the end of the list. If the specified
 // |value| type differs from the list storage type the value will be converted
 // using the value type semantics (such as sign/zero extend, etc). If the
@@ -383,6 +383,89 @@ TEST_F(VMListTest, ResizeVariant) {
   iree_vm_list_release(list);
 }
 
+// Tests bulk value get/set on lists storing the same value type directly.
+TEST_F(VMListTest, GetSetValuesI32) {
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_value_type(IREE_VM_VALUE_TYPE_I32);
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(iree_vm_list_create(&element_type, /*initial_capacity=*/8,
+                                     iree_allocator_system(), &list));
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 8));
+
+  int32_t values[4] = {10, -11, 12, -13};
+  IREE_ASSERT_OK(iree_vm_list_set_values(list, 2, IREE_ARRAYSIZE(values),
+                                         IREE_VM_VALUE_TYPE_I32, values));
+  for (iree_host_size_t i = 0; i < 8; ++i) {
+    iree_vm_value_t value;
+    IREE_ASSERT_OK(iree_vm_list_get_value(list, i, &value));
+    EXPECT_EQ(IREE_VM_VALUE_TYPE_I32, value.type);
+    EXPECT_EQ((i >= 2 && i < 6) ? values[i - 2] : 0, value.i32);
+  }
+
+  int32_t i32_values[3] = {0};
+  IREE_ASSERT_OK(iree_vm_list_get_values(list, 3, IREE_ARRAYSIZE(i32_values),
+                                         IREE_VM_VALUE_TYPE_I32, i32_values));
+  EXPECT_EQ(-11, i32_values[0]);
+  EXPECT_EQ(12, i32_values[1]);
+  EXPECT_EQ(-13, i32_values[2]);
+
+  // Other value types go through conversion (sign extension here).
+  int64_t i64_values[2] = {0};
+  IREE_ASSERT_OK(iree_vm_list_get_values(list, 3, IREE_ARRAYSIZE(i64_values),
+                                         IREE_VM_VALUE_TYPE_I64, i64_values));
+  EXPECT_EQ(-11, i64_values[0]);
+  EXPECT_EQ(12, i64_values[1]);
+
+  // Ranges must be entirely within the list.
+  EXPECT_THAT(Status(iree_vm_list_get_values(list, 6, 3, IREE_VM_VALUE_TYPE_I32,
+                                             i32_values)),
+              StatusIs(iree::StatusCode::kOutOfRange));
+  EXPECT_THAT(Status(iree_vm_list_set_values(list, 9, 0, IREE_VM_VALUE_TYPE_I32,
+                                             i32_values)),
+              StatusIs(iree::StatusCode::kOutOfRange));
+  IREE_EXPECT_OK(iree_vm_list_get_values(list, 8, 0, IREE_VM_VALUE_TYPE_I32,
+                                         i32_values));
+
+  iree_vm_list_release(list);
+}
+
+// Tests bulk value get/set on variant lists.
+TEST_F(VMListTest, GetSetValuesVariant) {
+  iree_vm_type_def_t element_type = iree_vm_type_def_make_variant_type();
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(iree_vm_list_create(&element_type, /*initial_capacity=*/4,
+                                     iree_allocator_system(), &list));
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 4));
+
+  float f32_values[2] = {1.5f, -2.5f};
+  IREE_ASSERT_OK(iree_vm_list_set_values(list, 0, IREE_ARRAYSIZE(f32_values),
+                                         IREE_VM_VALUE_TYPE_F32, f32_values));
+  int64_t i64_values[2] = {1ll << 40, -3};
+  IREE_ASSERT_OK(iree_vm_list_set_values(list, 2, IREE_ARRAYSIZE(i64_values),
+                                         IREE_VM_VALUE_TYPE_I64, i64_values));
+
+  iree_vm_value_t value;
+  IREE_ASSERT_OK(iree_vm_list_get_value(list, 1, &value));
+  EXPECT_EQ(IREE_VM_VALUE_TYPE_F32, value.type);
+  EXPECT_EQ(-2.5f, value.f32);
+  IREE_ASSERT_OK(iree_vm_list_get_value(list, 2, &value));
+  EXPECT_EQ(IREE_VM_VALUE_TYPE_I64, value.type);
+  EXPECT_EQ(1ll << 40, value.i64);
+
+  float f32_results[2] = {0.0f};
+  IREE_ASSERT_OK(iree_vm_list_get_values(list, 0, IREE_ARRAYSIZE(f32_results),
+                                         IREE_VM_VALUE_TYPE_F32, f32_results));
+  EXPECT_EQ(1.5f, f32_results[0]);
+  EXPECT_EQ(-2.5f, f32_results[1]);
+  int64_t i64_results[2] = {0};
+  IREE_ASSERT_OK(iree_vm_list_get_values(list, 2, IREE_ARRAYSIZE(i64_results),
+                                         IREE_VM_VALUE_TYPE_I64, i64_results));
+  EXPECT_EQ(1ll << 40, i64_results[0]);
+  EXPECT_EQ(-3, i64_results[1]);
+
+  iree_vm_list_release(list);
+}
+
 // TODO(benvanik): test value get/set.
 
 // TODO(benvanik): test value conversion.
@@ -263,6 +263,41 @@ typedef struct iree_vm_execution_result_t {
   int reserved;
 } iree_vm_execution_result_t;
 
+// Maximum number of arguments or results of a directly callable function.
+#define IREE_VM_DIRECT_CALL_MAX_VALUES 8
+
+// Calls a function taking and returning only primitive values (i32, i64, f32,
+// f64) without a stack frame or ABI buffer marshaling.
+// Each value occupies one 64-bit slot of |arguments| or |results| in the order
+// of the function cconv and is stored in the leading bytes of the slot as if
+// copied with memcpy. |module_state| is the callee module state in the context
+// of the caller.
+typedef iree_status_t(IREE_API_PTR* iree_vm_direct_call_fn_t)(
+    const void* function_data, iree_vm_module_state_t* module_state,
+    const uint64_t* IREE_RESTRICT arguments, uint64_t* IREE_RESTRICT results);
+
+// A function entry point callable directly with iree_vm_direct_call_fn_t.
+typedef struct iree_vm_direct_function_t {
+  iree_vm_direct_call_fn_t call;
+  const void* function_data;
+} iree_vm_direct_function_t;
+
+// Execution statistics of a function accumulated across all invocations made
+// with IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION in a context.
+typedef struct iree_vm_function_profile_t {
+  // Module containing the function.
+  iree_vm_module_t* module;
+  // Name of the function within the module or empty if not available.
+  iree_string_view_t name;
+  // Total number of times the function was entered.
+  uint64_t call_count;
+  // Total number of instructions executed within the function.
+  uint64_t instruction_count;
+  // Total host time spent executing within the function (including any
+  // imported functions it calls but excluding its internal callees).
+  iree_duration_t self_time_ns;
+} iree_vm_function_profile_t;
+
 //===----------------------------------------------------------------------===//
 // Source locations
 //===----------------------------------------------------------------------===//
@@ -381,12 +416,26 @@ typedef struct iree_vm_module_t {
   void(IREE_API_PTR* free_state)(void* self,
                                  iree_vm_module_state_t* module_state);
 
+  // Optional: allocates module state data initialized from |parent_state|.
+  // Used when forking contexts (see iree_vm_context_fork) to share immutable
+  // state such as constant buffers instead of rerunning initializers. The new
+  // state must not reference |parent_state| itself as the parent may be freed
+  // first. Imports will be resolved on the new state after it is returned.
+  // If omitted the state is allocated with alloc_state and initialized as if
+  // registered with a new context.
+  iree_status_t(IREE_API_PTR* fork_state)(
+      void* self, iree_vm_module_state_t* parent_state,
+      iree_allocator_t allocator, iree_vm_module_state_t** out_module_state);
+
   // Resolves the import with the given ordinal to |function|.
-  // The function is guaranteed to remain valid for the lifetime of the module
-  // state.
+  // |function_state| is the state of the module containing |function| within
+  // the same context and may be cached to call the function without querying
+  // it again. Both are guaranteed to remain valid for the lifetime of the
+  // module state.
   iree_status_t(IREE_API_PTR* resolve_import)(
       void* self, iree_vm_module_state_t* module_state,
       iree_host_size_t ordinal, const iree_vm_function_t* function,
+      iree_vm_module_state_t* function_state,
       const iree_vm_function_signature_t* signature);
 
   // Notifies the module of a system signal.
@@ -406,6 +455,22 @@ typedef struct iree_vm_module_t {
       void* self, iree_vm_stack_t* stack,
       iree_vm_execution_result_t* out_result);
 
+  // Optional: gets a direct entry point for the exported function |ordinal|.
+  // Callers may use it in place of begin_call when the function has at most
+  // IREE_VM_DIRECT_CALL_MAX_VALUES primitive arguments and results. Direct
+  // calls have no stack frame and must not yield. Returns
+  // IREE_STATUS_UNAVAILABLE if the function cannot be called directly.
+  iree_status_t(IREE_API_PTR* get_direct_function)(
+      void* self, iree_host_size_t ordinal,
+      iree_vm_direct_function_t* out_direct_function);
+
+  // Optional: gets the execution profile of the internal function |ordinal|
+  // accumulated in |module_state|. Modules that support profiling have one
+  // profile per internal function as reported by the module signature.
+  iree_status_t(IREE_API_PTR* get_function_profile)(
+      void* self, iree_vm_module_state_t* module_state,
+      iree_host_size_t ordinal, iree_vm_function_profile_t* out_profile);
+
   // TODO(benvanik): move this/refactor.
   // Gets a reflection attribute for a function by index.
   // The returned key and value strings are guaranteed valid for the life
@@ -257,14 +257,24 @@ static void IREE_API_PTR iree_vm_native_module_free_state(
   assert(!module_state);
 }
 
+static iree_status_t IREE_API_PTR iree_vm_native_module_fork_state(
+    void* self, iree_vm_module_state_t* parent_state,
+    iree_allocator_t allocator, iree_vm_module_state_t** out_module_state) {
+  iree_vm_native_module_t* module = (iree_vm_native_module_t*)self;
+  *out_module_state = NULL;
+  return module->user_interface.fork_state(module->self, parent_state,
+                                           allocator, out_module_state);
+}
+
 static iree_status_t IREE_API_PTR iree_vm_native_module_resolve_import(
     void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
-    const iree_vm_function_t* function,
+    const iree_vm_function_t* function, iree_vm_module_state_t* function_state,
     const iree_vm_function_signature_t* signature) {
   iree_vm_native_module_t* module = (iree_vm_native_module_t*)self;
   if (module->user_interface.resolve_import) {
-    return module->user_interface.resolve_import(module->self, module_state,
-                                                 ordinal, function, signature);
+    return module->user_interface.resolve_import(
+        module->self, module_state, ordinal, function, function_state,
+        signature);
   }
   return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
                           "native module does not support imports");
@@ -436,6 +446,11 @@ IREE_API_EXPORT iree_status_t iree_vm_native_module_initialize(
       iree_vm_native_module_lookup_function;
   module->base_interface.alloc_state = iree_vm_native_module_alloc_state;
   module->base_interface.free_state = iree_vm_native_module_free_state;
+  // Forking is only supported if the user implements it so that the context
+  // can fall back to initializing fresh state.
+  module->base_interface.fork_state =
+      module->user_interface.fork_state ? iree_vm_native_module_fork_state
+                                        : NULL;
   module->base_interface.resolve_import = iree_vm_native_module_resolve_import;
   module->base_interface.notify = iree_vm_native_module_notify;
   module->base_interface.begin_call = iree_vm_native_module_begin_call;
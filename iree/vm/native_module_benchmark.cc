@@ -4,16 +4,136 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <cstdint>
+#include <memory>
+
 #include "benchmark/benchmark.h"
 #include "iree/base/api.h"
 #include "iree/base/logging.h"
-#include "iree/vm/module.h"
-#include "iree/vm/native_module.h"
+#include "iree/vm/api.h"
+#include "iree/vm/native_module_cc.h"
 #include "iree/vm/native_module_test.h"
-#include "iree/vm/stack.h"
 
+namespace iree {
+namespace vm {
 namespace {
 
-// TODO(benvanik): native module benchmarks.
+class CcModuleState final {
+ public:
+  StatusOr<int32_t> Add1(int32_t value) { return value + 1; }
+};
+
+static const NativeFunction<CcModuleState> kCcModuleFunctions[] = {
+    MakeNativeFunction("add_1", &CcModuleState::Add1),
+};
+
+class CcModule final : public NativeModule<CcModuleState> {
+ public:
+  using NativeModule<CcModuleState>::NativeModule;
+
+  StatusOr<std::unique_ptr<CcModuleState>> CreateState(
+      iree_allocator_t allocator) override {
+    return std::make_unique<CcModuleState>();
+  }
+};
+
+// Context holding a single |module| with a stack able to call into it.
+class ModuleFixture {
+ public:
+  explicit ModuleFixture(iree_vm_module_t* module) : module_(module) {
+    IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance_));
+    IREE_CHECK_OK(iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_NONE, &module_, /*module_count=*/1,
+        iree_allocator_system(), &context_));
+    IREE_CHECK_OK(iree_vm_stack_allocate(
+        IREE_VM_INVOCATION_FLAG_NONE, iree_vm_context_state_resolver(context_),
+        iree_allocator_system(), &stack_));
+    IREE_CHECK_OK(iree_vm_module_lookup_function_by_name(
+        module_, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_make_cstring_view("add_1"), &function_));
+  }
+
+  ~ModuleFixture() {
+    iree_vm_stack_free(stack_);
+    iree_vm_context_release(context_);
+    iree_vm_module_release(module_);
+    iree_vm_instance_release(instance_);
+  }
+
+  iree_vm_module_t* module() { return module_; }
+  iree_vm_stack_t* stack() { return stack_; }
+  const iree_vm_function_t& function() const { return function_; }
+
+ private:
+  iree_vm_instance_t* instance_ = nullptr;
+  iree_vm_module_t* module_ = nullptr;
+  iree_vm_context_t* context_ = nullptr;
+  iree_vm_stack_t* stack_ = nullptr;
+  iree_vm_function_t function_;
+};
+
+// Calls `add_1` through begin_call as the bytecode dispatcher does for imports
+// without a direct entry point.
+static void RunBeginCall(benchmark::State& state, ModuleFixture& fixture) {
+  int32_t value = 0;
+  for (auto _ : state) {
+    int32_t result = 0;
+    iree_vm_function_call_t call;
+    call.function = fixture.function();
+    call.arguments = iree_make_byte_span(&value, sizeof(value));
+    call.results = iree_make_byte_span(&result, sizeof(result));
+    iree_vm_execution_result_t execution_result;
+    IREE_CHECK_OK(fixture.module()->begin_call(
+        fixture.module()->self, fixture.stack(), &call, &execution_result));
+    value = result;
+  }
+  benchmark::DoNotOptimize(value);
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_NativeModuleBeginCall(benchmark::State& state) {
+  iree_vm_module_t* module = nullptr;
+  IREE_CHECK_OK(module_a_create(iree_allocator_system(), &module));
+  ModuleFixture fixture(module);
+  RunBeginCall(state, fixture);
+}
+BENCHMARK(BM_NativeModuleBeginCall);
+
+static void BM_CcModuleBeginCall(benchmark::State& state) {
+  auto module = std::make_unique<CcModule>(
+      "cc_module", iree_allocator_system(),
+      iree::span<const NativeFunction<CcModuleState>>(kCcModuleFunctions));
+  ModuleFixture fixture(module.release()->interface());
+  RunBeginCall(state, fixture);
+}
+BENCHMARK(BM_CcModuleBeginCall);
+
+// Calls `add_1` through its direct entry point as the bytecode dispatcher does
+// for primitive-only imports.
+static void BM_CcModuleDirectCall(benchmark::State& state) {
+  auto module = std::make_unique<CcModule>(
+      "cc_module", iree_allocator_system(),
+      iree::span<const NativeFunction<CcModuleState>>(kCcModuleFunctions));
+  ModuleFixture fixture(module.release()->interface());
+  iree_vm_direct_function_t direct_function;
+  IREE_CHECK_OK(fixture.module()->get_direct_function(
+      fixture.module()->self, fixture.function().ordinal, &direct_function));
+  iree_vm_module_state_t* module_state = nullptr;
+  IREE_CHECK_OK(iree_vm_stack_query_module_state(
+      fixture.stack(), fixture.module(), &module_state));
+
+  uint64_t arguments[1] = {0};
+  uint64_t results[1] = {0};
+  for (auto _ : state) {
+    IREE_CHECK_OK(direct_function.call(direct_function.function_data,
+                                       module_state, arguments, results));
+    arguments[0] = results[0];
+  }
+  benchmark::DoNotOptimize(results[0]);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CcModuleDirectCall);
 
 }  // namespace
+}  // namespace vm
+}  // namespace iree
@@ -36,6 +36,11 @@ namespace vm {
 // tuples of mixed types, or dynamic arrays (variadic arguments). Results may be
 // returned as either their type or an std::tuple/std::array of types.
 //
+// Functions taking and returning only 32-bit and 64-bit primitive values (or
+// std::tuples of them) also expose a direct entry point. Bytecode modules
+// importing them call it without entering a stack frame or marshaling through
+// the ABI buffers.
+//
 // Usage:
 //   // Per-context module state that must only be thread-compatible.
 //   // Define
@@ -80,6 +85,7 @@ class NativeModule {
     interface_.resolve_import = NativeModule::ModuleResolveImport;
     interface_.notify = NativeModule::ModuleNotify;
     interface_.begin_call = NativeModule::ModuleBeginCall;
+    interface_.get_direct_function = NativeModule::ModuleGetDirectFunction;
   }
 
   virtual ~NativeModule() = default;
@@ -202,6 +208,7 @@ class NativeModule {
   static iree_status_t ModuleResolveImport(
       void* self, iree_vm_module_state_t* module_state,
       iree_host_size_t ordinal, const iree_vm_function_t* function,
+      iree_vm_module_state_t* function_state,
       const iree_vm_function_signature_t* signature) {
     return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
                             "C++ API does not support imports");
@@ -250,6 +257,39 @@ class NativeModule {
     return iree_vm_stack_function_leave(stack);
   }
 
+  static iree_status_t ModuleGetDirectFunction(
+      void* self, iree_host_size_t ordinal,
+      iree_vm_direct_function_t* out_direct_function) {
+    IREE_ASSERT_ARGUMENT(out_direct_function);
+    std::memset(out_direct_function, 0, sizeof(*out_direct_function));
+    auto* module = FromModulePointer(self);
+    if (IREE_UNLIKELY(ordinal >= module->dispatch_table_.size())) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "function ordinal out of bounds: 0 < %zu < %zu",
+                              ordinal, module->dispatch_table_.size());
+    }
+    const auto& info = module->dispatch_table_[ordinal];
+    if (!info.direct_call) {
+      return iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+    }
+    out_direct_function->call = NativeModule::ModuleDirectCall;
+    out_direct_function->function_data = &info;
+    return iree_ok_status();
+  }
+
+  // Calls a function resolved with ModuleGetDirectFunction. Unlike
+  // ModuleBeginCall no stack frame is entered and the arguments are passed
+  // to the function without unpacking from the ABI buffers.
+  static iree_status_t ModuleDirectCall(const void* function_data,
+                                        iree_vm_module_state_t* module_state,
+                                        const uint64_t* IREE_RESTRICT arguments,
+                                        uint64_t* IREE_RESTRICT results) {
+    const auto& info =
+        *reinterpret_cast<const NativeFunction<State>*>(function_data);
+    return info.direct_call(info.ptr, FromStatePointer(module_state),
+                            arguments, results);
+  }
+
   const char* name_;
   const iree_allocator_t allocator_;
   iree_vm_module_t interface_;
@@ -7,6 +7,7 @@
 #ifndef IREE_VM_MODULE_ABI_PACKING_H_
 #define IREE_VM_MODULE_ABI_PACKING_H_
 
+#include <cstring>
 #include <memory>
 #include <tuple>
 #include <utility>
@@ -668,6 +669,153 @@ struct DispatchFunctorVoid {
   }
 };
 
+//===----------------------------------------------------------------------===//
+// Direct calls
+//===----------------------------------------------------------------------===//
+
+namespace impl {
+
+template <bool... B>
+struct bool_pack;
+template <bool... B>
+using all_true = std::is_same<bool_pack<true, B...>, bool_pack<B..., true>>;
+
+// Values that can be passed in iree_vm_direct_call_fn_t slots: those mapping to
+// the `i` (32-bit) and `I` (64-bit) cconv types.
+template <typename T>
+struct is_direct_value
+    : std::integral_constant<bool, ((std::is_arithmetic<T>::value ||
+                                     std::is_enum<T>::value) &&
+                                    sizeof(T) == sizeof(int32_t)) ||
+                                       std::is_same<T, int64_t>::value ||
+                                       std::is_same<T, uint64_t>::value> {};
+
+template <typename T>
+static inline T LoadDirectValue(const uint64_t& slot) {
+  T value;
+  std::memcpy(&value, &slot, sizeof(T));
+  return value;
+}
+
+template <typename T>
+static inline void StoreDirectValue(uint64_t& slot, const T& value) {
+  std::memcpy(&slot, &value, sizeof(T));
+}
+
+template <typename T, typename Enable = void>
+struct DirectResult {
+  static constexpr bool value = false;
+};
+
+template <typename T>
+struct DirectResult<T,
+                    typename std::enable_if<is_direct_value<T>::value>::type> {
+  static constexpr bool value = true;
+  static void Store(uint64_t* results, const T& value) {
+    StoreDirectValue(results[0], value);
+  }
+};
+
+template <typename... Ts>
+struct DirectResult<
+    std::tuple<Ts...>,
+    typename std::enable_if<
+        all_true<is_direct_value<Ts>::value...>::value &&
+        sizeof...(Ts) <= IREE_VM_DIRECT_CALL_MAX_VALUES>::type> {
+  static constexpr bool value = true;
+  static void Store(uint64_t* results, const std::tuple<Ts...>& value) {
+    StoreSequence(results, value, std::make_index_sequence<sizeof...(Ts)>());
+  }
+  template <size_t... I>
+  static void StoreSequence(uint64_t* results, const std::tuple<Ts...>& value,
+                            std::index_sequence<I...>) {
+    impl::order_sequence{
+        (StoreDirectValue(results[I], std::get<I>(value)), 0)...};
+  }
+};
+
+template <typename... Params>
+using direct_params =
+    std::integral_constant<bool,
+                           all_true<is_direct_value<typename remove_cvref<
+                               Params>::type>::value...>::value &&
+                               sizeof...(Params) <=
+                                   IREE_VM_DIRECT_CALL_MAX_VALUES>;
+
+}  // namespace impl
+
+template <typename Owner>
+using DirectCallFn = Status (*)(void (Owner::*ptr)(), Owner* self,
+                                const uint64_t* arguments, uint64_t* results);
+
+// Calls methods taking and returning only primitive values directly from
+// iree_vm_direct_call_fn_t slots. Only available when kEnabled is true.
+template <typename Owner, typename Result, typename... Params>
+struct DirectFunctor {
+  using FnPtr = StatusOr<Result> (Owner::*)(Params...);
+  static constexpr bool kEnabled = impl::DirectResult<Result>::value &&
+                                   impl::direct_params<Params...>::value;
+
+  static constexpr DirectCallFn<Owner> Get() {
+    return Select(std::integral_constant<bool, kEnabled>());
+  }
+
+  static Status Call(void (Owner::*ptr)(), Owner* self,
+                     const uint64_t* arguments, uint64_t* results) {
+    IREE_ASSIGN_OR_RETURN(
+        auto value, ApplyFn(reinterpret_cast<FnPtr>(ptr), self, arguments,
+                            std::make_index_sequence<sizeof...(Params)>()));
+    impl::DirectResult<Result>::Store(results, value);
+    return OkStatus();
+  }
+
+ private:
+  static constexpr DirectCallFn<Owner> Select(std::true_type) { return &Call; }
+  static constexpr DirectCallFn<Owner> Select(std::false_type) {
+    return nullptr;
+  }
+
+  template <size_t... I>
+  static StatusOr<Result> ApplyFn(FnPtr ptr, Owner* self,
+                                  const uint64_t* arguments,
+                                  std::index_sequence<I...>) {
+    return (self->*ptr)(
+        impl::LoadDirectValue<typename impl::remove_cvref<Params>::type>(
+            arguments[I])...);
+  }
+};
+
+// A DirectFunctor specialization for methods with no return values.
+template <typename Owner, typename... Params>
+struct DirectFunctorVoid {
+  using FnPtr = Status (Owner::*)(Params...);
+  static constexpr bool kEnabled = impl::direct_params<Params...>::value;
+
+  static constexpr DirectCallFn<Owner> Get() {
+    return Select(std::integral_constant<bool, kEnabled>());
+  }
+
+  static Status Call(void (Owner::*ptr)(), Owner* self,
+                     const uint64_t* arguments, uint64_t* results) {
+    return ApplyFn(reinterpret_cast<FnPtr>(ptr), self, arguments,
+                   std::make_index_sequence<sizeof...(Params)>());
+  }
+
+ private:
+  static constexpr DirectCallFn<Owner> Select(std::true_type) { return &Call; }
+  static constexpr DirectCallFn<Owner> Select(std::false_type) {
+    return nullptr;
+  }
+
+  template <size_t... I>
+  static Status ApplyFn(FnPtr ptr, Owner* self, const uint64_t* arguments,
+                        std::index_sequence<I...>) {
+    return (self->*ptr)(
+        impl::LoadDirectValue<typename impl::remove_cvref<Params>::type>(
+            arguments[I])...);
+  }
+};
+
 }  // namespace packing
 
 template <typename Owner>
@@ -679,24 +827,31 @@ struct NativeFunction {
                        iree_vm_stack_t* stack,
                        const iree_vm_function_call_t* call,
                        iree_vm_execution_result_t* out_result);
+  // Called in place of |call| by callers using iree_vm_direct_call_fn_t.
+  // Only present for functions with primitive arguments and results.
+  const packing::DirectCallFn<Owner> direct_call;
 };
 
 template <typename Owner, typename Result, typename... Params>
 constexpr NativeFunction<Owner> MakeNativeFunction(
     const char* name, StatusOr<Result> (Owner::*fn)(Params...)) {
   using dispatch_functor_t = packing::DispatchFunctor<Owner, Result, Params...>;
+  using direct_functor_t = packing::DirectFunctor<Owner, Result, Params...>;
   return {iree_make_cstring_view(name),
           packing::cconv_storage<Result, sizeof...(Params), Params...>::value(),
-          (void (Owner::*)())fn, &dispatch_functor_t::Call};
+          (void (Owner::*)())fn, &dispatch_functor_t::Call,
+          direct_functor_t::Get()};
 }
 
 template <typename Owner, typename... Params>
 constexpr NativeFunction<Owner> MakeNativeFunction(
     const char* name, Status (Owner::*fn)(Params...)) {
   using dispatch_functor_t = packing::DispatchFunctorVoid<Owner, Params...>;
+  using direct_functor_t = packing::DirectFunctorVoid<Owner, Params...>;
   return {iree_make_cstring_view(name),
           packing::cconv_storage_void<sizeof...(Params), Params...>::value(),
-          (void (Owner::*)())fn, &dispatch_functor_t::Call};
+          (void (Owner::*)())fn, &dispatch_functor_t::Call,
+          direct_functor_t::Get()};
 }
 
 }  // namespace vm
@@ -6,6 +6,7 @@
 
 #include "iree/vm/native_module_test.h"
 
+#include <cstring>
 #include <vector>
 
 #include "iree/base/status_cc.h"
@@ -56,12 +57,18 @@ class VMNativeModuleTest : public ::testing::Test {
 
   StatusOr<int32_t> RunFunction(iree_string_view_t function_name,
                                 int32_t arg0) {
+    return RunFunction(context_, function_name, arg0);
+  }
+
+  StatusOr<int32_t> RunFunction(iree_vm_context_t* context,
+                                iree_string_view_t function_name,
+                                int32_t arg0) {
     // Lookup the entry function. This can be cached in an application if
     // multiple calls will be made.
     iree_vm_function_t function;
     IREE_RETURN_IF_ERROR(
         iree_vm_context_resolve_function(
-            context_, iree_make_cstring_view("module_b.entry"), &function),
+            context, iree_make_cstring_view("module_b.entry"), &function),
         "unable to resolve entry point");
 
     // Setup I/O lists and pass in the argument. The result list will be
@@ -78,7 +85,7 @@ class VMNativeModuleTest : public ::testing::Test {
 
     // Invoke the entry function to do our work. Runs synchronously.
     IREE_RETURN_IF_ERROR(
-        iree_vm_invoke(context_, function, IREE_VM_INVOCATION_FLAG_NONE,
+        iree_vm_invoke(context, function, IREE_VM_INVOCATION_FLAG_NONE,
                        /*policy=*/nullptr, input_list.get(), output_list.get(),
                        iree_allocator_system()));
 
@@ -89,7 +96,7 @@ class VMNativeModuleTest : public ::testing::Test {
     return ret0_value.i32;
   }
 
- private:
+ protected:
   iree_vm_instance_t* instance_ = nullptr;
   iree_vm_context_t* context_ = nullptr;
 };
@@ -106,5 +113,117 @@ TEST_F(VMNativeModuleTest, Example) {
   ASSERT_EQ(v2, 8);
 }
 
+// Tests that forked contexts start from the parent state and then diverge.
+TEST_F(VMNativeModuleTest, Fork) {
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v0, RunFunction(iree_make_cstring_view("module_b.entry"), 1));
+  ASSERT_EQ(v0, 1);
+
+  iree_vm_context_t* fork = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_context_fork(context_, iree_allocator_system(), &fork));
+  EXPECT_NE(iree_vm_context_id(fork), iree_vm_context_id(context_));
+
+  // The fork continues from the parent counter without affecting it.
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v1,
+      RunFunction(fork, iree_make_cstring_view("module_b.entry"), 2));
+  EXPECT_EQ(v1, 4);
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v2, RunFunction(iree_make_cstring_view("module_b.entry"), 3));
+  EXPECT_EQ(v2, 5);
+
+  // Forks are independent of the parent lifetime.
+  iree_vm_context_release(context_);
+  context_ = fork;
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v3, RunFunction(iree_make_cstring_view("module_b.entry"), 3));
+  EXPECT_EQ(v3, 8);
+}
+
+// Tests that only frozen contexts can be forked.
+TEST_F(VMNativeModuleTest, ForkRequiresFrozen) {
+  iree_vm_context_t* context = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_create(instance_, IREE_VM_CONTEXT_FLAG_NONE,
+                                        iree_allocator_system(), &context));
+  iree_vm_context_t* fork = nullptr;
+  EXPECT_THAT(
+      Status(iree_vm_context_fork(context, iree_allocator_system(), &fork)),
+      testing::status::StatusIs(StatusCode::kFailedPrecondition));
+  IREE_ASSERT_OK(iree_vm_context_freeze(context));
+  IREE_ASSERT_OK(iree_vm_context_fork(context, iree_allocator_system(), &fork));
+  iree_vm_context_release(fork);
+  iree_vm_context_release(context);
+}
+
+// Tests repeated invocation of a prepared call with raw ABI arguments.
+TEST_F(VMNativeModuleTest, PreparedCall) {
+  iree_vm_function_t function;
+  IREE_ASSERT_OK(iree_vm_context_resolve_function(
+      context_, iree_make_cstring_view("module_b.entry"), &function));
+  iree_vm_prepared_call_t* call = nullptr;
+  IREE_ASSERT_OK(iree_vm_prepared_call_create(
+      context_, function, IREE_VM_INVOCATION_FLAG_NONE,
+      iree_allocator_system(), &call));
+
+  iree_byte_span_t arguments = iree_vm_prepared_call_arguments(call);
+  iree_byte_span_t results = iree_vm_prepared_call_results(call);
+  ASSERT_EQ(arguments.data_length, sizeof(int32_t));
+  ASSERT_EQ(results.data_length, sizeof(int32_t));
+
+  // module_b.entry accumulates into per-context state so each invocation must
+  // observe the prior ones.
+  const int32_t expected_results[] = {1, 4, 8};
+  for (int32_t i = 0; i < 3; ++i) {
+    int32_t arg0 = i + 1;
+    memcpy(arguments.data, &arg0, sizeof(arg0));
+    IREE_ASSERT_OK(iree_vm_prepared_call_invoke(call));
+    int32_t ret0 = 0;
+    memcpy(&ret0, results.data, sizeof(ret0));
+    EXPECT_EQ(ret0, expected_results[i]);
+  }
+
+  iree_vm_prepared_call_destroy(call);
+}
+
+// Tests that prepared calls marshal lists the same as iree_vm_invoke.
+TEST_F(VMNativeModuleTest, PreparedCallLists) {
+  iree_vm_function_t function;
+  IREE_ASSERT_OK(iree_vm_context_resolve_function(
+      context_, iree_make_cstring_view("module_b.entry"), &function));
+  iree_vm_prepared_call_t* call = nullptr;
+  IREE_ASSERT_OK(iree_vm_prepared_call_create(
+      context_, function, IREE_VM_INVOCATION_FLAG_NONE,
+      iree_allocator_system(), &call));
+
+  vm::ref<iree_vm_list_t> input_list;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/nullptr, 1,
+                                     iree_allocator_system(), &input_list));
+  IREE_ASSERT_OK(iree_vm_list_resize(input_list.get(), 1));
+  vm::ref<iree_vm_list_t> output_list;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/nullptr, 1,
+                                     iree_allocator_system(), &output_list));
+
+  const int32_t expected_results[] = {1, 4, 8};
+  for (int32_t i = 0; i < 3; ++i) {
+    auto arg0_value = iree_vm_value_make_i32(i + 1);
+    IREE_ASSERT_OK(iree_vm_list_set_value(input_list.get(), 0, &arg0_value));
+    IREE_ASSERT_OK(iree_vm_prepared_call_invoke_lists(call, input_list.get(),
+                                                      output_list.get()));
+    ASSERT_EQ(iree_vm_list_size(output_list.get()), 1);
+    iree_vm_value_t ret0_value;
+    IREE_ASSERT_OK(iree_vm_list_get_value(output_list.get(), 0, &ret0_value));
+    EXPECT_EQ(ret0_value.i32, expected_results[i]);
+  }
+
+  // Mismatched inputs fail without invoking the function.
+  IREE_ASSERT_OK(iree_vm_list_resize(input_list.get(), 2));
+  EXPECT_THAT(Status(iree_vm_prepared_call_invoke_lists(
+                  call, input_list.get(), output_list.get())),
+              testing::status::StatusIs(StatusCode::kInvalidArgument));
+
+  iree_vm_prepared_call_destroy(call);
+}
+
 }  // namespace
 }  // namespace iree
@@ -194,10 +194,23 @@ module_b_free_state(void* self, iree_vm_module_state_t* module_state) {
   iree_allocator_free(state->allocator, state);
 }
 
+// Allocates per-context state for a forked context starting from the state of
+// the parent context. Imports are resolved again for the new context.
+static iree_status_t IREE_API_PTR
+module_b_fork_state(void* self, iree_vm_module_state_t* parent_state,
+                    iree_allocator_t allocator,
+                    iree_vm_module_state_t** out_module_state) {
+  IREE_RETURN_IF_ERROR(
+      module_b_alloc_state(self, allocator, out_module_state));
+  module_b_state_t* state = (module_b_state_t*)*out_module_state;
+  state->counter = ((module_b_state_t*)parent_state)->counter;
+  return iree_ok_status();
+}
+
 // Called once per import function so the module can store the function ref.
 static iree_status_t IREE_API_PTR module_b_resolve_import(
     void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
-    const iree_vm_function_t* function,
+    const iree_vm_function_t* function, iree_vm_module_state_t* function_state,
     const iree_vm_function_signature_t* signature) {
   module_b_state_t* state = (module_b_state_t*)module_state;
   state->imports[ordinal] = *function;
@@ -301,6 +314,7 @@ static iree_status_t module_b_create(iree_allocator_t allocator,
   interface.destroy = module_b_destroy;
   interface.alloc_state = module_b_alloc_state;
   interface.free_state = module_b_free_state;
+  interface.fork_state = module_b_fork_state;
   interface.resolve_import = module_b_resolve_import;
   return iree_vm_native_module_create(&interface, &module_b_descriptor_,
                                       allocator, out_module);
@@ -17,32 +17,39 @@
 // or something more complex).
 #define IREE_VM_MAX_TYPE_ID 64
 
-static inline volatile iree_atomic_ref_count_t* iree_vm_get_raw_counter_ptr(
+static inline iree_atomic_ref_count_t* iree_vm_get_raw_counter_ptr(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
-  return (volatile iree_atomic_ref_count_t*)(((uintptr_t)(ptr)) +
-                                             type_descriptor->offsetof_counter);
-}
-
-static inline volatile iree_atomic_ref_count_t* iree_vm_get_ref_counter_ptr(
-    iree_vm_ref_t* ref) {
-  return (volatile iree_atomic_ref_count_t*)(((uintptr_t)ref->ptr) +
-                                             ref->offsetof_counter);
+  return (iree_atomic_ref_count_t*)(((uintptr_t)(ptr)) +
+                                    type_descriptor->offsetof_counter);
 }
 
 IREE_API_EXPORT void iree_vm_ref_object_retain(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
   if (!ptr) return;
-  volatile iree_atomic_ref_count_t* counter =
+  iree_atomic_ref_count_t* counter =
       iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
-  iree_atomic_ref_count_inc(counter);
+  if (type_descriptor->flags & IREE_VM_REF_TYPE_FLAG_THREAD_LOCAL) {
+    iree_atomic_store_int32(
+        counter, iree_atomic_load_int32(counter, iree_memory_order_relaxed) + 1,
+        iree_memory_order_relaxed);
+  } else {
+    iree_atomic_ref_count_inc(counter);
+  }
 }
 
 IREE_API_EXPORT void iree_vm_ref_object_release(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
   if (!ptr) return;
-  volatile iree_atomic_ref_count_t* counter =
+  iree_atomic_ref_count_t* counter =
       iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
-  if (iree_atomic_ref_count_dec(counter) == 1) {
+  int32_t value = 0;
+  if (type_descriptor->flags & IREE_VM_REF_TYPE_FLAG_THREAD_LOCAL) {
+    value = iree_atomic_load_int32(counter, iree_memory_order_relaxed);
+    iree_atomic_store_int32(counter, value - 1, iree_memory_order_relaxed);
+  } else {
+    value = iree_atomic_ref_count_dec(counter);
+  }
+  if (value == 1) {
     if (type_descriptor->destroy) {
       // NOTE: this makes us not re-entrant, but I think that's OK.
       type_descriptor->destroy(ptr);
@@ -71,7 +78,14 @@ static const iree_vm_ref_type_descriptor_t* iree_vm_ref_get_type_descriptor(
 
 IREE_API_EXPORT iree_status_t
 iree_vm_ref_register_type(iree_vm_ref_type_descriptor_t* descriptor) {
-  for (int i = 1; i <= IREE_VM_MAX_TYPE_ID; ++i) {
+  // iree_vm_ref_t only has room for 7 bits of counter offset.
+  if (descriptor->offsetof_counter >= 128) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "reference counter offset %u exceeds the maximum "
+                            "of 127 bytes",
+                            (uint32_t)descriptor->offsetof_counter);
+  }
+  for (int i = 1; i < IREE_VM_MAX_TYPE_ID; ++i) {
     if (!iree_vm_ref_type_descriptors[i]) {
       iree_vm_ref_type_descriptors[i] = descriptor;
       descriptor->type = i;
@@ -88,15 +102,15 @@ iree_vm_ref_register_type(iree_vm_ref_type_descriptor_t* descriptor) {
 
 IREE_API_EXPORT iree_string_view_t
 iree_vm_ref_type_name(iree_vm_ref_type_t type) {
-  if (type == 0 || type >= IREE_VM_MAX_TYPE_ID) {
-    return iree_string_view_empty();
-  }
-  return iree_vm_ref_type_descriptors[type]->type_name;
+  const iree_vm_ref_type_descriptor_t* type_descriptor =
+      iree_vm_ref_get_type_descriptor(type);
+  return type_descriptor ? type_descriptor->type_name
+                         : iree_string_view_empty();
 }
 
 IREE_API_EXPORT const iree_vm_ref_type_descriptor_t*
 iree_vm_ref_lookup_registered_type(iree_string_view_t full_name) {
-  for (int i = 1; i <= IREE_VM_MAX_TYPE_ID; ++i) {
+  for (int i = 1; i < IREE_VM_MAX_TYPE_ID; ++i) {
     if (!iree_vm_ref_type_descriptors[i]) break;
     if (iree_string_view_equal(iree_vm_ref_type_descriptors[i]->type_name,
                                full_name)) {
@@ -109,7 +123,7 @@ iree_vm_ref_lookup_registered_type(iree_string_view_t full_name) {
 // Useful debugging tool:
 #if 0
 static void iree_vm_ref_trace(const char* msg, iree_vm_ref_t* ref) {
-  volatile iree_atomic_ref_count_t* counter = iree_vm_get_ref_counter_ptr(ref);
+  iree_atomic_ref_count_t* counter = iree_vm_ref_counter_ptr(ref);
   iree_string_view_t name = iree_vm_ref_type_name(ref->type);
   fprintf(stderr, "%s %.*s 0x%p %d\n", msg, (int)name.size, name.data, ref->ptr,
           counter->__val);
@@ -138,6 +152,8 @@ IREE_API_EXPORT iree_status_t iree_vm_ref_wrap_assign(void* ptr,
   out_ref->ptr = ptr;
   out_ref->offsetof_counter = type_descriptor->offsetof_counter;
   out_ref->type = type;
+  out_ref->is_thread_local =
+      (type_descriptor->flags & IREE_VM_REF_TYPE_FLAG_THREAD_LOCAL) ? 1 : 0;
 
   iree_vm_ref_trace("WRAP ASSIGN", out_ref);
   return iree_ok_status();
@@ -148,9 +164,7 @@ IREE_API_EXPORT iree_status_t iree_vm_ref_wrap_retain(void* ptr,
                                                       iree_vm_ref_t* out_ref) {
   IREE_RETURN_IF_ERROR(iree_vm_ref_wrap_assign(ptr, type, out_ref));
   if (out_ref->ptr) {
-    volatile iree_atomic_ref_count_t* counter =
-        iree_vm_get_ref_counter_ptr(out_ref);
-    iree_atomic_ref_count_inc(counter);
+    iree_vm_ref_counter_inc(out_ref);
     iree_vm_ref_trace("WRAP RETAIN", out_ref);
   }
   return iree_ok_status();
@@ -158,22 +172,8 @@ IREE_API_EXPORT iree_status_t iree_vm_ref_wrap_retain(void* ptr,
 
 IREE_API_EXPORT void iree_vm_ref_retain(iree_vm_ref_t* ref,
                                         iree_vm_ref_t* out_ref) {
-  // NOTE: ref and out_ref may alias or be nested so we retain before we
-  // potentially release.
-  iree_vm_ref_t temp_ref = *ref;
-  if (ref->ptr) {
-    volatile iree_atomic_ref_count_t* counter =
-        iree_vm_get_ref_counter_ptr(ref);
-    iree_atomic_ref_count_inc(counter);
-    iree_vm_ref_trace("RETAIN", ref);
-  }
-  if (out_ref->ptr) {
-    // Output ref contains a value that should be released first.
-    // Note that we check above for it being the same as the new value so we
-    // don't do extra work unless we have to.
-    iree_vm_ref_release(out_ref);
-  }
-  *out_ref = temp_ref;
+  iree_vm_ref_trace("RETAIN", ref);
+  iree_vm_ref_retain_inline(ref, out_ref);
 }
 
 IREE_API_EXPORT iree_status_t iree_vm_ref_retain_checked(
@@ -188,11 +188,7 @@ IREE_API_EXPORT iree_status_t iree_vm_ref_retain_checked(
 
 IREE_API_EXPORT void iree_vm_ref_retain_or_move(int is_move, iree_vm_ref_t* ref,
                                                 iree_vm_ref_t* out_ref) {
-  if (is_move) {
-    iree_vm_ref_move(ref, out_ref);
-  } else {
-    iree_vm_ref_retain(ref, out_ref);
-  }
+  iree_vm_ref_retain_or_move_inline(is_move, ref, out_ref);
 }
 
 IREE_API_EXPORT iree_status_t iree_vm_ref_retain_or_move_checked(
@@ -207,60 +203,29 @@ IREE_API_EXPORT iree_status_t iree_vm_ref_retain_or_move_checked(
   return iree_ok_status();
 }
 
-IREE_API_EXPORT void iree_vm_ref_release(iree_vm_ref_t* ref) {
-  if (ref->type == IREE_VM_REF_TYPE_NULL || ref->ptr == NULL) return;
-
-  iree_vm_ref_trace("RELEASE", ref);
-  volatile iree_atomic_ref_count_t* counter = iree_vm_get_ref_counter_ptr(ref);
-  if (iree_atomic_ref_count_dec(counter) == 1) {
-    const iree_vm_ref_type_descriptor_t* type_descriptor =
-        iree_vm_ref_get_type_descriptor(ref->type);
-    if (type_descriptor->destroy) {
-      // NOTE: this makes us not re-entrant, but I think that's OK.
-      iree_vm_ref_trace("DESTROY", ref);
-      type_descriptor->destroy(ref->ptr);
-    }
+IREE_API_EXPORT void iree_vm_ref_destroy_object(void* ptr,
+                                                iree_vm_ref_type_t type) {
+  const iree_vm_ref_type_descriptor_t* type_descriptor =
+      iree_vm_ref_get_type_descriptor(type);
+  if (type_descriptor && type_descriptor->destroy) {
+    // NOTE: this makes us not re-entrant, but I think that's OK.
+    type_descriptor->destroy(ptr);
   }
+}
 
-  // Reset ref to point at nothing.
-  memset(ref, 0, sizeof(*ref));
+IREE_API_EXPORT void iree_vm_ref_release(iree_vm_ref_t* ref) {
+  iree_vm_ref_trace("RELEASE", ref);
+  iree_vm_ref_release_inline(ref);
 }
 
 IREE_API_EXPORT void iree_vm_ref_assign(iree_vm_ref_t* ref,
                                         iree_vm_ref_t* out_ref) {
-  // NOTE: ref and out_ref may alias.
-  iree_vm_ref_t temp_ref = *ref;
-  if (ref == out_ref) {
-    // Source == target; ignore entirely.
-    return;
-  } else if (out_ref->ptr != NULL) {
-    // Release existing value.
-    iree_vm_ref_release(out_ref);
-  }
-
-  // Assign ref to out_ref (without incrementing counter).
-  *out_ref = temp_ref;
+  iree_vm_ref_assign_inline(ref, out_ref);
 }
 
 IREE_API_EXPORT void iree_vm_ref_move(iree_vm_ref_t* ref,
                                       iree_vm_ref_t* out_ref) {
-  // NOTE: ref and out_ref may alias.
-  if (ref == out_ref) {
-    // Source == target; ignore entirely.
-    return;
-  }
-
-  // Reset input ref so it points at nothing.
-  iree_vm_ref_t temp_ref = *ref;
-  memset(ref, 0, sizeof(*ref));
-
-  if (out_ref->ptr != NULL) {
-    // Release existing value.
-    iree_vm_ref_release(out_ref);
-  }
-
-  // Assign ref to out_ref (without incrementing counter).
-  *out_ref = temp_ref;
+  iree_vm_ref_move_inline(ref, out_ref);
 }
 
 IREE_API_EXPORT bool iree_vm_ref_is_null(iree_vm_ref_t* ref) {
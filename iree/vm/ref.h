@@ -11,6 +11,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "iree/base/api.h"
 #include "iree/base/internal/atomics.h"
@@ -79,9 +80,12 @@ typedef struct iree_vm_ref_t {
   // Offset from ptr, in bytes, to the start of an atomic_int32_t representing
   // the current reference count. We store this here to avoid the need for an
   // indirection in the (extremely common) case of just reference count inc/dec.
-  uint32_t offsetof_counter : 8;
+  uint32_t offsetof_counter : 7;
   // Registered type of the object pointed to by ptr.
   iree_vm_ref_type_t type : 24;
+  // Set when the type was registered with IREE_VM_REF_TYPE_FLAG_THREAD_LOCAL
+  // and the counter can be adjusted without atomic read-modify-writes.
+  uint32_t is_thread_local : 1;
 } iree_vm_ref_t;
 static_assert(
     sizeof(iree_vm_ref_t) <= sizeof(void*) * 2,
@@ -89,6 +93,22 @@ static_assert(
 
 typedef void(IREE_API_PTR* iree_vm_ref_destroy_t)(void* ptr);
 
+// Bitfield specifying behavior of a registered ref type.
+enum iree_vm_ref_type_flag_bits_t {
+  IREE_VM_REF_TYPE_FLAG_NONE = 0u,
+
+  // Objects of this type are only ever referenced from a single thread at a
+  // time, such as objects created and consumed within one context that never
+  // escape to the hosting application. Reference counts are adjusted with
+  // plain loads and stores instead of atomic read-modify-writes.
+  //
+  // WARNING: retaining or releasing an object of this type from multiple
+  // threads concurrently will corrupt its reference count. Only set this when
+  // all owners of the objects are known, as sharing is not detected.
+  IREE_VM_REF_TYPE_FLAG_THREAD_LOCAL = 1u << 0,
+};
+typedef uint32_t iree_vm_ref_type_flags_t;
+
 // Describes a type for the VM.
 typedef struct iree_vm_ref_type_descriptor_t {
   // Function called when references of this type reach 0 and should be
@@ -102,6 +122,8 @@ typedef struct iree_vm_ref_type_descriptor_t {
   iree_vm_ref_type_t type : 24;
   // Unretained type name that can be used for debugging.
   iree_string_view_t type_name;
+  // Flags controlling how references to objects of this type are managed.
+  iree_vm_ref_type_flags_t flags;
 } iree_vm_ref_type_descriptor_t;
 
 // Directly retains the object with base |ptr| with the given |type_descriptor|.
@@ -123,7 +145,8 @@ IREE_API_EXPORT void iree_vm_ref_object_release(
 // Registers a user-defined type with the IREE C ref system.
 // The provided destroy function will be used to destroy objects when their
 // reference count goes to 0. NULL can be used to no-op the destruction if the
-// type is not owned by the VM.
+// type is not owned by the VM. The counter must be within the first 128 bytes
+// of the object.
 //
 // TODO(benvanik): keep names alive for user types?
 // NOTE: the name is not retained and must be kept live by the caller. Ideally
@@ -178,6 +201,101 @@ static inline iree_status_t iree_vm_ref_check(const iree_vm_ref_t ref,
                                     : "ref type mismatch");
 }
 
+// Destroys the object |ptr| of |type| with its registered destroy function.
+// Must only be called once the last reference to the object has been released;
+// prefer iree_vm_ref_release.
+IREE_API_EXPORT void iree_vm_ref_destroy_object(void* ptr,
+                                                iree_vm_ref_type_t type);
+
+// Returns a pointer to the reference counter of the object |ref| points at.
+static inline iree_atomic_ref_count_t* iree_vm_ref_counter_ptr(
+    const iree_vm_ref_t* ref) {
+  return (iree_atomic_ref_count_t*)(((uintptr_t)ref->ptr) +
+                                    ref->offsetof_counter);
+}
+
+// Increments the reference count of the non-NULL object |ref| points at.
+static inline void iree_vm_ref_counter_inc(const iree_vm_ref_t* ref) {
+  iree_atomic_ref_count_t* counter = iree_vm_ref_counter_ptr(ref);
+  if (ref->is_thread_local) {
+    iree_atomic_store_int32(
+        counter, iree_atomic_load_int32(counter, iree_memory_order_relaxed) + 1,
+        iree_memory_order_relaxed);
+  } else {
+    iree_atomic_ref_count_inc(counter);
+  }
+}
+
+// Decrements the reference count of the non-NULL object |ref| points at and
+// returns the value prior to decrementing.
+static inline int32_t iree_vm_ref_counter_dec(const iree_vm_ref_t* ref) {
+  iree_atomic_ref_count_t* counter = iree_vm_ref_counter_ptr(ref);
+  if (ref->is_thread_local) {
+    int32_t value = iree_atomic_load_int32(counter, iree_memory_order_relaxed);
+    iree_atomic_store_int32(counter, value - 1, iree_memory_order_relaxed);
+    return value;
+  }
+  return iree_atomic_ref_count_dec(counter);
+}
+
+// The *_inline variants below are what the exported iree_vm_ref_* functions are
+// implemented with and behave identically. Hot paths such as the bytecode
+// interpreter can use them to avoid the call overhead: a retain compiles down
+// to a single increment and a release to a decrement and a predictable branch.
+
+// Inline version of iree_vm_ref_release.
+static inline void iree_vm_ref_release_inline(iree_vm_ref_t* ref) {
+  if (ref->type == IREE_VM_REF_TYPE_NULL || ref->ptr == NULL) return;
+  if (iree_vm_ref_counter_dec(ref) == 1) {
+    iree_vm_ref_destroy_object(ref->ptr, ref->type);
+  }
+  // Reset ref to point at nothing.
+  memset(ref, 0, sizeof(*ref));
+}
+
+// Inline version of iree_vm_ref_retain.
+static inline void iree_vm_ref_retain_inline(iree_vm_ref_t* ref,
+                                             iree_vm_ref_t* out_ref) {
+  // NOTE: ref and out_ref may alias or be nested so we retain before we
+  // potentially release.
+  iree_vm_ref_t temp_ref = *ref;
+  if (temp_ref.ptr) iree_vm_ref_counter_inc(&temp_ref);
+  if (out_ref->ptr) iree_vm_ref_release_inline(out_ref);
+  *out_ref = temp_ref;
+}
+
+// Inline version of iree_vm_ref_assign.
+static inline void iree_vm_ref_assign_inline(iree_vm_ref_t* ref,
+                                             iree_vm_ref_t* out_ref) {
+  // NOTE: ref and out_ref may alias.
+  if (ref == out_ref) return;
+  iree_vm_ref_t temp_ref = *ref;
+  if (out_ref->ptr) iree_vm_ref_release_inline(out_ref);
+  *out_ref = temp_ref;
+}
+
+// Inline version of iree_vm_ref_move.
+static inline void iree_vm_ref_move_inline(iree_vm_ref_t* ref,
+                                           iree_vm_ref_t* out_ref) {
+  // NOTE: ref and out_ref may alias.
+  if (ref == out_ref) return;
+  iree_vm_ref_t temp_ref = *ref;
+  memset(ref, 0, sizeof(*ref));
+  if (out_ref->ptr) iree_vm_ref_release_inline(out_ref);
+  *out_ref = temp_ref;
+}
+
+// Inline version of iree_vm_ref_retain_or_move.
+static inline void iree_vm_ref_retain_or_move_inline(int is_move,
+                                                     iree_vm_ref_t* ref,
+                                                     iree_vm_ref_t* out_ref) {
+  if (is_move) {
+    iree_vm_ref_move_inline(ref, out_ref);
+  } else {
+    iree_vm_ref_retain_inline(ref, out_ref);
+  }
+}
+
 // Retains the reference-counted pointer |ref|.
 // |out_ref| will be released if it already contains a reference.
 IREE_API_EXPORT void iree_vm_ref_retain(iree_vm_ref_t* ref,
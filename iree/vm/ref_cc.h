@@ -278,6 +278,7 @@ class ref {
     ref_.ptr = static_cast<T*>(rhs.release());
     ref_.offsetof_counter = rhs.ref_.offsetof_counter;
     ref_.type = rhs.ref_.type;
+    ref_.is_thread_local = rhs.ref_.is_thread_local;
   }
   template <typename U>
   ref& operator=(ref<U>&& rhs) noexcept {
@@ -140,6 +140,57 @@ TEST(VMRefTest, WrappingRequriesTypeRegistration) {
   iree_status_free(status);
 }
 
+// Tests that types with counters beyond what iree_vm_ref_t can address fail to
+// register.
+TEST(VMRefTest, TypeRegistrationCounterOffsetLimit) {
+  static iree_vm_ref_type_descriptor_t descriptor = {0};
+  descriptor.type_name = iree_make_cstring_view("FarCounterType");
+  descriptor.offsetof_counter = 128;
+  iree_status_t status = iree_vm_ref_register_type(&descriptor);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT, status);
+  iree_status_free(status);
+  EXPECT_EQ(nullptr, iree_vm_ref_lookup_registered_type(
+                         iree_make_cstring_view("FarCounterType")));
+}
+
+// Tests that thread-local types count references and are destroyed like any
+// other type.
+TEST(VMRefTest, ThreadLocalType) {
+  static int destroy_count = 0;
+  static iree_vm_ref_type_descriptor_t descriptor = {0};
+  if (descriptor.type == IREE_VM_REF_TYPE_NULL) {
+    descriptor.type_name = iree_make_cstring_view("ThreadLocalType");
+    descriptor.offsetof_counter = offsetof(ref_object_c_t, ref_object.counter);
+    descriptor.destroy = +[](void* ptr) {
+      ++destroy_count;
+      delete reinterpret_cast<ref_object_c_t*>(ptr);
+    };
+    descriptor.flags = IREE_VM_REF_TYPE_FLAG_THREAD_LOCAL;
+    IREE_ASSERT_OK(iree_vm_ref_register_type(&descriptor));
+  }
+  destroy_count = 0;
+
+  iree_vm_ref_t ref = {0};
+  IREE_ASSERT_OK(
+      iree_vm_ref_wrap_assign(new ref_object_c_t(), descriptor.type, &ref));
+  EXPECT_EQ(1, ref.is_thread_local);
+
+  iree_vm_ref_t other_ref = {0};
+  iree_vm_ref_retain(&ref, &other_ref);
+  EXPECT_EQ(1, other_ref.is_thread_local);
+  EXPECT_EQ(2, ReadCounter(&ref));
+  iree_vm_ref_object_retain(ref.ptr, &descriptor);
+  EXPECT_EQ(3, ReadCounter(&ref));
+  iree_vm_ref_object_release(ref.ptr, &descriptor);
+  EXPECT_EQ(2, ReadCounter(&ref));
+
+  iree_vm_ref_release(&other_ref);
+  EXPECT_EQ(1, ReadCounter(&ref));
+  EXPECT_EQ(0, destroy_count);
+  iree_vm_ref_release(&ref);
+  EXPECT_EQ(1, destroy_count);
+}
+
 // Tests that wrapping releases any existing ref in out_ref.
 TEST(VMRefTest, WrappingReleasesExisting) {
   RegisterTypeC();
@@ -6,6 +6,10 @@
 
 #include "iree/vm/shims.h"
 
+IREE_VM_ABI_DEFINE_SHIM(i, r);
+IREE_VM_ABI_DEFINE_SHIM(i, ri);
+IREE_VM_ABI_DEFINE_SHIM(i, v);
+IREE_VM_ABI_DEFINE_SHIM(iriiiii, v);
 IREE_VM_ABI_DEFINE_SHIM(irii, v);
 IREE_VM_ABI_DEFINE_SHIM(r, i);
 IREE_VM_ABI_DEFINE_SHIM(r, ii);
@@ -31,6 +35,9 @@ IREE_VM_ABI_DEFINE_SHIM(riii, r);
 IREE_VM_ABI_DEFINE_SHIM(riii, v);
 IREE_VM_ABI_DEFINE_SHIM(riirii, r);
 IREE_VM_ABI_DEFINE_SHIM(riiirii, r);
+IREE_VM_ABI_DEFINE_SHIM(riiriiriiiii, v);
+IREE_VM_ABI_DEFINE_SHIM(riiiriiiii, v);
+IREE_VM_ABI_DEFINE_SHIM(riiiriiiriiiii, v);
 IREE_VM_ABI_DEFINE_SHIM(rrrCrD, r);
 IREE_VM_ABI_DEFINE_SHIM(ririi, v);
 IREE_VM_ABI_DEFINE_SHIM(rr, i);
@@ -39,6 +46,9 @@ IREE_VM_ABI_DEFINE_SHIM(rr, v);
 IREE_VM_ABI_DEFINE_SHIM(rr, ii);
 IREE_VM_ABI_DEFINE_SHIM(rrr, ii);
 IREE_VM_ABI_DEFINE_SHIM(rrCiriiD, r);
+IREE_VM_ABI_DEFINE_SHIM(rrCrD, v);
+IREE_VM_ABI_DEFINE_SHIM(rri, i);
+IREE_VM_ABI_DEFINE_SHIM(rri, v);
 IREE_VM_ABI_DEFINE_SHIM(rriCiD, v);
 IREE_VM_ABI_DEFINE_SHIM(rriiCiD, v);
 IREE_VM_ABI_DEFINE_SHIM(rriCiriiD, v);
@@ -184,6 +184,16 @@ IREE_VM_ABI_FIXED_STRUCT(iiii, {
   int32_t i3;
 });
 
+IREE_VM_ABI_FIXED_STRUCT(iriiiii, {
+  int32_t i0;
+  iree_vm_ref_t r1;
+  int32_t i2;
+  int32_t i3;
+  int32_t i4;
+  int32_t i5;
+  int32_t i6;
+});
+
 IREE_VM_ABI_FIXED_STRUCT(irii, {
   int32_t i0;
   iree_vm_ref_t r1;
@@ -255,6 +265,57 @@ IREE_VM_ABI_FIXED_STRUCT(riiirii, {
   int32_t i6;
 });
 
+IREE_VM_ABI_FIXED_STRUCT(riiriiriiiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  iree_vm_ref_t r3;
+  int32_t i4;
+  int32_t i5;
+  iree_vm_ref_t r6;
+  int32_t i7;
+  int32_t i8;
+  int32_t i9;
+  int32_t i10;
+  int32_t i11;
+});
+
+IREE_VM_ABI_FIXED_STRUCT(riiiriiiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  int32_t i3;
+  iree_vm_ref_t r4;
+  int32_t i5;
+  int32_t i6;
+  int32_t i7;
+  int32_t i8;
+  int32_t i9;
+});
+
+IREE_VM_ABI_FIXED_STRUCT(riiiriiiriiiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  int32_t i3;
+  iree_vm_ref_t r4;
+  int32_t i5;
+  int32_t i6;
+  int32_t i7;
+  iree_vm_ref_t r8;
+  int32_t i9;
+  int32_t i10;
+  int32_t i11;
+  int32_t i12;
+  int32_t i13;
+});
+
+IREE_VM_ABI_FIXED_STRUCT(rri, {
+  iree_vm_ref_t r0;
+  iree_vm_ref_t r1;
+  int32_t i2;
+});
+
 IREE_VM_ABI_FIXED_STRUCT(rriiii, {
   iree_vm_ref_t r0;
   iree_vm_ref_t r1;
@@ -349,6 +410,13 @@ IREE_VM_ABI_VLA_STRUCT(rirCrD, a3_count, a3, {
   iree_vm_abi_r_t a3[0];
 });
 
+IREE_VM_ABI_VLA_STRUCT(rrCrD, a2_count, a2, {
+  iree_vm_ref_t r0;
+  iree_vm_ref_t r1;
+  iree_vm_size_t a2_count;
+  iree_vm_abi_r_t a2[0];
+});
+
 IREE_VM_ABI_VLA_STRUCT(rrrCrD, a3_count, a3, {
   iree_vm_ref_t r0;
   iree_vm_ref_t r1;
@@ -404,6 +472,10 @@ IREE_VM_ABI_VLA_STRUCT(rriCiriiD, a3_count, a3, {
 // Shims for marshaling arguments and results
 //===----------------------------------------------------------------------===//
 
+IREE_VM_ABI_DECLARE_SHIM(i, r);
+IREE_VM_ABI_DECLARE_SHIM(i, ri);
+IREE_VM_ABI_DECLARE_SHIM(i, v);
+IREE_VM_ABI_DECLARE_SHIM(iriiiii, v);
 IREE_VM_ABI_DECLARE_SHIM(irii, v);
 IREE_VM_ABI_DECLARE_SHIM(r, i);
 IREE_VM_ABI_DECLARE_SHIM(r, ii);
@@ -429,6 +501,9 @@ IREE_VM_ABI_DECLARE_SHIM(riii, r);
 IREE_VM_ABI_DECLARE_SHIM(riii, v);
 IREE_VM_ABI_DECLARE_SHIM(riirii, r);
 IREE_VM_ABI_DECLARE_SHIM(riiirii, r);
+IREE_VM_ABI_DECLARE_SHIM(riiriiriiiii, v);
+IREE_VM_ABI_DECLARE_SHIM(riiiriiiii, v);
+IREE_VM_ABI_DECLARE_SHIM(riiiriiiriiiii, v);
 IREE_VM_ABI_DECLARE_SHIM(rrrCrD, r);
 IREE_VM_ABI_DECLARE_SHIM(ririi, v);
 IREE_VM_ABI_DECLARE_SHIM(rr, i);
@@ -437,6 +512,9 @@ IREE_VM_ABI_DECLARE_SHIM(rr, v);
 IREE_VM_ABI_DECLARE_SHIM(rr, ii);
 IREE_VM_ABI_DECLARE_SHIM(rrr, ii);
 IREE_VM_ABI_DECLARE_SHIM(rrCiriiD, r);
+IREE_VM_ABI_DECLARE_SHIM(rrCrD, v);
+IREE_VM_ABI_DECLARE_SHIM(rri, i);
+IREE_VM_ABI_DECLARE_SHIM(rri, v);
 IREE_VM_ABI_DECLARE_SHIM(rriCiD, v);
 IREE_VM_ABI_DECLARE_SHIM(rriiCiD, v);
 IREE_VM_ABI_DECLARE_SHIM(rriCiriiD, v);
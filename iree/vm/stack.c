@@ -9,10 +9,12 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "iree/base/alignment.h"
 #include "iree/base/api.h"
+#include "iree/base/internal/atomic_slist.h"
 #include "iree/base/tracing.h"
 #include "iree/vm/module.h"
 
@@ -48,9 +50,9 @@
 // us (practically) unlimited stack depth.
 //
 // [iree_vm_stack_t]
-//   +- top -------> [frame 3 header] [registers] ---+
+//   +- top -------> [frame 3 header] [registers] ---+         (segment 1)
 //                                                   |
-//              +--- [frame 2 header] [registers] <--+
+//              +--- [frame 2 header] [registers] <--+         (segment 0)
 //              |
 //              +--> [frame 1 header] [registers] ---+
 //                                                   |
@@ -71,13 +73,16 @@
 // expand the required register count for a function from 30 to 3000.
 //
 // To support these cases the stack can optionally be provided an allocator to
-// enable it to grow the stack when the initial storage is exhausted. As we
-// store pointers to the stack storage within the storage itself (such as the
-// iree_vm_registers_t pointers) this means we need to perform a fixup step
-// during reallocation to ensure they are all updated. This also means that the
-// pointers to the stack frames are possibly invalidated on every function
-// entry and that users of the stack cannot rely on pointer stability during
-// execution.
+// enable it to grow the stack when the initial storage is exhausted. Growth
+// chains a new segment of frame storage after the current one instead of
+// reallocating so that existing frames never move and no copies or pointer
+// fixups are required. Frames never span segments: a frame that does not fit
+// in the remaining space of the current segment begins the next one.
+//
+// Segments are retained when the frames within them are left and reused the
+// next time the stack grows that deep. Combined with iree_vm_stack_pool_t,
+// which recycles entire stacks across invocations, steady-state invocations do
+// not allocate regardless of how deep they go.
 //
 // Calling convention
 // ------------------
@@ -115,12 +120,27 @@
 // code paths which are likely still in instruction cache the bulk of the work
 // amounts to some small memcpys.
 
-// Multiplier on the capacity of the stack frame storage when growing.
-// Since we never shrink stacks it's nice to keep this relative low. If we
+// Multiplier on the capacity of each new stack segment relative to the prior
+// one. Since we never shrink stacks it's nice to keep this relative low. If we
 // measure a lot of growth happening in normal models we should increase this
 // but otherwise leave as small as we can to avoid overallocation.
 #define IREE_VM_STACK_GROWTH_FACTOR 2
 
+// A contiguous block of frame storage. The first segment is the storage the
+// stack was initialized with and additional segments are heap allocated on
+// demand and linked after it.
+typedef struct iree_vm_stack_segment_t {
+  // Previous segment in the chain or NULL for the initial segment.
+  struct iree_vm_stack_segment_t* prev;
+  // Next segment in the chain, retained for reuse even when unused.
+  struct iree_vm_stack_segment_t* next;
+  // Bytes used in |prev| when the stack moved on to this segment.
+  iree_host_size_t prev_storage_size;
+  // Total capacity of |storage| in bytes.
+  iree_host_size_t capacity;
+  uint8_t* storage;
+} iree_vm_stack_segment_t;
+
 // A private stack frame header that allows us to walk the linked list of
 // frames without exposing their exact structure through the API. This makes it
 // easier for us to add/version additional information or hide implementation
@@ -128,8 +148,8 @@
 typedef struct iree_vm_stack_frame_header_t {
   // Size, in bytes, of the frame header and frame payload including registers.
   // Adding this value to the base header pointer will yield the next available
-  // memory location. Ensure that it does not exceed the total
-  // frame_storage_capacity.
+  // memory location. Ensure that it does not exceed the capacity of the
+  // segment containing the frame.
   iree_host_size_t frame_size;
 
   // Pointer to the parent stack frame, usually immediately preceding this one
@@ -152,44 +172,66 @@ typedef struct iree_vm_stack_frame_header_t {
 } iree_vm_stack_frame_header_t;
 
 // Core stack storage. This will be mapped either into dynamic memory allocated
-// by the member allocator or static memory allocated externally. Static stacks
-// cannot grow when storage runs out while dynamic ones will resize their stack.
+// by the member allocator or static memory allocated externally. Stacks without
+// an allocator cannot grow when storage runs out while others will chain
+// additional segments.
 struct iree_vm_stack_t {
   // NOTE: to get better cache hit rates we put the most frequently accessed
   // members first.
 
   // Pointer to the current top of the stack.
   // This can be used to walk the stack from top to bottom by following the
-  // |parent| pointers. Note that these pointers are invalidated each time the
-  // stack grows (if dynamic growth is enabled) and all of the frames will need
-  // updating.
+  // |parent| pointers. Frames never move once entered.
   iree_vm_stack_frame_header_t* top;
 
-  // Base pointer to stack storage.
-  // For statically-allocated stacks this will (likely) point to immediately
-  // after the iree_vm_stack_t in memory. For dynamically-allocated stacks this
-  // will (likely) point to heap memory.
-  iree_host_size_t frame_storage_capacity;
+  // Segment containing the top of the stack and the bytes used within it.
+  iree_vm_stack_segment_t* segment;
   iree_host_size_t frame_storage_size;
-  void* frame_storage;
 
   // Flags controlling the behavior of the invocation owning this stack.
   iree_vm_invocation_flags_t flags;
 
-  // True if the stack owns the frame_storage and should free it when it is no
-  // longer required. Host stack-allocated stacks don't own their storage but
-  // may transition to owning it on dynamic growth.
-  bool owns_frame_storage;
+  // Total capacity of all segments in the chain, in bytes.
+  iree_host_size_t total_capacity;
 
   // Resolves a module to a module state within a context.
   // This will be called on function entry whenever module transitions occur.
   iree_vm_state_resolver_t state_resolver;
 
+  // Most recently resolved module and its state. Module states do not change
+  // for the lifetime of the context backing |state_resolver| so this avoids
+  // requerying when calls alternate between two modules (such as bytecode
+  // calling into imports).
+  iree_vm_module_t* resolved_module;
+  iree_vm_module_state_t* resolved_module_state;
+
   // Allocator used for dynamic stack allocations. May be the null allocator
   // if growth is prohibited.
   iree_allocator_t allocator;
+
+  // Used by iree_vm_stack_pool_t to track stacks available for reuse.
+  iree_atomic_slist_intrusive_ptr_t pool_next;
+
+  // Initial segment referencing the storage the stack was initialized with.
+  // For statically-allocated stacks this will (likely) point to immediately
+  // after the iree_vm_stack_t in memory.
+  iree_vm_stack_segment_t base_segment;
 };
 
+IREE_TYPED_ATOMIC_SLIST_WRAPPER(iree_vm_stack, iree_vm_stack_t,
+                                offsetof(iree_vm_stack_t, pool_next));
+
+// Frees |segment| and all segments following it in the chain.
+static void iree_vm_stack_free_segments(iree_vm_stack_t* stack,
+                                        iree_vm_stack_segment_t* segment) {
+  while (segment) {
+    iree_vm_stack_segment_t* next = segment->next;
+    stack->total_capacity -= segment->capacity;
+    iree_allocator_free(stack->allocator, segment);
+    segment = next;
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // Stack implementation
 //===----------------------------------------------------------------------===//
@@ -211,16 +253,17 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_initialize(
 
   iree_vm_stack_t* stack = (iree_vm_stack_t*)storage.data;
   memset(stack, 0, sizeof(iree_vm_stack_t));
-  stack->owns_frame_storage = false;
   stack->flags = flags;
   stack->state_resolver = state_resolver;
   stack->allocator = allocator;
 
   iree_host_size_t storage_offset =
       iree_host_align(sizeof(iree_vm_stack_t), 16);
-  stack->frame_storage_capacity = storage.data_length - storage_offset;
+  stack->base_segment.capacity = storage.data_length - storage_offset;
+  stack->base_segment.storage = storage.data + storage_offset;
+  stack->segment = &stack->base_segment;
   stack->frame_storage_size = 0;
-  stack->frame_storage = storage.data + storage_offset;
+  stack->total_capacity = stack->base_segment.capacity;
 
   stack->top = NULL;
 
@@ -237,9 +280,8 @@ IREE_API_EXPORT void iree_vm_stack_deinitialize(iree_vm_stack_t* stack) {
     iree_status_ignore(iree_vm_stack_function_leave(stack));
   }
 
-  if (stack->owns_frame_storage) {
-    iree_allocator_free(stack->allocator, stack->frame_storage);
-  }
+  iree_vm_stack_free_segments(stack, stack->base_segment.next);
+  stack->base_segment.next = NULL;
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -278,6 +320,78 @@ IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+//===----------------------------------------------------------------------===//
+// Stack pool
+//===----------------------------------------------------------------------===//
+
+struct iree_vm_stack_pool_t {
+  iree_allocator_t allocator;
+  iree_vm_state_resolver_t state_resolver;
+
+  // Stacks with no frames available for reuse. Each retains the segments it
+  // grew during prior invocations.
+  iree_vm_stack_slist_t available_stacks;
+};
+
+IREE_API_EXPORT iree_status_t iree_vm_stack_pool_create(
+    iree_vm_state_resolver_t state_resolver, iree_allocator_t allocator,
+    iree_vm_stack_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(out_pool);
+  *out_pool = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_stack_pool_t* pool = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, sizeof(*pool), (void**)&pool));
+  pool->allocator = allocator;
+  pool->state_resolver = state_resolver;
+  iree_vm_stack_slist_initialize(&pool->available_stacks);
+
+  *out_pool = pool;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT void iree_vm_stack_pool_free(iree_vm_stack_pool_t* pool) {
+  if (!pool) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_stack_t* stack = NULL;
+  while ((stack = iree_vm_stack_slist_pop(&pool->available_stacks)) != NULL) {
+    iree_vm_stack_free(stack);
+  }
+  iree_vm_stack_slist_deinitialize(&pool->available_stacks);
+  iree_allocator_free(pool->allocator, pool);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_stack_pool_acquire(
+    iree_vm_stack_pool_t* pool, iree_vm_invocation_flags_t flags,
+    iree_vm_stack_t** out_stack) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_ASSERT_ARGUMENT(out_stack);
+  iree_vm_stack_t* stack = iree_vm_stack_slist_pop(&pool->available_stacks);
+  if (IREE_LIKELY(stack)) {
+    stack->flags = flags;
+    *out_stack = stack;
+    return iree_ok_status();
+  }
+  return iree_vm_stack_allocate(flags, pool->state_resolver, pool->allocator,
+                                out_stack);
+}
+
+IREE_API_EXPORT void iree_vm_stack_pool_release(iree_vm_stack_pool_t* pool,
+                                                iree_vm_stack_t* stack) {
+  IREE_ASSERT_ARGUMENT(pool);
+  if (!stack) return;
+  // Unwind any frames left behind by a failed invocation.
+  while (stack->top) {
+    iree_status_ignore(iree_vm_stack_function_leave(stack));
+  }
+  iree_vm_stack_slist_push(&pool->available_stacks, stack);
+}
+
 IREE_API_EXPORT iree_vm_invocation_flags_t
 iree_vm_stack_invocation_flags(const iree_vm_stack_t* stack) {
   return stack->flags;
@@ -295,83 +409,84 @@ IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_parent_frame(
   return parent_header ? &parent_header->frame : NULL;
 }
 
+// Resolves the state of |module| through the stack state resolver, reusing the
+// result of the last query when possible.
+static inline iree_status_t iree_vm_stack_resolve_module_state(
+    iree_vm_stack_t* stack, iree_vm_module_t* module,
+    iree_vm_module_state_t** out_module_state) {
+  if (IREE_LIKELY(module && stack->resolved_module == module)) {
+    *out_module_state = stack->resolved_module_state;
+    return iree_ok_status();
+  }
+  IREE_RETURN_IF_ERROR(stack->state_resolver.query_module_state(
+      stack->state_resolver.self, module, out_module_state));
+  stack->resolved_module = module;
+  stack->resolved_module_state = *out_module_state;
+  return iree_ok_status();
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_stack_query_module_state(
     iree_vm_stack_t* stack, iree_vm_module_t* module,
     iree_vm_module_state_t** out_module_state) {
-  return stack->state_resolver.query_module_state(stack->state_resolver.self,
-                                                  module, out_module_state);
+  return iree_vm_stack_resolve_module_state(stack, module, out_module_state);
 }
 
-// Attempts to grow the stack store to hold at least |minimum_capacity|.
-// Pointers to existing stack frames will be invalidated and any pointers
-// embedded in the stack frame data structures will be updated.
+// Moves the top of the stack to the next segment, ensuring it can hold at
+// least |minimum_capacity| bytes. A segment retained from prior growth is
+// reused if large enough and otherwise a new one is allocated.
+// Existing frames are not moved and pointers to them remain valid.
 // Fails if dynamic stack growth is disabled or the allocator is OOM.
-static iree_status_t iree_vm_stack_grow(iree_vm_stack_t* stack,
-                                        iree_host_size_t minimum_capacity) {
-  if (IREE_UNLIKELY(stack->allocator.ctl == NULL)) {
-    return iree_make_status(
-        IREE_STATUS_RESOURCE_EXHAUSTED,
-        "stack initialized on the host stack and cannot grow");
+static iree_status_t iree_vm_stack_push_segment(
+    iree_vm_stack_t* stack, iree_host_size_t minimum_capacity) {
+  iree_vm_stack_segment_t* segment = stack->segment;
+  iree_vm_stack_segment_t* next_segment = segment->next;
+  if (next_segment && next_segment->capacity < minimum_capacity) {
+    // The retained segments were sized for a different call tree; drop them
+    // so that a large enough one can take their place.
+    iree_vm_stack_free_segments(stack, next_segment);
+    segment->next = next_segment = NULL;
   }
 
-  // Ensure we grow at least as much as required.
-  iree_host_size_t new_capacity = stack->frame_storage_capacity;
-  do {
-    new_capacity *= IREE_VM_STACK_GROWTH_FACTOR;
-  } while (new_capacity < minimum_capacity);
-  if (new_capacity > IREE_VM_STACK_MAX_SIZE) {
-    return iree_make_status(
-        IREE_STATUS_RESOURCE_EXHAUSTED,
-        "new stack size would exceed maximum size: %zu > %d", new_capacity,
-        IREE_VM_STACK_MAX_SIZE);
-  }
+  if (!next_segment) {
+    if (IREE_UNLIKELY(stack->allocator.ctl == NULL)) {
+      return iree_make_status(
+          IREE_STATUS_RESOURCE_EXHAUSTED,
+          "stack initialized on the host stack and cannot grow");
+    }
 
-  IREE_TRACE_ZONE_BEGIN(z0);
+    // Ensure we grow at least as much as required.
+    iree_host_size_t new_capacity =
+        iree_max(segment->capacity * IREE_VM_STACK_GROWTH_FACTOR,
+                 minimum_capacity);
+    if (stack->total_capacity + new_capacity > IREE_VM_STACK_MAX_SIZE) {
+      return iree_make_status(
+          IREE_STATUS_RESOURCE_EXHAUSTED,
+          "new stack size would exceed maximum size: %zu > %d",
+          stack->total_capacity + new_capacity, IREE_VM_STACK_MAX_SIZE);
+    }
 
-  // Reallocate the frame storage. 99.9999% chance the new storage pointer will
-  // differ and we'll need to fix up pointers so we just always do that.
-  void* old_storage = stack->frame_storage;
-  void* new_storage = stack->frame_storage;
-  iree_status_t status;
-  if (stack->owns_frame_storage) {
-    // We own the storage already likely from a previous growth operation.
-    status =
-        iree_allocator_realloc(stack->allocator, new_capacity, &new_storage);
-  } else {
-    // We don't own the original storage so we are going to switch to our own
-    // newly-allocated storage instead. We need to make sure we copy over the
-    // existing stack contents.
-    status =
-        iree_allocator_malloc(stack->allocator, new_capacity, &new_storage);
-    if (iree_status_is_ok(status)) {
-      memcpy(new_storage, old_storage, stack->frame_storage_capacity);
+    IREE_TRACE_ZONE_BEGIN(z0);
+    IREE_TRACE_ZONE_APPEND_VALUE(z0, new_capacity);
+    const iree_host_size_t header_size = iree_sizeof_struct(*next_segment);
+    iree_status_t status =
+        iree_allocator_malloc(stack->allocator, header_size + new_capacity,
+                              (void**)&next_segment);
+    if (!iree_status_is_ok(status)) {
+      IREE_TRACE_ZONE_END(z0);
+      return status;
     }
-  }
-  if (!iree_status_is_ok(status)) {
+    next_segment->prev = segment;
+    next_segment->next = NULL;
+    next_segment->capacity = new_capacity;
+    next_segment->storage = (uint8_t*)next_segment + header_size;
+    segment->next = next_segment;
+    stack->total_capacity += new_capacity;
     IREE_TRACE_ZONE_END(z0);
-    return status;
-  }
-  stack->frame_storage = new_storage;
-  stack->frame_storage_capacity = new_capacity;
-  stack->owns_frame_storage = true;
-
-#define REBASE_POINTER(type, ptr, old_base, new_base)           \
-  if (ptr) {                                                    \
-    (ptr) = (type)(((uintptr_t)(ptr) - (uintptr_t)(old_base)) + \
-                   (uintptr_t)(new_base));                      \
-  }
-
-  // Fixup embedded stack frame pointers.
-  REBASE_POINTER(iree_vm_stack_frame_header_t*, stack->top, old_storage,
-                 new_storage);
-  iree_vm_stack_frame_header_t* frame_header = stack->top;
-  while (frame_header != NULL) {
-    REBASE_POINTER(iree_vm_stack_frame_header_t*, frame_header->parent,
-                   old_storage, new_storage);
-    frame_header = frame_header->parent;
   }
 
-  IREE_TRACE_ZONE_END(z0);
+  next_segment->prev_storage_size = stack->frame_storage_size;
+  stack->segment = next_segment;
+  stack->frame_storage_size = 0;
   return iree_ok_status();
 }
 
@@ -382,14 +497,6 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_function_enter(
     iree_vm_stack_frame_t** out_callee_frame) {
   if (out_callee_frame) *out_callee_frame = NULL;
 
-  // Allocate stack space and grow stack, if required.
-  iree_host_size_t header_size = sizeof(iree_vm_stack_frame_header_t);
-  iree_host_size_t new_top =
-      stack->frame_storage_size + header_size + frame_size;
-  if (IREE_UNLIKELY(new_top > stack->frame_storage_capacity)) {
-    IREE_RETURN_IF_ERROR(iree_vm_stack_grow(stack, new_top));
-  }
-
   // Try to reuse the same module state if the caller and callee are from the
   // same module. Otherwise, query the state from the registered handler.
   iree_vm_stack_frame_header_t* caller_frame_header = stack->top;
@@ -399,13 +506,22 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_function_enter(
   if (caller_frame && caller_frame->function.module == function->module) {
     module_state = caller_frame->module_state;
   } else if (function->module != NULL) {
-    IREE_RETURN_IF_ERROR(stack->state_resolver.query_module_state(
-        stack->state_resolver.self, function->module, &module_state));
+    IREE_RETURN_IF_ERROR(iree_vm_stack_resolve_module_state(
+        stack, function->module, &module_state));
+  }
+
+  // Allocate stack space and grow stack, if required. This happens after the
+  // state query so that a failure leaves the stack unchanged.
+  iree_host_size_t header_size = sizeof(iree_vm_stack_frame_header_t);
+  iree_host_size_t total_frame_size = header_size + frame_size;
+  if (IREE_UNLIKELY(stack->frame_storage_size + total_frame_size >
+                    stack->segment->capacity)) {
+    IREE_RETURN_IF_ERROR(iree_vm_stack_push_segment(stack, total_frame_size));
   }
 
   // Bump pointer and get real stack pointer offsets.
   iree_vm_stack_frame_header_t* frame_header =
-      (iree_vm_stack_frame_header_t*)((uintptr_t)stack->frame_storage +
+      (iree_vm_stack_frame_header_t*)(stack->segment->storage +
                                       stack->frame_storage_size);
   memset(frame_header, 0, header_size + frame_size);
 
@@ -421,7 +537,7 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_function_enter(
   callee_frame->module_state = module_state;
   callee_frame->pc = 0;
 
-  stack->frame_storage_size = new_top;
+  stack->frame_storage_size += total_frame_size;
   stack->top = frame_header;
 
   IREE_TRACE({
@@ -463,6 +579,13 @@ iree_vm_stack_function_leave(iree_vm_stack_t* stack) {
   stack->frame_storage_size -= stack->top->frame_size;
   stack->top = stack->top->parent;
 
+  // Return to the previous segment once the last frame in this one is left.
+  // The segment stays linked so that the next growth can reuse it.
+  if (stack->frame_storage_size == 0 && stack->segment->prev) {
+    stack->frame_storage_size = stack->segment->prev_storage_size;
+    stack->segment = stack->segment->prev;
+  }
+
   return iree_ok_status();
 }
 
@@ -38,8 +38,11 @@ extern "C" {
 // The minimum size of VM stack storage.
 #define IREE_VM_STACK_MIN_SIZE (1 * 1024)
 
-// The maximum size of VM stack storage; anything larger is probably a bug.
+// The maximum total size of VM stack storage across all segments; anything
+// larger is probably a bug (such as unbounded recursion).
+#if !defined(IREE_VM_STACK_MAX_SIZE)
 #define IREE_VM_STACK_MAX_SIZE (1 * 1024 * 1024)
+#endif  // !IREE_VM_STACK_MAX_SIZE
 
 enum iree_vm_invocation_flag_bits_t {
   IREE_VM_INVOCATION_FLAG_NONE = 0u,
@@ -49,6 +52,11 @@ enum iree_vm_invocation_flag_bits_t {
   // functionality is available; specifically:
   //   -DIREE_VM_EXECUTION_TRACING_ENABLE=1
   IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION = 1u << 0,
+
+  // Enables collection of per-function execution profiles (when available) for
+  // the invocation. See iree_vm_context_enumerate_function_profiles.
+  //   -DIREE_VM_EXECUTION_PROFILING_ENABLE=1
+  IREE_VM_INVOCATION_FLAG_PROFILE_EXECUTION = 1u << 1,
 };
 typedef uint32_t iree_vm_invocation_flags_t;
 
@@ -188,6 +196,32 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_allocate(
 // Frees a dynamically-allocated |stack| from iree_vm_stack_allocate.
 IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack);
 
+// A thread-safe pool of dynamically-allocated stacks reused across invocations.
+// Stacks returned to the pool keep any storage they grew so that steady-state
+// invocations acquire a stack already large enough without allocating.
+typedef struct iree_vm_stack_pool_t iree_vm_stack_pool_t;
+
+// Creates a pool of stacks resolving module state with |state_resolver|.
+// Stacks and the pool itself are allocated from |allocator|.
+IREE_API_EXPORT iree_status_t iree_vm_stack_pool_create(
+    iree_vm_state_resolver_t state_resolver, iree_allocator_t allocator,
+    iree_vm_stack_pool_t** out_pool);
+
+// Frees |pool| and all stacks in it. All acquired stacks must have been
+// released back to the pool.
+IREE_API_EXPORT void iree_vm_stack_pool_free(iree_vm_stack_pool_t* pool);
+
+// Acquires an empty stack for an invocation with |flags|, allocating a new one
+// only if no stack is available in |pool|.
+// The stack must be returned with iree_vm_stack_pool_release.
+IREE_API_EXPORT iree_status_t iree_vm_stack_pool_acquire(
+    iree_vm_stack_pool_t* pool, iree_vm_invocation_flags_t flags,
+    iree_vm_stack_t** out_stack);
+
+// Returns |stack| to |pool| for reuse. Remaining frames are left.
+IREE_API_EXPORT void iree_vm_stack_pool_release(iree_vm_stack_pool_t* pool,
+                                                iree_vm_stack_t* stack);
+
 // Returns the flags controlling the invocation this stack is used with.
 IREE_API_EXPORT iree_vm_invocation_flags_t
 iree_vm_stack_invocation_flags(const iree_vm_stack_t* stack);
@@ -206,8 +240,8 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_query_module_state(
     iree_vm_module_state_t** out_module_state);
 
 // Enters into the given |function| and returns the callee stack frame.
-// May invalidate any pointers to stack frames and the only pointer that can be
-// assumed valid after return is the one in |out_callee_frame|.
+// Pointers to existing stack frames remain valid; growth chains additional
+// storage instead of moving frames.
 //
 // |frame_size| can optionally be used to allocate storage within the stack for
 // callee data. |frame_cleanup_fn| will be called when the frame is left either
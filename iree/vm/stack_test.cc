@@ -6,6 +6,9 @@
 
 #include "iree/vm/stack.h"
 
+#include <cstdint>
+#include <cstring>
+
 #include "iree/base/api.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
@@ -120,6 +123,106 @@ TEST(VMStackTest, StackOverflow) {
   iree_vm_stack_deinitialize(stack);
 }
 
+// Tests that growing the stack keeps existing frames in place and that the
+// grown storage is reused after unwinding.
+TEST(VMStackTest, GrowthPreservesFrames) {
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  iree_vm_stack_t* stack = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_allocate(IREE_VM_INVOCATION_FLAG_NONE,
+                                        state_resolver, iree_allocator_system(),
+                                        &stack));
+
+  // Enough frames to spill the initial storage a few times over.
+  static const int kFrameCount = 32;
+  static const iree_host_size_t kFrameSize = 1024;
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  iree_vm_stack_frame_t* frames[kFrameCount] = {nullptr};
+  for (int i = 0; i < kFrameCount; ++i) {
+    IREE_ASSERT_OK(iree_vm_stack_function_enter(
+        stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, kFrameSize, NULL,
+        &frames[i]));
+    memset(iree_vm_stack_frame_storage(frames[i]), i, kFrameSize);
+  }
+  for (int i = 0; i < kFrameCount; ++i) {
+    EXPECT_EQ(i, frames[i]->depth);
+    uint8_t* storage = (uint8_t*)iree_vm_stack_frame_storage(frames[i]);
+    EXPECT_EQ(i, storage[0]);
+    EXPECT_EQ(i, storage[kFrameSize - 1]);
+  }
+  EXPECT_EQ(frames[kFrameCount - 1], iree_vm_stack_current_frame(stack));
+  EXPECT_EQ(frames[kFrameCount - 2], iree_vm_stack_parent_frame(stack));
+
+  // Unwinding and reentering lands in the same (retained) storage.
+  for (int i = 0; i < kFrameCount; ++i) {
+    IREE_ASSERT_OK(iree_vm_stack_function_leave(stack));
+  }
+  EXPECT_EQ(nullptr, iree_vm_stack_current_frame(stack));
+  for (int i = 0; i < kFrameCount; ++i) {
+    iree_vm_stack_frame_t* frame = nullptr;
+    IREE_ASSERT_OK(iree_vm_stack_function_enter(
+        stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, kFrameSize, NULL,
+        &frame));
+    EXPECT_EQ(frames[i], frame);
+  }
+
+  iree_vm_stack_free(stack);
+}
+
+// Tests that pooled stacks are reused along with their grown storage.
+TEST(VMStackTest, PoolReuse) {
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  iree_vm_stack_pool_t* pool = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_pool_create(state_resolver,
+                                           iree_allocator_system(), &pool));
+
+  iree_vm_stack_t* stack_a = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_pool_acquire(pool, IREE_VM_INVOCATION_FLAG_NONE,
+                                            &stack_a));
+  iree_vm_stack_t* stack_b = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_pool_acquire(pool, IREE_VM_INVOCATION_FLAG_NONE,
+                                            &stack_b));
+  EXPECT_NE(stack_a, stack_b);
+
+  // Grow stack_a and release it with frames remaining.
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  iree_vm_stack_frame_t* frame = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_function_enter(
+      stack_a, &function_a, IREE_VM_STACK_FRAME_NATIVE, 4096, NULL, &frame));
+  IREE_ASSERT_OK(iree_vm_stack_function_enter(
+      stack_a, &function_a, IREE_VM_STACK_FRAME_NATIVE, 16 * 1024, NULL,
+      &frame));
+  iree_vm_stack_frame_t* grown_frame = frame;
+  iree_vm_stack_pool_release(pool, stack_a);
+  iree_vm_stack_pool_release(pool, stack_b);
+
+  // Most recently released first; flags are reset on each acquire.
+  iree_vm_stack_t* reused_b = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_pool_acquire(
+      pool, IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION, &reused_b));
+  EXPECT_EQ(stack_b, reused_b);
+  EXPECT_EQ(IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION,
+            iree_vm_stack_invocation_flags(reused_b));
+  iree_vm_stack_t* stack = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_pool_acquire(pool, IREE_VM_INVOCATION_FLAG_NONE,
+                                            &stack));
+  EXPECT_EQ(stack_a, stack);
+  iree_vm_stack_pool_release(pool, reused_b);
+
+  // The grown storage of stack_a is reused without moving.
+  EXPECT_EQ(nullptr, iree_vm_stack_current_frame(stack));
+  IREE_ASSERT_OK(iree_vm_stack_function_enter(
+      stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, 4096, NULL, &frame));
+  IREE_ASSERT_OK(iree_vm_stack_function_enter(
+      stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, 16 * 1024, NULL,
+      &frame));
+  EXPECT_EQ(grown_frame, frame);
+  iree_vm_stack_pool_release(pool, stack);
+
+  iree_vm_stack_pool_free(pool);
+}
+
 // Tests unbalanced stack popping.
 TEST(VMStackTest, UnbalancedPop) {
   iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
@@ -176,6 +279,47 @@ TEST(VMStackTest, ModuleStateQueries) {
   iree_vm_stack_deinitialize(stack);
 }
 
+// Tests that the most recently queried module state is reused when calls
+// alternate between modules.
+TEST(VMStackTest, ModuleStateQueryCache) {
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  IREE_VM_INLINE_STACK_INITIALIZE(stack, IREE_VM_INVOCATION_FLAG_NONE,
+                                  state_resolver, iree_allocator_system());
+
+  module_a_state_resolve_count = 0;
+  module_b_state_resolve_count = 0;
+
+  // [A (queried)]
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  iree_vm_stack_frame_t* frame_a = nullptr;
+  IREE_EXPECT_OK(iree_vm_stack_function_enter(
+      stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, 0, NULL, &frame_a));
+  EXPECT_EQ(1, module_a_state_resolve_count);
+
+  // [A, B (queried)] -> [A] -> [A, B (cached)] -> [A].
+  iree_vm_function_t function_b = {MODULE_B_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 1};
+  for (int i = 0; i < 2; ++i) {
+    iree_vm_stack_frame_t* frame_b = nullptr;
+    IREE_EXPECT_OK(iree_vm_stack_function_enter(
+        stack, &function_b, IREE_VM_STACK_FRAME_NATIVE, 0, NULL, &frame_b));
+    EXPECT_EQ(MODULE_B_STATE_SENTINEL, frame_b->module_state);
+    IREE_EXPECT_OK(iree_vm_stack_function_leave(stack));
+  }
+  EXPECT_EQ(1, module_b_state_resolve_count);
+
+  // Explicit queries hit the same cache.
+  iree_vm_module_state_t* module_state = nullptr;
+  IREE_EXPECT_OK(iree_vm_stack_query_module_state(stack, MODULE_B_SENTINEL,
+                                                  &module_state));
+  EXPECT_EQ(MODULE_B_STATE_SENTINEL, module_state);
+  EXPECT_EQ(1, module_b_state_resolve_count);
+
+  IREE_EXPECT_OK(iree_vm_stack_function_leave(stack));
+  iree_vm_stack_deinitialize(stack);
+}
+
 // Tests that module state query failures propagate to callers correctly.
 TEST(VMStackTest, ModuleStateQueryFailure) {
   iree_vm_state_resolver_t state_resolver = {
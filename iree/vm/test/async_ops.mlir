@@ -0,0 +1,63 @@
+vm.module @async_ops {
+
+  //===--------------------------------------------------------------------===//
+  // vm.yield
+  //===--------------------------------------------------------------------===//
+
+  vm.export @test_yield_sequence
+  vm.func @test_yield_sequence() {
+    %c1 = vm.const.i32 1 : i32
+    %c2 = vm.const.i32 2 : i32
+    %c3 = vm.const.i32 3 : i32
+    %y0 = util.do_not_optimize(%c1) : i32
+    vm.yield ^bb1(%y0 : i32)
+  ^bb1(%y1 : i32):
+    %y1_dno = util.do_not_optimize(%y1) : i32
+    %y2 = vm.add.i32 %y1_dno, %c1 : i32
+    vm.yield ^bb2(%y2 : i32)
+  ^bb2(%y3 : i32):
+    vm.check.eq %y3, %c2, "yield values preserved" : i32
+    %y4 = vm.add.i32 %y3, %c1 : i32
+    vm.check.eq %y4, %c3, "execution resumed at target" : i32
+    vm.return
+  }
+
+  vm.export @test_yield_loop
+  vm.func @test_yield_loop() {
+    %c0 = vm.const.i32 0 : i32
+    %c1 = vm.const.i32 1 : i32
+    %c4 = vm.const.i32 4 : i32
+    %c0_dno = util.do_not_optimize(%c0) : i32
+    vm.br ^loop(%c0_dno : i32)
+  ^loop(%i : i32):
+    %i_next = vm.add.i32 %i, %c1 : i32
+    vm.yield ^check(%i_next : i32)
+  ^check(%j : i32):
+    %done = vm.cmp.eq.i32 %j, %c4 : i32
+    vm.cond_br %done, ^exit(%j : i32), ^loop(%j : i32)
+  ^exit(%n : i32):
+    vm.check.eq %n, %c4, "yielded once per iteration" : i32
+    vm.return
+  }
+
+  vm.export @test_yield_in_call
+  vm.func @test_yield_in_call() {
+    %c1 = vm.const.i32 1 : i32
+    %c2 = vm.const.i32 2 : i32
+    %c1_dno = util.do_not_optimize(%c1) : i32
+    %0 = vm.call @_yield_add_one(%c1_dno) : (i32) -> i32
+    vm.check.eq %0, %c2, "callee results returned after resume" : i32
+    %c1_after = util.do_not_optimize(%c1) : i32
+    vm.check.eq %c1_after, %c1, "caller registers preserved" : i32
+    vm.return
+  }
+
+  vm.func @_yield_add_one(%arg : i32) -> i32 attributes {noinline} {
+    %c1 = vm.const.i32 1 : i32
+    vm.yield ^bb1
+  ^bb1:
+    %0 = vm.add.i32 %arg, %c1 : i32
+    vm.return %0 : i32
+  }
+
+}
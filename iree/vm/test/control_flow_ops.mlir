@@ -85,4 +85,54 @@ vm.module @control_flow_ops {
     vm.fail %code, "unreachable!"
   }
 
+  // Compare-and-branch sequences are fused by the bytecode encoder.
+
+  vm.export @test_cond_br_cmp_eq
+  vm.func @test_cond_br_cmp_eq() {
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %cmp = vm.cmp.eq.i32 %c1dno, %c1 : i32
+    vm.cond_br %cmp, ^bb1, ^bb2
+  ^bb1:
+    vm.return
+  ^bb2:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  }
+
+  vm.export @test_cond_br_cmp_lt_u_false
+  vm.func @test_cond_br_cmp_lt_u_false() {
+    %cn1 = vm.const.i32 -1 : i32
+    %c1 = vm.const.i32 1 : i32
+    %cn1dno = util.do_not_optimize(%cn1) : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %cmp = vm.cmp.lt.i32.u %cn1dno, %c1dno : i32
+    vm.cond_br %cmp, ^bb1, ^bb2
+  ^bb1:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  ^bb2:
+    vm.return
+  }
+
+  vm.export @test_cond_br_cmp_mixed_args
+  vm.func @test_cond_br_cmp_mixed_args() {
+    %c1 = vm.const.i32 1 : i32
+    %c2 = vm.const.i32 2 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %c2dno = util.do_not_optimize(%c2) : i32
+    %ref = vm.const.ref.zero : !vm.ref<?>
+    %cmp = vm.cmp.lt.i32.s %c1dno, %c2dno : i32
+    vm.cond_br %cmp, ^bb1(%ref, %c2dno, %c1dno : !vm.ref<?>, i32, i32),
+                     ^bb2(%c1dno : i32)
+  ^bb1(%arg_ref : !vm.ref<?>, %arg_a : i32, %arg_b : i32):
+    vm.check.eq %arg_ref, %ref, "error!" : !vm.ref<?>
+    vm.check.eq %arg_a, %c2dno, "error!" : i32
+    vm.check.eq %arg_b, %c1dno, "error!" : i32
+    vm.return
+  ^bb2(%arg_c : i32):
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  }
+
 }
@@ -6,6 +6,8 @@
 
 #include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtOps.h"
 
+#include <cmath>
+
 #include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtDialect.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallSet.h"
@@ -190,9 +192,30 @@ static LogicalResult verifyScatterOp(ScatterOp op) {
 SmallVector<StringRef> ScatterOp::getLoopIteratorTypes() {
   SmallVector<StringRef> iteratorTypes(getUpdateType().getRank(),
                                        getParallelIteratorTypeName());
+  // Repeated indices make the updates of a slice depend on each other.
+  if (!unique_indices()) {
+    iteratorTypes[0] = getReductionIteratorTypeName();
+  }
   return iteratorTypes;
 }
 
+SmallVector<unsigned> ScatterOp::getPartitionableLoops(
+    unsigned maxNumParallelDims) {
+  // With repeated indices only the dimensions of the update slices are
+  // partitioned. Each slice is then updated by a single workgroup, which
+  // applies the updates in order without atomics.
+  unsigned firstLoop = unique_indices() ? 0 : 1;
+  auto range = llvm::seq<unsigned>(firstLoop, getUpdateType().getRank());
+  SmallVector<unsigned> partitionableLoops(range.begin(), range.end());
+  if (partitionableLoops.size() > maxNumParallelDims) {
+    partitionableLoops.erase(
+        partitionableLoops.begin(),
+        std::next(partitionableLoops.begin(),
+                  partitionableLoops.size() - maxNumParallelDims));
+  }
+  return partitionableLoops;
+}
+
 SmallVector<Range> ScatterOp::getIterationDomain(OpBuilder &builder) {
   Location loc = getLoc();
   Value zero = builder.create<arith::ConstantIndexOp>(loc, 0);
@@ -515,6 +538,227 @@ LogicalResult SortOp::generateScalarImplementation(OpBuilder &b, Location loc,
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// TopkOp
+//===----------------------------------------------------------------------===//
+
+static LogicalResult verifyTopkOp(TopkOp op) {
+  if (op.getNumInputs() != 1 && op.getNumInputs() != 2) {
+    return op.emitOpError("expected one or two input operands");
+  }
+  if (op.getNumOutputs() != 2) {
+    return op.emitOpError("expected two output operands");
+  }
+  int64_t rank = op.getInputRank();
+  int64_t dimension = op.dimension();
+  if (dimension < 0 || dimension >= rank) {
+    return op.emitOpError("dimension must be within [0, ") << rank << ")";
+  }
+
+  auto inputType = op.getInputType();
+  if (Optional<Value> indices = op.indices()) {
+    auto indicesType = indices->getType().cast<ShapedType>();
+    if (!indicesType.getElementType().isInteger(32)) {
+      return op.emitOpError("expected input indices to be of i32 type");
+    }
+    if (failed(verifyCompatibleShape(inputType, indicesType))) {
+      return op.emitOpError("input values and indices shapes must match");
+    }
+  }
+
+  auto outputValuesType = op.outputValues().getType().cast<ShapedType>();
+  auto outputIndicesType = op.outputIndices().getType().cast<ShapedType>();
+  if (outputValuesType.getElementType() != inputType.getElementType()) {
+    return op.emitOpError(
+        "expected input/output value element types to be identical");
+  }
+  if (!outputIndicesType.getElementType().isInteger(32)) {
+    return op.emitOpError("expected output indices to be of i32 type");
+  }
+  if (failed(verifyCompatibleShape(outputValuesType, outputIndicesType))) {
+    return op.emitOpError("output values and indices shapes must match");
+  }
+  if (outputValuesType.getRank() != rank) {
+    return op.emitOpError("expected input/output to have identical ranks");
+  }
+  for (auto dim : llvm::seq<int64_t>(0, rank)) {
+    if (dim == dimension) continue;
+    int64_t inputSize = inputType.getDimSize(dim);
+    int64_t outputSize = outputValuesType.getDimSize(dim);
+    if (inputSize != ShapedType::kDynamicSize &&
+        outputSize != ShapedType::kDynamicSize && inputSize != outputSize) {
+      return op.emitOpError("incompatible input/output shapes at dim#")
+             << dim;
+    }
+  }
+
+  Block &block = op.region().front();
+  if (block.getNumArguments() != 2) {
+    return op.emitOpError("expected region to have two arguments");
+  }
+  for (BlockArgument arg : block.getArguments()) {
+    if (arg.getType() != inputType.getElementType()) {
+      return op.emitOpError("region block argument #")
+             << arg.getArgNumber() << " should be of type "
+             << inputType.getElementType() << " but got " << arg.getType();
+    }
+  }
+  auto yieldOp = cast<YieldOp>(block.getTerminator());
+  if (yieldOp.getNumOperands() != 1) {
+    return op.emitOpError("should yield exactly one operand");
+  }
+  auto ty = yieldOp.getOperand(0).getType().dyn_cast<IntegerType>();
+  if (!ty || ty.getWidth() != 1) {
+    return op.emitOpError("should yield i1 type");
+  }
+  return success();
+}
+
+SmallVector<Range> TopkOp::getIterationDomain(OpBuilder &builder) {
+  int64_t operandRank = getInputRank();
+  SmallVector<Range> loopBounds(operandRank);
+  Location loc = getLoc();
+  Value zero = builder.create<arith::ConstantIndexOp>(loc, 0);
+  Value one = builder.create<arith::ConstantIndexOp>(loc, 1);
+  Value source = values();
+  for (auto dim : llvm::seq<int64_t>(0, operandRank)) {
+    loopBounds[dim].offset = zero;
+    loopBounds[dim].size = getDimValue(builder, loc, source, dim);
+    loopBounds[dim].stride = one;
+  }
+  return loopBounds;
+}
+
+SmallVector<StringRef> TopkOp::getLoopIteratorTypes() {
+  SmallVector<StringRef> iteratorTypes(getInputRank(),
+                                       getParallelIteratorTypeName());
+  iteratorTypes[dimension()] = getReductionIteratorTypeName();
+  return iteratorTypes;
+}
+
+SmallVector<unsigned> TopkOp::getPartitionableLoops(
+    unsigned maxNumParallelDims) {
+  auto range = llvm::seq<unsigned>(0, getInputRank());
+  SmallVector<unsigned> partitionableLoops(range.begin(), range.end());
+  partitionableLoops.erase(std::next(partitionableLoops.begin(), dimension()));
+  if (partitionableLoops.size() > maxNumParallelDims) {
+    partitionableLoops.erase(
+        partitionableLoops.begin(),
+        std::next(partitionableLoops.begin(),
+                  partitionableLoops.size() - maxNumParallelDims));
+  }
+  return partitionableLoops;
+}
+
+// Generates the insertion of a single input element into the sorted outputs:
+//
+//     value = values[ivs], index = indices[ivs]
+//     for (j = 0; j < k; ++j) {
+//       if (comparator(value, outputValues[j])) {
+//         swap(value, outputValues[j])
+//         swap(index, outputIndices[j])
+//       }
+//     }
+LogicalResult TopkOp::generateScalarImplementation(OpBuilder &b, Location loc,
+                                                   ValueRange ivs) {
+  uint64_t topkDim = dimension();
+  Value zero = b.create<arith::ConstantIndexOp>(loc, 0);
+  Value one = b.create<arith::ConstantIndexOp>(loc, 1);
+  Value ub = getDimValue(b, loc, outputValues(), topkDim);
+
+  Value value = b.create<memref::LoadOp>(loc, values(), ivs);
+  Value index;
+  if (Optional<Value> inputIndices = indices()) {
+    index = b.create<memref::LoadOp>(loc, *inputIndices, ivs);
+  } else {
+    index = b.create<arith::IndexCastOp>(loc, b.getI32Type(), ivs[topkDim]);
+  }
+
+  auto &srcBlock = region().front();
+  b.create<scf::ForOp>(
+      loc, zero, ub, one, ValueRange{value, index},
+      [&](OpBuilder &b, Location loc, Value iv, ValueRange iters) {
+        SmallVector<Value> outputIvs(ivs);
+        outputIvs[topkDim] = iv;
+        Value outputValue =
+            b.create<memref::LoadOp>(loc, outputValues(), outputIvs);
+        Value outputIndex =
+            b.create<memref::LoadOp>(loc, outputIndices(), outputIvs);
+
+        BlockAndValueMapping bvm;
+        bvm.map(srcBlock.getArgument(0), iters[0]);
+        bvm.map(srcBlock.getArgument(1), outputValue);
+        for (auto &blockOp : srcBlock.without_terminator()) {
+          b.clone(blockOp, bvm);
+        }
+        Value cond =
+            bvm.lookupOrDefault(srcBlock.getTerminator()->getOperand(0));
+
+        auto ifOp = b.create<scf::IfOp>(
+            loc, iters.getTypes(), cond,
+            [&](OpBuilder &b, Location loc) {
+              // Insert the element and carry the displaced one.
+              b.create<memref::StoreOp>(loc, iters[0], outputValues(),
+                                        outputIvs);
+              b.create<memref::StoreOp>(loc, iters[1], outputIndices(),
+                                        outputIvs);
+              b.create<scf::YieldOp>(loc,
+                                     ValueRange{outputValue, outputIndex});
+            },
+            [&](OpBuilder &b, Location loc) {
+              b.create<scf::YieldOp>(loc, iters);
+            });
+        b.create<scf::YieldOp>(loc, ifOp.getResults());
+      });
+  return success();
+}
+
+Operation *TopkOp::getTiledImplementation(OpBuilder &builder,
+                                          ValueRange outputs,
+                                          ArrayRef<OpFoldResult> offsets,
+                                          ArrayRef<OpFoldResult> sizes,
+                                          SmallVectorImpl<Value> &results) {
+  assert(outputs.size() == this->outputs().size());
+  int64_t rank = getInputRank();
+  assert(offsets.size() == static_cast<size_t>(rank) &&
+         sizes.size() == static_cast<size_t>(rank));
+  auto oneAttr = builder.getI64IntegerAttr(1);
+  SmallVector<OpFoldResult> strides(rank, oneAttr);
+  Location loc = getLoc();
+
+  SmallVector<Value> tiledOperands;
+  for (OpOperand *input : getInputOperands()) {
+    tiledOperands.emplace_back(
+        getSlice(builder, loc, input->get(), offsets, sizes, strides));
+  }
+
+  // The outputs are not tiled along the top-k dimension.
+  SmallVector<OpFoldResult> outputOffsets(offsets.begin(), offsets.end());
+  SmallVector<OpFoldResult> outputSizes(sizes.begin(), sizes.end());
+  outputOffsets[dimension()] = builder.getI64IntegerAttr(0);
+  outputSizes[dimension()] = getDim(builder, loc, outputs[0], dimension());
+  for (Value output : outputs) {
+    tiledOperands.emplace_back(getSlice(builder, loc, output, outputOffsets,
+                                        outputSizes, strides));
+  }
+
+  SmallVector<Type, 4> resultTypes;
+  if (hasTensorSemantics()) {
+    for (Value output : ValueRange(tiledOperands).take_back(outputs.size())) {
+      resultTypes.push_back(output.getType());
+    }
+  }
+  Operation *tiledTopkOp = cast<LinalgExtOp>(getOperation())
+                               .clone(builder, loc, resultTypes, tiledOperands);
+  for (auto result : llvm::enumerate(tiledTopkOp->getResults())) {
+    auto insertSliceOp = builder.create<tensor::InsertSliceOp>(
+        loc, result.value(), outputs[result.index()], outputOffsets,
+        outputSizes, strides);
+    results.push_back(insertSliceOp.getResult());
+  }
+  return tiledTopkOp;
+}
+
 //===----------------------------------------------------------------------===//
 // FftOp
 //===----------------------------------------------------------------------===//
@@ -1131,6 +1375,239 @@ Operation *ReverseOp::getTiledImplementation(OpBuilder &builder,
   return tiledRevOp;
 }
 
+//===----------------------------------------------------------------------===//
+// AttentionOp
+//===----------------------------------------------------------------------===//
+
+static LogicalResult verifyAttentionOp(AttentionOp op) {
+  if (op.getNumInputs() != 3) {
+    return op.emitOpError("expected three input operands");
+  }
+  if (op.getNumOutputs() != 1) {
+    return op.emitOpError("expected one output operand");
+  }
+  ShapedType queryType = op.getQueryType();
+  ShapedType keyType = op.getKeyType();
+  ShapedType valueType = op.getValueType();
+  ShapedType outputType = op.getOutputType();
+  if (!queryType.hasRank() || !keyType.hasRank() || !valueType.hasRank() ||
+      !outputType.hasRank() || queryType.getRank() != 3 ||
+      keyType.getRank() != 3 || valueType.getRank() != 3 ||
+      outputType.getRank() != 3) {
+    return op.emitOpError("expected all operands to be of rank 3");
+  }
+  Type elementType = outputType.getElementType();
+  if (!elementType.isa<FloatType>()) {
+    return op.emitOpError("expected a floating point element type");
+  }
+  if (queryType.getElementType() != elementType ||
+      keyType.getElementType() != elementType ||
+      valueType.getElementType() != elementType) {
+    return op.emitOpError("expected all element types to be identical");
+  }
+  auto isCompatible = [](int64_t lhs, int64_t rhs) {
+    return lhs == ShapedType::kDynamicSize ||
+           rhs == ShapedType::kDynamicSize || lhs == rhs;
+  };
+  int64_t batch = queryType.getDimSize(0);
+  if (!isCompatible(batch, keyType.getDimSize(0)) ||
+      !isCompatible(batch, valueType.getDimSize(0)) ||
+      !isCompatible(batch, outputType.getDimSize(0))) {
+    return op.emitOpError("incompatible batch dimensions");
+  }
+  if (!isCompatible(queryType.getDimSize(2), keyType.getDimSize(2))) {
+    return op.emitOpError("incompatible query/key head dimensions");
+  }
+  if (!isCompatible(keyType.getDimSize(1), valueType.getDimSize(1))) {
+    return op.emitOpError("incompatible key/value sequence lengths");
+  }
+  if (!isCompatible(queryType.getDimSize(1), outputType.getDimSize(1)) ||
+      !isCompatible(valueType.getDimSize(2), outputType.getDimSize(2))) {
+    return op.emitOpError("incompatible output shape");
+  }
+  return success();
+}
+
+bool AttentionOp::payloadUsesValueFromOperand(OpOperand *opOperand) {
+  return opOperand->getOperandNumber() < getNumInputs();
+}
+
+SmallVector<StringRef> AttentionOp::getLoopIteratorTypes() {
+  // The batch and query row loops; the reductions over the keys and the head
+  // dimension are part of the scalar implementation.
+  SmallVector<StringRef> iteratorTypes(2, getParallelIteratorTypeName());
+  return iteratorTypes;
+}
+
+SmallVector<Range> AttentionOp::getIterationDomain(OpBuilder &builder) {
+  Location loc = getLoc();
+  Value zero = builder.create<arith::ConstantIndexOp>(loc, 0);
+  Value one = builder.create<arith::ConstantIndexOp>(loc, 1);
+  SmallVector<Range> ranges;
+  for (auto dim : llvm::seq<int64_t>(0, 2)) {
+    Value ub = getDimValue(builder, loc, output(), dim);
+    ranges.emplace_back(Range{zero, ub, one});
+  }
+  return ranges;
+}
+
+// Generates the online softmax of a single query row:
+//
+//     max = -inf, sum = 0, output[b, m, :] = 0
+//     for n:
+//       s = dot(query[b, m, :], key[b, n, :]) * scale
+//       newMax = max(max, s)
+//       correction = exp(max - newMax)
+//       p = exp(s - newMax)
+//       sum = sum * correction + p
+//       output[b, m, :] = output[b, m, :] * correction + p * value[b, n, :]
+//       max = newMax
+//     output[b, m, :] /= sum
+LogicalResult AttentionOp::generateScalarImplementation(OpBuilder &b,
+                                                        Location loc,
+                                                        ValueRange ivs) {
+  Value batch = ivs[0];
+  Value row = ivs[1];
+  auto elementType = getOutputType().getElementType().cast<FloatType>();
+  Value zero = b.create<arith::ConstantIndexOp>(loc, 0);
+  Value one = b.create<arith::ConstantIndexOp>(loc, 1);
+  Value headDim = getDimValue(b, loc, query(), 2);
+  Value keyLength = getDimValue(b, loc, key(), 1);
+  Value valueDim = getDimValue(b, loc, value(), 2);
+  Value zeroF =
+      b.create<arith::ConstantOp>(loc, b.getFloatAttr(elementType, 0.0));
+  Value negInf = b.create<arith::ConstantOp>(
+      loc, FloatAttr::get(elementType,
+                          APFloat::getInf(elementType.getFloatSemantics(),
+                                          /*Negative=*/true)));
+  Value scale;
+  if (getQueryType().isDynamicDim(2)) {
+    Value headDimInt =
+        b.create<arith::IndexCastOp>(loc, b.getI64Type(), headDim);
+    scale = b.create<math::RsqrtOp>(
+        loc, b.create<arith::SIToFPOp>(loc, elementType, headDimInt));
+  } else {
+    scale = b.create<arith::ConstantOp>(
+        loc, b.getFloatAttr(elementType,
+                            1.0 / std::sqrt(getQueryType().getDimSize(2))));
+  }
+
+  b.create<scf::ForOp>(
+      loc, zero, valueDim, one, llvm::None,
+      [&](OpBuilder &b, Location loc, Value e, ValueRange) {
+        b.create<memref::StoreOp>(loc, zeroF, output(),
+                                  ValueRange{batch, row, e});
+        b.create<scf::YieldOp>(loc);
+      });
+
+  auto keyLoop = b.create<scf::ForOp>(
+      loc, zero, keyLength, one, ValueRange{negInf, zeroF},
+      [&](OpBuilder &b, Location loc, Value n, ValueRange args) {
+        Value max = args[0];
+        Value sum = args[1];
+        auto dotLoop = b.create<scf::ForOp>(
+            loc, zero, headDim, one, ValueRange{zeroF},
+            [&](OpBuilder &b, Location loc, Value d, ValueRange args) {
+              Value q = b.create<memref::LoadOp>(loc, query(),
+                                                 ValueRange{batch, row, d});
+              Value k = b.create<memref::LoadOp>(loc, key(),
+                                                 ValueRange{batch, n, d});
+              Value qk = b.create<arith::MulFOp>(loc, q, k);
+              b.create<scf::YieldOp>(
+                  loc, ValueRange{b.create<arith::AddFOp>(loc, args[0], qk)});
+            });
+        Value score =
+            b.create<arith::MulFOp>(loc, dotLoop.getResult(0), scale);
+        Value newMax = b.create<arith::MaxFOp>(loc, max, score);
+        Value correction = b.create<math::ExpOp>(
+            loc, b.create<arith::SubFOp>(loc, max, newMax));
+        Value p = b.create<math::ExpOp>(
+            loc, b.create<arith::SubFOp>(loc, score, newMax));
+        Value newSum = b.create<arith::AddFOp>(
+            loc, b.create<arith::MulFOp>(loc, sum, correction), p);
+        b.create<scf::ForOp>(
+            loc, zero, valueDim, one, llvm::None,
+            [&](OpBuilder &b, Location loc, Value e, ValueRange) {
+              Value acc = b.create<memref::LoadOp>(loc, output(),
+                                                   ValueRange{batch, row, e});
+              Value v = b.create<memref::LoadOp>(loc, value(),
+                                                 ValueRange{batch, n, e});
+              Value result = b.create<arith::AddFOp>(
+                  loc, b.create<arith::MulFOp>(loc, acc, correction),
+                  b.create<arith::MulFOp>(loc, p, v));
+              b.create<memref::StoreOp>(loc, result, output(),
+                                        ValueRange{batch, row, e});
+              b.create<scf::YieldOp>(loc);
+            });
+        b.create<scf::YieldOp>(loc, ValueRange{newMax, newSum});
+      });
+
+  Value sum = keyLoop.getResult(1);
+  b.create<scf::ForOp>(
+      loc, zero, valueDim, one, llvm::None,
+      [&](OpBuilder &b, Location loc, Value e, ValueRange) {
+        Value acc =
+            b.create<memref::LoadOp>(loc, output(), ValueRange{batch, row, e});
+        b.create<memref::StoreOp>(loc, b.create<arith::DivFOp>(loc, acc, sum),
+                                  output(), ValueRange{batch, row, e});
+        b.create<scf::YieldOp>(loc);
+      });
+  return success();
+}
+
+Operation *AttentionOp::getTiledImplementation(
+    OpBuilder &builder, ValueRange outputs, ArrayRef<OpFoldResult> offsets,
+    ArrayRef<OpFoldResult> sizes, SmallVectorImpl<Value> &results) {
+  assert(outputs.size() == 1);
+  assert(offsets.size() == 2 && sizes.size() == 2);
+  Location loc = getLoc();
+  auto zeroAttr = builder.getI64IntegerAttr(0);
+  auto oneAttr = builder.getI64IntegerAttr(1);
+  SmallVector<OpFoldResult> strides(3, oneAttr);
+
+  // The query rows and the output rows are tiled along with the iteration
+  // domain; every tile reads all the keys and values of its batches.
+  auto getRowsSlice = [&](Value source) {
+    SmallVector<OpFoldResult> sliceOffsets = {offsets[0], offsets[1],
+                                              zeroAttr};
+    SmallVector<OpFoldResult> sliceSizes = {sizes[0], sizes[1],
+                                            getDim(builder, loc, source, 2)};
+    return getSlice(builder, loc, source, sliceOffsets, sliceSizes, strides);
+  };
+  auto getBatchSlice = [&](Value source) {
+    SmallVector<OpFoldResult> sliceOffsets = {offsets[0], zeroAttr, zeroAttr};
+    SmallVector<OpFoldResult> sliceSizes = {sizes[0],
+                                            getDim(builder, loc, source, 1),
+                                            getDim(builder, loc, source, 2)};
+    return getSlice(builder, loc, source, sliceOffsets, sliceSizes, strides);
+  };
+  SmallVector<Value> tiledOperands = {getRowsSlice(query()),
+                                      getBatchSlice(key()),
+                                      getBatchSlice(value()),
+                                      getRowsSlice(outputs[0])};
+
+  SmallVector<Type, 4> resultTypes;
+  if (hasTensorSemantics()) {
+    resultTypes.push_back(tiledOperands[3].getType());
+  }
+
+  Operation *tiledAttentionOp =
+      cast<LinalgExtOp>(getOperation())
+          .clone(builder, loc, resultTypes, tiledOperands);
+
+  for (auto result : llvm::enumerate(tiledAttentionOp->getResults())) {
+    SmallVector<OpFoldResult> resultOffsets = {offsets[0], offsets[1],
+                                               zeroAttr};
+    SmallVector<OpFoldResult> resultSizes = {
+        sizes[0], sizes[1], getDim(builder, loc, outputs[0], 2)};
+    auto insertSliceOp = builder.create<tensor::InsertSliceOp>(
+        loc, result.value(), outputs[result.index()], resultOffsets,
+        resultSizes, strides);
+    results.push_back(insertSliceOp.getResult());
+  }
+  return tiledAttentionOp;
+}
+
 #define DEFINE_OP_GET_EFFECTS(OP_NAME)                                    \
   void OP_NAME::getEffects(                                               \
       SmallVectorImpl<SideEffects::EffectInstance<MemoryEffects::Effect>> \
@@ -1143,9 +1620,11 @@ Operation *ReverseOp::getTiledImplementation(OpBuilder &builder,
 
 DEFINE_OP_GET_EFFECTS(ScatterOp)
 DEFINE_OP_GET_EFFECTS(SortOp)
+DEFINE_OP_GET_EFFECTS(TopkOp)
 DEFINE_OP_GET_EFFECTS(FftOp)
 DEFINE_OP_GET_EFFECTS(ReverseOp)
 DEFINE_OP_GET_EFFECTS(ScanOp)
+DEFINE_OP_GET_EFFECTS(AttentionOp)
 
 namespace {
 /// This is derived from mlir/lib/Dialect/Linalg/IR/LinalgOps.cpp without any
@@ -604,3 +604,97 @@ func @scan_2d(%0: memref<16x32xi32>, %1: memref<16x32xi32>) {
 // CHECK:               memref.store %[[V4]], %[[BUFO]][%[[ARG1]], %[[ARG2]]]
 // CHECK:               memref.store %[[V4]], %[[ACC]][%[[ARG2]]]
 // CHECK:             }
+
+// -----
+
+func @attention(%query: memref<2x4x8xf32>, %key: memref<2x16x8xf32>,
+    %value: memref<2x16x4xf32>, %output: memref<2x4x4xf32>) {
+  iree_linalg_ext.attention
+    ins(%query, %key, %value : memref<2x4x8xf32>, memref<2x16x8xf32>, memref<2x16x4xf32>)
+    outs(%output : memref<2x4x4xf32>)
+  return
+}
+// CHECK-LABEL: func @attention
+// CHECK-SAME:    %[[QUERY:[a-zA-Z0-9]+]]
+// CHECK-SAME:    %[[KEY:[a-zA-Z0-9]+]]
+// CHECK-SAME:    %[[VALUE:[a-zA-Z0-9]+]]
+// CHECK-SAME:    %[[OUTPUT:[a-zA-Z0-9]+]]
+// CHECK-DAG:     %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG:     %[[C1:.+]] = arith.constant 1 : index
+// CHECK-DAG:     %[[C2:.+]] = arith.constant 2 : index
+// CHECK-DAG:     %[[C4:.+]] = arith.constant 4 : index
+// CHECK-DAG:     %[[C8:.+]] = arith.constant 8 : index
+// CHECK-DAG:     %[[C16:.+]] = arith.constant 16 : index
+// CHECK-DAG:     %[[ZERO:.+]] = arith.constant 0.000000e+00 : f32
+// CHECK-DAG:     %[[NEG_INF:.+]] = arith.constant 0xFF800000 : f32
+// CHECK:         scf.for %[[B:.+]] = %[[C0]] to %[[C2]] step %[[C1]]
+// CHECK:           scf.for %[[M:.+]] = %[[C0]] to %[[C4]] step %[[C1]]
+// CHECK:             scf.for %[[E0:.+]] = %[[C0]] to %[[C4]] step %[[C1]]
+// CHECK:               memref.store %[[ZERO]], %[[OUTPUT]][%[[B]], %[[M]], %[[E0]]]
+// CHECK:             %[[KEY_LOOP:.+]]:2 = scf.for %[[N:.+]] = %[[C0]] to %[[C16]] step %[[C1]]
+// CHECK-SAME:            iter_args(%[[MAX:.+]] = %[[NEG_INF]], %[[SUM:.+]] = %[[ZERO]])
+// CHECK:               %[[DOT:.+]] = scf.for %[[D:.+]] = %[[C0]] to %[[C8]] step %[[C1]]
+// CHECK-SAME:              iter_args(%[[ACC:.+]] = %[[ZERO]])
+// CHECK:                 %[[Q:.+]] = memref.load %[[QUERY]][%[[B]], %[[M]], %[[D]]]
+// CHECK:                 %[[K:.+]] = memref.load %[[KEY]][%[[B]], %[[N]], %[[D]]]
+// CHECK:                 %[[QK:.+]] = arith.mulf %[[Q]], %[[K]]
+// CHECK:                 %[[NEW_ACC:.+]] = arith.addf %[[ACC]], %[[QK]]
+// CHECK:                 scf.yield %[[NEW_ACC]]
+// CHECK:               %[[SCORE:.+]] = arith.mulf %[[DOT]], %{{.+}} : f32
+// CHECK:               %[[NEW_MAX:.+]] = arith.maxf %[[MAX]], %[[SCORE]]
+// CHECK:               %[[MAX_DIFF:.+]] = arith.subf %[[MAX]], %[[NEW_MAX]]
+// CHECK:               %[[CORRECTION:.+]] = math.exp %[[MAX_DIFF]]
+// CHECK:               %[[SCORE_DIFF:.+]] = arith.subf %[[SCORE]], %[[NEW_MAX]]
+// CHECK:               %[[P:.+]] = math.exp %[[SCORE_DIFF]]
+// CHECK:               %[[SCALED_SUM:.+]] = arith.mulf %[[SUM]], %[[CORRECTION]]
+// CHECK:               %[[NEW_SUM:.+]] = arith.addf %[[SCALED_SUM]], %[[P]]
+// CHECK:               scf.for %[[E1:.+]] = %[[C0]] to %[[C4]] step %[[C1]]
+// CHECK:                 %[[OUT:.+]] = memref.load %[[OUTPUT]][%[[B]], %[[M]], %[[E1]]]
+// CHECK:                 %[[V:.+]] = memref.load %[[VALUE]][%[[B]], %[[N]], %[[E1]]]
+// CHECK:                 %[[SCALED_OUT:.+]] = arith.mulf %[[OUT]], %[[CORRECTION]]
+// CHECK:                 %[[PV:.+]] = arith.mulf %[[P]], %[[V]]
+// CHECK:                 %[[NEW_OUT:.+]] = arith.addf %[[SCALED_OUT]], %[[PV]]
+// CHECK:                 memref.store %[[NEW_OUT]], %[[OUTPUT]][%[[B]], %[[M]], %[[E1]]]
+// CHECK:               scf.yield %[[NEW_MAX]], %[[NEW_SUM]]
+// CHECK:             scf.for %[[E2:.+]] = %[[C0]] to %[[C4]] step %[[C1]]
+// CHECK:               %[[FINAL:.+]] = memref.load %[[OUTPUT]][%[[B]], %[[M]], %[[E2]]]
+// CHECK:               %[[NORMALIZED:.+]] = arith.divf %[[FINAL]], %[[KEY_LOOP]]#1
+// CHECK:               memref.store %[[NORMALIZED]], %[[OUTPUT]][%[[B]], %[[M]], %[[E2]]]
+
+// -----
+
+func @topk_1d(%values: memref<10xf32>, %out_values: memref<3xf32>,
+    %out_indices: memref<3xi32>) {
+  iree_linalg_ext.topk dimension(0)
+    ins(%values : memref<10xf32>)
+    outs(%out_values, %out_indices : memref<3xf32>, memref<3xi32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %0 = arith.cmpf ogt, %arg0, %arg1 : f32
+      iree_linalg_ext.yield %0 : i1
+    }
+  return
+}
+// CHECK-LABEL: func @topk_1d
+// CHECK-SAME:    %[[VALUES:[a-zA-Z0-9_]+]]
+// CHECK-SAME:    %[[OUT_VALUES:[a-zA-Z0-9_]+]]
+// CHECK-SAME:    %[[OUT_INDICES:[a-zA-Z0-9_]+]]
+// CHECK-DAG:     %[[C0:.+]] = arith.constant 0 : index
+// CHECK-DAG:     %[[C1:.+]] = arith.constant 1 : index
+// CHECK-DAG:     %[[C3:.+]] = arith.constant 3 : index
+// CHECK-DAG:     %[[C10:.+]] = arith.constant 10 : index
+// CHECK:         scf.for %[[I:.+]] = %[[C0]] to %[[C10]] step %[[C1]]
+// CHECK:           %[[V:.+]] = memref.load %[[VALUES]][%[[I]]]
+// CHECK:           %[[IDX:.+]] = arith.index_cast %[[I]] : index to i32
+// CHECK:           scf.for %[[J:.+]] = %[[C0]] to %[[C3]] step %[[C1]]
+// CHECK-SAME:          iter_args(%[[CUR_V:.+]] = %[[V]], %[[CUR_IDX:.+]] = %[[IDX]]) -> (f32, i32)
+// CHECK:             %[[OUT_V:.+]] = memref.load %[[OUT_VALUES]][%[[J]]]
+// CHECK:             %[[OUT_IDX:.+]] = memref.load %[[OUT_INDICES]][%[[J]]]
+// CHECK:             %[[COND:.+]] = arith.cmpf ogt, %[[CUR_V]], %[[OUT_V]] : f32
+// CHECK:             %[[SWAP:.+]]:2 = scf.if %[[COND]] -> (f32, i32) {
+// CHECK:               memref.store %[[CUR_V]], %[[OUT_VALUES]][%[[J]]]
+// CHECK:               memref.store %[[CUR_IDX]], %[[OUT_INDICES]][%[[J]]]
+// CHECK:               scf.yield %[[OUT_V]], %[[OUT_IDX]]
+// CHECK:             } else {
+// CHECK:               scf.yield %[[CUR_V]], %[[CUR_IDX]]
+// CHECK:             }
+// CHECK:             scf.yield %[[SWAP]]#0, %[[SWAP]]#1
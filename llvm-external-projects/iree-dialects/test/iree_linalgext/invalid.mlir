@@ -416,3 +416,76 @@ func @reverse_dup_dims(%arg0: tensor<3x5xi32>) -> tensor<3x5xi32> {
          outs(%init : tensor<3x5xi32>) : tensor<3x5xi32>
   return %0 : tensor<3x5xi32>
 }
+
+// -----
+
+func @attention_head_dim_mismatch(%query: tensor<2x128x64xf32>,
+    %key: tensor<2x256x32xf32>, %value: tensor<2x256x32xf32>)
+    -> tensor<2x128x32xf32> {
+  %init = linalg.init_tensor [2, 128, 32] : tensor<2x128x32xf32>
+  // expected-error @+1 {{incompatible query/key head dimensions}}
+  %0 = iree_linalg_ext.attention
+         ins(%query, %key, %value : tensor<2x128x64xf32>, tensor<2x256x32xf32>, tensor<2x256x32xf32>)
+         outs(%init : tensor<2x128x32xf32>) -> tensor<2x128x32xf32>
+  return %0 : tensor<2x128x32xf32>
+}
+
+// -----
+
+func @attention_int(%query: tensor<2x128x64xi32>, %key: tensor<2x256x64xi32>,
+    %value: tensor<2x256x32xi32>) -> tensor<2x128x32xi32> {
+  %init = linalg.init_tensor [2, 128, 32] : tensor<2x128x32xi32>
+  // expected-error @+1 {{expected a floating point element type}}
+  %0 = iree_linalg_ext.attention
+         ins(%query, %key, %value : tensor<2x128x64xi32>, tensor<2x256x64xi32>, tensor<2x256x32xi32>)
+         outs(%init : tensor<2x128x32xi32>) -> tensor<2x128x32xi32>
+  return %0 : tensor<2x128x32xi32>
+}
+
+// -----
+
+func @topk_invalid_dimension(%values: tensor<2x20xf32>,
+    %out_values: tensor<2x3xf32>, %out_indices: tensor<2x3xi32>)
+    -> (tensor<2x3xf32>, tensor<2x3xi32>) {
+  // expected-error @+1 {{dimension must be within [0, 2)}}
+  %0:2 = iree_linalg_ext.topk dimension(2)
+    ins(%values : tensor<2x20xf32>)
+    outs(%out_values, %out_indices : tensor<2x3xf32>, tensor<2x3xi32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %1 = arith.cmpf ogt, %arg0, %arg1 : f32
+      iree_linalg_ext.yield %1 : i1
+    } -> tensor<2x3xf32>, tensor<2x3xi32>
+  return %0#0, %0#1 : tensor<2x3xf32>, tensor<2x3xi32>
+}
+
+// -----
+
+func @topk_invalid_output_indices(%values: tensor<2x20xf32>,
+    %out_values: tensor<2x3xf32>, %out_indices: tensor<2x3xi64>)
+    -> (tensor<2x3xf32>, tensor<2x3xi64>) {
+  // expected-error @+1 {{expected output indices to be of i32 type}}
+  %0:2 = iree_linalg_ext.topk dimension(1)
+    ins(%values : tensor<2x20xf32>)
+    outs(%out_values, %out_indices : tensor<2x3xf32>, tensor<2x3xi64>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %1 = arith.cmpf ogt, %arg0, %arg1 : f32
+      iree_linalg_ext.yield %1 : i1
+    } -> tensor<2x3xf32>, tensor<2x3xi64>
+  return %0#0, %0#1 : tensor<2x3xf32>, tensor<2x3xi64>
+}
+
+// -----
+
+func @topk_mismatched_shapes(%values: tensor<2x20xf32>,
+    %out_values: tensor<4x3xf32>, %out_indices: tensor<4x3xi32>)
+    -> (tensor<4x3xf32>, tensor<4x3xi32>) {
+  // expected-error @+1 {{incompatible input/output shapes at dim#0}}
+  %0:2 = iree_linalg_ext.topk dimension(1)
+    ins(%values : tensor<2x20xf32>)
+    outs(%out_values, %out_indices : tensor<4x3xf32>, tensor<4x3xi32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %1 = arith.cmpf ogt, %arg0, %arg1 : f32
+      iree_linalg_ext.yield %1 : i1
+    } -> tensor<4x3xf32>, tensor<4x3xi32>
+  return %0#0, %0#1 : tensor<4x3xf32>, tensor<4x3xi32>
+}
@@ -492,3 +492,105 @@ func @reverse_multi_dims(%arg0: tensor<3x5xi32>) -> tensor<3x5xi32> {
 //  CHECK-SAME:      dimensions(dense<[0, 1]> : tensor<2xi64>)
 //  CHECK-SAME:      ins(%[[ARG0]]
 //  CHECK-SAME:      outs(%[[INIT]]
+
+// -----
+
+func @attention_tensor(%query: tensor<2x128x64xf32>, %key: tensor<2x256x64xf32>,
+    %value: tensor<2x256x32xf32>) -> tensor<2x128x32xf32> {
+  %init = linalg.init_tensor [2, 128, 32] : tensor<2x128x32xf32>
+  %0 = iree_linalg_ext.attention
+         ins(%query, %key, %value : tensor<2x128x64xf32>, tensor<2x256x64xf32>, tensor<2x256x32xf32>)
+         outs(%init : tensor<2x128x32xf32>) -> tensor<2x128x32xf32>
+  return %0 : tensor<2x128x32xf32>
+}
+// CHECK-LABEL: func @attention_tensor
+//  CHECK-SAME:   %[[QUERY:[a-zA-Z0-9]+]]: tensor<2x128x64xf32>
+//  CHECK-SAME:   %[[KEY:[a-zA-Z0-9]+]]: tensor<2x256x64xf32>
+//  CHECK-SAME:   %[[VALUE:[a-zA-Z0-9]+]]: tensor<2x256x32xf32>
+//       CHECK:   %[[INIT:.+]] = linalg.init_tensor [2, 128, 32]
+//       CHECK:   %[[RESULT:.+]] = iree_linalg_ext.attention
+//  CHECK-SAME:      ins(%[[QUERY]], %[[KEY]], %[[VALUE]]
+//  CHECK-SAME:      outs(%[[INIT]]
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
+func @attention_memref(%query: memref<?x?x?xf16>, %key: memref<?x?x?xf16>,
+    %value: memref<?x?x?xf16>, %output: memref<?x?x?xf16>) {
+  iree_linalg_ext.attention
+    ins(%query, %key, %value : memref<?x?x?xf16>, memref<?x?x?xf16>, memref<?x?x?xf16>)
+    outs(%output : memref<?x?x?xf16>)
+  return
+}
+// CHECK-LABEL: func @attention_memref
+//  CHECK-SAME:   %[[QUERY:[a-zA-Z0-9]+]]: memref<?x?x?xf16>
+//  CHECK-SAME:   %[[KEY:[a-zA-Z0-9]+]]: memref<?x?x?xf16>
+//  CHECK-SAME:   %[[VALUE:[a-zA-Z0-9]+]]: memref<?x?x?xf16>
+//  CHECK-SAME:   %[[OUTPUT:[a-zA-Z0-9]+]]: memref<?x?x?xf16>
+//       CHECK:   iree_linalg_ext.attention
+//  CHECK-SAME:      ins(%[[QUERY]], %[[KEY]], %[[VALUE]]
+//  CHECK-SAME:      outs(%[[OUTPUT]]
+
+// -----
+
+func @scatter_repeated_indices(
+    %original: tensor<8xi32>, %indices: tensor<4x1xi32>,
+    %update: tensor<4xi32>) -> tensor<8xi32> {
+  %0 = iree_linalg_ext.scatter {unique_indices = false}
+    ins(%update, %indices : tensor<4xi32>, tensor<4x1xi32>)
+    outs(%original : tensor<8xi32>)  {
+    ^bb0(%arg1: i32, %arg2: i32):
+      %1 = arith.addi %arg1, %arg2 : i32
+      iree_linalg_ext.yield %1 : i32
+    } -> tensor<8xi32>
+  return %0 : tensor<8xi32>
+}
+// CHECK-LABEL: func @scatter_repeated_indices
+//       CHECK:   %[[RESULT:.+]] = iree_linalg_ext.scatter
+//  CHECK-SAME:     {unique_indices = false}
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
+func @topk_tensor(%values: tensor<2x20xf32>, %out_values: tensor<2x3xf32>,
+    %out_indices: tensor<2x3xi32>) -> (tensor<2x3xf32>, tensor<2x3xi32>) {
+  %0:2 = iree_linalg_ext.topk dimension(1)
+    ins(%values : tensor<2x20xf32>)
+    outs(%out_values, %out_indices : tensor<2x3xf32>, tensor<2x3xi32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %1 = arith.cmpf ogt, %arg0, %arg1 : f32
+      iree_linalg_ext.yield %1 : i1
+    } -> tensor<2x3xf32>, tensor<2x3xi32>
+  return %0#0, %0#1 : tensor<2x3xf32>, tensor<2x3xi32>
+}
+// CHECK-LABEL: func @topk_tensor
+//  CHECK-SAME:   %[[VALUES:[a-zA-Z0-9_]+]]: tensor<2x20xf32>
+//  CHECK-SAME:   %[[OUT_VALUES:[a-zA-Z0-9_]+]]: tensor<2x3xf32>
+//  CHECK-SAME:   %[[OUT_INDICES:[a-zA-Z0-9_]+]]: tensor<2x3xi32>
+//       CHECK:   %[[RESULT:.+]]:2 = iree_linalg_ext.topk dimension(1)
+//  CHECK-SAME:      ins(%[[VALUES]]
+//  CHECK-SAME:      outs(%[[OUT_VALUES]], %[[OUT_INDICES]]
+//       CHECK:   return %[[RESULT]]#0, %[[RESULT]]#1
+
+// -----
+
+func @topk_memref_with_indices(%values: memref<?x?xi32>,
+    %indices: memref<?x?xi32>, %out_values: memref<?x4xi32>,
+    %out_indices: memref<?x4xi32>) {
+  iree_linalg_ext.topk dimension(1)
+    ins(%values, %indices : memref<?x?xi32>, memref<?x?xi32>)
+    outs(%out_values, %out_indices : memref<?x4xi32>, memref<?x4xi32>) {
+    ^bb0(%arg0: i32, %arg1: i32):
+      %0 = arith.cmpi slt, %arg0, %arg1 : i32
+      iree_linalg_ext.yield %0 : i1
+    }
+  return
+}
+// CHECK-LABEL: func @topk_memref_with_indices
+//  CHECK-SAME:   %[[VALUES:[a-zA-Z0-9_]+]]: memref<?x?xi32>
+//  CHECK-SAME:   %[[INDICES:[a-zA-Z0-9_]+]]: memref<?x?xi32>
+//  CHECK-SAME:   %[[OUT_VALUES:[a-zA-Z0-9_]+]]: memref<?x4xi32>
+//  CHECK-SAME:   %[[OUT_INDICES:[a-zA-Z0-9_]+]]: memref<?x4xi32>
+//       CHECK:   iree_linalg_ext.topk dimension(1)
+//  CHECK-SAME:      ins(%[[VALUES]], %[[INDICES]]
+//  CHECK-SAME:      outs(%[[OUT_VALUES]], %[[OUT_INDICES]]
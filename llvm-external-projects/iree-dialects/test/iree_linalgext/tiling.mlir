@@ -1270,3 +1270,80 @@ func @scan_2d_memref(%0: memref<16x32xi32>, %1: memref<16x32xi32>) {
 // CHECK-SAME:       ins(%[[UPDATE_SLICE_IN]]
 // CHECK-SAME:       outs(%[[UPDATE_SLICE_OUT]], %[[UPDATE_SLICE_ACC]]
 //      CHECK:   return
+
+// -----
+
+func @attention_tiling(%query: tensor<?x?x64xf32>, %key: tensor<?x?x64xf32>,
+    %value: tensor<?x?x32xf32>, %init: tensor<?x?x32xf32>) -> tensor<?x?x32xf32> {
+  %0 = iree_linalg_ext.attention
+         {__internal_linalg_transform__ = "tiling_input"}
+         ins(%query, %key, %value : tensor<?x?x64xf32>, tensor<?x?x64xf32>, tensor<?x?x32xf32>)
+         outs(%init : tensor<?x?x32xf32>) -> tensor<?x?x32xf32>
+  return %0 : tensor<?x?x32xf32>
+}
+//      CHECK: func @attention_tiling(
+// CHECK-SAME:   %[[QUERY:[a-zA-Z0-9_]+]]
+// CHECK-SAME:   %[[KEY:[a-zA-Z0-9_]+]]
+// CHECK-SAME:   %[[VALUE:[a-zA-Z0-9_]+]]
+// CHECK-SAME:   %[[INIT:[a-zA-Z0-9_]+]]
+//  CHECK-DAG:   %[[C10:.+]] = arith.constant 10 : index
+//  CHECK-DAG:   %[[C20:.+]] = arith.constant 20 : index
+//      CHECK:   %[[RESULT:.+]] = scf.for %[[B:.+]] = %{{.+}} to %{{.+}} step %[[C10]]
+// CHECK-SAME:       iter_args(%[[ARG0:.+]] = %[[INIT]])
+//      CHECK:     %[[YIELD:.+]] = scf.for %[[M:.+]] = %{{.+}} to %{{.+}} step %[[C20]]
+// CHECK-SAME:         iter_args(%[[ARG1:.+]] = %[[ARG0]])
+//      CHECK:       %[[QUERY_SLICE:.+]] = tensor.extract_slice %[[QUERY]][%[[B]], %[[M]], 0]
+// CHECK-SAME:           [%{{.+}}, %{{.+}}, 64] [1, 1, 1]
+//      CHECK:       %[[KEY_SLICE:.+]] = tensor.extract_slice %[[KEY]][%[[B]], 0, 0]
+// CHECK-SAME:           [%{{.+}}, %{{.+}}, 64] [1, 1, 1]
+//      CHECK:       %[[VALUE_SLICE:.+]] = tensor.extract_slice %[[VALUE]][%[[B]], 0, 0]
+// CHECK-SAME:           [%{{.+}}, %{{.+}}, 32] [1, 1, 1]
+//      CHECK:       %[[OUTPUT_SLICE:.+]] = tensor.extract_slice %[[ARG1]][%[[B]], %[[M]], 0]
+// CHECK-SAME:           [%{{.+}}, %{{.+}}, 32] [1, 1, 1]
+//      CHECK:       %[[ATTENTION:.+]] = iree_linalg_ext.attention
+// CHECK-SAME:           {__internal_linalg_transform__ = "tiling_output"}
+// CHECK-SAME:           ins(%[[QUERY_SLICE]], %[[KEY_SLICE]], %[[VALUE_SLICE]]
+// CHECK-SAME:           outs(%[[OUTPUT_SLICE]]
+//      CHECK:       %[[INSERT:.+]] = tensor.insert_slice %[[ATTENTION]] into %[[ARG1]][%[[B]], %[[M]], 0]
+// CHECK-SAME:           [%{{.+}}, %{{.+}}, 32] [1, 1, 1]
+//      CHECK:       scf.yield %[[INSERT]]
+//      CHECK:     scf.yield %[[YIELD]]
+//      CHECK:   return %[[RESULT]]
+
+// -----
+
+func @topk_tile_parallel(%values: tensor<?x?xf32>, %out_values: tensor<?x3xf32>,
+    %out_indices: tensor<?x3xi32>) -> (tensor<?x3xf32>, tensor<?x3xi32>) {
+  %0:2 = iree_linalg_ext.topk dimension(1)
+    {__internal_linalg_transform__ = "inner_reduce_input"}
+    ins(%values : tensor<?x?xf32>)
+    outs(%out_values, %out_indices : tensor<?x3xf32>, tensor<?x3xi32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      %1 = arith.cmpf ogt, %arg0, %arg1 : f32
+      iree_linalg_ext.yield %1 : i1
+    } -> tensor<?x3xf32>, tensor<?x3xi32>
+  return %0#0, %0#1 : tensor<?x3xf32>, tensor<?x3xi32>
+}
+//      CHECK: func @topk_tile_parallel(
+// CHECK-SAME:   %[[VALUES:[a-zA-Z0-9_]+]]
+// CHECK-SAME:   %[[OUT_VALUES:[a-zA-Z0-9_]+]]
+// CHECK-SAME:   %[[OUT_INDICES:[a-zA-Z0-9_]+]]
+//  CHECK-DAG:   %[[C10:.+]] = arith.constant 10 : index
+//  CHECK-DAG:   %[[C1:.+]] = arith.constant 1 : index
+//  CHECK-DAG:   %[[D1:.+]] = tensor.dim %[[VALUES]], %[[C1]]
+//      CHECK:   %[[RESULT:.+]]:2 = scf.for %[[IV:.+]] = %{{.+}} to %{{.+}} step %[[C10]]
+// CHECK-SAME:       iter_args(%[[ARG0:.+]] = %[[OUT_VALUES]], %[[ARG1:.+]] = %[[OUT_INDICES]])
+//      CHECK:     %[[VALUES_SLICE:.+]] = tensor.extract_slice %[[VALUES]][%[[IV]], 0]
+// CHECK-SAME:         [%{{.+}}, %[[D1]]] [1, 1]
+//      CHECK:     %[[OUT_VALUES_SLICE:.+]] = tensor.extract_slice %[[ARG0]][%[[IV]], 0]
+// CHECK-SAME:         [%{{.+}}, 3] [1, 1]
+//      CHECK:     %[[OUT_INDICES_SLICE:.+]] = tensor.extract_slice %[[ARG1]][%[[IV]], 0]
+// CHECK-SAME:         [%{{.+}}, 3] [1, 1]
+//      CHECK:     %[[TOPK:.+]]:2 = iree_linalg_ext.topk
+// CHECK-SAME:         __internal_linalg_transform__ = "inner_reduce_output"
+// CHECK-SAME:         ins(%[[VALUES_SLICE]]
+// CHECK-SAME:         outs(%[[OUT_VALUES_SLICE]], %[[OUT_INDICES_SLICE]]
+//      CHECK:     %[[INSERT0:.+]] = tensor.insert_slice %[[TOPK]]#0 into %[[ARG0]][%[[IV]], 0]
+//      CHECK:     %[[INSERT1:.+]] = tensor.insert_slice %[[TOPK]]#1 into %[[ARG1]][%[[IV]], 0]
+//      CHECK:     scf.yield %[[INSERT0]], %[[INSERT1]]
+//      CHECK:   return %[[RESULT]]#0, %[[RESULT]]#1
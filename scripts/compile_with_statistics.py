@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+
+# Copyright 2022 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Runs a compile command and records statistics about it as JSON.
+
+The command following `--` is run as-is and must produce the module file
+specified by --module_file. The statistics file contains the wall time taken
+by the command, the peak resident memory of the compiler, and the size of the
+resulting module:
+
+  {
+    "module_file": "<module-file>",
+    "compile_time_ms": 1234,
+    "compile_peak_rss_bytes": 5678,
+    "module_size_bytes": 91011
+  }
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+
+def parse_arguments():
+  """Parses command line arguments."""
+  parser = argparse.ArgumentParser()
+  parser.add_argument("--module_file",
+                      type=str,
+                      required=True,
+                      metavar="<module-file>",
+                      help="The module file produced by the command")
+  parser.add_argument("-o",
+                      "--output",
+                      type=str,
+                      required=True,
+                      metavar="<output-file>",
+                      help="Output JSON statistics file to write to")
+  parser.add_argument("command",
+                      nargs=argparse.REMAINDER,
+                      help="The compile command to run, following `--`")
+  args = parser.parse_args()
+  if args.command and args.command[0] == "--":
+    args.command = args.command[1:]
+  if not args.command:
+    parser.error("a compile command must be specified after `--`")
+  return args
+
+
+def main(args):
+  start_time = time.perf_counter()
+  process = subprocess.Popen(args.command)
+  _, status, rusage = os.wait4(process.pid, 0)
+  compile_time_ms = int(round((time.perf_counter() - start_time) * 1000))
+  exit_code = os.waitstatus_to_exitcode(status)
+  if exit_code != 0:
+    sys.exit(exit_code)
+
+  # ru_maxrss is reported in KiB on Linux and bytes on macOS.
+  peak_rss_bytes = rusage.ru_maxrss
+  if sys.platform != "darwin":
+    peak_rss_bytes *= 1024
+
+  statistics = {
+      "module_file": os.path.basename(args.module_file),
+      "compile_time_ms": compile_time_ms,
+      "compile_peak_rss_bytes": peak_rss_bytes,
+      "module_size_bytes": os.path.getsize(args.module_file),
+  }
+  with open(args.output, "w") as f:
+    json.dump(statistics, f, indent=2)
+    f.write("\n")
+
+
+if __name__ == "__main__":
+  main(parse_arguments())
@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+
+# Copyright 2022 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Tunes the lowering configurations of the dispatches of a program.
+
+The program is compiled once with the default heuristics while recording the
+configuration picked for each dispatch (--iree-codegen-tuning-database-record).
+Candidate configurations are derived from those and compiled in rounds: each
+round assigns the next candidate of every dispatch through a tuning database
+(--iree-codegen-tuning-database). Every round is benchmarked with one
+iree-benchmark-module invocation on the functions exported by
+--iree-flow-export-benchmark-funcs, and the fastest configuration of each
+dispatch is written to the output database. Later compiles pick the winners up
+when passed --iree-codegen-tuning-database=<output>.
+
+Candidate generation scales the workload per workgroup and the intermediate
+tile sizes of the CPU pipelines. Entries for other pipelines keep their default
+configuration but can be edited by hand; the compiler consumes them the same
+way.
+
+Example usage:
+
+  python3 tune_lowering_configs.py \\
+    --translate_tool=/path/to/iree-translate \\
+    --benchmark_tool=/path/to/iree-benchmark-module \\
+    --driver=dylib -o tuned.jsonl model.mlir -- \\
+    --iree-input-type=mhlo --iree-hal-target-backends=dylib-llvm-aot
+"""
+
+import argparse
+import itertools
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+from typing import Any, Dict, List, Optional, Sequence
+
+# Bounds of the workload per workgroup along each dimension.
+MIN_WORKLOAD_PER_WORKGROUP = 1
+MAX_WORKLOAD_PER_WORKGROUP = 512
+
+
+def parse_arguments():
+  """Parses command line arguments."""
+  parser = argparse.ArgumentParser()
+  parser.add_argument("input_file",
+                      type=str,
+                      metavar="<input-file>",
+                      help="The program to tune")
+  parser.add_argument("--translate_tool",
+                      type=str,
+                      default="iree-translate",
+                      help="Path to iree-translate")
+  parser.add_argument("--benchmark_tool",
+                      type=str,
+                      default="iree-benchmark-module",
+                      help="Path to iree-benchmark-module")
+  parser.add_argument("--driver",
+                      type=str,
+                      required=True,
+                      help="The runtime driver to benchmark with")
+  parser.add_argument("--database",
+                      type=str,
+                      default=None,
+                      help="An existing tuning database to start from")
+  parser.add_argument("--max_candidates",
+                      type=int,
+                      default=8,
+                      help="Maximum number of candidates tried per dispatch")
+  parser.add_argument("--benchmark_repetitions",
+                      type=int,
+                      default=3,
+                      help="Number of repetitions of each benchmark; the "
+                      "fastest repetition is kept")
+  parser.add_argument("-o",
+                      "--output",
+                      type=str,
+                      required=True,
+                      metavar="<output-file>",
+                      help="Output tuning database to write to")
+  parser.add_argument("--verbose",
+                      action="store_true",
+                      help="Print the commands being run")
+  parser.add_argument("compile_flags",
+                      nargs=argparse.REMAINDER,
+                      help="Additional iree-translate flags, following `--`")
+  args = parser.parse_args()
+  if args.compile_flags and args.compile_flags[0] == "--":
+    args.compile_flags = args.compile_flags[1:]
+  return args
+
+
+def entry_id(entry: Dict[str, Any]) -> str:
+  """Returns the identity of a database entry."""
+  return entry["target"] + "\n" + entry["key"]
+
+
+def read_database(path: str) -> List[Dict[str, Any]]:
+  """Reads the entries of a tuning database."""
+  with open(path) as f:
+    return [json.loads(line) for line in f if line.strip()]
+
+
+def write_database(path: str, entries: Sequence[Dict[str, Any]]):
+  """Writes the entries of a tuning database."""
+  with open(path, "w") as f:
+    for entry in entries:
+      f.write(json.dumps(entry, sort_keys=True) + "\n")
+
+
+def scaled(values: Sequence[int], index: int, factor: float) -> List[int]:
+  """Returns a copy of |values| with |values[index]| scaled by |factor|."""
+  values = list(values)
+  values[index] = int(values[index] * factor)
+  return values
+
+
+def generate_candidates(entry: Dict[str, Any],
+                        max_candidates: int) -> List[Dict[str, Any]]:
+  """Returns configurations to try for |entry|, starting with |entry|."""
+  candidates = [entry]
+  if not entry["pass_pipeline"].startswith("CPU"):
+    return candidates
+  tile_sizes = entry["tile_sizes"]
+  workload = entry["workload_per_wg"]
+
+  # The first tiling level is either empty or holds the reversed workload per
+  # workgroup on the distributed loops; keep the two in sync.
+  first_level = tile_sizes[0] if tile_sizes else []
+  distributed = [i for i, size in enumerate(first_level) if size != 0]
+  if first_level and [first_level[i] for i in reversed(distributed)
+                     ] != workload:
+    return candidates
+
+  def with_workload(new_workload):
+    new_tile_sizes = [list(sizes) for sizes in tile_sizes]
+    if first_level:
+      for i, size in zip(reversed(distributed), new_workload):
+        new_tile_sizes[0][i] = size
+    return dict(entry, tile_sizes=new_tile_sizes, workload_per_wg=new_workload)
+
+  def with_level(level, new_sizes):
+    new_tile_sizes = [list(sizes) for sizes in tile_sizes]
+    new_tile_sizes[level] = new_sizes
+    return dict(entry, tile_sizes=new_tile_sizes)
+
+  variants = []
+  for i, factor in itertools.product(range(len(workload)), (2, 0.5)):
+    new_workload = scaled(workload, i, factor)
+    if (MIN_WORKLOAD_PER_WORKGROUP <= new_workload[i] <=
+        MAX_WORKLOAD_PER_WORKGROUP):
+      variants.append(with_workload(new_workload))
+  # Intermediate levels must remain multiples of the level below them.
+  for level in range(1, len(tile_sizes) - 1):
+    sizes = tile_sizes[level]
+    inner = tile_sizes[level + 1]
+    for i, factor in itertools.product(range(len(sizes)), (2, 0.5)):
+      if sizes[i] == 0:
+        continue
+      new_sizes = scaled(sizes, i, factor)
+      if new_sizes[i] < 1 or (i < len(inner) and inner[i] != 0 and
+                              new_sizes[i] % inner[i] != 0):
+        continue
+      variants.append(with_level(level, new_sizes))
+
+  for variant in variants:
+    if len(candidates) >= max_candidates:
+      break
+    if variant not in candidates:
+      candidates.append(variant)
+  return candidates
+
+
+def compile_module(args, work_dir: str, name: str,
+                   database: Optional[str]) -> Optional[tuple]:
+  """Compiles the input with |database| and records the chosen configs.
+
+  Returns the module path and the recorded entries, or None on failure.
+  """
+  module_path = os.path.join(work_dir, name + ".vmfb")
+  record_path = os.path.join(work_dir, name + ".record.jsonl")
+  if os.path.exists(record_path):
+    os.remove(record_path)
+  cmd = [
+      args.translate_tool, "--iree-mlir-to-vm-bytecode-module",
+      "--iree-flow-export-benchmark-funcs",
+      f"--iree-codegen-tuning-database-record={record_path}", "-o",
+      module_path
+  ] + args.compile_flags + [args.input_file]
+  if database:
+    cmd.append(f"--iree-codegen-tuning-database={database}")
+  if args.verbose:
+    print(f"cmd: {' '.join(cmd)}")
+  if subprocess.run(cmd, stdout=subprocess.DEVNULL).returncode != 0:
+    return None
+  return module_path, read_database(record_path)
+
+
+def benchmark_module(args, module_path: str) -> Dict[str, float]:
+  """Returns the fastest time in ms of each benchmark function by name."""
+  cmd = [
+      args.benchmark_tool, f"--module_file={module_path}",
+      f"--driver={args.driver}", "--benchmark_format=json",
+      f"--benchmark_repetitions={args.benchmark_repetitions}"
+  ]
+  if args.verbose:
+    print(f"cmd: {' '.join(cmd)}")
+  output = subprocess.run(cmd, check=True, text=True,
+                          stdout=subprocess.PIPE).stdout
+  times = {}
+  for benchmark in json.loads(output)["benchmarks"]:
+    if benchmark.get("run_type", "iteration") != "iteration":
+      continue
+    name = benchmark["run_name"] if "run_name" in benchmark else benchmark[
+        "name"]
+    name = name[len("BM_"):] if name.startswith("BM_") else name
+    times[name] = min(times.get(name, float("inf")), benchmark["real_time"])
+  return times
+
+
+def dispatch_times(records: Sequence[Dict[str, Any]],
+                   times: Dict[str, float]) -> Dict[str, float]:
+  """Returns the benchmarked time of each dispatch entry by entry id.
+
+  Dispatches sharing a configuration have their times summed.
+  """
+  result = {}
+  for record in records:
+    time = times.get(record.get("dispatch", "") + "_benchmark")
+    if time is not None:
+      result[entry_id(record)] = result.get(entry_id(record), 0.0) + time
+  return result
+
+
+def main(args):
+  with tempfile.TemporaryDirectory() as work_dir:
+    baseline = compile_module(args, work_dir, "baseline", args.database)
+    if baseline is None:
+      sys.exit("error: failed to compile the baseline module")
+    module_path, records = baseline
+    baseline_times = dispatch_times(records,
+                                    benchmark_module(args, module_path))
+
+    # Records for dispatches sharing a configuration are identical.
+    entries = {}
+    for record in records:
+      record.pop("time_ms", None)
+      entries.setdefault(entry_id(record), record)
+    candidates = {
+        id: generate_candidates(entry, args.max_candidates)
+        for id, entry in entries.items()
+    }
+    best = {
+        id: (baseline_times[id], entry)
+        for id, entry in entries.items()
+        if id in baseline_times
+    }
+
+    def try_round(name, assignment):
+      """Benchmarks the candidates in |assignment| by entry id."""
+      database = os.path.join(work_dir, name + ".jsonl")
+      write_database(database, list(assignment.values()))
+      compiled = compile_module(args, work_dir, name, database)
+      if compiled is None:
+        return False
+      round_times = dispatch_times(compiled[1],
+                                   benchmark_module(args, compiled[0]))
+      for id, candidate in assignment.items():
+        if id in round_times and round_times[id] < best.get(
+            id, (float("inf"),))[0]:
+          best[id] = (round_times[id], candidate)
+      return True
+
+    num_rounds = max((len(c) for c in candidates.values()), default=1)
+    for round_index in range(1, num_rounds):
+      assignment = {
+          id: c[round_index] for id, c in candidates.items()
+          if round_index < len(c)
+      }
+      print(f"round {round_index}/{num_rounds - 1}: "
+            f"{len(assignment)} candidates")
+      if try_round(f"round{round_index}", assignment):
+        continue
+      # A candidate failed to compile; isolate it by retrying one at a time.
+      for i, (id, candidate) in enumerate(assignment.items()):
+        if not try_round(f"round{round_index}_{i}", {id: candidate}):
+          print(f"skipping candidate that failed to compile: {candidate}")
+
+  tuned = []
+  for time, entry in best.values():
+    tuned.append(dict(entry, time_ms=time))
+  write_database(args.output, tuned)
+  print(f"wrote {len(tuned)} entries to {args.output}")
+
+
+if __name__ == "__main__":
+  main(parse_arguments())